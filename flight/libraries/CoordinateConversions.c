@@ -29,7 +29,9 @@
 
 #include <math.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <pios_math.h>
+#include <fastmath.h>
 #include "CoordinateConversions.h"
 
 #define MIN_ALLOWABLE_MAGNITUDE 1e-30f
@@ -141,11 +143,10 @@ void Quaternion2RPY(const float q[4], float rpy[3])
     R23    = 2.0f * (q[2] * q[3] + q[0] * q[1]);
     R33    = q0s - q1s - q2s + q3s;
 
-    rpy[1] = RAD2DEG(asinf(-R13)); // pitch always between -pi/2 to pi/2
-    rpy[2] = RAD2DEG(atan2f(R12, R11));
-    rpy[0] = RAD2DEG(atan2f(R23, R33));
-
-    // TODO: consider the cases where |R13| ~= 1, |pitch| ~= pi/2
+    // fast_asinf clamps |R13| > 1 from rounding to a pitch of +-pi/2
+    rpy[1] = RAD2DEG(fast_asinf(-R13)); // pitch always between -pi/2 to pi/2
+    rpy[2] = RAD2DEG(fast_atan2f(R12, R11));
+    rpy[0] = RAD2DEG(fast_atan2f(R23, R33));
 }
 
 // ****** find quaternion from roll, pitch, yaw ********
@@ -157,12 +158,9 @@ void RPY2Quaternion(const float rpy[3], float q[4])
     phi    = DEG2RAD(rpy[0] / 2);
     theta  = DEG2RAD(rpy[1] / 2);
     psi    = DEG2RAD(rpy[2] / 2);
-    cphi   = cosf(phi);
-    sphi   = sinf(phi);
-    ctheta = cosf(theta);
-    stheta = sinf(theta);
-    cpsi   = cosf(psi);
-    spsi   = sinf(psi);
+    fast_sincosf(phi, &sphi, &cphi);
+    fast_sincosf(theta, &stheta, &ctheta);
+    fast_sincosf(psi, &spsi, &cpsi);
 
     q[0]   = cphi * ctheta * cpsi + sphi * stheta * spsi;
     q[1]   = sphi * ctheta * cpsi - cphi * stheta * spsi;
@@ -279,6 +277,88 @@ void ECEF2Base(double ECEF[3], double BaseECEF[3], float Rne[3][3], float NED[3]
     NED[2]  = Rne[2][0] * diff[0] + Rne[2][1] * diff[1] + Rne[2][2] * diff[2];
 }
 
+// ****** Local tangent plane around a base LLA ********
+// The position is computed from its latitude, longitude and altitude differences
+// to the base, which are exact in fixed point, with the small differences of the
+// ECEF terms written in well conditioned forms. So no double precision is needed,
+// the error stays below 1cm within 50km of the base.
+#define WGS84_A  6378137.0f // Equatorial Radius
+#define WGS84_E2 6.69437999014e-3f // Eccentricity squared
+
+void LTPBaseFromLLA(int32_t LLAi[3], float radius, LTPBase *base)
+{
+    float lat = DEG2RAD((float)LLAi[0] * 1e-7f);
+
+    base->LLAi[0] = LLAi[0];
+    base->LLAi[1] = LLAi[1];
+    base->LLAi[2] = LLAi[2];
+    base->sinLat  = sinf(lat);
+    base->cosLat  = cosf(lat);
+    base->s = sqrtf(1.0f - WGS84_E2 * base->sinLat * base->sinLat);
+    base->N = WGS84_A / base->s;
+    RneFromLLA(LLAi, base->Rne);
+
+    // radius in degrees along the meridian and the parallel, with some margin for the flattening
+    float dLat = RAD2DEG(radius / (WGS84_A * (1.0f - WGS84_E2)));
+    float dLon = (base->cosLat > 1e-3f) ? RAD2DEG(radius / (WGS84_A * base->cosLat)) : 180.0f;
+    base->maxDLat = (int32_t)(MIN(dLat, 90.0f) * 1e7f);
+    base->maxDLon = (int32_t)(MIN(dLon, 180.0f) * 1e7f);
+}
+
+bool LLA2LTP(const LTPBase *base, int32_t LLAi[3], float NED[3])
+{
+    int32_t dLatI = LLAi[0] - base->LLAi[0];
+    int64_t dLonI = (int64_t)LLAi[1] - base->LLAi[1];
+
+    if (dLonI > 1800000000) {
+        dLonI -= 3600000000LL;
+    } else if (dLonI < -1800000000) {
+        dLonI += 3600000000LL;
+    }
+    if (dLatI > base->maxDLat || dLatI < -base->maxDLat || dLonI > base->maxDLon || dLonI < -base->maxDLon) {
+        return false;
+    }
+
+    float dLat  = DEG2RAD((float)dLatI * 1e-7f);
+    float dLon  = DEG2RAD((float)dLonI * 1e-7f);
+    float h0    = (float)base->LLAi[2] * 1e-4f;
+    float dh    = (float)(LLAi[2] - base->LLAi[2]) * 1e-4f;
+
+    // latitude terms from the half latitude difference
+    float sdLat2 = sinf(0.5f * dLat);
+    float cdLat2 = cosf(0.5f * dLat);
+    float sinDLat = 2.0f * sdLat2 * cdLat2;
+    float cosDLat = 1.0f - 2.0f * sdLat2 * sdLat2;
+    float sinLat  = base->sinLat * cosDLat + base->cosLat * sinDLat;
+    float cosLat  = base->cosLat * cosDLat - base->sinLat * sinDLat;
+    float sinMid  = base->sinLat * cdLat2 + base->cosLat * sdLat2;
+    float cosMid  = base->cosLat * cdLat2 - base->sinLat * sdLat2;
+    float dSinLat = 2.0f * cosMid * sdLat2; // sin(lat) - sin(lat0)
+    float dCosLat = -2.0f * sinMid * sdLat2; // cos(lat) - cos(lat0)
+
+    // radius of curvature difference: N - N0 = a * (s0 - s) / (s * s0)
+    float s  = sqrtf(1.0f - WGS84_E2 * sinLat * sinLat);
+    float dN = WGS84_A * (WGS84_E2 * dSinLat * (sinLat + base->sinLat) / (base->s + s)) / (s * base->s);
+    float r0 = base->N + h0;
+    float dr = dN + dh;
+    float r  = r0 + dr;
+
+    // longitude terms, cos(dLon) - 1 from the half longitude difference
+    float sdLon2   = sinf(0.5f * dLon);
+    float cosDLon1 = -2.0f * sdLon2 * sdLon2;
+    float sinDLon  = sinf(dLon);
+
+    // ECEF difference in the frame of the base meridian
+    float dx = r * cosLat * cosDLon1 + dr * cosLat + r0 * dCosLat;
+    float dz = (dN * (1.0f - WGS84_E2) + dh) * sinLat + (base->N * (1.0f - WGS84_E2) + h0) * dSinLat;
+
+    NED[0] = -base->sinLat * dx + base->cosLat * dz;
+    NED[1] = r * cosLat * sinDLon;
+    NED[2] = -base->cosLat * dx - base->sinLat * dz;
+
+    return true;
+}
+
 // ****** convert Rotation Matrix to Quaternion ********
 // ****** if R converts from e to b, q is rotation from e to b ****
 void R2Quaternion(float R[3][3], float q[4])
@@ -300,7 +380,7 @@ void R2Quaternion(float R[3][3], float q[4])
             index = i;
         }
     }
-    mag = 2 * sqrtf(mag);
+    mag = 2 * fast_sqrtf(mag);
 
     if (index == 0) {
         q[0] = mag / 4;
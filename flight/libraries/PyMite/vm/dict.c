@@ -42,6 +42,7 @@ dict_new(pPmObj_t *r_pdict)
     /* Init dict fields */
     pdict = (pPmDict_t)pchunk;
     OBJ_SET_TYPE(pdict, OBJ_TYPE_DIC);
+    PM_DICT_MODIFIED();
     pdict->length = 0;
     pdict->d_keys = C_NULL;
     pdict->d_vals = C_NULL;
@@ -67,6 +68,7 @@ dict_clear(pPmObj_t pdict)
 
     /* clear length */
     ((pPmDict_t)pdict)->length = 0;
+    PM_DICT_MODIFIED();
 
     /* Free the keys and values seglists if needed */
     if (((pPmDict_t)pdict)->d_keys != C_NULL)
@@ -127,6 +129,8 @@ dict_setItem(pPmObj_t pdict, pPmObj_t pkey, pPmObj_t pval)
         pkey = PM_ZERO;
     }
 
+    PM_DICT_MODIFIED();
+
     /*
      * #115: If this is the first key/value pair to be added to the Dict,
      * allocate the key and value seglists that hold those items
@@ -232,6 +236,7 @@ dict_delItem(pPmObj_t pdict, pPmObj_t pkey)
     PM_RETURN_IF_ERROR(retval);
 
     /* Remove the key and value */
+    PM_DICT_MODIFIED();
     retval = seglist_removeItem(((pPmDict_t)pdict)->d_keys, indx);
     PM_RETURN_IF_ERROR(retval);
     retval = seglist_removeItem(((pPmDict_t)pdict)->d_vals, indx);
@@ -71,6 +71,31 @@
 #define PM_BYTEARRAY_STR (pPmObj_t)(gVmGlobal.pbaStr)
 #endif /* HAVE_BYTEARRAY */
 
+/** Number of entries in the LOAD_GLOBAL lookup cache, a power of two */
+#define PM_GLOBAL_CACHE_SIZE 16
+
+/** Bumped by every dict mutation, invalidates the LOAD_GLOBAL cache */
+#define PM_DICT_MODIFIED() (gVmGlobal.dictVersion++)
+
+/**
+ * LOAD_GLOBAL cache entry
+ *
+ * Remembers the value a name resolved to in a globals dict (or the builtins).
+ * Only valid while no dict has been modified since, so the value is still
+ * referenced by the dict and needs no marking by the GC.
+ */
+typedef struct PmGlobalCacheEntry_s
+{
+    /** The globals dict the name was looked up in */
+    pPmObj_t pglobals;
+    /** The name, a string from the code object's names tuple */
+    pPmObj_t pname;
+    /** The value found */
+    pPmObj_t pval;
+    /** dictVersion at the time of the lookup */
+    uint32_t version;
+} PmGlobalCacheEntry_t;
+
 /**
  * This struct contains ALL of PyMite's globals
  */
@@ -153,6 +178,12 @@ typedef struct PmVmGlobal_s
 
     /** Flag to trigger rescheduling */
     uint8_t reschedule;
+
+    /** Incremented whenever any dict is created or modified */
+    uint32_t dictVersion;
+
+    /** Direct mapped LOAD_GLOBAL cache, indexed by the name's address */
+    PmGlobalCacheEntry_t globalCache[PM_GLOBAL_CACHE_SIZE];
 } PmVmGlobal_t,
  *pPmVmGlobal_t;
 
@@ -1598,10 +1598,24 @@ interpret(const uint8_t returnOnNoThreads)
                 continue;
 
             case LOAD_GLOBAL:
+            {
+                volatile PmGlobalCacheEntry_t *pentry;
+
                 /* Get name */
                 t16 = GET_ARG();
                 pobj1 = PM_FP->fo_func->f_co->co_names->val[t16];
 
+                /* Use the cached value if no dict changed since */
+                pentry = &gVmGlobal.globalCache[((uintptr_t)pobj1 >> 2)
+                                                & (PM_GLOBAL_CACHE_SIZE - 1)];
+                if ((pentry->pname == pobj1)
+                    && (pentry->pglobals == (pPmObj_t)PM_FP->fo_globals)
+                    && (pentry->version == gVmGlobal.dictVersion))
+                {
+                    PM_PUSH(pentry->pval);
+                    continue;
+                }
+
                 /* Try globals first */
                 retval = dict_getItem((pPmObj_t)PM_FP->fo_globals,
                                       pobj1, &pobj2);
@@ -1619,8 +1633,14 @@ interpret(const uint8_t returnOnNoThreads)
                     }
                 }
                 PM_BREAK_IF_ERROR(retval);
+
+                pentry->pglobals = (pPmObj_t)PM_FP->fo_globals;
+                pentry->pname = pobj1;
+                pentry->pval = pobj2;
+                pentry->version = gVmGlobal.dictVersion;
                 PM_PUSH(pobj2);
                 continue;
+            }
 
             case SETUP_LOOP:
             {
@@ -20,6 +20,9 @@
  *                - Hard coded coefficients for model
  *                - Elimination of user interface
  *                - Elimination of dynamic memory allocation
+ *                - Legendre recurrence fused with the summation, using
+ *                  precomputed normalisation tables, and no secular
+ *                  variation of the elements
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -40,22 +43,13 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
-#include "openpilot.h"
-
-#include <stdio.h>
-#include <string.h>
 #include <math.h>
-#include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "WorldMagModel.h"
 #include "WMMInternal.h"
 
-#define MALLOC(x) pios_malloc(x)
-#define FREE(x)   vPortFree(x)
-// #define MALLOC(x) malloc(x)
-// #define FREE(x) free(x)
-
 // http://reviews.openpilot.org/cru/OPReview-436#c6476 :
 // first column not used but it will be optimized out by compiler
 static const float CoeffFile[91][6] = {
@@ -152,49 +146,59 @@ static const float CoeffFile[91][6] = {
     { 12.0f, 12.0f, 0.0f,      0.9f,     0.1f,   0.0f   }
 };
 
-static WMMtype_Ellipsoid *Ellip = NULL;
-static WMMtype_MagneticModel *MagneticModel = NULL;
-static float decimal_date;
+/* Gauss-normalized associated Legendre function recurrence factors
+   ((n-1)^2 - m^2) / ((2n-1)(2n-3)), indexed like CoeffFile, zero where unused */
+static const float LegendreK[NUMTERMS] = {
+    0.0f,
+    0.0f, 0.0f,
+    0.333333333f, 0.0f, 0.0f,
+    0.266666667f, 0.2f, 0.0f, 0.0f,
+    0.257142857f, 0.228571429f, 0.142857143f, 0.0f, 0.0f,
+    0.253968254f, 0.238095238f, 0.19047619f, 0.111111111f, 0.0f, 0.0f,
+    0.252525253f, 0.242424242f, 0.212121212f, 0.161616162f, 0.0909090909f, 0.0f, 0.0f,
+    0.251748252f, 0.244755245f, 0.223776224f, 0.188811189f, 0.13986014f, 0.0769230769f, 0.0f, 0.0f,
+    0.251282051f, 0.246153846f, 0.230769231f, 0.205128205f, 0.169230769f, 0.123076923f, 0.0666666667f, 0.0f, 0.0f,
+    0.250980392f, 0.247058824f, 0.235294118f, 0.215686275f, 0.188235294f, 0.152941176f, 0.109803922f, 0.0588235294f, 0.0f, 0.0f,
+    0.250773994f, 0.247678019f, 0.238390093f, 0.222910217f, 0.20123839f, 0.173374613f, 0.139318885f, 0.0990712074f, 0.0526315789f, 0.0f, 0.0f,
+    0.250626566f, 0.248120301f, 0.240601504f, 0.228070175f, 0.210526316f, 0.187969925f, 0.160401003f, 0.127819549f, 0.0902255639f, 0.0476190476f, 0.0f, 0.0f,
+    0.250517598f, 0.248447205f, 0.242236025f, 0.231884058f, 0.217391304f, 0.198757764f, 0.175983437f, 0.149068323f, 0.118012422f, 0.082815735f, 0.0434782609f, 0.0f, 0.0f
+};
+
+/* Ratios between the Gauss-normalized associated Legendre functions and the
+   Schmidt quasi-normalized version sqrt((m==0?1:2)*(n-m)!/(n+m)!)*(2n-1)!!/(n-m)! */
+static const float SchmidtQuasiNorm[NUMTERMS] = {
+    1.0f,
+    1.0f, 1.0f,
+    1.5f, 1.73205081f, 0.866025404f,
+    2.5f, 3.06186218f, 1.93649167f, 0.790569415f,
+    4.375f, 5.53398591f, 3.91311896f, 2.09165007f, 0.739509973f,
+    7.875f, 10.1665813f, 7.68521307f, 4.70621265f, 2.21852992f, 0.70156076f,
+    14.4375f, 18.9031247f, 14.9442323f, 9.96282151f, 5.45686208f, 2.32681381f, 0.671693289f,
+    26.8125f, 35.4696035f, 28.96081f, 20.4783851f, 12.3489309f, 6.17446544f, 2.4218246f, 0.647259849f,
+    50.2734375f, 67.03125f, 56.0823674f, 41.4195733f, 26.7362196f, 14.8305863f, 6.86522743f, 2.50682662f, 0.626706654f,
+    94.9609375f, 127.403467f, 108.650042f, 82.98284f, 56.3757384f, 33.6909477f, 17.3979306f, 7.53352493f, 2.58397773f, 0.609049392f,
+    180.425781f, 243.286074f, 210.69192f, 165.28034f, 116.87085f, 73.9156153f, 41.3200851f, 20.0431853f, 8.18259615f, 2.65478475f, 0.593627917f,
+    344.449219f, 466.386447f, 409.047973f, 327.968008f, 239.513968f, 158.423599f, 94.1176423f, 49.6043529f, 22.7600381f, 8.81492484f, 2.72034486f, 0.579979474f,
+    660.194336f, 897.027462f, 795.129861f, 649.220813f, 486.915609f, 334.021352f, 208.29891f, 117.053882f, 58.5269411f, 25.5432512f, 9.43247064f, 2.78148384f, 0.567768012f
+};
+
+static WMMtype_GridCache Cache;
 
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
-*	WMM_Initialize(); // Set default values and constants
-*
 *	WMM_GetMagVector(float Lat, float Lon, float Alt, uint16_t Month, uint16_t Day, uint16_t Year, float B[3]);
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
-*	B is the NED (XYZ) magnetic vector in nTesla
+*	B is the NED (XYZ) magnetic vector in milliGauss
+*
+*	WMM_GetMagVectorCached() takes the same parameters, for callers asking
+*	repeatedly around the same place.
 **************************************************************************************/
 
 int WMM_Initialize()
-// Sets default values for WMM subroutines.
-// UPDATES : Ellip and MagneticModel
+// The model is made of constants only, nothing to set up any more
 {
-    if (!Ellip) {
-        return -1; // invalid pointer
-    }
-    if (!MagneticModel) {
-        return -2; // invalid pointer
-    }
-    // Sets WGS-84 parameters
-    Ellip->a     = 6378.137f;   // semi-major axis of the ellipsoid in km
-    Ellip->b     = 6356.7523142f;       // semi-minor axis of the ellipsoid in km
-    Ellip->fla   = 1.0f / 298.257223563f;     // flattening
-    Ellip->eps   = sqrt(1 - (Ellip->b * Ellip->b) / (Ellip->a * Ellip->a));   // first eccentricity
-    Ellip->epssq = (Ellip->eps * Ellip->eps); // first eccentricity squared
-    Ellip->re    = 6371.2f;    // Earth's radius in km
-
-    // Sets Magnetic Model parameters
-    MagneticModel->nMax = WMM_MAX_MODEL_DEGREES;
-    MagneticModel->nMaxSecVar = WMM_MAX_SECULAR_VARIATION_MODEL_DEGREES;
-    MagneticModel->SecularVariationUsed = 0;
-
-    // Really, Really needs to be read from a file - out of date in 2015 at latest
-    MagneticModel->EditionDate = 0.0f; /* OP change. Originally 5.7863328170559505e-307, truncates to 0.0f */
-    MagneticModel->epoch = 2010.0f;
-    sprintf(MagneticModel->ModelName, "WMM-2010");
-
     return 0; // OK
 }
 
@@ -203,310 +207,122 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
     // return '0' if all appears to be OK
     // return < 0 if error
 
-    int returned = 0; // default to OK
-
-    // ***********
-    // range check supplied params
+    float DecimalYear;
+    int returned = WMM_CheckInputs(Lat, Lon, Month, Day, Year, &DecimalYear);
 
-    if (Lat < -90.0f) {
-        return -1; // error
-    }
-    if (Lat > 90.0f) {
-        return -2; // error
-    }
-    if (Lon < -180.0f) {
-        return -3; // error
-    }
-    if (Lon > 180.0f) {
-        return -4; // error
+    if (returned < 0) {
+        return returned;
     }
-    // ***********
-    // allocated required memory
 
-// Ellip = NULL;
-// MagneticModel = NULL;
+    WMM_Geomag(Lat, Lon, AltEllipsoid / 1000.0f, DecimalYear - WMM_EPOCH, B);
 
-// MagneticModel = NULL;
-// CoordGeodetic = NULL;
-// GeoMagneticElements = NULL;
-
-    Ellip = (WMMtype_Ellipsoid *)MALLOC(sizeof(WMMtype_Ellipsoid));
-    MagneticModel = (WMMtype_MagneticModel *)MALLOC(sizeof(WMMtype_MagneticModel));
-
-    WMMtype_CoordSpherical *CoordSpherical = (WMMtype_CoordSpherical *)MALLOC(sizeof(WMMtype_CoordSpherical));
-    WMMtype_CoordGeodetic *CoordGeodetic   = (WMMtype_CoordGeodetic *)MALLOC(sizeof(WMMtype_CoordGeodetic));
-    WMMtype_GeoMagneticElements *GeoMagneticElements = (WMMtype_GeoMagneticElements *)MALLOC(sizeof(WMMtype_GeoMagneticElements));
-
-    if (!Ellip || !MagneticModel || !CoordSpherical || !CoordGeodetic || !GeoMagneticElements) {
-        returned = -5; // error
-    }
-    // ***********
-
-    if (returned >= 0) {
-        if (WMM_Initialize() < 0) {
-            returned = -6; // error
-        }
-    }
+    return 0; // OK
+}
 
-    if (returned >= 0) {
-        CoordGeodetic->lambda = Lon;
-        CoordGeodetic->phi    = Lat;
-        CoordGeodetic->HeightAboveEllipsoid = AltEllipsoid / 1000.0f; // convert to km
+int WMM_GetMagVectorCached(float Lat, float Lon, float AltEllipsoid, uint16_t Month, uint16_t Day, uint16_t Year, float B[3])
+/* Interpolates bilinearly between the field at the corners of the grid cell
+   holding the point. The corners are evaluated again when the point leaves the
+   cell, moves more than WMM_CACHE_MAX_HEIGHT_KM up or down or the date changes.
+   Not reentrant, there is a single cache. */
+{
+    float DecimalYear;
+    int returned = WMM_CheckInputs(Lat, Lon, Month, Day, Year, &DecimalYear);
 
-        // Convert from geodetic to Spherical Equations: 17-18, WMM Technical report
-        if (WMM_GeodeticToSpherical(CoordGeodetic, CoordSpherical) < 0) {
-            returned = -7; // error
-        }
+    if (returned < 0) {
+        return returned;
     }
 
+    float HeightAboveEllipsoid = AltEllipsoid / 1000.0f; // convert to km
+    float lat0 = floorf(Lat / WMM_CACHE_CELL_DEG) * WMM_CACHE_CELL_DEG;
+    float lon0 = floorf(Lon / WMM_CACHE_CELL_DEG) * WMM_CACHE_CELL_DEG;
 
-    if (returned >= 0) {
-        if (WMM_DateToYear(Month, Day, Year) < 0) {
-            returned = -8; // error
-        }
-    }
-
-    if (returned >= 0) {
-        // Compute the geoMagnetic field elements and their time change
-        if (WMM_Geomag(CoordSpherical, CoordGeodetic, GeoMagneticElements) < 0) {
-            returned = -9; // error
-        } else { // set the returned values
-            B[0] = GeoMagneticElements->X;
-            B[1] = GeoMagneticElements->Y;
-            B[2] = GeoMagneticElements->Z;
-        }
+    // the north pole is the upper edge of the last row of cells
+    if (lat0 > 90.0f - WMM_CACHE_CELL_DEG) {
+        lat0 = 90.0f - WMM_CACHE_CELL_DEG;
     }
 
-    // ***********
-    // free allocated memory
+    if (!Cache.valid || Cache.lat0 != lat0 || Cache.lon0 != lon0 || Cache.DecimalYear != DecimalYear ||
+        fabsf(Cache.HeightAboveEllipsoid - HeightAboveEllipsoid) > WMM_CACHE_MAX_HEIGHT_KM) {
+        float dt = DecimalYear - WMM_EPOCH;
 
-    if (GeoMagneticElements) {
-        FREE(GeoMagneticElements);
-    }
+        // past 180 degrees the longitude only goes through sine and cosine, no need to wrap it
+        WMM_Geomag(lat0, lon0, HeightAboveEllipsoid, dt, Cache.B[0]);
+        WMM_Geomag(lat0, lon0 + WMM_CACHE_CELL_DEG, HeightAboveEllipsoid, dt, Cache.B[1]);
+        WMM_Geomag(lat0 + WMM_CACHE_CELL_DEG, lon0, HeightAboveEllipsoid, dt, Cache.B[2]);
+        WMM_Geomag(lat0 + WMM_CACHE_CELL_DEG, lon0 + WMM_CACHE_CELL_DEG, HeightAboveEllipsoid, dt, Cache.B[3]);
 
-    if (CoordGeodetic) {
-        FREE(CoordGeodetic);
+        Cache.lat0 = lat0;
+        Cache.lon0 = lon0;
+        Cache.HeightAboveEllipsoid = HeightAboveEllipsoid;
+        Cache.DecimalYear = DecimalYear;
+        Cache.valid = true;
     }
 
-    if (CoordSpherical) {
-        FREE(CoordSpherical);
-    }
+    float u = (Lon - lon0) / WMM_CACHE_CELL_DEG;
+    float v = (Lat - lat0) / WMM_CACHE_CELL_DEG;
 
-    if (MagneticModel) {
-        FREE(MagneticModel);
-        MagneticModel = NULL;
+    for (int i = 0; i < 3; i++) {
+        B[i] = (1.0f - v) * ((1.0f - u) * Cache.B[0][i] + u * Cache.B[1][i]) +
+               v * ((1.0f - u) * Cache.B[2][i] + u * Cache.B[3][i]);
     }
 
-    if (Ellip) {
-        FREE(Ellip);
-        Ellip = NULL;
-    }
-
-    B[0] = GeoMagneticElements->X * 1e-2f;
-    B[1] = GeoMagneticElements->Y * 1e-2f;
-    B[2] = GeoMagneticElements->Z * 1e-2f;
-
-    return returned;
+    return 0; // OK
 }
 
-int WMM_Geomag(WMMtype_CoordSpherical *CoordSpherical, WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_GeoMagneticElements *GeoMagneticElements)
-/*
-   The main subroutine that calls a sequence of WMM sub-functions to calculate the magnetic field elements for a single point.
-   The function expects the model coefficients and point coordinates as input and returns the magnetic field elements and
-   their rate of change. Though, this subroutine can be called successively to calculate a time series, profile or grid
-   of magnetic field, these are better achieved by the subroutine WMM_Grid.
-
-   INPUT: Ellip
-   CoordSpherical
-   CoordGeodetic
-   TimedMagneticModel
-
-   OUTPUT : GeoMagneticElements
-
-   CALLS:    WMM_ComputeSphericalHarmonicVariables( Ellip, CoordSpherical, TimedMagneticModel->nMax, &SphVariables); (Compute Spherical Harmonic variables  )
-   WMM_AssociatedLegendreFunction(CoordSpherical, TimedMagneticModel->nMax, LegendreFunction);       Compute ALF
-   WMM_Summation(LegendreFunction, TimedMagneticModel, SphVariables, CoordSpherical, &MagneticResultsSph);  Accumulate the spherical harmonic coefficients
-   WMM_SecVarSummation(LegendreFunction, TimedMagneticModel, SphVariables, CoordSpherical, &MagneticResultsSphVar); Sum the Secular Variation Coefficients
-   WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, MagneticResultsSph, &MagneticResultsGeo); Map the computed Magnetic fields to Geodeitic coordinates
-   WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, MagneticResultsSphVar, &MagneticResultsGeoVar);  Map the secular variation field components to Geodetic coordinates
-   WMM_CalculateGeoMagneticElements(&MagneticResultsGeo, GeoMagneticElements);   Calculate the Geomagnetic elements
-   WMM_CalculateSecularVariation(MagneticResultsGeoVar, GeoMagneticElements); Calculate the secular variation of each of the Geomagnetic elements
-
- */
+int WMM_CheckInputs(float Lat, float Lon, uint16_t Month, uint16_t Day, uint16_t Year, float *DecimalYear)
+// Range checks the supplied parameters and converts the date
 {
-    int returned = 0; // default to OK
-
-    WMMtype_MagneticResults MagneticResultsSph;
-    WMMtype_MagneticResults MagneticResultsGeo;
-    WMMtype_MagneticResults MagneticResultsSphVar;
-    WMMtype_MagneticResults MagneticResultsGeoVar;
-
-    // ********
-    // allocate required memory
-
-    WMMtype_LegendreFunction *LegendreFunction = (WMMtype_LegendreFunction *)MALLOC(sizeof(WMMtype_LegendreFunction));
-    WMMtype_SphericalHarmonicVariables *SphVariables = (WMMtype_SphericalHarmonicVariables *)MALLOC(sizeof(WMMtype_SphericalHarmonicVariables));
-
-    if (!LegendreFunction || !SphVariables) {
-        returned = -1; // memory allocation error
-    }
-    // ********
-
-    if (returned >= 0) { // Compute Spherical Harmonic variables
-        if (WMM_ComputeSphericalHarmonicVariables(CoordSpherical, MagneticModel->nMax, SphVariables) < 0) {
-            returned = -2; // error
-        }
-    }
-
-    if (returned >= 0) { // Compute ALF
-        if (WMM_AssociatedLegendreFunction(CoordSpherical, MagneticModel->nMax, LegendreFunction) < 0) {
-            returned = -3; // error
-        }
-    }
-
-    if (returned >= 0) { // Accumulate the spherical harmonic coefficients
-        if (WMM_Summation(LegendreFunction, SphVariables, CoordSpherical, &MagneticResultsSph) < 0) {
-            returned = -4; // error
-        }
-    }
-
-    if (returned >= 0) { // Sum the Secular Variation Coefficients
-        if (WMM_SecVarSummation(LegendreFunction, SphVariables, CoordSpherical, &MagneticResultsSphVar) < 0) {
-            returned = -5; // error
-        }
-    }
-
-    if (returned >= 0) { // Map the computed Magnetic fields to Geodeitic coordinates
-        if (WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, &MagneticResultsSph, &MagneticResultsGeo) < 0) {
-            returned = -6; // error
-        }
-    }
-
-    if (returned >= 0) { // Map the secular variation field components to Geodetic coordinates
-        if (WMM_RotateMagneticVector(CoordSpherical, CoordGeodetic, &MagneticResultsSphVar, &MagneticResultsGeoVar) < 0) {
-            returned = -7; // error
-        }
-    }
-
-    if (returned >= 0) { // Calculate the Geomagnetic elements, Equation 18 , WMM Technical report
-        if (WMM_CalculateGeoMagneticElements(&MagneticResultsGeo, GeoMagneticElements) < 0) {
-            returned = -8; // error
-        }
-    }
-
-    if (returned >= 0) { // Calculate the secular variation of each of the Geomagnetic elements
-        if (WMM_CalculateSecularVariation(&MagneticResultsGeoVar, GeoMagneticElements) < 0) {
-            returned = -9; // error
-        }
+    if (Lat < -90.0f) {
+        return -1; // error
     }
-
-    // ********
-    // free allocated memory
-
-    if (SphVariables) {
-        FREE(SphVariables);
+    if (Lat > 90.0f) {
+        return -2; // error
     }
-
-    if (LegendreFunction) {
-        FREE(LegendreFunction);
+    if (Lon < -180.0f) {
+        return -3; // error
     }
-
-    // ********
-
-    return returned;
-}
-
-int WMM_ComputeSphericalHarmonicVariables(WMMtype_CoordSpherical *CoordSpherical, uint16_t nMax, WMMtype_SphericalHarmonicVariables *SphVariables)
-/* Computes Spherical variables
-   Variables computed are (a/r)^(n+2), cos_m(lamda) and sin_m(lambda) for spherical harmonic
-   summations. (Equations 10-12 in the WMM Technical Report)
-   INPUT   Ellip  data  structure with the following elements
-   float a; semi-major axis of the ellipsoid
-   float b; semi-minor axis of the ellipsoid
-   float fla;  flattening
-   float epssq; first eccentricity squared
-   float eps;  first eccentricity
-   float re; mean radius of  ellipsoid
-   CoordSpherical    A data structure with the following elements
-   float lambda; ( longitude)
-   float phig; ( geocentric latitude )
-   float r;            ( distance from the center of the ellipsoid)
-   nMax   integer     ( Maxumum degree of spherical harmonic secular model)\
-
-   OUTPUT  SphVariables  Pointer to the   data structure with the following elements
-   float RelativeRadiusPower[WMM_MAX_MODEL_DEGREES+1];   [earth_reference_radius_km  sph. radius ]^n
-   float cos_mlambda[WMM_MAX_MODEL_DEGREES+1]; cp(m)  - cosine of (mspherical coord. longitude)
-   float sin_mlambda[WMM_MAX_MODEL_DEGREES+1];  sp(m)  - sine of (mspherical coord. longitude)
-   CALLS : none
- */
-{
-    float cos_lambda, sin_lambda;
-    uint16_t m, n;
-
-    cos_lambda = cosf(DEG2RAD(CoordSpherical->lambda));
-    sin_lambda = sinf(DEG2RAD(CoordSpherical->lambda));
-
-    /* for n = 0 ... model_order, compute (Radius of Earth / Spherica radius r)^(n+2)
-       for n  1..nMax-1 (this is much faster than calling pow MAX_N+1 times).      */
-
-    SphVariables->RelativeRadiusPower[0] = (Ellip->re / CoordSpherical->r) * (Ellip->re / CoordSpherical->r);
-    for (n = 1; n <= nMax; n++) {
-        SphVariables->RelativeRadiusPower[n] = SphVariables->RelativeRadiusPower[n - 1] * (Ellip->re / CoordSpherical->r);
+    if (Lon > 180.0f) {
+        return -4; // error
     }
-
-    /*
-       Compute cosf(m*lambda), sinf(m*lambda) for m = 0 ... nMax
-       cosf(a + b) = cosf(a)*cosf(b) - sinf(a)*sinf(b)
-       sinf(a + b) = cosf(a)*sinf(b) + sinf(a)*cosf(b)
-     */
-    SphVariables->cos_mlambda[0] = 1.0f;
-    SphVariables->sin_mlambda[0] = 0.0f;
-
-    SphVariables->cos_mlambda[1] = cos_lambda;
-    SphVariables->sin_mlambda[1] = sin_lambda;
-    for (m = 2; m <= nMax; m++) {
-        SphVariables->cos_mlambda[m] = SphVariables->cos_mlambda[m - 1] * cos_lambda - SphVariables->sin_mlambda[m - 1] * sin_lambda;
-        SphVariables->sin_mlambda[m] = SphVariables->cos_mlambda[m - 1] * sin_lambda + SphVariables->sin_mlambda[m - 1] * cos_lambda;
+    if (WMM_DateToYear(Month, Day, Year, DecimalYear) < 0) {
+        return -8; // error
     }
 
     return 0; // OK
 }
 
-int WMM_AssociatedLegendreFunction(WMMtype_CoordSpherical *CoordSpherical, uint16_t nMax, WMMtype_LegendreFunction *LegendreFunction)
-/* Computes  all of the Schmidt-semi normalized associated Legendre
-   functions up to degree nMax. If nMax <= 16, function WMM_PcupLow is used.
-   Otherwise WMM_PcupHigh is called.
-   INPUT  CoordSpherical        A data structure with the following elements
-   float lambda; ( longitude)
-   float phig; ( geocentric latitude )
-   float r;       ( distance from the center of the ellipsoid)
-   nMax         integer          ( Maxumum degree of spherical harmonic secular model)
-   LegendreFunction Pointer to data structure with the following elements
-   float *Pcup;  (  pointer to store Legendre Function  )
-   float *dPcup; ( pointer to store  Derivative of Lagendre function )
-
-   OUTPUT  LegendreFunction  Calculated Legendre variables in the data structure
+void WMM_Geomag(float Lat, float Lon, float HeightAboveEllipsoid, float dt, float B[3])
+/*
+   Calculates the magnetic field vector for a single point, in milliGauss.
+
+   INPUT: Lat, Lon geodetic latitude and longitude in degrees
+   HeightAboveEllipsoid in km
+   dt years since the epoch of the model
 
+   CALLS:    WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical); Convert from geodetic to Spherical Equations: 17-18, WMM Technical report
+   WMM_Summation(&CoordSpherical, dt, &MagneticResultsSph);  Accumulate the spherical harmonic coefficients
+   WMM_RotateMagneticVector(&CoordSpherical, &CoordGeodetic, &MagneticResultsSph, &MagneticResultsGeo); Map the computed Magnetic fields to Geodeitic coordinates
  */
 {
-    float sin_phi = sinf(DEG2RAD(CoordSpherical->phig)); /* sinf  (geocentric latitude) */
+    WMMtype_CoordGeodetic CoordGeodetic;
+    WMMtype_CoordSpherical CoordSpherical;
+    WMMtype_MagneticResults MagneticResultsSph;
+    WMMtype_MagneticResults MagneticResultsGeo;
 
-    if (nMax <= 16 || (1 - fabsf(sin_phi)) < 1.0e-10f) { /* If nMax is less tha 16 or at the poles */
-        if (WMM_PcupLow(LegendreFunction->Pcup, LegendreFunction->dPcup, sin_phi, nMax) < 0) {
-            return -1; // error
-        }
-    } else {
-        if (WMM_PcupHigh(LegendreFunction->Pcup, LegendreFunction->dPcup, sin_phi, nMax) < 0) {
-            return -2; // error
-        }
-    }
+    CoordGeodetic.lambda = Lon;
+    CoordGeodetic.phi    = Lat;
+    CoordGeodetic.HeightAboveEllipsoid = HeightAboveEllipsoid;
 
-    return 0; // OK
+    WMM_GeodeticToSpherical(&CoordGeodetic, &CoordSpherical);
+    WMM_Summation(&CoordSpherical, dt, &MagneticResultsSph);
+    WMM_RotateMagneticVector(&CoordSpherical, &CoordGeodetic, &MagneticResultsSph, &MagneticResultsGeo);
+
+    B[0] = MagneticResultsGeo.Bx * 1e-2f;
+    B[1] = MagneticResultsGeo.By * 1e-2f;
+    B[2] = MagneticResultsGeo.Bz * 1e-2f;
 }
 
-int WMM_Summation(WMMtype_LegendreFunction *LegendreFunction,
-                  WMMtype_SphericalHarmonicVariables *SphVariables,
-                  WMMtype_CoordSpherical *CoordSpherical, WMMtype_MagneticResults *MagneticResults)
+void WMM_Summation(const WMMtype_CoordSpherical *CoordSpherical, float dt, WMMtype_MagneticResults *MagneticResults)
 {
     /* Computes Geomagnetic Field Elements X, Y and Z in Spherical coordinate system using
        spherical harmonic summation.
@@ -518,10 +334,18 @@ int WMM_Summation(WMMtype_LegendreFunction *LegendreFunction,
        grad V = -- r  +  - -- t  +  -------- -- p
        dr       r dt       r sinf(t) dp
 
-       INPUT :  LegendreFunction
-       MagneticModel
-       SphVariables
-       CoordSpherical
+       The associated Legendre functions are not stored: for each order m they are
+       walked up in degree n with the recurrence of the Gauss-normalized functions
+       and scaled to the Schmidt quasi-normalized version as they are summed.
+       Notes: Overflow may occur if nMax > 20, especially for high-latitudes.
+
+       In geomagnetism, the derivatives of ALF are usually found with respect to
+       the colatitudes. Here the derivatives are found with respect to the
+       latitude. The difference is a sign reversal for the derivative of the
+       Associated Legendre Functions.
+
+       INPUT :  CoordSpherical
+       dt years since the epoch of the model
        OUTPUT : MagneticResults
 
        CALLS : WMM_SummationSpecial
@@ -530,558 +354,113 @@ int WMM_Summation(WMMtype_LegendreFunction *LegendreFunction,
      */
 
     uint16_t m, n, index;
-    float cos_phi;
+    float RelativeRadiusPower[WMM_MAX_MODEL_DEGREES + 1]; // [earth_reference_radius_km / sph. radius ]^(n+2)
+    float g, h, gcos_hsin, Ps, dPs;
+    float P, dP, P1, dP1, P2, dP2, tmp;
+
+    float sin_phi    = sinf(DEG2RAD(CoordSpherical->phig));
+    float cos_phi    = cosf(DEG2RAD(CoordSpherical->phig));
+    float cos_lambda = cosf(DEG2RAD(CoordSpherical->lambda));
+    float sin_lambda = sinf(DEG2RAD(CoordSpherical->lambda));
+    float cos_mlambda = 1.0f; // cosine of (m*spherical coord. longitude)
+    float sin_mlambda = 0.0f; // sine of (m*spherical coord. longitude)
+    float Pmm  = 1.0f; // Gauss-normalized P and dP of degree and order m
+    float dPmm = 0.0f;
+
+    /* for n = 0 ... model_order, compute (Radius of Earth / Spherica radius r)^(n+2) */
+    RelativeRadiusPower[0] = (WMM_EARTH_RADIUS / CoordSpherical->r) * (WMM_EARTH_RADIUS / CoordSpherical->r);
+    for (n = 1; n <= WMM_MAX_MODEL_DEGREES; n++) {
+        RelativeRadiusPower[n] = RelativeRadiusPower[n - 1] * (WMM_EARTH_RADIUS / CoordSpherical->r);
+    }
 
     MagneticResults->Bz = 0.0f;
     MagneticResults->By = 0.0f;
     MagneticResults->Bx = 0.0f;
 
-    for (n = 1; n <= MagneticModel->nMax; n++) {
-        for (m = 0; m <= n; m++) {
+    for (m = 0; m <= WMM_MAX_MODEL_DEGREES; m++) {
+        if (m > 0) {
+            tmp  = cos_phi * Pmm;
+            dPmm = cos_phi * dPmm + sin_phi * Pmm;
+            Pmm  = tmp;
+
+            /* cosf(a + b) = cosf(a)*cosf(b) - sinf(a)*sinf(b)
+               sinf(a + b) = cosf(a)*sinf(b) + sinf(a)*cosf(b) */
+            tmp = cos_mlambda * cos_lambda - sin_mlambda * sin_lambda;
+            sin_mlambda = cos_mlambda * sin_lambda + sin_mlambda * cos_lambda;
+            cos_mlambda = tmp;
+        }
+
+        P   = Pmm;
+        dP  = dPmm;
+        P1  = 0.0f; // degree n - 1
+        dP1 = 0.0f;
+        for (n = m; n <= WMM_MAX_MODEL_DEGREES; n++) {
             index = (n * (n + 1) / 2 + m);
+            if (n > m) {
+                /* k is zero for n = m + 1, where there is no degree n - 2 */
+                P2  = P1;
+                dP2 = dP1;
+                P1  = P;
+                dP1 = dP;
+                P   = sin_phi * P1 - LegendreK[index] * P2;
+                dP  = sin_phi * dP1 - cos_phi * P1 - LegendreK[index] * dP2;
+            }
+            if (n == 0) {
+                continue;
+            }
+
+            g   = CoeffFile[index][2] + dt * CoeffFile[index][4];
+            h   = CoeffFile[index][3] + dt * CoeffFile[index][5];
+            Ps  = P * SchmidtQuasiNorm[index];
+            dPs = -dP * SchmidtQuasiNorm[index];
+            gcos_hsin = RelativeRadiusPower[n] * (g * cos_mlambda + h * sin_mlambda);
 
 /*		    nMax        (n+2)     n     m            m           m
         Bz =   -SUM (a/r)   (n+1) SUM  [g cosf(m p) + h sinf(m p)] P (sinf(phi))
                         n=1                   m=0   n            n           n  */
 /* Equation 12 in the WMM Technical report.  Derivative with respect to radius.*/
-            MagneticResults->Bz -=
-                SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_main_field_coeff_g(index) *
-                 SphVariables->cos_mlambda[m] + WMM_get_main_field_coeff_h(index) * SphVariables->sin_mlambda[m])
-                * (float)(n + 1) * LegendreFunction->Pcup[index];
+            MagneticResults->Bz -= gcos_hsin * (float)(n + 1) * Ps;
 
 /*		  1 nMax  (n+2)    n     m            m           m
         By =    SUM (a/r) (m)  SUM  [g cosf(m p) + h sinf(m p)] dP (sinf(phi))
                    n=1             m=0   n            n           n  */
 /* Equation 11 in the WMM Technical report. Derivative with respect to longitude, divided by radius. */
-            MagneticResults->By +=
-                SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_main_field_coeff_g(index) *
-                 SphVariables->sin_mlambda[m] - WMM_get_main_field_coeff_h(index) * SphVariables->cos_mlambda[m])
-                * (float)(m) * LegendreFunction->Pcup[index];
+            MagneticResults->By += RelativeRadiusPower[n] * (g * sin_mlambda - h * cos_mlambda) * (float)(m) * Ps;
+
 /*		   nMax  (n+2) n     m            m           m
         Bx = - SUM (a/r)   SUM  [g cosf(m p) + h sinf(m p)] dP (sinf(phi))
                    n=1         m=0   n            n           n  */
 /* Equation 10  in the WMM Technical report. Derivative with respect to latitude, divided by radius. */
-
-            MagneticResults->Bx -=
-                SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_main_field_coeff_g(index) *
-                 SphVariables->cos_mlambda[m] + WMM_get_main_field_coeff_h(index) * SphVariables->sin_mlambda[m])
-                * LegendreFunction->dPcup[index];
+            MagneticResults->Bx -= gcos_hsin * dPs;
         }
     }
 
-    cos_phi = cosf(DEG2RAD(CoordSpherical->phig));
     if (fabsf(cos_phi) > 1.0e-10f) {
         MagneticResults->By = MagneticResults->By / cos_phi;
     } else {
         /* Special calculation for component - By - at Geographic poles.
          * If the user wants to avoid using this function,  please make sure that
-         * the latitude is not exactly +/-90. An option is to make use the function
-         * WMM_CheckGeographicPoles.
+         * the latitude is not exactly +/-90.
          */
-        if (WMM_SummationSpecial(SphVariables, CoordSpherical, MagneticResults) < 0) {
-            return -1; // error
-        }
+        MagneticResults->By = WMM_SummationSpecial(RelativeRadiusPower, sin_phi, cos_lambda, sin_lambda, dt);
     }
-
-    return 0; // OK
 }
 
-int WMM_SecVarSummation(WMMtype_LegendreFunction *LegendreFunction,
-                        WMMtype_SphericalHarmonicVariables *
-                        SphVariables, WMMtype_CoordSpherical *CoordSpherical, WMMtype_MagneticResults *MagneticResults)
-{
-    /*This Function sums the secular variation coefficients to get the secular variation of the Magnetic vector.
-       INPUT :  LegendreFunction
-       MagneticModel
-       SphVariables
-       CoordSpherical
-       OUTPUT : MagneticResults
-
-       CALLS : WMM_SecVarSummationSpecial
-
-     */
-
-    uint16_t m, n, index;
-    float cos_phi;
-
-    MagneticModel->SecularVariationUsed = TRUE;
-
-    MagneticResults->Bz = 0.0f;
-    MagneticResults->By = 0.0f;
-    MagneticResults->Bx = 0.0f;
-
-    for (n = 1; n <= MagneticModel->nMaxSecVar; n++) {
-        for (m = 0; m <= n; m++) {
-            index = (n * (n + 1) / 2 + m);
-
-/*		    nMax        (n+2)     n     m            m           m
-        Bz =   -SUM (a/r)   (n+1) SUM  [g cosf(m p) + h sinf(m p)] P (sinf(phi))
-                        n=1                   m=0   n            n           n  */
-/*  Derivative with respect to radius.*/
-            MagneticResults->Bz -=
-                SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_secular_var_coeff_g(index) *
-                 SphVariables->cos_mlambda[m] + WMM_get_secular_var_coeff_h(index) * SphVariables->sin_mlambda[m])
-                * (float)(n + 1) * LegendreFunction->Pcup[index];
-
-/*		  1 nMax  (n+2)    n     m            m           m
-        By =    SUM (a/r) (m)  SUM  [g cosf(m p) + h sinf(m p)] dP (sinf(phi))
-                   n=1             m=0   n            n           n  */
-/* Derivative with respect to longitude, divided by radius. */
-            MagneticResults->By +=
-                SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_secular_var_coeff_g(index) *
-                 SphVariables->sin_mlambda[m] - WMM_get_secular_var_coeff_h(index) * SphVariables->cos_mlambda[m])
-                * (float)(m) * LegendreFunction->Pcup[index];
-/*		   nMax  (n+2) n     m            m           m
-        Bx = - SUM (a/r)   SUM  [g cosf(m p) + h sinf(m p)] dP (sinf(phi))
-                   n=1         m=0   n            n           n  */
-/* Derivative with respect to latitude, divided by radius. */
-
-            MagneticResults->Bx -=
-                SphVariables->RelativeRadiusPower[n] *
-                (WMM_get_secular_var_coeff_g(index) *
-                 SphVariables->cos_mlambda[m] + WMM_get_secular_var_coeff_h(index) * SphVariables->sin_mlambda[m])
-                * LegendreFunction->dPcup[index];
-        }
-    }
-    cos_phi = cosf(DEG2RAD(CoordSpherical->phig));
-    if (fabsf(cos_phi) > 1.0e-10f) {
-        MagneticResults->By = MagneticResults->By / cos_phi;
-    } else {
-        /* Special calculation for component By at Geographic poles */
-        if (WMM_SecVarSummationSpecial(SphVariables, CoordSpherical, MagneticResults) < 0) {
-            return -1; // error
-        }
-    }
-
-    return 0; // OK
-}
-
-int WMM_RotateMagneticVector(WMMtype_CoordSpherical *CoordSpherical,
-                             WMMtype_CoordGeodetic *CoordGeodetic,
-                             WMMtype_MagneticResults *MagneticResultsSph, WMMtype_MagneticResults *MagneticResultsGeo)
-/* Rotate the Magnetic Vectors to Geodetic Coordinates
-   Manoj Nair, June, 2009 Manoj.C.Nair@Noaa.Gov
-   Equation 16, WMM Technical report
-
-   INPUT : CoordSpherical : Data structure WMMtype_CoordSpherical with the following elements
-   float lambda; ( longitude)
-   float phig; ( geocentric latitude )
-   float r;       ( distance from the center of the ellipsoid)
-
-   CoordGeodetic : Data structure WMMtype_CoordGeodetic with the following elements
-   float lambda; (longitude)
-   float phi; ( geodetic latitude)
-   float HeightAboveEllipsoid; (height above the ellipsoid (HaE) )
-   float HeightAboveGeoid;(height above the Geoid )
-
-   MagneticResultsSph : Data structure WMMtype_MagneticResults with the following elements
-   float Bx;     North
-   float By;       East
-   float Bz;    Down
-
-   OUTPUT: MagneticResultsGeo Pointer to the data structure WMMtype_MagneticResults, with the following elements
-   float Bx;     North
-   float By;       East
-   float Bz;    Down
-
-   CALLS : none
-
- */
-{
-    /* Difference between the spherical and Geodetic latitudes */
-    float Psi = DEG2RAD(CoordSpherical->phig - CoordGeodetic->phi);
-
-    /* Rotate spherical field components to the Geodeitic system */
-    MagneticResultsGeo->Bz = MagneticResultsSph->Bx * sinf(Psi) + MagneticResultsSph->Bz * cosf(Psi);
-    MagneticResultsGeo->Bx = MagneticResultsSph->Bx * cosf(Psi) - MagneticResultsSph->Bz * sinf(Psi);
-    MagneticResultsGeo->By = MagneticResultsSph->By;
-
-    return 0;
-}
-
-int WMM_CalculateGeoMagneticElements(WMMtype_MagneticResults *MagneticResultsGeo, WMMtype_GeoMagneticElements *GeoMagneticElements)
-/* Calculate all the Geomagnetic elements from X,Y and Z components
-   INPUT     MagneticResultsGeo   Pointer to data structure with the following elements
-   float Bx;    ( North )
-   float By;      ( East )
-   float Bz;    ( Down )
-   OUTPUT    GeoMagneticElements    Pointer to data structure with the following elements
-   float Decl; (Angle between the magnetic field vector and true north, positive east)
-   float Incl; Angle between the magnetic field vector and the horizontal plane, positive down
-   float F; Magnetic Field Strength
-   float H; Horizontal Magnetic Field Strength
-   float X; Northern component of the magnetic field vector
-   float Y; Eastern component of the magnetic field vector
-   float Z; Downward component of the magnetic field vector
-   CALLS : none
- */
-{
-    GeoMagneticElements->X    = MagneticResultsGeo->Bx;
-    GeoMagneticElements->Y    = MagneticResultsGeo->By;
-    GeoMagneticElements->Z    = MagneticResultsGeo->Bz;
-
-    GeoMagneticElements->H    = sqrtf(MagneticResultsGeo->Bx * MagneticResultsGeo->Bx + MagneticResultsGeo->By * MagneticResultsGeo->By);
-    GeoMagneticElements->F    = sqrtf(GeoMagneticElements->H * GeoMagneticElements->H + MagneticResultsGeo->Bz * MagneticResultsGeo->Bz);
-    GeoMagneticElements->Decl = RAD2DEG(atan2f(GeoMagneticElements->Y, GeoMagneticElements->X));
-    GeoMagneticElements->Incl = RAD2DEG(atan2f(GeoMagneticElements->Z, GeoMagneticElements->H));
-
-    return 0; // OK
-}
-
-int WMM_CalculateSecularVariation(WMMtype_MagneticResults *MagneticVariation, WMMtype_GeoMagneticElements *MagneticElements)
-/*This takes the Magnetic Variation in x, y, and z and uses it to calculate the secular variation of each of the Geomagnetic elements.
-        INPUT     MagneticVariation   Data structure with the following elements
-                                float Bx;    ( North )
-                                float By;	  ( East )
-                                float Bz;    ( Down )
-        OUTPUT   MagneticElements   Pointer to the data  structure with the following elements updated
-                        float Decldot; Yearly Rate of change in declination
-                        float Incldot; Yearly Rate of change in inclination
-                        float Fdot; Yearly rate of change in Magnetic field strength
-                        float Hdot; Yearly rate of change in horizontal field strength
-                        float Xdot; Yearly rate of change in the northern component
-                        float Ydot; Yearly rate of change in the eastern component
-                        float Zdot; Yearly rate of change in the downward component
-                        float GVdot;Yearly rate of chnage in grid variation
-        CALLS : none
-
- */
-{
-    MagneticElements->Xdot    = MagneticVariation->Bx;
-    MagneticElements->Ydot    = MagneticVariation->By;
-    MagneticElements->Zdot    = MagneticVariation->Bz;
-    MagneticElements->Hdot    = (MagneticElements->X * MagneticElements->Xdot + MagneticElements->Y * MagneticElements->Ydot) / MagneticElements->H;   // See equation 19 in the WMM technical report
-    MagneticElements->Fdot    =
-        (MagneticElements->X * MagneticElements->Xdot +
-         MagneticElements->Y * MagneticElements->Ydot + MagneticElements->Z * MagneticElements->Zdot) / MagneticElements->F;
-    MagneticElements->Decldot =
-        180.0f / M_PI_F * (MagneticElements->X * MagneticElements->Ydot -
-                           MagneticElements->Y * MagneticElements->Xdot) / (MagneticElements->H * MagneticElements->H);
-    MagneticElements->Incldot =
-        180.0f / M_PI_F * (MagneticElements->H * MagneticElements->Zdot -
-                           MagneticElements->Z * MagneticElements->Hdot) / (MagneticElements->F * MagneticElements->F);
-    MagneticElements->GVdot   = MagneticElements->Decldot;
-
-    return 0; // OK
-}
-
-int WMM_PcupHigh(float *Pcup, float *dPcup, float x, uint16_t nMax)
-/*	This function evaluates all of the Schmidt-semi normalized associated Legendre
-        functions up to degree nMax. The functions are initially scaled by
-        10^280 sinf^m in order to minimize the effects of underflow at large m
-        near the poles (see Holmes and Featherstone 2002, J. Geodesy, 76, 279-299).
-        Note that this function performs the same operation as WMM_PcupLow.
-        However this function also can be used for high degree (large nMax) models.
-
-        Calling Parameters:
-                INPUT
-                        nMax:	 Maximum spherical harmonic degree to compute.
-                        x:		cosf(colatitude) or sinf(latitude).
-
-                OUTPUT
-                        Pcup:	A vector of all associated Legendgre polynomials evaluated at
-                                        x up to nMax. The lenght must by greater or equal to (nMax+1)*(nMax+2)/2.
-                  dPcup:   Derivative of Pcup(x) with respect to latitude
-
-                CALLS : none
-        Notes:
-
-   Adopted from the FORTRAN code written by Mark Wieczorek September 25, 2005.
-
-   Manoj Nair, Nov, 2009 Manoj.C.Nair@Noaa.Gov
-
-   Change from the previous version
-   The prevous version computes the derivatives as
-   dP(n,m)(x)/dx, where x = sinf(latitude) (or cosf(colatitude) ).
-   However, the WMM Geomagnetic routines requires dP(n,m)(x)/dlatitude.
-   Hence the derivatives are multiplied by sinf(latitude).
-   Removed the options for CS phase and normalizations.
-
-   Note: In geomagnetism, the derivatives of ALF are usually found with
-   respect to the colatitudes. Here the derivatives are found with respect
-   to the latitude. The difference is a sign reversal for the derivative of
-   the Associated Legendre Functions.
-
-   The derivates can't be computed for latitude = |90| degrees.
- */
-{
-    uint16_t k, kstart, m, n;
-    float pm2, pm1, pmm, plm, rescalem, z, scalef;
-
-    float *f1     = (float *)MALLOC(sizeof(float) * NUMPCUP);
-    float *f2     = (float *)MALLOC(sizeof(float) * NUMPCUP);
-    float *PreSqr = (float *)MALLOC(sizeof(float) * NUMPCUP);
-
-    if (!PreSqr || !f2 || !f1) { // memory allocation error
-        if (PreSqr) {
-            FREE(PreSqr);
-        }
-        if (f2) {
-            FREE(f2);
-        }
-        if (f1) {
-            FREE(f1);
-        }
-
-        return -1;
-    }
-
-    /*
-     * Note: OP code change to avoid floating point equality test.
-     * Was: if (fabs(x) == 1.0)
-     */
-    if (fabsf(x) - 1.0f < 1e-9f) {
-        FREE(PreSqr);
-        FREE(f2);
-        FREE(f1);
-
-        // printf("Error in PcupHigh: derivative cannot be calculated at poles\n");
-        return -2;
-    }
-
-    /* OP Change: 1.0e-280 is too small to store in a float - the compiler truncates
-     * it to 0.0f, which is bad as the code below divides by scalef. */
-    scalef = 1.0e-20f;
-
-    for (n = 0; n <= 2 * nMax + 1; ++n) {
-        PreSqr[n] = sqrtf((float)(n));
-    }
-
-    k = 2;
-
-    for (n = 2; n <= nMax; n++) {
-        k     = k + 1;
-        f1[k] = (float)(2 * n - 1) / (float)(n);
-        f2[k] = (float)(n - 1) / (float)(n);
-        for (m = 1; m <= n - 2; m++) {
-            k     = k + 1;
-            f1[k] = (float)(2 * n - 1) / PreSqr[n + m] / PreSqr[n - m];
-            f2[k] = PreSqr[n - m - 1] * PreSqr[n + m - 1] / PreSqr[n + m] / PreSqr[n - m];
-        }
-        k = k + 2;
-    }
-
-    /*z = sinf (geocentric latitude) */
-    z        = sqrtf((1.0f - x) * (1.0f + x));
-    pm2      = 1.0f;
-    Pcup[0]  = 1.0f;
-    dPcup[0] = 0.0f;
-    if (nMax == 0) {
-        FREE(PreSqr);
-        FREE(f2);
-        FREE(f1);
-        return -3;
-    }
-    pm1      = x;
-    Pcup[1]  = pm1;
-    dPcup[1] = z;
-    k = 1;
-
-    for (n = 2; n <= nMax; n++) {
-        k        = k + n;
-        plm      = f1[k] * x * pm1 - f2[k] * pm2;
-        Pcup[k]  = plm;
-        dPcup[k] = (float)(n) * (pm1 - x * plm) / z;
-        pm2      = pm1;
-        pm1      = plm;
-    }
-
-    pmm      = PreSqr[2] * scalef;
-    rescalem = 1.0f / scalef;
-    kstart   = 0;
-
-    for (m = 1; m <= nMax - 1; ++m) {
-        rescalem      = rescalem * z;
-
-        /* Calculate Pcup(m,m) */
-        kstart        = kstart + m + 1;
-        pmm = pmm * PreSqr[2 * m + 1] / PreSqr[2 * m];
-        Pcup[kstart]  = pmm * rescalem / PreSqr[2 * m + 1];
-        dPcup[kstart] = -((float)(m) * x * Pcup[kstart] / z);
-        pm2      = pmm / PreSqr[2 * m + 1];
-        /* Calculate Pcup(m+1,m) */
-        k        = kstart + m + 1;
-        pm1      = x * PreSqr[2 * m + 1] * pm2;
-        Pcup[k]  = pm1 * rescalem;
-        dPcup[k] = ((pm2 * rescalem) * PreSqr[2 * m + 1] - x * (float)(m + 1) * Pcup[k]) / z;
-        /* Calculate Pcup(n,m) */
-        for (n = m + 2; n <= nMax; ++n) {
-            k        = k + n;
-            plm      = x * f1[k] * pm1 - f2[k] * pm2;
-            Pcup[k]  = plm * rescalem;
-            dPcup[k] = (PreSqr[n + m] * PreSqr[n - m] * (pm1 * rescalem) - (float)(n) * x * Pcup[k]) / z;
-            pm2      = pm1;
-            pm1      = plm;
-        }
-    }
-
-    /* Calculate Pcup(nMax,nMax) */
-    rescalem      = rescalem * z;
-    kstart        = kstart + m + 1;
-    pmm = pmm / PreSqr[2 * nMax];
-    Pcup[kstart]  = pmm * rescalem;
-    dPcup[kstart] = -(float)(nMax) * x * Pcup[kstart] / z;
-
-    // *********
-    // free allocated memory
-
-    FREE(PreSqr);
-    FREE(f2);
-    FREE(f1);
-
-    // *********
-
-    return 0; // OK
-}
-
-int WMM_PcupLow(float *Pcup, float *dPcup, float x, uint16_t nMax)
-/*   This function evaluates all of the Schmidt-semi normalized associated Legendre
-        functions up to degree nMax.
-
-        Calling Parameters:
-                INPUT
-                        nMax:	 Maximum spherical harmonic degree to compute.
-                        x:		cosf(colatitude) or sinf(latitude).
-
-                OUTPUT
-                        Pcup:	A vector of all associated Legendgre polynomials evaluated at
-                                        x up to nMax.
-                   dPcup: Derivative of Pcup(x) with respect to latitude
-
-        Notes: Overflow may occur if nMax > 20 , especially for high-latitudes.
-        Use WMM_PcupHigh for large nMax.
-
-   Writted by Manoj Nair, June, 2009 . Manoj.C.Nair@Noaa.Gov.
-
-   Note: In geomagnetism, the derivatives of ALF are usually found with
-   respect to the colatitudes. Here the derivatives are found with respect
-   to the latitude. The difference is a sign reversal for the derivative of
-   the Associated Legendre Functions.
- */
-{
-    uint16_t n, m, index, index1, index2;
-    float k, z;
-
-    float *schmidtQuasiNorm = (float *)MALLOC(sizeof(float) * NUMPCUP);
-
-    if (!schmidtQuasiNorm) { // memory allocation error
-        return -1;
-    }
-
-    Pcup[0]  = 1.0f;
-    dPcup[0] = 0.0f;
-
-    /*sinf (geocentric latitude) - sin_phi */
-    z = sqrtf((1.0f - x) * (1.0f + x));
-
-    /*       First, Compute the Gauss-normalized associated Legendre  functions */
-    for (n = 1; n <= nMax; n++) {
-        for (m = 0; m <= n; m++) {
-            index = (n * (n + 1) / 2 + m);
-            if (n == m) {
-                index1 = (n - 1) * n / 2 + m - 1;
-                Pcup[index] = z * Pcup[index1];
-                dPcup[index] = z * dPcup[index1] + x * Pcup[index1];
-            } else if (n == 1 && m == 0) {
-                index1 = (n - 1) * n / 2 + m;
-                Pcup[index] = x * Pcup[index1];
-                dPcup[index] = x * dPcup[index1] - z * Pcup[index1];
-            } else if (n > 1 && n != m) {
-                index1 = (n - 2) * (n - 1) / 2 + m;
-                index2 = (n - 1) * n / 2 + m;
-                if (m > n - 2) {
-                    Pcup[index]  = x * Pcup[index2];
-                    dPcup[index] = x * dPcup[index2] - z * Pcup[index2];
-                } else {
-                    k = (float)(((n - 1) * (n - 1)) - (m * m)) / (float)((2 * n - 1)
-                                                                         * (2 * n - 3));
-                    Pcup[index]  = x * Pcup[index2] - k * Pcup[index1];
-                    dPcup[index] = x * dPcup[index2] - z * Pcup[index2] - k * dPcup[index1];
-                }
-            }
-        }
-    }
-/*Compute the ration between the Gauss-normalized associated Legendre
-   functions and the Schmidt quasi-normalized version. This is equivalent to
-   sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!  */
-
-    schmidtQuasiNorm[0] = 1.0f;
-    for (n = 1; n <= nMax; n++) {
-        index  = (n * (n + 1) / 2);
-        index1 = (n - 1) * n / 2;
-        /* for m = 0 */
-        schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * (float)(2 * n - 1) / (float)n;
-
-        for (m = 1; m <= n; m++) {
-            index  = (n * (n + 1) / 2 + m);
-            index1 = (n * (n + 1) / 2 + m - 1);
-            schmidtQuasiNorm[index] = schmidtQuasiNorm[index1] * sqrtf((float)((n - m + 1) * (m == 1 ? 2 : 1)) / (float)(n + m));
-        }
-    }
-
-/* Converts the  Gauss-normalized associated Legendre
-          functions to the Schmidt quasi-normalized version using pre-computed
-          relation stored in the variable schmidtQuasiNorm */
-
-    for (n = 1; n <= nMax; n++) {
-        for (m = 0; m <= n; m++) {
-            index = (n * (n + 1) / 2 + m);
-            Pcup[index]  = Pcup[index] * schmidtQuasiNorm[index];
-            dPcup[index] = -dPcup[index] * schmidtQuasiNorm[index];
-            /* The sign is changed since the new WMM routines use derivative with respect to latitude
-               insted of co-latitude */
-        }
-    }
-
-    FREE(schmidtQuasiNorm);
-
-    return 0; // OK
-}
-
-int WMM_SummationSpecial(WMMtype_SphericalHarmonicVariables *
-                         SphVariables, WMMtype_CoordSpherical *CoordSpherical, WMMtype_MagneticResults *MagneticResults)
+float WMM_SummationSpecial(const float RelativeRadiusPower[], float sin_phi, float cos_lambda, float sin_lambda, float dt)
 /* Special calculation for the component By at Geographic poles.
    Manoj Nair, June, 2009 manoj.c.nair@noaa.gov
-   INPUT: MagneticModel
-   SphVariables
-   CoordSpherical
-   OUTPUT: MagneticResults
-   CALLS : none
    See Section 1.4, "SINGULARITIES AT THE GEOGRAPHIC POLES", WMM Technical report
-
  */
 {
     uint16_t n, index;
-    float k, sin_phi;
-    float schmidtQuasiNorm1;
-    float schmidtQuasiNorm2;
-    float schmidtQuasiNorm3;
-
-    float *PcupS = (float *)MALLOC(sizeof(float) * NUMPCUPS);
-
-    if (!PcupS) {
-        return -1; // memory allocation error
-    }
-    PcupS[0] = 1;
-    schmidtQuasiNorm1   = 1.0f;
-
-    MagneticResults->By = 0.0f;
-    sin_phi = sinf(DEG2RAD(CoordSpherical->phig));
+    float k, g, h;
+    float By = 0.0f;
+    float PcupS[NUMPCUPS];
 
-    for (n = 1; n <= MagneticModel->nMax; n++) {
-        /*Compute the ration between the Gauss-normalized associated Legendre
-           functions and the Schmidt quasi-normalized version. This is equivalent to
-           sqrt((m==0?1:2)*(n-m)!/(n+m!))*(2n-1)!!/(n-m)!  */
+    PcupS[0] = 1.0f;
 
+    for (n = 1; n <= WMM_MAX_MODEL_DEGREES; n++) {
         index = (n * (n + 1) / 2 + 1);
-        schmidtQuasiNorm2 = schmidtQuasiNorm1 * (float)(2 * n - 1) / (float)n;
-        schmidtQuasiNorm3 = schmidtQuasiNorm2 * sqrtf((float)(n * 2) / (float)(n + 1));
-        schmidtQuasiNorm1 = schmidtQuasiNorm2;
         if (n == 1) {
             PcupS[n] = PcupS[n - 1];
         } else {
@@ -1089,162 +468,34 @@ int WMM_SummationSpecial(WMMtype_SphericalHarmonicVariables *
             PcupS[n] = sin_phi * PcupS[n - 1] - k * PcupS[n - 2];
         }
 
-/*		  1 nMax  (n+2)    n     m            m           m
-        By =    SUM (a/r) (m)  SUM  [g cosf(m p) + h sinf(m p)] dP (sinf(phi))
-                   n=1             m=0   n            n           n  */
-/* Equation 11 in the WMM Technical report. Derivative with respect to longitude, divided by radius. */
-
-        MagneticResults->By +=
-            SphVariables->RelativeRadiusPower[n] *
-            (WMM_get_main_field_coeff_g(index) *
-             SphVariables->sin_mlambda[1] - WMM_get_main_field_coeff_h(index) * SphVariables->cos_mlambda[1])
-            * PcupS[n] * schmidtQuasiNorm3;
-    }
-
-    FREE(PcupS);
-
-    return 0; // OK
-}
-
-int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
-                               SphVariables, WMMtype_CoordSpherical *CoordSpherical, WMMtype_MagneticResults *MagneticResults)
-{
-    /*Special calculation for the secular variation summation at the poles.
-
-       INPUT: MagneticModel
-       SphVariables
-       CoordSpherical
-       OUTPUT: MagneticResults
-       CALLS : none
-
-     */
-    uint16_t n, index;
-    float k, sin_phi;
-    float schmidtQuasiNorm1;
-    float schmidtQuasiNorm2;
-    float schmidtQuasiNorm3;
-
-    float *PcupS = (float *)MALLOC(sizeof(float) * NUMPCUPS);
+        g   = CoeffFile[index][2] + dt * CoeffFile[index][4];
+        h   = CoeffFile[index][3] + dt * CoeffFile[index][5];
 
-    if (!PcupS) {
-        return -1; // memory allocation error
-    }
-    PcupS[0] = 1;
-    schmidtQuasiNorm1   = 1.0f;
-
-    MagneticResults->By = 0.0f;
-    sin_phi = sinf(DEG2RAD(CoordSpherical->phig));
-
-    for (n = 1; n <= MagneticModel->nMaxSecVar; n++) {
-        index = (n * (n + 1) / 2 + 1);
-        schmidtQuasiNorm2 = schmidtQuasiNorm1 * (float)(2 * n - 1) / (float)n;
-        schmidtQuasiNorm3 = schmidtQuasiNorm2 * sqrtf((float)(n * 2) / (float)(n + 1));
-        schmidtQuasiNorm1 = schmidtQuasiNorm2;
-        if (n == 1) {
-            PcupS[n] = PcupS[n - 1];
-        } else {
-            k = (float)(((n - 1) * (n - 1)) - 1) / (float)((2 * n - 1) * (2 * n - 3));
-            PcupS[n] = sin_phi * PcupS[n - 1] - k * PcupS[n - 2];
-        }
-
-/*		  1 nMax  (n+2)    n     m            m           m
-        By =    SUM (a/r) (m)  SUM  [g cosf(m p) + h sinf(m p)] dP (sinf(phi))
-                   n=1             m=0   n            n           n  */
-/* Derivative with respect to longitude, divided by radius. */
-
-        MagneticResults->By +=
-            SphVariables->RelativeRadiusPower[n] *
-            (WMM_get_secular_var_coeff_g(index) *
-             SphVariables->sin_mlambda[1] - WMM_get_secular_var_coeff_h(index) * SphVariables->cos_mlambda[1])
-            * PcupS[n] * schmidtQuasiNorm3;
+/* Equation 11 in the WMM Technical report. Derivative with respect to longitude, divided by radius. */
+        By += RelativeRadiusPower[n] * (g * sin_lambda - h * cos_lambda) * PcupS[n] * SchmidtQuasiNorm[index];
     }
 
-    FREE(PcupS);
-
-    return 0; // OK
+    return By;
 }
 
-/**
- * @brief Comput the MainFieldCoeffH accounting for the date
+void WMM_RotateMagneticVector(const WMMtype_CoordSpherical *CoordSpherical,
+                              const WMMtype_CoordGeodetic *CoordGeodetic,
+                              const WMMtype_MagneticResults *MagneticResultsSph, WMMtype_MagneticResults *MagneticResultsGeo)
+/* Rotate the Magnetic Vectors to Geodetic Coordinates
+   Manoj Nair, June, 2009 Manoj.C.Nair@Noaa.Gov
+   Equation 16, WMM Technical report
  */
-float WMM_get_main_field_coeff_g(uint16_t index)
-{
-    if (index >= NUMTERMS) {
-        return 0;
-    }
-
-    uint16_t n, m, sum_index, a, b;
-
-    float coeff = CoeffFile[index][2];
-
-    a = MagneticModel->nMaxSecVar;
-    b = (a * (a + 1) / 2 + a);
-    for (n = 1; n <= MagneticModel->nMax; n++) {
-        for (m = 0; m <= n; m++) {
-            sum_index = (n * (n + 1) / 2 + m);
-
-            /* Hacky for now, will solve for which conditions need summing analytically */
-            if (sum_index != index) {
-                continue;
-            }
-
-            if (index <= b) {
-                coeff += (decimal_date - MagneticModel->epoch) * WMM_get_secular_var_coeff_g(sum_index);
-            }
-        }
-    }
-
-    return coeff;
-}
-
-float WMM_get_main_field_coeff_h(uint16_t index)
-{
-    if (index >= NUMTERMS) {
-        return 0;
-    }
-
-    uint16_t n, m, sum_index, a, b;
-    float coeff = CoeffFile[index][3];
-
-    a = MagneticModel->nMaxSecVar;
-    b = (a * (a + 1) / 2 + a);
-    for (n = 1; n <= MagneticModel->nMax; n++) {
-        for (m = 0; m <= n; m++) {
-            sum_index = (n * (n + 1) / 2 + m);
-
-            /* Hacky for now, will solve for which conditions need summing analytically */
-            if (sum_index != index) {
-                continue;
-            }
-
-            if (index <= b) {
-                coeff += (decimal_date - MagneticModel->epoch) * WMM_get_secular_var_coeff_h(sum_index);
-            }
-        }
-    }
-
-    return coeff;
-}
-
-float WMM_get_secular_var_coeff_g(uint16_t index)
-{
-    if (index >= NUMTERMS) {
-        return 0;
-    }
-
-    return CoeffFile[index][4];
-}
-
-float WMM_get_secular_var_coeff_h(uint16_t index)
 {
-    if (index >= NUMTERMS) {
-        return 0;
-    }
+    /* Difference between the spherical and Geodetic latitudes */
+    float Psi = DEG2RAD(CoordSpherical->phig - CoordGeodetic->phi);
 
-    return CoeffFile[index][5];
+    /* Rotate spherical field components to the Geodeitic system */
+    MagneticResultsGeo->Bz = MagneticResultsSph->Bx * sinf(Psi) + MagneticResultsSph->Bz * cosf(Psi);
+    MagneticResultsGeo->Bx = MagneticResultsSph->Bx * cosf(Psi) - MagneticResultsSph->Bz * sinf(Psi);
+    MagneticResultsGeo->By = MagneticResultsSph->By;
 }
 
-int WMM_DateToYear(uint16_t month, uint16_t day, uint16_t year)
+int WMM_DateToYear(uint16_t month, uint16_t day, uint16_t year, float *DecimalYear)
 // Converts a given calendar date into a decimal year
 {
     uint16_t temp     = 0;      // Total number of days
@@ -1271,12 +522,12 @@ int WMM_DateToYear(uint16_t month, uint16_t day, uint16_t year)
     }
     temp += day;
 
-    decimal_date = year + (temp - 1) / (365.0f + ExtraDay);
+    *DecimalYear = year + (temp - 1) / (365.0f + ExtraDay);
 
     return 0; // OK
 }
 
-int WMM_GeodeticToSpherical(WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_CoordSpherical *CoordSpherical)
+void WMM_GeodeticToSpherical(const WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_CoordSpherical *CoordSpherical)
 // Converts Geodetic coordinates to Spherical coordinates
 // Convert geodetic coordinates, (defined by the WGS-84
 // reference ellipsoid), to Earth Centered Earth Fixed Cartesian
@@ -1288,18 +539,16 @@ int WMM_GeodeticToSpherical(WMMtype_CoordGeodetic *CoordGeodetic, WMMtype_CoordS
     SinLat = sinf(DEG2RAD(CoordGeodetic->phi));
 
     // compute the local radius of curvature on the WGS-84 reference ellipsoid
-    rc     = Ellip->a / sqrtf(1.0f - Ellip->epssq * SinLat * SinLat);
+    rc     = WMM_ELLIPSOID_A / sqrtf(1.0f - WMM_ELLIPSOID_EPSSQ * SinLat * SinLat);
 
     // compute ECEF Cartesian coordinates of specified point (for longitude=0)
 
     xp = (rc + CoordGeodetic->HeightAboveEllipsoid) * CosLat;
-    zp = (rc * (1.0f - Ellip->epssq) + CoordGeodetic->HeightAboveEllipsoid) * SinLat;
+    zp = (rc * (1.0f - WMM_ELLIPSOID_EPSSQ) + CoordGeodetic->HeightAboveEllipsoid) * SinLat;
 
     // compute spherical radius and angle lambda and phi of specified point
 
     CoordSpherical->r      = sqrtf(xp * xp + zp * zp);
     CoordSpherical->phig   = RAD2DEG(asinf(zp / CoordSpherical->r));  // geocentric latitude
     CoordSpherical->lambda = CoordGeodetic->lambda; // longitude
-
-    return 0; // OK
 }
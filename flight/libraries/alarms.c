@@ -40,10 +40,22 @@
 // Private types
 
 // Private variables
+/*
+ * The alarm states are kept here and SystemAlarms is only written when one of them
+ * actually changes. Each state is a single byte, so it is read and written without
+ * locking; the lock only serialises the publication of the object.
+ * A writer stores its state before it publishes, and the object is copied
+ * from the states under the lock, so the last publication holds every change.
+ */
 static xSemaphoreHandle lock;
+static volatile uint8_t severities[SYSTEMALARMS_ALARM_NUMELEM];
+static volatile uint8_t extendedStatus[SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM];
+static volatile uint8_t extendedSubStatus[SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM];
 static volatile uint16_t lastAlarmChange[SYSTEMALARMS_ALARM_NUMELEM] = { 0 }; // this deliberately overflows every 2^16 milliseconds to save memory
 
 // Private functions
+static bool needsChange(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity, uint16_t flightTime);
+static void publish(void);
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
 
 /**
@@ -51,12 +63,22 @@ static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
  */
 int32_t AlarmsInitialize(void)
 {
+    SystemAlarmsData alarms;
+
     SystemAlarmsInitialize();
 
     lock = xSemaphoreCreateRecursiveMutex();
     // do not change the default states of the alarms, let the init code generated by the uavobjectgenerator handle that
     // AlarmsClearAll();
     // AlarmsDefaultAll();
+    SystemAlarmsGet(&alarms);
+    for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n) {
+        severities[n] = SystemAlarmsAlarmToArray(alarms.Alarm)[n];
+    }
+    for (uint32_t n = 0; n < SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM; ++n) {
+        extendedStatus[n]    = SystemAlarmsExtendedAlarmStatusToArray(alarms.ExtendedAlarmStatus)[n];
+        extendedSubStatus[n] = SystemAlarmsExtendedAlarmSubStatusToArray(alarms.ExtendedAlarmSubStatus)[n];
+    }
     return 0;
 }
 
@@ -68,29 +90,18 @@ int32_t AlarmsInitialize(void)
  */
 int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity)
 {
-    SystemAlarmsAlarmData alarms;
-
     // Check that this is a valid alarm
     if (alarm >= SYSTEMALARMS_ALARM_NUMELEM) {
         return -1;
     }
 
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
-
-    // Read alarm and update its severity only if it was changed
-    SystemAlarmsAlarmGet(&alarms);
+    // Update its severity only if it was changed
     uint16_t flightTime = (uint16_t)xTaskGetTickCount() * (uint16_t)portTICK_RATE_MS; // this deliberately overflows every 2^16 milliseconds to save memory
-    if (((uint16_t)(flightTime - lastAlarmChange[alarm]) > PIOS_ALARM_GRACETIME &&
-         SystemAlarmsAlarmToArray(alarms)[alarm] != severity)
-        || SystemAlarmsAlarmToArray(alarms)[alarm] < severity) {
-        SystemAlarmsAlarmToArray(alarms)[alarm] = severity;
+    if (needsChange(alarm, severity, flightTime)) {
+        severities[alarm]      = severity;
         lastAlarmChange[alarm] = flightTime;
-        SystemAlarmsAlarmSet(&alarms);
+        publish();
     }
-
-    // Release lock
-    xSemaphoreGiveRecursive(lock);
     return 0;
 }
 
@@ -107,32 +118,51 @@ int32_t ExtendedAlarmsSet(SystemAlarmsAlarmElem alarm,
                           SystemAlarmsExtendedAlarmStatusOptions status,
                           uint8_t subStatus)
 {
-    SystemAlarmsData alarms;
-
     // Check that this is a valid alarm
     if (alarm >= SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM) {
         return -1;
     }
 
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
-
-    // Read alarm and update its severity only if it was changed
-    SystemAlarmsGet(&alarms);
+    // Update its severity only if it was changed
     uint16_t flightTime = (uint16_t)xTaskGetTickCount() * (uint16_t)portTICK_RATE_MS; // this deliberately overflows every 2^16 milliseconds to save memory
-    if (((uint16_t)(flightTime - lastAlarmChange[alarm]) > PIOS_ALARM_GRACETIME &&
-         SystemAlarmsAlarmToArray(alarms.Alarm)[alarm] != severity)
-        || SystemAlarmsAlarmToArray(alarms.Alarm)[alarm] < severity) {
-        SystemAlarmsExtendedAlarmStatusToArray(alarms.ExtendedAlarmStatus)[alarm] = status;
-        SystemAlarmsExtendedAlarmSubStatusToArray(alarms.ExtendedAlarmSubStatus)[alarm] = subStatus;
-        SystemAlarmsAlarmToArray(alarms.Alarm)[alarm] = severity;
-        lastAlarmChange[alarm] = flightTime;
-        SystemAlarmsSet(&alarms);
+    if (needsChange(alarm, severity, flightTime)) {
+        extendedStatus[alarm]    = status;
+        extendedSubStatus[alarm] = subStatus;
+        severities[alarm]        = severity;
+        lastAlarmChange[alarm]   = flightTime;
+        publish();
     }
+    return 0;
+}
 
-    // Release lock
+/**
+ * An alarm is raised at once, lowered or changed only after the grace time
+ */
+static bool needsChange(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity, uint16_t flightTime)
+{
+    uint8_t current = severities[alarm];
+
+    return ((uint16_t)(flightTime - lastAlarmChange[alarm]) > PIOS_ALARM_GRACETIME && current != severity)
+           || current < severity;
+}
+
+/**
+ * Write the alarm states to SystemAlarms
+ */
+static void publish(void)
+{
+    SystemAlarmsData alarms;
+
+    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
+    for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n) {
+        SystemAlarmsAlarmToArray(alarms.Alarm)[n] = severities[n];
+    }
+    for (uint32_t n = 0; n < SYSTEMALARMS_EXTENDEDALARMSTATUS_NUMELEM; ++n) {
+        SystemAlarmsExtendedAlarmStatusToArray(alarms.ExtendedAlarmStatus)[n] = extendedStatus[n];
+        SystemAlarmsExtendedAlarmSubStatusToArray(alarms.ExtendedAlarmSubStatus)[n] = extendedSubStatus[n];
+    }
+    SystemAlarmsSet(&alarms);
     xSemaphoreGiveRecursive(lock);
-    return 0;
 }
 
 /**
@@ -142,16 +172,12 @@ int32_t ExtendedAlarmsSet(SystemAlarmsAlarmElem alarm,
  */
 SystemAlarmsAlarmOptions AlarmsGet(SystemAlarmsAlarmElem alarm)
 {
-    SystemAlarmsAlarmData alarms;
-
     // Check that this is a valid alarm
     if (alarm >= SYSTEMALARMS_ALARM_NUMELEM) {
         return 0;
     }
 
-    // Read alarm
-    SystemAlarmsAlarmGet(&alarms);
-    return SystemAlarmsAlarmToArray(alarms)[alarm];
+    return severities[alarm];
 }
 
 /**
@@ -233,24 +259,14 @@ int32_t AlarmsHasCritical()
  */
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity)
 {
-    SystemAlarmsAlarmData alarms;
-
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
-
-    // Read alarms
-    SystemAlarmsAlarmGet(&alarms);
-
     // Go through alarms and check if any are of the given severity or higher
     for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n) {
-        if (SystemAlarmsAlarmToArray(alarms)[n] >= severity) {
-            xSemaphoreGiveRecursive(lock);
+        if (severities[n] >= severity) {
             return 1;
         }
     }
 
     // If this point is reached then no alarms found
-    xSemaphoreGiveRecursive(lock);
     return 0;
 }
 /**
@@ -259,25 +275,17 @@ static int32_t hasSeverity(SystemAlarmsAlarmOptions severity)
  */
 SystemAlarmsAlarmOptions AlarmsGetHighestSeverity()
 {
-    SystemAlarmsAlarmData alarmsData;
     SystemAlarmsAlarmOptions highest = SYSTEMALARMS_ALARM_UNINITIALISED;
 
-    // Lock
-    xSemaphoreTakeRecursive(lock, portMAX_DELAY);
-
-    // Read alarms
-    SystemAlarmsAlarmGet(&alarmsData);
-
     // Go through alarms and find the highest severity
     uint32_t n = 0;
     while (n < SYSTEMALARMS_ALARM_NUMELEM && highest != SYSTEMALARMS_ALARM_CRITICAL) {
-        if (SystemAlarmsAlarmToArray(alarmsData)[n] > highest) {
-            highest = SystemAlarmsAlarmToArray(alarmsData)[n];
+        if (severities[n] > highest) {
+            highest = severities[n];
         }
         n++;
     }
 
-    xSemaphoreGiveRecursive(lock);
     return highest;
 }
 
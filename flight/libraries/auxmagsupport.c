@@ -4,7 +4,8 @@
  * @file       auxmagsupport.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
  * @brief      Functions to handle aux mag data and calibration.
- *             --
+ *             The online calibration fits an ellipsoid to the raw samples
+ *             in a low priority callback, see magfit.c
  * @see        The GNU Public License (GPL) Version 3
  *
  *****************************************************************************/
@@ -27,32 +28,102 @@
 #include <stdint.h>
 #include "inc/auxmagsupport.h"
 #include "CoordinateConversions.h"
+#include <mathmisc.h>
+#include <magfit.h>
+#include <auxmagcalibration.h>
+#include <callbackinfo.h>
+#include <homelocation.h>
+
+#define CALIBRATION_STACK_SIZE_BYTES 512
+#define CALIBRATION_PRIORITY         CALLBACK_PRIORITY_LOW
+#define CALIBRATION_TASK_PRIORITY    CALLBACK_TASK_AUXILIARY
+// the fit is trusted once it saw most directions and predicts the field length
+#define CALIBRATION_MIN_SAMPLES      100
+#define CALIBRATION_MIN_COVERAGE     6
+#define CALIBRATION_MAX_RESIDUAL     0.03f
 
 static float mag_bias[3] = { 0, 0, 0 };
 static float mag_transform[3][3] = {
     { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 }
 };
+static float mag_rotation[3][3];
 
 AuxMagSettingsTypeOptions option;
 
+// Online calibration, the publishing task hands one raw sample at a time to a
+// low priority callback, and takes the calibration it applies from it
+static AuxMagSettingsOnlineCalibrationOptions calibrationMode;
+static uint16_t calibrationMemory;
+static DelayedCallbackInfo *calibrationCallback;
+static struct magfit fit;
+static float fitScale; // mGau per unit of the fit, 0 until the first sample
+static bool fitFromHome; // fitScale is the field of the home location
+static float sample[3];
+static volatile bool fitting;
+static volatile bool restart;
+static float applyBias[3];
+static float applyTransform[3][3];
+static volatile bool applyPending;
+
+// Batched samples, replayed at the pace they were taken at
+static float queuedMags[AUXMAGSUPPORT_MAX_QUEUED][3];
+static uint16_t queuedOffset[AUXMAGSUPPORT_MAX_QUEUED]; // ms from the first sample
+static uint8_t queuedCount;
+static uint8_t queuedNext;
+static uint8_t queuedStatus;
+static uint32_t queuedStart; // PIOS_DELAY_GetRaw() at the first sample
+
+static void calibrationTask(void);
+
 void auxmagsupport_reload_settings()
 {
     AuxMagSettingsTypeGet(&option);
     float a[3][3];
-    float b[3][3];
     float rotz;
     AuxMagSettingsmag_transformArrayGet((float *)a);
     AuxMagSettingsOrientationGet(&rotz);
     rotz = DEG2RAD(rotz);
-    rot_about_axis_z(rotz, b);
-    matrix_mult_3x3f(a, b, mag_transform);
+    rot_about_axis_z(rotz, mag_rotation);
+    matrix_mult_3x3f(a, mag_rotation, mag_transform);
     AuxMagSettingsmag_biasArrayGet(mag_bias);
+    applyPending = false;
+
+    AuxMagSettingsOnlineCalibrationOptions mode;
+    AuxMagSettingsOnlineCalibrationGet(&mode);
+    AuxMagSettingsOnlineCalibrationMemoryGet(&calibrationMemory);
+    if (mode != AUXMAGSETTINGS_ONLINECALIBRATION_DISABLED && !calibrationCallback) {
+        AuxMagCalibrationInitialize();
+        calibrationCallback = PIOS_CALLBACKSCHEDULER_Create(&calibrationTask, CALIBRATION_PRIORITY, CALIBRATION_TASK_PRIORITY,
+                                                            CALLBACKINFO_RUNNING_AUXMAGCALIBRATION, CALIBRATION_STACK_SIZE_BYTES);
+    }
+    // a fit of an earlier session is not trusted, nor applied over new settings
+    if (mode != calibrationMode) {
+        restart = true;
+    }
+    calibrationMode = mode;
+    // publishes the disabled status
+    if (calibrationCallback && restart && mode == AUXMAGSETTINGS_ONLINECALIBRATION_DISABLED) {
+        PIOS_CALLBACKSCHEDULER_Dispatch(calibrationCallback);
+    }
 }
 
 void auxmagsupport_publish_samples(float mags[3], uint8_t status)
 {
     float mag_out[3];
 
+    if (calibrationCallback && calibrationMode != AUXMAGSETTINGS_ONLINECALIBRATION_DISABLED && !fitting) {
+        sample[0] = mags[0];
+        sample[1] = mags[1];
+        sample[2] = mags[2];
+        fitting   = true;
+        PIOS_CALLBACKSCHEDULER_Dispatch(calibrationCallback);
+    }
+    if (applyPending) {
+        memcpy(mag_bias, applyBias, sizeof(mag_bias));
+        memcpy(mag_transform, applyTransform, sizeof(mag_transform));
+        applyPending = false;
+    }
+
     mags[0] -= mag_bias[0];
     mags[1] -= mag_bias[1];
     mags[2] -= mag_bias[2];
@@ -66,7 +137,116 @@ void auxmagsupport_publish_samples(float mags[3], uint8_t status)
     AuxMagSensorSet(&data);
 }
 
+void auxmagsupport_queue_samples(float mags[][3], const uint16_t time[], uint8_t count, uint8_t status)
+{
+    // a batch never waits behind the previous one
+    while (queuedNext < queuedCount) {
+        auxmagsupport_publish_samples(queuedMags[queuedNext++], queuedStatus);
+    }
+
+    count = MIN(count, AUXMAGSUPPORT_MAX_QUEUED);
+    for (uint8_t i = 0; i < count; i++) {
+        memcpy(queuedMags[i], mags[i], sizeof(queuedMags[i]));
+        queuedOffset[i] = (uint16_t)(time[i] - time[0]);
+    }
+    queuedCount  = count;
+    queuedNext   = 0;
+    queuedStatus = status;
+    queuedStart  = PIOS_DELAY_GetRaw();
+    auxmagsupport_publish_queued();
+}
+
+bool auxmagsupport_publish_queued()
+{
+    if (queuedNext < queuedCount) {
+        const uint32_t elapsed = PIOS_DELAY_DiffuS(queuedStart) / 1000;
+        while (queuedNext < queuedCount && queuedOffset[queuedNext] <= elapsed) {
+            auxmagsupport_publish_samples(queuedMags[queuedNext++], queuedStatus);
+        }
+    }
+    return queuedNext < queuedCount;
+}
+
 AuxMagSettingsTypeOptions auxmagsupport_get_type()
 {
     return option;
 }
+
+/**
+ * Feeds the raw sample to the ellipsoid fit, publishes the calibration it
+ * gives and hands it to the publishing task if it is to be applied
+ */
+static void calibrationTask(void)
+{
+    AuxMagCalibrationData calibration;
+
+    if (restart) {
+        restart  = false;
+        fitScale = 0.0f;
+        magfit_init(&fit);
+    }
+    if (calibrationMode == AUXMAGSETTINGS_ONLINECALIBRATION_DISABLED) {
+        AuxMagCalibrationGet(&calibration);
+        calibration.Status = AUXMAGCALIBRATION_STATUS_DISABLED;
+        AuxMagCalibrationSet(&calibration);
+        fitting = false;
+        return;
+    }
+
+    // the fit works in units of the expected field, from the home location or the first sample
+    if (fitScale == 0.0f) {
+        uint8_t set;
+        float Be[3];
+        HomeLocationSetGet(&set);
+        HomeLocationBeGet(Be);
+        fitFromHome = (set == HOMELOCATION_SET_TRUE);
+        fitScale    = fitFromHome ? vector_lengthf(Be, 3) : vector_lengthf(sample, 3);
+        if (!(fitScale > 0.0f)) {
+            fitScale = 0.0f;
+            fitting  = false;
+            return;
+        }
+    }
+    const float scaled[3] = { sample[0] / fitScale, sample[1] / fitScale, sample[2] / fitScale };
+    const float lambda    = 1.0f - 1.0f / MAX(calibrationMemory, 10);
+    const bool taken = magfit_update(&fit, lambda, scaled);
+
+    // the sample can be refilled now
+    fitting = false;
+
+    struct magfit_solution solution;
+    if (!taken || !magfit_solution(&fit, &solution)) {
+        return;
+    }
+
+    // gains bring the field to the home location one, or keep its mean length without home location
+    const float radius = fitFromHome ? 1.0f : (solution.radius[0] + solution.radius[1] + solution.radius[2]) / 3.0f;
+    for (uint8_t i = 0; i < 3; i++) {
+        (&calibration.mag_bias.X)[i] = solution.center[i] * fitScale;
+        (&calibration.Gain.X)[i]     = radius / solution.radius[i];
+    }
+    calibration.Residual = solution.residual * 100.0f;
+    calibration.Coverage = solution.coverage;
+    calibration.Samples  = fit.samples;
+
+    const bool converged = fit.samples >= CALIBRATION_MIN_SAMPLES &&
+                           solution.coverage >= CALIBRATION_MIN_COVERAGE &&
+                           solution.residual < CALIBRATION_MAX_RESIDUAL;
+    if (!converged) {
+        calibration.Status = AUXMAGCALIBRATION_STATUS_COLLECTING;
+    } else if (calibrationMode != AUXMAGSETTINGS_ONLINECALIBRATION_APPLY) {
+        calibration.Status = AUXMAGCALIBRATION_STATUS_CONVERGED;
+    } else {
+        calibration.Status = AUXMAGCALIBRATION_STATUS_APPLIED;
+        if (!applyPending) {
+            // the gains act on the sensor axes, before the orientation
+            float gain[3][3] = {
+                { calibration.Gain.X, 0, 0 }, { 0, calibration.Gain.Y, 0 }, { 0, 0, calibration.Gain.Z }
+            };
+            memcpy(applyBias, &calibration.mag_bias, sizeof(applyBias));
+            matrix_mult_3x3f(mag_rotation, gain, applyTransform);
+            applyPending = true;
+        }
+    }
+    AuxMagCalibrationSet(&calibration);
+}
@@ -210,6 +210,19 @@ uint16_t fifoBuf_getData(t_fifo_buffer *buf, void *data, uint16_t len)
     return i; // return number of bytes copied
 }
 
+uint16_t fifoBuf_getContiguous(t_fifo_buffer *buf, uint8_t **data)
+{ // point at the data up to the wrap-around without removing it, fifoBuf_removeData() releases it
+    uint16_t rd = buf->rd;
+    uint16_t wr = buf->wr;
+
+    *data = buf->buf_ptr + rd;
+
+    if (wr < rd) {
+        return buf->buf_size - rd; // return number of contiguous bytes
+    }
+    return wr - rd;
+}
+
 uint16_t fifoBuf_putByte(t_fifo_buffer *buf, const uint8_t b)
 { // add a data byte to the buffer
     uint16_t wr        = buf->wr;
@@ -71,6 +71,23 @@ void LLA2Base(int32_t LLAi[3], double BaseECEF[3], float Rne[3][3], float NED[3]
 // ****** Express ECEF in a local NED Base Frame ********
 void ECEF2Base(double ECEF[3], double BaseECEF[3], float Rne[3][3], float NED[3]);
 
+// ****** Local tangent plane around a base LLA, single precision only ********
+typedef struct {
+    int32_t LLAi[3]; // latitude and longitude in 1e-7 deg, altitude in 1e-4 m
+    float   sinLat;
+    float   cosLat;
+    float   s; // sqrt(1 - e^2 * sin(lat)^2)
+    float   N; // prime vertical radius of curvature
+    float   Rne[3][3];
+    int32_t maxDLat; // extent of the valid region in 1e-7 deg
+    int32_t maxDLon;
+} LTPBase;
+
+void LTPBaseFromLLA(int32_t LLAi[3], float radius, LTPBase *base);
+
+// ****** Express LLA in the local NED frame of an LTP base, returns false outside of its radius ********
+bool LLA2LTP(const LTPBase *base, int32_t LLAi[3], float NED[3]);
+
 // ****** convert Rotation Matrix to Quaternion ********
 // ****** if R converts from e to b, q is rotation from e to b ****
 void R2Quaternion(float R[3][3], float q[4]);
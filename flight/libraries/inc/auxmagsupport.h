@@ -29,7 +29,7 @@
 #include <auxmagsettings.h>
 #include <auxmagsensor.h>
 /**
- * @brief reload Aux Mag settings
+ * @brief reload Aux Mag settings, starts the online calibration if enabled
  */
 void auxmagsupport_reload_settings();
 
@@ -40,6 +40,25 @@ void auxmagsupport_reload_settings();
  */
 void auxmagsupport_publish_samples(float mags[3], uint8_t status);
 
+#define AUXMAGSUPPORT_MAX_QUEUED 8
+
+/**
+ * @brief Queue a batch of Aux Magnetometer samples, published with the spacing
+ * they were taken at, see auxmagsupport_publish_queued(). The first one is
+ * published right away, as are the ones left from the previous batch.
+ * @param[in] mags  Mag samples in milliGauss, oldest first
+ * @param[in] time  Sample times in ms, low bits of the sender clock
+ * @param[in] count Number of samples, at most AUXMAGSUPPORT_MAX_QUEUED
+ * @param[in] status one of AuxMagSensorStatusOptions option
+ */
+void auxmagsupport_queue_samples(float mags[][3], const uint16_t time[], uint8_t count, uint8_t status);
+
+/**
+ * @brief Publish the queued samples that are due
+ * @return true if samples are left in the queue
+ */
+bool auxmagsupport_publish_queued();
+
 /**
  * @brief Get the Aux Mag settings Type option
  * @param[in] mags  Mag sample in milliGauss
@@ -48,6 +48,13 @@ typedef struct {
 #define COUNT   1
 #define DATA    5
 
+// Opt[1] of an Upload start packet, the firmware bank is not erased as a whole
+#define DFU_DELTA_UPLOAD     0x44454C54
+// Capability flags of a device, byte 16 of Rep_Capabilities
+#define DFU_CAP_SECTOR_DELTA 0x01
+// Sectors of the firmware bank which can be kept by a delta upload, the others are always rewritten
+#define DFU_MAX_SECTORS      128
+
 /* Exported functions ------------------------------------------------------- */
 void processComand(uint8_t *Receive_Buffer);
 void DataDownload(DownloadAction);
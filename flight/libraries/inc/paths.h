@@ -34,6 +34,25 @@ struct path_status {
     float correction_vector[3];
 };
 
+// geometry of a PathDesired that the follower needs on every iteration
+struct path_segment {
+    uint8_t Mode;
+    bool    mode3D;
+    float   Start[3];
+    float   End[3];
+    float   StartingVelocity;
+    float   EndingVelocity;
+    // End - Start, without the down component in 2D modes
+    float   vector[3];
+    float   direction[3];
+    float   length;
+    // circle modes: distance from the center End to Start and its angle in 0..2pi
+    float   radius;
+    float   start_angle;
+};
+
+void path_segment_init(struct path_segment *segment, const PathDesiredData *path);
+void path_segment_progress(const struct path_segment *segment, const float *cur_point, struct path_status *status);
 void path_progress(PathDesiredData *path, float *cur_point, struct path_status *status);
 
 #endif
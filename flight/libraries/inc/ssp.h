@@ -37,6 +37,16 @@
 #define SSP_RX_ACK        6
 #define SSP_RX_SYNCH      7
 
+// Windowed mode, negotiated with a synchronise request carrying
+// { SSP_SYNC_MAGIC, SSP_SYNC_VERSION, window, frame data length }, the ACK of
+// a board that supports it carries the values both ends will use. An empty
+// synchronise request, or ACK, keeps the stop-and-wait protocol.
+#define SSP_SYNC_MAGIC    0x57
+#define SSP_SYNC_VERSION  1
+#define SSP_SYNC_LENGTH   4
+#define SSP_MAX_WINDOW    8
+#define SSP_ACK_BUF_SIZE  (1 + 1 + SSP_SYNC_LENGTH + 2)
+
 typedef enum decodeState_ {
     decode_len1_e = 0,
     decode_seqNo_e,
@@ -68,6 +78,8 @@ typedef struct {
     int16_t (*pfSerialRead)(void); // function to call to read a byte from serial hardware
     void (*pfSerialWrite)(uint8_t); // function used to write a byte to serial hardware for transmission
     uint32_t (*pfGetTime)(void); // function returns time in number of seconds that has elapsed from a given reference point
+    uint8_t  rxWindow; // frames the host may send ahead of our ACKs, 0 keeps the stop-and-wait protocol
+    uint16_t (*pfRxSpace)(void); // optional, room left for received data, a frame that does not fit is not acknowledged
 } PortConfig_t;
 
 typedef struct Port_tag {
@@ -99,6 +111,10 @@ typedef struct Port_tag {
     uint32_t RxError;
     uint32_t TxError;
     uint16_t flags;
+    uint8_t  rxWindow; // largest window offered to the host
+    uint8_t  windowed; // the host negotiated the windowed mode
+    uint16_t (*pfRxSpace)(void);
+    uint8_t  ackBuf[SSP_ACK_BUF_SIZE]; // ACKs are built apart, txBuf may hold a packet still waiting for its own ACK
 } Port_t;
 
 /** Public Data **/
@@ -33,12 +33,20 @@
 #include <math.h>
 #include <stdint.h>
 #include <pios_math.h>
+#include <pios_mem.h>
 
 // constants/macros/typdefs
 #define NUMX 13 // number of states, X is the state vector
 #define NUMW 9 // number of plant noise inputs, w is disturbance noise vector
 #define NUMV 10 // number of measurements, v is the measurement noise vector
 #define NUMU 6 // number of deterministic inputs, U is the input vector
+#define NUMP (NUMX * (NUMX + 1) / 2) // number of independent terms of the symmetric covariance P
+
+// The Cortex-M4 builds keep only the upper triangle of the covariance, the
+// prediction and update only compute that half anyway
+#if defined(ARM_MATH_CM4) && !defined(INSGPS_DENSE_COVARIANCE)
+#define INSGPS_PACKED_COVARIANCE
+#endif
 
 // Private functions
 void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
@@ -52,6 +60,11 @@ void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
                  float G[NUMX][NUMW]);
 void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
 void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+void CovariancePredictionPacked(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                                float Q[NUMW], float dT, float P[NUMP]);
+void SerialUpdatePacked(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+                        float Y[NUMV], float P[NUMP], float X[NUMX],
+                        uint16_t SensorsUsed);
 
 // Private variables
 
@@ -84,6 +97,10 @@ static const int8_t GrowMax[NUMX] = { -1, -1, -1, 5, 5, 5, 2, 2, 2, 2, 6, 7, 8 }
 static const int8_t HrowMin[NUMV] = { 0, 1, 2, 3, 4, 5, 6, 6, 6, 2 };
 static const int8_t HrowMax[NUMV] = { 0, 1, 2, 3, 4, 5, 9, 9, 9, 2 };
 
+// packed upper triangle of P, row by row: P[i][j] with i <= j is at ProwStart[i] + j
+static const uint8_t ProwStart[NUMX] = { 0, 12, 23, 33, 42, 50, 57, 63, 68, 72, 75, 77, 78 };
+#define PIDX(i, j) ((i) <= (j) ? ProwStart[(i)] + (j) : ProwStart[(j)] + (i))
+
 static struct EKFData {
     // linearized system matrices
     float F[NUMX][NUMX];
@@ -92,12 +109,22 @@ static struct EKFData {
     // local magnetic unit vector in NED frame
     float Be[3];
     // covariance matrix and state vector
+#if defined(INSGPS_PACKED_COVARIANCE)
+    float P[NUMP];
+#else
     float P[NUMX][NUMX];
+#endif
     float X[NUMX];
     // input noise and measurement noise variances
     float Q[NUMW];
     float R[NUMV];
-} ekf;
+} ekf PIOS_MEM_FAST;
+
+#if defined(INSGPS_PACKED_COVARIANCE)
+#define EKF_P(i, j) ekf.P[PIDX(i, j)]
+#else
+#define EKF_P(i, j) ekf.P[i][j]
+#endif
 
 // Global variables
 struct NavStruct Nav;
@@ -118,7 +145,7 @@ void INSGPSInit() // pretty much just a place holder for now
 
     for (int i = 0; i < NUMX; i++) {
         for (int j = 0; j < NUMX; j++) {
-            ekf.P[i][j] = 0.0f; // zero all terms
+            EKF_P(i, j) = 0.0f; // zero all terms
             ekf.F[i][j] = 0.0f;
         }
 
@@ -140,10 +167,10 @@ void INSGPSInit() // pretty much just a place holder for now
     }
 
 
-    ekf.P[0][0]   = ekf.P[1][1] = ekf.P[2][2] = 25.0f;            // initial position variance (m^2)
-    ekf.P[3][3]   = ekf.P[4][4] = ekf.P[5][5] = 5.0f;             // initial velocity variance (m/s)^2
-    ekf.P[6][6]   = ekf.P[7][7] = ekf.P[8][8] = ekf.P[9][9] = 1e-5f;  // initial quaternion variance
-    ekf.P[10][10] = ekf.P[11][11] = ekf.P[12][12] = 1e-9f; // initial gyro bias variance (rad/s)^2
+    EKF_P(0, 0)   = EKF_P(1, 1) = EKF_P(2, 2) = 25.0f;            // initial position variance (m^2)
+    EKF_P(3, 3)   = EKF_P(4, 4) = EKF_P(5, 5) = 5.0f;             // initial velocity variance (m/s)^2
+    EKF_P(6, 6)   = EKF_P(7, 7) = EKF_P(8, 8) = EKF_P(9, 9) = 1e-5f;  // initial quaternion variance
+    EKF_P(10, 10) = EKF_P(11, 11) = EKF_P(12, 12) = 1e-9f; // initial gyro bias variance (rad/s)^2
 
     ekf.X[0]  = ekf.X[1] = ekf.X[2] = ekf.X[3] = ekf.X[4] = ekf.X[5] = 0.0f; // initial pos and vel (m)
     ekf.X[6]  = 1.0f;
@@ -170,9 +197,9 @@ void INSResetP(float PDiag[NUMX])
     for (i = 0; i < NUMX; i++) {
         if (PDiag != 0) {
             for (j = 0; j < NUMX; j++) {
-                ekf.P[i][j] = ekf.P[j][i] = 0.0f;
+                EKF_P(i, j) = EKF_P(j, i) = 0.0f;
             }
-            ekf.P[i][i] = PDiag[i];
+            EKF_P(i, i) = PDiag[i];
         }
     }
 }
@@ -184,7 +211,7 @@ void INSGetP(float PDiag[NUMX])
     // retrieve diagonal elements (aka state variance)
     for (i = 0; i < NUMX; i++) {
         if (PDiag != 0) {
-            PDiag[i] = ekf.P[i][i];
+            PDiag[i] = EKF_P(i, i);
         }
     }
 }
@@ -211,13 +238,13 @@ void INSPosVelReset(float pos[3], float vel[3])
 {
     for (int i = 0; i < 6; i++) {
         for (int j = i; j < NUMX; j++) {
-            ekf.P[i][j] = 0; // zero the first 6 rows and columns
-            ekf.P[j][i] = 0;
+            EKF_P(i, j) = 0; // zero the first 6 rows and columns
+            EKF_P(j, i) = 0;
         }
     }
 
-    ekf.P[0][0] = ekf.P[1][1] = ekf.P[2][2] = 25; // initial position variance (m^2)
-    ekf.P[3][3] = ekf.P[4][4] = ekf.P[5][5] = 5; // initial velocity variance (m/s)^2
+    EKF_P(0, 0) = EKF_P(1, 1) = EKF_P(2, 2) = 25; // initial position variance (m^2)
+    EKF_P(3, 3) = EKF_P(4, 4) = EKF_P(5, 5) = 5; // initial velocity variance (m/s)^2
 
     ekf.X[0]    = pos[0];
     ekf.X[1]    = pos[1];
@@ -329,7 +356,11 @@ void INSStatePrediction(float gyro_data[3], float accel_data[3], float dT)
 
 void INSCovariancePrediction(float dT)
 {
+#if defined(INSGPS_PACKED_COVARIANCE)
+    CovariancePredictionPacked(ekf.F, ekf.G, ekf.Q, dT, ekf.P);
+#else
     CovariancePrediction(ekf.F, ekf.G, ekf.Q, dT, ekf.P);
+#endif
 }
 
 float zeros[3] = { 0, 0, 0 };
@@ -400,7 +431,11 @@ void INSCorrection(float mag_data[3], float Pos[3], float Vel[3],
     // EKF correction step
     LinearizeH(ekf.X, ekf.Be, ekf.H);
     MeasurementEq(ekf.X, ekf.Be, Y);
+#if defined(INSGPS_PACKED_COVARIANCE)
+    SerialUpdatePacked(ekf.H, ekf.R, Z, Y, ekf.P, ekf.X, SensorsUsed);
+#else
     SerialUpdate(ekf.H, ekf.R, Z, Y, ekf.P, ekf.X, SensorsUsed);
+#endif
     qmag       = sqrtf(ekf.X[6] * ekf.X[6] + ekf.X[7] * ekf.X[7] + ekf.X[8] * ekf.X[8] + ekf.X[9] * ekf.X[9]);
     ekf.X[6]  /= qmag;
     ekf.X[7]  /= qmag;
@@ -551,6 +586,112 @@ void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
     }
 }
 
+// *************  Packed covariance ***************
+// Same computations as CovariancePrediction and SerialUpdate, in the same order so
+// the results are bit identical, on the packed upper triangle of P (see PIDX).
+// Each term of P is stored once, so the new terms are written sequentially and the
+// lower triangle copies are gone.
+// ************************************************
+
+__attribute__((optimize("O3"))) PIOS_MEM_RAMFUNC
+void CovariancePredictionPacked(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                                float Q[NUMW], float dT, float P[NUMP])
+{
+    float dT1  = 1.0f / dT; // multiplication is faster than division on fpu.
+    float dTsq = dT * dT;
+
+    float Dummy[NUMX][NUMX];
+    int8_t i;
+
+    for (i = 0; i < NUMX; i++) { // Calculate Dummy = (P/T +F*P)
+        float *Firow   = F[i];
+        float *Dirow   = Dummy[i];
+        int8_t Fistart = FrowMin[i];
+        int8_t Fiend   = FrowMax[i];
+        int8_t j;
+        for (j = 0; j < NUMX; j++) {
+            Dirow[j] = P[PIDX(i, j)] * dT1; // Dummy = P / T ...
+            int8_t k;
+            for (k = Fistart; k <= Fiend; k++) {
+                Dirow[j] += Firow[k] * P[PIDX(k, j)]; // [] + F * P
+            }
+        }
+    }
+    float *Pij = P;
+    for (i = 0; i < NUMX; i++) { // Calculate Pnew = (T^2) [Dummy/T + Dummy*F' + G*Qw*G']
+        float *Dirow   = Dummy[i];
+        float *Girow   = G[i];
+        int8_t Gistart = GrowMin[i];
+        int8_t Giend   = GrowMax[i];
+        int8_t j;
+        for (j = i; j < NUMX; j++) { // upper triangle, in storage order
+            float Ptmp = Dirow[j] * dT1; // Pnew = Dummy / T ...
+
+            {
+                float *Fjrow   = F[j];
+                int8_t Fjstart = FrowMin[j];
+                int8_t Fjend   = FrowMax[j];
+                int8_t k;
+                for (k = Fjstart; k <= Fjend; k++) {
+                    Ptmp += Dirow[k] * Fjrow[k]; // [] + Dummy*F' ...
+                }
+            }
+
+            {
+                float *Gjrow   = G[j];
+                int8_t Gjstart = MAX(Gistart, GrowMin[j]);
+                int8_t Gjend   = MIN(Giend, GrowMax[j]);
+                int8_t k;
+                for (k = Gjstart; k <= Gjend; k++) {
+                    Ptmp += Q[k] * Girow[k] * Gjrow[k]; // [] + G*Q*G' ...
+                }
+            }
+
+            *Pij++ = Ptmp * dTsq; // [] * (T^2)
+        }
+    }
+}
+
+void SerialUpdatePacked(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+                        float Y[NUMV], float P[NUMP], float X[NUMX],
+                        uint16_t SensorsUsed)
+{
+    float HP[NUMX], HPHR, Error;
+    uint8_t i, j, k, m;
+    float Km[NUMX];
+
+    for (m = 0; m < NUMV; m++) {
+        if (SensorsUsed & (0x01 << m)) { // use this sensor for update
+            for (j = 0; j < NUMX; j++) { // Find Hp = H*P
+                HP[j] = 0;
+                for (k = HrowMin[m]; k <= HrowMax[m]; k++) {
+                    HP[j] += H[m][k] * P[PIDX(k, j)];
+                }
+            }
+            HPHR = R[m]; // Find  HPHR = H*P*H' + R
+            for (k = HrowMin[m]; k <= HrowMax[m]; k++) {
+                HPHR += HP[k] * H[m][k];
+            }
+
+            for (k = 0; k < NUMX; k++) {
+                Km[k] = HP[k] / HPHR; // find K = HP/HPHR
+            }
+            float *Pij = P;
+            for (i = 0; i < NUMX; i++) { // Find P(m)= P(m-1) + K*HP
+                for (j = i; j < NUMX; j++) {
+                    *Pij = *Pij - Km[i] * HP[j];
+                    Pij++;
+                }
+            }
+
+            Error = Z[m] - Y[m];
+            for (i = 0; i < NUMX; i++) { // Find X(m)= X(m-1) + K*Error
+                X[i] = X[i] + Km[i] * Error;
+            }
+        }
+    }
+}
+
 // *************  RungeKutta **********************
 // Does a 4th order Runge Kutta numerical integration step
 // Output, Xnew, is written over X
@@ -28,6 +28,26 @@
 #include <instrumentation.h>
 #include <pios_instrumentation.h>
 
+#ifdef PIOS_INCLUDE_EVENTTRACE
+#include <tracecontrol.h>
+#include <tracestatus.h>
+#include <tracedata.h>
+
+#define TRACE_STREAM_WINDOW    8
+#define TRACE_EVENTS_PER_BLOCK (sizeof(((TraceDataData *)0)->Data) / sizeof(struct pios_eventtrace_event))
+
+static TraceDataData *traceBlock; // too large for the event dispatcher stack
+static void traceControlUpdatedCb(UAVObjEvent *ev);
+static void traceStream(uint16_t first);
+static void tracePublishStatus();
+#endif
+
+#ifdef PIOS_INCLUDE_LATENCYPROBE
+#include <latencyprobe.h>
+
+static void latencyPublish();
+#endif
+
 static uint8_t publishedCountersInstances = 0;
 static void counterCallback(const pios_perf_counter_t *counter, const int8_t index, void *context);
 static xSemaphoreHandle sem;
@@ -36,6 +56,22 @@ void InstrumentationInit()
     PerfCounterInitialize();
     publishedCountersInstances = 1;
     vSemaphoreCreateBinary(sem);
+#ifdef PIOS_INCLUDE_EVENTTRACE
+    PIOS_EVENTTRACE_Init();
+    TraceControlInitialize();
+    TraceStatusInitialize();
+    TraceDataInitialize();
+    for (int i = 1; i < TRACE_STREAM_WINDOW; i++) {
+        TraceDataCreateInstance();
+    }
+    traceBlock = pios_malloc(sizeof(TraceDataData));
+    PIOS_Assert(traceBlock);
+    TraceControlConnectCallback(traceControlUpdatedCb);
+#endif
+#ifdef PIOS_INCLUDE_LATENCYPROBE
+    PIOS_LATENCYPROBE_Init();
+    LatencyProbeInitialize();
+#endif
 }
 
 void InstrumentationPublishAllCounters()
@@ -45,6 +81,12 @@ void InstrumentationPublishAllCounters()
     }
     PIOS_Instrumentation_ForEachCounter(&counterCallback, NULL);
     xSemaphoreGive(sem);
+#ifdef PIOS_INCLUDE_EVENTTRACE
+    tracePublishStatus();
+#endif
+#ifdef PIOS_INCLUDE_LATENCYPROBE
+    latencyPublish();
+#endif
 }
 
 void counterCallback(const pios_perf_counter_t *counter, const int8_t index, __attribute__((unused)) void *context)
@@ -60,3 +102,82 @@ void counterCallback(const pios_perf_counter_t *counter, const int8_t index, __a
     data.Counter.Value = counter->value;
     PerfCounterInstSet(index, &data);
 }
+
+#ifdef PIOS_INCLUDE_EVENTTRACE
+static void traceControlUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    TraceControlData control;
+
+    TraceControlGet(&control);
+    switch (control.Operation) {
+    case TRACECONTROL_OPERATION_START:
+        PIOS_EVENTTRACE_Start(false);
+        break;
+    case TRACECONTROL_OPERATION_STARTCONTINUOUS:
+        PIOS_EVENTTRACE_Start(true);
+        break;
+    case TRACECONTROL_OPERATION_STOP:
+        PIOS_EVENTTRACE_Stop();
+        break;
+    case TRACECONTROL_OPERATION_STREAM:
+        traceStream(control.Event);
+        break;
+    default:
+        break;
+    }
+    tracePublishStatus();
+}
+
+/**
+ * Push up to TRACE_STREAM_WINDOW blocks of events starting at first,
+ * the stream stops early with a block that is not full after the last event
+ */
+static void traceStream(uint16_t first)
+{
+    for (uint16_t i = 0; i < TRACE_STREAM_WINDOW; i++) {
+        struct pios_eventtrace_event event;
+        uint8_t n;
+
+        memset(traceBlock, 0, sizeof(TraceDataData));
+        traceBlock->Event = first + i * TRACE_EVENTS_PER_BLOCK;
+        for (n = 0; n < TRACE_EVENTS_PER_BLOCK && PIOS_EVENTTRACE_GetEvent(traceBlock->Event + n, &event) == 0; n++) {
+            memcpy(&traceBlock->Data[n * sizeof(event)], &event, sizeof(event));
+        }
+        traceBlock->Count = n;
+        TraceDataInstSet(i, traceBlock);
+        if (n < TRACE_EVENTS_PER_BLOCK) {
+            break;
+        }
+    }
+}
+
+static void tracePublishStatus()
+{
+    TraceStatusData status;
+
+    status.State      = PIOS_EVENTTRACE_IsRunning() ? TRACESTATUS_STATE_RUNNING : TRACESTATUS_STATE_STOPPED;
+    status.Events     = PIOS_EVENTTRACE_GetCount();
+    status.TicksPerMs = PIOS_EVENTTRACE_GetTicksPerMs();
+    TraceStatusSet(&status);
+}
+#endif /* PIOS_INCLUDE_EVENTTRACE */
+
+#ifdef PIOS_INCLUDE_LATENCYPROBE
+static void latencyPublish()
+{
+    struct pios_latencyprobe_stats stats;
+    LatencyProbeData data;
+
+    PIOS_LATENCYPROBE_GetStats(&stats);
+    data.Samples     = stats.samples;
+    data.Dropped     = stats.dropped;
+    data.Latency.Min = stats.min;
+    data.Latency.Avg = stats.avg;
+    data.Latency.Max = stats.max;
+    data.Stage.Receiver      = stats.stage[PIOS_LATENCYPROBE_MANUALCONTROLCOMMAND];
+    data.Stage.ManualControl = stats.stage[PIOS_LATENCYPROBE_STABILIZATIONDESIRED] - stats.stage[PIOS_LATENCYPROBE_MANUALCONTROLCOMMAND];
+    data.Stage.Stabilization = stats.stage[PIOS_LATENCYPROBE_ACTUATORDESIRED] - stats.stage[PIOS_LATENCYPROBE_STABILIZATIONDESIRED];
+    data.Stage.Actuator      = stats.stage[PIOS_LATENCYPROBE_OUTPUT] - stats.stage[PIOS_LATENCYPROBE_ACTUATORDESIRED];
+    LatencyProbeSet(&data);
+}
+#endif /* PIOS_INCLUDE_LATENCYPROBE */
@@ -256,4 +256,6 @@ void LedNotificationExtLedsRun()
     for (uint8_t i = 0; i < MAX_HANDLED_LED; i++) {
         run_led(&led_status[i]);
     }
+    // send the colors set while the previous frame was still being sent, nothing if unchanged
+    PIOS_WS2811_Update();
 }
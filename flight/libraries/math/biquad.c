@@ -0,0 +1,168 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Biquad filter bank
+ * @{
+ *
+ * @file       biquad.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Low pass and notch sections after the RBJ audio EQ cookbook
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include <pios_math.h>
+#include "fastmath.h"
+#include "biquad.h"
+
+/**
+ * Second order low pass section.
+ * @param[out] stage Coefficients
+ * @param[in]  rate Sample rate in Hz
+ * @param[in]  cutoff -3dB frequency in Hz for q = sqrt(1/2)
+ * @param[in]  q Quality factor, sqrt(1/2) for a Butterworth response
+ * @returns false if the cutoff is not below the Nyquist frequency
+ */
+bool biquad_lowpass(struct biquad_stage *stage, float rate, float cutoff, float q)
+{
+    if (!(cutoff > 0.0f && cutoff < 0.5f * rate && q > 0.0f)) {
+        return false;
+    }
+
+    float s, c;
+    fast_sincosf(M_2PI_F * cutoff / rate, &s, &c);
+    const float alpha = s / (2.0f * q);
+    const float a0inv = 1.0f / (1.0f + alpha);
+
+    stage->b0 = 0.5f * (1.0f - c) * a0inv;
+    stage->b1 = (1.0f - c) * a0inv;
+    stage->b2 = stage->b0;
+    stage->a1 = -2.0f * c * a0inv;
+    stage->a2 = (1.0f - alpha) * a0inv;
+    return true;
+}
+
+/**
+ * Notch section with unity gain away from the center.
+ * Cheap enough to retune a running bank, the state is kept.
+ * @param[out] stage Coefficients
+ * @param[in]  rate Sample rate in Hz
+ * @param[in]  center Notch frequency in Hz
+ * @param[in]  bandwidth Width between the -3dB points in Hz
+ * @returns false if the center is not below the Nyquist frequency
+ */
+bool biquad_notch(struct biquad_stage *stage, float rate, float center, float bandwidth)
+{
+    if (!(center > 0.0f && center < 0.5f * rate && bandwidth > 0.0f)) {
+        return false;
+    }
+
+    float s, c;
+    fast_sincosf(M_2PI_F * center / rate, &s, &c);
+    // exact -3dB bandwidth in the digital domain, no prewarping of an analog Q
+    const float alpha = tanf(M_PI_F * bandwidth / rate);
+    const float a0inv = 1.0f / (1.0f + alpha);
+
+    stage->b0 = a0inv;
+    stage->b1 = -2.0f * c * a0inv;
+    stage->b2 = a0inv;
+    stage->a1 = stage->b1;
+    stage->a2 = (1.0f - alpha) * a0inv;
+    return true;
+}
+
+/**
+ * Remove all stages, the bank passes the samples through.
+ */
+void biquad_bank_clear(struct biquad_bank *bank)
+{
+    memset(bank, 0, sizeof(*bank));
+}
+
+/**
+ * Append a stage with a cleared state.
+ * @returns index of the stage, -1 if the bank is full
+ */
+int8_t biquad_bank_add(struct biquad_bank *bank, const struct biquad_stage *stage)
+{
+    if (bank->stages >= BIQUAD_MAX_STAGES) {
+        return -1;
+    }
+
+    int8_t index = bank->stages++;
+    bank->stage[index] = *stage;
+    for (uint8_t t = 0; t < BIQUAD_AXES; t++) {
+        bank->z1[index][t] = 0.0f;
+        bank->z2[index][t] = 0.0f;
+    }
+    return index;
+}
+
+/**
+ * Append a Butterworth low pass of even order as order / 2 stages.
+ * @returns false if it does not fit or the cutoff is invalid, the bank is unchanged then
+ */
+bool biquad_bank_add_butterworth(struct biquad_bank *bank, float rate, float cutoff, uint8_t order)
+{
+    const uint8_t count = order / 2;
+
+    if (count == 0 || bank->stages + count > BIQUAD_MAX_STAGES) {
+        return false;
+    }
+
+    struct biquad_stage stage[BIQUAD_MAX_STAGES];
+    for (uint8_t k = 0; k < count; k++) {
+        // pole pairs of the Butterworth polynomial
+        const float q = 1.0f / (2.0f * cosf(M_PI_F * (2 * k + 1) / (2 * order)));
+        if (!biquad_lowpass(&stage[k], rate, cutoff, q)) {
+            return false;
+        }
+    }
+    for (uint8_t k = 0; k < count; k++) {
+        biquad_bank_add(bank, &stage[k]);
+    }
+    return true;
+}
+
+/**
+ * Set the state of every stage as if x had been the input forever.
+ * Avoids the step response when the bank is (re)started on a live signal.
+ */
+void biquad_bank_reset(struct biquad_bank *bank, const float x[BIQUAD_AXES])
+{
+    for (uint8_t t = 0; t < BIQUAD_AXES; t++) {
+        float in = x[t];
+        for (uint8_t s = 0; s < bank->stages; s++) {
+            const struct biquad_stage *c = &bank->stage[s];
+            // DC gain of the section
+            const float y = in * (c->b0 + c->b1 + c->b2) / (1.0f + c->a1 + c->a2);
+            bank->z2[s][t] = c->b2 * in - c->a2 * y;
+            bank->z1[s][t] = y - c->b0 * in;
+            in = y;
+        }
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Biquad filter bank
+ * @{
+ *
+ * @file       biquad.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Cascade of second order sections filtering three axes at once
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BIQUAD_AXES       3
+#define BIQUAD_MAX_STAGES 4
+
+// Coefficients of one section, normalised to a0 = 1
+struct biquad_stage {
+    float b0;
+    float b1;
+    float b2;
+    float a1;
+    float a2;
+};
+
+// Sections share the coefficients over the axes, the state is per axis
+struct biquad_bank {
+    uint8_t stages;
+    struct biquad_stage stage[BIQUAD_MAX_STAGES];
+    // transposed direct form 2 state
+    float   z1[BIQUAD_MAX_STAGES][BIQUAD_AXES];
+    float   z2[BIQUAD_MAX_STAGES][BIQUAD_AXES];
+};
+
+// Coefficients, false and the stage left as is for frequencies outside (0, rate / 2)
+bool biquad_lowpass(struct biquad_stage *stage, float rate, float cutoff, float q);
+bool biquad_notch(struct biquad_stage *stage, float rate, float center, float bandwidth);
+
+// Bank setup, done when the settings change
+void biquad_bank_clear(struct biquad_bank *bank);
+int8_t biquad_bank_add(struct biquad_bank *bank, const struct biquad_stage *stage);
+bool biquad_bank_add_butterworth(struct biquad_bank *bank, float rate, float cutoff, uint8_t order);
+void biquad_bank_reset(struct biquad_bank *bank, const float x[BIQUAD_AXES]);
+
+/**
+ * Filter one sample of every axis in place, a pass through with no stages.
+ * The loops only depend on the number of stages, not on the data.
+ */
+static inline void biquad_bank_apply(struct biquad_bank *bank, float x[BIQUAD_AXES])
+{
+    for (uint8_t s = 0; s < bank->stages; s++) {
+        const struct biquad_stage *c = &bank->stage[s];
+        float *z1 = bank->z1[s];
+        float *z2 = bank->z2[s];
+        for (uint8_t t = 0; t < BIQUAD_AXES; t++) {
+            const float in = x[t];
+            const float y  = c->b0 * in + z1[t];
+            z1[t] = c->b1 * in - c->a1 * y + z2[t];
+            z2[t] = c->b2 * in - c->a2 * y;
+            x[t]  = y;
+        }
+    }
+}
+
+#endif /* BIQUAD_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,228 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Fast math functions
+ * @{
+ *
+ * @file       fastmath.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Polynomial approximations of the libm functions used in hot loops
+ *
+ * Constant time, branch light replacements for atan2f, asinf, sinf/cosf,
+ * sqrtf, 1/sqrtf, expf and logf. They do not set errno nor handle every
+ * special value, so each call site picks them over libm where the speed
+ * matters and the error bounds below are good enough.
+ * The bounds are checked against double precision libm by the math unit test.
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pios_math.h>
+
+typedef union {
+    float    f;
+    int32_t  i;
+    uint32_t u;
+} fastmath_bits_t;
+
+// Cody-Waite splits, n * HI (and n * MID) are exact in float for |n| < 2048
+#define FASTMATH_PIO2_HI  1.5703125f
+#define FASTMATH_PIO2_MID 4.837512969970703125e-4f
+#define FASTMATH_PIO2_LO  7.549789948768648e-8f
+#define FASTMATH_LN2_HI  0.693145751953125f
+#define FASTMATH_LN2_LO  1.428606765330187045e-6f
+
+/**
+ * 1/sqrt(x), two Newton steps from the bit level first guess.
+ * Relative error < 5e-6 for normal x > 0.
+ * fast_invsqrtf() in mathmisc.h takes a single step, 2e-3.
+ */
+static inline float fast_rsqrtf(float x)
+{
+    fastmath_bits_t b;
+    float half = 0.5f * x;
+
+    b.f = x;
+    b.u = 0x5f375a86 - (b.u >> 1);
+    float y = b.f;
+    y = y * (1.5f - half * y * y);
+    y = y * (1.5f - half * y * y);
+    return y;
+}
+
+/**
+ * sqrt(x), 0 for x <= 0.
+ * Exact on targets with a hardware FPU, relative error < 5e-6 otherwise.
+ */
+static inline float fast_sqrtf(float x)
+{
+    if (!(x > 0.0f)) {
+        return 0.0f;
+    }
+#if defined(__ARM_FP) && (__ARM_FP & 4)
+    float r;
+    __asm__ ("vsqrt.f32 %0, %1" : "=t" (r) : "t" (x));
+    return r;
+#else
+    return x * fast_rsqrtf(x);
+#endif
+}
+
+/**
+ * atan2(y, x) in rad, odd minimax polynomial of degree 11 on the octant,
+ * Abramowitz and Stegun 4.4.49.
+ * Absolute error < 4e-6 rad, 0 for (0, 0).
+ */
+static inline float fast_atan2f(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+
+    if (ax == 0.0f && ay == 0.0f) {
+        return 0.0f;
+    }
+
+    bool steep = ay > ax;
+    float z    = steep ? ax / ay : ay / ax;
+    float z2   = z * z;
+    float a    = z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f +
+                                                                   z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+
+    if (steep) {
+        a = M_PI_2_F - a;
+    }
+    if (x < 0.0f) {
+        a = M_PI_F - a;
+    }
+    return (y < 0.0f) ? -a : a;
+}
+
+/**
+ * asin(x) in rad through fast_atan2f, x is clamped to [-1, 1].
+ * Absolute error < 6e-6 rad.
+ */
+static inline float fast_asinf(float x)
+{
+    if (x > 1.0f) {
+        x = 1.0f;
+    } else if (x < -1.0f) {
+        x = -1.0f;
+    }
+    return fast_atan2f(x, fast_sqrtf((1.0f - x) * (1.0f + x)));
+}
+
+/**
+ * sin(x) and cos(x) at once, x in rad.
+ * Reduced to [-pi/4, pi/4] where the Taylor series up to x^7 and x^8 are used.
+ * Absolute error < 5e-7 for |x| < 3000.
+ */
+static inline void fast_sincosf(float x, float *s, float *c)
+{
+    int32_t n = (int32_t)(x * M_2_PI_F + (x >= 0.0f ? 0.5f : -0.5f));
+    float r   = ((x - n * FASTMATH_PIO2_HI) - n * FASTMATH_PIO2_MID) - n * FASTMATH_PIO2_LO;
+    float r2  = r * r;
+
+    float sr  = r * (1.0f + r2 * (-1.0f / 6.0f + r2 * (1.0f / 120.0f + r2 * (-1.0f / 5040.0f))));
+    float cr  = 1.0f + r2 * (-0.5f + r2 * (1.0f / 24.0f + r2 * (-1.0f / 720.0f + r2 * (1.0f / 40320.0f))));
+
+    switch (n & 3) {
+    case 0:
+        *s = sr;
+        *c = cr;
+        break;
+    case 1:
+        *s = cr;
+        *c = -sr;
+        break;
+    case 2:
+        *s = -sr;
+        *c = -cr;
+        break;
+    default:
+        *s = -cr;
+        *c = sr;
+        break;
+    }
+}
+
+/**
+ * exp(x), saturates at exp(88) and returns 0 below -87.
+ * Range reduction by ln(2) and a degree 6 polynomial.
+ * Relative error < 4e-7.
+ */
+static inline float fast_expf(float x)
+{
+    if (x > 88.0f) {
+        x = 88.0f;
+    } else if (x < -87.0f) {
+        return 0.0f;
+    }
+
+    int32_t n = (int32_t)(x * M_LOG2E_F + (x >= 0.0f ? 0.5f : -0.5f));
+    float r   = (x - n * FASTMATH_LN2_HI) - n * FASTMATH_LN2_LO;
+    float p   = 1.0f + r * (1.0f + r * (0.5f + r * (1.0f / 6.0f + r * (1.0f / 24.0f + r * (1.0f / 120.0f + r * (1.0f / 720.0f))))));
+
+    fastmath_bits_t scale;
+    scale.i = (n + 127) << 23;
+    return p * scale.f;
+}
+
+/**
+ * Natural log of a normal x > 0, -INFINITY for 0 and NAN for x < 0.
+ * The mantissa is reduced to [sqrt(1/2), sqrt(2)] and ln(m) is
+ * 2 atanh((m - 1) / (m + 1)) to the 9th power.
+ * Absolute error < 2e-7 for x in [0.5, 2), relative error < 2e-7 elsewhere.
+ */
+static inline float fast_logf(float x)
+{
+    if (!(x > 0.0f)) {
+        return (x == 0.0f) ? -INFINITY : NAN;
+    }
+
+    fastmath_bits_t b;
+    b.f = x;
+    int32_t e = (int32_t)((b.u >> 23) & 0xff) - 127;
+
+    b.u = (b.u & 0x007fffff) | 0x3f800000;
+    float m = b.f;
+    if (m > M_SQRT2_F) {
+        m *= 0.5f;
+        e++;
+    }
+
+    float s  = (m - 1.0f) / (m + 1.0f);
+    float s2 = s * s;
+    float l  = 2.0f * s * (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f + s2 * (1.0f / 9.0f)))));
+
+    return e * M_LN2_F + l;
+}
+
+#endif /* FASTMATH_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Fast Fourier transform
+ * @{
+ *
+ * @file       fft.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Iterative radix 2 decimation in time FFT
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <pios_math.h>
+#include "fft.h"
+
+/**
+ * Set up a plan, the twiddle factors are computed once into the caller's buffer.
+ * @param[out] plan Plan to initialise
+ * @param[in]  n Transform length, a power of two from 4 on
+ * @param[in]  twiddle Storage of n floats
+ * @returns false if n is not supported
+ */
+bool fft_plan_init(struct fft_plan *plan, uint16_t n, float *twiddle)
+{
+    if (n < 4 || (n & (n - 1)) != 0 || !twiddle) {
+        return false;
+    }
+
+    plan->n = n;
+    plan->twiddle = twiddle;
+    for (uint16_t k = 0; k < n / 2; k++) {
+        const float a = -M_2PI_F * k / n;
+        twiddle[2 * k]     = cosf(a);
+        twiddle[2 * k + 1] = sinf(a);
+    }
+    return true;
+}
+
+/**
+ * Forward transform of n complex values in place, not normalised.
+ * @param[in]     plan Plan of the transform length
+ * @param[in,out] data n complex values, interleaved re, im
+ */
+void fft_complex(const struct fft_plan *plan, float *data)
+{
+    const uint16_t n = plan->n;
+
+    // bit reversed order
+    for (uint16_t i = 1, j = 0; i < n; i++) {
+        uint16_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            float re = data[2 * i];
+            float im = data[2 * i + 1];
+            data[2 * i]     = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j]     = re;
+            data[2 * j + 1] = im;
+        }
+    }
+
+    // butterflies
+    for (uint16_t half = 1, step = n / 2; half < n; half <<= 1, step >>= 1) {
+        for (uint16_t k = 0; k < half; k++) {
+            const float wr = plan->twiddle[2 * k * step];
+            const float wi = plan->twiddle[2 * k * step + 1];
+            for (uint16_t i = k; i < n; i += 2 * half) {
+                float *a = &data[2 * i];
+                float *b = &data[2 * (i + half)];
+                const float tr = wr * b[0] - wi * b[1];
+                const float ti = wr * b[1] + wi * b[0];
+                b[0]  = a[0] - tr;
+                b[1]  = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+/**
+ * Magnitudes of the spectra of two real signals transformed together.
+ * With data = FFT(a + i b) A[k] = (Z[k] + conj(Z[n - k])) / 2 and
+ * B[k] = (Z[k] - conj(Z[n - k])) / 2i.
+ * @param[in]  plan Plan of the transform length
+ * @param[in]  data Output of fft_complex()
+ * @param[out] magA |A[k]| for k = 0 .. n / 2
+ * @param[out] magB |B[k]| for k = 0 .. n / 2, may be NULL
+ */
+void fft_real_pair_magnitude(const struct fft_plan *plan, const float *data, float *magA, float *magB)
+{
+    const uint16_t n = plan->n;
+
+    for (uint16_t k = 0; k <= n / 2; k++) {
+        const uint16_t m = (n - k) & (n - 1);
+        const float zr   = data[2 * k];
+        const float zi   = data[2 * k + 1];
+        const float cr   = data[2 * m];
+        const float ci   = -data[2 * m + 1];
+        magA[k] = 0.5f * sqrtf((zr + cr) * (zr + cr) + (zi + ci) * (zi + ci));
+        if (magB) {
+            magB[k] = 0.5f * sqrtf((zr - cr) * (zr - cr) + (zi - ci) * (zi - ci));
+        }
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
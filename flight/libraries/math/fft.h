@@ -0,0 +1,52 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Fast Fourier transform
+ * @{
+ *
+ * @file       fft.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      In place complex FFT with caller provided twiddle storage
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+struct fft_plan {
+    uint16_t n;
+    // n / 2 roots exp(-2 pi i k / n), interleaved re, im
+    float    *twiddle;
+};
+
+bool fft_plan_init(struct fft_plan *plan, uint16_t n, float *twiddle);
+void fft_complex(const struct fft_plan *plan, float *data);
+void fft_real_pair_magnitude(const struct fft_plan *plan, const float *data, float *magA, float *magB);
+
+#endif /* FFT_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,194 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Magnetometer calibration
+ * @{
+ *
+ * @file       magfit.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Recursive least squares fit of an axis aligned ellipsoid to
+ *             magnetometer samples
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include "magfit.h"
+
+// the prior is the unit sphere, the samples should be in units of the expected field
+#define MAGFIT_P_INIT    10.0f
+// without new directions the forgetting would let P grow without bound
+#define MAGFIT_P_MAX     1000.0f
+// a sample is taken once its direction moved by about 10 degrees
+#define MAGFIT_MIN_ANGLE 0.985f // cosine
+// an octant is covered with at least this many recent samples
+#define MAGFIT_OCTANT    1.0f
+
+/**
+ * Start from the unit sphere around the origin.
+ */
+void magfit_init(struct magfit *fit)
+{
+    memset(fit, 0, sizeof(*fit));
+    fit->theta[0] = -1.0f;
+    fit->theta[1] = -1.0f;
+    fit->theta[5] = 1.0f;
+    for (uint8_t i = 0; i < MAGFIT_PARAMS; i++) {
+        fit->P[i][i] = MAGFIT_P_INIT;
+    }
+}
+
+static bool ellipsoid(const float theta[MAGFIT_PARAMS], float center[3], float radius2[3])
+{
+    // x^2 + B y^2 + C z^2 + D x + E y + F z + G = 0
+    const float B = -theta[0];
+    const float C = -theta[1];
+
+    if (!(B > 0.0f && C > 0.0f)) {
+        return false;
+    }
+    center[0] = 0.5f * theta[2];
+    center[1] = 0.5f * theta[3] / B;
+    center[2] = 0.5f * theta[4] / C;
+
+    const float K = center[0] * center[0] + B * center[1] * center[1] + C * center[2] * center[2] + theta[5];
+    if (!(K > 0.0f)) {
+        return false;
+    }
+    radius2[0] = K;
+    radius2[1] = K / B;
+    radius2[2] = K / C;
+    return true;
+}
+
+/**
+ * Feed one sample, it is skipped if its direction is too close to the last
+ * one taken, so that a steady attitude does not outweigh the others.
+ * @param[in] lambda Forgetting factor per sample taken, 1 - 1 / memory in samples
+ * @param[in] mag Raw sample, in units of the expected field
+ * @returns true if the sample was taken
+ */
+bool magfit_update(struct magfit *fit, float lambda, const float mag[3])
+{
+    float center[3]  = { 0.0f, 0.0f, 0.0f };
+    float radius2[3] = { 1.0f, 1.0f, 1.0f };
+    const bool solved = ellipsoid(fit->theta, center, radius2);
+
+    float d[3] = { mag[0] - center[0], mag[1] - center[1], mag[2] - center[2] };
+    const float norm = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    if (!(norm > 0.0f)) {
+        return false;
+    }
+    d[0] /= norm;
+    d[1] /= norm;
+    d[2] /= norm;
+    if (fit->samples > 0 && d[0] * fit->last[0] + d[1] * fit->last[1] + d[2] * fit->last[2] > MAGFIT_MIN_ANGLE) {
+        return false;
+    }
+    fit->last[0] = d[0];
+    fit->last[1] = d[1];
+    fit->last[2] = d[2];
+
+    // the quality of the current solution on a sample it did not see
+    if (solved) {
+        const float len = sqrtf((mag[0] - center[0]) * (mag[0] - center[0]) / radius2[0] +
+                                (mag[1] - center[1]) * (mag[1] - center[1]) / radius2[1] +
+                                (mag[2] - center[2]) * (mag[2] - center[2]) / radius2[2]);
+        fit->error  = lambda * fit->error + (len - 1.0f) * (len - 1.0f);
+        fit->weight = lambda * fit->weight + 1.0f;
+    }
+
+    const uint8_t octant = (d[0] < 0.0f ? 1 : 0) | (d[1] < 0.0f ? 2 : 0) | (d[2] < 0.0f ? 4 : 0);
+    for (uint8_t i = 0; i < 8; i++) {
+        fit->octant[i] *= lambda;
+    }
+    fit->octant[octant] += 1.0f;
+
+    const float phi[MAGFIT_PARAMS] = { mag[1] * mag[1], mag[2] * mag[2], mag[0], mag[1], mag[2], 1.0f };
+    float Pphi[MAGFIT_PARAMS];
+    float den = lambda;
+    float e   = mag[0] * mag[0];
+
+    for (uint8_t i = 0; i < MAGFIT_PARAMS; i++) {
+        Pphi[i] = 0.0f;
+        for (uint8_t j = 0; j < MAGFIT_PARAMS; j++) {
+            Pphi[i] += fit->P[i][j] * phi[j];
+        }
+    }
+    for (uint8_t i = 0; i < MAGFIT_PARAMS; i++) {
+        den += phi[i] * Pphi[i];
+        e   -= fit->theta[i] * phi[i];
+    }
+
+    const float inv = 1.0f / den;
+    float trace     = 0.0f;
+    for (uint8_t i = 0; i < MAGFIT_PARAMS; i++) {
+        fit->theta[i] += Pphi[i] * inv * e;
+        for (uint8_t j = 0; j < MAGFIT_PARAMS; j++) {
+            fit->P[i][j] -= Pphi[i] * Pphi[j] * inv;
+        }
+        trace += fit->P[i][i];
+    }
+
+    if (trace < MAGFIT_P_MAX) {
+        const float scale = 1.0f / lambda;
+        for (uint8_t i = 0; i < MAGFIT_PARAMS; i++) {
+            for (uint8_t j = 0; j < MAGFIT_PARAMS; j++) {
+                fit->P[i][j] *= scale;
+            }
+        }
+    }
+
+    fit->samples++;
+    return true;
+}
+
+/**
+ * Current ellipsoid and its quality.
+ * @param[out] solution Left as is if there is no ellipsoid yet
+ * @returns false if the samples do not describe an ellipsoid
+ */
+bool magfit_solution(const struct magfit *fit, struct magfit_solution *solution)
+{
+    float center[3];
+    float radius2[3];
+
+    if (fit->samples == 0 || !ellipsoid(fit->theta, center, radius2)) {
+        return false;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        solution->center[i] = center[i];
+        solution->radius[i] = sqrtf(radius2[i]);
+    }
+    solution->residual = fit->weight > 0.0f ? sqrtf(fit->error / fit->weight) : 1.0f;
+    solution->coverage = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        if (fit->octant[i] >= MAGFIT_OCTANT) {
+            solution->coverage++;
+        }
+    }
+    return true;
+}
+
+/**
+ * @}
+ * @}
+ */
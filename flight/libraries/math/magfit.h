@@ -0,0 +1,71 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Magnetometer calibration
+ * @{
+ *
+ * @file       magfit.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Recursive least squares fit of an axis aligned ellipsoid to
+ *             magnetometer samples
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef MAGFIT_H
+#define MAGFIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// x^2 = theta . { y^2, z^2, x, y, z, 1 }
+#define MAGFIT_PARAMS 6
+
+struct magfit {
+    float    theta[MAGFIT_PARAMS];
+    float    P[MAGFIT_PARAMS][MAGFIT_PARAMS];
+    float    last[3]; // direction of the last sample taken
+    // forgotten sum of the squared relative field length errors, before each update
+    float    error;
+    // forgotten number of samples
+    float    weight;
+    // forgotten number of samples in each octant around the center
+    float    octant[8];
+    uint32_t samples; // samples taken
+};
+
+// Ellipsoid of the samples, in the units of the samples
+struct magfit_solution {
+    float   center[3]; // hard iron offset
+    float   radius[3]; // half axis along x, y and z
+    float   residual; // rms relative error of the field length, 0 .. 1
+    uint8_t coverage; // octants around the center with recent samples, 0 .. 8
+};
+
+void magfit_init(struct magfit *fit);
+bool magfit_update(struct magfit *fit, float lambda, const float mag[3]);
+bool magfit_solution(const struct magfit *fit, struct magfit_solution *solution);
+
+#endif /* MAGFIT_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,159 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Noise generator for simulated sensors
+ * @{
+ *
+ * @file       noise.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Seeded gaussian noise and sensor error models, shared by the
+ *             simposix simulated sensors and the GCS HITL plugin
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include "noise.h"
+
+#define NOISE_2PI 6.28318530717958647692f
+
+static inline uint32_t rotl(uint32_t x, int k)
+{
+    return (x << k) | (x >> (32 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seed the generator, the same seed always gives the same sequence
+ * @param[in] seed any value
+ */
+void NoiseSeed(struct NoiseGenerator *gen, uint64_t seed)
+{
+    for (int lane = 0; lane < NOISE_LANES; lane++) {
+        uint64_t a = splitmix64(&seed);
+        uint64_t b = splitmix64(&seed);
+        gen->s[0][lane] = (uint32_t)a;
+        gen->s[1][lane] = (uint32_t)(a >> 32);
+        gen->s[2][lane] = (uint32_t)b;
+        gen->s[3][lane] = (uint32_t)(b >> 32) | 1; // never all zero
+    }
+    gen->next = NOISE_BLOCK_SIZE;
+}
+
+// One step of every lane, the loops have no dependency between lanes so they vectorise
+static void nextUniforms(struct NoiseGenerator *gen, float *u)
+{
+    uint32_t r[NOISE_LANES];
+
+    for (int lane = 0; lane < NOISE_LANES; lane++) {
+        r[lane] = gen->s[0][lane] + gen->s[3][lane];
+        uint32_t t = gen->s[1][lane] << 9;
+        gen->s[2][lane] ^= gen->s[0][lane];
+        gen->s[3][lane] ^= gen->s[1][lane];
+        gen->s[1][lane] ^= gen->s[2][lane];
+        gen->s[0][lane] ^= gen->s[3][lane];
+        gen->s[2][lane] ^= t;
+        gen->s[3][lane]  = rotl(gen->s[3][lane], 11);
+    }
+    // 24 bit uniforms in (0, 1]
+    for (int lane = 0; lane < NOISE_LANES; lane++) {
+        u[lane] = (float)((r[lane] >> 8) + 1) * (1.0f / 16777216.0f);
+    }
+}
+
+/**
+ * Fill a buffer with unit gaussian samples, Box-Muller on pairs of uniforms
+ * @param[out] out the samples
+ * @param[in] count number of samples, a multiple of 2 * NOISE_LANES avoids wasting any
+ */
+void NoiseGaussBlock(struct NoiseGenerator *gen, float *out, uint32_t count)
+{
+    float u1[NOISE_LANES];
+    float u2[NOISE_LANES];
+    float g[2 * NOISE_LANES];
+
+    for (uint32_t n = 0; n < count; n += 2 * NOISE_LANES) {
+        nextUniforms(gen, u1);
+        nextUniforms(gen, u2);
+        for (int lane = 0; lane < NOISE_LANES; lane++) {
+            float r = sqrtf(-2.0f * logf(u1[lane]));
+            float a = NOISE_2PI * u2[lane];
+            g[2 * lane]     = r * cosf(a);
+            g[2 * lane + 1] = r * sinf(a);
+        }
+        uint32_t left = count - n;
+        memcpy(&out[n], g, sizeof(float) * (left < 2 * NOISE_LANES ? left : 2 * NOISE_LANES));
+    }
+}
+
+/**
+ * @returns one unit gaussian sample, taken from the current block
+ */
+float NoiseGauss(struct NoiseGenerator *gen)
+{
+    if (gen->next >= NOISE_BLOCK_SIZE) {
+        NoiseGaussBlock(gen, gen->gauss, NOISE_BLOCK_SIZE);
+        gen->next = 0;
+    }
+    return gen->gauss[gen->next++];
+}
+
+/**
+ * Clear the correlated noise and the bias of a sensor model
+ */
+void NoiseSensorReset(struct NoiseSensorModel *model)
+{
+    memset(model->correlated, 0, sizeof(model->correlated));
+    memset(model->bias, 0, sizeof(model->bias));
+}
+
+/**
+ * Add the sensor errors to one sample
+ * @param[in,out] value the 3 axis sample
+ * @param[in] dT time since the previous sample, in s
+ * @param[in] temperature sensor temperature, in deg C
+ */
+void NoiseSensorApply(struct NoiseSensorModel *model, struct NoiseGenerator *gen, float value[3], float dT, float temperature)
+{
+    // keeps the variance of the correlated noise at correlatedSigma^2
+    const float innovation = model->correlatedSigma * sqrtf(1.0f - model->correlation * model->correlation);
+    const float walk  = model->biasWalk * sqrtf(dT > 0.0f ? dT : 0.0f);
+    const float drift = model->tempCoeff * (temperature - model->tempRef);
+
+    for (int i = 0; i < 3; i++) {
+        model->correlated[i] = model->correlation * model->correlated[i] + innovation * NoiseGauss(gen);
+        model->bias[i] += walk * NoiseGauss(gen);
+        value[i] += model->sigma * NoiseGauss(gen) + model->correlated[i] + model->bias[i] + drift;
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
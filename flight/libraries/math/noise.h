@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup Noise generator for simulated sensors
+ * @{
+ *
+ * @file       noise.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Seeded gaussian noise and sensor error models, shared by the
+ *             simposix simulated sensors and the GCS HITL plugin
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+
+#define NOISE_LANES      4
+#define NOISE_BLOCK_SIZE 64
+
+// NOISE_LANES interleaved xoshiro128+ generators, refilled a block at a time
+struct NoiseGenerator {
+    uint32_t s[4][NOISE_LANES];
+    float    gauss[NOISE_BLOCK_SIZE];
+    uint32_t next;
+};
+
+// Error model of a 3 axis sensor, each axis gets its own noise
+struct NoiseSensorModel {
+    float sigma; // white noise
+    float correlation; // AR(1) coefficient of the correlated noise, in [0, 1)
+    float correlatedSigma; // standard deviation of the correlated noise
+    float biasWalk; // bias random walk, per sqrt(s)
+    float tempCoeff; // bias drift per deg C away from tempRef
+    float tempRef;
+    // state
+    float correlated[3];
+    float bias[3];
+};
+
+// Function declarations
+void NoiseSeed(struct NoiseGenerator *gen, uint64_t seed);
+void NoiseGaussBlock(struct NoiseGenerator *gen, float *out, uint32_t count);
+float NoiseGauss(struct NoiseGenerator *gen);
+void NoiseSensorReset(struct NoiseSensorModel *model);
+void NoiseSensorApply(struct NoiseSensorModel *model, struct NoiseGenerator *gen, float value[3], float dT, float temperature);
+
+#endif /* NOISE_H */
+
+/**
+ * @}
+ * @}
+ */
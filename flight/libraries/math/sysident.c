@@ -0,0 +1,166 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup System identification
+ * @{
+ *
+ * @file       sysident.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Recursive least squares fit of a first order plant with dead time
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include "sysident.h"
+
+// weak prior, the first samples decide
+#define SYSIDENT_P_INIT 1000.0f
+// without excitation the forgetting would let P grow without bound
+#define SYSIDENT_P_MAX  100000.0f
+
+/**
+ * Clear the estimators, the model is available SYSIDENT_DELAYS + 1 samples later.
+ */
+void sysident_init(struct sysident *id)
+{
+    memset(id, 0, sizeof(*id));
+    for (uint8_t d = 0; d < SYSIDENT_DELAYS; d++) {
+        for (uint8_t i = 0; i < SYSIDENT_PARAMS; i++) {
+            id->rls[d].P[i][i] = SYSIDENT_P_INIT;
+        }
+    }
+}
+
+/**
+ * Keep the estimates but refill the input history, after samples were lost.
+ */
+void sysident_restart(struct sysident *id)
+{
+    id->history = 0;
+}
+
+static void rls_update(struct sysident_rls *r, float lambda, const float phi[SYSIDENT_PARAMS], float y)
+{
+    float Pphi[SYSIDENT_PARAMS];
+    float den = lambda;
+    float e   = y;
+
+    for (uint8_t i = 0; i < SYSIDENT_PARAMS; i++) {
+        Pphi[i] = 0.0f;
+        for (uint8_t j = 0; j < SYSIDENT_PARAMS; j++) {
+            Pphi[i] += r->P[i][j] * phi[j];
+        }
+    }
+    for (uint8_t i = 0; i < SYSIDENT_PARAMS; i++) {
+        den += phi[i] * Pphi[i];
+        e   -= r->theta[i] * phi[i];
+    }
+    r->error = lambda * r->error + e * e;
+
+    const float inv = 1.0f / den;
+    float trace     = 0.0f;
+    for (uint8_t i = 0; i < SYSIDENT_PARAMS; i++) {
+        r->theta[i] += Pphi[i] * inv * e;
+        // P is symmetric, so is P phi phi' P
+        for (uint8_t j = 0; j < SYSIDENT_PARAMS; j++) {
+            r->P[i][j] -= Pphi[i] * Pphi[j] * inv;
+        }
+        trace += r->P[i][i];
+    }
+
+    if (trace < SYSIDENT_P_MAX) {
+        const float scale = 1.0f / lambda;
+        for (uint8_t i = 0; i < SYSIDENT_PARAMS; i++) {
+            for (uint8_t j = 0; j < SYSIDENT_PARAMS; j++) {
+                r->P[i][j] *= scale;
+            }
+        }
+    }
+}
+
+/**
+ * Feed one sample to the estimators of all candidate delays.
+ * @param[in] lambda Forgetting factor, 1 - dT / memory time
+ * @param[in] u Plant input of this sample
+ * @param[in] y Plant output of this sample
+ */
+void sysident_update(struct sysident *id, float lambda, float u, float y)
+{
+    if (id->history >= SYSIDENT_DELAYS) {
+        const float dy = y - id->y;
+        id->change = lambda * id->change + dy * dy;
+        id->weight = lambda * id->weight + 1.0f;
+        for (uint8_t d = 0; d < SYSIDENT_DELAYS; d++) {
+            const float phi[SYSIDENT_PARAMS] = { id->y, id->u[d], 1.0f };
+            rls_update(&id->rls[d], lambda, phi, y);
+        }
+        id->samples++;
+    } else {
+        id->history++;
+    }
+
+    for (uint8_t d = SYSIDENT_DELAYS - 1; d > 0; d--) {
+        id->u[d] = id->u[d - 1];
+    }
+    id->u[0] = u;
+    id->y    = y;
+}
+
+/**
+ * Continuous first order model with dead time of the best candidate.
+ * @param[in]  dT Sample period in s
+ * @param[out] model Left as is if there is no stable estimate yet
+ * @returns false without estimate, e.g. while the input was never exercised
+ */
+bool sysident_model(const struct sysident *id, float dT, struct sysident_model *model)
+{
+    if (id->samples == 0 || !(dT > 0.0f)) {
+        return false;
+    }
+
+    uint8_t best = 0;
+    for (uint8_t d = 1; d < SYSIDENT_DELAYS; d++) {
+        if (id->rls[d].error < id->rls[best].error) {
+            best = d;
+        }
+    }
+
+    const struct sysident_rls *r = &id->rls[best];
+    const float a = r->theta[0];
+    const float b = r->theta[1];
+    if (!(a > 0.0f && a < 1.0f) || b == 0.0f) {
+        return false;
+    }
+
+    model->gain  = b / (1.0f - a);
+    model->tau   = -dT / logf(a);
+    model->delay = best * dT;
+    model->fit   = id->change > 0.0f ? fmaxf(1.0f - r->error / id->change, 0.0f) : 0.0f;
+    // var(theta) = P * the variance of the prediction error
+    model->uncertainty = sqrtf(r->P[1][1] * r->error / id->weight) / fabsf(b);
+    return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilot Math Utilities
+ * @{
+ * @addtogroup System identification
+ * @{
+ *
+ * @file       sysident.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Recursive least squares fit of a first order plant with dead time
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SYSIDENT_H
+#define SYSIDENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// candidate dead times in samples, one estimator each
+#define SYSIDENT_DELAYS 8
+// regressors y[k - 1], u[k - 1 - d] and a constant for trim and gravity torques
+#define SYSIDENT_PARAMS 3
+
+// Estimate of y[k] = a y[k - 1] + b u[k - 1 - d] + c for one d
+struct sysident_rls {
+    float theta[SYSIDENT_PARAMS];
+    float P[SYSIDENT_PARAMS][SYSIDENT_PARAMS];
+    // forgotten sum of the squared prediction errors
+    float error;
+};
+
+struct sysident {
+    float    u[SYSIDENT_DELAYS]; // input history, newest first
+    float    y; // last output
+    // forgotten sum of the squared output changes, what a hold predictor gets wrong
+    float    change;
+    // forgotten number of samples
+    float    weight;
+    uint8_t  history; // valid entries of u
+    uint32_t samples; // estimator updates
+    struct sysident_rls rls[SYSIDENT_DELAYS];
+};
+
+// Continuous model of the candidate with the smallest prediction error
+struct sysident_model {
+    float gain; // steady state output per unit of input
+    float tau; // time constant in s
+    float delay; // dead time in s
+    float fit; // share of the output changes explained, 0 .. 1
+    float uncertainty; // relative standard deviation of the gain
+};
+
+void sysident_init(struct sysident *id);
+void sysident_restart(struct sysident *id);
+void sysident_update(struct sysident *id, float lambda, float u, float y);
+bool sysident_model(const struct sysident *id, float dT, struct sysident_model *model);
+
+#endif /* SYSIDENT_H */
+
+/**
+ * @}
+ * @}
+ */
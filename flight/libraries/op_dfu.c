@@ -62,6 +62,13 @@ uint8_t Data2;
 uint8_t Data3;
 uint32_t Opt[3];
 
+// Delta upload vars, sectors whose content is already the new one are kept
+static bool deltaUpload = false;
+static uint8_t keptSectors[(DFU_MAX_SECTORS + 7) / 8];
+static uint32_t flashReadyEnd; // sectors below it are erased or kept
+static uint32_t curSectorEnd; // sector of the last word written
+static bool curSectorKept;
+
 // Download vars
 uint32_t downSizeOfLastPacket = 0;
 uint32_t downPacketTotal = 0;
@@ -75,6 +82,9 @@ extern int32_t platform_senddata(const uint8_t *msg, uint16_t msg_len);
 static uint32_t baseOfAdressType(uint8_t type);
 static uint8_t isBiggerThanAvailable(uint8_t type, uint32_t size);
 static void OPDfuIni(uint8_t discover);
+static int16_t sectorIndex(uint32_t adr, uint32_t *start, uint32_t *size);
+static uint8_t prepareDeltaWord(uint32_t adr, bool *write);
+static uint8_t eraseDeltaRemainder(void);
 bool flash_read(uint8_t *buffer, uint32_t adr, DFUProgType type);
 /* Private functions ---------------------------------------------------------*/
 void sendData(uint8_t *buf, uint16_t size);
@@ -186,7 +196,8 @@ void processComand(uint8_t *xReceive_Buffer)
         }
         break;
     case Upload:
-        if ((DeviceState == DFUidle) || (DeviceState == uploading)) {
+        if ((DeviceState == DFUidle) || (DeviceState == uploading)
+            || (DeviceState == wrong_packet_received)) {
             if ((StartFlag == 1) && (Next_Packet == 0)) {
                 TransferType     = Data0;
                 SizeOfTransfer   = Count;
@@ -200,10 +211,19 @@ void processComand(uint8_t *xReceive_Buffer)
                     Aditionals  = (uint32_t)Command;
                 } else {
                     uint8_t result = 1;
+                    deltaUpload = false;
                     if (TransferType == FW) {
                         switch (currentProgrammingDestination) {
                         case Self_flash:
-                            result = PIOS_BL_HELPER_FLASH_Start();
+                            if (Opt[1] == DFU_DELTA_UPLOAD) {
+                                // sectors are erased when the first word for them arrives
+                                deltaUpload   = true;
+                                memset(keptSectors, 0, sizeof(keptSectors));
+                                flashReadyEnd = baseOfAdressType(FW);
+                                curSectorEnd  = flashReadyEnd;
+                            } else {
+                                result = PIOS_BL_HELPER_FLASH_Start();
+                            }
                             break;
                         case Remote_flash_via_spi:
                             result = false;
@@ -238,6 +258,16 @@ void processComand(uint8_t *xReceive_Buffer)
                             Data   = unpack_uint32(&xReceive_Buffer[DATA + offset]);
                             aux    = baseOfAdressType(TransferType) + (uint32_t)(
                                 Count * 14 * 4 + x * 4);
+                            if (deltaUpload) {
+                                bool write;
+                                result = prepareDeltaWord(aux, &write);
+                                if (result != 1) {
+                                    break;
+                                }
+                                if (!write) {
+                                    continue;
+                                }
+                            }
                             result = 0;
                             for (int retry = 0; retry < MAX_WRI_RETRYS; ++retry) {
                                 if (result == 0) {
@@ -257,12 +287,17 @@ void processComand(uint8_t *xReceive_Buffer)
                     if (result != 1) {
                         DeviceState = Last_operation_failed;
                         Aditionals  = (uint32_t)Command;
+                    } else {
+                        DeviceState = uploading;
                     }
 
                     ++Next_Packet;
+                } else if (Count < Next_Packet - 1) {
+                    // already written, the host rewound to resend a packet we missed
                 } else {
+                    // a packet went missing, report the one we need next
                     DeviceState = wrong_packet_received;
-                    Aditionals  = Count;
+                    Aditionals  = Next_Packet - 1;
                 }
             } else {
                 DeviceState = Last_operation_failed;
@@ -297,6 +332,7 @@ void processComand(uint8_t *xReceive_Buffer)
             pack_uint32(devicesTable[Data0 - 1].FW_Crc, &Buffer[10]);
             Buffer[14] = devicesTable[Data0 - 1].devID >> 8;
             Buffer[15] = devicesTable[Data0 - 1].devID;
+            Buffer[16] = devicesTable[Data0 - 1].programmingType == Self_flash ? DFU_CAP_SECTOR_DELTA : 0;
         }
         sendData(Buffer + 1, 63);
         break;
@@ -318,14 +354,65 @@ void processComand(uint8_t *xReceive_Buffer)
         break;
     case Abort_Operation:
         Next_Packet = 0;
+        deltaUpload = false;
         DeviceState = DFUidle;
         break;
+    case Req_Sector_CRC:
+    {
+        // Count is an offset in the firmware bank, a size of 0 is past its end
+        uint32_t start = 0;
+        uint32_t size  = 0;
+        uint32_t crc   = 0;
+        if (currentProgrammingDestination == Self_flash && sectorIndex(baseOfAdressType(FW) + Count, &start, &size) >= 0) {
+            crc   = PIOS_BL_HELPER_CRC_Sector_Calc(start, size);
+            start = start - baseOfAdressType(FW);
+        } else {
+            start = 0;
+            size  = 0;
+        }
+        Buffer[0] = 0x01;
+        Buffer[1] = Rep_Sector_CRC;
+        pack_uint32(start, &Buffer[2]);
+        pack_uint32(size, &Buffer[6]);
+        pack_uint32(crc, &Buffer[10]);
+        sendData(Buffer + 1, 63);
+        break;
+    }
+    case Keep_Sector:
+        // Count is the offset of the sector, Data its CRC, a sector which does not match is rewritten
+        if (deltaUpload && DeviceState == uploading) {
+            uint32_t start;
+            uint32_t size;
+            int16_t index = sectorIndex(baseOfAdressType(FW) + Count, &start, &size);
+            if (index >= 0 && index < DFU_MAX_SECTORS && PIOS_BL_HELPER_CRC_Sector_Calc(start, size) == Data) {
+                keptSectors[index / 8] |= 1 << (index % 8);
+            }
+        }
+        break;
+    case Upload_Skip:
+        // Count is the first packet skipped, Data the next one sent, the skipped packets only hold data of kept sectors
+        if (deltaUpload && Next_Packet != 0) {
+            if (Data > SizeOfTransfer || Data < Count) {
+                DeviceState = too_many_packets;
+                Aditionals  = Data;
+            } else if (Count == Next_Packet - 1) {
+                Next_Packet = Data + 1;
+            } else if (Count > Next_Packet - 1) {
+                // a packet before the skipped ones went missing
+                DeviceState = wrong_packet_received;
+                Aditionals  = Next_Packet - 1;
+            }
+        }
+        break;
 
     case Op_END:
         if (DeviceState == uploading) {
             if (Next_Packet - 1 == SizeOfTransfer) {
                 Next_Packet = 0;
-                if ((TransferType != FW) || (Expected_CRC == CalcFirmCRC())) {
+                if (deltaUpload && eraseDeltaRemainder() != 1) {
+                    DeviceState = Last_operation_failed;
+                    Aditionals  = (uint32_t)Command;
+                } else if ((TransferType != FW) || (Expected_CRC == CalcFirmCRC())) {
                     DeviceState = Last_operation_Success;
                 } else {
                     DeviceState = CRC_Fail;
@@ -335,6 +422,7 @@ void processComand(uint8_t *xReceive_Buffer)
                 Next_Packet = 0;
                 DeviceState = too_few_packets;
             }
+            deltaUpload = false;
         }
         break;
     case Download_Req:
@@ -477,3 +565,77 @@ bool flash_read(uint8_t *buffer, uint32_t adr, DFUProgType type)
         return false;
     }
 }
+
+/**
+ * Sector of the firmware bank holding adr, and its position in the bank
+ * \return the index of the sector, -1 if adr is outside the bank
+ */
+static int16_t sectorIndex(uint32_t adr, uint32_t *start, uint32_t *size)
+{
+    uint32_t end = baseOfAdressType(FW) + currentDevice.sizeOfCode + currentDevice.sizeOfDescription;
+    int16_t index = 0;
+
+    for (uint32_t sector = baseOfAdressType(FW); sector < end; sector = *start + *size, index++) {
+        if (!PIOS_BL_HELPER_FLASH_GetSector(sector, start, size)) {
+            return -1;
+        }
+        if (adr < *start + *size) {
+            return (adr >= *start) ? index : -1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Before writing a word of a delta upload, erase its sector the first time it is reached
+ * \param[out] write false when the word belongs to a kept sector and is not written
+ * \return 1 on success
+ */
+static uint8_t prepareDeltaWord(uint32_t adr, bool *write)
+{
+    if (adr >= curSectorEnd) {
+        uint32_t start;
+        uint32_t size;
+        int16_t index = sectorIndex(adr, &start, &size);
+        if (index < 0) {
+            return 0;
+        }
+        curSectorEnd  = start + size;
+        curSectorKept = index < DFU_MAX_SECTORS && (keptSectors[index / 8] & (1 << (index % 8)));
+        if (!curSectorKept && start >= flashReadyEnd) {
+            if (PIOS_BL_HELPER_FLASH_EraseSector(start) != 1) {
+                return 0;
+            }
+        }
+        if (curSectorEnd > flashReadyEnd) {
+            flashReadyEnd = curSectorEnd;
+        }
+    }
+    *write = !curSectorKept;
+    return 1;
+}
+
+/**
+ * Erase the sectors past the end of a delta upload which are not kept, they
+ * may hold the remains of a bigger firmware and the description is written there
+ * \return 1 on success
+ */
+static uint8_t eraseDeltaRemainder(void)
+{
+    uint32_t end = baseOfAdressType(FW) + currentDevice.sizeOfCode + currentDevice.sizeOfDescription;
+    uint32_t start;
+    uint32_t size;
+
+    for (uint32_t sector = flashReadyEnd; sector < end; sector = start + size) {
+        int16_t index = sectorIndex(sector, &start, &size);
+        if (index < 0) {
+            return 0;
+        }
+        if (index >= DFU_MAX_SECTORS || !(keptSectors[index / 8] & (1 << (index % 8)))) {
+            if (PIOS_BL_HELPER_FLASH_EraseSector(start) != 1) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
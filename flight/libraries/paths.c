@@ -34,9 +34,68 @@
 // no direct UAVObject usage allowed in this file
 
 // private functions
-static void path_endpoint(PathDesiredData *path, float *cur_point, struct path_status *status, bool mode);
-static void path_vector(PathDesiredData *path, float *cur_point, struct path_status *status, bool mode);
-static void path_circle(PathDesiredData *path, float *cur_point, struct path_status *status, bool clockwise);
+static void path_endpoint(const struct path_segment *segment, const float *cur_point, struct path_status *status);
+static void path_vector(const struct path_segment *segment, const float *cur_point, struct path_status *status);
+static void path_circle(const struct path_segment *segment, const float *cur_point, struct path_status *status);
+
+/**
+ * @brief Compute the geometry of a path segment that does not depend on the position
+ * @param[out] segment Segment to initialise
+ * @param[in] path PathDesired structure
+ */
+void path_segment_init(struct path_segment *segment, const PathDesiredData *path)
+{
+    segment->Mode = path->Mode;
+
+    segment->Start[0]         = path->Start.North;
+    segment->Start[1]         = path->Start.East;
+    segment->Start[2]         = path->Start.Down;
+    segment->End[0]           = path->End.North;
+    segment->End[1]           = path->End.East;
+    segment->End[2]           = path->End.Down;
+    segment->StartingVelocity = path->StartingVelocity;
+    segment->EndingVelocity   = path->EndingVelocity;
+
+    switch (path->Mode) {
+    case PATHDESIRED_MODE_DRIVEVECTOR:
+    case PATHDESIRED_MODE_DRIVEENDPOINT:
+    case PATHDESIRED_MODE_FLYCIRCLERIGHT:
+    case PATHDESIRED_MODE_DRIVECIRCLERIGHT:
+    case PATHDESIRED_MODE_FLYCIRCLELEFT:
+    case PATHDESIRED_MODE_DRIVECIRCLELEFT:
+        segment->mode3D = false;
+        break;
+    case PATHDESIRED_MODE_BRAKE:
+    case PATHDESIRED_MODE_FLYVECTOR:
+    case PATHDESIRED_MODE_FLYENDPOINT:
+        segment->mode3D = true;
+        break;
+    default:
+        // the endpoint failsafe of unknown modes is 2D
+        segment->mode3D = false;
+        break;
+    }
+
+    segment->vector[0] = segment->End[0] - segment->Start[0];
+    segment->vector[1] = segment->End[1] - segment->Start[1];
+    segment->vector[2] = segment->mode3D ? segment->End[2] - segment->Start[2] : 0.0f;
+    segment->length    = vector_lengthf(segment->vector, 3);
+
+    if (segment->length > 1e-6f) {
+        segment->direction[0] = segment->vector[0] / segment->length;
+        segment->direction[1] = segment->vector[1] / segment->length;
+        segment->direction[2] = segment->vector[2] / segment->length;
+    } else {
+        segment->direction[0] = segment->direction[1] = segment->direction[2] = 0.0f;
+    }
+
+    // circles go around End through Start, always horizontal
+    segment->radius = sqrtf(squaref(segment->vector[0]) + squaref(segment->vector[1]));
+    segment->start_angle = atan2f(segment->vector[0], segment->vector[1]);
+    if (segment->start_angle < 0) {
+        segment->start_angle += 2.0f * M_PI_F;
+    }
+}
 
 /**
  * @brief Compute progress along path and deviation from it
@@ -46,34 +105,39 @@ static void path_circle(PathDesiredData *path, float *cur_point, struct path_sta
  */
 void path_progress(PathDesiredData *path, float *cur_point, struct path_status *status)
 {
-    switch (path->Mode) {
+    struct path_segment segment;
+
+    path_segment_init(&segment, path);
+    path_segment_progress(&segment, cur_point, status);
+}
+
+/**
+ * @brief Compute progress along a segment prepared by path_segment_init() and deviation from it
+ * @param[in] segment Segment geometry
+ * @param[in] cur_point Current location
+ * @param[out] status Structure containing progress along path and deviation
+ */
+void path_segment_progress(const struct path_segment *segment, const float *cur_point, struct path_status *status)
+{
+    switch (segment->Mode) {
     case PATHDESIRED_MODE_BRAKE: // should never get here...
     case PATHDESIRED_MODE_FLYVECTOR:
-        return path_vector(path, cur_point, status, true);
-
-        break;
     case PATHDESIRED_MODE_DRIVEVECTOR:
-        return path_vector(path, cur_point, status, false);
+        return path_vector(segment, cur_point, status);
 
         break;
     case PATHDESIRED_MODE_FLYCIRCLERIGHT:
     case PATHDESIRED_MODE_DRIVECIRCLERIGHT:
-        return path_circle(path, cur_point, status, 1);
-
-        break;
     case PATHDESIRED_MODE_FLYCIRCLELEFT:
     case PATHDESIRED_MODE_DRIVECIRCLELEFT:
-        return path_circle(path, cur_point, status, 0);
+        return path_circle(segment, cur_point, status);
 
         break;
     case PATHDESIRED_MODE_FLYENDPOINT:
-        return path_endpoint(path, cur_point, status, true);
-
-        break;
     case PATHDESIRED_MODE_DRIVEENDPOINT:
     default:
         // use the endpoint as default failsafe if called in unknown modes
-        return path_endpoint(path, cur_point, status, false);
+        return path_endpoint(segment, cur_point, status);
 
         break;
     }
@@ -81,28 +145,21 @@ void path_progress(PathDesiredData *path, float *cur_point, struct path_status *
 
 /**
  * @brief Compute progress towards endpoint. Deviation equals distance
- * @param[in] path PathDesired
+ * @param[in] segment Segment geometry
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
- * @param[in] mode3D set true to include altitude in distance and progress calculation
  */
-static void path_endpoint(PathDesiredData *path, float *cur_point, struct path_status *status, bool mode3D)
+static void path_endpoint(const struct path_segment *segment, const float *cur_point, struct path_status *status)
 {
     float diff[3];
-    float dist_path, dist_diff;
-
-    // Distance to go
-    status->path_vector[0] = path->End.North - path->Start.North;
-    status->path_vector[1] = path->End.East - path->Start.East;
-    status->path_vector[2] = mode3D ? path->End.Down - path->Start.Down : 0.0f;
+    float dist_diff;
 
     // Current progress location relative to end
-    diff[0]   = path->End.North - cur_point[0];
-    diff[1]   = path->End.East - cur_point[1];
-    diff[2]   = mode3D ? path->End.Down - cur_point[2] : 0.0f;
+    diff[0]   = segment->End[0] - cur_point[0];
+    diff[1]   = segment->End[1] - cur_point[1];
+    diff[2]   = segment->mode3D ? segment->End[2] - cur_point[2] : 0.0f;
 
     dist_diff = vector_lengthf(diff, 3);
-    dist_path = vector_lengthf(status->path_vector, 3);
 
     if (dist_diff < 1e-6f) {
         status->fractional_progress  = 1;
@@ -114,8 +171,8 @@ static void path_endpoint(PathDesiredData *path, float *cur_point, struct path_s
         return;
     }
 
-    if (fmaxf(dist_path, 1.0f) > dist_diff) {
-        status->fractional_progress = 1 - dist_diff / fmaxf(dist_path, 1.0f);
+    if (fmaxf(segment->length, 1.0f) > dist_diff) {
+        status->fractional_progress = 1 - dist_diff / fmaxf(segment->length, 1.0f);
     } else {
         status->fractional_progress = 0; // we don't want fractional_progress to become negative
     }
@@ -127,53 +184,46 @@ static void path_endpoint(PathDesiredData *path, float *cur_point, struct path_s
     status->correction_vector[2] = diff[2];
 
     // base movement direction in this mode is a constant velocity offset on top of correction in the same direction
-    status->path_vector[0] = path->EndingVelocity * status->correction_vector[0] / dist_diff;
-    status->path_vector[1] = path->EndingVelocity * status->correction_vector[1] / dist_diff;
-    status->path_vector[2] = path->EndingVelocity * status->correction_vector[2] / dist_diff;
+    const float velocity = segment->EndingVelocity / dist_diff;
+    status->path_vector[0] = velocity * status->correction_vector[0];
+    status->path_vector[1] = velocity * status->correction_vector[1];
+    status->path_vector[2] = velocity * status->correction_vector[2];
 }
 
 /**
  * @brief Compute progress along path and deviation from it
- * @param[in] path PathDesired
+ * @param[in] segment Segment geometry
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
- * @param[in] mode3D set true to include altitude in distance and progress calculation
  */
-static void path_vector(PathDesiredData *path, float *cur_point, struct path_status *status, bool mode3D)
+static void path_vector(const struct path_segment *segment, const float *cur_point, struct path_status *status)
 {
     float diff[3];
-    float dist_path;
     float dot;
     float velocity;
     float track_point[3];
 
-    // Distance to go
-    status->path_vector[0] = path->End.North - path->Start.North;
-    status->path_vector[1] = path->End.East - path->Start.East;
-    status->path_vector[2] = mode3D ? path->End.Down - path->Start.Down : 0.0f;
-
-    // Current progress location relative to start
-    diff[0]   = cur_point[0] - path->Start.North;
-    diff[1]   = cur_point[1] - path->Start.East;
-    diff[2]   = mode3D ? cur_point[2] - path->Start.Down : 0.0f;
-
-    dot       = status->path_vector[0] * diff[0] + status->path_vector[1] * diff[1] + status->path_vector[2] * diff[2];
-    dist_path = vector_lengthf(status->path_vector, 3);
-
-    if (dist_path > 1e-6f) {
-        // Compute direction to travel & progress
-        status->fractional_progress = dot / (dist_path * dist_path);
-    } else {
+    if (segment->length <= 1e-6f) {
         // Fly towards the endpoint to prevent flying away,
         // but assume progress=1 either way.
-        path_endpoint(path, cur_point, status, mode3D);
+        path_endpoint(segment, cur_point, status);
         status->fractional_progress = 1;
         return;
     }
+
+    // Current progress location relative to start
+    diff[0] = cur_point[0] - segment->Start[0];
+    diff[1] = cur_point[1] - segment->Start[1];
+    diff[2] = segment->mode3D ? cur_point[2] - segment->Start[2] : 0.0f;
+
+    // Compute direction to travel & progress
+    dot     = segment->direction[0] * diff[0] + segment->direction[1] * diff[1] + segment->direction[2] * diff[2];
+    status->fractional_progress = dot / segment->length;
+
     // Compute point on track that is closest to our current position.
-    track_point[0] = status->fractional_progress * status->path_vector[0] + path->Start.North;
-    track_point[1] = status->fractional_progress * status->path_vector[1] + path->Start.East;
-    track_point[2] = status->fractional_progress * status->path_vector[2] + path->Start.Down;
+    track_point[0] = status->fractional_progress * segment->vector[0] + segment->Start[0];
+    track_point[1] = status->fractional_progress * segment->vector[1] + segment->Start[1];
+    track_point[2] = status->fractional_progress * segment->vector[2] + segment->Start[2];
 
     status->correction_vector[0] = track_point[0] - cur_point[0];
     status->correction_vector[1] = track_point[1] - cur_point[1];
@@ -182,50 +232,46 @@ static void path_vector(PathDesiredData *path, float *cur_point, struct path_sta
     status->error = vector_lengthf(status->correction_vector, 3);
 
     // correct movement vector to current velocity
-    velocity = path->StartingVelocity + boundf(status->fractional_progress, 0.0f, 1.0f) * (path->EndingVelocity - path->StartingVelocity);
-    status->path_vector[0] = velocity * status->path_vector[0] / dist_path;
-    status->path_vector[1] = velocity * status->path_vector[1] / dist_path;
-    status->path_vector[2] = velocity * status->path_vector[2] / dist_path;
+    velocity = segment->StartingVelocity + boundf(status->fractional_progress, 0.0f, 1.0f) * (segment->EndingVelocity - segment->StartingVelocity);
+    status->path_vector[0] = velocity * segment->direction[0];
+    status->path_vector[1] = velocity * segment->direction[1];
+    status->path_vector[2] = velocity * segment->direction[2];
 }
 
 /**
  * @brief Compute progress along circular path and deviation from it
- * @param[in] path PathDesired
+ * @param[in] segment Segment geometry
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_circle(PathDesiredData *path, float *cur_point, struct path_status *status, bool clockwise)
+static void path_circle(const struct path_segment *segment, const float *cur_point, struct path_status *status)
 {
-    float radius_north, radius_east, diff_north, diff_east, diff_down;
-    float radius, cradius;
+    const bool clockwise = segment->Mode == PATHDESIRED_MODE_FLYCIRCLERIGHT || segment->Mode == PATHDESIRED_MODE_DRIVECIRCLERIGHT;
+    float diff_north, diff_east, diff_down;
+    float cradius;
     float normal[2];
     float progress;
-    float a_diff, a_radius;
-
-    // Radius
-    radius_north = path->End.North - path->Start.North;
-    radius_east  = path->End.East - path->Start.East;
+    float a_diff;
 
     // Current location relative to center
-    diff_north   = cur_point[0] - path->End.North;
-    diff_east    = cur_point[1] - path->End.East;
-    diff_down    = cur_point[2] - path->End.Down;
+    diff_north = cur_point[0] - segment->End[0];
+    diff_east  = cur_point[1] - segment->End[1];
+    diff_down  = cur_point[2] - segment->End[2];
 
-    radius  = sqrtf(squaref(radius_north) + squaref(radius_east));
-    cradius = sqrtf(squaref(diff_north) + squaref(diff_east));
+    cradius    = sqrtf(squaref(diff_north) + squaref(diff_east));
 
     // circles are always horizontal (for now - TODO: allow 3d circles - problem: clockwise/counterclockwise does no longer apply)
     status->path_vector[2] = 0.0f;
 
     // error is current radius minus wanted radius - positive if too close
-    status->error = radius - cradius;
+    status->error = segment->radius - cradius;
 
     if (cradius < 1e-6f) {
         // cradius is zero, just fly somewhere
         status->fractional_progress  = 1;
         status->correction_vector[0] = 0;
         status->correction_vector[1] = 0;
-        status->path_vector[0] = path->EndingVelocity;
+        status->path_vector[0] = segment->EndingVelocity;
         status->path_vector[1] = 0;
     } else {
         if (clockwise) {
@@ -239,17 +285,13 @@ static void path_circle(PathDesiredData *path, float *cur_point, struct path_sta
         }
 
         // normalize progress to 0..1
-        a_diff   = atan2f(diff_north, diff_east);
-        a_radius = atan2f(radius_north, radius_east);
+        a_diff = atan2f(diff_north, diff_east);
 
         if (a_diff < 0) {
             a_diff += 2.0f * M_PI_F;
         }
-        if (a_radius < 0) {
-            a_radius += 2.0f * M_PI_F;
-        }
 
-        progress = (a_diff - a_radius + M_PI_F) / (2.0f * M_PI_F);
+        progress = (a_diff - segment->start_angle + M_PI_F) / (2.0f * M_PI_F);
 
         if (progress < 0.0f) {
             progress += 1.0f;
@@ -264,8 +306,8 @@ static void path_circle(PathDesiredData *path, float *cur_point, struct path_sta
         status->fractional_progress = progress;
 
         // Compute direction to travel
-        status->path_vector[0] = normal[0] * path->EndingVelocity;
-        status->path_vector[1] = normal[1] * path->EndingVelocity;
+        status->path_vector[0] = normal[0] * segment->EndingVelocity;
+        status->path_vector[1] = normal[1] * segment->EndingVelocity;
 
         // Compute direction to correct error
         status->correction_vector[0] = status->error * diff_north / cradius;
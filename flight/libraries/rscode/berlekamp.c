@@ -76,7 +76,7 @@ Modified_Berlekamp_Massey (void)
   copy_poly(psi, gamma);	
   k = -1; L = NErasures;
 	
-  for (n = NErasures; n < RS_ECC_NPARITY; n++) {
+  for (n = NErasures; n < NParity; n++) {
 	
     d = compute_discrepancy(psi, synBytes, L, n);
 		
@@ -119,7 +119,7 @@ compute_modified_omega ()
 	
   mult_polys(product, Lambda, synBytes);	
   zero_poly(Omega);
-  for(i = 0; i < RS_ECC_NPARITY; i++) Omega[i] = product[i];
+  for(i = 0; i < NParity; i++) Omega[i] = product[i];
 
 }
 
@@ -242,7 +242,7 @@ Find_Roots (void)
   for (r = 1; r < 256; r++) {
     sum = 0;
     /* evaluate lambda at r */
-    for (k = 0; k < RS_ECC_NPARITY+1; k++) {
+    for (k = 0; k < NParity+1; k++) {
       sum ^= gmult(gexp[(k*r)%255], Lambda[k]);
     }
     if (sum == 0) 
@@ -280,11 +280,14 @@ correct_errors_erasures (unsigned char codeword[],
   NErasures = nerasures;
   for (i = 0; i < NErasures; i++) ErasureLocs[i] = erasures[i];
 
+  /* nothing to locate in a clean codeword */
+  if (NErasures == 0 && !check_syndrome()) return(0);
+
   Modified_Berlekamp_Massey();
   Find_Roots();
   
 
-  if ((NErrors <= RS_ECC_NPARITY) && NErrors > 0) { 
+  if ((NErrors <= NParity) && NErrors > 0) { 
 
     /* first check for illegal error locs */
     for (r = 0; r < NErrors; r++) {
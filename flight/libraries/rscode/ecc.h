@@ -55,9 +55,18 @@ typedef unsigned short BIT16;
 
 /* **************************************************************** */
 
+/* RS_ECC_NPARITY is the largest number of parity bytes, set_ecc_parity()
+ * can select any smaller even number at run time. */
+#if (RS_ECC_NPARITY & 1)
+#error RS_ECC_NPARITY must be even
+#endif
+
 /* Maximum degree of various polynomials. */
 #define MAXDEG (RS_ECC_NPARITY*2)
 
+/* Parity bytes of the current code */
+extern int NParity;
+
 /*************************************/
 /* Encoder parity bytes */
 extern int pBytes[MAXDEG];
@@ -70,6 +79,7 @@ extern int synBytes[MAXDEG];
 
 /* Reed Solomon encode/decode routines */
 void initialize_ecc (void);
+void set_ecc_parity (int npar);
 int check_syndrome (void);
 void decode_data (unsigned char data[], int nbytes);
 void encode_data (unsigned char msg[], int nbytes, unsigned char dst[]);
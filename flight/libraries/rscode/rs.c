@@ -35,8 +35,26 @@ int pBytes[MAXDEG];
 /* Decoder syndrome bytes */
 int synBytes[MAXDEG];
 
-/* generator polynomial */
-int genPoly[MAXDEG*2];
+/* Parity bytes of the current code, set_ecc_parity() selects it */
+int NParity = RS_ECC_NPARITY;
+
+/* generator polynomials of all the even parity depths */
+static int genPolys[RS_ECC_NPARITY/2][RS_ECC_NPARITY+1];
+
+/* generator polynomial of the current code */
+static int *genPoly = genPolys[RS_ECC_NPARITY/2-1];
+
+/* logs of the generator coefficients, the encoder multiplies with one
+ * table lookup per coefficient. Full product tables would be 256 bytes
+ * per coefficient, too much RAM for the small targets. */
+static unsigned char genLogs[RS_ECC_NPARITY/2][RS_ECC_NPARITY];
+static unsigned char *genLog = genLogs[RS_ECC_NPARITY/2-1];
+
+/* set if a generator has a zero coefficient, which has no log */
+static int genZero;
+
+/* log of alpha^(k*(j+1)) for k = 1..4, the syndrome steps of root j */
+static int synSteps[RS_ECC_NPARITY][4];
 
 //int DEBUG = FALSE;
 
@@ -47,11 +65,37 @@ compute_genpoly (int nbytes, int genpoly[]);
 void
 initialize_ecc ()
 {
+  int i, j, tmp[MAXDEG*2];
+
   /* Initialize the galois field arithmetic tables */
     init_galois_tables();
 
-    /* Compute the encoder generator polynomial */
-    compute_genpoly(RS_ECC_NPARITY, genPoly);
+    /* Compute the encoder generator polynomials */
+    for (i = 0; i < RS_ECC_NPARITY/2; i++) {
+      compute_genpoly(2*(i+1), tmp);
+      for (j = 0; j <= RS_ECC_NPARITY; j++) genPolys[i][j] = tmp[j];
+      for (j = 0; j < 2*(i+1); j++) {
+        if (tmp[j] == 0) genZero = TRUE;
+        genLogs[i][j] = glog[tmp[j]];
+      }
+    }
+
+    for (i = 0; i < RS_ECC_NPARITY; i++) {
+      for (j = 0; j < 4; j++) synSteps[i][j] = ((j+1)*(i+1)) % 255;
+    }
+    set_ecc_parity(RS_ECC_NPARITY);
+}
+
+/* Select the number of parity bytes used by the encoder and the decoder.
+ * It must be even, and between 2 and RS_ECC_NPARITY.
+ */
+void
+set_ecc_parity (int npar)
+{
+  if (npar < 2 || npar > RS_ECC_NPARITY || (npar & 1)) return;
+  NParity = npar;
+  genPoly = genPolys[npar/2-1];
+  genLog = genLogs[npar/2-1];
 }
 
 void
@@ -68,7 +112,7 @@ print_parity (void)
 #ifdef NEVER
   int i;
   printf("Parity Bytes: ");
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
+  for (i = 0; i < NParity; i++) 
     printf("[%d]:%x, ",i,pBytes[i]);
   printf("\n");
 #endif
@@ -81,7 +125,7 @@ print_syndrome (void)
 #ifdef NEVER
   int i;
   printf("Syndrome Bytes: ");
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
+  for (i = 0; i < NParity; i++) 
     printf("[%d]:%x, ",i,synBytes[i]);
   printf("\n");
 #endif
@@ -95,8 +139,8 @@ build_codeword (unsigned char msg[], int nbytes, unsigned char dst[])
 	
   for (i = 0; i < nbytes; i++) dst[i] = msg[i];
 	
-  for (i = 0; i < RS_ECC_NPARITY; i++) {
-    dst[i+nbytes] = pBytes[RS_ECC_NPARITY-1-i];
+  for (i = 0; i < NParity; i++) {
+    dst[i+nbytes] = pBytes[NParity-1-i];
   }
 }
 	
@@ -105,19 +149,47 @@ build_codeword (unsigned char msg[], int nbytes, unsigned char dst[])
  *
  * Computes the syndrome of a codeword. Puts the results
  * into the synBytes[] array.
+ *
+ * The codeword is read 4 bytes at a time, the logs of the
+ * bytes are shared by all the roots and each root then
+ * takes 4 Horner steps at once:
+ *   S = S*a^4 + d0*a^3 + d1*a^2 + d2*a + d3
  */
  
 void
 decode_data(unsigned char data[], int nbytes)
 {
-  int i, j, sum;
-  for (j = 0; j < RS_ECC_NPARITY;  j++) {
-    sum	= 0;
-    for (i = 0; i < nbytes; i++) {
-      sum = data[i] ^ gmult(gexp[j+1], sum);
+  int i, j, k, sum, lsum, words = nbytes & ~3;
+  int syn[RS_ECC_NPARITY];
+  int l[4];
+
+  for (j = 0; j < NParity; j++) syn[j] = 0;
+
+  for (i = 0; i < words; i += 4) {
+    /* -1 for the zero bytes, which have no log */
+    for (k = 0; k < 4; k++) l[k] = data[i+k] ? glog[data[i+k]] : -1;
+    for (j = 0; j < NParity; j++) {
+      const int *step = synSteps[j];
+      sum = syn[j];
+      lsum = sum ? glog[sum] : -1;
+      sum = (l[3] < 0) ? 0 : gexp[l[3]];
+      if (lsum >= 0) sum ^= gexp[lsum + step[3]];
+      if (l[0] >= 0) sum ^= gexp[l[0] + step[2]];
+      if (l[1] >= 0) sum ^= gexp[l[1] + step[1]];
+      if (l[2] >= 0) sum ^= gexp[l[2] + step[0]];
+      syn[j] = sum;
+    }
+  }
+
+  for (; i < nbytes; i++) {
+    for (j = 0; j < NParity; j++) {
+      syn[j] = data[i] ^ (syn[j] ? gexp[glog[syn[j]] + synSteps[j][0]] : 0);
     }
-    synBytes[j]  = sum;
   }
+
+  for (j = 0; j < NParity; j++) synBytes[j] = syn[j];
+  /* left over from a deeper code, they would end up in Omega */
+  for (; j < MAXDEG; j++) synBytes[j] = 0;
 }
 
 
@@ -126,7 +198,7 @@ int
 check_syndrome (void)
 {
  int i, nz = 0;
- for (i =0 ; i < RS_ECC_NPARITY; i++) {
+ for (i =0 ; i < NParity; i++) {
   if (synBytes[i] != 0) {
       nz = 1;
       break;
@@ -189,17 +261,34 @@ encode_data (unsigned char msg[], int nbytes, unsigned char dst[])
 {
   int i, LFSR[RS_ECC_NPARITY+1],dbyte, j;
 	
-  for(i=0; i < RS_ECC_NPARITY+1; i++) LFSR[i]=0;
+  for(i=0; i < NParity+1; i++) LFSR[i]=0;
 
-  for (i = 0; i < nbytes; i++) {
-    dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY-1];
-    for (j = RS_ECC_NPARITY-1; j > 0; j--) {
-      LFSR[j] = LFSR[j-1] ^ gmult(genPoly[j], dbyte);
+  if (genZero) {
+    for (i = 0; i < nbytes; i++) {
+      dbyte = msg[i] ^ LFSR[NParity-1];
+      for (j = NParity-1; j > 0; j--) {
+        LFSR[j] = LFSR[j-1] ^ gmult(genPoly[j], dbyte);
+      }
+      LFSR[0] = gmult(genPoly[0], dbyte);
+    }
+  } else {
+    /* the feedback byte is zero checked once, its log serves every coefficient */
+    for (i = 0; i < nbytes; i++) {
+      dbyte = msg[i] ^ LFSR[NParity-1];
+      if (dbyte == 0) {
+        for (j = NParity-1; j > 0; j--) LFSR[j] = LFSR[j-1];
+        LFSR[0] = 0;
+      } else {
+        int ldbyte = glog[dbyte];
+        for (j = NParity-1; j > 0; j--) {
+          LFSR[j] = LFSR[j-1] ^ gexp[genLog[j] + ldbyte];
+        }
+        LFSR[0] = gexp[genLog[0] + ldbyte];
+      }
     }
-    LFSR[0] = gmult(genPoly[0], dbyte);
   }
 
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
+  for (i = 0; i < NParity; i++) 
     pBytes[i] = LFSR[i];
 	
   build_codeword(msg, nbytes, dst);
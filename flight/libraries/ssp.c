@@ -37,6 +37,12 @@
 * This protocol is best used in cases where one device is the master and the other is the slave, or a don't
 * speak unless spoken to type of approach.
 *
+* Windowed mode: a port configured with a rxWindow lets the host send up to that many packets ahead of the
+* ACKs, when the synchronise request asks for it (see SSP_SYNC_MAGIC). Packets are then only accepted in
+* sequence, an ACK acknowledges the packet and all those before it, and a packet out of sequence is answered
+* with the ACK of the last one accepted so that the host resends from there. Old hosts send an empty
+* synchronise request and keep the stop-and-wait protocol.
+*
 * The following are items are required to initialize a port for communications:
 * 1. The number attempts for each packet
 * 2. time to wait for an ack.
@@ -115,7 +121,10 @@ static int16_t sf_DecodeState(Port_t *thisport, uint8_t c);
 static int16_t sf_ReceiveState(Port_t *thisport, uint8_t c);
 
 static void sf_SendPacket(Port_t *thisport);
+static void sf_SendFrame(Port_t *thisport, const uint8_t *buf);
 static void sf_SendAckPacket(Port_t *thisport, uint8_t seqNumber);
+static void sf_SendSynchAck(Port_t *thisport);
+static int16_t sf_ReceiveWindowed(Port_t *thisport);
 static void sf_MakePacket(uint8_t *buf, const uint8_t *pdata, uint16_t length,
                           uint8_t seqNo);
 static int16_t sf_ReceivePacket(Port_t *thisport);
@@ -196,6 +205,9 @@ void ssp_Init(Port_t *thisport, const PortConfig_t *const info)
     thisport->rxSeqNo = 255;
     thisport->txSeqNo = 255;
     thisport->SendState     = SSP_IDLE;
+    thisport->rxWindow      = (info->rxWindow > SSP_MAX_WINDOW) ? SSP_MAX_WINDOW : info->rxWindow;
+    thisport->windowed      = FALSE;
+    thisport->pfRxSpace     = info->pfRxSpace;
 }
 
 /*!
@@ -421,16 +433,27 @@ uint16_t ssp_Synchronise(Port_t *thisport)
  * Packet should be formed through the use of sf_MakePacket before calling this function.
  */
 static void sf_SendPacket(Port_t *thisport)
+{
+    sf_SendFrame(thisport, thisport->txBuf);
+    thisport->retryCount++;
+}
+
+/*!
+ * \brief   sends out a preformatted packet held in any buffer
+ * \param   thisport = which port to use.
+ * \param	buf = packet formed by sf_MakePacket
+ * \return  none.
+ */
+static void sf_SendFrame(Port_t *thisport, const uint8_t *buf)
 {
     // add 3 to packet data length for: 1 length + 2 CRC (packet overhead)
-    uint8_t packetLen = thisport->txBuf[LENGTH] + 3;
+    uint16_t packetLen = buf[LENGTH] + 3;
 
     // use the raw serial write function so the SYNC byte does not get 'escaped'
     thisport->pfSerialWrite(SYNC);
-    for (uint8_t x = 0; x < packetLen; x++) {
-        sf_write_byte(thisport, thisport->txBuf[x]);
+    for (uint16_t x = 0; x < packetLen; x++) {
+        sf_write_byte(thisport, buf[x]);
     }
-    thisport->retryCount++;
 }
 
 /*!
@@ -486,11 +509,40 @@ static void sf_SendAckPacket(Port_t *thisport, uint8_t seqNumber)
     uint8_t AckSeqNumber = SETBIT(seqNumber, ACK_BIT);
 
     // create the packet, note we pass AckSequenceNumber directly
-    sf_MakePacket(thisport->txBuf, NULL, 0, AckSeqNumber);
-    sf_SendPacket(thisport);
+    sf_MakePacket(thisport->ackBuf, NULL, 0, AckSeqNumber);
+    sf_SendFrame(thisport, thisport->ackBuf);
     // we don't set the timeout for an ACK because we don't ACK our ACKs in this protocol
 }
 
+/*!
+ * \brief   answers a synchronise request, in windowed mode if the host asked for it
+ * \param   thisport = which port to use
+ * \return  none.
+ *
+ * \note
+ * The ACK of a windowed request carries the window and frame length the host may use.
+ */
+static void sf_SendSynchAck(Port_t *thisport)
+{
+    uint8_t *request = &thisport->rxBuf[DATA];
+
+    thisport->windowed = (thisport->rxWindow > 0 && thisport->rxBufLen >= SSP_SYNC_LENGTH &&
+                          request[0] == SSP_SYNC_MAGIC && request[1] == SSP_SYNC_VERSION && request[2] > 0);
+    if (!thisport->windowed) {
+        sf_SendAckPacket(thisport, 0);
+        return;
+    }
+
+    uint8_t reply[SSP_SYNC_LENGTH];
+    reply[0] = SSP_SYNC_MAGIC;
+    reply[1] = SSP_SYNC_VERSION;
+    reply[2] = (request[2] < thisport->rxWindow) ? request[2] : thisport->rxWindow;
+    // rxBufSize bounds the length byte, which counts the sequence number too
+    reply[3] = (request[3] < thisport->rxBufSize - 1) ? request[3] : thisport->rxBufSize - 1;
+    sf_MakePacket(thisport->ackBuf, reply, SSP_SYNC_LENGTH, ACK_BIT);
+    sf_SendFrame(thisport, thisport->ackBuf);
+}
+
 /*!
  * \brief   writes a byte out the output channel. Adds escape byte where needed
  * \param   thisport = which port to use
@@ -769,9 +821,11 @@ static int16_t sf_ReceivePacket(Port_t *thisport)
 #ifdef ACTIVE_SYNCH
             thisport->sendSynch = TRUE;
 #endif
-            sf_SendAckPacket(thisport, thisport->rxBuf[SEQNUM]);
+            sf_SendSynchAck(thisport);
             thisport->rxSeqNo   = 0;
             value = FALSE;
+        } else if (thisport->windowed) {
+            value = sf_ReceiveWindowed(thisport);
         } else if (thisport->rxBuf[SEQNUM] == thisport->rxSeqNo) {
             // Already seen this packet, just ack it, don't act on the packet.
             sf_SendAckPacket(thisport, thisport->rxBuf[SEQNUM]);
@@ -793,3 +847,35 @@ static int16_t sf_ReceivePacket(Port_t *thisport)
     }
     return value;
 }
+
+/*!
+ * \brief   receives a data packet in windowed mode
+ * \param   thisport = which port to use
+ * \return  true = the packet was handed to the application
+ * \return	false = otherwise
+ *
+ * \note
+ * Only the packet following the last one accepted is handed to the application, any other is
+ * answered with the ACK of the last one accepted. A packet the application has no room for is
+ * dropped without ACK, the host resends it once its ACK timed out.
+ */
+static int16_t sf_ReceiveWindowed(Port_t *thisport)
+{
+    uint8_t expected = (thisport->rxSeqNo >= 0x7F) ? 1 : thisport->rxSeqNo + 1;
+
+    if (thisport->rxBuf[SEQNUM] != expected) {
+        if (thisport->rxSeqNo != 0) {
+            sf_SendAckPacket(thisport, thisport->rxSeqNo);
+        }
+        return FALSE;
+    }
+    if (thisport->pfRxSpace != NULL && thisport->pfRxSpace() < thisport->rxBufLen) {
+        return FALSE;
+    }
+    thisport->rxSeqNo = expected;
+    if (thisport->pfCallBack != NULL) {
+        thisport->pfCallBack(&(thisport->rxBuf[DATA]), thisport->rxBufLen);
+    }
+    sf_SendAckPacket(thisport, expected);
+    return TRUE;
+}
@@ -69,6 +69,10 @@ static int8_t counter;
 
 #define ACTUATOR_ONESHOT125_CLOCK       2000000
 #define ACTUATOR_ONESHOT125_PULSE_SCALE 4
+#define ACTUATOR_MULTISHOT_CLOCK        12000000
+#define ACTUATOR_DSHOT_PULSE_MIN        1000
+#define ACTUATOR_DSHOT_THROTTLE_MIN     48
+#define ACTUATOR_DSHOT_THROTTLE_MAX     2047
 #define ACTUATOR_PWM_CLOCK              1000000
 // Private types
 
@@ -94,9 +98,7 @@ static bool set_channel(uint8_t mixer_channel, uint16_t value, const ActuatorSet
 static void actuator_update_rate_if_changed(const ActuatorSettingsData *actuatorSettings, bool force_update);
 static void MixerSettingsUpdatedCb(UAVObjEvent *ev);
 static void ActuatorSettingsUpdatedCb(UAVObjEvent *ev);
-float ProcessMixer(const int index, const float curve1, const float curve2,
-                   const MixerSettingsData *mixerSettings, ActuatorDesiredData *desired,
-                   const float period);
+float ProcessMixer(const int index, float result, const MixerSettingsData *mixerSettings, const float period);
 
 // this structure is equivalent to the UAVObjects for one mixer.
 typedef struct {
@@ -104,6 +106,19 @@ typedef struct {
     int8_t  matrix[5];
 } __attribute__((packed)) Mixer_t;
 
+// MixerSettings compiled into the rows of the mixers that use the matrix,
+// so every update is a small contiguous matrix-vector product
+typedef struct {
+    uint8_t enabled; // mixers that are not disabled
+    uint8_t rows; // mixers of type motor, reversable motor or servo
+    uint8_t channel[MAX_MIX_ACTUATORS];
+    float   matrix[MAX_MIX_ACTUATORS][MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+} MixerMatrix_t;
+
+static MixerMatrix_t mixerMatrix;
+
+static void compileMixer(const MixerSettingsData *mixerSettings);
+
 /**
  * @brief Module initialization
  * @return 0
@@ -195,6 +210,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
     MixerSettingsData mixerSettings;
     mixer_settings_updated = false;
     MixerSettingsGet(&mixerSettings);
+    compileMixer(&mixerSettings);
 
     /* Force an initial configuration of the actuator update rates */
     actuator_update_rate_if_changed(&actuatorSettings, true);
@@ -223,6 +239,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
         if (mixer_settings_updated) {
             mixer_settings_updated = false;
             MixerSettingsGet(&mixerSettings);
+            compileMixer(&mixerSettings);
         }
 
         if (rc != pdTRUE) {
@@ -239,6 +256,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
 
         FlightStatusGet(&flightStatus);
         ActuatorDesiredGet(&desired);
+        PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_ACTUATORDESIRED, PIOS_LATENCYPROBE_ACTUATOR);
         ActuatorCommandGet(&command);
         SystemSettingsThrustControlGet(&thrustType);
 
@@ -279,14 +297,8 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
 #ifdef DIAG_MIXERSTATUS
         MixerStatusGet(&mixerStatus);
 #endif
-        int nMixers     = 0;
         Mixer_t *mixers = (Mixer_t *)&mixerSettings.Mixer1Type;
-        for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-            if (mixers[ct].type != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
-                nMixers++;
-            }
-        }
-        if ((nMixers < 2) && !ActuatorCommandReadOnly()) { // Nothing can fly with less than two mixers.
+        if ((mixerMatrix.enabled < 2) && !ActuatorCommandReadOnly()) { // Nothing can fly with less than two mixers.
             setFailsafe(&actuatorSettings, &mixerSettings); // So that channels like PWM buzzer keep working
             continue;
         }
@@ -334,6 +346,23 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
             break;
         }
 
+        float input[MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+        input[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] = curve1;
+        input[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] = curve2;
+        input[MIXERSETTINGS_MIXER1VECTOR_ROLL]  = desired.Roll;
+        input[MIXERSETTINGS_MIXER1VECTOR_PITCH] = desired.Pitch;
+        input[MIXERSETTINGS_MIXER1VECTOR_YAW]   = desired.Yaw;
+
+        float mixed[MAX_MIX_ACTUATORS];
+        for (uint8_t r = 0; r < mixerMatrix.rows; r++) {
+            const float *row = mixerMatrix.matrix[r];
+            float result     = 0.0f;
+            for (uint8_t v = 0; v < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; v++) {
+                result += row[v] * input[v];
+            }
+            mixed[mixerMatrix.channel[r]] = result;
+        }
+
         float *status = (float *)&mixerStatus; // access status objects as an array of floats
 
         for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
@@ -350,7 +379,7 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
             }
 
             if ((mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_MOTOR) || (mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_REVERSABLEMOTOR) || (mixers[ct].type == MIXERSETTINGS_MIXER1TYPE_SERVO)) {
-                status[ct] = ProcessMixer(ct, curve1, curve2, &mixerSettings, &desired, dTSeconds);
+                status[ct] = ProcessMixer(ct, mixed[ct], &mixerSettings, dTSeconds);
             } else {
                 status[ct] = -1;
             }
@@ -440,30 +469,38 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
         if (command.UpdateTime > command.MaxUpdateTime) {
             command.MaxUpdateTime = command.UpdateTime;
         }
-        // Update output object
-        ActuatorCommandSet(&command);
-        // Update in case read only (eg. during servo configuration)
-        ActuatorCommandGet(&command);
-
-#ifdef DIAG_MIXERSTATUS
-        MixerStatusSet(&mixerStatus);
-#endif
-
+        // Use the GCS values during servo configuration
+        if (ActuatorCommandReadOnly()) {
+            ActuatorCommandGet(&command);
+        }
 
-        // Update servo outputs
+        // Update servo outputs before anything else, the synchronous modes send right away.
+        // The camera stabilization fast path writes its channels itself, unless the GCS has them
+        uint16_t directChannels = 0;
+        if (CameraDesiredHandle() && !ActuatorCommandReadOnly()) {
+            CameraDesiredDirectChannelsGet(&directChannels);
+        }
         bool success = true;
 
         for (int n = 0; n < ACTUATORCOMMAND_CHANNEL_NUMELEM; ++n) {
-            success &= set_channel(n, command.Channel[n], &actuatorSettings);
+            if (!(directChannels & (1 << n))) {
+                success &= set_channel(n, command.Channel[n], &actuatorSettings);
+            }
         }
 
         PIOS_Servo_Update();
 
         if (!success) {
             command.NumFailedUpdates++;
-            ActuatorCommandSet(&command);
             AlarmsSet(SYSTEMALARMS_ALARM_ACTUATOR, SYSTEMALARMS_ALARM_CRITICAL);
         }
+
+        // Update output object
+        ActuatorCommandSet(&command);
+
+#ifdef DIAG_MIXERSTATUS
+        MixerStatusSet(&mixerStatus);
+#endif
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
         PIOS_Instrumentation_TimeEnd(counter);
 #endif
@@ -471,22 +508,40 @@ static void actuatorTask(__attribute__((unused)) void *parameters)
 }
 
 
+/**
+ * Build mixerMatrix from the settings, the int8 mixer vectors are scaled by 1/128
+ */
+static void compileMixer(const MixerSettingsData *mixerSettings)
+{
+    const Mixer_t *mixers = (Mixer_t *)&mixerSettings->Mixer1Type; // pointer to array of mixers in UAVObjects
+
+    mixerMatrix.enabled = 0;
+    mixerMatrix.rows    = 0;
+    for (uint8_t ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+        const Mixer_t *mixer = &mixers[ct];
+        if (mixer->type != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
+            mixerMatrix.enabled++;
+        }
+        if ((mixer->type == MIXERSETTINGS_MIXER1TYPE_MOTOR) || (mixer->type == MIXERSETTINGS_MIXER1TYPE_REVERSABLEMOTOR) || (mixer->type == MIXERSETTINGS_MIXER1TYPE_SERVO)) {
+            uint8_t r = mixerMatrix.rows++;
+            mixerMatrix.channel[r] = ct;
+            for (uint8_t v = 0; v < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; v++) {
+                mixerMatrix.matrix[r][v] = (float)mixer->matrix[v] * (1.0f / 128.0f);
+            }
+        }
+    }
+}
+
 /**
  * Process mixing for one actuator
+ * \param[in] result output of the mixer matrix for this actuator
  */
-float ProcessMixer(const int index, const float curve1, const float curve2,
-                   const MixerSettingsData *mixerSettings, ActuatorDesiredData *desired, const float period)
+float ProcessMixer(const int index, float result, const MixerSettingsData *mixerSettings, const float period)
 {
     static float lastFilteredResult[MAX_MIX_ACTUATORS];
     const Mixer_t *mixers = (Mixer_t *)&mixerSettings->Mixer1Type; // pointer to array of mixers in UAVObjects
     const Mixer_t *mixer  = &mixers[index];
 
-    float result = ((((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1]) * curve1) +
-                    (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2]) * curve2) +
-                    (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_ROLL]) * desired->Roll) +
-                    (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_PITCH]) * desired->Pitch) +
-                    (((float)mixer->matrix[MIXERSETTINGS_MIXER1VECTOR_YAW]) * desired->Yaw)) / 128.0f;
-
     // note: no feedforward for reversable motors yet for safety reasons
     if (mixer->type == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
         if (result < 0.0f) { // idle throttle
@@ -744,6 +799,17 @@ static bool set_channel(uint8_t mixer_channel, uint16_t value, const ActuatorSet
             // Remap 1000-2000 range to 125-250
             PIOS_Servo_Set(actuatorSettings->ChannelAddr[mixer_channel], value / ACTUATOR_ONESHOT125_PULSE_SCALE);
             break;
+        case ACTUATORSETTINGS_BANKMODE_MULTISHOT:
+            // Remap 1000-2000 range to 5-25us, in 12MHz ticks
+            PIOS_Servo_Set(actuatorSettings->ChannelAddr[mixer_channel], value > 750 ? (value * 6) / 25 - 180 : 0);
+            break;
+        case ACTUATORSETTINGS_BANKMODE_DSHOT150:
+        case ACTUATORSETTINGS_BANKMODE_DSHOT300:
+        case ACTUATORSETTINGS_BANKMODE_DSHOT600:
+            // Remap 1000-2000 range to throttle 48-2047, 1000 and below disarm
+            PIOS_Servo_Set(actuatorSettings->ChannelAddr[mixer_channel], value > ACTUATOR_DSHOT_PULSE_MIN ?
+                           ACTUATOR_DSHOT_THROTTLE_MIN + ((uint32_t)MIN(value, 2000) - ACTUATOR_DSHOT_PULSE_MIN) * (ACTUATOR_DSHOT_THROTTLE_MAX - ACTUATOR_DSHOT_THROTTLE_MIN) / 1000 : 0);
+            break;
         default:
             PIOS_Servo_Set(actuatorSettings->ChannelAddr[mixer_channel], value);
             break;
@@ -784,28 +850,38 @@ static void actuator_update_rate_if_changed(const ActuatorSettingsData *actuator
         uint16_t freq[ACTUATORSETTINGS_BANKUPDATEFREQ_NUMELEM];
         uint32_t clock[ACTUATORSETTINGS_BANKUPDATEFREQ_NUMELEM] = { 0 };
         for (uint8_t i = 0; i < ACTUATORSETTINGS_BANKMODE_NUMELEM; i++) {
-            if (force_update || (actuatorSettings->BankMode[i] != prevBankMode[i])) {
-                PIOS_Servo_SetBankMode(i,
-                                       actuatorSettings->BankMode[i] ==
-                                       ACTUATORSETTINGS_BANKMODE_PWM ?
-                                       PIOS_SERVO_BANK_MODE_PWM :
-                                       PIOS_SERVO_BANK_MODE_SINGLE_PULSE
-                                       );
-            }
+            uint8_t mode = PIOS_SERVO_BANK_MODE_SINGLE_PULSE;
             switch (actuatorSettings->BankMode[i]) {
             case ACTUATORSETTINGS_BANKMODE_ONESHOT125:
                 freq[i]  = 100; // Value must be small enough so CCr isn't update until the PIOS_Servo_Update is triggered
                 clock[i] = ACTUATOR_ONESHOT125_CLOCK; // Setup an 2MHz timer clock
                 break;
+            case ACTUATORSETTINGS_BANKMODE_MULTISHOT:
+                freq[i]  = 100;
+                clock[i] = ACTUATOR_MULTISHOT_CLOCK;
+                break;
+            case ACTUATORSETTINGS_BANKMODE_DSHOT150:
+            case ACTUATORSETTINGS_BANKMODE_DSHOT300:
+            case ACTUATORSETTINGS_BANKMODE_DSHOT600:
+                // The servo driver takes the bit rate
+                mode     = PIOS_SERVO_BANK_MODE_DSHOT;
+                freq[i]  = 100;
+                clock[i] = actuatorSettings->BankMode[i] == ACTUATORSETTINGS_BANKMODE_DSHOT150 ? 150000 :
+                           actuatorSettings->BankMode[i] == ACTUATORSETTINGS_BANKMODE_DSHOT300 ? 300000 : 600000;
+                break;
             case ACTUATORSETTINGS_BANKMODE_PWMSYNC:
                 freq[i]  = 100;
                 clock[i] = ACTUATOR_PWM_CLOCK;
                 break;
             default: // PWM
+                mode     = PIOS_SERVO_BANK_MODE_PWM;
                 freq[i]  = actuatorSettings->BankUpdateFreq[i];
                 clock[i] = ACTUATOR_PWM_CLOCK;
                 break;
             }
+            if (force_update || (actuatorSettings->BankMode[i] != prevBankMode[i])) {
+                PIOS_Servo_SetBankMode(i, mode);
+            }
         }
 
         memcpy(prevBankMode,
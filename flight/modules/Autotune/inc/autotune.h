@@ -2,12 +2,12 @@
  ******************************************************************************
  * @addtogroup OpenPilotModules OpenPilot Modules
  * @{
- * @addtogroup Attitude Attitude Module
+ * @addtogroup Autotuning module
  * @{
  *
- * @file       attitude.h
+ * @file       autotune.h
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2011.
- * @brief      Acquires sensor data and fuses it into attitude estimate for CC
+ * @brief      On board system identification for tuning the rate loops
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -27,11 +27,11 @@
  * with this program; if not, write to the Free Software Foundation, Inc.,
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
-#ifndef ATTITUDE_H
-#define ATTITUDE_H
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
 
 #include "openpilot.h"
 
-int32_t AttitudeInitialize(void);
+int32_t AutotuneInitialize(void);
 
-#endif // ATTITUDE_H
+#endif // AUTOTUNE_H
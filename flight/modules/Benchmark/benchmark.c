@@ -0,0 +1,353 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup BenchmarkModule Benchmark module
+ * @brief Cycle counts of flight code kernels on the target
+ * Output object: BenchmarkResults
+ *
+ * Runs a fixed set of kernels once after boot in a low priority callback and
+ * publishes the DWT cycle counts, so optimisations can be compared on real
+ * boards. Every kernel works on private data, the live filter and objects are
+ * never touched.
+ * @{
+ *
+ * @file       benchmark.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      On target benchmark of flight code kernels
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <openpilot.h>
+#include <pid.h>
+#include <uavtalk.h>
+#include <uavtalk_priv.h>
+
+#include "callbackinfo.h"
+#include "hwsettings.h"
+#include "attitudestate.h"
+#include "benchmarkresults.h"
+
+// Private constants
+#define STACK_SIZE_BYTES  768
+#define CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
+#define CBTASK_PRIORITY   CALLBACK_TASK_AUXILIARY
+
+// let the other modules settle first
+#define START_DELAY_MS    10000
+#define ITERATIONS        200
+
+#define CRC_BLOCK_SIZE    256
+
+// INSGPS dimensions and kernels, see insgps13state.c
+#define NUMX              13
+#define NUMW              9
+#define NUMV              10
+#define NUMP              (NUMX * (NUMX + 1) / 2)
+
+// same covariance storage as the filter in this build
+#if defined(ARM_MATH_CM4) && !defined(INSGPS_DENSE_COVARIANCE)
+#define BENCHMARK_PACKED_COVARIANCE
+typedef float covariance_t[NUMP];
+void CovariancePredictionPacked(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                                float Q[NUMW], float dT, float P[NUMP]);
+void SerialUpdatePacked(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+                        float Y[NUMV], float P[NUMP], float X[NUMX],
+                        uint16_t SensorsUsed);
+#else
+typedef float covariance_t[NUMX][NUMX];
+void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                          float Q[NUMW], float dT, float P[NUMX][NUMX]);
+void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+                  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
+                  uint16_t SensorsUsed);
+#endif
+
+enum kernel {
+    KERNEL_EKFPREDICT = 0,
+    KERNEL_EKFUPDATE,
+    KERNEL_RATELOOP,
+    KERNEL_UAVTALKENCODE,
+    KERNEL_UAVTALKDECODE,
+    KERNEL_CRC8,
+    KERNEL_CRC32,
+    KERNEL_CALLBACKDISPATCH,
+    KERNEL_COUNT
+};
+
+struct kernel_stats {
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint16_t count;
+};
+
+// kernel work space, only allocated when the module is enabled
+struct benchmark_data {
+    float F[NUMX][NUMX];
+    float G[NUMX][NUMW];
+    float H[NUMV][NUMX];
+    covariance_t P;
+    float X[NUMX];
+    float Q[NUMW];
+    float R[NUMV];
+    float Z[NUMV];
+    float Y[NUMV];
+    struct pid pid[3];
+    uint8_t  block[CRC_BLOCK_SIZE];
+    uint8_t  packet[UAVTALK_MAX_PACKET_LENGTH];
+    uint16_t packetLength;
+    struct kernel_stats stats[KERNEL_COUNT];
+};
+
+// Private variables
+static DelayedCallbackInfo *benchmarkCallback;
+static DelayedCallbackInfo *dispatchCallback;
+static bool benchmarkEnabled = false;
+static struct benchmark_data *data;
+static UAVTalkConnection uavTalkCon;
+static volatile uint32_t dispatchStart;
+static volatile uint32_t dispatchCycles;
+// keeps the compiler from dropping the rate loop
+static volatile float rateOutput[3];
+
+// Private functions
+static void benchmarkTask(void);
+static void dispatchTask(void);
+static void prepareData(void);
+static int32_t captureOutput(uint8_t *buf, int32_t length);
+
+/**
+ * Start the module, the benchmark runs once START_DELAY_MS later
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+static int32_t BenchmarkStart(void)
+{
+    if (!benchmarkEnabled) {
+        return -1;
+    }
+
+    PIOS_CALLBACKSCHEDULER_Schedule(benchmarkCallback, START_DELAY_MS, CALLBACK_UPDATEMODE_OVERRIDE);
+    return 0;
+}
+
+/**
+ * Initialise the module, called on startup
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+static int32_t BenchmarkInitialize(void)
+{
+#ifdef MODULE_BENCHMARK_BUILTIN
+    benchmarkEnabled = true;
+#else
+    HwSettingsInitialize();
+    HwSettingsOptionalModulesData optionalModules;
+
+    HwSettingsOptionalModulesGet(&optionalModules);
+    benchmarkEnabled = (optionalModules.Benchmark == HWSETTINGS_OPTIONALMODULES_ENABLED);
+#endif
+
+    if (!benchmarkEnabled) {
+        return 0;
+    }
+
+    AttitudeStateInitialize();
+    BenchmarkResultsInitialize();
+
+    data = (struct benchmark_data *)pios_malloc(sizeof(struct benchmark_data));
+    uavTalkCon = UAVTalkInitialize(&captureOutput);
+    if (!data || !uavTalkCon) {
+        benchmarkEnabled = false;
+        return -1;
+    }
+
+    benchmarkCallback = PIOS_CALLBACKSCHEDULER_Create(&benchmarkTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_BENCHMARK, STACK_SIZE_BYTES);
+    // a task above the benchmark, so the dispatch preempts it right away
+    dispatchCallback  = PIOS_CALLBACKSCHEDULER_Create(&dispatchTask, CALLBACK_PRIORITY_CRITICAL, CALLBACK_TASK_NAVIGATION, CALLBACKINFO_RUNNING_BENCHMARKDISPATCH, STACK_SIZE_BYTES);
+
+    return 0;
+}
+MODULE_INITCALL(BenchmarkInitialize, BenchmarkStart);
+
+static void addSample(enum kernel k, uint32_t cycles)
+{
+    struct kernel_stats *s = &data->stats[k];
+
+    s->min  = s->count ? MIN(s->min, cycles) : cycles;
+    s->max  = s->count ? MAX(s->max, cycles) : cycles;
+    s->sum += cycles;
+    s->count++;
+}
+
+static void benchmarkTask(void)
+{
+    uint32_t start;
+
+    prepareData();
+    memset(data->stats, 0, sizeof(data->stats));
+
+    for (uint16_t n = 0; n < ITERATIONS; n++) {
+        start = PIOS_DELAY_GetRaw();
+#ifdef BENCHMARK_PACKED_COVARIANCE
+        CovariancePredictionPacked(data->F, data->G, data->Q, 0.002f, data->P);
+#else
+        CovariancePrediction(data->F, data->G, data->Q, 0.002f, data->P);
+#endif
+        addSample(KERNEL_EKFPREDICT, PIOS_DELAY_GetRaw() - start);
+
+        // all sensors, the filter state stays bounded as the inputs do not change
+        start = PIOS_DELAY_GetRaw();
+#ifdef BENCHMARK_PACKED_COVARIANCE
+        SerialUpdatePacked(data->H, data->R, data->Z, data->Y, data->P, data->X, 0x3FF);
+#else
+        SerialUpdate(data->H, data->R, data->Z, data->Y, data->P, data->X, 0x3FF);
+#endif
+        addSample(KERNEL_EKFUPDATE, PIOS_DELAY_GetRaw() - start);
+
+        // the three axes of the rate loop
+        start = PIOS_DELAY_GetRaw();
+        for (uint8_t t = 0; t < 3; t++) {
+            static const pid_scaler scaler = { 1.0f, 1.0f, 1.0f };
+            rateOutput[t] = pid_apply_setpoint(&data->pid[t], &scaler, 100.0f * t, data->Z[t], 0.002f);
+        }
+        addSample(KERNEL_RATELOOP, PIOS_DELAY_GetRaw() - start);
+
+        start = PIOS_DELAY_GetRaw();
+        UAVTalkSendObject(uavTalkCon, AttitudeStateHandle(), 0, false, 0);
+        addSample(KERNEL_UAVTALKENCODE, PIOS_DELAY_GetRaw() - start);
+
+        // only parses and checks the packet, the object is not updated
+        uint16_t used;
+        start = PIOS_DELAY_GetRaw();
+        UAVTalkProcessInputBufferQuiet(uavTalkCon, data->packet, data->packetLength, &used);
+        addSample(KERNEL_UAVTALKDECODE, PIOS_DELAY_GetRaw() - start);
+
+        start = PIOS_DELAY_GetRaw();
+        data->block[0] ^= PIOS_CRC_updateCRC(0, data->block, CRC_BLOCK_SIZE);
+        addSample(KERNEL_CRC8, PIOS_DELAY_GetRaw() - start);
+
+        start = PIOS_DELAY_GetRaw();
+        data->block[1] ^= PIOS_CRC32_updateCRC(0xFFFFFFFF, data->block, CRC_BLOCK_SIZE);
+        addSample(KERNEL_CRC32, PIOS_DELAY_GetRaw() - start);
+
+        dispatchCycles = 0;
+        dispatchStart  = PIOS_DELAY_GetRaw();
+        PIOS_CALLBACKSCHEDULER_Dispatch(dispatchCallback);
+        // set by dispatchTask if it preempted us as it should
+        if (dispatchCycles) {
+            addSample(KERNEL_CALLBACKDISPATCH, dispatchCycles);
+        }
+    }
+
+    BenchmarkResultsData results;
+    uint32_t *minCycles  = BenchmarkResultsMinCyclesToArray(results.MinCycles);
+    uint32_t *meanCycles = BenchmarkResultsMeanCyclesToArray(results.MeanCycles);
+    uint32_t *maxCycles  = BenchmarkResultsMaxCyclesToArray(results.MaxCycles);
+
+    for (uint8_t k = 0; k < KERNEL_COUNT; k++) {
+        const struct kernel_stats *s = &data->stats[k];
+        minCycles[k]  = s->min;
+        meanCycles[k] = s->count ? (uint32_t)(s->sum / s->count) : 0;
+        maxCycles[k]  = s->max;
+    }
+    results.SysClock   = PIOS_SYSCLK;
+    results.Iterations = ITERATIONS;
+    BenchmarkResultsSet(&results);
+}
+
+static void dispatchTask(void)
+{
+    dispatchCycles = PIOS_DELAY_GetRaw() - dispatchStart;
+}
+
+/**
+ * Fixed pseudo random inputs of the same magnitudes as in flight
+ */
+static void prepareData(void)
+{
+    uint32_t seed = 0x12345678;
+
+#define NEXT_RANDOM(min, max) ((seed = seed * 1664525 + 1013904223), (min) + ((max) - (min)) * (float)(seed >> 8) / (float)(1 << 24))
+
+    for (uint8_t i = 0; i < NUMX; i++) {
+        for (uint8_t j = 0; j < NUMX; j++) {
+            data->F[i][j] = NEXT_RANDOM(-2.0f, 2.0f);
+        }
+        for (uint8_t j = 0; j < NUMW; j++) {
+            data->G[i][j] = NEXT_RANDOM(-2.0f, 2.0f);
+        }
+        data->X[i] = NEXT_RANDOM(-1.0f, 1.0f);
+    }
+    // identity covariance
+    memset(data->P, 0, sizeof(data->P));
+    for (uint8_t i = 0; i < NUMX; i++) {
+#ifdef BENCHMARK_PACKED_COVARIANCE
+        // first element of row i of the upper triangle
+        data->P[i * NUMX - i * (i - 1) / 2] = 1.0f;
+#else
+        data->P[i][i] = 1.0f;
+#endif
+    }
+    for (uint8_t i = 0; i < NUMW; i++) {
+        data->Q[i] = NEXT_RANDOM(0.0f, 1e-3f);
+    }
+    for (uint8_t m = 0; m < NUMV; m++) {
+        for (uint8_t j = 0; j < NUMX; j++) {
+            data->H[m][j] = NEXT_RANDOM(-1.0f, 1.0f);
+        }
+        data->R[m] = NEXT_RANDOM(0.01f, 1.0f);
+        data->Z[m] = NEXT_RANDOM(-1.0f, 1.0f);
+        data->Y[m] = NEXT_RANDOM(-1.0f, 1.0f);
+    }
+
+    for (uint8_t t = 0; t < 3; t++) {
+        pid_configure(&data->pid[t], 0.003f, 0.006f, 0.00004f, 0.3f);
+    }
+
+    for (uint16_t i = 0; i < CRC_BLOCK_SIZE; i++) {
+        seed = seed * 1664525 + 1013904223;
+        data->block[i] = seed >> 24;
+    }
+
+#undef NEXT_RANDOM
+
+    // one encoded AttitudeState for the decoder
+    data->packetLength = 0;
+    UAVTalkSendObject(uavTalkCon, AttitudeStateHandle(), 0, false, 0);
+}
+
+/**
+ * Output stream of the private connection, keeps the last packet
+ */
+static int32_t captureOutput(uint8_t *buf, int32_t length)
+{
+    if (length > 0 && length <= (int32_t)sizeof(data->packet)) {
+        memcpy(data->packet, buf, length);
+        data->packetLength = length;
+    }
+    return length;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -2,9 +2,9 @@
  ******************************************************************************
  *
  * @file       callbacktest.c
- * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2010.
- * @brief      Example module to be used as a template for actual modules.
- *             Event callback version.
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Callback scheduler stress benchmark
+ *             Output object: CallbackBenchmark
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -27,124 +27,283 @@
 
 /**
  *
- * This is a test suite to test the callback scheduler,
- * including its forward scheduling ability
+ * This is a stress benchmark of the callback scheduler. Once after boot it
+ * runs a set of callbacks on every callback task and at every callback
+ * priority. Each run of a callback does a little work and triggers the
+ * callback again, with a random choice of an immediate dispatch, a schedule
+ * a few ms ahead or a dispatch from ISR context. The latency from the
+ * trigger to the start of the callback, the missed deadlines and the cost
+ * of the trigger calls are published in CallbackBenchmark.
+ *
+ * The load holds up the flight tasks, add the module to the MODULES of a
+ * test build only.
  *
  */
 
 #include "openpilot.h"
+#include "callbackbenchmark.h"
 
 // Private constants
-#define STACK_SIZE        configMINIMAL_STACK_SIZE
-#define CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
-#define TASK_PRIORITY     CALLBACK_TASKPRIORITY_AUXILIARY
+#define STACK_SIZE_BYTES     512
+#define REPORT_PRIORITY      CALLBACK_PRIORITY_LOW
+#define REPORT_TASK_PRIORITY CALLBACK_TASK_AUXILIARY
+
+// let the other modules settle first
+#define START_DELAY_MS       10000
+
+#define CALLBACKS_PER_CLASS  2 // callbacks of each task and priority
+#define RUNS_PER_CALLBACK    250
+#define MAX_SCHEDULE_MS      4
+#define MAX_WORK_US          50
+#define DEADLINE_US          2000 // a callback starting later than this after its trigger or due time missed it
+
+enum trigger {
+    TRIGGER_DISPATCH = 0,
+    TRIGGER_SCHEDULE,
+    TRIGGER_DISPATCHFROMISR,
+    TRIGGER_COUNT
+};
+
 // Private types
+struct trigger_stats {
+    uint32_t runs;
+    uint64_t latencySum;
+    uint32_t latencyMax;
+    uint32_t missed;
+    uint32_t calls;
+    uint32_t callMin;
+    uint32_t callMax;
+    uint32_t histogram[PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS];
+};
 
-// #define DEBUGPRINT(...) fprintf (stderr, __VA_ARGS__)
-#define DEBUGPRINT(...) xSemaphoreTakeRecursive(mutex, portMAX_DELAY); fprintf(stderr, __VA_ARGS__); xSemaphoreGiveRecursive(mutex);
+struct test_callback {
+    DelayedCallbackInfo *cbinfo;
+    uint32_t seed;
+    uint32_t armed; // PIOS_DELAY_GetRaw() of the trigger
+    uint32_t due; // us from the trigger to the earliest start
+    uint16_t runs;
+    uint8_t  trigger;
+};
 
-static xSemaphoreHandle mutex;
+static const DelayedCallbackPriorityTask tasks[] = {
+    CALLBACK_TASK_AUXILIARY,
+    CALLBACK_TASK_NAVIGATION,
+    CALLBACK_TASK_FLIGHTCONTROL,
+    CALLBACK_TASK_DEVICEDRIVER,
+};
+static const DelayedCallbackPriority priorities[] = {
+    CALLBACK_PRIORITY_CRITICAL,
+    CALLBACK_PRIORITY_REGULAR,
+    CALLBACK_PRIORITY_LOW,
+};
+
+#define CALLBACK_COUNT (NELEMENTS(tasks) * NELEMENTS(priorities) * CALLBACKS_PER_CLASS)
 
 // Private variables
-static DelayedCallbackInfo *cbinfo[10];
+static DelayedCallbackInfo *reportCallback;
+static struct test_callback callbacks[CALLBACK_COUNT];
+static struct trigger_stats stats[TRIGGER_COUNT];
+static uint32_t volatile finished;
+static uint32_t startTime;
+
+// Private functions
+static void runCallback(uint8_t n);
+static void trigger(struct test_callback *cb);
+static void reportTask(void);
+
+// The scheduler calls callbacks without arguments, one entry point each
+#define TEST_CALLBACK(n) static void testCallback ## n(void) { runCallback(n); }
+TEST_CALLBACK(0) TEST_CALLBACK(1) TEST_CALLBACK(2) TEST_CALLBACK(3)
+TEST_CALLBACK(4) TEST_CALLBACK(5) TEST_CALLBACK(6) TEST_CALLBACK(7)
+TEST_CALLBACK(8) TEST_CALLBACK(9) TEST_CALLBACK(10) TEST_CALLBACK(11)
+TEST_CALLBACK(12) TEST_CALLBACK(13) TEST_CALLBACK(14) TEST_CALLBACK(15)
+TEST_CALLBACK(16) TEST_CALLBACK(17) TEST_CALLBACK(18) TEST_CALLBACK(19)
+TEST_CALLBACK(20) TEST_CALLBACK(21) TEST_CALLBACK(22) TEST_CALLBACK(23)
 
-static volatile int32_t counter[10] = { 0 };
+static const DelayedCallback testCallbacks[] = {
+    testCallback0,  testCallback1,  testCallback2,  testCallback3,
+    testCallback4,  testCallback5,  testCallback6,  testCallback7,
+    testCallback8,  testCallback9,  testCallback10, testCallback11,
+    testCallback12, testCallback13, testCallback14, testCallback15,
+    testCallback16, testCallback17, testCallback18, testCallback19,
+    testCallback20, testCallback21, testCallback22, testCallback23,
+};
 
-static void DelayedCb0();
-static void DelayedCb1();
-static void DelayedCb2();
-static void DelayedCb3();
-static void DelayedCb4();
-static void DelayedCb5();
-static void DelayedCb6();
 /**
  * Initialise the module, called on startup.
  * \returns 0 on success or -1 if initialisation failed
  */
 int32_t CallbackTestInitialize()
 {
-    mutex     = xSemaphoreCreateRecursiveMutex();
+    PIOS_STATIC_ASSERT(NELEMENTS(testCallbacks) == CALLBACK_COUNT);
 
-    cbinfo[0] = PIOS_CALLBACKSCHEDULER_Create(&DelayedCb0, CALLBACK_PRIORITY_LOW, tskIDLE_PRIORITY + 2, -1, STACK_SIZE);
-    cbinfo[1] = PIOS_CALLBACKSCHEDULER_Create(&DelayedCb1, CALLBACK_PRIORITY_LOW, tskIDLE_PRIORITY + 2, -1, STACK_SIZE);
-    cbinfo[2] = PIOS_CALLBACKSCHEDULER_Create(&DelayedCb2, CALLBACK_PRIORITY_CRITICAL, tskIDLE_PRIORITY + 2, -1, STACK_SIZE);
-    cbinfo[3] = PIOS_CALLBACKSCHEDULER_Create(&DelayedCb3, CALLBACK_PRIORITY_CRITICAL, tskIDLE_PRIORITY + 2, -1, STACK_SIZE);
-    cbinfo[4] = PIOS_CALLBACKSCHEDULER_Create(&DelayedCb4, CALLBACK_PRIORITY_LOW, tskIDLE_PRIORITY + 2, -1, STACK_SIZE);
-    cbinfo[5] = PIOS_CALLBACKSCHEDULER_Create(&DelayedCb5, CALLBACK_PRIORITY_LOW, tskIDLE_PRIORITY + 2, -1, STACK_SIZE);
-    cbinfo[6] = PIOS_CALLBACKSCHEDULER_Create(&DelayedCb6, CALLBACK_PRIORITY_LOW, tskIDLE_PRIORITY + 20, -1, STACK_SIZE);
+    CallbackBenchmarkInitialize();
 
+    // before the scheduler starts, so the callback tasks get the stack
+    uint8_t n = 0;
+    for (uint8_t t = 0; t < NELEMENTS(tasks); t++) {
+        for (uint8_t p = 0; p < NELEMENTS(priorities); p++) {
+            for (uint8_t i = 0; i < CALLBACKS_PER_CLASS; i++, n++) {
+                callbacks[n].cbinfo = PIOS_CALLBACKSCHEDULER_Create(testCallbacks[n], priorities[p], tasks[t], -1, STACK_SIZE_BYTES);
+                callbacks[n].seed   = 0x12345678 + n;
+                if (!callbacks[n].cbinfo) {
+                    return -1;
+                }
+            }
+        }
+    }
+    reportCallback = PIOS_CALLBACKSCHEDULER_Create(&reportTask, REPORT_PRIORITY, REPORT_TASK_PRIORITY, -1, STACK_SIZE_BYTES);
 
-    return 0;
+    return reportCallback ? 0 : -1;
 }
+
+/**
+ * Start the module, the benchmark runs once START_DELAY_MS later
+ * \returns 0 on success or -1 if initialisation failed
+ */
 int32_t CallbackTestStart()
 {
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[3]);
-    PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[2]);
-    PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[1]);
-    PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[0]);
-    // different callback priorities within a taskpriority
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[4], 30000, CALLBACK_UPDATEMODE_NONE);
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[4], 5000, CALLBACK_UPDATEMODE_OVERRIDE);
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[4], 4000, CALLBACK_UPDATEMODE_SOONER);
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[4], 10000, CALLBACK_UPDATEMODE_SOONER);
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[4], 1000, CALLBACK_UPDATEMODE_LATER);
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[4], 4800, CALLBACK_UPDATEMODE_LATER);
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[4], 48000, CALLBACK_UPDATEMODE_NONE);
-    // should be at 4.8 seconds after this, allowing for exactly 9 prints of the following
-    PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[5], 500, CALLBACK_UPDATEMODE_NONE);
-    // delayed counter with 500 ms
-    PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[6]);
-    // high task prio
-    xSemaphoreGiveRecursive(mutex);
+    PIOS_CALLBACKSCHEDULER_Schedule(reportCallback, START_DELAY_MS, CALLBACK_UPDATEMODE_OVERRIDE);
     return 0;
 }
+MODULE_INITCALL(CallbackTestInitialize, CallbackTestStart);
 
-static void DelayedCb0()
+static uint32_t nextRandom(uint32_t *seed)
 {
-    DEBUGPRINT("delayed counter low prio 0 updated: %i\n", counter[0]);
-    if (++counter[0] < 10) {
-        PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[0]);
-    }
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed >> 8;
 }
-static void DelayedCb1()
+
+/**
+ * Count a duration in us into a histogram, same bins as CallbackInfo
+ */
+static void addToHistogram(uint32_t *histogram, uint32_t us)
 {
-    DEBUGPRINT("delayed counter low prio 1 updated: %i\n", counter[1]);
-    if (++counter[1] < 10) {
-        PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[1]);
+    uint8_t bin = 0;
+
+    for (uint32_t limit = 16; bin < PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS - 1 && us >= limit; limit *= 4) {
+        bin++;
     }
+    histogram[bin]++;
 }
-static void DelayedCb2()
+
+static void runCallback(uint8_t n)
 {
-    DEBUGPRINT("delayed counter high prio 2 updated: %i\n", counter[2]);
-    if (++counter[2] < 10) {
-        PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[2]);
+    struct test_callback *cb = &callbacks[n];
+    uint32_t elapsed = PIOS_DELAY_DiffuS(cb->armed);
+    uint32_t latency = (elapsed > cb->due) ? elapsed - cb->due : 0;
+    struct trigger_stats *s = &stats[cb->trigger];
+
+    // callbacks of all tasks come here, keep them from preempting each other
+    vPortEnterCritical();
+    s->runs++;
+    s->latencySum += latency;
+    s->latencyMax  = MAX(s->latencyMax, latency);
+    if (latency > DEADLINE_US) {
+        s->missed++;
     }
-}
-static void DelayedCb3()
-{
-    DEBUGPRINT("delayed counter high prio 3 updated: %i\n", counter[3]);
-    if (++counter[3] < 10) {
-        PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[3]);
+    addToHistogram(s->histogram, latency);
+    vPortExitCritical();
+
+    // some work, so the callbacks of a task hold each other up
+    PIOS_DELAY_WaituS(nextRandom(&cb->seed) % (MAX_WORK_US + 1));
+
+    if (++cb->runs < RUNS_PER_CALLBACK) {
+        trigger(cb);
+    } else if (__atomic_add_fetch(&finished, 1, __ATOMIC_ACQ_REL) == CALLBACK_COUNT) {
+        PIOS_CALLBACKSCHEDULER_Dispatch(reportCallback);
     }
 }
-static void DelayedCb4()
-{
-    DEBUGPRINT("delayed scheduled callback 4 reached!\n");
-    exit(0);
-}
-static void DelayedCb5()
+
+/**
+ * Trigger the callback again, in one of the ways the flight code does
+ */
+static void trigger(struct test_callback *cb)
 {
-    DEBUGPRINT("delayed scheduled counter 5 updated: %i\n", counter[5]);
-    if (++counter[5] < 10) {
-        PIOS_CALLBACKSCHEDULER_Schedule(cbinfo[5], 500, CALLBACK_UPDATEMODE_NONE);
+    uint32_t random = nextRandom(&cb->seed);
+    uint32_t cycles;
+
+    cb->trigger = random % TRIGGER_COUNT;
+    switch (cb->trigger) {
+    case TRIGGER_SCHEDULE:
+    {
+        int32_t milliseconds = 1 + (random >> 4) % MAX_SCHEDULE_MS;
+        // due at the start of the tick it is scheduled for
+        cb->due   = (milliseconds - portTICK_RATE_MS) * 1000;
+        cb->armed = PIOS_DELAY_GetRaw();
+        PIOS_CALLBACKSCHEDULER_Schedule(cb->cbinfo, milliseconds, CALLBACK_UPDATEMODE_OVERRIDE);
+        cycles    = PIOS_DELAY_GetRaw() - cb->armed;
+        break;
+    }
+    case TRIGGER_DISPATCHFROMISR:
+    {
+        // the interrupt entry is not portable, this only runs the same code
+        // with the interrupts masked and yields as an ISR exit would
+        long woken = pdFALSE;
+        cb->due   = 0;
+        cb->armed = PIOS_DELAY_GetRaw();
+        vPortEnterCritical();
+        PIOS_CALLBACKSCHEDULER_DispatchFromISR(cb->cbinfo, &woken);
+        cycles    = PIOS_DELAY_GetRaw() - cb->armed;
+        vPortExitCritical();
+        if (woken == pdTRUE) {
+            taskYIELD();
+        }
+        break;
+    }
+    default:
+        cb->due   = 0;
+        cb->armed = PIOS_DELAY_GetRaw();
+        PIOS_CALLBACKSCHEDULER_Dispatch(cb->cbinfo);
+        cycles    = PIOS_DELAY_GetRaw() - cb->armed;
+        break;
     }
-    // it will likely only reach 8 due to cb4 aborting the run
+
+    // a higher priority callback task may have run inside the call, min is the undisturbed cost
+    struct trigger_stats *s = &stats[cb->trigger];
+    vPortEnterCritical();
+    s->callMin = s->calls ? MIN(s->callMin, cycles) : cycles;
+    s->callMax = MAX(s->callMax, cycles);
+    s->calls++;
+    vPortExitCritical();
 }
-static void DelayedCb6()
+
+/**
+ * Starts the benchmark, and publishes the results once all callbacks are done
+ */
+static void reportTask(void)
 {
-    DEBUGPRINT("delayed counter 6 (high task prio) updated: %i\n", counter[6]);
-    if (++counter[6] < 10) {
-        PIOS_CALLBACKSCHEDULER_Dispatch(cbinfo[6]);
+    if (!startTime) {
+        memset(stats, 0, sizeof(stats));
+        finished  = 0;
+        startTime = xTaskGetTickCount();
+        for (uint8_t n = 0; n < CALLBACK_COUNT; n++) {
+            callbacks[n].runs = 0;
+            trigger(&callbacks[n]);
+        }
+        return;
+    }
+
+    CallbackBenchmarkData results;
+    uint32_t *latencyMean = CallbackBenchmarkLatencyMeanToArray(results.LatencyMean);
+    uint32_t *latencyMax  = CallbackBenchmarkLatencyMaxToArray(results.LatencyMax);
+    uint32_t *missed      = CallbackBenchmarkMissedDeadlinesToArray(results.MissedDeadlines);
+    uint32_t *callMin     = CallbackBenchmarkCallCyclesMinToArray(results.CallCyclesMin);
+    uint32_t *callMax     = CallbackBenchmarkCallCyclesMaxToArray(results.CallCyclesMax);
+
+    results.Runs = 0;
+    for (uint8_t t = 0; t < TRIGGER_COUNT; t++) {
+        const struct trigger_stats *s = &stats[t];
+        latencyMean[t] = s->runs ? (uint32_t)(s->latencySum / s->runs) : 0;
+        latencyMax[t]  = s->latencyMax;
+        missed[t]      = s->missed;
+        callMin[t]     = s->callMin;
+        callMax[t]     = s->callMax;
+        memcpy(&results.LatencyHistogram[t * PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS], s->histogram, sizeof(s->histogram));
+        results.Runs  += s->runs;
     }
+    results.Callbacks = CALLBACK_COUNT;
+    results.Duration  = (xTaskGetTickCount() - startTime) * portTICK_RATE_MS;
+    results.SysClock  = PIOS_SYSCLK;
+    CallbackBenchmarkSet(&results);
 }
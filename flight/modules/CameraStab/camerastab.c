@@ -35,6 +35,10 @@
  *
  * This module will periodically calculate the output values for stabilizing the camera
  *
+ * With a FastPathRate the outputs are calculated on the gyro updates instead, in the flight
+ * control callback task after the stabilization inner loop, and the PWM camera channels are
+ * written right away rather than at the next Actuator update.
+ *
  * UAVObjects are automatically generated by the UAVObjectGenerator from
  * the object definition XML file.
  *
@@ -52,19 +56,47 @@
 #include "camerastabsettings.h"
 #include "cameradesired.h"
 #include "hwsettings.h"
+#include "gyrostate.h"
+#include "mixersettings.h"
+#include "actuatorsettings.h"
+#include "actuatorcommand.h"
+#include "callbackinfo.h"
 
 //
 // Configuration
 //
-#define SAMPLE_PERIOD_MS 10
+#define SAMPLE_PERIOD_MS    10
+#define CAMERA_BOOT_DELAY_MS 7000 // as the Actuator module
+
+#define CALLBACK_PRIORITY   CALLBACK_PRIORITY_REGULAR
+#define CBTASK_PRIORITY     CALLBACK_TASK_FLIGHTCONTROL
+#define STACK_SIZE_BYTES    768
 
 // Private types
 
+// Camera channel written by the fast path
+typedef struct {
+    uint8_t channel;
+    uint8_t output; // 0 RollOrServo1, 1 PitchOrServo2, 2 Yaw
+    uint8_t addr;
+    int16_t min;
+    int16_t max;
+    int16_t neutral;
+} CameraChannel_t;
+
 // Private variables
 static struct CameraStab_data {
     portTickType lastSysTime;
     float inputs[CAMERASTABSETTINGS_INPUT_NUMELEM];
 
+    DelayedCallbackInfo *fastPathCallback;
+    uint16_t fastPathDivider;
+    uint16_t gyroUpdates;
+    float    gyro[3];
+    bool     channelsChanged;
+    uint8_t  numChannels;
+    CameraChannel_t channels[ACTUATORCOMMAND_CHANNEL_NUMELEM];
+
 #ifdef USE_GIMBAL_LPF
     float attitudeFiltered[CAMERASTABSETTINGS_INPUT_NUMELEM];
 #endif
@@ -78,6 +110,11 @@ static struct CameraStab_data {
 
 // Private functions
 static void attitudeUpdated(UAVObjEvent *ev);
+static void cameraStabUpdate(float dT_millis, const float *gyro, CameraDesiredData *cameraDesired);
+static void gyroUpdated(UAVObjEvent *ev);
+static void fastPathTask(void);
+static void settingsUpdated(UAVObjEvent *ev);
+static void updateChannels(void);
 
 #ifdef USE_GIMBAL_FF
 static void applyFeedForward(uint8_t index, float dT, float *attitude, CameraStabSettingsData *cameraStab);
@@ -121,6 +158,17 @@ int32_t CameraStabInitialize(void)
         AttitudeStateInitialize();
         CameraStabSettingsInitialize();
         CameraDesiredInitialize();
+        GyroStateInitialize();
+        MixerSettingsInitialize();
+        ActuatorSettingsInitialize();
+        ActuatorCommandInitialize();
+
+        csd->fastPathCallback = PIOS_CALLBACKSCHEDULER_Create(&fastPathTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_CAMERASTAB, STACK_SIZE_BYTES);
+        settingsUpdated(NULL);
+        CameraStabSettingsConnectCallback(settingsUpdated);
+        MixerSettingsConnectCallback(settingsUpdated);
+        ActuatorSettingsConnectCallback(settingsUpdated);
+        GyroStateConnectCallback(gyroUpdated);
 
         UAVObjEvent ev = {
             .obj    = AttitudeStateHandle(),
@@ -146,15 +194,10 @@ MODULE_INITCALL(CameraStabInitialize, CameraStabStart);
 
 static void attitudeUpdated(UAVObjEvent *ev)
 {
-    if (ev->obj != AttitudeStateHandle()) {
+    if (ev->obj != AttitudeStateHandle() || csd->fastPathDivider > 0) {
         return;
     }
 
-    AccessoryDesiredData accessory;
-
-    CameraStabSettingsData cameraStab;
-    CameraStabSettingsGet(&cameraStab);
-
     // check how long since last update, time delta between calls in ms
     portTickType thisSysTime = xTaskGetTickCount();
     float dT_millis = (thisSysTime > csd->lastSysTime) ?
@@ -162,6 +205,25 @@ static void attitudeUpdated(UAVObjEvent *ev)
                       (float)SAMPLE_PERIOD_MS;
     csd->lastSysTime = thisSysTime;
 
+    CameraDesiredData cameraDesired;
+    cameraStabUpdate(dT_millis, NULL, &cameraDesired);
+    // the Actuator module writes all the camera channels, even if the fast path was just turned off
+    cameraDesired.DirectChannels = 0;
+    CameraDesiredSet(&cameraDesired);
+}
+
+/**
+ * Calculates the camera outputs, the attitude is extrapolated with the gyro rates when given
+ */
+static void cameraStabUpdate(float dT_millis, const float *gyro, CameraDesiredData *cameraDesired)
+{
+    AccessoryDesiredData accessory;
+
+    CameraStabSettingsData cameraStab;
+
+    CameraStabSettingsGet(&cameraStab);
+    CameraDesiredGet(cameraDesired);
+
     // storage for elevon roll component before the pitch component has been generated
     // we are guaranteed that the iteration order of i is roll pitch yaw
     // that guarnteees this won't be used uninited, but the compiler doesn't know that
@@ -212,6 +274,10 @@ static void attitudeUpdated(UAVObjEvent *ev)
             PIOS_Assert(0);
         }
 
+        if (gyro) {
+            attitude += gyro[i] * (float)CameraStabSettingsGyroFeedForwardToArray(cameraStab.GyroFeedForward)[i] * 0.001f;
+        }
+
 #ifdef USE_GIMBAL_LPF
         if (CameraStabSettingsResponseTimeToArray(cameraStab.ResponseTime)[i]) {
             float rt = (float)CameraStabSettingsResponseTimeToArray(cameraStab.ResponseTime)[i];
@@ -238,7 +304,7 @@ static void attitudeUpdated(UAVObjEvent *ev)
             if (cameraStab.GimbalType == CAMERASTABSETTINGS_GIMBALTYPE_ROLLPITCHMIXED) {
                 elevon_roll = output;
             } else {
-                CameraDesiredRollOrServo1Set(&output);
+                cameraDesired->RollOrServo1 = output;
             }
             break;
         case CAMERASTABSETTINGS_INPUT_PITCH:
@@ -258,7 +324,7 @@ static void attitudeUpdated(UAVObjEvent *ev)
                     // use pitch + roll
                     output = (elevon_pitch + elevon_roll) / 2.0f;
                 }
-                CameraDesiredRollOrServo1Set(&output);
+                cameraDesired->RollOrServo1 = output;
                 // if servo 2 pitch is reversed
                 if (cameraStab.Servo2PitchReverse == CAMERASTABSETTINGS_SERVO2PITCHREVERSE_TRUE) {
                     // use (reversed pitch) - roll
@@ -267,13 +333,13 @@ static void attitudeUpdated(UAVObjEvent *ev)
                     // use pitch - roll
                     output = (elevon_pitch - elevon_roll) / 2.0f;
                 }
-                CameraDesiredPitchOrServo2Set(&output);
+                cameraDesired->PitchOrServo2 = output;
             } else {
-                CameraDesiredPitchOrServo2Set(&output);
+                cameraDesired->PitchOrServo2 = output;
             }
             break;
         case CAMERASTABSETTINGS_INPUT_YAW:
-            CameraDesiredYawSet(&output);
+            cameraDesired->Yaw = output;
             break;
         default:
             PIOS_Assert(0);
@@ -281,6 +347,123 @@ static void attitudeUpdated(UAVObjEvent *ev)
     }
 }
 
+/**
+ * Settings changed, the fast path rebuilds its channels before the next update
+ */
+static void settingsUpdated(__attribute__((unused)) UAVObjEvent *ev)
+{
+    uint16_t rate;
+
+    CameraStabSettingsFastPathRateGet(&rate);
+    if (rate > 0) {
+        uint16_t divider = (uint16_t)(PIOS_SENSOR_RATE / rate + 0.5f);
+        csd->fastPathDivider = (divider > 0) ? divider : 1;
+    } else {
+        csd->fastPathDivider = 0;
+    }
+    csd->channelsChanged = true;
+}
+
+/**
+ * Finds the camera channels the fast path writes: PWM channels of banks in PWM mode, the
+ * synchronous modes are triggered by the Actuator update and stay with it.
+ */
+static void updateChannels(void)
+{
+    MixerSettingsData mixerSettings;
+    ActuatorSettingsData actuatorSettings;
+    uint16_t directChannels = 0;
+
+    csd->numChannels = 0;
+
+#if !defined(ARCH_POSIX) && !defined(ARCH_WIN32)
+    if (csd->fastPathDivider > 0) {
+        MixerSettingsGet(&mixerSettings);
+        ActuatorSettingsGet(&actuatorSettings);
+
+        // the mixers are interleaved type and vector fields, see the Actuator module
+        const uint8_t *mixer = &mixerSettings.Mixer1Type;
+        for (uint8_t ct = 0; ct < ACTUATORCOMMAND_CHANNEL_NUMELEM; ct++, mixer += 1 + MIXERSETTINGS_MIXER1VECTOR_NUMELEM) {
+            if (*mixer < MIXERSETTINGS_MIXER1TYPE_CAMERAROLLORSERVO1 || *mixer > MIXERSETTINGS_MIXER1TYPE_CAMERAYAW ||
+                actuatorSettings.ChannelType[ct] != ACTUATORSETTINGS_CHANNELTYPE_PWM ||
+                actuatorSettings.BankMode[PIOS_Servo_GetPinBank(actuatorSettings.ChannelAddr[ct])] != ACTUATORSETTINGS_BANKMODE_PWM) {
+                continue;
+            }
+            CameraChannel_t *channel = &csd->channels[csd->numChannels++];
+            channel->channel = ct;
+            channel->output  = *mixer - MIXERSETTINGS_MIXER1TYPE_CAMERAROLLORSERVO1;
+            channel->addr    = actuatorSettings.ChannelAddr[ct];
+            channel->min     = actuatorSettings.ChannelMin[ct];
+            channel->max     = actuatorSettings.ChannelMax[ct];
+            channel->neutral = actuatorSettings.ChannelNeutral[ct];
+            directChannels  |= 1 << ct;
+        }
+    }
+#endif
+    CameraDesiredDirectChannelsSet(&directChannels);
+}
+
+/**
+ * Counts the gyro updates, runs the fast path every fastPathDivider of them
+ */
+static void gyroUpdated(__attribute__((unused)) UAVObjEvent *ev)
+{
+    if (csd->fastPathDivider == 0 && !csd->channelsChanged) {
+        return;
+    }
+    if (++csd->gyroUpdates >= csd->fastPathDivider || csd->channelsChanged) {
+        GyroStateData gyroState;
+        GyroStateGet(&gyroState);
+        csd->gyro[0]     = gyroState.x;
+        csd->gyro[1]     = gyroState.y;
+        csd->gyro[2]     = gyroState.z;
+        csd->gyroUpdates = 0;
+        PIOS_CALLBACKSCHEDULER_Dispatch(csd->fastPathCallback);
+    }
+}
+
+static void fastPathTask(void)
+{
+    if (csd->channelsChanged) {
+        csd->channelsChanged = false;
+        updateChannels();
+    }
+    if (csd->fastPathDivider == 0) {
+        return;
+    }
+
+    portTickType thisSysTime = xTaskGetTickCount();
+    float dT_millis = (thisSysTime > csd->lastSysTime) ?
+                      (float)((thisSysTime - csd->lastSysTime) * portTICK_RATE_MS) :
+                      1000.0f * csd->fastPathDivider / PIOS_SENSOR_RATE;
+    csd->lastSysTime = thisSysTime;
+
+    CameraDesiredData cameraDesired;
+    cameraStabUpdate(dT_millis, csd->gyro, &cameraDesired);
+    CameraDesiredSet(&cameraDesired);
+
+#if !defined(ARCH_POSIX) && !defined(ARCH_WIN32)
+    // the GCS drives the outputs during the servo configuration
+    if (ActuatorCommandReadOnly()) {
+        return;
+    }
+    const float *outputs = &cameraDesired.RollOrServo1;
+    for (uint8_t i = 0; i < csd->numChannels; i++) {
+        const CameraChannel_t *channel = &csd->channels[i];
+        uint16_t value = 0;
+        if (thisSysTime >= (CAMERA_BOOT_DELAY_MS / portTICK_RATE_MS)) {
+            // from -1/+1 to the pulse duration, as the Actuator module
+            float output = outputs[channel->output];
+            int16_t pulse = (output >= 0.0f) ?
+                            (int16_t)(output * (float)(channel->max - channel->neutral)) + channel->neutral :
+                            (int16_t)(output * (float)(channel->neutral - channel->min)) + channel->neutral;
+            value = (uint16_t)boundf(pulse, MIN(channel->min, channel->max), MAX(channel->min, channel->max));
+        }
+        PIOS_Servo_Set(channel->addr, value);
+    }
+#endif
+}
+
 #ifdef USE_GIMBAL_FF
 void applyFeedForward(uint8_t index, float dT_millis, float *attitude, CameraStabSettingsData *cameraStab)
 {
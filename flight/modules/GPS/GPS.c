@@ -50,6 +50,7 @@
 #include "UBX.h"
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER) && !defined(PIOS_GPS_MINIMAL)
 #include "inc/ubx_autoconfig.h"
+#include <auxmagsupport.h>
 #endif
 
 #include <pios_instrumentation_helper.h>
@@ -71,6 +72,7 @@ static float GravityAccel(float latitude, float longitude, float altitude);
 void AuxMagSettingsUpdatedCb(UAVObjEvent *ev);
 #ifndef PIOS_GPS_MINIMAL
 void updateGpsSettings(UAVObjEvent *ev);
+static void updateGpsv9Link(uint32_t timeNowMs);
 #endif
 #endif
 
@@ -90,8 +92,6 @@ void updateGpsSettings(UAVObjEvent *ev);
         #define STACK_SIZE_BYTES   1024
 #else
 #if defined(PIOS_GPS_MINIMAL)
-        #define GPS_READ_BUFFER    32
-
 #ifdef PIOS_INCLUDE_GPS_NMEA_PARSER
         #define STACK_SIZE_BYTES   580 // NMEA
 #else
@@ -102,9 +102,11 @@ void updateGpsSettings(UAVObjEvent *ev);
 #endif // PIOS_GPS_MINIMAL
 #endif // PIOS_GPS_SETS_HOMELOCATION
 
-#ifndef GPS_READ_BUFFER
-#define GPS_READ_BUFFER            128
-#endif
+// NMEA parser input limit
+#define GPS_NMEA_READ_MAX          255
+
+// GPS Platinum link speed until the faster one is negotiated
+#define GPSV9_DEFAULT_BAUDRATE     57600
 
 #define TASK_PRIORITY              (tskIDLE_PRIORITY + 1)
 
@@ -125,6 +127,12 @@ static uint32_t timeOfLastUpdateMs;
 static struct GPS_RX_STATS gpsRxStats;
 #endif
 
+#if defined(PIOS_INCLUDE_GPS_UBX_PARSER) && !defined(PIOS_GPS_MINIMAL)
+// GPS Platinum link speed to negotiate, 0 when the port runs at GPSSpeed
+static uint32_t gpsv9LinkBaudRate;
+static enum { GPSV9LINK_DEFAULT, GPSV9LINK_REQUESTED, GPSV9LINK_FAST } gpsv9LinkState;
+#endif
+
 // ****************
 /**
  * Initialise the gps module
@@ -262,7 +270,6 @@ static void gpsTask(__attribute__((unused)) void *parameters)
     PERF_INIT_COUNTER(counterBytesIn, 0x97510001);
     PERF_INIT_COUNTER(counterRate, 0x97510002);
     PERF_INIT_COUNTER(counterParse, 0x97510003);
-    uint8_t c[GPS_READ_BUFFER];
 
     // Loop forever
     while (1) {
@@ -277,11 +284,18 @@ static void gpsTask(__attribute__((unused)) void *parameters)
             if (count) {
                 PIOS_COM_SendBuffer(gpsPort, (uint8_t *)buffer, count);
             }
+            updateGpsv9Link(xTaskGetTickCount() * portTICK_RATE_MS);
         }
+        // batched aux mag samples are published at their pace, the task does not block meanwhile
+        portTickType rxDelay = auxmagsupport_publish_queued() ? 0 : xDelay;
+#else
+        portTickType rxDelay = xDelay;
 #endif
-        // This blocks the task until there is something on the buffer
+        // This blocks the task until there is something on the buffer,
+        // the parsers read it in place.
+        uint8_t *c;
         uint16_t cnt;
-        while ((cnt = PIOS_COM_ReceiveBuffer(gpsPort, c, GPS_READ_BUFFER, xDelay)) > 0) {
+        while ((cnt = PIOS_COM_ReceiveRegion(gpsPort, &c, rxDelay)) > 0) {
             PERF_TIMED_SECTION_START(counterParse);
             PERF_TRACK_VALUE(counterBytesIn, cnt);
             PERF_MEASURE_PERIOD(counterRate);
@@ -289,6 +303,9 @@ static void gpsTask(__attribute__((unused)) void *parameters)
             switch (gpsSettings.DataProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
             case GPSSETTINGS_DATAPROTOCOL_NMEA:
+                if (cnt > GPS_NMEA_READ_MAX) {
+                    cnt = GPS_NMEA_READ_MAX;
+                }
                 res = parse_nmea_stream(c, cnt, gps_rx_buffer, &gpspositionsensor, &gpsRxStats);
                 break;
 #endif
@@ -318,6 +335,8 @@ static void gpsTask(__attribute__((unused)) void *parameters)
                 break;
             }
 
+            PIOS_COM_ReleaseRegion(gpsPort, cnt);
+
             PERF_TIMED_SECTION_END(counterParse);
             if (res == PARSER_COMPLETE) {
                 timeNowMs = xTaskGetTickCount() * portTICK_RATE_MS;
@@ -436,36 +455,93 @@ static void updateHwSettings()
         uint8_t speed;
         HwSettingsGPSSpeedGet(&speed);
 
-        // Set port speed
+        uint32_t baudRate = 0;
         switch (speed) {
         case HWSETTINGS_GPSSPEED_2400:
-            PIOS_COM_ChangeBaud(gpsPort, 2400);
+            baudRate = 2400;
             break;
         case HWSETTINGS_GPSSPEED_4800:
-            PIOS_COM_ChangeBaud(gpsPort, 4800);
+            baudRate = 4800;
             break;
         case HWSETTINGS_GPSSPEED_9600:
-            PIOS_COM_ChangeBaud(gpsPort, 9600);
+            baudRate = 9600;
             break;
         case HWSETTINGS_GPSSPEED_19200:
-            PIOS_COM_ChangeBaud(gpsPort, 19200);
+            baudRate = 19200;
             break;
         case HWSETTINGS_GPSSPEED_38400:
-            PIOS_COM_ChangeBaud(gpsPort, 38400);
+            baudRate = 38400;
             break;
         case HWSETTINGS_GPSSPEED_57600:
-            PIOS_COM_ChangeBaud(gpsPort, 57600);
+            baudRate = 57600;
             break;
         case HWSETTINGS_GPSSPEED_115200:
-            PIOS_COM_ChangeBaud(gpsPort, 115200);
+            baudRate = 115200;
             break;
         case HWSETTINGS_GPSSPEED_230400:
-            PIOS_COM_ChangeBaud(gpsPort, 230400);
+            baudRate = 230400;
             break;
         }
+
+#if defined(REVOLUTION) && defined(PIOS_INCLUDE_GPS_UBX_PARSER) && !defined(PIOS_GPS_MINIMAL)
+        // A GPS Platinum starts at its default speed, the faster one is negotiated
+        if (auxmagsupport_get_type() == AUXMAGSETTINGS_TYPE_GPSV9 && baudRate > GPSV9_DEFAULT_BAUDRATE) {
+            gpsv9LinkBaudRate = baudRate;
+            baudRate = GPSV9_DEFAULT_BAUDRATE;
+        }
+#endif
+
+        // Set port speed
+        if (baudRate) {
+            PIOS_COM_ChangeBaud(gpsPort, baudRate);
+        }
     }
 }
 
+#if defined(PIOS_INCLUDE_GPS_UBX_PARSER) && !defined(PIOS_GPS_MINIMAL)
+/**
+ * Negotiates the GPS Platinum link speed. The request is answered by the
+ * system info of the board, which advertises the option, and is sent again
+ * with each one: the board goes back to its default speed without it. The
+ * port follows on the next loop, once the request is out, and goes back to
+ * the default speed when the board falls silent.
+ */
+static void updateGpsv9Link(uint32_t timeNowMs)
+{
+    if (!gpsv9LinkBaudRate) {
+        return;
+    }
+
+    switch (gpsv9LinkState) {
+    case GPSV9LINK_REQUESTED:
+        PIOS_COM_ChangeBaud(gpsPort, gpsv9LinkBaudRate);
+        gpsv9LinkState = GPSV9LINK_FAST;
+        // the board gets a whole timeout to show up at the new speed
+        timeOfLastUpdateMs = timeNowMs;
+        break;
+    case GPSV9LINK_FAST:
+        if ((timeNowMs - timeOfLastUpdateMs) >= GPS_TIMEOUT_MS) {
+            PIOS_COM_ChangeBaud(gpsPort, GPSV9_DEFAULT_BAUDRATE);
+            gpsv9LinkState = GPSV9LINK_DEFAULT;
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (ubxOpSysReceived) {
+        ubxOpSysReceived = false;
+        if (ubxOpSysOptions & UBX_OP_SYS_OPTIONS_LINK) {
+            uint8_t request[sizeof(struct UBX_OP_LINK) + 8];
+            PIOS_COM_SendBuffer(gpsPort, request, build_ubx_op_link(request, gpsv9LinkBaudRate));
+            if (gpsv9LinkState == GPSV9LINK_DEFAULT) {
+                gpsv9LinkState = GPSV9LINK_REQUESTED;
+            }
+        }
+    }
+}
+#endif /* if defined(PIOS_INCLUDE_GPS_UBX_PARSER) && !defined(PIOS_GPS_MINIMAL) */
+
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER) && !defined(PIOS_GPS_MINIMAL)
 void AuxMagSettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
@@ -53,27 +53,28 @@ static uint32_t lastPvtTime = 0;
 typedef struct {
     uint8_t msgClass;
     uint8_t msgID;
-    void (*handler)(struct UBXPacket *, GPSPositionSensorData *GpsPosition);
+    void (*handler)(UBXPayload *, GPSPositionSensorData *GpsPosition);
 } ubx_message_handler;
 
 // parsing functions, roughly ordered by reception rate (higher rate messages on top)
 
-static void parse_ubx_nav_posllh(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
-static void parse_ubx_nav_velned(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
-static void parse_ubx_nav_sol(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
-static void parse_ubx_nav_dop(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_nav_posllh(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_nav_velned(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_nav_sol(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_nav_dop(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
 #ifndef PIOS_GPS_MINIMAL
-static void parse_ubx_nav_pvt(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
-static void parse_ubx_nav_timeutc(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
-static void parse_ubx_nav_svinfo(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_nav_pvt(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_nav_timeutc(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_nav_svinfo(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
 
-static void parse_ubx_op_sys(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
-static void parse_ubx_op_mag(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_op_sys(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_op_mag(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_op_magbatch(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
 
-static void parse_ubx_ack_ack(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
-static void parse_ubx_ack_nak(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_ack_ack(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_ack_nak(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
 
-static void parse_ubx_mon_ver(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition);
+static void parse_ubx_mon_ver(UBXPayload *payload, GPSPositionSensorData *GpsPosition);
 #endif
 
 const ubx_message_handler ubx_handler_table[] = {
@@ -83,6 +84,7 @@ const ubx_message_handler ubx_handler_table[] = {
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_DOP,     .handler = &parse_ubx_nav_dop     },
 #ifndef PIOS_GPS_MINIMAL
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_PVT,     .handler = &parse_ubx_nav_pvt     },
+    { .msgClass = UBX_CLASS_OP_CUST, .msgID = UBX_ID_OP_MAGBATCH, .handler = &parse_ubx_op_magbatch },
     { .msgClass = UBX_CLASS_OP_CUST, .msgID = UBX_ID_OP_MAG,      .handler = &parse_ubx_op_mag      },
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_SVINFO,  .handler = &parse_ubx_nav_svinfo  },
     { .msgClass = UBX_CLASS_NAV,     .msgID = UBX_ID_NAV_TIMEUTC, .handler = &parse_ubx_nav_timeutc },
@@ -103,11 +105,22 @@ int32_t ubxHwVersion = -1;
 struct UBX_ACK_ACK ubxLastAck;
 struct UBX_ACK_NAK ubxLastNak;
 
+#ifndef PIOS_GPS_MINIMAL
+bool ubxOpSysReceived;
+uint16_t ubxOpSysOptions;
+#endif
+
 // If a PVT sentence is received in the last UBX_PVT_TIMEOUT (ms) timeframe it disables VELNED/POSLLH/SOL/TIMEUTC
 #define UBX_PVT_TIMEOUT (1000)
+// sync, class, id and length before the payload, checksum after it
+#define UBX_FRAME_HEADER_LEN 6
+#define UBX_FRAME_OVERHEAD   (UBX_FRAME_HEADER_LEN + 2)
+
 // parse incoming character stream for messages in UBX binary format
+// Whole frames are checked and parsed where they are, usually the COM receive buffer,
+// only the frames cut by the end of rx go through the byte state machine.
 
-int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionSensorData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+int parse_ubx_stream(uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionSensorData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
     int ret = PARSER_INCOMPLETE; // message not (yet) complete
     enum proto_states {
@@ -127,8 +140,49 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
     static uint8_t rx_count = 0;
     struct UBXPacket *ubx   = (struct UBXPacket *)gps_rx_buffer;
 
-    for (int i = 0; i < len; i++) {
-        c = rx[i];
+    for (int i = 0; i < len;) {
+        if (proto_state == START) {
+            uint8_t *sync = memchr(&rx[i], UBX_SYNC1, len - i);
+            int skip = sync ? sync - &rx[i] : len - i;
+            if (skip > 0) {
+                ret = (ret != PARSER_COMPLETE) ? PARSER_ERROR : PARSER_COMPLETE; // parser couldn't use these bytes
+                i  += skip;
+                continue;
+            }
+            uint16_t avail = len - i;
+            if (avail >= 2 && rx[i + 1] != UBX_SYNC2) {
+                // not a frame start, look for the next sync
+                ret = (ret != PARSER_COMPLETE) ? PARSER_ERROR : PARSER_COMPLETE;
+                i++;
+                continue;
+            }
+            if (avail >= UBX_FRAME_OVERHEAD) {
+                uint16_t plen = rx[i + 4] | (rx[i + 5] << 8);
+                if (plen <= sizeof(UBXPayload) && avail >= plen + UBX_FRAME_OVERHEAD) {
+                    uint8_t *frame = &rx[i];
+                    uint8_t ck_a, ck_b;
+                    ubx_checksum(frame[2], frame[3], plen, &frame[UBX_FRAME_HEADER_LEN], &ck_a, &ck_b);
+                    if (frame[UBX_FRAME_HEADER_LEN + plen] == ck_a && frame[UBX_FRAME_HEADER_LEN + plen + 1] == ck_b) {
+                        UBXPayload *payload = (UBXPayload *)&frame[UBX_FRAME_HEADER_LEN];
+                        // The payload structs need natural alignment, copy the frames that are not
+                        if ((uintptr_t)payload & 3) {
+                            memcpy(ubx->payload.payload, payload, plen);
+                            payload = &ubx->payload;
+                        }
+                        parse_ubx_message(frame[2], frame[3], payload, GpsData);
+                        gpsRxStats->gpsRxReceived++;
+                        ret = PARSER_COMPLETE; // message complete & processed
+                    } else {
+                        gpsRxStats->gpsRxChkSumError++;
+                        ret = (ret != PARSER_COMPLETE) ? PARSER_ERROR : PARSER_COMPLETE;
+                    }
+                    i += plen + UBX_FRAME_OVERHEAD;
+                    continue;
+                }
+            }
+        }
+
+        c = rx[i++];
         switch (proto_state) {
         case START: // detect protocol
             if (c == UBX_SYNC1) { // first UBX sync char found
@@ -138,7 +192,7 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
         case UBX_SY2:
             if (c == UBX_SYNC2) { // second UBX sync char found
                 proto_state = UBX_CLASS;
-            } else {
+            } else if (c != UBX_SYNC1) { // a repeated first sync char may still start a frame
                 proto_state = START; // reset state
             }
             break;
@@ -182,7 +236,7 @@ int parse_ubx_stream(uint8_t *rx, uint8_t len, char *gps_rx_buffer, GPSPositionS
         case UBX_CHK2:
             ubx->header.ck_b = c;
             if (checksum_ubx_message(ubx)) { // message complete and valid
-                parse_ubx_message(ubx, GpsData);
+                parse_ubx_message(ubx->header.class, ubx->header.id, &ubx->payload, GpsData);
                 proto_state = FINISHED;
             } else {
                 gpsRxStats->gpsRxChkSumError++;
@@ -237,40 +291,20 @@ bool check_msgtracker(uint32_t tow, uint8_t msg_flag)
 
 bool checksum_ubx_message(struct UBXPacket *ubx)
 {
-    int i;
     uint8_t ck_a, ck_b;
 
-    ck_a  = ubx->header.class;
-    ck_b  = ck_a;
-
-    ck_a += ubx->header.id;
-    ck_b += ck_a;
-
-    ck_a += ubx->header.len & 0xff;
-    ck_b += ck_a;
-
-    ck_a += ubx->header.len >> 8;
-    ck_b += ck_a;
-
-    for (i = 0; i < ubx->header.len; i++) {
-        ck_a += ubx->payload.payload[i];
-        ck_b += ck_a;
-    }
+    ubx_checksum(ubx->header.class, ubx->header.id, ubx->header.len, ubx->payload.payload, &ck_a, &ck_b);
 
-    if (ubx->header.ck_a == ck_a &&
-        ubx->header.ck_b == ck_b) {
-        return true;
-    } else {
-        return false;
-    }
+    return ubx->header.ck_a == ck_a &&
+           ubx->header.ck_b == ck_b;
 }
 
-static void parse_ubx_nav_posllh(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition)
+static void parse_ubx_nav_posllh(UBXPayload *payload, GPSPositionSensorData *GpsPosition)
 {
     if (usePvt) {
         return;
     }
-    struct UBX_NAV_POSLLH *posllh = &ubx->payload.nav_posllh;
+    struct UBX_NAV_POSLLH *posllh = &payload->nav_posllh;
 
     if (check_msgtracker(posllh->iTOW, POSLLH_RECEIVED)) {
         if (GpsPosition->Status != GPSPOSITIONSENSOR_STATUS_NOFIX) {
@@ -282,12 +316,12 @@ static void parse_ubx_nav_posllh(struct UBXPacket *ubx, GPSPositionSensorData *G
     }
 }
 
-static void parse_ubx_nav_sol(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition)
+static void parse_ubx_nav_sol(UBXPayload *payload, GPSPositionSensorData *GpsPosition)
 {
     if (usePvt) {
         return;
     }
-    struct UBX_NAV_SOL *sol = &ubx->payload.nav_sol;
+    struct UBX_NAV_SOL *sol = &payload->nav_sol;
     if (check_msgtracker(sol->iTOW, SOL_RECEIVED)) {
         GpsPosition->Satellites = sol->numSV;
 
@@ -307,9 +341,9 @@ static void parse_ubx_nav_sol(struct UBXPacket *ubx, GPSPositionSensorData *GpsP
     }
 }
 
-static void parse_ubx_nav_dop(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition)
+static void parse_ubx_nav_dop(UBXPayload *payload, GPSPositionSensorData *GpsPosition)
 {
-    struct UBX_NAV_DOP *dop = &ubx->payload.nav_dop;
+    struct UBX_NAV_DOP *dop = &payload->nav_dop;
 
     if (check_msgtracker(dop->iTOW, DOP_RECEIVED)) {
         GpsPosition->HDOP = (float)dop->hDOP * 0.01f;
@@ -318,13 +352,13 @@ static void parse_ubx_nav_dop(struct UBXPacket *ubx, GPSPositionSensorData *GpsP
     }
 }
 
-static void parse_ubx_nav_velned(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition)
+static void parse_ubx_nav_velned(UBXPayload *payload, GPSPositionSensorData *GpsPosition)
 {
     if (usePvt) {
         return;
     }
     GPSVelocitySensorData GpsVelocity;
-    struct UBX_NAV_VELNED *velned = &ubx->payload.nav_velned;
+    struct UBX_NAV_VELNED *velned = &payload->nav_velned;
     if (check_msgtracker(velned->iTOW, VELNED_RECEIVED)) {
         if (GpsPosition->Status != GPSPOSITIONSENSOR_STATUS_NOFIX) {
             GpsVelocity.North        = (float)velned->velN / 100.0f;
@@ -337,12 +371,12 @@ static void parse_ubx_nav_velned(struct UBXPacket *ubx, GPSPositionSensorData *G
     }
 }
 #if !defined(PIOS_GPS_MINIMAL)
-static void parse_ubx_nav_pvt(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition)
+static void parse_ubx_nav_pvt(UBXPayload *payload, GPSPositionSensorData *GpsPosition)
 {
     lastPvtTime = PIOS_DELAY_GetuS();
 
     GPSVelocitySensorData GpsVelocity;
-    struct UBX_NAV_PVT *pvt = &ubx->payload.nav_pvt;
+    struct UBX_NAV_PVT *pvt = &payload->nav_pvt;
     check_msgtracker(pvt->iTOW, (ALL_RECEIVED));
 
     GpsVelocity.North = (float)pvt->velN * 0.001f;
@@ -380,13 +414,13 @@ static void parse_ubx_nav_pvt(struct UBXPacket *ubx, GPSPositionSensorData *GpsP
     }
 }
 
-static void parse_ubx_nav_timeutc(struct UBXPacket *ubx, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+static void parse_ubx_nav_timeutc(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
 {
     if (usePvt) {
         return;
     }
 
-    struct UBX_NAV_TIMEUTC *timeutc = &ubx->payload.nav_timeutc;
+    struct UBX_NAV_TIMEUTC *timeutc = &payload->nav_timeutc;
     // Test if time is valid
     if ((timeutc->valid & TIMEUTC_VALIDTOW) && (timeutc->valid & TIMEUTC_VALIDWKN)) {
         // Time is valid, set GpsTime
@@ -406,11 +440,11 @@ static void parse_ubx_nav_timeutc(struct UBXPacket *ubx, __attribute__((unused))
     }
 }
 
-static void parse_ubx_nav_svinfo(struct UBXPacket *ubx, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+static void parse_ubx_nav_svinfo(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
 {
     uint8_t chan;
     GPSSatellitesData svdata;
-    struct UBX_NAV_SVINFO *svinfo = &ubx->payload.nav_svinfo;
+    struct UBX_NAV_SVINFO *svinfo = &payload->nav_svinfo;
 
     svdata.SatsInView = 0;
     for (chan = 0; chan < svinfo->numCh; chan++) {
@@ -433,23 +467,23 @@ static void parse_ubx_nav_svinfo(struct UBXPacket *ubx, __attribute__((unused))
     GPSSatellitesSet(&svdata);
 }
 
-static void parse_ubx_ack_ack(struct UBXPacket *ubx, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+static void parse_ubx_ack_ack(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
 {
-    struct UBX_ACK_ACK *ack_ack = &ubx->payload.ack_ack;
+    struct UBX_ACK_ACK *ack_ack = &payload->ack_ack;
 
     ubxLastAck = *ack_ack;
 }
 
-static void parse_ubx_ack_nak(struct UBXPacket *ubx, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+static void parse_ubx_ack_nak(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
 {
-    struct UBX_ACK_NAK *ack_nak = &ubx->payload.ack_nak;
+    struct UBX_ACK_NAK *ack_nak = &payload->ack_nak;
 
     ubxLastNak = *ack_nak;
 }
 
-static void parse_ubx_mon_ver(struct UBXPacket *ubx, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+static void parse_ubx_mon_ver(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
 {
-    struct UBX_MON_VER *mon_ver = &ubx->payload.mon_ver;
+    struct UBX_MON_VER *mon_ver = &payload->mon_ver;
 
     ubxHwVersion = atoi(mon_ver->hwVersion);
 
@@ -457,9 +491,9 @@ static void parse_ubx_mon_ver(struct UBXPacket *ubx, __attribute__((unused)) GPS
                    ((ubxHwVersion >= 70000) ? GPSPOSITIONSENSOR_SENSORTYPE_UBX7 : GPSPOSITIONSENSOR_SENSORTYPE_UBX);
 }
 
-static void parse_ubx_op_sys(struct UBXPacket *ubx, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+static void parse_ubx_op_sys(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
 {
-    struct UBX_OP_SYSINFO *sysinfo = &ubx->payload.op_sysinfo;
+    struct UBX_OP_SYSINFO *sysinfo = &payload->op_sysinfo;
     GPSExtendedStatusData data;
 
     data.FlightTime   = sysinfo->flightTime;
@@ -470,24 +504,65 @@ static void parse_ubx_op_sys(struct UBXPacket *ubx, __attribute__((unused)) GPSP
     data.Options = sysinfo->options;
     data.Status  = GPSEXTENDEDSTATUS_STATUS_GPSV9;
     GPSExtendedStatusSet(&data);
+
+    ubxOpSysOptions  = sysinfo->options;
+    ubxOpSysReceived = true;
 }
 
-static void parse_ubx_op_mag(struct UBXPacket *ubx, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+static void parse_ubx_op_mag(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
 {
     if (!useMag) {
         return;
     }
-    struct UBX_OP_MAG *mag = &ubx->payload.op_mag;
+    struct UBX_OP_MAG *mag = &payload->op_mag;
     float mags[3] = { mag->x, mag->y, mag->z };
     auxmagsupport_publish_samples(mags, AUXMAGSENSOR_STATUS_OK);
 }
+
+static void parse_ubx_op_magbatch(UBXPayload *payload, __attribute__((unused)) GPSPositionSensorData *GpsPosition)
+{
+    if (!useMag) {
+        return;
+    }
+    struct UBX_OP_MAGBATCH *batch = &payload->op_magbatch;
+    const uint8_t count = MIN(batch->count, UBX_OP_MAGBATCH_MAX_SAMPLES);
+    float mags[UBX_OP_MAGBATCH_MAX_SAMPLES][3];
+    uint16_t time[UBX_OP_MAGBATCH_MAX_SAMPLES];
+
+    for (uint8_t i = 0; i < count; i++) {
+        mags[i][0] = batch->samples[i].x;
+        mags[i][1] = batch->samples[i].y;
+        mags[i][2] = batch->samples[i].z;
+        time[i]    = batch->samples[i].time;
+    }
+    auxmagsupport_queue_samples(mags, time, count, AUXMAGSENSOR_STATUS_OK);
+}
+
+/**
+ * Build the GPS Platinum link speed request in buffer, returns its length
+ */
+uint16_t build_ubx_op_link(uint8_t *buffer, uint32_t baudrate)
+{
+    const struct UBX_OP_LINK link = { .baudrate = baudrate };
+
+    buffer[0] = UBX_SYNC1;
+    buffer[1] = UBX_SYNC2;
+    buffer[2] = UBX_CLASS_OP_CUST;
+    buffer[3] = UBX_ID_OP_LINK;
+    buffer[4] = sizeof(link);
+    buffer[5] = 0;
+    memcpy(&buffer[UBX_FRAME_HEADER_LEN], &link, sizeof(link));
+    ubx_checksum(buffer[2], buffer[3], sizeof(link), &buffer[UBX_FRAME_HEADER_LEN],
+                 &buffer[UBX_FRAME_HEADER_LEN + sizeof(link)], &buffer[UBX_FRAME_HEADER_LEN + sizeof(link) + 1]);
+    return sizeof(link) + UBX_FRAME_OVERHEAD;
+}
 #endif /* if !defined(PIOS_GPS_MINIMAL) */
 
 
 // UBX message parser
 // returns UAVObjectID if a UAVObject structure is ready for further processing
 
-uint32_t parse_ubx_message(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosition)
+uint32_t parse_ubx_message(uint8_t msgClass, uint8_t msgID, UBXPayload *payload, GPSPositionSensorData *GpsPosition)
 {
     uint32_t id = 0;
     static bool ubxInitialized = false;
@@ -503,8 +578,8 @@ uint32_t parse_ubx_message(struct UBXPacket *ubx, GPSPositionSensorData *GpsPosi
     usePvt = (lastPvtTime) && (PIOS_DELAY_GetuSSince(lastPvtTime) < UBX_PVT_TIMEOUT * 1000);
     for (uint8_t i = 0; i < UBX_HANDLER_TABLE_SIZE; i++) {
         const ubx_message_handler *handler = &ubx_handler_table[i];
-        if (handler->msgClass == ubx->header.class && handler->msgID == ubx->header.id) {
-            handler->handler(ubx, GpsPosition);
+        if (handler->msgClass == msgClass && handler->msgID == msgID) {
+            handler->handler(payload, GpsPosition);
             break;
         }
     }
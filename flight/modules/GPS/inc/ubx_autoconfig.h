@@ -32,7 +32,9 @@
 #include <stdbool.h>
 
 // defines
-// TODO: NEO8 max rate is for Rom version, flash is limited to 10Hz, need to handle that.
+// Highest rates by hardware generation, a receiver that NAKs the rate
+// (e.g. flash firmware on a NEO8, limited to 10Hz) is stepped down
+#define UBX_MAX_RATE_VER9       25
 #define UBX_MAX_RATE_VER8       18
 #define UBX_MAX_RATE_VER7       10
 #define UBX_MAX_RATE            5
@@ -52,8 +52,12 @@ typedef struct {
     int8_t lastConfigSent; // index of last configuration string sent
     struct UBX_ACK_ACK requiredAck; // Class and id of the message we are waiting for an ACK from GPS
     uint8_t retryCount;
+    uint8_t navRateLimit; // lowered each time the receiver NAKs the rate, 0 for none
 } status_t;
 
+// rates tried in turn until the receiver takes one
+static const uint8_t nav_rate_steps[] = { 25, 20, 18, 10, 5, 4, 2, 1 };
+
 ubx_cfg_msg_t msg_config_ubx6[] = {
     // messages to disable
     { .msgClass = UBX_CLASS_NAV, .msgID = UBX_ID_NAV_CLOCK,   .rate = 0  },
@@ -168,9 +172,15 @@ void config_rate(uint16_t *bytes_to_send)
         rate = UBX_MAX_RATE;
     } else if (ubxHwVersion < UBX_HW_VERSION_8 && rate > UBX_MAX_RATE_VER7) {
         rate = UBX_MAX_RATE_VER7;
-    } else if (ubxHwVersion >= UBX_HW_VERSION_8 && rate > UBX_MAX_RATE_VER8) {
+    } else if (ubxHwVersion < UBX_HW_VERSION_9 && rate > UBX_MAX_RATE_VER8) {
         rate = UBX_MAX_RATE_VER8;
+    } else if (rate > UBX_MAX_RATE_VER9) {
+        rate = UBX_MAX_RATE_VER9;
+    }
+    if (status->navRateLimit && rate > status->navRateLimit) {
+        rate = status->navRateLimit;
     }
+    status->navRateLimit = rate;
     uint16_t period = 1000 / rate;
 
     status->working_packet.message.payload.cfg_rate.measRate = period;
@@ -323,6 +333,8 @@ void ubx_autoconfig_run(char * *buffer, uint16_t *bytes_to_send, bool gps_connec
         // clear ack
         ubxLastAck.clsID = 0x00;
         ubxLastAck.msgID = 0x00;
+        ubxLastNak.clsID = 0x00;
+        ubxLastNak.msgID = 0x00;
 
         status->lastStepTimestampRaw = PIOS_DELAY_GetRaw();
         build_request(&status->working_packet, UBX_CLASS_MON, UBX_ID_MON_VER, bytes_to_send);
@@ -331,6 +343,7 @@ void ubx_autoconfig_run(char * *buffer, uint16_t *bytes_to_send, bool gps_connec
 
     case INIT_STEP_WAIT_VER:
         if (ubxHwVersion > 0) {
+            status->navRateLimit   = 0;
             status->lastConfigSent = LAST_CONFIG_SENT_START;
             status->currentStep    = INIT_STEP_ENABLE_SENTENCES;
             status->lastStepTimestampRaw = PIOS_DELAY_GetRaw();
@@ -373,6 +386,18 @@ void ubx_autoconfig_run(char * *buffer, uint16_t *bytes_to_send, bool gps_connec
             // Continue with next configuration option
             status->retryCount = 0;
             status->lastConfigSent++;
+        } else if (ubxLastNak.clsID == UBX_CLASS_CFG && ubxLastNak.msgID == UBX_ID_CFG_RATE &&
+                   status->requiredAck.clsID == UBX_CLASS_CFG && status->requiredAck.msgID == UBX_ID_CFG_RATE &&
+                   status->navRateLimit > 1) {
+            // rate refused, resend the next lower one
+            ubxLastNak.clsID = 0x00;
+            ubxLastNak.msgID = 0x00;
+            uint8_t i = 0;
+            while (i < NELEMENTS(nav_rate_steps) - 1 && nav_rate_steps[i] >= status->navRateLimit) {
+                i++;
+            }
+            status->navRateLimit = nav_rate_steps[i];
+            status->retryCount   = 0;
         } else if (PIOS_DELAY_DiffuS(status->lastStepTimestampRaw) > UBX_REPLY_TIMEOUT) {
             // timeout, resend the message or abort
             status->retryCount++;
@@ -36,19 +36,55 @@
 #include "debuglogstatus.h"
 #include "debuglogentry.h"
 #include "flightstatus.h"
+#include "callbackinfo.h"
+#if defined(PIOS_INCLUDE_SDLOG)
+#include "taskinfo.h"
+#endif
+
+// private constants
+#define CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
+#define CBTASK_PRIORITY   CALLBACK_TASK_AUXILIARY
+#define STACK_SIZE_BYTES  512
+#define FLUSH_PERIOD_MS   10
+// entries pushed per stream request, one DebugLogEntry instance each
+#define STREAM_WINDOW     8
+#if defined(PIOS_INCLUDE_SDLOG)
+// the card can stall for hundreds of ms, it gets a task of its own so the auxiliary callbacks keep running
+#define SDLOG_TASK_PRIORITY    (tskIDLE_PRIORITY + 1)
+#define SDLOG_STACK_SIZE_BYTES 640
+#endif
 
 // private variables
+static DelayedCallbackInfo *loggingCallback;
+static struct {
+    DebugLogEntryData *buffer;
+    bool     pending;
+    uint16_t flight;
+    uint16_t entry;
+} stream;
 static DebugLogSettingsData settings;
 static DebugLogControlData control;
 static DebugLogStatusData status;
 static FlightStatusData flightstatus;
 static DebugLogEntryData *entry; // would be better on stack but event dispatcher stack might be insufficient
+#if defined(PIOS_INCLUDE_SDLOG)
+// the SD log follows the flash log, all card accesses are done from the SD log task
+static volatile bool sdlogEnabled;
+static xTaskHandle sdlogTaskHandle;
+static xSemaphoreHandle sdlogSignal;
+#endif
 
 // private functions
 static void SettingsUpdatedCb(UAVObjEvent *ev);
 static void ControlUpdatedCb(UAVObjEvent *ev);
 static void StatusUpdatedCb(UAVObjEvent *ev);
 static void FlightStatusUpdatedCb(UAVObjEvent *ev);
+static void LoggingCb(void);
+static void StreamEntries(void);
+static void EnableLogging(uint8_t enable);
+#if defined(PIOS_INCLUDE_SDLOG)
+static void SDLogTask(void *parameters);
+#endif
 
 int32_t LoggingInitialize(void)
 {
@@ -59,9 +95,20 @@ int32_t LoggingInitialize(void)
     FlightStatusInitialize();
     PIOS_DEBUGLOG_Initialize();
     entry = pios_malloc(sizeof(DebugLogEntryData));
-    if (!entry) {
+    stream.buffer = pios_malloc(sizeof(DebugLogEntryData));
+    if (!entry || !stream.buffer) {
         return -1;
     }
+#if defined(PIOS_INCLUDE_SDLOG)
+    if (PIOS_SDLOG_Init() == 0) {
+        vSemaphoreCreateBinary(sdlogSignal);
+    }
+#endif
+    for (int i = 1; i < STREAM_WINDOW; i++) {
+        DebugLogEntryCreateInstance();
+    }
+    // log entries are queued by the producers and written to flash from here, streams are also read from here
+    loggingCallback = PIOS_CALLBACKSCHEDULER_Create(&LoggingCb, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_LOGGING, STACK_SIZE_BYTES);
 
     return 0;
 }
@@ -82,6 +129,13 @@ int32_t LoggingStart(void)
     EventPeriodicCallbackCreate(&ev, StatusUpdatedCb, 1000);
     // invoke a periodic dispatcher callback - the event struct is a dummy, it could be filled with anything!
     StatusUpdatedCb(&ev);
+    PIOS_CALLBACKSCHEDULER_Schedule(loggingCallback, FLUSH_PERIOD_MS, CALLBACK_UPDATEMODE_SOONER);
+#if defined(PIOS_INCLUDE_SDLOG)
+    if (sdlogSignal) {
+        xTaskCreate(SDLogTask, "SDLog", SDLOG_STACK_SIZE_BYTES / 4, NULL, SDLOG_TASK_PRIORITY, &sdlogTaskHandle);
+        PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_LOGGING, sdlogTaskHandle);
+    }
+#endif
 
     return 0;
 }
@@ -90,6 +144,10 @@ MODULE_INITCALL(LoggingInitialize, LoggingStart);
 static void StatusUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     PIOS_DEBUGLOG_Info(&status.Flight, &status.Entry, &status.FreeSlots, &status.UsedSlots);
+    status.DroppedEntries = PIOS_DEBUGLOG_Dropped();
+#if defined(PIOS_INCLUDE_SDLOG)
+    status.DroppedEntries += PIOS_SDLOG_Dropped();
+#endif
     DebugLogStatusSet(&status);
 }
 
@@ -99,28 +157,88 @@ static void FlightStatusUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
     if (settings.LoggingEnabled == DEBUGLOGSETTINGS_LOGGINGENABLED_ONLYWHENARMED) {
         if (flightstatus.Armed != FLIGHTSTATUS_ARMED_ARMED) {
             PIOS_DEBUGLOG_Printf("FlightStatus Disarmed: On board Logging disabled.");
-            PIOS_DEBUGLOG_Enable(0);
+            EnableLogging(0);
         } else {
-            PIOS_DEBUGLOG_Enable(1);
+            EnableLogging(1);
             PIOS_DEBUGLOG_Printf("FlightStatus Armed: On board logging enabled.");
         }
     }
 }
 
+static void LoggingCb(void)
+{
+    if (stream.pending) {
+        stream.pending = false;
+        StreamEntries();
+    }
+    PIOS_DEBUGLOG_Flush();
+    PIOS_CALLBACKSCHEDULER_Schedule(loggingCallback, FLUSH_PERIOD_MS, CALLBACK_UPDATEMODE_SOONER);
+}
+
+#if defined(PIOS_INCLUDE_SDLOG)
+static void SDLogTask(__attribute__((unused)) void *parameters)
+{
+    while (1) {
+        // woken early when logging is switched on or off
+        xSemaphoreTake(sdlogSignal, FLUSH_PERIOD_MS / portTICK_RATE_MS);
+        if (sdlogEnabled && !PIOS_SDLOG_IsOpen()) {
+            // no card or no space, wait until logging is enabled again
+            if (PIOS_SDLOG_Open() != 0) {
+                sdlogEnabled = false;
+            }
+        } else if (!sdlogEnabled && PIOS_SDLOG_IsOpen()) {
+            PIOS_SDLOG_Close();
+        }
+        PIOS_SDLOG_Flush();
+    }
+}
+#endif
+
+static void StreamEntries(void)
+{
+    // the instances are not touched again before the next request, so telemetry can send them at its own pace
+    for (uint16_t i = 0; i < STREAM_WINDOW; i++) {
+        memset(stream.buffer, 0, sizeof(DebugLogEntryData));
+        if (PIOS_DEBUGLOG_Read(stream.buffer, stream.flight, stream.entry + i) != 0) {
+            stream.buffer->Flight = stream.flight;
+            stream.buffer->Entry  = stream.entry + i;
+            stream.buffer->Type   = DEBUGLOGENTRY_TYPE_EMPTY;
+        }
+        DebugLogEntryInstSet(i, stream.buffer);
+        DebugLogEntryInstUpdated(i);
+        if (stream.buffer->Type == DEBUGLOGENTRY_TYPE_EMPTY) {
+            break;
+        }
+    }
+}
+
 static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     DebugLogSettingsGet(&settings);
     if (settings.LoggingEnabled == DEBUGLOGSETTINGS_LOGGINGENABLED_ALWAYS) {
-        PIOS_DEBUGLOG_Enable(1);
+        EnableLogging(1);
         PIOS_DEBUGLOG_Printf("On board logging enabled.");
     } else if (settings.LoggingEnabled == DEBUGLOGSETTINGS_LOGGINGENABLED_DISABLED) {
         PIOS_DEBUGLOG_Printf("On board logging disabled.");
-        PIOS_DEBUGLOG_Enable(0);
+        EnableLogging(0);
     } else {
         FlightStatusUpdatedCb(NULL);
     }
 }
 
+static void EnableLogging(uint8_t enable)
+{
+    PIOS_DEBUGLOG_Enable(enable);
+#if defined(PIOS_INCLUDE_SDLOG)
+    if (sdlogEnabled != (enable != 0)) {
+        sdlogEnabled = (enable != 0);
+        if (sdlogSignal) {
+            xSemaphoreGive(sdlogSignal);
+        }
+    }
+#endif
+}
+
 static void ControlUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     DebugLogControlGet(&control);
@@ -133,6 +251,12 @@ static void ControlUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
             entry->Type   = DEBUGLOGENTRY_TYPE_EMPTY;
         }
         DebugLogEntrySet(entry);
+    } else if (control.Operation == DEBUGLOGCONTROL_OPERATION_STREAM) {
+        // flash reads are done from the logging callback, not from the event dispatcher
+        stream.flight  = control.Flight;
+        stream.entry   = control.Entry;
+        stream.pending = true;
+        PIOS_CALLBACKSCHEDULER_Dispatch(loggingCallback);
     } else if (control.Operation == DEBUGLOGCONTROL_OPERATION_FORMATFLASH) {
         uint8_t armed;
         FlightStatusArmedGet(&armed);
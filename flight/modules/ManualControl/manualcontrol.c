@@ -187,6 +187,7 @@ static void manualControlTask(void)
     FlightStatusGet(&flightStatus);
     ManualControlCommandData cmd;
     ManualControlCommandGet(&cmd);
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_MANUALCONTROLCOMMAND, PIOS_LATENCYPROBE_MANUALCONTROL);
 #ifndef PIOS_EXCLUDE_ADVANCED_FEATURES
     VtolPathFollowerSettingsThrustLimitsData thrustLimits;
     VtolPathFollowerSettingsThrustLimitsGet(&thrustLimits);
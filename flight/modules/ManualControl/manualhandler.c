@@ -62,6 +62,8 @@ void manualHandler(bool newinit)
     actuator.Thrust = cmd.Thrust;
 
     ActuatorDesiredSet(&actuator);
+    // No stabilization in manual, the tag goes straight to the Actuator
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_MANUALCONTROL, PIOS_LATENCYPROBE_ACTUATORDESIRED);
 }
 
 
@@ -167,6 +167,7 @@ void stabilizedHandler(bool newinit)
     stabilization.StabilizationMode.Thrust = stab_settings[3];
     stabilization.Thrust = cmd.Thrust;
     StabilizationDesiredSet(&stabilization);
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_MANUALCONTROL, PIOS_LATENCYPROBE_STABILIZATIONDESIRED);
 }
 
 
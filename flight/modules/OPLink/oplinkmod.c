@@ -157,12 +157,16 @@ static void systemTask(__attribute__((unused)) void *parameters)
             oplinkStatus.RxErrors = radio_stats.rx_error;
             oplinkStatus.RxMissed = radio_stats.rx_missed;
             oplinkStatus.RxFailure     = radio_stats.rx_failure;
+            oplinkStatus.RCGood   = radio_stats.rc_good;
+            oplinkStatus.RCLost   = radio_stats.rc_lost;
             oplinkStatus.TxDropped     = radio_stats.tx_dropped;
             oplinkStatus.TxFailure     = radio_stats.tx_failure;
             oplinkStatus.Resets      = radio_stats.resets;
             oplinkStatus.Timeouts    = radio_stats.timeouts;
             oplinkStatus.RSSI        = radio_stats.rssi;
             oplinkStatus.LinkQuality = radio_stats.link_quality;
+            oplinkStatus.AirDataRate = radio_stats.air_datarate;
+            oplinkStatus.FECParity   = radio_stats.fec_parity;
             if (first_time) {
                 first_time = false;
             } else {
@@ -132,6 +132,15 @@ void clearGraphics()
     memset((uint8_t *)draw_buffer_level, 0, GRAPHICS_WIDTH * GRAPHICS_HEIGHT);
 }
 
+// The last 8 pixels of every row are its last byte
+static void clearLastByte(void)
+{
+    for (uint32_t y = 0; y < GRAPHICS_HEIGHT_REAL; y++) {
+        draw_buffer_level[y * GRAPHICS_WIDTH + GRAPHICS_WIDTH - 1] = 0;
+        draw_buffer_mask[y * GRAPHICS_WIDTH + GRAPHICS_WIDTH - 1]  = 0;
+    }
+}
+
 void copyimage(uint16_t offsetx, uint16_t offsety, int image)
 {
     // check top/left position
@@ -379,6 +388,35 @@ void write_pixel_lm(unsigned int x, unsigned int y, int mmode, int lmode)
     WRITE_WORD_MODE(draw_buffer_level, wordnum, mask, lmode);
 }
 
+/**
+ * write_span: apply a mode to count whole bytes of a row. Set and clear are a
+ * memset, which stores words, toggle goes byte by byte.
+ *
+ * @param       buff    pointer to buffer to write in
+ * @param       addr    first byte
+ * @param       count   number of bytes, may be 0 or negative
+ * @param       mode    0 = clear, 1 = set, 2 = toggle
+ */
+static inline void write_span(uint8_t *buff, int addr, int count, int mode)
+{
+    if (count <= 0) {
+        return;
+    }
+    switch (mode) {
+    case 0:
+        memset(&buff[addr], 0x00, count);
+        break;
+    case 1:
+        memset(&buff[addr], 0xff, count);
+        break;
+    case 2:
+        for (int i = addr; i < addr + count; i++) {
+            buff[i] ^= 0xff;
+        }
+        break;
+    }
+}
+
 /**
  * write_hline: optimised horizontal line writing algorithm
  *
@@ -404,7 +442,7 @@ void write_hline(uint8_t *buff, unsigned int x0, unsigned int x1, unsigned int y
     int addr1     = CALC_BUFF_ADDR(x1, y);
     int addr0_bit = CALC_BIT_IN_WORD(x0);
     int addr1_bit = CALC_BIT_IN_WORD(x1);
-    int mask, mask_l, mask_r, i;
+    int mask, mask_l, mask_r;
     /* If the addresses are equal, we only need to write one word
      * which is an island. */
     if (addr0 == addr1) {
@@ -416,11 +454,8 @@ void write_hline(uint8_t *buff, unsigned int x0, unsigned int x1, unsigned int y
         mask_r = COMPUTE_HLINE_EDGE_R_MASK(addr1_bit);
         WRITE_WORD_MODE(buff, addr0, mask_l, mode);
         WRITE_WORD_MODE(buff, addr1, mask_r, mode);
-        // Now write 0xffff words from start+1 to end-1.
-        for (i = addr0 + 1; i <= addr1 - 1; i++) {
-            uint8_t m = 0xff;
-            WRITE_WORD_MODE(buff, i, m, mode);
-        }
+        // Now write the whole bytes from start+1 to end-1.
+        write_span(buff, addr0 + 1, addr1 - addr0 - 1, mode);
     }
 }
 
@@ -581,7 +616,7 @@ void write_filled_rectangle(uint8_t *buff, unsigned int x, unsigned int y, unsig
     unsigned int addr1     = CALC_BUFF_ADDR(x + width, y);
     unsigned int addr0_bit = CALC_BIT_IN_WORD(x);
     unsigned int addr1_bit = CALC_BIT_IN_WORD(x + width);
-    unsigned int mask, mask_l, mask_r, i;
+    unsigned int mask, mask_l, mask_r;
     // If the addresses are equal, we need to write one word vertically.
     if (addr0 == addr1) {
         mask = COMPUTE_HLINE_ISLAND_MASK(addr0_bit, addr1_bit);
@@ -609,10 +644,7 @@ void write_filled_rectangle(uint8_t *buff, unsigned int x, unsigned int y, unsig
         addr0 = addr0_old;
         addr1 = addr1_old;
         while (yy < height) {
-            for (i = addr0 + 1; i <= addr1 - 1; i++) {
-                uint8_t m = 0xff;
-                WRITE_WORD_MODE(buff, i, m, mode);
-            }
+            write_span(buff, addr0 + 1, addr1 - addr0 - 1, mode);
             addr0 += GRAPHICS_WIDTH_REAL / 8;
             addr1 += GRAPHICS_WIDTH_REAL / 8;
             yy++;
@@ -2025,10 +2057,7 @@ void introGraphics()
     drawBox(APPLY_HDEADBAND(0), APPLY_VDEADBAND(0), APPLY_HDEADBAND(GRAPHICS_RIGHT - 8), APPLY_VDEADBAND(GRAPHICS_BOTTOM));
 
     // Must mask out last half-word because SPI keeps clocking it out otherwise
-    for (uint32_t i = 0; i < 8; i++) {
-        write_vline(draw_buffer_level, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
-        write_vline(draw_buffer_mask, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
-    }
+    clearLastByte();
 }
 
 void calcHomeArrow(int16_t m_yaw)
@@ -2381,10 +2410,7 @@ void updateGraphics()
     }
 
     // Must mask out last half-word because SPI keeps clocking it out otherwise
-    for (uint32_t i = 0; i < 8; i++) {
-        write_vline(draw_buffer_level, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
-        write_vline(draw_buffer_mask, GRAPHICS_WIDTH_REAL - i - 1, 0, GRAPHICS_HEIGHT_REAL - 1, 0);
-    }
+    clearLastByte();
 }
 
 void updateOnceEveryFrame()
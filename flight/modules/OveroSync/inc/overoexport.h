@@ -0,0 +1,207 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup Overo Sync Module
+ * @{
+ *
+ * @file       overoexport.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Fixed layout records exported to the companion computer.
+ *             Shared by the firmware and the companion side, so it only
+ *             depends on the C standard headers.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef OVEROEXPORT_H
+#define OVEROEXPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * The records share the Overo stream with the UAVTalk frames of all the objects, they
+ * are only sent when OveroSyncSettings.ExportRecords is enabled.
+ * A record is a header, a payload of the type's fixed size and a CRC-8 (same
+ * polynomial as UAVTalk) over both, all fields little endian.
+ * The timestamp is the firmware microsecond clock when the source object was set,
+ * it wraps every 71 minutes. The sequence counts every record sent so a gap shows
+ * the records dropped because the link was full.
+ */
+#define OVEROEXPORT_SYNC         0xA5
+#define OVEROEXPORT_UAVTALK_SYNC 0x3C
+/* UAVTalk frame length: header (8 to 16 bytes) plus data, without the CRC */
+#define OVEROEXPORT_UAVTALK_MIN_FRAME 8
+#define OVEROEXPORT_UAVTALK_MAX_FRAME (16 + 256)
+
+enum overoexport_type {
+    OVEROEXPORT_TYPE_IMU      = 1,
+    OVEROEXPORT_TYPE_ATTITUDE = 2,
+    OVEROEXPORT_TYPE_GPS      = 3,
+    OVEROEXPORT_TYPE_ACTUATOR = 4,
+};
+
+struct overoexport_header {
+    uint8_t  sync;
+    uint8_t  type;
+    uint8_t  length; /* payload bytes */
+    uint8_t  sequence;
+    uint32_t timestamp; /* us */
+} __attribute__((packed));
+
+struct overoexport_imu {
+    float gyro[3]; /* deg/s */
+    float accel[3]; /* m/s^2 */
+    float temperature; /* deg C, of the gyro */
+} __attribute__((packed));
+
+struct overoexport_attitude {
+    float q[4];
+    float roll; /* degrees */
+    float pitch;
+    float yaw;
+} __attribute__((packed));
+
+struct overoexport_gps {
+    int32_t latitude; /* degrees x 10^-7 */
+    int32_t longitude;
+    float   altitude; /* m */
+    float   groundspeed; /* m/s */
+    float   heading; /* degrees */
+    float   pdop;
+    uint8_t status; /* GPSPositionSensor Status */
+    int8_t  satellites;
+} __attribute__((packed));
+
+#define OVEROEXPORT_ACTUATOR_CHANNELS 12
+
+struct overoexport_actuator {
+    int16_t channel[OVEROEXPORT_ACTUATOR_CHANNELS]; /* us */
+} __attribute__((packed));
+
+#define OVEROEXPORT_MAX_PAYLOAD 64
+#define OVEROEXPORT_MAX_RECORD  (sizeof(struct overoexport_header) + OVEROEXPORT_MAX_PAYLOAD + 1)
+
+/**
+ * Payload size of a record type, 0 for an unknown type
+ */
+static inline size_t overoexport_payload_length(uint8_t type)
+{
+    switch (type) {
+    case OVEROEXPORT_TYPE_IMU:
+        return sizeof(struct overoexport_imu);
+
+    case OVEROEXPORT_TYPE_ATTITUDE:
+        return sizeof(struct overoexport_attitude);
+
+    case OVEROEXPORT_TYPE_GPS:
+        return sizeof(struct overoexport_gps);
+
+    case OVEROEXPORT_TYPE_ACTUATOR:
+        return sizeof(struct overoexport_actuator);
+
+    default:
+        return 0;
+    }
+}
+
+static inline uint8_t overoexport_crc(uint8_t crc, const uint8_t *data, size_t length)
+{
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * Find the next record in a received buffer, without copying it.
+ * UAVTalk frames and bytes which do not start a valid record are skipped.
+ * \param[in] buf received bytes
+ * \param[in] length number of bytes in buf
+ * \param[out] consumed bytes of buf done with, including the record returned,
+ *                      the caller keeps the rest and appends to it
+ * \return the record header, the payload follows it, or NULL if buf holds no
+ *         complete record
+ */
+static inline const struct overoexport_header *overoexport_next(const uint8_t *buf, size_t length, size_t *consumed)
+{
+    size_t pos = 0;
+
+    while (pos < length) {
+        if (buf[pos] == OVEROEXPORT_UAVTALK_SYNC) {
+            /* sync, type, 16 bit length of the frame without its CRC */
+            if (length - pos < 4) {
+                break;
+            }
+            size_t frame = (size_t)buf[pos + 2] | ((size_t)buf[pos + 3] << 8);
+            if (frame < OVEROEXPORT_UAVTALK_MIN_FRAME || frame > OVEROEXPORT_UAVTALK_MAX_FRAME) {
+                pos++;
+                continue;
+            }
+            if (length - pos < frame + 1) {
+                break; /* wait for the rest of it */
+            }
+            pos += (overoexport_crc(0, &buf[pos], frame) == buf[pos + frame]) ? frame + 1 : 1;
+            continue;
+        }
+        if (buf[pos] != OVEROEXPORT_SYNC) {
+            pos++;
+            continue;
+        }
+        if (length - pos < sizeof(struct overoexport_header)) {
+            break;
+        }
+        const struct overoexport_header *header = (const struct overoexport_header *)&buf[pos];
+        size_t payload = overoexport_payload_length(header->type);
+        if (payload == 0 || header->length != payload) {
+            pos++;
+            continue;
+        }
+        size_t record = sizeof(*header) + payload;
+        if (length - pos < record + 1) {
+            break;
+        }
+        if (overoexport_crc(0, &buf[pos], record) != buf[pos + record]) {
+            pos++;
+            continue;
+        }
+        *consumed = pos + record + 1;
+        return header;
+    }
+    *consumed = pos;
+    return NULL;
+}
+
+/**
+ * The payload of a record returned by overoexport_next()
+ */
+static inline const void *overoexport_payload(const struct overoexport_header *header)
+{
+    return header + 1;
+}
+
+#endif /* OVEROEXPORT_H */
+
+/**
+ * @}
+ * @}
+ */
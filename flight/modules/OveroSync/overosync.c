@@ -33,27 +33,45 @@
 #include <openpilot.h>
 
 #include "overosync.h"
+#include "overoexport.h"
 
 #include "hwsettings.h"
 #include "overosyncstats.h"
+#include "overosyncsettings.h"
 #include "systemstats.h"
 #include "taskinfo.h"
+#include "gyrosensor.h"
+#include "accelsensor.h"
+#include "attitudestate.h"
+#include "gpspositionsensor.h"
+#include "actuatorcommand.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE   200
 #define STACK_SIZE_BYTES 512
 #define TASK_PRIORITY    (tskIDLE_PRIORITY + 0)
 
+// Below the sensor and flight control tasks, the events carry the time of the update
+#define EXPORT_QUEUE_SIZE       8
+#define EXPORT_STACK_SIZE_BYTES 384
+#define EXPORT_TASK_PRIORITY    (tskIDLE_PRIORITY + 2)
+
 // Private types
 
 // Private variables
 static xQueueHandle queue;
+static xQueueHandle exportQueue;
 static UAVTalkConnection uavTalkCon;
 static xTaskHandle overoSyncTaskHandle;
+static xTaskHandle overoExportTaskHandle;
 static bool overoEnabled;
+static bool exportEnabled;
+static uint8_t exportSequence;
 
 // Private functions
 static void overoSyncTask(void *parameters);
+static void overoExportTask(void *parameters);
+static void exportRecord(uint8_t type, uint32_t timestamp, const void *payload, uint8_t length);
 static int32_t packData(uint8_t *data, int32_t length);
 static void registerObject(UAVObjHandle obj);
 
@@ -88,7 +106,7 @@ int32_t OveroSyncInitialize(void)
     if (optionalModules[HWSETTINGS_OPTIONALMODULES_OVERO] == HWSETTINGS_OPTIONALMODULES_ENABLED) {
         overoEnabled = true;
 
-        // Create object queues
+        // Create object queue
         queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
     } else {
         overoEnabled = false;
@@ -98,6 +116,20 @@ int32_t OveroSyncInitialize(void)
 
 
     OveroSyncStatsInitialize();
+    OveroSyncSettingsInitialize();
+
+    // The records are sent besides the UAVTalk objects when enabled, read once at startup
+    uint8_t exportRecords;
+    OveroSyncSettingsExportRecordsGet(&exportRecords);
+    exportEnabled = (exportRecords == OVEROSYNCSETTINGS_EXPORTRECORDS_ENABLED);
+    if (exportEnabled) {
+        exportQueue = xQueueCreate(EXPORT_QUEUE_SIZE, sizeof(UAVObjTimestampedEvent));
+        GyroSensorInitialize();
+        AccelSensorInitialize();
+        AttitudeStateInitialize();
+        GPSPositionSensorInitialize();
+        ActuatorCommandInitialize();
+    }
 
 
     // Initialise UAVTalk
@@ -131,6 +163,15 @@ int32_t OveroSyncStart(void)
     // Start overosync tasks
     xTaskCreate(overoSyncTask, (signed char *)"OveroSync", STACK_SIZE_BYTES / 4, NULL, TASK_PRIORITY, &overoSyncTaskHandle);
 
+    if (exportEnabled && exportQueue) {
+        UAVObjConnectQueueTimestamped(GyroSensorHandle(), exportQueue, EV_UPDATED | EV_UPDATED_MANUAL);
+        UAVObjConnectQueueTimestamped(AttitudeStateHandle(), exportQueue, EV_UPDATED | EV_UPDATED_MANUAL);
+        UAVObjConnectQueueTimestamped(GPSPositionSensorHandle(), exportQueue, EV_UPDATED | EV_UPDATED_MANUAL);
+        UAVObjConnectQueueTimestamped(ActuatorCommandHandle(), exportQueue, EV_UPDATED | EV_UPDATED_MANUAL);
+        // TaskInfo has no slot for the export task, it is not monitored
+        xTaskCreate(overoExportTask, (signed char *)"OveroExport", EXPORT_STACK_SIZE_BYTES / 4, NULL, EXPORT_TASK_PRIORITY, &overoExportTaskHandle);
+    }
+
     PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_OVEROSYNC, overoSyncTaskHandle);
 
     return 0;
@@ -201,6 +242,89 @@ static void overoSyncTask(__attribute__((unused)) void *parameters)
     }
 }
 
+/**
+ * Export task, turns the updates of the exported objects into fixed layout records
+ * (see overoexport.h) stamped with the time of the update. AccelSensor is set just
+ * before GyroSensor, the IMU record is sent on the gyro update with the latest accel.
+ */
+static void overoExportTask(__attribute__((unused)) void *parameters)
+{
+    UAVObjTimestampedEvent event;
+
+    while (1) {
+        if (xQueueReceive(exportQueue, &event, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        UAVObjEvent ev     = event.ev;
+        uint32_t timestamp = event.timestamp;
+
+        if (ev.obj == GyroSensorHandle()) {
+            GyroSensorData gyro;
+            AccelSensorData accel;
+            GyroSensorGet(&gyro);
+            AccelSensorGet(&accel);
+
+            struct overoexport_imu imu = {
+                .gyro        = { gyro.x, gyro.y, gyro.z },
+                .accel       = { accel.x, accel.y, accel.z },
+                .temperature = gyro.temperature,
+            };
+            exportRecord(OVEROEXPORT_TYPE_IMU, timestamp, &imu, sizeof(imu));
+        } else if (ev.obj == AttitudeStateHandle()) {
+            AttitudeStateData att;
+            AttitudeStateGet(&att);
+
+            struct overoexport_attitude attitude = {
+                .q     = { att.q1, att.q2, att.q3, att.q4 },
+                .roll  = att.Roll,
+                .pitch = att.Pitch,
+                .yaw   = att.Yaw,
+            };
+            exportRecord(OVEROEXPORT_TYPE_ATTITUDE, timestamp, &attitude, sizeof(attitude));
+        } else if (ev.obj == GPSPositionSensorHandle()) {
+            GPSPositionSensorData pos;
+            GPSPositionSensorGet(&pos);
+
+            struct overoexport_gps gps = {
+                .latitude    = pos.Latitude,
+                .longitude   = pos.Longitude,
+                .altitude    = pos.Altitude,
+                .groundspeed = pos.Groundspeed,
+                .heading     = pos.Heading,
+                .pdop        = pos.PDOP,
+                .status      = pos.Status,
+                .satellites  = pos.Satellites,
+            };
+            exportRecord(OVEROEXPORT_TYPE_GPS, timestamp, &gps, sizeof(gps));
+        } else if (ev.obj == ActuatorCommandHandle()) {
+            struct overoexport_actuator actuator = { { 0 } };
+            int16_t channel[ACTUATORCOMMAND_CHANNEL_NUMELEM];
+            ActuatorCommandChannelGet(channel);
+            memcpy(actuator.channel, channel, MIN(sizeof(channel), sizeof(actuator.channel)));
+            exportRecord(OVEROEXPORT_TYPE_ACTUATOR, timestamp, &actuator, sizeof(actuator));
+        }
+    }
+}
+
+/**
+ * Frame a record and queue it whole, it is dropped when the link is full.
+ */
+static void exportRecord(uint8_t type, uint32_t timestamp, const void *payload, uint8_t length)
+{
+    uint8_t record[OVEROEXPORT_MAX_RECORD];
+    struct overoexport_header *header = (struct overoexport_header *)record;
+
+    header->sync      = OVEROEXPORT_SYNC;
+    header->type      = type;
+    header->length    = length;
+    header->sequence  = exportSequence++;
+    header->timestamp = timestamp;
+    memcpy(&record[sizeof(*header)], payload, length);
+    record[sizeof(*header) + length] = PIOS_CRC_updateCRC(0, record, sizeof(*header) + length);
+
+    packData(record, sizeof(*header) + length + 1);
+}
+
 /**
  * Transmit data buffer to the modem or USB port.
  * \param[in] data Data buffer to send
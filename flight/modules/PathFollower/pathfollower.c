@@ -35,7 +35,10 @@
  * This module acts as "autopilot" - it controls the setpoints of stabilization
  * based on current flight situation and desired flight path (PathDesired) as
  * directed by flightmode selection or pathplanner
- * This is a periodic delayed callback module
+ * This is a periodic delayed callback module, made of two callbacks of the
+ * same task: the path geometry (PathDesired to VelocityDesired) runs every
+ * PathUpdatePeriod, the velocity control (VelocityDesired to
+ * StabilizationDesired) every UpdatePeriod of the frame type settings
  *
  * Modules have no API, all communication to other modules is done through UAVObjects.
  * However modules may use the API exposed by shared libraries.
@@ -106,6 +109,14 @@
 
 // Private types
 
+// Fixed wing speed alarm thresholds, from the settings
+struct SpeedLimits {
+    float overspeed;
+    float highspeed;
+    float lowspeed;
+    float stallspeed;
+};
+
 struct Globals {
     struct pid PIDposH[2];
     struct pid PIDposV;
@@ -117,6 +128,7 @@ struct Globals {
     float poiRadius;
     float vtolEmergencyFallback;
     bool  vtolEmergencyFallbackSwitch;
+    bool  pathValid; // pathVelocityDesired and pathStatus are up to date
 };
 
 struct NeutralThrustEstimation {
@@ -135,14 +147,24 @@ static struct NeutralThrustEstimation neutralThrustEst;
 
 // Private variables
 static DelayedCallbackInfo *pathFollowerCBInfo;
-static uint32_t updatePeriod = PF_IDLE_UPDATE_RATE_MS;
+static DelayedCallbackInfo *pathGeometryCBInfo;
+static uint32_t updatePeriod     = PF_IDLE_UPDATE_RATE_MS;
+static uint32_t pathUpdatePeriod = PF_IDLE_UPDATE_RATE_MS;
 static struct Globals global;
 static PathStatusData pathStatus;
 static PathDesiredData pathDesired;
+// pathDesired geometry, recomputed only when pathDesired changes
+static struct path_segment pathSegment;
+// output of the path geometry, input of the velocity control
+static VelocityDesiredData pathVelocityDesired;
 static FixedWingPathFollowerSettingsData fixedWingPathFollowerSettings;
 static VtolPathFollowerSettingsData vtolPathFollowerSettings;
 static FlightStatusData flightStatus;
 static PathSummaryData pathSummary;
+// settings derived values, recomputed only when the settings change
+static bool vtolFrame;
+static struct SpeedLimits speedLimits;
+static float maximumRateYaw;
 
 // correct speed by measured airspeed
 static float indicatedAirspeedStateBias = 0.0f;
@@ -150,11 +172,15 @@ static float indicatedAirspeedStateBias = 0.0f;
 
 // Private functions
 static void pathFollowerTask(void);
+static void pathGeometryTask(void);
 static void resetGlobals();
 static void SettingsUpdatedCb(UAVObjEvent *ev);
+static void updatePath();
 static uint8_t updateAutoPilotByFrameType();
 static uint8_t updateAutoPilotFixedWing();
 static uint8_t updateAutoPilotVtol();
+static bool vtolFallbackActive();
+static void updatePathVtol();
 static float updateTailInBearing();
 static float updateCourseBearing();
 static float updatePathBearing();
@@ -178,6 +204,7 @@ int32_t PathFollowerStart()
     // Start main task
     PathStatusGet(&pathStatus);
     SettingsUpdatedCb(NULL);
+    PIOS_CALLBACKSCHEDULER_Dispatch(pathGeometryCBInfo);
     PIOS_CALLBACKSCHEDULER_Dispatch(pathFollowerCBInfo);
 
     return 0;
@@ -217,8 +244,11 @@ int32_t PathFollowerInitialize()
 
     // Create object queue
     pathFollowerCBInfo = PIOS_CALLBACKSCHEDULER_Create(&pathFollowerTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_PATHFOLLOWER, STACK_SIZE_BYTES);
+    pathGeometryCBInfo = PIOS_CALLBACKSCHEDULER_Create(&pathGeometryTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_PATHFOLLOWERPATH, STACK_SIZE_BYTES);
     FixedWingPathFollowerSettingsConnectCallback(&SettingsUpdatedCb);
     VtolPathFollowerSettingsConnectCallback(&SettingsUpdatedCb);
+    SystemSettingsConnectCallback(&SettingsUpdatedCb);
+    StabilizationBankConnectCallback(&SettingsUpdatedCb);
     PathDesiredConnectCallback(SettingsUpdatedCb);
     AirspeedStateConnectCallback(airspeedStateUpdatedCb);
 
@@ -228,7 +258,7 @@ MODULE_INITCALL(PathFollowerInitialize, PathFollowerStart);
 
 
 /**
- * Module thread, should not return.
+ * Velocity control callback, tracks the VelocityDesired of the path geometry
  */
 static void pathFollowerTask(void)
 {
@@ -241,19 +271,12 @@ static void pathFollowerTask(void)
         return;
     }
 
-    if (flightStatus.FlightMode == FLIGHTSTATUS_FLIGHTMODE_POI) { // TODO Hack from vtolpathfollower, move into manualcontrol!
-        processPOI();
-    }
-
-    int16_t old_uid = pathStatus.UID;
-    pathStatus.UID    = pathDesired.UID;
     pathStatus.Status = PATHSTATUS_STATUS_INPROGRESS;
-    if (pathDesired.ModeParameters[PATHDESIRED_MODEPARAMETER_BRAKE_TIMEOUT] > 0.0f) {
-        if (old_uid != pathStatus.UID) {
-            pathStatus.path_time = 0.0f;
-        } else {
-            pathStatus.path_time += updatePeriod / 1000.0f;
-        }
+
+    // Both callbacks run in the same task, the geometry of a newly engaged
+    // follower is computed right away rather than controlling on a stale one
+    if (!global.pathValid) {
+        updatePath();
     }
 
     switch (pathDesired.Mode) {
@@ -284,13 +307,67 @@ static void pathFollowerTask(void)
         AlarmsSet(SYSTEMALARMS_ALARM_GUIDANCE, SYSTEMALARMS_ALARM_ERROR);
         break;
     }
-    PathStatusSet(&pathStatus);
-
 
     PIOS_CALLBACKSCHEDULER_Schedule(pathFollowerCBInfo, updatePeriod, CALLBACK_UPDATEMODE_SOONER);
 }
 
 
+/**
+ * Path geometry callback, publishes PathStatus with the status of the last
+ * velocity control
+ */
+static void pathGeometryTask(void)
+{
+    if (flightStatus.ControlChain.PathFollower != FLIGHTSTATUS_CONTROLCHAIN_TRUE) {
+        PIOS_CALLBACKSCHEDULER_Schedule(pathGeometryCBInfo, PF_IDLE_UPDATE_RATE_MS, CALLBACK_UPDATEMODE_SOONER);
+        return;
+    }
+
+    updatePath();
+
+    PIOS_CALLBACKSCHEDULER_Schedule(pathGeometryCBInfo, pathUpdatePeriod, CALLBACK_UPDATEMODE_SOONER);
+}
+
+
+/**
+ * Computes VelocityDesired and the progress along the path
+ */
+static void updatePath()
+{
+    if (flightStatus.FlightMode == FLIGHTSTATUS_FLIGHTMODE_POI) { // TODO Hack from vtolpathfollower, move into manualcontrol!
+        processPOI();
+    }
+
+    int16_t old_uid = pathStatus.UID;
+    pathStatus.UID = pathDesired.UID;
+    if (pathDesired.ModeParameters[PATHDESIRED_MODEPARAMETER_BRAKE_TIMEOUT] > 0.0f) {
+        if (old_uid != pathStatus.UID) {
+            pathStatus.path_time = 0.0f;
+        } else {
+            pathStatus.path_time += pathUpdatePeriod / 1000.0f;
+        }
+    }
+    global.pathValid = true;
+
+    switch (pathDesired.Mode) {
+    case PATHDESIRED_MODE_FLYENDPOINT:
+    case PATHDESIRED_MODE_FLYVECTOR:
+    case PATHDESIRED_MODE_BRAKE:
+    case PATHDESIRED_MODE_FLYCIRCLERIGHT:
+    case PATHDESIRED_MODE_FLYCIRCLELEFT:
+        if (vtolFrame) {
+            updatePathVtol();
+        } else {
+            updatePathVelocity(fixedWingPathFollowerSettings.CourseFeedForward, true);
+        }
+        break;
+    default:
+        break;
+    }
+    PathStatusSet(&pathStatus);
+}
+
+
 static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     FixedWingPathFollowerSettingsGet(&fixedWingPathFollowerSettings);
@@ -309,7 +386,44 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
     pid_configure(&global.BrakePIDvel[0], vtolPathFollowerSettings.BrakeHorizontalVelPID.Kp, vtolPathFollowerSettings.BrakeHorizontalVelPID.Ki, vtolPathFollowerSettings.BrakeHorizontalVelPID.Kd, vtolPathFollowerSettings.BrakeHorizontalVelPID.ILimit);
     pid_configure(&global.BrakePIDvel[1], vtolPathFollowerSettings.BrakeHorizontalVelPID.Kp, vtolPathFollowerSettings.BrakeHorizontalVelPID.Ki, vtolPathFollowerSettings.BrakeHorizontalVelPID.Kd, vtolPathFollowerSettings.BrakeHorizontalVelPID.ILimit);
 
+    FrameType_t frameType = GetCurrentFrameType();
+    if (frameType == FRAME_TYPE_CUSTOM || frameType == FRAME_TYPE_GROUND) {
+        switch (vtolPathFollowerSettings.TreatCustomCraftAs) {
+        case VTOLPATHFOLLOWERSETTINGS_TREATCUSTOMCRAFTAS_FIXEDWING:
+            frameType = FRAME_TYPE_FIXED_WING;
+            break;
+        case VTOLPATHFOLLOWERSETTINGS_TREATCUSTOMCRAFTAS_VTOL:
+            frameType = FRAME_TYPE_MULTIROTOR;
+            break;
+        }
+    }
+    vtolFrame = (frameType == FRAME_TYPE_MULTIROTOR || frameType == FRAME_TYPE_HELI);
+
+    if (vtolFrame) {
+        updatePeriod     = vtolPathFollowerSettings.UpdatePeriod;
+        pathUpdatePeriod = vtolPathFollowerSettings.PathUpdatePeriod;
+        // horizontal gains depend on the follower in use, see updatePathVtol()
+        pid_configure(&global.PIDposV, vtolPathFollowerSettings.VerticalPosP, 0.0f, 0.0f, 0.0f);
+    } else {
+        updatePeriod     = fixedWingPathFollowerSettings.UpdatePeriod;
+        pathUpdatePeriod = fixedWingPathFollowerSettings.PathUpdatePeriod;
+        pid_configure(&global.PIDposH[0], fixedWingPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
+        pid_configure(&global.PIDposH[1], fixedWingPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
+        pid_configure(&global.PIDposV, fixedWingPathFollowerSettings.VerticalPosP, 0.0f, 0.0f, 0.0f);
+    }
+
+    float airSpeedMax, airSpeedMin;
+    SystemSettingsAirSpeedMaxGet(&airSpeedMax);
+    SystemSettingsAirSpeedMinGet(&airSpeedMin);
+    speedLimits.overspeed  = airSpeedMax * fixedWingPathFollowerSettings.Safetymargins.Overspeed;
+    speedLimits.highspeed  = fixedWingPathFollowerSettings.HorizontalVelMax * fixedWingPathFollowerSettings.Safetymargins.Highspeed;
+    speedLimits.lowspeed   = fixedWingPathFollowerSettings.HorizontalVelMin * fixedWingPathFollowerSettings.Safetymargins.Lowspeed;
+    speedLimits.stallspeed = airSpeedMin * fixedWingPathFollowerSettings.Safetymargins.Stallspeed;
+
+    StabilizationBankMaximumRateYawGet(&maximumRateYaw);
+
     PathDesiredGet(&pathDesired);
+    path_segment_init(&pathSegment, &pathDesired);
 }
 
 
@@ -356,6 +470,7 @@ static void resetGlobals()
     global.poiRadius = 0.0f;
     global.vtolEmergencyFallback = 0;
     global.vtolEmergencyFallbackSwitch = false;
+    global.pathValid = false;
 
     // reset neutral thrust assessment. We restart this process
     // and do once for each position hold engagement
@@ -373,49 +488,31 @@ static void resetGlobals()
 
 static uint8_t updateAutoPilotByFrameType()
 {
-    FrameType_t frameType = GetCurrentFrameType();
-
-    if (frameType == FRAME_TYPE_CUSTOM || frameType == FRAME_TYPE_GROUND) {
-        switch (vtolPathFollowerSettings.TreatCustomCraftAs) {
-        case VTOLPATHFOLLOWERSETTINGS_TREATCUSTOMCRAFTAS_FIXEDWING:
-            frameType = FRAME_TYPE_FIXED_WING;
-            break;
-        case VTOLPATHFOLLOWERSETTINGS_TREATCUSTOMCRAFTAS_VTOL:
-            frameType = FRAME_TYPE_MULTIROTOR;
-            break;
-        }
-    }
-    switch (frameType) {
-    case FRAME_TYPE_MULTIROTOR:
-    case FRAME_TYPE_HELI:
-        updatePeriod = vtolPathFollowerSettings.UpdatePeriod;
+    if (vtolFrame) {
         return updateAutoPilotVtol();
-
-        break;
-    case FRAME_TYPE_FIXED_WING:
-    default:
-        updatePeriod = fixedWingPathFollowerSettings.UpdatePeriod;
-        return updateAutoPilotFixedWing();
-
-        break;
     }
+    return updateAutoPilotFixedWing();
 }
 
 /**
  * fixed wing autopilot:
- * straight forward:
- * 1. update path velocity for limited motion crafts
- * 2. update attitude according to default fixed wing pathfollower algorithm
+ * update attitude according to default fixed wing pathfollower algorithm,
+ * the path velocity for limited motion crafts comes from updatePath()
  */
 static uint8_t updateAutoPilotFixedWing()
 {
-    pid_configure(&global.PIDposH[0], fixedWingPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
-    pid_configure(&global.PIDposH[1], fixedWingPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
-    pid_configure(&global.PIDposV, fixedWingPathFollowerSettings.VerticalPosP, 0.0f, 0.0f, 0.0f);
-    updatePathVelocity(fixedWingPathFollowerSettings.CourseFeedForward, true);
     return updateFixedDesiredAttitude();
 }
 
+/**
+ * Whether the vtol flies with the emergency fallback follower
+ */
+static bool vtolFallbackActive()
+{
+    return global.vtolEmergencyFallbackSwitch ||
+           vtolPathFollowerSettings.FlyawayEmergencyFallback == VTOLPATHFOLLOWERSETTINGS_FLYAWAYEMERGENCYFALLBACK_ALWAYS;
+}
+
 /**
  * vtol autopilot
  * use hover capable algorithm with unlimeted movement calculation. if that fails (flyaway situation due to compass failure)
@@ -423,86 +520,70 @@ static uint8_t updateAutoPilotFixedWing()
  */
 static uint8_t updateAutoPilotVtol()
 {
-    enum { RETURN_0 = 0, RETURN_1 = 1, RETURN_RESULT } returnmode;
-    enum { FOLLOWER_REGULAR, FOLLOWER_FALLBACK } followermode;
-    uint8_t result = 0;
-
-    // decide on behaviour based on settings and system state
-    if (global.vtolEmergencyFallbackSwitch) {
-        returnmode   = RETURN_0;
-        followermode = FOLLOWER_FALLBACK;
-    } else {
-        if (vtolPathFollowerSettings.FlyawayEmergencyFallback == VTOLPATHFOLLOWERSETTINGS_FLYAWAYEMERGENCYFALLBACK_ALWAYS) {
-            returnmode   = RETURN_1;
-            followermode = FOLLOWER_FALLBACK;
-        } else {
-            returnmode   = RETURN_RESULT;
-            followermode = FOLLOWER_REGULAR;
-        }
-    }
-
-    // vertical positon control PID loops works the same in both regular and fallback modes, setup according to settings
-    pid_configure(&global.PIDposV, vtolPathFollowerSettings.VerticalPosP, 0.0f, 0.0f, 0.0f);
+    if (vtolFallbackActive()) {
+        // emergency follower has no return value
+        updateVtolDesiredAttitudeEmergencyFallback();
 
-    switch (followermode) {
-    case FOLLOWER_REGULAR:
-    {
-        // horizontal position control PID loop works according to settings in regular mode, allowing integral terms
-        pid_configure(&global.PIDposH[0], vtolPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
-        pid_configure(&global.PIDposH[1], vtolPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
-        updatePathVelocity(vtolPathFollowerSettings.CourseFeedForward, false);
+        // the fallback switched on by a flyaway is an error, one forced by the settings is not
+        return global.vtolEmergencyFallbackSwitch ? 0 : 1;
+    }
 
-        // yaw behaviour is configurable in vtolpathfollower, select yaw control algorithm
-        bool yaw_attitude = true;
-        float yaw = 0.0f;
+    // yaw behaviour is configurable in vtolpathfollower, select yaw control algorithm
+    bool yaw_attitude = true;
+    float yaw = 0.0f;
 
-        if (pathDesired.Mode == PATHDESIRED_MODE_BRAKE) {
+    if (pathDesired.Mode == PATHDESIRED_MODE_BRAKE) {
+        yaw_attitude = false;
+    } else {
+        switch (vtolPathFollowerSettings.YawControl) {
+        case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_MANUAL:
             yaw_attitude = false;
-        } else {
-            switch (vtolPathFollowerSettings.YawControl) {
-            case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_MANUAL:
-                yaw_attitude = false;
-                break;
-            case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_TAILIN:
-                yaw = updateTailInBearing();
-                break;
-            case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_MOVEMENTDIRECTION:
-                yaw = updateCourseBearing();
-                break;
-            case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_PATHDIRECTION:
-                yaw = updatePathBearing();
-                break;
-            case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_POI:
-                yaw = updatePOIBearing();
-                break;
-            }
+            break;
+        case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_TAILIN:
+            yaw = updateTailInBearing();
+            break;
+        case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_MOVEMENTDIRECTION:
+            yaw = updateCourseBearing();
+            break;
+        case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_PATHDIRECTION:
+            yaw = updatePathBearing();
+            break;
+        case VTOLPATHFOLLOWERSETTINGS_YAWCONTROL_POI:
+            yaw = updatePOIBearing();
+            break;
         }
-        result = updateVtolDesiredAttitude(yaw_attitude, yaw);
-
-        if (!result) {
-            if (pathDesired.Mode == PATHDESIRED_MODE_BRAKE) {
-                plan_setup_assistedcontrol(true); // revert braking to position hold, user can always stick override
-            } else if (vtolPathFollowerSettings.FlyawayEmergencyFallback != VTOLPATHFOLLOWERSETTINGS_FLYAWAYEMERGENCYFALLBACK_DISABLED) {
-                // switch to emergency follower if follower indicates problems
-                global.vtolEmergencyFallbackSwitch = true;
-            }
+    }
+    uint8_t result = updateVtolDesiredAttitude(yaw_attitude, yaw);
+
+    if (!result) {
+        if (pathDesired.Mode == PATHDESIRED_MODE_BRAKE) {
+            plan_setup_assistedcontrol(true); // revert braking to position hold, user can always stick override
+        } else if (vtolPathFollowerSettings.FlyawayEmergencyFallback != VTOLPATHFOLLOWERSETTINGS_FLYAWAYEMERGENCYFALLBACK_DISABLED) {
+            // switch to emergency follower if follower indicates problems
+            global.vtolEmergencyFallbackSwitch = true;
         }
     }
-    break;
-    case FOLLOWER_FALLBACK:
-    {
+
+    return result;
+}
+
+/**
+ * vtol path geometry, with the brake mode end conditions
+ */
+static void updatePathVtol()
+{
+    if (vtolFallbackActive()) {
         // fallback loop only cares about intended horizontal flight direction, simplify control behaviour accordingly
         pid_configure(&global.PIDposH[0], 1.0f, 0.0f, 0.0f, 0.0f);
         pid_configure(&global.PIDposH[1], 1.0f, 0.0f, 0.0f, 0.0f);
         updatePathVelocity(vtolPathFollowerSettings.CourseFeedForward, true);
-
-        // emergency follower has no return value
-        updateVtolDesiredAttitudeEmergencyFallback();
-    }
-    break;
+    } else {
+        // horizontal position control PID loop works according to settings in regular mode, allowing integral terms
+        pid_configure(&global.PIDposH[0], vtolPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
+        pid_configure(&global.PIDposH[1], vtolPathFollowerSettings.HorizontalPosP, 0.0f, 0.0f, 0.0f);
+        updatePathVelocity(vtolPathFollowerSettings.CourseFeedForward, false);
     }
 
-
     // Brake mode end condition checks
     if (pathDesired.Mode == PATHDESIRED_MODE_BRAKE) {
         bool exit_brake = false;
@@ -543,18 +624,8 @@ static uint8_t updateAutoPilotVtol()
             neutralThrustEst.have_correction = false;
         }
     }
-
-    switch (returnmode) {
-    case RETURN_RESULT:
-        return result;
-
-    default:
-        // returns either 0 or 1 according to enum definition above
-        return returnmode;
-    }
 }
 
-
 /**
  * Compute bearing of current takeoff location
  */
@@ -595,7 +666,7 @@ static float updatePathBearing()
                      positionState.Down };
     struct path_status progress;
 
-    path_progress(&pathDesired, cur, &progress);
+    path_segment_progress(&pathSegment, cur, &progress);
 
     // atan2f always returns in between + and - 180 degrees
     return RAD2DEG(atan2f(progress.path_vector[1], progress.path_vector[0]));
@@ -645,7 +716,7 @@ static float updatePOIBearing()
  **/
 static void processPOI()
 {
-    const float dT = updatePeriod / 1000.0f;
+    const float dT = pathUpdatePeriod / 1000.0f;
 
 
     PositionStateData positionState;
@@ -708,6 +779,7 @@ static void processPOI()
             pathDesired.StartingVelocity = 1.0f;
             pathDesired.EndingVelocity   = 0.0f;
             pathDesired.Mode = PATHDESIRED_MODE_FLYENDPOINT;
+            path_segment_init(&pathSegment, &pathDesired);
             PathDesiredSet(&pathDesired);
         }
     }
@@ -758,7 +830,7 @@ static void updatePathVelocity(float kFF, bool limited)
     VelocityStateGet(&velocityState);
     VelocityDesiredData velocityDesired;
 
-    const float dT = updatePeriod / 1000.0f;
+    const float dT = pathUpdatePeriod / 1000.0f;
 
     if (pathDesired.Mode == PATHDESIRED_MODE_BRAKE) {
         float brakeRate = vtolPathFollowerSettings.BrakeRate;
@@ -798,7 +870,7 @@ static void updatePathVelocity(float kFF, bool limited)
                          positionState.East + (velocityState.East * kFF),
                          positionState.Down + (velocityState.Down * kFF) };
         struct path_status progress;
-        path_progress(&pathDesired, cur, &progress);
+        path_segment_progress(&pathSegment, cur, &progress);
 
         // calculate velocity - can be zero if waypoints are too close
         velocityDesired.North = progress.path_vector[0];
@@ -842,6 +914,7 @@ static void updatePathVelocity(float kFF, bool limited)
     }
 
 
+    pathVelocityDesired = velocityDesired;
     VelocityDesiredSet(&velocityDesired);
 }
 
@@ -855,13 +928,12 @@ static uint8_t updateFixedDesiredAttitude()
 
     const float dT = updatePeriod / 1000.0f; // Convert from [ms] to [s]
 
-    VelocityDesiredData velocityDesired;
+    VelocityDesiredData velocityDesired = pathVelocityDesired;
     VelocityStateData velocityState;
     StabilizationDesiredData stabDesired;
     AttitudeStateData attitudeState;
     FixedWingPathFollowerStatusData fixedWingPathFollowerStatus;
     AirspeedStateData airspeedState;
-    SystemSettingsData systemSettings;
 
     float groundspeedProjection;
     float indicatedAirspeedState;
@@ -884,10 +956,8 @@ static uint8_t updateFixedDesiredAttitude()
 
     VelocityStateGet(&velocityState);
     StabilizationDesiredGet(&stabDesired);
-    VelocityDesiredGet(&velocityDesired);
     AttitudeStateGet(&attitudeState);
     AirspeedStateGet(&airspeedState);
-    SystemSettingsGet(&systemSettings);
 
     /**
      * Compute speed error and course
@@ -950,19 +1020,19 @@ static uint8_t updateFixedDesiredAttitude()
     // Error condition: plane too slow or too fast
     fixedWingPathFollowerStatus.Errors.Highspeed = 0;
     fixedWingPathFollowerStatus.Errors.Lowspeed  = 0;
-    if (indicatedAirspeedState > systemSettings.AirSpeedMax * fixedWingPathFollowerSettings.Safetymargins.Overspeed) {
+    if (indicatedAirspeedState > speedLimits.overspeed) {
         fixedWingPathFollowerStatus.Errors.Overspeed = 1;
         result = 0;
     }
-    if (indicatedAirspeedState > fixedWingPathFollowerSettings.HorizontalVelMax * fixedWingPathFollowerSettings.Safetymargins.Highspeed) {
+    if (indicatedAirspeedState > speedLimits.highspeed) {
         fixedWingPathFollowerStatus.Errors.Highspeed = 1;
         result = 0;
     }
-    if (indicatedAirspeedState < fixedWingPathFollowerSettings.HorizontalVelMin * fixedWingPathFollowerSettings.Safetymargins.Lowspeed) {
+    if (indicatedAirspeedState < speedLimits.lowspeed) {
         fixedWingPathFollowerStatus.Errors.Lowspeed = 1;
         result = 0;
     }
-    if (indicatedAirspeedState < systemSettings.AirSpeedMin * fixedWingPathFollowerSettings.Safetymargins.Stallspeed) {
+    if (indicatedAirspeedState < speedLimits.stallspeed) {
         fixedWingPathFollowerStatus.Errors.Stallspeed = 1;
         result = 0;
     }
@@ -1213,12 +1283,10 @@ static int8_t updateVtolDesiredAttitude(bool yaw_attitude, float yaw_direction)
     uint8_t result     = 1;
     bool manual_thrust = false;
 
-    VelocityDesiredData velocityDesired;
+    VelocityDesiredData velocityDesired = pathVelocityDesired;
     VelocityStateData velocityState;
     StabilizationDesiredData stabDesired;
     AttitudeStateData attitudeState;
-    StabilizationBankData stabSettings;
-    SystemSettingsData systemSettings;
     VtolSelfTuningStatsData vtolSelfTuningStats;
 
     float northError;
@@ -1230,13 +1298,9 @@ static int8_t updateVtolDesiredAttitude(bool yaw_attitude, float yaw_direction)
     float downError;
     float downCommand;
 
-    SystemSettingsGet(&systemSettings);
     VelocityStateGet(&velocityState);
-    VelocityDesiredGet(&velocityDesired);
     StabilizationDesiredGet(&stabDesired);
-    VelocityDesiredGet(&velocityDesired);
     AttitudeStateGet(&attitudeState);
-    StabilizationBankGet(&stabSettings);
     VtolSelfTuningStatsGet(&vtolSelfTuningStats);
 
 
@@ -1409,7 +1473,7 @@ static int8_t updateVtolDesiredAttitude(bool yaw_attitude, float yaw_direction)
         stabDesired.Yaw = yaw_direction;
     } else {
         stabDesired.StabilizationMode.Yaw = STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK;
-        stabDesired.Yaw = stabSettings.MaximumRate.Yaw * manualControl.Yaw;
+        stabDesired.Yaw = maximumRateYaw * manualControl.Yaw;
     }
 
     // default thrust mode to cruise control
@@ -1466,7 +1530,7 @@ static void updateVtolDesiredAttitudeEmergencyFallback()
 {
     const float dT = updatePeriod / 1000.0f;
 
-    VelocityDesiredData velocityDesired;
+    VelocityDesiredData velocityDesired = pathVelocityDesired;
     VelocityStateData velocityState;
     StabilizationDesiredData stabDesired;
 
@@ -1477,7 +1541,6 @@ static void updateVtolDesiredAttitudeEmergencyFallback()
     float downCommand;
 
     VelocityStateGet(&velocityState);
-    VelocityDesiredGet(&velocityDesired);
 
     ManualControlCommandData manualControlData;
     ManualControlCommandGet(&manualControlData);
@@ -56,7 +56,7 @@
 #define RETRY_TIMEOUT_MS  20
 #define EVENT_QUEUE_SIZE  10
 #define MAX_PORT_DELAY    200
-#define SERIAL_RX_BUF_LEN 100
+#define FORWARD_CHUNK_LEN 100
 #define PPM_INPUT_TIMEOUT 100
 
 
@@ -80,9 +80,6 @@ typedef struct {
     xQueueHandle uavtalkEventQueue;
     xQueueHandle radioEventQueue;
 
-    // The raw serial Rx buffer
-    uint8_t  serialRxBuf[SERIAL_RX_BUF_LEN];
-
     // Error statistics.
     uint32_t telemetryTxRetries;
     uint32_t radioTxRetries;
@@ -108,8 +105,9 @@ static void radioRxTask(void *parameters);
 static void PPMInputTask(void *parameters);
 static int32_t UAVTalkSendHandler(uint8_t *buf, int32_t length);
 static int32_t RadioSendHandler(uint8_t *buf, int32_t length);
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte);
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte);
+static void ForwardStream(uint32_t inputPort, uint32_t outputPort);
+static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t *buf, uint16_t length);
+static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t *buf, uint16_t length);
 static void objectPersistenceUpdatedCb(UAVObjEvent *objEv);
 static void registerObject(UAVObjHandle obj);
 
@@ -402,26 +400,17 @@ static void radioRxTask(__attribute__((unused)) void *parameters)
 #ifdef PIOS_INCLUDE_WDG
         PIOS_WDG_UpdateFlag(PIOS_WDG_RADIORX);
 #endif
-        if (PIOS_COM_RADIO) {
-            uint8_t serial_data[1];
-            uint16_t bytes_to_process = PIOS_COM_ReceiveBuffer(PIOS_COM_RADIO, serial_data, sizeof(serial_data), MAX_PORT_DELAY);
+        if (PIOS_COM_RADIO && data->parseUAVTalk) {
+            // Pass the data through the UAVTalk parser, straight from the radio buffer.
+            uint8_t *region;
+            uint16_t bytes_to_process = PIOS_COM_ReceiveRegion(PIOS_COM_RADIO, &region, MAX_PORT_DELAY);
             if (bytes_to_process > 0) {
-                if (data->parseUAVTalk) {
-                    // Pass the data through the UAVTalk parser.
-                    for (uint8_t i = 0; i < bytes_to_process; i++) {
-                        ProcessRadioStream(data->radioUAVTalkCon, data->telemUAVTalkCon, serial_data[i]);
-                    }
-                } else if (PIOS_COM_TELEMETRY) {
-                    // Send the data straight to the telemetry port.
-                    // Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
-                    // It is the caller responsibility to retry in such cases...
-                    int32_t ret   = -2;
-                    uint8_t count = 5;
-                    while (count-- > 0 && ret < -1) {
-                        ret = PIOS_COM_SendBufferNonBlocking(PIOS_COM_TELEMETRY, serial_data, bytes_to_process);
-                    }
-                }
+                ProcessRadioStream(data->radioUAVTalkCon, data->telemUAVTalkCon, region, bytes_to_process);
+                PIOS_COM_ReleaseRegion(PIOS_COM_RADIO, bytes_to_process);
             }
+        } else if (PIOS_COM_RADIO) {
+            // Send the data straight to the telemetry port.
+            ForwardStream(PIOS_COM_RADIO, PIOS_COM_TELEMETRY);
         } else {
             vTaskDelay(5);
         }
@@ -448,12 +437,11 @@ static void telemetryRxTask(__attribute__((unused)) void *parameters)
         }
 #endif /* PIOS_INCLUDE_USB */
         if (inputPort) {
-            uint8_t serial_data[1];
-            uint16_t bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), MAX_PORT_DELAY);
+            uint8_t *region;
+            uint16_t bytes_to_process = PIOS_COM_ReceiveRegion(inputPort, &region, MAX_PORT_DELAY);
             if (bytes_to_process > 0) {
-                for (uint8_t i = 0; i < bytes_to_process; i++) {
-                    ProcessTelemetryStream(data->telemUAVTalkCon, data->radioUAVTalkCon, serial_data[i]);
-                }
+                ProcessTelemetryStream(data->telemUAVTalkCon, data->radioUAVTalkCon, region, bytes_to_process);
+                PIOS_COM_ReleaseRegion(inputPort, bytes_to_process);
             }
         } else {
             vTaskDelay(5);
@@ -508,25 +496,44 @@ static void serialRxTask(__attribute__((unused)) void *parameters)
         PIOS_WDG_UpdateFlag(PIOS_WDG_SERIALRX);
 #endif
         if (inputPort && PIOS_COM_RADIO) {
-            // Receive some data.
-            uint16_t bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, data->serialRxBuf, sizeof(data->serialRxBuf), MAX_PORT_DELAY);
-
-            if (bytes_to_process > 0) {
-                // Send the data over the radio link.
-                // Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
-                // It is the caller responsibility to retry in such cases...
-                int32_t ret   = -2;
-                uint8_t count = 5;
-                while (count-- > 0 && ret < -1) {
-                    ret = PIOS_COM_SendBufferNonBlocking(PIOS_COM_RADIO, data->serialRxBuf, bytes_to_process);
-                }
-            }
+            // Send the data over the radio link.
+            ForwardStream(inputPort, PIOS_COM_RADIO);
         } else {
             vTaskDelay(5);
         }
     }
 }
 
+/**
+ * @brief Forward the bytes received on a port to another one.
+ * The bytes are sent straight from the input port buffer and dropped if the output does not take them.
+ *
+ * @param[in] inputPort  The port to read from
+ * @param[in] outputPort  The port to send to, 0 to drop the bytes
+ */
+static void ForwardStream(uint32_t inputPort, uint32_t outputPort)
+{
+    uint8_t *region;
+    uint16_t bytes_to_process = PIOS_COM_ReceiveRegion(inputPort, &region, MAX_PORT_DELAY);
+
+    if (bytes_to_process > 0) {
+        // Keep the chunks small enough to fit in the output buffer
+        if (bytes_to_process > FORWARD_CHUNK_LEN) {
+            bytes_to_process = FORWARD_CHUNK_LEN;
+        }
+        if (outputPort) {
+            // Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
+            // It is the caller responsibility to retry in such cases...
+            int32_t ret   = -2;
+            uint8_t count = 5;
+            while (count-- > 0 && ret < -1) {
+                ret = PIOS_COM_SendBufferNonBlocking(outputPort, region, bytes_to_process);
+            }
+        }
+        PIOS_COM_ReleaseRegion(inputPort, bytes_to_process);
+    }
+}
+
 /**
  * @brief Transmit data buffer to the com port.
  *
@@ -591,18 +598,22 @@ static int32_t RadioSendHandler(uint8_t *buf, int32_t length)
 }
 
 /**
- * @brief Process a byte of data received on the telemetry stream
+ * @brief Process the data received on the telemetry stream
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the telemetry port
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the radio port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] buf  The received bytes.
+ * @param[in] length  The number of received bytes.
  */
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte)
+static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t *buf, uint16_t length)
 {
-    // Keep reading until we receive a completed packet.
-    UAVTalkRxState state = UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
+    for (uint16_t pos = 0, used; pos < length; pos += used) {
+        // Keep reading until we receive a completed packet.
+        UAVTalkRxState state = UAVTalkProcessInputBufferQuiet(inConnectionHandle, &buf[pos], length - pos, &used);
 
-    if (state == UAVTALK_STATE_COMPLETE) {
+        if (state != UAVTALK_STATE_COMPLETE) {
+            continue;
+        }
         // We only want to unpack certain telemetry objects
         uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
         switch (objId) {
@@ -638,18 +649,22 @@ static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle, UAVTalk
 }
 
 /**
- * @brief Process a byte of data received on the radio data stream.
+ * @brief Process the data received on the radio data stream.
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the radio port.
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the telemetry port.
- * @param[in] rxbyte  The received byte.
+ * @param[in] buf  The received bytes.
+ * @param[in] length  The number of received bytes.
  */
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t rxbyte)
+static void ProcessRadioStream(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle, uint8_t *buf, uint16_t length)
 {
-    // Keep reading until we receive a completed packet.
-    UAVTalkRxState state = UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
+    for (uint16_t pos = 0, used; pos < length; pos += used) {
+        // Keep reading until we receive a completed packet.
+        UAVTalkRxState state = UAVTalkProcessInputBufferQuiet(inConnectionHandle, &buf[pos], length - pos, &used);
 
-    if (state == UAVTALK_STATE_COMPLETE) {
+        if (state != UAVTALK_STATE_COMPLETE) {
+            continue;
+        }
         // We only want to unpack certain objects from the remote modem
         // Similarly we only want to relay certain objects to the telemetry port
         uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
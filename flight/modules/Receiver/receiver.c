@@ -59,11 +59,14 @@
 #endif
 
 #define TASK_PRIORITY                    (tskIDLE_PRIORITY + 3) // 3 = flight control
+// also the longest wait for a frame from a receiver signalling them
 #define UPDATE_PERIOD_MS                 20
 #define THROTTLE_FAILSAFE                -0.1f
 #define ARMED_THRESHOLD                  0.50f
 // safe band to allow a bit of calibration error or trim offset (in microseconds)
 #define CONNECTION_OFFSET                250
+// time the input has to stay valid or invalid to change the connection status, the frame rate does not matter
+#define CONNECTION_HYSTERESIS_MS         (10 * UPDATE_PERIOD_MS)
 
 #define ASSISTEDCONTROL_DEADBAND_MINIMUM 0.02f // minimum value for a well bahaved Tx.
 
@@ -157,8 +160,8 @@ static void receiverTask(__attribute__((unused)) void *parameters)
     ManualControlCommandData cmd;
     FlightStatusData flightStatus;
 
-    uint8_t disconnected_count = 0;
-    uint8_t connected_count    = 0;
+    uint32_t disconnected_time = 0;
+    uint32_t connected_time    = 0;
 
     // For now manual instantiate extra instances of Accessory Desired.  In future should be done dynamically
     // this includes not even registering it if not used
@@ -176,13 +179,24 @@ static void receiverTask(__attribute__((unused)) void *parameters)
 
     // Main task loop
     lastSysTime = xTaskGetTickCount();
+    portTickType lastConnectionTime = lastSysTime;
 
     float scaledChannel[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM] = { 0 };
     SystemSettingsThrustControlOptions thrustType;
+    xSemaphoreHandle frameSemaphore = NULL;
 
     while (1) {
-        // Wait until next update
-        vTaskDelayUntil(&lastSysTime, UPDATE_PERIOD_MS / portTICK_RATE_MS);
+        // Wait for the next frame of the throttle receiver if it signals them, else until next update
+        if (frameSemaphore) {
+            xSemaphoreTake(frameSemaphore, UPDATE_PERIOD_MS / portTICK_RATE_MS);
+            lastSysTime = xTaskGetTickCount();
+        } else {
+            vTaskDelayUntil(&lastSysTime, UPDATE_PERIOD_MS / portTICK_RATE_MS);
+        }
+        // time since the last pass, only counted by the connection hysteresis of a pass that gets there
+        portTickType thisConnectionTime = xTaskGetTickCount();
+        uint32_t elapsed = (thisConnectionTime - lastConnectionTime) * portTICK_RATE_MS;
+        lastConnectionTime = thisConnectionTime;
 #ifdef PIOS_INCLUDE_WDG
         PIOS_WDG_UpdateFlag(PIOS_WDG_MANUAL);
 #endif
@@ -191,6 +205,13 @@ static void receiverTask(__attribute__((unused)) void *parameters)
         ManualControlSettingsGet(&settings);
         SystemSettingsThrustControlGet(&thrustType);
 
+        if (settings.ChannelGroups.Throttle < MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+            extern uint32_t pios_rcvr_group_map[];
+            frameSemaphore = PIOS_RCVR_GetSemaphore(pios_rcvr_group_map[settings.ChannelGroups.Throttle], settings.ChannelNumber.Throttle);
+        } else {
+            frameSemaphore = NULL;
+        }
+
         /* Update channel activity monitor */
         if (flightStatus.Armed == FLIGHTSTATUS_ARMED_DISARMED) {
             if (updateRcvrActivity(&activity_fsm)) {
@@ -242,6 +263,7 @@ static void receiverTask(__attribute__((unused)) void *parameters)
                                                 ManualControlSettingsChannelNeutralToArray(settings.ChannelNeutral)[n]);
             }
         }
+        PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_FRAME, PIOS_LATENCYPROBE_RECEIVER);
 
         // Check settings, if error raise alarm
         if (settings.ChannelGroups.Roll >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE
@@ -310,14 +332,14 @@ static void receiverTask(__attribute__((unused)) void *parameters)
         }
 
         // Implement hysteresis loop on connection status
-        if (valid_input_detected && (++connected_count > 10)) {
-            cmd.Connected      = MANUALCONTROLCOMMAND_CONNECTED_TRUE;
-            connected_count    = 0;
-            disconnected_count = 0;
-        } else if (!valid_input_detected && (++disconnected_count > 10)) {
-            cmd.Connected      = MANUALCONTROLCOMMAND_CONNECTED_FALSE;
-            connected_count    = 0;
-            disconnected_count = 0;
+        if (valid_input_detected && ((connected_time += elapsed) > CONNECTION_HYSTERESIS_MS)) {
+            cmd.Connected     = MANUALCONTROLCOMMAND_CONNECTED_TRUE;
+            connected_time    = 0;
+            disconnected_time = 0;
+        } else if (!valid_input_detected && ((disconnected_time += elapsed) > CONNECTION_HYSTERESIS_MS)) {
+            cmd.Connected     = MANUALCONTROLCOMMAND_CONNECTED_FALSE;
+            connected_time    = 0;
+            disconnected_time = 0;
         }
 
         if (cmd.Connected == MANUALCONTROLCOMMAND_CONNECTED_FALSE) {
@@ -473,6 +495,7 @@ static void receiverTask(__attribute__((unused)) void *parameters)
 
         // Update cmd object
         ManualControlCommandSet(&cmd);
+        PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_RECEIVER, PIOS_LATENCYPROBE_MANUALCONTROLCOMMAND);
 
 
 #if defined(PIOS_INCLUDE_USB_RCTX)
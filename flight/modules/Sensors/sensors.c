@@ -30,10 +30,12 @@
  */
 
 /**
- * Input objects: None, takes sensor data via pios
+ * Input objects: None, takes sensor data via pios, or @ref HITLSensors in HITL
  * Output objects: @ref GyroSensor @ref AccelSensor @ref MagSensor
  *
- * The module executes in its own thread.
+ * The module executes in its own thread, woken by the samples the gyro/accel
+ * interrupt queues. Polled sensors (mag, baro) are serviced at their own rates
+ * by a low priority callback, woken early by their data ready interrupt.
  *
  * UAVObjects are automatically generated by the UAVObjectGenerator from
  * the object definition XML file.
@@ -54,6 +56,11 @@
 #include <gyrosensor.h>
 #include <barosensor.h>
 #include <flightstatus.h>
+#include <hitlsensors.h>
+#include <gpspositionsensor.h>
+#include <gpsvelocitysensor.h>
+#include <airspeedsensor.h>
+#include <actuatorcommand.h>
 
 #include <attitudesettings.h>
 #include <revocalibration.h>
@@ -62,6 +69,7 @@
 
 #include <mathmisc.h>
 #include <taskinfo.h>
+#include <callbackinfo.h>
 #include <pios_math.h>
 #include <pios_constants.h>
 #include <CoordinateConversions.h>
@@ -72,7 +80,13 @@
 #define STACK_SIZE_BYTES         1000
 #define TASK_PRIORITY            (tskIDLE_PRIORITY + 3)
 
+#define POLL_STACK_SIZE_BYTES    768
+#define POLL_CALLBACK_PRIORITY   CALLBACK_PRIORITY_LOW
+#define POLL_CBTASK_PRIORITY     CALLBACK_TASK_NAVIGATION
+#define MAX_POLLED_SENSORS       4
+
 #define MAX_SENSORS_PER_INSTANCE 2
+#define SENSOR_EVENT_QUEUE_SIZE  16 // callback events of a few samples until the event dispatcher gets to run
 #ifdef PIOS_INCLUDE_WDG
 #define RELOAD_WDG()   PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS)
 #define REGISTER_WDG() PIOS_WDG_RegisterFlag(PIOS_WDG_SENSORS)
@@ -82,6 +96,11 @@
 #endif
 
 static const TickType_t sensor_period_ticks = ((uint32_t)1000.0f / PIOS_SENSOR_RATE) / portTICK_RATE_MS;
+#define SENSOR_PERIOD_US         ((uint32_t)(1000000.0f / PIOS_SENSOR_RATE))
+// An update goes out with the first sample this close to its due time
+#define SENSOR_UPDATE_SLACK_US   (SENSOR_PERIOD_US / 4)
+// The primary sensor is reset after this many periods without a sample
+#define SENSOR_TIMEOUT_PERIODS   4
 
 // Interval in number of sample to recalculate temp bias
 #define TEMP_CALIB_INTERVAL      30
@@ -101,6 +120,9 @@ static const float temp_alpha_baro = TEMP_DT_BARO / (TEMP_DT_BARO + 1.0f / (2.0f
 
 
 #define ZERO_ROT_ANGLE           0.00001f
+
+// Board sensors are muted until this long after the last HITLSensors packet
+#define HITL_TIMEOUT_MS          200
 // Private types
 typedef struct {
     // used to accumulate all samples in a task iteration
@@ -115,6 +137,13 @@ typedef union {
     PIOS_SENSORS_1Axis_SensorsWithTemp sensorSample1Axis;
 } sensor_data;
 
+typedef struct {
+    const PIOS_SENSORS_Instance *sensor;
+    portTickType  period;
+    portTickType  next_poll;
+    volatile bool data_ready;
+} polled_sensor;
+
 #define PIOS_INSTRUMENT_MODULE
 #include <pios_instrumentation_helper.h>
 
@@ -127,7 +156,11 @@ PERF_DEFINE_COUNTER(counterSensorResets);
 
 // Private functions
 static void SensorsTask(void *parameters);
+static void pollSensorsCb(void);
+static bool sensorDataReady(const PIOS_SENSORS_Instance *sensor);
 static void settingsUpdatedCb(UAVObjEvent *objEv);
+static void hitlSensorsUpdatedCb(UAVObjEvent *objEv);
+static bool hitlActive(void);
 
 static void accumulateSamples(sensor_fetch_context *sensor_context, sensor_data *sample);
 static void processSamples3d(sensor_fetch_context *sensor_context, const PIOS_SENSORS_Instance *sensor);
@@ -147,6 +180,13 @@ static void updateBaroTempBias(float temperature);
 // Private variables
 static sensor_data *source_data;
 static xTaskHandle sensorsTaskHandle;
+
+// Polled sensors, the callback has its own buffers
+static polled_sensor polled_sensors[MAX_POLLED_SENSORS];
+static uint8_t polled_count;
+static DelayedCallbackInfo *pollCBInfo;
+static sensor_data *poll_source_data;
+static sensor_fetch_context poll_context;
 RevoCalibrationData cal;
 AccelGyroSettingsData agcal;
 
@@ -181,6 +221,10 @@ static uint8_t baro_temp_calibration_count = 0;
 
 static int8_t rotate = 0;
 
+static volatile bool hitl_active = false;
+static volatile portTickType hitl_last_packet;
+static uint32_t hitl_sim_time;
+
 /**
  * Initialise the module.  Called before the start function
  * \returns 0 on success or -1 if initialisation failed
@@ -196,6 +240,11 @@ int32_t SensorsInitialize(void)
     RevoSettingsInitialize();
     AttitudeSettingsInitialize();
     AccelGyroSettingsInitialize();
+    HITLSensorsInitialize();
+    GPSPositionSensorInitialize();
+    GPSVelocitySensorInitialize();
+    AirspeedSensorInitialize();
+    ActuatorCommandInitialize();
 
     rotate = 0;
 
@@ -203,6 +252,7 @@ int32_t SensorsInitialize(void)
     RevoCalibrationConnectCallback(&settingsUpdatedCb);
     AttitudeSettingsConnectCallback(&settingsUpdatedCb);
     AccelGyroSettingsConnectCallback(&settingsUpdatedCb);
+    HITLSensorsConnectCallback(&hitlSensorsUpdatedCb);
 
     return 0;
 }
@@ -213,6 +263,22 @@ int32_t SensorsInitialize(void)
  */
 int32_t SensorsStart(void)
 {
+    PIOS_SENSORS_Instance *sensor;
+
+    LL_FOREACH(PIOS_SENSORS_GetList(), sensor) {
+        if (sensor->driver->is_polled) {
+            PIOS_Assert(polled_count < MAX_POLLED_SENSORS);
+            polled_sensors[polled_count].sensor = sensor;
+            polled_sensors[polled_count].period = sensor->poll_period_ms ? MAX(sensor->poll_period_ms / portTICK_RATE_MS, 1) : sensor_period_ticks;
+            polled_count++;
+        }
+    }
+    if (polled_count) {
+        poll_source_data = (sensor_data *)pios_malloc(MAX_SENSOR_DATA_SIZE);
+        clearContext(&poll_context);
+        pollCBInfo = PIOS_CALLBACKSCHEDULER_Create(&pollSensorsCb, POLL_CALLBACK_PRIORITY, POLL_CBTASK_PRIORITY, CALLBACKINFO_RUNNING_SENSORSPOLL, POLL_STACK_SIZE_BYTES);
+    }
+
     // Start main task
     xTaskCreate(SensorsTask, "Sensors", STACK_SIZE_BYTES / 4, NULL, TASK_PRIORITY, &sensorsTaskHandle);
     PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_SENSORS, sensorsTaskHandle);
@@ -229,23 +295,27 @@ int32_t mag_test;
 
 
 /**
- * The sensor task.  This polls the gyros at 500 Hz and pumps that data to
- * stabilization and to the attitude loop
- *
+ * The sensor task. It is woken by the samples the primary sensor (the
+ * gyro/accel, with the higher sample rate) queues from its interrupt and
+ * pumps them to stabilization and to the attitude loop at PIOS_SENSOR_RATE.
  */
 
 uint32_t sensor_dt_us;
 static void SensorsTask(__attribute__((unused)) void *parameters)
 {
-    portTickType lastSysTime;
     sensor_fetch_context sensor_context;
+    sensor_fetch_context primary_context;
     bool error = false;
     const PIOS_SENSORS_Instance *sensors_list = PIOS_SENSORS_GetList();
+    const PIOS_SENSORS_Instance *primary = NULL;
     PIOS_SENSORS_Instance *sensor;
 
     AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
     settingsUpdatedCb(NULL);
 
+    // every sample raises gyro and accel events, keep them off the shared event queue
+    EventDispatcherCreateFastPath(SENSOR_EVENT_QUEUE_SIZE);
+
     // Performance counters
     PERF_INIT_COUNTER(counterAccelSamples, 0x53000001);
     PERF_INIT_COUNTER(counterAccelPeriod, 0x53000002);
@@ -260,6 +330,9 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
     LL_FOREACH((PIOS_SENSORS_Instance *)sensors_list, sensor) {
         sensors_test &= PIOS_SENSORS_Test(sensor);
         count++;
+        if (!primary && !sensor->driver->is_polled && (sensor->type & PIOS_SENSORS_TYPE_3AXIS_ACCEL)) {
+            primary = sensor;
+        }
     }
 
     PIOS_Assert(count);
@@ -271,64 +344,127 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
         }
     }
 
+    // Polled sensors run on their own from here
+    if (polled_count) {
+        portTickType now = xTaskGetTickCount();
+        for (uint8_t i = 0; i < polled_count; i++) {
+            polled_sensors[i].next_poll = now;
+        }
+        PIOS_SENSORS_SetDataReadyHandler(&sensorDataReady);
+        PIOS_CALLBACKSCHEDULER_Dispatch(pollCBInfo);
+    }
+
+    if (!primary) {
+        while (1) {
+            RELOAD_WDG();
+            vTaskDelay(sensor_period_ticks);
+        }
+    }
+
     // Main task loop
-    lastSysTime = xTaskGetTickCount();
+    const QueueHandle_t primary_queue = PIOS_SENSORS_GetQueue(primary);
     uint32_t reset_counter = 0;
+    uint32_t next_update   = PIOS_DELAY_GetuS();
 
+    clearContext(&primary_context);
+    clearContext(&sensor_context);
     while (1) {
-        // TODO: add timeouts to the sensor reads and set an error if the fail
-        if (error) {
-            RELOAD_WDG();
-            lastSysTime = xTaskGetTickCount();
-            vTaskDelayUntil(&lastSysTime, sensor_period_ticks);
+        if (xQueueReceive(primary_queue, (void *)source_data, SENSOR_TIMEOUT_PERIODS * sensor_period_ticks) != pdTRUE) {
+            PIOS_SENSOR_Reset(primary);
+            clearContext(&primary_context);
+            reset_counter++;
+            PERF_TRACK_VALUE(counterSensorResets, reset_counter);
             AlarmsSet(SYSTEMALARMS_ALARM_SENSORS, SYSTEMALARMS_ALARM_CRITICAL);
-            error = false;
-        } else {
-            AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
+            error = true;
+            RELOAD_WDG();
+            continue;
         }
+        accumulateSamples(&primary_context, source_data);
+
+        // Faster samples are averaged down to the sensor rate, the update goes
+        // out with the sample that completes it rather than at a fixed phase
+        uint32_t now = PIOS_DELAY_GetuS();
+        int32_t due  = (int32_t)(next_update - now);
+        if (due > (int32_t)SENSOR_UPDATE_SLACK_US) {
+            continue;
+        }
+        next_update = (due < -(int32_t)SENSOR_PERIOD_US) ? now + SENSOR_PERIOD_US : next_update + SENSOR_PERIOD_US;
 
+        processSamples3d(&primary_context, primary);
+        clearContext(&primary_context);
 
-        // reset the fetch context
-        clearContext(&sensor_context);
+        // Other queued sensors are drained along with the primary one
         LL_FOREACH((PIOS_SENSORS_Instance *)sensors_list, sensor) {
-            // we will wait on the sensor that's marked as primary( that means the sensor with higher sample rate)
-            bool is_primary = (sensor->type & PIOS_SENSORS_TYPE_3AXIS_ACCEL);
-
-            if (!sensor->driver->is_polled) {
-                const QueueHandle_t queue = PIOS_SENSORS_GetQueue(sensor);
-                while (xQueueReceive(queue,
-                                     (void *)source_data,
-                                     (is_primary && !sensor_context.count) ? sensor_period_ticks : 0) == pdTRUE) {
-                    accumulateSamples(&sensor_context, source_data);
-                }
-                if (sensor_context.count) {
-                    processSamples3d(&sensor_context, sensor);
-                    clearContext(&sensor_context);
-                } else if (is_primary) {
-                    PIOS_SENSOR_Reset(sensor);
-                    reset_counter++;
-                    PERF_TRACK_VALUE(counterSensorResets, reset_counter);
-                    error = true;
-                }
-            } else {
-                if (PIOS_SENSORS_Poll(sensor)) {
-                    PIOS_SENSOR_Fetch(sensor, (void *)source_data, MAX_SENSORS_PER_INSTANCE);
-                    if (sensor->type & PIOS_SENSORS_TYPE_3D) {
-                        accumulateSamples(&sensor_context, source_data);
-                        processSamples3d(&sensor_context, sensor);
-                    } else {
-                        processSamples1d(&source_data->sensorSample1Axis, sensor);
-                    }
-                    clearContext(&sensor_context);
-                }
+            if (sensor == primary || sensor->driver->is_polled) {
+                continue;
+            }
+            const QueueHandle_t queue = PIOS_SENSORS_GetQueue(sensor);
+            while (xQueueReceive(queue, (void *)source_data, 0) == pdTRUE) {
+                accumulateSamples(&sensor_context, source_data);
             }
+            if (sensor_context.count) {
+                processSamples3d(&sensor_context, sensor);
+                clearContext(&sensor_context);
+            }
+        }
+
+        if (error) {
+            AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
+            error = false;
         }
         PERF_MEASURE_PERIOD(counterSensorPeriod);
         RELOAD_WDG();
-        vTaskDelayUntil(&lastSysTime, sensor_period_ticks);
     }
 }
 
+/**
+ * Services the polled sensors that signalled data ready or are due, then
+ * sleeps until the next one is due
+ */
+static void pollSensorsCb(void)
+{
+    portTickType now  = xTaskGetTickCount();
+    portTickType wait = portMAX_DELAY;
+
+    for (uint8_t i = 0; i < polled_count; i++) {
+        polled_sensor *polled = &polled_sensors[i];
+
+        if (polled->data_ready || (int32_t)(now - polled->next_poll) >= 0) {
+            polled->data_ready = false;
+            polled->next_poll  = now + polled->period;
+            if (PIOS_SENSORS_Poll(polled->sensor)) {
+                PIOS_SENSOR_Fetch(polled->sensor, (void *)poll_source_data, MAX_SENSORS_PER_INSTANCE);
+                if (polled->sensor->type & PIOS_SENSORS_TYPE_3D) {
+                    accumulateSamples(&poll_context, poll_source_data);
+                    processSamples3d(&poll_context, polled->sensor);
+                    clearContext(&poll_context);
+                } else {
+                    processSamples1d(&poll_source_data->sensorSample1Axis, polled->sensor);
+                }
+            }
+        }
+        wait = MIN(wait, polled->next_poll - now);
+    }
+
+    PIOS_CALLBACKSCHEDULER_Schedule(pollCBInfo, wait * portTICK_RATE_MS, CALLBACK_UPDATEMODE_SOONER);
+}
+
+/**
+ * Data ready signal of a polled sensor, from its ISR
+ */
+static bool sensorDataReady(const PIOS_SENSORS_Instance *sensor)
+{
+    long woken = pdFALSE;
+
+    for (uint8_t i = 0; i < polled_count; i++) {
+        if (polled_sensors[i].sensor == sensor) {
+            polled_sensors[i].data_ready = true;
+        }
+    }
+    PIOS_CALLBACKSCHEDULER_DispatchFromISR(pollCBInfo, &woken);
+    return woken == pdTRUE;
+}
+
 static void clearContext(sensor_fetch_context *sensor_context)
 {
     // clear the context once it has finished
@@ -358,6 +494,9 @@ static void processSamples3d(sensor_fetch_context *sensor_context, const PIOS_SE
     float temperature;
     float scales[MAX_SENSORS_PER_INSTANCE];
 
+    if (hitlActive()) {
+        return;
+    }
     PIOS_SENSORS_GetScales(sensor, scales, MAX_SENSORS_PER_INSTANCE);
     float inv_count = 1.0f / (float)sensor_context->count;
     if ((sensor->type & PIOS_SENSORS_TYPE_3AXIS_ACCEL) ||
@@ -395,6 +534,9 @@ static void processSamples3d(sensor_fetch_context *sensor_context, const PIOS_SE
 
 static void processSamples1d(PIOS_SENSORS_1Axis_SensorsWithTemp *sample, const PIOS_SENSORS_Instance *sensor)
 {
+    if (hitlActive()) {
+        return;
+    }
     switch (sensor->type) {
     case PIOS_SENSORS_TYPE_1AXIS_BARO:
         PERF_MEASURE_PERIOD(counterBaroPeriod);
@@ -475,6 +617,88 @@ static void handleBaro(float sample, float temperature)
     }
 }
 
+static bool hitlActive(void)
+{
+    if (hitl_active && (xTaskGetTickCount() - hitl_last_packet) > HITL_TIMEOUT_MS / portTICK_RATE_MS) {
+        hitl_active = false;
+    }
+    return hitl_active;
+}
+
+/**
+ * Publish a HITLSensors packet as if the board sensors had produced it,
+ * then send the actuator outputs back right away.
+ */
+static void hitlSensorsUpdatedCb(__attribute__((unused)) UAVObjEvent *objEv)
+{
+    HITLSensorsData hitl;
+
+    HITLSensorsGet(&hitl);
+
+    // Packets are not acked and may come out of order, keep the sim time moving forward
+    if (hitlActive() && (int32_t)(hitl.SimTime - hitl_sim_time) <= 0) {
+        return;
+    }
+    hitl_sim_time    = hitl.SimTime;
+    hitl_last_packet = xTaskGetTickCount();
+    hitl_active = true;
+
+    if (hitl.Updated.Accel == HITLSENSORS_UPDATED_TRUE) {
+        AccelSensorData accel;
+        accel.x = hitl.Accel.x;
+        accel.y = hitl.Accel.y;
+        accel.z = hitl.Accel.z;
+        accel.temperature = hitl.Temperature;
+        AccelSensorSet(&accel);
+    }
+    if (hitl.Updated.Gyro == HITLSENSORS_UPDATED_TRUE) {
+        GyroSensorData gyro;
+        gyro.x = hitl.Gyro.x;
+        gyro.y = hitl.Gyro.y;
+        gyro.z = hitl.Gyro.z;
+        gyro.temperature = hitl.Temperature;
+        GyroSensorSet(&gyro);
+    }
+    if (hitl.Updated.Baro == HITLSENSORS_UPDATED_TRUE) {
+        BaroSensorData baro;
+        baro.Altitude    = hitl.BaroAltitude;
+        baro.Temperature = hitl.Temperature;
+        baro.Pressure    = hitl.BaroPressure;
+        BaroSensorSet(&baro);
+    }
+    if (hitl.Updated.GPS == HITLSENSORS_UPDATED_TRUE) {
+        GPSPositionSensorData gpsPos;
+        GPSPositionSensorGet(&gpsPos);
+        gpsPos.Latitude    = hitl.Latitude;
+        gpsPos.Longitude   = hitl.Longitude;
+        gpsPos.Altitude    = hitl.Altitude;
+        gpsPos.Groundspeed = hitl.Groundspeed;
+        gpsPos.Heading     = hitl.Heading;
+        gpsPos.GeoidSeparation = 0.0f;
+        gpsPos.PDOP       = 3.0f;
+        gpsPos.VDOP       = 4.5f;
+        gpsPos.Satellites = 10;
+        gpsPos.Status     = GPSPOSITIONSENSOR_STATUS_FIX3D;
+        GPSPositionSensorSet(&gpsPos);
+
+        GPSVelocitySensorData gpsVel;
+        gpsVel.North = hitl.VelocityNED.North;
+        gpsVel.East  = hitl.VelocityNED.East;
+        gpsVel.Down  = hitl.VelocityNED.Down;
+        GPSVelocitySensorSet(&gpsVel);
+    }
+    if (hitl.Updated.Airspeed == HITLSENSORS_UPDATED_TRUE) {
+        AirspeedSensorData airspeed;
+        AirspeedSensorGet(&airspeed);
+        airspeed.SensorConnected    = AIRSPEEDSENSOR_SENSORCONNECTED_TRUE;
+        airspeed.CalibratedAirspeed = hitl.CalibratedAirspeed;
+        airspeed.TrueAirspeed = hitl.TrueAirspeed;
+        AirspeedSensorSet(&airspeed);
+    }
+
+    ActuatorCommandUpdated();
+}
+
 static void updateAccelTempBias(float temperature)
 {
     if (isnan(accel_temperature)) {
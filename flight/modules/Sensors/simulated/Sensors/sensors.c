@@ -69,6 +69,7 @@
 #include "taskinfo.h"
 
 #include "CoordinateConversions.h"
+#include "noise.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1540
@@ -88,8 +89,12 @@ static void simulateConstant();
 static void simulateModelAgnostic();
 static void simulateModelQuadcopter();
 static void simulateModelAirplane();
+#if defined(PIOS_INCLUDE_SIM)
+static void simulateExternal(const struct pios_sim_sensors *sensors);
+#endif
 
 static float accel_bias[3];
+static struct NoiseGenerator noise;
 
 static float rand_gauss();
 
@@ -102,6 +107,11 @@ enum sensor_sim_type { CONSTANT, MODEL_AGNOSTIC, MODEL_QUADCOPTER, MODEL_AIRPLAN
  */
 int32_t SensorsInitialize(void)
 {
+#if defined(PIOS_INCLUDE_SIM)
+    NoiseSeed(&noise, PIOS_SIM_GetSeed());
+#else
+    NoiseSeed(&noise, 1);
+#endif
     accel_bias[0] = rand_gauss() / 10;
     accel_bias[1] = rand_gauss() / 10;
     accel_bias[2] = rand_gauss() / 10;
@@ -194,6 +204,16 @@ static void SensorsTask(__attribute__((unused)) void *parameters)
 
         sensors_count++;
 
+#if defined(PIOS_INCLUDE_SIM)
+        // A lockstep simulator that sends its own sensor values replaces the models
+        struct pios_sim_sensors simSensors;
+        if (PIOS_SIM_GetSensors(&simSensors)) {
+            simulateExternal(&simSensors);
+            vTaskDelay(SENSOR_PERIOD / portTICK_RATE_MS);
+            continue;
+        }
+#endif
+
         switch (sensor_sim_type) {
         case CONSTANT:
             simulateConstant();
@@ -259,6 +279,39 @@ static void simulateConstant()
     MagSensorSet(&mag);
 }
 
+#if defined(PIOS_INCLUDE_SIM)
+static void simulateExternal(const struct pios_sim_sensors *sensors)
+{
+    AccelSensorData accelSensorData;
+
+    accelSensorData.x = sensors->accel[0];
+    accelSensorData.y = sensors->accel[1];
+    accelSensorData.z = sensors->accel[2];
+    accelSensorData.temperature = sensors->temperature;
+    AccelSensorSet(&accelSensorData);
+
+    GyroSensorData gyroSensorData;
+    gyroSensorData.x = sensors->gyro[0];
+    gyroSensorData.y = sensors->gyro[1];
+    gyroSensorData.z = sensors->gyro[2];
+    gyroSensorData.temperature = sensors->temperature;
+    GyroSensorSet(&gyroSensorData);
+
+    MagSensorData mag;
+    mag.x = sensors->mag[0];
+    mag.y = sensors->mag[1];
+    mag.z = sensors->mag[2];
+    mag.temperature = sensors->temperature;
+    MagSensorSet(&mag);
+
+    BaroSensorData baroSensor;
+    BaroSensorGet(&baroSensor);
+    baroSensor.Altitude    = sensors->altitude;
+    baroSensor.Temperature = sensors->temperature;
+    BaroSensorSet(&baroSensor);
+}
+#endif /* if defined(PIOS_INCLUDE_SIM) */
+
 static void simulateModelAgnostic()
 {
     float Rbe[3][3];
@@ -837,20 +890,7 @@ static void simulateModelAirplane()
 
 static float rand_gauss(void)
 {
-    float v1, v2, s;
-
-    do {
-        v1 = 2.0 * ((float)rand() / RAND_MAX) - 1;
-        v2 = 2.0 * ((float)rand() / RAND_MAX) - 1;
-
-        s  = v1 * v1 + v2 * v2;
-    } while (s >= 1.0);
-
-    if (s == 0.0) {
-        return 0.0;
-    } else {
-        return v1 * sqrt(-2.0 * log(s) / s);
-    }
+    return NoiseGauss(&noise);
 }
 
 
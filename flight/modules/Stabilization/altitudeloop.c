@@ -47,7 +47,6 @@
 #define UPDATE_MAX        1.0f
 #define UPDATE_ALPHA      1.0e-2f
 
-#define CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
 #define CBTASK_PRIORITY   CALLBACK_TASK_FLIGHTCONTROL
 
 #define STACK_SIZE_BYTES  512
@@ -62,6 +61,8 @@ static PiOSDeltatimeConfig timeval;
 static float thrustSetpoint = 0.0f;
 static float thrustDemand   = 0.0f;
 static float startThrust    = 0.5f;
+static uint32_t loopPeriodUs;
+static uint32_t nextDispatchUs;
 
 
 // Private functions
@@ -132,10 +133,24 @@ void stabilizationAltitudeloopInit()
     PositionStateInitialize();
     VelocityStateInitialize();
 
-    PIOS_DELTATIME_Init(&timeval, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
-    // Create object queue
+    // The callback priority is only read at startup, the default is the one of the
+    // outer loop so the thrust it reads is at most one run old
+    uint8_t loopPriority;
+    DelayedCallbackPriority priority;
+    AltitudeHoldSettingsLoopPriorityGet(&loopPriority);
+    switch (loopPriority) {
+    case ALTITUDEHOLDSETTINGS_LOOPPRIORITY_CRITICAL:
+        priority = CALLBACK_PRIORITY_CRITICAL;
+        break;
+    case ALTITUDEHOLDSETTINGS_LOOPPRIORITY_LOW:
+        priority = CALLBACK_PRIORITY_LOW;
+        break;
+    default:
+        priority = CALLBACK_PRIORITY_REGULAR;
+        break;
+    }
 
-    altitudeHoldCBInfo = PIOS_CALLBACKSCHEDULER_Create(&altitudeHoldTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_ALTITUDEHOLD, STACK_SIZE_BYTES);
+    altitudeHoldCBInfo = PIOS_CALLBACKSCHEDULER_Create(&altitudeHoldTask, priority, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_ALTITUDEHOLD, STACK_SIZE_BYTES);
     AltitudeHoldSettingsConnectCallback(&SettingsUpdatedCb);
     VelocityStateConnectCallback(&VelocityStateUpdatedCb);
 
@@ -198,6 +213,13 @@ static void altitudeHoldTask(void)
 static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     AltitudeHoldSettingsGet(&altitudeHoldSettings);
+    if (altitudeHoldSettings.LoopRate > 0) {
+        loopPeriodUs = 1000000 / altitudeHoldSettings.LoopRate;
+        PIOS_DELTATIME_Init(&timeval, 1.0f / altitudeHoldSettings.LoopRate, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
+    } else {
+        loopPeriodUs = 0;
+        PIOS_DELTATIME_Init(&timeval, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
+    }
     pid_configure(&pid0, altitudeHoldSettings.AltitudePI.Kp, altitudeHoldSettings.AltitudePI.Ki, 0, altitudeHoldSettings.AltitudePI.Ilimit);
     pid_zero(&pid0);
     pid_configure(&pid1, altitudeHoldSettings.VelocityPI.Kp, altitudeHoldSettings.VelocityPI.Ki, 0, altitudeHoldSettings.VelocityPI.Ilimit);
@@ -206,6 +228,19 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 
 static void VelocityStateUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
+    // the estimate comes at sensor rate, the loops run at most at LoopRate, zero is every estimate
+    if (loopPeriodUs) {
+        uint32_t now = PIOS_DELAY_GetuS();
+        // on the grid of the period, with a quarter of it of slack for the jitter of the estimates
+        if ((int32_t)(now - nextDispatchUs) < -(int32_t)(loopPeriodUs / 4)) {
+            return;
+        }
+        // restart the grid after a pause rather than catching up
+        if ((int32_t)(now - nextDispatchUs) >= (int32_t)loopPeriodUs) {
+            nextDispatchUs = now;
+        }
+        nextDispatchUs += loopPeriodUs;
+    }
     PIOS_CALLBACKSCHEDULER_Dispatch(altitudeHoldCBInfo);
 }
 
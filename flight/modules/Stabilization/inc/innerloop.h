@@ -34,5 +34,6 @@
 #define INNERLOOP_H
 
 void stabilizationInnerloopInit();
+void stabilizationInnerloopTuneNotch(float center);
 
 #endif /* INNERLOOP_H */
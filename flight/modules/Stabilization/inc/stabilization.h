@@ -35,6 +35,7 @@
 
 #include <openpilot.h>
 #include <pid.h>
+#include <biquad.h>
 #include <stabilizationsettings.h>
 #include <stabilizationbank.h>
 
@@ -45,6 +46,13 @@ typedef struct {
     StabilizationSettingsData settings;
     StabilizationBankData     stabBank;
     float gyro_alpha;
+    // gyro filter bank compiled from the settings, restarted on the next sample after a change
+    struct biquad_bank gyroBank;
+    bool   gyroBankReset;
+    // bank stage of the dynamic notch or -1, retuned by the inner loop
+    int8_t gyroNotchStage;
+    float  gyroNotchCenter;
+    float  gyroNotchRequest;
     struct {
         float min_thrust;
         float max_thrust;
@@ -59,8 +67,16 @@ typedef struct {
     }     monitor;
     float rattitude_mode_transition_stick_position;
     struct pid innerPids[3], outerPids[3];
-    // TPS [Roll,Pitch,Yaw][P,I,D]
-    bool  thrust_pid_scaling_enabled[3][3];
+    // inner loop per axis configuration, compiled from the bank whenever it changes
+    struct {
+        float maxRate;
+        float manualRateInv;
+        // TPS weight [P,I,D], 1.0 if scaled by the thrust curve else 0.0
+        float tps[3];
+    }      innerAxis[3];
+    // TPS curve, only evaluated if enabled for any axis
+    bool   thrust_pid_scaling_enabled;
+    pointf thrust_pid_scaling_curve[5];
 } StabilizationData;
 
 
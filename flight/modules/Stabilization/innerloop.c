@@ -39,6 +39,7 @@
 #include <actuatordesired.h>
 #include <gyrostate.h>
 #include <airspeedstate.h>
+#include <vibrationanalysisoutput.h>
 #include <stabilizationstatus.h>
 #include <flightstatus.h>
 #include <manualcontrolcommand.h>
@@ -47,6 +48,7 @@
 #include <actuatordesired.h>
 
 #include <stabilization.h>
+#include <innerloop.h>
 #include <virtualflybar.h>
 #include <cruisecontrol.h>
 
@@ -72,6 +74,7 @@ static void stabilizationInnerloopTask();
 static void GyroStateUpdatedCb(__attribute__((unused)) UAVObjEvent *ev);
 #ifdef REVOLUTION
 static void AirSpeedUpdatedCb(__attribute__((unused)) UAVObjEvent *ev);
+static void VibrationAnalysisOutputUpdatedCb(__attribute__((unused)) UAVObjEvent *ev);
 #endif
 
 void stabilizationInnerloopInit()
@@ -87,6 +90,8 @@ void stabilizationInnerloopInit()
 #ifdef REVOLUTION
     AirspeedStateInitialize();
     AirspeedStateConnectCallback(AirSpeedUpdatedCb);
+    VibrationAnalysisOutputInitialize();
+    VibrationAnalysisOutputConnectCallback(VibrationAnalysisOutputUpdatedCb);
 #endif
     PIOS_DELTATIME_Init(&timeval, UPDATE_EXPECTED, UPDATE_MIN, UPDATE_MAX, UPDATE_ALPHA);
 
@@ -123,51 +128,21 @@ static float get_pid_scale_source_value()
     return value;
 }
 
-typedef struct pid_curve_scaler {
-    float  x;
-    pointf points[5];
-} pid_curve_scaler;
-
-static float pid_curve_value(const pid_curve_scaler *scaler)
+static float get_pid_curve_value()
 {
-    float y = y_on_curve(scaler->x, scaler->points, sizeof(scaler->points) / sizeof(scaler->points[0]));
+    float y = y_on_curve(get_pid_scale_source_value(), stabSettings.thrust_pid_scaling_curve, 5);
 
-    return 1.0f + (IS_REAL(y) ? y : 0.0f);
+    return IS_REAL(y) ? y : 0.0f;
 }
 
-static pid_scaler create_pid_scaler(int axis)
+static inline pid_scaler create_pid_scaler(int axis, float curve_value)
 {
     pid_scaler scaler;
 
-    // Always scaled with the this.
-    scaler.p = scaler.i = scaler.d = speedScaleFactor;
-
-    if (stabSettings.thrust_pid_scaling_enabled[axis][0]
-        || stabSettings.thrust_pid_scaling_enabled[axis][1]
-        || stabSettings.thrust_pid_scaling_enabled[axis][2]) {
-        const pid_curve_scaler curve_scaler = {
-            .x      = get_pid_scale_source_value(),
-            .points = {
-                { 0.00f, stabSettings.stabBank.ThrustPIDScaleCurve[0] },
-                { 0.25f, stabSettings.stabBank.ThrustPIDScaleCurve[1] },
-                { 0.50f, stabSettings.stabBank.ThrustPIDScaleCurve[2] },
-                { 0.75f, stabSettings.stabBank.ThrustPIDScaleCurve[3] },
-                { 1.00f, stabSettings.stabBank.ThrustPIDScaleCurve[4] }
-            }
-        };
-
-        float curve_value = pid_curve_value(&curve_scaler);
-
-        if (stabSettings.thrust_pid_scaling_enabled[axis][0]) {
-            scaler.p *= curve_value;
-        }
-        if (stabSettings.thrust_pid_scaling_enabled[axis][1]) {
-            scaler.i *= curve_value;
-        }
-        if (stabSettings.thrust_pid_scaling_enabled[axis][2]) {
-            scaler.d *= curve_value;
-        }
-    }
+    // Always scaled with the speed scale factor, TPS weights are 0 for unscaled terms
+    scaler.p = speedScaleFactor * (1.0f + stabSettings.innerAxis[axis].tps[0] * curve_value);
+    scaler.i = speedScaleFactor * (1.0f + stabSettings.innerAxis[axis].tps[1] * curve_value);
+    scaler.d = speedScaleFactor * (1.0f + stabSettings.innerAxis[axis].tps[2] * curve_value);
 
     return scaler;
 }
@@ -232,6 +207,7 @@ static void stabilizationInnerloopTask()
     FlightStatusControlChainData cchain;
 
     RateDesiredGet(&rateDesired);
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_RATEDESIRED, PIOS_LATENCYPROBE_INNERLOOP);
     ActuatorDesiredGet(&actuator);
     StabilizationStatusInnerLoopGet(&enabled);
     FlightStatusControlChainGet(&cchain);
@@ -241,6 +217,9 @@ static void stabilizationInnerloopTask()
     float dT;
     dT = PIOS_DELTATIME_GetAverageSeconds(&timeval);
 
+    // TPS curve offset, once per cycle for all axes
+    float curve_value = stabSettings.thrust_pid_scaling_enabled ? get_pid_curve_value() : 0.0f;
+
     for (t = 0; t < AXES; t++) {
         bool reinit = (StabilizationStatusInnerLoopToArray(enabled)[t] != previous_mode[t]);
         previous_mode[t] = StabilizationStatusInnerLoopToArray(enabled)[t];
@@ -267,28 +246,19 @@ static void stabilizationInnerloopTask()
             // keep order as it is, RATE must follow!
             case STABILIZATIONSTATUS_INNERLOOP_RATE:
                 // limit rate to maximum configured limits (once here instead of 5 times in outer loop)
-                rate[t] = boundf(rate[t],
-                                 -StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t],
-                                 StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t]
-                                 );
-                pid_scaler scaler = create_pid_scaler(t);
+                rate[t] = boundf(rate[t], -stabSettings.innerAxis[t].maxRate, stabSettings.innerAxis[t].maxRate);
+                pid_scaler scaler = create_pid_scaler(t, curve_value);
                 actuatorDesiredAxis[t] = pid_apply_setpoint(&stabSettings.innerPids[t], &scaler, rate[t], gyro_filtered[t], dT);
                 break;
             case STABILIZATIONSTATUS_INNERLOOP_ACRO:
             {
-                float stickinput[3];
-                stickinput[0] = boundf(rate[0] / stabSettings.stabBank.ManualRate.Roll, -1.0f, 1.0f);
-                stickinput[1] = boundf(rate[1] / stabSettings.stabBank.ManualRate.Pitch, -1.0f, 1.0f);
-                stickinput[2] = boundf(rate[2] / stabSettings.stabBank.ManualRate.Yaw, -1.0f, 1.0f);
-                rate[t] = boundf(rate[t],
-                                 -StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t],
-                                 StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[t]
-                                 );
-                pid_scaler ascaler = create_pid_scaler(t);
-                ascaler.i *= boundf(1.0f - (1.5f * fabsf(stickinput[t])), 0.0f, 1.0f); // this prevents Integral from getting too high while controlled manually
+                float stickinput = boundf(rate[t] * stabSettings.innerAxis[t].manualRateInv, -1.0f, 1.0f);
+                rate[t] = boundf(rate[t], -stabSettings.innerAxis[t].maxRate, stabSettings.innerAxis[t].maxRate);
+                pid_scaler ascaler = create_pid_scaler(t, curve_value);
+                ascaler.i *= boundf(1.0f - (1.5f * fabsf(stickinput)), 0.0f, 1.0f); // this prevents Integral from getting too high while controlled manually
                 float arate  = pid_apply_setpoint(&stabSettings.innerPids[t], &ascaler, rate[t], gyro_filtered[t], dT);
-                float factor = fabsf(stickinput[t]) * stabSettings.stabBank.AcroInsanityFactor;
-                actuatorDesiredAxis[t] = factor * stickinput[t] + (1.0f - factor) * arate;
+                float factor = fabsf(stickinput) * stabSettings.stabBank.AcroInsanityFactor;
+                actuatorDesiredAxis[t] = factor * stickinput + (1.0f - factor) * arate;
             }
             break;
             case STABILIZATIONSTATUS_INNERLOOP_DIRECT:
@@ -315,6 +285,7 @@ static void stabilizationInnerloopTask()
 
     if (cchain.Stabilization == FLIGHTSTATUS_CONTROLCHAIN_TRUE) {
         ActuatorDesiredSet(&actuator);
+        PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_INNERLOOP, PIOS_LATENCYPROBE_ACTUATORDESIRED);
     } else {
         // Force all axes to reinitialize when engaged
         for (t = 0; t < AXES; t++) {
@@ -350,15 +321,36 @@ static void stabilizationInnerloopTask()
 }
 
 
+/**
+ * Move the dynamic gyro notch, clamped to GyroNotchRange.
+ * Ignored unless GyroNotchMode is Dynamic, applied on the next gyro sample.
+ */
+void stabilizationInnerloopTuneNotch(float center)
+{
+    stabSettings.gyroNotchRequest = boundf(center, stabSettings.settings.GyroNotchRange.Min, stabSettings.settings.GyroNotchRange.Max);
+}
+
 static void GyroStateUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
 {
     GyroStateData gyroState;
 
     GyroStateGet(&gyroState);
 
-    gyro_filtered[0] = gyro_filtered[0] * stabSettings.gyro_alpha + gyroState.x * (1 - stabSettings.gyro_alpha);
-    gyro_filtered[1] = gyro_filtered[1] * stabSettings.gyro_alpha + gyroState.y * (1 - stabSettings.gyro_alpha);
-    gyro_filtered[2] = gyro_filtered[2] * stabSettings.gyro_alpha + gyroState.z * (1 - stabSettings.gyro_alpha);
+    float gyro[3] = { gyroState.x, gyroState.y, gyroState.z };
+    if (stabSettings.gyroBankReset) {
+        biquad_bank_reset(&stabSettings.gyroBank, gyro);
+        stabSettings.gyroBankReset = false;
+    }
+    if (stabSettings.gyroNotchStage >= 0 && stabSettings.gyroNotchRequest != stabSettings.gyroNotchCenter) {
+        stabSettings.gyroNotchCenter = stabSettings.gyroNotchRequest;
+        biquad_notch(&stabSettings.gyroBank.stage[stabSettings.gyroNotchStage], PIOS_SENSOR_RATE,
+                     stabSettings.gyroNotchCenter, stabSettings.settings.GyroNotch.Bandwidth);
+    }
+    biquad_bank_apply(&stabSettings.gyroBank, gyro);
+
+    gyro_filtered[0] = gyro_filtered[0] * stabSettings.gyro_alpha + gyro[0] * (1 - stabSettings.gyro_alpha);
+    gyro_filtered[1] = gyro_filtered[1] * stabSettings.gyro_alpha + gyro[1] * (1 - stabSettings.gyro_alpha);
+    gyro_filtered[2] = gyro_filtered[2] * stabSettings.gyro_alpha + gyro[2] * (1 - stabSettings.gyro_alpha);
 
     PIOS_CALLBACKSCHEDULER_Dispatch(callbackHandle);
     stabSettings.monitor.gyroupdates++;
@@ -381,6 +373,17 @@ static void AirSpeedUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
                                   stabSettings.settings.ScaleToAirspeedLimits.Max);
     }
 }
+
+static void VibrationAnalysisOutputUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    float frequency;
+
+    // the analyzer publishes 0 while no resonance is strong enough to follow
+    VibrationAnalysisOutputNotchFrequencyGet(&frequency);
+    if (frequency > 0.0f) {
+        stabilizationInnerloopTuneNotch(frequency);
+    }
+}
 #endif
 
 /**
@@ -98,6 +98,7 @@ static void stabilizationOuterloopTask()
 
     AttitudeStateGet(&attitudeState);
     StabilizationDesiredGet(&stabilizationDesired);
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_STABILIZATIONDESIRED, PIOS_LATENCYPROBE_OUTERLOOP);
     RateDesiredGet(&rateDesired);
     StabilizationStatusOuterLoopGet(&enabled);
     float *stabilizationDesiredAxis = &stabilizationDesired.Roll;
@@ -263,6 +264,7 @@ static void stabilizationOuterloopTask()
     }
 
     RateDesiredSet(&rateDesired);
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_OUTERLOOP, PIOS_LATENCYPROBE_RATEDESIRED);
     {
         uint8_t armed;
         FlightStatusArmedGet(&armed);
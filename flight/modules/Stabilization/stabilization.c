@@ -330,12 +330,21 @@ static void BankUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
         use_tps_for_i(),
         use_tps_for_d()
     };
+    stabSettings.thrust_pid_scaling_enabled = false;
     for (int axis = 0; axis < 3; axis++) {
         for (int pid = 0; pid < 3; pid++) {
-            stabSettings.thrust_pid_scaling_enabled[axis][pid] = stabSettings.stabBank.EnableThrustPIDScaling
-                                                                 && tps_for_axis[axis]
-                                                                 && tps_for_pid[pid];
+            bool enabled = stabSettings.stabBank.EnableThrustPIDScaling
+                           && tps_for_axis[axis]
+                           && tps_for_pid[pid];
+            stabSettings.innerAxis[axis].tps[pid]   = enabled ? 1.0f : 0.0f;
+            stabSettings.thrust_pid_scaling_enabled |= enabled;
         }
+        stabSettings.innerAxis[axis].maxRate = StabilizationBankMaximumRateToArray(stabSettings.stabBank.MaximumRate)[axis];
+        stabSettings.innerAxis[axis].manualRateInv = 1.0f / StabilizationBankManualRateToArray(stabSettings.stabBank.ManualRate)[axis];
+    }
+    for (int i = 0; i < 5; i++) {
+        stabSettings.thrust_pid_scaling_curve[i].x = 0.25f * i;
+        stabSettings.thrust_pid_scaling_curve[i].y = stabSettings.stabBank.ThrustPIDScaleCurve[i];
     }
 }
 
@@ -360,6 +369,24 @@ static void SettingsUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
         stabSettings.gyro_alpha = expf(-fakeDt / stabSettings.settings.GyroTau);
     }
 
+    // Gyro filter bank, ahead of the first order filter above
+    biquad_bank_clear(&stabSettings.gyroBank);
+    stabSettings.gyroNotchStage = -1;
+    if (stabSettings.settings.GyroLowPassCutoff > 0.0f) {
+        biquad_bank_add_butterworth(&stabSettings.gyroBank, PIOS_SENSOR_RATE,
+                                    stabSettings.settings.GyroLowPassCutoff, stabSettings.settings.GyroLowPassOrder);
+    }
+    struct biquad_stage notch;
+    if (biquad_notch(&notch, PIOS_SENSOR_RATE, stabSettings.settings.GyroNotch.Center, stabSettings.settings.GyroNotch.Bandwidth)) {
+        int8_t stage = biquad_bank_add(&stabSettings.gyroBank, &notch);
+        if (stabSettings.settings.GyroNotchMode == STABILIZATIONSETTINGS_GYRONOTCHMODE_DYNAMIC) {
+            stabSettings.gyroNotchStage = stage;
+        }
+        stabSettings.gyroNotchCenter  = stabSettings.settings.GyroNotch.Center;
+        stabSettings.gyroNotchRequest = stabSettings.gyroNotchCenter;
+    }
+    stabSettings.gyroBankReset = true;
+
     // force flight mode update
     cur_flight_mode = -1;
 
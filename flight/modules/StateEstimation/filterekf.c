@@ -32,6 +32,8 @@
 
 #include "inc/stateestimation.h"
 
+#include <callbackinfo.h>
+
 #include <ekfconfiguration.h>
 #include <ekfstatevariance.h>
 #include <attitudestate.h>
@@ -48,6 +50,8 @@
 #define DT_MIN         1e-6f
 #define DT_MAX         1.0f
 #define DT_INIT        (1.0f / PIOS_SENSOR_RATE) // initialize with board sensor rate
+#define CORRECTION_CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
+#define CORRECTION_CBTASK_PRIORITY   CALLBACK_TASK_FLIGHTCONTROL // the state estimation task, so the EKF is never used concurrently
 
 #define IMPORT_SENSOR_IF_UPDATED(shortname, num) \
     if (IS_SET(state->updated, SENSORUPDATES_##shortname)) { \
@@ -58,6 +62,16 @@
     }
 
 // Private types
+struct correction {
+    uint16_t sensors;
+    float    mag[3];
+    float    pos[3];
+    float    vel[3];
+    float    baro;
+    float    posVar[3];
+    float    velVar[3];
+};
+
 struct data {
     EKFConfigurationData ekfConfiguration;
     HomeLocationData     homeLocation;
@@ -71,10 +85,19 @@ struct data {
     bool inited;
 
     PiOSDeltatimeConfig dtconfig;
+
+    // decimated covariance prediction
+    uint8_t covarianceSteps;
+    float   covarianceDT;
+
+    // correction waiting for the correction callback
+    struct correction pending;
 };
 
 // Private variables
 static bool initialized = 0;
+static DelayedCallbackInfo *correctionCallback;
+static struct data *correctionData;
 
 
 // Private functions
@@ -84,6 +107,11 @@ static int32_t init13(stateFilter *self);
 static int32_t maininit(stateFilter *self);
 static filterResult filter(stateFilter *self, stateEstimation *state);
 static inline bool invalid_var(float data);
+static void predictCovariance(struct data *this, float dT);
+static void flushCovariance(struct data *this);
+static void applyCorrection(struct data *this, struct correction *c);
+static void checkVariance(struct data *this);
+static void correctionCb(void);
 
 static void globalInit(void);
 
@@ -95,6 +123,7 @@ static void globalInit(void)
         EKFConfigurationInitialize();
         EKFStateVarianceInitialize();
         HomeLocationInitialize();
+        correctionCallback = PIOS_CALLBACKSCHEDULER_Create(&correctionCb, CORRECTION_CALLBACK_PRIORITY, CORRECTION_CBTASK_PRIORITY, CALLBACKINFO_RUNNING_EKFCORRECTION, STACK_REQUIRED);
     }
 }
 
@@ -158,6 +187,9 @@ static int32_t maininit(stateFilter *self)
     this->inited       = false;
     this->init_stage   = 0;
     this->work.updated = 0;
+    this->covarianceSteps = 0;
+    this->covarianceDT    = 0.0f;
+    this->pending.sensors = 0;
     PIOS_DELTATIME_Init(&this->dtconfig, DT_INIT, DT_MIN, DT_MAX, DT_ALPHA);
 
     EKFConfigurationGet(&this->ekfConfiguration);
@@ -178,6 +210,9 @@ static int32_t maininit(stateFilter *self)
             return 2;
         }
     }
+    if (this->ekfConfiguration.CovariancePredictionDecimation < 1) {
+        return 2;
+    }
     HomeLocationGet(&this->homeLocation);
     // Don't require HomeLocation.Set to be true but at least require a mag configuration (allows easily
     // switching between indoor and outdoor mode with Set = false)
@@ -354,7 +389,7 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
     state->updated |= SENSORUPDATES_attitude | SENSORUPDATES_pos | SENSORUPDATES_vel;
 
     // Advance the covariance estimate
-    INSCovariancePrediction(dT);
+    predictCovariance(this, dT);
 
     if (IS_SET(this->work.updated, SENSORUPDATES_mag)) {
         sensors |= MAG_SENSORS;
@@ -364,26 +399,19 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
         sensors |= BARO_SENSOR;
     }
 
-    INSSetMagNorth(this->homeLocation.Be);
-
+    struct correction c;
     if (!this->usePos) {
         // position and velocity variance used in indoor mode
-        INSSetPosVelVar((float[3]) { this->ekfConfiguration.FakeR.FakeGPSPosIndoor,
-                                     this->ekfConfiguration.FakeR.FakeGPSPosIndoor,
-                                     this->ekfConfiguration.FakeR.FakeGPSPosIndoor },
-                        (float[3]) { this->ekfConfiguration.FakeR.FakeGPSVelIndoor,
-                                     this->ekfConfiguration.FakeR.FakeGPSVelIndoor,
-                                     this->ekfConfiguration.FakeR.FakeGPSVelIndoor }
-                        );
+        c.posVar[0] = c.posVar[1] = c.posVar[2] = this->ekfConfiguration.FakeR.FakeGPSPosIndoor;
+        c.velVar[0] = c.velVar[1] = c.velVar[2] = this->ekfConfiguration.FakeR.FakeGPSVelIndoor;
     } else {
         // position and velocity variance used in outdoor mode
-        INSSetPosVelVar((float[3]) { this->ekfConfiguration.R.GPSPosNorth,
-                                     this->ekfConfiguration.R.GPSPosEast,
-                                     this->ekfConfiguration.R.GPSPosDown },
-                        (float[3]) { this->ekfConfiguration.R.GPSVelNorth,
-                                     this->ekfConfiguration.R.GPSVelEast,
-                                     this->ekfConfiguration.R.GPSVelDown }
-                        );
+        c.posVar[0] = this->ekfConfiguration.R.GPSPosNorth;
+        c.posVar[1] = this->ekfConfiguration.R.GPSPosEast;
+        c.posVar[2] = this->ekfConfiguration.R.GPSPosDown;
+        c.velVar[0] = this->ekfConfiguration.R.GPSVelNorth;
+        c.velVar[1] = this->ekfConfiguration.R.GPSVelEast;
+        c.velVar[2] = this->ekfConfiguration.R.GPSVelDown;
     }
 
     if (IS_SET(this->work.updated, SENSORUPDATES_pos)) {
@@ -397,13 +425,8 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
     if (IS_SET(this->work.updated, SENSORUPDATES_airspeed) && ((!IS_SET(this->work.updated, SENSORUPDATES_vel) && !IS_SET(this->work.updated, SENSORUPDATES_pos)) | !this->usePos)) {
         // HACK: feed airspeed into EKF as velocity, treat wind as 1e2 variance
         sensors |= HORIZ_SENSORS | VERT_SENSORS;
-        INSSetPosVelVar((float[3]) { this->ekfConfiguration.FakeR.FakeGPSPosIndoor,
-                                     this->ekfConfiguration.FakeR.FakeGPSPosIndoor,
-                                     this->ekfConfiguration.FakeR.FakeGPSPosIndoor },
-                        (float[3]) { this->ekfConfiguration.FakeR.FakeGPSVelAirspeed,
-                                     this->ekfConfiguration.FakeR.FakeGPSVelAirspeed,
-                                     this->ekfConfiguration.FakeR.FakeGPSVelAirspeed }
-                        );
+        c.posVar[0] = c.posVar[1] = c.posVar[2] = this->ekfConfiguration.FakeR.FakeGPSPosIndoor;
+        c.velVar[0] = c.velVar[1] = c.velVar[2] = this->ekfConfiguration.FakeR.FakeGPSVelAirspeed;
         // rotate airspeed vector into NED frame - airspeed is measured in X axis only
         float R[3][3];
         Quaternion2R(Nav.q, R);
@@ -416,10 +439,77 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
      * although probably should occur within INS itself
      */
     if (sensors) {
-        INSCorrection(this->work.mag, this->work.pos, this->work.vel, this->work.baro[0], sensors);
+        c.sensors = sensors;
+        memcpy(c.mag, this->work.mag, sizeof(c.mag));
+        memcpy(c.pos, this->work.pos, sizeof(c.pos));
+        memcpy(c.vel, this->work.vel, sizeof(c.vel));
+        c.baro = this->work.baro[0];
+        if (this->ekfConfiguration.DeferredCorrection == EKFCONFIGURATION_DEFERREDCORRECTION_TRUE && correctionCallback) {
+            // Corrections still waiting are merged, the latest measurements win
+            c.sensors     |= this->pending.sensors;
+            this->pending  = c;
+            correctionData = this;
+            PIOS_CALLBACKSCHEDULER_Dispatch(correctionCallback);
+        } else {
+            applyCorrection(this, &c);
+        }
+    } else {
+        checkVariance(this);
+    }
+
+    // all sensor data has been used, reset!
+    this->work.updated = 0;
+
+    if (this->init_stage < 0) {
+        return FILTERRESULT_WARNING;
+    } else {
+        return FILTERRESULT_OK;
+    }
+}
+
+/**
+ * Covariance prediction, run once every CovariancePredictionDecimation state predictions
+ * over the time elapsed since the previous covariance prediction
+ */
+static void predictCovariance(struct data *this, float dT)
+{
+    this->covarianceDT += dT;
+    if (++this->covarianceSteps >= this->ekfConfiguration.CovariancePredictionDecimation) {
+        flushCovariance(this);
     }
+}
+
+/**
+ * Bring the covariance up to date with the state, required before any correction
+ */
+static void flushCovariance(struct data *this)
+{
+    if (this->covarianceSteps > 0) {
+        INSCovariancePrediction(this->covarianceDT);
+        this->covarianceSteps = 0;
+        this->covarianceDT    = 0.0f;
+    }
+}
 
+/**
+ * Correct the EKF with the measurements
+ */
+static void applyCorrection(struct data *this, struct correction *c)
+{
+    flushCovariance(this);
+    INSSetMagNorth(this->homeLocation.Be);
+    INSSetPosVelVar(c->posVar, c->velVar);
+    INSCorrection(c->mag, c->pos, c->vel, c->baro, c->sensors);
+    checkVariance(this);
+}
+
+/**
+ * Publish the state variance and reset the covariance if it became invalid
+ */
+static void checkVariance(struct data *this)
+{
     EKFStateVarianceData vardata;
+
     EKFStateVarianceGet(&vardata);
     INSGetP(EKFStateVariancePToArray(vardata.P));
     EKFStateVarianceSet(&vardata);
@@ -431,14 +521,19 @@ static filterResult filter(stateFilter *self, stateEstimation *state)
             break;
         }
     }
+}
 
-    // all sensor data has been used, reset!
-    this->work.updated = 0;
+/**
+ * Deferred correction, runs in the state estimation task after the more urgent callbacks
+ */
+static void correctionCb(void)
+{
+    struct data *this = correctionData;
 
-    if (this->init_stage < 0) {
-        return FILTERRESULT_WARNING;
-    } else {
-        return FILTERRESULT_OK;
+    if (this && this->pending.sensors && this->inited) {
+        struct correction c = this->pending;
+        this->pending.sensors = 0;
+        applyCorrection(this, &c);
     }
 }
 
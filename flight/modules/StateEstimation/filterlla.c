@@ -45,7 +45,7 @@ struct data {
     GPSSettingsData  settings;
     HomeLocationData home;
     double HomeECEF[3];
-    float HomeRne[3][3];
+    LTPBase HomeLTP;
 };
 
 // Private variables
@@ -81,7 +81,8 @@ static int32_t init(__attribute__((unused)) stateFilter *self)
             (int32_t)(this->home.Altitude * 1e4f),
         };
         LLA2ECEF(LLAi, this->HomeECEF);
-        RneFromLLA(LLAi, this->HomeRne);
+        // positions within the radius are converted in single precision
+        LTPBaseFromLLA(LLAi, this->settings.LTPRadius, &this->HomeLTP);
     }
     return 0;
 }
@@ -111,7 +112,9 @@ static filterResult filter(__attribute__((unused)) stateFilter *self, stateEstim
                 gpsdata.Longitude,
                 (int32_t)((gpsdata.Altitude + gpsdata.GeoidSeparation) * 1e4f),
             };
-            LLA2Base(LLAi, this->HomeECEF, this->HomeRne, state->pos);
+            if (!LLA2LTP(&this->HomeLTP, LLAi, state->pos)) {
+                LLA2Base(LLAi, this->HomeECEF, this->HomeLTP.Rne, state->pos);
+            }
             state->updated |= SENSORUPDATES_pos;
         }
     }
@@ -61,6 +61,12 @@
 #define CALLBACK_PRIORITY       CALLBACK_PRIORITY_REGULAR
 #define TASK_PRIORITY           CALLBACK_TASK_FLIGHTCONTROL
 #define TIMEOUT_MS              10
+#define SLOW_CALLBACK_PRIORITY  CALLBACK_PRIORITY_LOW
+#define SLOW_TASK_PRIORITY      CALLBACK_TASK_FLIGHTCONTROL
+
+// sensors handled by the slow path when the filter chain is split, and the states it hands to the fast path
+#define SLOW_SENSORS            (SENSORUPDATES_boardMag | SENSORUPDATES_auxMag | SENSORUPDATES_vel | SENSORUPDATES_baro | SENSORUPDATES_airspeed | SENSORUPDATES_lla)
+#define SLOW_STATES             (SENSORUPDATES_mag | SENSORUPDATES_pos | SENSORUPDATES_vel | SENSORUPDATES_baro | SENSORUPDATES_airspeed)
 
 // Private filter init const
 #define FILTER_INIT_FORCE       -1
@@ -130,19 +136,32 @@
 // Private types
 struct filterPipelineStruct;
 
+// path of a filter when RevoSettings.FilterScheduling splits the chain
+typedef enum {
+    FILTERPATH_FAST = 0, // runs for every gyro and accel sample
+    FILTERPATH_SLOW = 1, // runs for mag, baro, airspeed and GPS updates in the lower priority callback
+} filterPath;
+
 typedef const struct filterPipelineStruct {
     const stateFilter *filter;
+    filterPath path;
     const struct filterPipelineStruct *next;
 } filterPipeline;
 
 // Private variables
 static DelayedCallbackInfo *stateEstimationCallback;
+static DelayedCallbackInfo *slowCallback;
 
 static volatile RevoSettingsData revoSettings;
 static volatile sensorUpdates updatedSensors;
+static volatile sensorUpdates updatedSlowSensors;
 static volatile int32_t fusionAlgorithm  = -1;
 static const filterPipeline *filterChain = NULL;
 
+// output of the slow path waiting for the next run of the fast path
+static stateEstimation slowStates;
+static filterResult slowAlarm = FILTERRESULT_OK;
+
 // different filters available to state estimation
 static stateFilter magFilter;
 static stateFilter baroFilter;
@@ -164,8 +183,10 @@ static float gyroDelta[3];
 // preconfigured filter chains selectable via revoSettings.FusionAlgorithm
 static const filterPipeline *cfQueue = &(filterPipeline) {
     .filter = &airFilter,
+    .path   = FILTERPATH_SLOW,
     .next   = &(filterPipeline) {
         .filter = &baroiFilter,
+        .path   = FILTERPATH_SLOW,
         .next   = &(filterPipeline) {
             .filter = &altitudeFilter,
             .next   = &(filterPipeline) {
@@ -177,10 +198,13 @@ static const filterPipeline *cfQueue = &(filterPipeline) {
 };
 static const filterPipeline *cfmiQueue = &(filterPipeline) {
     .filter = &magFilter,
+    .path   = FILTERPATH_SLOW,
     .next   = &(filterPipeline) {
         .filter = &airFilter,
+        .path   = FILTERPATH_SLOW,
         .next   = &(filterPipeline) {
             .filter = &baroiFilter,
+            .path   = FILTERPATH_SLOW,
             .next   = &(filterPipeline) {
                 .filter = &altitudeFilter,
                 .next   = &(filterPipeline) {
@@ -193,12 +217,16 @@ static const filterPipeline *cfmiQueue = &(filterPipeline) {
 };
 static const filterPipeline *cfmQueue = &(filterPipeline) {
     .filter = &magFilter,
+    .path   = FILTERPATH_SLOW,
     .next   = &(filterPipeline) {
         .filter = &airFilter,
+        .path   = FILTERPATH_SLOW,
         .next   = &(filterPipeline) {
             .filter = &llaFilter,
+            .path   = FILTERPATH_SLOW,
             .next   = &(filterPipeline) {
                 .filter = &baroFilter,
+                .path   = FILTERPATH_SLOW,
                 .next   = &(filterPipeline) {
                     .filter = &altitudeFilter,
                     .next   = &(filterPipeline) {
@@ -212,10 +240,13 @@ static const filterPipeline *cfmQueue = &(filterPipeline) {
 };
 static const filterPipeline *ekf13iQueue = &(filterPipeline) {
     .filter = &magFilter,
+    .path   = FILTERPATH_SLOW,
     .next   = &(filterPipeline) {
         .filter = &airFilter,
+        .path   = FILTERPATH_SLOW,
         .next   = &(filterPipeline) {
             .filter = &baroiFilter,
+            .path   = FILTERPATH_SLOW,
             .next   = &(filterPipeline) {
                 .filter = &stationaryFilter,
                 .next   = &(filterPipeline) {
@@ -232,12 +263,16 @@ static const filterPipeline *ekf13iQueue = &(filterPipeline) {
 
 static const filterPipeline *ekf13Queue = &(filterPipeline) {
     .filter = &magFilter,
+    .path   = FILTERPATH_SLOW,
     .next   = &(filterPipeline) {
         .filter = &airFilter,
+        .path   = FILTERPATH_SLOW,
         .next   = &(filterPipeline) {
             .filter = &llaFilter,
+            .path   = FILTERPATH_SLOW,
             .next   = &(filterPipeline) {
                 .filter = &baroFilter,
+                .path   = FILTERPATH_SLOW,
                 .next   = &(filterPipeline) {
                     .filter = &ekf13Filter,
                     .next   = &(filterPipeline) {
@@ -256,6 +291,9 @@ static void settingsUpdatedCb(UAVObjEvent *objEv);
 static void sensorUpdatedCb(UAVObjEvent *objEv);
 static void homeLocationUpdatedCb(UAVObjEvent *objEv);
 static void StateEstimationCb(void);
+static void StateEstimationSlowCb(void);
+static const filterPipeline *nextFilter(const filterPipeline *current, bool split, filterPath path);
+static void copyStates(stateEstimation *dst, const stateEstimation *src, sensorUpdates updated);
 
 static inline int32_t maxint32_t(int32_t a, int32_t b)
 {
@@ -319,6 +357,7 @@ int32_t StateEstimationInitialize(void)
     stack_required = maxint32_t(stack_required, filterEKF13Initialize(&ekf13Filter));
 
     stateEstimationCallback = PIOS_CALLBACKSCHEDULER_Create(&StateEstimationCb, CALLBACK_PRIORITY, TASK_PRIORITY, CALLBACKINFO_RUNNING_STATEESTIMATION, stack_required);
+    slowCallback = PIOS_CALLBACKSCHEDULER_Create(&StateEstimationSlowCb, SLOW_CALLBACK_PRIORITY, SLOW_TASK_PRIORITY, CALLBACKINFO_RUNNING_STATEESTIMATIONSLOW, stack_required);
 
     return 0;
 }
@@ -353,6 +392,7 @@ static void StateEstimationCb(void)
     static stateEstimation states;
     static uint32_t last_time;
     static uint16_t bootDelay = 64;
+    static bool split;
 
     // after system startup, first few sensor readings might be messed up, delay until everything has settled
     if (bootDelay) {
@@ -415,16 +455,24 @@ static void StateEstimationCb(void)
                     AlarmsSet(SYSTEMALARMS_ALARM_ATTITUDE, SYSTEMALARMS_ALARM_ERROR);
                     return;
                 } else {
-                    // set new fusion algortithm
-                    filterChain     = newFilterChain;
-                    fusionAlgorithm = revoSettings.FusionAlgorithm;
+                    // set new fusion algortithm, slow path results of the previous chain are dropped
+                    filterChain        = newFilterChain;
+                    fusionAlgorithm    = revoSettings.FusionAlgorithm;
+                    slowStates.updated = 0;
+                    slowAlarm          = FILTERRESULT_OK;
                 }
             }
         }
 
         // read updated sensor UAVObjects and set initial state
+        split = (revoSettings.FilterScheduling == REVOSETTINGS_FILTERSCHEDULING_SPLIT);
         states.updated = updatedSensors;
         updatedSensors = 0;
+        if (!split) {
+            // left over by the slow path after the scheduling changed
+            states.updated |= updatedSlowSensors;
+            updatedSlowSensors = 0;
+        }
 
         // fetch sensors, check values, and load into state struct
         FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(GyroSensor, gyro, x, y, z);
@@ -444,8 +492,19 @@ static void StateEstimationCb(void)
 
         // at this point sensor state is stored in "states" with some rudimentary filtering applied
 
-        // apply all filters in the current filter chain
-        current  = filterChain;
+        // merge the states the slow path filtered since the last run, both callbacks run in the same task
+        if (slowStates.updated) {
+            copyStates(&states, &slowStates, slowStates.updated);
+            states.updated    |= slowStates.updated;
+            slowStates.updated = 0;
+            if (slowAlarm > alarm) {
+                alarm = slowAlarm;
+            }
+            slowAlarm = FILTERRESULT_OK;
+        }
+
+        // apply all filters in the current filter chain, only those of the fast path if split
+        current  = nextFilter(filterChain, split, FILTERPATH_FAST);
 
         // we are not done, re-dispatch self execution
         runState = RUNSTATE_FILTER;
@@ -459,7 +518,7 @@ static void StateEstimationCb(void)
             if (result > alarm) {
                 alarm = result;
             }
-            current = current->next;
+            current = nextFilter(current->next, split, FILTERPATH_FAST);
         }
 
         // we are not done, re-dispatch self execution
@@ -552,6 +611,119 @@ static void StateEstimationCb(void)
 }
 
 
+/**
+ * Slow path callback, runs the mag, baro, airspeed and GPS filters of a split chain
+ * and hands their states to the fast path. Like the fast path it runs one filter
+ * per execution, so a waiting fast path is delayed by a single filter at most.
+ */
+static void StateEstimationSlowCb(void)
+{
+    static enum { RUNSTATE_LOAD = 0, RUNSTATE_FILTER = 1, RUNSTATE_SAVE = 2 } runState = RUNSTATE_LOAD;
+    static filterResult alarm = FILTERRESULT_OK;
+    static const filterPipeline *chain;
+    static const filterPipeline *current;
+    static stateEstimation states;
+
+    switch (runState) {
+    case RUNSTATE_LOAD:
+
+        // the chain is chosen and initialized by the fast path
+        if (filterChain == NULL) {
+            updatedSlowSensors = 0;
+            return;
+        }
+
+        alarm = FILTERRESULT_OK;
+        chain = filterChain;
+        states.updated     = updatedSlowSensors;
+        updatedSlowSensors = 0;
+
+        FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(MagSensor, boardMag, x, y, z);
+        FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(AuxMagSensor, auxMag, x, y, z);
+        FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_3_DIMENSIONS(GPSVelocitySensor, vel, North, East, Down);
+        FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_1_DIMENSION_WITH_CUSTOM_EXTRA_CHECK(BaroSensor, baro, Altitude, true);
+        FETCH_SENSOR_FROM_UAVOBJECT_CHECK_AND_LOAD_TO_STATE_2_DIMENSION_WITH_CUSTOM_EXTRA_CHECK(AirspeedSensor, airspeed, CalibratedAirspeed, TrueAirspeed, s.SensorConnected == AIRSPEEDSENSOR_SENSORCONNECTED_TRUE);
+
+        current  = nextFilter(chain, true, FILTERPATH_SLOW);
+        runState = RUNSTATE_FILTER;
+        PIOS_CALLBACKSCHEDULER_Dispatch(slowCallback);
+        break;
+
+    case RUNSTATE_FILTER:
+
+        // filters of a replaced chain have been initialized again, drop this update
+        if (chain != filterChain) {
+            current = NULL;
+        } else if (current != NULL) {
+            filterResult result = current->filter->filter((stateFilter *)current->filter, &states);
+            if (result > alarm) {
+                alarm = result;
+            }
+            current = nextFilter(current->next, true, FILTERPATH_SLOW);
+        }
+
+        if (!current) {
+            runState = RUNSTATE_SAVE;
+        }
+        PIOS_CALLBACKSCHEDULER_Dispatch(slowCallback);
+        break;
+
+    case RUNSTATE_SAVE:
+
+        // newer states replace those the fast path did not pick up yet
+        if (chain == filterChain) {
+            sensorUpdates updated = states.updated & SLOW_STATES;
+            copyStates(&slowStates, &states, updated);
+            slowStates.updated |= updated;
+            if (alarm > slowAlarm) {
+                slowAlarm = alarm;
+            }
+            PIOS_CALLBACKSCHEDULER_Dispatch(stateEstimationCallback);
+        }
+
+        runState = RUNSTATE_LOAD;
+        if (updatedSlowSensors) {
+            PIOS_CALLBACKSCHEDULER_Dispatch(slowCallback);
+        }
+        break;
+    }
+}
+
+/**
+ * Next filter of the chain on the given path, starting at current
+ * all filters are on the fast path unless the chain is split
+ */
+static const filterPipeline *nextFilter(const filterPipeline *current, bool split, filterPath path)
+{
+    while (split && current != NULL && current->path != path) {
+        current = current->next;
+    }
+    return current;
+}
+
+/**
+ * Copy the states of the given updates
+ */
+static void copyStates(stateEstimation *dst, const stateEstimation *src, sensorUpdates updated)
+{
+    if (IS_SET(updated, SENSORUPDATES_mag)) {
+        memcpy(dst->mag, src->mag, sizeof(dst->mag));
+        dst->magStatus = src->magStatus;
+    }
+    if (IS_SET(updated, SENSORUPDATES_pos)) {
+        memcpy(dst->pos, src->pos, sizeof(dst->pos));
+    }
+    if (IS_SET(updated, SENSORUPDATES_vel)) {
+        memcpy(dst->vel, src->vel, sizeof(dst->vel));
+    }
+    if (IS_SET(updated, SENSORUPDATES_baro)) {
+        memcpy(dst->baro, src->baro, sizeof(dst->baro));
+    }
+    if (IS_SET(updated, SENSORUPDATES_airspeed)) {
+        memcpy(dst->airspeed, src->airspeed, sizeof(dst->airspeed));
+    }
+}
+
 /**
  * Callback for eventdispatcher when RevoSettings has been updated
  */
@@ -577,12 +749,14 @@ static void homeLocationUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
  */
 static void sensorUpdatedCb(UAVObjEvent *ev)
 {
+    sensorUpdates updated = 0;
+
     if (!ev) {
         return;
     }
 
     if (ev->obj == GyroSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_gyro;
+        updated = SENSORUPDATES_gyro;
         // shortcut - update GyroState right away
         GyroSensorData s;
         GyroStateData t;
@@ -594,33 +768,41 @@ static void sensorUpdatedCb(UAVObjEvent *ev)
     }
 
     if (ev->obj == AccelSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_accel;
+        updated = SENSORUPDATES_accel;
     }
 
     if (ev->obj == MagSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_boardMag;
+        updated = SENSORUPDATES_boardMag;
     }
 
     if (ev->obj == AuxMagSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_auxMag;
+        updated = SENSORUPDATES_auxMag;
     }
 
     if (ev->obj == GPSPositionSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_lla;
+        updated = SENSORUPDATES_lla;
     }
 
     if (ev->obj == GPSVelocitySensorHandle()) {
-        updatedSensors |= SENSORUPDATES_vel;
+        updated = SENSORUPDATES_vel;
     }
 
     if (ev->obj == BaroSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_baro;
+        updated = SENSORUPDATES_baro;
     }
 
     if (ev->obj == AirspeedSensorHandle()) {
-        updatedSensors |= SENSORUPDATES_airspeed;
+        updated = SENSORUPDATES_airspeed;
+    }
+
+    // slow sensors of a split chain go to the slow path
+    if (revoSettings.FilterScheduling == REVOSETTINGS_FILTERSCHEDULING_SPLIT && (updated & SLOW_SENSORS)) {
+        updatedSlowSensors |= updated;
+        PIOS_CALLBACKSCHEDULER_Dispatch(slowCallback);
+        return;
     }
 
+    updatedSensors |= updated;
     PIOS_CALLBACKSCHEDULER_Dispatch(stateEstimationCallback);
 }
 
@@ -49,6 +49,7 @@
 
 // UAVOs
 #include <objectpersistence.h>
+#include <settingscrc.h>
 #include <flightstatus.h>
 #include <systemstats.h>
 #include <systemsettings.h>
@@ -56,6 +57,7 @@
 #include <taskinfo.h>
 #include <watchdogstatus.h>
 #include <callbackinfo.h>
+#include <flighttelemetrystats.h>
 #include <hwsettings.h>
 #include <pios_flashfs.h>
 #include <pios_notify.h>
@@ -65,6 +67,15 @@
 #include <pios_instrumentation.h>
 #endif
 
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+#include <memorystats.h>
+#include <memorypoolstats.h>
+#endif
+
+#ifdef PIOS_INCLUDE_INITCALL_PROFILE
+#include <bootprofile.h>
+#endif
+
 #if defined(PIOS_INCLUDE_RFM22B)
 #include <oplinkstatus.h>
 #endif
@@ -92,6 +103,15 @@
 
 #define TASK_PRIORITY           (tskIDLE_PRIORITY + 1)
 
+// Settings log is compacted once no save or delete happened for this many update periods
+#define COMPACT_DELAY_PERIODS   4
+
+// Tasks and callbacks sampled per update period. A full pass over all of them
+// then takes about as long as the default telemetry period of TaskInfo and CallbackInfo.
+#define DIAG_ITEMS_PER_UPDATE   1
+// A GCS asking for TaskInfo or CallbackInfo faster than this gets a full pass every update period
+#define DIAG_DEMANDED_PERIOD_MS 2000
+
 // Private types
 
 // Private variables
@@ -102,13 +122,24 @@ static bool mallocFailed;
 static HwSettingsData bootHwSettings;
 static FrameType_t bootFrameType;
 static struct PIOS_FLASHFS_Stats fsStats;
+static uint8_t compactDelay;
+#ifdef DIAG_TASKS
+static TaskInfoData taskInfoData;
+static CallbackInfoData callbackInfoData;
+static uint16_t diagCursor;
+static bool diagDemanded;
+#endif
 
 // Private functions
 static void objectUpdatedCb(UAVObjEvent *ev);
+static int32_t objectListOperation(ObjectPersistenceData *objper);
+static void settingsCRCRequest();
 static void checkSettingsUpdatedCb(UAVObjEvent *ev);
 #ifdef DIAG_TASKS
 static void taskMonitorForEachCallback(uint16_t task_id, const struct pios_task_info *task_info, void *context);
 static void callbackSchedulerForEachCallback(int16_t callback_id, const struct pios_callback_info *callback_info, void *context);
+static void updateDiagnostics();
+static bool diagnosticsDemanded();
 #endif
 static void updateStats();
 static void updateSystemAlarms();
@@ -117,6 +148,12 @@ static void systemTask(void *parameters);
 static void updateI2Cstats();
 static void updateWDGstats();
 #endif
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+static void updateMemoryStats();
+#endif
+#ifdef PIOS_INCLUDE_INITCALL_PROFILE
+static void publishBootProfile();
+#endif
 
 extern uintptr_t pios_uavo_settings_fs_id;
 extern uintptr_t pios_user_fs_id;
@@ -149,9 +186,11 @@ int32_t SystemModInitialize(void)
     SystemStatsInitialize();
     FlightStatusInitialize();
     ObjectPersistenceInitialize();
+    SettingsCRCInitialize();
 #ifdef DIAG_TASKS
     TaskInfoInitialize();
     CallbackInfoInitialize();
+    FlightTelemetryStatsInitialize();
 #endif
 #ifdef DIAG_I2C_WDG_STATS
     I2CStatsInitialize();
@@ -161,8 +200,16 @@ int32_t SystemModInitialize(void)
 #ifdef PIOS_INCLUDE_INSTRUMENTATION
     InstrumentationInit();
 #endif
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+    MemoryStatsInitialize();
+    MemoryPoolStatsInitialize();
+#endif
+#ifdef PIOS_INCLUDE_INITCALL_PROFILE
+    BootProfileInitialize();
+#endif
 
-    objectPersistenceQueue = xQueueCreate(1, sizeof(UAVObjEvent));
+    // Room for an ObjectPersistence and a SettingsCRC request at the same time
+    objectPersistenceQueue = xQueueCreate(2, sizeof(UAVObjEvent));
     if (objectPersistenceQueue == NULL) {
         return -1;
     }
@@ -181,6 +228,13 @@ static void systemTask(__attribute__((unused)) void *parameters)
     /* create all modules thread */
     MODULE_TASKCREATE_ALL;
 
+#ifdef PIOS_INCLUDE_INITCALL_PROFILE
+    publishBootProfile();
+#endif
+
+    /* load the settings no module has used yet, from here rather than on first use in a flight loop */
+    UAVObjLoadPendingSettings();
+
     /* start the delayed callback scheduler */
     PIOS_CALLBACKSCHEDULER_Start();
 
@@ -197,6 +251,7 @@ static void systemTask(__attribute__((unused)) void *parameters)
 #endif
     // Listen for SettingPersistance object updates, connect a callback function
     ObjectPersistenceConnectQueue(objectPersistenceQueue);
+    SettingsCRCConnectQueue(objectPersistenceQueue);
 
     // Load a copy of HwSetting active at boot time
     HwSettingsGet(&bootHwSettings);
@@ -205,10 +260,6 @@ static void systemTask(__attribute__((unused)) void *parameters)
     HwSettingsConnectCallback(checkSettingsUpdatedCb);
     SystemSettingsConnectCallback(checkSettingsUpdatedCb);
 
-#ifdef DIAG_TASKS
-    TaskInfoData taskInfoData;
-    CallbackInfoData callbackInfoData;
-#endif
     // Main system loop
     while (1) {
         NotificationUpdateStatus();
@@ -225,17 +276,14 @@ static void systemTask(__attribute__((unused)) void *parameters)
         InstrumentationPublishAllCounters();
 #endif
 
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+        updateMemoryStats();
+#endif
+
 #ifdef DIAG_TASKS
-        // Update the task status object
-        PIOS_TASK_MONITOR_ForEachTask(taskMonitorForEachCallback, &taskInfoData);
-        TaskInfoSet(&taskInfoData);
-        // Update the callback status object
-// if(FALSE){
-        PIOS_CALLBACKSCHEDULER_ForEachCallback(callbackSchedulerForEachCallback, &callbackInfoData);
-        CallbackInfoSet(&callbackInfoData);
-// }
+        // Update the task and callback status objects
+        updateDiagnostics();
 #endif
-// }
 
 
         UAVObjEvent ev;
@@ -266,12 +314,16 @@ static void systemTask(__attribute__((unused)) void *parameters)
             oplinkStatus.RxErrors = radio_stats.rx_error;
             oplinkStatus.RxMissed = radio_stats.rx_missed;
             oplinkStatus.RxFailure     = radio_stats.rx_failure;
+            oplinkStatus.RCGood   = radio_stats.rc_good;
+            oplinkStatus.RCLost   = radio_stats.rc_lost;
             oplinkStatus.TxDropped     = radio_stats.tx_dropped;
             oplinkStatus.TxFailure     = radio_stats.tx_failure;
             oplinkStatus.Resets      = radio_stats.resets;
             oplinkStatus.Timeouts    = radio_stats.timeouts;
             oplinkStatus.RSSI        = radio_stats.rssi;
             oplinkStatus.LinkQuality = radio_stats.link_quality;
+            oplinkStatus.AirDataRate = radio_stats.air_datarate;
+            oplinkStatus.FECParity   = radio_stats.fec_parity;
             if (first_time) {
                 first_time = false;
             } else {
@@ -295,6 +347,17 @@ static void systemTask(__attribute__((unused)) void *parameters)
 
 #endif /* if defined(PIOS_INCLUDE_RFM22B) */
 
+#if defined(PIOS_INCLUDE_FLASH_LOGFS_SETTINGS)
+        // Garbage collect the settings log while idle, so the next save doesn't have to
+        if (compactDelay && --compactDelay == 0) {
+            uint8_t armed;
+            FlightStatusArmedGet(&armed);
+            if (armed == FLIGHTSTATUS_ARMED_DISARMED) {
+                PIOS_FLASHFS_Compact(pios_uavo_settings_fs_id);
+            }
+        }
+#endif
+
         if (xQueueReceive(objectPersistenceQueue, &ev, delayTime) == pdTRUE) {
             // If object persistence is updated call the callback
             objectUpdatedCb(&ev);
@@ -340,6 +403,8 @@ static void objectUpdatedCb(UAVObjEvent *ev)
                 retval = UAVObjLoadSettings();
             } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
                 retval = UAVObjLoadMetaobjects();
+            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_OBJECTLIST) {
+                retval = objectListOperation(&objper);
             }
         } else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_SAVE) {
             if (objper.Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
@@ -362,6 +427,8 @@ static void objectUpdatedCb(UAVObjEvent *ev)
                 retval = UAVObjSaveSettings();
             } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
                 retval = UAVObjSaveMetaobjects();
+            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_OBJECTLIST) {
+                retval = objectListOperation(&objper);
             }
         } else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_DELETE) {
             if (objper.Selection == OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT) {
@@ -376,6 +443,8 @@ static void objectUpdatedCb(UAVObjEvent *ev)
                 retval = UAVObjDeleteSettings();
             } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLMETAOBJECTS || objper.Selection == OBJECTPERSISTENCE_SELECTION_ALLOBJECTS) {
                 retval = UAVObjDeleteMetaobjects();
+            } else if (objper.Selection == OBJECTPERSISTENCE_SELECTION_OBJECTLIST) {
+                retval = objectListOperation(&objper);
             }
         } else if (objper.Operation == OBJECTPERSISTENCE_OPERATION_FULLERASE) {
 #if defined(PIOS_INCLUDE_FLASH_LOGFS_SETTINGS)
@@ -386,6 +455,9 @@ static void objectUpdatedCb(UAVObjEvent *ev)
         }
         switch (retval) {
         case 0:
+            if (objper.Operation == OBJECTPERSISTENCE_OPERATION_SAVE || objper.Operation == OBJECTPERSISTENCE_OPERATION_DELETE) {
+                compactDelay = COMPACT_DELAY_PERIODS;
+            }
             objper.Operation = OBJECTPERSISTENCE_OPERATION_COMPLETED;
             ObjectPersistenceSet(&objper);
             break;
@@ -396,9 +468,31 @@ static void objectUpdatedCb(UAVObjEvent *ev)
         default:
             break;
         }
+    } else if (ev->obj == SettingsCRCHandle()) {
+        settingsCRCRequest();
     }
 }
 
+/**
+ * Answer a SettingsCRC request with the CRC32 of each object listed
+ */
+static void settingsCRCRequest()
+{
+    SettingsCRCData request;
+
+    SettingsCRCGet(&request);
+    // The answer comes back here too
+    if (request.Operation != SETTINGSCRC_OPERATION_REQUEST) {
+        return;
+    }
+    for (uint8_t i = 0; i < SETTINGSCRC_OBJECTIDS_NUMELEM; i++) {
+        UAVObjHandle obj = request.ObjectIDs[i] ? UAVObjGetByID(request.ObjectIDs[i]) : 0;
+        request.CRCs[i] = obj ? UAVObjUpdateCRC32(obj, 0, 0xFFFFFFFF) : 0;
+    }
+    request.Operation = SETTINGSCRC_OPERATION_COMPLETED;
+    SettingsCRCSet(&request);
+}
+
 /**
  * Called whenever hardware settings changed
  */
@@ -445,9 +539,135 @@ static void callbackSchedulerForEachCallback(int16_t callback_id, const struct p
     ((uint8_t *)&callbackData->Running)[callback_id] = callback_info->is_running;
     ((uint32_t *)&callbackData->RunningTime)[callback_id]   = callback_info->running_time_count;
     ((int16_t *)&callbackData->StackRemaining)[callback_id] = callback_info->stack_remaining;
+
+    // histograms are reported as percentage of all runs, PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS per callback
+    PIOS_DEBUG_Assert(CALLBACKINFO_RUNTIMEHISTOGRAM_NUMELEM == CALLBACKINFO_RUNNING_NUMELEM * PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS);
+    uint32_t runs = 0;
+    uint32_t dispatches = 0;
+    for (uint8_t b = 0; b < PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS; b++) {
+        runs += callback_info->run_time_histogram[b];
+        dispatches += callback_info->latency_histogram[b];
+    }
+    for (uint8_t b = 0; b < PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS; b++) {
+        uint16_t i = callback_id * PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS + b;
+        callbackData->RunTimeHistogram[i] = runs ? (uint8_t)(100.0f * callback_info->run_time_histogram[b] / runs + 0.5f) : 0;
+        callbackData->LatencyHistogram[i] = dispatches ? (uint8_t)(100.0f * callback_info->latency_histogram[b] / dispatches + 0.5f) : 0;
+    }
+}
+
+/**
+ * Sample the next few tasks and callbacks, a full pass takes several update periods
+ * unless diagnostics are demanded. TaskInfo is set once all tasks were sampled,
+ * CallbackInfo once all callbacks were.
+ */
+static void updateDiagnostics()
+{
+    uint16_t items = diagDemanded ? UINT16_MAX : DIAG_ITEMS_PER_UPDATE;
+
+    while (items--) {
+        if (diagCursor < TASKINFO_RUNNING_NUMELEM) {
+            struct pios_task_info task_info;
+            if (PIOS_TASK_MONITOR_GetTaskInfo(diagCursor, &task_info) == 0) {
+                taskMonitorForEachCallback(diagCursor, &task_info, &taskInfoData);
+            }
+            if (++diagCursor == TASKINFO_RUNNING_NUMELEM) {
+                TaskInfoSet(&taskInfoData);
+            }
+        } else {
+            struct pios_callback_info callback_info;
+            int16_t callback_id;
+            if (PIOS_CALLBACKSCHEDULER_GetCallbackInfo(diagCursor - TASKINFO_RUNNING_NUMELEM, &callback_id, &callback_info)) {
+                callbackSchedulerForEachCallback(callback_id, &callback_info, &callbackInfoData);
+                diagCursor++;
+            } else {
+                CallbackInfoSet(&callbackInfoData);
+                // at most one pass per update, the rate is decided again for the next one
+                diagCursor   = 0;
+                diagDemanded = diagnosticsDemanded();
+                return;
+            }
+        }
+    }
+}
+
+static bool diagnosticsObjectDemanded(UAVObjHandle obj)
+{
+    UAVObjMetadata metadata;
+
+    if (UAVObjGetMetadata(obj, &metadata) < 0) {
+        return false;
+    }
+    switch (UAVObjGetTelemetryUpdateMode(&metadata)) {
+    case UPDATEMODE_ONCHANGE:
+        return true;
+
+    case UPDATEMODE_PERIODIC:
+    case UPDATEMODE_THROTTLED:
+        return metadata.telemetryUpdatePeriod < DIAG_DEMANDED_PERIOD_MS;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * Diagnostics are demanded while a GCS is connected and has lowered the
+ * telemetry period of TaskInfo or CallbackInfo, as the profiler gadget does
+ */
+static bool diagnosticsDemanded()
+{
+    uint8_t status;
+
+    FlightTelemetryStatsStatusGet(&status);
+    if (status != FLIGHTTELEMETRYSTATS_STATUS_CONNECTED) {
+        return false;
+    }
+    return diagnosticsObjectDemanded(TaskInfoHandle()) || diagnosticsObjectDemanded(CallbackInfoHandle());
 }
 #endif /* ifdef DIAG_TASKS */
 
+/**
+ * Load, save or delete every object of an ObjectList request. Entries that
+ * failed are flagged in FailedObjects, bit n standing for ObjectIDs[n].
+ * Saved objects are read back the same way as a single object save.
+ * \return 0 if all the objects were processed, -1 otherwise
+ */
+static int32_t objectListOperation(ObjectPersistenceData *objper)
+{
+    int32_t retval = 0;
+
+    objper->FailedObjects = 0;
+    for (uint8_t i = 0; i < OBJECTPERSISTENCE_OBJECTIDS_NUMELEM && objper->ObjectIDs[i] != 0; i++) {
+        UAVObjHandle obj = UAVObjGetByID(objper->ObjectIDs[i]);
+        int32_t ret = -1;
+
+        if (obj != 0) {
+            switch (objper->Operation) {
+            case OBJECTPERSISTENCE_OPERATION_LOAD:
+                ret = UAVObjLoad(obj, objper->InstanceID);
+                break;
+            case OBJECTPERSISTENCE_OPERATION_SAVE:
+                ret = UAVObjSave(obj, objper->InstanceID);
+                vTaskDelay(10);
+                if (ret == 0) {
+                    ret = UAVObjLoad(obj, objper->InstanceID);
+                }
+                break;
+            case OBJECTPERSISTENCE_OPERATION_DELETE:
+                ret = UAVObjDelete(obj, objper->InstanceID);
+                break;
+            default:
+                break;
+            }
+        }
+        if (ret != 0) {
+            objper->FailedObjects |= (1u << i);
+            retval = -1;
+        }
+    }
+    return retval;
+}
+
 /**
  * Called periodically to update the I2C statistics
  */
@@ -482,6 +702,88 @@ static void updateWDGstats()
 }
 #endif /* ifdef DIAG_I2C_WDG_STATS */
 
+#if defined(PIOS_INCLUDE_MEM_ACCOUNTING) || defined(PIOS_INCLUDE_INITCALL_PROFILE)
+/**
+ * Modules are named after their initialize function, get the length of the name without the suffix
+ */
+static size_t moduleNameLength(const char *name)
+{
+    size_t length = strlen(name);
+
+    if (length > 10 && !strcmp(name + length - 10, "Initialize")) {
+        length -= 10;
+    }
+    return length;
+}
+#endif
+
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+/**
+ * Called periodically to publish the memory use of each owner and of the block pools.
+ * Owners only change while allocating, so an instance is only set when it changed.
+ */
+static void updateMemoryStats()
+{
+    static uint8_t instances = 1;
+    struct pios_mem_owner_stats owner;
+
+    for (uint8_t i = 0; PIOS_MEM_GetOwnerStats(i, &owner); i++) {
+        if (i >= instances) {
+            MemoryStatsCreateInstance();
+            instances++;
+        }
+        MemoryStatsData stats;
+        memset(&stats, 0, sizeof(stats));
+        size_t length = moduleNameLength(owner.name);
+        memcpy(stats.Owner, owner.name, MIN(length, MEMORYSTATS_OWNER_NUMELEM - 1));
+        stats.HeapBytes   = owner.heap_bytes;
+        stats.PoolBlocks  = owner.pool_blocks;
+        stats.Allocations = owner.allocations;
+
+        MemoryStatsData published;
+        MemoryStatsInstGet(i, &published);
+        if (memcmp(&stats, &published, sizeof(stats))) {
+            MemoryStatsInstSet(i, &stats);
+        }
+    }
+
+    MemoryPoolStatsData poolStats;
+    struct pios_mem_pool_stats pool;
+    memset(&poolStats, 0, sizeof(poolStats));
+    for (uint8_t i = 0; i < MEMORYPOOLSTATS_BLOCKSIZE_NUMELEM && PIOS_MEM_GetPoolStats(i, &pool); i++) {
+        poolStats.BlockSize[i] = pool.block_size;
+        poolStats.Blocks[i]    = pool.blocks;
+        poolStats.Free[i]      = pool.free;
+        poolStats.MinFree[i]   = pool.min_free;
+        poolStats.Misses[i]    = pool.misses;
+    }
+    MemoryPoolStatsSet(&poolStats);
+}
+#endif /* ifdef PIOS_INCLUDE_MEM_ACCOUNTING */
+
+#ifdef PIOS_INCLUDE_INITCALL_PROFILE
+/**
+ * Called once all the modules are started to publish the time each one took to boot.
+ */
+static void publishBootProfile()
+{
+    struct pios_initcall_profile profile;
+
+    for (uint8_t i = 0; PIOS_INITCALL_GetProfile(i, &profile); i++) {
+        if (i > 0) {
+            BootProfileCreateInstance();
+        }
+        BootProfileData data;
+        memset(&data, 0, sizeof(data));
+        size_t length = moduleNameLength(profile.name);
+        memcpy(data.Module, profile.name, MIN(length, BOOTPROFILE_MODULE_NUMELEM - 1));
+        data.InitTime  = profile.init_us;
+        data.StartTime = profile.start_us;
+        BootProfileInstSet(i, &data);
+    }
+}
+#endif /* ifdef PIOS_INCLUDE_INITCALL_PROFILE */
+
 /**
  * Called periodically to update the system stats
  */
@@ -620,6 +922,10 @@ static void updateSystemAlarms()
         AlarmsClear(SYSTEMALARMS_ALARM_EVENTSYSTEM);
     }
 
+    // Worst periodic event latency since the last update
+    uint16_t eventLatency = (evStats.maxLatencyMs > UINT16_MAX) ? UINT16_MAX : (uint16_t)evStats.maxLatencyMs;
+    SystemStatsEventSystemMaxLatencySet(&eventLatency);
+
     if (objStats.lastCallbackErrorID || objStats.lastQueueErrorID || evStats.lastErrorID) {
         SystemStatsData sysStats;
         SystemStatsGet(&sysStats);
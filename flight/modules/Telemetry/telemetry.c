@@ -36,8 +36,17 @@
 
 #include "flighttelemetrystats.h"
 #include "gcstelemetrystats.h"
+#include "telemetryping.h"
+#include "metadataoverride.h"
 #include "hwsettings.h"
 #include "taskinfo.h"
+#ifdef DIAG_TELEMETRY
+#include "telemetryobjectstats.h"
+#endif
+#ifdef PIOS_INCLUDE_RFM22B
+#include "oplinkstatus.h"
+#include "oplinksettings.h"
+#endif
 
 // Private constants
 #define MAX_QUEUE_SIZE            TELEM_QUEUE_SIZE
@@ -59,13 +68,61 @@
 #define TASK_PRIORITY_RX          (tskIDLE_PRIORITY + 2)
 #define TASK_PRIORITY_TX          (tskIDLE_PRIORITY + 2)
 #define TASK_PRIORITY_RADRX       (tskIDLE_PRIORITY + 2)
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+#ifdef PIOS_TELEM_LOG_STACK_SIZE
+#define STACK_SIZE_LOG_BYTES      PIOS_TELEM_LOG_STACK_SIZE
+#else
+#define STACK_SIZE_LOG_BYTES      600
+#endif
+// Same as the telemetry tasks, neither can starve the other
+#define TASK_PRIORITY_LOG         (tskIDLE_PRIORITY + 2)
+// Events taken from the logging queue at once
+#define LOG_BATCH_SIZE            16
+#endif
 #define REQ_TIMEOUT_MS            250
+// bytes handed to UAVTalk at once by the receive tasks
+#define RX_CHUNK_SIZE             32
 #define MAX_RETRIES               2
 #define STATS_UPDATE_PERIOD_MS    4000
 #define CONNECTION_TIMEOUT_MS     8000
+// TelemetryObjectStats is demanded when the GCS lowers its period below this
+#define DIAG_DEMANDED_PERIOD_MS   2000
+// Objects without ack are batched in multi-object frames for at most this time, zero disables batching
+#ifdef PIOS_TELEM_BATCH_LATENCY_MS
+#define BATCH_LATENCY_MS          PIOS_TELEM_BATCH_LATENCY_MS
+#else
+#define BATCH_LATENCY_MS          0
+#endif
+// Periodic objects without ack are sent as deltas with a key frame every this many frames, zero disables deltas
+#ifdef PIOS_TELEM_DELTA_KEYFRAME_PERIOD
+#define DELTA_KEYFRAME_PERIOD     PIOS_TELEM_DELTA_KEYFRAME_PERIOD
+#else
+#define DELTA_KEYFRAME_PERIOD     0
+#endif
+// Periodic objects without ack and with at most this period are sent timestamped with the board time, zero disables it
+#ifdef PIOS_TELEM_TIMESTAMPED_PERIOD_MS
+#define TIMESTAMPED_PERIOD_MS     PIOS_TELEM_TIMESTAMPED_PERIOD_MS
+#else
+#define TIMESTAMPED_PERIOD_MS     0
+#endif
+// The periods of the fast non priority objects are scaled up to this factor when the link is saturated
+#define MAX_PERIOD_SCALE          8
+// Objects with a longer period are status objects and are never scaled
+#define UNSCALED_PERIOD_MS        1000
+// Link load in percent of the estimated bandwidth above which the periods are scaled up, and below which they are scaled down
+#define LINK_LOAD_HIGH_PERCENT    90
+#define LINK_LOAD_LOW_PERCENT     40
+// Round trip time measured by the GCS above which the link is considered saturated, the queues are filling up
+#define LINK_LATENCY_HIGH_MS      1000
 
 // Private types
 
+// Telemetry period set by the GCS session over the metadata of an object
+struct MetadataOverrideEntry {
+    UAVObjHandle obj;
+    uint16_t     period;
+};
+
 // Private variables
 static uint32_t telemetryPort;
 #ifdef PIOS_INCLUDE_RFM22B
@@ -79,6 +136,11 @@ static xQueueHandle priorityQueue;
 #define priorityQueue queue
 #endif
 
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+static xQueueHandle loggingQueue;
+static xTaskHandle telemetryLogTaskHandle;
+#endif
+
 static xTaskHandle telemetryTxTaskHandle;
 static xTaskHandle telemetryRxTaskHandle;
 #ifdef PIOS_INCLUDE_RFM22B
@@ -87,6 +149,13 @@ static xTaskHandle radioRxTaskHandle;
 static uint32_t txErrors;
 static uint32_t txRetries;
 static uint32_t timeOfLastObjectUpdate;
+static bool batchPending;
+static portTickType batchStartTime;
+static uint32_t telemetryBandwidth;
+static uint8_t periodScale;
+static struct MetadataOverrideEntry overrides[METADATAOVERRIDE_OBJECTID_NUMELEM];
+static bool overridesActive;
+static uint32_t overridesExpiry;
 static UAVTalkConnection uavTalkCon;
 #ifdef PIOS_INCLUDE_RFM22B
 static UAVTalkConnection radioUavTalkCon;
@@ -95,6 +164,10 @@ static UAVTalkConnection radioUavTalkCon;
 // Private functions
 static void telemetryTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+static void telemetryLogTask(void *parameters);
+static void updateLogging(UAVObjHandle obj, int32_t eventType);
+#endif
 #ifdef PIOS_INCLUDE_RFM22B
 static void radioRxTask(void *parameters);
 static int32_t transmitRadioData(uint8_t *data, int32_t length);
@@ -105,10 +178,26 @@ static void updateObject(UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
 static int32_t setLoggingPeriod(UAVObjHandle obj, int32_t updatePeriodMs);
 static void processObjEvent(UAVObjEvent *ev);
+static void logObjEvent(UAVObjEvent *ev);
+static int32_t telemetryEventMask(UAVObjHandle obj, const UAVObjMetadata *metadata, int32_t eventType);
+static int32_t loggingEventMask(UAVObjHandle obj, const UAVObjMetadata *metadata, int32_t eventType);
+static void flushBatchIfDue();
 static void updateTelemetryStats();
 static void gcsTelemetryStatsUpdated();
+static void telemetryPingReceived();
+static void metadataOverrideUpdated();
+static void setOverrides(const struct MetadataOverrideEntry *entries);
+static void getTelemetryMetadata(UAVObjHandle obj, UAVObjMetadata *metadata);
 static void updateSettings();
 static uint32_t getComPort(bool input);
+static int32_t scaledUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
+static void updatePeriodScale(uint32_t txRate, uint32_t errors, float roundTripTime);
+static void rescaleObject(UAVObjHandle obj);
+static uint32_t getLinkBandwidth();
+#ifdef DIAG_TELEMETRY
+static void updateObjectStats();
+static bool objectStatsDemanded();
+#endif
 
 /**
  * Initialise the telemetry module
@@ -122,12 +211,18 @@ int32_t TelemetryStart(void)
 
     // Listen to objects of interest
     GCSTelemetryStatsConnectQueue(priorityQueue);
+    TelemetryPingConnectQueue(priorityQueue);
+    MetadataOverrideConnectQueue(priorityQueue);
 
     // Start telemetry tasks
     xTaskCreate(telemetryTxTask, "TelTx", STACK_SIZE_TX_BYTES / 4, NULL, TASK_PRIORITY_TX, &telemetryTxTaskHandle);
     PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_TELEMETRYTX, telemetryTxTaskHandle);
     xTaskCreate(telemetryRxTask, "TelRx", STACK_SIZE_RX_BYTES / 4, NULL, TASK_PRIORITY_RX, &telemetryRxTaskHandle);
     PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_TELEMETRYRX, telemetryRxTaskHandle);
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+    xTaskCreate(telemetryLogTask, "TelLog", STACK_SIZE_LOG_BYTES / 4, NULL, TASK_PRIORITY_LOG, &telemetryLogTaskHandle);
+    PIOS_TASK_MONITOR_RegisterTask(TASKINFO_RUNNING_TELEMETRYLOG, telemetryLogTaskHandle);
+#endif
 
 #ifdef PIOS_INCLUDE_RFM22B
     xTaskCreate(radioRxTask, "RadioRx", STACK_SIZE_RADIO_RX_BYTES / 4, NULL, TASK_PRIORITY_RADRX, &radioRxTaskHandle);
@@ -146,15 +241,28 @@ int32_t TelemetryInitialize(void)
 {
     FlightTelemetryStatsInitialize();
     GCSTelemetryStatsInitialize();
+    TelemetryPingInitialize();
+    MetadataOverrideInitialize();
+#ifdef DIAG_TELEMETRY
+    TelemetryObjectStatsInitialize();
+#endif
 
     // Initialize vars
     timeOfLastObjectUpdate = 0;
+    batchPending = false;
+    telemetryBandwidth     = 0;
+    periodScale  = 1;
+    overridesActive = false;
+    memset(overrides, 0, sizeof(overrides));
 
     // Create object queues
     queue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 #if defined(PIOS_TELEM_PRIORITY_QUEUE)
     priorityQueue = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
 #endif
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+    loggingQueue  = xQueueCreate(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+#endif
 
     // Update telemetry settings
     telemetryPort = PIOS_COM_TELEM_RF;
@@ -206,7 +314,6 @@ static void registerObject(UAVObjHandle obj)
 static void updateObject(UAVObjHandle obj, int32_t eventType)
 {
     UAVObjMetadata metadata;
-    UAVObjUpdateMode updateMode, loggingMode;
     int32_t eventMask;
 
     if (UAVObjIsMetaobject(obj)) {
@@ -217,16 +324,64 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
     }
 
     // Get metadata
+    getTelemetryMetadata(obj, &metadata);
+    eventMask = telemetryEventMask(obj, &metadata, eventType);
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+    // The logging has its own queue, only a metadata change concerns it here.
+    // Manual logging is rare and comes through the telemetry queue, which saves
+    // the second connection for the objects not logged otherwise.
+    eventMask |= EV_LOGGING_MANUAL;
+    if (eventType == EV_NONE) {
+        updateLogging(obj, EV_NONE);
+    }
+#else
+    eventMask |= loggingEventMask(obj, &metadata, eventType);
+#endif
+
+    // note that all setting objects have implicitly IsPriority=true
+    if (UAVObjIsPriority(obj)) {
+        UAVObjConnectQueue(obj, priorityQueue, eventMask);
+    } else {
+        UAVObjConnectQueue(obj, queue, eventMask);
+    }
+}
+
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+/**
+ * Update object's logging queue connection and timer, depending on object's settings
+ * \param[in] obj Object to updates
+ */
+static void updateLogging(UAVObjHandle obj, int32_t eventType)
+{
+    UAVObjMetadata metadata;
+
     UAVObjGetMetadata(obj, &metadata);
-    updateMode  = UAVObjGetTelemetryUpdateMode(&metadata);
-    loggingMode = UAVObjGetLoggingUpdateMode(&metadata);
+    int32_t eventMask = loggingEventMask(obj, &metadata, eventType) & ~EV_LOGGING_MANUAL;
+    // A zero mask would connect all the events
+    if (eventMask) {
+        UAVObjConnectQueue(obj, loggingQueue, eventMask);
+    } else {
+        UAVObjDisconnectQueue(obj, loggingQueue);
+    }
+}
+#endif /* PIOS_TELEM_LOGGING_QUEUE */
+
+/**
+ * Set the telemetry period of an object and get the events it needs
+ * \param[in] obj The object
+ * \param[in] metadata Its metadata
+ * \param[in] eventType The event that triggered the update, EV_NONE on a metadata change
+ * \return The telemetry event mask
+ */
+static int32_t telemetryEventMask(UAVObjHandle obj, const UAVObjMetadata *metadata, int32_t eventType)
+{
+    int32_t eventMask = 0;
 
     // Setup object depending on update mode
-    eventMask   = 0;
-    switch (updateMode) {
+    switch (UAVObjGetTelemetryUpdateMode(metadata)) {
     case UPDATEMODE_PERIODIC:
         // Set update period
-        setUpdatePeriod(obj, metadata.telemetryUpdatePeriod);
+        setUpdatePeriod(obj, scaledUpdatePeriod(obj, metadata->telemetryUpdatePeriod));
         // Connect queue
         eventMask |= EV_UPDATED_PERIODIC | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
         break;
@@ -242,7 +397,7 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
             eventMask |= EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
             // Set update period on initialization and metadata change
             if (eventType == EV_NONE) {
-                setUpdatePeriod(obj, metadata.telemetryUpdatePeriod);
+                setUpdatePeriod(obj, metadata->telemetryUpdatePeriod);
             }
         } else {
             // Otherwise, we just received an object update, so switch to periodic for the timeout period to prevent more updates
@@ -256,10 +411,24 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
         eventMask |= EV_UPDATED_MANUAL | EV_UPDATE_REQ;
         break;
     }
-    switch (loggingMode) {
+    return eventMask;
+}
+
+/**
+ * Set the logging period of an object and get the events it needs
+ * \param[in] obj The object
+ * \param[in] metadata Its metadata
+ * \param[in] eventType The event that triggered the update, EV_NONE on a metadata change
+ * \return The logging event mask
+ */
+static int32_t loggingEventMask(UAVObjHandle obj, const UAVObjMetadata *metadata, int32_t eventType)
+{
+    int32_t eventMask = 0;
+
+    switch (UAVObjGetLoggingUpdateMode(metadata)) {
     case UPDATEMODE_PERIODIC:
         // Set update period
-        setLoggingPeriod(obj, metadata.loggingUpdatePeriod);
+        setLoggingPeriod(obj, metadata->loggingUpdatePeriod);
         // Connect queue
         eventMask |= EV_LOGGING_PERIODIC | EV_LOGGING_MANUAL;
         break;
@@ -275,7 +444,7 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
             eventMask |= EV_UPDATED | EV_LOGGING_MANUAL;
             // Set update period on initialization and metadata change
             if (eventType == EV_NONE) {
-                setLoggingPeriod(obj, metadata.loggingUpdatePeriod);
+                setLoggingPeriod(obj, metadata->loggingUpdatePeriod);
             }
         } else {
             // Otherwise, we just received an object update, so switch to periodic for the timeout period to prevent more updates
@@ -289,12 +458,7 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
         eventMask |= EV_LOGGING_MANUAL;
         break;
     }
-    // note that all setting objects have implicitly IsPriority=true
-    if (UAVObjIsPriority(obj)) {
-        UAVObjConnectQueue(obj, priorityQueue, eventMask);
-    } else {
-        UAVObjConnectQueue(obj, queue, eventMask);
-    }
+    return eventMask;
 }
 
 /**
@@ -311,9 +475,18 @@ static void processObjEvent(UAVObjEvent *ev)
         updateTelemetryStats();
     } else if (ev->obj == GCSTelemetryStatsHandle()) {
         gcsTelemetryStatsUpdated();
+    } else if (ev->obj == TelemetryPingHandle()) {
+        telemetryPingReceived();
+    } else if (ev->obj == MetadataOverrideHandle()) {
+        metadataOverrideUpdated();
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+    } else if (ev->event == EV_LOGGING_MANUAL) {
+        // Hand it over to the logging task
+        xQueueSend(loggingQueue, ev, 0);
+#endif
     } else {
         // Get object metadata
-        UAVObjGetMetadata(ev->obj, &metadata);
+        getTelemetryMetadata(ev->obj, &metadata);
         updateMode = UAVObjGetTelemetryUpdateMode(&metadata);
 
         // Act on event
@@ -322,6 +495,21 @@ static void processObjEvent(UAVObjEvent *ev)
         if ((ev->event == EV_UPDATED && (updateMode == UPDATEMODE_ONCHANGE || updateMode == UPDATEMODE_THROTTLED))
             || ev->event == EV_UPDATED_MANUAL
             || (ev->event == EV_UPDATED_PERIODIC && updateMode != UPDATEMODE_THROTTLED)) {
+            // Send the fast periodic objects without ack timestamped, the other periodic ones as deltas and batch the
+            // rest, they are sent directly if this fails
+            if (TIMESTAMPED_PERIOD_MS > 0 && ev->event == EV_UPDATED_PERIODIC && !UAVObjGetTelemetryAcked(&metadata)
+                && metadata.telemetryUpdatePeriod > 0 && metadata.telemetryUpdatePeriod <= TIMESTAMPED_PERIOD_MS) {
+                success = UAVTalkSendObjectTimestamped(uavTalkCon, ev->obj, ev->instId, 0, 0);
+            } else if (DELTA_KEYFRAME_PERIOD > 0 && ev->event == EV_UPDATED_PERIODIC
+                && !UAVObjGetTelemetryAcked(&metadata) && !UAVObjIsPriority(ev->obj)) {
+                success = UAVTalkSendObjectDelta(uavTalkCon, ev->obj, ev->instId, DELTA_KEYFRAME_PERIOD);
+            } else if (BATCH_LATENCY_MS > 0 && !UAVObjGetTelemetryAcked(&metadata) && !UAVObjIsPriority(ev->obj)) {
+                success = UAVTalkSendObjectBatched(uavTalkCon, ev->obj, ev->instId);
+                if (!batchPending) {
+                    batchPending   = true;
+                    batchStartTime = xTaskGetTickCount();
+                }
+            }
             // Send update to GCS (with retries)
             while (retries < MAX_RETRIES && success == -1) {
                 // call blocks until ack is received or timeout
@@ -361,25 +549,44 @@ static void processObjEvent(UAVObjEvent *ev)
             }
         }
     }
+#if !defined(PIOS_TELEM_LOGGING_QUEUE)
     // Log UAVObject if necessary
-    if (ev->obj) {
-        updateMode = UAVObjGetLoggingUpdateMode(&metadata);
-        if ((ev->event == EV_UPDATED && (updateMode == UPDATEMODE_ONCHANGE || updateMode == UPDATEMODE_THROTTLED))
-            || ev->event == EV_LOGGING_MANUAL
-            || (ev->event == EV_LOGGING_PERIODIC && updateMode != UPDATEMODE_THROTTLED)) {
-            if (ev->instId == UAVOBJ_ALL_INSTANCES) {
-                success = UAVObjGetNumInstances(ev->obj);
-                for (retries = 0; retries < success; retries++) {
-                    UAVObjInstanceWriteToLog(ev->obj, retries);
-                }
-            } else {
-                UAVObjInstanceWriteToLog(ev->obj, ev->instId);
+    logObjEvent(ev);
+#endif
+}
+
+/**
+ * Write the object of an event to the log if its logging mode asks for it
+ */
+static void logObjEvent(UAVObjEvent *ev)
+{
+    UAVObjMetadata metadata;
+    UAVObjUpdateMode updateMode;
+
+    if (ev->obj == 0) {
+        return;
+    }
+    UAVObjGetMetadata(ev->obj, &metadata);
+    updateMode = UAVObjGetLoggingUpdateMode(&metadata);
+    if ((ev->event == EV_UPDATED && (updateMode == UPDATEMODE_ONCHANGE || updateMode == UPDATEMODE_THROTTLED))
+        || ev->event == EV_LOGGING_MANUAL
+        || (ev->event == EV_LOGGING_PERIODIC && updateMode != UPDATEMODE_THROTTLED)) {
+        if (ev->instId == UAVOBJ_ALL_INSTANCES) {
+            uint16_t numInstances = UAVObjGetNumInstances(ev->obj);
+            for (uint16_t instId = 0; instId < numInstances; instId++) {
+                UAVObjInstanceWriteToLog(ev->obj, instId);
             }
+        } else {
+            UAVObjInstanceWriteToLog(ev->obj, ev->instId);
         }
-        if (updateMode == UPDATEMODE_THROTTLED) {
-            // If this is UPDATEMODE_THROTTLED, the event mask changes on every event.
-            updateObject(ev->obj, ev->event);
-        }
+    }
+    if (updateMode == UPDATEMODE_THROTTLED) {
+        // If this is UPDATEMODE_THROTTLED, the event mask changes on every event.
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+        updateLogging(ev->obj, ev->event);
+#else
+        updateObject(ev->obj, ev->event);
+#endif
     }
 }
 
@@ -417,9 +624,55 @@ static void telemetryTxTask(__attribute__((unused)) void *parameters)
             processObjEvent(&ev);
         }
 #endif /* if defined(PIOS_TELEM_PRIORITY_QUEUE) */
+        flushBatchIfDue();
+    }
+}
+
+/**
+ * Send the multi-object frame once its oldest object has waited for BATCH_LATENCY_MS
+ */
+static void flushBatchIfDue()
+{
+    if (batchPending && (xTaskGetTickCount() - batchStartTime) >= BATCH_LATENCY_MS / portTICK_RATE_MS) {
+        batchPending = false;
+        if (UAVTalkFlushBatch(uavTalkCon) == -1) {
+            ++txErrors;
+        }
     }
 }
 
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+/**
+ * Logging task, writes the objects to the log apart from the telemetry so that
+ * neither a saturated link nor a busy log holds the other up. The pending
+ * events are taken at once, an object is read when written so it is written
+ * once per batch.
+ */
+static void telemetryLogTask(__attribute__((unused)) void *parameters)
+{
+    UAVObjEvent batch[LOG_BATCH_SIZE];
+    UAVObjEvent ev;
+
+    while (1) {
+        if (xQueueReceive(loggingQueue, &batch[0], portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        uint8_t count = 1;
+        while (count < LOG_BATCH_SIZE && xQueueReceive(loggingQueue, &ev, 0) == pdTRUE) {
+            uint8_t n = 0;
+            while (n < count && (batch[n].obj != ev.obj || batch[n].instId != ev.instId || batch[n].event != ev.event)) {
+                n++;
+            }
+            if (n == count) {
+                batch[count++] = ev;
+            }
+        }
+        for (uint8_t n = 0; n < count; n++) {
+            logObjEvent(&batch[n]);
+        }
+    }
+}
+#endif /* PIOS_TELEM_LOGGING_QUEUE */
 
 /**
  * Telemetry receive task. Processes queue events and periodic updates.
@@ -432,14 +685,12 @@ static void telemetryRxTask(__attribute__((unused)) void *parameters)
 
         if (inputPort) {
             // Block until data are available
-            uint8_t serial_data[1];
+            uint8_t serial_data[RX_CHUNK_SIZE];
             uint16_t bytes_to_process;
 
             bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 500);
             if (bytes_to_process > 0) {
-                for (uint8_t i = 0; i < bytes_to_process; i++) {
-                    UAVTalkProcessInputStream(uavTalkCon, serial_data[i]);
-                }
+                UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
             }
         } else {
             vTaskDelay(5);
@@ -457,14 +708,12 @@ static void radioRxTask(__attribute__((unused)) void *parameters)
     while (1) {
         if (radioPort) {
             // Block until data are available
-            uint8_t serial_data[1];
+            uint8_t serial_data[RX_CHUNK_SIZE];
             uint16_t bytes_to_process;
 
             bytes_to_process = PIOS_COM_ReceiveBuffer(radioPort, serial_data, sizeof(serial_data), 500);
             if (bytes_to_process > 0) {
-                for (uint8_t i = 0; i < bytes_to_process; i++) {
-                    UAVTalkProcessInputStream(radioUavTalkCon, serial_data[i]);
-                }
+                UAVTalkProcessInputBuffer(radioUavTalkCon, serial_data, bytes_to_process);
             }
         } else {
             vTaskDelay(5);
@@ -551,7 +800,11 @@ static int32_t setLoggingPeriod(UAVObjHandle obj, int32_t updatePeriodMs)
     ev.event  = EV_LOGGING_PERIODIC;
     ev.lowPriority = true;
 
+#if defined(PIOS_TELEM_LOGGING_QUEUE)
+    xQueueHandle targetQueue = loggingQueue;
+#else
     xQueueHandle targetQueue = UAVObjIsPriority(obj) ? priorityQueue : queue;
+#endif
 
     ret = EventPeriodicQueueUpdate(&ev, targetQueue, updatePeriodMs);
     if (ret == -1) {
@@ -577,6 +830,96 @@ static void gcsTelemetryStatsUpdated()
     }
 }
 
+/**
+ * Answer a time exchange request of the GCS at once, from the priority queue.
+ * The tick count is the board time of the timestamped objects too.
+ */
+static void telemetryPingReceived()
+{
+    TelemetryPingData ping;
+
+    TelemetryPingGet(&ping);
+    // The reply comes back here too
+    if (ping.Operation != TELEMETRYPING_OPERATION_REQUEST) {
+        return;
+    }
+    ping.FlightReceiveTime  = xTaskGetTickCount() * portTICK_RATE_MS;
+    ping.Operation          = TELEMETRYPING_OPERATION_REPLY;
+    ping.FlightTransmitTime = xTaskGetTickCount() * portTICK_RATE_MS;
+    TelemetryPingSet(&ping);
+    UAVTalkSendObject(uavTalkCon, TelemetryPingHandle(), 0, 0, 0);
+}
+
+/**
+ * The GCS sent the set of telemetry periods of its session, or refreshed it
+ */
+static void metadataOverrideUpdated()
+{
+    MetadataOverrideData data;
+    struct MetadataOverrideEntry entries[METADATAOVERRIDE_OBJECTID_NUMELEM];
+
+    MetadataOverrideGet(&data);
+    memset(entries, 0, sizeof(entries));
+    if (data.Timeout > 0) {
+        for (uint8_t n = 0; n < METADATAOVERRIDE_OBJECTID_NUMELEM; n++) {
+            UAVObjHandle obj = data.ObjectID[n] ? UAVObjGetByID(data.ObjectID[n]) : 0;
+            if (obj && !UAVObjIsMetaobject(obj) && data.TelemetryUpdatePeriod[n] > 0) {
+                entries[n].obj    = obj;
+                entries[n].period = data.TelemetryUpdatePeriod[n];
+            }
+        }
+        overridesExpiry = xTaskGetTickCount() * portTICK_RATE_MS + data.Timeout * 1000;
+    }
+    setOverrides(entries);
+}
+
+/**
+ * Replace the overrides, only the objects whose telemetry changes are updated
+ * so that refreshing the same set does not restart their periods
+ * \param[in] entries The new set, all zero to drop the overrides
+ */
+static void setOverrides(const struct MetadataOverrideEntry *entries)
+{
+    struct MetadataOverrideEntry previous[METADATAOVERRIDE_OBJECTID_NUMELEM];
+
+    memcpy(previous, overrides, sizeof(previous));
+    memcpy(overrides, entries, sizeof(overrides));
+    overridesActive = false;
+    for (uint8_t n = 0; n < METADATAOVERRIDE_OBJECTID_NUMELEM; n++) {
+        overridesActive |= (overrides[n].obj != 0);
+    }
+
+    for (uint8_t n = 0; n < METADATAOVERRIDE_OBJECTID_NUMELEM; n++) {
+        if (previous[n].obj == overrides[n].obj && previous[n].period == overrides[n].period) {
+            continue;
+        }
+        if (previous[n].obj) {
+            updateObject(previous[n].obj, EV_NONE);
+        }
+        if (overrides[n].obj) {
+            updateObject(overrides[n].obj, EV_NONE);
+        }
+    }
+}
+
+/**
+ * Get the metadata of an object, with the telemetry period of the GCS session if it has one
+ */
+static void getTelemetryMetadata(UAVObjHandle obj, UAVObjMetadata *metadata)
+{
+    UAVObjGetMetadata(obj, metadata);
+    if (!overridesActive) {
+        return;
+    }
+    for (uint8_t n = 0; n < METADATAOVERRIDE_OBJECTID_NUMELEM; n++) {
+        if (overrides[n].obj == obj) {
+            UAVObjSetTelemetryUpdateMode(metadata, UPDATEMODE_PERIODIC);
+            metadata->telemetryUpdatePeriod = overrides[n].period;
+            return;
+        }
+    }
+}
+
 /**
  * Update telemetry statistics and handle connection handshake
  */
@@ -594,6 +937,9 @@ static void updateTelemetryStats()
 #ifdef PIOS_INCLUDE_RFM22B
     UAVTalkAddStats(radioUavTalkCon, &utalkStats, true);
 #endif
+#ifdef DIAG_TELEMETRY
+    updateObjectStats();
+#endif
 
     // Get object data
     FlightTelemetryStatsGet(&flightStats);
@@ -601,6 +947,8 @@ static void updateTelemetryStats()
 
     // Update stats object
     if (flightStats.Status == FLIGHTTELEMETRYSTATS_STATUS_CONNECTED) {
+        updatePeriodScale(utalkStats.txBytes * 1000 / STATS_UPDATE_PERIOD_MS, txErrors, gcsStats.RoundTripTime);
+
         flightStats.TxDataRate    = (float)utalkStats.txBytes / ((float)STATS_UPDATE_PERIOD_MS / 1000.0f);
         flightStats.TxBytes      += utalkStats.txBytes;
         flightStats.TxFailures   += txErrors;
@@ -661,6 +1009,13 @@ static void updateTelemetryStats()
         flightStats.Status = FLIGHTTELEMETRYSTATS_STATUS_DISCONNECTED;
     }
 
+    // The overrides of a GCS gone away must not stay set
+    if (overridesActive && (flightStats.Status != FLIGHTTELEMETRYSTATS_STATUS_CONNECTED || (int32_t)(timeNow - overridesExpiry) >= 0)) {
+        struct MetadataOverrideEntry none[METADATAOVERRIDE_OBJECTID_NUMELEM];
+        memset(none, 0, sizeof(none));
+        setOverrides(none);
+    }
+
     // TODO: check whether is there any error condition worth raising an alarm
     // Disconnection is actually a normal (non)working status so it is not raising alarms anymore.
     if (flightStats.Status == FLIGHTTELEMETRYSTATS_STATUS_CONNECTED) {
@@ -676,6 +1031,82 @@ static void updateTelemetryStats()
     }
 }
 
+#ifdef DIAG_TELEMETRY
+/**
+ * Publish the traffic of the objects that used the most of the links since
+ * the last update, busiest first, while the GCS demands it
+ */
+static void updateObjectStats()
+{
+    static uint32_t lastTime;
+    UAVTalkObjectStats stats[UAVTALK_OBJECT_STATS_SIZE];
+
+    PIOS_STATIC_ASSERT(TELEMETRYOBJECTSTATS_OBJECTID_NUMELEM == UAVTALK_OBJECT_STATS_SIZE);
+
+    // The counters are cleared anyway, the next period starts now
+    memset(stats, 0, sizeof(stats));
+    UAVTalkAddObjectStats(uavTalkCon, stats, true);
+#ifdef PIOS_INCLUDE_RFM22B
+    UAVTalkAddObjectStats(radioUavTalkCon, stats, true);
+#endif
+    uint32_t timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
+    uint32_t period  = timeNow - lastTime;
+    lastTime = timeNow;
+
+    if (period == 0 || !objectStatsDemanded()) {
+        return;
+    }
+
+    // Insertion sort, the last entry holds the rest and stays last
+    for (int8_t n = 1; n < UAVTALK_OBJECT_STATS_SIZE - 1; n++) {
+        UAVTalkObjectStats entry = stats[n];
+        uint32_t bytes = entry.txBytes + entry.rxBytes;
+        int8_t m = n - 1;
+        for (; m >= 0 && stats[m].txBytes + stats[m].rxBytes < bytes; m--) {
+            stats[m + 1] = stats[m];
+        }
+        stats[m + 1] = entry;
+    }
+
+    TelemetryObjectStatsData data;
+    for (uint8_t n = 0; n < UAVTALK_OBJECT_STATS_SIZE; n++) {
+        data.ObjectID[n]   = stats[n].objId;
+        data.TxDataRate[n] = MIN((uint64_t)stats[n].txBytes * 1000 / period, UINT16_MAX);
+        data.RxDataRate[n] = MIN((uint64_t)stats[n].rxBytes * 1000 / period, UINT16_MAX);
+        data.TxPackets[n]  = stats[n].txPackets;
+        data.RxPackets[n]  = stats[n].rxPackets;
+    }
+    data.Period = MIN(period, UINT16_MAX);
+    TelemetryObjectStatsSet(&data);
+}
+
+/**
+ * TelemetryObjectStats is demanded while a GCS is connected and has lowered
+ * its telemetry period, as for TaskInfo
+ */
+static bool objectStatsDemanded()
+{
+    UAVObjMetadata metadata;
+    uint8_t status;
+
+    FlightTelemetryStatsStatusGet(&status);
+    if (status != FLIGHTTELEMETRYSTATS_STATUS_CONNECTED || UAVObjGetMetadata(TelemetryObjectStatsHandle(), &metadata) < 0) {
+        return false;
+    }
+    switch (UAVObjGetTelemetryUpdateMode(&metadata)) {
+    case UPDATEMODE_ONCHANGE:
+        return true;
+
+    case UPDATEMODE_PERIODIC:
+    case UPDATEMODE_THROTTLED:
+        return metadata.telemetryUpdatePeriod < DIAG_DEMANDED_PERIOD_MS;
+
+    default:
+        return false;
+    }
+}
+#endif /* DIAG_TELEMETRY */
+
 /**
  * Update the telemetry settings, called on startup.
  * FIXME: This should be in the TelemetrySettings object. But objects
@@ -688,35 +1119,138 @@ static void updateSettings()
     if (telemetryPort) {
         // Retrieve settings
         uint8_t speed;
+        uint32_t baud = 0;
         HwSettingsTelemetrySpeedGet(&speed);
 
         // Set port speed
         switch (speed) {
         case HWSETTINGS_TELEMETRYSPEED_2400:
-            PIOS_COM_ChangeBaud(telemetryPort, 2400);
+            baud = 2400;
             break;
         case HWSETTINGS_TELEMETRYSPEED_4800:
-            PIOS_COM_ChangeBaud(telemetryPort, 4800);
+            baud = 4800;
             break;
         case HWSETTINGS_TELEMETRYSPEED_9600:
-            PIOS_COM_ChangeBaud(telemetryPort, 9600);
+            baud = 9600;
             break;
         case HWSETTINGS_TELEMETRYSPEED_19200:
-            PIOS_COM_ChangeBaud(telemetryPort, 19200);
+            baud = 19200;
             break;
         case HWSETTINGS_TELEMETRYSPEED_38400:
-            PIOS_COM_ChangeBaud(telemetryPort, 38400);
+            baud = 38400;
             break;
         case HWSETTINGS_TELEMETRYSPEED_57600:
-            PIOS_COM_ChangeBaud(telemetryPort, 57600);
+            baud = 57600;
             break;
         case HWSETTINGS_TELEMETRYSPEED_115200:
-            PIOS_COM_ChangeBaud(telemetryPort, 115200);
+            baud = 115200;
             break;
         }
+        if (baud) {
+            PIOS_COM_ChangeBaud(telemetryPort, baud);
+            // 8N1, ten bits per byte
+            telemetryBandwidth = baud / 10;
+        }
     }
 }
 
+/**
+ * Telemetry period of an object once scaled to the link bandwidth.
+ * Objects are ranked by priority then period: priority objects and slow status objects
+ * (FlightStatus is on change, PositionState and the alarms are slow or priority) keep
+ * their period, the fast streams are slowed down when the link is saturated.
+ * \param[in] obj The object
+ * \param[in] updatePeriodMs The update period from the metadata
+ * \return The update period to use
+ */
+static int32_t scaledUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs)
+{
+    if (UAVObjIsPriority(obj) || updatePeriodMs <= 0 || updatePeriodMs >= UNSCALED_PERIOD_MS) {
+        return updatePeriodMs;
+    }
+    // Never scale past the status objects
+    int32_t period = updatePeriodMs * periodScale;
+    return (period < UNSCALED_PERIOD_MS) ? period : UNSCALED_PERIOD_MS;
+}
+
+/**
+ * Adapt the scale of the periods to the load of the link, called every STATS_UPDATE_PERIOD_MS.
+ * The scale is doubled while the link is overloaded, sends fail or the round trip time
+ * shows the queues of the link filling up, and halved once the load would still be
+ * acceptable with the shorter periods.
+ * \param[in] txRate Bytes/s sent during the last period
+ * \param[in] errors Send failures during the last period
+ * \param[in] roundTripTime Link round trip time in ms measured by the GCS, 0 if unknown
+ */
+static void updatePeriodScale(uint32_t txRate, uint32_t errors, float roundTripTime)
+{
+    uint32_t bandwidth = getLinkBandwidth();
+    uint8_t scale = periodScale;
+    bool congested = errors > 0 || roundTripTime > LINK_LATENCY_HIGH_MS;
+
+    if (bandwidth == 0) {
+        scale = 1;
+    } else if ((congested || txRate * 100 > bandwidth * LINK_LOAD_HIGH_PERCENT) && scale < MAX_PERIOD_SCALE) {
+        scale *= 2;
+    } else if (!congested && txRate * 100 < bandwidth * LINK_LOAD_LOW_PERCENT && scale > 1) {
+        scale /= 2;
+    }
+
+    if (scale != periodScale) {
+        periodScale = scale;
+        UAVObjIterate(&rescaleObject);
+    }
+}
+
+/**
+ * Apply the current period scale to a periodic object
+ */
+static void rescaleObject(UAVObjHandle obj)
+{
+    UAVObjMetadata metadata;
+
+    if (UAVObjIsMetaobject(obj) || UAVObjIsPriority(obj)) {
+        return;
+    }
+    getTelemetryMetadata(obj, &metadata);
+    if (UAVObjGetTelemetryUpdateMode(&metadata) == UPDATEMODE_PERIODIC) {
+        setUpdatePeriod(obj, scaledUpdatePeriod(obj, metadata.telemetryUpdatePeriod));
+    }
+}
+
+/**
+ * Estimate the bandwidth of the current output port
+ * \return Bytes/s, zero if the port is not limited (USB)
+ */
+static uint32_t getLinkBandwidth()
+{
+    uint32_t outputPort = getComPort(false);
+
+#if defined(PIOS_INCLUDE_USB)
+    if (outputPort == PIOS_COM_TELEM_USB) {
+        return 0;
+    }
+#endif /* PIOS_INCLUDE_USB */
+#ifdef PIOS_INCLUDE_RFM22B
+    // The onboard radio bandwidth depends on the link quality
+    if (outputPort && outputPort == PIOS_COM_RF) {
+        static const uint32_t comSpeeds[] = { 4800, 9600, 19200, 38400, 57600, 115200 };
+        uint8_t comSpeed;
+        OPLinkStatusData oplinkStatus;
+
+        OPLinkSettingsComSpeedGet(&comSpeed);
+        OPLinkStatusGet(&oplinkStatus);
+        if (comSpeed >= NELEMENTS(comSpeeds) || oplinkStatus.LinkState != OPLINKSTATUS_LINKSTATE_CONNECTED) {
+            // Nothing gets through, keep the minimum traffic
+            return 1;
+        }
+        // The link quality ranges from 0 to 128 (all packets good)
+        return (comSpeeds[comSpeed] / 10) * oplinkStatus.LinkQuality / 128 + 1;
+    }
+#endif /* PIOS_INCLUDE_RFM22B */
+    return outputPort ? telemetryBandwidth : 0;
+}
+
 /**
  * Determine input/output com port as highest priority available
  * @param[in] input Returns the approproate input com port if true, else the appropriate output com port
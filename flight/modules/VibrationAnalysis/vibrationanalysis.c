@@ -0,0 +1,308 @@
+/**
+ ******************************************************************************
+ * @addtogroup OpenPilotModules OpenPilot Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @brief Real time amplitude spectrum of the gyro
+ * Input object: GyroSensor
+ * Output object: VibrationAnalysisOutput
+ *
+ * Every GyroSensor update is collected into a window. Full windows are
+ * handed to a low priority callback that computes the Hann windowed spectrum
+ * of all three axes, publishes it in bands together with the resonance peak
+ * of every axis and, if configured, the frequency that the dynamic gyro
+ * notch of Stabilization should follow.
+ * @{
+ *
+ * @file       vibrationanalysis.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Gyro spectrum analyzer
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <openpilot.h>
+#include <fft.h>
+#include <mathmisc.h>
+
+#include "callbackinfo.h"
+#include "hwsettings.h"
+#include "gyrosensor.h"
+#include "vibrationanalysissettings.h"
+#include "vibrationanalysisoutput.h"
+
+// Private constants
+#define STACK_SIZE_BYTES  768
+#define CALLBACK_PRIORITY CALLBACK_PRIORITY_LOW
+#define CBTASK_PRIORITY   CALLBACK_TASK_AUXILIARY
+
+#define AXES              3
+#define BANDS             VIBRATIONANALYSISOUTPUT_X_NUMELEM
+
+// Private variables
+static DelayedCallbackInfo *analysisCallback;
+static bool analysisEnabled = false;
+
+static struct fft_plan plan;
+static uint16_t windowSize;
+// two windows of samples [2][AXES][windowSize], the gyro fills one while the other is analysed
+static float *samples;
+static uint8_t fillWindow;
+static uint16_t fillCount;
+static uint32_t fillStart;
+static uint32_t windowTime;
+static volatile bool analysing;
+
+// analysis work space
+static float *hann;
+static float *spectrum;
+static float *magnitude[2];
+
+// Private functions
+static void GyroSensorUpdatedCb(UAVObjEvent *ev);
+static void analysisTask(void);
+static void reduceSpectrum(const float *mag, float binWidth, float minFrequency, float *bands, float *peakFrequency, float *peakAmplitude);
+
+/**
+ * Start the module, the analysis starts with the first full window
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+static int32_t VibrationAnalysisStart(void)
+{
+    if (!analysisEnabled) {
+        return -1;
+    }
+
+    GyroSensorConnectCallback(&GyroSensorUpdatedCb);
+    return 0;
+}
+
+/**
+ * Initialise the module, called on startup
+ * \return -1 if initialisation failed
+ * \return 0 on success
+ */
+static int32_t VibrationAnalysisInitialize(void)
+{
+#ifdef MODULE_VIBRATIONANALYSIS_BUILTIN
+    analysisEnabled = true;
+#else
+    HwSettingsInitialize();
+    HwSettingsOptionalModulesData optionalModules;
+
+    HwSettingsOptionalModulesGet(&optionalModules);
+    analysisEnabled = (optionalModules.VibrationAnalysis == HWSETTINGS_OPTIONALMODULES_ENABLED);
+#endif
+
+    if (!analysisEnabled) {
+        return 0;
+    }
+
+    GyroSensorInitialize();
+    VibrationAnalysisSettingsInitialize();
+    VibrationAnalysisOutputInitialize();
+
+    // the options are 64 times the powers of two
+    uint8_t size;
+    VibrationAnalysisSettingsFFTWindowSizeGet(&size);
+    windowSize = 64 << size;
+
+    samples     = (float *)pios_malloc(2 * AXES * windowSize * sizeof(float));
+    hann        = (float *)pios_malloc(windowSize * sizeof(float));
+    spectrum    = (float *)pios_malloc(2 * windowSize * sizeof(float));
+    magnitude[0] = (float *)pios_malloc((windowSize / 2 + 1) * sizeof(float));
+    magnitude[1] = (float *)pios_malloc((windowSize / 2 + 1) * sizeof(float));
+    float *twiddle = (float *)pios_malloc(windowSize * sizeof(float));
+    if (!samples || !hann || !spectrum || !magnitude[0] || !magnitude[1] || !twiddle) {
+        analysisEnabled = false;
+        return -1;
+    }
+
+    fft_plan_init(&plan, windowSize, twiddle);
+    for (uint16_t i = 0; i < windowSize; i++) {
+        hann[i] = 0.5f - 0.5f * cosf(M_2PI_F * i / windowSize);
+    }
+
+    analysisCallback = PIOS_CALLBACKSCHEDULER_Create(&analysisTask, CALLBACK_PRIORITY, CBTASK_PRIORITY, CALLBACKINFO_RUNNING_VIBRATIONANALYSIS, STACK_SIZE_BYTES);
+
+    return 0;
+}
+MODULE_INITCALL(VibrationAnalysisInitialize, VibrationAnalysisStart);
+
+/**
+ * Collects the samples at the full gyro rate, runs in the event dispatcher so keep it short
+ */
+static void GyroSensorUpdatedCb(__attribute__((unused)) UAVObjEvent *ev)
+{
+    GyroSensorData gyro;
+
+    GyroSensorGet(&gyro);
+
+    if (fillCount == 0) {
+        fillStart = PIOS_DELAY_GetRaw();
+    }
+    float *window = &samples[fillWindow * AXES * windowSize];
+    window[fillCount] = gyro.x;
+    window[windowSize + fillCount]     = gyro.y;
+    window[2 * windowSize + fillCount] = gyro.z;
+
+    if (++fillCount < windowSize) {
+        return;
+    }
+    fillCount = 0;
+
+    // the analysis of the previous window is still running, drop this one
+    if (analysing) {
+        return;
+    }
+    windowTime = PIOS_DELAY_DiffuS(fillStart);
+    analysing  = true;
+    fillWindow ^= 1;
+    PIOS_CALLBACKSCHEDULER_Dispatch(analysisCallback);
+}
+
+/**
+ * Hann windowed input without its mean, b may be NULL for a single signal
+ */
+static void loadSpectrum(const float *a, const float *b)
+{
+    float meanA = 0.0f;
+    float meanB = 0.0f;
+
+    for (uint16_t i = 0; i < windowSize; i++) {
+        meanA += a[i];
+        meanB += b ? b[i] : 0.0f;
+    }
+    meanA /= windowSize;
+    meanB /= windowSize;
+
+    for (uint16_t i = 0; i < windowSize; i++) {
+        spectrum[2 * i]     = (a[i] - meanA) * hann[i];
+        spectrum[2 * i + 1] = b ? (b[i] - meanB) * hann[i] : 0.0f;
+    }
+}
+
+static void analysisTask(void)
+{
+    VibrationAnalysisSettingsData settings;
+    VibrationAnalysisOutputData output;
+
+    VibrationAnalysisSettingsGet(&settings);
+
+    const float *window = &samples[(fillWindow ^ 1) * AXES * windowSize];
+    // windowTime spans windowSize - 1 sample periods
+    const float rate    = windowTime > 0 ? (windowSize - 1) * 1e6f / windowTime : 0.0f;
+    const float binWidth = rate / windowSize;
+    // the coherent gain of the Hann window is 1/2, an amplitude A sine gives A * n / 4
+    const float scale   = 4.0f / windowSize;
+
+    // x and y in one complex transform, z alone
+    loadSpectrum(&window[0], &window[windowSize]);
+    fft_complex(&plan, spectrum);
+    fft_real_pair_magnitude(&plan, spectrum, magnitude[0], magnitude[1]);
+    for (uint16_t k = 0; k <= windowSize / 2; k++) {
+        magnitude[0][k] *= scale;
+        magnitude[1][k] *= scale;
+    }
+    reduceSpectrum(magnitude[0], binWidth, settings.MinFrequency, output.x, &output.PeakFrequency.x, &output.PeakAmplitude.x);
+    reduceSpectrum(magnitude[1], binWidth, settings.MinFrequency, output.y, &output.PeakFrequency.y, &output.PeakAmplitude.y);
+
+    loadSpectrum(&window[2 * windowSize], NULL);
+    fft_complex(&plan, spectrum);
+    fft_real_pair_magnitude(&plan, spectrum, magnitude[0], NULL);
+    for (uint16_t k = 0; k <= windowSize / 2; k++) {
+        magnitude[0][k] *= scale;
+    }
+    reduceSpectrum(magnitude[0], binWidth, settings.MinFrequency, output.z, &output.PeakFrequency.z, &output.PeakAmplitude.z);
+
+    // the window can be refilled now
+    analysing = false;
+
+    output.SampleRate = rate;
+    output.BandWidth  = binWidth * (windowSize / 2 / BANDS);
+
+    const float *peakFrequency = &output.PeakFrequency.x;
+    const float *peakAmplitude = &output.PeakAmplitude.x;
+    int8_t axis = -1;
+    switch (settings.NotchSource) {
+    case VIBRATIONANALYSISSETTINGS_NOTCHSOURCE_ROLL:
+        axis = 0;
+        break;
+    case VIBRATIONANALYSISSETTINGS_NOTCHSOURCE_PITCH:
+        axis = 1;
+        break;
+    case VIBRATIONANALYSISSETTINGS_NOTCHSOURCE_YAW:
+        axis = 2;
+        break;
+    case VIBRATIONANALYSISSETTINGS_NOTCHSOURCE_STRONGEST:
+        axis = 0;
+        for (int8_t t = 1; t < AXES; t++) {
+            if (peakAmplitude[t] > peakAmplitude[axis]) {
+                axis = t;
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    // 0 keeps the notch where it is
+    output.NotchFrequency = (axis >= 0 && peakAmplitude[axis] >= settings.NotchMinAmplitude) ? peakFrequency[axis] : 0.0f;
+
+    VibrationAnalysisOutputSet(&output);
+}
+
+/**
+ * Reduce the bins 1 .. n / 2 to the largest value per band and find the
+ * largest bin from minFrequency on, its frequency interpolated by a parabola.
+ */
+static void reduceSpectrum(const float *mag, float binWidth, float minFrequency, float *bands, float *peakFrequency, float *peakAmplitude)
+{
+    const uint16_t bins    = windowSize / 2;
+    const uint16_t perBand = bins / BANDS;
+
+    for (uint8_t b = 0; b < BANDS; b++) {
+        float value = 0.0f;
+        for (uint16_t k = 1 + b * perBand; k <= (b + 1) * perBand; k++) {
+            value = fmaxf(value, mag[k]);
+        }
+        bands[b] = value;
+    }
+
+    uint16_t first = binWidth > 0.0f ? (uint16_t)boundf(minFrequency / binWidth, 1, bins - 1) : 1;
+    uint16_t peak = first;
+    for (uint16_t k = first + 1; k < bins; k++) {
+        if (mag[k] > mag[peak]) {
+            peak = k;
+        }
+    }
+
+    float delta = 0.0f;
+    const float den = mag[peak - 1] - 2.0f * mag[peak] + mag[peak + 1];
+    if (den < 0.0f) {
+        delta = 0.5f * (mag[peak - 1] - mag[peak + 1]) / den;
+    }
+    *peakFrequency = (peak + delta) * binWidth;
+    *peakAmplitude = mag[peak];
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -31,11 +31,22 @@
 #include <pios_ubx_ddc.h>
 
 #include "gps9gpshandler.h"
+#include "gps9maghandler.h"
 #include "gps9protocol.h"
+#include "gpsdsysmod.h"
+
+// the link goes back to the default speed when the flight controller stops asking for it
+#define LINK_TIMEOUT_MS 30000
 
 uint32_t lastUnsentData = 0;
 uint8_t buffer[BUFFER_SIZE];
 
+static uint32_t linkBaudRate = GPS_MODULE_DEFAULT_BAUDRATE;
+static uint32_t lastLinkRequest;
+
+static void parseLinkRequest(const uint8_t *data, int32_t count);
+static void setLinkBaudRate(uint32_t baudrate);
+
 void handleGPS()
 {
     bool completeSentenceSent = false;
@@ -53,6 +64,8 @@ void handleGPS()
             completeSentenceSent = ubx_getLastSentence(buffer, toRead, &lastSentence, &lastSentenceLength);
             if (completeSentenceSent) {
                 toSend = (uint8_t)(lastSentence - buffer + lastSentenceLength);
+                // the mag samples share the transfer with the GPS sentence
+                flushMag();
             } else {
                 lastUnsentData = 0;
             }
@@ -68,6 +81,7 @@ void handleGPS()
 
         datacounter = PIOS_COM_ReceiveBuffer(pios_com_main_id, buffer, BUFFER_SIZE, 0);
         if (datacounter > 0) {
+            parseLinkRequest(buffer, datacounter);
             PIOS_UBX_DDC_WriteData(PIOS_I2C_GPS, buffer, datacounter);
         }
         if (maxCount) {
@@ -76,6 +90,57 @@ void handleGPS()
             vTaskDelay(2 * configTICK_RATE_HZ / 1000);
         }
     } while (maxCount--);
+
+    if (linkBaudRate != GPS_MODULE_DEFAULT_BAUDRATE && PIOS_DELAY_DiffuS(lastLinkRequest) > LINK_TIMEOUT_MS * 1000) {
+        setLinkBaudRate(GPS_MODULE_DEFAULT_BAUDRATE);
+    }
+}
+
+/**
+ * Looks for the link speed request in the data from the flight controller.
+ * The data is forwarded to the GPS anyway, it ignores the custom class.
+ */
+static void parseLinkRequest(const uint8_t *data, int32_t count)
+{
+    static LinkUbxPkt request;
+    static uint8_t received;
+    const uint8_t header[] = { UBX_SYN1, UBX_SYN2, UBX_OP_CUST_CLASS, UBX_OP_LINK, sizeof(LinkData), 0 };
+
+    for (int32_t i = 0; i < count; i++) {
+        const uint8_t c = data[i];
+        if (received < sizeof(header) && c != header[received]) {
+            received = (c == UBX_SYN1) ? 1 : 0;
+            continue;
+        }
+        request.packet.binarystream[received++] = c;
+        if (received < sizeof(LinkUbxPkt)) {
+            continue;
+        }
+        received = 0;
+
+        const UBXFooter_t footer = request.fragments.footer;
+        ubx_appendChecksum(&request.packet);
+        if (footer.chk1 == request.fragments.footer.chk1 && footer.chk2 == request.fragments.footer.chk2) {
+            lastLinkRequest = PIOS_DELAY_GetRaw();
+            setLinkBaudRate(request.fragments.data.baudrate);
+        }
+    }
+}
+
+static void setLinkBaudRate(uint32_t baudrate)
+{
+    switch (baudrate) {
+    case 57600:
+    case 115200:
+    case 230400:
+        break;
+    default:
+        return;
+    }
+    if (baudrate != linkBaudRate) {
+        linkBaudRate = baudrate;
+        PIOS_COM_ChangeBaud(pios_com_main_id, linkBaudRate);
+    }
 }
 
 typedef struct {
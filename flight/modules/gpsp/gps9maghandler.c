@@ -29,9 +29,14 @@
 #include <ubx_utils.h>
 #include <pios_hmc5x83.h>
 #include "inc/gps9protocol.h"
-#define MAG_RATE_HZ 30
+#include "inc/gps9maghandler.h"
+#define MAG_RATE_HZ 75
 extern pios_hmc5x83_dev_t onboard_mag;
 
+// samples waiting for the next GPS sentence or a full batch
+static MagBatchUbxPkt batchPkt;
+static uint8_t batchCount;
+
 void handleMag()
 {
 #ifdef PIOS_HMC5X83_HAS_GPIOS
@@ -48,13 +53,26 @@ void handleMag()
     static int16_t mag[3];
 
     if (PIOS_HMC5x83_ReadMag(onboard_mag, mag) == 0) {
-        MagUbxPkt magPkt;
-        magPkt.fragments.data.X = mag[0];
-        magPkt.fragments.data.Y = mag[1];
-        magPkt.fragments.data.Z = mag[2];
-        magPkt.fragments.data.status = 1;
-        ubx_buildPacket(&magPkt.packet, UBX_OP_CUST_CLASS, UBX_OP_MAG, sizeof(MagData));
-        PIOS_COM_SendBuffer(pios_com_main_id, magPkt.packet.binarystream, sizeof(MagUbxPkt));
+        MagSample *sample = &batchPkt.fragments.data.samples[batchCount++];
+        sample->X    = mag[0];
+        sample->Y    = mag[1];
+        sample->Z    = mag[2];
+        sample->time = (uint16_t)(xTaskGetTickCount() * portTICK_RATE_MS);
+        if (batchCount == MAG_BATCH_SIZE) {
+            flushMag();
+        }
+    }
+}
+
+void flushMag()
+{
+    if (!batchCount) {
         return;
     }
+    const uint16_t len = sizeof(MagBatchData) - (MAG_BATCH_SIZE - batchCount) * sizeof(MagSample);
+    batchPkt.fragments.data.count  = batchCount;
+    batchPkt.fragments.data.status = 1;
+    ubx_buildPacket(&batchPkt.packet, UBX_OP_CUST_CLASS, UBX_OP_MAGBATCH, len);
+    PIOS_COM_SendBuffer(pios_com_main_id, batchPkt.packet.binarystream, UBX_HEADER_LEN + len + sizeof(UBXFooter_t));
+    batchCount = 0;
 }
@@ -119,10 +119,10 @@ static void gpspSystemTask(__attribute__((unused)) void *parameters)
 #if defined(PIOS_INCLUDE_IAP)
     PIOS_IAP_WriteBootCount(0);
 #endif
-    /* Right now there is no configuration and uart speed is fixed at 57600.
+    /* The uart starts at 57600, the flight controller may ask for a faster link, see handleGPS().
      * TODO:
      * 1) add a tiny ubx parser on gps side to intercept CFG-RINV and use that for config storage;
-     * 2) second ubx parser on uart side that intercept custom configuration message and flash commands.
+     * 2) intercept flash commands on the uart side.
      */
     PIOS_COM_ChangeBaud(pios_com_main_id, GPS_MODULE_DEFAULT_BAUDRATE);
     setupGPS();
@@ -201,7 +201,7 @@ static void updateStats()
 
     // Get stats and update
     sysPkt.fragments.data.flightTime = xTaskGetTickCount() * portTICK_RATE_MS;
-    sysPkt.fragments.data.options    = SYS_DATA_OPTIONS_MAG | (flash_available() ? SYS_DATA_OPTIONS_FLASH : 0);
+    sysPkt.fragments.data.options    = SYS_DATA_OPTIONS_MAG | SYS_DATA_OPTIONS_MAGBATCH | SYS_DATA_OPTIONS_LINK | (flash_available() ? SYS_DATA_OPTIONS_FLASH : 0);
     ubx_buildPacket(&sysPkt.packet, UBX_OP_CUST_CLASS, UBX_OP_SYS, sizeof(SysData));
     PIOS_COM_SendBuffer(pios_com_main_id, sysPkt.packet.binarystream, sizeof(SysUbxPkt));
 }
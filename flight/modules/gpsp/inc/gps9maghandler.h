@@ -27,6 +27,8 @@
 #define GPS9MAGHANDLER_H
 
 void handleMag();
+// sends the samples read since the last batch, the GPS sentences carry them along
+void flushMag();
 
 
 #endif
@@ -36,10 +36,16 @@
 #define UBX_OP_CUST_CLASS             0x99
 #define UBX_OP_SYS                    0x01
 #define UBX_OP_MAG                    0x02
+#define UBX_OP_MAGBATCH               0x03
+#define UBX_OP_LINK                   0x04
 
 
 #define SYS_DATA_OPTIONS_FLASH        0x01
 #define SYS_DATA_OPTIONS_MAG          0x02
+#define SYS_DATA_OPTIONS_MAGBATCH     0x04
+#define SYS_DATA_OPTIONS_LINK         0x08
+
+#define MAG_BATCH_SIZE                4
 
 #define CFG_PRT_DATA_PORTID_DDC       0x00
 #define CFG_PRT_DATA_TXREADI_DISABLED 0x00
@@ -67,6 +73,43 @@ typedef union {
     UBXPacket_t packet;
 } MagUbxPkt;
 
+typedef struct {
+    int16_t  X;
+    int16_t  Y;
+    int16_t  Z;
+    uint16_t time; // ms, low bits of the board clock
+} __attribute__((packed)) MagSample;
+
+// only the first count samples are sent
+typedef struct {
+    uint8_t   count;
+    uint8_t   status;
+    MagSample samples[MAG_BATCH_SIZE];
+} __attribute__((packed)) MagBatchData;
+
+typedef union {
+    struct {
+        UBXHeader_t  header;
+        MagBatchData data;
+        UBXFooter_t  footer;
+    } __attribute__((packed)) fragments;
+    UBXPacket_t packet;
+} MagBatchUbxPkt;
+
+// link speed requested by the flight controller
+typedef struct {
+    uint32_t baudrate;
+} __attribute__((packed)) LinkData;
+
+typedef union {
+    struct {
+        UBXHeader_t header;
+        LinkData    data;
+        UBXFooter_t footer;
+    } __attribute__((packed)) fragments;
+    UBXPacket_t packet;
+} LinkUbxPkt;
+
 typedef struct {
     uint32_t flightTime;
     uint16_t options;
@@ -157,6 +157,7 @@ static volatile portBASE_TYPE xSchedulerStarted = pdFALSE;
 static volatile portBASE_TYPE xInterruptsEnabled = pdFALSE;
 static volatile portBASE_TYPE xSchedulerNesting = 0;
 static volatile portBASE_TYPE xPendYield = pdFALSE;
+static volatile portBASE_TYPE xTickTaken = pdFALSE;
 static volatile portLONG lIndexOfLastAddedTask = 0;
 /*-----------------------------------------------------------*/
 
@@ -172,6 +173,13 @@ static xThreadState* prvGetThreadHandleByThread( pthread_t hThread );
 static portLONG prvGetFreeThreadState( void );
 static void prvDeleteThread( void *xThreadId );
 static void prvPortYield();
+static void prvWaitForIdle( void );
+
+/*
+ * Optional simulated time source (lockstep SITL). Called before each tick,
+ * it may block until the tick is due and returns pdFALSE to keep the wall clock.
+ */
+extern portBASE_TYPE xPortLockstepTick( void ) __attribute__((weak));
 /*-----------------------------------------------------------*/
 
 /*
@@ -303,6 +311,19 @@ portBASE_TYPE xPortStartScheduler( void )
 	
 	while ( pdTRUE != xSchedulerEnd )
 	{
+		/* lockstep: tick as soon as the previous one has been processed */
+		if ( xPortLockstepTick && xPortLockstepTick() ) {
+			xTickTaken = pdFALSE;
+			while ( pdTRUE != xSchedulerEnd && pdTRUE != xTickTaken ) {
+				vPortSystemTickHandler();
+				if ( pdTRUE != xTickTaken ) {
+					sched_yield();
+				}
+			}
+			prvWaitForIdle();
+			continue;
+		}
+
 		/* wait for the specified wait time */
 		wait.tv_sec = sleepTimeUS / 1000000;
 		wait.tv_nsec = 1000 * ( sleepTimeUS % 1000000 );
@@ -647,6 +668,7 @@ void vPortSystemTickHandler()
 	 * call tick handler
 	 */
 	xTaskIncrementTick();
+	xTickTaken = pdTRUE;
 
 	
 #if ( configUSE_PREEMPTION == 1 )
@@ -673,6 +695,19 @@ void vPortSystemTickHandler()
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * Simulated time must not move on while a task still has work for the
+ * current tick: wait until every task is blocked and the idle task runs.
+ */
+static void prvWaitForIdle( void )
+{
+	struct timespec wait = { 0, 10000 };
+	while ( pdTRUE != xSchedulerEnd && xTaskGetCurrentTaskHandle() != xTaskGetIdleTaskHandle() ) {
+		nanosleep( &wait, NULL );
+	}
+}
+/*-----------------------------------------------------------*/
+
 /**
  * thread kill implementation
  */
@@ -1324,6 +1324,154 @@ uint32_t DFS_WriteFile(PFILEINFO fileinfo, uint8_t *scratch, uint8_t *buffer, ui
 }
 
 
+/*
+        End of chain marker of the volume's FAT type
+*/
+static uint32_t DFS_EndOfChain(PVOLINFO volinfo)
+{
+        switch(volinfo->filesystem) {
+                case FAT12:             return 0xff8;
+                case FAT16:             return 0xfff8;
+                default:                return 0x0ffffff8;
+        }
+}
+
+/*
+        Write the file length of an open file into its directory entry
+*/
+uint32_t DFS_SetFileLength(PFILEINFO fileinfo, uint8_t *scratch, uint32_t len)
+{
+        fileinfo->filelen = len;
+        if (DFS_ReadSector(fileinfo->volinfo->unit, scratch, fileinfo->dirsector, 1))
+                return DFS_ERRMISC;
+        ((PDIRENT) scratch)[fileinfo->diroffset].filesize_0 = len & 0xff;
+        ((PDIRENT) scratch)[fileinfo->diroffset].filesize_1 = (len & 0xff00) >> 8;
+        ((PDIRENT) scratch)[fileinfo->diroffset].filesize_2 = (len & 0xff0000) >> 16;
+        ((PDIRENT) scratch)[fileinfo->diroffset].filesize_3 = (len & 0xff000000) >> 24;
+        if (DFS_WriteSector(fileinfo->volinfo->unit, scratch, fileinfo->dirsector, 1))
+                return DFS_ERRMISC;
+        return DFS_OK;
+}
+
+/*
+        Give an empty file just created by DFS_OpenFile a run of contiguous clusters
+        holding at least len bytes, so the data can be written sector by sector without
+        walking or updating the FAT. The file length stays 0.
+        On FAT16 and FAT32 the chain is written a FAT sector at a time.
+        Returns DFS_OK, or DFS_ERRMISC if there is no free run that long.
+*/
+uint32_t DFS_Preallocate(PFILEINFO fileinfo, uint8_t *scratch, uint32_t len)
+{
+        PVOLINFO volinfo = fileinfo->volinfo;
+        uint32_t clustersize = volinfo->secperclus * SECTOR_SIZE;
+        uint32_t count = (len + clustersize - 1) / clustersize;
+        uint32_t start = 2, run = 0, i, scratchcache = 0;
+
+        if (fileinfo->filelen || count == 0)
+                return DFS_ERRMISC;
+
+        // the cluster DFS_OpenFile allocated is reused if it is part of the run
+        if (DFS_SetFAT(volinfo, scratch, &scratchcache, fileinfo->firstcluster, 0))
+                return DFS_ERRMISC;
+
+        for (i = 2; i < volinfo->numclusters && run < count; i++) {
+                if (DFS_GetFAT(volinfo, scratch, &scratchcache, i)) {
+                        run = 0;
+                        start = i + 1;
+                }
+                else
+                        run++;
+        }
+        if (run < count) {
+                // give the file its cluster back
+                DFS_SetFAT(volinfo, scratch, &scratchcache, fileinfo->firstcluster, DFS_EndOfChain(volinfo));
+                return DFS_ERRMISC;
+        }
+
+        if (volinfo->filesystem == FAT12) {
+                for (i = start; i < start + count; i++) {
+                        if (DFS_SetFAT(volinfo, scratch, &scratchcache, i,
+                          (i == start + count - 1) ? DFS_EndOfChain(volinfo) : i + 1))
+                                return DFS_ERRMISC;
+                }
+        }
+        else {
+                uint32_t entrysize = (volinfo->filesystem == FAT16) ? 2 : 4;
+
+                i = start;
+                while (i < start + count) {
+                        uint32_t sector = volinfo->fat1 + (i * entrysize) / SECTOR_SIZE;
+
+                        if (DFS_ReadSector(volinfo->unit, scratch, sector, 1))
+                                return DFS_ERRMISC;
+                        // fill every entry of the run which is in this FAT sector
+                        do {
+                                uint32_t next = (i == start + count - 1) ? DFS_EndOfChain(volinfo) : i + 1;
+                                uint8_t *entry = &scratch[(i * entrysize) % SECTOR_SIZE];
+
+                                entry[0] = next & 0xff;
+                                entry[1] = (next & 0xff00) >> 8;
+                                if (entrysize == 4) {
+                                        entry[2] = (next & 0xff0000) >> 16;
+                                        entry[3] = (entry[3] & 0xf0) | ((next & 0x0f000000) >> 24);
+                                }
+                                i++;
+                        } while (i < start + count && (i * entrysize) % SECTOR_SIZE);
+
+                        if (DFS_WriteSector(volinfo->unit, scratch, sector, 1) ||
+                          DFS_WriteSector(volinfo->unit, scratch, sector + volinfo->secperfat, 1))
+                                return DFS_ERRMISC;
+                }
+        }
+
+        // point the directory entry to the run
+        if (DFS_ReadSector(volinfo->unit, scratch, fileinfo->dirsector, 1))
+                return DFS_ERRMISC;
+        ((PDIRENT) scratch)[fileinfo->diroffset].startclus_l_l = start & 0xff;
+        ((PDIRENT) scratch)[fileinfo->diroffset].startclus_l_h = (start & 0xff00) >> 8;
+        ((PDIRENT) scratch)[fileinfo->diroffset].startclus_h_l = (start & 0xff0000) >> 16;
+        ((PDIRENT) scratch)[fileinfo->diroffset].startclus_h_h = (start & 0xff000000) >> 24;
+        if (DFS_WriteSector(volinfo->unit, scratch, fileinfo->dirsector, 1))
+                return DFS_ERRMISC;
+
+        fileinfo->firstcluster = start;
+        fileinfo->cluster = start;
+        fileinfo->pointer = 0;
+        return DFS_OK;
+}
+
+/*
+        Set the length of an open file to len and free the clusters after it
+*/
+uint32_t DFS_Truncate(PFILEINFO fileinfo, uint8_t *scratch, uint32_t len)
+{
+        PVOLINFO volinfo = fileinfo->volinfo;
+        uint32_t clustersize = volinfo->secperclus * SECTOR_SIZE;
+        // the first cluster is always kept, an empty file still owns it
+        uint32_t keep = len ? (len + clustersize - 1) / clustersize : 1;
+        uint32_t cluster = fileinfo->firstcluster, next, scratchcache = 0;
+
+        while (--keep) {
+                cluster = DFS_GetFAT(volinfo, scratch, &scratchcache, cluster);
+                if (cluster < 2 || cluster >= DFS_EndOfChain(volinfo))
+                        return DFS_SetFileLength(fileinfo, scratch, len);
+        }
+
+        next = DFS_GetFAT(volinfo, scratch, &scratchcache, cluster);
+        if (next >= 2 && next < DFS_EndOfChain(volinfo)) {
+                if (DFS_SetFAT(volinfo, scratch, &scratchcache, cluster, DFS_EndOfChain(volinfo)))
+                        return DFS_ERRMISC;
+                while (next >= 2 && next < DFS_EndOfChain(volinfo)) {
+                        cluster = next;
+                        next = DFS_GetFAT(volinfo, scratch, &scratchcache, cluster);
+                        if (DFS_SetFAT(volinfo, scratch, &scratchcache, cluster, 0))
+                                return DFS_ERRMISC;
+                }
+        }
+
+        return DFS_SetFileLength(fileinfo, scratch, len);
+}
+
 /*
 // TK: added 2009-02-12
         Close a file
@@ -377,6 +377,31 @@ uint32_t DFS_UnlinkFile(PVOLINFO volinfo, uint8_t *path, uint8_t *scratch);
 */
 uint32_t DFS_GetFAT(PVOLINFO volinfo, uint8_t *scratch, uint32_t *scratchcache, uint32_t cluster);
 
+/*
+        Write the file length of an open file into its directory entry
+        scratch must point to a sector-sized buffer
+*/
+uint32_t DFS_SetFileLength(PFILEINFO fileinfo, uint8_t *scratch, uint32_t len);
+
+/*
+        Allocate contiguous clusters for at least len bytes to a file just created
+        with DFS_OpenFile, its sectors start at DFS_FileSector(fileinfo, 0).
+        The file length is not changed, see DFS_SetFileLength.
+        Returns DFS_OK, or DFS_ERRMISC if there is no free run that long.
+*/
+uint32_t DFS_Preallocate(PFILEINFO fileinfo, uint8_t *scratch, uint32_t len);
+
+/*
+        Set the length of an open file and free the clusters after it
+        scratch must point to a sector-sized buffer
+*/
+uint32_t DFS_Truncate(PFILEINFO fileinfo, uint8_t *scratch, uint32_t len);
+
+/*
+        Physical sector of a file sector, only valid for preallocated files
+*/
+#define DFS_FileSector(fileinfo, n) ((fileinfo)->volinfo->dataarea + (((fileinfo)->firstcluster - 2) * (fileinfo)->volinfo->secperclus) + (n))
+
 /*
 // TK: added 2009-02-12
         Close a file
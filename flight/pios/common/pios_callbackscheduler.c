@@ -36,14 +36,21 @@
 #define STACK_SIZE        (190 + STACK_SAFETYSIZE)
 #define STACK_SAFETYSIZE  8
 #define MAX_SLEEP         1000
+#define HISTOGRAM_FIRST   16 // upper bound of the first histogram bin in us, each further bin is 4 times wider
 
 // Private types
 /**
  * task information
+ * callbackQueue holds all callbacks of a priority, readyQueue is a lock free
+ * stack that any task or ISR pushes dispatched callbacks onto, and readyBatch
+ * is the batch the scheduler task took off it last, in dispatch order.
  */
 struct DelayedCallbackTaskStruct {
     DelayedCallbackInfo *callbackQueue[CALLBACK_PRIORITY_LOW + 1];
-    DelayedCallbackInfo *queueCursor[CALLBACK_PRIORITY_LOW + 1];
+    DelayedCallbackInfo *readyQueue[CALLBACK_PRIORITY_LOW + 1];
+    DelayedCallbackInfo *readyBatch[CALLBACK_PRIORITY_LOW + 1];
+    bool lowerServed[CALLBACK_PRIORITY_LOW + 1];
+    uint32_t volatile nextSchedule;
     xTaskHandle callbackSchedulerTaskHandle;
     char name[3];
     uint32_t    stackSize;
@@ -58,8 +65,12 @@ struct DelayedCallbackTaskStruct {
 struct DelayedCallbackInfoStruct {
     DelayedCallback   cb;
     int16_t callbackID;
+    DelayedCallbackPriority priority;
     bool volatile     waiting;
     uint32_t volatile scheduletime;
+    uint32_t dispatchTime;
+    uint32_t runTimeHistogram[PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS];
+    uint32_t latencyHistogram[PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS];
     uint32_t stackSize;
     int32_t  stackFree;
     int32_t  stackNotFree;
@@ -68,6 +79,7 @@ struct DelayedCallbackInfoStruct {
     uint32_t runCount;
     struct DelayedCallbackTaskStruct *task;
     struct DelayedCallbackInfoStruct *next;
+    struct DelayedCallbackInfoStruct *readyNext;
 };
 
 
@@ -78,7 +90,59 @@ static bool schedulerStarted;
 
 // Private functions
 static void CallbackSchedulerTask(void *task);
-static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority);
+static bool runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority);
+static int32_t dispatchScheduled(struct DelayedCallbackTaskStruct *task);
+
+/**
+ * Mark a callback as waiting and push it onto the ready queue of its priority.
+ * Lock free, safe to call from any task and from ISRs.
+ * \return true if the callback was queued, false if it was already waiting
+ */
+static bool pushReady(DelayedCallbackInfo *cbinfo)
+{
+    if (__atomic_exchange_n(&cbinfo->waiting, true, __ATOMIC_ACQ_REL)) {
+        return false; // already queued, will run anyway
+    }
+    cbinfo->dispatchTime = PIOS_DELAY_GetRaw();
+
+    DelayedCallbackInfo **head = &cbinfo->task->readyQueue[cbinfo->priority];
+    DelayedCallbackInfo *top   = __atomic_load_n(head, __ATOMIC_RELAXED);
+    do {
+        cbinfo->readyNext = top;
+    } while (!__atomic_compare_exchange_n(head, &top, cbinfo, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    return true;
+}
+
+/**
+ * Take everything off a ready queue, the stack is reversed to restore dispatch order.
+ * Only called by the scheduler task owning the queue.
+ */
+static DelayedCallbackInfo *takeReady(DelayedCallbackInfo **head)
+{
+    DelayedCallbackInfo *stack = __atomic_exchange_n(head, NULL, __ATOMIC_ACQUIRE);
+    DelayedCallbackInfo *batch = NULL;
+
+    while (stack) {
+        DelayedCallbackInfo *next = stack->readyNext;
+        stack->readyNext = batch;
+        batch = stack;
+        stack = next;
+    }
+    return batch;
+}
+
+/**
+ * Count a duration in us into a histogram
+ */
+static void addToHistogram(uint32_t *histogram, uint32_t us)
+{
+    uint8_t bin = 0;
+
+    for (uint32_t limit = HISTOGRAM_FIRST; bin < PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS - 1 && us >= limit; limit *= 4) {
+        bin++;
+    }
+    histogram[bin]++;
+}
 
 /**
  * Initialize the scheduler
@@ -187,6 +251,9 @@ int32_t PIOS_CALLBACKSCHEDULER_Schedule(
             result = 2;
         }
         cbinfo->scheduletime = new;
+        if (!cbinfo->task->nextSchedule || (int32_t)(new - cbinfo->task->nextSchedule) < 0) {
+            cbinfo->task->nextSchedule = new;
+        }
 
         // scheduler needs to be notified to adapt sleep times
         xSemaphoreGive(cbinfo->task->signal);
@@ -208,7 +275,9 @@ int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo)
     PIOS_Assert(cbinfo);
 
     // no semaphore needed for the callback
-    cbinfo->waiting = true;
+    if (!pushReady(cbinfo)) {
+        return pdTRUE;
+    }
     // but the scheduler as a whole needs to be notified
     return xSemaphoreGive(cbinfo->task->signal);
 }
@@ -232,7 +301,9 @@ int32_t PIOS_CALLBACKSCHEDULER_DispatchFromISR(DelayedCallbackInfo *cbinfo, long
     PIOS_Assert(cbinfo);
 
     // no semaphore needed for the callback
-    cbinfo->waiting = true;
+    if (!pushReady(cbinfo)) {
+        return pdTRUE;
+    }
     // but the scheduler as a whole needs to be notified
     return xSemaphoreGiveFromISR(cbinfo->task->signal, pxHigherPriorityTaskWoken);
 }
@@ -282,8 +353,11 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
         // initialize structure
         for (DelayedCallbackPriority p = 0; p <= CALLBACK_PRIORITY_LOW; p++) {
             task->callbackQueue[p] = NULL;
-            task->queueCursor[p]   = NULL;
+            task->readyQueue[p]    = NULL;
+            task->readyBatch[p]    = NULL;
+            task->lowerServed[p]   = false;
         }
+        task->nextSchedule = 0;
         task->name[0]      = 'C';
         task->name[1]      = 'a' + t;
         task->name[2]      = 0;
@@ -335,6 +409,8 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
         return NULL; // error - not enough memory
     }
     info->next               = NULL;
+    info->readyNext          = NULL;
+    info->priority           = priority;
     info->waiting            = false;
     info->scheduletime       = 0;
     info->task               = task;
@@ -346,6 +422,11 @@ DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(
     info->stackFree          = 0;
     info->stackSafetyCount   = STACK_SAFETYCOUNT;
     info->currentSafetyCount = 0;
+    info->dispatchTime       = 0;
+    for (uint8_t b = 0; b < PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS; b++) {
+        info->runTimeHistogram[b] = 0;
+        info->latencyHistogram[b] = 0;
+    }
 
     // add to scheduling queue
     LL_APPEND(task->callbackQueue[priority], info);
@@ -380,6 +461,8 @@ void PIOS_CALLBACKSCHEDULER_ForEachCallback(CallbackSchedulerCallbackInfoCallbac
                 info.is_running = true;
                 info.stack_remaining    = cbinfo->stackNotFree;
                 info.running_time_count = cbinfo->runCount;
+                memcpy(info.run_time_histogram, cbinfo->runTimeHistogram, sizeof(info.run_time_histogram));
+                memcpy(info.latency_histogram, cbinfo->latencyHistogram, sizeof(info.latency_histogram));
                 xSemaphoreGiveRecursive(mutex);
                 callback(cbinfo->callbackID, &info, context);
             }
@@ -387,6 +470,43 @@ void PIOS_CALLBACKSCHEDULER_ForEachCallback(CallbackSchedulerCallbackInfoCallbac
     }
 }
 
+/**
+ * Retrieves the information of the n-th callback, in the order of PIOS_CALLBACKSCHEDULER_ForEachCallback().
+ * Only the list is walked up to it, the copy is done for that callback alone.
+ *
+ * @param[in]  index        Position of the callback
+ * @param[out] callback_id  The id the callback was created with
+ * @param[out] info         Receives the information about the callback
+ * @return true if there is a callback at that position, false past the last one
+ */
+bool PIOS_CALLBACKSCHEDULER_GetCallbackInfo(uint16_t index, int16_t *callback_id, struct pios_callback_info *info)
+{
+    struct DelayedCallbackTaskStruct *task = NULL;
+
+    LL_FOREACH(schedulerTasks, task) {
+        int prio;
+
+        for (prio = 0; prio < (CALLBACK_PRIORITY_LOW + 1); prio++) {
+            struct DelayedCallbackInfoStruct *cbinfo;
+            LL_FOREACH(task->callbackQueue[prio], cbinfo) {
+                if (index--) {
+                    continue;
+                }
+                xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+                info->is_running = true;
+                info->stack_remaining    = cbinfo->stackNotFree;
+                info->running_time_count = cbinfo->runCount;
+                memcpy(info->run_time_histogram, cbinfo->runTimeHistogram, sizeof(info->run_time_histogram));
+                memcpy(info->latency_histogram, cbinfo->latencyHistogram, sizeof(info->latency_histogram));
+                xSemaphoreGiveRecursive(mutex);
+                *callback_id = cbinfo->callbackID;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 /**
  * Stack magic, find how much stack is being used without affecting performance
  */
@@ -458,75 +578,109 @@ static void checkStack(DelayedCallbackInfo *current)
 }
 
 /**
- * Scheduler subtask
+ * Dispatch all callbacks whose schedule is due
  * \param[in] task The scheduler task in question
- * \param[in] priority The scheduling priority of the callback to search for
- * \return wait time until next scheduled callback is due - 0 if a callback has just been executed
+ * \return wait time until the next scheduled callback is due
  */
-static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority)
+static int32_t dispatchScheduled(struct DelayedCallbackTaskStruct *task)
 {
-    int32_t result = MAX_SLEEP;
-    int32_t diff   = 0;
+    uint32_t next = task->nextSchedule;
 
-    // no such queue
-    if (priority > CALLBACK_PRIORITY_LOW) {
-        return result;
+    if (!next) {
+        return MAX_SLEEP;
     }
-
-    // queue is empty, search a lower priority queue
-    if (task->callbackQueue[priority] == NULL) {
-        return runNextCallback(task, priority + 1);
+    int32_t diff = next - xTaskGetTickCount();
+    if (diff > 0) {
+        return diff < MAX_SLEEP ? diff : MAX_SLEEP;
     }
 
-    DelayedCallbackInfo *current = task->queueCursor[priority];
-    DelayedCallbackInfo *next;
-    do {
-        if (current == NULL) {
-            next = task->callbackQueue[priority]; // loop around the end of the list
-            // also attempt to run a callback that has lower priority
-            // every time the queue is completely traversed
-            diff = runNextCallback(task, priority + 1);
-            if (!diff) {
-                task->queueCursor[priority] = next; // the recursive call has executed a callback
-                return 0;
-            }
-            if (diff < result) {
-                result = diff; // adjust sleep time
-            }
-        } else {
-            next = current->next;
-            xSemaphoreTakeRecursive(mutex, portMAX_DELAY); // access to scheduletime should be mutex protected
-            if (current->scheduletime) {
-                diff = current->scheduletime - xTaskGetTickCount();
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY); // access to scheduletime should be mutex protected
+    uint32_t now = xTaskGetTickCount();
+    int32_t result = INT32_MAX;
+    for (DelayedCallbackPriority p = 0; p <= CALLBACK_PRIORITY_LOW; p++) {
+        DelayedCallbackInfo *cbinfo;
+        LL_FOREACH(task->callbackQueue[p], cbinfo) {
+            if (cbinfo->scheduletime) {
+                diff = cbinfo->scheduletime - now;
                 if (diff <= 0) {
-                    current->waiting = true;
+                    cbinfo->scheduletime = 0;
+                    pushReady(cbinfo);
                 } else if (diff < result) {
-                    result = diff; // adjust sleep time
+                    result = diff;
                 }
             }
-            if (current->waiting) {
-                task->queueCursor[priority] = next;
-                current->scheduletime = 0; // any schedules are reset
-                current->waiting = false; // the flag is reset just before execution.
-                xSemaphoreGiveRecursive(mutex);
-
-                /* callback gets invoked here - check stack sizes */
-                markStack(current);
-
-                current->cb(); // call the callback
+        }
+    }
+    if (result == INT32_MAX) {
+        task->nextSchedule = 0;
+        result = MAX_SLEEP;
+    } else {
+        task->nextSchedule = (now + result) ? (now + result) : 1;
+    }
+    xSemaphoreGiveRecursive(mutex);
 
-                checkStack(current);
+    return result < MAX_SLEEP ? result : MAX_SLEEP;
+}
 
-                current->runCount++;
+/**
+ * Scheduler subtask
+ * Runs the next callback of the current batch of a priority. Whenever a batch
+ * is used up the next lower priority gets one slot before a new batch is taken.
+ * \param[in] task The scheduler task in question
+ * \param[in] priority The scheduling priority of the callback to search for
+ * \return true if a callback has just been executed
+ */
+static bool runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCallbackPriority priority)
+{
+    // no such queue
+    if (priority > CALLBACK_PRIORITY_LOW) {
+        return false;
+    }
 
-                return 0;
+    if (!task->readyBatch[priority]) {
+        bool lowerTried = false;
+        if (!task->lowerServed[priority]) {
+            task->lowerServed[priority] = true;
+            if (runNextCallback(task, priority + 1)) {
+                return true;
             }
-            xSemaphoreGiveRecursive(mutex);
+            lowerTried = true;
         }
-        current = next;
-    } while (current != task->queueCursor[priority]);
-    // once the list has been traversed entirely without finding any to be executed task, abort (nothing to do)
-    return result;
+        task->readyBatch[priority] = takeReady(&task->readyQueue[priority]);
+        if (!task->readyBatch[priority]) {
+            // nothing waiting at this priority, search a lower priority queue
+            return !lowerTried && runNextCallback(task, priority + 1);
+        }
+        task->lowerServed[priority] = false;
+    }
+
+    DelayedCallbackInfo *current = task->readyBatch[priority];
+    task->readyBatch[priority] = current->readyNext;
+
+    if (current->scheduletime) {
+        xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+        current->scheduletime = 0; // any schedules are reset
+        xSemaphoreGiveRecursive(mutex);
+    }
+    // the flag is reset just before execution, a dispatch from now on queues it again
+    __atomic_store_n(&current->waiting, false, __ATOMIC_RELEASE);
+
+    addToHistogram(current->latencyHistogram, PIOS_DELAY_DiffuS(current->dispatchTime));
+    uint32_t start = PIOS_DELAY_GetRaw();
+
+    /* callback gets invoked here - check stack sizes */
+    markStack(current);
+
+    PIOS_EVENTTRACE(PIOS_EVENTTRACE_CALLBACK_START, current->callbackID);
+    current->cb(); // call the callback
+    PIOS_EVENTTRACE(PIOS_EVENTTRACE_CALLBACK_END, current->callbackID);
+
+    checkStack(current);
+
+    addToHistogram(current->runTimeHistogram, PIOS_DELAY_DiffuS(start));
+    current->runCount++;
+
+    return true;
 }
 
 /**
@@ -535,11 +689,11 @@ static int32_t runNextCallback(struct DelayedCallbackTaskStruct *task, DelayedCa
  */
 static void CallbackSchedulerTask(void *task)
 {
-    uint32_t delay = 0;
+    int32_t delay = 0;
 
     while (1) {
-        delay = runNextCallback((struct DelayedCallbackTaskStruct *)task, CALLBACK_PRIORITY_CRITICAL);
-        if (delay) {
+        delay = dispatchScheduled((struct DelayedCallbackTaskStruct *)task);
+        if (!runNextCallback((struct DelayedCallbackTaskStruct *)task, CALLBACK_PRIORITY_CRITICAL)) {
             // nothing to do but sleep
             xSemaphoreTake(((struct DelayedCallbackTaskStruct *)task)->signal, delay);
         }
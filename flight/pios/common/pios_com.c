@@ -101,6 +101,7 @@ static struct pios_com_dev *PIOS_COM_alloc(void)
 #endif /* if defined(PIOS_INCLUDE_FREERTOS) */
 
 static uint16_t PIOS_COM_TxOutCallback(uint32_t context, uint8_t *buf, uint16_t buf_len, uint16_t *headroom, bool *need_yield);
+static uint16_t PIOS_COM_TxRegionCallback(uint32_t context, uint16_t bytes_sent, uint8_t **region, bool *need_yield);
 static uint16_t PIOS_COM_RxInCallback(uint32_t context, uint8_t *buf, uint16_t buf_len, uint16_t *headroom, bool *need_yield);
 static void PIOS_COM_UnblockRx(struct pios_com_dev *com_dev, bool *need_yield);
 static void PIOS_COM_UnblockTx(struct pios_com_dev *com_dev, bool *need_yield);
@@ -155,6 +156,10 @@ int32_t PIOS_COM_Init(uint32_t *com_id, const struct pios_com_driver *driver, ui
         vSemaphoreCreateBinary(com_dev->tx_sem);
 #endif /* PIOS_INCLUDE_FREERTOS */
         (com_dev->driver->bind_tx_cb)(lower_id, PIOS_COM_TxOutCallback, (uint32_t)com_dev);
+        if (com_dev->driver->bind_tx_region_cb) {
+            /* Let the driver send straight out of the fifo */
+            (com_dev->driver->bind_tx_region_cb)(lower_id, PIOS_COM_TxRegionCallback, (uint32_t)com_dev);
+        }
     }
 #if defined(PIOS_INCLUDE_FREERTOS)
     com_dev->sendbuffer_sem = xSemaphoreCreateMutex();
@@ -259,6 +264,25 @@ static uint16_t PIOS_COM_TxOutCallback(uint32_t context, uint8_t *buf, uint16_t
     return bytes_from_fifo;
 }
 
+static uint16_t PIOS_COM_TxRegionCallback(uint32_t context, uint16_t bytes_sent, uint8_t **region, bool *need_yield)
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)context;
+
+    bool valid = PIOS_COM_validate(com_dev);
+
+    PIOS_Assert(valid);
+    PIOS_Assert(region);
+    PIOS_Assert(com_dev->has_tx);
+
+    if (bytes_sent > 0) {
+        /* The region has left the fifo, more space has been made in the buffer */
+        fifoBuf_removeData(&com_dev->tx, bytes_sent);
+        PIOS_COM_UnblockTx(com_dev, need_yield);
+    }
+
+    return fifoBuf_getContiguous(&com_dev->tx, region);
+}
+
 /**
  * Change the port speed without re-initializing
  * \param[in] port COM port
@@ -570,6 +594,77 @@ check_again:
     return bytes_from_fifo;
 }
 
+/**
+ * Zero copy rx: get the contiguous bytes at the head of the port buffer
+ * without removing them, PIOS_COM_ReleaseRegion() must follow once they are used
+ * \param[in] port COM port
+ * \param[out] region first byte of the region
+ * \param[in] timeout_ms how long to wait for some bytes
+ * \returns number of bytes in the region, 0 on timeout
+ */
+uint16_t PIOS_COM_ReceiveRegion(uint32_t com_id, uint8_t **region, uint32_t timeout_ms)
+{
+    PIOS_Assert(region);
+    uint16_t bytes_in_region;
+
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        PIOS_Assert(0);
+    }
+    PIOS_Assert(com_dev->has_rx);
+
+check_again:
+    bytes_in_region = fifoBuf_getContiguous(&com_dev->rx, region);
+
+    if (bytes_in_region == 0) {
+        /* Make sure the receiver is running while we wait */
+        if (com_dev->driver->rx_start) {
+            (com_dev->driver->rx_start)(com_dev->lower_id,
+                                        fifoBuf_getFree(&com_dev->rx));
+        }
+        if (timeout_ms > 0) {
+#if defined(PIOS_INCLUDE_FREERTOS)
+            if (xSemaphoreTake(com_dev->rx_sem, timeout_ms / portTICK_RATE_MS) == pdTRUE) {
+                timeout_ms = 0;
+                goto check_again;
+            }
+#else
+            PIOS_DELAY_WaitmS(1);
+            timeout_ms--;
+            goto check_again;
+#endif
+        }
+    }
+
+    return bytes_in_region;
+}
+
+/**
+ * Remove the bytes of a region got with PIOS_COM_ReceiveRegion() from the port buffer
+ * \param[in] port COM port
+ * \param[in] len number of bytes used, at most the region length
+ */
+void PIOS_COM_ReleaseRegion(uint32_t com_id, uint16_t len)
+{
+    struct pios_com_dev *com_dev = (struct pios_com_dev *)com_id;
+
+    if (!PIOS_COM_validate(com_dev)) {
+        /* Undefined COM port for this board (see pios_board.c) */
+        PIOS_Assert(0);
+    }
+    PIOS_Assert(com_dev->has_rx);
+
+    fifoBuf_removeData(&com_dev->rx, len);
+
+    if (com_dev->driver->rx_start) {
+        /* Notify the lower layer that there is now room in the rx buffer */
+        (com_dev->driver->rx_start)(com_dev->lower_id,
+                                    fifoBuf_getFree(&com_dev->rx));
+    }
+}
+
 /**
  * Query if a com port is available for use.  That can be
  * used to check a link is established even if the device
@@ -41,11 +41,17 @@ extern uintptr_t pios_user_fs_id; // flash filesystem for logging
 
 #if defined(PIOS_INCLUDE_FREERTOS)
 static xSemaphoreHandle mutex = 0;
-#define mutexlock()   xSemaphoreTakeRecursive(mutex, portMAX_DELAY)
-#define mutexunlock() xSemaphoreGiveRecursive(mutex)
+#define mutexlock()       xSemaphoreTakeRecursive(mutex, portMAX_DELAY)
+#define mutexunlock()     xSemaphoreGiveRecursive(mutex)
+// separate from the flash mutex, so Printf never waits for flash writes
+static xSemaphoreHandle textmutex = 0;
+#define textmutexlock()   xSemaphoreTakeRecursive(textmutex, portMAX_DELAY)
+#define textmutexunlock() xSemaphoreGiveRecursive(textmutex)
 #else
 #define mutexlock()
 #define mutexunlock()
+#define textmutexlock()
+#define textmutexunlock()
 #endif
 
 static bool logging_enabled = false;
@@ -66,8 +72,35 @@ static DebugLogEntryData staticbuffer;
 
 static uint32_t used_buffer_space = 0;
 
+// entries are queued in a ring by the producers and written to flash by PIOS_DEBUGLOG_Flush()
+#ifndef PIOS_DEBUGLOG_RING_SIZE
+#define PIOS_DEBUGLOG_RING_SIZE 4096 /* must be a power of 2 */
+#endif
+#define RING_MASK     (PIOS_DEBUGLOG_RING_SIZE - 1)
+#define RING_ALIGN(x) (((x) + 3) & ~3)
+
+struct ring_entry {
+    uint32_t time;
+    uint32_t objid; // 0 for text entries
+    uint16_t instid;
+    uint16_t size;
+};
+
+static uint8_t *ring = 0;
+#if !defined(PIOS_INCLUDE_FREERTOS)
+static uint8_t staticring[PIOS_DEBUGLOG_RING_SIZE];
+#endif
+// head is only written by the producers, tail only by the consumer
+static volatile uint32_t ring_head = 0;
+static volatile uint32_t ring_tail = 0;
+static uint32_t dropped = 0;
+static char textbuffer[LOG_ENTRY_MAX_DATA_SIZE];
+
 /* Private Function Prototypes */
-static void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data);
+static void ring_push(uint32_t objid, uint16_t instid, size_t size, const uint8_t *data);
+static void ring_copy(uint8_t *dst, uint32_t pos, size_t size);
+static bool enqueue_data(struct ring_entry *header);
+static bool write_text(struct ring_entry *header);
 static bool write_current_buffer();
 /**
  * @brief Initialize the log facility
@@ -77,15 +110,20 @@ void PIOS_DEBUGLOG_Initialize()
 #if defined(PIOS_INCLUDE_FREERTOS)
     if (!mutex) {
         mutex  = xSemaphoreCreateRecursiveMutex();
+        textmutex = xSemaphoreCreateRecursiveMutex();
         buffer = pios_malloc(sizeof(DebugLogEntryData));
+        ring   = pios_malloc(PIOS_DEBUGLOG_RING_SIZE);
     }
 #else
     buffer = &staticbuffer;
+    ring   = staticring;
 #endif
-    if (!buffer) {
+    if (!buffer || !ring) {
         return;
     }
     mutexlock();
+    ring_tail   = ring_head;
+    dropped     = 0;
     lognum      = 0;
     flightnum   = 0;
     fails_count = 0;
@@ -114,6 +152,7 @@ void PIOS_DEBUGLOG_Enable(uint8_t enabled)
 
 /**
  * @brief Write a debug log entry with a uavobject
+ * The entry is only queued, this does not block and can be called from any task.
  * @param[in] objectid
  * @param[in] instanceid
  * @param[in] instanceid
@@ -122,14 +161,10 @@ void PIOS_DEBUGLOG_Enable(uint8_t enabled)
  */
 void PIOS_DEBUGLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
 {
-    if (!logging_enabled || !buffer || log_is_full) {
+    if (!logging_enabled || !ring || log_is_full) {
         return;
     }
-    mutexlock();
-
-    enqueue_data(objid, instid, size, data);
-
-    mutexunlock();
+    ring_push(objid, instid, size, data);
 }
 /**
  * @brief Write a debug log entry with text
@@ -139,31 +174,42 @@ void PIOS_DEBUGLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, uint8
  */
 void PIOS_DEBUGLOG_Printf(char *format, ...)
 {
-    if (!logging_enabled || !buffer || log_is_full) {
+    if (!logging_enabled || !ring || log_is_full) {
         return;
     }
 
     va_list args;
     va_start(args, format);
-    mutexlock();
-    // flush any pending buffer before writing debug text
-    if (used_buffer_space) {
-        write_current_buffer();
-    }
-    memset(buffer->Data, 0xff, sizeof(buffer->Data));
-    vsnprintf((char *)buffer->Data, sizeof(buffer->Data), (char *)format, args);
-    buffer->Flight     = flightnum;
-
-    buffer->FlightTime = PIOS_DELAY_GetuS();
+    textmutexlock();
+    vsnprintf(textbuffer, sizeof(textbuffer), (char *)format, args);
+    ring_push(0, 0, strlen(textbuffer), (const uint8_t *)textbuffer);
+    textmutexunlock();
+    va_end(args);
+}
 
-    buffer->Entry      = lognum;
-    buffer->Type       = DEBUGLOGENTRY_TYPE_TEXT;
-    buffer->ObjectID   = 0;
-    buffer->InstanceID = 0;
-    buffer->Size       = strlen((const char *)buffer->Data);
+/**
+ * @brief Write the queued log entries to flash
+ * Called periodically from a low priority task, this is the only consumer of the queue.
+ */
+void PIOS_DEBUGLOG_Flush(void)
+{
+    if (!buffer || !ring) {
+        return;
+    }
+    mutexlock();
+    while (ring_tail != ring_head) {
+        struct ring_entry header;
 
-    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
-        lognum++;
+        if (log_is_full) {
+            ring_tail = ring_head;
+            break;
+        }
+        ring_copy((uint8_t *)&header, ring_tail, sizeof(header));
+        if (!(header.objid ? enqueue_data(&header) : write_text(&header))) {
+            // flash write failed, keep the entry queued and retry on the next flush
+            break;
+        }
+        ring_tail = ring_tail + sizeof(header) + RING_ALIGN(header.size);
     }
     mutexunlock();
 }
@@ -212,6 +258,14 @@ void PIOS_DEBUGLOG_Info(uint16_t *flight, uint16_t *entry, uint16_t *free, uint1
     }
 }
 
+/**
+ * @brief Number of log entries dropped because the queue was full
+ */
+uint32_t PIOS_DEBUGLOG_Dropped(void)
+{
+    return dropped;
+}
+
 /**
  * @brief Format entire flash memory!!!
  */
@@ -219,6 +273,8 @@ void PIOS_DEBUGLOG_Format(void)
 {
     mutexlock();
     PIOS_FLASHFS_Format(pios_user_fs_id);
+    ring_tail   = ring_head;
+    dropped     = 0;
     lognum      = 0;
     flightnum   = 0;
     log_is_full = false;
@@ -227,9 +283,52 @@ void PIOS_DEBUGLOG_Format(void)
     mutexunlock();
 }
 
-void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
+static void ring_push(uint32_t objid, uint16_t instid, size_t size, const uint8_t *data)
+{
+    if (size > LOG_ENTRY_MAX_DATA_SIZE) {
+        size = LOG_ENTRY_MAX_DATA_SIZE;
+    }
+    struct ring_entry header = {
+        .time   = PIOS_DELAY_GetuS(),
+        .objid  = objid,
+        .instid = instid,
+        .size   = size,
+    };
+    uint32_t length = sizeof(header) + RING_ALIGN(size);
+
+    // producers are serialized by masking interrupts during the copy, the consumer never locks out producers
+    PIOS_IRQ_Disable();
+    uint32_t head = ring_head;
+    if (PIOS_DEBUGLOG_RING_SIZE - (head - ring_tail) < length) {
+        dropped++;
+    } else {
+        uint32_t pos   = head & RING_MASK;
+        uint32_t first = MIN(sizeof(header), PIOS_DEBUGLOG_RING_SIZE - pos);
+        memcpy(&ring[pos], &header, first);
+        memcpy(ring, (uint8_t *)&header + first, sizeof(header) - first);
+        pos   = (pos + sizeof(header)) & RING_MASK;
+        first = MIN(size, PIOS_DEBUGLOG_RING_SIZE - pos);
+        memcpy(&ring[pos], data, first);
+        memcpy(ring, data + first, size - first);
+        // the entry must be complete before the consumer sees the new head
+        __sync_synchronize();
+        ring_head = head + length;
+    }
+    PIOS_IRQ_Enable();
+}
+
+static void ring_copy(uint8_t *dst, uint32_t pos, size_t size)
+{
+    pos &= RING_MASK;
+    uint32_t first = MIN(size, PIOS_DEBUGLOG_RING_SIZE - pos);
+    memcpy(dst, &ring[pos], first);
+    memcpy(dst + first, ring, size - first);
+}
+
+static bool enqueue_data(struct ring_entry *header)
 {
     DebugLogEntryData *entry;
+    size_t size = header->size;
 
     // start a new block
     if (!used_buffer_space) {
@@ -241,7 +340,7 @@ void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
         if (used_buffer_space + size + LOG_ENTRY_HEADER_SIZE > LOG_ENTRY_MAX_DATA_SIZE) {
             buffer->Type = DEBUGLOGENTRY_TYPE_MULTIPLEUAVOBJECTS;
             if (!write_current_buffer()) {
-                return;
+                return false;
             }
             entry = buffer;
             memset(buffer->Data, 0xff, sizeof(buffer->Data));
@@ -253,20 +352,48 @@ void enqueue_data(uint32_t objid, uint16_t instid, size_t size, uint8_t *data)
     }
 
     entry->Flight     = flightnum;
-    entry->FlightTime = PIOS_DELAY_GetuS();
+    entry->FlightTime = header->time;
     entry->Entry = lognum;
     entry->Type = DEBUGLOGENTRY_TYPE_UAVOBJECT;
-    entry->ObjectID   = objid;
-    entry->InstanceID = instid;
-    if (size > sizeof(buffer->Data)) {
-        size = sizeof(buffer->Data);
-    }
+    entry->ObjectID   = header->objid;
+    entry->InstanceID = header->instid;
     entry->Size = size;
 
-    memcpy(entry->Data, data, size);
+    ring_copy(entry->Data, ring_tail + sizeof(*header), size);
+    return true;
+}
+
+static bool write_text(struct ring_entry *header)
+{
+    // flush any pending buffer before writing debug text
+    if (used_buffer_space) {
+        if (used_buffer_space > buffer->Size) {
+            buffer->Type = DEBUGLOGENTRY_TYPE_MULTIPLEUAVOBJECTS;
+        }
+        if (!write_current_buffer()) {
+            return false;
+        }
+    }
+    memset(buffer->Data, 0xff, sizeof(buffer->Data));
+    ring_copy(buffer->Data, ring_tail + sizeof(*header), header->size);
+    if (header->size < LOG_ENTRY_MAX_DATA_SIZE) {
+        buffer->Data[header->size] = 0;
+    }
+    buffer->Flight     = flightnum;
+    buffer->FlightTime = header->time;
+    buffer->Entry      = lognum;
+    buffer->Type       = DEBUGLOGENTRY_TYPE_TEXT;
+    buffer->ObjectID   = 0;
+    buffer->InstanceID = 0;
+    buffer->Size       = header->size;
+
+    if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
+        lognum++;
+    }
+    return true;
 }
 
-bool write_current_buffer()
+static bool write_current_buffer()
 {
     // not enough space, write the block and start a new one
     if (PIOS_FLASHFS_ObjSave(pios_user_fs_id, LOG_GET_FLIGHT_OBJID(flightnum), lognum, (uint8_t *)buffer, sizeof(DebugLogEntryData)) == 0) {
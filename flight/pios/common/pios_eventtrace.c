@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_eventtrace.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      PiOS event trace buffer
+ *             Records time stamped task switches, callback runs, ISRs and
+ *             instrumented sections into a RAM buffer to be read out later
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <pios.h>
+
+#ifdef PIOS_INCLUDE_EVENTTRACE
+
+#ifndef PIOS_EVENTTRACE_EVENTS
+#define PIOS_EVENTTRACE_EVENTS 1024 // must be a power of 2
+#endif
+
+static struct pios_eventtrace_event *events;
+static uint32_t volatile head; // total number of events claimed since start
+static bool volatile running;
+static bool continuous;
+static uint32_t ticksPerMs;
+
+void PIOS_EVENTTRACE_Init(void)
+{
+    events = (struct pios_eventtrace_event *)pios_malloc(sizeof(struct pios_eventtrace_event) * PIOS_EVENTTRACE_EVENTS);
+    PIOS_Assert(events);
+    running = false;
+    head    = 0;
+
+    uint32_t start = PIOS_DELAY_GetRaw();
+    PIOS_DELAY_WaitmS(1);
+    ticksPerMs = PIOS_DELAY_GetRaw() - start;
+}
+
+void PIOS_EVENTTRACE_Start(bool continuous_trace)
+{
+    running    = false;
+    continuous = continuous_trace;
+    head       = 0;
+    __sync_synchronize();
+    running    = true;
+}
+
+void PIOS_EVENTTRACE_Stop(void)
+{
+    running = false;
+}
+
+bool PIOS_EVENTTRACE_IsRunning(void)
+{
+    return running;
+}
+
+uint16_t PIOS_EVENTTRACE_GetCount(void)
+{
+    return head < PIOS_EVENTTRACE_EVENTS ? head : PIOS_EVENTTRACE_EVENTS;
+}
+
+int32_t PIOS_EVENTTRACE_GetEvent(uint16_t index, struct pios_eventtrace_event *event)
+{
+    if (index >= PIOS_EVENTTRACE_GetCount()) {
+        return -1;
+    }
+    // once a continuous trace wrapped around, the oldest event is the one at head
+    uint32_t first = (continuous && head >= PIOS_EVENTTRACE_EVENTS) ? head : 0;
+    *event = events[(first + index) & (PIOS_EVENTTRACE_EVENTS - 1)];
+    return 0;
+}
+
+uint32_t PIOS_EVENTTRACE_GetTicksPerMs(void)
+{
+    return ticksPerMs;
+}
+
+void PIOS_EVENTTRACE_Event(uint8_t type, uint16_t id)
+{
+    if (!running) {
+        return;
+    }
+    uint32_t timestamp = PIOS_DELAY_GetRaw();
+    uint32_t index     = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+    // head is left to the other writers, only the index tells a full buffer
+    if (index >= PIOS_EVENTTRACE_EVENTS && !continuous) {
+        running = false;
+        return;
+    }
+    struct pios_eventtrace_event *event = &events[index & (PIOS_EVENTTRACE_EVENTS - 1)];
+    event->timestamp = timestamp;
+    event->id        = id;
+    event->type      = type;
+    event->reserved  = 0;
+}
+
+void PIOS_EVENTTRACE_TaskSwitchedIn(void *task)
+{
+    if (running) {
+#ifdef PIOS_INCLUDE_TASK_MONITOR
+        PIOS_EVENTTRACE_Event(PIOS_EVENTTRACE_TASK_SWITCH, PIOS_TASK_MONITOR_GetTaskId((xTaskHandle)task));
+#else
+        PIOS_EVENTTRACE_Event(PIOS_EVENTTRACE_TASK_SWITCH, 0xFFFF);
+#endif
+    }
+}
+
+#endif /* PIOS_INCLUDE_EVENTTRACE */
@@ -54,6 +54,22 @@
 #define JEDEC_STATUS_SEC          0x40
 #define JEDEC_STATUS_SRP0         0x80
 
+#define JEDEC_PAGE_SIZE           0x100
+
+/*
+ * With PIOS_FLASH_JEDEC_CACHE_PAGES set, reads are served from a window of
+ * that many pages which is refilled with one burst on a miss, and writes
+ * to a page are merged in RAM and programmed once the page is full or
+ * something else needs the chip.
+ */
+#ifndef PIOS_FLASH_JEDEC_CACHE_PAGES
+#define PIOS_FLASH_JEDEC_CACHE_PAGES 0
+#endif
+#if PIOS_FLASH_JEDEC_CACHE_PAGES > 0
+#define FLASH_CACHE
+#define FLASH_CACHE_SIZE          (PIOS_FLASH_JEDEC_CACHE_PAGES * JEDEC_PAGE_SIZE)
+#endif
+
 enum pios_jedec_dev_magic {
     PIOS_JEDEC_DEV_MAGIC = 0xcb55aa55,
 };
@@ -72,6 +88,22 @@ struct jedec_flash_dev {
 #if defined(FLASH_FREERTOS)
     xSemaphoreHandle transaction_lock;
 #endif
+#ifdef FLASH_CACHE
+    /* read-ahead window of FLASH_CACHE_SIZE bytes, cache_addr is page aligned */
+    uint8_t  *cache;
+    uint32_t cache_addr;
+    bool     cache_valid;
+
+    /* writes not programmed yet, page_buf holds the AND of them over 0xff */
+    uint8_t  *page_buf;
+    uint32_t page_addr;
+    uint16_t page_start;
+    uint16_t page_end;
+    bool     page_dirty;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreHandle cache_lock;
+#endif
+#endif /* FLASH_CACHE */
     enum pios_jedec_dev_magic magic;
 };
 
@@ -88,6 +120,13 @@ static int32_t PIOS_Flash_Jedec_ClaimBus(struct jedec_flash_dev *flash_dev, bool
 static int32_t PIOS_Flash_Jedec_ReleaseBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_WriteEnable(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_Busy(struct jedec_flash_dev *flash_dev);
+static int32_t PIOS_Flash_Jedec_ReadDirect(struct jedec_flash_dev *flash_dev, uint32_t addr, uint8_t *data, uint16_t len);
+static int32_t PIOS_Flash_Jedec_ProgramPage(struct jedec_flash_dev *flash_dev, uint32_t addr, uint8_t *data, uint16_t len);
+#ifdef FLASH_CACHE
+static void PIOS_Flash_Jedec_CacheLock(struct jedec_flash_dev *flash_dev);
+static void PIOS_Flash_Jedec_CacheUnlock(struct jedec_flash_dev *flash_dev);
+static int32_t PIOS_Flash_Jedec_FlushPage(struct jedec_flash_dev *flash_dev);
+#endif
 
 /**
  * @brief Allocate a new device
@@ -106,6 +145,16 @@ static struct jedec_flash_dev *PIOS_Flash_Jedec_alloc(void)
 #if defined(FLASH_FREERTOS)
     flash_dev->transaction_lock = xSemaphoreCreateMutex();
 #endif
+#ifdef FLASH_CACHE
+    /* Without the buffers the device still works, uncached */
+    flash_dev->cache       = (uint8_t *)pios_malloc(FLASH_CACHE_SIZE);
+    flash_dev->page_buf    = (uint8_t *)pios_malloc(JEDEC_PAGE_SIZE);
+    flash_dev->cache_valid = false;
+    flash_dev->page_dirty  = false;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    flash_dev->cache_lock  = xSemaphoreCreateMutex();
+#endif
+#endif /* FLASH_CACHE */
     return flash_dev;
 }
 
@@ -270,6 +319,254 @@ static int32_t PIOS_Flash_Jedec_ReadID(struct jedec_flash_dev *flash_dev)
     return flash_dev->manufacturer;
 }
 
+/**
+ * @brief Read data from the chip, one command then a single DMA burst
+ */
+static int32_t PIOS_Flash_Jedec_ReadDirect(struct jedec_flash_dev *flash_dev, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    bool fast_read = flash_dev->cfg->fast_read != 0;
+
+    if (PIOS_Flash_Jedec_ClaimBus(flash_dev, fast_read) == -1) {
+        return -1;
+    }
+    /* Execute read command and clock in address.  Keep CS asserted */
+    if (!fast_read) {
+        uint8_t out[] = { JEDEC_READ_DATA, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff };
+        if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, sizeof(out), NULL) < 0) {
+            PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+            return -2;
+        }
+    } else {
+        uint8_t cmdlen = flash_dev->cfg->fast_read_dummy_bytes + 4;
+        uint8_t out[cmdlen];
+        memset(out, 0x0, cmdlen);
+        out[0] = flash_dev->cfg->fast_read;
+        out[1] = (addr >> 16) & 0xff;
+        out[2] = (addr >> 8) & 0xff;
+        out[3] = addr & 0xff;
+        if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, cmdlen, NULL) < 0) {
+            PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+            return -2;
+        }
+    }
+
+    /* Copy the transfer data to the buffer */
+    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, NULL, data, len, NULL) < 0) {
+        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+        return -3;
+    }
+
+    PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+
+    return 0;
+}
+
+/**
+ * @brief Program data within one page and wait for the chip to finish
+ */
+static int32_t PIOS_Flash_Jedec_ProgramPage(struct jedec_flash_dev *flash_dev, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    uint8_t ret;
+    uint8_t out[4] = { JEDEC_PAGE_WRITE, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff };
+
+    if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0) {
+        return ret;
+    }
+
+    /* Execute write page command and clock in address.  Keep CS asserted */
+    if (PIOS_Flash_Jedec_ClaimBus(flash_dev, true) != 0) {
+        return -1;
+    }
+    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, sizeof(out), NULL) < 0) {
+        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+        return -1;
+    }
+
+    /* Clock out data to flash */
+    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, data, NULL, len, NULL) < 0) {
+        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+        return -1;
+    }
+
+    PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+
+    // Keep polling when bus is busy too
+#if defined(FLASH_FREERTOS)
+    while (PIOS_Flash_Jedec_Busy(flash_dev) != 0) {
+        vTaskDelay(1);
+    }
+#else
+
+    // Query status this way to prevent accel chip locking us out
+    if (PIOS_Flash_Jedec_ClaimBus(flash_dev, true) < 0) {
+        return -1;
+    }
+
+    PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS);
+    while (PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS) & JEDEC_STATUS_BUSY) {
+        ;
+    }
+
+    PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+
+#endif
+    return 0;
+}
+
+#ifdef FLASH_CACHE
+
+static inline bool PIOS_Flash_Jedec_Cached(struct jedec_flash_dev *flash_dev)
+{
+    return flash_dev->cache != NULL && flash_dev->page_buf != NULL;
+}
+
+/**
+ * @brief Serialise the users of the cache, both file systems of a chip share it
+ */
+static void PIOS_Flash_Jedec_CacheLock(__attribute__((unused)) struct jedec_flash_dev *flash_dev)
+{
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreTake(flash_dev->cache_lock, portMAX_DELAY);
+#endif
+}
+
+static void PIOS_Flash_Jedec_CacheUnlock(__attribute__((unused)) struct jedec_flash_dev *flash_dev)
+{
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreGive(flash_dev->cache_lock);
+#endif
+}
+
+/**
+ * @brief Program the pending writes of the page buffer
+ * The read window is kept valid, a program can only clear bits.
+ */
+static int32_t PIOS_Flash_Jedec_FlushPage(struct jedec_flash_dev *flash_dev)
+{
+    if (!flash_dev->page_dirty) {
+        return 0;
+    }
+    flash_dev->page_dirty = false;
+
+    uint32_t addr = flash_dev->page_addr + flash_dev->page_start;
+    uint16_t len  = flash_dev->page_end - flash_dev->page_start;
+    int32_t ret   = PIOS_Flash_Jedec_ProgramPage(flash_dev, addr, &flash_dev->page_buf[flash_dev->page_start], len);
+
+    if (ret != 0) {
+        flash_dev->cache_valid = false;
+    } else if (flash_dev->cache_valid && addr >= flash_dev->cache_addr && addr < flash_dev->cache_addr + FLASH_CACHE_SIZE) {
+        /* The page buffer never crosses a page, so it is either all in the window or out of it */
+        uint8_t *cached = &flash_dev->cache[addr - flash_dev->cache_addr];
+        for (uint16_t i = 0; i < len; i++) {
+            cached[i] &= flash_dev->page_buf[flash_dev->page_start + i];
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Merge a write into the page buffer, programming the previous page first
+ * @note the caller checks that the write stays within one page
+ */
+static int32_t PIOS_Flash_Jedec_BufferWrite(struct jedec_flash_dev *flash_dev, uint32_t addr, const uint8_t *data, uint16_t len)
+{
+    uint32_t page = addr & ~(JEDEC_PAGE_SIZE - 1);
+    int32_t ret;
+
+    if (flash_dev->page_dirty && flash_dev->page_addr != page) {
+        if ((ret = PIOS_Flash_Jedec_FlushPage(flash_dev)) != 0) {
+            return ret;
+        }
+    }
+
+    if (!flash_dev->page_dirty) {
+        memset(flash_dev->page_buf, 0xff, JEDEC_PAGE_SIZE);
+        flash_dev->page_addr  = page;
+        flash_dev->page_start = JEDEC_PAGE_SIZE;
+        flash_dev->page_end   = 0;
+        flash_dev->page_dirty = true;
+    }
+
+    uint16_t offset = addr - page;
+    for (uint16_t i = 0; i < len; i++) {
+        flash_dev->page_buf[offset + i] &= data[i];
+    }
+    flash_dev->page_start = MIN(flash_dev->page_start, offset);
+    flash_dev->page_end   = MAX(flash_dev->page_end, offset + len);
+
+    /* Nothing more can be merged into a full page */
+    if (flash_dev->page_start == 0 && flash_dev->page_end == JEDEC_PAGE_SIZE) {
+        return PIOS_Flash_Jedec_FlushPage(flash_dev);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Read through the window, refilling it from the page of addr on a miss
+ */
+static int32_t PIOS_Flash_Jedec_CachedRead(struct jedec_flash_dev *flash_dev, uint32_t addr, uint8_t *data, uint16_t len)
+{
+    int32_t ret;
+
+    /* Pending writes must reach the chip before it is read back */
+    if (flash_dev->page_dirty && addr < flash_dev->page_addr + JEDEC_PAGE_SIZE && addr + len > flash_dev->page_addr) {
+        if ((ret = PIOS_Flash_Jedec_FlushPage(flash_dev)) != 0) {
+            return ret;
+        }
+    }
+
+    /* A burst this long gains nothing from the window */
+    if (len >= FLASH_CACHE_SIZE) {
+        return PIOS_Flash_Jedec_ReadDirect(flash_dev, addr, data, len);
+    }
+
+    while (len > 0) {
+        if (!flash_dev->cache_valid || addr < flash_dev->cache_addr || addr >= flash_dev->cache_addr + FLASH_CACHE_SIZE) {
+            uint32_t window = addr & ~(JEDEC_PAGE_SIZE - 1);
+            flash_dev->cache_valid = false;
+            if ((ret = PIOS_Flash_Jedec_ReadDirect(flash_dev, window, flash_dev->cache, FLASH_CACHE_SIZE)) != 0) {
+                return ret;
+            }
+            flash_dev->cache_addr  = window;
+            flash_dev->cache_valid = true;
+        }
+
+        uint32_t offset = addr - flash_dev->cache_addr;
+        uint16_t chunk  = MIN(len, FLASH_CACHE_SIZE - offset);
+        memcpy(data, &flash_dev->cache[offset], chunk);
+
+        data += chunk;
+        addr += chunk;
+        len  -= chunk;
+    }
+
+    return 0;
+}
+
+#endif /* FLASH_CACHE */
+
+/**
+ * @brief Program the writes still held in RAM, used when a transaction ends
+ */
+static int32_t PIOS_Flash_Jedec_Sync(__attribute__((unused)) struct jedec_flash_dev *flash_dev)
+{
+#ifdef FLASH_CACHE
+    if (!PIOS_Flash_Jedec_Cached(flash_dev)) {
+        return 0;
+    }
+    PIOS_Flash_Jedec_CacheLock(flash_dev);
+    int32_t ret = PIOS_Flash_Jedec_FlushPage(flash_dev);
+    PIOS_Flash_Jedec_CacheUnlock(flash_dev);
+    return ret;
+
+#else
+    return 0;
+
+#endif
+}
+
 /**********************************
  *
  * Provide a PIOS flash driver API
@@ -312,13 +609,15 @@ static int32_t PIOS_Flash_Jedec_EndTransaction(uintptr_t flash_id)
         return -1;
     }
 
+    int32_t ret = PIOS_Flash_Jedec_Sync(flash_dev);
+
 #if defined(PIOS_INCLUDE_FREERTOS)
     if (xSemaphoreGive(flash_dev->transaction_lock) != pdTRUE) {
         return -2;
     }
 #endif
 
-    return 0;
+    return ret;
 }
 
 #else /* FLASH_USE_FREERTOS_LOCKS */
@@ -328,28 +627,24 @@ static int32_t PIOS_Flash_Jedec_StartTransaction(__attribute__((unused)) uintptr
     return 0;
 }
 
-static int32_t PIOS_Flash_Jedec_EndTransaction(__attribute__((unused)) uintptr_t flash_id)
+static int32_t PIOS_Flash_Jedec_EndTransaction(uintptr_t flash_id)
 {
-    return 0;
+    struct jedec_flash_dev *flash_dev = (struct jedec_flash_dev *)flash_id;
+
+    if (PIOS_Flash_Jedec_Validate(flash_dev) != 0) {
+        return -1;
+    }
+
+    return PIOS_Flash_Jedec_Sync(flash_dev);
 }
 
 #endif /* FLASH_USE_FREERTOS_LOCKS */
 
 /**
- * @brief Erase a sector on the flash chip
- * @param[in] add Address of flash to erase
- * @returns 0 if successful
- * @retval -1 if unable to claim bus
- * @retval
+ * @brief Erase a sector, the flash_dev is already validated
  */
-static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t flash_id, uint32_t addr)
+static int32_t PIOS_Flash_Jedec_EraseSectorDirect(struct jedec_flash_dev *flash_dev, uint32_t addr)
 {
-    struct jedec_flash_dev *flash_dev = (struct jedec_flash_dev *)flash_id;
-
-    if (PIOS_Flash_Jedec_Validate(flash_dev) != 0) {
-        return -1;
-    }
-
     uint8_t ret;
     uint8_t out[] = { flash_dev->cfg->sector_erase, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff };
 
@@ -379,10 +674,13 @@ static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t flash_id, uint32_t addr)
 }
 
 /**
- * @brief Execute the whole chip
- * @returns 0 if successful, -1 if unable to claim bus
+ * @brief Erase a sector on the flash chip
+ * @param[in] add Address of flash to erase
+ * @returns 0 if successful
+ * @retval -1 if unable to claim bus
+ * @retval
  */
-static int32_t PIOS_Flash_Jedec_EraseChip(uintptr_t flash_id)
+static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t flash_id, uint32_t addr)
 {
     struct jedec_flash_dev *flash_dev = (struct jedec_flash_dev *)flash_id;
 
@@ -390,6 +688,28 @@ static int32_t PIOS_Flash_Jedec_EraseChip(uintptr_t flash_id)
         return -1;
     }
 
+#ifdef FLASH_CACHE
+    if (PIOS_Flash_Jedec_Cached(flash_dev)) {
+        PIOS_Flash_Jedec_CacheLock(flash_dev);
+        int32_t ret = PIOS_Flash_Jedec_FlushPage(flash_dev);
+        /* The sector size is not known here, drop the whole window */
+        flash_dev->cache_valid = false;
+        if (ret == 0) {
+            ret = PIOS_Flash_Jedec_EraseSectorDirect(flash_dev, addr);
+        }
+        PIOS_Flash_Jedec_CacheUnlock(flash_dev);
+        return ret;
+    }
+#endif /* FLASH_CACHE */
+
+    return PIOS_Flash_Jedec_EraseSectorDirect(flash_dev, addr);
+}
+
+/**
+ * @brief Erase the whole chip, the flash_dev is already validated
+ */
+static int32_t PIOS_Flash_Jedec_EraseChipDirect(struct jedec_flash_dev *flash_dev)
+{
     uint8_t ret;
     uint8_t out[] = { flash_dev->cfg->chip_erase };
 
@@ -427,6 +747,33 @@ static int32_t PIOS_Flash_Jedec_EraseChip(uintptr_t flash_id)
     return 0;
 }
 
+/**
+ * @brief Execute the whole chip
+ * @returns 0 if successful, -1 if unable to claim bus
+ */
+static int32_t PIOS_Flash_Jedec_EraseChip(uintptr_t flash_id)
+{
+    struct jedec_flash_dev *flash_dev = (struct jedec_flash_dev *)flash_id;
+
+    if (PIOS_Flash_Jedec_Validate(flash_dev) != 0) {
+        return -1;
+    }
+
+#ifdef FLASH_CACHE
+    if (PIOS_Flash_Jedec_Cached(flash_dev)) {
+        PIOS_Flash_Jedec_CacheLock(flash_dev);
+        /* Everything pending is erased anyway */
+        flash_dev->page_dirty  = false;
+        flash_dev->cache_valid = false;
+        int32_t ret = PIOS_Flash_Jedec_EraseChipDirect(flash_dev);
+        PIOS_Flash_Jedec_CacheUnlock(flash_dev);
+        return ret;
+    }
+#endif /* FLASH_CACHE */
+
+    return PIOS_Flash_Jedec_EraseChipDirect(flash_dev);
+}
+
 
 /**
  * @brief Write one page of data (up to 256 bytes) aligned to a page start
@@ -437,6 +784,7 @@ static int32_t PIOS_Flash_Jedec_EraseChip(uintptr_t flash_id)
  * @retval -1 Unable to claim SPI bus
  * @retval -2 Size exceeds 256 bytes
  * @retval -3 Length to write would wrap around page boundary
+ * @note With the page buffer the data may only be programmed when the transaction ends
  */
 static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t flash_id, uint32_t addr, uint8_t *data, uint16_t len)
 {
@@ -446,60 +794,26 @@ static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t flash_id, uint32_t addr, uin
         return -1;
     }
 
-    uint8_t ret;
-    uint8_t out[4] = { JEDEC_PAGE_WRITE, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff };
-
     /* Can only write one page at a time */
-    if (len > 0x100) {
+    if (len > JEDEC_PAGE_SIZE) {
         return -2;
     }
 
     /* Ensure number of bytes fits after starting address before end of page */
-    if (((addr & 0xff) + len) > 0x100) {
+    if (((addr & 0xff) + len) > JEDEC_PAGE_SIZE) {
         return -3;
     }
-    if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0) {
-        return ret;
-    }
-
-    /* Execute write page command and clock in address.  Keep CS asserted */
-    if (PIOS_Flash_Jedec_ClaimBus(flash_dev, true) != 0) {
-        return -1;
-    }
-    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, sizeof(out), NULL) < 0) {
-        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-        return -1;
-    }
-
-    /* Clock out data to flash */
-    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, data, NULL, len, NULL) < 0) {
-        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-        return -1;
-    }
-
-    PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-
-    // Keep polling when bus is busy too
-#if defined(FLASH_FREERTOS)
-    while (PIOS_Flash_Jedec_Busy(flash_dev) != 0) {
-        vTaskDelay(1);
-    }
-#else
 
-    // Query status this way to prevent accel chip locking us out
-    if (PIOS_Flash_Jedec_ClaimBus(flash_dev, true) < 0) {
-        return -1;
-    }
-
-    PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS);
-    while (PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS) & JEDEC_STATUS_BUSY) {
-        ;
+#ifdef FLASH_CACHE
+    if (PIOS_Flash_Jedec_Cached(flash_dev)) {
+        PIOS_Flash_Jedec_CacheLock(flash_dev);
+        int32_t ret = PIOS_Flash_Jedec_BufferWrite(flash_dev, addr, data, len);
+        PIOS_Flash_Jedec_CacheUnlock(flash_dev);
+        return ret;
     }
+#endif /* FLASH_CACHE */
 
-    PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-
-#endif
-    return 0;
+    return PIOS_Flash_Jedec_ProgramPage(flash_dev, addr, data, len);
 }
 
 /**
@@ -529,14 +843,28 @@ static int32_t PIOS_Flash_Jedec_WriteChunks(uintptr_t flash_id, uint32_t addr, s
         len += chunks[i].len;
     }
 
-    if (len > 0x100) {
+    if (len > JEDEC_PAGE_SIZE) {
         return -2;
     }
 
     /* Ensure number of bytes fits after starting address before end of page */
-    if (((addr & 0xff) + len) > 0x100) {
+    if (((addr & 0xff) + len) > JEDEC_PAGE_SIZE) {
         return -3;
     }
+
+#ifdef FLASH_CACHE
+    if (PIOS_Flash_Jedec_Cached(flash_dev)) {
+        int32_t err = 0;
+        PIOS_Flash_Jedec_CacheLock(flash_dev);
+        for (uint32_t i = 0; i < num && err == 0; i++) {
+            err   = PIOS_Flash_Jedec_BufferWrite(flash_dev, addr, chunks[i].addr, chunks[i].len);
+            addr += chunks[i].len;
+        }
+        PIOS_Flash_Jedec_CacheUnlock(flash_dev);
+        return err;
+    }
+#endif /* FLASH_CACHE */
+
     if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0) {
         return ret;
     }
@@ -582,40 +910,17 @@ static int32_t PIOS_Flash_Jedec_ReadData(uintptr_t flash_id, uint32_t addr, uint
     if (PIOS_Flash_Jedec_Validate(flash_dev) != 0) {
         return -1;
     }
-    bool fast_read = flash_dev->cfg->fast_read != 0;
-    if (PIOS_Flash_Jedec_ClaimBus(flash_dev, fast_read) == -1) {
-        return -1;
-    }
-    /* Execute read command and clock in address.  Keep CS asserted */
-    if (!fast_read) {
-        uint8_t out[] = { JEDEC_READ_DATA, (addr >> 16) & 0xff, (addr >> 8) & 0xff, addr & 0xff };
-        if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, sizeof(out), NULL) < 0) {
-            PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-            return -2;
-        }
-    } else {
-        uint8_t cmdlen = flash_dev->cfg->fast_read_dummy_bytes + 4;
-        uint8_t out[cmdlen];
-        memset(out, 0x0, cmdlen);
-        out[0] = flash_dev->cfg->fast_read;
-        out[1] = (addr >> 16) & 0xff;
-        out[2] = (addr >> 8) & 0xff;
-        out[3] = addr & 0xff;
-        if (PIOS_SPI_TransferBlock(flash_dev->spi_id, out, NULL, cmdlen, NULL) < 0) {
-            PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-            return -2;
-        }
-    }
 
-    /* Copy the transfer data to the buffer */
-    if (PIOS_SPI_TransferBlock(flash_dev->spi_id, NULL, data, len, NULL) < 0) {
-        PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-        return -3;
+#ifdef FLASH_CACHE
+    if (PIOS_Flash_Jedec_Cached(flash_dev)) {
+        PIOS_Flash_Jedec_CacheLock(flash_dev);
+        int32_t ret = PIOS_Flash_Jedec_CachedRead(flash_dev, addr, data, len);
+        PIOS_Flash_Jedec_CacheUnlock(flash_dev);
+        return ret;
     }
+#endif /* FLASH_CACHE */
 
-    PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-
-    return 0;
+    return PIOS_Flash_Jedec_ReadDirect(flash_dev, addr, data, len);
 }
 
 /* Provide a flash driver to external drivers */
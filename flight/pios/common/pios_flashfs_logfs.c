@@ -30,6 +30,7 @@
 #ifdef PIOS_INCLUDE_FLASH
 
 #include <stdbool.h>
+#include <string.h>
 #include <openpilot.h>
 #include <pios_math.h>
 #include <pios_wdg.h>
@@ -39,6 +40,12 @@
  * Filesystem state data tracked in RAM
  */
 
+struct logfs_index_entry {
+    uint32_t obj_id;
+    uint16_t obj_inst_id;
+    uint16_t slot_id;
+};
+
 enum pios_flashfs_logfs_dev_magic {
     PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
@@ -56,6 +63,11 @@ struct logfs_state {
     uint16_t num_free_slots; /* slots in free state */
     uint16_t num_active_slots; /* slots in active state */
 
+    /* RAM index of the active slots, sorted by object and instance id */
+    struct logfs_index_entry *index;
+    uint16_t index_count;
+    bool     index_valid; /* false if it overflowed, lookups then scan the log */
+
     /* Underlying flash driver glue */
     const struct pios_flash_driver *driver;
     uintptr_t flash_id;
@@ -353,6 +365,67 @@ struct slot_header {
     uint16_t obj_size;
 } __attribute__((packed));
 
+/*
+ * RAM index, lookups are a binary search instead of reading all slot headers from flash
+ */
+
+/* Returns the position of the object in the index, or where it would be inserted */
+static uint16_t logfs_index_search(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    uint16_t lo = 0;
+    uint16_t hi = logfs->index_count;
+
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        const struct logfs_index_entry *entry = &logfs->index[mid];
+        if (entry->obj_id < obj_id || (entry->obj_id == obj_id && entry->obj_inst_id < obj_inst_id)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool logfs_index_match(const struct logfs_state *logfs, uint16_t pos, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    return pos < logfs->index_count &&
+           logfs->index[pos].obj_id == obj_id &&
+           logfs->index[pos].obj_inst_id == obj_inst_id;
+}
+
+static void logfs_index_insert(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+    if (!logfs->index_valid) {
+        return;
+    }
+
+    uint16_t pos = logfs_index_search(logfs, obj_id, obj_inst_id);
+    if (logfs_index_match(logfs, pos, obj_id, obj_inst_id) || logfs->index_count >= logfs->cfg->index_size) {
+        /* More than one active version or too many objects, fall back to scanning the log */
+        logfs->index_valid = false;
+        return;
+    }
+    memmove(&logfs->index[pos + 1], &logfs->index[pos], (logfs->index_count - pos) * sizeof(logfs->index[0]));
+    logfs->index[pos].obj_id      = obj_id;
+    logfs->index[pos].obj_inst_id = obj_inst_id;
+    logfs->index[pos].slot_id     = slot_id;
+    logfs->index_count++;
+}
+
+static void logfs_index_remove(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    if (!logfs->index_valid) {
+        return;
+    }
+
+    uint16_t pos = logfs_index_search(logfs, obj_id, obj_inst_id);
+    if (logfs_index_match(logfs, pos, obj_id, obj_inst_id)) {
+        logfs->index_count--;
+        memmove(&logfs->index[pos], &logfs->index[pos + 1], (logfs->index_count - pos) * sizeof(logfs->index[0]));
+    }
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 static int32_t logfs_raw_copy_bytes(const struct logfs_state *logfs, uintptr_t src_addr, uint16_t src_size, uintptr_t dst_addr)
 {
@@ -422,7 +495,8 @@ static int32_t logfs_unmount_log(struct logfs_state *logfs)
 
     logfs->num_active_slots = 0;
     logfs->num_free_slots   = 0;
-    logfs->mounted = false;
+    logfs->index_count = 0;
+    logfs->mounted     = false;
 
     return 0;
 }
@@ -434,6 +508,8 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
     logfs->num_active_slots = 0;
     logfs->num_free_slots   = 0;
     logfs->active_arena_id  = arena_id;
+    logfs->index_count = 0;
+    logfs->index_valid = (logfs->index != NULL);
 
     /* Scan the log to find out how full it is */
     for (uint16_t slot_id = 1;
@@ -461,6 +537,7 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
             break;
         case SLOT_STATE_ACTIVE:
             logfs->num_active_slots++;
+            logfs_index_insert(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id, slot_id);
             break;
         case SLOT_STATE_RESERVED:
         case SLOT_STATE_OBSOLETE:
@@ -497,6 +574,9 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
     /* Invalidate the magic */
     logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+    if (logfs->index) {
+        vPortFree(logfs->index);
+    }
     vPortFree(logfs);
 }
 #else
@@ -559,6 +639,12 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
     logfs->driver   = driver; /* lower-level flash driver */
     logfs->flash_id = flash_id; /* lower-level flash device id */
     logfs->mounted  = false;
+    logfs->index    = NULL;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (cfg->index_size) {
+        logfs->index = (struct logfs_index_entry *)pios_malloc(cfg->index_size * sizeof(struct logfs_index_entry));
+    }
+#endif
 
     if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
         rc = -1;
@@ -745,12 +831,98 @@ static int16_t logfs_object_find_next(const struct logfs_state *logfs, struct sl
     return -1;
 }
 
+/* NOTE: Must be called while holding the flash transaction lock */
+static int16_t logfs_object_find(struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+    if (!logfs->index_valid) {
+        *slot_id = 0;
+        return logfs_object_find_next(logfs, slot_hdr, slot_id, obj_id, obj_inst_id);
+    }
+
+    uint16_t pos = logfs_index_search(logfs, obj_id, obj_inst_id);
+    if (!logfs_index_match(logfs, pos, obj_id, obj_inst_id)) {
+        return -1;
+    }
+    *slot_id = logfs->index[pos].slot_id;
+
+    uintptr_t slot_addr = logfs_get_addr(logfs, logfs->active_arena_id, *slot_id);
+    if (logfs->driver->read_data(logfs->flash_id,
+                                 slot_addr,
+                                 (uint8_t *)slot_hdr,
+                                 sizeof(*slot_hdr)) != 0) {
+        return -2;
+    }
+    if (slot_hdr->state != SLOT_STATE_ACTIVE ||
+        slot_hdr->obj_id != obj_id ||
+        slot_hdr->obj_inst_id != obj_inst_id) {
+        /* Index doesn't match the log, stop trusting it */
+        PIOS_DEBUG_Assert(0);
+        logfs->index_valid = false;
+        *slot_id = 0;
+        return logfs_object_find_next(logfs, slot_hdr, slot_id, obj_id, obj_inst_id);
+    }
+    return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+/* Compares an object with its active version in the log, true if they are identical */
+static bool logfs_object_unchanged(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, const uint8_t *obj_data, uint16_t obj_size)
+{
+#define COMPARE_BLOCK_SIZE 16
+    uint8_t data_block[COMPARE_BLOCK_SIZE];
+    struct slot_header slot_hdr;
+    uint16_t slot_id;
+
+    if (logfs_object_find(logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0 ||
+        slot_hdr.obj_size != obj_size) {
+        return false;
+    }
+
+    uintptr_t addr = logfs_get_addr(logfs, logfs->active_arena_id, slot_id) + sizeof(slot_hdr);
+    for (uint16_t offset = 0; offset < obj_size; offset += COMPARE_BLOCK_SIZE) {
+        uint16_t blk_size = MIN(COMPARE_BLOCK_SIZE, obj_size - offset);
+        if (logfs->driver->read_data(logfs->flash_id, addr + offset, data_block, blk_size) != 0 ||
+            memcmp(data_block, obj_data + offset, blk_size) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
 /* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
 static int8_t logfs_delete_object(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
     int8_t rc;
 
+    if (logfs->index_valid) {
+        /* The index only holds objects with exactly one active version */
+        struct slot_header slot_hdr;
+        uint16_t slot_id;
+        switch (logfs_object_find(logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id)) {
+        case 0:
+            break;
+        case -1:
+            return 0;
+
+        default:
+            return -1;
+        }
+        if (logfs->index_valid) {
+            slot_hdr.state = SLOT_STATE_OBSOLETE;
+            if (logfs->driver->write_data(logfs->flash_id,
+                                          logfs_get_addr(logfs, logfs->active_arena_id, slot_id),
+                                          (uint8_t *)&slot_hdr,
+                                          sizeof(slot_hdr)) != 0) {
+                return -2;
+            }
+            logfs->num_active_slots--;
+            logfs_index_remove(logfs, obj_id, obj_inst_id);
+            return 0;
+        }
+        /* The index got invalidated by the lookup, scan the whole log */
+    }
+
     bool more = true;
     uint16_t curr_slot_id = 0;
 
@@ -891,6 +1063,7 @@ static int8_t logfs_append_to_log(struct logfs_state *logfs, uint32_t obj_id, ui
 
     /* Object has been successfully written to the slot */
     logfs->num_active_slots++;
+    logfs_index_insert(logfs, obj_id, obj_inst_id, free_slot_id);
     return 0;
 }
 
@@ -936,6 +1109,12 @@ int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
         goto out_exit;
     }
 
+    /* Saving the same contents again would only use up a slot */
+    if (logfs_object_unchanged(logfs, obj_id, obj_inst_id, obj_data, obj_size)) {
+        rc = 0;
+        goto out_end_trans;
+    }
+
     if (logfs_delete_object(logfs, obj_id, obj_inst_id) != 0) {
         rc = -3;
         goto out_end_trans;
@@ -1023,9 +1202,9 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
     }
 
     /* Find the object in the log */
-    uint16_t slot_id = 0;
+    uint16_t slot_id;
     struct slot_header slot_hdr;
-    if (logfs_object_find_next(logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+    if (logfs_object_find(logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
         /* Object does not exist in fs */
         rc = -3;
         goto out_end_trans;
@@ -1158,6 +1337,49 @@ out_end_trans:
 out_exit:
     return rc;
 }
+/**
+ * @brief Garbage collects the log ahead of time, so saves rarely have to
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if garbage collection failed
+ */
+int32_t PIOS_FLASHFS_Compact(uintptr_t fs_id)
+{
+    int32_t rc;
+
+    struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+    if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+        rc = -1;
+        goto out_exit;
+    }
+
+    if (logfs->driver->start_transaction(logfs->flash_id) != 0) {
+        rc = -2;
+        goto out_exit;
+    }
+
+    /* Only compact when less than a quarter of the log is free and at least as many slots are obsolete */
+    uint16_t num_slots    = (logfs->cfg->arena_size / logfs->cfg->slot_size) - 1;
+    uint16_t num_obsolete = num_slots - logfs->num_free_slots - logfs->num_active_slots;
+    if (logfs->num_free_slots < num_slots / 4 && num_obsolete >= num_slots / 4) {
+        if (logfs_garbage_collect(logfs) != 0) {
+            rc = -3;
+            goto out_end_trans;
+        }
+    }
+
+    rc = 0;
+
+out_end_trans:
+    logfs->driver->end_transaction(logfs->flash_id);
+
+out_exit:
+    return rc;
+}
+
 /**
  * @brief Returs stats for the filesystems
  * @param[in] fs_id The filesystem to use for this action
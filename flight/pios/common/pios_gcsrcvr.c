@@ -38,6 +38,29 @@
 
 static GCSReceiverData gcsreceiverdata;
 
+/*
+ * The GCS stamps its updates with its own ms clock. The difference to the local
+ * clock is the link delay plus an unknown offset, so the delay of an update is
+ * measured against the fastest update of the same period.
+ */
+#define STATUS_PERIOD_MS 1000
+/* An update this much older than the last one is a restart of the GCS clock, not a late update */
+#define RESYNC_MS        1000
+
+struct gcsrcvr_timing {
+    uint32_t last_timestamp;
+    uint32_t period_start;
+    int32_t  offset_base;
+    int32_t  offset_min;
+    int32_t  offset_max;
+    int32_t  offset_sum;
+    uint16_t count;
+    uint16_t stale;
+    bool     started;
+};
+
+static struct gcsrcvr_timing timing;
+
 /* Provide a RCVR driver */
 static int32_t PIOS_GCSRCVR_Get(uint32_t rcvr_id, uint8_t channel);
 static void PIOS_gcsrcvr_Supervisor(uint32_t ppm_id);
@@ -106,12 +129,70 @@ static struct pios_gcsrcvr_dev *PIOS_gcsrcvr_alloc(void)
 }
 #endif /* if defined(PIOS_INCLUDE_FREERTOS) */
 
+/**
+ * Accounts a timestamped update, false if it is older than the last one applied.
+ * A jump back of more than RESYNC_MS restarts the timing rather than rejecting
+ * every update until the GCS clock catches up.
+ */
+static bool gcsrcvr_timing_update(uint32_t timestamp)
+{
+    uint32_t now = xTaskGetTickCount() * portTICK_RATE_MS;
+
+    if (timing.started && (int32_t)(timing.last_timestamp - timestamp) > RESYNC_MS) {
+        timing.started = false;
+        timing.count   = 0;
+    }
+    if (!timing.started) {
+        timing.started      = true;
+        timing.period_start = now;
+    } else if ((int32_t)(timestamp - timing.last_timestamp) <= 0) {
+        timing.stale++;
+        return false;
+    }
+    timing.last_timestamp = timestamp;
+
+    // relative to the first update of the period, so the sums do not overflow
+    int32_t offset = (int32_t)(now - timestamp);
+    if (timing.count == 0) {
+        timing.offset_base = offset;
+        timing.offset_min  = 0;
+        timing.offset_max  = 0;
+        timing.offset_sum  = 0;
+    }
+    offset -= timing.offset_base;
+    timing.offset_min  = MIN(timing.offset_min, offset);
+    timing.offset_max  = MAX(timing.offset_max, offset);
+    timing.offset_sum += offset;
+    timing.count++;
+
+    uint32_t elapsed = now - timing.period_start;
+    if (elapsed >= STATUS_PERIOD_MS) {
+        GCSReceiverStatusData status;
+        status.Rate     = (timing.count * 1000 + elapsed / 2) / elapsed;
+        status.Delay    = timing.offset_sum / timing.count - timing.offset_min;
+        status.DelayMax = timing.offset_max - timing.offset_min;
+        status.Stale    = timing.stale;
+        GCSReceiverStatusSet(&status);
+
+        timing.period_start = now;
+        timing.count = 0;
+    }
+    return true;
+}
+
 static void gcsreceiver_updated(UAVObjEvent *ev)
 {
     struct pios_gcsrcvr_dev *gcsrcvr_dev = global_gcsrcvr_dev;
 
     if (ev->obj == GCSReceiverHandle()) {
-        GCSReceiverGet(&gcsreceiverdata);
+        GCSReceiverData data;
+        GCSReceiverGet(&data);
+
+        // updates without a timestamp (simulators, older GCS) are always applied
+        if (data.Timestamp != 0 && !gcsrcvr_timing_update(data.Timestamp)) {
+            return;
+        }
+        gcsreceiverdata    = data;
         gcsrcvr_dev->Fresh = true;
     }
 }
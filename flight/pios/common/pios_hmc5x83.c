@@ -46,9 +46,14 @@ typedef struct {
     uint8_t  slave_num;
     uint8_t  CTRLB;
     volatile bool data_ready;
+    const PIOS_SENSORS_Instance *sensor;
 } pios_hmc5x83_dev_data_t;
 
+// Output period in ms for each PIOS_HMC5x83_ODR_* setting
+static const uint16_t output_period_ms[] = { 1334, 667, 334, 134, 67, 34, 14, 14 };
+
 static int32_t PIOS_HMC5x83_Config(pios_hmc5x83_dev_data_t *dev);
+static void PIOS_HMC5x83_Wait(uint32_t ms);
 
 // sensor driver interface
 bool PIOS_HMC5x83_driver_Test(uintptr_t context);
@@ -117,7 +122,12 @@ pios_hmc5x83_dev_t PIOS_HMC5x83_Init(const struct pios_hmc5x83_cfg *cfg, uint32_
 
 void PIOS_HMC5x83_Register(pios_hmc5x83_dev_t handler)
 {
-    PIOS_SENSORS_Register(&PIOS_HMC5x83_Driver, PIOS_SENSORS_TYPE_3AXIS_MAG, handler);
+    pios_hmc5x83_dev_data_t *dev    = dev_validate(handler);
+    PIOS_SENSORS_Instance *instance = PIOS_SENSORS_Register(&PIOS_HMC5x83_Driver, PIOS_SENSORS_TYPE_3AXIS_MAG, handler);
+
+    // The data ready interrupt wakes the polling, the period only covers a missed one
+    PIOS_SENSORS_SetPollPeriod(instance, output_period_ms[(dev->cfg->M_ODR >> 2) & 0x07]);
+    dev->sensor = instance;
 }
 
 /**
@@ -341,6 +351,21 @@ bool PIOS_HMC5x83_NewDataAvailable(pios_hmc5x83_dev_t handler)
     return dev->data_ready;
 }
 
+/**
+ * Wait for the device, letting the other tasks run when the scheduler is started as
+ * the self-test spends most of its time waiting and otherwise stalls the start-up.
+ */
+static void PIOS_HMC5x83_Wait(uint32_t ms)
+{
+#if defined(PIOS_INCLUDE_FREERTOS) && (INCLUDE_xTaskGetSchedulerState == 1)
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        vTaskDelay(MAX(ms / portTICK_RATE_MS, 1));
+        return;
+    }
+#endif
+    PIOS_DELAY_WaitmS(ms);
+}
+
 /**
  * @brief Run self-test operation.  Do not call this during operational use!!
  * \return 0 if success, -1 if test failed
@@ -370,7 +395,7 @@ int32_t PIOS_HMC5x83_Test(pios_hmc5x83_dev_t handler)
     }
 
     /* Stop the device and read out last value */
-    PIOS_DELAY_WaitmS(10);
+    PIOS_HMC5x83_Wait(10);
     if (dev->cfg->Driver->Write(handler, PIOS_HMC5x83_MODE_REG, PIOS_HMC5x83_MODE_IDLE) != 0) {
         return -1;
     }
@@ -392,21 +417,21 @@ int32_t PIOS_HMC5x83_Test(pios_hmc5x83_dev_t handler)
      *
      * Changing measurement config back to PIOS_HMC5x83_MEASCONF_NORMAL will leave self-test mode.
      */
-    PIOS_DELAY_WaitmS(10);
+    PIOS_HMC5x83_Wait(10);
     if (dev->cfg->Driver->Write(handler, PIOS_HMC5x83_CONFIG_REG_A, PIOS_HMC5x83_MEASCONF_BIAS_POS | PIOS_HMC5x83_ODR_15) != 0) {
         return -1;
     }
-    PIOS_DELAY_WaitmS(10);
+    PIOS_HMC5x83_Wait(10);
     if (dev->cfg->Driver->Write(handler, PIOS_HMC5x83_CONFIG_REG_B, PIOS_HMC5x83_GAIN_8_1) != 0) {
         return -1;
     }
-    PIOS_DELAY_WaitmS(10);
+    PIOS_HMC5x83_Wait(10);
     if (dev->cfg->Driver->Write(handler, PIOS_HMC5x83_MODE_REG, PIOS_HMC5x83_MODE_SINGLE) != 0) {
         return -1;
     }
 
     /* Must wait for value to be updated */
-    PIOS_DELAY_WaitmS(200);
+    PIOS_HMC5x83_Wait(200);
 
     if (PIOS_HMC5x83_ReadMag(handler, values) != 0) {
         return -1;
@@ -419,15 +444,15 @@ int32_t PIOS_HMC5x83_Test(pios_hmc5x83_dev_t handler)
 
 
     /* Restore backup configuration */
-    PIOS_DELAY_WaitmS(10);
+    PIOS_HMC5x83_Wait(10);
     if (dev->cfg->Driver->Write(handler, PIOS_HMC5x83_CONFIG_REG_A, registers[0]) != 0) {
         return -1;
     }
-    PIOS_DELAY_WaitmS(10);
+    PIOS_HMC5x83_Wait(10);
     if (dev->cfg->Driver->Write(handler, PIOS_HMC5x83_CONFIG_REG_B, registers[1]) != 0) {
         return -1;
     }
-    PIOS_DELAY_WaitmS(10);
+    PIOS_HMC5x83_Wait(10);
     if (dev->cfg->Driver->Write(handler, PIOS_HMC5x83_MODE_REG, registers[2]) != 0) {
         return -1;
     }
@@ -443,7 +468,7 @@ bool PIOS_HMC5x83_IRQHandler(pios_hmc5x83_dev_t handler)
     pios_hmc5x83_dev_data_t *dev = dev_validate(handler);
 
     dev->data_ready = true;
-    return false;
+    return PIOS_SENSORS_DataReadyFromISR(dev->sensor);
 }
 
 #ifdef PIOS_INCLUDE_SPI
@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_initcall.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup PiOS
+ * @{
+ * @addtogroup PiOS
+ * @{
+ * @brief PiOS module initcall boot profile
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <pios.h>
+
+#if defined(PIOS_INCLUDE_INITCALL_PROFILE) && !defined(USE_SIM_POSIX)
+
+/* entries are indexed by the position of the module in the initcall section,
+ * both phases run from a single task so no locking is needed */
+static uint32_t init_us[PIOS_INITCALL_PROFILE_SIZE];
+static uint32_t start_us[PIOS_INITCALL_PROFILE_SIZE];
+
+void PIOS_INITCALL_Profile(const initmodule_t *fn, enum pios_initcall_phase phase, uint32_t raw)
+{
+    uint32_t us    = PIOS_DELAY_DiffuS(raw);
+    uint32_t index = fn - __module_initcall_start;
+
+    if (index >= PIOS_INITCALL_PROFILE_SIZE) {
+        return;
+    }
+    if (phase == PIOS_INITCALL_PHASE_INIT) {
+        init_us[index] = us;
+    } else {
+        start_us[index] = us;
+    }
+}
+
+bool PIOS_INITCALL_GetProfile(uint8_t index, struct pios_initcall_profile *profile)
+{
+    if (index >= PIOS_INITCALL_PROFILE_SIZE || __module_initcall_start + index >= __module_initcall_end) {
+        return false;
+    }
+    profile->name     = __module_initcall_start[index].name;
+    profile->init_us  = init_us[index];
+    profile->start_us = start_us[index];
+    return true;
+}
+
+#endif /* PIOS_INCLUDE_INITCALL_PROFILE */
+
+/**
+ * @}
+ * @}
+ */
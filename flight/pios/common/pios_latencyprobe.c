@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_latencyprobe.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      PiOS stick to output latency probe
+ *             Follows one receiver frame at a time through the control chain
+ *             up to the output it ends in, and keeps the latency statistics
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <pios.h>
+
+#ifdef PIOS_INCLUDE_LATENCYPROBE
+
+#ifndef PIOS_LATENCYPROBE_TIMEOUT_US
+#define PIOS_LATENCYPROBE_TIMEOUT_US 500000 // a tag older than this is dropped, the flight mode may not lead to an output
+#endif
+
+static uint8_t volatile stage;
+static uint32_t volatile start; // PIOS_DELAY_GetRaw() of the tagged frame
+static uint32_t arrival[PIOS_LATENCYPROBE_STAGES]; // us from the tagged frame
+
+// Statistics, only changed with the scheduler locked but dropped, which the ISRs count
+static uint32_t samples;
+static uint32_t volatile dropped;
+static uint32_t min;
+static uint32_t max;
+static uint64_t sum;
+static uint64_t stageSum[PIOS_LATENCYPROBE_STAGES];
+
+static void complete(uint32_t latency);
+
+void PIOS_LATENCYPROBE_Init(void)
+{
+    stage   = PIOS_LATENCYPROBE_IDLE;
+    samples = 0;
+    dropped = 0;
+    min     = UINT32_MAX;
+    max     = 0;
+    sum     = 0;
+    memset(stageSum, 0, sizeof(stageSum));
+}
+
+void PIOS_LATENCYPROBE_Frame(void)
+{
+    uint8_t current = __atomic_load_n(&stage, __ATOMIC_ACQUIRE);
+
+    if (current != PIOS_LATENCYPROBE_IDLE) {
+        if (PIOS_DELAY_DiffuS(start) < PIOS_LATENCYPROBE_TIMEOUT_US) {
+            return;
+        }
+        if (!__atomic_compare_exchange_n(&stage, &current, PIOS_LATENCYPROBE_IDLE, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return;
+        }
+        dropped++;
+    }
+
+    current = PIOS_LATENCYPROBE_IDLE;
+    if (__atomic_compare_exchange_n(&stage, &current, PIOS_LATENCYPROBE_FRAME, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        start = PIOS_DELAY_GetRaw();
+        arrival[PIOS_LATENCYPROBE_FRAME] = 0;
+    }
+}
+
+void PIOS_LATENCYPROBE_Pass(uint8_t from, uint8_t to)
+{
+    // Every update of the chain comes here, keep the untagged ones cheap
+    if (__atomic_load_n(&stage, __ATOMIC_ACQUIRE) != from) {
+        return;
+    }
+
+    uint32_t elapsed = PIOS_DELAY_DiffuS(start);
+    uint8_t expected = from;
+    if (!__atomic_compare_exchange_n(&stage, &expected, to, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    for (uint8_t i = from + 1; i <= to; i++) {
+        arrival[i] = elapsed;
+    }
+
+    if (to == PIOS_LATENCYPROBE_OUTPUT) {
+        complete(elapsed);
+        __atomic_store_n(&stage, PIOS_LATENCYPROBE_IDLE, __ATOMIC_RELEASE);
+    }
+}
+
+void PIOS_LATENCYPROBE_GetStats(struct pios_latencyprobe_stats *stats)
+{
+    vPortEnterCritical();
+    stats->samples = samples;
+    stats->dropped = dropped;
+    stats->min     = samples ? min : 0;
+    stats->max     = max;
+    stats->avg     = samples ? (uint32_t)(sum / samples) : 0;
+    for (uint8_t i = 0; i < PIOS_LATENCYPROBE_STAGES; i++) {
+        stats->stage[i] = samples ? (uint32_t)(stageSum[i] / samples) : 0;
+    }
+    vPortExitCritical();
+}
+
+static void complete(uint32_t latency)
+{
+    vPortEnterCritical();
+    samples++;
+    sum += latency;
+    if (latency < min) {
+        min = latency;
+    }
+    if (latency > max) {
+        max = latency;
+    }
+    for (uint8_t i = PIOS_LATENCYPROBE_FRAME; i < PIOS_LATENCYPROBE_STAGES; i++) {
+        stageSum[i] += arrival[i];
+    }
+    vPortExitCritical();
+}
+
+#endif /* PIOS_INCLUDE_LATENCYPROBE */
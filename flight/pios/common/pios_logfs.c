@@ -294,6 +294,17 @@ int32_t PIOS_FLASHFS_GetStats(
     return 0;
 }
 
+/**
+ * @brief Garbage collects the log ahead of time, so saves rarely have to
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ */
+int32_t PIOS_FLASHFS_Compact(__attribute__((unused)) uintptr_t fs_id)
+{
+    /* stub - not needed */
+    return 0;
+}
+
 
 /**
  * @}
@@ -30,39 +30,200 @@
 #ifdef PIOS_TARGET_PROVIDES_FAST_HEAP
 // relies on pios_general_malloc to perform the allocation (i.e. pios_msheap.c)
 extern void *pios_general_malloc(size_t size, bool fastheap);
+#define heap_malloc(size)     pios_general_malloc((size), false)
+#define fastheap_malloc(size) pios_general_malloc((size), true)
+#else
+// demand to pvPortMalloc implementation
+#define heap_malloc(size)     pvPortMalloc(size)
+#define fastheap_malloc(size) pvPortMalloc(size)
+#endif /* ifdef PIOS_TARGET_PROVIDES_FAST_HEAP */
 
-void *pios_fastheapmalloc(size_t size)
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+static struct pios_mem_owner_stats owners[PIOS_MEM_MAX_OWNERS] = { { .name = "System" } };
+static uint8_t ownerCount   = 1;
+static uint8_t currentOwner = 0;
+
+void PIOS_MEM_SetOwner(const char *name)
+{
+    uint8_t owner;
+
+    for (owner = 0; name && owner < ownerCount && strcmp(owners[owner].name, name); owner++) {
+        ;
+    }
+    if (name && owner == ownerCount) {
+        if (ownerCount == PIOS_MEM_MAX_OWNERS) {
+            // table full, charge it to the system
+            owner = 0;
+        } else {
+            owners[ownerCount++].name = name;
+        }
+    }
+    currentOwner = name ? owner : 0;
+}
+
+bool PIOS_MEM_GetOwnerStats(uint8_t owner, struct pios_mem_owner_stats *stats)
 {
-    return pios_general_malloc(size, true);
+    if (owner >= ownerCount) {
+        return false;
+    }
+    PIOS_IRQ_Disable();
+    *stats = owners[owner];
+    PIOS_IRQ_Enable();
+    return true;
 }
+#endif /* PIOS_INCLUDE_MEM_ACCOUNTING */
 
+#ifdef PIOS_MEM_POOLS
+struct mem_pool_cfg {
+    uint16_t block_size; // multiple of the heap alignment
+    uint16_t blocks;
+};
 
-void *pios_malloc(size_t size)
+struct mem_pool {
+    uint8_t  *arena; // blocks, followed by the owner of each block with accounting
+    void     *free_list; // the first word of a free block links to the next one
+    uint16_t free;
+    uint16_t min_free;
+    uint16_t misses;
+};
+
+static const struct mem_pool_cfg poolCfg[] = PIOS_MEM_POOLS;
+static struct mem_pool pools[NELEMENTS(poolCfg)];
+static bool poolsCreated;
+
+// run by the first allocation, early in the board init
+static void createPools(void)
 {
-    return pios_general_malloc(size, false);
+    poolsCreated = true;
+    for (uint8_t p = 0; p < NELEMENTS(poolCfg); p++) {
+        uint32_t size = poolCfg[p].block_size * poolCfg[p].blocks;
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+        size += poolCfg[p].blocks;
+#endif
+        struct mem_pool *pool = &pools[p];
+        pool->arena = (uint8_t *)heap_malloc(size);
+        if (!pool->arena) {
+            continue;
+        }
+        for (int16_t b = poolCfg[p].blocks - 1; b >= 0; b--) {
+            void *block = pool->arena + b * poolCfg[p].block_size;
+            *(void **)block = pool->free_list;
+            pool->free_list = block;
+        }
+        pool->free     = poolCfg[p].blocks;
+        pool->min_free = poolCfg[p].blocks;
+    }
 }
 
-void pios_free(void *p)
+static void *poolAlloc(size_t size)
 {
-    vPortFree(p);
+    if (!poolsCreated) {
+        createPools();
+    }
+    for (uint8_t p = 0; p < NELEMENTS(poolCfg); p++) {
+        struct mem_pool *pool = &pools[p];
+        if (size > poolCfg[p].block_size || !pool->arena) {
+            continue;
+        }
+        PIOS_IRQ_Disable();
+        void *block = pool->free_list;
+        if (block) {
+            pool->free_list = *(void **)block;
+            pool->free--;
+            if (pool->free < pool->min_free) {
+                pool->min_free = pool->free;
+            }
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+            uint16_t b = ((uint8_t *)block - pool->arena) / poolCfg[p].block_size;
+            pool->arena[poolCfg[p].block_size * poolCfg[p].blocks + b] = currentOwner;
+            owners[currentOwner].pool_blocks++;
+            owners[currentOwner].allocations++;
+#endif
+        } else {
+            // try the next larger pool, then the heap
+            pool->misses++;
+        }
+        PIOS_IRQ_Enable();
+        if (block) {
+            return block;
+        }
+    }
+    return NULL;
 }
 
-#else
-// demand to pvPortMalloc implementation
-void *pios_fastheapmalloc(size_t size)
+static bool poolFree(void *p)
 {
-    return pvPortMalloc(size);
+    for (uint8_t i = 0; i < NELEMENTS(poolCfg); i++) {
+        struct mem_pool *pool = &pools[i];
+        uint32_t arenaSize    = poolCfg[i].block_size * poolCfg[i].blocks;
+        if (!pool->arena || (uint8_t *)p < pool->arena || (uint8_t *)p >= pool->arena + arenaSize) {
+            continue;
+        }
+        PIOS_IRQ_Disable();
+        *(void **)p     = pool->free_list;
+        pool->free_list = p;
+        pool->free++;
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+        uint16_t b = ((uint8_t *)p - pool->arena) / poolCfg[i].block_size;
+        owners[pool->arena[arenaSize + b]].pool_blocks--;
+#endif
+        PIOS_IRQ_Enable();
+        return true;
+    }
+    return false;
 }
 
+bool PIOS_MEM_GetPoolStats(uint8_t pool, struct pios_mem_pool_stats *stats)
+{
+    if (pool >= NELEMENTS(poolCfg)) {
+        return false;
+    }
+    stats->block_size = poolCfg[pool].block_size;
+    stats->blocks     = pools[pool].arena ? poolCfg[pool].blocks : 0;
+    stats->free       = pools[pool].free;
+    stats->min_free   = pools[pool].min_free;
+    stats->misses     = pools[pool].misses;
+    return true;
+}
+
+#else /* ifdef PIOS_MEM_POOLS */
+#define poolAlloc(size) NULL
+#define poolFree(p)     false
+
+bool PIOS_MEM_GetPoolStats(__attribute__((unused)) uint8_t pool, __attribute__((unused)) struct pios_mem_pool_stats *stats)
+{
+    return false;
+}
+#endif /* ifdef PIOS_MEM_POOLS */
+
+static void *accountHeap(void *p, __attribute__((unused)) size_t size)
+{
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+    if (p) {
+        PIOS_IRQ_Disable();
+        owners[currentOwner].heap_bytes += size;
+        owners[currentOwner].allocations++;
+        PIOS_IRQ_Enable();
+    }
+#endif
+    return p;
+}
+
+void *pios_fastheapmalloc(size_t size)
+{
+    return accountHeap(fastheap_malloc(size), size);
+}
 
 void *pios_malloc(size_t size)
 {
-    return pvPortMalloc(size);
+    void *p = poolAlloc(size);
+
+    return p ? p : accountHeap(heap_malloc(size), size);
 }
 
 void pios_free(void *p)
 {
-    vPortFree(p);
+    if (!poolFree(p)) {
+        vPortFree(p);
+    }
 }
-
-#endif /* ifdef PIOS_TARGET_PROVIDES_FAST_HEAP */
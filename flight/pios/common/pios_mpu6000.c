@@ -68,6 +68,11 @@ struct mpu6000_dev {
     enum pios_mpu6000_range gyro_range;
     enum pios_mpu6000_accel_range accel_range;
     enum pios_mpu6000_filter filter;
+    uint8_t fifo_burst;
+    uint8_t fifo_pending;
+#ifdef PIOS_SPI_JOBS
+    struct pios_spi_job sensor_job;
+#endif
     enum pios_mpu6000_dev_magic   magic;
 };
 
@@ -97,10 +102,25 @@ typedef union {
 
 #define GET_SENSOR_DATA(mpudataptr, sensor) (mpudataptr.data.sensor##_h << 8 | mpudataptr.data.sensor##_l)
 
+// FIFO samples hold the same registers in the same order as a direct read
+#define PIOS_MPU6000_FIFO_SAMPLE \
+    (PIOS_MPU6000_ACCEL_OUT | PIOS_MPU6000_FIFO_TEMP_OUT | PIOS_MPU6000_FIFO_GYRO_X_OUT | \
+     PIOS_MPU6000_FIFO_GYRO_Y_OUT | PIOS_MPU6000_FIFO_GYRO_Z_OUT)
+#define PIOS_MPU6000_FIFO_SIZE        1024
+#define PIOS_MPU6000_FIFO_MAX_SAMPLES 16
+
 // ! Global structure for this device device
 static struct mpu6000_dev *dev;
 volatile bool mpu6000_configured = false;
 static mpu6000_data_t mpu6000_data;
+#ifdef PIOS_SPI_JOBS
+static const uint8_t mpu6000_sensor_send_buf[1 + PIOS_MPU6000_SAMPLES_BYTES] = { PIOS_MPU6000_SENSOR_FIRST_REG | 0x80 };
+static const struct pios_spi_transfer mpu6000_sensor_transfer = {
+    .send_buffer    = &mpu6000_sensor_send_buf[0],
+    .receive_buffer = &mpu6000_data.buffer[0],
+    .len = sizeof(mpu6000_data_t),
+};
+#endif
 static PIOS_SENSORS_3Axis_SensorsWithTemp *queue_data = 0;
 #define SENSOR_COUNT     2
 #define SENSOR_DATA_SIZE (sizeof(PIOS_SENSORS_3Axis_SensorsWithTemp) + sizeof(Vector3i16) * SENSOR_COUNT)
@@ -112,7 +132,12 @@ static int32_t PIOS_MPU6000_SetReg(uint8_t address, uint8_t buffer);
 static int32_t PIOS_MPU6000_GetReg(uint8_t address);
 static void PIOS_MPU6000_SetSpeed(const bool fast);
 static bool PIOS_MPU6000_HandleData();
+#ifdef PIOS_SPI_JOBS
+static void PIOS_MPU6000_SensorJobDone(struct pios_spi_job *job, int32_t status, bool *woken);
+#else
 static bool PIOS_MPU6000_ReadSensor(bool *woken);
+#endif
+static bool PIOS_MPU6000_ReadFifo(bool *woken);
 
 static int32_t PIOS_MPU6000_Test(void);
 
@@ -131,6 +156,8 @@ static struct mpu6000_dev *PIOS_MPU6000_alloc(const struct pios_mpu6000_cfg *cfg
     PIOS_Assert(mpu6000_dev);
 
     mpu6000_dev->magic = PIOS_MPU6000_DEV_MAGIC;
+    mpu6000_dev->fifo_burst   = 0;
+    mpu6000_dev->fifo_pending = 0;
 
     mpu6000_dev->queue = xQueueCreate(cfg->max_downsample + 1, SENSOR_DATA_SIZE);
     PIOS_Assert(mpu6000_dev->queue);
@@ -174,6 +201,18 @@ int32_t PIOS_MPU6000_Init(uint32_t spi_id, uint32_t slave_num, const struct pios
     dev->slave_num = slave_num;
     dev->cfg = cfg;
 
+#ifdef PIOS_SPI_JOBS
+    /* The samples are read by a queued job, ahead of any other job of the bus */
+    dev->sensor_job = (struct pios_spi_job) {
+        .slave_id      = slave_num,
+        .prescaler     = cfg->fast_prescaler,
+        .priority      = PIOS_SPI_PRIORITY_HIGH,
+        .transfers     = &mpu6000_sensor_transfer,
+        .num_transfers = 1,
+        .callback      = PIOS_MPU6000_SensorJobDone,
+    };
+#endif
+
     /* Configure the MPU6000 Sensor */
     PIOS_MPU6000_Config(cfg);
 
@@ -230,12 +269,13 @@ static void PIOS_MPU6000_Config(struct pios_mpu6000_cfg const *cfg)
     }
 
     // FIFO storage
-    while (PIOS_MPU6000_SetReg(PIOS_MPU6000_FIFO_EN_REG, cfg->Fifo_store) != 0) {
+    while (PIOS_MPU6000_SetReg(PIOS_MPU6000_FIFO_EN_REG, cfg->fifo_rate ? PIOS_MPU6000_FIFO_SAMPLE : cfg->Fifo_store) != 0) {
         ;
     }
     PIOS_MPU6000_ConfigureRanges(cfg->gyro_range, cfg->accel_range, cfg->filter);
     // Interrupt configuration
-    while (PIOS_MPU6000_SetReg(PIOS_MPU6000_USER_CTRL_REG, cfg->User_ctl) != 0) {
+    while (PIOS_MPU6000_SetReg(PIOS_MPU6000_USER_CTRL_REG,
+                               cfg->fifo_rate ? (cfg->User_ctl | PIOS_MPU6000_USERCTL_FIFO_EN | PIOS_MPU6000_USERCTL_FIFO_RST) : cfg->User_ctl) != 0) {
         ;
     }
 
@@ -286,6 +326,14 @@ int32_t PIOS_MPU6000_ConfigureRanges(
 
     dev->filter = filterSetting;
 
+    // Number of data ready interrupts between two FIFO reads
+    if (dev->cfg->fifo_rate) {
+        uint16_t rate  = filterSetting == PIOS_MPU6000_LOWPASS_256_HZ ?
+                         8000 / (1 + dev->cfg->Smpl_rate_div_no_dlp) : 1000 / (1 + dev->cfg->Smpl_rate_div_dlp);
+        uint16_t burst = rate / dev->cfg->fifo_rate;
+        dev->fifo_burst = burst < 1 ? 1 : (burst > PIOS_MPU6000_FIFO_MAX_SAMPLES ? PIOS_MPU6000_FIFO_MAX_SAMPLES : burst);
+    }
+
     // Gyro range
     while (PIOS_MPU6000_SetReg(PIOS_MPU6000_GYRO_CFG_REG, gyroRange) != 0) {
         ;
@@ -547,12 +595,29 @@ bool PIOS_MPU6000_IRQHandler(void)
     }
 
     bool read_ok = false;
-    read_ok = PIOS_MPU6000_ReadSensor(&woken);
+    if (dev->fifo_burst) {
+        // No FIFO watermark interrupt on this chip, count data ready until a burst is due
+        if (++dev->fifo_pending < dev->fifo_burst) {
+            return false;
+        }
+        dev->fifo_pending = 0;
+        PIOS_EVENTTRACE(PIOS_EVENTTRACE_ISR_ENTER, PIOS_EVENTTRACE_ISR_MPU6000);
+        read_ok = PIOS_MPU6000_ReadFifo(&woken);
+    } else {
+        PIOS_EVENTTRACE(PIOS_EVENTTRACE_ISR_ENTER, PIOS_EVENTTRACE_ISR_MPU6000);
+#ifdef PIOS_SPI_JOBS
+        // The sample is handled once the job is done, while the job is pending new samples are dropped
+        PIOS_SPI_QueueJob(dev->spi_id, &dev->sensor_job);
+#else
+        read_ok = PIOS_MPU6000_ReadSensor(&woken);
+#endif
+    }
 
     if (read_ok) {
         bool woken2 = PIOS_MPU6000_HandleData();
         woken |= woken2;
     }
+    PIOS_EVENTTRACE(PIOS_EVENTTRACE_ISR_EXIT, PIOS_EVENTTRACE_ISR_MPU6000);
 
     return woken;
 }
@@ -605,6 +670,14 @@ static bool PIOS_MPU6000_HandleData()
     return higherPriorityTaskWoken == pdTRUE;
 }
 
+#ifdef PIOS_SPI_JOBS
+static void PIOS_MPU6000_SensorJobDone(__attribute__((unused)) struct pios_spi_job *job, int32_t status, bool *woken)
+{
+    if (status == 0 && PIOS_MPU6000_HandleData()) {
+        *woken = true;
+    }
+}
+#else
 static bool PIOS_MPU6000_ReadSensor(bool *woken)
 {
     const uint8_t mpu6000_send_buf[1 + PIOS_MPU6000_SAMPLES_BYTES] = { PIOS_MPU6000_SENSOR_FIRST_REG | 0x80 };
@@ -619,6 +692,67 @@ static bool PIOS_MPU6000_ReadSensor(bool *woken)
     PIOS_MPU6000_ReleaseBusISR(woken);
     return true;
 }
+#endif /* PIOS_SPI_JOBS */
+
+/**
+ * @brief Burst read all the samples queued in the FIFO and average them into mpu6000_data
+ * @return true if a sample is ready in mpu6000_data
+ */
+static bool PIOS_MPU6000_ReadFifo(bool *woken)
+{
+    static const uint8_t count_send_buf[3] = { PIOS_MPU6000_FIFO_CNT_MSB | 0x80 };
+    static const uint8_t fifo_send_buf[1 + PIOS_MPU6000_FIFO_MAX_SAMPLES * PIOS_MPU6000_SAMPLES_BYTES] = { PIOS_MPU6000_FIFO_REG | 0x80 };
+    static uint8_t fifo_buf[1 + PIOS_MPU6000_FIFO_MAX_SAMPLES * PIOS_MPU6000_SAMPLES_BYTES];
+    uint8_t count_buf[3];
+
+    if (PIOS_MPU6000_ClaimBusISR(woken, true) != 0) {
+        return false;
+    }
+    if (PIOS_SPI_TransferBlock(dev->spi_id, &count_send_buf[0], &count_buf[0], sizeof(count_buf), NULL) < 0) {
+        PIOS_MPU6000_ReleaseBusISR(woken);
+        return false;
+    }
+    PIOS_SPI_RC_PinSet(dev->spi_id, dev->slave_num, 1);
+
+    uint16_t count = count_buf[1] << 8 | count_buf[2];
+    if (count > PIOS_MPU6000_FIFO_SIZE - PIOS_MPU6000_SAMPLES_BYTES) {
+        // Overflowed, the sample boundaries are lost
+        const uint8_t reset_buf[2] = { PIOS_MPU6000_USER_CTRL_REG & 0x7f,
+                                       dev->cfg->User_ctl | PIOS_MPU6000_USERCTL_FIFO_EN | PIOS_MPU6000_USERCTL_FIFO_RST };
+        PIOS_SPI_RC_PinSet(dev->spi_id, dev->slave_num, 0);
+        PIOS_SPI_TransferBlock(dev->spi_id, &reset_buf[0], NULL, sizeof(reset_buf), NULL);
+        PIOS_MPU6000_ReleaseBusISR(woken);
+        return false;
+    }
+
+    uint16_t samples = count / PIOS_MPU6000_SAMPLES_BYTES;
+    if (samples == 0) {
+        PIOS_MPU6000_ReleaseBusISR(woken);
+        return false;
+    }
+    if (samples > PIOS_MPU6000_FIFO_MAX_SAMPLES) {
+        samples = PIOS_MPU6000_FIFO_MAX_SAMPLES;
+    }
+    PIOS_SPI_RC_PinSet(dev->spi_id, dev->slave_num, 0);
+    if (PIOS_SPI_TransferBlock(dev->spi_id, &fifo_send_buf[0], &fifo_buf[0], 1 + samples * PIOS_MPU6000_SAMPLES_BYTES, NULL) < 0) {
+        PIOS_MPU6000_ReleaseBusISR(woken);
+        return false;
+    }
+    PIOS_MPU6000_ReleaseBusISR(woken);
+
+    // Boxcar decimation of every 16 bit word (accel, temperature and gyro)
+    for (uint8_t w = 1; w < 1 + PIOS_MPU6000_SAMPLES_BYTES; w += 2) {
+        int32_t sum = 0;
+        for (uint16_t i = 0; i < samples; i++) {
+            const uint8_t *b = &fifo_buf[w + i * PIOS_MPU6000_SAMPLES_BYTES];
+            sum += (int16_t)(b[0] << 8 | b[1]);
+        }
+        sum = (sum + (sum >= 0 ? samples / 2 : -(int32_t)(samples / 2))) / (int32_t)samples;
+        mpu6000_data.buffer[w]     = (uint8_t)(sum >> 8);
+        mpu6000_data.buffer[w + 1] = (uint8_t)sum;
+    }
+    return true;
+}
 
 // Sensor driver implementation
 bool PIOS_MPU6000_driver_Test(__attribute__((unused)) uintptr_t context)
@@ -628,6 +762,11 @@ bool PIOS_MPU6000_driver_Test(__attribute__((unused)) uintptr_t context)
 
 void PIOS_MPU6000_driver_Reset(__attribute__((unused)) uintptr_t context)
 {
+    if (dev->fifo_burst) {
+        PIOS_MPU6000_SetReg(PIOS_MPU6000_USER_CTRL_REG, dev->cfg->User_ctl | PIOS_MPU6000_USERCTL_FIFO_EN | PIOS_MPU6000_USERCTL_FIFO_RST);
+        dev->fifo_pending = 0;
+        return;
+    }
     PIOS_MPU6000_DummyReadGyros();
 }
 
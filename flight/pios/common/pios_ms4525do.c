@@ -35,7 +35,29 @@
 
 /* Local Defs and Variables */
 
+#ifdef PIOS_I2C_ASYNC
+static uint8_t ms4525do_rx[4];
+static uint8_t ms4525do_data[4];
+static volatile int8_t ms4525do_status = -2; // of ms4525do_data, -2 until the read started by the last call has ended
 
+static const struct pios_i2c_txn ms4525do_txn_list[] = {
+    {
+        .info = "PIOS_MS4525DO_Read",
+        .addr = MS4525DO_I2C_ADDR,
+        .rw   = PIOS_I2C_TXN_READ,
+        .len  = sizeof(ms4525do_rx),
+        .buf  = ms4525do_rx,
+    }
+};
+
+static void PIOS_MS4525DO_ReadDone(int32_t status, __attribute__((unused)) void *context, __attribute__((unused)) bool *woken)
+{
+    if (status == 0) {
+        memcpy(ms4525do_data, ms4525do_rx, sizeof(ms4525do_data));
+    }
+    ms4525do_status = status;
+}
+#else
 static int8_t PIOS_MS4525DO_ReadI2C(uint8_t *buffer, uint8_t len)
 {
     const struct pios_i2c_txn txn_list[] = {
@@ -50,6 +72,7 @@ static int8_t PIOS_MS4525DO_ReadI2C(uint8_t *buffer, uint8_t len)
 
     return PIOS_I2C_Transfer(PIOS_I2C_MS4525DO_ADAPTER, txn_list, NELEMENTS(txn_list));
 }
+#endif /* PIOS_I2C_ASYNC */
 
 
 // values has to ba an arrray with two elements
@@ -57,7 +80,27 @@ static int8_t PIOS_MS4525DO_ReadI2C(uint8_t *buffer, uint8_t len)
 int8_t PIOS_MS4525DO_Read(uint16_t *values)
 {
     uint8_t data[4];
+
+#ifdef PIOS_I2C_ASYNC
+    // Hand out the read ended since the last call and start the next one,
+    // so the values are one call late but the caller does not wait for its read
+    PIOS_IRQ_Disable();
+    int8_t retVal = ms4525do_status;
+    memcpy(data, ms4525do_data, sizeof(data));
+    ms4525do_status = -2;
+    PIOS_IRQ_Enable();
+
+    int32_t started = PIOS_I2C_Transfer_Async(PIOS_I2C_MS4525DO_ADAPTER, ms4525do_txn_list, NELEMENTS(ms4525do_txn_list), PIOS_MS4525DO_ReadDone, NULL);
+    if (started != 0) {
+        ms4525do_status = started;
+    }
+
+    if (retVal != 0) {
+        return retVal;
+    }
+#else
     int8_t retVal  = PIOS_MS4525DO_ReadI2C(data, sizeof(data));
+#endif /* PIOS_I2C_ASYNC */
 
     uint8_t status = data[0] & 0xC0;
 
@@ -399,7 +399,10 @@ int32_t PIOS_MS5611_Test()
 /* PIOS sensor driver implementation */
 void PIOS_MS5611_Register()
 {
-    PIOS_SENSORS_Register(&PIOS_MS5611_Driver, PIOS_SENSORS_TYPE_1AXIS_BARO, 0);
+    PIOS_SENSORS_Instance *instance = PIOS_SENSORS_Register(&PIOS_MS5611_Driver, PIOS_SENSORS_TYPE_1AXIS_BARO, 0);
+
+    // No data ready line, poll once per conversion
+    PIOS_SENSORS_SetPollPeriod(instance, conversionDelayMs);
 }
 
 bool PIOS_MS5611_driver_Test(__attribute__((unused)) uintptr_t context)
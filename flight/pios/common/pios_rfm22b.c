@@ -64,7 +64,7 @@
 #include <sha1.h>
 
 /* Local Defines */
-#define STACK_SIZE_BYTES                 200
+#define STACK_SIZE_BYTES                 280
 #define TASK_PRIORITY                    (tskIDLE_PRIORITY + 4) // flight control relevant device driver (ppm link)
 #define ISR_TIMEOUT                      1 // ms
 #define EVENT_QUEUE_SIZE                 5
@@ -127,6 +127,36 @@
 #define CONNECTED_TIMEOUT (250 / portTICK_RATE_MS) /* ms */
 #define MAX_CHANNELS      32
 
+// Link adaptation, see rfm22_adaptLink()
+#define RFM22B_LINK_CTRL_BYTES           2
+#define RFM22B_FEC_MIN_PARITY            4
+#define RFM22B_FEC_LEVELS                ((RS_ECC_NPARITY - RFM22B_FEC_MIN_PARITY) / 2 + 1)
+#define RFM22B_ADAPT_PACKETS             64 // tx packets between two decisions, the rx stats window
+#define RFM22B_ADAPT_LQ_LOW              96
+#define RFM22B_ADAPT_LQ_HIGH             120
+#define RFM22B_ADAPT_CORRECTED_HIGH      16
+#define RFM22B_ADAPT_CORRECTED_LOW       2
+#define RFM22B_ADAPT_GOOD_PERIODS        2
+#define RFM22B_ADAPT_RSSI_DOWN_MARGIN    3  // dB
+#define RFM22B_ADAPT_RSSI_UP_MARGIN      10 // dB
+#define RFM22B_LINK_LOST_TIMEOUT         2000 // ms
+
+// The RC slot that leads every packet of a PPM link, see radio_txStart()
+#define RFM22B_RC_DATA_LEN               (RFM22B_PPM_NUM_CHANNELS + 2) // LSBs, channels, CRC
+#define RFM22B_RC_PARITY                 RFM22B_FEC_MIN_PARITY
+#define RFM22B_RC_SLOT_LEN               (RFM22B_RC_DATA_LEN + RFM22B_RC_PARITY)
+
+// The first byte of the link control header
+#define RFM22B_CTRL_FEC_MASK             0x03
+#define RFM22B_CTRL_SHORT                0x04
+#define RFM22B_CTRL_RATE_SHIFT           3
+#define RFM22B_CTRL_RATE_MASK            0x78
+#define RFM22B_CTRL_RATE_SWITCH          0x80
+
+#if (RS_ECC_NPARITY < RFM22B_FEC_MIN_PARITY) || (RFM22B_FEC_LEVELS > RFM22B_CTRL_FEC_MASK + 1)
+#error RS_ECC_NPARITY out of range for the RFM22B link
+#endif
+
 /* Local type definitions */
 
 struct pios_rfm22b_transition {
@@ -185,6 +215,9 @@ static enum pios_radio_event rfm22_timeout(struct pios_rfm22b_dev *rfm22b_dev);
 static enum pios_radio_event rfm22_error(struct pios_rfm22b_dev *rfm22b_dev);
 static enum pios_radio_event rfm22_fatal_error(struct pios_rfm22b_dev *rfm22b_dev);
 static void rfm22b_add_rx_status(struct pios_rfm22b_dev *rfm22b_dev, enum pios_rfm22b_rx_packet_status status);
+static void rfm22b_add_rc_status(struct pios_rfm22b_dev *rfm22b_dev, bool received);
+static void rfm22_packRCSlot(struct pios_rfm22b_dev *rfm22b_dev, uint8_t *p);
+static bool rfm22_unpackRCSlot(struct pios_rfm22b_dev *rfm22b_dev, uint8_t *p);
 static void rfm22_setNominalCarrierFrequency(struct pios_rfm22b_dev *rfm22b_dev, uint8_t init_chan);
 static bool rfm22_setFreqHopChannel(struct pios_rfm22b_dev *rfm22b_dev, uint8_t channel);
 static void rfm22_updatePairStatus(struct pios_rfm22b_dev *radio_dev);
@@ -200,6 +233,17 @@ static uint8_t rfm22_calcChannelFromClock(struct pios_rfm22b_dev *rfm22b_dev);
 static bool rfm22_changeChannel(struct pios_rfm22b_dev *rfm22b_dev);
 static void rfm22_clearLEDs();
 
+// Link adaptation functions.
+static void rfm22_setLinkRate(struct pios_rfm22b_dev *rfm22b_dev, enum rfm22b_datarate datarate);
+static void rfm22_switchDatarate(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_updateLink(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_adaptLink(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_followCoordinator(struct pios_rfm22b_dev *rfm22b_dev, uint8_t ctrl);
+static uint8_t rfm22_linkControl(struct pios_rfm22b_dev *rfm22b_dev);
+static int8_t rfm22_decodePacket(struct pios_rfm22b_dev *rfm22b_dev, uint8_t *p, uint8_t rx_len, bool *corrected);
+static uint32_t rfm22_hopCycle(struct pios_rfm22b_dev *rfm22b_dev);
+static uint8_t rfm22_fecParity(uint8_t level);
+
 // Utility functions.
 static uint32_t pios_rfm22_time_difference_ms(portTickType start_time, portTickType end_time);
 static struct pios_rfm22b_dev *pios_rfm22_alloc(void);
@@ -372,6 +416,9 @@ static const uint8_t packet_time[] = { 80, 40, 25, 15, 13, 10, 8, 6, 5 };
 static const uint8_t packet_time_ppm[] = { 26, 25, 25, 15, 13, 10, 8, 6, 5 };
 static const uint8_t num_channels[] = { 32, 32, 32, 32, 32, 32, 32, 32, 32 };
 
+// Approximate receiver sensitivity in dBm, for the RSSI margins of the link adaptation.
+static const int8_t rssi_min[] = { -108, -105, -103, -101, -100, -98, -97, -95, -94 };
+
 static struct pios_rfm22b_dev *g_rfm22b_dev = NULL;
 
 
@@ -423,6 +470,10 @@ int32_t PIOS_RFM22B_Init(uint32_t *rfm22b_id, uint32_t spi_id, uint32_t slave_nu
     rfm22b_dev->stats.rx_corrected    = 0;
     rfm22b_dev->stats.rx_error     = 0;
     rfm22b_dev->stats.rx_missed    = 0;
+    rfm22b_dev->stats.rc_good      = 0;
+    rfm22b_dev->stats.rc_lost      = 0;
+    rfm22b_dev->rc_slot_lost       = 0;
+    rfm22b_dev->rc_slot_count      = 0;
     rfm22b_dev->stats.tx_dropped   = 0;
     rfm22b_dev->stats.resets       = 0;
     rfm22b_dev->stats.timeouts     = 0;
@@ -600,26 +651,25 @@ void PIOS_RFM22B_SetChannelConfig(uint32_t rfm22b_id, enum rfm22b_datarate datar
     if (ppm_only) {
         rfm22b_dev->one_way_link = true;
         datarate = RFM22B_PPM_ONLY_DATARATE;
-        rfm22b_dev->datarate     = RFM22B_PPM_ONLY_DATARATE;
     } else {
         rfm22b_dev->one_way_link = oneway;
-        rfm22b_dev->datarate     = datarate;
     }
-    rfm22b_dev->packet_time = (ppm_mode ? packet_time_ppm[datarate] : packet_time[datarate]);
+    rfm22b_dev->min_chan = min_chan;
+    rfm22b_dev->max_chan = max_chan;
 
-    uint8_t num_found = 0;
-    rfm22_gen_channels(rfm22_destinationID(rfm22b_dev), datarate, min_chan, max_chan,
-                       rfm22b_dev->channels, &num_found);
-
-    rfm22b_dev->num_channels = num_found;
-
-    // Calculate the maximum packet length from the datarate.
-    float bytes_per_period = (float)data_rate[datarate] * (float)(rfm22b_dev->packet_time - 2) / 9000;
-
-    rfm22b_dev->max_packet_len = bytes_per_period - TX_PREAMBLE_NIBBLES / 2 - SYNC_BYTES - HEADER_BYTES - LENGTH_BYTES;
-    if (rfm22b_dev->max_packet_len > RFM22B_MAX_PACKET_LEN) {
-        rfm22b_dev->max_packet_len = RFM22B_MAX_PACKET_LEN;
-    }
+    // Only a bound two way link can negotiate, the others stay at the configured datarate.
+    rfm22b_dev->adaptive = !rfm22b_dev->one_way_link && (coordinator || rfm22b_dev->coordinatorID);
+    rfm22b_dev->base_datarate     = datarate;
+    rfm22b_dev->next_datarate     = datarate;
+    rfm22b_dev->fec_level         = 0;
+    rfm22b_dev->short_packets     = false;
+    rfm22b_dev->rx_fec_level      = 0;
+    rfm22b_dev->peer_link_quality = 0;
+    rfm22b_dev->good_periods      = 0;
+    rfm22b_dev->adapt_seq         = rfm22b_dev->stats.tx_seq;
+    rfm22b_dev->time_epoch        = 0;
+    rfm22b_dev->rate_step_ticks   = xTaskGetTickCount();
+    rfm22_setLinkRate(rfm22b_dev, datarate);
 }
 
 /**
@@ -668,6 +718,8 @@ void PIOS_RFM22B_GetStats(uint32_t rfm22b_id, struct rfm22b_stats *stats)
 
     // Calculate the current link quality
     rfm22_calculateLinkQuality(rfm22b_dev);
+    rfm22b_dev->stats.air_datarate = rfm22b_dev->datarate;
+    rfm22b_dev->stats.fec_parity   = rfm22b_dev->ppm_only_mode ? 0 : rfm22_fecParity(rfm22b_dev->fec_level);
 
     // Return the stats.
     *stats = rfm22b_dev->stats;
@@ -1189,6 +1241,9 @@ static void pios_rfm22_task(void *parameters)
             }
         }
 
+        // Follow or drive the link adaptation.
+        rfm22_updateLink(rfm22b_dev);
+
         // Change channels if necessary.
         if (rfm22_changeChannel(rfm22b_dev)) {
             rfm22_process_event(rfm22b_dev, RADIO_EVENT_RX_MODE);
@@ -1733,6 +1788,9 @@ static bool pios_rfm22_readStatus(struct pios_rfm22b_dev *rfm22b_dev)
 static void rfm22_rxFailure(struct pios_rfm22b_dev *rfm22b_dev)
 {
     rfm22b_add_rx_status(rfm22b_dev, RADIO_FAILURE_RX_PACKET);
+    if (rfm22b_dev->ppm_recv_mode) {
+        rfm22b_add_rc_status(rfm22b_dev, false);
+    }
     rfm22b_dev->rx_buffer_wr = 0;
     rfm22b_dev->packet_start_ticks = 0;
     rfm22b_dev->rfm22b_state = RFM22B_STATE_TRANSITION;
@@ -1743,9 +1801,87 @@ static void rfm22_rxFailure(struct pios_rfm22b_dev *rfm22b_dev)
 * Radio Transmit and Receive functions.
 *****************************************************************************/
 
+/**
+ * Write the PPM values to the RC slot: the LSB of each channel, the upper 8 bits
+ * of each channel and a CRC.
+ *
+ * @param[in] radio_dev The device structure
+ * @param[out] p  The RC slot, RFM22B_RC_DATA_LEN bytes
+ */
+static void rfm22_packRCSlot(struct pios_rfm22b_dev *radio_dev, uint8_t *p)
+{
+    // The first byte stores the LSB of each channel
+    p[0] = 0;
+
+    // Read the PPM input.
+    for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS; ++i) {
+        int32_t val = radio_dev->ppm[i];
+
+        // Clamp and translate value, or transmit as reserved "invalid" constant
+        if ((val == PIOS_RCVR_INVALID) || (val == PIOS_RCVR_TIMEOUT)) {
+            val = RFM22B_PPM_INVALID;
+        } else if (val > RFM22B_PPM_MAX_US) {
+            val = RFM22B_PPM_MAX;
+        } else if (val < RFM22B_PPM_MIN_US) {
+            val = RFM22B_PPM_MIN;
+        } else {
+            val = (val - RFM22B_PPM_MIN_US) / RFM22B_PPM_SCALE + RFM22B_PPM_MIN;
+        }
+
+        // Store LSB
+        if (val & 1) {
+            p[0] |= (1 << i);
+        }
+
+        // Store upper 8 bits in array
+        p[i + 1] = val >> 1;
+    }
+
+    // The last byte is a CRC, which also catches a wrong RS correction.
+    p[RFM22B_PPM_NUM_CHANNELS + 1] = PIOS_CRC_updateCRC(0, p, RFM22B_PPM_NUM_CHANNELS + 1);
+}
+
+/**
+ * Read the PPM values from a received RC slot, and pass them to the PPM callback.
+ *
+ * @param[in] radio_dev The device structure
+ * @param[in] p  The RC slot, RFM22B_RC_DATA_LEN bytes
+ * @return True if the CRC matched and the values were taken
+ */
+static bool rfm22_unpackRCSlot(struct pios_rfm22b_dev *radio_dev, uint8_t *p)
+{
+    if (p[RFM22B_PPM_NUM_CHANNELS + 1] != PIOS_CRC_updateCRC(0, p, RFM22B_PPM_NUM_CHANNELS + 1)) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS; ++i) {
+        // Calculate 9-bit value taking the LSB from byte 0
+        uint32_t val = (p[i + 1] << 1) + ((p[0] >> i) & 1);
+        // Is this a valid channel?
+        if (val != RFM22B_PPM_INVALID) {
+            radio_dev->ppm[i] = (uint16_t)(RFM22B_PPM_MIN_US + (val - RFM22B_PPM_MIN) * RFM22B_PPM_SCALE);
+        } else {
+            radio_dev->ppm[i] = PIOS_RCVR_INVALID;
+        }
+    }
+
+    // Call the PPM received callback if it's available.
+    if (radio_dev->ppm_callback) {
+        radio_dev->ppm_callback(radio_dev->ppm);
+    }
+    return true;
+}
+
 /**
  * Start a transmit if possible
  *
+ * In PPM mode every packet of the coordinator starts with a fixed length RC
+ * slot, the PPM values with their own CRC and RS parity, followed by the RS
+ * codeword of the link control header and the telemetry. The RC slot does not
+ * depend on the FEC level, the packet size or the telemetry queue, and is
+ * decoded on its own, so the RC latency stays one packet period whatever the
+ * telemetry load and errors.
+ *
  * @param[in] radio_dev The device structure
  * @return enum pios_radio_event  The next event to inject
  */
@@ -1753,7 +1889,8 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev *radio_dev)
 {
     uint8_t *p  = radio_dev->tx_packet;
     uint8_t len = 0;
-    uint8_t max_data_len = radio_dev->max_packet_len - (radio_dev->ppm_only_mode ? 0 : RS_ECC_NPARITY);
+    uint8_t rc_len = 0;
+    uint8_t parity = radio_dev->ppm_only_mode ? 0 : rfm22_fecParity(radio_dev->fec_level);
 
     // Don't send if it's not our turn, or if we're receiving a packet.
     if (!rfm22_timeToSend(radio_dev) || !PIOS_RFM22B_InRxWait((uint32_t)radio_dev)) {
@@ -1765,75 +1902,59 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev *radio_dev)
         return RADIO_EVENT_RX_MODE;
     }
 
-    // Should we append PPM data to the packet?
-    if (radio_dev->ppm_send_mode) {
-        len = RFM22B_PPM_NUM_CHANNELS + (radio_dev->ppm_only_mode ? 2 : 1);
-
-        // Ensure we can fit the PPM data in the packet.
-        if (max_data_len < len) {
+    // A PPM only packet is the RC slot alone, without parity.
+    if (radio_dev->ppm_only_mode) {
+        if (!radio_dev->ppm_send_mode) {
             return RADIO_EVENT_RX_MODE;
         }
+        rfm22_packRCSlot(radio_dev, p);
+        len = RFM22B_RC_DATA_LEN;
+    } else {
+        // The RC slot leads the packet and keeps its length whatever the link settings.
+        if (radio_dev->ppm_send_mode) {
+            rfm22_packRCSlot(radio_dev, p);
+            set_ecc_parity(RFM22B_RC_PARITY);
+            encode_data((unsigned char *)p, RFM22B_RC_DATA_LEN, (unsigned char *)p);
+            rc_len = RFM22B_RC_SLOT_LEN;
+            p += rc_len;
+        }
 
-        // The first byte stores the LSB of each channel
-        p[0] = 0;
-
-        // Read the PPM input.
-        for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS; ++i) {
-            int32_t val = radio_dev->ppm[i];
-
-            // Clamp and translate value, or transmit as reserved "invalid" constant
-            if ((val == PIOS_RCVR_INVALID) || (val == PIOS_RCVR_TIMEOUT)) {
-                val = RFM22B_PPM_INVALID;
-            } else if (val > RFM22B_PPM_MAX_US) {
-                val = RFM22B_PPM_MAX;
-            } else if (val < RFM22B_PPM_MIN_US) {
-                val = RFM22B_PPM_MIN;
-            } else {
-                val = (val - RFM22B_PPM_MIN_US) / RFM22B_PPM_SCALE + RFM22B_PPM_MIN;
-            }
+        // The telemetry codeword gets the rest of the packet.
+        uint8_t max_len = radio_dev->max_packet_len - rc_len;
+        if (radio_dev->short_packets) {
+            max_len /= 2;
+        }
+        if (max_len < parity + RFM22B_LINK_CTRL_BYTES) {
+            return RADIO_EVENT_RX_MODE;
+        }
 
-            // Store LSB
-            if (val & 1) {
-                p[0] |= (1 << i);
-            }
+        // Every RS encoded codeword starts with the link control header.
+        p[0] = rfm22_linkControl(radio_dev);
+        p[1] = radio_dev->stats.link_quality;
+        len  = RFM22B_LINK_CTRL_BYTES;
 
-            // Store upper 8 bits in array
-            p[i + 1] = val >> 1;
+        // Append data from the com interface if applicable.
+        if (radio_dev->tx_out_cb) {
+            // Try to get some data to send
+            bool need_yield = false;
+            len += (radio_dev->tx_out_cb)(radio_dev->tx_out_context, p + len, max_len - parity - len, NULL, &need_yield);
         }
 
-        // The last byte is a CRC.
-        if (radio_dev->ppm_only_mode) {
-            uint8_t crc = 0;
-            for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS + 1; ++i) {
-                crc = PIOS_CRC_updateByte(crc, p[i]);
-            }
-            p[RFM22B_PPM_NUM_CHANNELS + 1] = crc;
+        // Always send a packet if this modem is a coordinator.
+        if ((len == RFM22B_LINK_CTRL_BYTES) && !rfm22_isCoordinator(radio_dev)) {
+            return RADIO_EVENT_RX_MODE;
         }
-    }
 
-    // Append data from the com interface if applicable.
-    if (!radio_dev->ppm_only_mode && radio_dev->tx_out_cb) {
-        // Try to get some data to send
-        bool need_yield = false;
-        len += (radio_dev->tx_out_cb)(radio_dev->tx_out_context, p + len, max_data_len - len, NULL, &need_yield);
-    }
-
-    // Always send a packet if this modem is a coordinator.
-    if ((len == 0) && !rfm22_isCoordinator(radio_dev)) {
-        return RADIO_EVENT_RX_MODE;
+        // Add the error correcting code.
+        set_ecc_parity(parity);
+        encode_data((unsigned char *)p, len, (unsigned char *)p);
+        len += parity + rc_len;
+        p    = radio_dev->tx_packet;
     }
 
     // Increment the packet sequence number.
     radio_dev->stats.tx_seq++;
 
-    // Add the error correcting code.
-    if (!radio_dev->ppm_only_mode) {
-        if (len != 0) {
-            encode_data((unsigned char *)p, len, (unsigned char *)p);
-        }
-        len += RS_ECC_NPARITY;
-    }
-
     // Transmit the packet.
     PIOS_RFM22B_TransmitPacket((uint32_t)radio_dev, p, len);
 
@@ -1899,65 +2020,47 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev *radio_d
 {
     bool good_packet = true;
     bool corrected_packet = false;
-    uint8_t data_len = rx_len;
-
-    // We don't rsencode ppm only packets.
-    if (!radio_dev->ppm_only_mode) {
-        data_len -= RS_ECC_NPARITY;
-
-        // Attempt to correct any errors in the packet.
-        if (data_len > 0) {
-            decode_data((unsigned char *)p, rx_len);
-            good_packet = check_syndrome() == 0;
-
-            // We have an error.  Try to correct it.
-            if (!good_packet && (correct_errors_erasures((unsigned char *)p, rx_len, 0, 0) != 0)) {
-                // We corrected it
-                corrected_packet = true;
-            }
-        }
-    }
-
-    // Should we pull PPM data off of the head of the packet?
-    if ((good_packet || corrected_packet) && radio_dev->ppm_recv_mode) {
-        uint8_t ppm_len = RFM22B_PPM_NUM_CHANNELS + (radio_dev->ppm_only_mode ? 2 : 1);
-
-        // Ensure the packet it long enough
-        if (data_len < ppm_len) {
-            good_packet = false;
+    uint8_t data_len = 0;
+    uint8_t ctrl     = 0;
+    uint8_t peer_link_quality = 0;
+
+    if (radio_dev->ppm_only_mode) {
+        // We don't rsencode ppm only packets, the RC slot has its CRC.
+        good_packet = radio_dev->ppm_recv_mode && (rx_len >= RFM22B_RC_DATA_LEN) && rfm22_unpackRCSlot(radio_dev, p);
+        if (radio_dev->ppm_recv_mode) {
+            rfm22b_add_rc_status(radio_dev, good_packet);
         }
-
-        // Verify the CRC if this is a PPM only packet.
-        if ((good_packet || corrected_packet) && radio_dev->ppm_only_mode) {
-            uint8_t crc = 0;
-            for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS + 1; ++i) {
-                crc = PIOS_CRC_updateByte(crc, p[i]);
-            }
-            if (p[RFM22B_PPM_NUM_CHANNELS + 1] != crc) {
-                good_packet = false;
-                corrected_packet = false;
+    } else {
+        // The RC slot is decoded on its own, it survives a telemetry codeword that can't be recovered.
+        if (radio_dev->ppm_recv_mode) {
+            bool rc_good = false;
+            if (rx_len > RFM22B_RC_SLOT_LEN) {
+                set_ecc_parity(RFM22B_RC_PARITY);
+                decode_data((unsigned char *)p, RFM22B_RC_SLOT_LEN);
+                rc_good = (check_syndrome() == 0) || (correct_errors_erasures((unsigned char *)p, RFM22B_RC_SLOT_LEN, 0, 0) != 0);
+                rc_good = rc_good && rfm22_unpackRCSlot(radio_dev, p);
+                p      += RFM22B_RC_SLOT_LEN;
+                rx_len -= RFM22B_RC_SLOT_LEN;
+            } else {
+                rx_len = 0;
             }
+            rfm22b_add_rc_status(radio_dev, rc_good);
         }
 
-        if (good_packet || corrected_packet) {
-            for (uint8_t i = 0; i < RFM22B_PPM_NUM_CHANNELS; ++i) {
-                // Calculate 9-bit value taking the LSB from byte 0
-                uint32_t val = (p[i + 1] << 1) + ((p[0] >> i) & 1);
-                // Is this a valid channel?
-                if (val != RFM22B_PPM_INVALID) {
-                    radio_dev->ppm[i] = (uint16_t)(RFM22B_PPM_MIN_US + (val - RFM22B_PPM_MIN) * RFM22B_PPM_SCALE);
-                } else {
-                    radio_dev->ppm[i] = PIOS_RCVR_INVALID;
-                }
-            }
-
-            p += RFM22B_PPM_NUM_CHANNELS + 1;
-            data_len -= RFM22B_PPM_NUM_CHANNELS + 1;
-
-            // Call the PPM received callback if it's available.
-            if (radio_dev->ppm_callback) {
-                radio_dev->ppm_callback(radio_dev->ppm);
-            }
+        // Attempt to correct any errors in the telemetry codeword.
+        int8_t level = rfm22_decodePacket(radio_dev, p, rx_len, &corrected_packet);
+        if (level < 0) {
+            good_packet = false;
+            corrected_packet = false;
+        } else {
+            good_packet = !corrected_packet;
+            radio_dev->rx_fec_level = level;
+
+            // Strip the link control header.
+            ctrl = p[0];
+            peer_link_quality = p[1];
+            p += RFM22B_LINK_CTRL_BYTES;
+            data_len = rx_len - RFM22B_LINK_CTRL_BYTES - rfm22_fecParity(level);
         }
     }
 
@@ -1987,6 +2090,10 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev *radio_d
             radio_dev->rx_destination_id == rfm22_destinationID(radio_dev)) {
             rfm22_synchronizeClock(radio_dev);
             radio_dev->stats.link_state = OPLINKSTATUS_LINKSTATE_CONNECTED;
+            rfm22_followCoordinator(radio_dev, ctrl);
+        } else if (rfm22_isCoordinator(radio_dev) &&
+                   radio_dev->rx_destination_id == rfm22_destinationID(radio_dev)) {
+            radio_dev->peer_link_quality = peer_link_quality;
         }
 
         radio_dev->last_contact = xTaskGetTickCount();
@@ -2120,6 +2227,10 @@ static void rfm22_calculateLinkQuality(struct pios_rfm22b_dev *rfm22b_dev)
     // Using this equation, error and resent packets are counted as -2, and corrected packets are counted as -1.
     // The range is 0 (all error or resent packets) to 128 (all good packets).
     rfm22b_dev->stats.link_quality = 64 + rfm22b_dev->stats.rx_good - rfm22b_dev->stats.rx_error - rfm22b_dev->stats.rx_failure;
+
+    // The RC slots of the same window.
+    rfm22b_dev->stats.rc_lost = __builtin_popcountll(rfm22b_dev->rc_slot_lost);
+    rfm22b_dev->stats.rc_good = rfm22b_dev->rc_slot_count - rfm22b_dev->stats.rc_lost;
 }
 
 /**
@@ -2137,6 +2248,306 @@ static void rfm22b_add_rx_status(struct pios_rfm22b_dev *rfm22b_dev, enum pios_r
     rfm22b_dev->rx_packet_stats[0] = (rfm22b_dev->rx_packet_stats[0] << 2) | status;
 }
 
+/**
+ * Add the status of a RC slot to the RC slot window, over the last 64 packets
+ * of the coordinator.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] received  Whether the RC slot was received
+ */
+static void rfm22b_add_rc_status(struct pios_rfm22b_dev *rfm22b_dev, bool received)
+{
+    rfm22b_dev->rc_slot_lost = (rfm22b_dev->rc_slot_lost << 1) | (received ? 0 : 1);
+    if (rfm22b_dev->rc_slot_count < 64) {
+        rfm22b_dev->rc_slot_count++;
+    }
+}
+
+
+/*****************************************************************************
+* Link Adaptation Functions
+*
+* The coordinator picks the datarate, the RS parity depth and the packet size
+* from the link quality both modems measure and from the RSSI, and announces
+* them in the link control header that leads every RS encoded packet:
+*
+*   byte 0: FEC level (bits 0-1), short packets (bit 2), datarate (bits 3-6)
+*           and a datarate switch at the end of this hop cycle (bit 7)
+*   byte 1: the link quality the sender measures
+*
+* The peer transmits with the FEC level and packet size of the coordinator,
+* and switches datarate at the same hop cycle boundary. A peer that lost the
+* coordinator scans the datarates, and a coordinator that lost the peer falls
+* back to lower datarates, until they meet again.
+*****************************************************************************/
+
+/**
+ * The number of parity bytes of a FEC level.
+ *
+ * @param[in] level  The FEC level
+ */
+static uint8_t rfm22_fecParity(uint8_t level)
+{
+    return RFM22B_FEC_MIN_PARITY + 2 * level;
+}
+
+/**
+ * The hop cycle the coordinator clock is in.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static uint32_t rfm22_hopCycle(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    portTickType time = rfm22_coordinatorTime(rfm22b_dev, xTaskGetTickCount());
+
+    return time / (rfm22b_dev->packet_time * rfm22b_dev->num_channels);
+}
+
+/**
+ * Set the packet timing, the hop channels and the maximum packet length of a datarate.
+ * The radio registers are left alone.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] datarate  The air datarate
+ */
+static void rfm22_setLinkRate(struct pios_rfm22b_dev *rfm22b_dev, enum rfm22b_datarate datarate)
+{
+    bool ppm_mode = rfm22b_dev->ppm_send_mode || rfm22b_dev->ppm_recv_mode;
+
+    rfm22b_dev->datarate      = datarate;
+    rfm22b_dev->next_datarate = datarate;
+    rfm22b_dev->packet_time   = (ppm_mode ? packet_time_ppm[datarate] : packet_time[datarate]);
+
+    uint8_t num_found = 0;
+    rfm22_gen_channels(rfm22_destinationID(rfm22b_dev), datarate, rfm22b_dev->min_chan, rfm22b_dev->max_chan,
+                       rfm22b_dev->channels, &num_found);
+
+    rfm22b_dev->num_channels = num_found;
+
+    // Calculate the maximum packet length from the datarate.
+    float bytes_per_period = (float)data_rate[datarate] * (float)(rfm22b_dev->packet_time - 2) / 9000;
+
+    rfm22b_dev->max_packet_len = bytes_per_period - TX_PREAMBLE_NIBBLES / 2 - SYNC_BYTES - HEADER_BYTES - LENGTH_BYTES;
+    if (rfm22b_dev->max_packet_len > RFM22B_MAX_PACKET_LEN) {
+        rfm22b_dev->max_packet_len = RFM22B_MAX_PACKET_LEN;
+    }
+}
+
+/**
+ * Switch to the next datarate. The coordinator clock restarts from the start of
+ * the current hop cycle, which both modems agree on, so the peer stays in sync.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static void rfm22_switchDatarate(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    portTickType time  = rfm22_coordinatorTime(rfm22b_dev, xTaskGetTickCount());
+    uint16_t cycle_time = rfm22b_dev->packet_time * rfm22b_dev->num_channels;
+    bool faster = rfm22b_dev->next_datarate > rfm22b_dev->datarate;
+
+    rfm22b_dev->time_epoch += time - (time % cycle_time);
+    rfm22_setLinkRate(rfm22b_dev, rfm22b_dev->next_datarate);
+    pios_rfm22_setDatarate(rfm22b_dev);
+
+    // A faster datarate starts with the strongest code, a slower one with the weakest.
+    rfm22b_dev->fec_level     = faster ? RFM22B_FEC_LEVELS - 1 : 0;
+    rfm22b_dev->short_packets = false;
+    rfm22b_dev->good_periods  = 0;
+    rfm22b_dev->adapt_seq     = rfm22b_dev->stats.tx_seq;
+    rfm22b_dev->channel_index = 0;
+
+    rfm22_process_event(rfm22b_dev, RADIO_EVENT_RX_MODE);
+}
+
+/**
+ * Run the link adaptation, called from the radio task between packets.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static void rfm22_updateLink(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    if (!rfm22b_dev->adaptive || (rfm22b_dev->rfm22b_state != RFM22B_STATE_RX_WAIT)) {
+        return;
+    }
+
+    // A switch takes place at the end of the hop cycle that announced it.
+    if (rfm22b_dev->next_datarate != rfm22b_dev->datarate) {
+        if (rfm22_hopCycle(rfm22b_dev) > rfm22b_dev->switch_cycle) {
+            rfm22_switchDatarate(rfm22b_dev);
+        }
+        return;
+    }
+
+    portTickType now = xTaskGetTickCount();
+    uint32_t since_contact = pios_rfm22_time_difference_ms(rfm22b_dev->last_contact, now);
+    enum rfm22b_datarate min_rate = (rfm22b_dev->ppm_send_mode || rfm22b_dev->ppm_recv_mode) ?
+                                    RFM22_datarate_19200 : RFM22_datarate_9600;
+    min_rate = MIN(min_rate, rfm22b_dev->base_datarate);
+
+    if (!rfm22_isCoordinator(rfm22b_dev)) {
+        // Wait on each datarate for two hop cycles to hear the sync channel.
+        uint32_t dwell = 2 * rfm22b_dev->packet_time * rfm22b_dev->num_channels;
+        if ((since_contact > dwell) && (pios_rfm22_time_difference_ms(rfm22b_dev->rate_step_ticks, now) > dwell)) {
+            rfm22b_dev->rate_step_ticks = now;
+            rfm22b_dev->next_datarate   = (rfm22b_dev->datarate > min_rate) ?
+                                          rfm22b_dev->datarate - 1 : rfm22b_dev->base_datarate;
+            if (rfm22b_dev->next_datarate != rfm22b_dev->datarate) {
+                rfm22_switchDatarate(rfm22b_dev);
+            }
+        }
+        return;
+    }
+
+    if (since_contact > RFM22B_LINK_LOST_TIMEOUT) {
+        if ((pios_rfm22_time_difference_ms(rfm22b_dev->rate_step_ticks, now) > RFM22B_LINK_LOST_TIMEOUT) &&
+            (rfm22b_dev->datarate > min_rate)) {
+            rfm22b_dev->rate_step_ticks = now;
+            rfm22b_dev->next_datarate   = rfm22b_dev->datarate - 1;
+            rfm22_switchDatarate(rfm22b_dev);
+        }
+        return;
+    }
+
+    // Decide once the rx statistics window has been refilled.
+    if ((uint16_t)(rfm22b_dev->stats.tx_seq - rfm22b_dev->adapt_seq) >= RFM22B_ADAPT_PACKETS) {
+        rfm22b_dev->adapt_seq = rfm22b_dev->stats.tx_seq;
+        rfm22_adaptLink(rfm22b_dev);
+        if (rfm22b_dev->next_datarate != rfm22b_dev->datarate) {
+            rfm22b_dev->switch_cycle = rfm22_hopCycle(rfm22b_dev) + 1;
+        }
+    }
+}
+
+/**
+ * Move the coordinator one step along the ladder of link settings. From fast to
+ * robust, each datarate goes through the FEC levels and then short packets,
+ * before the next lower datarate. A RSSI close to the sensitivity skips to the
+ * lower datarate, and a faster datarate needs a good RSSI margin.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static void rfm22_adaptLink(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    rfm22_calculateLinkQuality(rfm22b_dev);
+
+    uint8_t quality   = MIN(rfm22b_dev->stats.link_quality, rfm22b_dev->peer_link_quality);
+    uint8_t corrected = rfm22b_dev->stats.rx_corrected;
+    int8_t rssi = rfm22b_dev->rssi_dBm;
+    uint8_t rate     = rfm22b_dev->datarate;
+    uint8_t min_rate = (rfm22b_dev->ppm_send_mode || rfm22b_dev->ppm_recv_mode) ?
+                       RFM22_datarate_19200 : RFM22_datarate_9600;
+    bool weak_signal = rssi < rssi_min[rate] + RFM22B_ADAPT_RSSI_DOWN_MARGIN;
+
+    min_rate = MIN(min_rate, rfm22b_dev->base_datarate);
+
+    if ((quality < RFM22B_ADAPT_LQ_LOW) || (corrected > RFM22B_ADAPT_CORRECTED_HIGH) || weak_signal) {
+        rfm22b_dev->good_periods = 0;
+        if (weak_signal && (rate > min_rate)) {
+            rfm22b_dev->next_datarate = rate - 1;
+        } else if (rfm22b_dev->fec_level < RFM22B_FEC_LEVELS - 1) {
+            rfm22b_dev->fec_level++;
+        } else if (!rfm22b_dev->short_packets) {
+            rfm22b_dev->short_packets = true;
+        } else if (rate > min_rate) {
+            rfm22b_dev->next_datarate = rate - 1;
+        }
+    } else if ((quality >= RFM22B_ADAPT_LQ_HIGH) && (corrected <= RFM22B_ADAPT_CORRECTED_LOW)) {
+        if (++rfm22b_dev->good_periods < RFM22B_ADAPT_GOOD_PERIODS) {
+            return;
+        }
+        rfm22b_dev->good_periods = 0;
+        if (rfm22b_dev->short_packets) {
+            rfm22b_dev->short_packets = false;
+        } else if (rfm22b_dev->fec_level > 0) {
+            rfm22b_dev->fec_level--;
+        } else if ((rate < rfm22b_dev->base_datarate) && (rssi >= rssi_min[rate + 1] + RFM22B_ADAPT_RSSI_UP_MARGIN)) {
+            rfm22b_dev->next_datarate = rate + 1;
+        }
+    } else {
+        rfm22b_dev->good_periods = 0;
+    }
+}
+
+/**
+ * Build the first byte of the link control header.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static uint8_t rfm22_linkControl(struct pios_rfm22b_dev *rfm22b_dev)
+{
+    uint8_t ctrl = rfm22b_dev->fec_level | (rfm22b_dev->short_packets ? RFM22B_CTRL_SHORT : 0);
+
+    if (rfm22_isCoordinator(rfm22b_dev) && (rfm22b_dev->next_datarate != rfm22b_dev->datarate) &&
+        (rfm22_hopCycle(rfm22b_dev) == rfm22b_dev->switch_cycle)) {
+        return ctrl | (rfm22b_dev->next_datarate << RFM22B_CTRL_RATE_SHIFT) | RFM22B_CTRL_RATE_SWITCH;
+    }
+    return ctrl | (rfm22b_dev->datarate << RFM22B_CTRL_RATE_SHIFT);
+}
+
+/**
+ * Apply the link control header of a packet from our coordinator.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] ctrl  The first byte of the link control header
+ */
+static void rfm22_followCoordinator(struct pios_rfm22b_dev *rfm22b_dev, uint8_t ctrl)
+{
+    if (!rfm22b_dev->adaptive) {
+        return;
+    }
+    uint8_t rate = (ctrl & RFM22B_CTRL_RATE_MASK) >> RFM22B_CTRL_RATE_SHIFT;
+
+    rfm22b_dev->fec_level     = MIN(ctrl & RFM22B_CTRL_FEC_MASK, RFM22B_FEC_LEVELS - 1);
+    rfm22b_dev->short_packets = (ctrl & RFM22B_CTRL_SHORT) != 0;
+    if ((ctrl & RFM22B_CTRL_RATE_SWITCH) && (rate != rfm22b_dev->datarate) && (rate <= RFM22_datarate_256000) &&
+        (rfm22b_dev->next_datarate == rfm22b_dev->datarate)) {
+        rfm22b_dev->next_datarate = rate;
+        rfm22b_dev->switch_cycle  = rfm22_hopCycle(rfm22b_dev);
+    }
+}
+
+/**
+ * Check and correct a received packet. The FEC level of the last packet is tried
+ * first, then the others in case the sender changed it. A packet is accepted only
+ * if its link control header names the level it was decoded with.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] p  The packet
+ * @param[in] rx_len  The packet length, with the parity bytes
+ * @param[out] corrected  Set if errors were corrected
+ * @return The FEC level, or -1 if the packet can't be recovered
+ */
+static int8_t rfm22_decodePacket(struct pios_rfm22b_dev *rfm22b_dev, uint8_t *p, uint8_t rx_len, bool *corrected)
+{
+    uint8_t level = rfm22b_dev->rx_fec_level;
+
+    *corrected = false;
+    for (uint8_t i = 0; i <= RFM22B_FEC_LEVELS; ++i) {
+        if (i > 0) {
+            level = i - 1;
+            if (level == rfm22b_dev->rx_fec_level) {
+                continue;
+            }
+        }
+        uint8_t parity = rfm22_fecParity(level);
+        if (rx_len <= parity + RFM22B_LINK_CTRL_BYTES) {
+            continue;
+        }
+        set_ecc_parity(parity);
+        decode_data((unsigned char *)p, rx_len);
+        bool good = check_syndrome() == 0;
+        if (!good && (correct_errors_erasures((unsigned char *)p, rx_len, 0, 0) != 0)) {
+            // A lower level can correct a packet of a higher level, the next passes check it.
+            *corrected = true;
+            good = true;
+        }
+        if (good && ((p[0] & RFM22B_CTRL_FEC_MASK) == level)) {
+            return level;
+        }
+    }
+    return -1;
+}
+
 
 /*****************************************************************************
 * Connection Handling Functions
@@ -2192,7 +2603,7 @@ static void rfm22_synchronizeClock(struct pios_rfm22b_dev *rfm22b_dev)
     uint8_t offset = (uint8_t)ceil(35000.0F / data_rate[rfm22b_dev->datarate]);
 
     rfm22b_dev->time_delta = frequency_hop_cycle_time - time_delta + offset +
-                             rfm22b_dev->packet_time * rfm22b_dev->channel_index;
+                             rfm22b_dev->packet_time * rfm22b_dev->channel_index + rfm22b_dev->time_epoch;
 }
 
 /**
@@ -2204,9 +2615,9 @@ static void rfm22_synchronizeClock(struct pios_rfm22b_dev *rfm22b_dev)
 static portTickType rfm22_coordinatorTime(struct pios_rfm22b_dev *rfm22b_dev, portTickType ticks)
 {
     if (rfm22_isCoordinator(rfm22b_dev)) {
-        return ticks;
+        return ticks - rfm22b_dev->time_epoch;
     }
-    return ticks + rfm22b_dev->time_delta;
+    return ticks + rfm22b_dev->time_delta - rfm22b_dev->time_epoch;
 }
 
 /**
@@ -42,11 +42,17 @@ static uint16_t PIOS_SBus_RxInCallback(uint32_t context,
                                        uint16_t *headroom,
                                        bool *need_yield);
 static void PIOS_SBus_Supervisor(uint32_t sbus_id);
+#if defined(PIOS_INCLUDE_FREERTOS)
+static xSemaphoreHandle PIOS_SBus_Get_Semaphore(uint32_t rcvr_id, uint8_t channel);
+#endif
 
 
 /* Local Variables */
 const struct pios_rcvr_driver pios_sbus_rcvr_driver = {
     .read = PIOS_SBus_Get,
+#if defined(PIOS_INCLUDE_FREERTOS)
+    .get_semaphore = PIOS_SBus_Get_Semaphore,
+#endif
 };
 
 enum pios_sbus_dev_magic {
@@ -66,6 +72,9 @@ struct pios_sbus_dev {
     enum pios_sbus_dev_magic   magic;
     const struct pios_sbus_cfg *cfg;
     struct pios_sbus_state     state;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreHandle new_frame_semaphore;
+#endif
 };
 
 /* Allocate S.Bus device descriptor */
@@ -142,6 +151,9 @@ int32_t PIOS_SBus_Init(uint32_t *sbus_id,
 
     /* Bind the configuration to the device instance */
     sbus_dev->cfg = cfg;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    sbus_dev->new_frame_semaphore = NULL;
+#endif
 
     PIOS_SBus_ResetState(&(sbus_dev->state));
 
@@ -188,6 +200,31 @@ static int32_t PIOS_SBus_Get(uint32_t rcvr_id, uint8_t channel)
     return sbus_dev->state.channel_data[channel];
 }
 
+#if defined(PIOS_INCLUDE_FREERTOS)
+/**
+ * Get the semaphore given each time a frame has been decoded
+ * \param[in] channel Number of the channel desired (zero based), all share the semaphore
+ * \output NULL channel not available
+ */
+static xSemaphoreHandle PIOS_SBus_Get_Semaphore(uint32_t rcvr_id, uint8_t channel)
+{
+    struct pios_sbus_dev *sbus_dev = (struct pios_sbus_dev *)rcvr_id;
+
+    if (!PIOS_SBus_Validate(sbus_dev)) {
+        return NULL;
+    }
+
+    if (channel >= PIOS_SBUS_NUM_INPUTS) {
+        return NULL;
+    }
+
+    if (sbus_dev->new_frame_semaphore == NULL) {
+        vSemaphoreCreateBinary(sbus_dev->new_frame_semaphore);
+    }
+    return sbus_dev->new_frame_semaphore;
+}
+#endif /* if defined(PIOS_INCLUDE_FREERTOS) */
+
 /**
  * Compute channel_data[] from received_data[].
  * For efficiency it unrolls first 8 channels without loops and does the
@@ -225,12 +262,14 @@ static void PIOS_SBus_UnrollChannels(struct pios_sbus_state *state)
     *d++ = (s[22] & SBUS_FLAG_DC2) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
 }
 
-/* Update decoder state processing input byte from the S.Bus stream */
-static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
+/* Update decoder state processing input byte from the S.Bus stream, true once a frame updated the channels */
+static bool PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 {
+    bool updated = false;
+
     /* should not process any data until new frame is found */
     if (!state->frame_found) {
-        return;
+        return false;
     }
 
     if (state->byte_count == 0) {
@@ -241,7 +280,7 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
             /* do not store the SOF byte */
             state->byte_count++;
         }
-        return;
+        return false;
     }
 
     /* do not store last frame byte as well */
@@ -258,10 +297,12 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
             } else if (flags & SBUS_FLAG_FS) {
                 /* failsafe flag active */
                 PIOS_SBus_ResetChannels(state);
+                updated = true;
             } else {
                 /* data looking good */
                 PIOS_SBus_UnrollChannels(state);
                 state->failsafe_timer = 0;
+                updated = true;
             }
         } else {
             /* discard whole frame */
@@ -270,6 +311,8 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
         /* prepare for the next frame */
         state->frame_found = 0;
     }
+
+    return updated;
 }
 
 /* Comm byte received callback */
@@ -286,10 +329,11 @@ static uint16_t PIOS_SBus_RxInCallback(uint32_t context,
     PIOS_Assert(valid);
 
     struct pios_sbus_state *state = &(sbus_dev->state);
+    uint8_t frames = 0;
 
     /* process byte(s) and clear receive timer */
-    for (uint8_t i = 0; i < buf_len; i++) {
-        PIOS_SBus_UpdateState(state, buf[i]);
+    for (uint16_t i = 0; i < buf_len; i++) {
+        frames += PIOS_SBus_UpdateState(state, buf[i]);
         state->receive_timer = 0;
     }
 
@@ -298,8 +342,20 @@ static uint16_t PIOS_SBus_RxInCallback(uint32_t context,
         *headroom = SBUS_FRAME_LENGTH;
     }
 
-    /* We never need a yield */
-    *need_yield = false;
+    if (frames) {
+        PIOS_LATENCYPROBE_FRAME();
+    }
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+    /* Wake the reader of the channels once per decoded frame */
+    if (frames && sbus_dev->new_frame_semaphore) {
+        signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+        xSemaphoreGiveFromISR(sbus_dev->new_frame_semaphore, &xHigherPriorityTaskWoken);
+        if (xHigherPriorityTaskWoken == pdTRUE) {
+            *need_yield = true;
+        }
+    }
+#endif /* if defined(PIOS_INCLUDE_FREERTOS) */
 
     /* Always indicate that all bytes were consumed */
     return buf_len;
@@ -80,6 +80,16 @@ uint8_t PIOS_SDCARD_Sector[SECTOR_SIZE];
 #define SDCMD_WRITE_SINGLE_BLOCK     (0x40 + 24)
 #define SDCMD_WRITE_SINGLE_BLOCK_CRC 0xff
 
+#define SDCMD_WRITE_MULTIPLE_BLOCK     (0x40 + 25)
+#define SDCMD_WRITE_MULTIPLE_BLOCK_CRC 0xff
+
+#define SDCMD_SET_WR_BLK_ERASE_COUNT   (0xC0 + 23)
+#define SDCMD_SET_WR_BLK_ERASE_COUNT_CRC 0xff
+
+/* Data tokens of a multiple block write */
+#define SDTOKEN_MULTIPLE_BLOCK         0xfc
+#define SDTOKEN_STOP_TRAN              0xfd
+
 /* Card type flags (CardType) */
 #define CT_MMC                       0x01
 #define CT_SD1                       0x02
@@ -553,6 +563,99 @@ error:
     return status;
 }
 
+/**
+ * Writes consecutive sectors with a single multiple block write command.
+ * The card programs the blocks while the next ones are sent, which is much
+ * faster than a write per sector on most cards.
+ * \param[in] sector 32bit first sector
+ * \param[in] *buffer pointer to count * 512 bytes
+ * \param[in] count number of sectors
+ * \return 0 if all sectors have been successfully written
+ * \return -error flags like PIOS_SDCARD_SectorWrite
+ * \return -256 if timeout during command has been sent
+ * \return -257 if write operation not accepted
+ * \return -258 if timeout during write operation
+ */
+int32_t PIOS_SDCARD_SectorWriteMulti(uint32_t sector, const uint8_t *buffer, uint32_t count)
+{
+    int32_t status;
+    int i;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    SDCARD_MUTEX_TAKE;
+
+    if (!(CardType & CT_BLOCK)) {
+        sector *= 512;
+    }
+
+    PIOS_SPI_SetClockSpeed(PIOS_SDCARD_SPI, PIOS_SPI_PRESCALER_4);
+
+    /* Let SD cards pre-erase the blocks, ignore the result as it is only a hint */
+    if (CardType & CT_SDC) {
+        PIOS_SDCARD_SendSDCCmd(SDCMD_SET_WR_BLK_ERASE_COUNT, count, SDCMD_SET_WR_BLK_ERASE_COUNT_CRC);
+        PIOS_SPI_RC_PinSet(PIOS_SDCARD_SPI, 0, 1); /* spi, pin_value */
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+    }
+
+    if ((status = PIOS_SDCARD_SendSDCCmd(SDCMD_WRITE_MULTIPLE_BLOCK, sector, SDCMD_WRITE_MULTIPLE_BLOCK_CRC))) {
+        status = (status < 0) ? -256 : status; /* Return timeout indicator or error flags */
+        goto error;
+    }
+
+    for (uint32_t block = 0; block < count; ++block) {
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, SDTOKEN_MULTIPLE_BLOCK);
+
+        /* Send 512 bytes of data via DMA */
+        PIOS_SPI_TransferBlock(PIOS_SDCARD_SPI, &buffer[block * 512], NULL, 512, NULL);
+
+        /* Send CRC */
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+        PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+
+        uint8_t response = PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+        if ((response & 0x0f) != 0x5) {
+            status = -257;
+            break;
+        }
+
+        /* Wait until the block is programmed */
+        for (i = 0; i < 32 * 65536; ++i) {
+            if (PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff) != 0x00) {
+                break;
+            }
+        }
+        if (i == 32 * 65536) {
+            status = -258;
+            break;
+        }
+    }
+
+    /* The transmission is stopped on errors too, the card stays in the data state otherwise */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, SDTOKEN_STOP_TRAN);
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+    for (i = 0; i < 32 * 65536; ++i) {
+        if (PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff) != 0x00) {
+            break;
+        }
+    }
+    if (i == 32 * 65536 && status == 0) {
+        status = -258;
+    }
+
+error:
+    /* Deactivate chip select */
+    PIOS_SPI_RC_PinSet(PIOS_SDCARD_SPI, 0, 1); /* spi, pin_value */
+    /* Send dummy byte once deactivated to drop cards DO */
+    PIOS_SPI_TransferByte(PIOS_SDCARD_SPI, 0xff);
+
+    SDCARD_MUTEX_GIVE;
+
+    return status;
+}
+
 /**
  * Reads the CID informations from SD Card
  * \param[in] *cid pointer to buffer which holds the CID informations
@@ -0,0 +1,311 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_SDLOG SD card streaming log
+ * @brief Writes UAVObject updates to an SD card in the GCS .opl format
+ * @{
+ *
+ * @file       pios_sdlog.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      SD card streaming log
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SDLOG) && !defined(USE_SIM_POSIX)
+
+/*
+ * The log file gets contiguous clusters when it is opened, so the records are
+ * written straight to consecutive sectors with multiple block writes, the FAT
+ * is only touched again when the file is closed.
+ * The producers copy into one of two RAM buffers while the other is written.
+ */
+#ifndef PIOS_SDLOG_BUFFER_SECTORS
+#define PIOS_SDLOG_BUFFER_SECTORS 8
+#endif
+#ifndef PIOS_SDLOG_PREALLOCATE
+#define PIOS_SDLOG_PREALLOCATE    (64 * 1024 * 1024)
+#endif
+#define MIN_PREALLOCATE           (1024 * 1024)
+#define BUFFER_SIZE               (PIOS_SDLOG_BUFFER_SECTORS * SECTOR_SIZE)
+// the file length is written every that many buffers, a log cut by a power loss is readable up to there
+#define SYNC_BUFFERS              16
+#define MAX_LOG_NUMBER            99999
+
+// every record is the .opl header, a 32 bit ms timestamp and a 64 bit size, followed by an UAVTalk object packet
+#define RECORD_HEADER_SIZE        (sizeof(uint32_t) + sizeof(int64_t))
+#define UAVTALK_HEADER_SIZE       10
+#define UAVTALK_SYNC_VAL          0x3C
+#define UAVTALK_TYPE_OBJ          0x20
+#define UAVTALK_MAX_DATA          256
+
+static xSemaphoreHandle mutex = 0;
+#define mutexlock()   xSemaphoreTakeRecursive(mutex, portMAX_DELAY)
+#define mutexunlock() xSemaphoreGiveRecursive(mutex)
+
+static uint8_t *buffer[2];
+// fill and active are only written by the producers, full is cleared by the writer
+static uint16_t fill;
+static uint8_t active;
+static volatile bool full[2];
+
+static FILEINFO file;
+static bool log_open;
+// cleared when the card fails or the file is full, the log is cut there
+static bool log_writing;
+static uint32_t sectors_written;
+static uint32_t max_sectors;
+static uint32_t start_time;
+static uint32_t dropped;
+static uint16_t lognum;
+static uint8_t scratch[SECTOR_SIZE];
+
+static uint32_t buffer_space(void);
+static void buffer_append(const uint8_t *data, uint16_t len);
+static bool write_sectors(const uint8_t *data, uint32_t count);
+static bool flush_full(void);
+
+int32_t PIOS_SDLOG_Init(void)
+{
+    if (!mutex) {
+        mutex     = xSemaphoreCreateRecursiveMutex();
+        buffer[0] = pios_malloc(BUFFER_SIZE);
+        buffer[1] = pios_malloc(BUFFER_SIZE);
+    }
+    if (!mutex || !buffer[0] || !buffer[1]) {
+        return -1;
+    }
+    return 0;
+}
+
+int32_t PIOS_SDLOG_Open(void)
+{
+    char filename[13];
+
+    if (!mutex || !PIOS_SDCARD_IsMounted()) {
+        return -1;
+    }
+    if (log_open) {
+        return 0;
+    }
+
+    // the numbers of earlier logs of this boot are not probed again
+    for (lognum++; lognum <= MAX_LOG_NUMBER; lognum++) {
+        sprintf(filename, "LOG%05u.OPL", lognum);
+        if (DFS_OpenFile(&PIOS_SDCARD_VolInfo, (uint8_t *)filename, DFS_READ, scratch, &file) == DFS_NOTFOUND) {
+            break;
+        }
+    }
+    if (lognum > MAX_LOG_NUMBER ||
+        DFS_OpenFile(&PIOS_SDCARD_VolInfo, (uint8_t *)filename, DFS_WRITE, scratch, &file) != DFS_OK) {
+        return -2;
+    }
+
+    // take less when the card is fragmented
+    uint32_t size = PIOS_SDLOG_PREALLOCATE;
+    while (DFS_Preallocate(&file, scratch, size) != DFS_OK) {
+        size /= 2;
+        if (size < MIN_PREALLOCATE) {
+            DFS_UnlinkFile(&PIOS_SDCARD_VolInfo, (uint8_t *)filename, scratch);
+            return -3;
+        }
+    }
+
+    mutexlock();
+    fill   = 0;
+    active = 0;
+    full[0]         = false;
+    full[1]         = false;
+    sectors_written = 0;
+    max_sectors     = size / SECTOR_SIZE;
+    dropped    = 0;
+    start_time = xTaskGetTickCount() * portTICK_RATE_MS;
+    log_open    = true;
+    log_writing = true;
+    mutexunlock();
+
+    return 0;
+}
+
+void PIOS_SDLOG_Close(void)
+{
+    if (!log_open) {
+        return;
+    }
+
+    // the producers are stopped under the lock, so nothing moves between the full buffers and the partial one
+    mutexlock();
+    bool writing = log_writing;
+    log_writing = false;
+    if (writing) {
+        writing = flush_full();
+    }
+
+    // the rest of the last sector is padded, the file length cuts it off again
+    uint32_t length = sectors_written * SECTOR_SIZE;
+    if (writing && fill) {
+        uint16_t count = (fill + SECTOR_SIZE - 1) / SECTOR_SIZE;
+        memset(&buffer[active][fill], 0, count * SECTOR_SIZE - fill);
+        if (write_sectors(buffer[active], count)) {
+            length += fill;
+        }
+    }
+    DFS_Truncate(&file, scratch, length);
+    log_open = false;
+    mutexunlock();
+}
+
+bool PIOS_SDLOG_IsOpen(void)
+{
+    return log_open;
+}
+
+void PIOS_SDLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, const uint8_t *data)
+{
+    if (!log_writing || size > UAVTALK_MAX_DATA) {
+        return;
+    }
+
+    uint16_t packet_size = UAVTALK_HEADER_SIZE + size + 1;
+    uint8_t header[RECORD_HEADER_SIZE + UAVTALK_HEADER_SIZE];
+    uint32_t timestamp   = xTaskGetTickCount() * portTICK_RATE_MS - start_time;
+    int64_t record_size  = packet_size;
+    uint16_t length = packet_size - 1;
+
+    memcpy(&header[0], &timestamp, sizeof(timestamp));
+    memcpy(&header[sizeof(timestamp)], &record_size, sizeof(record_size));
+    uint8_t *packet = &header[RECORD_HEADER_SIZE];
+    packet[0] = UAVTALK_SYNC_VAL;
+    packet[1] = UAVTALK_TYPE_OBJ;
+    memcpy(&packet[2], &length, sizeof(length));
+    memcpy(&packet[4], &objid, sizeof(objid));
+    memcpy(&packet[8], &instid, sizeof(instid));
+    uint8_t crc = PIOS_CRC_updateCRC(0, packet, UAVTALK_HEADER_SIZE);
+    crc = PIOS_CRC_updateCRC(crc, data, size);
+
+    mutexlock();
+    if (log_writing && buffer_space() >= RECORD_HEADER_SIZE + packet_size) {
+        buffer_append(header, sizeof(header));
+        buffer_append(data, size);
+        buffer_append(&crc, sizeof(crc));
+    } else {
+        dropped++;
+    }
+    mutexunlock();
+}
+
+void PIOS_SDLOG_Flush(void)
+{
+    if (!log_open) {
+        return;
+    }
+
+    if (!flush_full()) {
+        mutexlock();
+        log_writing = false;
+        mutexunlock();
+    }
+}
+
+uint32_t PIOS_SDLOG_Dropped(void)
+{
+    return dropped;
+}
+
+/**
+ * Bytes the producers can append, called with the lock held
+ */
+static uint32_t buffer_space(void)
+{
+    if (full[active]) {
+        return 0;
+    }
+    return BUFFER_SIZE - fill + (full[active ^ 1] ? 0 : BUFFER_SIZE);
+}
+
+/**
+ * Append to the buffers, the space has been checked. Called with the lock held
+ */
+static void buffer_append(const uint8_t *data, uint16_t len)
+{
+    while (len) {
+        uint16_t chunk = MIN(len, BUFFER_SIZE - fill);
+        memcpy(&buffer[active][fill], data, chunk);
+        fill += chunk;
+        data += chunk;
+        len  -= chunk;
+        if (fill == BUFFER_SIZE) {
+            full[active] = true;
+            active ^= 1;
+            fill    = 0;
+        }
+    }
+}
+
+/**
+ * Write the full buffers, the older one first. The producers do not touch a full
+ * buffer, so it is written without the lock. Returns false when the card failed
+ * or the file is full, the buffers are released anyway.
+ */
+static bool flush_full(void)
+{
+    bool ok = true;
+
+    for (uint8_t n = 0; n < 2; n++) {
+        // when both are full the active buffer is the older one
+        mutexlock();
+        uint8_t next = full[active] ? active : active ^ 1;
+        mutexunlock();
+        if (!full[next]) {
+            break;
+        }
+
+        if (ok && !write_sectors(buffer[next], PIOS_SDLOG_BUFFER_SECTORS)) {
+            ok = false;
+        } else if (ok && sectors_written % (SYNC_BUFFERS * PIOS_SDLOG_BUFFER_SECTORS) == 0) {
+            DFS_SetFileLength(&file, scratch, sectors_written * SECTOR_SIZE);
+        }
+        full[next] = false;
+    }
+    return ok;
+}
+
+/**
+ * Write sectors after the last ones written
+ */
+static bool write_sectors(const uint8_t *data, uint32_t count)
+{
+    if (sectors_written + count > max_sectors) {
+        return false;
+    }
+    if (PIOS_SDCARD_SectorWriteMulti(DFS_FileSector(&file, sectors_written), data, count) != 0) {
+        return false;
+    }
+    sectors_written += count;
+    return true;
+}
+
+#endif /* PIOS_INCLUDE_SDLOG && !USE_SIM_POSIX */
+
+/**
+ * @}
+ * @}
+ */
@@ -31,6 +31,7 @@
 // private variables
 
 static PIOS_SENSORS_Instance *sensor_list = 0;
+static PIOS_SENSORS_data_ready_function data_ready_handler;
 
 PIOS_SENSORS_Instance *PIOS_SENSORS_Register(const PIOS_SENSORS_Driver *driver, PIOS_SENSORS_TYPE type, uintptr_t context)
 {
@@ -40,10 +41,32 @@ PIOS_SENSORS_Instance *PIOS_SENSORS_Register(const PIOS_SENSORS_Driver *driver,
     instance->type    = type;
     instance->context = context;
     instance->next    = NULL;
+    instance->poll_period_ms = 0;
     LL_APPEND(sensor_list, instance);
     return instance;
 }
 
+void PIOS_SENSORS_SetPollPeriod(PIOS_SENSORS_Instance *sensor, uint16_t period_ms)
+{
+    PIOS_Assert(sensor);
+    sensor->poll_period_ms = period_ms;
+}
+
+void PIOS_SENSORS_SetDataReadyHandler(PIOS_SENSORS_data_ready_function handler)
+{
+    data_ready_handler = handler;
+}
+
+bool PIOS_SENSORS_DataReadyFromISR(const PIOS_SENSORS_Instance *sensor)
+{
+    PIOS_SENSORS_data_ready_function handler = data_ready_handler;
+
+    if (!sensor || !handler) {
+        return false;
+    }
+    return handler(sensor);
+}
+
 PIOS_SENSORS_Instance *PIOS_SENSORS_GetList()
 {
     return sensor_list;
@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_spscqueue.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      PiOS lock free single producer single consumer queue
+ *             Copies fixed size items between one producer and one consumer
+ *             without critical sections, neither side ever blocks
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <pios.h>
+
+/*
+ * head is only written by the producer and tail only by the consumer, both count
+ * items since creation and wrap around. The release store of an index publishes
+ * the item copy before it, the acquire load on the other side orders the access.
+ */
+struct pios_spscqueue {
+    uint32_t head; // items sent
+    uint32_t tail; // items received
+    uint16_t mask; // length - 1
+    uint16_t itemSize;
+    uint8_t  items[];
+};
+
+pios_spscqueue_t PIOS_SPSCQUEUE_Create(uint16_t length, uint16_t itemSize)
+{
+    if (length == 0 || length > 0x8000 || itemSize == 0) {
+        return NULL;
+    }
+
+    uint32_t size = 1;
+    while (size < length) {
+        size <<= 1;
+    }
+
+    struct pios_spscqueue *queue = (struct pios_spscqueue *)pios_malloc(sizeof(struct pios_spscqueue) + size * itemSize);
+    if (!queue) {
+        return NULL;
+    }
+    queue->head     = 0;
+    queue->tail     = 0;
+    queue->mask     = size - 1;
+    queue->itemSize = itemSize;
+
+    return queue;
+}
+
+bool PIOS_SPSCQUEUE_Send(pios_spscqueue_t queue, const void *item)
+{
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail > queue->mask) {
+        return false;
+    }
+    memcpy(&queue->items[(head & queue->mask) * queue->itemSize], item, queue->itemSize);
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool PIOS_SPSCQUEUE_Receive(pios_spscqueue_t queue, void *item)
+{
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) {
+        return false;
+    }
+    memcpy(item, &queue->items[(tail & queue->mask) * queue->itemSize], queue->itemSize);
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+uint16_t PIOS_SPSCQUEUE_Count(pios_spscqueue_t queue)
+{
+    uint32_t tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+    uint32_t head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+
+    return (uint16_t)(head - tail);
+}
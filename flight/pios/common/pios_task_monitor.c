@@ -32,7 +32,7 @@
 // Private variables
 static xSemaphoreHandle mLock;
 static xTaskHandle *mTaskHandles;
-static uint32_t mLastMonitorTime;
+static uint32_t *mLastMonitorTimes;
 static uint32_t mLastIdleMonitorTime;
 static uint16_t mMaxTasks;
 
@@ -52,12 +52,21 @@ int32_t PIOS_TASK_MONITOR_Initialize(uint16_t max_tasks)
     }
     memset(mTaskHandles, 0, max_tasks * sizeof(xTaskHandle));
 
+    // each task keeps its own sampling time so tasks can be sampled one at a time
+    mLastMonitorTimes = (uint32_t *)pios_malloc(max_tasks * sizeof(uint32_t));
+    if (!mLastMonitorTimes) {
+        return -1;
+    }
+
     mMaxTasks = max_tasks;
 #if (configGENERATE_RUN_TIME_STATS == 1)
-    mLastMonitorTime     = portGET_RUN_TIME_COUNTER_VALUE();
-    mLastIdleMonitorTime = portGET_RUN_TIME_COUNTER_VALUE();
+    uint32_t currentTime = portGET_RUN_TIME_COUNTER_VALUE();
+    for (uint16_t n = 0; n < max_tasks; ++n) {
+        mLastMonitorTimes[n] = currentTime;
+    }
+    mLastIdleMonitorTime = currentTime;
 #else
-    mLastMonitorTime     = 0;
+    memset(mLastMonitorTimes, 0, max_tasks * sizeof(uint32_t));
     mLastIdleMonitorTime = 0;
 #endif
     return 0;
@@ -101,6 +110,67 @@ bool PIOS_TASK_MONITOR_IsRunning(uint16_t task_id)
     return mTaskHandles && task_id <= mMaxTasks && mTaskHandles[task_id];
 }
 
+/**
+ * Look up the id of a registered task
+ */
+uint16_t PIOS_TASK_MONITOR_GetTaskId(xTaskHandle handle)
+{
+    if (mTaskHandles && handle) {
+        for (uint16_t n = 0; n < mMaxTasks; ++n) {
+            if (mTaskHandles[n] == handle) {
+                return n;
+            }
+        }
+    }
+    return 0xFFFF;
+}
+
+/**
+ * Sample one task, the lock must be held
+ */
+static void getTaskInfo(uint16_t task_id, struct pios_task_info *info)
+{
+    if (mTaskHandles[task_id]) {
+        info->is_running = true;
+#if defined(ARCH_POSIX) || defined(ARCH_WIN32)
+        info->stack_remaining = 10000;
+#else
+        info->stack_remaining = uxTaskGetStackHighWaterMark(mTaskHandles[task_id]) * 4;
+#endif
+#if (configGENERATE_RUN_TIME_STATS == 1)
+        /* Calculate the amount of elapsed run time since this task was last
+         * measured. Scale so that the task run time converts directly to a
+         * percentage, avoiding divide-by-zero if the interval is too small */
+        uint32_t currentTime = portGET_RUN_TIME_COUNTER_VALUE();
+        uint32_t deltaTime   = ((currentTime - mLastMonitorTimes[task_id]) / 100) ? : 1;
+        mLastMonitorTimes[task_id]    = currentTime;
+        info->running_time_percentage = uxTaskGetRunTime(mTaskHandles[task_id]) / deltaTime;
+#else
+        info->running_time_percentage = 0;
+#endif
+    } else {
+        info->is_running = false;
+        info->stack_remaining = 0;
+        info->running_time_percentage = 0;
+    }
+}
+
+/**
+ * Get the status of a single task
+ */
+int32_t PIOS_TASK_MONITOR_GetTaskInfo(uint16_t task_id, struct pios_task_info *info)
+{
+    if (!mTaskHandles || task_id >= mMaxTasks) {
+        return -1;
+    }
+
+    xSemaphoreTakeRecursive(mLock, portMAX_DELAY);
+    getTaskInfo(task_id, info);
+    xSemaphoreGiveRecursive(mLock);
+
+    return 0;
+}
+
 /**
  * Tell the caller the status of all tasks via a task-by-task callback
  */
@@ -112,36 +182,10 @@ void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback, void *c
 
     xSemaphoreTakeRecursive(mLock, portMAX_DELAY);
 
-#if (configGENERATE_RUN_TIME_STATS == 1)
-    /* Calculate the amount of elapsed run time between the last time we
-     * measured and now. Scale so that we can convert task run times
-     * directly to percentages. */
-    uint32_t currentTime = portGET_RUN_TIME_COUNTER_VALUE();
-    /* avoid divide-by-zero if the interval is too small */
-    uint32_t deltaTime   = ((currentTime - mLastMonitorTime) / 100) ? : 1;
-    mLastMonitorTime = currentTime;
-#endif
     /* Update all task information */
     for (uint16_t n = 0; n < mMaxTasks; ++n) {
         struct pios_task_info info;
-        if (mTaskHandles[n]) {
-            info.is_running = true;
-#if defined(ARCH_POSIX) || defined(ARCH_WIN32)
-            info.stack_remaining = 10000;
-#else
-            info.stack_remaining = uxTaskGetStackHighWaterMark(mTaskHandles[n]) * 4;
-#endif
-#if (configGENERATE_RUN_TIME_STATS == 1)
-            /* Generate run time percentage stats */
-            info.running_time_percentage = uxTaskGetRunTime(mTaskHandles[n]) / deltaTime;
-#else
-            info.running_time_percentage = 0;
-#endif
-        } else {
-            info.is_running = false;
-            info.stack_remaining = 0;
-            info.running_time_percentage = 0;
-        }
+        getTaskInfo(n, &info);
         /* Pass the information for this task back to the caller */
         callback(n, &info, context);
     }
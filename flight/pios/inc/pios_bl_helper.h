@@ -36,6 +36,9 @@ extern uint8_t PIOS_BL_HELPER_FLASH_Ini();
 extern uint32_t PIOS_BL_HELPER_CRC_Memory_Calc();
 extern void PIOS_BL_HELPER_FLASH_Read_Description(uint8_t *array, uint8_t size);
 extern uint8_t PIOS_BL_HELPER_FLASH_Start();
+extern bool PIOS_BL_HELPER_FLASH_GetSector(uint32_t address, uint32_t *sector_start, uint32_t *sector_size);
+extern uint8_t PIOS_BL_HELPER_FLASH_EraseSector(uint32_t address);
+extern uint32_t PIOS_BL_HELPER_CRC_Sector_Calc(uint32_t address, uint32_t size);
 extern uint8_t PIOS_BL_HELPER_FLASH_Erase_Bootloader();
 extern void PIOS_BL_HELPER_CRC_Ini();
 
@@ -186,6 +186,13 @@ int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo);
  */
 int32_t PIOS_CALLBACKSCHEDULER_DispatchFromISR(DelayedCallbackInfo *cbinfo, long *pxHigherPriorityTaskWoken);
 
+/**
+ * Number of bins of the run time and latency histograms. Bin 0 counts runs
+ * shorter than 16us, every further bin is 4 times wider, the last one counts
+ * anything longer.
+ */
+#define PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS 6
+
 /**
  * Information about a running callback that has been registered
  * via a call to PIOS_CALLBACKSCHEDULER_Create().
@@ -197,6 +204,10 @@ struct pios_callback_info {
     bool     is_running;
     /** Count of executions of the callback since system start */
     uint32_t running_time_count;
+    /** Histogram of the callback execution times */
+    uint32_t run_time_histogram[PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS];
+    /** Histogram of the times from dispatch to start of execution */
+    uint32_t latency_histogram[PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS];
 };
 
 /**
@@ -216,4 +227,15 @@ typedef void (*CallbackSchedulerCallbackInfoCallback)(int16_t task_id, const str
  */
 void PIOS_CALLBACKSCHEDULER_ForEachCallback(CallbackSchedulerCallbackInfoCallback callback, void *context);
 
+/**
+ * Retrieves the information of the callback at a position of the iteration order,
+ * for callers which spread the collection over time.
+ *
+ * @param[in]  index        Position of the callback, 0 for the first one
+ * @param[out] callback_id  The id of the callback
+ * @param[out] info         Information about the callback
+ * @return true on success, false if there are fewer callbacks than index + 1
+ */
+bool PIOS_CALLBACKSCHEDULER_GetCallbackInfo(uint16_t index, int16_t *callback_id, struct pios_callback_info *info);
+
 #endif // PIOS_CALLBACKSCHEDULER_H
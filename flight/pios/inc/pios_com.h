@@ -35,6 +35,8 @@
 #include <stdbool.h> /* bool */
 
 typedef uint16_t (*pios_com_callback)(uint32_t context, uint8_t *buf, uint16_t buf_len, uint16_t *headroom, bool *task_woken);
+/* Zero copy tx: releases the bytes sent from the previous region and returns the next contiguous region to send */
+typedef uint16_t (*pios_com_region_callback)(uint32_t context, uint16_t bytes_sent, uint8_t **region, bool *task_woken);
 
 struct pios_com_driver {
     void (*init)(uint32_t id);
@@ -43,6 +45,7 @@ struct pios_com_driver {
     void (*rx_start)(uint32_t id, uint16_t rx_bytes_avail);
     void (*bind_rx_cb)(uint32_t id, pios_com_callback rx_in_cb, uint32_t context);
     void (*bind_tx_cb)(uint32_t id, pios_com_callback tx_out_cb, uint32_t context);
+    void (*bind_tx_region_cb)(uint32_t id, pios_com_region_callback tx_region_cb, uint32_t context);
     bool (*available)(uint32_t id);
 };
 
@@ -57,6 +60,8 @@ extern int32_t PIOS_COM_SendString(uint32_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uint32_t com_id, const char *format, ...);
 extern int32_t PIOS_COM_SendFormattedString(uint32_t com_id, const char *format, ...);
 extern uint16_t PIOS_COM_ReceiveBuffer(uint32_t com_id, uint8_t *buf, uint16_t buf_len, uint32_t timeout_ms);
+extern uint16_t PIOS_COM_ReceiveRegion(uint32_t com_id, uint8_t **region, uint32_t timeout_ms);
+extern void PIOS_COM_ReleaseRegion(uint32_t com_id, uint16_t len);
 extern bool PIOS_COM_Available(uint32_t com_id);
 
 #endif /* PIOS_COM_H */
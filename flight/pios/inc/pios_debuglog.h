@@ -61,6 +61,12 @@ void PIOS_DEBUGLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, uint8
  */
 void PIOS_DEBUGLOG_Printf(char *format, ...);
 
+/**
+ * @brief Write the queued log entries to flash
+ * Called periodically from a low priority task, this is the only consumer of the queue.
+ */
+void PIOS_DEBUGLOG_Flush(void);
+
 /**
  * @brief Load one object instance from the filesystem
  * @param[out] buffer where to store the uavobject
@@ -84,6 +90,11 @@ int32_t PIOS_DEBUGLOG_Read(void *buffer, uint16_t flight, uint16_t inst);
  */
 void PIOS_DEBUGLOG_Info(uint16_t *flight, uint16_t *entry, uint16_t *free, uint16_t *used);
 
+/**
+ * @brief Number of log entries dropped because the queue was full
+ */
+uint32_t PIOS_DEBUGLOG_Dropped(void);
+
 /**
  * @brief Format entire flash memory!!!
  */
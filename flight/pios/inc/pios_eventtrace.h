@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_eventtrace.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @brief      PiOS event trace buffer
+ *             Records time stamped task switches, callback runs, ISRs and
+ *             instrumented sections into a RAM buffer to be read out later
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PIOS_EVENTTRACE_H
+#define PIOS_EVENTTRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/**
+ * Event types, the meaning of the event id depends on the type
+ */
+enum pios_eventtrace_event_type {
+    PIOS_EVENTTRACE_TASK_SWITCH    = 0, /* id is the TaskInfo task id, 0xFFFF for tasks not monitored */
+    PIOS_EVENTTRACE_CALLBACK_START = 1, /* id is the CallbackInfo callback id */
+    PIOS_EVENTTRACE_CALLBACK_END   = 2,
+    PIOS_EVENTTRACE_ISR_ENTER      = 3, /* id is a enum pios_eventtrace_isr */
+    PIOS_EVENTTRACE_ISR_EXIT       = 4,
+    PIOS_EVENTTRACE_SECTION_START  = 5, /* id is the PerfCounter instance of the timed section */
+    PIOS_EVENTTRACE_SECTION_END    = 6,
+};
+
+enum pios_eventtrace_isr {
+    PIOS_EVENTTRACE_ISR_MPU6000 = 0,
+    PIOS_EVENTTRACE_ISR_USART   = 1,
+};
+
+struct pios_eventtrace_event {
+    uint32_t timestamp; /* PIOS_DELAY_GetRaw() ticks */
+    uint16_t id;
+    uint8_t  type;
+    uint8_t  reserved;
+};
+
+#ifdef PIOS_INCLUDE_EVENTTRACE
+
+/**
+ * Initialize the trace buffer, tracing is stopped
+ */
+extern void PIOS_EVENTTRACE_Init(void);
+
+/**
+ * Start a new trace, previous events are discarded
+ * @param continuous false to stop once the buffer is full, true to keep overwriting the oldest events until stopped
+ */
+extern void PIOS_EVENTTRACE_Start(bool continuous);
+
+/**
+ * Stop tracing, the recorded events stay available
+ */
+extern void PIOS_EVENTTRACE_Stop(void);
+
+/**
+ * @return true while events are recorded
+ */
+extern bool PIOS_EVENTTRACE_IsRunning(void);
+
+/**
+ * @return number of events available to PIOS_EVENTTRACE_GetEvent()
+ */
+extern uint16_t PIOS_EVENTTRACE_GetCount(void);
+
+/**
+ * Read a recorded event, oldest first. Only consistent while tracing is stopped.
+ * @param index event index, 0 to PIOS_EVENTTRACE_GetCount() - 1
+ * @param event filled with the event
+ * @return 0 on success, -1 if index is out of range
+ */
+extern int32_t PIOS_EVENTTRACE_GetEvent(uint16_t index, struct pios_eventtrace_event *event);
+
+/**
+ * @return time stamp ticks per millisecond
+ */
+extern uint32_t PIOS_EVENTTRACE_GetTicksPerMs(void);
+
+/**
+ * Record an event, can be called from tasks and ISRs
+ */
+extern void PIOS_EVENTTRACE_Event(uint8_t type, uint16_t id);
+
+/**
+ * FreeRTOS traceTASK_SWITCHED_IN() hook
+ */
+extern void PIOS_EVENTTRACE_TaskSwitchedIn(void *task);
+
+#define PIOS_EVENTTRACE(type, id) PIOS_EVENTTRACE_Event((type), (uint16_t)(id))
+
+#else
+
+#define PIOS_EVENTTRACE(type, id)
+
+#endif /* PIOS_INCLUDE_EVENTTRACE */
+
+#endif /* PIOS_EVENTTRACE_H */
@@ -34,6 +34,7 @@
 #include <pios.h>
 
 #include "gcsreceiver.h"
+#include "gcsreceiverstatus.h"
 
 extern const struct pios_rcvr_driver pios_gcsrcvr_rcvr_driver;
 
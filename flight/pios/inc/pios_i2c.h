@@ -63,12 +63,22 @@ struct pios_i2c_fault_history {
     uint8_t  state[I2C_LOG_DEPTH];
 };
 
+/*
+ * Completion of PIOS_I2C_Transfer_Async(), status 0 on success, -1 on a bus
+ * error, -2 on a timeout or -3 on a NACK. Called from the I2C or DMA interrupt,
+ * or on a timeout from the task starting the next transfer. The bus is still
+ * held, so the callback must not start a transfer itself.
+ */
+typedef void (*pios_i2c_callback)(int32_t status, void *context, bool *woken);
+
 /* Public Functions */
 extern int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns);
 extern int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, void *callback);
+extern int32_t PIOS_I2C_Transfer_Async(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, pios_i2c_callback callback, void *context);
 extern void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_IRQ_Handler(uint32_t i2c_id);
+extern void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_GetDiagnostics(struct pios_i2c_fault_history *data, uint8_t *error_counts);
 
 #endif /* PIOS_I2C_H */
@@ -40,6 +40,14 @@ struct pios_i2c_adapter_cfg {
     struct stm32_gpio sda;
     struct stm32_irq  event;
     struct stm32_irq  error;
+#ifdef PIOS_I2C_ASYNC
+    /*
+     * Optional, reads of two bytes or more go through the rx stream, its
+     * init must point the peripheral address at the DR of regs. NULL
+     * keeps every byte in the event interrupt. tx is not used.
+     */
+    const struct stm32_dma *dma;
+#endif
 };
 
 enum pios_i2c_adapter_magic {
@@ -69,6 +77,11 @@ struct pios_i2c_adapter {
     const struct pios_i2c_txn *last_txn;
 
     void    (*callback)();
+#ifdef PIOS_I2C_ASYNC
+    bool     async; // the transfer ends in i2c_adapter_async_done(), not in the caller
+    pios_i2c_callback async_callback; // cleared by whoever ends the transfer
+    void     *async_context;
+#endif
 
     uint8_t *active_byte;
     uint8_t *last_byte;
@@ -46,8 +46,45 @@ typedef int32_t (*initcall_t)(void);
 typedef struct {
     initcall_t fn_minit;
     initcall_t fn_tinit;
+#if defined(PIOS_INCLUDE_MEM_ACCOUNTING) || defined(PIOS_INCLUDE_INITCALL_PROFILE)
+    const char *name; /* owner of the memory allocated by the initcalls, name of the profile entry */
+#endif
 } initmodule_t;
 
+enum pios_initcall_phase {
+    PIOS_INITCALL_PHASE_INIT,
+    PIOS_INITCALL_PHASE_START,
+};
+
+struct pios_initcall_profile {
+    const char *name;
+    uint32_t   init_us; /* time spent in the initialize function */
+    uint32_t   start_us; /* time spent in the start function */
+};
+
+#ifdef PIOS_INCLUDE_INITCALL_PROFILE
+/* number of modules profiled, the ones beyond are not recorded */
+#ifndef PIOS_INITCALL_PROFILE_SIZE
+#define PIOS_INITCALL_PROFILE_SIZE 32
+#endif
+
+/**
+ * Record the time spent in one module initcall
+ * @param fn the initcall
+ * @param phase initialize or start
+ * @param raw PIOS_DELAY_GetRaw() taken before the call
+ */
+extern void PIOS_INITCALL_Profile(const initmodule_t *fn, enum pios_initcall_phase phase, uint32_t raw);
+
+/**
+ * Get the times recorded for one module
+ * @param index module index, from 0, in initcall order
+ * @param profile
+ * @return false if there is no such module
+ */
+extern bool PIOS_INITCALL_GetProfile(uint8_t index, struct pios_initcall_profile *profile);
+#endif
+
 /* Init module section */
 extern initmodule_t __module_initcall_start[], __module_initcall_end[];
 
@@ -85,24 +122,49 @@ extern void StartModules();
     static initcall_t __initcall_##fn##id __attribute__((__used__)) \
     __attribute__((__section__(".initcall" level ".init"))) = fn
 
+#if defined(PIOS_INCLUDE_MEM_ACCOUNTING) || defined(PIOS_INCLUDE_INITCALL_PROFILE)
+#define __define_module_initcall(level, ifn, sfn) \
+    static initmodule_t __initcall_##ifn __attribute__((__used__)) \
+    __attribute__((__section__(".initcall" level ".init"))) = { .fn_minit = ifn, .fn_tinit = sfn, .name = #ifn }
+#else
 #define __define_module_initcall(level, ifn, sfn) \
     static initmodule_t __initcall_##ifn __attribute__((__used__)) \
     __attribute__((__section__(".initcall" level ".init"))) = { .fn_minit = ifn, .fn_tinit = sfn }
+#endif
+
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+#define __module_initcall_owner(name) PIOS_MEM_SetOwner(name)
+#else
+#define __module_initcall_owner(name)
+#endif
+
+#ifdef PIOS_INCLUDE_INITCALL_PROFILE
+#define __module_initcall_call(fn, call, phase) \
+    { uint32_t __raw = PIOS_DELAY_GetRaw(); \
+      (fn->call)(); \
+      PIOS_INITCALL_Profile(fn, phase, __raw); }
+#else
+#define __module_initcall_call(fn, call, phase) (fn->call)()
+#endif
 
 #define MODULE_INITCALL(ifn, sfn) __define_module_initcall("module", ifn, sfn)
 
 #define MODULE_INITIALISE_ALL \
     { for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) { \
           if (fn->fn_minit) { \
-              (fn->fn_minit)(); } \
+              __module_initcall_owner(fn->name); \
+              __module_initcall_call(fn, fn_minit, PIOS_INITCALL_PHASE_INIT); } \
       } \
+      __module_initcall_owner(NULL); \
     }
 
 #define MODULE_TASKCREATE_ALL \
     { for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) { \
           if (fn->fn_tinit) { \
-              (fn->fn_tinit)(); } \
+              __module_initcall_owner(fn->name); \
+              __module_initcall_call(fn, fn_tinit, PIOS_INITCALL_PHASE_START); } \
       } \
+      __module_initcall_owner(NULL); \
     }
 
 #endif /* USE_SIM_POSIX */
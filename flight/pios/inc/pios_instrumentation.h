@@ -77,6 +77,7 @@ inline void PIOS_Instrumentation_TimeStart(pios_counter_t counter_handle)
 
     counter->lastUpdateTS = PIOS_DELAY_GetRaw();
     vPortExitCritical();
+    PIOS_EVENTTRACE(PIOS_EVENTTRACE_SECTION_START, counter - pios_instrumentation_perf_counters);
 }
 
 /**
@@ -89,6 +90,7 @@ inline void PIOS_Instrumentation_TimeEnd(pios_counter_t counter_handle)
     vPortEnterCritical();
     pios_perf_counter_t *counter = (pios_perf_counter_t *)counter_handle;
 
+    PIOS_EVENTTRACE(PIOS_EVENTTRACE_SECTION_END, counter - pios_instrumentation_perf_counters);
     counter->value = PIOS_DELAY_DiffuS(counter->lastUpdateTS);
     counter->max--;
     if (counter->value > counter->max) {
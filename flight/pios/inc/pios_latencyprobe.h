@@ -0,0 +1,98 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_latencyprobe.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      PiOS stick to output latency probe
+ *             Follows one receiver frame at a time through the control chain
+ *             up to the output it ends in, and keeps the latency statistics
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PIOS_LATENCYPROBE_H
+#define PIOS_LATENCYPROBE_H
+
+#include <stdint.h>
+
+/**
+ * Stages of the control chain, in order. A stage is reached when the code
+ * on it has taken in the data of the tagged frame: the tag moves on only
+ * from the stage it is at, so a stage working on older data does not take
+ * it early.
+ */
+enum pios_latencyprobe_stage {
+    PIOS_LATENCYPROBE_IDLE = 0,
+    PIOS_LATENCYPROBE_FRAME, /* frame decoded by the receiver driver */
+    PIOS_LATENCYPROBE_RECEIVER, /* channels read by the Receiver task */
+    PIOS_LATENCYPROBE_MANUALCONTROLCOMMAND, /* ManualControlCommand published */
+    PIOS_LATENCYPROBE_MANUALCONTROL, /* ManualControlCommand read by ManualControl */
+    PIOS_LATENCYPROBE_STABILIZATIONDESIRED, /* StabilizationDesired published */
+    PIOS_LATENCYPROBE_OUTERLOOP, /* StabilizationDesired read by the outer loop */
+    PIOS_LATENCYPROBE_RATEDESIRED, /* RateDesired published */
+    PIOS_LATENCYPROBE_INNERLOOP, /* RateDesired read by the inner loop */
+    PIOS_LATENCYPROBE_ACTUATORDESIRED, /* ActuatorDesired published */
+    PIOS_LATENCYPROBE_ACTUATOR, /* ActuatorDesired read by the Actuator */
+    PIOS_LATENCYPROBE_OUTPUT, /* first output set, ends the measurement */
+    PIOS_LATENCYPROBE_STAGES,
+};
+
+struct pios_latencyprobe_stats {
+    uint32_t samples; /* completed measurements */
+    uint32_t dropped; /* tags that did not reach an output in time */
+    uint32_t min; /* us */
+    uint32_t avg; /* us */
+    uint32_t max; /* us */
+    uint32_t stage[PIOS_LATENCYPROBE_STAGES]; /* mean time from the frame to each stage, us */
+};
+
+#ifdef PIOS_INCLUDE_LATENCYPROBE
+
+/**
+ * Reset the statistics, no frame is tagged
+ */
+extern void PIOS_LATENCYPROBE_Init(void);
+
+/**
+ * A receiver driver decoded a frame, it is tagged unless a measurement is
+ * under way. Can be called from ISRs.
+ */
+extern void PIOS_LATENCYPROBE_Frame(void);
+
+/**
+ * Move the tag from stage from to stage to, if it is at from. Stages in
+ * between are skipped, as the manual flight mode does for stabilization.
+ * Reaching PIOS_LATENCYPROBE_OUTPUT ends the measurement.
+ */
+extern void PIOS_LATENCYPROBE_Pass(uint8_t from, uint8_t to);
+
+/**
+ * Copy the statistics since the initialization
+ */
+extern void PIOS_LATENCYPROBE_GetStats(struct pios_latencyprobe_stats *stats);
+
+#define PIOS_LATENCYPROBE_FRAME()        PIOS_LATENCYPROBE_Frame()
+#define PIOS_LATENCYPROBE_PASS(from, to) PIOS_LATENCYPROBE_Pass((from), (to))
+
+#else
+
+#define PIOS_LATENCYPROBE_FRAME()
+#define PIOS_LATENCYPROBE_PASS(from, to)
+
+#endif /* PIOS_INCLUDE_LATENCYPROBE */
+
+#endif /* PIOS_LATENCYPROBE_H */
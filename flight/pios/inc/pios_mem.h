@@ -27,6 +27,30 @@
 #ifndef PIOS_MEM_H
 #define PIOS_MEM_H
 #include <strings.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Boards can serve small pios_malloc() requests from fixed size block pools
+ * by defining PIOS_MEM_POOLS as a list of { block size, block count } pairs,
+ * smallest block first, e.g. { { 16, 32 }, { 32, 16 } }.
+ * Freed blocks go back to their pool, even where the heap can not free (heap_1).
+ */
+
+/*
+ * Placement of the data and code of the control path, on targets with a fast
+ * heap in the CCM (see link_stm32f4xx_sections.ld), and nothing elsewhere:
+ * PIOS_MEM_FAST     static data in the CCM, zero initialized. The DMA can not reach it.
+ * PIOS_MEM_RAMFUNC  a function run from SRAM, without the flash wait states
+ * "make fw_<board>_placement" lists what went where.
+ */
+#ifdef PIOS_TARGET_PROVIDES_FAST_HEAP
+#define PIOS_MEM_FAST    __attribute__((section(".fast")))
+#define PIOS_MEM_RAMFUNC __attribute__((section(".ramfunc"), noinline))
+#else
+#define PIOS_MEM_FAST
+#define PIOS_MEM_RAMFUNC
+#endif
 
 void *pios_fastheapmalloc(size_t size);
 
@@ -34,4 +58,50 @@ void *pios_malloc(size_t size);
 
 void pios_free(void *p);
 
+struct pios_mem_pool_stats {
+    uint16_t block_size;
+    uint16_t blocks;
+    uint16_t free; /* blocks currently free */
+    uint16_t min_free; /* lowest number of free blocks seen */
+    uint16_t misses; /* requests that fell back to the heap because the pool was empty */
+};
+
+/**
+ * Get the statistics of a block pool
+ * @param pool pool index, from 0
+ * @param stats
+ * @return false if there is no such pool
+ */
+bool PIOS_MEM_GetPoolStats(uint8_t pool, struct pios_mem_pool_stats *stats);
+
+#ifdef PIOS_INCLUDE_MEM_ACCOUNTING
+
+#ifndef PIOS_MEM_MAX_OWNERS
+#define PIOS_MEM_MAX_OWNERS 24
+#endif
+
+struct pios_mem_owner_stats {
+    const char *name;
+    uint32_t   heap_bytes; /* bytes taken from the heap, heap frees are not credited back */
+    uint16_t   pool_blocks; /* pool blocks in use */
+    uint16_t   allocations;
+};
+
+/**
+ * Charge the following allocations to an owner, until the next call.
+ * The module initcalls are charged to their module, everything else to "System".
+ * @param name owner name, must stay valid. NULL for the system.
+ */
+void PIOS_MEM_SetOwner(const char *name);
+
+/**
+ * Get the memory use of an owner
+ * @param owner owner index, 0 is the system
+ * @param stats
+ * @return false if there is no such owner
+ */
+bool PIOS_MEM_GetOwnerStats(uint8_t owner, struct pios_mem_owner_stats *stats);
+
+#endif /* PIOS_INCLUDE_MEM_ACCOUNTING */
+
 #endif /* PIOS_MEM_H */
@@ -151,6 +151,7 @@ struct pios_mpu6000_cfg {
     SPIPrescalerTypeDef fast_prescaler;
     SPIPrescalerTypeDef std_prescaler;
     uint8_t max_downsample;
+    uint16_t fifo_rate; /* 0 reads the data registers on every sample, else the FIFO is burst read and averaged down to this rate (Hz) */
 };
 
 /* Public Functions */
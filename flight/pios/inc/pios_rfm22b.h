@@ -89,6 +89,8 @@ struct rfm22b_stats {
     uint8_t  rx_error;
     uint8_t  rx_missed;
     uint8_t  rx_failure;
+    uint8_t  rc_good;
+    uint8_t  rc_lost;
     uint8_t  tx_dropped;
     uint8_t  tx_failure;
     uint8_t  resets;
@@ -97,6 +99,8 @@ struct rfm22b_stats {
     int8_t   rssi;
     int8_t   afc_correction;
     uint8_t  link_state;
+    uint8_t  air_datarate;
+    uint8_t  fec_parity;
 };
 
 /* Public Functions */
@@ -697,6 +697,12 @@ struct pios_rfm22b_dev {
 
     // The RF datarate lookup index.
     uint8_t  datarate;
+    // The configured datarate, the link adapts at or below it.
+    uint8_t  base_datarate;
+    // The datarate to switch to at the end of the announcing hop cycle.
+    uint8_t  next_datarate;
+    // The hop cycle that announces the datarate switch.
+    uint32_t switch_cycle;
 
     // The radio state machine state
     enum pios_radio_state state;
@@ -710,6 +716,9 @@ struct pios_rfm22b_dev {
     // The error statistics counters
     uint16_t prev_rx_seq_num;
     uint32_t rx_packet_stats[RFM22B_RX_PACKET_STATS_LEN];
+    // The RC slot window, a set bit is a lost RC slot
+    uint64_t rc_slot_lost;
+    uint8_t  rc_slot_count;
 
     // The RFM22B state machine state
     enum pios_rfm22b_state rfm22b_state;
@@ -762,6 +771,22 @@ struct pios_rfm22b_dev {
     bool         ppm_recv_mode;
     // Are we sending / receiving only PPM data?
     bool         ppm_only_mode;
+    // Does the link adapt the datarate, FEC and packet size to the conditions?
+    bool         adaptive;
+    // The FEC level and packet size used to transmit.
+    uint8_t      fec_level;
+    bool         short_packets;
+    // The FEC level of the last packet received.
+    uint8_t      rx_fec_level;
+    // The link quality reported by the other modem.
+    uint8_t      peer_link_quality;
+    // Consecutive adaptation periods with a good link.
+    uint8_t      good_periods;
+    // The tx sequence number of the last adaptation.
+    uint16_t     adapt_seq;
+    // The minimum and maximum channels.
+    uint8_t      min_chan;
+    uint8_t      max_chan;
 
     // The channel list
     uint8_t      channels[RFM22B_NUM_CHANNELS];
@@ -781,6 +806,10 @@ struct pios_rfm22b_dev {
     portTickType tx_complete_ticks;
     portTickType time_delta;
     portTickType last_contact;
+    // The coordinator time of the last datarate switch.
+    portTickType time_epoch;
+    // The time of the last datarate step while not connected.
+    portTickType rate_step_ticks;
 };
 
 
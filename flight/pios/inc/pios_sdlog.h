@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @defgroup   PIOS_SDLOG SD card streaming log
+ * @brief Writes UAVObject updates to an SD card in the GCS .opl format
+ * @{
+ *
+ * @file       pios_sdlog.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      SD card streaming log
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_SDLOG_H
+#define PIOS_SDLOG_H
+
+/**
+ * @brief Allocate the buffers, call once the SD card is initialised
+ * @return 0 if success, -1 if out of memory
+ */
+int32_t PIOS_SDLOG_Init(void);
+
+/**
+ * @brief Create the next LOGnnnnn.OPL file on the mounted card and preallocate it
+ * Scans the FAT, so it is slow and must be called from a low priority task.
+ * @return 0 if success or error code
+ * @retval -1 if not initialised or the card is not mounted
+ * @retval -2 if no file could be created
+ * @retval -3 if there is no contiguous free space for the log
+ */
+int32_t PIOS_SDLOG_Open(void);
+
+/**
+ * @brief Write what is left of the log, set the file length and free the unused space
+ * Called from the same task as PIOS_SDLOG_Flush().
+ */
+void PIOS_SDLOG_Close(void);
+
+/**
+ * @brief Check if a log file is open
+ */
+bool PIOS_SDLOG_IsOpen(void);
+
+/**
+ * @brief Queue an object update as a record of the log, never blocks on the card
+ * Records which do not fit in the free buffer space are dropped and counted.
+ * When the card fails or the preallocated space is used up the log stops there.
+ * @param[in] objid the object ID
+ * @param[in] instid the instance ID
+ * @param[in] size of the object data
+ * @param[in] data the object data
+ */
+void PIOS_SDLOG_UAVObject(uint32_t objid, uint16_t instid, size_t size, const uint8_t *data);
+
+/**
+ * @brief Write the full buffers to the card
+ * Called periodically from a low priority task, this is the only writer to the card.
+ */
+void PIOS_SDLOG_Flush(void);
+
+/**
+ * @brief Number of records dropped since the log was opened
+ */
+uint32_t PIOS_SDLOG_Dropped(void);
+
+#endif /* PIOS_SDLOG_H */
+
+/**
+ * @}
+ * @}
+ */
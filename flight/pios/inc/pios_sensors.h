@@ -68,9 +68,16 @@ typedef struct PIOS_SENSORS_Instance {
     const PIOS_SENSORS_Driver    *driver;
     uintptr_t context;
     struct PIOS_SENSORS_Instance *next;
-    uint8_t type;
+    uint8_t  type;
+    uint16_t poll_period_ms; // polled sensors are checked at this period and when they signal data ready, 0 for the sensor rate
 } PIOS_SENSORS_Instance;
 
+/**
+ * Called from the ISR of a polled sensor that has new data available
+ * @return true if a higher priority task was woken
+ */
+typedef bool (*PIOS_SENSORS_data_ready_function)(const PIOS_SENSORS_Instance *sensor);
+
 /**
  * A 3d Accel sample with temperature
  */
@@ -94,6 +101,26 @@ typedef struct PIOS_SENSORS_1Axis_SensorsWithTemp {
  */
 
 PIOS_SENSORS_Instance *PIOS_SENSORS_Register(const PIOS_SENSORS_Driver *driver, PIOS_SENSORS_TYPE type, uintptr_t context);
+
+/**
+ * Set the period a polled sensor is checked at, in absence of data ready signals
+ * @param sensor instance
+ * @param period_ms period in ms, 0 for the sensor rate
+ */
+void PIOS_SENSORS_SetPollPeriod(PIOS_SENSORS_Instance *sensor, uint16_t period_ms);
+
+/**
+ * Set the handler the data ready signals of the polled sensors go to
+ * @param handler handler, NULL to ignore the signals
+ */
+void PIOS_SENSORS_SetDataReadyHandler(PIOS_SENSORS_data_ready_function handler);
+
+/**
+ * Signal that a polled sensor has new data, to be called from the driver ISR
+ * @param sensor instance, NULL if the sensor was not registered
+ * @return true if a higher priority task was woken
+ */
+bool PIOS_SENSORS_DataReadyFromISR(const PIOS_SENSORS_Instance *sensor);
 /**
  * return the list of registered sensors.
  * @return the first sensor instance in the list.
@@ -33,7 +33,9 @@
 /* Global types */
 enum pios_servo_bank_mode {
     PIOS_SERVO_BANK_MODE_PWM = 0,
-    PIOS_SERVO_BANK_MODE_SINGLE_PULSE = 1
+    PIOS_SERVO_BANK_MODE_SINGLE_PULSE = 1,
+    // digital frames sent by DMA on every PIOS_Servo_Update(), positions are 0-2047
+    PIOS_SERVO_BANK_MODE_DSHOT = 2
 };
 /* Public Functions */
 extern void PIOS_Servo_SetHz(const uint16_t *speeds, const uint32_t *clock, uint8_t banks);
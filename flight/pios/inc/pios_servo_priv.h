@@ -42,6 +42,11 @@ struct pios_servo_cfg {
     uint32_t remap;
     const struct pios_tim_channel *channels;
     uint8_t  num_channels;
+#if defined(STM32F2XX) || defined(STM32F4XX)
+    /* optional, the banks whose timer has an update DMA stream here can use DShot */
+    const struct pios_tim_burst_dma *dshot_dma;
+    uint8_t  num_dshot_dma;
+#endif
 };
 
 extern int32_t PIOS_Servo_Init(const struct pios_servo_cfg *cfg);
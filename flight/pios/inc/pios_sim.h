@@ -0,0 +1,99 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_sim.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Simulated time for the posix target.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_SIM_H
+#define PIOS_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <semaphore.h>
+
+/* Global Types */
+enum pios_sim_mode {
+    PIOS_SIM_REALTIME, /* wall clock, the default */
+    PIOS_SIM_FREERUN, /* the next tick starts as soon as every task is blocked */
+    PIOS_SIM_STEPPED, /* ticks are granted by an external simulator */
+};
+
+/* Sensor values injected by the simulator, see modules/Sensors/simulated */
+struct pios_sim_sensors {
+    float gyro[3]; /* deg/s */
+    float accel[3]; /* m/s^2 */
+    float mag[3]; /* mGa */
+    float altitude; /* barometric, m */
+    float temperature; /* deg C */
+} __attribute__((packed));
+
+#define PIOS_SIM_STEP_SENSORS 0x01
+
+/* Datagram sent by the simulator: run that many ticks, then reply */
+struct pios_sim_step {
+    uint32_t ticks;
+    uint32_t flags;
+    struct pios_sim_sensors sensors; /* valid with PIOS_SIM_STEP_SENSORS */
+} __attribute__((packed));
+
+#define PIOS_SIM_NUM_SERVOS 8
+
+/* Datagram sent back once the ticks ran and every task is blocked again */
+struct pios_sim_reply {
+    uint64_t time_us;
+    uint16_t servos[PIOS_SIM_NUM_SERVOS]; /* us, 0 for outputs the board does not have */
+} __attribute__((packed));
+
+#define PIOS_SIM_RING_SIZE 16
+
+/*
+ * Shared memory transport, an alternative to the UDP steps when the simulator
+ * runs on the same host. The simulator creates the object with shm_open(),
+ * sizes it, initialises the process shared semaphores and starts the board
+ * with its name. Each ring has a single producer and a single consumer.
+ */
+struct pios_sim_shm {
+    sem_t    step_free; /* counts free step slots, posted by the board */
+    sem_t    step_ready; /* counts queued steps, posted by the simulator */
+    sem_t    reply_free;
+    sem_t    reply_ready;
+    uint32_t step_head; /* written by the simulator */
+    uint32_t step_tail; /* written by the board */
+    uint32_t reply_head; /* written by the board */
+    uint32_t reply_tail; /* written by the simulator */
+    struct pios_sim_step  steps[PIOS_SIM_RING_SIZE];
+    struct pios_sim_reply replies[PIOS_SIM_RING_SIZE];
+};
+
+/* Public Functions */
+extern int32_t PIOS_SIM_Init(enum pios_sim_mode mode, uint16_t port);
+extern int32_t PIOS_SIM_InitShared(const char *name);
+extern bool PIOS_SIM_Lockstep(void);
+extern uint64_t PIOS_SIM_GetTimeuS(void);
+extern bool PIOS_SIM_GetSensors(struct pios_sim_sensors *sensors);
+extern void PIOS_SIM_SetSeed(uint32_t seed);
+extern uint32_t PIOS_SIM_GetSeed(void);
+
+/* Provided by the posix servo driver */
+extern uint16_t PIOS_Servo_GetPosition(uint8_t servo);
+
+#endif /* PIOS_SIM_H */
@@ -42,6 +42,39 @@ typedef enum {
     PIOS_SPI_PRESCALER_256 = 7
 } SPIPrescalerTypeDef;
 
+/* Queued transactions, see PIOS_SPI_QueueJob() */
+enum pios_spi_priority {
+    PIOS_SPI_PRIORITY_HIGH   = 0,
+    PIOS_SPI_PRIORITY_NORMAL = 1,
+    PIOS_SPI_PRIORITY_LOW    = 2,
+    PIOS_SPI_PRIORITY_NUM
+};
+
+struct pios_spi_transfer {
+    const uint8_t *send_buffer; /* NULL sends 0xff */
+    uint8_t *receive_buffer; /* NULL discards the received bytes */
+    uint16_t len;
+};
+
+struct pios_spi_job;
+
+/* Called from the DMA interrupt, status is 0 or -4 on a CRC error. woken is set like for an ISR */
+typedef void (*pios_spi_job_callback)(struct pios_spi_job *job, int32_t status, bool *woken);
+
+struct pios_spi_job {
+    /* Set by the caller, the buffers must stay valid and out of CCM until the callback */
+    uint32_t slave_id;
+    SPIPrescalerTypeDef prescaler;
+    enum pios_spi_priority priority;
+    const struct pios_spi_transfer *transfers; /* all done with the slave selected */
+    uint8_t num_transfers;
+    pios_spi_job_callback callback;
+    void *context;
+    /* Private to the driver */
+    struct pios_spi_job *next;
+    volatile bool queued;
+};
+
 /* Public Functions */
 extern int32_t PIOS_SPI_SetClockSpeed(uint32_t spi_id, SPIPrescalerTypeDef spi_prescaler);
 extern int32_t PIOS_SPI_RC_PinSet(uint32_t spi_id, uint32_t slave_id, uint8_t pin_value);
@@ -54,6 +87,7 @@ extern int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id);
 extern int32_t PIOS_SPI_ReleaseBusISR(uint32_t spi_id, bool *woken);
 extern void    PIOS_SPI_IRQ_Handler(uint32_t spi_id);
 extern void    PIOS_SPI_SetPrescalar(uint32_t spi_id, uint32_t prescalar);
+extern int32_t PIOS_SPI_QueueJob(uint32_t spi_id, struct pios_spi_job *job);
 
 #endif /* PIOS_SPI_H */
 
@@ -52,6 +52,12 @@ struct pios_spi_dev {
     void    (*callback)(uint8_t, uint8_t);
     uint8_t tx_dummy_byte;
     uint8_t rx_dummy_byte;
+#ifdef PIOS_SPI_JOBS
+    struct pios_spi_job *job;
+    uint8_t job_transfer;
+    struct pios_spi_job *job_head[PIOS_SPI_PRIORITY_NUM];
+    struct pios_spi_job *job_tail[PIOS_SPI_PRIORITY_NUM];
+#endif
 #if defined(PIOS_INCLUDE_FREERTOS)
     xSemaphoreHandle busy;
 #else
@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_spscqueue.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      PiOS lock free single producer single consumer queue
+ *             Copies fixed size items between one producer and one consumer
+ *             without critical sections, neither side ever blocks
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PIOS_SPSCQUEUE_H
+#define PIOS_SPSCQUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct pios_spscqueue *pios_spscqueue_t;
+
+/**
+ * Create a queue
+ * @param length number of items, rounded up to a power of 2
+ * @param itemSize size of an item in bytes
+ * @return the queue or NULL if out of memory
+ */
+extern pios_spscqueue_t PIOS_SPSCQUEUE_Create(uint16_t length, uint16_t itemSize);
+
+/**
+ * Copy an item into the queue, only to be called by the producer
+ * @return false if the queue is full
+ */
+extern bool PIOS_SPSCQUEUE_Send(pios_spscqueue_t queue, const void *item);
+
+/**
+ * Copy the oldest item out of the queue, only to be called by the consumer
+ * @return false if the queue is empty
+ */
+extern bool PIOS_SPSCQUEUE_Receive(pios_spscqueue_t queue, void *item);
+
+/**
+ * @return the number of items waiting, exact when called by either side
+ */
+extern uint16_t PIOS_SPSCQUEUE_Count(pios_spscqueue_t queue);
+
+#endif /* PIOS_SPSCQUEUE_H */
@@ -71,6 +71,15 @@ extern int32_t PIOS_TASK_MONITOR_UnregisterTask(uint16_t task_id);
  */
 extern bool PIOS_TASK_MONITOR_IsRunning(uint16_t task_id);
 
+/**
+ * Looks up the id a task has been registered with.
+ * Does not lock, so it can be used from the scheduler hooks.
+ *
+ * @param handle The FreeRTOS xTaskHandle of the task.
+ * @return the task id, 0xFFFF if the task has not been registered.
+ */
+extern uint16_t PIOS_TASK_MONITOR_GetTaskId(xTaskHandle handle);
+
 /**
  * Information about a running task that has been registered
  * via a call to PIOS_TASK_MONITOR_Add().
@@ -80,8 +89,9 @@ struct pios_task_info {
     uint32_t stack_remaining;
     /** Flag indicating whether or not the task is running. */
     bool     is_running;
-    /** Percentage of cpu time used by the task since the last call
-     *  to PIOS_TASK_MONITOR_ForEachTask(). Low-load tasks may
+    /** Percentage of cpu time used by the task since it was last
+     *  sampled by PIOS_TASK_MONITOR_ForEachTask() or
+     *  PIOS_TASK_MONITOR_GetTaskInfo(). Low-load tasks may
      *  report 0% load even though they have run during the interval. */
     uint8_t running_time_percentage;
 };
@@ -104,6 +114,15 @@ typedef void (*TaskMonitorTaskInfoCallback)(uint16_t task_id, const struct pios_
  */
 extern void PIOS_TASK_MONITOR_ForEachTask(TaskMonitorTaskInfoCallback callback, void *context);
 
+/**
+ * Get the information of a single task, to spread the sampling of all tasks over time.
+ *
+ * @param task_id   The id of the task
+ * @param info      Receives the information about the task
+ * @return 0 on success, -1 if task_id is out of range
+ */
+extern int32_t PIOS_TASK_MONITOR_GetTaskInfo(uint16_t task_id, struct pios_task_info *info);
+
 /**
  * Return the idle task running time percentage.
  */
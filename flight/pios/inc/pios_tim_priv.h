@@ -25,4 +25,19 @@ struct pios_tim_callbacks {
 extern int32_t PIOS_TIM_InitClock(const struct pios_tim_clock_cfg *cfg);
 extern int32_t PIOS_TIM_InitChannels(uint32_t *tim_id, const struct pios_tim_channel *channels, uint8_t num_channels, const struct pios_tim_callbacks *callbacks, uint32_t context);
 
+#if defined(STM32F2XX) || defined(STM32F4XX)
+/* DMA stream serving the update request of a timer, used for burst writes to the CCRs */
+struct pios_tim_burst_dma {
+    TIM_TypeDef *timer;
+    DMA_Stream_TypeDef *stream;
+    uint32_t    channel; /* DMA_Channel_x of the TIMx_UP request on that stream */
+    uint32_t    flags; /* all DMA_FLAG_xxIFn flags of the stream */
+};
+
+extern int32_t PIOS_TIM_InitBurstDMA(const struct pios_tim_burst_dma *cfg, uint8_t first, uint8_t count, const uint32_t *buffer, uint16_t transfers);
+extern bool PIOS_TIM_StartBurstDMA(const struct pios_tim_burst_dma *cfg, uint16_t transfers);
+extern bool PIOS_TIM_BurstDMABusy(const struct pios_tim_burst_dma *cfg);
+extern void PIOS_TIM_StopBurstDMA(const struct pios_tim_burst_dma *cfg);
+#endif
+
 #endif /* PIOS_TIM_PRIV_H */
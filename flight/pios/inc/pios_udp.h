@@ -31,5 +31,10 @@
 /* Global Types */
 
 /* Public Functions */
+extern void PIOS_UDP_SetPortOffset(uint16_t offset);
+extern int32_t PIOS_UDP_SetMulticastGroup(const char *group, uint16_t port);
+
+/* Published datagrams start with a 16 bit little endian sequence number */
+#define PIOS_UDP_MULTICAST_SEQUENCE_LENGTH 2
 
 #endif /* PIOS_UDP_H */
@@ -38,23 +38,39 @@
 #include <fcntl.h>
 #include <netinet/in.h>
 
+#if defined(__linux__)
+// One epoll thread serves all the ports, datagrams are read and sent in batches
+#define PIOS_UDP_EVENT_LOOP
+#include <sys/epoll.h>
+#endif
+
+// Datagrams read or sent with one system call
+#define PIOS_UDP_BATCH_LENGTH 8
+
 struct pios_udp_cfg {
     const char *ip;
     uint16_t   port;
+    bool multicast; // transmit to the multicast group, if one is set
 };
 
 typedef struct {
     const struct pios_udp_cfg *cfg;
+#if !defined(PIOS_UDP_EVENT_LOOP)
 #if defined(PIOS_INCLUDE_FREERTOS)
     xTaskHandle rxThread;
 #else
     pthread_t   rxThread;
+#endif
 #endif
 
     int socket;
     struct sockaddr_in server;
     struct sockaddr_in client;
     uint32_t clientLength;
+    // transmit destination when publishing, every datagram then starts with a sequence number
+    bool     multicast;
+    struct sockaddr_in group;
+    uint16_t sequence;
 
     pthread_cond_t     cond;
     pthread_mutex_t    mutex;
@@ -65,7 +81,7 @@ typedef struct {
     uint32_t rx_in_context;
 
     uint8_t  rx_buffer[PIOS_UDP_RX_BUFFER_SIZE];
-    uint8_t  tx_buffer[PIOS_UDP_RX_BUFFER_SIZE];
+    uint8_t  tx_buffer[PIOS_UDP_BATCH_LENGTH][PIOS_UDP_RX_BUFFER_SIZE];
 } pios_udp_dev;
 
 extern int32_t PIOS_UDP_Init(uint32_t *udp_id, const struct pios_udp_cfg *cfg);
@@ -45,10 +45,13 @@ struct pios_usart_cfg {
     struct stm32_gpio rx;
     struct stm32_gpio tx;
     struct stm32_irq  irq;
+    const struct stm32_dma *dma; /* optional, transmit by DMA instead of TXE interrupts, uses .tx (STM32F4 only) */
+    const struct stm32_dma *dma_rx; /* optional, receive bursts by circular DMA and IDLE interrupts, uses .rx (STM32F4 only) */
 };
 
 extern int32_t PIOS_USART_Init(uint32_t *usart_id, const struct pios_usart_cfg *cfg);
 extern const struct pios_usart_cfg *PIOS_USART_GetConfig(uint32_t usart_id);
+extern void PIOS_USART_DMA_irq_handler(USART_TypeDef *regs);
 
 #endif /* PIOS_USART_PRIV_H */
 
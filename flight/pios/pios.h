@@ -111,6 +111,15 @@ extern "C" {
 #include <pios_callbackscheduler.h>
 #endif
 
+/* PIOS trace buffer, PIOS_EVENTTRACE() compiles to nothing without PIOS_INCLUDE_EVENTTRACE */
+#include <pios_eventtrace.h>
+
+/* PIOS latency probe, PIOS_LATENCYPROBE_*() compile to nothing without PIOS_INCLUDE_LATENCYPROBE */
+#include <pios_latencyprobe.h>
+
+/* PIOS lock free single producer single consumer queue */
+#include <pios_spscqueue.h>
+
 /* PIOS bootloader helper */
 #ifdef PIOS_INCLUDE_BL_HELPER
 /* #define PIOS_INCLUDE_BL_HELPER_WRITE_SUPPORT */
@@ -259,6 +268,9 @@ extern "C" {
 /* #define LOG_FILENAME "startup.log" */
 #include <dosfs.h>
 #include <pios_sdcard.h>
+#ifdef PIOS_INCLUDE_SDLOG
+#include <pios_sdlog.h>
+#endif
 #endif
 
 #ifdef PIOS_INCLUDE_FLASH
@@ -56,6 +56,15 @@
 #include <pios_callbackscheduler.h>
 #endif
 
+/* PIOS trace buffer, PIOS_EVENTTRACE() compiles to nothing without PIOS_INCLUDE_EVENTTRACE */
+#include <pios_eventtrace.h>
+
+/* PIOS latency probe, PIOS_LATENCYPROBE_*() compile to nothing without PIOS_INCLUDE_LATENCYPROBE */
+#include <pios_latencyprobe.h>
+
+/* PIOS lock free single producer single consumer queue */
+#include <pios_spscqueue.h>
+
 /* C Lib Includes */
 #include <stdio.h>
 #include <stdlib.h>
@@ -83,6 +92,7 @@ extern void PIOS_LED_Init(void);
 #include <pios_irq.h>
 #include <pios_sdcard.h>
 #include <pios_udp.h>
+#include <pios_sim.h>
 #include <pios_com.h>
 #include <pios_servo.h>
 #include <pios_wdg.h>
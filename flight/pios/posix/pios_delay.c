@@ -63,6 +63,12 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
     static struct timespec wait, rest;
 
+#if defined(PIOS_INCLUDE_SIM)
+    // Simulated time stands still while a task runs, there is nothing to wait for
+    if (PIOS_SIM_Lockstep()) {
+        return 0;
+    }
+#endif
     wait.tv_sec  = 0;
     wait.tv_nsec = 1000 * uS;
     while (nanosleep(&wait, &rest) != 0) {
@@ -90,6 +96,11 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
     // PIOS_DELAY_WaituS(1000);
     static struct timespec wait, rest;
 
+#if defined(PIOS_INCLUDE_SIM)
+    if (PIOS_SIM_Lockstep()) {
+        return 0;
+    }
+#endif
     wait.tv_sec  = mS / 1000;
     wait.tv_nsec = (mS % 1000) * 1000000;
     while (nanosleep(&wait, &rest) != 0) {
@@ -109,6 +120,11 @@ uint32_t PIOS_DELAY_GetuS()
 {
     static struct timespec current;
 
+#if defined(PIOS_INCLUDE_SIM)
+    if (PIOS_SIM_Lockstep()) {
+        return (uint32_t)PIOS_SIM_GetTimeuS();
+    }
+#endif
     clock_gettime(CLOCK_REALTIME, &current);
     return (current.tv_sec * 1000000) + (current.tv_nsec / 1000);
 }
@@ -68,4 +68,14 @@ void PIOS_Servo_Set(uint8_t Servo, uint16_t Position)
 #endif // PIOS_ENABLE_DEBUG_PINS
 }
 
+/**
+ * Get servo position, read back by the simulator
+ * \param[in] Servo Servo number (0-7)
+ * \return Position in microseconds, 0 if the servo does not exist
+ */
+uint16_t PIOS_Servo_GetPosition(uint8_t Servo)
+{
+    return (Servo < PIOS_SERVO_NUM_OUTPUTS) ? ServoPosition[Servo] : 0;
+}
+
 #endif /* if defined(PIOS_INCLUDE_SERVO) */
@@ -0,0 +1,258 @@
+/**
+ ******************************************************************************
+ *
+ * @file       pios_sim.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Lockstep simulated time for the posix target.
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   PIOS_SIM Simulated time
+ * @{
+ *
+ * In lockstep modes the FreeRTOS tick, PIOS_DELAY and PIOS_DELAY_GetRaw all
+ * follow a simulated clock that moves one tick at a time, and only once every
+ * task is blocked waiting for a later tick. The firmware then runs as fast as
+ * the host allows, and the result does not depend on the host load.
+ *
+ * In stepped mode an external simulator drives the clock over UDP: it sends a
+ * pios_sim_step datagram, optionally with sensor values for the simulated
+ * sensors module, the firmware runs the requested ticks and answers with a
+ * pios_sim_reply holding the simulated time and the servo outputs. The same
+ * messages can go through the pios_sim_shm rings instead, which is what the
+ * swarm harness uses to drive many boards at once.
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* Project Includes */
+#include "pios.h"
+
+#if defined(PIOS_INCLUDE_SIM)
+
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+/* Local Variables */
+static enum pios_sim_mode sim_mode = PIOS_SIM_REALTIME;
+static volatile uint64_t sim_time_us;
+
+static int sim_socket = -1;
+static struct sockaddr_in sim_peer;
+static struct pios_sim_shm *sim_shm;
+static uint32_t sim_ticks_left;
+static bool sim_stepping;
+
+static pthread_mutex_t sim_sensors_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct pios_sim_sensors sim_sensors;
+static bool sim_sensors_valid;
+static uint32_t sim_seed = 1;
+
+/**
+ * Selects the time base, must be called before the scheduler starts
+ * \param[in] mode realtime, free running or stepped lockstep
+ * \param[in] port UDP port the simulator steps from, stepped mode only
+ * \return < 0 if the simulator socket could not be opened
+ */
+int32_t PIOS_SIM_Init(enum pios_sim_mode mode, uint16_t port)
+{
+    sim_mode    = mode;
+    sim_time_us = 0;
+
+    if (mode != PIOS_SIM_STEPPED) {
+        return 0;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port        = htons(port);
+
+    sim_socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sim_socket < 0 || bind(sim_socket, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Simulator socket on port %u: %s\n", port, strerror(errno));
+        sim_mode = PIOS_SIM_REALTIME;
+        return -1;
+    }
+    fprintf(stderr, "Waiting for simulator steps on UDP port %u\n", port);
+    return 0;
+}
+
+/**
+ * Stepped mode through shared memory rings, must be called before the scheduler starts
+ * \param[in] name shared memory object created by the simulator
+ * \return < 0 if it could not be mapped
+ */
+int32_t PIOS_SIM_InitShared(const char *name)
+{
+    int fd = shm_open(name, O_RDWR, 0);
+
+    if (fd < 0) {
+        fprintf(stderr, "Simulator shared memory %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    sim_shm = mmap(NULL, sizeof(*sim_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (sim_shm == MAP_FAILED) {
+        fprintf(stderr, "Simulator shared memory %s: %s\n", name, strerror(errno));
+        sim_shm = NULL;
+        return -1;
+    }
+
+    sim_mode    = PIOS_SIM_STEPPED;
+    sim_time_us = 0;
+    return 0;
+}
+
+/**
+ * \return true when the time base is simulated
+ */
+bool PIOS_SIM_Lockstep(void)
+{
+    return sim_mode != PIOS_SIM_REALTIME;
+}
+
+/**
+ * \return the simulated time in us
+ */
+uint64_t PIOS_SIM_GetTimeuS(void)
+{
+    return sim_time_us;
+}
+
+/**
+ * Get the last sensor values the simulator injected
+ * \param[out] sensors the values
+ * \return false if the simulator never sent any
+ */
+bool PIOS_SIM_GetSensors(struct pios_sim_sensors *sensors)
+{
+    pthread_mutex_lock(&sim_sensors_mutex);
+    bool valid = sim_sensors_valid;
+    if (valid) {
+        *sensors = sim_sensors;
+    }
+    pthread_mutex_unlock(&sim_sensors_mutex);
+    return valid;
+}
+
+/**
+ * Seed for the simulated sensor noise, the same seed gives the same run
+ */
+void PIOS_SIM_SetSeed(uint32_t seed)
+{
+    sim_seed = seed;
+}
+
+uint32_t PIOS_SIM_GetSeed(void)
+{
+    return sim_seed;
+}
+
+static void sendReply(void)
+{
+    struct pios_sim_reply reply;
+
+    reply.time_us = sim_time_us;
+    for (uint8_t i = 0; i < PIOS_SIM_NUM_SERVOS; i++) {
+#if defined(PIOS_INCLUDE_SERVO)
+        reply.servos[i] = PIOS_Servo_GetPosition(i);
+#else
+        reply.servos[i] = 0;
+#endif
+    }
+    if (sim_shm) {
+        while (sem_wait(&sim_shm->reply_free) < 0 && errno == EINTR) {
+            ;
+        }
+        sim_shm->replies[sim_shm->reply_head % PIOS_SIM_RING_SIZE] = reply;
+        __sync_synchronize();
+        sim_shm->reply_head++;
+        sem_post(&sim_shm->reply_ready);
+        return;
+    }
+    sendto(sim_socket, &reply, sizeof(reply), 0, (struct sockaddr *)&sim_peer, sizeof(sim_peer));
+}
+
+/* Blocks until the simulator grants some ticks */
+static void waitForStep(void)
+{
+    struct pios_sim_step step;
+
+    while (sim_ticks_left == 0) {
+        if (sim_shm) {
+            if (sem_wait(&sim_shm->step_ready) < 0) {
+                continue;
+            }
+            step = sim_shm->steps[sim_shm->step_tail % PIOS_SIM_RING_SIZE];
+            __sync_synchronize();
+            sim_shm->step_tail++;
+            sem_post(&sim_shm->step_free);
+        } else {
+            socklen_t len = sizeof(sim_peer);
+            ssize_t size  = recvfrom(sim_socket, &step, sizeof(step), 0, (struct sockaddr *)&sim_peer, &len);
+
+            if (size != sizeof(step)) {
+                continue;
+            }
+        }
+        if (step.flags & PIOS_SIM_STEP_SENSORS) {
+            pthread_mutex_lock(&sim_sensors_mutex);
+            sim_sensors       = step.sensors;
+            sim_sensors_valid = true;
+            pthread_mutex_unlock(&sim_sensors_mutex);
+        }
+        if (step.ticks == 0) {
+            // Just a query, answer with the current state
+            sendReply();
+        }
+        sim_ticks_left = step.ticks;
+    }
+}
+
+/**
+ * Hook called by the FreeRTOS posix port before each tick, from the scheduler
+ * thread. The port has already waited for all the tasks to block.
+ * \return pdFALSE to keep the wall clock ticks
+ */
+portBASE_TYPE xPortLockstepTick(void)
+{
+    if (sim_mode == PIOS_SIM_REALTIME) {
+        return pdFALSE;
+    }
+    if (sim_mode == PIOS_SIM_STEPPED) {
+        if (sim_ticks_left == 0) {
+            if (sim_stepping) {
+                sendReply();
+            }
+            waitForStep();
+            sim_stepping = true;
+        }
+        sim_ticks_left--;
+    }
+    sim_time_us += portTICK_RATE_MICROSECONDS;
+    return pdTRUE;
+}
+
+#endif /* if defined(PIOS_INCLUDE_SIM) */
+
+/**
+ * @}
+ */
@@ -26,6 +26,9 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* recvmmsg, sendmmsg */
+#endif
 
 /* Project Includes */
 #include "pios.h"
@@ -71,6 +74,75 @@ static pios_udp_dev *find_udp_dev_by_id(uint8_t udp)
     return &(pios_udp_devices[udp]);
 }
 
+/**
+ * Hand a received datagram to the COM layer
+ */
+static void PIOS_UDP_Received(pios_udp_dev *udp_dev, uint8_t *buffer, uint16_t length)
+{
+    /* we do NOT buffer data locally. If the com buffer can't receive, data is discarded! */
+    /* (thats what the USART driver does too!) */
+    bool rx_need_yield = false;
+
+    if (udp_dev->rx_in_cb) {
+        (void)(udp_dev->rx_in_cb)(udp_dev->rx_in_context, buffer, length, NULL, &rx_need_yield);
+    }
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (rx_need_yield) {
+        vPortYieldFromISR();
+    }
+#endif /* PIOS_INCLUDE_FREERTOS */
+}
+
+#if defined(PIOS_UDP_EVENT_LOOP)
+
+static int pios_udp_epoll = -1;
+#if defined(PIOS_INCLUDE_FREERTOS)
+static xTaskHandle pios_udp_event_thread;
+#else
+static pthread_t pios_udp_event_thread;
+#endif
+
+/**
+ * Event loop of all the UDP ports, each ready socket is drained of up to
+ * PIOS_UDP_BATCH_LENGTH datagrams per system call. The socket is reported
+ * again by the next wait if more are queued.
+ */
+void *PIOS_UDP_EventThread(__attribute__((unused)) void *arg)
+{
+    static uint8_t buffers[PIOS_UDP_BATCH_LENGTH][PIOS_UDP_RX_BUFFER_SIZE];
+    static struct sockaddr_in sources[PIOS_UDP_BATCH_LENGTH];
+    struct mmsghdr messages[PIOS_UDP_BATCH_LENGTH];
+    struct iovec vectors[PIOS_UDP_BATCH_LENGTH];
+    struct epoll_event events[PIOS_UDP_BATCH_LENGTH];
+
+    while (1) {
+        int ready = epoll_wait(pios_udp_epoll, events, PIOS_UDP_BATCH_LENGTH, -1);
+
+        for (int i = 0; i < ready; i++) {
+            pios_udp_dev *udp_dev = (pios_udp_dev *)events[i].data.ptr;
+
+            memset(messages, 0, sizeof(messages));
+            for (int n = 0; n < PIOS_UDP_BATCH_LENGTH; n++) {
+                vectors[n].iov_base = buffers[n];
+                vectors[n].iov_len  = PIOS_UDP_RX_BUFFER_SIZE;
+                messages[n].msg_hdr.msg_iov     = &vectors[n];
+                messages[n].msg_hdr.msg_iovlen  = 1;
+                messages[n].msg_hdr.msg_name    = &sources[n];
+                messages[n].msg_hdr.msg_namelen = sizeof(sources[n]);
+            }
+            int received = recvmmsg(udp_dev->socket, messages, PIOS_UDP_BATCH_LENGTH, MSG_DONTWAIT, NULL);
+            for (int n = 0; n < received; n++) {
+                // answer the last client heard
+                udp_dev->client = sources[n];
+                PIOS_UDP_Received(udp_dev, buffers[n], messages[n].msg_len);
+            }
+        }
+    }
+}
+
+#else /* PIOS_UDP_EVENT_LOOP */
+
 /**
  * RxThread
  */
@@ -94,23 +166,48 @@ void *PIOS_UDP_RxThread(void *udp_dev_n)
                                  0,
                                  (struct sockaddr *)&udp_dev->client,
                                  (socklen_t *)&udp_dev->clientLength)) >= 0) {
-            /* copy received data to buffer if possible */
-            /* we do NOT buffer data locally. If the com buffer can't receive, data is discarded! */
-            /* (thats what the USART driver does too!) */
-            bool rx_need_yield = false;
-            if (udp_dev->rx_in_cb) {
-                (void)(udp_dev->rx_in_cb)(udp_dev->rx_in_context, udp_dev->rx_buffer, received, NULL, &rx_need_yield);
-            }
-
-#if defined(PIOS_INCLUDE_FREERTOS)
-            if (rx_need_yield) {
-                vPortYieldFromISR();
-            }
-#endif /* PIOS_INCLUDE_FREERTOS */
+            PIOS_UDP_Received(udp_dev, udp_dev->rx_buffer, received);
         }
     }
 }
 
+#endif /* PIOS_UDP_EVENT_LOOP */
+
+
+// Added to every configured port, several simulated boards can then share a host
+static uint16_t pios_udp_port_offset;
+
+/**
+ * Set the offset added to the configured ports, call before PIOS_UDP_Init
+ */
+void PIOS_UDP_SetPortOffset(uint16_t offset)
+{
+    pios_udp_port_offset = offset;
+}
+
+// Group the ports configured for it publish to, none when s_addr is INADDR_ANY
+static struct sockaddr_in pios_udp_multicast_group;
+static uint16_t pios_udp_multicast_port;
+
+/**
+ * Publish the ports configured for it to a multicast group instead of
+ * answering the last client, call before PIOS_UDP_Init. The port offset is
+ * added to the group port too.
+ * \return 0 on success, -1 if the group is not a multicast address
+ */
+int32_t PIOS_UDP_SetMulticastGroup(const char *group, uint16_t port)
+{
+    in_addr_t addr = inet_addr(group);
+
+    if (addr == INADDR_NONE || !IN_MULTICAST(ntohl(addr))) {
+        return -1;
+    }
+    memset(&pios_udp_multicast_group, 0, sizeof(pios_udp_multicast_group));
+    pios_udp_multicast_group.sin_family = AF_INET;
+    pios_udp_multicast_group.sin_addr.s_addr = addr;
+    pios_udp_multicast_port = port;
+    return 0;
+}
 
 /**
  * Open UDP socket
@@ -133,9 +230,39 @@ int32_t PIOS_UDP_Init(uint32_t *udp_id, const struct pios_udp_cfg *cfg)
     memset(&udp_dev->client, 0, sizeof(udp_dev->client));
     udp_dev->server.sin_family = AF_INET;
     udp_dev->server.sin_addr.s_addr = inet_addr(udp_dev->cfg->ip);
-    udp_dev->server.sin_port   = htons(udp_dev->cfg->port);
+    udp_dev->server.sin_port   = htons(udp_dev->cfg->port + pios_udp_port_offset);
     int res = bind(udp_dev->socket, (struct sockaddr *)&udp_dev->server, sizeof(udp_dev->server));
 
+    udp_dev->multicast = cfg->multicast && pios_udp_multicast_group.sin_addr.s_addr != INADDR_ANY;
+    if (udp_dev->multicast) {
+        // receivers still reach us on the bound port, only where we send changes
+        udp_dev->group = pios_udp_multicast_group;
+        udp_dev->group.sin_port = htons(pios_udp_multicast_port + pios_udp_port_offset);
+        udp_dev->sequence = 0;
+        unsigned char ttl  = 1;
+        unsigned char loop = 1;
+        setsockopt(udp_dev->socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        setsockopt(udp_dev->socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+    }
+
+#if defined(PIOS_UDP_EVENT_LOOP)
+    /* The first port starts the event thread, the others join it */
+    if (pios_udp_epoll < 0) {
+        pios_udp_epoll = epoll_create1(0);
+#if defined(PIOS_INCLUDE_FREERTOS)
+        xTaskCreate((pdTASK_CODE)PIOS_UDP_EventThread, "UDP_Event_Thread", 1024, NULL, (tskIDLE_PRIORITY + 1), &pios_udp_event_thread);
+#else
+        pthread_create(&pios_udp_event_thread, NULL, PIOS_UDP_EventThread, NULL);
+#endif
+    }
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events   = EPOLLIN;
+    event.data.ptr = udp_dev;
+    if (epoll_ctl(pios_udp_epoll, EPOLL_CTL_ADD, udp_dev->socket, &event) < 0) {
+        res = -1;
+    }
+#else /* PIOS_UDP_EVENT_LOOP */
     /* Create transmit thread for this connection */
 #if defined(PIOS_INCLUDE_FREERTOS)
 // ( pdTASK_CODE pvTaskCode, const portCHAR * const pcName, unsigned portSHORT usStackDepth, void *pvParameters, unsigned portBASE_TYPE uxPriority, xTaskHandle *pvCreatedTask );
@@ -143,6 +270,7 @@ int32_t PIOS_UDP_Init(uint32_t *udp_id, const struct pios_udp_cfg *cfg)
 #else
     pthread_create(&udp_dev->rxThread, NULL, PIOS_UDP_RxThread, (void *)udp_dev);
 #endif
+#endif /* PIOS_UDP_EVENT_LOOP */
 
 
     printf("udp dev %i - socket %i opened - result %i\n", pios_udp_num_devices - 1, udp_dev->socket, res);
@@ -169,33 +297,73 @@ static void PIOS_UDP_RxStart(uint32_t udp_id, uint16_t rx_bytes_avail)
 }
 
 
+/**
+ * Send the first count datagrams of the transmit buffers
+ */
+static void PIOS_UDP_SendBatch(pios_udp_dev *udp_dev, struct sockaddr_in *destination, const int32_t *lengths, int count)
+{
+#if defined(PIOS_UDP_EVENT_LOOP)
+    struct mmsghdr messages[PIOS_UDP_BATCH_LENGTH];
+    struct iovec vectors[PIOS_UDP_BATCH_LENGTH];
+
+    memset(messages, 0, sizeof(messages));
+    for (int n = 0; n < count; n++) {
+        vectors[n].iov_base = udp_dev->tx_buffer[n];
+        vectors[n].iov_len  = lengths[n];
+        messages[n].msg_hdr.msg_iov     = &vectors[n];
+        messages[n].msg_hdr.msg_iovlen  = 1;
+        messages[n].msg_hdr.msg_name    = destination;
+        messages[n].msg_hdr.msg_namelen = sizeof(*destination);
+    }
+    sendmmsg(udp_dev->socket, messages, count, 0);
+#else
+    for (int n = 0; n < count; n++) {
+        sendto(udp_dev->socket, udp_dev->tx_buffer[n], lengths[n], 0,
+               (struct sockaddr *)destination, sizeof(*destination));
+    }
+#endif
+}
+
 static void PIOS_UDP_TxStart(uint32_t udp_id, uint16_t tx_bytes_avail)
 {
     pios_udp_dev *udp_dev = find_udp_dev_by_id(udp_id);
 
     PIOS_Assert(udp_dev);
 
-    int32_t length, len, rem;
+    if (!udp_dev->tx_out_cb) {
+        return;
+    }
 
     /**
-     * we send everything directly whenever notified of data to send (lazy!)
+     * we send everything directly whenever notified of data to send (lazy!),
+     * one datagram per chunk. Published datagrams start with a sequence
+     * number, receivers tell a lost one from it.
      */
-    if (udp_dev->tx_out_cb) {
-        while (tx_bytes_avail > 0) {
+    uint16_t header = udp_dev->multicast ? PIOS_UDP_MULTICAST_SEQUENCE_LENGTH : 0;
+    struct sockaddr_in *destination = udp_dev->multicast ? &udp_dev->group : &udp_dev->client;
+    while (tx_bytes_avail > 0) {
+        int32_t lengths[PIOS_UDP_BATCH_LENGTH];
+        int count = 0;
+
+        while (count < PIOS_UDP_BATCH_LENGTH && tx_bytes_avail > 0) {
             bool tx_need_yield = false;
-            length = (udp_dev->tx_out_cb)(udp_dev->tx_out_context, udp_dev->tx_buffer, PIOS_UDP_RX_BUFFER_SIZE, NULL, &tx_need_yield);
-            rem    = length;
-            while (rem > 0) {
-                len = sendto(udp_dev->socket, udp_dev->tx_buffer + length - rem, rem, 0,
-                             (struct sockaddr *)&udp_dev->client,
-                             sizeof(udp_dev->client));
-                if (len <= 0) {
-                    rem = 0;
-                } else {
-                    rem -= len;
-                }
+            uint8_t *buffer    = udp_dev->tx_buffer[count];
+            int32_t length     = (udp_dev->tx_out_cb)(udp_dev->tx_out_context, buffer + header,
+                                                      PIOS_UDP_RX_BUFFER_SIZE - header, NULL, &tx_need_yield);
+            if (length <= 0) {
+                tx_bytes_avail = 0;
+                break;
             }
-            tx_bytes_avail -= length;
+            if (udp_dev->multicast) {
+                buffer[0] = udp_dev->sequence & 0xff;
+                buffer[1] = udp_dev->sequence >> 8;
+                udp_dev->sequence++;
+            }
+            lengths[count++] = length + header;
+            tx_bytes_avail   = (length < tx_bytes_avail) ? tx_bytes_avail - length : 0;
+        }
+        if (count > 0) {
+            PIOS_UDP_SendBatch(udp_dev, destination, lengths, count);
         }
     }
 }
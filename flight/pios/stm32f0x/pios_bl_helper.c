@@ -43,6 +43,8 @@ uint8_t *PIOS_BL_HELPER_FLASH_If_Read(uint32_t SectorAddress)
 
 #if defined(PIOS_INCLUDE_BL_HELPER_WRITE_SUPPORT)
 
+#define FLASH_PAGE_BYTES 1024
+
 static bool erase_flash(uint32_t startAddress, uint32_t endAddress);
 
 uint8_t PIOS_BL_HELPER_FLASH_Ini()
@@ -62,6 +64,18 @@ uint8_t PIOS_BL_HELPER_FLASH_Start()
     return (success) ? 1 : 0;
 }
 
+bool PIOS_BL_HELPER_FLASH_GetSector(uint32_t address, uint32_t *sector_start, uint32_t *sector_size)
+{
+    *sector_start = address & ~(FLASH_PAGE_BYTES - 1);
+    *sector_size  = FLASH_PAGE_BYTES;
+    return true;
+}
+
+uint8_t PIOS_BL_HELPER_FLASH_EraseSector(uint32_t address)
+{
+    return erase_flash(address & ~(FLASH_PAGE_BYTES - 1), address + 1) ? 1 : 0;
+}
+
 uint8_t PIOS_BL_HELPER_FLASH_Erase_Bootloader()
 {
 /// Bootloader memory space erase
@@ -87,7 +101,7 @@ static bool erase_flash(uint32_t startAddress, uint32_t endAddress)
                 fail = true;
             }
         }
-        pageAddress += 1024;
+        pageAddress += FLASH_PAGE_BYTES;
     }
     return !fail;
 }
@@ -104,6 +118,14 @@ uint32_t PIOS_BL_HELPER_CRC_Memory_Calc()
     return CRC_GetCRC();
 }
 
+uint32_t PIOS_BL_HELPER_CRC_Sector_Calc(uint32_t address, uint32_t size)
+{
+    PIOS_BL_HELPER_CRC_Ini();
+    CRC_ResetDR();
+    CRC_CalcBlockCRC((uint32_t *)address, size >> 2);
+    return CRC_GetCRC();
+}
+
 void PIOS_BL_HELPER_FLASH_Read_Description(uint8_t *array, uint8_t size)
 {
     const struct pios_board_info *bdinfo = &pios_board_info_blob;
@@ -43,10 +43,16 @@ static uint16_t PIOS_DSM_RxInCallback(uint32_t context,
                                       uint16_t *headroom,
                                       bool *need_yield);
 static void PIOS_DSM_Supervisor(uint32_t dsm_id);
+#if defined(PIOS_INCLUDE_FREERTOS)
+static xSemaphoreHandle PIOS_DSM_Get_Semaphore(uint32_t rcvr_id, uint8_t channel);
+#endif
 
 /* Local Variables */
 const struct pios_rcvr_driver pios_dsm_rcvr_driver = {
     .read = PIOS_DSM_Get,
+#if defined(PIOS_INCLUDE_FREERTOS)
+    .get_semaphore = PIOS_DSM_Get_Semaphore,
+#endif
 };
 
 enum pios_dsm_dev_magic {
@@ -70,6 +76,9 @@ struct pios_dsm_dev {
     enum pios_dsm_dev_magic   magic;
     const struct pios_dsm_cfg *cfg;
     struct pios_dsm_state     state;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    xSemaphoreHandle new_frame_semaphore;
+#endif
 };
 
 /* Allocate DSM device descriptor */
@@ -251,10 +260,11 @@ stream_error:
     return -1;
 }
 
-/* Update decoder state processing input byte from the DSMx stream */
-static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
+/* Update decoder state processing input byte from the DSMx stream, true once a frame updated the channels */
+static bool PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
 {
     struct pios_dsm_state *state = &(dsm_dev->state);
+    bool updated = false;
 
     if (state->frame_found) {
         /* receiving the data frame */
@@ -266,6 +276,7 @@ static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
                 if (!PIOS_DSM_UnrollChannels(dsm_dev)) {
                     /* data looking good */
                     state->failsafe_timer = 0;
+                    updated = true;
                 }
 
                 /* prepare for the next frame */
@@ -273,6 +284,8 @@ static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
             }
         }
     }
+
+    return updated;
 }
 
 /* Initialise DSM receiver interface */
@@ -295,6 +308,9 @@ int32_t PIOS_DSM_Init(uint32_t *dsm_id,
 
     /* Bind the configuration to the device instance */
     dsm_dev->cfg = cfg;
+#if defined(PIOS_INCLUDE_FREERTOS)
+    dsm_dev->new_frame_semaphore = NULL;
+#endif
 
     /* Bind the receiver if requested */
     if (bind) {
@@ -328,9 +344,11 @@ static uint16_t PIOS_DSM_RxInCallback(uint32_t context,
 
     PIOS_Assert(valid);
 
+    uint8_t frames = 0;
+
     /* process byte(s) and clear receive timer */
     for (uint8_t i = 0; i < buf_len; i++) {
-        PIOS_DSM_UpdateState(dsm_dev, buf[i]);
+        frames += PIOS_DSM_UpdateState(dsm_dev, buf[i]);
         dsm_dev->state.receive_timer = 0;
     }
 
@@ -339,8 +357,20 @@ static uint16_t PIOS_DSM_RxInCallback(uint32_t context,
         *headroom = DSM_FRAME_LENGTH;
     }
 
-    /* We never need a yield */
-    *need_yield = false;
+    if (frames) {
+        PIOS_LATENCYPROBE_FRAME();
+    }
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+    /* Wake the reader of the channels once per decoded frame */
+    if (frames && dsm_dev->new_frame_semaphore) {
+        signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+        xSemaphoreGiveFromISR(dsm_dev->new_frame_semaphore, &xHigherPriorityTaskWoken);
+        if (xHigherPriorityTaskWoken == pdTRUE) {
+            *need_yield = true;
+        }
+    }
+#endif /* if defined(PIOS_INCLUDE_FREERTOS) */
 
     /* Always indicate that all bytes were consumed */
     return buf_len;
@@ -370,6 +400,31 @@ static int32_t PIOS_DSM_Get(uint32_t rcvr_id, uint8_t channel)
     return dsm_dev->state.channel_data[channel];
 }
 
+#if defined(PIOS_INCLUDE_FREERTOS)
+/**
+ * Get the semaphore given each time a frame has been decoded
+ * \param[in] channel Number of the channel desired (zero based), all share the semaphore
+ * \output NULL channel not available
+ */
+static xSemaphoreHandle PIOS_DSM_Get_Semaphore(uint32_t rcvr_id, uint8_t channel)
+{
+    struct pios_dsm_dev *dsm_dev = (struct pios_dsm_dev *)rcvr_id;
+
+    if (!PIOS_DSM_Validate(dsm_dev)) {
+        return NULL;
+    }
+
+    if (channel >= PIOS_DSM_NUM_INPUTS) {
+        return NULL;
+    }
+
+    if (dsm_dev->new_frame_semaphore == NULL) {
+        vSemaphoreCreateBinary(dsm_dev->new_frame_semaphore);
+    }
+    return dsm_dev->new_frame_semaphore;
+}
+#endif /* if defined(PIOS_INCLUDE_FREERTOS) */
+
 /**
  * Input data supervisor is called periodically and provides
  * two functions: frame syncing and failsafe triggering.
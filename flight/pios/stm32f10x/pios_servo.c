@@ -150,8 +150,10 @@ void PIOS_Servo_SetHz(const uint16_t *speeds, const uint32_t *clock, uint8_t ban
             if (clock[i]) {
                 new_clock = clock[i];
             }
+            // the counters are 16 bit, a bank runs at least at clock / 65536
+            uint32_t period = MIN(new_clock / speeds[i], 0x10000);
             TIM_TimeBaseStructure.TIM_Prescaler = (PIOS_MASTER_CLOCK / new_clock) - 1;
-            TIM_TimeBaseStructure.TIM_Period    = ((new_clock / speeds[i]) - 1);
+            TIM_TimeBaseStructure.TIM_Period    = period - 1;
 
             TIM_TimeBaseInit((TIM_TypeDef *)timer, &TIM_TimeBaseStructure);
         }
@@ -170,6 +172,7 @@ void PIOS_Servo_Set(uint8_t servo, uint16_t position)
         return;
     }
 
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_ACTUATOR, PIOS_LATENCYPROBE_OUTPUT);
 
     /* Update the position */
     const struct pios_tim_channel *chan = &servo_cfg->channels[servo];
@@ -180,6 +183,10 @@ void PIOS_Servo_Set(uint8_t servo, uint16_t position)
     }
 
     uint8_t bank = pios_servo_pin_bank[servo];
+    // DShot needs the update DMA of the F4 driver, keep the pins low
+    if (pios_servo_bank_mode[bank] == PIOS_SERVO_BANK_MODE_DSHOT) {
+        val = 0;
+    }
     if (pios_servo_bank_max_pulse[bank] < val) {
         pios_servo_bank_max_pulse[bank] = val;
     }
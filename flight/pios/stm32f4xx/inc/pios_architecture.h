@@ -35,5 +35,14 @@
 #define PIOS_ADC_STM32_TEMP_AVG_SLOPE 2.5f /* mV/C */
 #define PIOS_CONVERT_VOLT_TO_CPU_TEMP(x) ((x - PIOS_ADC_STM32_TEMP_V25) * 1000.0f / PIOS_ADC_STM32_TEMP_AVG_SLOPE + 25.0f)
 
+// the SPI driver runs queued jobs, see PIOS_SPI_QueueJob()
+#define PIOS_SPI_JOBS
+
+// read-ahead window of the external flash driver, in 256 byte pages
+#define PIOS_FLASH_JEDEC_CACHE_PAGES 4
+
+// the I2C driver completes transfers from its interrupts, see PIOS_I2C_Transfer_Async()
+#define PIOS_I2C_ASYNC
+
 
 #endif /* PIOS_ARCHITECTURE_H */
@@ -189,11 +189,16 @@
 
 /****************** USB OTG FS CONFIGURATION **********************************/
 #ifdef USB_OTG_FS_CORE
+/*
+ * 320 words in total. EP0 and the CDC notification endpoint (2) only ever have one
+ * packet queued, the HID (1) and CDC data (3) endpoints hold 4 and 6 packets so
+ * the core always has the next ones ready while a multi packet transfer runs.
+ */
  #define RX_FIFO_FS_SIZE   128
- #define TX0_FIFO_FS_SIZE  64
- #define TX1_FIFO_FS_SIZE  32
- #define TX2_FIFO_FS_SIZE  32
- #define TX3_FIFO_FS_SIZE  64
+ #define TX0_FIFO_FS_SIZE  16
+ #define TX1_FIFO_FS_SIZE  64
+ #define TX2_FIFO_FS_SIZE  16
+ #define TX3_FIFO_FS_SIZE  96
  #define TXH_NP_HS_FIFOSIZ 96
  #define TXH_P_HS_FIFOSIZ  96
 
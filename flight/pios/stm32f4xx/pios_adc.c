@@ -30,9 +30,10 @@
 
 /*
  * @note This is a stripped-down ADC driver intended primarily for sampling
- * voltage and current values.  Samples are averaged over the period between
- * fetches so that relatively accurate measurements can be obtained without
- * forcing higher-level logic to poll aggressively.
+ * voltage and current values.  The pins are scanned continuously by DMA into
+ * a double buffer. Each buffer flip decimates the block to one mean per pin,
+ * which feeds a first order low pass per pin. Readers get the latest filtered
+ * value without locking or resetting anything, at any rate.
  *
  * @todo This module needs more work to be more generally useful.  It should
  * almost certainly grow callback support so that e.g. voltage and current readings
@@ -65,6 +66,17 @@
 #define PIOS_ADC_NUM_CHANNELS     0
 #endif
 
+#if !defined(PIOS_ADC_BLOCK_SCANS)
+#define PIOS_ADC_BLOCK_SCANS      32 // scans of all pins per DMA buffer, about 170 buffer flips a second with 4 pins
+#endif
+
+#if !defined(PIOS_ADC_FILTER_SHIFT)
+#define PIOS_ADC_FILTER_SHIFT     4 // low pass time constant of 2^shift blocks, about 100ms
+#endif
+
+// Fractional bits of the filtered values
+#define PIOS_ADC_FILTER_FRAC      8
+
 // Private types
 enum pios_adc_dev_magic {
     PIOS_ADC_DEV_MAGIC = 0x58375124,
@@ -105,19 +117,16 @@ struct dma_config {
     uint32_t     channel;
 };
 
-struct adc_accumulator {
-    uint32_t accumulator;
-    uint32_t count;
-};
-
 #if defined(PIOS_INCLUDE_ADC)
 static const struct dma_config config[] = PIOS_DMA_PIN_CONFIG;
 #define PIOS_ADC_NUM_PINS (sizeof(config) / sizeof(config[0]))
 
-static struct adc_accumulator accumulator[PIOS_ADC_NUM_PINS];
+// Filtered pin values with PIOS_ADC_FILTER_FRAC fractional bits, written by the DMA interrupt only
+static volatile uint32_t filtered[PIOS_ADC_NUM_PINS];
+static volatile bool filtered_valid;
 
 // Two buffers here for double buffering
-static uint16_t adc_raw_buffer[2][PIOS_ADC_MAX_SAMPLES][PIOS_ADC_NUM_PINS];
+static uint16_t adc_raw_buffer[2][PIOS_ADC_BLOCK_SCANS][PIOS_ADC_NUM_PINS];
 #endif
 
 #if defined(PIOS_INCLUDE_ADC)
@@ -209,10 +218,13 @@ static void init_adc(void)
 
     /* Configure input scan */
     for (uint32_t i = 0; i < PIOS_ADC_NUM_PINS; i++) {
+        // The longest sampling time: the samples are averaged anyway, the
+        // sensor dividers have a high impedance and the temperature sensor
+        // needs 10us
         ADC_RegularChannelConfig(pios_adc_dev->cfg->adc_dev,
                                  config[i].channel,
                                  i + 1,
-                                 ADC_SampleTime_56Cycles); /* XXX this is totally arbitrary... */
+                                 ADC_SampleTime_480Cycles);
     }
 
     ADC_DMARequestAfterLastTransferCmd(pios_adc_dev->cfg->adc_dev, ENABLE);
@@ -294,31 +306,23 @@ void PIOS_ADC_Config(__attribute__((unused)) uint32_t oversampling)
 /**
  * Returns value of an ADC Pin
  * @param[in] pin number
- * @return ADC pin value averaged over the set of samples since the last reading.
+ * @return ADC pin value, low pass filtered
  * @return -1 if pin doesn't exist
- * @return -2 if no data acquired since last read
+ * @return -2 if no data acquired yet
  */
-int32_t last_conv_value;
 int32_t PIOS_ADC_PinGet(uint32_t pin)
 {
 #if defined(PIOS_INCLUDE_ADC)
-    int32_t result;
-
     /* Check if pin exists */
     if (pin >= PIOS_ADC_NUM_PINS) {
         return -1;
     }
 
-    if (accumulator[pin].accumulator <= 0) {
+    if (!filtered_valid) {
         return -2;
     }
 
-    /* return accumulated result and clear accumulator */
-    result = accumulator[pin].accumulator / (accumulator[pin].count ? : 1);
-    accumulator[pin].accumulator = result;
-    accumulator[pin].count = 1;
-
-    return result;
+    return (filtered[pin] + (1 << (PIOS_ADC_FILTER_FRAC - 1))) >> PIOS_ADC_FILTER_FRAC;
 
 #endif
     return -1;
@@ -326,6 +330,12 @@ int32_t PIOS_ADC_PinGet(uint32_t pin)
 
 float PIOS_ADC_PinGetVolt(uint32_t pin)
 {
+#if defined(PIOS_INCLUDE_ADC)
+    // Keep the resolution gained by the filter
+    if (pin < PIOS_ADC_NUM_PINS && filtered_valid) {
+        return (float)filtered[pin] * (PIOS_ADC_VOLTAGE_SCALE / (1 << PIOS_ADC_FILTER_FRAC));
+    }
+#endif
     return ((float)PIOS_ADC_PinGet(pin)) * PIOS_ADC_VOLTAGE_SCALE;
 }
 
@@ -391,44 +401,31 @@ void PIOS_ADC_SetFIRCoefficients(__attribute__((unused)) float *new_filter)
 }
 
 /**
- * @brief accumulate the data for each of the channels.
+ * @brief decimate a block of scans to one mean per pin and low pass filter it
  */
-void accumulate(uint16_t *buffer, uint32_t count)
+static void decimate(const uint16_t *buffer)
 {
 #if defined(PIOS_INCLUDE_ADC)
-    uint16_t *sp = buffer;
-
-    /*
-     * Accumulate sampled values.
-     */
-    while (count--) {
-        for (uint32_t i = 0; i < PIOS_ADC_NUM_PINS; ++i) {
-            accumulator[i].accumulator += *sp++;
-            accumulator[i].count++;
-            /*
-             * If the accumulator reaches half-full, rescale in order to
-             * make more space.
-             */
-            if (accumulator[i].accumulator >= (((uint32_t)1) << 31)) {
-                accumulator[i].accumulator /= 2;
-                accumulator[i].count /= 2;
-            }
+    uint32_t sum[PIOS_ADC_NUM_PINS] = { 0 };
+    const uint16_t *sp = buffer;
+
+    for (uint32_t n = 0; n < PIOS_ADC_BLOCK_SCANS; n++) {
+        for (uint32_t i = 0; i < PIOS_ADC_NUM_PINS; i++) {
+            sum[i] += *sp++;
         }
     }
 
-#if defined(PIOS_INCLUDE_FREERTOS)
-    // XXX should do something with this
-    if (pios_adc_dev->data_queue) {
-        static portBASE_TYPE xHigherPriorityTaskWoken;
-// xQueueSendFromISR(pios_adc_dev->data_queue, pios_adc_dev->downsampled_buffer, &xHigherPriorityTaskWoken);
-        portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
+    for (uint32_t i = 0; i < PIOS_ADC_NUM_PINS; i++) {
+        int32_t mean = (int32_t)((sum[i] << PIOS_ADC_FILTER_FRAC) / PIOS_ADC_BLOCK_SCANS);
+        if (filtered_valid) {
+            // a single aligned store, readers never see a partial value
+            filtered[i] = (int32_t)filtered[i] + ((mean - (int32_t)filtered[i]) >> PIOS_ADC_FILTER_SHIFT);
+        } else {
+            filtered[i] = mean;
+        }
     }
-
-#endif
+    filtered_valid = true;
 #endif /* if defined(PIOS_INCLUDE_ADC) */
-
-// if(pios_adc_dev->callback_function)
-// pios_adc_dev->callback_function(pios_adc_dev->downsampled_buffer);
 }
 
 /**
@@ -447,9 +444,8 @@ void PIOS_ADC_DMA_Handler(void)
     if (DMA_GetITStatus(pios_adc_dev->cfg->dma.rx.channel, pios_adc_dev->cfg->full_flag)) {
         DMA_ClearITPendingBit(pios_adc_dev->cfg->dma.rx.channel, pios_adc_dev->cfg->full_flag);
 
-        /* accumulate results from the buffer that was just completed */
-        accumulate(&adc_raw_buffer[DMA_GetCurrentMemoryTarget(pios_adc_dev->cfg->dma.rx.channel) ? 0 : 1][0][0],
-                   PIOS_ADC_MAX_SAMPLES);
+        /* filter the buffer that was just completed */
+        decimate(&adc_raw_buffer[DMA_GetCurrentMemoryTarget(pios_adc_dev->cfg->dma.rx.channel) ? 0 : 1][0][0]);
     }
 #endif
 }
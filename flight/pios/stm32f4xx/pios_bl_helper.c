@@ -150,6 +150,18 @@ uint8_t PIOS_BL_HELPER_FLASH_Start()
 }
 
 
+bool PIOS_BL_HELPER_FLASH_GetSector(uint32_t address, uint32_t *sector_start, uint32_t *sector_size)
+{
+    uint8_t sector_number;
+
+    return PIOS_BL_HELPER_FLASH_GetSectorInfo(address, &sector_number, sector_start, sector_size);
+}
+
+uint8_t PIOS_BL_HELPER_FLASH_EraseSector(uint32_t address)
+{
+    return erase_flash(address, address + 1) ? 1 : 0;
+}
+
 uint8_t PIOS_BL_HELPER_FLASH_Erase_Bootloader()
 {
 /// Bootloader memory space erase
@@ -203,6 +215,14 @@ uint32_t PIOS_BL_HELPER_CRC_Memory_Calc()
     return CRC_GetCRC();
 }
 
+uint32_t PIOS_BL_HELPER_CRC_Sector_Calc(uint32_t address, uint32_t size)
+{
+    PIOS_BL_HELPER_CRC_Ini();
+    CRC_ResetDR();
+    CRC_CalcBlockCRC((uint32_t *)address, size >> 2);
+    return CRC_GetCRC();
+}
+
 void PIOS_BL_HELPER_FLASH_Read_Description(uint8_t *array, uint8_t size)
 {
     const struct pios_board_info *bdinfo = &pios_board_info_blob;
@@ -58,6 +58,8 @@ enum i2c_adapter_state {
     I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
     I2C_STATE_R_MORE_TXN_PRE_LAST,
     I2C_STATE_R_MORE_TXN_POST_LAST,
+    I2C_STATE_R_MORE_TXN_DMA,
+    I2C_STATE_R_MORE_TXN_DMA_DONE,
 
     I2C_STATE_R_LAST_TXN_ADDR,
     I2C_STATE_R_LAST_TXN_PRE_ONE,
@@ -65,6 +67,8 @@ enum i2c_adapter_state {
     I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
     I2C_STATE_R_LAST_TXN_PRE_LAST,
     I2C_STATE_R_LAST_TXN_POST_LAST,
+    I2C_STATE_R_LAST_TXN_DMA,
+    I2C_STATE_R_LAST_TXN_DMA_DONE,
 
     I2C_STATE_W_MORE_TXN_ADDR,
     I2C_STATE_W_MORE_TXN_MIDDLE,
@@ -92,12 +96,14 @@ enum i2c_adapter_event {
     I2C_EVENT_ADDR_SENT_LEN_EQ_1,
     I2C_EVENT_ADDR_SENT_LEN_EQ_2,
     I2C_EVENT_ADDR_SENT_LEN_GT_2,
+    I2C_EVENT_ADDR_SENT_DMA,
     I2C_EVENT_TRANSFER_DONE_LEN_EQ_0,
     I2C_EVENT_TRANSFER_DONE_LEN_EQ_1,
     I2C_EVENT_TRANSFER_DONE_LEN_EQ_2,
     I2C_EVENT_TRANSFER_DONE_LEN_GT_2,
     I2C_EVENT_NACK,
     I2C_EVENT_STOPPED,
+    I2C_EVENT_DMA_DONE,
     I2C_EVENT_AUTO, /* FIXME: remove this */
 
     I2C_EVENT_NUM_EVENTS /* Must be last */
@@ -139,6 +145,9 @@ static void go_r_any_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter);
 static void go_r_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter);
 static void go_r_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter);
 static void go_r_any_txn_post_last(struct pios_i2c_adapter *i2c_adapter);
+static void go_r_any_txn_dma(struct pios_i2c_adapter *i2c_adapter);
+static void go_r_more_txn_dma_done(struct pios_i2c_adapter *i2c_adapter);
+static void go_r_last_txn_dma_done(struct pios_i2c_adapter *i2c_adapter);
 
 static void go_w_any_txn_addr(struct pios_i2c_adapter *i2c_adapter);
 static void go_w_any_txn_middle(struct pios_i2c_adapter *i2c_adapter);
@@ -157,6 +166,11 @@ static void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum
 static void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter);
 static bool i2c_adapter_wait_for_stopped(struct pios_i2c_adapter *i2c_adapter);
 static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_dma_stop(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_async_done(struct pios_i2c_adapter *i2c_adapter);
+#ifdef USE_FREERTOS
+static bool i2c_adapter_wait_ready(struct pios_i2c_adapter *i2c_adapter, portTickType timeout);
+#endif
 
 static void i2c_adapter_log_fault(enum pios_i2c_error_type type);
 static bool i2c_adapter_callback_handler(struct pios_i2c_adapter *i2c_adapter);
@@ -213,6 +227,7 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
             [I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_PRE_ONE,
             [I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
             [I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
+            [I2C_EVENT_ADDR_SENT_DMA]      = I2C_STATE_R_MORE_TXN_DMA,
             [I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
         },
     },
@@ -258,6 +273,21 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
         },
     },
 
+    [I2C_STATE_R_MORE_TXN_DMA] =        {
+        .entry_fn   = go_r_any_txn_dma,
+        .next_state =                   {
+            [I2C_EVENT_DMA_DONE]  = I2C_STATE_R_MORE_TXN_DMA_DONE,
+            [I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+        },
+    },
+
+    [I2C_STATE_R_MORE_TXN_DMA_DONE] =   {
+        .entry_fn   = go_r_more_txn_dma_done,
+        .next_state =                   {
+            [I2C_EVENT_AUTO] = I2C_STATE_STARTING,
+        },
+    },
+
     /*
      * Read
      */
@@ -268,6 +298,7 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
             [I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_PRE_ONE,
             [I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
             [I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
+            [I2C_EVENT_ADDR_SENT_DMA]      = I2C_STATE_R_LAST_TXN_DMA,
             [I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
         },
     },
@@ -313,6 +344,21 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
         },
     },
 
+    [I2C_STATE_R_LAST_TXN_DMA] =        {
+        .entry_fn   = go_r_any_txn_dma,
+        .next_state =                   {
+            [I2C_EVENT_DMA_DONE]  = I2C_STATE_R_LAST_TXN_DMA_DONE,
+            [I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+        },
+    },
+
+    [I2C_STATE_R_LAST_TXN_DMA_DONE] =   {
+        .entry_fn   = go_r_last_txn_dma_done,
+        .next_state =                   {
+            [I2C_EVENT_AUTO] = I2C_STATE_STOPPING,
+        },
+    },
+
     /*
      * Write with restart
      */
@@ -417,6 +463,11 @@ static void go_stopping(struct pios_i2c_adapter *i2c_adapter)
 
     I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_EVT | I2C_IT_BUF | I2C_IT_ERR, DISABLE);
 
+    /* Nobody waits on sem_ready, i2c_adapter_async_done() ends the transfer */
+    if (i2c_adapter->async) {
+        return;
+    }
+
 #ifdef USE_FREERTOS
     if (xSemaphoreGiveFromISR(i2c_adapter->sem_ready, &pxHigherPriorityTaskWoken) != pdTRUE) {
 #if defined(I2C_HALT_ON_ERRORS)
@@ -562,6 +613,54 @@ static void go_r_any_txn_post_last(struct pios_i2c_adapter *i2c_adapter)
     i2c_adapter->active_txn++;
 }
 
+/* Common to 'more' and 'last' transaction */
+static void go_r_any_txn_dma(struct pios_i2c_adapter *i2c_adapter)
+{
+    PIOS_DEBUG_Assert(i2c_adapter->cfg->dma);
+    PIOS_DEBUG_Assert(i2c_adapter->active_byte < i2c_adapter->last_byte);
+
+    const struct stm32_dma_chan *rx = &i2c_adapter->cfg->dma->rx;
+    DMA_InitTypeDef dma_init = rx->init;
+
+    /* The stream moves the bytes, only errors and its transfer complete interrupt are left */
+    I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_EVT | I2C_IT_BUF, DISABLE);
+
+    DMA_Cmd(rx->channel, DISABLE);
+    DMA_DeInit(rx->channel);
+    dma_init.DMA_Memory0BaseAddr = (uint32_t)i2c_adapter->active_byte;
+    dma_init.DMA_BufferSize = i2c_adapter->last_byte - i2c_adapter->active_byte + 1;
+    DMA_Init(rx->channel, &dma_init);
+    DMA_ITConfig(rx->channel, DMA_IT_TC, ENABLE);
+    DMA_Cmd(rx->channel, ENABLE);
+
+    /* LAST makes the peripheral NACK the final byte by itself */
+    I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, ENABLE);
+    I2C_DMALastTransferCmd(i2c_adapter->cfg->regs, ENABLE);
+    I2C_DMACmd(i2c_adapter->cfg->regs, ENABLE);
+}
+
+static void go_r_more_txn_dma_done(struct pios_i2c_adapter *i2c_adapter)
+{
+    PIOS_DEBUG_Assert(i2c_adapter->active_txn < i2c_adapter->last_txn);
+
+    /* The restart is generated when entering I2C_STATE_STARTING */
+    i2c_adapter_dma_stop(i2c_adapter);
+
+    i2c_adapter->active_byte = i2c_adapter->last_byte + 1;
+    i2c_adapter->active_txn++;
+}
+
+static void go_r_last_txn_dma_done(struct pios_i2c_adapter *i2c_adapter)
+{
+    PIOS_DEBUG_Assert(i2c_adapter->active_txn == i2c_adapter->last_txn);
+
+    I2C_GenerateSTOP(i2c_adapter->cfg->regs, ENABLE);
+    i2c_adapter_dma_stop(i2c_adapter);
+
+    i2c_adapter->active_byte = i2c_adapter->last_byte + 1;
+    i2c_adapter->active_txn++;
+}
+
 /* Common to 'more' and 'last' transaction */
 static void go_w_any_txn_addr(struct pios_i2c_adapter *i2c_adapter)
 {
@@ -714,6 +813,8 @@ static bool i2c_adapter_wait_for_stopped(struct pios_i2c_adapter *i2c_adapter)
 
 static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
 {
+    i2c_adapter_dma_stop(i2c_adapter);
+
     /* Reset the I2C block */
     I2C_DeInit(i2c_adapter->cfg->regs);
 
@@ -802,6 +903,90 @@ static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
     }
 }
 
+static void i2c_adapter_dma_stop(struct pios_i2c_adapter *i2c_adapter)
+{
+    if (!i2c_adapter->cfg->dma) {
+        return;
+    }
+
+    I2C_DMACmd(i2c_adapter->cfg->regs, DISABLE);
+    I2C_DMALastTransferCmd(i2c_adapter->cfg->regs, DISABLE);
+    DMA_Cmd(i2c_adapter->cfg->dma->rx.channel, DISABLE);
+}
+
+/*
+ * Called at the end of each interrupt, ends an asynchronous transfer once
+ * the FSM has reached I2C_STATE_STOPPING
+ */
+static void i2c_adapter_async_done(struct pios_i2c_adapter *i2c_adapter)
+{
+    PIOS_IRQ_Disable();
+    pios_i2c_callback callback = i2c_adapter->async_callback;
+    if (!callback || i2c_adapter->curr_state != I2C_STATE_STOPPING) {
+        PIOS_IRQ_Enable();
+        return;
+    }
+    i2c_adapter->async_callback = NULL;
+    PIOS_IRQ_Enable();
+
+    if (i2c_adapter_wait_for_stopped(i2c_adapter)) {
+        i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_STOPPED);
+    } else {
+        i2c_adapter_fsm_init(i2c_adapter);
+    }
+
+    int32_t status = i2c_adapter->bus_error ? -1 :
+                     i2c_adapter->nack ? -3 :
+                     0;
+    bool woken     = false;
+
+    callback(status, i2c_adapter->async_context, &woken);
+
+    /* sem_ready, not the bus mutex, is what the next transfer waits on */
+#ifdef USE_FREERTOS
+    signed portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
+
+    xSemaphoreGiveFromISR(i2c_adapter->sem_ready, &xHigherPriorityTaskWoken);
+    portEND_SWITCHING_ISR((woken || xHigherPriorityTaskWoken == pdTRUE) ? pdTRUE : pdFALSE);
+#else
+    PIOS_IRQ_Disable();
+    i2c_adapter->busy = 0;
+    PIOS_IRQ_Enable();
+#endif /* USE_FREERTOS */
+}
+
+#ifdef USE_FREERTOS
+/*
+ * Takes sem_ready before a transfer is started, with the bus mutex held.
+ * An asynchronous transfer keeps sem_ready until its interrupt ends it,
+ * one whose interrupts never came is failed with -2 once this times out.
+ */
+static bool i2c_adapter_wait_ready(struct pios_i2c_adapter *i2c_adapter, portTickType timeout)
+{
+    if (xSemaphoreTake(i2c_adapter->sem_ready, timeout) == pdTRUE) {
+        return true;
+    }
+
+    PIOS_IRQ_Disable();
+    pios_i2c_callback callback = i2c_adapter->async_callback;
+    i2c_adapter->async_callback = NULL;
+    PIOS_IRQ_Enable();
+
+    if (!callback) {
+        /* Ended by its interrupt in the meantime, or not asynchronous at all */
+        return xSemaphoreTake(i2c_adapter->sem_ready, 0) == pdTRUE;
+    }
+
+    /* sem_ready was never given back, it now belongs to the caller */
+    i2c_adapter_fsm_init(i2c_adapter);
+    i2c_timeout_counter++;
+
+    bool woken = false;
+    callback(-2, i2c_adapter->async_context, &woken);
+
+    return true;
+}
+#endif /* USE_FREERTOS */
 
 /* Return true if the FSM is in a terminal state */
 static bool i2c_adapter_fsm_terminated(struct pios_i2c_adapter *i2c_adapter)
@@ -997,6 +1182,9 @@ int32_t PIOS_I2C_Init(uint32_t *i2c_id, const struct pios_i2c_adapter_cfg *cfg)
     i2c_adapter->busy     = 0;
 #endif // USE_FREERTOS
 
+    i2c_adapter->async = false;
+    i2c_adapter->async_callback = NULL;
+
     /* Initialize the state machine */
     i2c_adapter_fsm_init(i2c_adapter);
 
@@ -1005,7 +1193,9 @@ int32_t PIOS_I2C_Init(uint32_t *i2c_id, const struct pios_i2c_adapter_cfg *cfg)
     /* Configure and enable I2C interrupts */
     NVIC_Init((NVIC_InitTypeDef *)&(i2c_adapter->cfg->event.init));
     NVIC_Init((NVIC_InitTypeDef *)&(i2c_adapter->cfg->error.init));
-
+    if (i2c_adapter->cfg->dma) {
+        NVIC_Init((NVIC_InitTypeDef *)&(i2c_adapter->cfg->dma->irq.init));
+    }
 
     /* No error */
     return 0;
@@ -1052,7 +1242,7 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
 
 #ifdef USE_FREERTOS
     /* Make sure the done/ready semaphore is consumed before we start */
-    semaphore_success &= (xSemaphoreTake(i2c_adapter->sem_ready, timeout) == pdTRUE);
+    semaphore_success &= i2c_adapter_wait_ready(i2c_adapter, timeout);
 #endif
 
     // Estimate bytes of transmission. Per txns: 1 adress byte + length
@@ -1064,6 +1254,7 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
     i2c_adapter->transfer_timeout_ticks <<= 3;
 
     i2c_adapter->callback  = NULL;
+    i2c_adapter->async     = false;
     i2c_adapter->bus_error = false;
     i2c_adapter->nack = false;
     i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START);
@@ -1148,7 +1339,7 @@ int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn tx
 
 #ifdef USE_FREERTOS
     /* Make sure the done/ready semaphore is consumed before we start */
-    semaphore_success &= (xSemaphoreTake(i2c_adapter->sem_ready, timeout) == pdTRUE);
+    semaphore_success &= i2c_adapter_wait_ready(i2c_adapter, timeout);
 #endif
 
     // used in the i2c_adapter_callback_handler function
@@ -1161,12 +1352,80 @@ int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn tx
     i2c_adapter->transfer_timeout_ticks <<= 3;
 
     i2c_adapter->callback  = callback;
+    i2c_adapter->async     = false;
     i2c_adapter->bus_error = false;
     i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START);
 
     return !semaphore_success ? -2 : 0;
 }
 
+/**
+ * Starts a transfer and returns at once, the callback is called from the
+ * interrupt that ends it. The bus mutex is only held while the transfer is
+ * started, the next caller then waits on sem_ready like for a previous
+ * blocking transfer. Must be called from a task.
+ * \param[in] txn_list the transactions, they and their buffers must stay valid and out of CCM until the callback
+ * \return 0 if the transfer was started, -1 on a bad adapter, -2 if the bus stayed busy
+ */
+int32_t PIOS_I2C_Transfer_Async(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, pios_i2c_callback callback, void *context)
+{
+    struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+    if (!PIOS_I2C_validate(i2c_adapter)) {
+        return -1;
+    }
+
+    PIOS_Assert(callback);
+
+    PIOS_DEBUG_Assert(txn_list);
+    PIOS_DEBUG_Assert(num_txns);
+
+#ifdef USE_FREERTOS
+    /* Lock the bus */
+    portTickType timeout;
+    timeout = i2c_adapter->cfg->transfer_timeout_ms / portTICK_RATE_MS;
+    if (xSemaphoreTake(i2c_adapter->sem_busy, timeout) == pdFALSE) {
+        return -2;
+    }
+
+    /* Wait for the previous transfer, i2c_adapter_async_done() gives sem_ready back for this one */
+    if (!i2c_adapter_wait_ready(i2c_adapter, timeout)) {
+        xSemaphoreGive(i2c_adapter->sem_busy);
+        i2c_timeout_counter++;
+        return -2;
+    }
+#else
+    PIOS_IRQ_Disable();
+    if (i2c_adapter->busy) {
+        PIOS_IRQ_Enable();
+        return -2;
+    }
+    i2c_adapter->busy = 1;
+    PIOS_IRQ_Enable();
+#endif /* USE_FREERTOS */
+
+    PIOS_DEBUG_Assert(i2c_adapter->curr_state == I2C_STATE_STOPPED);
+
+    i2c_adapter->first_txn  = &txn_list[0];
+    i2c_adapter->last_txn   = &txn_list[num_txns - 1];
+    i2c_adapter->active_txn = i2c_adapter->first_txn;
+
+    i2c_adapter->callback       = NULL;
+    i2c_adapter->async          = true;
+    i2c_adapter->async_context  = context;
+    i2c_adapter->async_callback = callback;
+    i2c_adapter->bus_error = false;
+    i2c_adapter->nack = false;
+    i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START);
+
+#ifdef USE_FREERTOS
+    /* Unlock the bus, the transfer keeps sem_ready until it ends */
+    xSemaphoreGive(i2c_adapter->sem_busy);
+#endif /* USE_FREERTOS */
+
+    return 0;
+}
+
 void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 {
     struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
@@ -1231,6 +1490,11 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
         break;
     case I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED: /* EV6 */
     case I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED: /* EV6 */
+        if (i2c_adapter->cfg->dma && i2c_adapter->active_txn->rw == PIOS_I2C_TXN_READ &&
+            i2c_adapter->last_byte - i2c_adapter->active_byte + 1 >= 2) {
+            i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_DMA);
+            break;
+        }
         switch (i2c_adapter->last_byte - i2c_adapter->active_byte + 1) {
         case 0:
             i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_0);
@@ -1296,7 +1560,7 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
     }
 
 skip_event:
-    ;
+    i2c_adapter_async_done(i2c_adapter);
 }
 
 
@@ -1327,6 +1591,31 @@ void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id)
         /* Fail hard on any errors for now */
         i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_BUS_ERROR);
     }
+
+    i2c_adapter_async_done(i2c_adapter);
+}
+
+void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id)
+{
+    struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+    if (!PIOS_I2C_validate(i2c_adapter) || !i2c_adapter->cfg->dma) {
+        return;
+    }
+
+    DMA_ClearFlag(i2c_adapter->cfg->dma->rx.channel, i2c_adapter->cfg->dma->irq.flags);
+
+    switch (i2c_adapter->curr_state) {
+    case I2C_STATE_R_MORE_TXN_DMA:
+    case I2C_STATE_R_LAST_TXN_DMA:
+        i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_DMA_DONE);
+        break;
+    default:
+        /* Late completion of a stream stopped by a bus error */
+        break;
+    }
+
+    i2c_adapter_async_done(i2c_adapter);
 }
 
 #endif /* PIOS_INCLUDE_I2C */
@@ -321,6 +321,7 @@ static void PIOS_PPM_tim_edge_cb(__attribute__((unused)) uint32_t tim_id, uint32
                  i < PIOS_PPM_IN_MAX_NUM_CHANNELS; i++) {
                 ppm_dev->CaptureValue[i] = PIOS_RCVR_TIMEOUT;
             }
+            PIOS_LATENCYPROBE_FRAME();
 #if defined(PIOS_INCLUDE_FREERTOS)
             /* Signal that a new sample is ready on this channel. */
             if (ppm_dev->new_sample_semaphores[chan_idx] != 0) {
@@ -52,6 +52,29 @@ static uint8_t *pios_servo_pin_bank;
 
 #define PIOS_SERVO_TIMER_CLOCK 1000000
 #define PIOS_SERVO_SAFE_MARGIN 50
+
+// DShot bit timing in timer ticks, the timer runs at 20 ticks per bit
+#define PIOS_SERVO_DSHOT_BIT_TICKS 20
+#define PIOS_SERVO_DSHOT_T0H       7
+#define PIOS_SERVO_DSHOT_T1H       14
+// 1 to 47 are ESC commands (beep, spin direction, save settings...), never sent as throttle
+#define PIOS_SERVO_DSHOT_MIN       48
+#define PIOS_SERVO_DSHOT_MAX       2047
+// 16 bits of the frame and two low periods that leave the line idle
+#define PIOS_SERVO_DSHOT_BITS      16
+#define PIOS_SERVO_DSHOT_SLOTS     (PIOS_SERVO_DSHOT_BITS + 2)
+
+// DMA burst of one bank, CCR values [PIOS_SERVO_DSHOT_SLOTS][channels]
+struct pios_servo_dshot_bank {
+    const struct pios_tim_burst_dma *dma;
+    uint32_t *buffer;
+    uint8_t  first;
+    uint8_t  channels;
+};
+static struct pios_servo_dshot_bank pios_servo_dshot[PIOS_SERVO_BANKS];
+
+static void PIOS_Servo_DShotInitBank(uint8_t bank);
+static void PIOS_Servo_DShotSet(uint8_t bank, const struct pios_tim_channel *chan, uint16_t value);
 /**
  * Initialise Servos
  */
@@ -119,6 +142,9 @@ int32_t PIOS_Servo_Init(const struct pios_servo_cfg *cfg)
 void PIOS_Servo_SetBankMode(uint8_t bank, uint8_t mode)
 {
     PIOS_Assert(bank < PIOS_SERVO_BANKS);
+    if (pios_servo_bank_mode[bank] == PIOS_SERVO_BANK_MODE_DSHOT && pios_servo_dshot[bank].dma) {
+        PIOS_TIM_StopBurstDMA(pios_servo_dshot[bank].dma);
+    }
     pios_servo_bank_mode[bank] = mode;
 
     if (pios_servo_bank_timer[bank]) {
@@ -143,17 +169,109 @@ void PIOS_Servo_SetBankMode(uint8_t bank, uint8_t mode)
             }
         }
 
+        if (mode == PIOS_SERVO_BANK_MODE_DSHOT) {
+            PIOS_Servo_DShotInitBank(bank);
+        }
+
         // Setup the timer accordingly
         TIM_SelectOnePulseMode(pios_servo_bank_timer[bank], TIM_OPMode_Repetitive);
         TIM_Cmd(pios_servo_bank_timer[bank], ENABLE);
     }
 }
 
+/**
+ * Find the update DMA stream of the bank timer and set up the burst over the
+ * CCRs of its pins. Without a stream the compares stay 0 and the pins low.
+ */
+static void PIOS_Servo_DShotInitBank(uint8_t bank)
+{
+    struct pios_servo_dshot_bank *dshot = &pios_servo_dshot[bank];
+
+    dshot->dma = NULL;
+    for (uint8_t i = 0; i < servo_cfg->num_dshot_dma; i++) {
+        if (servo_cfg->dshot_dma[i].timer == pios_servo_bank_timer[bank]) {
+            dshot->dma = &servo_cfg->dshot_dma[i];
+        }
+    }
+
+    uint8_t first = 3;
+    uint8_t last  = 0;
+    for (uint8_t i = 0; i < servo_cfg->num_channels; i++) {
+        if (pios_servo_pin_bank[i] == bank) {
+            // TIM_Channel_x is 4 times the CCR index
+            uint8_t ccr = servo_cfg->channels[i].timer_chan >> 2;
+            first = MIN(first, ccr);
+            last  = MAX(last, ccr);
+
+            // the PWM positions are far above the DShot period, idle low until the first frame
+            const struct pios_tim_channel *chan = &servo_cfg->channels[i];
+            switch (chan->timer_chan) {
+            case TIM_Channel_1:
+                TIM_SetCompare1(chan->timer, 0);
+                break;
+            case TIM_Channel_2:
+                TIM_SetCompare2(chan->timer, 0);
+                break;
+            case TIM_Channel_3:
+                TIM_SetCompare3(chan->timer, 0);
+                break;
+            case TIM_Channel_4:
+                TIM_SetCompare4(chan->timer, 0);
+                break;
+            }
+        }
+    }
+
+    if (!dshot->dma) {
+        return;
+    }
+    if (!dshot->buffer) {
+        dshot->buffer = pios_malloc(PIOS_SERVO_DSHOT_SLOTS * 4 * sizeof(uint32_t));
+        PIOS_Assert(dshot->buffer);
+    }
+    dshot->first    = first;
+    dshot->channels = last - first + 1;
+    memset(dshot->buffer, 0, PIOS_SERVO_DSHOT_SLOTS * dshot->channels * sizeof(uint32_t));
+    PIOS_TIM_InitBurstDMA(dshot->dma, dshot->first, dshot->channels, dshot->buffer, PIOS_SERVO_DSHOT_SLOTS * dshot->channels);
+}
+
+/**
+ * Encode a value in the bank buffer: 11 bits value, no telemetry
+ * request and the 4 bit checksum, most significant bit first.
+ * Zero disarms, any other value is a throttle of 48 to 2047.
+ */
+static void PIOS_Servo_DShotSet(uint8_t bank, const struct pios_tim_channel *chan, uint16_t value)
+{
+    struct pios_servo_dshot_bank *dshot = &pios_servo_dshot[bank];
+
+    // don't touch a frame that is going out
+    if (!dshot->dma || PIOS_TIM_BurstDMABusy(dshot->dma)) {
+        return;
+    }
+
+    if (value) {
+        value = MAX(MIN(value, PIOS_SERVO_DSHOT_MAX), PIOS_SERVO_DSHOT_MIN);
+    }
+    uint16_t packet = value << 1;
+    packet = (packet << 4) | ((packet ^ (packet >> 4) ^ (packet >> 8)) & 0x0f);
+
+    uint32_t *slot = &dshot->buffer[(chan->timer_chan >> 2) - dshot->first];
+    for (uint8_t b = 0; b < PIOS_SERVO_DSHOT_BITS; b++) {
+        *slot   = (packet & 0x8000) ? PIOS_SERVO_DSHOT_T1H : PIOS_SERVO_DSHOT_T0H;
+        packet <<= 1;
+        slot   += dshot->channels;
+    }
+}
+
 
 void PIOS_Servo_Update()
 {
     for (uint8_t i = 0; (i < PIOS_SERVO_BANKS); i++) {
         const TIM_TypeDef *timer = pios_servo_bank_timer[i];
+        if (timer && pios_servo_bank_mode[i] == PIOS_SERVO_BANK_MODE_DSHOT && pios_servo_dshot[i].dma) {
+            // skipped if the last frame is still going out
+            PIOS_TIM_StartBurstDMA(pios_servo_dshot[i].dma, PIOS_SERVO_DSHOT_SLOTS * pios_servo_dshot[i].channels);
+        }
         if (timer && pios_servo_bank_mode[i] == PIOS_SERVO_BANK_MODE_SINGLE_PULSE) {
             // a pulse to be generated is longer than cycle period. skip this update.
             if (TIM_GetCounter((TIM_TypeDef *)timer) > (uint32_t)(pios_servo_bank_next_update[i] + PIOS_SERVO_SAFE_MARGIN)) {
@@ -190,7 +308,7 @@ void PIOS_Servo_Update()
 /**
  * Set the servo update rate (Max 500Hz)
  * \param[in] array of rates in Hz
- * \param[in] array of timer clocks in Hz
+ * \param[in] array of timer clocks in Hz, the bit rate for DShot banks
  * \param[in] maximum number of banks
  */
 void PIOS_Servo_SetHz(const uint16_t *speeds, const uint32_t *clock, uint8_t banks)
@@ -208,16 +326,27 @@ void PIOS_Servo_SetHz(const uint16_t *speeds, const uint32_t *clock, uint8_t ban
         const TIM_TypeDef *timer = pios_servo_bank_timer[i];
         if (timer) {
             uint32_t new_clock = PIOS_SERVO_TIMER_CLOCK;
+            uint32_t period;
             if (clock[i]) {
                 new_clock = clock[i];
             }
+            if (pios_servo_bank_mode[i] == PIOS_SERVO_BANK_MODE_DSHOT) {
+                period     = PIOS_SERVO_DSHOT_BIT_TICKS;
+                new_clock *= PIOS_SERVO_DSHOT_BIT_TICKS;
+            } else {
+                period     = new_clock / speeds[i];
+                // only TIM2 and TIM5 have a 32 bit counter, the others run at least at clock / 65536
+                if (timer != TIM2 && timer != TIM5 && period > 0x10000) {
+                    period = 0x10000;
+                }
+            }
             // Choose the correct prescaler value for the APB the timer is attached
             if (timer == TIM1 || timer == TIM8 || timer == TIM9 || timer == TIM10 || timer == TIM11) {
                 TIM_TimeBaseStructure.TIM_Prescaler = (PIOS_PERIPHERAL_APB2_CLOCK / new_clock) - 1;
             } else {
                 TIM_TimeBaseStructure.TIM_Prescaler = (PIOS_PERIPHERAL_APB1_CLOCK / new_clock) - 1;
             }
-            TIM_TimeBaseStructure.TIM_Period = ((new_clock / speeds[i]) - 1);
+            TIM_TimeBaseStructure.TIM_Period = period - 1;
             TIM_TimeBaseInit((TIM_TypeDef *)timer, &TIM_TimeBaseStructure);
         }
     }
@@ -235,16 +364,22 @@ void PIOS_Servo_Set(uint8_t servo, uint16_t position)
         return;
     }
 
+    PIOS_LATENCYPROBE_PASS(PIOS_LATENCYPROBE_ACTUATOR, PIOS_LATENCYPROBE_OUTPUT);
 
     /* Update the position */
     const struct pios_tim_channel *chan = &servo_cfg->channels[servo];
+    uint8_t bank = pios_servo_pin_bank[servo];
+    if (pios_servo_bank_mode[bank] == PIOS_SERVO_BANK_MODE_DSHOT) {
+        PIOS_Servo_DShotSet(bank, chan, position);
+        return;
+    }
+
     uint16_t val    = position;
     uint16_t margin = chan->timer->ARR / 50; // Leave 2% of period as margin to prevent overlaps
     if (val > (chan->timer->ARR - margin)) {
         val = chan->timer->ARR - margin;
     }
 
-    uint8_t bank = pios_servo_pin_bank[servo];
     if (pios_servo_bank_max_pulse[bank] < val) {
         pios_servo_bank_max_pulse[bank] = val;
     }
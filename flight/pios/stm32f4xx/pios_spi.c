@@ -35,6 +35,12 @@
 /*
  * @todo	Clocking is wrong (interface is badly defined, should be speed not prescaler magic numbers)
  * @todo	DMA doesn't work.  Fix it.
+ *
+ * Besides the blocking calls, drivers can queue jobs with PIOS_SPI_QueueJob().
+ * A job selects a slave, runs a list of DMA transfers at its own clock speed
+ * and ends with a callback from the DMA interrupt, the next job is started
+ * from there. Queued jobs own the bus semaphore while they run, so blocking
+ * users and jobs share the bus without knowing about each other.
  */
 #include <pios.h>
 
@@ -44,6 +50,9 @@
 
 #define SPI_MAX_BLOCK_PIO 128
 
+static void SPI_JobsRun(struct pios_spi_dev *spi_dev, bool *woken);
+static void SPI_JobTransferDone(struct pios_spi_dev *spi_dev, bool *woken);
+
 static bool PIOS_SPI_validate(__attribute__((unused)) struct pios_spi_dev *com_dev)
 {
     /* Should check device magic here */
@@ -98,6 +107,13 @@ int32_t PIOS_SPI_Init(uint32_t *spi_id, const struct pios_spi_cfg *cfg)
     /* Disable callback function */
     spi_dev->callback = NULL;
 
+    /* No queued jobs */
+    spi_dev->job = NULL;
+    for (uint8_t prio = 0; prio < PIOS_SPI_PRIORITY_NUM; prio++) {
+        spi_dev->job_head[prio] = NULL;
+        spi_dev->job_tail[prio] = NULL;
+    }
+
     /* Set rx/tx dummy bytes to a known value */
     spi_dev->rx_dummy_byte = 0xFF;
     spi_dev->tx_dummy_byte = 0xFF;
@@ -335,6 +351,13 @@ int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id)
     spi_dev->busy = 0;
     PIOS_IRQ_Enable();
 #endif
+
+    /* Jobs queued while the bus was claimed go now, a task waiting for the bus
+     * gets it once the queue is empty */
+    bool woken = false;
+    PIOS_IRQ_Disable();
+    SPI_JobsRun(spi_dev, &woken);
+    PIOS_IRQ_Enable();
     return 0;
 }
 
@@ -358,6 +381,11 @@ int32_t PIOS_SPI_ReleaseBusISR(uint32_t spi_id, bool *woken)
     if (woken) {
         *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
     }
+
+    bool jobs_woken = false;
+    PIOS_IRQ_Disable();
+    SPI_JobsRun(spi_dev, &jobs_woken);
+    PIOS_IRQ_Enable();
     return 0;
 
 #else
@@ -444,36 +472,14 @@ int32_t PIOS_SPI_TransferByte(uint32_t spi_id, uint8_t b)
 }
 
 /**
- * Transfers a block of bytes via DMA.
- * \param[in] spi SPI number (0 or 1)
- * \param[in] send_buffer pointer to buffer which should be sent.<BR>
- * If NULL, 0xff (all-one) will be sent.
- * \param[in] receive_buffer pointer to buffer which should get the received values.<BR>
- * If NULL, received bytes will be discarded.
- * \param[in] len number of bytes which should be transfered
- * \param[in] callback pointer to callback function which will be executed
- * from DMA channel interrupt once the transfer is finished.
- * If NULL, no callback function will be used, and PIOS_SPI_TransferBlock() will
- * block until the transfer is finished.
- * \return >= 0 if no error during transfer
- * \return -1 if disabled SPI port selected
- * \return -3 if function has been called during an ongoing DMA transfer
+ * Set up both DMA streams for a transfer and start it
+ * \param[in] init SPI configuration for this transfer
+ * \param[in] irq enable the transfer complete interrupt
  */
-static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, void *callback)
+static void SPI_DMA_Start(struct pios_spi_dev *spi_dev, const SPI_InitTypeDef *init, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, bool irq)
 {
-    struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
-
-    bool valid = PIOS_SPI_validate(spi_dev);
-
-    PIOS_Assert(valid)
-
     DMA_InitTypeDef dma_init;
 
-    /* Exit if ongoing transfer */
-    if (DMA_GetCurrDataCounter(spi_dev->cfg->dma.rx.channel)) {
-        return -3;
-    }
-
     /* Disable the DMA channels */
     DMA_Cmd(spi_dev->cfg->dma.rx.channel, DISABLE);
     DMA_Cmd(spi_dev->cfg->dma.tx.channel, DISABLE);
@@ -488,7 +494,7 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
     /* Disable the SPI peripheral */
     /* Initialize the SPI block */
     SPI_DeInit(spi_dev->cfg->regs);
-    SPI_Init(spi_dev->cfg->regs, (SPI_InitTypeDef *)&(spi_dev->cfg->init));
+    SPI_Init(spi_dev->cfg->regs, (SPI_InitTypeDef *)init);
     SPI_Cmd(spi_dev->cfg->regs, DISABLE);
     /* Configure CRC calculation */
     if (spi_dev->cfg->use_crc) {
@@ -500,9 +506,6 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
     /* Enable SPI interrupts to DMA */
     SPI_I2S_DMACmd(spi_dev->cfg->regs, SPI_I2S_DMAReq_Tx | SPI_I2S_DMAReq_Rx, ENABLE);
 
-    /* Set callback function */
-    spi_dev->callback = callback;
-
     /*
      * Configure Rx channel
      */
@@ -555,8 +558,8 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
 
     DMA_Init(spi_dev->cfg->dma.tx.channel, &(dma_init));
 
-    /* Enable DMA interrupt if callback function active */
-    DMA_ITConfig(spi_dev->cfg->dma.rx.channel, DMA_IT_TC, (callback != NULL) ? ENABLE : DISABLE);
+    /* Enable DMA interrupt if the end of the transfer is handled there */
+    DMA_ITConfig(spi_dev->cfg->dma.rx.channel, DMA_IT_TC, irq ? ENABLE : DISABLE);
 
     /* Flush out the CRC registers */
     SPI_CalculateCRC(spi_dev->cfg->regs, DISABLE);
@@ -577,6 +580,41 @@ static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer
 
     /* Reenable the SPI device */
     SPI_Cmd(spi_dev->cfg->regs, ENABLE);
+}
+
+/**
+ * Transfers a block of bytes via DMA.
+ * \param[in] spi SPI number (0 or 1)
+ * \param[in] send_buffer pointer to buffer which should be sent.<BR>
+ * If NULL, 0xff (all-one) will be sent.
+ * \param[in] receive_buffer pointer to buffer which should get the received values.<BR>
+ * If NULL, received bytes will be discarded.
+ * \param[in] len number of bytes which should be transfered
+ * \param[in] callback pointer to callback function which will be executed
+ * from DMA channel interrupt once the transfer is finished.
+ * If NULL, no callback function will be used, and PIOS_SPI_TransferBlock() will
+ * block until the transfer is finished.
+ * \return >= 0 if no error during transfer
+ * \return -1 if disabled SPI port selected
+ * \return -3 if function has been called during an ongoing DMA transfer
+ */
+static int32_t SPI_DMA_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, void *callback)
+{
+    struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
+
+    bool valid = PIOS_SPI_validate(spi_dev);
+
+    PIOS_Assert(valid)
+
+    /* Exit if ongoing transfer */
+    if (DMA_GetCurrDataCounter(spi_dev->cfg->dma.rx.channel)) {
+        return -3;
+    }
+
+    /* Set callback function */
+    spi_dev->callback = callback;
+
+    SPI_DMA_Start(spi_dev, &spi_dev->cfg->init, send_buffer, receive_buffer, len, callback != NULL);
 
     if (callback) {
         /* User has requested a callback, don't wait for the transfer to complete. */
@@ -718,8 +756,9 @@ int32_t PIOS_SPI_Busy(uint32_t spi_id)
 
     PIOS_Assert(valid)
 
-    /* DMA buffer has data or SPI transmit register not empty or SPI is busy*/
-    if (DMA_GetCurrDataCounter(spi_dev->cfg->dma.rx.channel) ||
+    /* Job running, DMA buffer has data or SPI transmit register not empty or SPI is busy*/
+    if (spi_dev->job ||
+        DMA_GetCurrDataCounter(spi_dev->cfg->dma.rx.channel) ||
         !SPI_I2S_GetFlagStatus(spi_dev->cfg->regs, SPI_I2S_FLAG_TXE) ||
         SPI_I2S_GetFlagStatus(spi_dev->cfg->regs, SPI_I2S_FLAG_BSY)) {
         return -3;
@@ -728,6 +767,173 @@ int32_t PIOS_SPI_Busy(uint32_t spi_id)
     return 0;
 }
 
+/**
+ * Take the bus for the jobs, interrupts must be disabled
+ */
+static bool SPI_JobClaimBus(struct pios_spi_dev *spi_dev, bool *woken)
+{
+#if defined(PIOS_INCLUDE_FREERTOS)
+    signed portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+
+    if (xSemaphoreTakeFromISR(spi_dev->busy, &higherPriorityTaskWoken) != pdTRUE) {
+        return false;
+    }
+    *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
+#else
+    (void)woken;
+    if (spi_dev->busy) {
+        return false;
+    }
+    spi_dev->busy = 1;
+#endif
+    return true;
+}
+
+/**
+ * Give the bus back once the queue is empty, interrupts must be disabled
+ */
+static void SPI_JobReleaseBus(struct pios_spi_dev *spi_dev, bool *woken)
+{
+    /* blocking users which do not set the clock expect the configured one */
+    SPI_Init(spi_dev->cfg->regs, (SPI_InitTypeDef *)&(spi_dev->cfg->init));
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+    signed portBASE_TYPE higherPriorityTaskWoken = pdFALSE;
+
+    xSemaphoreGiveFromISR(spi_dev->busy, &higherPriorityTaskWoken);
+    *woken = *woken || (higherPriorityTaskWoken == pdTRUE);
+#else
+    (void)woken;
+    spi_dev->busy = 0;
+#endif
+}
+
+/**
+ * Start the current transfer of the current job
+ */
+static void SPI_JobStartTransfer(struct pios_spi_dev *spi_dev)
+{
+    const struct pios_spi_job *job = spi_dev->job;
+    const struct pios_spi_transfer *transfer = &job->transfers[spi_dev->job_transfer];
+    SPI_InitTypeDef init = spi_dev->cfg->init;
+
+    init.SPI_BaudRatePrescaler = ((uint16_t)job->prescaler & 7) << 3;
+    SPI_DMA_Start(spi_dev, &init, transfer->send_buffer, transfer->receive_buffer, transfer->len, true);
+}
+
+/**
+ * Start the first job of the most urgent non empty queue, or release the bus
+ * if there is none. The jobs must own the bus and interrupts must be disabled.
+ */
+static void SPI_JobStartNext(struct pios_spi_dev *spi_dev, bool *woken)
+{
+    for (uint8_t prio = 0; prio < PIOS_SPI_PRIORITY_NUM; prio++) {
+        struct pios_spi_job *job = spi_dev->job_head[prio];
+        if (job) {
+            spi_dev->job_head[prio] = job->next;
+            job->next = NULL;
+            spi_dev->job = job;
+            spi_dev->job_transfer = 0;
+            PIOS_SPI_RC_PinSet((uint32_t)spi_dev, job->slave_id, 0);
+            SPI_JobStartTransfer(spi_dev);
+            return;
+        }
+    }
+    SPI_JobReleaseBus(spi_dev, woken);
+}
+
+/**
+ * Start the queued jobs unless they are running already or the bus is claimed,
+ * interrupts must be disabled
+ */
+static void SPI_JobsRun(struct pios_spi_dev *spi_dev, bool *woken)
+{
+    if (spi_dev->job) {
+        return;
+    }
+    for (uint8_t prio = 0; prio < PIOS_SPI_PRIORITY_NUM; prio++) {
+        if (spi_dev->job_head[prio]) {
+            /* when the bus is claimed the jobs start from its release */
+            if (SPI_JobClaimBus(spi_dev, woken)) {
+                SPI_JobStartNext(spi_dev, woken);
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * End of a DMA transfer of the current job: chain the next transfer of the job,
+ * or complete it and chain the next job
+ */
+static void SPI_JobTransferDone(struct pios_spi_dev *spi_dev, bool *woken)
+{
+    struct pios_spi_job *job = spi_dev->job;
+    int32_t status = 0;
+
+    if (spi_dev->cfg->use_crc && SPI_I2S_GetFlagStatus(spi_dev->cfg->regs, SPI_FLAG_CRCERR)) {
+        SPI_I2S_ClearFlag(spi_dev->cfg->regs, SPI_FLAG_CRCERR);
+        status = -4;
+    }
+
+    if (status == 0 && ++spi_dev->job_transfer < job->num_transfers) {
+        SPI_JobStartTransfer(spi_dev);
+        return;
+    }
+
+    PIOS_SPI_RC_PinSet((uint32_t)spi_dev, job->slave_id, 1);
+    spi_dev->job = NULL;
+    job->queued  = false;
+    /* the callback may queue the job again, it is then picked up below with the others */
+    if (job->callback) {
+        job->callback(job, status, woken);
+    }
+
+    PIOS_IRQ_Disable();
+    SPI_JobStartNext(spi_dev, woken);
+    PIOS_IRQ_Enable();
+}
+
+/**
+ * Queue a job. It runs as soon as the bus is free and no job of a more urgent
+ * priority is queued, its callback is then called from the DMA interrupt.
+ * Can be called from tasks and interrupts.
+ * \param[in] spi_id SPI device handle
+ * \param[in] job the job, owned by the driver until its callback is called
+ * \return 0 if the job was queued
+ * \return -2 if the job is still queued or running
+ */
+int32_t PIOS_SPI_QueueJob(uint32_t spi_id, struct pios_spi_job *job)
+{
+    struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
+
+    bool valid = PIOS_SPI_validate(spi_dev);
+
+    PIOS_Assert(valid)
+    PIOS_Assert(job->priority < PIOS_SPI_PRIORITY_NUM && job->num_transfers > 0)
+
+    PIOS_IRQ_Disable();
+    if (job->queued) {
+        PIOS_IRQ_Enable();
+        return -2;
+    }
+    job->queued = true;
+    job->next   = NULL;
+    if (spi_dev->job_head[job->priority]) {
+        spi_dev->job_tail[job->priority]->next = job;
+    } else {
+        spi_dev->job_head[job->priority] = job;
+    }
+    spi_dev->job_tail[job->priority] = job;
+
+    /* taking the bus cannot wake a task up */
+    bool woken = false;
+    SPI_JobsRun(spi_dev, &woken);
+    PIOS_IRQ_Enable();
+
+    return 0;
+}
+
 void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
 {
     struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
@@ -751,6 +957,15 @@ void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
         }
     }
 
+    if (spi_dev->job) {
+        bool woken = false;
+        SPI_JobTransferDone(spi_dev, &woken);
+#if defined(PIOS_INCLUDE_FREERTOS)
+        portEND_SWITCHING_ISR(woken ? pdTRUE : pdFALSE);
+#endif
+        return;
+    }
+
     if (spi_dev->callback != NULL) {
         bool crc_ok = true;
         uint8_t crc_val;
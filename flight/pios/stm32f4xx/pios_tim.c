@@ -185,6 +185,95 @@ out_fail:
     return -1;
 }
 
+/**
+ * Set up a DMA stream that writes a burst of capture/compare registers on every
+ * update event of the timer, one period per entry and channel of the buffer.
+ * The stream is left disabled, PIOS_TIM_StartBurstDMA() sends the buffer.
+ * \param[in] cfg stream of the TIMx_UP request
+ * \param[in] first index of the first CCR written, 0 for CCR1
+ * \param[in] count number of CCRs written per update event, 1 to 4
+ * \param[in] buffer CCR values, count per update event, in SRAM reachable by the DMA
+ * \param[in] transfers total number of values in the buffer
+ */
+int32_t PIOS_TIM_InitBurstDMA(const struct pios_tim_burst_dma *cfg, uint8_t first, uint8_t count, const uint32_t *buffer, uint16_t transfers)
+{
+    PIOS_Assert(cfg);
+    PIOS_Assert(count > 0 && first + count <= 4);
+
+    if ((uint32_t)cfg->stream < (uint32_t)DMA2_Stream0) {
+        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA1, ENABLE);
+    } else {
+        RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA2, ENABLE);
+    }
+
+    DMA_Cmd(cfg->stream, DISABLE);
+    while (DMA_GetCmdStatus(cfg->stream) == ENABLE) {
+        ;
+    }
+    DMA_DeInit(cfg->stream);
+
+    DMA_InitTypeDef init = {
+        .DMA_Channel            = cfg->channel,
+        .DMA_PeripheralBaseAddr = (uint32_t)&cfg->timer->DMAR,
+        .DMA_Memory0BaseAddr    = (uint32_t)buffer,
+        .DMA_DIR                = DMA_DIR_MemoryToPeripheral,
+        .DMA_BufferSize         = transfers,
+        .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+        .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+        // word writes also reach the 32 bit CCRs of TIM2 and TIM5
+        .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word,
+        .DMA_MemoryDataSize     = DMA_MemoryDataSize_Word,
+        .DMA_Mode               = DMA_Mode_Normal,
+        .DMA_Priority           = DMA_Priority_High,
+        .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+        .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+        .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+        .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+    };
+    DMA_Init(cfg->stream, &init);
+
+    TIM_DMAConfig(cfg->timer, TIM_DMABase_CCR1 + first, (uint16_t)(count - 1) << 8);
+    TIM_DMACmd(cfg->timer, TIM_DMA_Update, ENABLE);
+
+    return 0;
+}
+
+/**
+ * Send the buffer set up by PIOS_TIM_InitBurstDMA() once.
+ * \param[in] cfg stream of the TIMx_UP request
+ * \param[in] transfers number of values to send from the start of the buffer
+ * \return false if the previous transfer is still running
+ */
+bool PIOS_TIM_StartBurstDMA(const struct pios_tim_burst_dma *cfg, uint16_t transfers)
+{
+    // the stream disables itself at the end of a normal mode transfer
+    if (DMA_GetCmdStatus(cfg->stream) == ENABLE) {
+        return false;
+    }
+
+    DMA_ClearFlag(cfg->stream, cfg->flags);
+    DMA_SetCurrDataCounter(cfg->stream, transfers);
+    DMA_Cmd(cfg->stream, ENABLE);
+    return true;
+}
+
+bool PIOS_TIM_BurstDMABusy(const struct pios_tim_burst_dma *cfg)
+{
+    return DMA_GetCmdStatus(cfg->stream) == ENABLE;
+}
+
+/**
+ * Stop the stream and the DMA requests of the timer, the timer keeps running.
+ */
+void PIOS_TIM_StopBurstDMA(const struct pios_tim_burst_dma *cfg)
+{
+    TIM_DMACmd(cfg->timer, TIM_DMA_Update, DISABLE);
+    DMA_Cmd(cfg->stream, DISABLE);
+    while (DMA_GetCmdStatus(cfg->stream) == ENABLE) {
+        ;
+    }
+}
+
 static void PIOS_TIM_generic_irq_handler(TIM_TypeDef *timer)
 {
     /* Iterate over all registered clients of the TIM layer to find channels on this timer */
@@ -38,10 +38,15 @@
 
 #include <pios_usart_priv.h>
 
+#ifndef PIOS_USART_RX_DMA_BUF_LEN
+#define PIOS_USART_RX_DMA_BUF_LEN 128
+#endif
+
 /* Provide a COM driver */
 static void PIOS_USART_ChangeBaud(uint32_t usart_id, uint32_t baud);
 static void PIOS_USART_RegisterRxCallback(uint32_t usart_id, pios_com_callback rx_in_cb, uint32_t context);
 static void PIOS_USART_RegisterTxCallback(uint32_t usart_id, pios_com_callback tx_out_cb, uint32_t context);
+static void PIOS_USART_RegisterTxRegionCallback(uint32_t usart_id, pios_com_region_callback tx_region_cb, uint32_t context);
 static void PIOS_USART_TxStart(uint32_t usart_id, uint16_t tx_bytes_avail);
 static void PIOS_USART_RxStart(uint32_t usart_id, uint16_t rx_bytes_avail);
 
@@ -51,6 +56,7 @@ const struct pios_com_driver pios_usart_com_driver = {
     .rx_start   = PIOS_USART_RxStart,
     .bind_tx_cb = PIOS_USART_RegisterTxCallback,
     .bind_rx_cb = PIOS_USART_RegisterRxCallback,
+    .bind_tx_region_cb = PIOS_USART_RegisterTxRegionCallback,
 };
 
 enum pios_usart_dev_magic {
@@ -65,6 +71,11 @@ struct pios_usart_dev {
     uint32_t rx_in_context;
     pios_com_callback tx_out_cb;
     uint32_t tx_out_context;
+    pios_com_region_callback tx_region_cb;
+    uint32_t tx_region_context;
+    volatile uint16_t tx_dma_len; /* bytes of the region being sent by DMA, 0 when idle */
+    uint8_t  *rx_dma_buf; /* circular DMA receive buffer, NULL when receiving by RXNE interrupts */
+    uint16_t rx_dma_pos; /* first byte of rx_dma_buf not yet handed to rx_in_cb */
 };
 
 static bool PIOS_USART_validate(struct pios_usart_dev *usart_dev)
@@ -72,6 +83,11 @@ static bool PIOS_USART_validate(struct pios_usart_dev *usart_dev)
     return usart_dev->magic == PIOS_USART_DEV_MAGIC;
 }
 
+static bool PIOS_USART_tx_dma(struct pios_usart_dev *usart_dev)
+{
+    return usart_dev->cfg->dma && usart_dev->tx_region_cb;
+}
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 static struct pios_usart_dev *PIOS_USART_alloc(void)
 {
@@ -216,8 +232,38 @@ int32_t PIOS_USART_Init(uint32_t *usart_id, const struct pios_usart_cfg *cfg)
         break;
     }
     NVIC_Init((NVIC_InitTypeDef *)&(usart_dev->cfg->irq.init));
-    USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
-    USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (usart_dev->cfg->dma_rx) {
+        /* Not from the fast heap, DMA can't reach CCM */
+        usart_dev->rx_dma_buf = (uint8_t *)pios_malloc(PIOS_USART_RX_DMA_BUF_LEN);
+    }
+#endif
+    if (usart_dev->rx_dma_buf) {
+        /* Receive continuously into the circular buffer, bytes are handed up on IDLE, half and full buffer */
+        DMA_InitTypeDef dma_init = usart_dev->cfg->dma_rx->rx.init;
+        dma_init.DMA_Memory0BaseAddr = (uint32_t)usart_dev->rx_dma_buf;
+        dma_init.DMA_BufferSize = PIOS_USART_RX_DMA_BUF_LEN;
+        dma_init.DMA_Mode = DMA_Mode_Circular;
+        DMA_DeInit(usart_dev->cfg->dma_rx->rx.channel);
+        DMA_Init(usart_dev->cfg->dma_rx->rx.channel, &dma_init);
+        DMA_ITConfig(usart_dev->cfg->dma_rx->rx.channel, DMA_IT_HT | DMA_IT_TC, ENABLE);
+        NVIC_Init((NVIC_InitTypeDef *)&(usart_dev->cfg->dma_rx->irq.init));
+        USART_DMACmd(usart_dev->cfg->regs, USART_DMAReq_Rx, ENABLE);
+        DMA_Cmd(usart_dev->cfg->dma_rx->rx.channel, ENABLE);
+        USART_ITConfig(usart_dev->cfg->regs, USART_IT_IDLE, ENABLE);
+    } else {
+        USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
+    }
+    if (usart_dev->cfg->dma) {
+        /* Configure the tx stream, memory address and length are set per transfer */
+        DMA_DeInit(usart_dev->cfg->dma->tx.channel);
+        DMA_Init(usart_dev->cfg->dma->tx.channel, (DMA_InitTypeDef *)&(usart_dev->cfg->dma->tx.init));
+        DMA_ITConfig(usart_dev->cfg->dma->tx.channel, DMA_IT_TC, ENABLE);
+        NVIC_Init((NVIC_InitTypeDef *)&(usart_dev->cfg->dma->irq.init));
+        USART_DMACmd(usart_dev->cfg->regs, USART_DMAReq_Tx, ENABLE);
+    } else {
+        USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
+    }
 
     // FIXME XXX Clear / reset uart here - sends NUL char else
 
@@ -238,8 +284,31 @@ static void PIOS_USART_RxStart(uint32_t usart_id, __attribute__((unused)) uint16
 
     PIOS_Assert(valid);
 
+    if (usart_dev->rx_dma_buf) {
+        /* DMA never stops receiving */
+        return;
+    }
+
     USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
 }
+
+/* Sends the next contiguous region of the tx fifo, must be called from the DMA ISR or with IRQs disabled */
+static void PIOS_USART_DMA_TxNext(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+    DMA_Stream_TypeDef *stream = usart_dev->cfg->dma->tx.channel;
+    uint8_t *region;
+
+    usart_dev->tx_dma_len = (usart_dev->tx_region_cb)(usart_dev->tx_region_context, usart_dev->tx_dma_len, &region, need_yield);
+    if (usart_dev->tx_dma_len == 0) {
+        return;
+    }
+
+    DMA_ClearFlag(stream, usart_dev->cfg->dma->irq.flags);
+    DMA_MemoryTargetConfig(stream, (uint32_t)region, DMA_Memory_0);
+    DMA_SetCurrDataCounter(stream, usart_dev->tx_dma_len);
+    DMA_Cmd(stream, ENABLE);
+}
+
 static void PIOS_USART_TxStart(uint32_t usart_id, __attribute__((unused)) uint16_t tx_bytes_avail)
 {
     struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
@@ -248,6 +317,17 @@ static void PIOS_USART_TxStart(uint32_t usart_id, __attribute__((unused)) uint16
 
     PIOS_Assert(valid);
 
+    if (PIOS_USART_tx_dma(usart_dev)) {
+        /* A running transfer picks up the new data when it completes */
+        PIOS_IRQ_Disable();
+        if (usart_dev->tx_dma_len == 0) {
+            bool tx_need_yield = false;
+            PIOS_USART_DMA_TxNext(usart_dev, &tx_need_yield);
+        }
+        PIOS_IRQ_Enable();
+        return;
+    }
+
     USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
 }
 
@@ -308,6 +388,107 @@ static void PIOS_USART_RegisterTxCallback(uint32_t usart_id, pios_com_callback t
     usart_dev->tx_out_cb = tx_out_cb;
 }
 
+static void PIOS_USART_RegisterTxRegionCallback(uint32_t usart_id, pios_com_region_callback tx_region_cb, uint32_t context)
+{
+    struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
+
+    bool valid = PIOS_USART_validate(usart_dev);
+
+    PIOS_Assert(valid);
+
+    /*
+     * Order is important in these assignments since ISR uses _cb
+     * field to determine if it's ok to dereference _cb and _context
+     */
+    usart_dev->tx_region_context = context;
+    usart_dev->tx_region_cb = tx_region_cb;
+}
+
+/* Hands the bytes received by DMA since the last call to rx_in_cb, must be called from the USART or DMA ISR */
+static void PIOS_USART_DMA_RxFlush(struct pios_usart_dev *usart_dev, bool *need_yield)
+{
+    uint16_t pos = PIOS_USART_RX_DMA_BUF_LEN - DMA_GetCurrDataCounter(usart_dev->cfg->dma_rx->rx.channel);
+
+    if (pos == PIOS_USART_RX_DMA_BUF_LEN) {
+        pos = 0;
+    }
+    if (pos == usart_dev->rx_dma_pos || !usart_dev->rx_in_cb) {
+        usart_dev->rx_dma_pos = pos;
+        return;
+    }
+
+    if (pos < usart_dev->rx_dma_pos) {
+        /* Wrapped around, first the tail of the buffer */
+        (void)(usart_dev->rx_in_cb)(usart_dev->rx_in_context, &usart_dev->rx_dma_buf[usart_dev->rx_dma_pos],
+                                    PIOS_USART_RX_DMA_BUF_LEN - usart_dev->rx_dma_pos, NULL, need_yield);
+        usart_dev->rx_dma_pos = 0;
+    }
+    if (pos > usart_dev->rx_dma_pos) {
+        (void)(usart_dev->rx_in_cb)(usart_dev->rx_in_context, &usart_dev->rx_dma_buf[usart_dev->rx_dma_pos],
+                                    pos - usart_dev->rx_dma_pos, NULL, need_yield);
+    }
+    usart_dev->rx_dma_pos = pos;
+}
+
+/**
+ * DMA handler, to be bound by the board to the tx and rx stream IRQs
+ * \param[in] regs USART the streams serve
+ */
+void PIOS_USART_DMA_irq_handler(USART_TypeDef *regs)
+{
+    uint32_t usart_id = 0;
+
+    switch ((uint32_t)regs) {
+    case (uint32_t)USART1:
+        usart_id = PIOS_USART_1_id;
+        break;
+    case (uint32_t)USART2:
+        usart_id = PIOS_USART_2_id;
+        break;
+    case (uint32_t)USART3:
+        usart_id = PIOS_USART_3_id;
+        break;
+    case (uint32_t)UART4:
+        usart_id = PIOS_USART_4_id;
+        break;
+    case (uint32_t)UART5:
+        usart_id = PIOS_USART_5_id;
+        break;
+    case (uint32_t)USART6:
+        usart_id = PIOS_USART_6_id;
+        break;
+    }
+
+    struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
+
+    if (!usart_dev || !PIOS_USART_validate(usart_dev)) {
+        return;
+    }
+
+    /* Half or full rx buffer */
+    bool rx_need_yield = false;
+    if (usart_dev->rx_dma_buf) {
+        DMA_ClearFlag(usart_dev->cfg->dma_rx->rx.channel, usart_dev->cfg->dma_rx->irq.flags);
+        PIOS_USART_DMA_RxFlush(usart_dev, &rx_need_yield);
+    }
+
+    /* The tx stream disables itself once the transfer is complete */
+    bool tx_need_yield = false;
+    if (PIOS_USART_tx_dma(usart_dev) && usart_dev->tx_dma_len &&
+        DMA_GetCmdStatus(usart_dev->cfg->dma->tx.channel) == DISABLE) {
+        DMA_ClearFlag(usart_dev->cfg->dma->tx.channel, usart_dev->cfg->dma->irq.flags);
+
+        /* Release the region just sent and queue the next one */
+        PIOS_USART_DMA_TxNext(usart_dev, &tx_need_yield);
+    }
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+    if (rx_need_yield || tx_need_yield) {
+        vPortYield();
+    }
+#endif /* PIOS_INCLUDE_FREERTOS */
+}
+
 static void PIOS_USART_generic_irq_handler(uint32_t usart_id)
 {
     struct pios_usart_dev *usart_dev = (struct pios_usart_dev *)usart_id;
@@ -315,23 +496,35 @@ static void PIOS_USART_generic_irq_handler(uint32_t usart_id)
     bool valid = PIOS_USART_validate(usart_dev);
 
     PIOS_Assert(valid);
+    PIOS_EVENTTRACE(PIOS_EVENTTRACE_ISR_ENTER, PIOS_EVENTTRACE_ISR_USART);
 
-    /* Force read of dr after sr to make sure to clear error flags */
     volatile uint16_t sr = usart_dev->cfg->regs->SR;
-    volatile uint8_t dr  = usart_dev->cfg->regs->DR;
-
-    /* Check if RXNE flag is set */
     bool rx_need_yield   = false;
-    if (sr & USART_SR_RXNE) {
-        uint8_t byte = dr;
-        if (usart_dev->rx_in_cb) {
-            (void)(usart_dev->rx_in_cb)(usart_dev->rx_in_context, &byte, 1, NULL, &rx_need_yield);
+
+    if (usart_dev->rx_dma_buf) {
+        /* DMA owns dr, only read it after sr to clear the IDLE and error flags */
+        if (sr & (USART_SR_IDLE | USART_SR_ORE | USART_SR_NE | USART_SR_FE)) {
+            (void)usart_dev->cfg->regs->DR;
+
+            /* Line went idle, hand up the whole burst */
+            PIOS_USART_DMA_RxFlush(usart_dev, &rx_need_yield);
+        }
+    } else {
+        /* Force read of dr after sr to make sure to clear error flags */
+        volatile uint8_t dr = usart_dev->cfg->regs->DR;
+
+        /* Check if RXNE flag is set */
+        if (sr & USART_SR_RXNE) {
+            uint8_t byte = dr;
+            if (usart_dev->rx_in_cb) {
+                (void)(usart_dev->rx_in_cb)(usart_dev->rx_in_context, &byte, 1, NULL, &rx_need_yield);
+            }
         }
     }
 
-    /* Check if TXE flag is set */
+    /* Check if TXE flag is set, the TXE interrupt is never enabled while transmitting by DMA */
     bool tx_need_yield = false;
-    if (sr & USART_SR_TXE) {
+    if ((sr & USART_SR_TXE) && !PIOS_USART_tx_dma(usart_dev)) {
         if (usart_dev->tx_out_cb) {
             uint8_t b;
             uint16_t bytes_to_send;
@@ -351,6 +544,7 @@ static void PIOS_USART_generic_irq_handler(uint32_t usart_id)
         }
     }
 
+    PIOS_EVENTTRACE(PIOS_EVENTTRACE_ISR_EXIT, PIOS_EVENTTRACE_ISR_USART);
 #if defined(PIOS_INCLUDE_FREERTOS)
     if (rx_need_yield || tx_need_yield) {
         vPortYield();
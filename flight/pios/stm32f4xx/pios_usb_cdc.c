@@ -37,6 +37,11 @@
 #include "pios_usb_board_data.h" /* PIOS_BOARD_*_DATA_LENGTH */
 #include "pios_usbhook.h" /* PIOS_USBHOOK_* */
 
+/* Packets moved by one transfer from device to host, the core splits it and the Tx FIFO holds them */
+#ifndef PIOS_USB_CDC_TX_PACKETS
+#define PIOS_USB_CDC_TX_PACKETS 4
+#endif
+
 /* Implement COM layer driver API */
 static void PIOS_USB_CDC_RegisterTxCallback(uint32_t usbcdc_id, pios_com_callback tx_out_cb, uint32_t context);
 static void PIOS_USB_CDC_RegisterRxCallback(uint32_t usbcdc_id, pios_com_callback rx_in_cb, uint32_t context);
@@ -74,12 +79,13 @@ struct pios_usb_cdc_dev {
     volatile bool rx_active;
 
     /*
-     * NOTE: This is -1 as somewhat of a hack.  It ensures that we always send packets
-     * that are strictly < maxPacketSize for this interface which means we never have
-     * to bother with zero length packets (ZLP).
+     * Several full size packets per transfer. A transfer which ends on a full packet
+     * is followed by a zero length packet (ZLP) once there is nothing more to send,
+     * so the host does not wait for the end of it.
      */
-    uint8_t  tx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH - 1] __attribute__((aligned(4)));
+    uint8_t  tx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH * PIOS_USB_CDC_TX_PACKETS] __attribute__((aligned(4)));
     volatile bool tx_active;
+    bool     tx_zlp_needed;
 
     uint8_t  ctrl_tx_packet_buffer[PIOS_USB_BOARD_CDC_MGMT_LENGTH] __attribute__((aligned(4)));
 
@@ -181,6 +187,7 @@ int32_t PIOS_USB_CDC_Init(uint32_t *usbcdc_id, const struct pios_usb_cdc_cfg *cf
     /* Rx and Tx are not active yet */
     usb_cdc_dev->rx_active           = false;
     usb_cdc_dev->tx_active           = false;
+    usb_cdc_dev->tx_zlp_needed       = false;
 
     /* Clear stats */
     usb_cdc_dev->rx_dropped          = 0;
@@ -220,8 +227,12 @@ static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev *usb_cdc_dev)
                                            NULL,
                                            &need_yield);
     if (bytes_to_tx == 0) {
-        return false;
+        if (!usb_cdc_dev->tx_zlp_needed) {
+            return false;
+        }
+        /* The last transfer ended on a full packet, terminate it */
     }
+    usb_cdc_dev->tx_zlp_needed = bytes_to_tx && (bytes_to_tx % PIOS_USB_BOARD_CDC_DATA_LENGTH) == 0;
 
     /*
      * Mark this endpoint as being tx active _before_ actually transmitting
@@ -560,6 +571,7 @@ static void PIOS_USB_CDC_DATA_IF_Init(uint32_t usb_cdc_id)
                                        sizeof(usb_cdc_dev->rx_packet_buffer),
                                        PIOS_USB_CDC_DATA_EP_OUT_Callback,
                                        (uint32_t)usb_cdc_dev);
+    usb_cdc_dev->tx_zlp_needed = false;
     usb_cdc_dev->usb_data_if_enabled = true;
 }
 
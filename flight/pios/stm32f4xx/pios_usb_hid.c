@@ -37,6 +37,12 @@
 #include "pios_usb_board_data.h" /* PIOS_BOARD_*_DATA_LENGTH */
 #include <pios_usbhook.h> /* PIOS_USBHOOK_* */
 #include <pios_delay.h>
+
+/* Reports queued by one transfer, the core sends one per polling interval from the Tx FIFO */
+#ifndef PIOS_USB_HID_TX_REPORTS
+#define PIOS_USB_HID_TX_REPORTS 4
+#endif
+
 static void PIOS_USB_HID_RegisterTxCallback(uint32_t usbhid_id, pios_com_callback tx_out_cb, uint32_t context);
 static void PIOS_USB_HID_RegisterRxCallback(uint32_t usbhid_id, pios_com_callback rx_in_cb, uint32_t context);
 static void PIOS_USB_HID_TxStart(uint32_t usbhid_id, uint16_t tx_bytes_avail);
@@ -70,7 +76,7 @@ struct pios_usb_hid_dev {
     uint8_t  rx_packet_buffer[PIOS_USB_BOARD_HID_DATA_LENGTH] __attribute__((aligned(4)));
     volatile bool rx_active;
 
-    uint8_t  tx_packet_buffer[PIOS_USB_BOARD_HID_DATA_LENGTH] __attribute__((aligned(4)));
+    uint8_t  tx_packet_buffer[PIOS_USB_BOARD_HID_DATA_LENGTH * PIOS_USB_HID_TX_REPORTS] __attribute__((aligned(4)));
     volatile bool tx_active;
 
     uint32_t rx_dropped;
@@ -183,26 +189,37 @@ void PIOS_USB_HID_RegisterHidReport(const uint8_t *desc, uint16_t length)
 static bool PIOS_USB_HID_SendReport(struct pios_usb_hid_dev *usb_hid_dev)
 {
     uint16_t bytes_to_tx;
+    uint16_t reports = 0;
 
     if (!usb_hid_dev->tx_out_cb) {
         return false;
     }
     READ_MEMORY_BARRIER();
     bool need_yield = false;
+    /* Fill as many reports as there is data for, each one is a full packet */
+    for (; reports < PIOS_USB_HID_TX_REPORTS; reports++) {
+        uint8_t *report = &usb_hid_dev->tx_packet_buffer[reports * PIOS_USB_BOARD_HID_DATA_LENGTH];
 #ifdef PIOS_USB_BOARD_BL_HID_HAS_NO_LENGTH_BYTE
-    bytes_to_tx = (usb_hid_dev->tx_out_cb)(usb_hid_dev->tx_out_context,
-                                           &usb_hid_dev->tx_packet_buffer[1],
-                                           sizeof(usb_hid_dev->tx_packet_buffer) - 1,
-                                           NULL,
-                                           &need_yield);
+        bytes_to_tx = (usb_hid_dev->tx_out_cb)(usb_hid_dev->tx_out_context,
+                                               &report[1],
+                                               PIOS_USB_BOARD_HID_DATA_LENGTH - 1,
+                                               NULL,
+                                               &need_yield);
 #else
-    bytes_to_tx = (usb_hid_dev->tx_out_cb)(usb_hid_dev->tx_out_context,
-                                           &usb_hid_dev->tx_packet_buffer[2],
-                                           sizeof(usb_hid_dev->tx_packet_buffer) - 2,
-                                           NULL,
-                                           &need_yield);
+        bytes_to_tx = (usb_hid_dev->tx_out_cb)(usb_hid_dev->tx_out_context,
+                                               &report[2],
+                                               PIOS_USB_BOARD_HID_DATA_LENGTH - 2,
+                                               NULL,
+                                               &need_yield);
+        report[1]   = bytes_to_tx;
 #endif
-    if (bytes_to_tx == 0) {
+        if (bytes_to_tx == 0) {
+            break;
+        }
+        /* Always set type as report ID */
+        report[0] = 1;
+    }
+    if (reports == 0) {
         return false;
     }
 
@@ -212,19 +229,9 @@ static bool PIOS_USB_HID_SendReport(struct pios_usb_hid_dev *usb_hid_dev)
      */
     usb_hid_dev->tx_active = true;
 
-    /* Always set type as report ID */
-    usb_hid_dev->tx_packet_buffer[0] = 1;
-
-#ifdef PIOS_USB_BOARD_BL_HID_HAS_NO_LENGTH_BYTE
-    PIOS_USBHOOK_EndpointTx(usb_hid_dev->cfg->data_tx_ep,
-                            usb_hid_dev->tx_packet_buffer,
-                            sizeof(usb_hid_dev->tx_packet_buffer));
-#else
-    usb_hid_dev->tx_packet_buffer[1] = bytes_to_tx;
     PIOS_USBHOOK_EndpointTx(usb_hid_dev->cfg->data_tx_ep,
                             usb_hid_dev->tx_packet_buffer,
-                            sizeof(usb_hid_dev->tx_packet_buffer));
-#endif
+                            reports * PIOS_USB_BOARD_HID_DATA_LENGTH);
 
 #if defined(PIOS_INCLUDE_FREERTOS)
     if (need_yield) {
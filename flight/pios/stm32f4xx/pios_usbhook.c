@@ -136,9 +136,10 @@ void PIOS_USBHOOK_RegisterEpInCallback(uint8_t epnum, uint16_t max_len, pios_usb
     usb_epin_table[epnum].context = context;
     usb_epin_table[epnum].max_len = max_len;
 
+    /* max_len is the largest transfer, the core splits it into packets of at most the endpoint size */
     DCD_EP_Open(&pios_usb_otg_core_handle,
                 epnum | 0x80,
-                max_len,
+                MIN(max_len, USB_OTG_FS_MAX_PACKET_SIZE),
                 USB_OTG_EP_INT);
     /*
      * FIXME do not hardcode endpoint type
@@ -166,7 +167,7 @@ void PIOS_USBHOOK_RegisterEpOutCallback(uint8_t epnum, uint16_t max_len, pios_us
 
     DCD_EP_Open(&pios_usb_otg_core_handle,
                 epnum,
-                max_len,
+                MIN(max_len, USB_OTG_FS_MAX_PACKET_SIZE),
                 USB_OTG_EP_INT);
     /*
      * FIXME do not hardcode endpoint type
@@ -36,16 +36,44 @@
 #include "task.h"
 
 
-// framebuffer
+// led colors set by the user, rendered to the dma buffer when an update starts
+static Color_t pixels[PIOS_WS2811_NUMLEDS];
+static volatile bool dirty;
+// dma buffer, one halfword per bit
 static ledbuf_t *fb = 0;
 // bitmask with pin to be set/reset using dma
 static ledbuf_t dmaSource[4];
+// dma values of the 4 bits of a nibble, msb first
+static ledbuf_t nibbleBits[16][4];
+
+#ifdef PIOS_WS2811_GAMMA
+// 2.2 gamma, so that color values are perceived linearly
+static const uint8_t gamma[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+#endif
 
 static const struct pios_ws2811_cfg *pios_ws2811_cfg;
 static const struct pios_ws2811_pin_cfg *pios_ws2811_pin_cfg;
 
 static void setupTimer();
 static void setupDMA();
+static void render();
 
 // generic wrapper around corresponding SPL functions
 static void genericTIM_OCxInit(TIM_TypeDef *TIMx, const TIM_OCInitTypeDef *TIM_OCInitStruct, uint8_t ch);
@@ -174,13 +202,19 @@ void PIOS_WS2811_Init(const struct pios_ws2811_cfg *ws2811_cfg, const struct pio
     for (uint8_t i = 0; i < 4; i++) {
         dmaSource[i] = (ledbuf_t)pios_ws2811_pin_cfg->gpioInit.GPIO_Pin;
     }
+    // a "1" bit keeps the pin high, so ch1 does not reset it
+    for (uint8_t n = 0; n < 16; n++) {
+        for (uint8_t i = 0; i < 4; i++) {
+            nibbleBits[n][i] = ((n << i) & 0x08) ? 0x0 : dmaSource[0];
+        }
+    }
 
     fb = (ledbuf_t *)pios_malloc(PIOS_WS2811_BUFFER_SIZE * sizeof(ledbuf_t));
-    memset(fb, 0, PIOS_WS2811_BUFFER_SIZE * sizeof(ledbuf_t));
-    const Color_t ledoff = Color_Off;
     for (uint8_t i = 0; i < PIOS_WS2811_NUMLEDS; i++) {
-        PIOS_WS2811_setColorRGB(ledoff, i, false);
+        pixels[i] = Color_Off;
     }
+    render();
+    dirty = true;
     // Setup timers
     setupTimer();
     setupDMA();
@@ -287,12 +321,27 @@ void setupDMA()
     DMA_Cmd(pios_ws2811_cfg->streamUpdate, ENABLE);
 }
 
-void setColor(uint8_t color, ledbuf_t *buf)
+static inline ledbuf_t *encodeColor(ledbuf_t *buf, uint8_t color)
+{
+#ifdef PIOS_WS2811_GAMMA
+    color = gamma[color];
+#endif
+    memcpy(buf, nibbleBits[color >> 4], sizeof(nibbleBits[0]));
+    memcpy(buf + 4, nibbleBits[color & 0x0F], sizeof(nibbleBits[0]));
+    return buf + 8;
+}
+
+/**
+ * Convert the led colors to the dma buffer, only while no transfer is on going
+ */
+void render()
 {
-    uint8_t i;
+    ledbuf_t *buf = fb;
 
-    for (i = 0; i < 8; i++) {
-        buf[i] = ((color << i) & 0b10000000 ? 0x0 : dmaSource[0]);
+    for (uint8_t i = 0; i < PIOS_WS2811_NUMLEDS; i++) {
+        buf = encodeColor(buf, pixels[i].G);
+        buf = encodeColor(buf, pixels[i].R);
+        buf = encodeColor(buf, pixels[i].B);
     }
 }
 
@@ -307,9 +356,10 @@ void PIOS_WS2811_setColorRGB(Color_t c, uint8_t led, bool update)
     if (led >= PIOS_WS2811_NUMLEDS) {
         return;
     }
-    setColor(c.G, fb + (led * 24));
-    setColor(c.R, fb + 8 + (led * 24));
-    setColor(c.B, fb + 16 + (led * 24));
+    if (pixels[led].R != c.R || pixels[led].G != c.G || pixels[led].B != c.B) {
+        pixels[led] = c;
+        dirty = true;
+    }
 
     if (update) {
         PIOS_WS2811_Update();
@@ -317,14 +367,17 @@ void PIOS_WS2811_setColorRGB(Color_t c, uint8_t led, bool update)
 }
 
 /**
- * trigger an update cycle if not already running
+ * trigger an update cycle if a led changed and no cycle is running.
+ * A change made during a transfer is sent by the next call
  */
 void PIOS_WS2811_Update()
 {
     // does not start if framebuffer is not allocated (init has not been called yet) or a transfer is still on going
-    if (!fb || (pios_ws2811_cfg->timer->CR1 & TIM_CR1_CEN)) {
+    if (!fb || !dirty || (pios_ws2811_cfg->timer->CR1 & TIM_CR1_CEN)) {
         return;
     }
+    dirty = false;
+    render();
 
     // reset counters for synchronization
     pios_ws2811_cfg->timer->CNT = PIOS_WS2811_TIM_PERIOD - 1;
@@ -140,6 +140,9 @@
 /* #define PIOS_INCLUDE_COM_FLEXI */
 /* #define PIOS_INCLUDE_COM_AUX */
 /* #define PIOS_TELEM_PRIORITY_QUEUE */
+/* #define PIOS_TELEM_LOGGING_QUEUE */
+/* #define PIOS_TELEM_BATCH_LATENCY_MS 20 */
+/* #define PIOS_TELEM_DELTA_KEYFRAME_PERIOD 10 */
 #define PIOS_INCLUDE_GPS
 #define PIOS_GPS_MINIMAL
 /* #define PIOS_INCLUDE_GPS_NMEA_PARSER */
@@ -152,6 +155,9 @@
 /* Performance counters */
 #define IDLE_COUNTS_PER_SEC_AT_NO_LOAD  1995998
 
+/* Block pools for the small allocations (UAVO event entries, periodic update entries, small UAVO data) */
+#define PIOS_MEM_POOLS                  { { 16, 64 }, { 40, 48 } }
+
 /* Alarm Thresholds */
 #define HEAP_LIMIT_WARNING              220
 #define HEAP_LIMIT_CRITICAL             40
@@ -843,6 +843,7 @@ void PIOS_Board_Init(void)
 
 #if defined(PIOS_INCLUDE_GCSRCVR)
     GCSReceiverInitialize();
+    GCSReceiverStatusInitialize();
     uint32_t pios_gcsrcvr_id;
     PIOS_GCSRCVR_Init(&pios_gcsrcvr_id);
     uint32_t pios_gcsrcvr_rcvr_id;
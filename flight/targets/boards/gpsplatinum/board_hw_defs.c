@@ -248,7 +248,7 @@ static const struct pios_hmc5x83_cfg pios_mag_cfg = {
 #ifdef PIOS_HMC5X83_HAS_GPIOS
     .exti_cfg    = &pios_exti_mag_cfg,
 #endif
-    .M_ODR       = PIOS_HMC5x83_ODR_30,
+    .M_ODR       = PIOS_HMC5x83_ODR_75,
     .Meas_Conf   = PIOS_HMC5x83_MEASCONF_NORMAL,
     .Gain             = PIOS_HMC5x83_GAIN_1_3,
     .Mode             = PIOS_HMC5x83_MODE_CONTINUOUS,
@@ -70,8 +70,12 @@ typedef enum {
     Download_Req, // 9
     Download, // 10
     Status_Request, // 11
-    Status_Rep
-// 12
+    Status_Rep, // 12
+    Req_Sector_CRC, // 13
+    Rep_Sector_CRC, // 14
+    Keep_Sector, // 15
+    Upload_Skip
+// 16
 } DFUCommands;
 
 typedef enum {
@@ -46,9 +46,10 @@ typedef void (*pFunction)(void);
 /* Private define ------------------------------------------------------------*/
 #define MAX_PACKET_DATA_LEN 255
 #define MAX_PACKET_BUF_SIZE (1 + 1 + MAX_PACKET_DATA_LEN + 2)
-#define UART_BUFFER_SIZE    256
+#define UART_BUFFER_SIZE    512
 #define BL_WAIT_TIME        6 * 1000 * 1000
 #define DFU_BUFFER_SIZE     63
+#define SSP_RX_WINDOW       2 // a window of full frames fits UART_BUFFER_SIZE
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
@@ -83,6 +84,7 @@ static void jump_to_app();
 
 static void SSP_CallBack(uint8_t *buf, uint16_t len);
 static int16_t SSP_SerialRead(void);
+static uint16_t SSP_RxSpace(void);
 static void SSP_SerialWrite(uint8_t);
 
 
@@ -97,6 +99,8 @@ static const PortConfig_t ssp_portConfig = {
     .pfSerialRead  = SSP_SerialRead,
     .pfSerialWrite = SSP_SerialWrite,
     .pfGetTime     = PIOS_DELAY_GetuS,
+    .rxWindow      = SSP_RX_WINDOW,
+    .pfRxSpace     = SSP_RxSpace,
 };
 
 static Port_t ssp_port;
@@ -248,6 +252,11 @@ void SSP_CallBack(uint8_t *buf, uint16_t len)
     fifoBuf_putData(&ssp_buffer, buf, len);
 }
 
+uint16_t SSP_RxSpace(void)
+{
+    return fifoBuf_getFree(&ssp_buffer);
+}
+
 int16_t SSP_SerialRead(void)
 {
     uint8_t byte;
@@ -109,6 +109,8 @@
 /* #define PIOS_INCLUDE_OVERO */
 /* #define PIOS_OVERO_SPI */
 #define PIOS_INCLUDE_SDCARD
+#define PIOS_INCLUDE_SDLOG
+#define PIOS_SDLOG_BUFFER_SECTORS 2
 /* #define PIOS_USE_SETTINGS_ON_SDCARD */
 #define LOG_FILENAME "startup.log"
 #define PIOS_INCLUDE_FLASH
@@ -218,8 +218,7 @@ extern uint32_t pios_com_telem_usb_id;
     }
 
 /* we have to do all this to satisfy the PIOS_ADC_MAX_SAMPLES define in pios_adc.h */
-/* which is annoying because this then determines the rate at which we generate buffer turnover events */
-/* the objective here is to get enough buffer space to support 100Hz averaging rate */
+/* the F4 driver does not use it, its DMA blocks are PIOS_ADC_BLOCK_SCANS scans long */
 #define PIOS_ADC_NUM_CHANNELS     7
 #define PIOS_ADC_MAX_OVERSAMPLING 10
 #define PIOS_ADC_USE_ADC2         0
@@ -701,6 +701,7 @@ static const struct flashfs_logfs_cfg flashfs_external_system_cfg = {
     .start_offset  = 0,          /* start at the beginning of the chip */
     .sector_size   = 0x00010000, /* 64K bytes */
     .page_size     = 0x00000100, /* 256 bytes */
+    .index_size    = 128,        /* 1K bytes of RAM */
 };
 
 
@@ -721,11 +722,90 @@ static const struct flashfs_logfs_cfg flashfs_internal_cfg = {
 
 #include <pios_usart_priv.h>
 
+#if defined(PIOS_INCLUDE_COM_TELEM) || defined(PIOS_INCLUDE_SBUS)
+/* The main port receive stream, shared by the telemetry and S.Bus configurations */
+void PIOS_USART_main_rx_dma_irq_handler(void);
+void DMA2_Stream2_IRQHandler(void) __attribute__((alias("PIOS_USART_main_rx_dma_irq_handler")));
+void PIOS_USART_main_rx_dma_irq_handler(void)
+{
+    /* Call into the generic code to handle the IRQ for this specific device */
+    PIOS_USART_DMA_irq_handler(USART1);
+}
+#endif
+
 #ifdef PIOS_INCLUDE_COM_TELEM
 
 /*
  * MAIN USART
  */
+void PIOS_USART_main_dma_irq_handler(void);
+void DMA2_Stream7_IRQHandler(void) __attribute__((alias("PIOS_USART_main_dma_irq_handler")));
+static const struct stm32_dma pios_usart_main_dma = {
+    .irq                                       = {
+        .flags = (DMA_FLAG_TCIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_DMEIF7 | DMA_FLAG_FEIF7),
+        .init  = {
+            .NVIC_IRQChannel    = DMA2_Stream7_IRQn,
+            .NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+            .NVIC_IRQChannelSubPriority        = 0,
+            .NVIC_IRQChannelCmd = ENABLE,
+        },
+    },
+    .tx                                        = {
+        .channel = DMA2_Stream7,
+        .init    = {
+            .DMA_Channel            = DMA_Channel_4,
+            .DMA_PeripheralBaseAddr = (uint32_t)&(USART1->DR),
+            .DMA_DIR                = DMA_DIR_MemoryToPeripheral,
+            .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+            .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+            .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+            .DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+            .DMA_Mode               = DMA_Mode_Normal,
+            .DMA_Priority           = DMA_Priority_Medium,
+            .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+            .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+            .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+            .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+        },
+    },
+};
+void PIOS_USART_main_dma_irq_handler(void)
+{
+    /* Call into the generic code to handle the IRQ for this specific device */
+    PIOS_USART_DMA_irq_handler(USART1);
+}
+
+static const struct stm32_dma pios_usart_main_rx_dma = {
+    .irq                                       = {
+        .flags = (DMA_FLAG_TCIF2 | DMA_FLAG_HTIF2 | DMA_FLAG_TEIF2 | DMA_FLAG_DMEIF2 | DMA_FLAG_FEIF2),
+        .init  = {
+            .NVIC_IRQChannel    = DMA2_Stream2_IRQn,
+            // must match the USART IRQ priority, both hand up received bytes
+            .NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+            .NVIC_IRQChannelSubPriority        = 0,
+            .NVIC_IRQChannelCmd = ENABLE,
+        },
+    },
+    .rx                                        = {
+        .channel = DMA2_Stream2,
+        .init    = {
+            .DMA_Channel            = DMA_Channel_4,
+            .DMA_PeripheralBaseAddr = (uint32_t)&(USART1->DR),
+            .DMA_DIR                = DMA_DIR_PeripheralToMemory,
+            .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+            .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+            .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+            .DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+            .DMA_Mode               = DMA_Mode_Circular,
+            .DMA_Priority           = DMA_Priority_High,
+            .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+            .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+            .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+            .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+        },
+    },
+};
+
 static const struct pios_usart_cfg pios_usart_main_cfg = {
     .regs  = USART1,
     .remap = GPIO_AF_USART1,
@@ -765,6 +845,8 @@ static const struct pios_usart_cfg pios_usart_main_cfg = {
             .GPIO_PuPd  = GPIO_PuPd_UP
         },
     },
+    .dma    = &pios_usart_main_dma,
+    .dma_rx = &pios_usart_main_rx_dma,
 };
 #endif /* PIOS_INCLUDE_COM_TELEM */
 
@@ -837,6 +919,36 @@ static const struct pios_dsm_cfg pios_dsm_main_cfg = {
  */
 #include <pios_sbus_priv.h>
 
+static const struct stm32_dma pios_usart_sbus_main_rx_dma = {
+    .irq                                       = {
+        .flags = (DMA_FLAG_TCIF2 | DMA_FLAG_HTIF2 | DMA_FLAG_TEIF2 | DMA_FLAG_DMEIF2 | DMA_FLAG_FEIF2),
+        .init  = {
+            .NVIC_IRQChannel    = DMA2_Stream2_IRQn,
+            .NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_HIGH,
+            .NVIC_IRQChannelSubPriority        = 0,
+            .NVIC_IRQChannelCmd = ENABLE,
+        },
+    },
+    .rx                                        = {
+        .channel = DMA2_Stream2,
+        .init    = {
+            .DMA_Channel            = DMA_Channel_4,
+            .DMA_PeripheralBaseAddr = (uint32_t)&(USART1->DR),
+            .DMA_DIR                = DMA_DIR_PeripheralToMemory,
+            .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+            .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+            .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+            .DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+            .DMA_Mode               = DMA_Mode_Circular,
+            .DMA_Priority           = DMA_Priority_High,
+            .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+            .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+            .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+            .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+        },
+    },
+};
+
 static const struct pios_usart_cfg pios_usart_sbus_main_cfg = {
     .regs  = USART1,
     .remap = GPIO_AF_USART1,
@@ -876,6 +988,7 @@ static const struct pios_usart_cfg pios_usart_sbus_main_cfg = {
             .GPIO_PuPd  = GPIO_PuPd_NOPULL
         },
     },
+    .dma_rx = &pios_usart_sbus_main_rx_dma,
 };
 
 #endif /* PIOS_INCLUDE_SBUS */
@@ -904,6 +1017,80 @@ static const struct pios_sbus_cfg pios_sbus_cfg = {
 /*
  * FLEXI PORT
  */
+void PIOS_USART_flexi_dma_irq_handler(void);
+void DMA1_Stream3_IRQHandler(void) __attribute__((alias("PIOS_USART_flexi_dma_irq_handler")));
+static const struct stm32_dma pios_usart_flexi_dma = {
+    .irq                                       = {
+        .flags = (DMA_FLAG_TCIF3 | DMA_FLAG_HTIF3 | DMA_FLAG_TEIF3 | DMA_FLAG_DMEIF3 | DMA_FLAG_FEIF3),
+        .init  = {
+            .NVIC_IRQChannel    = DMA1_Stream3_IRQn,
+            .NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+            .NVIC_IRQChannelSubPriority        = 0,
+            .NVIC_IRQChannelCmd = ENABLE,
+        },
+    },
+    .tx                                        = {
+        .channel = DMA1_Stream3,
+        .init    = {
+            .DMA_Channel            = DMA_Channel_4,
+            .DMA_PeripheralBaseAddr = (uint32_t)&(USART3->DR),
+            .DMA_DIR                = DMA_DIR_MemoryToPeripheral,
+            .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+            .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+            .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+            .DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+            .DMA_Mode               = DMA_Mode_Normal,
+            .DMA_Priority           = DMA_Priority_Medium,
+            .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+            .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+            .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+            .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+        },
+    },
+};
+void PIOS_USART_flexi_dma_irq_handler(void)
+{
+    /* Call into the generic code to handle the IRQ for this specific device */
+    PIOS_USART_DMA_irq_handler(USART3);
+}
+
+void PIOS_USART_flexi_rx_dma_irq_handler(void);
+void DMA1_Stream1_IRQHandler(void) __attribute__((alias("PIOS_USART_flexi_rx_dma_irq_handler")));
+void PIOS_USART_flexi_rx_dma_irq_handler(void)
+{
+    /* Call into the generic code to handle the IRQ for this specific device */
+    PIOS_USART_DMA_irq_handler(USART3);
+}
+static const struct stm32_dma pios_usart_flexi_rx_dma = {
+    .irq                                       = {
+        .flags = (DMA_FLAG_TCIF1 | DMA_FLAG_HTIF1 | DMA_FLAG_TEIF1 | DMA_FLAG_DMEIF1 | DMA_FLAG_FEIF1),
+        .init  = {
+            .NVIC_IRQChannel    = DMA1_Stream1_IRQn,
+            .NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+            .NVIC_IRQChannelSubPriority        = 0,
+            .NVIC_IRQChannelCmd = ENABLE,
+        },
+    },
+    .rx                                        = {
+        .channel = DMA1_Stream1,
+        .init    = {
+            .DMA_Channel            = DMA_Channel_4,
+            .DMA_PeripheralBaseAddr = (uint32_t)&(USART3->DR),
+            .DMA_DIR                = DMA_DIR_PeripheralToMemory,
+            .DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+            .DMA_MemoryInc          = DMA_MemoryInc_Enable,
+            .DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+            .DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+            .DMA_Mode               = DMA_Mode_Circular,
+            .DMA_Priority           = DMA_Priority_High,
+            .DMA_FIFOMode           = DMA_FIFOMode_Disable,
+            .DMA_FIFOThreshold      = DMA_FIFOThreshold_Full,
+            .DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+            .DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+        },
+    },
+};
+
 static const struct pios_usart_cfg pios_usart_flexi_cfg = {
     .regs  = USART3,
     .remap = GPIO_AF_USART3,
@@ -944,6 +1131,8 @@ static const struct pios_usart_cfg pios_usart_flexi_cfg = {
             .GPIO_PuPd  = GPIO_PuPd_UP
         },
     },
+    .dma    = &pios_usart_flexi_dma,
+    .dma_rx = &pios_usart_flexi_rx_dma,
 };
 
 #endif /* PIOS_INCLUDE_COM_FLEXI */
@@ -1701,6 +1890,32 @@ static const struct pios_tim_channel pios_tim_servoport_all_pins[] = {
 #define PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN_PPM 11
 #define PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN     12
 
+// Update DMA requests of the servo timers for DShot. TIM9 (servo 3) and TIM12 have none,
+// the TIM8 stream is taken by the WS2811 driver.
+static const struct pios_tim_burst_dma pios_servo_dshot_dma[] = {
+    {
+        .timer   = TIM3,
+        .stream  = DMA1_Stream2,
+        .channel = DMA_Channel_5,
+        .flags   = DMA_FLAG_FEIF2 | DMA_FLAG_DMEIF2 | DMA_FLAG_TEIF2 | DMA_FLAG_HTIF2 | DMA_FLAG_TCIF2,
+    },
+    {
+        .timer   = TIM5,
+        .stream  = DMA1_Stream6,
+        .channel = DMA_Channel_6,
+        .flags   = DMA_FLAG_FEIF6 | DMA_FLAG_DMEIF6 | DMA_FLAG_TEIF6 | DMA_FLAG_HTIF6 | DMA_FLAG_TCIF6,
+    },
+#if !defined(PIOS_OVERO_SPI)
+    // shares the stream with the Overo SPI
+    {
+        .timer   = TIM2,
+        .stream  = DMA1_Stream7,
+        .channel = DMA_Channel_3,
+        .flags   = DMA_FLAG_FEIF7 | DMA_FLAG_DMEIF7 | DMA_FLAG_TEIF7 | DMA_FLAG_HTIF7 | DMA_FLAG_TCIF7,
+    },
+#endif
+};
+
 const struct pios_servo_cfg pios_servo_cfg_out = {
     .tim_oc_init          = {
         .TIM_OCMode       = TIM_OCMode_PWM1,
@@ -1712,8 +1927,10 @@ const struct pios_servo_cfg pios_servo_cfg_out = {
         .TIM_OCIdleState  = TIM_OCIdleState_Reset,
         .TIM_OCNIdleState = TIM_OCNIdleState_Reset,
     },
-    .channels     = pios_tim_servoport_all_pins,
-    .num_channels = PIOS_SERVOPORT_ALL_PINS_PWMOUT,
+    .channels      = pios_tim_servoport_all_pins,
+    .num_channels  = PIOS_SERVOPORT_ALL_PINS_PWMOUT,
+    .dshot_dma     = pios_servo_dshot_dma,
+    .num_dshot_dma = NELEMENTS(pios_servo_dshot_dma),
 };
 // All servo outputs, servo input ch1 ppm, ch2-6 outputs
 const struct pios_servo_cfg pios_servo_cfg_out_in_ppm = {
@@ -1727,8 +1944,10 @@ const struct pios_servo_cfg pios_servo_cfg_out_in_ppm = {
         .TIM_OCIdleState  = TIM_OCIdleState_Reset,
         .TIM_OCNIdleState = TIM_OCNIdleState_Reset,
     },
-    .channels     = pios_tim_servoport_all_pins,
-    .num_channels = PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN_PPM,
+    .channels      = pios_tim_servoport_all_pins,
+    .num_channels  = PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN_PPM,
+    .dshot_dma     = pios_servo_dshot_dma,
+    .num_dshot_dma = NELEMENTS(pios_servo_dshot_dma),
 };
 // All servo outputs, servo inputs ch1-6 Outputs
 const struct pios_servo_cfg pios_servo_cfg_out_in = {
@@ -1742,8 +1961,10 @@ const struct pios_servo_cfg pios_servo_cfg_out_in = {
         .TIM_OCIdleState  = TIM_OCIdleState_Reset,
         .TIM_OCNIdleState = TIM_OCNIdleState_Reset,
     },
-    .channels     = pios_tim_servoport_all_pins,
-    .num_channels = PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN,
+    .channels      = pios_tim_servoport_all_pins,
+    .num_channels  = PIOS_SERVOPORT_ALL_PINS_PWMOUT_IN,
+    .dshot_dma     = pios_servo_dshot_dma,
+    .num_dshot_dma = NELEMENTS(pios_servo_dshot_dma),
 };
 
 
@@ -96,6 +96,12 @@
     while (0)
 #define portGET_RUN_TIME_COUNTER_VALUE() (*(unsigned long *)0xe0001004) /* DWT_CYCCNT */
 
+#ifdef PIOS_INCLUDE_EVENTTRACE
+/* Record task switches in the PiOS trace buffer */
+extern void PIOS_EVENTTRACE_TaskSwitchedIn(void *task);
+#define traceTASK_SWITCHED_IN() PIOS_EVENTTRACE_TaskSwitchedIn(pxCurrentTCB)
+#endif
+
 
 /**
  * @}
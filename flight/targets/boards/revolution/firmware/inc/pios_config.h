@@ -143,6 +143,10 @@
 #define PIOS_INCLUDE_COM_FLEXI
 /* #define PIOS_INCLUDE_COM_AUX */
 #define PIOS_TELEM_PRIORITY_QUEUE
+#define PIOS_TELEM_LOGGING_QUEUE
+#define PIOS_TELEM_BATCH_LATENCY_MS 20
+#define PIOS_TELEM_DELTA_KEYFRAME_PERIOD 10
+/* #define PIOS_TELEM_TIMESTAMPED_PERIOD_MS 100 */
 #define PIOS_INCLUDE_GPS
 /* #define PIOS_GPS_MINIMAL */
 #define PIOS_INCLUDE_GPS_NMEA_PARSER
@@ -155,6 +159,12 @@
 /* Performance counters */
 #define IDLE_COUNTS_PER_SEC_AT_NO_LOAD 8379692
 
+/* Block pools for the small allocations (UAVO event entries, periodic update entries, small UAVO data) */
+#define PIOS_MEM_POOLS                 { { 16, 128 }, { 40, 96 } }
+
+/* Settings are read from flash on first access instead of at registration, the System task loads the rest once the modules are started */
+#define UAVOBJ_DEFERRED_SETTINGS_LOAD
+
 /* Alarm Thresholds */
 #define HEAP_LIMIT_WARNING             1000
 #define HEAP_LIMIT_CRITICAL            500
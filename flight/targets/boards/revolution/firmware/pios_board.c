@@ -208,6 +208,8 @@ static const struct pios_mpu6000_cfg pios_mpu6000_cfg = {
     .fast_prescaler = PIOS_SPI_PRESCALER_4,
     .std_prescaler  = PIOS_SPI_PRESCALER_64,
     .max_downsample = 20,
+    // burst read the 8 kHz samples and average them down to 1 kHz
+    .fifo_rate      = 1000,
 };
 #endif /* PIOS_INCLUDE_MPU6000 */
 
@@ -874,6 +876,7 @@ void PIOS_Board_Init(void)
 
 #if defined(PIOS_INCLUDE_GCSRCVR)
     GCSReceiverInitialize();
+    GCSReceiverStatusInitialize();
     uint32_t pios_gcsrcvr_id;
     PIOS_GCSRCVR_Init(&pios_gcsrcvr_id);
     uint32_t pios_gcsrcvr_rcvr_id;
@@ -169,7 +169,7 @@ extern uint32_t pios_spi_telem_flash_id;
 // -------------------------
 // Packet Handler
 // -------------------------
-#define RS_ECC_NPARITY          4
+#define RS_ECC_NPARITY          8
 #define PIOS_PH_MAX_PACKET      255
 #define PIOS_PH_WIN_SIZE        3
 #define PIOS_PH_MAX_CONNECTIONS 1
@@ -290,8 +290,7 @@ extern uint32_t pios_packet_handler;
     }
 
 /* we have to do all this to satisfy the PIOS_ADC_MAX_SAMPLES define in pios_adc.h */
-/* which is annoying because this then determines the rate at which we generate buffer turnover events */
-/* the objective here is to get enough buffer space to support 100Hz averaging rate */
+/* the F4 driver does not use it, its DMA blocks are PIOS_ADC_BLOCK_SCANS scans long */
 #define PIOS_ADC_NUM_CHANNELS     4
 #define PIOS_ADC_MAX_OVERSAMPLING 2
 #define PIOS_ADC_USE_ADC2         0
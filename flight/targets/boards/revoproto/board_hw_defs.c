@@ -482,6 +482,7 @@ static const struct flashfs_logfs_cfg flashfs_internal_cfg = {
     .start_offset  = EE_BANK_BASE, /* start after the bootloader */
     .sector_size   = 0x00004000, /* 16K bytes */
     .page_size     = 0x00004000, /* 16K bytes */
+    .index_size    = 64,         /* one entry per slot */
 };
 
 #endif /* PIOS_INCLUDE_FLASH */
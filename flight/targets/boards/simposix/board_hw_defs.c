@@ -36,8 +36,9 @@
  * Telemetry on main USART
  */
 const struct pios_udp_cfg pios_udp_telem_cfg = {
-    .ip   = "0.0.0.0",
-    .port = 9000,
+    .ip        = "0.0.0.0",
+    .port      = 9000,
+    .multicast = true,
 };
 #endif /* PIOS_COM_TELEM */
 
@@ -60,6 +60,7 @@
 #define PIOS_INCLUDE_RTC
 #define PIOS_INCLUDE_WDG
 #define PIOS_INCLUDE_UDP
+#define PIOS_INCLUDE_SIM
 
 /* Select the sensors to include */
 // #define PIOS_INCLUDE_BMA180
@@ -105,6 +106,7 @@
 /* Flags that alter behaviors - mostly to lower resources for CC */
 #define PIOS_INCLUDE_INITCALL          /* Include init call structures */
 #define PIOS_TELEM_PRIORITY_QUEUE      /* Enable a priority queue in telemetry */
+#define PIOS_TELEM_LOGGING_QUEUE       /* Log from a task of its own, apart from telemetry */
 #define PIOS_QUATERNION_STABILIZATION  /* Stabilization options */
 // #define PIOS_GPS_SETS_HOMELOCATION      /* GPS options */
 
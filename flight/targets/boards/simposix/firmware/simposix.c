@@ -31,9 +31,17 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* sched_setaffinity */
+#endif
+
 #include "inc/openpilot.h"
 #include <systemmod.h>
 #include <uavobjectsinit.h>
+#include <getopt.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
 
 /* Task Priorities */
 #define PRIORITY_TASK_HOOKS (tskIDLE_PRIORITY + 3)
@@ -69,6 +77,9 @@ static void Stack_Change_Weak() __attribute__((weakref("Stack_Change")));
 #define INIT_TASK_STACK    (1024 / 4)                                                                              // XXX this seems excessive
 static xTaskHandle initTaskHandle;
 
+/* Multicast group port when -g gives none */
+#define MULTICAST_DEFAULT_PORT 9500
+
 /* Function Prototypes */
 static void initTask(void *parameters);
 
@@ -83,10 +94,77 @@ extern void InitModules(void);
  * Start FreeRTOS Scheduler (vTaskStartScheduler)<BR>
  * If something goes wrong, blink LED1 and LED2 every 100ms
  *
+ * Options select the time base:<BR>
+ * -l run in lockstep simulated time, as fast as the host allows<BR>
+ * -s port run in lockstep, stepped by a simulator on this UDP port<BR>
+ * -g group[:port] publish telemetry to a multicast group
+ *
  */
-int main()
+int main(int argc, char *argv[])
 {
     int result;
+    int opt;
+    enum pios_sim_mode sim_mode = PIOS_SIM_REALTIME;
+    uint16_t sim_port = 0;
+    const char *sim_shm = NULL;
+
+    while ((opt = getopt(argc, argv, "ls:m:i:g:c:r:")) != -1) {
+        switch (opt) {
+        case 'l':
+            sim_mode = PIOS_SIM_FREERUN;
+            break;
+        case 's':
+            sim_mode = PIOS_SIM_STEPPED;
+            sim_port = atoi(optarg);
+            break;
+        case 'm':
+            sim_shm  = optarg;
+            break;
+        case 'r':
+            PIOS_SIM_SetSeed(strtoul(optarg, NULL, 0));
+            break;
+        case 'i':
+            // Instance n listens on the UDP ports + 10 * n
+            PIOS_UDP_SetPortOffset(10 * atoi(optarg));
+            break;
+        case 'g':
+        {
+            // group[:port], telemetry is published there instead of sent to the GCS
+            char *port = strchr(optarg, ':');
+            if (port) {
+                *port++ = '\0';
+            }
+            if (PIOS_UDP_SetMulticastGroup(optarg, port ? atoi(port) : MULTICAST_DEFAULT_PORT) < 0) {
+                fprintf(stderr, "%s is not a multicast group\n", optarg);
+                return 1;
+            }
+            break;
+        }
+#if defined(__linux__)
+        case 'c':
+        {
+            // Every thread created from here on inherits the mask
+            cpu_set_t cpus;
+            CPU_ZERO(&cpus);
+            CPU_SET(atoi(optarg), &cpus);
+            if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+                perror("sched_setaffinity");
+            }
+            break;
+        }
+#endif
+        default:
+            fprintf(stderr, "Usage: %s [-l] [-s port | -m shm] [-i instance] [-g group[:port]] [-c cpu] [-r seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sim_shm) {
+        if (PIOS_SIM_InitShared(sim_shm) < 0) {
+            return 1;
+        }
+    } else if (PIOS_SIM_Init(sim_mode, sim_port) < 0) {
+        return 1;
+    }
 
     /* NOTE: Do NOT modify the following start-up sequence */
     /* Any new initialization functions should be added in OpenPilotInit() */
@@ -0,0 +1,209 @@
+/**
+ ******************************************************************************
+ *
+ * @file       swarm.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Runs several simposix boards in lockstep from one host process.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * Each board is a separate simposix process pinned to its own core, stepped
+ * through a pios_sim_shm ring. Board k serves telemetry on UDP port 9000 + 10 * k.
+ * The vehicle model is the stationary one, replace simulateVehicle() for
+ * anything that moves.
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include <pios_sim.h>
+
+#define MAX_VEHICLES 64
+
+struct vehicle {
+    char name[32];
+    pid_t pid;
+    struct pios_sim_shm *shm;
+    struct pios_sim_reply reply;
+};
+
+static struct vehicle vehicles[MAX_VEHICLES];
+static int num_vehicles;
+static volatile sig_atomic_t quit;
+
+static void onSignal(__attribute__((unused)) int sig)
+{
+    quit = 1;
+}
+
+static void simulateVehicle(__attribute__((unused)) int k, struct pios_sim_sensors *sensors)
+{
+    memset(sensors, 0, sizeof(*sensors));
+    sensors->accel[2]    = -9.81f;
+    sensors->mag[0]      = 400.0f;
+    sensors->mag[2]      = 800.0f;
+    sensors->temperature = 20.0f;
+}
+
+static int startVehicle(int k, const char *firmware, int cpus)
+{
+    struct vehicle *v = &vehicles[k];
+
+    snprintf(v->name, sizeof(v->name), "/opsim-%d-%d", (int)getpid(), k);
+    int fd = shm_open(v->name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 || ftruncate(fd, sizeof(*v->shm)) < 0) {
+        fprintf(stderr, "%s: %s\n", v->name, strerror(errno));
+        return -1;
+    }
+    v->shm = mmap(NULL, sizeof(*v->shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (v->shm == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", v->name, strerror(errno));
+        return -1;
+    }
+    memset(v->shm, 0, sizeof(*v->shm));
+    sem_init(&v->shm->step_free, 1, PIOS_SIM_RING_SIZE);
+    sem_init(&v->shm->step_ready, 1, 0);
+    sem_init(&v->shm->reply_free, 1, PIOS_SIM_RING_SIZE);
+    sem_init(&v->shm->reply_ready, 1, 0);
+
+    char instance[8], cpu[8];
+    snprintf(instance, sizeof(instance), "%d", k);
+    snprintf(cpu, sizeof(cpu), "%d", k % cpus);
+
+    v->pid = fork();
+    if (v->pid == 0) {
+        execl(firmware, firmware, "-m", v->name, "-i", instance, "-c", cpu, (char *)NULL);
+        perror(firmware);
+        _exit(1);
+    }
+    return v->pid < 0 ? -1 : 0;
+}
+
+static void step(struct vehicle *v, int k, uint32_t ticks)
+{
+    struct pios_sim_shm *shm = v->shm;
+    struct pios_sim_step *s;
+
+    while (sem_wait(&shm->step_free) < 0 && errno == EINTR && !quit) {
+        ;
+    }
+    s = &shm->steps[shm->step_head % PIOS_SIM_RING_SIZE];
+    s->ticks = ticks;
+    s->flags = PIOS_SIM_STEP_SENSORS;
+    simulateVehicle(k, &s->sensors);
+    __sync_synchronize();
+    shm->step_head++;
+    sem_post(&shm->step_ready);
+}
+
+static int waitReply(struct vehicle *v)
+{
+    struct pios_sim_shm *shm = v->shm;
+
+    while (sem_wait(&shm->reply_ready) < 0) {
+        if (errno != EINTR || quit) {
+            return -1;
+        }
+    }
+    v->reply = shm->replies[shm->reply_tail % PIOS_SIM_RING_SIZE];
+    __sync_synchronize();
+    shm->reply_tail++;
+    sem_post(&shm->reply_free);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *firmware = "./simposix.elf";
+    uint32_t ticks = 1;
+    long steps     = 0;
+    int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    num_vehicles = 1;
+    while ((opt = getopt(argc, argv, "n:f:t:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_vehicles = atoi(optarg);
+            break;
+        case 'f':
+            firmware     = optarg;
+            break;
+        case 't':
+            ticks = atoi(optarg);
+            break;
+        case 's':
+            steps = atol(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-n vehicles] [-f firmware] [-t ticks per step] [-s steps]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (num_vehicles < 1 || num_vehicles > MAX_VEHICLES || ticks < 1 || cpus < 1) {
+        fprintf(stderr, "Between 1 and %d vehicles, at least one tick per step\n", MAX_VEHICLES);
+        return 1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = onSignal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    int started = 0;
+    while (started < num_vehicles && startVehicle(started, firmware, cpus) == 0) {
+        fprintf(stderr, "Vehicle %d: pid %d, telemetry on UDP port %d\n",
+                started, (int)vehicles[started].pid, 9000 + 10 * started);
+        started++;
+    }
+
+    // Global lockstep, every board runs the same ticks before any moves on
+    for (long n = 0; started == num_vehicles && !quit && (steps == 0 || n < steps); n++) {
+        for (int k = 0; k < num_vehicles; k++) {
+            step(&vehicles[k], k, ticks);
+        }
+        for (int k = 0; k < num_vehicles && !quit; k++) {
+            if (waitReply(&vehicles[k]) < 0) {
+                quit = 1;
+            }
+        }
+    }
+
+    for (int k = 0; k < started; k++) {
+        struct vehicle *v = &vehicles[k];
+        fprintf(stderr, "Vehicle %d: %.3f s simulated, servos %u %u %u %u\n", k,
+                v->reply.time_us / 1e6, v->reply.servos[0], v->reply.servos[1],
+                v->reply.servos[2], v->reply.servos[3]);
+        if (v->pid > 0) {
+            kill(v->pid, SIGTERM);
+            waitpid(v->pid, NULL, 0);
+        }
+        shm_unlink(v->name);
+    }
+    return started == num_vehicles ? 0 : 1;
+}
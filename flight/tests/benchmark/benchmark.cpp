@@ -0,0 +1,288 @@
+#include <benchmark/benchmark.h>
+
+#include <math.h>
+#include <stdlib.h> /* rand */
+#include <string.h> /* memset */
+
+extern "C" {
+#include "openpilot.h"
+#include "insgps.h"
+#include "CoordinateConversions.h"
+#include "fifo_buffer.h"
+#include "pid.h"
+#include "butterworth.h"
+#include "pios_crc.h"
+#include "ecc.h"
+}
+
+// Work loads of the size the firmware sees, every input is prepared outside the timed loop
+
+static float random(float min, float max)
+{
+    return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+// One EKF step of the 13 state filter as run by the StateEstimation module at the gyro rate
+class INSGPS : public benchmark::Fixture {
+public:
+    void SetUp(const benchmark::State &)
+    {
+        float pos[3] = { 0.0f, 0.0f, 0.0f };
+        float vel[3] = { 0.0f, 0.0f, 0.0f };
+        float q[4]   = { 1.0f, 0.0f, 0.0f, 0.0f };
+        float gyroBias[3]  = { 0.0f, 0.0f, 0.0f };
+        float accelBias[3] = { 0.0f, 0.0f, 0.0f };
+        float magNorth[3]  = { 0.22f, 0.0f, 0.43f };
+
+        INSGPSInit();
+        INSSetState(pos, vel, q, gyroBias, accelBias);
+        INSSetMagNorth(magNorth);
+        srand(1234);
+    }
+
+    float gyro[3]  = { 0.01f, -0.02f, 0.005f };
+    float accel[3] = { 0.1f, -0.05f, -9.81f };
+    float mag[3]   = { 0.22f, 0.01f, 0.43f };
+    float pos[3]   = { 0.5f, -0.3f, -1.0f };
+    float vel[3]   = { 0.1f, 0.2f, 0.0f };
+};
+
+BENCHMARK_F(INSGPS, Prediction)(benchmark::State & state) {
+    for (auto _ : state) {
+        INSStatePrediction(gyro, accel, 0.002f);
+        INSCovariancePrediction(0.002f);
+    }
+}
+
+BENCHMARK_F(INSGPS, FullCorrection)(benchmark::State & state) {
+    for (auto _ : state) {
+        INSStatePrediction(gyro, accel, 0.002f);
+        INSCovariancePrediction(0.002f);
+        INSCorrection(mag, pos, vel, -pos[2], FULL_SENSORS);
+    }
+}
+
+BENCHMARK_F(INSGPS, MagCorrection)(benchmark::State & state) {
+    for (auto _ : state) {
+        INSStatePrediction(gyro, accel, 0.002f);
+        INSCovariancePrediction(0.002f);
+        INSCorrection(mag, pos, vel, -pos[2], MAG_SENSORS);
+    }
+}
+
+static void BM_Quaternion2R(benchmark::State & state)
+{
+    float rpy[3] = { 10.0f, -20.0f, 135.0f };
+    float q[4];
+    float R[3][3];
+
+    RPY2Quaternion(rpy, q);
+    for (auto _ : state) {
+        Quaternion2R(q, R);
+        benchmark::DoNotOptimize(R);
+    }
+}
+BENCHMARK(BM_Quaternion2R);
+
+static void BM_Quaternion2RPY(benchmark::State & state)
+{
+    float rpy[3] = { 10.0f, -20.0f, 135.0f };
+    float q[4];
+
+    RPY2Quaternion(rpy, q);
+    for (auto _ : state) {
+        Quaternion2RPY(q, rpy);
+        benchmark::DoNotOptimize(rpy);
+    }
+}
+BENCHMARK(BM_Quaternion2RPY);
+
+static void BM_LLA2Base(benchmark::State & state)
+{
+    int32_t home[3] = { 473977420, 85455940, 40000 };
+    int32_t lla[3]  = { 473980000, 85460000, 45000 };
+    double homeECEF[3];
+    float Rne[3][3];
+    float NED[3];
+
+    LLA2ECEF(home, homeECEF);
+    RneFromLLA(home, Rne);
+    for (auto _ : state) {
+        LLA2Base(lla, homeECEF, Rne, NED);
+        benchmark::DoNotOptimize(NED);
+    }
+}
+BENCHMARK(BM_LLA2Base);
+
+static void BM_LLA2LTP(benchmark::State & state)
+{
+    int32_t home[3] = { 473977420, 85455940, 40000 };
+    int32_t lla[3]  = { 473980000, 85460000, 45000 };
+    LTPBase base;
+    float NED[3];
+
+    LTPBaseFromLLA(home, 6378137.0f, &base);
+    for (auto _ : state) {
+        LLA2LTP(&base, lla, NED);
+        benchmark::DoNotOptimize(NED);
+    }
+}
+BENCHMARK(BM_LLA2LTP);
+
+// The three axes of the rate loop
+static void BM_PIDApplySetpoint(benchmark::State & state)
+{
+    struct pid pid[3];
+    pid_scaler scaler = { 1.0f, 1.0f, 1.0f };
+    float setpoint[64];
+    float measured[64];
+
+    for (int i = 0; i < 3; i++) {
+        pid_configure(&pid[i], 0.003f, 0.006f, 0.00004f, 0.3f);
+    }
+    pid_configure_derivative(20.0f, 1.0f);
+    for (int i = 0; i < 64; i++) {
+        setpoint[i] = random(-300.0f, 300.0f);
+        measured[i] = random(-300.0f, 300.0f);
+    }
+
+    unsigned n = 0;
+    for (auto _ : state) {
+        for (int i = 0; i < 3; i++) {
+            benchmark::DoNotOptimize(pid_apply_setpoint(&pid[i], &scaler, setpoint[(n + i) & 63], measured[(n + i) & 63], 0.002f));
+        }
+        n++;
+    }
+}
+BENCHMARK(BM_PIDApplySetpoint);
+
+static void BM_ButterWorthDF2(benchmark::State & state)
+{
+    struct ButterWorthDF2Filter filter;
+    float wn1, wn2;
+    float x[64];
+
+    InitButterWorthDF2Filter(0.1f, &filter);
+    InitButterWorthDF2Values(0.0f, &filter, &wn1, &wn2);
+    for (int i = 0; i < 64; i++) {
+        x[i] = random(-1.0f, 1.0f);
+    }
+
+    unsigned n = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(FilterButterWorthDF2(x[n++ & 63], &filter, &wn1, &wn2));
+    }
+}
+BENCHMARK(BM_ButterWorthDF2);
+
+// Put and get chunks of the argument size through a com port sized buffer
+static void BM_FifoBuffer(benchmark::State & state)
+{
+    uint8_t storage[256] = { 0 };
+    uint8_t chunk[256];
+    t_fifo_buffer fifo;
+    const uint16_t len = state.range(0);
+
+    fifoBuf_init(&fifo, storage, sizeof(storage));
+    memset(chunk, 0x55, sizeof(chunk));
+    for (auto _ : state) {
+        fifoBuf_putData(&fifo, chunk, len);
+        benchmark::DoNotOptimize(fifoBuf_getData(&fifo, chunk, len));
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_FifoBuffer)->Arg(1)->Arg(16)->Arg(128);
+
+// The UAVTalk CRC over the largest object, the flash file system CRCs over a sector sized block
+static void BM_CRC8(benchmark::State & state)
+{
+    uint8_t data[4096];
+    const int32_t len = state.range(0);
+
+    for (int i = 0; i < len; i++) {
+        data[i] = rand();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PIOS_CRC_updateCRC(0, data, len));
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_CRC8)->Arg(255)->Arg(4096);
+
+static void BM_CRC16(benchmark::State & state)
+{
+    uint8_t data[4096];
+    const int32_t len = state.range(0);
+
+    for (int i = 0; i < len; i++) {
+        data[i] = rand();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PIOS_CRC16_updateCRC(0, data, len));
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_CRC16)->Arg(255)->Arg(4096);
+
+static void BM_CRC32(benchmark::State & state)
+{
+    uint8_t data[4096];
+    const int32_t len = state.range(0);
+
+    for (int i = 0; i < len; i++) {
+        data[i] = rand();
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(PIOS_CRC32_updateCRC(0, data, len));
+    }
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_CRC32)->Arg(255)->Arg(4096);
+
+// Reed Solomon with 8 parity bytes over an OPLink packet
+static void BM_RSEncode(benchmark::State & state)
+{
+    unsigned char msg[247];
+    unsigned char codeword[255];
+
+    initialize_ecc();
+    for (unsigned i = 0; i < sizeof(msg); i++) {
+        msg[i] = rand();
+    }
+    for (auto _ : state) {
+        encode_data(msg, sizeof(msg), codeword);
+        benchmark::DoNotOptimize(codeword);
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(msg));
+}
+BENCHMARK(BM_RSEncode);
+
+// Argument: number of corrupted bytes, 0 is the common case of a clean packet
+static void BM_RSDecode(benchmark::State & state)
+{
+    unsigned char msg[247];
+    unsigned char codeword[255];
+    unsigned char received[255];
+    const int errors = state.range(0);
+
+    initialize_ecc();
+    for (unsigned i = 0; i < sizeof(msg); i++) {
+        msg[i] = rand();
+    }
+    encode_data(msg, sizeof(msg), codeword);
+    for (int i = 0; i < errors; i++) {
+        codeword[(i * 37) % sizeof(codeword)] ^= 0xA5;
+    }
+    for (auto _ : state) {
+        memcpy(received, codeword, sizeof(codeword));
+        decode_data(received, sizeof(received));
+        if (check_syndrome() != 0) {
+            correct_errors_erasures(received, sizeof(received), 0, NULL);
+        }
+        benchmark::DoNotOptimize(received);
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(codeword));
+}
+BENCHMARK(BM_RSDecode)->Arg(0)->Arg(1)->Arg(4);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,8 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pios_math.h>
+
+#endif /* OPENPILOT_H */
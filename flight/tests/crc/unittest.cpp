@@ -0,0 +1,82 @@
+#include "gtest/gtest.h"
+
+#include <stdlib.h> /* rand */
+#include <string.h> /* strlen */
+
+extern "C" {
+#include "pios.h"
+}
+
+// Bitwise versions of the table driven CRCs, as a reference
+static uint8_t ref_crc8(uint8_t crc, const uint8_t *data, int32_t length)
+{
+    for (int32_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t ref_crc32(uint32_t crc, const uint8_t *data, int32_t length)
+{
+    for (int32_t i = 0; i < length; i++) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+class CRCTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        srand(1);
+        for (unsigned i = 0; i < sizeof(data); i++) {
+            data[i] = rand();
+        }
+    }
+
+    uint8_t data[600];
+};
+
+TEST_F(CRCTest, CheckValues) {
+    const uint8_t *check = (const uint8_t *)"123456789";
+
+    EXPECT_EQ(0xF4, PIOS_CRC_updateCRC(0, check, 9));
+    EXPECT_EQ(0x0376E6E7u, PIOS_CRC32_updateCRC(0xFFFFFFFF, check, 9));
+}
+
+TEST_F(CRCTest, CRC8AnyAlignmentAndLength) {
+    // the word at a time loop starts on an aligned word, whatever the buffer
+    for (int offset = 0; offset < 4; offset++) {
+        for (int32_t len = 0; len < 40; len++) {
+            EXPECT_EQ(ref_crc8(0x5A, data + offset, len), PIOS_CRC_updateCRC(0x5A, data + offset, len));
+        }
+    }
+    EXPECT_EQ(ref_crc8(0, data, sizeof(data)), PIOS_CRC_updateCRC(0, data, sizeof(data)));
+}
+
+TEST_F(CRCTest, CRC8MatchesBytewise) {
+    uint8_t crc = 0;
+
+    for (unsigned i = 0; i < sizeof(data); i++) {
+        crc = PIOS_CRC_updateByte(crc, data[i]);
+    }
+    EXPECT_EQ(crc, PIOS_CRC_updateCRC(0, data, sizeof(data)));
+    EXPECT_EQ(0, PIOS_CRC_updateCRC(0, data, -1));
+}
+
+TEST_F(CRCTest, CRC32Chained) {
+    uint32_t crc = 0xFFFFFFFF;
+
+    // a continued CRC is the same as one over the whole buffer
+    crc = PIOS_CRC32_updateCRC(crc, data + 1, 37);
+    crc = PIOS_CRC32_updateCRC(crc, data + 38, 300);
+    crc = PIOS_CRC32_updateCRC(crc, data + 338, 262);
+    EXPECT_EQ(ref_crc32(0xFFFFFFFF, data + 1, 599), crc);
+    EXPECT_EQ(ref_crc32(0, data, 64), PIOS_CRC32_updateCRC(0, data, 64));
+}
@@ -297,6 +297,88 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
     EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+TEST_F(LogfsTestCooked, WriteUnchangedKeepsSlot) {
+    struct PIOS_FLASHFS_Stats stats;
+    struct PIOS_FLASHFS_Stats stats_check;
+
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+
+    /* Saving the very same data again must not use up a slot */
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats_check));
+    EXPECT_EQ(stats.num_free_slots, stats_check.num_free_slots);
+    EXPECT_EQ(stats.num_active_slots, stats_check.num_active_slots);
+
+    /* New data does */
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats_check));
+    EXPECT_EQ(stats.num_free_slots - 1, stats_check.num_free_slots);
+    EXPECT_EQ(stats.num_active_slots, stats_check.num_active_slots);
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+}
+
+TEST_F(LogfsTestCooked, BadIdCompact) {
+    EXPECT_EQ(-1, PIOS_FLASHFS_Compact(fs_id + 1));
+}
+
+TEST_F(LogfsTestCooked, CompactReclaimsObsolete) {
+    struct PIOS_FLASHFS_Stats stats;
+    uint16_t num_slots = (flashfs_config_partition_a.arena_size / flashfs_config_partition_a.slot_size) - 1;
+
+    /* Nothing to reclaim yet, compacting must leave the log alone */
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+    EXPECT_EQ(0, PIOS_FLASHFS_Compact(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(num_slots - 1, stats.num_free_slots);
+
+    /* Fill most of the log with obsolete versions of obj1 */
+    for (uint32_t i = 0; i < num_slots - 10U; i++) {
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, (i & 1) ? obj1_alt : obj1, sizeof(obj1)));
+    }
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(9, stats.num_free_slots);
+
+    EXPECT_EQ(0, PIOS_FLASHFS_Compact(fs_id));
+    EXPECT_EQ(0, PIOS_FLASHFS_GetStats(fs_id, &stats));
+    EXPECT_EQ(2, stats.num_active_slots);
+    EXPECT_EQ(num_slots - 2, stats.num_free_slots);
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+    unsigned char obj2_check[OBJ2_SIZE];
+    memset(obj2_check, 0, sizeof(obj2_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+    EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+}
+
+TEST_F(LogfsTestCooked, IndexOverflowVerifyDelete) {
+    /* More instances than the RAM index holds, lookups fall back to scanning the log */
+    for (uint32_t i = 0; i < 2 * flashfs_config_partition_a.index_size; i++) {
+        obj1[0] = i;
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+    }
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    for (uint32_t i = 0; i < 2 * flashfs_config_partition_a.index_size; i++) {
+        obj1[0] = i;
+        memset(obj1_check, 0, sizeof(obj1_check));
+        EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, i, obj1_check, sizeof(obj1_check)));
+        EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+    }
+
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 3));
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 3, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 4, obj1_check, sizeof(obj1_check)));
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
     virtual void SetUp()
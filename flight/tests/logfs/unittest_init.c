@@ -22,6 +22,7 @@ const struct flashfs_logfs_cfg flashfs_config_partition_a = {
     .start_offset  = 0,          /* start at the beginning of the chip */
     .sector_size   = 0x00010000, /* 64K bytes */
     .page_size     = 0x00000100, /* 256 bytes */
+    .index_size    = 64,         /* less than the slots, so filling up overflows it */
 };
 
 const struct flashfs_logfs_cfg flashfs_config_partition_b = {
@@ -3,9 +3,35 @@
 #include <stdio.h> /* printf */
 #include <stdlib.h> /* abort */
 #include <string.h> /* memset */
+#include <time.h> /* clock */
 
 extern "C" {
 #include "mathmisc.h"
+#include "fastmath.h"
+#include "biquad.h"
+#include "fft.h"
+#include "sysident.h"
+#include "magfit.h"
+#include <stdbool.h>
+#include "CoordinateConversions.h"
+#include "noise.h"
+#include "WorldMagModel.h"
+
+// INSGPS covariance kernels (insgps13state.c)
+#define NUMX 13
+#define NUMW 9
+#define NUMV 10
+#define NUMP (NUMX * (NUMX + 1) / 2)
+void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                          float Q[NUMW], float dT, float P[NUMX][NUMX]);
+void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+                  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
+                  uint16_t SensorsUsed);
+void CovariancePredictionPacked(float F[NUMX][NUMX], float G[NUMX][NUMW],
+                                float Q[NUMW], float dT, float P[NUMP]);
+void SerialUpdatePacked(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
+                        float Y[NUMV], float P[NUMP], float X[NUMX],
+                        uint16_t SensorsUsed);
 }
 
 #define epsilon 0.00001f
@@ -108,3 +134,746 @@ TEST_F(MathTestRaw, y_on_curve1) {
     EXPECT_NEAR(-0.35f, y_on_curve(1.250f, points, length(points)), epsilon);
     EXPECT_NEAR(-0.50f, y_on_curve(2.000f, points, length(points)), epsilon);
 }
+
+// The packed covariance kernels used on the F4 must give the very same bits as the dense ones
+class INSGPSPackedTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        srand(1234);
+        // random symmetric covariance, with a dominant diagonal
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = i; j < NUMX; j++) {
+                P[i][j] = P[j][i] = random(-0.1f, 0.1f);
+            }
+            P[i][i] += 1.0f;
+        }
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = 0; j < NUMX; j++) {
+                F[i][j] = random(-2.0f, 2.0f);
+            }
+            for (int j = 0; j < NUMW; j++) {
+                G[i][j] = random(-2.0f, 2.0f);
+            }
+            X[i] = random(-1.0f, 1.0f);
+        }
+        for (int i = 0; i < NUMW; i++) {
+            Q[i] = random(0.0f, 1e-3f);
+        }
+        for (int m = 0; m < NUMV; m++) {
+            for (int j = 0; j < NUMX; j++) {
+                H[m][j] = random(-1.0f, 1.0f);
+            }
+            R[m] = random(0.01f, 1.0f);
+            Z[m] = random(-1.0f, 1.0f);
+            Y[m] = random(-1.0f, 1.0f);
+        }
+        pack();
+    }
+
+    float random(float min, float max)
+    {
+        return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+    }
+
+    void pack()
+    {
+        int n = 0;
+
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = i; j < NUMX; j++) {
+                Pp[n++] = P[i][j];
+            }
+        }
+    }
+
+    void expectSameP()
+    {
+        int n = 0;
+
+        for (int i = 0; i < NUMX; i++) {
+            for (int j = i; j < NUMX; j++) {
+                EXPECT_EQ(0, memcmp(&P[i][j], &Pp[n], sizeof(float))) << "P[" << i << "][" << j << "]";
+                EXPECT_EQ(0, memcmp(&P[i][j], &P[j][i], sizeof(float))) << "P[" << i << "][" << j << "]";
+                n++;
+            }
+        }
+    }
+
+    float F[NUMX][NUMX];
+    float G[NUMX][NUMW];
+    float H[NUMV][NUMX];
+    float P[NUMX][NUMX];
+    float Pp[NUMP];
+    float X[NUMX];
+    float Q[NUMW];
+    float R[NUMV];
+    float Z[NUMV];
+    float Y[NUMV];
+};
+
+TEST_F(INSGPSPackedTest, CovariancePrediction) {
+    for (int n = 0; n < 100; n++) {
+        CovariancePrediction(F, G, Q, 0.002f, P);
+        CovariancePredictionPacked(F, G, Q, 0.002f, Pp);
+    }
+    expectSameP();
+}
+
+TEST_F(INSGPSPackedTest, SerialUpdate) {
+    float Xp[NUMX];
+
+    memcpy(Xp, X, sizeof(X));
+    // all sensors, then the sensor subsets used by the filters
+    SerialUpdate(H, R, Z, Y, P, X, 0x3FF);
+    SerialUpdatePacked(H, R, Z, Y, Pp, Xp, 0x3FF);
+    SerialUpdate(H, R, Z, Y, P, X, 0x1C0);
+    SerialUpdatePacked(H, R, Z, Y, Pp, Xp, 0x1C0);
+    SerialUpdate(H, R, Z, Y, P, X, 0x23F);
+    SerialUpdatePacked(H, R, Z, Y, Pp, Xp, 0x23F);
+    expectSameP();
+    EXPECT_EQ(0, memcmp(X, Xp, sizeof(X)));
+}
+
+// LLA2LTP against the double precision ECEF path
+class LTPTest : public testing::Test {};
+
+TEST_F(LTPTest, MatchesLLA2Base) {
+    // bases near the equator, at mid latitude, near a pole and on the date line
+    int32_t bases[][3] = {
+        {         0,          0,      0 },
+        { 473977420,   85455940, 4500000 },
+        { -890000000, 1234567890,   10000 },
+        { -337000000, 1799990000,  200000 }
+    };
+    // offsets in 1e-7 deg and 1e-4 m
+    int32_t offsets[][3] = {
+        {       0,       0,       0 },
+        {      10,     -10,      10 },
+        {    9000,   12000,  -20000 },
+        {  -90000,  140000,  500000 },
+        {  400000, -300000, 1000000 },
+        { -3000000, 2000000, 5000000 }
+    };
+
+    for (unsigned b = 0; b < length(bases); b++) {
+        double HomeECEF[3];
+        float Rne[3][3];
+        LTPBase base;
+
+        LLA2ECEF(bases[b], HomeECEF);
+        RneFromLLA(bases[b], Rne);
+        LTPBaseFromLLA(bases[b], 50000.0f, &base);
+
+        for (unsigned o = 0; o < length(offsets); o++) {
+            int32_t LLAi[3];
+            float ref[3], ned[3];
+
+            for (int i = 0; i < 3; i++) {
+                LLAi[i] = bases[b][i] + offsets[o][i];
+            }
+            if (LLAi[1] > 1800000000) {
+                LLAi[1] -= 3600000000LL;
+            }
+            LLA2Base(LLAi, HomeECEF, Rne, ref);
+            if (!LLA2LTP(&base, LLAi, ned)) {
+                EXPECT_GT(sqrtf(ref[0] * ref[0] + ref[1] * ref[1]), 40000.0f);
+                continue;
+            }
+            for (int i = 0; i < 3; i++) {
+                EXPECT_NEAR(ref[i], ned[i], 0.01f) << "base " << b << " offset " << o << " axis " << i;
+            }
+        }
+    }
+}
+
+// Seeded noise used by the simulators
+class NoiseTest : public testing::Test {};
+
+TEST_F(NoiseTest, SameSeedSameSequence) {
+    struct NoiseGenerator a, b;
+
+    NoiseSeed(&a, 42);
+    NoiseSeed(&b, 42);
+    for (int n = 0; n < 1000; n++) {
+        float x = NoiseGauss(&a);
+        float y = NoiseGauss(&b);
+        ASSERT_EQ(0, memcmp(&x, &y, sizeof(float))) << "sample " << n;
+    }
+    NoiseSeed(&b, 43);
+    EXPECT_NE(NoiseGauss(&a), NoiseGauss(&b));
+}
+
+TEST_F(NoiseTest, UnitGaussian) {
+    struct NoiseGenerator gen;
+    const int count = 100000;
+    double sum = 0, sum2 = 0;
+
+    NoiseSeed(&gen, 1);
+    for (int n = 0; n < count; n++) {
+        float x = NoiseGauss(&gen);
+        ASSERT_TRUE(IS_REAL(x));
+        sum  += x;
+        sum2 += x * x;
+    }
+    EXPECT_NEAR(0.0, sum / count, 0.02);
+    EXPECT_NEAR(1.0, sum2 / count, 0.02);
+}
+
+TEST_F(NoiseTest, SensorModel) {
+    struct NoiseGenerator gen;
+    struct NoiseSensorModel model;
+    const int count = 20000;
+    double sum2 = 0;
+
+    NoiseSeed(&gen, 7);
+    memset(&model, 0, sizeof(model));
+    model.correlation     = 0.9f;
+    model.correlatedSigma = 0.5f;
+    model.tempCoeff = 0.1f;
+    model.tempRef   = 20.0f;
+    NoiseSensorReset(&model);
+
+    for (int n = 0; n < count; n++) {
+        float v[3] = { 0.0f, 0.0f, 0.0f };
+        NoiseSensorApply(&model, &gen, v, 0.002f, 30.0f);
+        // one deg C drift on every axis, no bias walk configured
+        sum2 += (v[0] - 1.0f) * (v[0] - 1.0f);
+        EXPECT_EQ(0.0f, model.bias[1]);
+    }
+    EXPECT_NEAR(0.25, sum2 / count, 0.03);
+}
+
+// fastmath.h against double precision libm, at the documented bounds
+class FastMathTest : public testing::Test {};
+
+TEST_F(FastMathTest, Atan2) {
+    double err = 0;
+
+    for (int i = 0; i < 10000; i++) {
+        float a = i * (M_2PI_F / 10000) - M_PI_F;
+        for (float r = 1e-3f; r < 1e4f; r *= 7.3f) {
+            float y = r * sinf(a);
+            float x = r * cosf(a);
+            err = fmax(err, fabs(fast_atan2f(y, x) - atan2((double)y, (double)x)));
+        }
+    }
+    EXPECT_LT(err, 4e-6);
+    EXPECT_EQ(0.0f, fast_atan2f(0.0f, 0.0f));
+    EXPECT_NEAR(M_PI_F, fast_atan2f(0.0f, -1.0f), 4e-6f);
+    EXPECT_NEAR(-M_PI_2_F, fast_atan2f(-2.0f, 0.0f), 4e-6f);
+}
+
+TEST_F(FastMathTest, Asin) {
+    double err = 0;
+
+    for (int i = 0; i <= 200000; i++) {
+        float x = i * 1e-5f - 1.0f;
+        err = fmax(err, fabs(fast_asinf(x) - asin((double)x)));
+    }
+    EXPECT_LT(err, 6e-6);
+    // rounding just outside the domain, as in Quaternion2RPY
+    EXPECT_NEAR(M_PI_2_F, fast_asinf(1.0000002f), 6e-6f);
+    EXPECT_NEAR(-M_PI_2_F, fast_asinf(-1.0000002f), 6e-6f);
+}
+
+TEST_F(FastMathTest, SinCos) {
+    double err = 0;
+
+    for (int i = 0; i <= 600000; i++) {
+        float x = i * 1e-2f - 3000.0f;
+        float s, c;
+        fast_sincosf(x, &s, &c);
+        err = fmax(err, fabs(s - sin((double)x)));
+        err = fmax(err, fabs(c - cos((double)x)));
+    }
+    EXPECT_LT(err, 5e-7);
+}
+
+TEST_F(FastMathTest, Sqrt) {
+    double rsqrt_err = 0, sqrt_err = 0;
+
+    for (float x = 1e-30f; x < 1e30f; x *= 1.0001f) {
+        rsqrt_err = fmax(rsqrt_err, fabs(fast_rsqrtf(x) * sqrt((double)x) - 1.0));
+        sqrt_err  = fmax(sqrt_err, fabs(fast_sqrtf(x) / sqrt((double)x) - 1.0));
+    }
+    EXPECT_LT(rsqrt_err, 5e-6);
+    EXPECT_LT(sqrt_err, 5e-6);
+    EXPECT_EQ(0.0f, fast_sqrtf(0.0f));
+    EXPECT_EQ(0.0f, fast_sqrtf(-1.0f));
+}
+
+TEST_F(FastMathTest, Exp) {
+    double err = 0;
+
+    for (int i = 0; i < 175000; i++) {
+        float x = i * 1e-3f - 87.0f;
+        err = fmax(err, fabs(fast_expf(x) / exp((double)x) - 1.0));
+    }
+    EXPECT_LT(err, 4e-7);
+    EXPECT_EQ(0.0f, fast_expf(-100.0f));
+    EXPECT_TRUE(IS_REAL(fast_expf(1000.0f)));
+}
+
+TEST_F(FastMathTest, Log) {
+    double abs_err = 0, rel_err = 0;
+
+    for (float x = 1e-37f; x < 1e38f; x *= 1.0001f) {
+        double ref = log((double)x);
+        double d   = fabs(fast_logf(x) - ref);
+        if (x >= 0.5f && x < 2.0f) {
+            abs_err = fmax(abs_err, d);
+        } else {
+            rel_err = fmax(rel_err, d / fabs(ref));
+        }
+    }
+    EXPECT_LT(abs_err, 2e-7);
+    EXPECT_LT(rel_err, 2e-7);
+    EXPECT_TRUE(isinf(fast_logf(0.0f)));
+    EXPECT_TRUE(isnan(fast_logf(-1.0f)));
+}
+
+TEST_F(FastMathTest, Quaternion2RPYRoundTrip) {
+    for (float roll = -172.5f; roll < 180.0f; roll += 7.5f) {
+        for (float pitch = -85.0f; pitch <= 85.0f; pitch += 5.0f) {
+            for (float yaw = -175.0f; yaw < 180.0f; yaw += 12.5f) {
+                float rpy[3] = { roll, pitch, yaw };
+                float q[4], out[3];
+                RPY2Quaternion(rpy, q);
+                Quaternion2RPY(q, out);
+                // all three are ill conditioned in float near gimbal lock, libm or not
+                EXPECT_NEAR(roll, out[0], 2e-3f);
+                EXPECT_NEAR(pitch, out[1], 2e-3f);
+                EXPECT_NEAR(yaw, out[2], 2e-3f);
+            }
+        }
+    }
+}
+
+// Host side timings against libm, run with --gtest_also_run_disabled_tests
+TEST_F(FastMathTest, DISABLED_Benchmark) {
+    const int count = 2000000;
+    volatile float sink;
+    float acc;
+    clock_t start;
+
+#define FASTMATH_TIME(name, libm, fast) \
+    acc   = 0.0f; start = clock(); \
+    for (int n = 0; n < count; n++) { float x = n * (1.0f / count) + 0.1f; acc += libm; } \
+    sink  = acc; \
+    double t_libm = (double)(clock() - start) / CLOCKS_PER_SEC; \
+    acc   = 0.0f; start = clock(); \
+    for (int n = 0; n < count; n++) { float x = n * (1.0f / count) + 0.1f; acc += fast; } \
+    sink  = acc; \
+    printf("%-8s libm %.3fs  fast %.3fs\n", name, t_libm, (double)(clock() - start) / CLOCKS_PER_SEC);
+
+    {
+        FASTMATH_TIME("atan2", atan2f(x, 1.0f - x), fast_atan2f(x, 1.0f - x));
+    }
+    {
+        FASTMATH_TIME("asin", asinf(x - 0.5f), fast_asinf(x - 0.5f));
+    }
+    {
+        FASTMATH_TIME("sin+cos", sinf(x) + cosf(x), ({ float s, c; fast_sincosf(x, &s, &c); s + c; }));
+    }
+    {
+        FASTMATH_TIME("1/sqrt", 1.0f / sqrtf(x), fast_rsqrtf(x));
+    }
+    {
+        FASTMATH_TIME("exp", expf(x), fast_expf(x));
+    }
+    {
+        FASTMATH_TIME("log", logf(x), fast_logf(x));
+    }
+#undef FASTMATH_TIME
+    (void)sink;
+}
+
+// Biquad filter bank
+class BiquadTest : public testing::Test {
+protected:
+    static const float rate;
+
+    // RMS gain of the bank for a sine of frequency f on every axis, after settling
+    static float gain(struct biquad_bank *bank, float f)
+    {
+        double sum2 = 0.0;
+        const float zero[BIQUAD_AXES] = { 0.0f, 0.0f, 0.0f };
+
+        biquad_bank_reset(bank, zero);
+        for (int n = 0; n < 4000; n++) {
+            float x = sinf(M_2PI_F * f * n / rate);
+            float v[BIQUAD_AXES] = { x, -x, 0.5f * x };
+            biquad_bank_apply(bank, v);
+            if (n >= 2000) {
+                sum2 += 2.0 * v[0] * v[0];
+                EXPECT_FLOAT_EQ(-v[0], v[1]);
+                EXPECT_NEAR(0.5f * v[0], v[2], 1e-6f);
+            }
+        }
+        return sqrt(sum2 / 2000);
+    }
+};
+
+const float BiquadTest::rate = 1000.0f;
+
+TEST_F(BiquadTest, EmptyBankPassesThrough) {
+    struct biquad_bank bank;
+    float v[BIQUAD_AXES] = { 1.0f, -2.0f, 3.0f };
+
+    biquad_bank_clear(&bank);
+    biquad_bank_apply(&bank, v);
+    EXPECT_EQ(1.0f, v[0]);
+    EXPECT_EQ(-2.0f, v[1]);
+    EXPECT_EQ(3.0f, v[2]);
+}
+
+TEST_F(BiquadTest, ButterworthLowPass) {
+    struct biquad_bank bank;
+
+    biquad_bank_clear(&bank);
+    ASSERT_TRUE(biquad_bank_add_butterworth(&bank, rate, 100.0f, 2));
+    EXPECT_EQ(1, bank.stages);
+    EXPECT_NEAR(1.0f, gain(&bank, 5.0f), 0.01f);
+    EXPECT_NEAR(M_SQRT1_2_F, gain(&bank, 100.0f), 0.01f);
+    EXPECT_LT(gain(&bank, 400.0f), 0.05f);
+
+    // fourth order is still -3dB at the cutoff, and steeper
+    biquad_bank_clear(&bank);
+    ASSERT_TRUE(biquad_bank_add_butterworth(&bank, rate, 100.0f, 4));
+    EXPECT_EQ(2, bank.stages);
+    EXPECT_NEAR(1.0f, gain(&bank, 5.0f), 0.01f);
+    EXPECT_NEAR(M_SQRT1_2_F, gain(&bank, 100.0f), 0.01f);
+    EXPECT_LT(gain(&bank, 400.0f), 0.005f);
+
+    // invalid cutoffs and orders leave the bank alone
+    EXPECT_FALSE(biquad_bank_add_butterworth(&bank, rate, 600.0f, 2));
+    EXPECT_FALSE(biquad_bank_add_butterworth(&bank, rate, 100.0f, 1));
+    EXPECT_FALSE(biquad_bank_add_butterworth(&bank, rate, 100.0f, 6));
+    EXPECT_EQ(2, bank.stages);
+}
+
+TEST_F(BiquadTest, Notch) {
+    struct biquad_bank bank;
+    struct biquad_stage notch;
+
+    biquad_bank_clear(&bank);
+    ASSERT_TRUE(biquad_notch(&notch, rate, 150.0f, 40.0f));
+    EXPECT_EQ(0, biquad_bank_add(&bank, &notch));
+    EXPECT_LT(gain(&bank, 150.0f), 0.01f);
+    EXPECT_NEAR(M_SQRT1_2_F, gain(&bank, 130.0f), 0.03f);
+    EXPECT_NEAR(M_SQRT1_2_F, gain(&bank, 170.0f), 0.03f);
+    EXPECT_NEAR(1.0f, gain(&bank, 20.0f), 0.01f);
+    EXPECT_NEAR(1.0f, gain(&bank, 400.0f), 0.01f);
+
+    // retuned in place, as the dynamic notch does
+    ASSERT_TRUE(biquad_notch(&bank.stage[0], rate, 200.0f, 40.0f));
+    EXPECT_LT(gain(&bank, 200.0f), 0.01f);
+    EXPECT_GT(gain(&bank, 150.0f), 0.8f);
+    EXPECT_FALSE(biquad_notch(&bank.stage[0], rate, 0.0f, 40.0f));
+}
+
+TEST_F(BiquadTest, ResetToSteadyState) {
+    struct biquad_bank bank;
+    struct biquad_stage notch;
+    const float level[BIQUAD_AXES] = { 100.0f, -20.0f, 0.0f };
+
+    biquad_bank_clear(&bank);
+    biquad_bank_add_butterworth(&bank, rate, 50.0f, 4);
+    biquad_notch(&notch, rate, 120.0f, 30.0f);
+    biquad_bank_add(&bank, &notch);
+    biquad_bank_reset(&bank, level);
+    for (int n = 0; n < 100; n++) {
+        float v[BIQUAD_AXES] = { level[0], level[1], level[2] };
+        biquad_bank_apply(&bank, v);
+        EXPECT_NEAR(level[0], v[0], 1e-3f);
+        EXPECT_NEAR(level[1], v[1], 1e-3f);
+        EXPECT_EQ(0.0f, v[2]);
+    }
+}
+
+TEST_F(BiquadTest, BankIsBounded) {
+    struct biquad_bank bank;
+    struct biquad_stage notch;
+
+    biquad_bank_clear(&bank);
+    biquad_notch(&notch, rate, 100.0f, 20.0f);
+    for (int i = 0; i < BIQUAD_MAX_STAGES; i++) {
+        EXPECT_EQ(i, biquad_bank_add(&bank, &notch));
+    }
+    EXPECT_EQ(-1, biquad_bank_add(&bank, &notch));
+    EXPECT_EQ(BIQUAD_MAX_STAGES, bank.stages);
+}
+
+class FFTTest : public testing::Test {
+protected:
+    static const uint16_t n = 64;
+    float twiddle[n];
+    struct fft_plan plan;
+
+    virtual void SetUp()
+    {
+        ASSERT_TRUE(fft_plan_init(&plan, n, twiddle));
+    }
+};
+
+TEST_F(FFTTest, RejectsUnsupportedLength) {
+    struct fft_plan p;
+    float t[48];
+
+    EXPECT_FALSE(fft_plan_init(&p, 2, t));
+    EXPECT_FALSE(fft_plan_init(&p, 48, t));
+    EXPECT_FALSE(fft_plan_init(&p, 64, NULL));
+    EXPECT_TRUE(fft_plan_init(&p, 4, t));
+}
+
+TEST_F(FFTTest, MatchesDFT) {
+    float data[2 * n];
+    float input[2 * n];
+
+    srand(1);
+    for (int i = 0; i < 2 * n; i++) {
+        input[i] = data[i] = (float)rand() / RAND_MAX - 0.5f;
+    }
+    fft_complex(&plan, data);
+
+    for (int k = 0; k < n; k++) {
+        double re = 0.0, im = 0.0;
+        for (int i = 0; i < n; i++) {
+            const double a = -2.0 * M_PI * i * k / n;
+            re += input[2 * i] * cos(a) - input[2 * i + 1] * sin(a);
+            im += input[2 * i] * sin(a) + input[2 * i + 1] * cos(a);
+        }
+        EXPECT_NEAR(re, data[2 * k], 1e-4);
+        EXPECT_NEAR(im, data[2 * k + 1], 1e-4);
+    }
+}
+
+TEST_F(FFTTest, RealPairMagnitude) {
+    float data[2 * n];
+    float magA[n / 2 + 1];
+    float magB[n / 2 + 1];
+
+    // two real signals in one transform, on bins 5 and 12
+    for (int i = 0; i < n; i++) {
+        data[2 * i]     = 3.0f * cosf(2.0f * M_PI_F * 5 * i / n);
+        data[2 * i + 1] = 0.5f * sinf(2.0f * M_PI_F * 12 * i / n) + 1.0f;
+    }
+    fft_complex(&plan, data);
+    fft_real_pair_magnitude(&plan, data, magA, magB);
+
+    for (int k = 0; k <= n / 2; k++) {
+        EXPECT_NEAR(k == 5 ? 3.0f * n / 2 : 0.0f, magA[k], 1e-3f);
+        EXPECT_NEAR(k == 12 ? 0.5f * n / 2 : (k == 0 ? n : 0.0f), magB[k], 1e-3f);
+    }
+}
+
+class SysIdentTest : public testing::Test {
+protected:
+    static const float dT;
+    struct sysident id;
+
+    virtual void SetUp()
+    {
+        sysident_init(&id);
+    }
+
+    // discretised tau dy/dt = -y + gain u(t - delay samples) + offset, driven by random steps
+    void simulate(float gain, float tau, int delay, float offset, float noise, int samples)
+    {
+        const float a = expf(-dT / tau);
+        float u[16] = { 0 };
+        float y     = 0.0f;
+        uint32_t seed = 12345;
+
+        for (int k = 0; k < samples; k++) {
+            y = a * y + (1.0f - a) * (gain * u[delay] + offset);
+            for (int i = 15; i > 0; i--) {
+                u[i] = u[i - 1];
+            }
+            if (k % 25 == 0) {
+                seed = seed * 1103515245u + 12345u;
+                u[0] = ((seed >> 16) & 0xff) / 127.5f - 1.0f;
+            }
+            seed = seed * 1103515245u + 12345u;
+            const float n = noise * (((seed >> 16) & 0xff) / 127.5f - 1.0f);
+            sysident_update(&id, 0.999f, u[0], y + n);
+        }
+    }
+};
+
+const float SysIdentTest::dT = 0.002f;
+
+TEST_F(SysIdentTest, FirstOrderWithDelay) {
+    struct sysident_model model;
+
+    simulate(500.0f, 0.05f, 3, 20.0f, 0.0f, 5000);
+    ASSERT_TRUE(sysident_model(&id, dT, &model));
+    EXPECT_NEAR(500.0f, model.gain, 1.0f);
+    EXPECT_NEAR(0.05f, model.tau, 1e-4f);
+    EXPECT_FLOAT_EQ(3 * dT, model.delay);
+    EXPECT_GT(model.fit, 0.99f);
+    EXPECT_LT(model.uncertainty, 0.01f);
+}
+
+TEST_F(SysIdentTest, NoisyOutput) {
+    struct sysident_model model;
+
+    simulate(300.0f, 0.03f, 5, 0.0f, 2.0f, 10000);
+    ASSERT_TRUE(sysident_model(&id, dT, &model));
+    EXPECT_NEAR(300.0f, model.gain, 30.0f);
+    EXPECT_NEAR(0.03f, model.tau, 0.005f);
+    EXPECT_FLOAT_EQ(5 * dT, model.delay);
+    EXPECT_LT(model.uncertainty, 0.1f);
+}
+
+TEST_F(SysIdentTest, NeedsExcitation) {
+    struct sysident_model model;
+
+    EXPECT_FALSE(sysident_model(&id, dT, &model));
+    for (int k = 0; k < 1000; k++) {
+        sysident_update(&id, 0.99f, 0.0f, 10.0f);
+    }
+    EXPECT_FALSE(sysident_model(&id, dT, &model));
+    // the forgetting does not wind up the covariance
+    for (int i = 0; i < SYSIDENT_PARAMS; i++) {
+        EXPECT_LT(id.rls[0].P[i][i], 1e6f);
+    }
+}
+
+class MagFitTest : public testing::Test {
+protected:
+    struct magfit fit;
+
+    virtual void SetUp()
+    {
+        magfit_init(&fit);
+    }
+
+    // the unit field seen through a hard iron offset and gains, over directions
+    // spread on the sphere, or on a cone of the given inclination for a level flight
+    void feed(const float center[3], const float gain[3], float noise, int samples, bool level)
+    {
+        uint32_t seed = 54321;
+
+        for (int k = 0; k < samples; k++) {
+            const float z   = level ? -0.8f : 1.0f - 2.0f * (k + 0.5f) / samples;
+            const float r   = sqrtf(1.0f - z * z);
+            const float a   = k * 2.39996323f; // golden angle
+            const float b[3] = { r * cosf(a), r * sinf(a), z };
+            float mag[3];
+            for (int i = 0; i < 3; i++) {
+                seed   = seed * 1103515245u + 12345u;
+                mag[i] = center[i] + gain[i] * b[i] + noise * (((seed >> 16) & 0xff) / 127.5f - 1.0f);
+            }
+            magfit_update(&fit, 0.999f, mag);
+        }
+    }
+};
+
+TEST_F(MagFitTest, HardAndSoftIron) {
+    const float center[3] = { 0.3f, -0.2f, 0.1f };
+    const float gain[3]   = { 1.1f, 0.9f, 1.05f };
+    struct magfit_solution solution;
+
+    feed(center, gain, 0.0f, 2000, false);
+    ASSERT_TRUE(magfit_solution(&fit, &solution));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_NEAR(center[i], solution.center[i], 1e-3f);
+        EXPECT_NEAR(gain[i], solution.radius[i], 1e-3f);
+    }
+    EXPECT_LT(solution.residual, 0.01f);
+    EXPECT_EQ(8, solution.coverage);
+}
+
+TEST_F(MagFitTest, NoisySamples) {
+    const float center[3] = { -0.4f, 0.1f, 0.25f };
+    const float gain[3]   = { 0.95f, 1.0f, 1.1f };
+    struct magfit_solution solution;
+
+    feed(center, gain, 0.02f, 4000, false);
+    ASSERT_TRUE(magfit_solution(&fit, &solution));
+    for (int i = 0; i < 3; i++) {
+        EXPECT_NEAR(center[i], solution.center[i], 0.02f);
+        EXPECT_NEAR(gain[i], solution.radius[i], 0.02f);
+    }
+    EXPECT_LT(solution.residual, 0.05f);
+}
+
+TEST_F(MagFitTest, SteadyAttitudeIsTakenOnce) {
+    const float mag[3] = { 0.5f, 0.2f, -0.8f };
+
+    for (int k = 0; k < 1000; k++) {
+        magfit_update(&fit, 0.99f, mag);
+    }
+    EXPECT_EQ(1u, fit.samples);
+}
+
+TEST_F(MagFitTest, LevelFlightCoverage) {
+    const float center[3] = { 0.1f, 0.1f, 0.0f };
+    const float gain[3]   = { 1.0f, 1.0f, 1.0f };
+    struct magfit_solution solution;
+
+    // turning in level flight only sees the lower half of the sphere
+    feed(center, gain, 0.0f, 1000, true);
+    ASSERT_TRUE(magfit_solution(&fit, &solution));
+    EXPECT_LE(solution.coverage, 4);
+    // the forgetting does not wind up the covariance
+    for (int i = 0; i < MAGFIT_PARAMS; i++) {
+        EXPECT_LT(fit.P[i][i], 1e4f);
+    }
+}
+
+class WorldMagModelTest : public testing::Test {};
+
+TEST_F(WorldMagModelTest, MatchesReference) {
+    // from the former implementation of the NOAA code, in milliGauss
+    static const struct {
+        float    lat, lon, alt;
+        uint16_t month, day, year;
+        float    B[3];
+    } ref[] = {
+        { 65.0f,  -20.0f,  0.0f,    5,  5,  2012, { 123.1659f, -32.3766f, 508.6807f }  },
+        { 45.5f,  9.2f,    1000.0f, 6,  15, 2013, { 224.8808f, 7.3464f,   415.7512f }  },
+        { -33.9f, 151.2f,  0.0f,    1,  1,  2011, { 241.7419f, 53.8042f,  -515.2314f } },
+        { -80.0f, -179.5f, 3000.0f, 12, 31, 2014, { -77.2917f, 92.4652f,  -596.8715f } },
+    };
+
+    for (unsigned i = 0; i < length(ref); i++) {
+        float B[3];
+        ASSERT_EQ(0, WMM_GetMagVector(ref[i].lat, ref[i].lon, ref[i].alt, ref[i].month, ref[i].day, ref[i].year, B));
+        for (int j = 0; j < 3; j++) {
+            EXPECT_NEAR(ref[i].B[j], B[j], 0.01f);
+        }
+    }
+}
+
+TEST_F(WorldMagModelTest, RejectsInvalidInputs) {
+    float B[3];
+
+    EXPECT_EQ(-2, WMM_GetMagVector(90.5f, 0.0f, 0.0f, 5, 5, 2012, B));
+    EXPECT_EQ(-3, WMM_GetMagVector(0.0f, -181.0f, 0.0f, 5, 5, 2012, B));
+    EXPECT_EQ(-8, WMM_GetMagVector(0.0f, 0.0f, 0.0f, 13, 5, 2012, B));
+    EXPECT_EQ(-8, WMM_GetMagVectorCached(0.0f, 0.0f, 0.0f, 2, 30, 2012, B));
+    EXPECT_EQ(0, WMM_GetMagVector(0.0f, 0.0f, 0.0f, 2, 29, 2012, B));
+}
+
+TEST_F(WorldMagModelTest, CachedFollowsDirect) {
+    float B[3], Bc[3];
+
+    // a flight wandering across cells, the date line and up to the pole
+    for (int k = 0; k <= 2000; k++) {
+        float lat = 60.0f + 30.0f * k / 2000.0f;
+        float lon = 179.0f + 0.001f * k;
+        float alt = 2.0f * k;
+        if (lon > 180.0f) {
+            lon -= 360.0f;
+        }
+        ASSERT_EQ(0, WMM_GetMagVector(lat, lon, alt, 3, 1, 2014, B));
+        ASSERT_EQ(0, WMM_GetMagVectorCached(lat, lon, alt, 3, 1, 2014, Bc));
+        float norm = sqrtf(B[0] * B[0] + B[1] * B[1] + B[2] * B[2]);
+        for (int j = 0; j < 3; j++) {
+            EXPECT_NEAR(B[j], Bc[j], 1e-3f * norm);
+        }
+    }
+}
@@ -0,0 +1,7 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,188 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* rand */
+#include <string.h> /* memcmp */
+#include <time.h> /* clock */
+
+extern "C" {
+#include "ecc.h"
+}
+
+// The plain bytewise codec the table driven one replaced, as a reference
+static void ref_genpoly(int npar, int gen[])
+{
+    memset(gen, 0, sizeof(int) * (npar + 1));
+    gen[0] = 1;
+    for (int i = 1; i <= npar; i++) {
+        // gen *= (x + a^i)
+        for (int j = i; j > 0; j--) {
+            gen[j] = gen[j - 1] ^ gmult(gen[j], gexp[i]);
+        }
+        gen[0] = gmult(gen[0], gexp[i]);
+    }
+}
+
+static void ref_encode(const unsigned char msg[], int nbytes, int npar, unsigned char dst[])
+{
+    int gen[MAXDEG + 1];
+    int lfsr[MAXDEG + 1] = { 0 };
+
+    ref_genpoly(npar, gen);
+    for (int i = 0; i < nbytes; i++) {
+        int dbyte = msg[i] ^ lfsr[npar - 1];
+        for (int j = npar - 1; j > 0; j--) {
+            lfsr[j] = lfsr[j - 1] ^ gmult(gen[j], dbyte);
+        }
+        lfsr[0] = gmult(gen[0], dbyte);
+    }
+    memmove(dst, msg, nbytes);
+    for (int i = 0; i < npar; i++) {
+        dst[nbytes + i] = lfsr[npar - 1 - i];
+    }
+}
+
+static void ref_syndrome(const unsigned char data[], int nbytes, int npar, int syn[])
+{
+    for (int j = 0; j < npar; j++) {
+        int sum = 0;
+        for (int i = 0; i < nbytes; i++) {
+            sum = data[i] ^ gmult(gexp[j + 1], sum);
+        }
+        syn[j] = sum;
+    }
+}
+
+static void fill_random(unsigned char *buf, int len)
+{
+    for (int i = 0; i < len; i++) {
+        // Plenty of zeros, they take the special cases
+        buf[i] = (rand() % 4) ? rand() : 0;
+    }
+}
+
+class RSCodeTest : public testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        initialize_ecc();
+        srand(1);
+    }
+
+    virtual void TearDown()
+    {
+        set_ecc_parity(RS_ECC_NPARITY);
+    }
+};
+
+TEST_F(RSCodeTest, EncodeMatchesReference) {
+    unsigned char msg[255], ref[255], out[255];
+
+    for (int npar = 2; npar <= RS_ECC_NPARITY; npar += 2) {
+        set_ecc_parity(npar);
+        for (int len = 1; len <= 255 - npar; len++) {
+            fill_random(msg, len);
+            ref_encode(msg, len, npar, ref);
+            encode_data(msg, len, out);
+            ASSERT_EQ(0, memcmp(ref, out, len + npar)) << "npar " << npar << " len " << len;
+        }
+    }
+}
+
+TEST_F(RSCodeTest, SyndromeMatchesReference) {
+    unsigned char data[255];
+    int syn[MAXDEG];
+
+    for (int npar = 2; npar <= RS_ECC_NPARITY; npar += 2) {
+        set_ecc_parity(npar);
+        for (int len = 1; len <= 255; len++) {
+            fill_random(data, len);
+            ref_syndrome(data, len, npar, syn);
+            decode_data(data, len);
+            for (int j = 0; j < npar; j++) {
+                ASSERT_EQ(syn[j], synBytes[j]) << "npar " << npar << " len " << len << " root " << j;
+            }
+            for (int j = npar; j < MAXDEG; j++) {
+                ASSERT_EQ(0, synBytes[j]);
+            }
+        }
+    }
+}
+
+TEST_F(RSCodeTest, CleanCodewordHasZeroSyndrome) {
+    unsigned char msg[64], code[64 + RS_ECC_NPARITY];
+
+    for (int npar = 2; npar <= RS_ECC_NPARITY; npar += 2) {
+        set_ecc_parity(npar);
+        fill_random(msg, sizeof(msg));
+        encode_data(msg, sizeof(msg), code);
+        decode_data(code, sizeof(msg) + npar);
+        EXPECT_EQ(0, check_syndrome());
+        // Nothing to correct, the codeword is left alone
+        EXPECT_EQ(0, correct_errors_erasures(code, sizeof(msg) + npar, 0, 0));
+        EXPECT_EQ(0, memcmp(msg, code, sizeof(msg)));
+    }
+}
+
+TEST_F(RSCodeTest, CorrectsUpToHalfTheParity) {
+    unsigned char msg[255], code[255];
+
+    for (int n = 0; n < 2000; n++) {
+        int npar = 2 * (1 + rand() % (RS_ECC_NPARITY / 2));
+        int len  = 1 + rand() % (255 - npar);
+        set_ecc_parity(npar);
+        fill_random(msg, len);
+        encode_data(msg, len, code);
+
+        int errors = 1 + rand() % (npar / 2);
+        for (int e = 0; e < errors; e++) {
+            code[rand() % (len + npar)] ^= 1 + rand() % 255;
+        }
+        decode_data(code, len + npar);
+        if (check_syndrome()) {
+            ASSERT_EQ(1, correct_errors_erasures(code, len + npar, 0, 0));
+        }
+        ASSERT_EQ(0, memcmp(msg, code, len)) << "npar " << npar << " len " << len;
+    }
+}
+
+// Host side timings of the reference and table driven codecs,
+// run with --gtest_also_run_disabled_tests
+TEST_F(RSCodeTest, DISABLED_Benchmark) {
+    const int packets = 20000;
+    const int len     = 64;
+    unsigned char msg[len], code[len + RS_ECC_NPARITY];
+    int syn[MAXDEG];
+    clock_t start;
+
+    fill_random(msg, len);
+
+    start = clock();
+    for (int n = 0; n < packets; n++) {
+        ref_encode(msg, len, RS_ECC_NPARITY, code);
+    }
+    double ref_enc = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int n = 0; n < packets; n++) {
+        encode_data(msg, len, code);
+    }
+    double enc = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int n = 0; n < packets; n++) {
+        ref_syndrome(code, len + RS_ECC_NPARITY, RS_ECC_NPARITY, syn);
+    }
+    double ref_syn = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (int n = 0; n < packets; n++) {
+        decode_data(code, len + RS_ECC_NPARITY);
+        correct_errors_erasures(code, len + RS_ECC_NPARITY, 0, 0);
+    }
+    double dec = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("%d packets of %d bytes, %d parity bytes\n", packets, len, RS_ECC_NPARITY);
+    printf("encode   reference %.3fs  tables %.3fs\n", ref_enc, enc);
+    printf("syndrome reference %.3fs  tables %.3fs (clean packets, with the correction call)\n", ref_syn, dec);
+}
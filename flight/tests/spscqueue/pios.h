@@ -0,0 +1,12 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pios_mem.h"
+#include "pios_spscqueue.h"
+
+#endif /* PIOS_H */
@@ -0,0 +1,113 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* abort */
+#include <string.h> /* memset */
+#include <pthread.h>
+#include <sched.h> /* sched_yield */
+
+extern "C" {
+#include "pios.h"
+}
+
+struct item {
+    uint32_t sequence;
+    uint32_t check;
+};
+
+class SPSCQueue : public testing::Test {};
+
+TEST_F(SPSCQueue, CreateRejectsInvalidSizes) {
+    EXPECT_TRUE(PIOS_SPSCQUEUE_Create(0, sizeof(item)) == NULL);
+    EXPECT_TRUE(PIOS_SPSCQUEUE_Create(4, 0) == NULL);
+    EXPECT_TRUE(PIOS_SPSCQUEUE_Create(0x8001, 1) == NULL);
+}
+
+TEST_F(SPSCQueue, LengthIsRoundedUpToPowerOfTwo) {
+    pios_spscqueue_t queue = PIOS_SPSCQUEUE_Create(5, sizeof(item));
+    item in = { 0, 0 };
+
+    ASSERT_TRUE(queue != NULL);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(PIOS_SPSCQUEUE_Send(queue, &in));
+    }
+    EXPECT_FALSE(PIOS_SPSCQUEUE_Send(queue, &in));
+    EXPECT_EQ(8, PIOS_SPSCQUEUE_Count(queue));
+    free(queue);
+}
+
+TEST_F(SPSCQueue, EmptyQueueReceivesNothing) {
+    pios_spscqueue_t queue = PIOS_SPSCQUEUE_Create(4, sizeof(item));
+    item out;
+
+    ASSERT_TRUE(queue != NULL);
+    EXPECT_FALSE(PIOS_SPSCQUEUE_Receive(queue, &out));
+    EXPECT_EQ(0, PIOS_SPSCQUEUE_Count(queue));
+    free(queue);
+}
+
+TEST_F(SPSCQueue, ItemsKeepTheirOrderOverWrapAround) {
+    pios_spscqueue_t queue = PIOS_SPSCQUEUE_Create(4, sizeof(item));
+    uint32_t sent = 0, received = 0;
+
+    ASSERT_TRUE(queue != NULL);
+    // three in, two out, so the indices wrap around many times
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 3; i++) {
+            item in = { sent, ~sent };
+            if (PIOS_SPSCQUEUE_Send(queue, &in)) {
+                sent++;
+            }
+        }
+        for (int i = 0; i < 2; i++) {
+            item out;
+            ASSERT_TRUE(PIOS_SPSCQUEUE_Receive(queue, &out));
+            EXPECT_EQ(received, out.sequence);
+            EXPECT_EQ(~received, out.check);
+            received++;
+        }
+        EXPECT_EQ(sent - received, PIOS_SPSCQUEUE_Count(queue));
+    }
+    free(queue);
+}
+
+#define STRESS_ITEMS 1000000
+
+static void *producer(void *arg)
+{
+    pios_spscqueue_t queue = (pios_spscqueue_t)arg;
+
+    for (uint32_t sequence = 0; sequence < STRESS_ITEMS;) {
+        item in = { sequence, ~sequence };
+        if (PIOS_SPSCQUEUE_Send(queue, &in)) {
+            sequence++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+TEST_F(SPSCQueue, ConcurrentProducerAndConsumer) {
+    pios_spscqueue_t queue = PIOS_SPSCQUEUE_Create(16, sizeof(item));
+    pthread_t thread;
+    uint32_t errors = 0;
+
+    ASSERT_TRUE(queue != NULL);
+    ASSERT_EQ(0, pthread_create(&thread, NULL, producer, queue));
+    for (uint32_t sequence = 0; sequence < STRESS_ITEMS;) {
+        item out;
+        if (PIOS_SPSCQUEUE_Receive(queue, &out)) {
+            if (out.sequence != sequence || out.check != ~sequence) {
+                errors++;
+            }
+            sequence++;
+        } else {
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+    EXPECT_EQ(0u, errors);
+    EXPECT_EQ(0, PIOS_SPSCQUEUE_Count(queue));
+    free(queue);
+}
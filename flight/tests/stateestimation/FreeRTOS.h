@@ -0,0 +1,44 @@
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define pvPortMalloc(xSize) (malloc(xSize))
+#define vPortFree(pv)       (free(pv))
+
+#define pdFALSE             0
+#define pdTRUE              1
+#define portMAX_DELAY       0xffffffff
+#define portTICK_RATE_MS    1
+#define tskIDLE_PRIORITY    0
+
+typedef uint32_t portTickType;
+typedef void *xSemaphoreHandle;
+typedef void *xQueueHandle;
+
+/* the replay is single threaded, locks always succeed */
+static inline xSemaphoreHandle xSemaphoreCreateRecursiveMutex(void)
+{
+    return (xSemaphoreHandle)1;
+}
+
+static inline int32_t xSemaphoreTakeRecursive(__attribute__((unused)) xSemaphoreHandle mutex, __attribute__((unused)) portTickType ticks)
+{
+    return pdTRUE;
+}
+
+static inline int32_t xSemaphoreGiveRecursive(__attribute__((unused)) xSemaphoreHandle mutex)
+{
+    return pdTRUE;
+}
+
+static inline int32_t xQueueSend(__attribute__((unused)) xQueueHandle queue, __attribute__((unused)) const void *item, __attribute__((unused)) portTickType ticks)
+{
+    return pdTRUE;
+}
+
+/* ticks of the simulated clock of the replay */
+portTickType xTaskGetTickCount(void);
+
+#endif /* FREERTOS_H */
@@ -0,0 +1,15 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+#include <stdbool.h>
+
+#include <pios.h>
+
+#include <utlist.h>
+#include <uavobjectmanager.h>
+#include <eventdispatcher.h>
+
+#include "alarms.h"
+#include <mathmisc.h>
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,34 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* a failed assert ends the replay instead of hanging it */
+#define PIOS_Assert(x) \
+    if (!(x)) { abort(); \
+    }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+#define PIOS_STATIC_ASSERT(test) ((void)sizeof(int[1 - 2 * !(test)]))
+
+/* PIOS Feature Selection */
+#include "pios_config.h"
+
+#ifdef PIOS_INCLUDE_FREERTOS
+/* FreeRTOS Includes */
+#include "FreeRTOS.h"
+#endif
+#include "pios_mem.h"
+
+#include <pios_math.h>
+#include <pios_crc.h>
+#include <pios_delay.h>
+#include <pios_deltatime.h>
+#include <pios_callbackscheduler.h>
+#include <pios_notify.h>
+#include <pios_debuglog.h>
+
+#endif /* PIOS_H */
@@ -0,0 +1,12 @@
+#ifndef PIOS_CONFIG_H
+#define PIOS_CONFIG_H
+
+#define PIOS_INCLUDE_FREERTOS
+
+/* the complementary filter waits for the mag of the revolution */
+#define PIOS_INCLUDE_HMC5X83
+
+/* board sensor rate of the revolution */
+#define PIOS_SENSOR_RATE 500.0f
+
+#endif /* PIOS_CONFIG_H */
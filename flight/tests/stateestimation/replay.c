@@ -0,0 +1,417 @@
+/*
+ * The filter chains of stateestimation.c on a simulated clock. The board only
+ * pieces the filters use are stubbed here: the clock, callbacks and events.
+ */
+
+#include <time.h>
+
+#include <openpilot.h>
+#include <stateestimation.h>
+#include <CoordinateConversions.h>
+
+#include <accelsensor.h>
+#include <altitudefiltersettings.h>
+#include <attitudesettings.h>
+#include <attitudestate.h>
+#include <auxmagsettings.h>
+#include <barosensor.h>
+#include <ekfconfiguration.h>
+#include <ekfstatevariance.h>
+#include <flightstatus.h>
+#include <gpspositionsensor.h>
+#include <gpssettings.h>
+#include <gpsvelocitysensor.h>
+#include <gyrosensor.h>
+#include <homelocation.h>
+#include <magsensor.h>
+#include <revocalibration.h>
+#include <revosettings.h>
+
+#include "replay.h"
+
+// the clock keeps running over replays, the gap keeps the time stamps of two runs apart
+#define RUN_GAP_US 10000000
+
+#define MAX_CALLBACKS 4
+
+struct DelayedCallbackInfoStruct {
+    DelayedCallback cb;
+    bool pending;
+};
+
+static struct DelayedCallbackInfoStruct callbacks[MAX_CALLBACKS];
+static uint8_t callbackCount;
+
+static uint64_t clockUs;
+static uint64_t runStartUs;
+
+static stateFilter magFilter;
+static stateFilter airFilter;
+static stateFilter llaFilter;
+static stateFilter baroFilter;
+static stateFilter altitudeFilter;
+static stateFilter cfmFilter;
+static stateFilter ekf13Filter;
+static stateFilter velocityFilter;
+
+struct pipelineStage {
+    const char  *name;
+    stateFilter *filter;
+};
+
+// the cfmQueue and ekf13Queue of stateestimation.c
+static const struct pipelineStage cfmPipeline[] = {
+    { "mag",      &magFilter      },
+    { "air",      &airFilter      },
+    { "lla",      &llaFilter      },
+    { "baro",     &baroFilter     },
+    { "altitude", &altitudeFilter },
+    { "cfm",      &cfmFilter      },
+    { NULL,       NULL            },
+};
+
+static const struct pipelineStage ekf13Pipeline[] = {
+    { "mag",      &magFilter      },
+    { "air",      &airFilter      },
+    { "lla",      &llaFilter      },
+    { "baro",     &baroFilter     },
+    { "ekf13",    &ekf13Filter    },
+    { "velocity", &velocityFilter },
+    { NULL,       NULL            },
+};
+
+static const struct pipelineStage *pipelines[REPLAY_FUSION_COUNT] = {
+    cfmPipeline,
+    ekf13Pipeline,
+};
+
+static const char *fusionNames[REPLAY_FUSION_COUNT] = {
+    "cfm",
+    "ekf13",
+};
+
+static const struct pipelineStage *pipeline;
+// the filters of the pipeline, then the deferred callbacks
+static struct replay_stage stages[REPLAY_MAX_STAGES];
+static uint8_t stageCount;
+
+static stateEstimation states;
+static sensorUpdates updatedSensors;
+
+static uint64_t cpuTimeNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+/**
+ * Board stubs
+ */
+portTickType xTaskGetTickCount(void)
+{
+    return (portTickType)(clockUs / 1000);
+}
+
+uint32_t PIOS_DELAY_GetRaw()
+{
+    return (uint32_t)clockUs;
+}
+
+uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
+{
+    return (uint32_t)clockUs - raw;
+}
+
+uint32_t PIOS_DELAY_GetuS()
+{
+    return (uint32_t)clockUs;
+}
+
+DelayedCallbackInfo *PIOS_CALLBACKSCHEDULER_Create(DelayedCallback cb,
+                                                   __attribute__((unused)) DelayedCallbackPriority priority,
+                                                   __attribute__((unused)) DelayedCallbackPriorityTask priorityTask,
+                                                   __attribute__((unused)) int16_t callbackID,
+                                                   __attribute__((unused)) uint32_t stacksize)
+{
+    PIOS_Assert(callbackCount < MAX_CALLBACKS);
+    callbacks[callbackCount].cb = cb;
+    callbacks[callbackCount].pending = false;
+    return &callbacks[callbackCount++];
+}
+
+// dispatched callbacks run after the filter chain, as a lower priority task would
+int32_t PIOS_CALLBACKSCHEDULER_Dispatch(DelayedCallbackInfo *cbinfo)
+{
+    cbinfo->pending = true;
+    return 1;
+}
+
+int32_t EventCallbackDispatch(UAVObjEvent *ev, UAVObjEventCallback cb)
+{
+    cb(ev);
+    return pdTRUE;
+}
+
+void PIOS_DEBUGLOG_UAVObject(__attribute__((unused)) uint32_t objid, __attribute__((unused)) uint16_t instid,
+                             __attribute__((unused)) size_t size, __attribute__((unused)) uint8_t *data)
+{}
+
+void PIOS_NOTIFY_StartNotification(__attribute__((unused)) pios_notify_notification notification,
+                                   __attribute__((unused)) pios_notify_priority priority)
+{}
+
+/**
+ * Replay
+ */
+void replay_initialize(void)
+{
+    UAVObjInitialize();
+    AlarmsInitialize();
+
+    AccelSensorInitialize();
+    AttitudeSettingsInitialize();
+    AttitudeStateInitialize();
+    AuxMagSettingsInitialize();
+    BaroSensorInitialize();
+    GPSVelocitySensorInitialize();
+    GyroSensorInitialize();
+    MagSensorInitialize();
+    RevoCalibrationInitialize();
+    RevoSettingsInitialize();
+
+    filterMagInitialize(&magFilter);
+    filterAirInitialize(&airFilter);
+    filterLLAInitialize(&llaFilter);
+    filterBaroInitialize(&baroFilter);
+    filterAltitudeInitialize(&altitudeFilter);
+    filterCFMInitialize(&cfmFilter);
+    filterEKF13Initialize(&ekf13Filter);
+    filterVelocityInitialize(&velocityFilter);
+}
+
+void replay_set_home(int32_t latitude, int32_t longitude, float altitude, const float Be[3])
+{
+    HomeLocationData home;
+
+    HomeLocationGet(&home);
+    home.Latitude  = latitude;
+    home.Longitude = longitude;
+    home.Altitude  = altitude;
+    home.Be[0]     = Be[0];
+    home.Be[1]     = Be[1];
+    home.Be[2]     = Be[2];
+    home.Set = HOMELOCATION_SET_TRUE;
+    HomeLocationSet(&home);
+}
+
+// the sensors module removes the bias, the complementary filter only trusts the mag of calibrated boards
+void replay_set_mag_bias(const float bias[3])
+{
+    float magBias[3] = { bias[0], bias[1], bias[2] };
+
+    RevoCalibrationmag_biasArraySet(magBias);
+}
+
+void replay_set_sensors(const struct replay_sensors *sensors, uint32_t updated)
+{
+    if (updated & REPLAY_SENSOR_GYRO) {
+        GyroSensorData gyro = { .x = sensors->gyro[0], .y = sensors->gyro[1], .z = sensors->gyro[2] };
+        GyroSensorSet(&gyro);
+        updatedSensors |= SENSORUPDATES_gyro;
+    }
+    if (updated & REPLAY_SENSOR_ACCEL) {
+        AccelSensorData accel = { .x = sensors->accel[0], .y = sensors->accel[1], .z = sensors->accel[2] };
+        AccelSensorSet(&accel);
+        updatedSensors |= SENSORUPDATES_accel;
+    }
+    if (updated & REPLAY_SENSOR_MAG) {
+        MagSensorData mag = { .x = sensors->mag[0], .y = sensors->mag[1], .z = sensors->mag[2] };
+        MagSensorSet(&mag);
+        updatedSensors |= SENSORUPDATES_boardMag;
+    }
+    if (updated & REPLAY_SENSOR_BARO) {
+        BaroSensorData baro = { .Altitude = sensors->baro };
+        BaroSensorSet(&baro);
+        updatedSensors |= SENSORUPDATES_baro;
+    }
+    if (updated & REPLAY_SENSOR_GPSVEL) {
+        GPSVelocitySensorData vel = { .North = sensors->vel[0], .East = sensors->vel[1], .Down = sensors->vel[2] };
+        GPSVelocitySensorSet(&vel);
+        updatedSensors |= SENSORUPDATES_vel;
+    }
+    if (updated & REPLAY_SENSOR_GPSPOS) {
+        GPSPositionSensorData pos;
+        GPSPositionSensorGet(&pos);
+        pos.Latitude   = sensors->latitude;
+        pos.Longitude  = sensors->longitude;
+        pos.Altitude   = sensors->altitude;
+        pos.GeoidSeparation = 0.0f;
+        pos.Status     = GPSPOSITIONSENSOR_STATUS_FIX3D;
+        pos.Satellites = 12;
+        pos.PDOP = 1.2f;
+        pos.HDOP = 0.8f;
+        pos.VDOP = 0.9f;
+        GPSPositionSensorSet(&pos);
+        updatedSensors |= SENSORUPDATES_lla;
+    }
+}
+
+/**
+ * Takes an object of a log: settings are applied, sensors are queued for the
+ * next step and anything else, the state estimated on the board included, is
+ * left alone.
+ */
+bool replay_unpack(uint32_t objId, const uint8_t *data, uint16_t length, uint32_t *updated)
+{
+    UAVObjHandle obj = UAVObjGetByID(objId);
+
+    if (!obj || UAVObjGetNumBytes(obj) != length) {
+        return false;
+    }
+
+    sensorUpdates sensor;
+    if (objId == GYROSENSOR_OBJID) {
+        sensor   = SENSORUPDATES_gyro;
+        *updated = REPLAY_SENSOR_GYRO;
+    } else if (objId == ACCELSENSOR_OBJID) {
+        sensor   = SENSORUPDATES_accel;
+        *updated = REPLAY_SENSOR_ACCEL;
+    } else if (objId == MAGSENSOR_OBJID) {
+        sensor   = SENSORUPDATES_boardMag;
+        *updated = REPLAY_SENSOR_MAG;
+    } else if (objId == BAROSENSOR_OBJID) {
+        sensor   = SENSORUPDATES_baro;
+        *updated = REPLAY_SENSOR_BARO;
+    } else if (objId == GPSVELOCITYSENSOR_OBJID) {
+        sensor   = SENSORUPDATES_vel;
+        *updated = REPLAY_SENSOR_GPSVEL;
+    } else if (objId == GPSPOSITIONSENSOR_OBJID) {
+        sensor   = SENSORUPDATES_lla;
+        *updated = REPLAY_SENSOR_GPSPOS;
+    } else if (UAVObjIsSettings(obj)) {
+        sensor   = 0;
+        *updated = 0;
+    } else {
+        return false;
+    }
+
+    UAVObjUnpack(obj, 0, data);
+    updatedSensors |= sensor;
+    return true;
+}
+
+void replay_start(enum replay_fusion fusion)
+{
+    clockUs   += RUN_GAP_US;
+    runStartUs = clockUs;
+
+    AttitudeStateSetDefaults(AttitudeStateHandle(), 0);
+    // lowering an alarm waits for the grace time, so the states are reset to their boot values
+    // and the alarms library takes them again from SystemAlarms
+    SystemAlarmsSetDefaults(SystemAlarmsHandle(), 0);
+    AlarmsInitialize();
+    memset(&states, 0, sizeof(states));
+    updatedSensors = 0;
+    for (uint8_t n = 0; n < callbackCount; n++) {
+        callbacks[n].pending = false;
+    }
+
+    pipeline   = pipelines[fusion];
+    memset(stages, 0, sizeof(stages));
+    stageCount = 0;
+    for (const struct pipelineStage *current = pipeline; current->filter; current++) {
+        current->filter->init(current->filter);
+        stages[stageCount++].name = current->name;
+    }
+    stages[stageCount++].name = "callbacks";
+}
+
+#define FETCH_SENSOR_3_DIMENSIONS(sensorname, shortname, a1, a2, a3) \
+    if (IS_SET(states.updated, SENSORUPDATES_##shortname)) { \
+        sensorname##Data s; \
+        sensorname##Get(&s); \
+        if (IS_REAL(s.a1) && IS_REAL(s.a2) && IS_REAL(s.a3)) { \
+            states.shortname[0] = s.a1; \
+            states.shortname[1] = s.a2; \
+            states.shortname[2] = s.a3; \
+        } else { \
+            UNSET_MASK(states.updated, SENSORUPDATES_##shortname); \
+        } \
+    }
+
+/**
+ * One run of the StateEstimation callback: load, filter and save
+ * @return true if the attitude was updated
+ */
+bool replay_step(uint32_t timeUs, struct replay_output *output)
+{
+    clockUs = runStartUs + timeUs;
+    if (!updatedSensors) {
+        return false;
+    }
+
+    states.updated = updatedSensors;
+    updatedSensors = 0;
+
+    FETCH_SENSOR_3_DIMENSIONS(GyroSensor, gyro, x, y, z);
+    FETCH_SENSOR_3_DIMENSIONS(AccelSensor, accel, x, y, z);
+    FETCH_SENSOR_3_DIMENSIONS(MagSensor, boardMag, x, y, z);
+    FETCH_SENSOR_3_DIMENSIONS(GPSVelocitySensor, vel, North, East, Down);
+    if (IS_SET(states.updated, SENSORUPDATES_baro)) {
+        BaroSensorAltitudeGet(&states.baro[0]);
+        if (!IS_REAL(states.baro[0])) {
+            UNSET_MASK(states.updated, SENSORUPDATES_baro);
+        }
+    }
+
+    uint8_t n = 0;
+    for (const struct pipelineStage *current = pipeline; current->filter; current++, n++) {
+        uint64_t start = cpuTimeNs();
+        current->filter->filter(current->filter, &states);
+        stages[n].cpuNs += cpuTimeNs() - start;
+        stages[n].calls++;
+    }
+
+    if (IS_SET(states.updated, SENSORUPDATES_attitude)) {
+        AttitudeStateData s;
+        AttitudeStateGet(&s);
+        s.q1 = states.attitude[0];
+        s.q2 = states.attitude[1];
+        s.q3 = states.attitude[2];
+        s.q4 = states.attitude[3];
+        Quaternion2RPY(&s.q1, &s.Roll);
+        AttitudeStateSet(&s);
+        memcpy(output->attitude, states.attitude, sizeof(output->attitude));
+    }
+    if (IS_SET(states.updated, SENSORUPDATES_pos)) {
+        memcpy(output->pos, states.pos, sizeof(output->pos));
+    }
+    if (IS_SET(states.updated, SENSORUPDATES_vel)) {
+        memcpy(output->vel, states.vel, sizeof(output->vel));
+    }
+
+    for (uint8_t c = 0; c < callbackCount; c++) {
+        if (callbacks[c].pending) {
+            uint64_t start = cpuTimeNs();
+            callbacks[c].pending = false;
+            callbacks[c].cb();
+            stages[n].cpuNs += cpuTimeNs() - start;
+            stages[n].calls++;
+        }
+    }
+
+    return IS_SET(states.updated, SENSORUPDATES_attitude);
+}
+
+uint8_t replay_stages(const struct replay_stage * *list)
+{
+    *list = stages;
+    return stageCount;
+}
+
+const char *replay_fusion_name(enum replay_fusion fusion)
+{
+    return fusionNames[fusion];
+}
@@ -0,0 +1,71 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Runs the filter chains of the StateEstimation module on a simulated clock,
+ * without the module itself. Sensors are set as their UAVObjects, so a replay
+ * sees the same data the module would fetch on the board.
+ */
+
+enum replay_fusion {
+    REPLAY_FUSION_CFM = 0, // complementary filter with mag and GPS
+    REPLAY_FUSION_EKF13, // 13 state INS with GPS
+    REPLAY_FUSION_COUNT
+};
+
+enum replay_sensor {
+    REPLAY_SENSOR_GYRO   = 1 << 0,
+    REPLAY_SENSOR_ACCEL  = 1 << 1,
+    REPLAY_SENSOR_MAG    = 1 << 2,
+    REPLAY_SENSOR_BARO   = 1 << 3,
+    REPLAY_SENSOR_GPSVEL = 1 << 4,
+    REPLAY_SENSOR_GPSPOS = 1 << 5,
+};
+
+struct replay_sensors {
+    float   gyro[3]; // deg/s
+    float   accel[3]; // m/s^2
+    float   mag[3]; // mGa
+    float   baro; // altitude in m
+    float   vel[3]; // NED in m/s
+    int32_t latitude; // degrees x 10^-7
+    int32_t longitude; // degrees x 10^-7
+    float   altitude; // m above the ellipsoid
+};
+
+struct replay_output {
+    float attitude[4];
+    float pos[3];
+    float vel[3];
+};
+
+#define REPLAY_MAX_STAGES 8
+
+struct replay_stage {
+    const char *name;
+    uint32_t   calls;
+    uint64_t   cpuNs;
+};
+
+void replay_initialize(void);
+void replay_set_home(int32_t latitude, int32_t longitude, float altitude, const float Be[3]);
+void replay_set_mag_bias(const float bias[3]);
+void replay_set_sensors(const struct replay_sensors *sensors, uint32_t updated);
+bool replay_unpack(uint32_t objId, const uint8_t *data, uint16_t length, uint32_t *updated);
+void replay_start(enum replay_fusion fusion);
+bool replay_step(uint32_t timeUs, struct replay_output *output);
+uint8_t replay_stages(const struct replay_stage * *stages);
+const char *replay_fusion_name(enum replay_fusion fusion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* REPLAY_H */
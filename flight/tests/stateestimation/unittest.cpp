@@ -0,0 +1,462 @@
+#include "gtest/gtest.h"
+
+#include <stdio.h> /* printf */
+#include <stdlib.h> /* getenv */
+#include <string.h> /* memcpy */
+#include <math.h>
+
+#include <string>
+#include <vector>
+
+#include "replay.h"
+
+extern "C" {
+#include <pios_crc.h>
+}
+
+/*
+ * Regression test of the attitude, position and velocity estimated by the
+ * StateEstimation filter chains.
+ *
+ * A synthetic flight with known truth is replayed through every chain.
+ * Setting STATEESTIMATION_REPLAY_LOG to an OPL telemetry log replays the
+ * sensor objects of the log as well. With STATEESTIMATION_REPLAY_GOLDEN set
+ * to a path prefix the outputs are compared with <prefix>_<replay>_<chain>.csv,
+ * which is written from the current filters when it doesn't exist yet.
+ */
+
+#define DEG2RAD_D           (M_PI / 180.0)
+#define RAD2DEG_D           (180.0 / M_PI)
+
+#define SENSOR_RATE_HZ      500
+#define MAG_DIVIDER         5 // 100Hz
+#define BARO_DIVIDER        10 // 50Hz
+#define GPS_DIVIDER         50 // 10Hz
+#define OUTPUT_DIVIDER      50 // outputs are kept at 10Hz
+
+#define FLIGHT_DURATION_S   180.0
+#define LEVEL_DURATION_S    20.0 // longer than the calibration of the complementary filter
+#define SETTLE_DURATION_S   60.0 // after which outputs are held against truth
+
+#define GRAVITY             9.81
+#define EARTH_RADIUS        6378137.0
+#define BARO_OFFSET         12.5 // between real altitude and baro altitude
+
+// against truth
+#define MAX_ATTITUDE_ERROR  5.0 // deg
+#define MAX_POSITION_ERROR  3.0 // m
+#define MAX_VELOCITY_ERROR  1.0 // m/s
+
+// against golden outputs
+#define MAX_ATTITUDE_CHANGE 0.5 // deg
+#define MAX_POSITION_CHANGE 0.25 // m
+#define MAX_VELOCITY_CHANGE 0.1 // m/s
+
+static const int32_t homeLatitude  = 473977419; // degrees x 10^-7
+static const int32_t homeLongitude = 85455938;
+static const float homeAltitude    = 420.0f;
+static const float homeBe[3] = { 215.0f, 4.5f, 425.0f }; // mGa
+static const float magBias[3] = { 12.0f, -7.0f, 30.0f }; // of a calibrated board, mags are replayed without it
+
+struct outputRecord {
+    uint32_t timeMs;
+    struct replay_output output;
+};
+
+/**
+ * Deterministic noise, the sum of four uniform samples with unit variance
+ */
+class Noise {
+public:
+    Noise() : state(12345) {}
+    double next()
+    {
+        double sum = 0.0;
+
+        for (int n = 0; n < 4; n++) {
+            state = state * 1664525u + 1013904223u;
+            sum  += state / 4294967296.0;
+        }
+        return (sum - 2.0) * sqrt(3.0);
+    }
+
+private:
+    uint32_t state;
+};
+
+struct truth {
+    double rpy[3]; // deg
+    double rates[3]; // body rates in deg/s
+    double pos[3]; // NED in m
+    double vel[3];
+    double accel[3];
+};
+
+/**
+ * Level on the ground, then circling in rolls and pitches while yawing
+ */
+static void trajectory(double t, struct truth *s)
+{
+    double f = t > LEVEL_DURATION_S ? t - LEVEL_DURATION_S : 0.0;
+    double moving = t > LEVEL_DURATION_S ? 1.0 : 0.0;
+
+    s->pos[0]   = 10.0 * (1.0 - cos(0.2 * f));
+    s->vel[0]   = 2.0 * sin(0.2 * f);
+    s->accel[0] = 0.4 * cos(0.2 * f) * moving;
+    s->pos[1]   = 5.0 * (1.0 - cos(0.1 * f));
+    s->vel[1]   = 0.5 * sin(0.1 * f);
+    s->accel[1] = 0.05 * cos(0.1 * f) * moving;
+    s->pos[2]   = -3.0 * (1.0 - cos(0.15 * f));
+    s->vel[2]   = -0.45 * sin(0.15 * f);
+    s->accel[2] = -0.0675 * cos(0.15 * f) * moving;
+
+    double w[3] = { 2.0 * M_PI / 10.0, 2.0 * M_PI / 14.0, 0.0 };
+    s->rpy[0] = 15.0 * sin(w[0] * f);
+    s->rpy[1] = 10.0 * sin(w[1] * f);
+    s->rpy[2] = 30.0 + 10.0 * f;
+    double rate[3] = { 15.0 * w[0] * cos(w[0] * f) * moving, 10.0 * w[1] * cos(w[1] * f) * moving, 10.0 * moving };
+
+    double sr = sin(s->rpy[0] * DEG2RAD_D), cr = cos(s->rpy[0] * DEG2RAD_D);
+    double sp = sin(s->rpy[1] * DEG2RAD_D), cp = cos(s->rpy[1] * DEG2RAD_D);
+    s->rates[0] = rate[0] - rate[2] * sp;
+    s->rates[1] = rate[1] * cr + rate[2] * sr * cp;
+    s->rates[2] = -rate[1] * sr + rate[2] * cr * cp;
+}
+
+static void rpyToRbe(const double rpy[3], double R[3][3])
+{
+    double sr = sin(rpy[0] * DEG2RAD_D), cr = cos(rpy[0] * DEG2RAD_D);
+    double sp = sin(rpy[1] * DEG2RAD_D), cp = cos(rpy[1] * DEG2RAD_D);
+    double sy = sin(rpy[2] * DEG2RAD_D), cy = cos(rpy[2] * DEG2RAD_D);
+
+    R[0][0] = cp * cy;
+    R[0][1] = cp * sy;
+    R[0][2] = -sp;
+    R[1][0] = sr * sp * cy - cr * sy;
+    R[1][1] = sr * sp * sy + cr * cy;
+    R[1][2] = sr * cp;
+    R[2][0] = cr * sp * cy + sr * sy;
+    R[2][1] = cr * sp * sy - sr * cy;
+    R[2][2] = cr * cp;
+}
+
+static void rpyToQuaternion(const double rpy[3], double q[4])
+{
+    double sr = sin(rpy[0] * DEG2RAD_D / 2), cr = cos(rpy[0] * DEG2RAD_D / 2);
+    double sp = sin(rpy[1] * DEG2RAD_D / 2), cp = cos(rpy[1] * DEG2RAD_D / 2);
+    double sy = sin(rpy[2] * DEG2RAD_D / 2), cy = cos(rpy[2] * DEG2RAD_D / 2);
+
+    q[0] = cr * cp * cy + sr * sp * sy;
+    q[1] = sr * cp * cy - cr * sp * sy;
+    q[2] = cr * sp * cy + sr * cp * sy;
+    q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+static double attitudeError(const float q[4], const double truth[4])
+{
+    double dot = fabs(q[0] * truth[0] + q[1] * truth[1] + q[2] * truth[2] + q[3] * truth[3]);
+    double norm = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+
+    if (norm <= 0.0) {
+        return 180.0;
+    }
+    return 2.0 * acos(fmin(1.0, dot / norm)) * RAD2DEG_D;
+}
+
+template<typename T1, typename T2>
+static double distance(const T1 a[3], const T2 b[3])
+{
+    return sqrt((a[0] - b[0]) * (a[0] - b[0]) + (a[1] - b[1]) * (a[1] - b[1]) + (a[2] - b[2]) * (a[2] - b[2]));
+}
+
+/**
+ * OPL telemetry logs: records of a timestamp (4), a size (8) and the bytes
+ */
+struct logObject {
+    uint32_t timeMs;
+    uint32_t objId;
+    std::vector<uint8_t> data;
+};
+
+static bool readLog(const char *fileName, std::vector<logObject> &objects)
+{
+    FILE *file = fopen(fileName, "rb");
+
+    if (!file) {
+        return false;
+    }
+
+    std::vector<uint8_t> stream;
+    std::vector<uint32_t> streamTime;
+    uint32_t timeStamp;
+    int64_t dataSize;
+    while (fread(&timeStamp, sizeof(timeStamp), 1, file) == 1 && fread(&dataSize, sizeof(dataSize), 1, file) == 1) {
+        if (dataSize < 1 || dataSize > 1024 * 1024) {
+            break;
+        }
+        size_t offset = stream.size();
+        stream.resize(offset + dataSize);
+        if (fread(&stream[offset], 1, dataSize, file) != (size_t)dataSize) {
+            stream.resize(offset);
+            break;
+        }
+        streamTime.resize(stream.size(), timeStamp);
+    }
+    fclose(file);
+
+    // plain and multi-object frames, delta frames need the previous image and are not replayed
+    for (size_t n = 0; n + 11 <= stream.size(); n++) {
+        if (stream[n] != 0x3C) {
+            continue;
+        }
+        uint8_t type   = stream[n + 1];
+        uint16_t length = stream[n + 2] | (stream[n + 3] << 8);
+        uint8_t header = (type & 0x80) ? 12 : 10;
+        if (length < header || n + length + 1 > stream.size() || PIOS_CRC_updateCRC(0, &stream[n], length) != stream[n + length]) {
+            continue;
+        }
+        const uint8_t *frame = &stream[n];
+        switch (type & 0x7F) {
+        case 0x20: // object
+        case 0x22: // object with ack
+        {
+            logObject obj = { streamTime[n], (uint32_t)(frame[4] | (frame[5] << 8) | (frame[6] << 16) | (frame[7] << 24)),
+                              std::vector<uint8_t>(frame + header, frame + length) };
+            objects.push_back(obj);
+            break;
+        }
+        case 0x25: // multi-object
+            for (const uint8_t *entry = frame + header; entry + 7 <= frame + length && entry + 7 + entry[6] <= frame + length; entry += 7 + entry[6]) {
+                logObject obj = { streamTime[n], (uint32_t)(entry[0] | (entry[1] << 8) | (entry[2] << 16) | (entry[3] << 24)),
+                                  std::vector<uint8_t>(entry + 7, entry + 7 + entry[6]) };
+                objects.push_back(obj);
+            }
+            break;
+        }
+        n += length;
+    }
+    return true;
+}
+
+static bool readGolden(const std::string &fileName, std::vector<outputRecord> &records)
+{
+    FILE *file = fopen(fileName.c_str(), "r");
+
+    if (!file) {
+        return false;
+    }
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        outputRecord r;
+        float *o = r.output.attitude;
+        if (sscanf(line, "%u,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f", &r.timeMs, &o[0], &o[1], &o[2], &o[3],
+                   &r.output.pos[0], &r.output.pos[1], &r.output.pos[2],
+                   &r.output.vel[0], &r.output.vel[1], &r.output.vel[2]) == 11) {
+            records.push_back(r);
+        }
+    }
+    fclose(file);
+    return true;
+}
+
+static void writeGolden(const std::string &fileName, const std::vector<outputRecord> &records)
+{
+    FILE *file = fopen(fileName.c_str(), "w");
+
+    ASSERT_TRUE(file != NULL) << "cannot write " << fileName;
+    fprintf(file, "time_ms,q1,q2,q3,q4,north,east,down,velocity_north,velocity_east,velocity_down\n");
+    for (size_t n = 0; n < records.size(); n++) {
+        const struct replay_output *o = &records[n].output;
+        fprintf(file, "%u,%.7f,%.7f,%.7f,%.7f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f\n", records[n].timeMs,
+                o->attitude[0], o->attitude[1], o->attitude[2], o->attitude[3],
+                o->pos[0], o->pos[1], o->pos[2], o->vel[0], o->vel[1], o->vel[2]);
+    }
+    fclose(file);
+}
+
+class StateEstimationReplay : public testing::Test {
+protected:
+    static void SetUpTestCase()
+    {
+        replay_initialize();
+        replay_set_home(homeLatitude, homeLongitude, homeAltitude, homeBe);
+        replay_set_mag_bias(magBias);
+    }
+
+    void printStages(const char *replay, enum replay_fusion fusion)
+    {
+        const struct replay_stage *stages;
+        uint8_t count = replay_stages(&stages);
+
+        printf("%s replay through %s, cpu time per filter:\n", replay, replay_fusion_name(fusion));
+        for (uint8_t n = 0; n < count; n++) {
+            if (stages[n].calls) {
+                printf("  %-10s %8u calls %10.3f ms %8.3f us/call\n", stages[n].name, stages[n].calls,
+                       stages[n].cpuNs / 1e6, stages[n].cpuNs / 1e3 / stages[n].calls);
+            }
+        }
+    }
+
+    void compareGolden(const char *replay, enum replay_fusion fusion, const std::vector<outputRecord> &records)
+    {
+        const char *prefix = getenv("STATEESTIMATION_REPLAY_GOLDEN");
+
+        if (!prefix) {
+            return;
+        }
+        std::string fileName = std::string(prefix) + "_" + replay + "_" + replay_fusion_name(fusion) + ".csv";
+        std::vector<outputRecord> golden;
+        if (!readGolden(fileName, golden)) {
+            printf("writing golden outputs %s\n", fileName.c_str());
+            writeGolden(fileName, records);
+            return;
+        }
+
+        ASSERT_EQ(golden.size(), records.size()) << fileName;
+        double attitude = 0.0, position = 0.0, velocity = 0.0;
+        for (size_t n = 0; n < records.size(); n++) {
+            double q[4] = { golden[n].output.attitude[0], golden[n].output.attitude[1], golden[n].output.attitude[2], golden[n].output.attitude[3] };
+            attitude = fmax(attitude, attitudeError(records[n].output.attitude, q));
+            position = fmax(position, distance(records[n].output.pos, golden[n].output.pos));
+            velocity = fmax(velocity, distance(records[n].output.vel, golden[n].output.vel));
+        }
+        printf("largest change against %s: attitude %.3f deg, position %.3f m, velocity %.3f m/s\n",
+               fileName.c_str(), attitude, position, velocity);
+        EXPECT_LT(attitude, MAX_ATTITUDE_CHANGE);
+        EXPECT_LT(position, MAX_POSITION_CHANGE);
+        EXPECT_LT(velocity, MAX_VELOCITY_CHANGE);
+    }
+
+    void replaySynthetic(enum replay_fusion fusion)
+    {
+        Noise noise;
+        std::vector<outputRecord> records;
+        struct replay_output output;
+        double maxAttitude = 0.0, maxPosition = 0.0, maxVelocity = 0.0;
+        uint32_t attitudeUpdates = 0;
+
+        memset(&output, 0, sizeof(output));
+        replay_start(fusion);
+
+        const uint32_t samples = (uint32_t)(FLIGHT_DURATION_S * SENSOR_RATE_HZ);
+        for (uint32_t n = 0; n < samples; n++) {
+            double t = (double)n / SENSOR_RATE_HZ;
+            struct truth s;
+            double R[3][3];
+            trajectory(t, &s);
+            rpyToRbe(s.rpy, R);
+
+            struct replay_sensors sensors;
+            uint32_t updated = REPLAY_SENSOR_GYRO | REPLAY_SENSOR_ACCEL;
+            double f[3] = { s.accel[0], s.accel[1], s.accel[2] - GRAVITY };
+            for (int i = 0; i < 3; i++) {
+                sensors.gyro[i]  = s.rates[i] + 0.2 * noise.next();
+                sensors.accel[i] = R[i][0] * f[0] + R[i][1] * f[1] + R[i][2] * f[2] + 0.1 * noise.next();
+                sensors.mag[i]   = R[i][0] * homeBe[0] + R[i][1] * homeBe[1] + R[i][2] * homeBe[2] + 1.0 * noise.next();
+                sensors.vel[i]   = s.vel[i] + 0.05 * noise.next();
+            }
+            sensors.baro      = homeAltitude + BARO_OFFSET - s.pos[2] + 0.3 * noise.next();
+            double north = s.pos[0] + 0.3 * noise.next();
+            double east  = s.pos[1] + 0.3 * noise.next();
+            sensors.latitude  = homeLatitude + (int32_t)lround(north / EARTH_RADIUS * RAD2DEG_D * 1e7);
+            sensors.longitude = homeLongitude + (int32_t)lround(east / (EARTH_RADIUS * cos(homeLatitude * 1e-7 * DEG2RAD_D)) * RAD2DEG_D * 1e7);
+            sensors.altitude  = homeAltitude - s.pos[2] + 0.5 * noise.next();
+            if (n % MAG_DIVIDER == 0) {
+                updated |= REPLAY_SENSOR_MAG;
+            }
+            if (n % BARO_DIVIDER == 0) {
+                updated |= REPLAY_SENSOR_BARO;
+            }
+            if (n % GPS_DIVIDER == 0) {
+                updated |= REPLAY_SENSOR_GPSPOS | REPLAY_SENSOR_GPSVEL;
+            }
+            replay_set_sensors(&sensors, updated);
+
+            if (!replay_step(n * (1000000 / SENSOR_RATE_HZ), &output)) {
+                continue;
+            }
+            if (attitudeUpdates++ % OUTPUT_DIVIDER == 0) {
+                outputRecord r = { n * 1000 / SENSOR_RATE_HZ, output };
+                records.push_back(r);
+            }
+            if (t > SETTLE_DURATION_S) {
+                double q[4];
+                rpyToQuaternion(s.rpy, q);
+                maxAttitude = fmax(maxAttitude, attitudeError(output.attitude, q));
+                maxPosition = fmax(maxPosition, distance(output.pos, s.pos));
+                maxVelocity = fmax(maxVelocity, distance(output.vel, s.vel));
+            }
+        }
+
+        printStages("synthetic", fusion);
+        printf("largest error against truth: attitude %.3f deg, position %.3f m, velocity %.3f m/s\n",
+               maxAttitude, maxPosition, maxVelocity);
+        EXPECT_GT(attitudeUpdates, samples / 2);
+        EXPECT_LT(maxAttitude, MAX_ATTITUDE_ERROR);
+        EXPECT_LT(maxPosition, MAX_POSITION_ERROR);
+        EXPECT_LT(maxVelocity, MAX_VELOCITY_ERROR);
+        compareGolden("synthetic", fusion, records);
+    }
+
+    void replayLog(enum replay_fusion fusion, const std::vector<logObject> &objects)
+    {
+        std::vector<outputRecord> records;
+        struct replay_output output;
+        uint32_t attitudeUpdates = 0;
+        uint32_t timeUs = 0;
+        uint32_t updated;
+
+        memset(&output, 0, sizeof(output));
+
+        // settings of the log as they were at its end
+        for (size_t n = 0; n < objects.size(); n++) {
+            replay_unpack(objects[n].objId, &objects[n].data[0], objects[n].data.size(), &updated);
+        }
+        replay_start(fusion);
+
+        // telemetry carries no sensor timestamps, gyro samples in one record are spread at the board rate
+        for (size_t n = 0; n < objects.size(); n++) {
+            if (!replay_unpack(objects[n].objId, &objects[n].data[0], objects[n].data.size(), &updated) || !(updated & REPLAY_SENSOR_GYRO)) {
+                continue;
+            }
+            uint32_t recordUs = objects[n].timeMs * 1000;
+            timeUs = recordUs > timeUs + 1000000 / SENSOR_RATE_HZ ? recordUs : timeUs + 1000000 / SENSOR_RATE_HZ;
+            if (replay_step(timeUs, &output) && attitudeUpdates++ % OUTPUT_DIVIDER == 0) {
+                outputRecord r = { timeUs / 1000, output };
+                records.push_back(r);
+            }
+        }
+
+        printStages("log", fusion);
+        EXPECT_GT(attitudeUpdates, 0u);
+        compareGolden("log", fusion, records);
+    }
+};
+
+TEST_F(StateEstimationReplay, SyntheticCFM) {
+    replaySynthetic(REPLAY_FUSION_CFM);
+}
+
+TEST_F(StateEstimationReplay, SyntheticEKF13) {
+    replaySynthetic(REPLAY_FUSION_EKF13);
+}
+
+TEST_F(StateEstimationReplay, Log) {
+    const char *fileName = getenv("STATEESTIMATION_REPLAY_LOG");
+
+    if (!fileName) {
+        printf("STATEESTIMATION_REPLAY_LOG is not set, no log to replay\n");
+        return;
+    }
+
+    std::vector<logObject> objects;
+    ASSERT_TRUE(readLog(fileName, objects)) << "cannot read " << fileName;
+    ASSERT_FALSE(objects.empty());
+    for (int fusion = 0; fusion < REPLAY_FUSION_COUNT; fusion++) {
+        replayLog((enum replay_fusion)fusion, objects);
+    }
+    // the synthetic flight gets its home location and calibration back
+    replay_set_home(homeLatitude, homeLongitude, homeAltitude, homeBe);
+    replay_set_mag_bias(magBias);
+}
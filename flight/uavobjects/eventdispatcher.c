@@ -41,9 +41,17 @@
 #define STACK_SIZE           configMINIMAL_STACK_SIZE
 #endif /* PIOS_EVENTDISPATCHER_STACK_SIZE */
 
+#if defined(PIOS_EVENTDISPATCHER_FAST_PATHS)
+#define MAX_FAST_PATHS       PIOS_EVENTDISPATCHER_FAST_PATHS
+#else
+#define MAX_FAST_PATHS       2
+#endif
+
 #define CALLBACK_PRIORITY    CALLBACK_PRIORITY_CRITICAL
 #define TASK_PRIORITY        CALLBACK_TASK_FLIGHTCONTROL
 #define MAX_UPDATE_PERIOD_MS 1000
+#define HEAP_INITIAL_SIZE    16
+#define HEAP_INDEX_NONE      0xFFFF
 
 // Private types
 
@@ -64,14 +72,28 @@ typedef struct {
 struct PeriodicObjectListStruct {
     EventCallbackInfo evInfo; /** Event callback information */
     uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-    int32_t  timeToNextUpdateMs; /** Time delay to the next update */
+    uint16_t heapIndex; /** Position in mHeap or HEAP_INDEX_NONE if not scheduled */
+    int32_t  timeToNextUpdateMs; /** System time of the next update */
     struct PeriodicObjectListStruct *next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
+/**
+ * Callback events of one producer task, the event task is the only consumer
+ */
+typedef struct {
+    xTaskHandle producer;
+    pios_spscqueue_t queue;
+} FastPath;
+
 // Private variables
 static PeriodicObjectList *mObjList;
+static PeriodicObjectList **mHeap; /** Min-heap of the scheduled entries, ordered by timeToNextUpdateMs */
+static uint16_t mHeapSize;
+static uint16_t mHeapCapacity;
 static xQueueHandle mQueue;
+static FastPath mFastPaths[MAX_FAST_PATHS];
+static uint8_t mFastPathCount;
 static DelayedCallbackInfo *eventSchedulerCallback;
 static xSemaphoreHandle mMutex;
 static EventStats mStats;
@@ -82,6 +104,11 @@ static void eventTask();
 static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, xQueueHandle queue, uint16_t periodMs);
 static uint16_t randomizePeriod(uint16_t periodMs);
+static void heapSiftUp(uint16_t index);
+static void heapSiftDown(uint16_t index);
+static int32_t heapInsert(PeriodicObjectList *objEntry);
+static void heapRemove(PeriodicObjectList *objEntry);
+static void heapReschedule(PeriodicObjectList *objEntry);
 
 
 /**
@@ -92,6 +119,9 @@ int32_t EventDispatcherInitialize()
 {
     // Initialize variables
     mObjList = NULL;
+    mHeap    = NULL;
+    mHeapSize     = 0;
+    mHeapCapacity = 0;
     memset(&mStats, 0, sizeof(EventStats));
 
     // Create mMutex
@@ -132,6 +162,40 @@ void EventClearStats()
     xSemaphoreGiveRecursive(mMutex);
 }
 
+/**
+ * Give the calling task its own lock free queue for the callback events it raises.
+ * Meant for tasks publishing at high rates, their events no longer go through
+ * the critical sections of the shared FreeRTOS queue.
+ * \param[in] length The number of events the queue holds
+ * \return Success (0), failure (-1)
+ */
+int32_t EventDispatcherCreateFastPath(uint16_t length)
+{
+    xTaskHandle self = xTaskGetCurrentTaskHandle();
+    int32_t result   = -1;
+
+    xSemaphoreTakeRecursive(mMutex, portMAX_DELAY);
+    uint8_t count = __atomic_load_n(&mFastPathCount, __ATOMIC_RELAXED);
+    for (uint8_t i = 0; i < count; i++) {
+        if (mFastPaths[i].producer == self) {
+            // Already created
+            xSemaphoreGiveRecursive(mMutex);
+            return 0;
+        }
+    }
+    if (count < MAX_FAST_PATHS) {
+        mFastPaths[count].queue = PIOS_SPSCQUEUE_Create(length, sizeof(EventCallbackInfo));
+        if (mFastPaths[count].queue) {
+            mFastPaths[count].producer = self;
+            // Publish the entry to the producer and the event task
+            __atomic_store_n(&mFastPathCount, count + 1, __ATOMIC_RELEASE);
+            result = 0;
+        }
+    }
+    xSemaphoreGiveRecursive(mMutex);
+    return result;
+}
+
 /**
  * Dispatch an event by invoking the supplied callback. The function
  * returns imidiatelly, the callback is invoked from the event task.
@@ -147,8 +211,23 @@ int32_t EventCallbackDispatch(UAVObjEvent *ev, UAVObjEventCallback cb)
     memcpy(&evInfo.ev, ev, sizeof(UAVObjEvent));
     evInfo.cb    = cb;
     evInfo.queue = 0;
+
+    // Push to the queue of the calling task if it has a fast path
+    int32_t result = pdFALSE;
+    uint8_t count  = __atomic_load_n(&mFastPathCount, __ATOMIC_ACQUIRE);
+    if (count) {
+        xTaskHandle self = xTaskGetCurrentTaskHandle();
+        for (uint8_t i = 0; i < count; i++) {
+            if (mFastPaths[i].producer == self) {
+                result = PIOS_SPSCQUEUE_Send(mFastPaths[i].queue, &evInfo) ? pdTRUE : pdFALSE;
+                PIOS_CALLBACKSCHEDULER_Dispatch(eventSchedulerCallback);
+                return result;
+            }
+        }
+    }
+
     // Push to queue
-    int32_t result = xQueueSend(mQueue, &evInfo, 0); // will not block if queue is full
+    result = xQueueSend(mQueue, &evInfo, 0); // will not block if queue is full
     PIOS_CALLBACKSCHEDULER_Dispatch(eventSchedulerCallback);
     return result;
 }
@@ -230,6 +309,7 @@ static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
     // Create handle
     objEntry = (PeriodicObjectList *)pios_malloc(sizeof(PeriodicObjectList));
     if (objEntry == NULL) {
+        xSemaphoreGiveRecursive(mMutex);
         return -1;
     }
     objEntry->evInfo.ev.obj      = ev->obj;
@@ -238,7 +318,14 @@ static int32_t eventPeriodicCreate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
     objEntry->evInfo.cb = cb;
     objEntry->evInfo.queue       = queue;
     objEntry->updatePeriodMs     = periodMs;
-    objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+    objEntry->timeToNextUpdateMs = xTaskGetTickCount() * portTICK_RATE_MS + randomizePeriod(periodMs); // avoid bunching of updates
+    objEntry->heapIndex = HEAP_INDEX_NONE;
+    // Schedule the first update
+    if (periodMs > 0 && heapInsert(objEntry) != 0) {
+        pios_free(objEntry);
+        xSemaphoreGiveRecursive(mMutex);
+        return -1;
+    }
     // Add to list
     LL_APPEND(mObjList, objEntry);
     // Release lock
@@ -268,11 +355,20 @@ static int32_t eventPeriodicUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
             objEntry->evInfo.ev.instId == ev->instId &&
             objEntry->evInfo.ev.event == ev->event) {
             // Object found, update period
+            int32_t rc = 0;
             objEntry->updatePeriodMs     = periodMs;
-            objEntry->timeToNextUpdateMs = randomizePeriod(periodMs); // avoid bunching of updates
+            objEntry->timeToNextUpdateMs = xTaskGetTickCount() * portTICK_RATE_MS + randomizePeriod(periodMs); // avoid bunching of updates
+            // Move the entry in, out or within the schedule
+            if (periodMs == 0) {
+                heapRemove(objEntry);
+            } else if (objEntry->heapIndex == HEAP_INDEX_NONE) {
+                rc = heapInsert(objEntry);
+            } else {
+                heapReschedule(objEntry);
+            }
             // Release lock
             xSemaphoreGiveRecursive(mMutex);
-            return 0;
+            return rc;
         }
     }
     // If this point is reached the object was not found
@@ -286,8 +382,29 @@ static int32_t eventPeriodicUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, xQue
 static void eventTask()
 {
     static uint32_t timeToNextUpdateMs = 0;
+    static bool fastPathCreated = false;
     EventCallbackInfo evInfo;
 
+    // Events raised by the callbacks of this task are consumed right here
+    if (!fastPathCreated) {
+        fastPathCreated = true;
+        EventDispatcherCreateFastPath(MAX_QUEUE_SIZE);
+    }
+
+    // limit loops to max queue size to slightly reduce the impact of recursive events
+    uint8_t count = __atomic_load_n(&mFastPathCount, __ATOMIC_ACQUIRE);
+    for (uint8_t i = 0; i < count; i++) {
+        int limit = MAX_QUEUE_SIZE;
+        while (PIOS_SPSCQUEUE_Receive(mFastPaths[i].queue, &evInfo)) {
+            if (evInfo.cb != 0) {
+                evInfo.cb(&evInfo.ev); // the function is expected to copy the event information
+            }
+            if (!--limit) {
+                break;
+            }
+        }
+    }
+
     // Wait for queue message
     int limit = MAX_QUEUE_SIZE;
 
@@ -311,7 +428,7 @@ static void eventTask()
 }
 
 /**
- * Handle periodic updates for all objects.
+ * Handle the periodic updates which are due, only the entries at the top of the heap are visited.
  * \return The system time until the next update (in ms) or -1 if failed
  */
 static int32_t processPeriodicUpdates()
@@ -319,49 +436,160 @@ static int32_t processPeriodicUpdates()
     PeriodicObjectList *objEntry;
     int32_t timeNow;
     int32_t timeToNextUpdate;
-    int32_t offset;
+    int32_t latency;
 
     // Get lock
     xSemaphoreTakeRecursive(mMutex, portMAX_DELAY);
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update.
-    timeToNextUpdate = xTaskGetTickCount() * portTICK_RATE_MS + MAX_UPDATE_PERIOD_MS;
-    LL_FOREACH(mObjList, objEntry) {
-        // If object is configured for periodic updates
-        if (objEntry->updatePeriodMs > 0) {
-            // Check if time for the next update
-            timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
-            if (objEntry->timeToNextUpdateMs <= timeNow) {
-                // Reset timer
-                offset = (timeNow - objEntry->timeToNextUpdateMs) % objEntry->updatePeriodMs;
-                objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-                // Invoke callback, if one
-                if (objEntry->evInfo.cb != 0) {
-                    objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
-                }
-                // Push event to queue, if one
-                if (objEntry->evInfo.queue != 0) {
-                    if (xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE && !objEntry->evInfo.ev.lowPriority) { // do not block if queue is full
-                        if (objEntry->evInfo.ev.obj != NULL) {
-                            mStats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-                        }
-                        ++mStats.eventErrors;
-                    }
+    // Dispatch each entry which is due at most once, in case callbacks take longer than the periods
+    uint16_t limit = mHeapSize;
+    timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
+    while (limit-- > 0 && mHeap[0]->timeToNextUpdateMs <= timeNow) {
+        objEntry = mHeap[0];
+        latency  = timeNow - objEntry->timeToNextUpdateMs;
+        if ((uint32_t)latency > mStats.maxLatencyMs) {
+            mStats.maxLatencyMs = latency;
+        }
+        // Reset timer, the entry stays in the heap and moves down to its new place
+        objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - (latency % objEntry->updatePeriodMs);
+        heapSiftDown(0);
+        // Invoke callback, if one
+        if (objEntry->evInfo.cb != 0) {
+            objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
+        }
+        // Push event to queue, if one
+        if (objEntry->evInfo.queue != 0) {
+            if (xQueueSend(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != pdTRUE && !objEntry->evInfo.ev.lowPriority) { // do not block if queue is full
+                if (objEntry->evInfo.ev.obj != NULL) {
+                    mStats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
                 }
+                ++mStats.eventErrors;
             }
-            // Update minimum delay
-            if (objEntry->timeToNextUpdateMs < timeToNextUpdate) {
-                timeToNextUpdate = objEntry->timeToNextUpdateMs;
-            }
+        }
+        // Callbacks might have taken a while
+        timeNow = xTaskGetTickCount() * portTICK_RATE_MS;
+        if (mHeapSize == 0) {
+            break;
         }
     }
 
+    // Calculate the delay to the next update
+    timeToNextUpdate = timeNow + MAX_UPDATE_PERIOD_MS;
+    if (mHeapSize > 0 && mHeap[0]->timeToNextUpdateMs < timeToNextUpdate) {
+        timeToNextUpdate = mHeap[0]->timeToNextUpdateMs;
+    }
+
     // Done
     xSemaphoreGiveRecursive(mMutex);
     return timeToNextUpdate;
 }
 
+/**
+ * Move a heap entry up until its parent is not due later
+ */
+static void heapSiftUp(uint16_t index)
+{
+    PeriodicObjectList *objEntry = mHeap[index];
+
+    while (index > 0) {
+        uint16_t parent = (index - 1) / 2;
+        if (mHeap[parent]->timeToNextUpdateMs <= objEntry->timeToNextUpdateMs) {
+            break;
+        }
+        mHeap[index] = mHeap[parent];
+        mHeap[index]->heapIndex = index;
+        index = parent;
+    }
+    mHeap[index] = objEntry;
+    objEntry->heapIndex = index;
+}
+
+/**
+ * Move a heap entry down until its children are not due earlier
+ */
+static void heapSiftDown(uint16_t index)
+{
+    PeriodicObjectList *objEntry = mHeap[index];
+
+    for (;;) {
+        uint32_t child = 2 * (uint32_t)index + 1;
+        if (child >= mHeapSize) {
+            break;
+        }
+        if (child + 1 < mHeapSize && mHeap[child + 1]->timeToNextUpdateMs < mHeap[child]->timeToNextUpdateMs) {
+            child++;
+        }
+        if (objEntry->timeToNextUpdateMs <= mHeap[child]->timeToNextUpdateMs) {
+            break;
+        }
+        mHeap[index] = mHeap[child];
+        mHeap[index]->heapIndex = index;
+        index = child;
+    }
+    mHeap[index] = objEntry;
+    objEntry->heapIndex = index;
+}
+
+/**
+ * Add an entry to the heap, growing it if needed
+ * \return Success (0), failure (-1)
+ */
+static int32_t heapInsert(PeriodicObjectList *objEntry)
+{
+    if (mHeapSize == mHeapCapacity) {
+        uint16_t capacity = (mHeapCapacity == 0) ? HEAP_INITIAL_SIZE : mHeapCapacity * 2;
+        if (capacity >= HEAP_INDEX_NONE) {
+            return -1;
+        }
+        PeriodicObjectList **heap = (PeriodicObjectList **)pios_malloc(capacity * sizeof(PeriodicObjectList *));
+        if (heap == NULL) {
+            return -1;
+        }
+        if (mHeap != NULL) {
+            memcpy(heap, mHeap, mHeapSize * sizeof(PeriodicObjectList *));
+            pios_free(mHeap);
+        }
+        mHeap = heap;
+        mHeapCapacity = capacity;
+    }
+    mHeap[mHeapSize] = objEntry;
+    heapSiftUp(mHeapSize++);
+    return 0;
+}
+
+/**
+ * Remove an entry from the heap, if it is scheduled
+ */
+static void heapRemove(PeriodicObjectList *objEntry)
+{
+    uint16_t index = objEntry->heapIndex;
+
+    if (index == HEAP_INDEX_NONE) {
+        return;
+    }
+    objEntry->heapIndex = HEAP_INDEX_NONE;
+    if (index != --mHeapSize) {
+        // Move the last entry into the hole
+        mHeap[index] = mHeap[mHeapSize];
+        mHeap[index]->heapIndex = index;
+        heapReschedule(mHeap[index]);
+    }
+}
+
+/**
+ * Restore the heap order after the time of an entry changed
+ */
+static void heapReschedule(PeriodicObjectList *objEntry)
+{
+    uint16_t index = objEntry->heapIndex;
+
+    if (index > 0 && mHeap[(index - 1) / 2]->timeToNextUpdateMs > objEntry->timeToNextUpdateMs) {
+        heapSiftUp(index);
+    } else {
+        heapSiftDown(index);
+    }
+}
+
 /**
  * Return a psedorandom integer from 0 to periodMs
  * Based on the Park-Miller-Carta Pseudo-Random Number Generator
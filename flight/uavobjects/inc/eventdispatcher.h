@@ -33,12 +33,14 @@
 typedef struct {
     uint32_t lastErrorID;
     uint32_t eventErrors;
+    uint32_t maxLatencyMs; /** Worst delay of a periodic event past its due time */
 } EventStats;
 
 // Public functions
 int32_t EventDispatcherInitialize();
 void EventGetStats(EventStats *statsOut);
 void EventClearStats();
+int32_t EventDispatcherCreateFastPath(uint16_t length);
 int32_t EventCallbackDispatch(UAVObjEvent *ev, UAVObjEventCallback cb);
 int32_t EventPeriodicCallbackCreate(UAVObjEvent *ev, UAVObjEventCallback cb, uint16_t periodMs);
 int32_t EventPeriodicCallbackUpdate(UAVObjEvent *ev, UAVObjEventCallback cb, uint16_t periodMs);
@@ -73,16 +73,17 @@ struct ObjectEventEntry {
     xQueueHandle queue;
     UAVObjEventCallback     cb;
     uint8_t eventMask;
+    bool    timestamped; // the queue takes UAVObjTimestampedEvent items
 };
 
 /*
    MetaInstance   == [UAVOBase [UAVObjMetadata]]
    SingleInstance == [UAVOBase [UAVOData [InstanceData]]]
-   MultiInstance  == [UAVOBase [UAVOData [NumInstances [InstanceData0 [next]]]]
-                                                  ____________________/
-   \-->[InstanceData1 [next]]
+   MultiInstance  == [UAVOBase [UAVOData [NumInstances [Capacity [overflow [InstanceData0 ... InstanceDataCapacity-1]]]]]]
+                                                            __/
+   \-->[next [InstanceDataCapacity]]
                                                   _________...________/
-   \-->[InstanceDataN [next]]
+   \-->[next [InstanceDataN]]
  */
 
 /*
@@ -100,13 +101,23 @@ struct UAVOBase {
         bool isSingle      : 1;
         bool isSettings    : 1;
         bool isPriority    : 1;
+        bool isSeqLocked   : 1;
+        bool isLoadPending : 1; /* instance 0 not loaded from flash yet, see UAVOBJ_DEFERRED_SETTINGS_LOAD */
+        bool isMetaInRam   : 1; /* meta only, the metadata has been written and copied to the heap */
     } flags;
+
+    /* Union of the event masks of the connected queues and callbacks */
+    uint8_t eventMask;
 } __attribute__((packed));
 
 /* Augmented type for Meta UAVO */
 struct UAVOMeta {
     struct UAVOBase base;
-    UAVObjMetadata  instance0;
+    /*
+     * The constant defaults of the object, in flash, until the metadata
+     * is first written: from then on a copy on the heap.
+     */
+    const UAVObjMetadata *instance0;
 } __attribute__((packed));
 
 /* Shared data structure for all data-carrying UAVObjects (UAVOSingle and UAVOMulti) */
@@ -125,6 +136,9 @@ struct UAVOData {
 struct UAVOSingle {
     struct UAVOData uavo;
 
+    /* Sequence counter, odd while a write is in progress (used when flags.isSeqLocked is set) */
+    volatile uint32_t seq __attribute__((aligned(4)));
+
     uint8_t instance0[];
     /*
      * Additional space will be malloc'd here to hold the
@@ -132,7 +146,7 @@ struct UAVOSingle {
      */
 } __attribute__((packed));
 
-/* Part of a linked list of instances chained off of a multi instance UAVO. */
+/* Part of a linked list of the instances created past the capacity of a multi instance UAVO. */
 struct UAVOMultiInst {
     struct UAVOMultiInst *next;
     uint8_t instance[];
@@ -146,10 +160,14 @@ struct UAVOMultiInst {
 struct UAVOMulti {
     struct UAVOData uavo;
     uint16_t num_instances;
-    struct UAVOMultiInst instance0 __attribute__((aligned(4)));
+    /* Instances allocated with the object, from the instances hint of the definition */
+    uint16_t capacity;
+    struct UAVOMultiInst *overflow;
+    uint8_t  instances[] __attribute__((aligned(4)));
     /*
      * Additional space will be malloc'd here to hold the
-     * the data for instance 0.
+     * the data for the first capacity instances, each
+     * MultiInstanceStride() bytes.
      */
 } __attribute__((packed));
 
@@ -157,16 +175,18 @@ struct UAVOMulti {
 #define MetaNumBytes sizeof(UAVObjMetadata)
 #define MetaBaseObjectPtr(obj)           ((struct UAVOData *)((obj) - offsetof(struct UAVOData, metaObj)))
 #define MetaObjectPtr(obj)               ((struct UAVODataMeta *)&((obj)->metaObj))
-#define MetaDataPtr(obj)                 ((UAVObjMetadata *)&((obj)->instance0))
-#define LinkedMetaDataPtr(obj)           ((UAVObjMetadata *)&((obj)->metaObj.instance0))
+#define MetaDataPtr(obj)                 ((obj)->instance0)
+#define LinkedMetaDataPtr(obj)           ((obj)->metaObj.instance0)
 
 /** all information about instances are dependant on object type **/
 #define ObjSingleInstanceDataOffset(obj) ((void *)(&(((struct UAVOSingle *)obj)->instance0)))
 #define InstanceDataOffset(inst)         ((void *)&(((struct UAVOMultiInst *)inst)->instance))
 #define InstanceData(instance)           ((void *)instance)
+#define MultiInstanceStride(obj)         (((obj)->instance_size + 3) & ~3)
 
 // Private functions
 int32_t sendEvent(struct UAVOBase *obj, uint16_t instId, UAVObjEventType event);
 InstanceHandle getInstance(struct UAVOData *obj, uint16_t instId);
+int32_t writeMetaData(struct UAVOMeta *obj, const void *dataIn, uint32_t offset, uint32_t size);
 
 #endif /* UAVOBJECTPRIVATE_H_ */
@@ -34,12 +34,20 @@
 #include "openpilot.h"
 #include "pios_struct_helper.h"
 #include "inc/uavobjectprivate.h"
+#include "uavobjectsinit.h"
 
 // Private functions
 static InstanceHandle createInstance(struct UAVOData *obj, uint16_t instId);
-static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue, UAVObjEventCallback cb, uint8_t eventMask);
+static int32_t findSortedId(uint32_t id);
+static void writeInstance(struct UAVOData *obj, InstanceHandle instEntry, const void *dataIn, uint32_t offset, uint32_t size);
+static void readSeqLocked(struct UAVOData *obj, void *dataOut, uint32_t offset, uint32_t size);
+#ifdef UAVOBJ_DEFERRED_SETTINGS_LOAD
+static void loadPending(struct UAVOData *obj);
+#endif
+static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue, UAVObjEventCallback cb, uint8_t eventMask, bool timestamped);
 static int32_t disconnectObj(UAVObjHandle obj_handle, xQueueHandle queue, UAVObjEventCallback cb);
 static void instanceAutoUpdated(UAVObjHandle obj_handle, uint16_t instId);
+static void updateEventMask(struct UAVOBase *obj);
 
 
 int32_t UAVObjPers_stub(__attribute__((unused)) UAVObjHandle obj_handle, __attribute__((unused))  uint16_t instId)
@@ -51,6 +59,14 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId) __attribute__((weak
 int32_t UAVObjDelete(UAVObjHandle obj_handle, uint16_t instId) __attribute__((weak, alias("UAVObjPers_stub")));
 
 
+// Private constants
+// Single instance objects up to this size are read under a sequence lock instead of the mutex
+#define UAVOBJ_SEQLOCK_MAX_SIZE 64
+// Attempts at a lock-free read before falling back on the mutex
+#define UAVOBJ_SEQLOCK_RETRIES  2
+// Subscribers of an event notified after the mutex is released, the others are notified under it
+#define UAVOBJ_EVENT_FANOUT_MAX 6
+
 // Private variables
 static xSemaphoreHandle mutex;
 static const UAVObjMetadata defMetadata = {
@@ -64,9 +80,17 @@ static const UAVObjMetadata defMetadata = {
     .gcsTelemetryUpdatePeriod = 0,
     .loggingUpdatePeriod      = 0,
 };
+// Metadata of the objects registered without defaults
+static const UAVObjMetadata noMetadata;
 
 static UAVObjStats stats;
 
+// Lookup table for UAVObjGetByID(), uavo_by_id[n] is the object with ID uavo_sorted_ids[n]
+static const uint32_t uavo_sorted_ids[UAVOBJECTS_COUNT] = UAVOBJECTS_SORTED_IDS;
+static struct UAVOData *uavo_by_id[UAVOBJECTS_COUNT];
+// Number of registered objects whose ID is not in uavo_sorted_ids
+static uint16_t uavo_unlisted_count;
+
 /**
  * Initialize the object manager
  * \return 0 Success
@@ -76,6 +100,8 @@ int32_t UAVObjInitialize()
 {
     // Initialize variables
     memset(&stats, 0, sizeof(UAVObjStats));
+    memset(uavo_by_id, 0, sizeof(uavo_by_id));
+    uavo_unlisted_count = 0;
 
     /* Initialize _uavo_handles start/stop pointers */
         #if (defined(__MACH__) && defined(__APPLE__))
@@ -137,17 +163,27 @@ static void UAVObjInitMetaData(struct UAVOMeta *obj_meta)
     uavo_base->flags.isSingle = true;
     uavo_base->next_event     = NULL;
 
-    /* Clear the instance data carried in the UAVO */
-    memset(&(obj_meta->instance0), 0, sizeof(obj_meta->instance0));
+    /* Empty until the object gives its defaults, see UAVObjSetDefaultMetadata() */
+    obj_meta->instance0 = &noMetadata;
 }
 
-static struct UAVOData *UAVObjAllocSingle(uint32_t num_bytes)
+static struct UAVOData *UAVObjAllocSingle(uint32_t num_bytes, bool fast)
 {
     /* Compute the complete size of the object, including the data for a single embedded instance */
     uint32_t object_size = sizeof(struct UAVOSingle) + num_bytes;
 
-    /* Allocate the object from the heap */
-    struct UAVOSingle *uavo_single = (struct UAVOSingle *)pios_malloc(object_size);
+    /* Allocate the object from the heap, the fast one (CCM) if asked for and there is one */
+    struct UAVOSingle *uavo_single = NULL;
+#ifdef PIOS_TARGET_PROVIDES_FAST_HEAP
+    if (fast) {
+        uavo_single = (struct UAVOSingle *)pios_fastheapmalloc(object_size);
+    }
+#else
+    (void)fast;
+#endif
+    if (!uavo_single) {
+        uavo_single = (struct UAVOSingle *)pios_malloc(object_size);
+    }
 
     if (!uavo_single) {
         return NULL;
@@ -158,6 +194,7 @@ static struct UAVOData *UAVObjAllocSingle(uint32_t num_bytes)
     memset(uavo_base, 0, sizeof(*uavo_base));
     uavo_base->flags.isSingle = true;
     uavo_base->next_event     = NULL;
+    uavo_single->seq = 0;
 
     /* Clear the instance data carried in the UAVO */
     memset(&(uavo_single->instance0), 0, num_bytes);
@@ -166,10 +203,15 @@ static struct UAVOData *UAVObjAllocSingle(uint32_t num_bytes)
     return &(uavo_single->uavo);
 }
 
-static struct UAVOData *UAVObjAllocMulti(uint32_t num_bytes)
+static struct UAVOData *UAVObjAllocMulti(uint32_t num_bytes, uint16_t capacity)
 {
-    /* Compute the complete size of the object, including the data for a single embedded instance */
-    uint32_t object_size = sizeof(struct UAVOMulti) + num_bytes;
+    if (capacity == 0) {
+        capacity = 1;
+    }
+
+    /* Compute the complete size of the object, including the data for the preallocated instances */
+    uint32_t stride = (num_bytes + 3) & ~3;
+    uint32_t object_size = sizeof(struct UAVOMulti) + stride * capacity;
 
     /* Allocate the object from the heap */
     struct UAVOMulti *uavo_multi = (struct UAVOMulti *)pios_malloc(object_size);
@@ -186,9 +228,11 @@ static struct UAVOData *UAVObjAllocMulti(uint32_t num_bytes)
 
     /* Set up the type-specific part of the UAVO */
     uavo_multi->num_instances = 1;
+    uavo_multi->capacity = capacity;
+    uavo_multi->overflow = NULL;
 
     /* Clear the multi instance data carried in the UAVO */
-    memset(&(uavo_multi->instance0), 0, sizeof(struct UAVOMultiInst) + num_bytes);
+    memset(uavo_multi->instances, 0, stride * capacity);
 
     /* Give back the generic UAVO part */
     return &(uavo_multi->uavo);
@@ -204,13 +248,14 @@ static struct UAVOData *UAVObjAllocMulti(uint32_t num_bytes)
  * \param[in] isSingleInstance Is this a single instance or multi-instance object
  * \param[in] isSettings Is this a settings object
  * \param[in] numBytes Number of bytes of object data (for one instance)
+ * \param[in] num_instances Instances of a multi-instance object allocated with it, more are allocated one by one
  * \param[in] initCb Default field and metadata initialization function
  * \return Object handle, or NULL if failure.
  * \return
  */
 UAVObjHandle UAVObjRegister(uint32_t id,
                             bool isSingleInstance, bool isSettings, bool isPriority,
-                            uint32_t num_bytes,
+                            uint32_t num_bytes, uint16_t num_instances,
                             UAVObjInitializeCallback initCb)
 {
     struct UAVOData *uavo_data = NULL;
@@ -224,9 +269,11 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 
     /* Map the various flags to one of the UAVO types we understand */
     if (isSingleInstance) {
-        uavo_data = UAVObjAllocSingle(num_bytes);
+        // The small state objects of the control path go in the fast heap. Settings do not,
+        // they are loaded in place from flash where the DMA can not reach the CCM
+        uavo_data = UAVObjAllocSingle(num_bytes, !isSettings && num_bytes <= UAVOBJ_SEQLOCK_MAX_SIZE);
     } else {
-        uavo_data = UAVObjAllocMulti(num_bytes);
+        uavo_data = UAVObjAllocMulti(num_bytes, num_instances);
     }
 
     if (!uavo_data) {
@@ -243,6 +290,10 @@ UAVObjHandle UAVObjRegister(uint32_t id,
     } else {
         uavo_data->base.flags.isPriority = isPriority;
     }
+    /* Small single instance objects can be read without the mutex (settings are loaded in place from flash) */
+    if (isSingleInstance && !isSettings && num_bytes <= UAVOBJ_SEQLOCK_MAX_SIZE) {
+        uavo_data->base.flags.isSeqLocked = true;
+    }
     /* Initialize the embedded meta UAVO */
     UAVObjInitMetaData(&uavo_data->metaObj);
 
@@ -256,18 +307,54 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 
     /* Attempt to load settings object from flash */
     if (uavo_data->base.flags.isSettings) {
+#ifdef UAVOBJ_DEFERRED_SETTINGS_LOAD
+        /* Loaded on first access or by UAVObjLoadPendingSettings(), whichever comes first */
+        uavo_data->base.flags.isLoadPending = true;
+#else
         UAVObjLoad((UAVObjHandle)uavo_data, 0);
+#endif
     }
 
     // fire events for outer object and its embedded meta object
     instanceAutoUpdated((UAVObjHandle)uavo_data, 0);
     instanceAutoUpdated((UAVObjHandle) & (uavo_data->metaObj), 0);
 
+    /* Publish the object for lookups by ID, only once it is fully initialized */
+    int32_t index = findSortedId(id);
+    if (index >= 0) {
+        uavo_by_id[index] = uavo_data;
+    } else {
+        uavo_unlisted_count++;
+    }
+
 unlock_exit:
     xSemaphoreGiveRecursive(mutex);
     return (UAVObjHandle)uavo_data;
 }
 
+/**
+ * Binary search of an object ID in the sorted ID table
+ * \param[in] id The object ID
+ * \return The index in uavo_sorted_ids or -1 if not found
+ */
+static int32_t findSortedId(uint32_t id)
+{
+    int32_t low  = 0;
+    int32_t high = UAVOBJECTS_COUNT - 1;
+
+    while (low <= high) {
+        int32_t mid = (low + high) / 2;
+        if (uavo_sorted_ids[mid] < id) {
+            low = mid + 1;
+        } else if (uavo_sorted_ids[mid] > id) {
+            high = mid - 1;
+        } else {
+            return mid;
+        }
+    }
+    return -1;
+}
+
 /**
  * Retrieve an object from the list given its id
  * \param[in] The object ID
@@ -277,6 +364,21 @@ UAVObjHandle UAVObjGetByID(uint32_t id)
 {
     UAVObjHandle *found_obj = (UAVObjHandle *)NULL;
 
+    // Objects known at build time are looked up in the sorted table, without locking.
+    // The table entries are only ever written once, after the object is initialized.
+    int32_t index = findSortedId(id);
+    if (index >= 0 && uavo_by_id[index]) {
+        return (UAVObjHandle)uavo_by_id[index];
+    }
+    // Meta object IDs are the parent ID + 1
+    index = findSortedId(id - 1);
+    if (index >= 0 && uavo_by_id[index]) {
+        return (UAVObjHandle) & (uavo_by_id[index]->metaObj);
+    }
+    if (uavo_unlisted_count == 0) {
+        return found_obj;
+    }
+
     // Get lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -514,7 +616,9 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t *da
         if (instId != 0) {
             goto unlock_exit;
         }
-        memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), dataIn, MetaNumBytes);
+        if (writeMetaData((struct UAVOMeta *)obj_handle, dataIn, 0, MetaNumBytes) != 0) {
+            goto unlock_exit;
+        }
     } else {
         struct UAVOData *obj;
         InstanceHandle instEntry;
@@ -533,15 +637,18 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t *da
             }
         }
         // Set the data
-        memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
+        writeInstance(obj, instEntry, dataIn, 0, obj->instance_size);
     }
 
-    // Fire event
-    sendEvent((struct UAVOBase *)obj_handle, instId, EV_UNPACKED);
     rc = 0;
 
 unlock_exit:
     xSemaphoreGiveRecursive(mutex);
+
+    // Fire event
+    if (rc == 0) {
+        sendEvent((struct UAVOBase *)obj_handle, instId, EV_UNPACKED);
+    }
     return rc;
 }
 
@@ -556,6 +663,14 @@ int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t *dataOut)
 {
     PIOS_Assert(obj_handle);
 
+    if (((struct UAVOBase *)obj_handle)->flags.isSeqLocked) {
+        if (instId != 0) {
+            return -1;
+        }
+        readSeqLocked((struct UAVOData *)obj_handle, dataOut, 0, ((struct UAVOData *)obj_handle)->instance_size);
+        return 0;
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -600,6 +715,16 @@ uint8_t UAVObjUpdateCRC(UAVObjHandle obj_handle, uint16_t instId, uint8_t crc)
 {
     PIOS_Assert(obj_handle);
 
+    if (((struct UAVOBase *)obj_handle)->flags.isSeqLocked) {
+        uint8_t data[UAVOBJ_SEQLOCK_MAX_SIZE];
+        uint16_t size = ((struct UAVOData *)obj_handle)->instance_size;
+        if (instId != 0) {
+            return crc;
+        }
+        readSeqLocked((struct UAVOData *)obj_handle, data, 0, size);
+        return PIOS_CRC_updateCRC(crc, data, (int32_t)size);
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -629,6 +754,61 @@ unlock_exit:
     return crc;
 }
 
+/**
+ * Update a CRC32 with an object data, same as UAVObjUpdateCRC but strong
+ * enough to tell whether two copies of a settings or meta object are the same
+ * \param[in] obj The object handle
+ * \param[in] instId The instance ID
+ * \param[in] crc The crc to update
+ * \return the updated crc
+ */
+uint32_t UAVObjUpdateCRC32(UAVObjHandle obj_handle, uint16_t instId, uint32_t crc)
+{
+    PIOS_Assert(obj_handle);
+
+    if (UAVObjIsMetaobject(obj_handle)) {
+        if (instId != 0) {
+            return crc;
+        }
+        xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+        crc = PIOS_CRC32_updateCRC(crc, (uint8_t *)MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
+        xSemaphoreGiveRecursive(mutex);
+        return crc;
+    }
+
+    if (((struct UAVOBase *)obj_handle)->flags.isSeqLocked) {
+        uint8_t data[UAVOBJ_SEQLOCK_MAX_SIZE];
+        uint16_t size = ((struct UAVOData *)obj_handle)->instance_size;
+        if (instId != 0) {
+            return crc;
+        }
+        readSeqLocked((struct UAVOData *)obj_handle, data, 0, size);
+        return PIOS_CRC32_updateCRC(crc, data, (int32_t)size);
+    }
+
+    // Lock
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+
+    InstanceHandle instEntry = getInstance((struct UAVOData *)obj_handle, instId);
+    if (instEntry != NULL) {
+        crc = PIOS_CRC32_updateCRC(crc, (uint8_t *)InstanceData(instEntry), (int32_t)((struct UAVOData *)obj_handle)->instance_size);
+    }
+
+    xSemaphoreGiveRecursive(mutex);
+    return crc;
+}
+
+/**
+ * Hand the object data to the loggers
+ */
+static void writeToLog(uint32_t objId, uint16_t instId, size_t size, uint8_t *data)
+{
+    PIOS_DEBUGLOG_UAVObject(objId, instId, size, data);
+#if defined(PIOS_INCLUDE_SDLOG)
+    PIOS_SDLOG_UAVObject(objId, instId, size, data);
+#endif
+}
+
 /**
  * Actually write the object's data to the logfile
  * \param[in] obj The object handle
@@ -638,6 +818,17 @@ void UAVObjInstanceWriteToLog(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
 
+    if (((struct UAVOBase *)obj_handle)->flags.isSeqLocked) {
+        uint8_t data[UAVOBJ_SEQLOCK_MAX_SIZE];
+        uint16_t size = ((struct UAVOData *)obj_handle)->instance_size;
+        if (instId != 0) {
+            return;
+        }
+        readSeqLocked((struct UAVOData *)obj_handle, data, 0, size);
+        writeToLog(UAVObjGetID(obj_handle), instId, size, data);
+        return;
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -645,7 +836,7 @@ void UAVObjInstanceWriteToLog(UAVObjHandle obj_handle, uint16_t instId)
         if (instId != 0) {
             goto unlock_exit;
         }
-        PIOS_DEBUGLOG_UAVObject(UAVObjGetID(obj_handle), instId, MetaNumBytes, (uint8_t *)MetaDataPtr((struct UAVOMeta *)obj_handle));
+        writeToLog(UAVObjGetID(obj_handle), instId, MetaNumBytes, (uint8_t *)MetaDataPtr((struct UAVOMeta *)obj_handle));
     } else {
         struct UAVOData *obj;
         InstanceHandle instEntry;
@@ -659,7 +850,7 @@ void UAVObjInstanceWriteToLog(UAVObjHandle obj_handle, uint16_t instId)
             goto unlock_exit;
         }
         // Pack data
-        PIOS_DEBUGLOG_UAVObject(UAVObjGetID(obj_handle), instId, obj->instance_size, (uint8_t *)InstanceData(instEntry));
+        writeToLog(UAVObjGetID(obj_handle), instId, obj->instance_size, (uint8_t *)InstanceData(instEntry));
     }
 
 unlock_exit:
@@ -726,6 +917,22 @@ xSemaphoreGiveRecursive(mutex);
 return rc;
 }
 
+/**
+ * Load the settings objects registered but not accessed yet, a no-op unless
+ * UAVOBJ_DEFERRED_SETTINGS_LOAD is defined. The lock is only held while
+ * loading each object so the other tasks are not held up for the whole list.
+ */
+void UAVObjLoadPendingSettings()
+{
+#ifdef UAVOBJ_DEFERRED_SETTINGS_LOAD
+    UAVO_LIST_ITERATE(obj)
+    if (obj->base.flags.isLoadPending) {
+        loadPending(obj);
+    }
+}
+#endif
+}
+
 /**
  * Delete all settings objects from the SD card.
  * @return 0 if success or -1 if failure
@@ -902,7 +1109,9 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
         if (instId != 0) {
             goto unlock_exit;
         }
-        memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), dataIn, MetaNumBytes);
+        if (writeMetaData((struct UAVOMeta *)obj_handle, dataIn, 0, MetaNumBytes) != 0) {
+            goto unlock_exit;
+        }
     } else {
         struct UAVOData *obj;
         InstanceHandle instEntry;
@@ -920,15 +1129,18 @@ int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
             goto unlock_exit;
         }
         // Set data
-        memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
+        writeInstance(obj, instEntry, dataIn, 0, obj->instance_size);
     }
 
-    // Fire event
-    sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
     rc = 0;
 
 unlock_exit:
     xSemaphoreGiveRecursive(mutex);
+
+    // Fire event
+    if (rc == 0) {
+        sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
+    }
     return rc;
 }
 
@@ -960,7 +1172,9 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
         }
 
         // Set data
-        memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, dataIn, size);
+        if (writeMetaData((struct UAVOMeta *)obj_handle, dataIn, offset, size) != 0) {
+            goto unlock_exit;
+        }
     } else {
         struct UAVOData *obj;
         InstanceHandle instEntry;
@@ -985,16 +1199,19 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
         }
 
         // Set data
-        memcpy(InstanceData(instEntry) + offset, dataIn, size);
+        writeInstance(obj, instEntry, dataIn, offset, size);
     }
 
 
-    // Fire event
-    sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
     rc = 0;
 
 unlock_exit:
     xSemaphoreGiveRecursive(mutex);
+
+    // Fire event
+    if (rc == 0) {
+        sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
+    }
     return rc;
 }
 
@@ -1010,6 +1227,14 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
     PIOS_Assert(obj_handle);
 
+    if (((struct UAVOBase *)obj_handle)->flags.isSeqLocked) {
+        if (instId != 0) {
+            return -1;
+        }
+        readSeqLocked((struct UAVOData *)obj_handle, dataOut, 0, ((struct UAVOData *)obj_handle)->instance_size);
+        return 0;
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1056,6 +1281,14 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
     PIOS_Assert(obj_handle);
 
+    if (((struct UAVOBase *)obj_handle)->flags.isSeqLocked) {
+        if (instId != 0 || (size + offset) > ((struct UAVOData *)obj_handle)->instance_size) {
+            return -1;
+        }
+        readSeqLocked((struct UAVOData *)obj_handle, dataOut, offset, size);
+        return 0;
+    }
+
     // Lock
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
 
@@ -1073,7 +1306,7 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
         }
 
         // Set data
-        memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
+        memcpy(dataOut, (const uint8_t *)MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
     } else {
         struct UAVOData *obj;
         InstanceHandle instEntry;
@@ -1126,6 +1359,76 @@ int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata *dataIn)
     return 0;
 }
 
+/**
+ * Set the object metadata to its constant defaults. Unless the metadata has
+ * been written before, the object keeps pointing at them instead of a copy.
+ * \param[in] obj The object handle
+ * \param[in] defaults The default metadata, which must not change or go away
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetDefaultMetadata(UAVObjHandle obj_handle, const UAVObjMetadata *defaults)
+{
+    PIOS_Assert(obj_handle);
+
+    if (UAVObjIsMetaobject(obj_handle)) {
+        return -1;
+    }
+
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+
+    struct UAVOMeta *meta = &((struct UAVOData *)obj_handle)->metaObj;
+    if (meta->base.flags.isMetaInRam) {
+        // readers do not hold the mutex, the copy stays
+        memcpy((UAVObjMetadata *)meta->instance0, defaults, MetaNumBytes);
+    } else {
+        meta->instance0 = defaults;
+    }
+    sendEvent(&meta->base, 0, EV_UPDATED);
+
+    xSemaphoreGiveRecursive(mutex);
+    return 0;
+}
+
+/**
+ * Set an object instance, and the metadata with instance 0, to the defaults
+ * generated for the object. Shared by the SetDefaults() of all objects, which
+ * keep their defaults in a table instead of code.
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] defaults The defaults, which must not change or go away
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetInstanceDefaults(UAVObjHandle obj_handle, uint16_t instId, const UAVObjDefaults *defaults)
+{
+    PIOS_Assert(obj_handle);
+
+    if (UAVObjIsMetaobject(obj_handle)) {
+        return -1;
+    }
+
+    // Lock
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+
+    int32_t rc = -1;
+    struct UAVOData *obj = (struct UAVOData *)obj_handle;
+    InstanceHandle instEntry = getInstance(obj, instId);
+
+    // A read only instance keeps its data but still gets the default metadata
+    if (instEntry != NULL && !UAVObjReadOnly(obj_handle)) {
+        writeInstance(obj, instEntry, defaults->data, 0, obj->instance_size);
+        sendEvent(&obj->base, instId, EV_UPDATED);
+        rc = 0;
+    }
+
+    if (instId == 0) {
+        UAVObjSetDefaultMetadata(obj_handle, &defaults->metadata);
+    }
+
+    // Unlock
+    xSemaphoreGiveRecursive(mutex);
+    return rc;
+}
+
 /**
  * Get the object metadata
  * \param[in] obj The object handle
@@ -1343,7 +1646,28 @@ int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, xQueueHandle queue,
     PIOS_Assert(queue);
     int32_t res;
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    res = connectObj(obj_handle, queue, 0, eventMask);
+    res = connectObj(obj_handle, queue, 0, eventMask, false);
+    xSemaphoreGiveRecursive(mutex);
+    return res;
+}
+
+/**
+ * Connect an event queue to the object as UAVObjConnectQueue(), the events are sent as
+ * UAVObjTimestampedEvent with the time they were generated, for the subscribers which
+ * do not process them right away but need the time of the update.
+ * \param[in] obj The object handle
+ * \param[in] queue The event queue, of items of sizeof(UAVObjTimestampedEvent)
+ * \param[in] eventMask The event mask, if EV_MASK_ALL then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectQueueTimestamped(UAVObjHandle obj_handle, xQueueHandle queue,
+                                      uint8_t eventMask)
+{
+    PIOS_Assert(obj_handle);
+    PIOS_Assert(queue);
+    int32_t res;
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    res = connectObj(obj_handle, queue, 0, eventMask, true);
     xSemaphoreGiveRecursive(mutex);
     return res;
 }
@@ -1379,7 +1703,7 @@ int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb,
     PIOS_Assert(obj_handle);
     int32_t res;
     xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
-    res = connectObj(obj_handle, 0, cb, eventMask);
+    res = connectObj(obj_handle, 0, cb, eventMask, false);
     xSemaphoreGiveRecursive(mutex);
     return res;
 }
@@ -1419,9 +1743,7 @@ void UAVObjRequestUpdate(UAVObjHandle obj_handle)
 void UAVObjRequestInstanceUpdate(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATE_REQ);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /**
@@ -1441,9 +1763,7 @@ void UAVObjUpdated(UAVObjHandle obj_handle)
 void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED_MANUAL);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /**
@@ -1454,9 +1774,7 @@ void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 static void instanceAutoUpdated(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /*
@@ -1476,9 +1794,7 @@ void UAVObjLogging(UAVObjHandle obj_handle)
 void UAVObjInstanceLogging(UAVObjHandle obj_handle, uint16_t instId)
 {
     PIOS_Assert(obj_handle);
-    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     sendEvent((struct UAVOBase *)obj_handle, instId, EV_LOGGING_MANUAL);
-    xSemaphoreGiveRecursive(mutex);
 }
 
 /**
@@ -1503,11 +1819,52 @@ void UAVObjIterate(void (*iterator)(UAVObjHandle obj))
 xSemaphoreGiveRecursive(mutex);
 }
 
+/**
+ * Notify one subscriber of an event
+ */
+static void dispatchEvent(UAVObjEvent *msg, xQueueHandle queue, UAVObjEventCallback cb, bool timestamped)
+{
+    // Send to queue if a valid queue is registered
+    if (queue && timestamped) {
+        UAVObjTimestampedEvent timestampedMsg = {
+            .ev        = *msg,
+            .timestamp = PIOS_DELAY_GetuS(),
+        };
+        // will not block
+        if (xQueueSend(queue, &timestampedMsg, 0) != pdTRUE) {
+            ++stats.eventQueueErrors;
+            stats.lastQueueErrorID = UAVObjGetID(msg->obj);
+        }
+    } else if (queue) {
+        // will not block
+        if (xQueueSend(queue, msg, 0) != pdTRUE) {
+            ++stats.eventQueueErrors;
+            stats.lastQueueErrorID = UAVObjGetID(msg->obj);
+        }
+    }
+
+    // Invoke callback (from event task) if a valid one is registered
+    if (cb) {
+        // invoke callback from the event task, will not block
+        if (EventCallbackDispatch(msg, cb) != pdTRUE) {
+            ++stats.eventCallbackErrors;
+            stats.lastCallbackErrorID = UAVObjGetID(msg->obj);
+        }
+    }
+}
+
 /**
  * Send a triggered event to all event queues registered on the object.
+ * The subscribers are collected under the mutex and notified once it is released,
+ * callers should not hold it so other tasks can access objects during the fan-out.
  */
 int32_t sendEvent(struct UAVOBase *obj, uint16_t instId, UAVObjEventType triggered_event)
 {
+    // Most events have no subscriber at all, such as the manual and logging events of most objects
+    if ((obj->eventMask & triggered_event) == 0) {
+        return 0;
+    }
+
     /* Set up the message that will be sent to all registered listeners */
     UAVObjEvent msg = {
         .obj    = (UAVObjHandle)obj,
@@ -1516,34 +1873,123 @@ int32_t sendEvent(struct UAVOBase *obj, uint16_t instId, UAVObjEventType trigger
         .lowPriority = false,
     };
 
-    // Go through each object and push the event message in the queue (if event is activated for the queue)
+    struct {
+        xQueueHandle queue;
+        UAVObjEventCallback cb;
+        bool timestamped;
+    } targets[UAVOBJ_EVENT_FANOUT_MAX];
+    uint8_t numTargets = 0;
+
+    // Go through each object and collect the queues and callbacks the event is activated for,
+    // the ones which do not fit are notified right away
     struct ObjectEventEntry *event;
 
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
     LL_FOREACH(obj->next_event, event) {
         if (event->eventMask == 0 || (event->eventMask & triggered_event) != 0) {
-            // Send to queue if a valid queue is registered
-            if (event->queue) {
-                // will not block
-                if (xQueueSend(event->queue, &msg, 0) != pdTRUE) {
-                    ++stats.eventQueueErrors;
-                    stats.lastQueueErrorID = UAVObjGetID(obj);
-                }
-            }
-
-            // Invoke callback (from event task) if a valid one is registered
-            if (event->cb) {
-                // invoke callback from the event task, will not block
-                if (EventCallbackDispatch(&msg, event->cb) != pdTRUE) {
-                    ++stats.eventCallbackErrors;
-                    stats.lastCallbackErrorID = UAVObjGetID(obj);
-                }
+            if (numTargets < UAVOBJ_EVENT_FANOUT_MAX) {
+                targets[numTargets].queue = event->queue;
+                targets[numTargets].cb    = event->cb;
+                targets[numTargets].timestamped = event->timestamped;
+                ++numTargets;
+            } else {
+                dispatchEvent(&msg, event->queue, event->cb, event->timestamped);
             }
         }
     }
+    xSemaphoreGiveRecursive(mutex);
+
+    for (uint8_t i = 0; i < numTargets; ++i) {
+        dispatchEvent(&msg, targets[i].queue, targets[i].cb, targets[i].timestamped);
+    }
 
     return 0;
 }
 
+/**
+ * Recompute the union of the event masks of the queues and callbacks connected to the object
+ */
+static void updateEventMask(struct UAVOBase *obj)
+{
+    struct ObjectEventEntry *event;
+    uint8_t eventMask = 0;
+
+    LL_FOREACH(obj->next_event, event) {
+        eventMask |= (event->eventMask == EV_MASK_ALL) ? 0xFF : event->eventMask;
+    }
+    obj->eventMask = eventMask;
+}
+
+static void copyInstance(uint8_t *dest, const void *dataIn, uint32_t size)
+{
+    if (dataIn) {
+        memcpy(dest, dataIn, size);
+    } else {
+        memset(dest, 0, size);
+    }
+}
+
+/**
+ * Copy data into an instance, the mutex must be held. NULL data clears it.
+ * The sequence counter of sequence locked objects is odd during the copy so lock-free readers retry.
+ */
+static void writeInstance(struct UAVOData *obj, InstanceHandle instEntry, const void *dataIn, uint32_t offset, uint32_t size)
+{
+    if (obj->base.flags.isSeqLocked) {
+        struct UAVOSingle *uavo_single = (struct UAVOSingle *)obj;
+        uavo_single->seq++;
+        __sync_synchronize();
+        copyInstance(InstanceData(instEntry) + offset, dataIn, size);
+        __sync_synchronize();
+        uavo_single->seq++;
+    } else {
+        copyInstance(InstanceData(instEntry) + offset, dataIn, size);
+    }
+}
+
+/**
+ * Read the data of a sequence locked object without taking the mutex.
+ * A reader which preempted a writer finds an odd counter and can not spin on it,
+ * so it waits on the mutex instead where the priority inheritance lets the writer complete.
+ */
+static void readSeqLocked(struct UAVOData *obj, void *dataOut, uint32_t offset, uint32_t size)
+{
+    struct UAVOSingle *uavo_single = (struct UAVOSingle *)obj;
+
+    for (uint8_t retry = 0; retry < UAVOBJ_SEQLOCK_RETRIES; ++retry) {
+        uint32_t seq = uavo_single->seq;
+        if (seq & 1) {
+            break;
+        }
+        __sync_synchronize();
+        memcpy(dataOut, uavo_single->instance0 + offset, size);
+        __sync_synchronize();
+        if (uavo_single->seq == seq) {
+            return;
+        }
+    }
+
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    memcpy(dataOut, uavo_single->instance0 + offset, size);
+    xSemaphoreGiveRecursive(mutex);
+}
+
+#ifdef UAVOBJ_DEFERRED_SETTINGS_LOAD
+/**
+ * Load a settings object whose load was deferred at registration.
+ * The flag is checked again under the lock as another task may have loaded it meanwhile,
+ * UAVObjLoad() clears it before its own getInstance() so this does not recurse.
+ */
+static void loadPending(struct UAVOData *obj)
+{
+    xSemaphoreTakeRecursive(mutex, portMAX_DELAY);
+    if (obj->base.flags.isLoadPending) {
+        UAVObjLoad((UAVObjHandle)obj, 0);
+    }
+    xSemaphoreGiveRecursive(mutex);
+}
+#endif
+
 /**
  * Create a new object instance, return the instance info or NULL if failure.
  */
@@ -1574,22 +2020,52 @@ static InstanceHandle createInstance(struct UAVOData *obj, uint16_t instId)
         }
     }
 
-    /* Create the actual instance */
-    uint32_t size = sizeof(struct UAVOMultiInst) + obj->instance_size;
-    instEntry = (struct UAVOMultiInst *)pios_malloc(size);
-    if (!instEntry) {
-        return NULL;
+    /* Create the actual instance, the preallocated ones are already cleared */
+    struct UAVOMulti *uavo_multi = (struct UAVOMulti *)obj;
+    InstanceHandle instance;
+    if (instId < uavo_multi->capacity) {
+        instance = &uavo_multi->instances[instId * MultiInstanceStride(obj)];
+    } else {
+        uint32_t size = sizeof(struct UAVOMultiInst) + obj->instance_size;
+        instEntry = (struct UAVOMultiInst *)pios_malloc(size);
+        if (!instEntry) {
+            return NULL;
+        }
+        memset(instEntry, 0, size);
+        LL_APPEND(uavo_multi->overflow, instEntry);
+        instance = InstanceDataOffset(instEntry);
     }
-    memset(instEntry, 0, size);
-    LL_APPEND(((struct UAVOMulti *)obj)->instance0.next, instEntry);
 
-    ((struct UAVOMulti *)obj)->num_instances++;
+    uavo_multi->num_instances++;
 
     // Fire event
     instanceAutoUpdated((UAVObjHandle)obj, instId);
 
     // Done
-    return InstanceDataOffset(instEntry);
+    return instance;
+}
+
+/**
+ * Write to the metadata of a meta object, which is copied from its
+ * constant defaults to the heap on the first write that changes it
+ * \return 0 if success or -1 if out of memory
+ */
+int32_t writeMetaData(struct UAVOMeta *obj, const void *dataIn, uint32_t offset, uint32_t size)
+{
+    if (!obj->base.flags.isMetaInRam) {
+        if (memcmp((const uint8_t *)obj->instance0 + offset, dataIn, size) == 0) {
+            return 0;
+        }
+        UAVObjMetadata *copy = (UAVObjMetadata *)pios_malloc(MetaNumBytes);
+        if (copy == NULL) {
+            return -1;
+        }
+        memcpy(copy, obj->instance0, MetaNumBytes);
+        obj->instance0 = copy;
+        obj->base.flags.isMetaInRam = true;
+    }
+    memcpy((uint8_t *)obj->instance0 + offset, dataIn, size);
+    return 0;
 }
 
 /**
@@ -1597,6 +2073,11 @@ static InstanceHandle createInstance(struct UAVOData *obj, uint16_t instId)
  */
 InstanceHandle getInstance(struct UAVOData *obj, uint16_t instId)
 {
+#ifdef UAVOBJ_DEFERRED_SETTINGS_LOAD
+    if (obj->base.flags.isLoadPending) {
+        loadPending(obj);
+    }
+#endif
     if (UAVObjIsMetaobject(&obj->base)) {
         /* Metadata Instance */
 
@@ -1625,10 +2106,14 @@ InstanceHandle getInstance(struct UAVOData *obj, uint16_t instId)
             return NULL;
         }
 
-        // Look for specified instance ID
-        uint16_t instance = 0;
+        if (instId < uavo_multi->capacity) {
+            return &uavo_multi->instances[instId * MultiInstanceStride(obj)];
+        }
+
+        // Look for specified instance ID in the ones past the capacity
+        uint16_t instance = uavo_multi->capacity;
         struct UAVOMultiInst *instEntry;
-        LL_FOREACH(&(uavo_multi->instance0), instEntry) {
+        LL_FOREACH(uavo_multi->overflow, instEntry) {
             if (instance++ == instId) {
                 /* Found it */
                 return &(instEntry->instance);
@@ -1648,7 +2133,7 @@ InstanceHandle getInstance(struct UAVOData *obj, uint16_t instId)
  * \return 0 if success or -1 if failure
  */
 static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
-                          UAVObjEventCallback cb, uint8_t eventMask)
+                          UAVObjEventCallback cb, uint8_t eventMask, bool timestamped)
 {
     struct ObjectEventEntry *event;
     struct UAVOBase *obj;
@@ -1658,7 +2143,9 @@ static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
     LL_FOREACH(obj->next_event, event) {
         if (event->queue == queue && event->cb == cb) {
             // Already connected, update event mask and return
-            event->eventMask = eventMask;
+            event->eventMask   = eventMask;
+            event->timestamped = timestamped;
+            updateEventMask(obj);
             return 0;
         }
     }
@@ -1671,7 +2158,9 @@ static int32_t connectObj(UAVObjHandle obj_handle, xQueueHandle queue,
     event->queue     = queue;
     event->cb        = cb;
     event->eventMask = eventMask;
+    event->timestamped = timestamped;
     LL_APPEND(obj->next_event, event);
+    updateEventMask(obj);
 
     // Done
     return 0;
@@ -1697,6 +2186,7 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, xQueueHandle queue,
              && event->cb == cb)) {
             LL_DELETE(obj->next_event, event);
             vPortFree(event);
+            updateEventMask(obj);
             return 0;
         }
     }
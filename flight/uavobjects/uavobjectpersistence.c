@@ -87,13 +87,23 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
             return -1;
         }
 
-        // Fire event on success
-        if (PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id, UAVObjGetID(obj_handle), instId, (uint8_t *)MetaDataPtr((struct UAVOMeta *)obj_handle), UAVObjGetNumBytes(obj_handle)) == 0) {
-            sendEvent((struct UAVOBase *)obj_handle, instId, EV_UNPACKED);
-        } else {
+        // Only saved metadata that differs from the defaults takes memory
+        UAVObjMetadata metadata;
+        if (PIOS_FLASHFS_ObjLoad(pios_uavo_settings_fs_id, UAVObjGetID(obj_handle), instId, (uint8_t *)&metadata, UAVObjGetNumBytes(obj_handle)) != 0) {
+            return -1;
+        }
+        if (writeMetaData((struct UAVOMeta *)obj_handle, &metadata, 0, MetaNumBytes) != 0) {
             return -1;
         }
+
+        // Fire event on success
+        sendEvent((struct UAVOBase *)obj_handle, instId, EV_UNPACKED);
     } else {
+        if (instId == 0) {
+            // loaded now, whatever the outcome, so a deferred load must not overwrite it later
+            ((struct UAVOBase *)obj_handle)->flags.isLoadPending = false;
+        }
+
         InstanceHandle instEntry = getInstance((struct UAVOData *)obj_handle, instId);
 
         if (instEntry == NULL) {
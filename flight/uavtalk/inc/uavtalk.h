@@ -46,6 +46,17 @@ typedef struct {
     uint32_t rxCrcErrors;
 } UAVTalkStats;
 
+// Size of the per object traffic tables, the last entry takes the objects that found no room
+#define UAVTALK_OBJECT_STATS_SIZE 16
+
+typedef struct {
+    uint32_t objId; // 0 in the last entry, and for the multi-object frames received
+    uint32_t txBytes;
+    uint32_t rxBytes;
+    uint16_t txPackets;
+    uint16_t rxPackets;
+} UAVTalkObjectStats;
+
 typedef void *UAVTalkConnection;
 
 typedef enum { UAVTALK_STATE_ERROR = 0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, UAVTALK_STATE_SIZE, UAVTALK_STATE_OBJID, UAVTALK_STATE_INSTID, UAVTALK_STATE_TIMESTAMP, UAVTALK_STATE_DATA, UAVTALK_STATE_CS, UAVTALK_STATE_COMPLETE } UAVTalkRxState;
@@ -57,13 +68,22 @@ UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
+int32_t UAVTalkSendObjectBatched(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId);
+int32_t UAVTalkFlushBatch(UAVTalkConnection connection);
+int32_t UAVTalkSendObjectDelta(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t keyFramePeriod);
 UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connection, uint8_t rxbyte);
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connection, uint8_t rxbyte);
+UAVTalkRxState UAVTalkProcessInputBufferQuiet(UAVTalkConnection connection, const uint8_t *buf, uint16_t length, uint16_t *used);
+int32_t UAVTalkProcessInputBuffer(UAVTalkConnection connection, const uint8_t *buf, uint16_t length);
 int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle);
+int32_t UAVTalkSetRelayFilter(UAVTalkConnection connectionHandle, const uint32_t *objIds, uint16_t count);
 int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle);
 void UAVTalkGetStats(UAVTalkConnection connection, UAVTalkStats *stats, bool reset);
 void UAVTalkAddStats(UAVTalkConnection connection, UAVTalkStats *stats, bool reset);
 void UAVTalkResetStats(UAVTalkConnection connection);
+#ifdef DIAG_TELEMETRY
+void UAVTalkAddObjectStats(UAVTalkConnection connection, UAVTalkObjectStats stats[UAVTALK_OBJECT_STATS_SIZE], bool reset);
+#endif
 void UAVTalkGetLastTimestamp(UAVTalkConnection connection, uint16_t *timestamp);
 uint32_t UAVTalkGetPacketObjId(UAVTalkConnection connection);
 
@@ -46,6 +46,27 @@
 #define UAVTALK_MIN_PACKET_LENGTH  UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH  UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
 
+// multi-object frame entry : object ID(4), instance ID(2), data length(1), data
+#define UAVTALK_MULTI_ENTRY_HEADER_LENGTH 7
+
+// multi-object frames must be accepted by the receivers as any other frame, and entry lengths are one byte
+#define UAVTALK_MAX_MULTI_PAYLOAD_LENGTH  (UAVOBJECTS_LARGEST < 255 ? UAVOBJECTS_LARGEST : 255)
+
+// delta frame payload : epoch(1), sequence number(1), chunk bitmask, changed chunks
+#define UAVTALK_DELTA_HEADER_LENGTH       2
+#define UAVTALK_DELTA_CHUNK_LENGTH        4
+#define UAVTALK_DELTA_KEYFRAME_DUE        0xFF // Sequence number forcing a key frame whatever the period
+#define UAVTALK_DELTA_NUM_CHUNKS(length)  (((length) + UAVTALK_DELTA_CHUNK_LENGTH - 1) / UAVTALK_DELTA_CHUNK_LENGTH)
+#define UAVTALK_DELTA_MASK_LENGTH(length) ((UAVTALK_DELTA_NUM_CHUNKS(length) + 7) / 8)
+#define UAVTALK_MAX_DELTA_PAYLOAD_LENGTH  UAVTALK_MAX_MULTI_PAYLOAD_LENGTH
+
+// Number of object instances tracked for delta encoding per connection
+#if defined(PIOS_UAVTALK_DELTA_MAX_OBJECTS)
+#define UAVTALK_DELTA_MAX_OBJECTS         PIOS_UAVTALK_DELTA_MAX_OBJECTS
+#else
+#define UAVTALK_DELTA_MAX_OBJECTS         32
+#endif
+
 typedef struct {
     uint8_t  type;
     uint16_t packet_size;
@@ -60,6 +81,15 @@ typedef struct {
     uint16_t rxPacketLength;
 } UAVTalkInputProcessor;
 
+/* Last image sent of an object instance, the base of the next delta */
+typedef struct {
+    uint32_t objId;
+    uint16_t instId;
+    uint8_t  epoch; // Number of the last key frame
+    uint8_t  seq; // Sequence number of the last frame in the epoch, zero for the key frame
+    uint8_t  *image;
+} UAVTalkDeltaEntry;
+
 typedef struct {
     uint8_t canari;
     UAVTalkOutputStream outStream;
@@ -71,8 +101,18 @@ typedef struct {
     uint16_t     respInstId;
     UAVTalkStats stats;
     UAVTalkInputProcessor iproc;
-    uint8_t      *rxBuffer;
+    uint8_t      *rxBuffer; // Payload of the received frame, its header is stored right before it and its CRC right after
     uint8_t      *txBuffer;
+    const uint32_t *relayFilter; // Object IDs relayed to this connection, all when NULL
+    uint16_t     relayFilterCount;
+    uint16_t     multiLength; // Length of the pending multi-object frame payload in txBuffer
+    uint8_t      multiCount; // Number of objects in the pending multi-object frame
+    UAVTalkDeltaEntry *deltaEntries; // Allocated on the first delta frame
+    uint8_t      deltaCount;
+#ifdef DIAG_TELEMETRY
+    UAVTalkObjectStats txObjectStats[UAVTALK_OBJECT_STATS_SIZE]; // Written with the lock held
+    UAVTalkObjectStats rxObjectStats[UAVTALK_OBJECT_STATS_SIZE]; // Written by the receiving task
+#endif
 } UAVTalkConnectionData;
 
 #define UAVTALK_CANARI          0xCA
@@ -86,6 +126,8 @@ typedef struct {
 #define UAVTALK_TYPE_OBJ_ACK    (UAVTALK_TYPE_VER | 0x02)
 #define UAVTALK_TYPE_ACK        (UAVTALK_TYPE_VER | 0x03)
 #define UAVTALK_TYPE_NACK       (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_OBJ_MULTI  (UAVTALK_TYPE_VER | 0x05)
+#define UAVTALK_TYPE_OBJ_DELTA  (UAVTALK_TYPE_VER | 0x06)
 #define UAVTALK_TYPE_OBJ_TS     (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 #define UAVTALK_TYPE_OBJ_ACK_TS (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
 
@@ -51,8 +51,22 @@
 static int32_t objectTransaction(UAVTalkConnectionData *connection, uint8_t type, UAVObjHandle obj, uint16_t instId, int32_t timeout);
 static int32_t sendObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, UAVObjHandle obj);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, UAVObjHandle obj);
+static int32_t batchObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static int32_t flushBatch(UAVTalkConnectionData *connection);
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t keyFramePeriod);
+static UAVTalkDeltaEntry *findDeltaEntry(UAVTalkConnectionData *connection, uint32_t objId, uint16_t instId);
+static void deltaRequestKeyFrame(UAVTalkConnectionData *connection, uint32_t objId);
 static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t *data);
 static void updateAck(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId);
+static uint8_t *rxFrame(UAVTalkConnectionData *connection);
+#ifdef DIAG_TELEMETRY
+static UAVTalkObjectStats *objectStatsEntry(UAVTalkObjectStats *table, uint32_t objId);
+static void countObjectTx(UAVTalkConnectionData *connection, uint32_t objId, uint32_t bytes);
+static void countObjectRx(UAVTalkConnectionData *connection, uint32_t objId, uint32_t bytes);
+#else
+#define countObjectTx(connection, objId, bytes)
+#define countObjectRx(connection, objId, bytes)
+#endif
 
 /**
  * Initialize the UAVTalk library
@@ -73,13 +87,20 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
     connection->iproc.rxPacketLength = 0;
     connection->iproc.state = UAVTALK_STATE_SYNC;
     connection->outStream   = outputStream;
+    connection->multiLength = 0;
+    connection->multiCount  = 0;
+    connection->deltaEntries = NULL;
+    connection->deltaCount  = 0;
+    connection->relayFilter = NULL;
+    connection->relayFilterCount = 0;
     connection->lock = xSemaphoreCreateRecursiveMutex();
     connection->transLock   = xSemaphoreCreateRecursiveMutex();
-    // allocate buffers
+    // allocate buffers, the received header goes in front of the payload
     connection->rxBuffer    = pios_malloc(UAVTALK_MAX_PACKET_LENGTH);
     if (!connection->rxBuffer) {
         return 0;
     }
+    connection->rxBuffer   += UAVTALK_MAX_HEADER_LENGTH;
     connection->txBuffer = pios_malloc(UAVTALK_MAX_PACKET_LENGTH);
     if (!connection->txBuffer) {
         return 0;
@@ -204,10 +225,59 @@ void UAVTalkResetStats(UAVTalkConnection connectionHandle)
 
     // Clear stats
     memset(&connection->stats, 0, sizeof(UAVTalkStats));
+#ifdef DIAG_TELEMETRY
+    memset(connection->txObjectStats, 0, sizeof(connection->txObjectStats));
+    memset(connection->rxObjectStats, 0, sizeof(connection->rxObjectStats));
+#endif
+
+    // Release lock
+    xSemaphoreGiveRecursive(connection->lock);
+}
+
+#ifdef DIAG_TELEMETRY
+/**
+ * Add the per object traffic counters to a table, objects are looked up by ID
+ * and the ones that find no room in it are added to its last entry.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in,out] stats Table to add to, zeroed before the first call
+ * \param[in] reset Clear the counters of the connection
+ */
+void UAVTalkAddObjectStats(UAVTalkConnection connectionHandle, UAVTalkObjectStats stats[UAVTALK_OBJECT_STATS_SIZE], bool reset)
+{
+    UAVTalkConnectionData *connection;
+
+    CHECKCONHANDLE(connectionHandle, connection, return );
+
+    // Lock, the receiving task does not take it: a packet received during the
+    // reset may be lost or land in an entry of the next period
+    xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+
+    for (uint8_t n = 0; n < UAVTALK_OBJECT_STATS_SIZE; n++) {
+        const UAVTalkObjectStats *tx = &connection->txObjectStats[n];
+        const UAVTalkObjectStats *rx = &connection->rxObjectStats[n];
+        UAVTalkObjectStats *entry;
+
+        if (tx->txPackets > 0) {
+            entry = objectStatsEntry(stats, tx->objId);
+            entry->txBytes   += tx->txBytes;
+            entry->txPackets += tx->txPackets;
+        }
+        if (rx->rxPackets > 0) {
+            entry = objectStatsEntry(stats, rx->objId);
+            entry->rxBytes   += rx->rxBytes;
+            entry->rxPackets += rx->rxPackets;
+        }
+    }
+
+    if (reset) {
+        memset(connection->txObjectStats, 0, sizeof(connection->txObjectStats));
+        memset(connection->rxObjectStats, 0, sizeof(connection->rxObjectStats));
+    }
 
     // Release lock
     xSemaphoreGiveRecursive(connection->lock);
 }
+#endif /* DIAG_TELEMETRY */
 
 /**
  * Accessor method to get the timestamp from the last UAVTalk message
@@ -289,6 +359,98 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
     }
 }
 
+/**
+ * Add the specified object to the pending multi-object frame.
+ * The frame is sent by UAVTalkFlushBatch(), when it is full or before any other message
+ * goes out on the connection, so the order of the messages is kept.
+ * Batched objects are never acked.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectBatched(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+    UAVTalkConnectionData *connection;
+    int32_t ret = 0;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+    if (instId != UAVOBJ_ALL_INSTANCES) {
+        ret = batchObject(connection, obj, instId);
+    } else if (UAVObjIsSingleInstance(obj)) {
+        ret = batchObject(connection, obj, 0);
+    } else {
+        // Same reverse order as sendObject()
+        uint16_t numInst = UAVObjGetNumInstances(obj);
+        for (uint16_t n = 0; n < numInst && ret == 0; ++n) {
+            ret = batchObject(connection, obj, numInst - n - 1);
+        }
+    }
+    xSemaphoreGiveRecursive(connection->lock);
+
+    return ret;
+}
+
+/**
+ * Send the pending multi-object frame, if any.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkFlushBatch(UAVTalkConnection connectionHandle)
+{
+    UAVTalkConnectionData *connection;
+    int32_t ret;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+    ret = flushBatch(connection);
+    xSemaphoreGiveRecursive(connection->lock);
+
+    return ret;
+}
+
+/**
+ * Send the specified object as the changes since the previous frame of this object.
+ * Every keyFramePeriod frames, after a failed send and when the receiver requests the object,
+ * a key frame with all of the object and a new epoch is sent instead. Delta frames are never
+ * acked, a receiver which missed a frame drops the following deltas and requests a key frame.
+ * Objects which cannot be tracked are sent in full.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID or UAVOBJ_ALL_INSTANCES for all instances.
+ * \param[in] keyFramePeriod Number of frames between full frames (the maximum is 255)
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectDelta(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t keyFramePeriod)
+{
+    UAVTalkConnectionData *connection;
+    int32_t ret = 0;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+    if (instId != UAVOBJ_ALL_INSTANCES) {
+        ret = sendDeltaObject(connection, obj, instId, keyFramePeriod);
+    } else if (UAVObjIsSingleInstance(obj)) {
+        ret = sendDeltaObject(connection, obj, 0, keyFramePeriod);
+    } else {
+        // Same reverse order as sendObject()
+        uint16_t numInst = UAVObjGetNumInstances(obj);
+        for (uint16_t n = 0; n < numInst && ret == 0; ++n) {
+            ret = sendDeltaObject(connection, obj, numInst - n - 1, keyFramePeriod);
+        }
+    }
+    xSemaphoreGiveRecursive(connection->lock);
+
+    return ret;
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -403,6 +565,8 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
         iproc->cs    = PIOS_CRC_updateByte(iproc->cs, rxbyte);
 
         iproc->type  = rxbyte;
+        rxFrame(connection)[0] = UAVTALK_SYNC_VAL;
+        rxFrame(connection)[1] = rxbyte;
 
         iproc->packet_size = 0;
         iproc->state = UAVTALK_STATE_SIZE;
@@ -412,6 +576,7 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 
         // update the CRC
         iproc->cs = PIOS_CRC_updateByte(iproc->cs, rxbyte);
+        rxFrame(connection)[iproc->rxPacketLength - 1] = rxbyte;
 
         if (iproc->rxCount == 0) {
             iproc->packet_size += rxbyte;
@@ -436,6 +601,7 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 
         // update the CRC
         iproc->cs     = PIOS_CRC_updateByte(iproc->cs, rxbyte);
+        rxFrame(connection)[iproc->rxPacketLength - 1] = rxbyte;
 
         iproc->objId += rxbyte << (8 * (iproc->rxCount++));
         if (iproc->rxCount < 4) {
@@ -451,6 +617,7 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 
         // update the CRC
         iproc->cs      = PIOS_CRC_updateByte(iproc->cs, rxbyte);
+        rxFrame(connection)[iproc->rxPacketLength - 1] = rxbyte;
 
         iproc->instId += rxbyte << (8 * (iproc->rxCount++));
         if (iproc->rxCount < 2) {
@@ -466,7 +633,8 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
             iproc->timestampLength = 0;
         } else {
             iproc->timestampLength = (iproc->type & UAVTALK_TIMESTAMPED) ? 2 : 0;
-            if (obj) {
+            // Multi-object and delta frames do not have the size of the object in the header
+            if (obj && iproc->type != UAVTALK_TYPE_OBJ_MULTI && iproc->type != UAVTALK_TYPE_OBJ_DELTA) {
                 iproc->length = UAVObjGetNumBytes(obj);
             } else {
                 iproc->length = iproc->packet_size - iproc->rxPacketLength - iproc->timestampLength;
@@ -508,6 +676,7 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 
         // update the CRC
         iproc->cs = PIOS_CRC_updateByte(iproc->cs, rxbyte);
+        rxFrame(connection)[iproc->rxPacketLength - 1] = rxbyte;
 
         iproc->timestamp += rxbyte << (8 * (iproc->rxCount++));
         if (iproc->rxCount < 2) {
@@ -556,8 +725,11 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
             break;
         }
 
+        connection->rxBuffer[iproc->length] = rxbyte;
+
         connection->stats.rxObjects++;
         connection->stats.rxObjectBytes += iproc->length;
+        countObjectRx(connection, iproc->objId, iproc->rxPacketLength);
 
         iproc->state = UAVTALK_STATE_COMPLETE;
         break;
@@ -572,6 +744,85 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
     return iproc->state;
 }
 
+/**
+ * Process bytes from the telemetry stream, up to the end of the next complete packet.
+ * The header bytes go through the state machine, the payload is copied in one go.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] buf Received bytes
+ * \param[in] length Number of received bytes
+ * \param[out] used Number of bytes processed, less than length when a packet completed early
+ * \return UAVTalkRxState after the last byte processed
+ */
+UAVTalkRxState UAVTalkProcessInputBufferQuiet(UAVTalkConnection connectionHandle, const uint8_t *buf, uint16_t length, uint16_t *used)
+{
+    UAVTalkConnectionData *connection;
+
+    // All dropped on an invalid connection
+    *used = length;
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    UAVTalkInputProcessor *iproc = &connection->iproc;
+    UAVTalkRxState state = iproc->state;
+    uint16_t pos = 0;
+
+    while (pos < length) {
+        if (iproc->state == UAVTALK_STATE_DATA) {
+            uint32_t count = iproc->length - iproc->rxCount;
+            if (count > (uint32_t)(length - pos)) {
+                count = length - pos;
+            }
+            memcpy(&connection->rxBuffer[iproc->rxCount], &buf[pos], count);
+            iproc->cs = PIOS_CRC_updateCRC(iproc->cs, &buf[pos], count);
+            iproc->rxCount += count;
+            // Bounded by the packet size checked in the header
+            iproc->rxPacketLength += count;
+            connection->stats.rxBytes += count;
+            pos += count;
+            if (iproc->rxCount == iproc->length) {
+                iproc->rxCount = 0;
+                iproc->state   = UAVTALK_STATE_CS;
+            }
+            state = iproc->state;
+            continue;
+        }
+        state = UAVTalkProcessInputStreamQuiet(connectionHandle, buf[pos++]);
+        if (state == UAVTALK_STATE_COMPLETE) {
+            break;
+        }
+    }
+
+    *used = pos;
+    return state;
+}
+
+/**
+ * Process a buffer from the telemetry stream and receive every packet completed in it.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] buf Received bytes
+ * \param[in] length Number of received bytes
+ * \return Number of packets completed
+ * \return -1 Invalid connection
+ */
+int32_t UAVTalkProcessInputBuffer(UAVTalkConnection connectionHandle, const uint8_t *buf, uint16_t length)
+{
+    UAVTalkConnectionData *connection;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    int32_t packets = 0;
+    while (length > 0) {
+        uint16_t used;
+        if (UAVTalkProcessInputBufferQuiet(connectionHandle, buf, length, &used) == UAVTALK_STATE_COMPLETE) {
+            UAVTalkReceiveObject(connectionHandle);
+            packets++;
+        }
+        buf    += used;
+        length -= used;
+    }
+
+    return packets;
+}
+
 /**
  * Process an byte from the telemetry stream.
  * \param[in] connection UAVTalkConnection to be used
@@ -592,11 +843,12 @@ UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uin
 /**
  * Send a parsed packet received on one connection handle out on a different connection handle.
  * The packet must be in a complete state, meaning it is completed parsing.
- * The packet is re-assembled from the component parts into a complete message and sent.
+ * The received frame is sent as is, header and CRC included, unless the object is
+ * filtered out by the relay filter of the output connection.
  * This can be used to relay packets from one UAVTalk connection to another.
- * \param[in] connection UAVTalkConnection to be used
- * \param[in] rxbyte Received byte
- * \return 0 Success
+ * \param[in] inConnectionHandle UAVTalkConnection the packet was received on
+ * \param[in] outConnectionHandle UAVTalkConnection to send it on
+ * \return 0 Success, also when the packet was filtered out
  * \return -1 Failure
  */
 int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle)
@@ -625,51 +877,34 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
     // Lock
     xSemaphoreTakeRecursive(outConnection->lock, portMAX_DELAY);
 
-    outConnection->txBuffer[0] = UAVTALK_SYNC_VAL;
-    // Setup type
-    outConnection->txBuffer[1] = inIproc->type;
-    // next 2 bytes are reserved for data length (inserted here later)
-    // Setup object ID
-    outConnection->txBuffer[4] = (uint8_t)(inIproc->objId & 0xFF);
-    outConnection->txBuffer[5] = (uint8_t)((inIproc->objId >> 8) & 0xFF);
-    outConnection->txBuffer[6] = (uint8_t)((inIproc->objId >> 16) & 0xFF);
-    outConnection->txBuffer[7] = (uint8_t)((inIproc->objId >> 24) & 0xFF);
-    // Setup instance ID
-    outConnection->txBuffer[8] = (uint8_t)(inIproc->instId & 0xFF);
-    outConnection->txBuffer[9] = (uint8_t)((inIproc->instId >> 8) & 0xFF);
-    int32_t headerLength = 10;
-
-    // Add timestamp when the transaction type is appropriate
-    if (inIproc->type & UAVTALK_TIMESTAMPED) {
-        portTickType time = xTaskGetTickCount();
-        outConnection->txBuffer[10] = (uint8_t)(time & 0xFF);
-        outConnection->txBuffer[11] = (uint8_t)((time >> 8) & 0xFF);
-        headerLength += 2;
-    }
-
-    // Copy data (if any)
-    if (inIproc->length > 0) {
-        memcpy(&outConnection->txBuffer[headerLength], inConnection->rxBuffer, inIproc->length);
+    if (outConnection->relayFilter) {
+        uint16_t n;
+        for (n = 0; n < outConnection->relayFilterCount && outConnection->relayFilter[n] != inIproc->objId; n++) {
+            ;
+        }
+        if (n == outConnection->relayFilterCount) {
+            xSemaphoreGiveRecursive(outConnection->lock);
+            return 0;
+        }
     }
 
-    // Store the packet length
-    outConnection->txBuffer[2] = (uint8_t)((headerLength + inIproc->length) & 0xFF);
-    outConnection->txBuffer[3] = (uint8_t)(((headerLength + inIproc->length) >> 8) & 0xFF);
-
-    // Copy the checksum
-    outConnection->txBuffer[headerLength + inIproc->length] = inIproc->cs;
+    // The relayed packet goes after the pending batch, which shares the buffer
+    flushBatch(outConnection);
 
-    // Send the buffer.
-    int32_t rc = (*outConnection->outStream)(outConnection->txBuffer, headerLength + inIproc->length + UAVTALK_CHECKSUM_LENGTH);
+    // Send the received frame.
+    int32_t length = inIproc->packet_size + UAVTALK_CHECKSUM_LENGTH;
+    int32_t rc     = (*outConnection->outStream)(rxFrame(inConnection), length);
 
     // Update stats
     outConnection->stats.txBytes += (rc > 0) ? rc : 0;
 
     // evaluate return value before releasing the lock
     int32_t ret = 0;
-    if (rc != (int32_t)(headerLength + inIproc->length + UAVTALK_CHECKSUM_LENGTH)) {
+    if (rc != length) {
         outConnection->stats.txErrors++;
         ret = -1;
+    } else {
+        countObjectTx(outConnection, inIproc->objId, length);
     }
 
     // Release lock
@@ -679,6 +914,28 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
     return ret;
 }
 
+/**
+ * Set the objects UAVTalkRelayPacket() sends on a connection.
+ * \param[in] connectionHandle UAVTalkConnection the packets are relayed to
+ * \param[in] objIds Object IDs to relay, NULL to relay all. Not copied, it must stay valid
+ * \param[in] count Number of object IDs
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetRelayFilter(UAVTalkConnection connectionHandle, const uint32_t *objIds, uint16_t count)
+{
+    UAVTalkConnectionData *connection;
+
+    CHECKCONHANDLE(connectionHandle, connection, return -1);
+
+    xSemaphoreTakeRecursive(connection->lock, portMAX_DELAY);
+    connection->relayFilter = objIds;
+    connection->relayFilterCount = objIds ? count : 0;
+    xSemaphoreGiveRecursive(connection->lock);
+
+    return 0;
+}
+
 /**
  * Complete receiving a UAVTalk packet.  This will cause the packet to be unpacked, acked, etc.
  * \param[in] connectionHandle UAVTalkConnection to be used
@@ -796,6 +1053,8 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
             // Object found, transmit it
             // The sent object will ack the object request on the receiver side
             ret = sendObject(connection, UAVTALK_TYPE_OBJ, objId, instId, obj);
+            // A receiver of delta frames requests the object when it lost their base
+            deltaRequestKeyFrame(connection, objId);
         } else {
             ret = -1;
         }
@@ -928,6 +1187,9 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type,
         return -1;
     }
 
+    // The pending batch shares the buffer and goes first to keep the message order
+    flushBatch(connection);
+
     // Setup sync byte
     connection->txBuffer[0] = UAVTALK_SYNC_VAL;
     // Setup type
@@ -989,6 +1251,7 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type,
         ++connection->stats.txObjects;
         connection->stats.txObjectBytes += length;
         connection->stats.txBytes += tx_msg_len;
+        countObjectTx(connection, objId, tx_msg_len);
     } else {
         connection->stats.txErrors++;
         // TODO rc == -1 connection not open, -2 buffer full should retry
@@ -1000,6 +1263,316 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, uint8_t type,
     return 0;
 }
 
+/**
+ * Pack an object into the pending multi-object frame, which is built in place in the transmit buffer.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t batchObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+    uint32_t objId  = UAVObjGetID(obj);
+    uint32_t length = UAVObjGetNumBytes(obj);
+
+    // Objects too large for a multi-object frame are sent on their own
+    if (UAVTALK_MULTI_ENTRY_HEADER_LENGTH + length > UAVTALK_MAX_MULTI_PAYLOAD_LENGTH) {
+        return sendSingleObject(connection, UAVTALK_TYPE_OBJ, objId, instId, obj);
+    }
+
+    // Make room if needed
+    if (connection->multiLength + UAVTALK_MULTI_ENTRY_HEADER_LENGTH + length > UAVTALK_MAX_MULTI_PAYLOAD_LENGTH) {
+        flushBatch(connection);
+    }
+
+    uint8_t *entry = &connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH + connection->multiLength];
+    entry[0] = (uint8_t)(objId & 0xFF);
+    entry[1] = (uint8_t)((objId >> 8) & 0xFF);
+    entry[2] = (uint8_t)((objId >> 16) & 0xFF);
+    entry[3] = (uint8_t)((objId >> 24) & 0xFF);
+    entry[4] = (uint8_t)(instId & 0xFF);
+    entry[5] = (uint8_t)((instId >> 8) & 0xFF);
+    entry[6] = (uint8_t)length;
+    if (UAVObjPack(obj, instId, &entry[UAVTALK_MULTI_ENTRY_HEADER_LENGTH]) == -1) {
+        connection->stats.txErrors++;
+        return -1;
+    }
+
+    connection->multiLength += UAVTALK_MULTI_ENTRY_HEADER_LENGTH + length;
+    connection->multiCount++;
+    // Counted once batched, the header of the frame is not shared out
+    countObjectTx(connection, objId, UAVTALK_MULTI_ENTRY_HEADER_LENGTH + length);
+
+    return 0;
+}
+
+/**
+ * Send the pending multi-object frame.
+ * A frame holding a single object is sent as a regular object message.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t flushBatch(UAVTalkConnectionData *connection)
+{
+    uint8_t count  = connection->multiCount;
+    int32_t length = connection->multiLength;
+    int32_t objectBytes;
+
+    if (count == 0) {
+        return 0;
+    }
+    connection->multiCount  = 0;
+    connection->multiLength = 0;
+
+    if (!connection->outStream) {
+        connection->stats.txErrors++;
+        return -1;
+    }
+
+    uint8_t *entry = &connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH];
+    if (count == 1) {
+        // Object and instance IDs of the entry move into the header, the data moves up
+        connection->txBuffer[1] = UAVTALK_TYPE_OBJ;
+        memcpy(&connection->txBuffer[4], entry, 6);
+        length = entry[6];
+        memmove(entry, &entry[UAVTALK_MULTI_ENTRY_HEADER_LENGTH], length);
+        objectBytes = length;
+    } else {
+        // The object ID is zero and the instance ID holds the number of objects
+        connection->txBuffer[1] = UAVTALK_TYPE_OBJ_MULTI;
+        connection->txBuffer[4] = 0;
+        connection->txBuffer[5] = 0;
+        connection->txBuffer[6] = 0;
+        connection->txBuffer[7] = 0;
+        connection->txBuffer[8] = count;
+        connection->txBuffer[9] = 0;
+        objectBytes = length - count * UAVTALK_MULTI_ENTRY_HEADER_LENGTH;
+    }
+    connection->txBuffer[0] = UAVTALK_SYNC_VAL;
+
+    // Store the packet length
+    connection->txBuffer[2] = (uint8_t)((UAVTALK_MIN_HEADER_LENGTH + length) & 0xFF);
+    connection->txBuffer[3] = (uint8_t)(((UAVTALK_MIN_HEADER_LENGTH + length) >> 8) & 0xFF);
+
+    // Calculate and store checksum
+    connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH + length] = PIOS_CRC_updateCRC(0, connection->txBuffer, UAVTALK_MIN_HEADER_LENGTH + length);
+
+    // Send all objects at once
+    uint16_t tx_msg_len = UAVTALK_MIN_HEADER_LENGTH + length + UAVTALK_CHECKSUM_LENGTH;
+    int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+
+    // Update stats
+    if (rc == tx_msg_len) {
+        connection->stats.txObjects     += count;
+        connection->stats.txObjectBytes += objectBytes;
+        connection->stats.txBytes += tx_msg_len;
+    } else {
+        connection->stats.txErrors++;
+        connection->stats.txBytes += (rc > 0) ? rc : 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Send an object instance as a delta frame, a key frame when one is due, or in full when it cannot be tracked.
+ * The new data is packed in the transmit buffer where the chunks start and the changed chunks
+ * are moved down in place, so no other buffer than the image of the previous frame is needed.
+ * A key frame is a delta frame of sequence number zero with all the chunks, it starts a new epoch.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID (can NOT be UAVOBJ_ALL_INSTANCES)
+ * \param[in] keyFramePeriod Number of frames between full frames
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t keyFramePeriod)
+{
+    uint32_t objId   = UAVObjGetID(obj);
+    uint32_t length  = UAVObjGetNumBytes(obj);
+    uint32_t maskLength = UAVTALK_DELTA_MASK_LENGTH(length);
+
+    if (!connection->outStream) {
+        connection->stats.txErrors++;
+        return -1;
+    }
+
+    // The frame shares the buffer with the pending batch
+    flushBatch(connection);
+
+    UAVTalkDeltaEntry *delta = findDeltaEntry(connection, objId, instId);
+    if (delta == NULL && length > 0 && UAVTALK_DELTA_HEADER_LENGTH + maskLength + length <= UAVTALK_MAX_DELTA_PAYLOAD_LENGTH) {
+        // Start tracking the instance, the key frame sent below fills the image
+        if (connection->deltaEntries == NULL) {
+            connection->deltaEntries = (UAVTalkDeltaEntry *)pios_malloc(UAVTALK_DELTA_MAX_OBJECTS * sizeof(UAVTalkDeltaEntry));
+        }
+        if (connection->deltaEntries != NULL && connection->deltaCount < UAVTALK_DELTA_MAX_OBJECTS) {
+            uint8_t *image = (uint8_t *)pios_malloc(length);
+            if (image != NULL) {
+                delta = &connection->deltaEntries[connection->deltaCount++];
+                delta->objId  = objId;
+                delta->instId = instId;
+                delta->epoch  = 0;
+                delta->seq    = UAVTALK_DELTA_KEYFRAME_DUE; // No base until the key frame is sent
+                delta->image  = image;
+            }
+        }
+    }
+    if (delta == NULL) {
+        return sendSingleObject(connection, UAVTALK_TYPE_OBJ, objId, instId, obj);
+    }
+    bool keyFrame = (delta->seq + 1 >= keyFramePeriod);
+
+    uint8_t *payload = &connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH];
+    uint8_t *chunks  = &payload[UAVTALK_DELTA_HEADER_LENGTH + maskLength];
+    if (UAVObjPack(obj, instId, chunks) == -1) {
+        connection->stats.txErrors++;
+        return -1;
+    }
+
+    // Keep the changed chunks only, all of them in a key frame, and update the image with them
+    uint32_t changedLength = 0;
+    memset(&payload[UAVTALK_DELTA_HEADER_LENGTH], 0, maskLength);
+    for (uint32_t n = 0, offset = 0; offset < length; ++n, offset += UAVTALK_DELTA_CHUNK_LENGTH) {
+        uint32_t chunkLength = (length - offset < UAVTALK_DELTA_CHUNK_LENGTH) ? length - offset : UAVTALK_DELTA_CHUNK_LENGTH;
+        if (keyFrame || memcmp(&chunks[offset], &delta->image[offset], chunkLength) != 0) {
+            memcpy(&delta->image[offset], &chunks[offset], chunkLength);
+            memmove(&chunks[changedLength], &chunks[offset], chunkLength);
+            payload[UAVTALK_DELTA_HEADER_LENGTH + n / 8] |= (1 << (n % 8));
+            changedLength += chunkLength;
+        }
+    }
+    if (keyFrame) {
+        delta->epoch++;
+        delta->seq = 0;
+    } else {
+        delta->seq++;
+    }
+    payload[0] = delta->epoch;
+    payload[1] = delta->seq;
+    int32_t payloadLength = UAVTALK_DELTA_HEADER_LENGTH + maskLength + changedLength;
+
+    connection->txBuffer[0] = UAVTALK_SYNC_VAL;
+    connection->txBuffer[1] = UAVTALK_TYPE_OBJ_DELTA;
+    connection->txBuffer[2] = (uint8_t)((UAVTALK_MIN_HEADER_LENGTH + payloadLength) & 0xFF);
+    connection->txBuffer[3] = (uint8_t)(((UAVTALK_MIN_HEADER_LENGTH + payloadLength) >> 8) & 0xFF);
+    connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
+    connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
+    connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
+    connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
+    connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
+    connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
+
+    // Calculate and store checksum
+    connection->txBuffer[UAVTALK_MIN_HEADER_LENGTH + payloadLength] = PIOS_CRC_updateCRC(0, connection->txBuffer, UAVTALK_MIN_HEADER_LENGTH + payloadLength);
+
+    // Send object
+    uint16_t tx_msg_len = UAVTALK_MIN_HEADER_LENGTH + payloadLength + UAVTALK_CHECKSUM_LENGTH;
+    int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+
+    // Update stats
+    if (rc == tx_msg_len) {
+        ++connection->stats.txObjects;
+        connection->stats.txObjectBytes += changedLength;
+        connection->stats.txBytes += tx_msg_len;
+        countObjectTx(connection, objId, tx_msg_len);
+    } else {
+        // The receiver will not get this base, start over with a key frame
+        delta->seq = UAVTALK_DELTA_KEYFRAME_DUE;
+        connection->stats.txErrors++;
+        connection->stats.txBytes += (rc > 0) ? rc : 0;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Find the delta encoding state of an object instance
+ * \return The entry or NULL if the instance is not tracked
+ */
+static UAVTalkDeltaEntry *findDeltaEntry(UAVTalkConnectionData *connection, uint32_t objId, uint16_t instId)
+{
+    for (uint8_t n = 0; n < connection->deltaCount; ++n) {
+        if (connection->deltaEntries[n].objId == objId && connection->deltaEntries[n].instId == instId) {
+            return &connection->deltaEntries[n];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Send key frames next for all the tracked instances of an object
+ */
+static void deltaRequestKeyFrame(UAVTalkConnectionData *connection, uint32_t objId)
+{
+    for (uint8_t n = 0; n < connection->deltaCount; ++n) {
+        if (connection->deltaEntries[n].objId == objId) {
+            connection->deltaEntries[n].seq = UAVTALK_DELTA_KEYFRAME_DUE;
+        }
+    }
+}
+
+/**
+ * Start of the frame being received, its header is stored in front of the payload
+ */
+static uint8_t *rxFrame(UAVTalkConnectionData *connection)
+{
+    return connection->rxBuffer - UAVTALK_MIN_HEADER_LENGTH - ((connection->iproc.type & UAVTALK_TIMESTAMPED) ? 2 : 0);
+}
+
+#ifdef DIAG_TELEMETRY
+/**
+ * Entry of an object in a per object traffic table, open addressing on the
+ * object ID which is a hash already. The last entry takes the objects that
+ * find no room, and the multi-object frames.
+ */
+static UAVTalkObjectStats *objectStatsEntry(UAVTalkObjectStats *table, uint32_t objId)
+{
+    if (objId != 0) {
+        uint8_t n = objId % (UAVTALK_OBJECT_STATS_SIZE - 1);
+        for (uint8_t probe = 0; probe < UAVTALK_OBJECT_STATS_SIZE - 1; probe++) {
+            if (table[n].objId == objId) {
+                return &table[n];
+            }
+            if (table[n].objId == 0) {
+                table[n].objId = objId;
+                return &table[n];
+            }
+            if (++n == UAVTALK_OBJECT_STATS_SIZE - 1) {
+                n = 0;
+            }
+        }
+    }
+    return &table[UAVTALK_OBJECT_STATS_SIZE - 1];
+}
+
+/**
+ * Count a packet sent, called with the lock held
+ */
+static void countObjectTx(UAVTalkConnectionData *connection, uint32_t objId, uint32_t bytes)
+{
+    UAVTalkObjectStats *entry = objectStatsEntry(connection->txObjectStats, objId);
+
+    entry->txBytes += bytes;
+    entry->txPackets++;
+}
+
+/**
+ * Count a packet received, called by the receiving task
+ */
+static void countObjectRx(UAVTalkConnectionData *connection, uint32_t objId, uint32_t bytes)
+{
+    UAVTalkObjectStats *entry = objectStatsEntry(connection->rxObjectStats, objId);
+
+    entry->rxBytes += bytes;
+    entry->rxPackets++;
+}
+#endif /* DIAG_TELEMETRY */
+
 /**
  * @}
  * @}
@@ -7,9 +7,9 @@ OsgEarth {
     sceneFile: qmlWidget.earthFile
     fieldOfView: 90
 
-    yaw: AttitudeState.Yaw
-    pitch: AttitudeState.Pitch
-    roll: AttitudeState.Roll
+    yaw: pfdData.yaw
+    pitch: pfdData.pitch
+    roll: pfdData.roll
 
     latitude: qmlWidget.actualPositionUsed ?
                   GPSPositionSensor.Latitude/10000000.0 : qmlWidget.latitude
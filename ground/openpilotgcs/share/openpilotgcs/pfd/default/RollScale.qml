@@ -23,7 +23,7 @@ Item {
 
         //rotate it around the center of horizon
         transform: Rotation {
-            angle: -AttitudeState.Roll
+            angle: -pfdData.roll
             origin.y : rollscale.height*2.4
             origin.x : rollscale.width/2
         }
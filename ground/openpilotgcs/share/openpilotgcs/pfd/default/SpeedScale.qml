@@ -3,8 +3,7 @@ import QtQuick 2.0
 Item {
     id: sceneItem
     property variant sceneSize
-    property real groundSpeed : qmlWidget.speedFactor * Math.sqrt(Math.pow(VelocityState.North,2)+
-                                                Math.pow(VelocityState.East,2))
+    property real groundSpeed : qmlWidget.speedFactor * pfdData.groundSpeed
 
     SvgElementImage {
         id: speed_window
@@ -0,0 +1,53 @@
+# Headless GCS telemetry core, not part of the GCS build.
+# Build it against a GCS build tree after the GCS, e.g.:
+#   mkdir build/gcsheadless && cd build/gcsheadless
+#   qmake GCS_BUILD_TREE=<root>/build/openpilotgcs_release <root>/ground/openpilotgcs/src/experimental/gcsheadless/gcsheadless.pro
+#   make && ../openpilotgcs_release/bin/gcsheadless --help
+
+TEMPLATE = app
+TARGET = gcsheadless
+
+QT += network serialport
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../../openpilotgcs.pri)
+
+DESTDIR = $$GCS_APP_PATH
+
+# the plugin classes are built in, the libraries only export a part of them
+DEFINES += UAVTALK_LIBRARY
+
+UAVTALK_DIR = $$GCS_SOURCE_TREE/src/plugins/uavtalk
+INCLUDEPATH += $$UAVTALK_DIR $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+
+include($$UAVTALK_DIR/uavtalk_dependencies.pri)
+
+HEADERS += \
+    $$UAVTALK_DIR/uavtalk.h \
+    $$UAVTALK_DIR/vehicleclock.h \
+    $$UAVTALK_DIR/telemetry.h \
+    $$UAVTALK_DIR/telemetrymonitor.h \
+    $$UAVTALK_DIR/objectcache.h \
+    headlesscore.h \
+    rpcserver.h
+
+SOURCES += \
+    $$UAVTALK_DIR/uavtalk.cpp \
+    $$UAVTALK_DIR/vehicleclock.cpp \
+    $$UAVTALK_DIR/telemetry.cpp \
+    $$UAVTALK_DIR/telemetrymonitor.cpp \
+    $$UAVTALK_DIR/objectcache.cpp \
+    $$UAVOBJECT_SYNTHETICS/uavobjectsinit.cpp \
+    headlesscore.cpp \
+    rpcserver.cpp \
+    main.cpp
+
+linux-* {
+    QMAKE_RPATHDIR = \'\$$ORIGIN\'/$$relative_path($$GCS_LIBRARY_PATH, $$DESTDIR)
+    QMAKE_RPATHDIR += \'\$$ORIGIN\'/$$relative_path($$GCS_PLUGIN_PATH/OpenPilot, $$DESTDIR)
+    QMAKE_RPATHDIR += \'\$$ORIGIN\'/$$relative_path($$GCS_QT_LIBRARY_PATH, $$DESTDIR)
+    include(../../rpath.pri)
+}
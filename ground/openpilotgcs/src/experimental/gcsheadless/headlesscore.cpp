@@ -0,0 +1,216 @@
+/**
+ ******************************************************************************
+ *
+ * @file       headlesscore.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Telemetry core of the headless GCS: objects, link and OPL logging
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "headlesscore.h"
+#include "uavtalk.h"
+#include "telemetrymonitor.h"
+#include "uavobjectsinit.h"
+
+#include <QSerialPort>
+#include <QTcpSocket>
+#include <QDebug>
+
+#include <string.h>
+
+// time given to a TCP connect before the link is given up
+#define TCP_CONNECT_TIMEOUT_MS 5000
+
+HeadlessCore::HeadlessCore(QObject *parent) : QObject(parent),
+    m_device(NULL), m_uavTalk(NULL), m_telemetry(NULL), m_monitor(NULL), m_connected(false), m_logTalk(NULL)
+{
+    UAVObjectsInitialize(&m_objManager);
+    connect(&m_objManager, SIGNAL(newInstance(UAVObject *)), this, SLOT(newInstance(UAVObject *)));
+}
+
+HeadlessCore::~HeadlessCore()
+{
+    stopLogging();
+    disconnectLink();
+}
+
+bool HeadlessCore::connectSerial(const QString &portName, int baudRate, QString *error)
+{
+    disconnectLink();
+
+    QSerialPort *port = new QSerialPort(portName);
+    port->setBaudRate(baudRate);
+    port->setDataBits(QSerialPort::Data8);
+    port->setParity(QSerialPort::NoParity);
+    port->setStopBits(QSerialPort::OneStop);
+    port->setFlowControl(QSerialPort::NoFlowControl);
+    if (!port->open(QIODevice::ReadWrite)) {
+        *error = port->errorString();
+        delete port;
+        return false;
+    }
+    connect(port, SIGNAL(error(QSerialPort::SerialPortError)), this, SLOT(linkError()));
+    startTelemetry(port);
+    return true;
+}
+
+bool HeadlessCore::connectTcp(const QString &host, quint16 port, QString *error)
+{
+    disconnectLink();
+
+    QTcpSocket *socket = new QTcpSocket();
+    socket->connectToHost(host, port);
+    if (!socket->waitForConnected(TCP_CONNECT_TIMEOUT_MS)) {
+        *error = socket->errorString();
+        delete socket;
+        return false;
+    }
+    connect(socket, SIGNAL(disconnected()), this, SLOT(linkError()));
+    startTelemetry(socket);
+    return true;
+}
+
+void HeadlessCore::startTelemetry(QIODevice *device)
+{
+    m_device    = device;
+    m_uavTalk   = new UAVTalk(m_device, &m_objManager);
+    connect(m_device, SIGNAL(readyRead()), m_uavTalk, SLOT(processInputStream()));
+    m_telemetry = new Telemetry(m_uavTalk, &m_objManager);
+    m_monitor   = new TelemetryMonitor(&m_objManager, m_telemetry);
+    connect(m_monitor, SIGNAL(connected()), this, SLOT(telemetryConnected()));
+    connect(m_monitor, SIGNAL(disconnected()), this, SLOT(telemetryDisconnected()));
+}
+
+void HeadlessCore::disconnectLink()
+{
+    if (!m_device) {
+        return;
+    }
+    m_monitor->disconnect(this);
+    delete m_monitor;
+    delete m_telemetry;
+    delete m_uavTalk;
+    // it may be in the middle of emitting the error which got us here
+    m_device->disconnect(this);
+    m_device->deleteLater();
+    m_monitor   = NULL;
+    m_telemetry = NULL;
+    m_uavTalk   = NULL;
+    m_device    = NULL;
+    telemetryDisconnected();
+}
+
+Telemetry::TelemetryStats HeadlessCore::telemetryStats() const
+{
+    Telemetry::TelemetryStats stats;
+
+    if (m_telemetry) {
+        stats = m_telemetry->getStats();
+    } else {
+        memset(&stats, 0, sizeof(stats));
+    }
+    return stats;
+}
+
+void HeadlessCore::telemetryConnected()
+{
+    if (!m_connected) {
+        m_connected = true;
+        emit connected();
+    }
+}
+
+void HeadlessCore::telemetryDisconnected()
+{
+    if (m_connected) {
+        m_connected = false;
+        emit disconnected();
+    }
+}
+
+void HeadlessCore::linkError()
+{
+    QSerialPort *port = qobject_cast<QSerialPort *>(m_device);
+
+    if (port && port->error() == QSerialPort::NoError) {
+        return;
+    }
+    qWarning() << "Telemetry link lost:" << m_device->errorString();
+    disconnectLink();
+}
+
+/**
+ * Same records as the logging plugin writes, the gadgets replay them
+ */
+bool HeadlessCore::startLogging(const QString &fileName, QString *error)
+{
+    stopLogging();
+
+    m_logFile.setFileName(fileName);
+    m_logFile.setCompressed(fileName.endsWith(".oplz"));
+    if (!m_logFile.open(QIODevice::WriteOnly)) {
+        *error = tr("Unable to open %1").arg(fileName);
+        return false;
+    }
+    m_logTalk     = new UAVTalk(&m_logFile, &m_objManager);
+    m_logTalk->setSendTimestamps(true);
+    m_logFileName = fileName;
+    foreach(const QList<UAVObject *> &instances, m_objManager.getObjects()) {
+        foreach(UAVObject * obj, instances) {
+            connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(logObject(UAVObject *)));
+        }
+    }
+    // the settings do not change by themselves, ask for them so the log has them
+    if (m_connected) {
+        foreach(const QList<UAVDataObject *> &instances, m_objManager.getDataObjects()) {
+            if (instances.first()->isSettingsObject()) {
+                instances.first()->requestUpdateAll();
+            }
+        }
+    }
+    return true;
+}
+
+void HeadlessCore::stopLogging()
+{
+    if (!m_logTalk) {
+        return;
+    }
+    foreach(const QList<UAVObject *> &instances, m_objManager.getObjects()) {
+        foreach(UAVObject * obj, instances) {
+            disconnect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(logObject(UAVObject *)));
+        }
+    }
+    delete m_logTalk;
+    m_logTalk = NULL;
+    m_logFile.close();
+    m_logFileName.clear();
+}
+
+void HeadlessCore::logObject(UAVObject *obj)
+{
+    if (m_logTalk && !m_logTalk->sendObject(obj, false, false)) {
+        qWarning() << "Error logging" << obj->getName();
+    }
+}
+
+void HeadlessCore::newInstance(UAVObject *obj)
+{
+    if (m_logTalk) {
+        connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(logObject(UAVObject *)));
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ ******************************************************************************
+ *
+ * @file       headlesscore.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Telemetry core of the headless GCS: objects, link and OPL logging
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef HEADLESSCORE_H
+#define HEADLESSCORE_H
+
+#include "uavobjectmanager.h"
+#include "telemetry.h"
+#include <utils/logfile.h>
+
+#include <QObject>
+#include <QString>
+
+class QIODevice;
+class UAVTalk;
+class TelemetryMonitor;
+
+/**
+ * What the GCS does between the plugin manager and the gadgets, without
+ * them: the object manager, one telemetry link with its monitor and the
+ * logging of every object update to an OPL file.
+ * Everything lives in the thread of the application.
+ */
+class HeadlessCore : public QObject {
+    Q_OBJECT
+
+public:
+    HeadlessCore(QObject *parent = 0);
+    ~HeadlessCore();
+
+    UAVObjectManager *objectManager()
+    {
+        return &m_objManager;
+    }
+
+    bool connectSerial(const QString &portName, int baudRate, QString *error);
+    bool connectTcp(const QString &host, quint16 port, QString *error);
+    void disconnectLink();
+    // the link is open, the telemetry may still be negotiating
+    bool hasLink() const
+    {
+        return m_device != NULL;
+    }
+    bool isConnected() const
+    {
+        return m_connected;
+    }
+    Telemetry::TelemetryStats telemetryStats() const;
+
+    bool startLogging(const QString &fileName, QString *error);
+    void stopLogging();
+    bool isLogging() const
+    {
+        return m_logTalk != NULL;
+    }
+    QString logFileName() const
+    {
+        return m_logFileName;
+    }
+
+signals:
+    void connected();
+    void disconnected();
+
+private slots:
+    void telemetryConnected();
+    void telemetryDisconnected();
+    void linkError();
+    void logObject(UAVObject *obj);
+    void newInstance(UAVObject *obj);
+
+private:
+    UAVObjectManager m_objManager;
+    QIODevice *m_device;
+    UAVTalk *m_uavTalk;
+    Telemetry *m_telemetry;
+    TelemetryMonitor *m_monitor;
+    bool m_connected;
+
+    LogFile m_logFile;
+    UAVTalk *m_logTalk;
+    QString m_logFileName;
+
+    void startTelemetry(QIODevice *device);
+};
+
+#endif // HEADLESSCORE_H
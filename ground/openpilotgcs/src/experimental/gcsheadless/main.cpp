@@ -0,0 +1,108 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Headless GCS telemetry core, for servers, test rigs and scripts
+ *
+ * Only the objects, the telemetry and the logging of the GCS are built in,
+ * there is no plugin manager, no settings and no gadget to load, it is up
+ * and connected in the time it takes to open the link. It is controlled
+ * with JSON lines on its standard input or a local TCP port, see
+ * rpcserver.h.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "headlesscore.h"
+#include "rpcserver.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static bool verbose = false;
+
+// the standard output carries the replies, the messages go to the standard error
+static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context);
+    if (type == QtDebugMsg && !verbose) {
+        return;
+    }
+    fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+    if (type == QtFatalMsg) {
+        abort();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    qInstallMessageHandler(messageHandler);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless GCS telemetry, controlled with JSON lines on the standard input or a TCP port");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("serial", "Connect to the autopilot on a serial port.", "port"));
+    parser.addOption(QCommandLineOption("baud", "Baud rate of the serial port.", "rate", "57600"));
+    parser.addOption(QCommandLineOption("tcp", "Connect to the autopilot or a simulator over TCP.", "host:port"));
+    parser.addOption(QCommandLineOption("log", "Log all object updates to an OPL file, compressed if named .oplz.", "file"));
+    parser.addOption(QCommandLineOption("rpc-port", "Accept controllers on this TCP port of the loopback interface.", "port"));
+    parser.addOption(QCommandLineOption("no-stdin", "Do not read requests from the standard input, run until killed or told to quit."));
+    parser.addOption(QCommandLineOption("interval", "Least time between two update events of an object.", "ms", "100"));
+    parser.addOption(QCommandLineOption("verbose", "Print the debug messages of the telemetry."));
+    parser.process(app);
+
+    verbose = parser.isSet("verbose");
+
+    HeadlessCore core;
+    core.objectManager()->setCoalescedUpdateInterval(parser.value("interval").toInt());
+
+    RpcServer server(&core);
+    QObject::connect(&server, SIGNAL(quitRequested()), &app, SLOT(quit()));
+    QString error;
+    if (parser.isSet("rpc-port") && !server.listen(parser.value("rpc-port").toUShort(), &error)) {
+        qCritical("RPC port: %s", qPrintable(error));
+        return 1;
+    }
+    if (!parser.isSet("no-stdin")) {
+        server.attachStdio();
+    }
+
+    if (parser.isSet("log") && !core.startLogging(parser.value("log"), &error)) {
+        qCritical("Log: %s", qPrintable(error));
+        return 1;
+    }
+    if (parser.isSet("serial")) {
+        if (!core.connectSerial(parser.value("serial"), parser.value("baud").toInt(), &error)) {
+            qCritical("%s: %s", qPrintable(parser.value("serial")), qPrintable(error));
+            return 1;
+        }
+    } else if (parser.isSet("tcp")) {
+        QStringList address = parser.value("tcp").split(':');
+        if (address.size() != 2 || !core.connectTcp(address.at(0), address.at(1).toUShort(), &error)) {
+            qCritical("%s: %s", qPrintable(parser.value("tcp")), qPrintable(error.isEmpty() ? QString("expected host:port") : error));
+            return 1;
+        }
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,292 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rpcserver.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Line based JSON control of the headless GCS
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "rpcserver.h"
+#include "headlesscore.h"
+#include "uavdataobject.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QSocketNotifier>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QDebug>
+
+#include <stdio.h>
+#ifndef Q_OS_WIN
+#include <unistd.h>
+#endif
+
+// a line longer than that is not a request, it is dropped
+#define MAX_REQUEST_LENGTH (64 * 1024)
+
+RpcClient::RpcClient(HeadlessCore *core, QIODevice *out, QObject *parent) : QObject(parent),
+    m_core(core), m_out(out)
+{
+    connect(m_core, SIGNAL(connected()), this, SLOT(linkConnected()));
+    connect(m_core, SIGNAL(disconnected()), this, SLOT(linkDisconnected()));
+}
+
+void RpcClient::feed(const QByteArray &data)
+{
+    m_pending.append(data);
+
+    int end;
+    while ((end = m_pending.indexOf('\n')) >= 0) {
+        QByteArray line = m_pending.left(end).trimmed();
+        m_pending.remove(0, end + 1);
+        if (line.isEmpty()) {
+            continue;
+        }
+        QJsonParseError parseError;
+        QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (!document.isObject()) {
+            QJsonObject reply;
+            reply["error"] = document.isNull() ? parseError.errorString() : tr("request is not an object");
+            send(reply);
+            continue;
+        }
+        send(handleRequest(document.object()));
+    }
+    if (m_pending.size() > MAX_REQUEST_LENGTH) {
+        m_pending.clear();
+        QJsonObject reply;
+        reply["error"] = tr("request too long");
+        send(reply);
+    }
+}
+
+QJsonObject RpcClient::handleRequest(const QJsonObject &request)
+{
+    const QString cmd = request["cmd"].toString();
+    QJsonObject reply;
+    QString error;
+
+    if (request.contains("id")) {
+        reply["id"] = request["id"];
+    }
+
+    if (cmd == "status") {
+        Telemetry::TelemetryStats stats = m_core->telemetryStats();
+        reply["link"]      = m_core->hasLink();
+        reply["connected"] = m_core->isConnected();
+        reply["logging"]   = m_core->isLogging();
+        if (m_core->isLogging()) {
+            reply["logfile"] = m_core->logFileName();
+        }
+        reply["txBytes"]   = (double)stats.txBytes;
+        reply["txObjects"] = (double)stats.txObjects;
+        reply["txErrors"]  = (double)stats.txErrors;
+        reply["txRetries"] = (double)stats.txRetries;
+        reply["rxBytes"]   = (double)stats.rxBytes;
+        reply["rxObjects"] = (double)stats.rxObjects;
+        reply["rxErrors"]  = (double)stats.rxErrors;
+    } else if (cmd == "connect") {
+        if (request.contains("serial")) {
+            m_core->connectSerial(request["serial"].toString(), request["baud"].toInt(57600), &error);
+        } else {
+            m_core->connectTcp(request["host"].toString("127.0.0.1"), request["port"].toInt(9000), &error);
+        }
+    } else if (cmd == "disconnect") {
+        m_core->disconnectLink();
+    } else if (cmd == "list") {
+        QJsonArray names;
+        foreach(const QList<UAVDataObject *> &instances, m_core->objectManager()->getDataObjects()) {
+            names.append(instances.first()->getName());
+        }
+        reply["objects"] = names;
+    } else if (cmd == "get") {
+        UAVObject *obj = findObject(request, &error);
+        if (obj) {
+            QJsonObject object;
+            obj->toJson(object);
+            reply["object"] = object;
+        }
+    } else if (cmd == "set") {
+        // the object as "get" returns it, only the fields and elements given are changed
+        QJsonObject object = request["object"].toObject();
+        UAVObject *obj     = findObject(object, &error);
+        if (obj) {
+            object["instance"] = (int)obj->getInstID();
+            obj->fromJson(object);
+        }
+    } else if (cmd == "request") {
+        UAVObject *obj = findObject(request, &error);
+        if (obj) {
+            obj->requestUpdate();
+        }
+    } else if (cmd == "subscribe" || cmd == "unsubscribe") {
+        UAVObject *obj = findObject(request, &error);
+        if (obj) {
+            // once per client, a second subscribe would double the events
+            m_core->objectManager()->unsubscribeCoalesced(obj, this);
+            if (cmd == "subscribe") {
+                m_core->objectManager()->subscribeCoalesced(obj, this, SLOT(objectUpdated(UAVObject *)));
+            }
+        }
+    } else if (cmd == "log") {
+        m_core->startLogging(request["file"].toString(), &error);
+    } else if (cmd == "stoplog") {
+        m_core->stopLogging();
+    } else if (cmd == "quit") {
+        emit quitRequested();
+    } else {
+        error = tr("unknown command \"%1\"").arg(cmd);
+    }
+
+    if (!error.isEmpty()) {
+        reply["error"] = error;
+    }
+    return reply;
+}
+
+/**
+ * The instance named by the "name" (or "object") and "instance" members
+ */
+UAVObject *RpcClient::findObject(const QJsonObject &request, QString *error)
+{
+    QString name = request.contains("name") ? request["name"].toString() : request["object"].toString();
+    UAVObject *obj = m_core->objectManager()->getObject(name, request["instance"].toInt(0));
+
+    if (!obj) {
+        *error = tr("no object %1 instance %2").arg(name).arg(request["instance"].toInt(0));
+    }
+    return obj;
+}
+
+void RpcClient::objectUpdated(UAVObject *obj)
+{
+    QJsonObject event;
+    QJsonObject object;
+
+    obj->toJson(object);
+    event["event"]  = QString("update");
+    event["object"] = object;
+    send(event);
+}
+
+void RpcClient::linkConnected()
+{
+    QJsonObject event;
+
+    event["event"] = QString("connected");
+    send(event);
+}
+
+void RpcClient::linkDisconnected()
+{
+    QJsonObject event;
+
+    event["event"] = QString("disconnected");
+    send(event);
+}
+
+void RpcClient::send(const QJsonObject &message)
+{
+    if (!m_out->isOpen()) {
+        return;
+    }
+    m_out->write(QJsonDocument(message).toJson(QJsonDocument::Compact));
+    m_out->write("\n", 1);
+    QFile *file = qobject_cast<QFile *>(m_out);
+    if (file) {
+        file->flush();
+    }
+}
+
+RpcServer::RpcServer(HeadlessCore *core, QObject *parent) : QObject(parent),
+    m_core(core), m_server(NULL), m_stdinNotifier(NULL), m_stdout(NULL), m_stdioClient(NULL)
+{}
+
+/**
+ * Only local clients, there is no authentication
+ */
+bool RpcServer::listen(quint16 port, QString *error)
+{
+    m_server = new QTcpServer(this);
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        *error = m_server->errorString();
+        return false;
+    }
+    connect(m_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+    return true;
+}
+
+void RpcServer::newConnection()
+{
+    QTcpSocket *socket;
+
+    while ((socket = m_server->nextPendingConnection())) {
+        // the client goes with its socket
+        RpcClient *client = new RpcClient(m_core, socket, socket);
+        connect(client, SIGNAL(quitRequested()), this, SIGNAL(quitRequested()));
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readSocket()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+void RpcServer::readSocket()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    RpcClient *client  = socket ? socket->findChild<RpcClient *>() : NULL;
+
+    if (client) {
+        client->feed(socket->readAll());
+    }
+}
+
+/**
+ * The standard input is a client too, the process then runs as a coprocess
+ * of a script. It ends with the standard input.
+ */
+void RpcServer::attachStdio()
+{
+#ifdef Q_OS_WIN
+    // a console handle cannot be watched by the event loop
+    qWarning() << "Control on the standard input is not supported on Windows, use the TCP port";
+#else
+    QFile *out = new QFile(this);
+    out->open(stdout, QIODevice::WriteOnly);
+    m_stdout = out;
+    m_stdioClient   = new RpcClient(m_core, m_stdout, this);
+    connect(m_stdioClient, SIGNAL(quitRequested()), this, SIGNAL(quitRequested()));
+    m_stdinNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    connect(m_stdinNotifier, SIGNAL(activated(int)), this, SLOT(readStdin()));
+#endif
+}
+
+void RpcServer::readStdin()
+{
+#ifndef Q_OS_WIN
+    char buffer[4096];
+    ssize_t length = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+
+    if (length <= 0) {
+        m_stdinNotifier->setEnabled(false);
+        emit quitRequested();
+        return;
+    }
+    m_stdioClient->feed(QByteArray(buffer, length));
+#endif
+}
@@ -0,0 +1,102 @@
+/**
+ ******************************************************************************
+ *
+ * @file       rpcserver.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Line based JSON control of the headless GCS
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef RPCSERVER_H
+#define RPCSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QJsonObject>
+
+class QIODevice;
+class QTcpServer;
+class QSocketNotifier;
+class HeadlessCore;
+class UAVObject;
+
+/**
+ * One controller. Requests and replies are JSON objects, one per line.
+ * A request has a "cmd" and may have an "id", which the reply repeats.
+ * Updates of the subscribed objects and link changes are sent as events,
+ * objects with an "event" member, whenever they happen. The updates are
+ * coalesced by the object manager, a fast object is sent at most once per
+ * delivery interval.
+ */
+class RpcClient : public QObject {
+    Q_OBJECT
+
+public:
+    RpcClient(HeadlessCore *core, QIODevice *out, QObject *parent = 0);
+
+    void feed(const QByteArray &data);
+
+signals:
+    void quitRequested();
+
+public slots:
+    void objectUpdated(UAVObject *obj);
+
+private slots:
+    void linkConnected();
+    void linkDisconnected();
+
+private:
+    HeadlessCore *m_core;
+    QIODevice *m_out;
+    QByteArray m_pending;
+
+    QJsonObject handleRequest(const QJsonObject &request);
+    UAVObject *findObject(const QJsonObject &request, QString *error);
+    void send(const QJsonObject &message);
+};
+
+/**
+ * Serves the controllers, the standard input and output and the clients of a
+ * TCP port on the loopback interface
+ */
+class RpcServer : public QObject {
+    Q_OBJECT
+
+public:
+    RpcServer(HeadlessCore *core, QObject *parent = 0);
+
+    bool listen(quint16 port, QString *error);
+    void attachStdio();
+
+signals:
+    void quitRequested();
+
+private slots:
+    void newConnection();
+    void readSocket();
+    void readStdin();
+
+private:
+    HeadlessCore *m_core;
+    QTcpServer *m_server;
+    QSocketNotifier *m_stdinNotifier;
+    QIODevice *m_stdout;
+    RpcClient *m_stdioClient;
+};
+
+#endif // RPCSERVER_H
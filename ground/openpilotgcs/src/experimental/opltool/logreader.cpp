@@ -0,0 +1,279 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logreader.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Memory mapped OPL log, split at record boundaries and merged by time
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logreader.h"
+
+#include <QtEndian>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <string.h>
+
+#include <utils/crc.h>
+
+// Log record: timestamp(4), data size(8), data
+#define RECORD_HEADER_LENGTH    12
+#define MAX_RECORD_LENGTH       (64 * 1024)
+// UAVTalk header: sync(1), type (1), size(2), object ID(4), instance ID(2)
+#define UAVTALK_SYNC_VAL        0x3C
+#define UAVTALK_TYPE_MASK       0x78
+#define UAVTALK_TYPE_VER        0x20
+#define UAVTALK_HEADER_LENGTH   10
+#define UAVTALK_CHECKSUM_LENGTH 1
+// Valid records that must follow a sync point, a single one matches random data too easily
+#define SYNC_CHAIN_LENGTH       4
+
+LogReader::LogReader() :
+    m_data(NULL),
+    m_size(0),
+    m_compressed(false)
+{}
+
+LogReader::~LogReader()
+{
+    if (m_data != NULL && m_file.isOpen()) {
+        m_file.unmap((uchar *)m_data);
+    }
+}
+
+bool LogReader::open(const QString &fileName, QString *error)
+{
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        *error = m_file.errorString();
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size == 0) {
+        return true;
+    }
+    m_data = m_file.map(0, m_size);
+    if (m_data == NULL) {
+        *error = m_file.errorString();
+        return false;
+    }
+    m_compressed = CompressedLog::readBlocks(m_data, m_size, m_blocks);
+    return true;
+}
+
+void LogReader::setData(const QByteArray &data)
+{
+    m_buffer = data;
+    m_data   = (const uchar *)m_buffer.constData();
+    m_size   = m_buffer.size();
+}
+
+QByteArray LogReader::block(int index) const
+{
+    return CompressedLog::decompress(m_data, m_blocks.at(index));
+}
+
+qint64 LogReader::readRecord(qint64 offset, LogRecord *record) const
+{
+    if (offset + RECORD_HEADER_LENGTH > m_size) {
+        return -1;
+    }
+    const uchar *header = m_data + offset;
+    qint64 dataSize     = qFromLittleEndian<qint64>(header + sizeof(quint32));
+    if (dataSize < 1 || dataSize > MAX_RECORD_LENGTH || offset + RECORD_HEADER_LENGTH + dataSize > m_size) {
+        return -1;
+    }
+    record->timeStamp = qFromLittleEndian<quint32>(header);
+    record->packet    = header + RECORD_HEADER_LENGTH;
+    record->length    = dataSize;
+    return offset + RECORD_HEADER_LENGTH + dataSize;
+}
+
+/**
+ * A record with a sane header holding one complete UAVTalk packet with a good CRC.
+ */
+bool LogReader::isValidRecord(qint64 offset, qint64 *next) const
+{
+    LogRecord record;
+
+    *next = readRecord(offset, &record);
+    if (*next < 0 || record.length < UAVTALK_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
+        || record.packet[0] != UAVTALK_SYNC_VAL || (record.packet[1] & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER) {
+        return false;
+    }
+    quint16 length = qFromLittleEndian<quint16>(record.packet + 2);
+    return length >= UAVTALK_HEADER_LENGTH && length + UAVTALK_CHECKSUM_LENGTH <= record.length
+           && Utils::Crc::updateCRC(0, record.packet, length) == record.packet[length];
+}
+
+qint64 LogReader::syncPoint(qint64 offset) const
+{
+    while (offset + RECORD_HEADER_LENGTH < m_size) {
+        // The sync byte of the packet is the cheap test, it is looked for with memchr
+        const uchar *sync = (const uchar *)memchr(m_data + offset + RECORD_HEADER_LENGTH, UAVTALK_SYNC_VAL,
+                                                  m_size - offset - RECORD_HEADER_LENGTH);
+        if (sync == NULL) {
+            break;
+        }
+        offset = sync - m_data - RECORD_HEADER_LENGTH;
+
+        qint64 next = offset;
+        int chain   = 0;
+        while (chain < SYNC_CHAIN_LENGTH && next < m_size && isValidRecord(next, &next)) {
+            ++chain;
+        }
+        if (chain == SYNC_CHAIN_LENGTH || (chain > 0 && next == m_size)) {
+            return offset;
+        }
+        ++offset;
+    }
+    return m_size;
+}
+
+namespace {
+struct SyncJob {
+    const LogReader *reader;
+    qint64 offset;
+};
+
+void syncJob(SyncJob &job)
+{
+    job.offset = job.reader->syncPoint(job.offset);
+}
+}
+
+QVector<qint64> LogReader::split(qint64 chunkSize) const
+{
+    QVector<SyncJob> jobs;
+
+    for (qint64 offset = chunkSize; offset < m_size; offset += chunkSize) {
+        SyncJob job;
+        job.reader = this;
+        job.offset = offset;
+        jobs.append(job);
+    }
+    QtConcurrent::blockingMap(jobs, syncJob);
+
+    // A long corrupted area can make several boundaries meet on the same record
+    QVector<qint64> boundaries;
+    boundaries.append(0);
+    foreach(const SyncJob &job, jobs) {
+        if (job.offset > boundaries.last()) {
+            boundaries.append(job.offset);
+        }
+    }
+    if (boundaries.last() != m_size) {
+        boundaries.append(m_size);
+    }
+    return boundaries;
+}
+
+qint64 LogReader::readSegment(qint64 begin, qint64 end, QVector<LogRecord> &records) const
+{
+    qint64 corrupted = 0;
+    qint64 offset    = begin;
+
+    while (offset < end) {
+        LogRecord record;
+        qint64 next = readRecord(offset, &record);
+        if (next < 0) {
+            next       = qMin(syncPoint(offset + 1), end);
+            corrupted += next - offset;
+        } else {
+            records.append(record);
+        }
+        offset = next;
+    }
+    return corrupted;
+}
+
+LogMerger::LogMerger(const QList<LogReader *> &readers) :
+    m_corruptedBytes(0)
+{
+    for (int i = 0; i < readers.size(); ++i) {
+        Cursor cursor;
+        cursor.reader = readers.at(i);
+        cursor.index  = i;
+        cursor.block  = -1;
+        cursor.offset = 0;
+        if (advance(cursor, NULL)) {
+            m_heap.append(cursor);
+        }
+    }
+    std::make_heap(m_heap.begin(), m_heap.end(), later);
+}
+
+bool LogMerger::later(const Cursor &a, const Cursor &b)
+{
+    if (a.record.timeStamp != b.record.timeStamp) {
+        return a.record.timeStamp > b.record.timeStamp;
+    }
+    return a.index > b.index;
+}
+
+/**
+ * Moves the cursor to its next record, skipping corrupted bytes. A
+ * compressed log moves on to its next block at the end of a block.
+ */
+bool LogMerger::advance(Cursor &cursor, QList<QByteArray> *buffers)
+{
+    while (true) {
+        const LogReader *reader = cursor.reader->isCompressed() ? cursor.blockReader.data() : cursor.reader;
+        while (reader != NULL && cursor.offset < reader->size()) {
+            qint64 next = reader->readRecord(cursor.offset, &cursor.record);
+            if (next >= 0) {
+                cursor.offset = next;
+                return true;
+            }
+            next = reader->syncPoint(cursor.offset + 1);
+            m_corruptedBytes += next - cursor.offset;
+            cursor.offset     = next;
+        }
+
+        if (!cursor.reader->isCompressed() || cursor.block + 1 >= cursor.reader->blockCount()) {
+            return false;
+        }
+        ++cursor.block;
+        cursor.blockReader = QSharedPointer<LogReader>(new LogReader);
+        cursor.blockReader->setData(cursor.reader->block(cursor.block));
+        cursor.offset = 0;
+        if (buffers != NULL) {
+            buffers->append(cursor.blockReader->data());
+        }
+    }
+}
+
+bool LogMerger::next(int count, QVector<LogRecord> &records, QList<QByteArray> &buffers)
+{
+    foreach(const Cursor &cursor, m_heap) {
+        if (cursor.blockReader) {
+            buffers.append(cursor.blockReader->data());
+        }
+    }
+
+    while (count-- > 0 && !m_heap.isEmpty()) {
+        std::pop_heap(m_heap.begin(), m_heap.end(), later);
+        Cursor &cursor = m_heap.last();
+        records.append(cursor.record);
+        if (advance(cursor, &buffers)) {
+            std::push_heap(m_heap.begin(), m_heap.end(), later);
+        } else {
+            m_heap.removeLast();
+        }
+    }
+    return !m_heap.isEmpty();
+}
@@ -0,0 +1,146 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logreader.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Memory mapped OPL log, split at record boundaries and merged by time
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGREADER_H
+#define LOGREADER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include <utils/compressedlog.h>
+
+/**
+ * One record of an OPL log. The packet points into the mapped file.
+ */
+struct LogRecord {
+    quint32 timeStamp;
+    const uchar *packet;
+    quint32 length;
+};
+
+/**
+ * An OPL log, memory mapped for the lifetime of the reader. Nothing is
+ * copied, the pages are read by the system as the records are walked.
+ *
+ * The records of a compressed log are read block by block: block()
+ * decompresses one, setData() makes a reader of it.
+ */
+class LogReader {
+public:
+    LogReader();
+    ~LogReader();
+
+    bool open(const QString &fileName, QString *error);
+    void setData(const QByteArray &data);
+
+    QString fileName() const
+    {
+        return m_file.fileName();
+    }
+    qint64 size() const
+    {
+        return m_size;
+    }
+    const QByteArray &data() const
+    {
+        return m_buffer;
+    }
+
+    bool isCompressed() const
+    {
+        return m_compressed;
+    }
+    int blockCount() const
+    {
+        return m_blocks.size();
+    }
+    // Decompresses a block, thread safe
+    QByteArray block(int index) const;
+
+    // Reads the record at offset. Returns the offset of the next record,
+    // or -1 if the record header is not sane, the log is corrupted there.
+    qint64 readRecord(qint64 offset, LogRecord *record) const;
+
+    // Offset of the first record at or after offset that starts a chain of
+    // valid records, the size of the log if there is none.
+    qint64 syncPoint(qint64 offset) const;
+
+    // Cuts the log into segments of about chunkSize bytes. The boundaries
+    // are resynchronised on records in parallel, segment i is
+    // [boundaries[i], boundaries[i + 1]).
+    QVector<qint64> split(qint64 chunkSize) const;
+
+    // Appends the records of [begin, end) to records, resynchronising
+    // after corrupted bytes. Returns the number of corrupted bytes skipped.
+    qint64 readSegment(qint64 begin, qint64 end, QVector<LogRecord> &records) const;
+
+private:
+    QFile m_file;
+    QByteArray m_buffer;
+    const uchar *m_data;
+    qint64 m_size;
+    bool m_compressed;
+    QVector<CompressedLog::Block> m_blocks;
+
+    bool isValidRecord(qint64 offset, qint64 *next) const;
+};
+
+/**
+ * K-way merge of several logs by time stamp. Records with the same time
+ * stamp keep the order of the logs on the command line.
+ */
+class LogMerger {
+public:
+    LogMerger(const QList<LogReader *> &readers);
+
+    // Appends up to count records in time order, returns false at the end.
+    // The blocks of compressed logs the records point to are appended to buffers.
+    bool next(int count, QVector<LogRecord> &records, QList<QByteArray> &buffers);
+
+    qint64 corruptedBytes() const
+    {
+        return m_corruptedBytes;
+    }
+
+private:
+    struct Cursor {
+        const LogReader *reader;
+        int index;
+        // current block of a compressed log
+        int block;
+        QSharedPointer<LogReader> blockReader;
+        qint64 offset;
+        LogRecord record;
+    };
+
+    QVector<Cursor> m_heap;
+    qint64 m_corruptedBytes;
+
+    bool advance(Cursor &cursor, QList<QByteArray> *buffers);
+    static bool later(const Cursor &a, const Cursor &b);
+};
+
+#endif // LOGREADER_H
@@ -0,0 +1,441 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logwriter.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Output formats of the OPL tool: OPL, CSV and JSON lines
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logwriter.h"
+
+#include <QDir>
+#include <QtEndian>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <utils/crc.h>
+#include "uavobjectmanager.h"
+#include "uavobjectfield.h"
+
+// Log record: timestamp(4), data size(8), data
+#define RECORD_HEADER_LENGTH    12
+// UAVTalk header: sync(1), type (1), size(2), object ID(4), instance ID(2)
+#define UAVTALK_SYNC_VAL        0x3C
+#define UAVTALK_TYPE_OBJ        0x20
+#define UAVTALK_TYPE_OBJ_ACK    0x22
+#define UAVTALK_TIMESTAMPED     0x80
+#define UAVTALK_HEADER_LENGTH   10
+// Board time stamp of the timestamped object packets, after the header
+#define UAVTALK_TIMESTAMP_LENGTH 2
+#define UAVTALK_CHECKSUM_LENGTH 1
+
+LogWriter::LogWriter(UAVObjectManager *objManager)
+{
+    foreach(const QList<UAVObject *> &instances, objManager->getObjects()) {
+        UAVObject *obj = instances.first();
+        ObjectLayout object;
+
+        object.index    = m_layouts.size();
+        object.name     = obj->getName();
+        object.numBytes = obj->getNumBytes();
+        foreach(UAVObjectField * field, obj->getFields()) {
+            if (!field->isNumeric() && field->getType() != UAVObjectField::ENUM) {
+                continue;
+            }
+            FieldLayout fieldLayout;
+            fieldLayout.name = field->getName();
+            QStringList elementNames = field->getElementNames();
+            quint32 elementBytes     = field->getNumBytes() / field->getNumElements();
+            for (quint32 n = 0; n < field->getNumElements(); ++n) {
+                ElementLayout element;
+                element.name   = field->getNumElements() > 1 ? field->getName() + "." + elementNames.at(n) : field->getName();
+                element.offset = field->getDataOffset() + n * elementBytes;
+                element.type   = field->getType();
+                if (element.type == UAVObjectField::ENUM) {
+                    element.options = field->getOptions();
+                }
+                fieldLayout.elements.append(element);
+            }
+            object.fields.append(fieldLayout);
+        }
+        m_layouts.insert(obj->getObjID(), object);
+    }
+
+    // the hash doesn't change anymore, its elements don't move
+    m_objects.resize(m_layouts.size());
+    for (QHash<quint32, ObjectLayout>::const_iterator it = m_layouts.constBegin(); it != m_layouts.constEnd(); ++it) {
+        m_objects[it.value().index] = &it.value();
+    }
+}
+
+LogWriter::~LogWriter()
+{}
+
+QStringList LogWriter::formats()
+{
+    return QStringList() << "opl" << "csv" << "json";
+}
+
+LogWriter *LogWriter::create(const QString &format, UAVObjectManager *objManager)
+{
+    if (format == "opl") {
+        return new OplWriter(objManager);
+    } else if (format == "csv") {
+        return new CsvWriter(objManager);
+    } else if (format == "json") {
+        return new JsonWriter(objManager);
+    }
+    return NULL;
+}
+
+bool LogWriter::setObjectFilter(const QStringList &names, QString *error)
+{
+    m_filter.clear();
+    foreach(const QString &name, names) {
+        bool found = false;
+        for (QHash<quint32, ObjectLayout>::const_iterator it = m_layouts.constBegin(); it != m_layouts.constEnd(); ++it) {
+            if (it.value().name == name) {
+                m_filter.insert(it.key());
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            *error = QString("unknown object %1").arg(name);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LogWriter::isFiltered(const LogRecord &record) const
+{
+    if (m_filter.isEmpty()) {
+        return false;
+    }
+    return record.length < UAVTALK_HEADER_LENGTH || !m_filter.contains(qFromLittleEndian<quint32>(record.packet + 4));
+}
+
+const LogWriter::ObjectLayout *LogWriter::layout(const LogRecord &record, const uchar **data) const
+{
+    const uchar *packet = record.packet;
+
+    if (record.length < UAVTALK_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH || packet[0] != UAVTALK_SYNC_VAL) {
+        return NULL;
+    }
+    const quint8 type      = packet[1] & ~UAVTALK_TIMESTAMPED;
+    const int headerLength = UAVTALK_HEADER_LENGTH + ((packet[1] & UAVTALK_TIMESTAMPED) ? UAVTALK_TIMESTAMP_LENGTH : 0);
+    if (type != UAVTALK_TYPE_OBJ && type != UAVTALK_TYPE_OBJ_ACK) {
+        return NULL;
+    }
+    quint16 length = qFromLittleEndian<quint16>(packet + 2);
+    if (length + UAVTALK_CHECKSUM_LENGTH > record.length || Utils::Crc::updateCRC(0, packet, length) != packet[length]) {
+        return NULL;
+    }
+    QHash<quint32, ObjectLayout>::const_iterator it = m_layouts.constFind(qFromLittleEndian<quint32>(packet + 4));
+    if (length < headerLength || it == m_layouts.constEnd() || it.value().numBytes != (quint32)length - headerLength) {
+        return NULL;
+    }
+    *data = packet + headerLength;
+    return &it.value();
+}
+
+double LogWriter::value(const uchar *data, int type)
+{
+    switch (type) {
+    case UAVObjectField::INT8:
+        return (qint8)data[0];
+
+    case UAVObjectField::INT16:
+        return qFromLittleEndian<qint16>(data);
+
+    case UAVObjectField::INT32:
+        return qFromLittleEndian<qint32>(data);
+
+    case UAVObjectField::UINT16:
+        return qFromLittleEndian<quint16>(data);
+
+    case UAVObjectField::UINT32:
+        return qFromLittleEndian<quint32>(data);
+
+    case UAVObjectField::FLOAT32:
+    {
+        quint32 raw = qFromLittleEndian<quint32>(data);
+        float f;
+        memcpy(&f, &raw, sizeof(f));
+        return f;
+    }
+    default:
+        // UINT8, ENUM and BITFIELD
+        return data[0];
+    }
+}
+
+static void appendNumber(QByteArray &out, double value, int type)
+{
+    if (type == UAVObjectField::FLOAT32) {
+        out.append(QByteArray::number(value, 'g', 9));
+    } else {
+        out.append(QByteArray::number((qlonglong)value));
+    }
+}
+
+// "-" is the standard output
+static bool openOutput(QFile &file, const QString &path, QString *error)
+{
+    bool opened;
+
+    if (path == "-") {
+        opened = file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(path);
+        opened = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!opened) {
+        *error = file.errorString();
+    }
+    return opened;
+}
+
+static bool writeOutput(QFile &file, const QByteArray &data, QString *error)
+{
+    if (file.write(data) != data.size()) {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+OplWriter::OplWriter(UAVObjectManager *objManager) :
+    LogWriter(objManager)
+{}
+
+bool OplWriter::open(const QString &path, QString *error)
+{
+    return openOutput(m_file, path, error);
+}
+
+void OplWriter::format(const QVector<LogRecord> &records, LogChunk &chunk) const
+{
+    QByteArray &out = chunk.streams[0];
+
+    foreach(const LogRecord &record, records) {
+        if (isFiltered(record)) {
+            ++chunk.skipped;
+            continue;
+        }
+        quint32 timeStamp = qToLittleEndian<quint32>(record.timeStamp);
+        qint64 dataSize   = qToLittleEndian<qint64>((qint64)record.length);
+        out.append((const char *)&timeStamp, sizeof(timeStamp));
+        out.append((const char *)&dataSize, sizeof(dataSize));
+        out.append((const char *)record.packet, record.length);
+        ++chunk.records;
+    }
+}
+
+bool OplWriter::write(const LogChunk &chunk, QString *error)
+{
+    return writeOutput(m_file, chunk.streams.value(0), error);
+}
+
+bool OplWriter::close(QString *error)
+{
+    bool ok = m_file.flush();
+
+    if (!ok) {
+        *error = m_file.errorString();
+    }
+    m_file.close();
+    return ok;
+}
+
+CsvWriter::CsvWriter(UAVObjectManager *objManager) :
+    LogWriter(objManager)
+{}
+
+CsvWriter::~CsvWriter()
+{
+    qDeleteAll(m_files);
+}
+
+bool CsvWriter::open(const QString &path, QString *error)
+{
+    if (!QDir().mkpath(path)) {
+        *error = QString("unable to create the directory %1").arg(path);
+        return false;
+    }
+    m_directory = path;
+    m_files.fill(NULL, m_objects.size());
+    return true;
+}
+
+void CsvWriter::format(const QVector<LogRecord> &records, LogChunk &chunk) const
+{
+    foreach(const LogRecord &record, records) {
+        const uchar *data;
+        const ObjectLayout *object = layout(record, &data);
+
+        if (object == NULL || isFiltered(record)) {
+            ++chunk.skipped;
+            continue;
+        }
+        QByteArray &out = chunk.streams[object->index];
+        out.append(QByteArray::number(record.timeStamp));
+        out.append(',');
+        out.append(QByteArray::number(qFromLittleEndian<quint16>(record.packet + 8)));
+        foreach(const FieldLayout &field, object->fields) {
+            foreach(const ElementLayout &element, field.elements) {
+                out.append(',');
+                appendNumber(out, value(data + element.offset, element.type), element.type);
+            }
+        }
+        out.append('\n');
+        ++chunk.records;
+    }
+}
+
+bool CsvWriter::write(const LogChunk &chunk, QString *error)
+{
+    for (QHash<int, QByteArray>::const_iterator it = chunk.streams.constBegin(); it != chunk.streams.constEnd(); ++it) {
+        QFile *&file = m_files[it.key()];
+        if (file == NULL) {
+            const ObjectLayout *object = m_objects.at(it.key());
+            file = new QFile(QDir(m_directory).filePath(object->name + ".csv"));
+            if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                *error = QString("%1: %2").arg(file->fileName(), file->errorString());
+                return false;
+            }
+            QByteArray header("time_ms,instance");
+            foreach(const FieldLayout &field, object->fields) {
+                foreach(const ElementLayout &element, field.elements) {
+                    header.append(',');
+                    header.append(element.name.toUtf8());
+                }
+            }
+            header.append('\n');
+            if (!writeOutput(*file, header, error)) {
+                return false;
+            }
+        }
+        if (!writeOutput(*file, it.value(), error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CsvWriter::close(QString *error)
+{
+    bool ok = true;
+
+    foreach(QFile * file, m_files) {
+        if (file != NULL && !file->flush()) {
+            *error = QString("%1: %2").arg(file->fileName(), file->errorString());
+            ok     = false;
+        }
+    }
+    qDeleteAll(m_files);
+    m_files.fill(NULL);
+    return ok;
+}
+
+JsonWriter::JsonWriter(UAVObjectManager *objManager) :
+    LogWriter(objManager)
+{}
+
+bool JsonWriter::open(const QString &path, QString *error)
+{
+    return openOutput(m_file, path, error);
+}
+
+void JsonWriter::format(const QVector<LogRecord> &records, LogChunk &chunk) const
+{
+    QByteArray &out = chunk.streams[0];
+
+    foreach(const LogRecord &record, records) {
+        const uchar *data;
+        const ObjectLayout *object = layout(record, &data);
+
+        if (object == NULL || isFiltered(record)) {
+            ++chunk.skipped;
+            continue;
+        }
+        out.append("{\"time\":");
+        out.append(QByteArray::number(record.timeStamp));
+        out.append(",\"object\":\"");
+        out.append(object->name.toUtf8());
+        out.append("\",\"instance\":");
+        out.append(QByteArray::number(qFromLittleEndian<quint16>(record.packet + 8)));
+        if (record.packet[1] & UAVTALK_TIMESTAMPED) {
+            // board time in ms, low 16 bits
+            out.append(",\"boardTime\":");
+            out.append(QByteArray::number(qFromLittleEndian<quint16>(record.packet + UAVTALK_HEADER_LENGTH)));
+        }
+        out.append(",\"data\":{");
+        for (int f = 0; f < object->fields.size(); ++f) {
+            const FieldLayout &field = object->fields.at(f);
+            if (f > 0) {
+                out.append(',');
+            }
+            out.append('"');
+            out.append(field.name.toUtf8());
+            out.append("\":");
+            if (field.elements.size() > 1) {
+                out.append('[');
+            }
+            for (int e = 0; e < field.elements.size(); ++e) {
+                const ElementLayout &element = field.elements.at(e);
+                double sample = value(data + element.offset, element.type);
+                if (e > 0) {
+                    out.append(',');
+                }
+                if (element.type == UAVObjectField::ENUM) {
+                    out.append('"');
+                    out.append((int)sample < element.options.size() ? element.options.at((int)sample).toUtf8() : QByteArray::number((int)sample));
+                    out.append('"');
+                } else if (isnan(sample) || isinf(sample)) {
+                    out.append("null");
+                } else {
+                    appendNumber(out, sample, element.type);
+                }
+            }
+            if (field.elements.size() > 1) {
+                out.append(']');
+            }
+        }
+        out.append("}}\n");
+        ++chunk.records;
+    }
+}
+
+bool JsonWriter::write(const LogChunk &chunk, QString *error)
+{
+    return writeOutput(m_file, chunk.streams.value(0), error);
+}
+
+bool JsonWriter::close(QString *error)
+{
+    bool ok = m_file.flush();
+
+    if (!ok) {
+        *error = m_file.errorString();
+    }
+    m_file.close();
+    return ok;
+}
@@ -0,0 +1,156 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logwriter.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Output formats of the OPL tool: OPL, CSV and JSON lines
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include "logreader.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class UAVObjectManager;
+
+/**
+ * A formatted batch of records. Every output stream of the format gets its
+ * own buffer, stream 0 for the formats writing a single file.
+ */
+struct LogChunk {
+    QHash<int, QByteArray> streams;
+    quint32 records;
+    quint32 skipped;
+
+    LogChunk() : records(0), skipped(0) {}
+};
+
+/**
+ * Base of the output formats. The object layouts are taken from the object
+ * manager once, format() only reads them and is called from the worker
+ * threads, write() is called with the chunks in log order from the main
+ * thread.
+ */
+class LogWriter {
+public:
+    virtual ~LogWriter();
+
+    static LogWriter *create(const QString &format, UAVObjectManager *objManager);
+    static QStringList formats();
+
+    // Limits the output to these objects, all of them if empty
+    bool setObjectFilter(const QStringList &names, QString *error);
+
+    virtual bool open(const QString &path, QString *error) = 0;
+    virtual void format(const QVector<LogRecord> &records, LogChunk &chunk) const = 0;
+    virtual bool write(const LogChunk &chunk, QString *error) = 0;
+    virtual bool close(QString *error) = 0;
+
+protected:
+    struct ElementLayout {
+        QString name;
+        quint32 offset;
+        int type;
+        QStringList options;
+    };
+
+    struct FieldLayout {
+        QString name;
+        QVector<ElementLayout> elements;
+    };
+
+    struct ObjectLayout {
+        int index;
+        QString name;
+        quint32 numBytes;
+        QVector<FieldLayout> fields;
+    };
+
+    LogWriter(UAVObjectManager *objManager);
+
+    // Layout of the object of a valid data packet, NULL for anything else.
+    // The element offsets are relative to data, the payload of the packet.
+    const ObjectLayout *layout(const LogRecord &record, const uchar **data) const;
+    bool isFiltered(const LogRecord &record) const;
+    static double value(const uchar *data, int type);
+
+    QHash<quint32, ObjectLayout> m_layouts;
+    QVector<const ObjectLayout *> m_objects;
+    QSet<quint32> m_filter;
+};
+
+/**
+ * Clean OPL log: the records are copied as is, corrupted bytes dropped.
+ */
+class OplWriter : public LogWriter {
+public:
+    OplWriter(UAVObjectManager *objManager);
+
+    bool open(const QString &path, QString *error);
+    void format(const QVector<LogRecord> &records, LogChunk &chunk) const;
+    bool write(const LogChunk &chunk, QString *error);
+    bool close(QString *error);
+
+private:
+    QFile m_file;
+};
+
+/**
+ * One CSV file per object in the output directory, a row per update with
+ * the time, the instance and a column per field element.
+ */
+class CsvWriter : public LogWriter {
+public:
+    CsvWriter(UAVObjectManager *objManager);
+    ~CsvWriter();
+
+    bool open(const QString &path, QString *error);
+    void format(const QVector<LogRecord> &records, LogChunk &chunk) const;
+    bool write(const LogChunk &chunk, QString *error);
+    bool close(QString *error);
+
+private:
+    QString m_directory;
+    QVector<QFile *> m_files;
+};
+
+/**
+ * A JSON object per update and per line, enum fields as their option name.
+ */
+class JsonWriter : public LogWriter {
+public:
+    JsonWriter(UAVObjectManager *objManager);
+
+    bool open(const QString &path, QString *error);
+    void format(const QVector<LogRecord> &records, LogChunk &chunk) const;
+    bool write(const LogChunk &chunk, QString *error);
+    bool close(QString *error);
+
+private:
+    QFile m_file;
+};
+
+#endif // LOGWRITER_H
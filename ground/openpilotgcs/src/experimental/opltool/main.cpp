@@ -0,0 +1,273 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Command line converter and merger of OPL logs
+ *
+ * A single log is cut in one segment per few MB, resynchronised on record
+ * boundaries, and the segments are decoded and formatted by all cores. The
+ * segments of a compressed log are its blocks, decompressed by the workers.
+ * Several logs are merged by time stamp (on board and GCS logs of the same
+ * flight for instance), the merge runs in the main thread while the
+ * previous batch of records is formatted by the workers. The output is
+ * written in log order as the batches complete, neither the logs nor the
+ * output are held in memory.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logreader.h"
+#include "logwriter.h"
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <stdio.h>
+
+// Size of the segments of a single log
+#define SEGMENT_SIZE       (4 * 1024 * 1024)
+// Records per batch of a merge
+#define MERGE_BATCH_LENGTH 32768
+
+namespace {
+struct FormatJob {
+    const LogWriter *writer;
+    const LogReader *reader;
+    qint64 begin;
+    qint64 end;
+    // block of a compressed log, -1 for a segment of a plain log
+    int block;
+    QVector<LogRecord> records;
+    // keeps the decompressed blocks the records point to
+    QList<QByteArray> buffers;
+    LogChunk chunk;
+    qint64 corrupted;
+};
+
+void formatJob(FormatJob &job)
+{
+    LogReader blockReader;
+
+    if (job.block >= 0) {
+        blockReader.setData(job.reader->block(job.block));
+        job.corrupted = blockReader.readSegment(0, blockReader.size(), job.records);
+    } else if (job.reader != NULL) {
+        job.corrupted = job.reader->readSegment(job.begin, job.end, job.records);
+    }
+    job.writer->format(job.records, job.chunk);
+    job.records.clear();
+    job.buffers.clear();
+}
+
+/**
+ * Source of the jobs, either the segments of a log or the batches of a merge.
+ */
+class JobSource {
+public:
+    virtual ~JobSource() {}
+    // Appends up to count jobs, returns false when there is nothing left
+    virtual bool fill(const LogWriter *writer, int count, QVector<FormatJob> &jobs) = 0;
+    virtual qint64 corruptedBytes() const
+    {
+        return 0;
+    }
+};
+
+class SegmentSource : public JobSource {
+public:
+    SegmentSource(const LogReader *reader) :
+        m_reader(reader), m_next(0)
+    {
+        if (!reader->isCompressed()) {
+            m_boundaries = reader->split(SEGMENT_SIZE);
+        }
+    }
+
+    bool fill(const LogWriter *writer, int count, QVector<FormatJob> &jobs)
+    {
+        const int segments = m_reader->isCompressed() ? m_reader->blockCount() : m_boundaries.size() - 1;
+
+        while (count-- > 0 && m_next < segments) {
+            FormatJob job;
+            job.writer    = writer;
+            job.reader    = m_reader;
+            job.corrupted = 0;
+            if (m_reader->isCompressed()) {
+                job.begin = 0;
+                job.end   = 0;
+                job.block = m_next;
+            } else {
+                job.begin = m_boundaries.at(m_next);
+                job.end   = m_boundaries.at(m_next + 1);
+                job.block = -1;
+            }
+            jobs.append(job);
+            ++m_next;
+        }
+        return !jobs.isEmpty();
+    }
+
+private:
+    const LogReader *m_reader;
+    QVector<qint64> m_boundaries;
+    int m_next;
+};
+
+class MergeSource : public JobSource {
+public:
+    MergeSource(const QList<LogReader *> &readers) :
+        m_merger(readers), m_done(false) {}
+
+    bool fill(const LogWriter *writer, int count, QVector<FormatJob> &jobs)
+    {
+        while (count-- > 0 && !m_done) {
+            FormatJob job;
+            job.writer    = writer;
+            job.reader    = NULL;
+            job.begin     = 0;
+            job.end       = 0;
+            job.block     = -1;
+            job.corrupted = 0;
+            m_done = !m_merger.next(MERGE_BATCH_LENGTH, job.records, job.buffers);
+            if (!job.records.isEmpty()) {
+                jobs.append(job);
+            }
+        }
+        return !jobs.isEmpty();
+    }
+
+    qint64 corruptedBytes() const
+    {
+        return m_merger.corruptedBytes();
+    }
+
+private:
+    LogMerger m_merger;
+    bool m_done;
+};
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("Converts OPL logs to other formats, several logs are merged by time stamp.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("format", "Output format: " + LogWriter::formats().join(", ") + ".", "format", "csv"));
+    parser.addOption(QCommandLineOption("output", "Output file, - for the standard output, or directory for csv.", "path"));
+    parser.addOption(QCommandLineOption("objects", "Only output these objects.", "name,..."));
+    parser.addOption(QCommandLineOption("threads", "Worker threads, all the cores by default.", "count"));
+    parser.addPositionalArgument("logs", "OPL logs to convert or merge, plain or compressed.", "log...");
+    parser.process(app);
+
+    QStringList logs = parser.positionalArguments();
+    if (logs.isEmpty() || !parser.isSet("output")) {
+        parser.showHelp(1);
+    }
+    if (parser.isSet("threads")) {
+        QThreadPool::globalInstance()->setMaxThreadCount(qMax(1, parser.value("threads").toInt()));
+    }
+
+    UAVObjectManager objManager;
+    UAVObjectsInitialize(&objManager);
+
+    LogWriter *writer = LogWriter::create(parser.value("format"), &objManager);
+    if (writer == NULL) {
+        fprintf(stderr, "Unknown format %s\n", qPrintable(parser.value("format")));
+        return 1;
+    }
+    QString error;
+    if (parser.isSet("objects") && !writer->setObjectFilter(parser.value("objects").split(','), &error)) {
+        fprintf(stderr, "%s\n", qPrintable(error));
+        return 1;
+    }
+
+    QList<LogReader *> readers;
+    foreach(const QString &log, logs) {
+        LogReader *reader = new LogReader;
+        readers.append(reader);
+        if (!reader->open(log, &error)) {
+            fprintf(stderr, "%s: %s\n", qPrintable(log), qPrintable(error));
+            return 1;
+        }
+    }
+    if (!writer->open(parser.value("output"), &error)) {
+        fprintf(stderr, "%s: %s\n", qPrintable(parser.value("output")), qPrintable(error));
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    JobSource *source;
+    if (readers.size() == 1) {
+        source = new SegmentSource(readers.first());
+    } else {
+        source = new MergeSource(readers);
+    }
+
+    // Two windows of jobs: one is formatted by the workers while the next is filled
+    const int windowLength = 2 * QThreadPool::globalInstance()->maxThreadCount();
+    QVector<FormatJob> current;
+    QVector<FormatJob> pending;
+    quint64 records   = 0;
+    quint64 skipped   = 0;
+    qint64 corrupted  = 0;
+    bool ok = true;
+
+    bool more = source->fill(writer, windowLength, current);
+    while (more && ok) {
+        QFuture<void> future = QtConcurrent::map(current, formatJob);
+        pending.clear();
+        more = source->fill(writer, windowLength, pending);
+        future.waitForFinished();
+
+        foreach(const FormatJob &job, current) {
+            if (!writer->write(job.chunk, &error)) {
+                ok = false;
+                break;
+            }
+            records   += job.chunk.records;
+            skipped   += job.chunk.skipped;
+            corrupted += job.corrupted;
+        }
+        current.swap(pending);
+    }
+    corrupted += source->corruptedBytes();
+
+    if (ok && !writer->close(&error)) {
+        ok = false;
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: %s\n", qPrintable(parser.value("output")), qPrintable(error));
+    }
+    fprintf(stderr, "%llu records written, %llu skipped, %lld corrupted bytes, %lld ms\n",
+            records, skipped, corrupted, timer.elapsed());
+
+    delete source;
+    delete writer;
+    qDeleteAll(readers);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+# OPL log converter and merger, not part of the GCS build.
+# Build it against a GCS build tree after the GCS, e.g.:
+#   mkdir build/opltool && cd build/opltool
+#   qmake GCS_BUILD_TREE=<root>/build/openpilotgcs_release <root>/ground/openpilotgcs/src/experimental/opltool/opltool.pro
+#   make && ../openpilotgcs_release/bin/opltool --format csv --output flight flight.opl
+
+TEMPLATE = app
+TARGET = opltool
+
+QT += concurrent
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../../openpilotgcs.pri)
+
+DESTDIR = $$GCS_APP_PATH
+
+INCLUDEPATH += $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+
+include($$GCS_SOURCE_TREE/src/plugins/uavobjects/uavobjects.pri)
+
+HEADERS += \
+    logreader.h \
+    logwriter.h
+
+SOURCES += \
+    $$UAVOBJECT_SYNTHETICS/uavobjectsinit.cpp \
+    logreader.cpp \
+    logwriter.cpp \
+    main.cpp
+
+linux-* {
+    QMAKE_RPATHDIR = \'\$$ORIGIN\'/$$relative_path($$GCS_LIBRARY_PATH, $$DESTDIR)
+    QMAKE_RPATHDIR += \'\$$ORIGIN\'/$$relative_path($$GCS_PLUGIN_PATH/OpenPilot, $$DESTDIR)
+    QMAKE_RPATHDIR += \'\$$ORIGIN\'/$$relative_path($$GCS_QT_LIBRARY_PATH, $$DESTDIR)
+    include(../../rpath.pri)
+}
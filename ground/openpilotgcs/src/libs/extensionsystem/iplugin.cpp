@@ -238,6 +238,17 @@
     \sa initialize()
  */
 
+/*!
+    \fn bool IPlugin::delayedInitialize()
+    Called once all plugins are running, in the same order as
+    IPlugin::extensionsInitialized() but one plugin at a time from the event
+    loop, so the main window is already shown. Work that is not needed to show
+    the first window, like scanning files or filling caches, belongs here.
+    Returns true if it did anything, the next plugin then waits a little
+    longer to keep the user interface responsive.
+    \sa extensionsInitialized()
+ */
+
 /*!
     \fn void IPlugin::shutdown()
     Called during a shutdown sequence in the same order as initialization
@@ -51,6 +51,10 @@ public:
 
     virtual bool initialize(const QStringList &arguments, QString *errorString) = 0;
     virtual void extensionsInitialized() = 0;
+    virtual bool delayedInitialize()
+    {
+        return false;
+    }
     virtual void shutdown() {}
 
     PluginSpec *pluginSpec() const;
@@ -37,6 +37,8 @@
 #include <QtCore/QDir>
 #include <QtCore/QTextStream>
 #include <QtCore/QWriteLocker>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
 #include <QtDebug>
 #ifdef WITH_TESTS
 #include <QTest>
@@ -407,6 +409,15 @@ void PluginManager::formatPluginOptions(QTextStream &str, int optionIndentation,
     }
 }
 
+/*!
+    \fn void PluginManager::nextDelayedInitialize()
+    \internal
+ */
+void PluginManager::nextDelayedInitialize()
+{
+    d->nextDelayedInitialize();
+}
+
 /*!
     \fn PluginManager::formatPluginVersions(QTextStream &str) const
 
@@ -494,7 +505,7 @@ PluginSpecPrivate *PluginManagerPrivate::privateSpec(PluginSpec *spec)
     \internal
  */
 PluginManagerPrivate::PluginManagerPrivate(PluginManager *pluginManager)
-    : extension("xml"), q(pluginManager)
+    : extension("xml"), delayedInitializeTimer(0), q(pluginManager)
 {}
 
 /*!
@@ -512,6 +523,13 @@ PluginManagerPrivate::~PluginManagerPrivate()
 
 void PluginManagerPrivate::stopAll()
 {
+    if (delayedInitializeTimer) {
+        delayedInitializeTimer->stop();
+        delete delayedInitializeTimer;
+        delayedInitializeTimer = 0;
+    }
+    delayedInitializeQueue.clear();
+
     QList<PluginSpec *> queue = loadQueue();
     foreach(PluginSpec * spec, queue) {
         loadPlugin(spec, PluginSpec::Stopped);
@@ -593,10 +611,69 @@ void PluginManagerPrivate::loadPlugins()
         PluginSpec *plugin = it.previous();
         emit q->pluginAboutToBeLoaded(plugin);
         loadPlugin(plugin, PluginSpec::Running);
+        if (plugin->state() == PluginSpec::Running) {
+            delayedInitializeQueue.append(plugin);
+        }
     }
     emit q->pluginsChanged();
     q->m_allPluginsLoaded = true;
+    reportStartupTime();
     emit q->pluginsLoadEnded();
+
+    // the rest runs from the event loop once the main window is up
+    delayedInitializeTimer = new QTimer;
+    delayedInitializeTimer->setInterval(0);
+    delayedInitializeTimer->setSingleShot(true);
+    QObject::connect(delayedInitializeTimer, SIGNAL(timeout()), q, SLOT(nextDelayedInitialize()));
+    delayedInitializeTimer->start();
+}
+
+/*!
+    \fn void PluginManagerPrivate::reportStartupTime() const
+    \internal
+ */
+void PluginManagerPrivate::reportStartupTime() const
+{
+    QList<QPair<qint64, PluginSpec *> > times;
+    qint64 total = 0;
+
+    foreach(PluginSpec * spec, pluginSpecs) {
+        qint64 time = startupTime.value(spec);
+        times.append(qMakePair(time, spec));
+        total += time;
+    }
+    // slowest first
+    qSort(times.begin(), times.end(), qGreater<QPair<qint64, PluginSpec *> >());
+
+    qDebug() << "PluginManager - plugins took" << total / 1000000 << "ms to start";
+    for (int i = 0; i < times.size(); ++i) {
+        qDebug().nospace() << "PluginManager - " << qPrintable(times.at(i).second->name())
+                           << ": " << times.at(i).first / 1000000 << "ms";
+    }
+}
+
+/*!
+    \fn void PluginManagerPrivate::nextDelayedInitialize()
+    \internal
+ */
+void PluginManagerPrivate::nextDelayedInitialize()
+{
+    while (!delayedInitializeQueue.isEmpty()) {
+        PluginSpec *spec = delayedInitializeQueue.takeFirst();
+        QElapsedTimer timer;
+        timer.start();
+        if (spec->d->delayedInitialize()) {
+            qDebug().nospace() << "PluginManager - " << qPrintable(spec->name())
+                               << ": delayed initialization took " << timer.elapsed() << "ms";
+            // give the event loop some time before the next one
+            delayedInitializeTimer->setInterval(20);
+            delayedInitializeTimer->start();
+            return;
+        }
+    }
+    delayedInitializeTimer->deleteLater();
+    delayedInitializeTimer = 0;
+    emit q->initializationDone();
 }
 
 /*!
@@ -667,8 +744,11 @@ void PluginManagerPrivate::loadPlugin(PluginSpec *spec, PluginSpec::State destSt
     if (spec->hasError()) {
         return;
     }
+    QElapsedTimer timer;
+    timer.start();
     if (destState == PluginSpec::Running) {
         spec->d->initializeExtensions();
+        startupTime[spec] += timer.nsecsElapsed();
         return;
     } else if (destState == PluginSpec::Deleted) {
         spec->d->kill();
@@ -685,8 +765,10 @@ void PluginManagerPrivate::loadPlugin(PluginSpec *spec, PluginSpec::State destSt
     }
     if (destState == PluginSpec::Loaded) {
         spec->d->loadLibrary();
+        startupTime[spec] += timer.nsecsElapsed();
     } else if (destState == PluginSpec::Initialized) {
         spec->d->initializePlugin();
+        startupTime[spec] += timer.nsecsElapsed();
     } else if (destState == PluginSpec::Stopped) {
         spec->d->stop();
     }
@@ -122,8 +122,10 @@ signals:
     void pluginAboutToBeLoaded(ExtensionSystem::PluginSpec *pluginSpec);
     void pluginsChanged();
     void pluginsLoadEnded();
+    void initializationDone();
 private slots:
     void startTests();
+    void nextDelayedInitialize();
 
 private:
     Internal::PluginManagerPrivate *d;
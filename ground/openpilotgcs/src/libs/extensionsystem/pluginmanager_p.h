@@ -32,10 +32,15 @@
 #include "pluginspec.h"
 
 #include <QtCore/QList>
+#include <QtCore/QHash>
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
 #include <QtCore/QObject>
 
+QT_BEGIN_NAMESPACE
+class QTimer;
+QT_END_NAMESPACE
+
 namespace ExtensionSystem {
 class PluginManager;
 
@@ -66,6 +71,15 @@ public:
 
     QStringList arguments;
 
+    // Plugins still to get IPlugin::delayedInitialize() after startup
+    QList<PluginSpec *> delayedInitializeQueue;
+    QTimer *delayedInitializeTimer;
+    void nextDelayedInitialize();
+
+    // Time spent loading and initializing each plugin in ns
+    QHash<PluginSpec *, qint64> startupTime;
+    void reportStartupTime() const;
+
     // Look in argument descriptions of the specs for the option.
     PluginSpec *pluginForOption(const QString &option, bool *requiresArgument) const;
     PluginSpec *pluginByName(const QString &name) const;
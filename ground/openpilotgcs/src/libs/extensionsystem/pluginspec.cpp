@@ -886,6 +886,18 @@ bool PluginSpecPrivate::initializeExtensions()
     return true;
 }
 
+/*!
+    \fn bool PluginSpecPrivate::delayedInitialize()
+    \internal
+ */
+bool PluginSpecPrivate::delayedInitialize()
+{
+    if (hasError || state != PluginSpec::Running || !plugin) {
+        return false;
+    }
+    return plugin->delayedInitialize();
+}
+
 /*!
     \fn bool PluginSpecPrivate::stop()
     \internal
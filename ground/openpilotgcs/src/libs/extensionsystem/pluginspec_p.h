@@ -52,6 +52,7 @@ public:
     bool loadLibrary();
     bool initializePlugin();
     bool initializeExtensions();
+    bool delayedInitialize();
     void stop();
     void kill();
 
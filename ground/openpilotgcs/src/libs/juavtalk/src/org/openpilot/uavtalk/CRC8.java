@@ -51,6 +51,21 @@ public class CRC8 {
 	    return crc;
 	}
 
+	/**
+	* update a CRC8 value with a part of a byte-array
+	* 
+	* @param crc - start CRC8 Value
+	* @param data - data byte-array to update the CRC8-Checksum with
+	* @param offset - index of the first byte
+	* @param length - number of bytes
+	* @return - the new CRC value
+	*/
+	public static byte arrayUpdate(byte crc, byte[] data, int offset, int length) {
+		for (int i=offset;i<offset+length;i++)
+			crc = CRC8_TABLE[(crc ^ data[i])&0xFF];
+		return crc;
+	}
+
 	/** CRC lookup table - values from PYCRC **/ 
 	private final static byte [] CRC8_TABLE = {
 		(byte)0x00, (byte)0x07, (byte)0x0e, (byte)0x09, (byte)0x1c, (byte)0x1b, (byte)0x12, (byte)0x15, (byte)0x38,
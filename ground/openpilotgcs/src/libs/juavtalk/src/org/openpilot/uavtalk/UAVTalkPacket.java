@@ -0,0 +1,84 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+package org.openpilot.uavtalk;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ ******************************************************************************
+ *
+ * @file       UAVTalkPacket.java
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      a received UAVTalk packet, owned by a UAVTalkPacketPool
+ *
+ ****************************************************************************
+*/
+public final class UAVTalkPacket {
+
+	public final static int MAX_PAYLOAD_LENGTH = 256;
+
+	byte type;
+	int objId;
+	int instId;
+	int length;
+
+	private final byte[] data = new byte[MAX_PAYLOAD_LENGTH];
+	private final ByteBuffer payload = ByteBuffer.wrap(data).order(ByteOrder.LITTLE_ENDIAN);
+	private final UAVTalkPacketPool pool;
+
+	UAVTalkPacket(UAVTalkPacketPool pool) {
+		this.pool = pool;
+	}
+
+	public byte getType() {
+		return type;
+	}
+
+	public int getObjID() {
+		return objId;
+	}
+
+	public int getInstID() {
+		return instId;
+	}
+
+	public int getLength() {
+		return length;
+	}
+
+	byte[] getData() {
+		return data;
+	}
+
+	/**
+	 * @return the payload as a little endian buffer, rewound on every call.
+	 * It is the same buffer for the life of the packet, do not keep it after release()
+	 */
+	public ByteBuffer getPayload() {
+		payload.clear();
+		payload.limit(length);
+		return payload;
+	}
+
+	/**
+	 * give the packet back to its pool, it must not be used afterwards
+	 */
+	public void release() {
+		pool.release(this);
+	}
+}
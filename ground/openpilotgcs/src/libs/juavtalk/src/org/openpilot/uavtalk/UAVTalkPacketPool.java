@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+package org.openpilot.uavtalk;
+
+/**
+ ******************************************************************************
+ *
+ * @file       UAVTalkPacketPool.java
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      fixed set of packets, so steady state reception does not allocate
+ *
+ ****************************************************************************
+*/
+public final class UAVTalkPacketPool {
+
+	private final UAVTalkPacket[] free;
+	private int numFree;
+
+	/**
+	 * @param size - the number of packets which can be in use at the same time
+	 */
+	public UAVTalkPacketPool(int size) {
+		free = new UAVTalkPacket[size];
+		for (numFree = 0; numFree < size; numFree++)
+			free[numFree] = new UAVTalkPacket(this);
+	}
+
+	/**
+	 * @return a free packet, null if all are in use
+	 */
+	public synchronized UAVTalkPacket acquire() {
+		if (numFree == 0)
+			return null;
+		UAVTalkPacket packet = free[--numFree];
+		free[numFree] = null;
+		return packet;
+	}
+
+	synchronized void release(UAVTalkPacket packet) {
+		if (numFree == free.length)
+			throw new IllegalStateException("packet released twice");
+		free[numFree++] = packet;
+	}
+
+	public synchronized int getNumFree() {
+		return numFree;
+	}
+}
@@ -0,0 +1,199 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+package org.openpilot.uavtalk;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.channels.ReadableByteChannel;
+
+/**
+ ******************************************************************************
+ *
+ * @file       UAVTalkParser.java
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      frames UAVTalk packets out of NIO buffers without allocating
+ *
+ * The header is sync(1), type(1), length(2), object ID(4), instance ID(2),
+ * the length counts the header and the data but not the CRC. Headers are
+ * parsed a byte at a time from the buffer, the data is copied in bulk into
+ * a packet of the pool. A packet handed to the listener belongs to it until
+ * it calls release(), when the pool is empty packets are dropped and counted.
+ *
+ ****************************************************************************
+*/
+public final class UAVTalkParser {
+
+	public interface Listener {
+		public void onPacket(UAVTalkPacket packet);
+	}
+
+	public final static int HEADER_LENGTH = 10;
+
+	private final static byte TYPE_MASK = (byte)0xF8;
+
+	private final static int STATE_SYNC = 0;
+	private final static int STATE_HEADER = 1;
+	private final static int STATE_DATA = 2;
+	private final static int STATE_CRC = 3;
+
+	private final UAVTalkPacketPool pool;
+	private final Listener listener;
+	private final ByteBuffer readBuffer;
+
+	private final byte[] header = new byte[HEADER_LENGTH];
+	private int state = STATE_SYNC;
+	private int headerPos;
+	private int dataLength;
+	private int dataPos;
+	private byte crc;
+	private UAVTalkPacket packet;
+
+	private long rxBytes;
+	private long rxPackets;
+	private long rxErrors;
+	private long rxDropped;
+
+	/**
+	 * @param pool - where the packets come from
+	 * @param listener - gets every packet with a valid CRC
+	 * @param readBufferSize - size of the buffer used by readFrom()
+	 */
+	public UAVTalkParser(UAVTalkPacketPool pool, Listener listener, int readBufferSize) {
+		this.pool = pool;
+		this.listener = listener;
+		readBuffer = ByteBuffer.allocateDirect(readBufferSize);
+	}
+
+	/**
+	 * read what the channel has and parse it
+	 *
+	 * @return the number of bytes read, -1 at the end of the stream
+	 */
+	public int readFrom(ReadableByteChannel channel) throws IOException {
+		readBuffer.clear();
+		int read = channel.read(readBuffer);
+		if (read > 0) {
+			readBuffer.flip();
+			parse(readBuffer);
+		}
+		return read;
+	}
+
+	/**
+	 * parse all remaining bytes of the buffer, a packet may span several calls
+	 */
+	public void parse(ByteBuffer in) {
+		rxBytes += in.remaining();
+		while (in.hasRemaining()) {
+			switch (state) {
+			case STATE_SYNC:
+				if (in.get() == UAVTalkDefinitions.SYNC_VAL) {
+					header[0] = UAVTalkDefinitions.SYNC_VAL;
+					headerPos = 1;
+					state = STATE_HEADER;
+				}
+				break;
+
+			case STATE_HEADER:
+				header[headerPos++] = in.get();
+				if (headerPos == 2 && (header[1] & TYPE_MASK) != UAVTalkDefinitions.TYPE_VER) {
+					resync();
+				} else if (headerPos == HEADER_LENGTH) {
+					startData();
+				}
+				break;
+
+			case STATE_DATA:
+				int chunk = Math.min(in.remaining(), dataLength - dataPos);
+				if (packet != null) {
+					in.get(packet.getData(), dataPos, chunk);
+				} else {
+					in.position(in.position() + chunk);
+				}
+				dataPos += chunk;
+				if (dataPos == dataLength)
+					state = STATE_CRC;
+				break;
+
+			case STATE_CRC:
+				endPacket(in.get());
+				break;
+			}
+		}
+	}
+
+	private void startData() {
+		int length = (header[2] & 0xFF) | ((header[3] & 0xFF) << 8);
+		dataLength = length - HEADER_LENGTH;
+		if (dataLength < 0 || dataLength > UAVTalkPacket.MAX_PAYLOAD_LENGTH) {
+			resync();
+			return;
+		}
+		crc = CRC8.arrayUpdate((byte)0, header, HEADER_LENGTH);
+		dataPos = 0;
+		packet = pool.acquire();
+		if (packet == null)
+			rxDropped++;
+		state = dataLength > 0 ? STATE_DATA : STATE_CRC;
+	}
+
+	private void endPacket(byte rxCrc) {
+		state = STATE_SYNC;
+		if (packet == null)
+			return;
+		if (CRC8.arrayUpdate(crc, packet.getData(), 0, dataLength) != rxCrc) {
+			resync();
+			return;
+		}
+		packet.type = header[1];
+		packet.objId = ValueParser.parse_int_from_arr_4(4, header);
+		packet.instId = (header[8] & 0xFF) | ((header[9] & 0xFF) << 8);
+		packet.length = dataLength;
+		rxPackets++;
+		UAVTalkPacket received = packet;
+		packet = null;
+		listener.onPacket(received);
+	}
+
+	private void resync() {
+		rxErrors++;
+		if (packet != null) {
+			packet.release();
+			packet = null;
+		}
+		state = STATE_SYNC;
+	}
+
+	public long getRxBytes() {
+		return rxBytes;
+	}
+
+	public long getRxPackets() {
+		return rxPackets;
+	}
+
+	public long getRxErrors() {
+		return rxErrors;
+	}
+
+	/**
+	 * @return the packets lost because the listener kept all the packets of the pool
+	 */
+	public long getRxDropped() {
+		return rxDropped;
+	}
+}
@@ -1,5 +1,7 @@
 include (../common.pri)
 
+QT += concurrent
+
 SOURCES += opmaps.cpp \
     pureimagecache.cpp \
     pureimage.cpp \
@@ -16,7 +18,9 @@ SOURCES += opmaps.cpp \
     point.cpp \
     size.cpp \
     kibertilecache.cpp \
-    diagnostics.cpp
+    decodedtilecache.cpp \
+    diagnostics.cpp \
+    elevation.cpp
 HEADERS += opmaps.h \
     size.h \
     maptype.h \
@@ -36,5 +40,7 @@ HEADERS += opmaps.h \
     placemark.h \
     point.h \
     kibertilecache.h \
+    decodedtilecache.h \
     debugheader.h \
-    diagnostics.h
+    diagnostics.h \
+    elevation.h
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ *
+ * @file       decodedtilecache.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Memory cache of decoded tiles
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "decodedtilecache.h"
+
+namespace core {
+DecodedTileCache::DecodedTileCache() : tiles(64 * 1024)
+{}
+
+void DecodedTileCache::setCapacity(const int &value)
+{
+    mutex.lock();
+    tiles.setMaxCost(value * 1024);
+    mutex.unlock();
+}
+int DecodedTileCache::Capacity()
+{
+    QMutexLocker locker(&mutex);
+
+    return tiles.maxCost() / 1024;
+}
+double DecodedTileCache::Size()
+{
+    QMutexLocker locker(&mutex);
+
+    return tiles.totalCost() / 1024.0;
+}
+
+QImage DecodedTileCache::GetTile(const RawTile &tile)
+{
+    QMutexLocker locker(&mutex);
+    // a lookup also makes the tile the most recently used one
+    QImage *img = tiles.object(tile);
+
+    return img ? *img : QImage();
+}
+bool DecodedTileCache::Contains(const RawTile &tile)
+{
+    QMutexLocker locker(&mutex);
+
+    return tiles.contains(tile);
+}
+void DecodedTileCache::AddTile(const RawTile &tile, const QImage &img)
+{
+    mutex.lock();
+    tiles.insert(tile, new QImage(img), 1 + img.byteCount() / 1024);
+#ifdef DEBUG_MEMORY_CACHE
+    qDebug() << "Decoded memory=" << tiles.totalCost() << "kb in " << tiles.count() << " tiles";
+#endif
+    mutex.unlock();
+}
+void DecodedTileCache::Clear()
+{
+    mutex.lock();
+    tiles.clear();
+    mutex.unlock();
+}
+}
@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ *
+ * @file       decodedtilecache.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Memory cache of decoded tiles
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef DECODEDTILECACHE_H
+#define DECODEDTILECACHE_H
+
+#include "rawtile.h"
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QDebug>
+#include "debugheader.h"
+namespace core {
+/**
+ * @brief Decoded tiles kept ready to draw
+ *
+ * Least recently used tiles are dropped first once the decoded size goes over
+ * the capacity. Tiles are decoded and added from the loader and prefetch threads.
+ */
+class DecodedTileCache {
+public:
+    DecodedTileCache();
+
+    /**
+     * @brief Sets the memory used for decoded tiles
+     *
+     * @param value size in Mb
+     */
+    void setCapacity(const int &value);
+    int Capacity();
+    /**
+     * @brief Returns the memory used by the decoded tiles in Mb
+     */
+    double Size();
+
+    QImage GetTile(const RawTile &tile);
+    bool Contains(const RawTile &tile);
+    void AddTile(const RawTile &tile, const QImage &img);
+    void Clear();
+private:
+    QMutex mutex;
+    // costs are in kb, a budget in bytes would overflow the int cost
+    QCache<RawTile, QImage> tiles;
+};
+}
+#endif // DECODEDTILECACHE_H
@@ -0,0 +1,118 @@
+/**
+ ******************************************************************************
+ *
+ * @file       elevation.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Terrain heights from elevation tiles kept in the tile cache
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "elevation.h"
+#include "opmaps.h"
+#include <QHash>
+#include <QtConcurrent/QtConcurrentRun>
+#include <qmath.h>
+#include <limits>
+
+namespace core {
+Elevation *Elevation::m_pInstance = 0;
+
+Elevation *Elevation::Instance()
+{
+    if (!m_pInstance) {
+        m_pInstance = new Elevation;
+    }
+    return m_pInstance;
+}
+
+Elevation::Elevation()
+{
+    queries.setMaxThreadCount(2);
+    loaders.setMaxThreadCount(4);
+}
+
+QFuture<QVector<double> > Elevation::Query(const QVector<internals::PointLatLng> &points)
+{
+    return QtConcurrent::run(&queries, this, &Elevation::Heights, points);
+}
+
+QVector<double> Elevation::Heights(const QVector<internals::PointLatLng> &points)
+{
+    const double tiles = 1 << Zoom;
+    QVector<double> heights(points.size(), std::numeric_limits<double>::quiet_NaN());
+    QVector<QPointF> pixels(points.size());
+    QVector<core::Point> pointTiles(points.size());
+    QHash<core::Point, QFuture<QImage> > loads;
+
+    // web mercator pixel of each point, the tiles they fall in are loaded in parallel
+    for (int i = 0; i < points.size(); ++i) {
+        const double lat = qBound(-85.05112878, points[i].Lat(), 85.05112878) * M_PI / 180.0;
+        const double x   = (points[i].Lng() + 180.0) / 360.0 * tiles;
+        const double y   = (1.0 - qLn(qTan(lat) + 1.0 / qCos(lat)) / M_PI) / 2.0 * tiles;
+        const core::Point tile(qBound(0, (int)x, (int)tiles - 1), qBound(0, (int)y, (int)tiles - 1));
+
+        pointTiles[i] = tile;
+        pixels[i]     = QPointF((x - tile.X()) * 256.0 - 0.5, (y - tile.Y()) * 256.0 - 0.5);
+        if (!loads.contains(tile)) {
+            loads.insert(tile, QtConcurrent::run(&loaders, &Elevation::LoadTile, tile));
+        }
+    }
+
+    QHash<core::Point, QImage> images;
+    for (QHash<core::Point, QFuture<QImage> >::const_iterator load = loads.constBegin(); load != loads.constEnd(); ++load) {
+        images.insert(load.key(), load.value().result());
+    }
+    for (int i = 0; i < points.size(); ++i) {
+        const QImage &image = images[pointTiles[i]];
+        if (!image.isNull()) {
+            heights[i] = Height(image, pixels[i].x(), pixels[i].y());
+        }
+    }
+    return heights;
+}
+
+QImage Elevation::LoadTile(const core::Point &tile)
+{
+    return OPMaps::Instance()->GetDecodedImageFrom(MapType::TerrariumElevation, tile, Zoom);
+}
+
+double Elevation::Height(const QImage &tile, double x, double y)
+{
+    // bilinear between the pixel centres, clamped at the tile edges
+    x = qBound(0.0, x, tile.width() - 1.0);
+    y = qBound(0.0, y, tile.height() - 1.0);
+    const int x0    = (int)x;
+    const int y0    = (int)y;
+    const int x1    = qMin(x0 + 1, tile.width() - 1);
+    const int y1    = qMin(y0 + 1, tile.height() - 1);
+    const double fx = x - x0;
+    const double fy = y - y0;
+
+    double h[2][2];
+    for (int j = 0; j < 2; ++j) {
+        for (int i = 0; i < 2; ++i) {
+            // Terrarium encoding, metres + 32768 over red, green and blue
+            const QRgb rgb = tile.pixel(i ? x1 : x0, j ? y1 : y0);
+            h[j][i] = qRed(rgb) * 256.0 + qGreen(rgb) + qBlue(rgb) / 256.0 - 32768.0;
+        }
+    }
+    return (h[0][0] * (1.0 - fx) + h[0][1] * fx) * (1.0 - fy) + (h[1][0] * (1.0 - fx) + h[1][1] * fx) * fy;
+}
+}
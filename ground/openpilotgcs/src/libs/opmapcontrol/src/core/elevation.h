@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ *
+ * @file       elevation.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Terrain heights from elevation tiles kept in the tile cache
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef ELEVATION_H
+#define ELEVATION_H
+
+#include <QFuture>
+#include <QImage>
+#include <QThreadPool>
+#include <QVector>
+#include "point.h"
+#include "../internals/pointlatlng.h"
+
+namespace core {
+/**
+ * Terrain heights from the Terrarium tiles, SRTM and other DEMs merged in
+ * the tiling of the maps. The tiles are fetched and stored by OPMaps as the
+ * map tiles are, in the same memory and database caches.
+ */
+class Elevation {
+public:
+    static Elevation *Instance();
+
+    /**
+     * @brief Heights above mean sea level of the points, in metres, NaN where
+     *        the tile could not be loaded. Each tile is loaded once, the ones
+     *        not in memory in parallel.
+     */
+    QVector<double> Heights(const QVector<internals::PointLatLng> &points);
+    /**
+     * @brief Same as Heights, run on the elevation worker pool
+     */
+    QFuture<QVector<double> > Query(const QVector<internals::PointLatLng> &points);
+
+    // ~38m per pixel at the equator, close to the resolution of the sources
+    static const int Zoom = 12;
+
+private:
+    Elevation();
+    Elevation(Elevation const &) {}
+    Elevation & operator=(Elevation const &)
+    {
+        return *this;
+    }
+    static QImage LoadTile(const core::Point &tile);
+    static double Height(const QImage &tile, double x, double y);
+
+    // queries and tile loads wait on each other, they have a pool each
+    QThreadPool queries;
+    QThreadPool loaders;
+    static Elevation *m_pInstance;
+};
+}
+#endif // ELEVATION_H
@@ -93,7 +93,10 @@ public:
         GoogleLabelsKorea    = 4003,
         GoogleHybridKorea    = 4005,
 
-        YandexMapRu = 5000
+        YandexMapRu = 5000,
+
+        // elevation data rather than a map, see Elevation
+        TerrariumElevation = 6000
     };
     static QString StrByType(Types const & value)
     {
@@ -118,6 +121,9 @@ public:
         QMetaEnum metaEnum     = metaObject.enumerator(metaObject.indexOfEnumerator("Types"));
 
         for (int x = 0; x < metaEnum.keyCount(); ++x) {
+            if (metaEnum.value(x) == TerrariumElevation) {
+                continue;
+            }
             ret.append(metaEnum.key(x));
         }
         return ret;
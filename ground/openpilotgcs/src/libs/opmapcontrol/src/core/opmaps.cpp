@@ -100,153 +100,222 @@ QByteArray OPMaps::GetImageFrom(const MapType::Types &type, const Point &pos, co
             }
         }
         if (accessmode != AccessMode::CacheOnly) {
-            QEventLoop q;
-            QNetworkReply *reply;
-            QNetworkRequest qheader;
-            QNetworkAccessManager network;
-            QTimer tT;
-            tT.setSingleShot(true);
-            connect(&network, SIGNAL(finished(QNetworkReply *)),
-                    &q, SLOT(quit()));
-            connect(&tT, SIGNAL(timeout()), &q, SLOT(quit()));
-            network.setProxy(Proxy);
+            ret = GetImageFromServer(type, pos, zoom);
+            if (ret.isEmpty()) {
+                return ret;
+            }
+            if (useMemoryCache) {
 #ifdef DEBUG_GMAPS
-            qDebug() << "Try Tile from the Internet";
+                qDebug() << "Add Tile to memory cache";
 #endif // DEBUG_GMAPS
+                AddTileToMemoryCache(RawTile(type, pos, zoom), ret);
+            }
+            if (accessmode != AccessMode::ServerOnly) {
+#ifdef DEBUG_GMAPS
+                qDebug() << "Add tile to DataBase";
+#endif // DEBUG_GMAPS
+                CacheItemQueue *item = new CacheItemQueue(type, pos, ret, zoom);
+                TileDBcacheQueue.EnqueueCacheTask(item);
+            }
+        }
+    }
+#ifdef DEBUG_GMAPS
+    qDebug() << "Entered GetImageFrom";
+#endif // DEBUG_GMAPS
+    return ret;
+}
+QByteArray OPMaps::GetImageFromServer(const MapType::Types &type, const Point &pos, const int &zoom)
+{
 #ifdef DEBUG_TIMINGS
-            qDebug() << "opmaps before make image url" << time.elapsed();
+    QTime time;
+    time.restart();
 #endif
-            QString url = MakeImageUrl(type, pos, zoom, LanguageStr);
+    QByteArray ret;
+    QEventLoop q;
+    QNetworkReply *reply;
+    QNetworkRequest qheader;
+    QNetworkAccessManager *network = Network();
+    QTimer tT;
+    tT.setSingleShot(true);
+    connect(&tT, SIGNAL(timeout()), &q, SLOT(quit()));
+    network->setProxy(Proxy);
+#ifdef DEBUG_GMAPS
+    qDebug() << "Try Tile from the Internet";
+#endif // DEBUG_GMAPS
+#ifdef DEBUG_TIMINGS
+    qDebug() << "opmaps before make image url" << time.elapsed();
+#endif
+    QString url = MakeImageUrl(type, pos, zoom, LanguageStr);
 #ifdef DEBUG_TIMINGS
-            qDebug() << "opmaps after make image url" << time.elapsed();
+    qDebug() << "opmaps after make image url" << time.elapsed();
 #endif // url	"http://vec02.maps.yandex.ru/tiles?l=map&v=2.10.2&x=7&y=5&z=3"	string
        // "http://map3.pergo.com.tr/tile/02/000/000/007/000/000/002.png"
-            qheader.setUrl(QUrl(url));
-            qheader.setRawHeader("User-Agent", UserAgent);
-            qheader.setRawHeader("Accept", "*/*");
-            switch (type) {
-            case MapType::GoogleMap:
-            case MapType::GoogleSatellite:
-            case MapType::GoogleLabels:
-            case MapType::GoogleTerrain:
-            case MapType::GoogleHybrid:
-            {
-                qheader.setRawHeader("Referrer", "http://maps.google.com/");
-            }
-            break;
+    QUrl tileUrl(url);
+    qheader.setUrl(tileUrl);
+    qheader.setRawHeader("User-Agent", UserAgent);
+    qheader.setRawHeader("Accept", "*/*");
+    qheader.setRawHeader("Connection", "keep-alive");
+    switch (type) {
+    case MapType::GoogleMap:
+    case MapType::GoogleSatellite:
+    case MapType::GoogleLabels:
+    case MapType::GoogleTerrain:
+    case MapType::GoogleHybrid:
+    {
+        qheader.setRawHeader("Referrer", "http://maps.google.com/");
+    }
+    break;
 
-            case MapType::GoogleMapChina:
-            case MapType::GoogleSatelliteChina:
-            case MapType::GoogleLabelsChina:
-            case MapType::GoogleTerrainChina:
-            case MapType::GoogleHybridChina:
-            {
-                qheader.setRawHeader("Referrer", "http://ditu.google.cn/");
-            }
-            break;
+    case MapType::GoogleMapChina:
+    case MapType::GoogleSatelliteChina:
+    case MapType::GoogleLabelsChina:
+    case MapType::GoogleTerrainChina:
+    case MapType::GoogleHybridChina:
+    {
+        qheader.setRawHeader("Referrer", "http://ditu.google.cn/");
+    }
+    break;
 
-            case MapType::BingHybrid:
-            case MapType::BingMap:
-            case MapType::BingSatellite:
-            {
-                qheader.setRawHeader("Referrer", "http://www.bing.com/maps/");
-            }
-            break;
+    case MapType::BingHybrid:
+    case MapType::BingMap:
+    case MapType::BingSatellite:
+    {
+        qheader.setRawHeader("Referrer", "http://www.bing.com/maps/");
+    }
+    break;
 
-            case MapType::YahooHybrid:
-            case MapType::YahooLabels:
-            case MapType::YahooMap:
-            case MapType::YahooSatellite:
-            {
-                qheader.setRawHeader("Referrer", "http://maps.yahoo.com/");
-            }
-            break;
+    case MapType::YahooHybrid:
+    case MapType::YahooLabels:
+    case MapType::YahooMap:
+    case MapType::YahooSatellite:
+    {
+        qheader.setRawHeader("Referrer", "http://maps.yahoo.com/");
+    }
+    break;
 
-            case MapType::ArcGIS_MapsLT_Map_Labels:
-            case MapType::ArcGIS_MapsLT_Map:
-            case MapType::ArcGIS_MapsLT_OrtoFoto:
-            case MapType::ArcGIS_MapsLT_Map_Hybrid:
-            {
-                qheader.setRawHeader("Referrer", "http://www.maps.lt/map_beta/");
-            }
-            break;
+    case MapType::ArcGIS_MapsLT_Map_Labels:
+    case MapType::ArcGIS_MapsLT_Map:
+    case MapType::ArcGIS_MapsLT_OrtoFoto:
+    case MapType::ArcGIS_MapsLT_Map_Hybrid:
+    {
+        qheader.setRawHeader("Referrer", "http://www.maps.lt/map_beta/");
+    }
+    break;
 
-            case MapType::OpenStreetMapSurfer:
-            case MapType::OpenStreetMapSurferTerrain:
-            {
-                qheader.setRawHeader("Referrer", "http://www.mapsurfer.net/");
-            }
-            break;
+    case MapType::OpenStreetMapSurfer:
+    case MapType::OpenStreetMapSurferTerrain:
+    {
+        qheader.setRawHeader("Referrer", "http://www.mapsurfer.net/");
+    }
+    break;
 
-            case MapType::OpenStreetMap:
-            case MapType::OpenStreetOsm:
-            {
-                qheader.setRawHeader("Referrer", "http://www.openstreetmap.org/");
-            }
-            break;
+    case MapType::OpenStreetMap:
+    case MapType::OpenStreetOsm:
+    {
+        qheader.setRawHeader("Referrer", "http://www.openstreetmap.org/");
+    }
+    break;
 
-            case MapType::YandexMapRu:
-            {
-                qheader.setRawHeader("Referrer", "http://maps.yandex.ru/");
-            }
-            break;
-            default:
-                break;
-            }
-            reply = network.get(qheader);
-            tT.start(Timeout);
-            q.exec();
+    case MapType::YandexMapRu:
+    {
+        qheader.setRawHeader("Referrer", "http://maps.yandex.ru/");
+    }
+    break;
+    default:
+        break;
+    }
+    if (!AcquireServer(tileUrl.host(), Timeout)) {
+        errorvars.lock();
+        ++diag.timeouts;
+        errorvars.unlock();
+        return ret;
+    }
+    reply = network->get(qheader);
+    connect(reply, SIGNAL(finished()), &q, SLOT(quit()));
+    tT.start(Timeout);
+    q.exec();
+    ReleaseServer(tileUrl.host());
 
-            if (!tT.isActive()) {
-                errorvars.lock();
-                ++diag.timeouts;
-                errorvars.unlock();
-                return ret;
-            }
-            tT.stop();
-            if ((reply->error() != QNetworkReply::NoError)) {
-                errorvars.lock();
-                ++diag.networkerrors;
-                errorvars.unlock();
-                reply->deleteLater();
-                return ret;
-            }
-            ret = reply->readAll();
-            reply->deleteLater(); // TODO can't this be global??
-            if (ret.isEmpty()) {
+    if (!tT.isActive()) {
+        errorvars.lock();
+        ++diag.timeouts;
+        errorvars.unlock();
+        reply->abort();
+        delete reply;
+        return ret;
+    }
+    tT.stop();
+    if ((reply->error() != QNetworkReply::NoError)) {
+        errorvars.lock();
+        ++diag.networkerrors;
+        errorvars.unlock();
+        delete reply;
+        return ret;
+    }
+    ret = reply->readAll();
+    // the manager outlives this call, replies would pile up under it until the thread ends
+    delete reply;
+    if (ret.isEmpty()) {
 #ifdef DEBUG_GMAPS
-                qDebug() << "Invalid Tile";
+        qDebug() << "Invalid Tile";
 #endif // DEBUG_GMAPS
-                errorvars.lock();
-                ++diag.emptytiles;
-                errorvars.unlock();
-                return ret;
-            }
+        errorvars.lock();
+        ++diag.emptytiles;
+        errorvars.unlock();
+        return ret;
+    }
 #ifdef DEBUG_GMAPS
-            qDebug() << "Received Tile from the Internet";
+    qDebug() << "Received Tile from the Internet";
 #endif // DEBUG_GMAPS
+    errorvars.lock();
+    ++diag.tilesFromNet;
+    errorvars.unlock();
+    return ret;
+}
+QImage OPMaps::GetDecodedImageFrom(const MapType::Types &type, const Point &pos, const int &zoom)
+{
+    RawTile tile(type, pos, zoom);
+    QImage img;
+
+    if (useMemoryCache) {
+        img = DecodedTilesInMemory.GetTile(tile);
+        if (!img.isNull()) {
             errorvars.lock();
-            ++diag.tilesFromNet;
+            ++diag.tilesFromMem;
             errorvars.unlock();
-            if (useMemoryCache) {
-#ifdef DEBUG_GMAPS
-                qDebug() << "Add Tile to memory cache";
-#endif // DEBUG_GMAPS
-                AddTileToMemoryCache(RawTile(type, pos, zoom), ret);
-            }
-            if (accessmode != AccessMode::ServerOnly) {
-#ifdef DEBUG_GMAPS
-                qDebug() << "Add tile to DataBase";
-#endif // DEBUG_GMAPS
-                CacheItemQueue *item = new CacheItemQueue(type, pos, ret, zoom);
-                TileDBcacheQueue.EnqueueCacheTask(item);
-            }
+            return img;
         }
     }
-#ifdef DEBUG_GMAPS
-    qDebug() << "Entered GetImageFrom";
-#endif // DEBUG_GMAPS
-    return ret;
+    // the loaders and the prefetcher often ask for the same tile at once, only one fetches it
+    pendingLock.lock();
+    bool waited = false;
+    while (pendingTiles.contains(tile)) {
+        pendingDone.wait(&pendingLock);
+        waited = true;
+    }
+    if (waited && useMemoryCache) {
+        img = DecodedTilesInMemory.GetTile(tile);
+        if (!img.isNull()) {
+            pendingLock.unlock();
+            return img;
+        }
+    }
+    pendingTiles.insert(tile);
+    pendingLock.unlock();
+
+    QByteArray ar = GetImageFrom(type, pos, zoom);
+    if (!ar.isEmpty()) {
+        img = PureImageProxy::ImageFromStream(ar);
+        if (useMemoryCache && !img.isNull()) {
+            DecodedTilesInMemory.AddTile(tile, img);
+        }
+    }
+
+    pendingLock.lock();
+    pendingTiles.remove(tile);
+    pendingDone.wakeAll();
+    pendingLock.unlock();
+    return img;
 }
 
 bool OPMaps::ExportToGMDB(const QString &file)
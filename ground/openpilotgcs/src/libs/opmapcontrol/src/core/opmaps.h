@@ -37,9 +37,12 @@
 #include "cacheitemqueue.h"
 #include "tilecachequeue.h"
 #include "pureimagecache.h"
+#include "pureimage.h"
 #include "alllayersoftype.h"
 #include "urlfactory.h"
 #include "diagnostics.h"
+#include <QSet>
+#include <QWaitCondition>
 
 // #include "point.h"
 
@@ -57,6 +60,14 @@ public: ~OPMaps();
 
 
     QByteArray GetImageFrom(const MapType::Types &type, const core::Point &pos, const int &zoom);
+    /**
+     * @brief Downloads a tile, bypassing and not filling any of the caches
+     */
+    QByteArray GetImageFromServer(const MapType::Types &type, const core::Point &pos, const int &zoom);
+    /**
+     * @brief Same as GetImageFrom, decoded and cached in DecodedTilesInMemory
+     */
+    QImage GetDecodedImageFrom(const MapType::Types &type, const core::Point &pos, const int &zoom);
     bool UseMemoryCache()
     {
         return useMemoryCache;
@@ -99,6 +110,9 @@ private:
     static OPMaps *m_pInstance;
     diagnostics diag;
     QMutex errorvars;
+    QMutex pendingLock;
+    QWaitCondition pendingDone;
+    QSet<RawTile> pendingTiles;
 protected:
     // MemoryCache TilesInMemory;
 };
@@ -35,6 +35,16 @@ QPixmap PureImageProxy::FromStream(const QByteArray &array)
 {
     return QPixmap::fromImage(QImage::fromData(array));
 }
+QImage PureImageProxy::ImageFromStream(const QByteArray &array)
+{
+    QImage img = QImage::fromData(array);
+
+    // indexed and 24 bit tiles are converted again on every draw otherwise
+    if (!img.isNull() && img.format() != QImage::Format_RGB32 && img.format() != QImage::Format_ARGB32_Premultiplied) {
+        img = img.convertToFormat(img.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    }
+    return img;
+}
 bool PureImageProxy::Save(const QByteArray &array, QPixmap &pic)
 {
     pic = QPixmap::fromImage(QImage::fromData(array));
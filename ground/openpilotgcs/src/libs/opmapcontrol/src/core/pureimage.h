@@ -36,6 +36,7 @@ class PureImageProxy {
 public:
     PureImageProxy();
     static QPixmap FromStream(const QByteArray &array);
+    static QImage ImageFromStream(const QByteArray &array);
     static bool Save(const QByteArray &array, QPixmap &pic);
 };
 }
@@ -31,13 +31,94 @@
 namespace core {
 qlonglong PureImageCache::ConnCounter = 0;
 
-PureImageCache::PureImageCache()
+PureImageCache::PureImageCache() : generation(0)
 {}
 
+PureImageCache::Connection::Connection(const QString &name, const QString &file, int generation) :
+    name(name), generation(generation)
+{
+    db = QSqlDatabase::addDatabase("QSQLITE", name);
+    db.setDatabaseName(file);
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=5000");
+    if (!db.open()) {
+#ifdef DEBUG_PUREIMAGECACHE
+        qDebug() << "Connection: Unable to open" << file << db.lastError().driverText();
+#endif // DEBUG_PUREIMAGECACHE
+        return;
+    }
+    {
+        // readers no longer wait for the cache writer, and the other way round
+        QSqlQuery query(db);
+        query.exec("PRAGMA journal_mode=WAL");
+        query.exec("PRAGMA synchronous=NORMAL");
+    }
+    createIndex(db);
+    selectTile     = QSqlQuery(db);
+    selectTile.prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+    insertTile     = QSqlQuery(db);
+    insertTile.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+    insertTileData = QSqlQuery(db);
+    insertTileData.prepare("INSERT INTO TilesData(id, Tile) VALUES(?, ?)");
+}
+
+PureImageCache::Connection::~Connection()
+{
+    // the queries and the handle must be gone before the connection can be removed
+    selectTile     = QSqlQuery();
+    insertTile     = QSqlQuery();
+    insertTileData = QSqlQuery();
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase(name);
+}
+
+bool PureImageCache::Connection::insert(const QByteArray &tile, const MapType::Types &type, const Point &pos, const int &zoom)
+{
+    insertTile.addBindValue(pos.X());
+    insertTile.addBindValue(pos.Y());
+    insertTile.addBindValue(zoom);
+    insertTile.addBindValue((int)type);
+    insertTile.addBindValue(QDateTime::currentDateTime().toString());
+    if (!insertTile.exec()) {
+        return false;
+    }
+    insertTileData.addBindValue(insertTile.lastInsertId());
+    insertTileData.addBindValue(tile);
+    return insertTileData.exec();
+}
+
+PureImageCache::Connection *PureImageCache::connection()
+{
+    Connection *cn = connections.localData();
+
+    if (cn && cn->generation != generation) {
+        // the cache moved since this thread last used it
+        delete cn;
+        cn = 0;
+    }
+    if (!cn) {
+        Mcounter.lock();
+        qlonglong id = ++ConnCounter;
+        Mcounter.unlock();
+        cn = new Connection(QString("PureImageCache%1").arg(id), gtilecache + "Data.qmdb", generation);
+        connections.setLocalData(cn);
+    }
+    return cn->isOpen() ? cn : 0;
+}
+
+void PureImageCache::createIndex(QSqlDatabase &db)
+{
+    // tiles are always looked up by position, without an index every lookup scans the table
+    QSqlQuery query(db);
+
+    query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+}
+
 void PureImageCache::setGtileCache(const QString &value)
 {
     lock.lockForWrite();
     gtilecache = value;
+    generation++;
     QDir d;
     if (!d.exists(gtilecache)) {
         d.mkdir(gtilecache);
@@ -154,132 +235,109 @@ bool PureImageCache::CreateEmptyDB(const QString &file)
         db.close();
         return false;
     }
+    createIndex(db);
     db.close();
     QSqlDatabase::removeDatabase(QLatin1String("CreateConn"));
     return true;
 }
 bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type, const Point &pos, const int &zoom)
 {
-    if (gtilecache.isEmpty() | gtilecache.isNull()) {
-        return false;
-    }
+    bool ret = false;
+
     lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
     qDebug() << "PutImageToCache Start:"; // <<pos;
 #endif // DEBUG_PUREIMAGECACHE
-    Mcounter.lock();
-    qlonglong id = ++ConnCounter;
-    Mcounter.unlock();
-    {
-        QSqlDatabase cn;
-        cn = QSqlDatabase::addDatabase("QSQLITE", QString::number(id));
-        QString db = gtilecache + "Data.qmdb";
-        cn.setDatabaseName(db);
-        cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-        if (cn.open()) {
-            {
-                QSqlQuery query(cn);
-                query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                query.addBindValue(pos.X());
-                query.addBindValue(pos.Y());
-                query.addBindValue(zoom);
+    Connection *cn = gtilecache.isEmpty() ? 0 : connection();
+    if (cn) {
+        ret = cn->insert(tile, type, pos, zoom);
+    }
+    lock.unlock();
+    return ret;
+}
+bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue *> &tiles)
+{
+    bool ret = false;
 
-                query.addBindValue((int)type);
-                query.addBindValue(QDateTime::currentDateTime().toString());
-                query.exec();
-            }
-            {
-                QSqlQuery query(cn);
-                query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                query.addBindValue(tile);
-                query.exec();
+    lock.lockForRead();
+    Connection *cn = gtilecache.isEmpty() ? 0 : connection();
+    if (cn) {
+        // one journal commit for all of them
+        cn->db.transaction();
+        ret = true;
+        foreach(CacheItemQueue * task, tiles) {
+            ret &= cn->insert(task->GetImg(), task->GetMapType(), task->GetPosition(), task->GetZoom());
+        }
+        cn->db.commit();
+    }
+    lock.unlock();
+    return ret;
+}
+QSet<Point> PureImageCache::CachedTiles(MapType::Types type, int zoom)
+{
+    QSet<Point> tiles;
+
+    lock.lockForRead();
+    Connection *cn = gtilecache.isEmpty() ? 0 : connection();
+    if (cn) {
+        QSqlQuery query(cn->db);
+        query.prepare("SELECT X, Y FROM Tiles WHERE Zoom=? AND Type=?");
+        query.addBindValue(zoom);
+        query.addBindValue((int)type);
+        if (query.exec()) {
+            while (query.next()) {
+                tiles.insert(Point(query.value(0).toInt(), query.value(1).toInt()));
             }
-            cn.close();
         }
     }
-    QSqlDatabase::removeDatabase(QString::number(id));
     lock.unlock();
-    return true;
+    return tiles;
 }
 QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
 {
-    lock.lockForRead();
     QByteArray ar;
-    if (gtilecache.isEmpty() | gtilecache.isNull()) {
-        return ar;
-    }
-    QString dir  = gtilecache;
-    Mcounter.lock();
-    qlonglong id = ++ConnCounter;
-    Mcounter.unlock();
+
+    lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
-    qDebug() << "Cache dir=" << dir << " Try to GET:" << pos.X() + "," + pos.Y();
+    qDebug() << "Cache dir=" << gtilecache << " Try to GET:" << pos.X() + "," + pos.Y();
 #endif // DEBUG_PUREIMAGECACHE
-
-    {
-        QString db = dir + "Data.qmdb";
-        {
-            QSqlDatabase cn;
-
-            cn = QSqlDatabase::addDatabase("QSQLITE", QString::number(id));
-
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if (cn.open()) {
-                {
-                    QSqlQuery query(cn);
-                    query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int)type));
-                    query.next();
-                    if (query.isValid()) {
-                        ar = query.value(0).toByteArray();
-                    }
-                }
-                cn.close();
-            }
+    Connection *cn = gtilecache.isEmpty() ? 0 : connection();
+    if (cn) {
+        cn->selectTile.addBindValue(pos.X());
+        cn->selectTile.addBindValue(pos.Y());
+        cn->selectTile.addBindValue(zoom);
+        cn->selectTile.addBindValue((int)type);
+        if (cn->selectTile.exec() && cn->selectTile.next()) {
+            ar = cn->selectTile.value(0).toByteArray();
         }
+        // release the read snapshot, or WAL checkpoints could not complete
+        cn->selectTile.finish();
     }
-    QSqlDatabase::removeDatabase(QString::number(id));
     lock.unlock();
     return ar;
 }
 void PureImageCache::deleteOlderTiles(int const & days)
 {
-    if (gtilecache.isEmpty() | gtilecache.isNull()) {
-        return;
-    }
     QList<long> add;
-    bool ret    = true;
-    QString dir = gtilecache;
-    {
-        QString db = dir + "Data.qmdb";
-        ret = QFileInfo(db).exists();
-        if (ret) {
-            QSqlDatabase cn;
-            Mcounter.lock();
-            qlonglong id = ++ConnCounter;
-            Mcounter.unlock();
-            cn = QSqlDatabase::addDatabase("QSQLITE", QString::number(id));
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if (cn.open()) {
-                {
-                    QSqlQuery query(cn);
-                    query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
-                    while (query.next()) {
-                        if (QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime()) > days) {
-                            add.append(query.value(0).toLongLong());
-                        }
-                    }
-                    foreach(long i, add) {
-                        query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
-                    }
-                }
 
-                cn.close();
+    lock.lockForRead();
+    Connection *cn = gtilecache.isEmpty() ? 0 : connection();
+    if (cn) {
+        QSqlQuery query(cn->db);
+        query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
+        while (query.next()) {
+            if (QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime()) > days) {
+                add.append(query.value(0).toLongLong());
             }
-            QSqlDatabase::removeDatabase(QString::number(id));
         }
+        query.finish();
+        cn->db.transaction();
+        foreach(long i, add) {
+            query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
+        }
+        cn->db.commit();
     }
+    lock.unlock();
 }
 // PureImageCache::ExportMapDataToDB("C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data.qmdb","C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data2.qmdb");
 bool PureImageCache::ExportMapDataToDB(QString sourceFile, QString destFile)
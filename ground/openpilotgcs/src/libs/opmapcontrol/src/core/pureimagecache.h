@@ -40,21 +40,52 @@
 #include <QVariant>
 #include "pureimage.h"
 #include <QList>
+#include <QSet>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include "cacheitemqueue.h"
 namespace core {
 class PureImageCache {
 public:
     PureImageCache();
     static bool CreateEmptyDB(const QString &file);
     bool PutImageToCache(const QByteArray &tile, const MapType::Types &type, const core::Point &pos, const int &zoom);
+    // Stores all the tiles in a single transaction
+    bool PutImagesToCache(const QList<CacheItemQueue *> &tiles);
     QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
+    // all the tiles of a type stored at a zoom level, in a single query
+    QSet<core::Point> CachedTiles(MapType::Types type, int zoom);
     QString GtileCache();
     void setGtileCache(const QString &value);
     static bool ExportMapDataToDB(QString sourceFile, QString destFile);
     void deleteOlderTiles(int const & days);
 private:
+    // QSqlDatabase connections can not be shared between threads,
+    // so every thread keeps its own, opened once with its statements prepared
+    struct Connection {
+        Connection(const QString &name, const QString &file, int generation);
+        ~Connection();
+        bool isOpen() const
+        {
+            return db.isOpen();
+        }
+        bool insert(const QByteArray &tile, const MapType::Types &type, const core::Point &pos, const int &zoom);
+
+        QString name;
+        int generation;
+        QSqlDatabase db;
+        QSqlQuery selectTile;
+        QSqlQuery insertTile;
+        QSqlQuery insertTileData;
+    };
+    // Connection of the calling thread to the current cache, to be called with the lock held
+    Connection *connection();
+    static void createIndex(QSqlDatabase &db);
+
     QString gtilecache;
+    int generation;
+    QThreadStorage<Connection *> connections;
     QMutex Mcounter;
     QReadWriteLock lock;
     static qlonglong ConnCounter;
@@ -42,13 +42,16 @@ void TileCacheQueue::EnqueueCacheTask(CacheItemQueue *task)
 #ifdef DEBUG_TILECACHEQUEUE
     qDebug() << "DB Do I EnqueueCacheTask" << task->GetPosition().X() << "," << task->GetPosition().Y();
 #endif // DEBUG_TILECACHEQUEUE
-    if (!tileCacheQueue.contains(task)) {
+    mutex.lock();
+    bool queued = tileCacheQueue.contains(task);
+    if (!queued) {
+        tileCacheQueue.enqueue(task);
+    }
+    mutex.unlock();
+    if (!queued) {
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug() << "EnqueueCacheTask" << task->GetPosition().X() << "," << task->GetPosition().Y();
 #endif // DEBUG_TILECACHEQUEUE
-        mutex.lock();
-        tileCacheQueue.enqueue(task);
-        mutex.unlock();
         if (this->isRunning()) {
 #ifdef DEBUG_TILECACHEQUEUE
             qDebug() << "Wake Thread";
@@ -71,22 +74,23 @@ void TileCacheQueue::run()
     qDebug() << "Cache Engine Start";
 #endif // DEBUG_TILECACHEQUEUE
     while (true) {
-        CacheItemQueue *task;
-#ifdef DEBUG_TILECACHEQUEUE
-        qDebug() << "Cache";
-#endif // DEBUG_TILECACHEQUEUE
-        if (tileCacheQueue.count() > 0) {
-            mutex.lock();
-            task = tileCacheQueue.dequeue();
-            mutex.unlock();
+        QList<CacheItemQueue *> tasks;
+        mutex.lock();
+        while (!tileCacheQueue.isEmpty() && tasks.count() < MAX_BATCH) {
+            tasks.append(tileCacheQueue.dequeue());
+        }
+        mutex.unlock();
+        if (!tasks.isEmpty()) {
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug() << "Cache engine Put:" << task->GetPosition().X() << "," << task->GetPosition().Y();
+            qDebug() << "Cache engine Put:" << tasks.count() << "tiles";
 #endif // DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(), task->GetMapType(), task->GetPosition(), task->GetZoom());
-            usleep(44);
-            delete task;
+            // all the tiles that piled up go in a single transaction
+            Cache::Instance()->ImageCache.PutImagesToCache(tasks);
+            qDeleteAll(tasks);
         } else {
+#ifdef DEBUG_TILECACHEQUEUE
             qDebug() << "Cache engine BEGIN WAIT";
+#endif // DEBUG_TILECACHEQUEUE
             waitmutex.lock();
             int tout = 4000;
             if (!waitc.wait(&waitmutex, tout)) {
@@ -100,8 +104,8 @@ void TileCacheQueue::run()
                     break;
                 }
                 mutex.unlock();
+                continue;
             }
-            qDebug() << "Cache Engine DID NOT TimeOut";
             waitmutex.unlock();
         }
     }
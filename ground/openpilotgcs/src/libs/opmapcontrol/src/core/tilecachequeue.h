@@ -49,6 +49,8 @@ public:
 protected:
     QQueue<CacheItemQueue *> tileCacheQueue;
 private:
+    // Tiles stored per transaction at most
+    static const int MAX_BATCH = 64;
     void run();
     QMutex mutex;
     QMutex waitmutex;
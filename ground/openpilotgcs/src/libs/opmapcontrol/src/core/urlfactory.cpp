@@ -49,9 +49,60 @@ UrlFactory::UrlFactory()
     isCorrectedGoogleVersions = false;
     UseGeocoderCache = true;
     UsePlacemarkCache = true;
+    defaultServerConcurrency  = 4;
 }
 UrlFactory::~UrlFactory()
 {}
+void UrlFactory::SetServerConcurrency(const QString &host, const int &value)
+{
+    serversLock.lock();
+    if (host.isEmpty()) {
+        defaultServerConcurrency = qMax(1, value);
+    } else if (value > 0) {
+        serverConcurrency.insert(host, value);
+    } else {
+        serverConcurrency.remove(host);
+    }
+    serverReleased.wakeAll();
+    serversLock.unlock();
+}
+int UrlFactory::ServerConcurrency(const QString &host)
+{
+    QMutexLocker locker(&serversLock);
+
+    return serverConcurrency.value(host, defaultServerConcurrency);
+}
+QNetworkAccessManager *UrlFactory::Network()
+{
+    if (!networks.hasLocalData()) {
+        networks.setLocalData(new QNetworkAccessManager());
+    }
+    return networks.localData();
+}
+bool UrlFactory::AcquireServer(const QString &host, const int &timeout)
+{
+    QTime time;
+
+    time.start();
+    QMutexLocker locker(&serversLock);
+    while (serverDownloads.value(host) >= serverConcurrency.value(host, defaultServerConcurrency)) {
+        int left = timeout - time.elapsed();
+        if (left <= 0 || !serverReleased.wait(&serversLock, left)) {
+            return false;
+        }
+    }
+    serverDownloads[host]++;
+    return true;
+}
+void UrlFactory::ReleaseServer(const QString &host)
+{
+    serversLock.lock();
+    if (--serverDownloads[host] <= 0) {
+        serverDownloads.remove(host);
+    }
+    serverReleased.wakeAll();
+    serversLock.unlock();
+}
 QString UrlFactory::TileXYToQuadKey(const int &tileX, const int &tileY, const int &levelOfDetail) const
 {
     QString quadKey;
@@ -473,6 +524,13 @@ QString UrlFactory::MakeImageUrl(const MapType::Types &type, const Point &pos, c
         return QString("http://%1").arg(server) + QString("0%2.maps.yandex.ru/tiles?l=map&v=%3&x=%4&y=%5&z=%6").arg(GetServerNum(pos, 4) + 1).arg(VersionYandexMap).arg(pos.X()).arg(pos.Y()).arg(zoom);
     }
     break;
+    case MapType::TerrariumElevation:
+    {
+        // https://s3.amazonaws.com/elevation-tiles-prod/terrarium/12/2138/1420.png
+
+        return QString("https://s3.amazonaws.com/elevation-tiles-prod/terrarium/%1/%2/%3.png").arg(zoom).arg(pos.X()).arg(pos.Y());
+    }
+    break;
     default:
         break;
     }
@@ -42,6 +42,9 @@
 #include "cache.h"
 #include "placemark.h"
 #include <QTextCodec>
+#include <QThreadStorage>
+#include <QWaitCondition>
+#include <QHash>
 #include "cmath"
 
 namespace core {
@@ -59,6 +62,14 @@ public:
     internals::PointLatLng GetLatLngFromGeodecoder(const QString &keywords, GeoCoderStatusCode::Types &status);
     Placemark GetPlacemarkFromGeocoder(internals::PointLatLng location);
     int Timeout;
+    /**
+     * @brief Sets how many tiles are downloaded at once from a tile server
+     *
+     * @param host server name as in the tile urls, empty to set the default of all servers
+     * @param value downloads at once, 0 to fall back to the default
+     */
+    void SetServerConcurrency(const QString &host, const int &value);
+    int ServerConcurrency(const QString &host);
 private:
     void GetSecGoogleWords(const core::Point &pos, QString &sec1, QString &sec2);
     int GetServerNum(const core::Point &pos, const int &max) const;
@@ -71,8 +82,18 @@ private:
     static const double EarthRadiusKm;
     double GetDistance(internals::PointLatLng p1, internals::PointLatLng p2);
     QMutex mutex;
+    QThreadStorage<QNetworkAccessManager *> networks;
+    QMutex serversLock;
+    QWaitCondition serverReleased;
+    QHash<QString, int> serverConcurrency;
+    QHash<QString, int> serverDownloads;
+    int defaultServerConcurrency;
 
 protected:
+    // network access of the calling thread, kept to reuse the keep-alive connections to the servers
+    QNetworkAccessManager *Network();
+    bool AcquireServer(const QString &host, const int &timeout);
+    void ReleaseServer(const QString &host);
     static short timelapse;
     QString LanguageStr;
     bool IsCorrectGoogleVersions();
@@ -33,6 +33,33 @@ qlonglong internals::Core::debugcounter = 0;
 using namespace projections;
 
 namespace internals {
+namespace {
+// Tile number of a layer, pergo maps are numbered from the bottom left
+Point LayerTilePos(MapType::Types type, const Point &pos, int maxY)
+{
+    return (type == MapType::PergoTurkeyMap) ? Point(pos.X(), maxY - pos.Y()) : pos;
+}
+
+// Gets a tile into the decoded memory cache before it is needed
+class PrefetchTask : public QRunnable {
+public:
+    PrefetchTask(const QVector<MapType::Types> &layers, const Point &pos, int zoom, int maxY) :
+        layers(layers), pos(pos), zoom(zoom), maxY(maxY)
+    {}
+    void run()
+    {
+        foreach(MapType::Types tl, layers) {
+            OPMaps::Instance()->GetDecodedImageFrom(tl, LayerTilePos(tl, pos, maxY), zoom);
+        }
+    }
+private:
+    QVector<MapType::Types> layers;
+    Point pos;
+    int zoom;
+    int maxY;
+};
+}
+
 Core::Core() : MouseWheelZooming(false), currentPosition(0, 0), currentPositionPixel(0, 0), LastLocationInBounds(-1, -1), sizeOfMapArea(0, 0)
     , minOfTiles(0, 0), maxOfTiles(0, 0), zoom(0), isDragging(false), TooltipTextPadding(10, 10), loaderLimit(5), maxzoom(21), runningThreads(0), started(false)
 {
@@ -40,6 +67,7 @@ Core::Core() : MouseWheelZooming(false), currentPosition(0, 0), currentPositionP
     SetProjection(new MercatorProjection());
     this->setAutoDelete(false);
     ProcessLoadTaskCallback.setMaxThreadCount(10);
+    PrefetchPool.setMaxThreadCount(2);
     renderOffset = Point(0, 0);
     dragPoint    = Point(0, 0);
     CanDragMap   = true;
@@ -48,6 +76,8 @@ Core::Core() : MouseWheelZooming(false), currentPosition(0, 0), currentPositionP
 }
 Core::~Core()
 {
+    PrefetchPool.clear();
+    PrefetchPool.waitForDone();
     ProcessLoadTaskCallback.waitForDone();
 }
 
@@ -70,9 +100,9 @@ void Core::run()
     MtileLoadQueue.lock();
     {
         if (tileLoadQueue.count() > 0) {
-            task = tileLoadQueue.dequeue();
+            task = tileLoadQueue.takeAt(NextLoadTask());
+            loadsInFlight.append(task);
             {
-                last = (tileLoadQueue.count() == 0);
 #ifdef DEBUG_CORE
                 qDebug() << "TileLoadQueue: " << tileLoadQueue.count() << " Point:" << task.Pos.ToString() << " ID=" << debug;;
 #endif // DEBUG_CORE
@@ -109,27 +139,27 @@ void Core::run()
                             int retry = 0;
 
                             do {
-                                QByteArray img;
+                                QImage img;
 
                                 // tile number inversion(BottomLeft -> TopLeft) for pergo maps
                                 if (tl == MapType::PergoTurkeyMap) {
-                                    img = OPMaps::Instance()->GetImageFrom(tl, Point(task.Pos.X(), maxOfTiles.Height() - task.Pos.Y()), task.Zoom);
+                                    img = OPMaps::Instance()->GetDecodedImageFrom(tl, Point(task.Pos.X(), maxOfTiles.Height() - task.Pos.Y()), task.Zoom);
                                 } else { // ok
 #ifdef DEBUG_CORE
                                     qDebug() << "start getting image" << " ID=" << debug;
 #endif // DEBUG_CORE
-                                    img = OPMaps::Instance()->GetImageFrom(tl, task.Pos, task.Zoom);
+                                    img = OPMaps::Instance()->GetDecodedImageFrom(tl, task.Pos, task.Zoom);
 #ifdef DEBUG_CORE
-                                    qDebug() << "Core::run:gotimage size:" << img.count() << " ID=" << debug << " time=" << t.elapsed();
+                                    qDebug() << "Core::run:gotimage size:" << img.byteCount() << " ID=" << debug << " time=" << t.elapsed();
 #endif // DEBUG_CORE
                                 }
 
-                                if (img.length() != 0) {
+                                if (!img.isNull()) {
                                     Moverlays.lock();
                                     {
                                         t->Overlays.append(img);
 #ifdef DEBUG_CORE
-                                        qDebug() << "Core::run append img:" << img.length() << " to tile:" << t->GetPos().ToString() << " now has " << t->Overlays.count() << " overlays" << " ID=" << debug;
+                                        qDebug() << "Core::run append img:" << img.byteCount() << " to tile:" << t->GetPos().ToString() << " now has " << t->Overlays.count() << " overlays" << " ID=" << debug;
 #endif // DEBUG_CORE
                                     }
                                     Moverlays.unlock();
@@ -170,6 +200,13 @@ void Core::run()
                 }
 
 
+                MtileLoadQueue.lock();
+                {
+                    loadsInFlight.removeOne(task);
+                    last = tileLoadQueue.isEmpty() && loadsInFlight.isEmpty();
+                }
+                MtileLoadQueue.unlock();
+
                 {
                     // last buddy cleans stuff ;}
                     if (last) {
@@ -196,6 +233,10 @@ void Core::run()
 #endif
             emit OnTilesStillToLoad(tilesToload < 0 ? 0 : tilesToload);
             loaderLimit.release();
+        } else {
+            MtileLoadQueue.lock();
+            loadsInFlight.removeOne(task);
+            MtileLoadQueue.unlock();
         }
     }
     MrunningThreads.lock();
@@ -539,6 +580,7 @@ void Core::Drag(Point const & pt)
 void Core::CancelAsyncTasks()
 {
     if (started) {
+        PrefetchPool.clear();
         ProcessLoadTaskCallback.waitForDone();
         MtileLoadQueue.lock();
         {
@@ -565,28 +607,106 @@ void Core::UpdateBounds()
         emit OnTileLoadStart();
 
 
-        foreach(Point p, tileDrawingList) {
-            LoadTask task = LoadTask(p, Zoom());
-            {
-                MtileLoadQueue.lock();
-                {
-                    if (!tileLoadQueue.contains(task)) {
-                        MtileToload.lock();
-                        ++tilesToload;
-                        MtileToload.unlock();
-                        tileLoadQueue.enqueue(task);
+        MtileLoadQueue.lock();
+        {
+            loadCenter = centerTileXYLocation;
+            // tiles that left the view are not worth loading anymore
+            for (int i = tileLoadQueue.count() - 1; i >= 0; i--) {
+                if (tileLoadQueue.at(i).Zoom != Zoom() || !tileDrawingList.contains(tileLoadQueue.at(i).Pos)) {
+                    tileLoadQueue.removeAt(i);
+                    MtileToload.lock();
+                    --tilesToload;
+                    MtileToload.unlock();
+                }
+            }
+            foreach(Point p, tileDrawingList) {
+                LoadTask task = LoadTask(p, Zoom());
+                // one request per tile, whether it is queued, loading or loaded already
+                if (!tileLoadQueue.contains(task) && !loadsInFlight.contains(task) && Matrix.TileAt(p) == 0) {
+                    MtileToload.lock();
+                    ++tilesToload;
+                    MtileToload.unlock();
+                    tileLoadQueue.enqueue(task);
 #ifdef DEBUG_CORE
-                        qDebug() << "Core::UpdateBounds new Task" << task.Pos.ToString();
+                    qDebug() << "Core::UpdateBounds new Task" << task.Pos.ToString();
 #endif // DEBUG_CORE
-                        ProcessLoadTaskCallback.start(this);
-                    }
+                    ProcessLoadTaskCallback.start(this);
                 }
-                MtileLoadQueue.unlock();
             }
         }
+        MtileLoadQueue.unlock();
     }
     MtileDrawingList.unlock();
     UpdateGroundResolution();
+    Prefetch();
+}
+void Core::Prefetch()
+{
+    // whatever was queued for the previous view is not needed anymore
+    PrefetchPool.clear();
+    if (!OPMaps::Instance()->UseMemoryCache()) {
+        return;
+    }
+    QVector<MapType::Types> layers = OPMaps::Instance()->GetAllLayersOfType(GetMapType());
+    int w = sizeOfMapArea.Width();
+    int h = sizeOfMapArea.Height();
+
+    // the ring just outside of the view first, panning is more frequent than zooming
+    for (int i = -w - 1; i <= w + 1; i++) {
+        for (int j = -h - 1; j <= h + 1; j++) {
+            if (qAbs(i) > w || qAbs(j) > h) {
+                PrefetchAt(layers, Point(centerTileXYLocation.X() + i, centerTileXYLocation.Y() + j), Zoom(), 2);
+            }
+        }
+    }
+    // the view one zoom level out
+    if (Zoom() > 0) {
+        for (int i = -(w + 1) / 2; i <= (w + 1) / 2; i++) {
+            for (int j = -(h + 1) / 2; j <= (h + 1) / 2; j++) {
+                PrefetchAt(layers, Point(centerTileXYLocation.X() / 2 + i, centerTileXYLocation.Y() / 2 + j), Zoom() - 1, 1);
+            }
+        }
+    }
+    // and one zoom level in, centered
+    if (Zoom() < MaxZoom()) {
+        for (int i = -w; i <= w; i++) {
+            for (int j = -h; j <= h; j++) {
+                PrefetchAt(layers, Point(centerTileXYLocation.X() * 2 + i, centerTileXYLocation.Y() * 2 + j), Zoom() + 1, 0);
+            }
+        }
+    }
+}
+void Core::PrefetchAt(const QVector<MapType::Types> &layers, const Point &pos, int zoom, int priority)
+{
+    Size min = Projection()->GetTileMatrixMinXY(zoom);
+    Size max = Projection()->GetTileMatrixMaxXY(zoom);
+
+    if (pos.X() < min.Width() || pos.Y() < min.Height() || pos.X() > max.Width() || pos.Y() > max.Height()) {
+        return;
+    }
+    bool cached = true;
+    foreach(MapType::Types tl, layers) {
+        cached &= OPMaps::Instance()->DecodedTilesInMemory.Contains(RawTile(tl, LayerTilePos(tl, pos, max.Height()), zoom));
+    }
+    if (!cached) {
+        PrefetchPool.start(new PrefetchTask(layers, pos, zoom, max.Height()), priority);
+    }
+}
+int Core::NextLoadTask()
+{
+    int next = 0;
+    qint64 nextDistance = -1;
+
+    for (int i = 0; i < tileLoadQueue.count(); i++) {
+        qint64 dx = tileLoadQueue.at(i).Pos.X() - loadCenter.X();
+        qint64 dy = tileLoadQueue.at(i).Pos.Y() - loadCenter.Y();
+        qint64 distance = dx * dx + dy * dy;
+        if (nextDistance < 0 || distance < nextDistance) {
+            next = i;
+            nextDistance = distance;
+        }
+    }
+    return next;
 }
 void Core::FindTilesAround(QList<Point> &list)
 {
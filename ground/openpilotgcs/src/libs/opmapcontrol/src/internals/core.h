@@ -294,6 +294,8 @@ public:
 
     void FindTilesAround(QList<core::Point> &list);
 
+    void Prefetch();
+
     void UpdateGroundResolution();
 
     TileMatrix Matrix;
@@ -344,6 +346,12 @@ private:
     Rectangle CurrentRegion;
 
     QQueue<LoadTask> tileLoadQueue;
+    // tiles taken from tileLoadQueue and not loaded yet
+    QList<LoadTask> loadsInFlight;
+    // view center the load queue is served around
+    core::Point loadCenter;
+    // index of the queued task closest to loadCenter, MtileLoadQueue must be held
+    int NextLoadTask();
 
     int zoom;
 
@@ -367,6 +375,9 @@ private:
     QSemaphore loaderLimit;
 
     QThreadPool ProcessLoadTaskCallback;
+    // decodes the tiles next to the view and at the zooms around it
+    QThreadPool PrefetchPool;
+    void PrefetchAt(const QVector<MapType::Types> &layers, const core::Point &pos, int zoom, int priority);
     QMutex MtileToload;
     int tilesToload;
 
@@ -152,6 +152,39 @@ public:
         core::OPMaps::Instance()->TilesInMemory.setMemoryCacheCapacity(value);
     }
 
+    /**
+     * @brief  Returns the currently used memory for decoded tiles
+     *
+     * @return
+     */
+    double DecodedTileMemoryUsed() const
+    {
+        return core::OPMaps::Instance()->DecodedTilesInMemory.Size();
+    }
+
+    /**
+     * @brief  Sets the size of the memory for decoded tiles
+     *
+     * @param  value size in Mb to use for decoded tiles
+     * @return
+     */
+    void SetDecodedTileMemorySize(int const & value)
+    {
+        core::OPMaps::Instance()->DecodedTilesInMemory.setCapacity(value);
+    }
+
+    /**
+     * @brief  Sets how many tiles are downloaded at once from a tile server
+     *
+     * @param  host server name as in the tile urls, empty for the default of all servers
+     * @param  value downloads at once, 0 to use the default again
+     * @return
+     */
+    void SetServerConcurrency(QString const & host, int const & value)
+    {
+        core::OPMaps::Instance()->SetServerConcurrency(host, value);
+    }
+
     /**
      * @brief Sets the location for the SQLite Database used for caching and the geocoding cache files
      *
@@ -105,6 +105,13 @@ public:
     double Zoom();
     double ZoomDigi();
     double ZoomTotal();
+    /**
+     * @brief Scale the tiles of the current zoom step are drawn with, 1 unless zoomed between steps or beyond the max zoom
+     */
+    qreal RenderTransform() const
+    {
+        return MapRenderTransform;
+    }
     void setOverlayOpacity(qreal value);
 protected:
     void mouseMoveEvent(QGraphicsSceneMouseEvent *event);
@@ -52,3 +52,7 @@ void MapRipForm::SetNumberOfTiles(const int &total, const int &actual)
 {
     ui->statuslabel->setText(QString(tr("Downloading tile %1 of %2")).arg(actual).arg(total));
 }
+void MapRipForm::SetThroughput(const double &tilesPerSecond)
+{
+    ui->ratelabel->setText(QString(tr("%1 tiles/s")).arg(tilesPerSecond, 0, 'f', 1));
+}
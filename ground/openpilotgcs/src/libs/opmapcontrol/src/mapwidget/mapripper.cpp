@@ -25,8 +25,24 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 #include "mapripper.h"
+#include <QThreadPool>
 namespace mapcontrol {
-MapRipper::MapRipper(internals::Core *core, const internals::RectLatLng & rect) : sleep(100), cancel(false), progressForm(0), core(core), yesToAll(false)
+namespace {
+class RipFetcher : public QRunnable {
+public:
+    RipFetcher(MapRipper *ripper, const QVector<core::MapType::Types> &types) : ripper(ripper), types(types)
+    {}
+    void run()
+    {
+        ripper->fetchTiles(types);
+    }
+private:
+    MapRipper *ripper;
+    QVector<core::MapType::Types> types;
+};
+}
+
+MapRipper::MapRipper(internals::Core *core, const internals::RectLatLng & rect) : next(0), done(0), failed(0), fetchers(0), cancel(false), progressForm(0), core(core), yesToAll(false)
 {
     if (!rect.IsEmpty()) {
         type    = core->GetMapType();
@@ -42,6 +58,7 @@ MapRipper::MapRipper(internals::Core *core, const internals::RectLatLng & rect)
         connect(this, SIGNAL(percentageChanged(int)), progressForm, SLOT(SetPercentage(int)));
         connect(this, SIGNAL(numberOfTilesChanged(int, int)), progressForm, SLOT(SetNumberOfTiles(int, int)));
         connect(this, SIGNAL(providerChanged(QString, int)), progressForm, SLOT(SetProvider(QString, int)));
+        connect(this, SIGNAL(throughputChanged(double)), progressForm, SLOT(SetThroughput(double)));
         connect(this, SIGNAL(finished()), this, SLOT(finish()));
         emit numberOfTilesChanged(0, 0);
     } else
@@ -91,44 +108,103 @@ void MapRipper::finish()
 
 void MapRipper::run()
 {
-    int countOk   = 0;
-    bool goodtile = false;
-
-    // Stuff.Shuffle<Point>(ref list);
     QVector<core::MapType::Types> types = OPMaps::Instance()->GetAllLayersOfType(type);
     int all = points.count();
-    for (int i = 0; i < all; i++) {
-        emit numberOfTilesChanged(all, i + 1);
-        if (cancel) {
-            break;
+
+    // whatever is stored already is skipped, which also resumes an interrupted rip
+    QList<QSet<core::Point> > cached;
+    foreach(core::MapType::Types type, types) {
+        cached.append(Cache::Instance()->ImageCache.CachedTiles(type, zoom));
+    }
+    pending.clear();
+    foreach(core::Point p, points) {
+        for (int i = 0; i < cached.count(); i++) {
+            if (!cached[i].contains(p)) {
+                pending.append(p);
+                break;
+            }
         }
+    }
+    next     = 0;
+    done     = all - pending.count();
+    failed   = 0;
+    fetchers = THREADS;
+    int skipped = done;
+    emit providerChanged(core::MapType::StrByType(type), zoom);
+    emit numberOfTilesChanged(all, done);
 
-        core::Point p = points[i];
-        {
-            // qDebug()<<"offline fetching:"<<p.ToString();
-            foreach(core::MapType::Types type, types) {
-                emit providerChanged(core::MapType::StrByType(type), zoom);
-                QByteArray img = OPMaps::Instance()->GetImageFrom(type, p, zoom);
+    QThreadPool pool;
+    pool.setMaxThreadCount(THREADS);
+    for (int i = 0; i < THREADS; i++) {
+        pool.start(new RipFetcher(this, types));
+    }
+
+    QTime time;
+    time.start();
+    bool running = true;
+    while (running) {
+        QList<core::CacheItemQueue *> batch;
+        mutex.lock();
+        if (fetchers > 0 && fetched.count() < BATCH_SIZE) {
+            fetchedCondition.wait(&mutex, 1000);
+        }
+        batch.swap(fetched);
+        int actual = done;
+        running = (fetchers > 0) || !fetched.isEmpty();
+        mutex.unlock();
 
-                if (img.length() != 0) {
-                    goodtile = true;
-                    img = NULL;
-                } else {
-                    goodtile = false;
+        // one transaction for the whole batch
+        if (!batch.isEmpty()) {
+            Cache::Instance()->ImageCache.PutImagesToCache(batch);
+            qDeleteAll(batch);
+        }
+        emit numberOfTilesChanged(all, actual);
+        emit percentageChanged(all > 0 ? (int)(actual * 100 / all) : 100);
+        if (time.elapsed() > 0) {
+            emit throughputChanged((actual - skipped) * 1000.0 / time.elapsed());
+        }
+    }
+    pool.waitForDone();
+}
+
+void MapRipper::fetchTiles(const QVector<core::MapType::Types> &types)
+{
+    forever {
+        mutex.lock();
+        if (cancel || next >= pending.count()) {
+            --fetchers;
+            fetchedCondition.wakeAll();
+            mutex.unlock();
+            return;
+        }
+        core::Point p = pending.at(next++);
+        mutex.unlock();
+
+        QList<core::CacheItemQueue *> tiles;
+        foreach(core::MapType::Types type, types) {
+            QByteArray img;
+            for (int retry = 0; img.isEmpty() && retry < RETRIES && !cancel; retry++) {
+                img = OPMaps::Instance()->GetImageFromServer(type, p, zoom);
+                if (img.isEmpty()) {
+                    QThread::msleep(1000);
                 }
             }
-            if (goodtile) {
-                countOk++;
-            } else {
-                i--;
-                QThread::msleep(1000);
-                continue;
+            if (img.isEmpty()) {
+                break;
             }
+            tiles.append(new core::CacheItemQueue(type, p, img, zoom));
         }
-        emit percentageChanged((int)((i + 1) * 100 / all)); // , i+1);
-        // worker.ReportProgress((int) ((i+1)*100/all), i+1);
 
-        QThread::msleep(sleep);
+        mutex.lock();
+        // tiles missing a layer are fetched again by the next rip of the area
+        if (tiles.count() == types.count()) {
+            ++done;
+        } else {
+            ++failed;
+        }
+        fetched.append(tiles);
+        fetchedCondition.wakeAll();
+        mutex.unlock();
     }
 }
 
@@ -32,17 +32,30 @@
 #include "mapripform.h"
 #include <QObject>
 #include <QMessageBox>
+#include <QWaitCondition>
 namespace mapcontrol {
 class MapRipper : public QThread {
     Q_OBJECT
 public:
     MapRipper(internals::Core *, internals::RectLatLng const &);
     void run();
+    void fetchTiles(const QVector<core::MapType::Types> &types);
 private:
+    static const int THREADS    = 4;
+    static const int BATCH_SIZE = 64;
+    static const int RETRIES    = 3;
     QList<core::Point> points;
+    // tiles of points not in the cache yet, next is the first one not taken by a fetcher
+    QList<core::Point> pending;
+    int next;
+    // downloaded tiles waiting to be stored
+    QList<core::CacheItemQueue *> fetched;
+    int done;
+    int failed;
+    int fetchers;
+    QWaitCondition fetchedCondition;
     int zoom;
     core::MapType::Types type;
-    int sleep;
     internals::RectLatLng area;
     bool cancel;
     MapRipForm *progressForm;
@@ -55,6 +68,7 @@ signals:
     void percentageChanged(int const & perc);
     void numberOfTilesChanged(int const & total, int const & actual);
     void providerChanged(QString const & prov, int const & zoom);
+    void throughputChanged(double const & tilesPerSecond);
 
 
 public slots:
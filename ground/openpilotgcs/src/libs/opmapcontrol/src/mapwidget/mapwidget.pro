@@ -15,6 +15,7 @@ SOURCES += mapgraphicitem.cpp \
     mapripform.cpp \
     mapripper.cpp \
     traillineitem.cpp \
+    trailpathitem.cpp \
     waypointline.cpp \
     waypointcircle.cpp
 
@@ -42,12 +43,14 @@ HEADERS += mapgraphicitem.h \
     mapripform.h \
     mapripper.h \
     traillineitem.h \
+    trailpathitem.h \
     waypointline.h \
     waypointcircle.h
 QT += opengl
 QT += network
 QT += sql
 QT += svg
+QT += concurrent
 RESOURCES += mapresources.qrc
 
 FORMS += \
@@ -32,6 +32,7 @@
 #include "../core/maptype.h"
 #include "../core/languagetype.h"
 #include "../core/diagnostics.h"
+#include "../core/elevation.h"
 #include "configuration.h"
 #include <QObject>
 #include <QtOpenGL/QGLWidget>
@@ -522,6 +523,17 @@ public:
     void WPDelete(int number);
     WayPointItem *WPFind(int number);
     void setSelectedWP(QList<WayPointItem *> list);
+    /**
+     * @brief Terrain heights above mean sea level of the points, in metres,
+     *        NaN where unknown. Runs on a worker pool, the elevation tiles are
+     *        cached with the map tiles.
+     *
+     * @param points the coordinates in LatLng
+     */
+    static QFuture<QVector<double> > TerrainHeights(QVector<internals::PointLatLng> const & points)
+    {
+        return core::Elevation::Instance()->Query(points);
+    }
 private:
     internals::Core *core;
     MapGraphicItem *map;
@@ -0,0 +1,256 @@
+/**
+ ******************************************************************************
+ *
+ * @file       trailpathitem.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      A graphicsItem drawing a whole trail
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "trailpathitem.h"
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsSceneHoverEvent>
+#include <QtCore/qmath.h>
+
+namespace mapcontrol {
+namespace {
+// Douglas-Peucker, marks the points of in that are kept
+void douglasPeucker(const QVector<QPointF> &in, qreal tolerance, QVector<bool> &keep)
+{
+    QVector<QPair<int, int> > stack;
+
+    keep.fill(false, in.count());
+    if (in.isEmpty()) {
+        return;
+    }
+    keep[0] = keep[in.count() - 1] = true;
+    stack.append(qMakePair(0, in.count() - 1));
+    while (!stack.isEmpty()) {
+        QPair<int, int> range = stack.takeLast();
+        QPointF a  = in[range.first];
+        QPointF ab = in[range.second] - a;
+        qreal len  = qSqrt(ab.x() * ab.x() + ab.y() * ab.y());
+        qreal maxDistance = 0;
+        int farthest = -1;
+        for (int i = range.first + 1; i < range.second; i++) {
+            QPointF ap = in[i] - a;
+            qreal distance = (len > 0) ? qAbs(ab.x() * ap.y() - ab.y() * ap.x()) / len : qSqrt(ap.x() * ap.x() + ap.y() * ap.y());
+            if (distance > maxDistance) {
+                maxDistance = distance;
+                farthest    = i;
+            }
+        }
+        if (farthest >= 0 && maxDistance > tolerance) {
+            keep[farthest] = true;
+            stack.append(qMakePair(range.first, farthest));
+            stack.append(qMakePair(farthest, range.second));
+        }
+    }
+}
+}
+
+TrailPathItem::TrailPathItem(QColor const & dotColor, QColor const & lineColor, MapGraphicItem *map) : QGraphicsItem(map), m_map(map),
+    m_dotBrush(dotColor), showDots(true), showLine(true), capacity(100000), zoom(-1)
+{
+    m_linePen = QPen(lineColor);
+    m_linePen.setCosmetic(true);
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+    setAcceptHoverEvents(true);
+    setAcceptedMouseButtons(Qt::NoButton);
+}
+
+int TrailPathItem::type() const
+{
+    return Type;
+}
+
+QRectF TrailPathItem::boundingRect() const
+{
+    return bounds;
+}
+
+void TrailPathItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+
+    // dots keep their size when the map is zoomed in digitally
+    qreal r = 2.0 / scale();
+    foreach(const Chunk &chunk, chunks) {
+        if (!option->exposedRect.intersects(chunk.bounds)) {
+            continue;
+        }
+        if (showLine) {
+            painter->setPen(m_linePen);
+            painter->drawPolyline(chunk.line);
+        }
+        if (showDots) {
+            painter->setPen(QPen());
+            painter->setBrush(m_dotBrush);
+            foreach(const QPointF &p, chunk.dots) {
+                painter->drawEllipse(p, r, r);
+            }
+        }
+    }
+}
+
+void TrailPathItem::AddPoint(internals::PointLatLng const & coord, int const & altitude)
+{
+    TrailPoint p;
+
+    p.coord    = coord;
+    p.altitude = altitude;
+    p.time     = QDateTime::currentDateTime();
+    if (chunks.isEmpty()) {
+        origin     = coord;
+        zoom       = (int)m_map->Zoom();
+        projection = m_map->Projection()->Type();
+    }
+    if (chunks.isEmpty() || chunks.last().points.count() >= CHUNK_SIZE) {
+        Chunk chunk;
+        // the first point of a chunk repeats the last one of the previous chunk, or the line would have gaps
+        if (!chunks.isEmpty()) {
+            chunk.points.append(chunks.last().points.last());
+        }
+        chunks.append(chunk);
+        while (chunks.count() > 1 && chunks.count() * CHUNK_SIZE > capacity) {
+            chunks.removeFirst();
+        }
+    }
+    chunks.last().points.append(p);
+    simplify(chunks.last());
+    updateBounds();
+    RefreshPos();
+}
+
+void TrailPathItem::Clear()
+{
+    prepareGeometryChange();
+    chunks.clear();
+    bounds = QRectF();
+}
+
+void TrailPathItem::SetShowDots(bool const & value)
+{
+    showDots = value;
+    update();
+}
+
+void TrailPathItem::SetShowLine(bool const & value)
+{
+    showLine = value;
+    update();
+}
+
+void TrailPathItem::SetCapacity(int const & points)
+{
+    capacity = qMax(points, CHUNK_SIZE);
+    if (chunks.count() * CHUNK_SIZE > capacity) {
+        while (chunks.count() > 1 && chunks.count() * CHUNK_SIZE > capacity) {
+            chunks.removeFirst();
+        }
+        updateBounds();
+    }
+}
+
+void TrailPathItem::simplify(Chunk &chunk)
+{
+    core::Point o = m_map->Projection()->FromLatLngToPixel(origin, zoom);
+    QVector<QPointF> px;
+
+    px.reserve(chunk.points.count());
+    foreach(const TrailPoint &p, chunk.points) {
+        core::Point w = m_map->Projection()->FromLatLngToPixel(p.coord, zoom);
+        px.append(QPointF(w.X() - o.X(), w.Y() - o.Y()));
+    }
+    // half a pixel off the real track is not visible
+    QVector<bool> keep;
+    douglasPeucker(px, 0.5, keep);
+    chunk.line.clear();
+    chunk.dots.clear();
+    chunk.dotPoints.clear();
+    for (int i = 0; i < px.count(); i++) {
+        if (keep[i]) {
+            chunk.line.append(px[i]);
+        }
+        // one dot for all the points under its 4 pixels
+        QPointF d = chunk.dots.isEmpty() ? QPointF() : px[i] - chunk.dots.last();
+        if (chunk.dots.isEmpty() || qAbs(d.x()) >= 4 || qAbs(d.y()) >= 4) {
+            chunk.dots.append(px[i]);
+            chunk.dotPoints.append(i);
+        }
+    }
+    chunk.bounds = chunk.line.boundingRect().adjusted(-3, -3, 3, 3);
+}
+
+void TrailPathItem::updateBounds()
+{
+    QRectF r;
+
+    foreach(const Chunk &chunk, chunks) {
+        r |= chunk.bounds;
+    }
+    if (r != bounds) {
+        prepareGeometryChange();
+        bounds = r;
+    }
+    update();
+}
+
+void TrailPathItem::RefreshPos()
+{
+    if (chunks.isEmpty()) {
+        return;
+    }
+    int z = (int)m_map->Zoom();
+    if (z != zoom || m_map->Projection()->Type() != projection) {
+        zoom       = z;
+        projection = m_map->Projection()->Type();
+        for (int i = 0; i < chunks.count(); i++) {
+            simplify(chunks[i]);
+        }
+        updateBounds();
+    }
+    // item coordinates are pixels at zoom, the digital zoom of the map scales them
+    core::Point p = m_map->FromLatLngToLocal(origin);
+    setPos(p.X(), p.Y());
+    setScale(m_map->RenderTransform());
+}
+
+void TrailPathItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
+{
+    qreal r = 4.0 / scale();
+
+    foreach(const Chunk &chunk, chunks) {
+        if (!chunk.bounds.contains(event->pos())) {
+            continue;
+        }
+        for (int i = 0; i < chunk.dots.count(); i++) {
+            QPointF d = chunk.dots[i] - event->pos();
+            if (qAbs(d.x()) < r && qAbs(d.y()) < r) {
+                const TrailPoint &p = chunk.points[chunk.dotPoints[i]];
+                QString coord_str   = " " + QString::number(p.coord.Lat(), 'f', 6) + "   " + QString::number(p.coord.Lng(), 'f', 6);
+                setToolTip(QString(tr("Position:") + "%1\n" + tr("Altitude:") + "%2\n" + tr("Time:") + "%3").arg(coord_str).arg(QString::number(p.altitude)).arg(p.time.toString()));
+                return;
+            }
+        }
+    }
+    setToolTip(QString());
+}
+}
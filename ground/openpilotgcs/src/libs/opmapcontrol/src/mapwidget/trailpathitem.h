@@ -0,0 +1,105 @@
+/**
+ ******************************************************************************
+ *
+ * @file       trailpathitem.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      A graphicsItem drawing a whole trail
+ * @see        The GNU Public License (GPL) Version 3
+ * @defgroup   OPMapWidget
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TRAILPATHITEM_H
+#define TRAILPATHITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QDateTime>
+#include <QPolygonF>
+#include "../internals/pointlatlng.h"
+#include <QObject>
+#include "mapgraphicitem.h"
+
+namespace mapcontrol {
+/**
+ * @brief The trail dots and the trail line of an item, as a single graphics item
+ *
+ * Points are kept in chunks, the oldest chunk is dropped once the trail holds
+ * more points than its capacity. Each chunk is simplified for the current zoom
+ * level and only those in view are drawn, so the cost of a frame does not grow
+ * with the length of the flight.
+ */
+class TrailPathItem : public QObject, public QGraphicsItem {
+    Q_OBJECT Q_INTERFACES(QGraphicsItem)
+public:
+    enum { Type = UserType + 10 };
+    TrailPathItem(QColor const & dotColor, QColor const & lineColor, MapGraphicItem *map);
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget);
+    QRectF boundingRect() const;
+    int type() const;
+
+    void AddPoint(internals::PointLatLng const & coord, int const & altitude);
+    void Clear();
+    void SetShowDots(bool const & value);
+    void SetShowLine(bool const & value);
+    /**
+     * @brief Sets how many points are kept, the oldest ones are dropped first
+     */
+    void SetCapacity(int const & points);
+    int Capacity() const
+    {
+        return capacity;
+    }
+protected:
+    void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
+private:
+    struct TrailPoint {
+        internals::PointLatLng coord;
+        int altitude;
+        QDateTime time;
+    };
+    struct Chunk {
+        QVector<TrailPoint> points;
+        // in pixels at zoom, relative to the origin of the trail
+        QPolygonF line;
+        QPolygonF dots;
+        QVector<int> dotPoints;
+        QRectF bounds;
+    };
+    static const int CHUNK_SIZE = 256;
+    void simplify(Chunk &chunk);
+    void updateBounds();
+
+    MapGraphicItem *m_map;
+    QBrush m_dotBrush;
+    QPen m_linePen;
+    bool showDots;
+    bool showLine;
+    int capacity;
+    QList<Chunk> chunks;
+    internals::PointLatLng origin;
+    // the chunks are simplified for this zoom and projection
+    int zoom;
+    QString projection;
+    QRectF bounds;
+public slots:
+    void RefreshPos();
+};
+}
+#endif // TRAILPATHITEM_H
@@ -1,2 +1,10 @@
 LIBS *= -l$$qtLibraryName(Qwt)
 
+include(qwtconfig.pri)
+
+# Users of the library see the same optional canvases it was built with
+contains(QWT_CONFIG, QwtOpenGL) {
+    QT *= opengl
+} else {
+    DEFINES *= QWT_NO_OPENGL
+}
@@ -24,6 +24,7 @@
 
 #include "cachedsvgitem.h"
 #include <QDebug>
+#include <qmath.h>
 
 #ifndef GL_CLAMP_TO_EDGE
 #define GL_CLAMP_TO_EDGE 0x812F
@@ -55,19 +56,55 @@ CachedSvgItem::~CachedSvgItem()
     }
 }
 
+bool CachedSvgItem::isCacheValid(qreal scale) const
+{
+    return qFuzzyCompare(scale, m_scale) && m_elementId == elementId() && m_size == boundingRect().size();
+}
+
+QImage CachedSvgItem::render(const QPainter *painter, const QStyleOptionGraphicsItem *option, int width, int height)
+{
+    QRectF br = boundingRect();
+    QImage img(width, height, QImage::Format_ARGB32_Premultiplied);
+
+    img.fill(Qt::transparent);
+    QPainter p;
+    p.begin(&img);
+    p.setRenderHints(painter->renderHints());
+    p.scale(m_scale, m_scale);
+    p.translate(-br.topLeft());
+    QGraphicsSvgItem::paint(&p, option, 0);
+    p.end();
+
+    m_elementId = elementId();
+    m_size = br.size();
+    return img;
+}
+
 void CachedSvgItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
+    QRectF br = boundingRect();
+    QTransform transform = painter->worldTransform();
+    // Physical pixels, so that the cache is sharp on high DPI screens
+    qreal sceneScale     = transform.map(QLineF(0, 0, 1, 0)).length() * painter->device()->devicePixelRatio();
+
     if (painter->paintEngine()->type() != QPaintEngine::OpenGL &&
         painter->paintEngine()->type() != QPaintEngine::OpenGL2) {
-        // Fallback to direct painting
-        QGraphicsSvgItem::paint(painter, option, widget);
+        if (sceneScale <= 0) {
+            QGraphicsSvgItem::paint(painter, option, widget);
+            return;
+        }
+        // Raster engine, the transformed image is still much cheaper than the SVG
+        if (m_image.isNull() || !isCacheValid(sceneScale)) {
+            m_scale = sceneScale;
+            m_image = render(painter, option, qCeil(br.width() * m_scale), qCeil(br.height() * m_scale));
+        }
+        bool smooth = painter->testRenderHint(QPainter::SmoothPixmapTransform);
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+        painter->drawImage(br, m_image);
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, smooth);
         return;
     }
 
-    QRectF br = boundingRect();
-    QTransform transform    = painter->worldTransform();
-    qreal sceneScale        = transform.map(QLineF(0, 0, 1, 0)).length();
-
     bool stencilTestEnabled = glIsEnabled(GL_STENCIL_TEST);
     bool scissorTestEnabled = glIsEnabled(GL_SCISSOR_TEST);
 
@@ -88,7 +125,7 @@ void CachedSvgItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *opt
         dirty     = true;
     }
 
-    if (!qFuzzyCompare(sceneScale, m_scale)) {
+    if (!isCacheValid(sceneScale)) {
         m_scale = sceneScale;
         dirty   = true;
     }
@@ -99,19 +136,7 @@ void CachedSvgItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *opt
     if (dirty) {
         // qDebug() << "re-render image";
 
-        QImage img(textureWidth, textureHeight, QImage::Format_ARGB32);
-        {
-            img.fill(Qt::transparent);
-            QPainter p;
-            p.begin(&img);
-            p.setRenderHints(painter->renderHints());
-            p.translate(br.topLeft());
-            p.scale(m_scale, m_scale);
-            QGraphicsSvgItem::paint(&p, option, 0);
-            p.end();
-
-            img = img.rgbSwapped();
-        }
+        QImage img = render(painter, option, textureWidth, textureHeight).convertToFormat(QImage::Format_ARGB32).rgbSwapped();
 
         glEnable(GL_TEXTURE_2D);
 
@@ -33,9 +33,10 @@
 
 class QGLContext;
 
-// Cache Svg item as GL Texture.
-// Texture is regenerated each time item is scaled
-// but it's reused during rotation, unlike DeviceCoordinateCache mode
+// Cache Svg item as GL Texture, or as an image without OpenGL.
+// Texture is regenerated each time item is scaled, the device pixel ratio
+// or the element changes, but it's reused during rotation, unlike
+// DeviceCoordinateCache mode
 class QTCREATOR_UTILS_EXPORT CachedSvgItem : public QGraphicsSvgItem {
     Q_OBJECT
 public:
@@ -49,6 +50,13 @@ private:
     QGLContext *m_context;
     GLuint m_texture;
     qreal m_scale;
+    // what the cache was rendered from
+    QString m_elementId;
+    QSizeF m_size;
+    QImage m_image;
+
+    bool isCacheValid(qreal scale) const;
+    QImage render(const QPainter *painter, const QStyleOptionGraphicsItem *option, int width, int height);
 };
 
 #endif // ifndef CACHEDSVGITEM_H
@@ -0,0 +1,429 @@
+/**
+ ******************************************************************************
+ *
+ * @file       compressedlog.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Block compressed OPL log container
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "compressedlog.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QtConcurrent/QtConcurrentRun>
+#include <string.h>
+
+#define LOG_MAGIC         "OPLZ"
+#define BLOCK_MAGIC       "OPLB"
+#define TRAILER_MAGIC     "OPLX"
+#define LOG_VERSION       2
+#define MAGIC_LENGTH      4
+// Size of the timestamp and data size in front of every record
+#define LOG_RECORD_HEADER_LENGTH (sizeof(quint32) + sizeof(qint64))
+// zlib level, the fast end: the GCS logs while flying
+#define COMPRESSION_LEVEL 1
+
+namespace {
+void writeBlockHeader(uchar *header, const CompressedLog::Block &block)
+{
+    memcpy(header, BLOCK_MAGIC, MAGIC_LENGTH);
+    qToLittleEndian<quint32>(block.size, header + 4);
+    qToLittleEndian<quint32>(block.compressedSize, header + 8);
+    qToLittleEndian<quint32>(block.firstTimeStamp, header + 12);
+    qToLittleEndian<quint32>(block.lastTimeStamp, header + 16);
+}
+
+bool readBlockHeader(const uchar *header, CompressedLog::Block &block)
+{
+    if (memcmp(header, BLOCK_MAGIC, MAGIC_LENGTH) != 0) {
+        return false;
+    }
+    block.size = qFromLittleEndian<quint32>(header + 4);
+    block.compressedSize = qFromLittleEndian<quint32>(header + 8);
+    block.firstTimeStamp = qFromLittleEndian<quint32>(header + 12);
+    block.lastTimeStamp  = qFromLittleEndian<quint32>(header + 16);
+    return true;
+}
+
+/**
+ * Block list from the index at the end of the log. The positions in the
+ * uncompressed stream follow from the sizes.
+ */
+bool readIndex(const uchar *data, qint64 size, QVector<CompressedLog::Block> &blocks)
+{
+    if (size < CompressedLog::HEADER_LENGTH + CompressedLog::TRAILER_LENGTH) {
+        return false;
+    }
+    const uchar *trailer = data + size - CompressedLog::TRAILER_LENGTH;
+    if (memcmp(trailer + 12, TRAILER_MAGIC, MAGIC_LENGTH) != 0) {
+        return false;
+    }
+    quint32 count = qFromLittleEndian<quint32>(trailer);
+    qint64 offset = qFromLittleEndian<qint64>(trailer + 4);
+    if (offset < CompressedLog::HEADER_LENGTH
+        || offset + (qint64)count * (CompressedLog::BLOCK_HEADER_LENGTH + 8) + CompressedLog::TRAILER_LENGTH != size) {
+        return false;
+    }
+
+    blocks.resize(count);
+    qint64 position = 0;
+    for (quint32 i = 0; i < count; ++i) {
+        const uchar *entry = data + offset + i * (CompressedLog::BLOCK_HEADER_LENGTH + 8);
+        CompressedLog::Block &block = blocks[i];
+        block.offset = qFromLittleEndian<qint64>(entry);
+        if (!readBlockHeader(entry + 8, block) || block.offset + block.compressedSize > offset) {
+            blocks.clear();
+            return false;
+        }
+        block.position = position;
+        position += block.size;
+    }
+    return true;
+}
+
+/**
+ * Block list of a log that was not closed, walking the block headers.
+ */
+void scanBlocks(const uchar *data, qint64 size, QVector<CompressedLog::Block> &blocks)
+{
+    qint64 offset   = CompressedLog::HEADER_LENGTH;
+    qint64 position = 0;
+
+    blocks.clear();
+    while (offset + CompressedLog::BLOCK_HEADER_LENGTH <= size) {
+        CompressedLog::Block block;
+        if (!readBlockHeader(data + offset, block)) {
+            break;
+        }
+        block.offset   = offset + CompressedLog::BLOCK_HEADER_LENGTH;
+        block.position = position;
+        if (block.offset + block.compressedSize > size) {
+            break;
+        }
+        blocks.append(block);
+        offset   = block.offset + block.compressedSize;
+        position += block.size;
+    }
+}
+
+QByteArray uncompressBlock(const QByteArray &data)
+{
+    return qUncompress(data);
+}
+}
+
+bool CompressedLog::isCompressed(const uchar *data, qint64 size)
+{
+    return size >= HEADER_LENGTH && memcmp(data, LOG_MAGIC, MAGIC_LENGTH) == 0
+           && qFromLittleEndian<quint32>(data + MAGIC_LENGTH) == LOG_VERSION;
+}
+
+bool CompressedLog::isCompressed(QIODevice *device)
+{
+    QByteArray header = device->peek(HEADER_LENGTH);
+
+    return isCompressed((const uchar *)header.constData(), header.size());
+}
+
+bool CompressedLog::readBlocks(const uchar *data, qint64 size, QVector<Block> &blocks)
+{
+    if (!isCompressed(data, size)) {
+        return false;
+    }
+    if (!readIndex(data, size, blocks)) {
+        qDebug() << "CompressedLog: no index, the log was not closed, scanning the blocks";
+        scanBlocks(data, size, blocks);
+    }
+    return true;
+}
+
+bool CompressedLog::readBlocks(QIODevice *device, QVector<Block> &blocks)
+{
+    QFile *file = qobject_cast<QFile *>(device);
+    uchar *data = (file != NULL) ? file->map(0, file->size()) : NULL;
+    bool ok;
+
+    if (data != NULL) {
+        ok = readBlocks(data, file->size(), blocks);
+        file->unmap(data);
+    } else {
+        QByteArray all = device->readAll();
+        ok = readBlocks((const uchar *)all.constData(), all.size(), blocks);
+    }
+    return ok;
+}
+
+QByteArray CompressedLog::decompress(const uchar *data, const Block &block)
+{
+    QByteArray result = qUncompress(data + block.offset, block.compressedSize);
+
+    if (result.size() != (int)block.size) {
+        qDebug() << "CompressedLog: corrupted block at offset" << block.offset;
+        return QByteArray();
+    }
+    return result;
+}
+
+CompressedLogWriter::CompressedLogWriter() :
+    m_file(NULL),
+    m_taskRunning(false),
+    m_error(false)
+{
+    m_block.firstTimeStamp = 0;
+    m_block.lastTimeStamp  = 0;
+}
+
+CompressedLogWriter::~CompressedLogWriter()
+{
+    m_task.waitForFinished();
+}
+
+bool CompressedLogWriter::start(QFile *file)
+{
+    uchar header[CompressedLog::HEADER_LENGTH];
+
+    memcpy(header, LOG_MAGIC, MAGIC_LENGTH);
+    qToLittleEndian<quint32>(LOG_VERSION, header + MAGIC_LENGTH);
+
+    m_file  = file;
+    m_error = false;
+    m_blocks.clear();
+    m_block.data.clear();
+    m_block.data.reserve(CompressedLog::BLOCK_SIZE + 1024);
+    return m_file->write((const char *)header, sizeof(header)) == sizeof(header);
+}
+
+void CompressedLogWriter::append(quint32 timeStamp, const char *data, qint64 dataSize)
+{
+    if (m_block.data.isEmpty()) {
+        m_block.firstTimeStamp = timeStamp;
+    } else if (m_block.data.size() + LOG_RECORD_HEADER_LENGTH + dataSize > CompressedLog::BLOCK_SIZE) {
+        submit();
+        m_block.firstTimeStamp = timeStamp;
+    }
+    m_block.lastTimeStamp = timeStamp;
+
+    // Same record layout as an uncompressed log
+    m_block.data.append((const char *)&timeStamp, sizeof(timeStamp));
+    m_block.data.append((const char *)&dataSize, sizeof(dataSize));
+    m_block.data.append(data, dataSize);
+}
+
+void CompressedLogWriter::submit()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_queue.enqueue(m_block);
+    m_block.data = QByteArray();
+    m_block.data.reserve(CompressedLog::BLOCK_SIZE + 1024);
+    if (!m_taskRunning) {
+        m_taskRunning = true;
+        m_task = QtConcurrent::run(this, &CompressedLogWriter::compressQueue);
+    }
+}
+
+/**
+ * Background task, runs until the queue is empty. Only one runs at a time,
+ * so the blocks are written in order.
+ */
+void CompressedLogWriter::compressQueue()
+{
+    while (true) {
+        PendingBlock pending;
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_queue.isEmpty()) {
+                m_taskRunning = false;
+                return;
+            }
+            pending = m_queue.dequeue();
+        }
+
+        QByteArray compressed = qCompress(pending.data, COMPRESSION_LEVEL);
+        CompressedLog::Block block;
+        block.offset   = m_file->pos() + CompressedLog::BLOCK_HEADER_LENGTH;
+        block.position = 0;
+        block.size     = pending.data.size();
+        block.compressedSize = compressed.size();
+        block.firstTimeStamp = pending.firstTimeStamp;
+        block.lastTimeStamp  = pending.lastTimeStamp;
+
+        uchar header[CompressedLog::BLOCK_HEADER_LENGTH];
+        writeBlockHeader(header, block);
+        if (m_file->write((const char *)header, sizeof(header)) != sizeof(header)
+            || m_file->write(compressed) != compressed.size()) {
+            m_error = true;
+        }
+        m_blocks.append(block);
+    }
+}
+
+bool CompressedLogWriter::finish()
+{
+    if (m_file == NULL) {
+        return false;
+    }
+    if (!m_block.data.isEmpty()) {
+        submit();
+    }
+    m_task.waitForFinished();
+
+    qint64 indexOffset = m_file->pos();
+    QByteArray index;
+    foreach(const CompressedLog::Block &block, m_blocks) {
+        uchar entry[CompressedLog::BLOCK_HEADER_LENGTH + 8];
+        qToLittleEndian<qint64>(block.offset, entry);
+        writeBlockHeader(entry + 8, block);
+        index.append((const char *)entry, sizeof(entry));
+    }
+    uchar trailer[CompressedLog::TRAILER_LENGTH];
+    qToLittleEndian<quint32>(m_blocks.size(), trailer);
+    qToLittleEndian<qint64>(indexOffset, trailer + 4);
+    memcpy(trailer + 12, TRAILER_MAGIC, MAGIC_LENGTH);
+    index.append((const char *)trailer, sizeof(trailer));
+
+    bool ok = !m_error && m_file->write(index) == index.size();
+    m_file = NULL;
+    return ok;
+}
+
+CompressedLogDevice::CompressedLogDevice(QFile *file, QObject *parent) :
+    QIODevice(parent),
+    m_file(file),
+    m_size(0),
+    m_current(-1),
+    m_prefetched(-1)
+{}
+
+CompressedLogDevice::~CompressedLogDevice()
+{
+    m_prefetch.waitForFinished();
+}
+
+bool CompressedLogDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::WriteOnly) || !m_file->isOpen()) {
+        return false;
+    }
+
+    QFile file(m_file->fileName());
+    if (!file.open(QIODevice::ReadOnly) || !CompressedLog::readBlocks(&file, m_blocks)) {
+        return false;
+    }
+    m_size    = m_blocks.isEmpty() ? 0 : m_blocks.last().position + m_blocks.last().size;
+    m_current = -1;
+    m_data.clear();
+    return QIODevice::open(mode);
+}
+
+qint64 CompressedLogDevice::size() const
+{
+    return m_size;
+}
+
+bool CompressedLogDevice::seek(qint64 pos)
+{
+    if (pos < 0 || pos > m_size) {
+        return false;
+    }
+    return QIODevice::seek(pos);
+}
+
+int CompressedLogDevice::findBlock(qint64 pos) const
+{
+    int first = 0;
+    int last  = m_blocks.size();
+
+    while (first < last) {
+        int middle = (first + last) / 2;
+        if (m_blocks.at(middle).position <= pos) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first - 1;
+}
+
+QByteArray CompressedLogDevice::readBlock(int index)
+{
+    const CompressedLog::Block &block = m_blocks.at(index);
+
+    if (!m_file->seek(block.offset)) {
+        return QByteArray();
+    }
+    return m_file->read(block.compressedSize);
+}
+
+bool CompressedLogDevice::loadBlock(int index)
+{
+    if (index == m_current) {
+        return true;
+    }
+
+    m_prefetch.waitForFinished();
+    if (index == m_prefetched) {
+        m_data = m_prefetch.result();
+    } else {
+        m_data = qUncompress(readBlock(index));
+    }
+    m_prefetched = -1;
+    if (m_data.size() != (int)m_blocks.at(index).size) {
+        qDebug() << "CompressedLogDevice: corrupted block" << index;
+        m_current = -1;
+        m_data.clear();
+        return false;
+    }
+    m_current = index;
+
+    // The replay reads forward, have the next block ready when it gets there
+    if (index + 1 < m_blocks.size()) {
+        m_prefetched = index + 1;
+        m_prefetch   = QtConcurrent::run(uncompressBlock, readBlock(index + 1));
+    }
+    return true;
+}
+
+qint64 CompressedLogDevice::readData(char *data, qint64 maxSize)
+{
+    qint64 pos  = QIODevice::pos();
+    qint64 read = 0;
+
+    while (read < maxSize && pos < m_size) {
+        int index = findBlock(pos);
+        if (index < 0 || !loadBlock(index)) {
+            return read > 0 ? read : -1;
+        }
+        const CompressedLog::Block &block = m_blocks.at(index);
+        qint64 inBlock = pos - block.position;
+        qint64 length  = qMin(maxSize - read, (qint64)block.size - inBlock);
+        memcpy(data + read, m_data.constData() + inBlock, length);
+        read += length;
+        pos  += length;
+    }
+    return read;
+}
+
+qint64 CompressedLogDevice::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
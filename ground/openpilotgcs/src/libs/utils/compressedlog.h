@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ *
+ * @file       compressedlog.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Block compressed OPL log container
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef COMPRESSEDLOG_H
+#define COMPRESSEDLOG_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QIODevice>
+#include <QMutex>
+#include <QQueue>
+#include <QVector>
+#include "utils_global.h"
+
+class QFile;
+
+/**
+ * Layout of the compressed OPL log (version 2), all integers little endian:
+ *
+ *   header  "OPLZ", version(4)
+ *   blocks  "OPLB", size(4), compressed size(4), first time(4), last time(4), data
+ *   index   one block header per block, in file order
+ *   trailer block count(4), index offset(8), "OPLX"
+ *
+ * The data of a block is a plain OPL record stream of a few hundred KB,
+ * compressed with qCompress. Records never span two blocks, so every block
+ * decompresses and decodes on its own. The block headers make a log that
+ * was not closed (no index) readable up to its last complete block.
+ */
+class QTCREATOR_UTILS_EXPORT CompressedLog {
+public:
+    struct Block {
+        qint64 offset; // of the compressed data in the file
+        qint64 position; // of the first record in the uncompressed stream
+        quint32 size;
+        quint32 compressedSize;
+        quint32 firstTimeStamp;
+        quint32 lastTimeStamp;
+    };
+
+    static const int HEADER_LENGTH       = 8;
+    static const int BLOCK_HEADER_LENGTH = 20;
+    static const int TRAILER_LENGTH      = 16;
+    static const int BLOCK_SIZE = 256 * 1024;
+
+    static bool isCompressed(const uchar *data, qint64 size);
+    static bool isCompressed(QIODevice *device);
+
+    // Block list of a mapped log, from the index or from the block headers
+    static bool readBlocks(const uchar *data, qint64 size, QVector<Block> &blocks);
+    static bool readBlocks(QIODevice *device, QVector<Block> &blocks);
+
+    static QByteArray decompress(const uchar *data, const Block &block);
+};
+
+/**
+ * Writes a compressed log. Records are gathered in blocks, the full blocks
+ * are compressed and written in order by a single background task, so
+ * append() only copies the record.
+ */
+class QTCREATOR_UTILS_EXPORT CompressedLogWriter {
+public:
+    CompressedLogWriter();
+    ~CompressedLogWriter();
+
+    // The file must be open for writing and empty
+    bool start(QFile *file);
+    void append(quint32 timeStamp, const char *data, qint64 dataSize);
+    // Writes the last block and the index, waits for the background task
+    bool finish();
+
+private:
+    struct PendingBlock {
+        QByteArray data;
+        quint32 firstTimeStamp;
+        quint32 lastTimeStamp;
+    };
+
+    QFile *m_file;
+    PendingBlock m_block;
+    QMutex m_mutex;
+    QQueue<PendingBlock> m_queue;
+    QFuture<void> m_task;
+    bool m_taskRunning;
+    bool m_error;
+    QVector<CompressedLog::Block> m_blocks;
+
+    void submit();
+    void compressQueue();
+};
+
+/**
+ * Read only random access device over the uncompressed record stream of a
+ * compressed log, for the replay. The block holding the current position
+ * is kept decompressed and the next one is decompressed in the background.
+ */
+class QTCREATOR_UTILS_EXPORT CompressedLogDevice : public QIODevice {
+    Q_OBJECT
+
+public:
+    CompressedLogDevice(QFile *file, QObject *parent = 0);
+    ~CompressedLogDevice();
+
+    bool open(OpenMode mode);
+    bool isSequential() const
+    {
+        return false;
+    }
+    qint64 size() const;
+    bool seek(qint64 pos);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private:
+    QFile *m_file;
+    QVector<CompressedLog::Block> m_blocks;
+    qint64 m_size;
+    int m_current;
+    QByteArray m_data;
+    int m_prefetched;
+    QFuture<QByteArray> m_prefetch;
+
+    int findBlock(qint64 pos) const;
+    bool loadBlock(int index);
+    QByteArray readBlock(int index);
+};
+
+#endif // COMPRESSEDLOG_H
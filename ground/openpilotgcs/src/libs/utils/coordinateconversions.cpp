@@ -31,12 +31,14 @@
 #include <stdint.h>
 #include <QDebug>
 #include <math.h>
+#include <Eigen/Core>
 
 #define RAD2DEG (180.0 / M_PI)
 #define DEG2RAD (M_PI / 180.0)
 
 namespace Utils {
-CoordinateConversions::CoordinateConversions()
+CoordinateConversions::CoordinateConversions() :
+    baseValid(false)
 {}
 
 /**
@@ -63,7 +65,7 @@ void CoordinateConversions::RneFromLLA(double LLA[3], float Rne[3][3])
  * @param[in] LLA[3] latitude longitude alititude coordinates in
  * @param[out] ECEF[3] location in ECEF coordinates
  */
-void CoordinateConversions::LLA2ECEF(double LLA[3], double ECEF[3])
+void CoordinateConversions::LLA2ECEF(const double LLA[3], double ECEF[3])
 {
     const double a = 6378137.0; // Equatorial Radius
     const double e = 8.1819190842622e-2; // Eccentricity
@@ -161,19 +163,96 @@ int CoordinateConversions::NED2LLA_HomeECEF(double BaseECEFm[3], double NED[3],
  */
 int CoordinateConversions::NED2LLA_HomeLLA(double homeLLA[3], double NED[3], double position[3])
 {
-    double T[3];
+    return NED2LLA_HomeLLA(homeLLA, NED, position, 1);
+}
+
+/**
+ * Convert a batch of points from LLA to ECEF coordinates
+ * @param[in] LLA count latitude, longitude, altitude triplets
+ * @param[out] ECEF count locations in ECEF coordinates
+ * @param[in] count number of points
+ */
+void CoordinateConversions::LLA2ECEF(const double *LLA, double *ECEF, int count)
+{
+    for (int i = 0; i < count; i++) {
+        LLA2ECEF(&LLA[3 * i], &ECEF[3 * i]);
+    }
+}
+
+/**
+ * Get the locations of a batch of points in Latitude, Longitude, Altitude,
+ * with the same approximation as the single point conversion
+ * @param[in] homeLLA the latitude, longitude, and altitude of the home location (in [m])
+ * @param[in] NED count offsets from the home location (in [m])
+ * @param[out] LLA count positions in decimal degrees and altitude in meters
+ * @param[in] count number of points
+ * @returns
+ *  @arg 0 success
+ */
+int CoordinateConversions::NED2LLA_HomeLLA(const double homeLLA[3], const double *NED, double *LLA, int count)
+{
+    Eigen::Map<const Eigen::Vector3d> home(homeLLA);
+    Eigen::Array3d scale;
 
-    T[0] = homeLLA[2] + 6.378137E6f * M_PI / 180.0;
-    T[1] = cosf(homeLLA[0] * M_PI / 180.0) * (homeLLA[2] + 6.378137E6f) * M_PI / 180.0;
-    T[2] = -1.0f;
+    // Degrees per meter
+    scale[0] = 1.0 / (homeLLA[2] + 6.378137E6f * M_PI / 180.0);
+    scale[1] = 1.0 / (cosf(homeLLA[0] * M_PI / 180.0) * (homeLLA[2] + 6.378137E6f) * M_PI / 180.0);
+    scale[2] = -1.0;
 
-    position[0] = homeLLA[0] + NED[0] / T[0];
-    position[1] = homeLLA[1] + NED[1] / T[1];
-    position[2] = homeLLA[2] + NED[2] / T[2];
+    Eigen::Map<const Eigen::Matrix3Xd> ned(NED, 3, count);
+    Eigen::Map<Eigen::Matrix3Xd> lla(LLA, 3, count);
+    lla = (ned.array().colwise() * scale).matrix().colwise() + home;
 
     return 0;
 }
 
+/**
+ * Get the offsets of a batch of points from the home location, on the WGS-84
+ * ellipsoid. The points are converted to ECEF one by one, their offsets are
+ * rotated to NED all at once.
+ * @param[in] homeLLA the latitude, longitude, and altitude of the home location (in [m])
+ * @param[in] LLA count positions in decimal degrees and altitude in meters
+ * @param[out] NED count offsets from the home location (in [m])
+ * @param[in] count number of points
+ */
+void CoordinateConversions::LLA2NED_HomeLLA(const double homeLLA[3], const double *LLA, double *NED, int count)
+{
+    setHome(homeLLA);
+
+    Eigen::Map<Eigen::Matrix3Xd> ned(NED, 3, count);
+    Eigen::Map<const Eigen::Vector3d> base(baseECEF);
+    Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor> > Rne(&baseRne[0][0]);
+
+    // The ECEF of the points go in the output, then are rotated in place
+    LLA2ECEF(LLA, NED, count);
+    ned = Rne * (ned.colwise() - base);
+}
+
+/**
+ * Convert the home location used by the batch conversions, unless it is the
+ * one of the previous batch
+ */
+void CoordinateConversions::setHome(const double LLA[3])
+{
+    if (baseValid && baseLLA[0] == LLA[0] && baseLLA[1] == LLA[1] && baseLLA[2] == LLA[2]) {
+        return;
+    }
+    for (int i = 0; i < 3; i++) {
+        baseLLA[i] = LLA[i];
+    }
+    LLA2ECEF(baseLLA, baseECEF);
+
+    double sinLat = sin(DEG2RAD * LLA[0]);
+    double sinLon = sin(DEG2RAD * LLA[1]);
+    double cosLat = cos(DEG2RAD * LLA[0]);
+    double cosLon = cos(DEG2RAD * LLA[1]);
+
+    baseRne[0][0] = -sinLat * cosLon; baseRne[0][1] = -sinLat * sinLon; baseRne[0][2] = cosLat;
+    baseRne[1][0] = -sinLon; baseRne[1][1] = cosLon; baseRne[1][2] = 0;
+    baseRne[2][0] = -cosLat * cosLon; baseRne[2][1] = -cosLat * sinLon; baseRne[2][2] = -sinLat;
+    baseValid     = true;
+}
+
 void CoordinateConversions::LLA2Base(double LLA[3], double BaseECEF[3], float Rne[3][3], float NED[3])
 {
     double ECEF[3];
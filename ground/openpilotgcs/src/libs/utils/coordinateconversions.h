@@ -42,13 +42,28 @@ public:
     int NED2LLA_HomeECEF(double BaseECEFcm[3], double NED[3], double position[3]);
     int NED2LLA_HomeLLA(double LLA[3], double NED[3], double position[3]);
     void RneFromLLA(double LLA[3], float Rne[3][3]);
-    void LLA2ECEF(double LLA[3], double ECEF[3]);
+    void LLA2ECEF(const double LLA[3], double ECEF[3]);
     int ECEF2LLA(double ECEF[3], double LLA[3]);
     void LLA2Base(double LLA[3], double BaseECEF[3], float Rne[3][3], float NED[3]);
     void Quaternion2RPY(const float q[4], float rpy[3]);
     void RPY2Quaternion(const float rpy[3], float q[4]);
     void Quaternion2R(const float q[4], float Rbe[3][3]);
     void R2Quaternion(float const Rbe[3][3], float q[4]);
+
+    // Batches of count points, each made of three doubles following the ones
+    // of the previous point. The conversion of the home location is kept from
+    // one call to the next while it does not move.
+    void LLA2ECEF(const double *LLA, double *ECEF, int count);
+    int NED2LLA_HomeLLA(const double homeLLA[3], const double *NED, double *LLA, int count);
+    void LLA2NED_HomeLLA(const double homeLLA[3], const double *LLA, double *NED, int count);
+
+private:
+    double baseLLA[3];
+    double baseECEF[3];
+    double baseRne[3][3]; // ECEF to NED rotation at the home location
+    bool baseValid;
+
+    void setHome(const double LLA[3]);
 };
 }
 
@@ -60,6 +60,43 @@ const quint8 crc_table[256] = {
     0xde, 0xd9, 0xd0, 0xd7, 0xc2, 0xc5, 0xcc, 0xcb, 0xe6, 0xe1, 0xe8, 0xef, 0xfa, 0xfd, 0xf4, 0xf3
 };
 
+/*
+ * Slice-by-8 tables, crc_slice_table[n][x] is the crc of byte x followed by n zero bytes.
+ * As the crc is linear the crc of 8 bytes can be computed with 8 independent lookups.
+ */
+static quint8 crc_slice_table[8][256];
+
+static bool initSliceTables()
+{
+    for (int x = 0; x < 256; ++x) {
+        crc_slice_table[0][x] = crc_table[x];
+    }
+    for (int n = 1; n < 8; ++n) {
+        for (int x = 0; x < 256; ++x) {
+            crc_slice_table[n][x] = crc_table[crc_slice_table[n - 1][x]];
+        }
+    }
+    return true;
+}
+
+static const bool crc_slice_table_initialized = initSliceTables();
+
+static quint32 crc32_table[256];
+
+static bool initCRC32Table()
+{
+    for (quint32 x = 0; x < 256; ++x) {
+        quint32 crc = x << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+        crc32_table[x] = crc;
+    }
+    return true;
+}
+
+static const bool crc32_table_initialized = initCRC32Table();
+
 quint8 Crc::updateCRC(quint8 crc, const quint8 data)
 {
     return crc_table[crc ^ data];
@@ -67,8 +104,34 @@ quint8 Crc::updateCRC(quint8 crc, const quint8 data)
 
 quint8 Crc::updateCRC(quint8 crc, const quint8 *data, qint32 length)
 {
+    Q_UNUSED(crc_slice_table_initialized);
+
+    // Process 8 bytes at a time
+    while (length >= 8) {
+        crc = crc_slice_table[7][crc ^ data[0]] ^
+              crc_slice_table[6][data[1]] ^
+              crc_slice_table[5][data[2]] ^
+              crc_slice_table[4][data[3]] ^
+              crc_slice_table[3][data[4]] ^
+              crc_slice_table[2][data[5]] ^
+              crc_slice_table[1][data[6]] ^
+              crc_slice_table[0][data[7]];
+        data   += 8;
+        length -= 8;
+    }
+    // And the remaining bytes one at a time
     while (length--) {
         crc = crc_table[crc ^ *data++];
     }
     return crc;
 }
+
+quint32 Crc::updateCRC32(quint32 crc, const quint8 *data, qint32 length)
+{
+    Q_UNUSED(crc32_table_initialized);
+
+    while (length--) {
+        crc = (crc << 8) ^ crc32_table[(crc >> 24) ^ *data++];
+    }
+    return crc;
+}
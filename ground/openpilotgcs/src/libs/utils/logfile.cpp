@@ -1,6 +1,23 @@
 #include "logfile.h"
+#include "compressedlog.h"
 #include <QDebug>
 #include <QtGlobal>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QtConcurrent/QtConcurrentRun>
+
+// Size of the timestamp and data size in front of every record
+#define LOG_RECORD_HEADER_LENGTH (sizeof(quint32) + sizeof(qint64))
+// UAVTalk header: sync, type, length, object ID and instance ID
+#define UAVTALK_HEADER_LENGTH    10
+#define UAVTALK_TYPE_VER         0x20
+#define UAVTALK_TYPE_OBJ         (UAVTALK_TYPE_VER | 0x00)
+#define UAVTALK_TYPE_OBJ_ACK     (UAVTALK_TYPE_VER | 0x02)
+#define UAVTALK_TIMESTAMPED      0x80
+
+#define LOG_INDEX_MAGIC          0x4F504C49 // "OPLI"
 
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
@@ -9,9 +26,15 @@ LogFile::LogFile(QObject *parent) :
     m_timeOffset(0),
     m_playbackSpeed(1.0),
     m_nextTimeStamp(0),
-    m_useProvidedTimeStamp(false)
+    m_useProvidedTimeStamp(false),
+    m_compressed(false),
+    m_input(&m_file),
+    m_compressedInput(NULL),
+    m_writer(NULL),
+    m_replayDuration(0)
 {
     connect(&m_timer, SIGNAL(timeout()), this, SLOT(timerFired()));
+    connect(&m_indexBuilder, SIGNAL(finished()), this, SLOT(indexCreated()));
 }
 
 /**
@@ -36,6 +59,30 @@ bool LogFile::open(OpenMode mode)
         return false;
     }
 
+    if (mode & QIODevice::WriteOnly) {
+        if (m_compressed) {
+            m_writer = new CompressedLogWriter;
+            if (!m_writer->start(&m_file)) {
+                qDebug() << "Unable to write to " << m_file.fileName();
+                delete m_writer;
+                m_writer = NULL;
+                m_file.close();
+                return false;
+            }
+        }
+    } else if (CompressedLog::isCompressed(&m_file)) {
+        // The replay reads the uncompressed records through the block device
+        m_compressedInput = new CompressedLogDevice(&m_file, this);
+        if (!m_compressedInput->open(QIODevice::ReadOnly)) {
+            qDebug() << "Unable to read the blocks of " << m_file.fileName();
+            delete m_compressedInput;
+            m_compressedInput = NULL;
+            m_file.close();
+            return false;
+        }
+        m_input = m_compressedInput;
+    }
+
     // TODO: Write a header at the beginng describing objects so that in future
     // they can be read back if ID's change
 
@@ -54,6 +101,18 @@ void LogFile::close()
     if (m_timer.isActive()) {
         m_timer.stop();
     }
+    if (m_writer != NULL) {
+        if (!m_writer->finish()) {
+            qDebug() << "Error writing the compressed log " << m_file.fileName();
+        }
+        delete m_writer;
+        m_writer = NULL;
+    }
+    if (m_compressedInput != NULL) {
+        delete m_compressedInput;
+        m_compressedInput = NULL;
+        m_input = &m_file;
+    }
     m_file.close();
     QIODevice::close();
 }
@@ -68,6 +127,12 @@ qint64 LogFile::writeData(const char *data, qint64 dataSize)
     // This is used when saving logs from on-board logging
     quint32 timeStamp = m_useProvidedTimeStamp ? m_nextTimeStamp : m_myTime.elapsed();
 
+    if (m_writer != NULL) {
+        m_writer->append(timeStamp, data, dataSize);
+        emit bytesWritten(dataSize);
+        return dataSize;
+    }
+
     m_file.write((char *)&timeStamp, sizeof(timeStamp));
     m_file.write((char *)&dataSize, sizeof(dataSize));
 
@@ -98,19 +163,20 @@ void LogFile::timerFired()
 {
     qint64 dataSize;
 
-    if (m_file.bytesAvailable() > 4) {
+    if (m_input->bytesAvailable() > 4) {
+        qint32 played = m_lastPlayed;
         int time;
         time = m_myTime.elapsed();
 
         // TODO: going back in time will be a problem
         while ((m_lastPlayed + ((time - m_timeOffset) * m_playbackSpeed) > m_lastTimeStamp)) {
             m_lastPlayed += ((time - m_timeOffset) * m_playbackSpeed);
-            if (m_file.bytesAvailable() < (qint64)sizeof(dataSize)) {
+            if (m_input->bytesAvailable() < (qint64)sizeof(dataSize)) {
                 stopReplay();
                 return;
             }
 
-            m_file.read((char *)&dataSize, sizeof(dataSize));
+            m_input->read((char *)&dataSize, sizeof(dataSize));
 
             if (dataSize < 1 || dataSize > (1024 * 1024)) {
                 qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
@@ -118,24 +184,24 @@ void LogFile::timerFired()
                 return;
             }
 
-            if (m_file.bytesAvailable() < dataSize) {
+            if (m_input->bytesAvailable() < dataSize) {
                 stopReplay();
                 return;
             }
 
             m_mutex.lock();
-            m_dataBuffer.append(m_file.read(dataSize));
+            m_dataBuffer.append(m_input->read(dataSize));
             m_mutex.unlock();
 
             emit readyRead();
 
-            if (m_file.bytesAvailable() < (qint64)sizeof(m_lastTimeStamp)) {
+            if (m_input->bytesAvailable() < (qint64)sizeof(m_lastTimeStamp)) {
                 stopReplay();
                 return;
             }
 
             int save = m_lastTimeStamp;
-            m_file.read((char *)&m_lastTimeStamp, sizeof(m_lastTimeStamp));
+            m_input->read((char *)&m_lastTimeStamp, sizeof(m_lastTimeStamp));
             // some validity checks
             if (m_lastTimeStamp < save // logfile goes back in time
                 || (m_lastTimeStamp - save) > (60 * 60 * 1000)) { // gap of more than 60 minutes)
@@ -147,6 +213,9 @@ void LogFile::timerFired()
             m_timeOffset = time;
             time = m_myTime.elapsed();
         }
+        if (m_lastPlayed != played) {
+            emit replayPositionChanged(m_lastPlayed);
+        }
     } else {
         stopReplay();
     }
@@ -158,13 +227,39 @@ bool LogFile::startReplay()
     m_myTime.restart();
     m_timeOffset = 0;
     m_lastPlayed = 0;
-    m_file.read((char *)&m_lastTimeStamp, sizeof(m_lastTimeStamp));
+    m_index.clear();
+    m_replayDuration = 0;
+    bool indexed = loadIndex();
+    if (!indexed) {
+        m_indexBuilder.setFuture(QtConcurrent::run(&LogFile::createIndex, m_file.fileName(), m_compressedInput != NULL));
+    }
+    m_input->read((char *)&m_lastTimeStamp, sizeof(m_lastTimeStamp));
     m_timer.setInterval(10);
     m_timer.start();
     emit replayStarted();
+    if (indexed) {
+        emit replayDurationChanged(m_replayDuration);
+    }
     return true;
 }
 
+/**
+ * Takes the index built by the worker, unless the replay was stopped or
+ * another log was opened meanwhile.
+ */
+void LogFile::indexCreated()
+{
+    Index index = m_indexBuilder.result();
+
+    if (!m_file.isOpen() || index.fileName != m_file.fileName() || !m_index.isEmpty() || index.entries.isEmpty()) {
+        return;
+    }
+    m_index = index.entries;
+    m_replayDuration = index.duration;
+    saveIndex();
+    emit replayDurationChanged(m_replayDuration);
+}
+
 bool LogFile::stopReplay()
 {
     close();
@@ -182,3 +277,231 @@ void LogFile::resumeReplay()
     m_timeOffset = m_myTime.elapsed();
     m_timer.start();
 }
+
+/**
+ * Moves the replay to the given log time. The object state at that time is
+ * restored by pushing the last record of every object instance before the
+ * nearest index entry, followed by the records from the index entry up to
+ * the requested time.
+ */
+bool LogFile::setReplayPosition(quint32 timeStamp)
+{
+    if (!m_file.isOpen() || m_index.isEmpty()) {
+        return false;
+    }
+
+    // Find the last index entry at or before the requested time
+    int first = 0;
+    int last  = m_index.size();
+    while (first < last) {
+        int middle = (first + last) / 2;
+        if (m_index.at(middle).timeStamp <= timeStamp) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    const IndexEntry &entry = m_index.at(qMax(first - 1, 0));
+
+    QByteArray state;
+    QByteArray record;
+    foreach(qint64 offset, entry.snapshot) {
+        if (readRecord(offset, record)) {
+            state.append(record);
+        }
+    }
+
+    // Fast forward to the first record after the requested time and leave
+    // the file positioned after its timestamp, as timerFired() expects
+    qint64 offset = entry.offset;
+    quint32 recordTimeStamp = 0;
+    bool atEnd = true;
+    while (m_input->seek(offset) && m_input->read((char *)&recordTimeStamp, sizeof(recordTimeStamp)) == sizeof(recordTimeStamp)) {
+        if (recordTimeStamp > timeStamp) {
+            atEnd = false;
+            break;
+        }
+        if (!readRecord(offset, record)) {
+            break;
+        }
+        state.append(record);
+        offset = m_input->pos();
+    }
+
+    m_mutex.lock();
+    m_dataBuffer = state;
+    m_mutex.unlock();
+
+    m_lastTimeStamp = recordTimeStamp;
+    m_lastPlayed    = timeStamp;
+    m_timeOffset    = m_myTime.elapsed();
+
+    emit readyRead();
+    emit replayPositionChanged(timeStamp);
+
+    if (atEnd) {
+        stopReplay();
+    }
+    return true;
+}
+
+/**
+ * Reads the data of the record at the given file offset.
+ */
+bool LogFile::readRecord(qint64 offset, QByteArray &data)
+{
+    quint32 timeStamp;
+    qint64 dataSize;
+
+    if (!m_input->seek(offset)
+        || m_input->read((char *)&timeStamp, sizeof(timeStamp)) != sizeof(timeStamp)
+        || m_input->read((char *)&dataSize, sizeof(dataSize)) != sizeof(dataSize)
+        || dataSize < 1 || dataSize > (1024 * 1024)) {
+        return false;
+    }
+    data = m_input->read(dataSize);
+    return data.size() == dataSize;
+}
+
+QString LogFile::indexFileName() const
+{
+    return m_file.fileName() + ".idx";
+}
+
+/**
+ * Worker thread, scans the record headers of the log and builds the seek index.
+ * The entries are empty if the log could not be read.
+ */
+LogFile::Index LogFile::createIndex(QString fileName, bool compressedLog)
+{
+    Index index;
+
+    index.fileName = fileName;
+    index.duration = 0;
+
+    // Use a separate file so that the replay position is not disturbed
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return index;
+    }
+    // Offsets of a compressed log are in its uncompressed record stream
+    CompressedLogDevice compressed(&file);
+    QIODevice *input = &file;
+    if (compressedLog) {
+        if (!compressed.open(QIODevice::ReadOnly)) {
+            return index;
+        }
+        input = &compressed;
+    }
+
+    QHash<quint64, qint64> lastRecords;
+    quint32 nextIndexTime = 0;
+    qint64 offset = 0;
+    QByteArray data;
+
+    while (true) {
+        quint32 timeStamp;
+        qint64 dataSize;
+        if (input->read((char *)&timeStamp, sizeof(timeStamp)) != sizeof(timeStamp)
+            || input->read((char *)&dataSize, sizeof(dataSize)) != sizeof(dataSize)) {
+            break;
+        }
+        // Same validity checks as the replay, the index stops at the first bad record
+        if (dataSize < 1 || dataSize > (1024 * 1024)
+            || (!index.entries.isEmpty() && (timeStamp < index.duration || (timeStamp - index.duration) > (60 * 60 * 1000)))) {
+            qDebug() << "LogFile: index stopped at corrupted record at offset" << offset;
+            break;
+        }
+        data = input->read(dataSize);
+        if (data.size() != dataSize) {
+            break;
+        }
+
+        if (index.entries.isEmpty() || timeStamp >= nextIndexTime) {
+            IndexEntry entry;
+            entry.timeStamp = timeStamp;
+            entry.offset    = offset;
+            entry.snapshot  = lastRecords.values().toVector();
+            // Replay the snapshot in log order
+            qSort(entry.snapshot);
+            index.entries.append(entry);
+            nextIndexTime   = timeStamp + INDEX_INTERVAL_MS;
+        }
+
+        if (dataSize >= UAVTALK_HEADER_LENGTH) {
+            const quint8 *header = (const quint8 *)data.constData();
+            quint8 type = header[1] & ~UAVTALK_TIMESTAMPED;
+            if (type == UAVTALK_TYPE_OBJ || type == UAVTALK_TYPE_OBJ_ACK) {
+                quint32 objId  = header[4] | (header[5] << 8) | (header[6] << 16) | ((quint32)header[7] << 24);
+                quint16 instId = header[8] | (header[9] << 8);
+                lastRecords.insert(((quint64)objId << 16) | instId, offset);
+            }
+        }
+
+        index.duration = timeStamp;
+        offset += LOG_RECORD_HEADER_LENGTH + dataSize;
+    }
+
+    return index;
+}
+
+/**
+ * Loads the index sidecar file, fails if it is missing or was created
+ * for another version of the log.
+ */
+bool LogFile::loadIndex()
+{
+    QFile file(indexFileName());
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QFileInfo logInfo(m_file.fileName());
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic, version;
+    qint64 logSize;
+    QDateTime logModified;
+    quint32 count;
+    stream >> magic >> version >> logSize >> logModified >> m_replayDuration >> count;
+    if (stream.status() != QDataStream::Ok || magic != LOG_INDEX_MAGIC || version != INDEX_VERSION
+        || logSize != logInfo.size() || logModified != logInfo.lastModified()) {
+        m_replayDuration = 0;
+        return false;
+    }
+
+    m_index.resize(count);
+    for (quint32 i = 0; i < count; ++i) {
+        stream >> m_index[i].timeStamp >> m_index[i].offset >> m_index[i].snapshot;
+    }
+    if (stream.status() != QDataStream::Ok || m_index.isEmpty()) {
+        m_index.clear();
+        m_replayDuration = 0;
+        return false;
+    }
+    return true;
+}
+
+bool LogFile::saveIndex() const
+{
+    QFile file(indexFileName());
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        // Not fatal, the log might be on a read only medium
+        qDebug() << "LogFile: unable to write index" << file.fileName();
+        return false;
+    }
+
+    QFileInfo logInfo(m_file.fileName());
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    stream << (quint32)LOG_INDEX_MAGIC << (quint32)INDEX_VERSION << logInfo.size() << logInfo.lastModified()
+           << m_replayDuration << (quint32)m_index.size();
+    foreach(const IndexEntry &entry, m_index) {
+        stream << entry.timeStamp << entry.offset << entry.snapshot;
+    }
+    return stream.status() == QDataStream::Ok;
+}
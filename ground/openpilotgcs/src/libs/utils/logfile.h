@@ -8,8 +8,13 @@
 #include <QDebug>
 #include <QBuffer>
 #include <QFile>
+#include <QVector>
+#include <QFutureWatcher>
 #include "utils_global.h"
 
+class CompressedLogDevice;
+class CompressedLogWriter;
+
 class QTCREATOR_UTILS_EXPORT LogFile : public QIODevice {
     Q_OBJECT
 public:
@@ -17,13 +22,18 @@ public:
     qint64 bytesAvailable() const;
     qint64 bytesToWrite() const
     {
-        return m_file.bytesToWrite();
+        // the file belongs to the compression task while writing a compressed log
+        return m_writer != NULL ? 0 : m_file.bytesToWrite();
     };
     bool open(OpenMode mode);
     void setFileName(QString name)
     {
         m_file.setFileName(name);
     };
+    QString fileName() const
+    {
+        return m_file.fileName();
+    }
     void close();
     qint64 writeData(const char *data, qint64 dataSize);
     qint64 readData(char *data, qint64 maxlen);
@@ -35,11 +45,27 @@ public:
         m_useProvidedTimeStamp = useProvidedTimeStamp;
     }
 
+    // Write a block compressed log (OPL version 2), the replay detects it by itself
+    void setCompressed(bool compressed)
+    {
+        m_compressed = compressed;
+    }
+
     void setNextTimeStamp(quint32 nextTimestamp)
     {
         m_nextTimeStamp = nextTimestamp;
     }
 
+    quint32 replayPosition() const
+    {
+        return m_lastPlayed;
+    }
+
+    quint32 replayDuration() const
+    {
+        return m_replayDuration;
+    }
+
 public slots:
     void setReplaySpeed(double val)
     {
@@ -48,14 +74,19 @@ public slots:
     };
     void pauseReplay();
     void resumeReplay();
+    bool setReplayPosition(quint32 timeStamp);
 
 protected slots:
     void timerFired();
+    void indexCreated();
 
 signals:
     void readReady();
     void replayStarted();
     void replayFinished();
+    void replayPositionChanged(quint32 timeStamp);
+    // The duration is known once the index is loaded or built, seeking works from then on
+    void replayDurationChanged(quint32 duration);
 
 protected:
     QByteArray m_dataBuffer;
@@ -71,8 +102,44 @@ protected:
     double m_playbackSpeed;
 
 private:
+    /**
+     * Index of the log, one entry every INDEX_INTERVAL_MS of log time.
+     * The snapshot holds the offset of the last record of every object
+     * instance seen before the entry, so that seeking can restore the full
+     * object state without replaying the log from the start.
+     */
+    struct IndexEntry {
+        quint32 timeStamp;
+        qint64  offset;
+        QVector<qint64> snapshot;
+    };
+
+    struct Index {
+        QString fileName;
+        QVector<IndexEntry> entries;
+        quint32 duration;
+    };
+
+    static const quint32 INDEX_INTERVAL_MS = 5000;
+    static const quint32 INDEX_VERSION     = 1;
+
     quint32 m_nextTimeStamp;
     bool m_useProvidedTimeStamp;
+    bool m_compressed;
+    // the uncompressed record stream of the replay, m_file or m_compressedInput
+    QIODevice *m_input;
+    CompressedLogDevice *m_compressedInput;
+    CompressedLogWriter *m_writer;
+    QVector<IndexEntry> m_index;
+    quint32 m_replayDuration;
+    // A log without an index file is scanned on a worker thread while it already replays
+    QFutureWatcher<Index> m_indexBuilder;
+
+    QString indexFileName() const;
+    bool loadIndex();
+    bool saveIndex() const;
+    static Index createIndex(QString fileName, bool compressedLog);
+    bool readRecord(qint64 offset, QByteArray &data);
 };
 
 #endif // LOGFILE_H
@@ -33,6 +33,8 @@
 SvgImageProvider::SvgImageProvider(const QString &basePath) :
     QObject(),
     QQuickImageProvider(QQuickImageProvider::Image),
+    m_mutex(QMutex::Recursive),
+    m_images(IMAGE_CACHE_SIZE_KB),
     m_basePath(basePath)
 {}
 
@@ -43,6 +45,7 @@ SvgImageProvider::~SvgImageProvider()
 
 QSvgRenderer *SvgImageProvider::loadRenderer(const QString &svgFile)
 {
+    QMutexLocker locker(&m_mutex);
     QSvgRenderer *renderer = m_renderers.value(svgFile);
 
     if (!renderer) {
@@ -82,6 +85,28 @@ QSvgRenderer *SvgImageProvider::loadRenderer(const QString &svgFile)
    }
  */
 QImage SvgImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    QMutexLocker locker(&m_mutex);
+    QString key = QString("%1@%2x%3").arg(id).arg(requestedSize.width()).arg(requestedSize.height());
+    RenderedImage *cached = m_images.object(key);
+    RenderedImage rendered;
+
+    if (cached) {
+        rendered = *cached;
+    } else {
+        rendered.image = renderImage(id, &rendered.size, requestedSize);
+        if (!rendered.image.isNull()) {
+            m_images.insert(key, new RenderedImage(rendered), qMax(1, rendered.image.byteCount() / 1024));
+        }
+    }
+
+    if (size) {
+        *size = rendered.size;
+    }
+    return rendered.image;
+}
+
+QImage SvgImageProvider::renderImage(const QString &id, QSize *size, const QSize &requestedSize)
 {
     QString svgFile = id;
     QString element;
@@ -226,6 +251,7 @@ QPixmap SvgImageProvider::requestPixmap(const QString &id, QSize *size, const QS
  */
 QRectF SvgImageProvider::scaledElementBounds(const QString &svgFile, const QString &elementName)
 {
+    QMutexLocker locker(&m_mutex);
     QSvgRenderer *renderer = loadRenderer(svgFile);
 
     if (!renderer) {
@@ -32,9 +32,18 @@
 #include <QQuickImageProvider>
 #include <QSvgRenderer>
 #include <QMap>
+#include <QCache>
+#include <QMutex>
 
 #include "utils_global.h"
 
+/**
+ * Renders the elements of SVG files for QML. The rendered images are kept
+ * in a cache keyed by the request id and size, so a gadget reloaded or
+ * showing an element several times does not render it again. The
+ * provider is thread safe, asynchronous QML images are rendered by the
+ * image loader thread.
+ */
 class QTCREATOR_UTILS_EXPORT SvgImageProvider : public QObject, public QQuickImageProvider {
     Q_OBJECT
 public:
@@ -49,8 +58,20 @@ public:
     Q_INVOKABLE QRectF scaledElementBounds(const QString &svgFile, const QString &elementName);
 
 private:
+    struct RenderedImage {
+        QImage image;
+        QSize size;
+    };
+
+    // Memory of the rendered images kept, KB
+    static const int IMAGE_CACHE_SIZE_KB = 64 * 1024;
+
+    QMutex m_mutex;
     QMap<QString, QSvgRenderer *> m_renderers;
+    QCache<QString, RenderedImage> m_images;
     QString m_basePath;
+
+    QImage renderImage(const QString &id, QSize *size, const QSize & requestedSize);
 };
 
 #endif // ifndef SVGIMAGEPROVIDER_H_
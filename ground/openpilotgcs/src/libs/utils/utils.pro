@@ -7,12 +7,15 @@ QT += gui \
     svg \
     opengl \
     qml quick \
-    widgets
+    widgets \
+    concurrent
 
 DEFINES += QTCREATOR_UTILS_LIB
 
 include(../../openpilotgcslibrary.pri)
 
+INCLUDEPATH += ../eigen
+
 SOURCES += reloadpromptutils.cpp \
     settingsutils.cpp \
     filesearch.cpp \
@@ -56,6 +59,7 @@ SOURCES += reloadpromptutils.cpp \
     svgimageprovider.cpp \
     hostosinfo.cpp \
     logfile.cpp \
+    compressedlog.cpp \
     crc.cpp \
     mustache.cpp
 
@@ -116,6 +120,7 @@ HEADERS += utils_global.h \
     svgimageprovider.h \
     hostosinfo.h \
     logfile.h \
+    compressedlog.h \
     crc.h \
     mustache.h
 
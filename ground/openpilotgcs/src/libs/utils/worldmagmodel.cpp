@@ -933,21 +933,13 @@ double WorldMagModel::get_main_field_coeff_g(int index)
 
     double coeff = CoeffFile[index][2];
 
+    // index = n * (n + 1) / 2 + m, so degrees 1 to nMax are indexes 1 to nMax * (nMax + 3) / 2
     int a = MagneticModel.nMaxSecVar;
     int b = (a * (a + 1) / 2 + a);
-    for (int n = 1; n <= MagneticModel.nMax; n++) {
-        for (int m = 0; m <= n; m++) {
-            int sum_index = (n * (n + 1) / 2 + m);
-
-            /* Hacky for now, will solve for which conditions need summing analytically */
-            if (sum_index != index) {
-                continue;
-            }
+    int nMax = MagneticModel.nMax;
 
-            if (index <= b) {
-                coeff += (decimal_date - MagneticModel.epoch) * get_secular_var_coeff_g(sum_index);
-            }
-        }
+    if (index >= 1 && index <= b && index <= nMax * (nMax + 3) / 2) {
+        coeff += (decimal_date - MagneticModel.epoch) * get_secular_var_coeff_g(index);
     }
 
     return coeff;
@@ -961,21 +953,13 @@ double WorldMagModel::get_main_field_coeff_h(int index)
 
     double coeff = CoeffFile[index][3];
 
+    // index = n * (n + 1) / 2 + m, so degrees 1 to nMax are indexes 1 to nMax * (nMax + 3) / 2
     int a = MagneticModel.nMaxSecVar;
     int b = (a * (a + 1) / 2 + a);
-    for (int n = 1; n <= MagneticModel.nMax; n++) {
-        for (int m = 0; m <= n; m++) {
-            int sum_index = (n * (n + 1) / 2 + m);
-
-            /* Hacky for now, will solve for which conditions need summing analytically */
-            if (sum_index != index) {
-                continue;
-            }
+    int nMax = MagneticModel.nMax;
 
-            if (index <= b) {
-                coeff += (decimal_date - MagneticModel.epoch) * get_secular_var_coeff_h(sum_index);
-            }
-        }
+    if (index >= 1 && index <= b && index <= nMax * (nMax + 3) / 2) {
+        coeff += (decimal_date - MagneticModel.epoch) * get_secular_var_coeff_h(index);
     }
 
     return coeff;
@@ -33,14 +33,23 @@
 AntennaTrackGadget::AntennaTrackGadget(QString classId, AntennaTrackWidget *widget, QWidget *parent) :
     IUAVGadget(classId, parent),
     m_widget(widget),
-    connected(false)
+    connected(false),
+    m_servoRate(50),
+    m_leadTime(0)
 {
     connect(m_widget->connectButton, SIGNAL(clicked(bool)), this, SLOT(onConnect()));
     connect(m_widget->disconnectButton, SIGNAL(clicked(bool)), this, SLOT(onDisconnect()));
+
+    tracker = new TrackPredictor(this);
+    connect(tracker, SIGNAL(pointing(double, double)), m_widget, SLOT(setPointing(double, double)));
+    connect(tracker, SIGNAL(received(QString)), m_widget, SLOT(dumpPacket(QString)));
+    connect(tracker, SIGNAL(finished()), this, SLOT(onTrackingStopped()));
 }
 
 AntennaTrackGadget::~AntennaTrackGadget()
-{}
+{
+    tracker->close();
+}
 
 /*
    This is called when a configuration is loaded, and updates the plugin's settings.
@@ -50,10 +59,9 @@ AntennaTrackGadget::~AntennaTrackGadget()
  */
 void AntennaTrackGadget::loadConfiguration(IUAVGadgetConfiguration *config)
 {
-    // Delete the (old)port, this also closes it.
-    if (port) {
-        delete port;
-    }
+    // The tracker thread owns the port, it is opened again on connect
+    tracker->close();
+    m_port = QSerialPortInfo();
 
     // Delete the (old)parser, this also disconnects all signals.
     if (parser) {
@@ -68,6 +76,8 @@ void AntennaTrackGadget::loadConfiguration(IUAVGadgetConfiguration *config)
     m_portsettings.Parity = AntennaTrackConfig->parity();
     m_portsettings.StopBits    = AntennaTrackConfig->stopBits();
     m_portsettings.Timeout_Millisec = AntennaTrackConfig->timeOut();
+    m_servoRate = AntennaTrackConfig->servoRate();
+    m_leadTime  = AntennaTrackConfig->leadTime();
 
     // In case we find no port, buttons disabled
     m_widget->connectButton->setEnabled(false);
@@ -78,14 +88,11 @@ void AntennaTrackGadget::loadConfiguration(IUAVGadgetConfiguration *config)
         if (nport.portName() == AntennaTrackConfig->port()) {
             qDebug() << "Using Serial port";
             // parser = new NMEAParser();
-            port = new QSerialPort(nport);
-            m_widget->setPort(port);
+            m_port = nport;
             m_widget->connectButton->setEnabled(true);
             m_widget->disconnectButton->setEnabled(false);
             m_widget->connectButton->setHidden(false);
             m_widget->disconnectButton->setHidden(false);
-
-            connect(port, SIGNAL(readyRead()), this, SLOT(onDataAvailable()));
         }
     }
     m_widget->dataStreamGroupBox->setHidden(false);
@@ -100,22 +107,12 @@ void AntennaTrackGadget::loadConfiguration(IUAVGadgetConfiguration *config)
 void AntennaTrackGadget::onConnect()
 {
     m_widget->textBrowser->append(QString("Connecting to Tracker ...\n"));
-    // TODO: Somehow mark that we're running, and disable connect button while so?
 
-    if (port) {
-        qDebug() << "Opening: " << port->portName() << ".";
-        bool isOpen = port->open(QIODevice::ReadWrite);
-        qDebug() << "Open: " << isOpen;
-        if (isOpen) {
-            if (port->setBaudRate(m_portsettings.BaudRate)
-                && port->setDataBits(m_portsettings.DataBits)
-                && port->setParity(m_portsettings.Parity)
-                && port->setStopBits(m_portsettings.StopBits)
-                && port->setFlowControl(m_portsettings.FlowControl)) {
-                m_widget->connectButton->setEnabled(false);
-                m_widget->disconnectButton->setEnabled(true);
-            }
-        }
+    if (!m_port.isNull()) {
+        qDebug() << "Opening: " << m_port.portName() << ".";
+        tracker->open(m_port, m_portsettings, m_servoRate, m_leadTime);
+        m_widget->connectButton->setEnabled(false);
+        m_widget->disconnectButton->setEnabled(true);
     } else {
         qDebug() << "Port undefined or invalid.";
     }
@@ -123,37 +120,19 @@ void AntennaTrackGadget::onConnect()
 
 void AntennaTrackGadget::onDisconnect()
 {
-    if (port) {
-        qDebug() << "Closing: " << port->portName() << ".";
-        port->close();
-        m_widget->connectButton->setEnabled(true);
-        m_widget->disconnectButton->setEnabled(false);
+    if (!m_port.isNull()) {
+        qDebug() << "Closing: " << m_port.portName() << ".";
+        tracker->close();
     } else {
         qDebug() << "Port undefined or invalid.";
     }
 }
 
-void AntennaTrackGadget::onDataAvailable()
-{
-    int avail = port->bytesAvailable();
-
-    if (avail > 0) {
-        QByteArray serialData;
-        serialData.resize(avail);
-        int bytesRead = port->read(serialData.data(), serialData.size());
-        if (bytesRead > 0) {
-            processNewSerialData(serialData);
-        }
-    }
-}
-
-void AntennaTrackGadget::processNewSerialData(QByteArray serialData)
+/**
+ * The tracker thread ended, after a disconnect or when the port failed to open
+ */
+void AntennaTrackGadget::onTrackingStopped()
 {
-    int dataLength   = serialData.size();
-    const char *data = serialData.constData();
-
-    m_widget->textBrowser->append(QString(serialData));
-    for (int pos = 0; pos < dataLength; pos++) {
-        // parser->processInputStream(data[pos]);
-    }
+    m_widget->connectButton->setEnabled(!m_port.isNull());
+    m_widget->disconnectButton->setEnabled(false);
 }
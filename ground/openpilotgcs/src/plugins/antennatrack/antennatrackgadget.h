@@ -28,10 +28,11 @@
 #ifndef ANTENNATRACKGADGET_H_
 #define ANTENNATRACKGADGET_H_
 
-#include <QtSerialPort/QSerialPort>
+#include <QtSerialPort/QSerialPortInfo>
 #include <coreplugin/iuavgadget.h>
 #include "antennatrackwidget.h"
 #include "telemetryparser.h"
+#include "trackpredictor.h"
 
 class IUAVGadget;
 class QWidget;
@@ -59,15 +60,17 @@ public slots:
     void onDisconnect();
 
 private slots:
-    void onDataAvailable();
+    void onTrackingStopped();
 
 private:
     QPointer<AntennaTrackWidget> m_widget;
-    QPointer<QSerialPort> port;
+    QSerialPortInfo m_port;
     QPointer<GPSParser> parser;
+    TrackPredictor *tracker;
     bool connected;
-    void processNewSerialData(QByteArray serialData);
     PortSettings m_portsettings;
+    int m_servoRate;
+    int m_leadTime;
 };
 
 
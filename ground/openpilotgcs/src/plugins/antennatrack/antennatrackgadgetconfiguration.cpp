@@ -41,7 +41,9 @@ AntennaTrackGadgetConfiguration::AntennaTrackGadgetConfiguration(QString classId
     m_defaultFlow(QSerialPort::UnknownFlowControl),
     m_defaultParity(QSerialPort::UnknownParity),
     m_defaultStopBits(QSerialPort::UnknownStopBits),
-    m_defaultTimeOut(5000)
+    m_defaultTimeOut(5000),
+    m_servoRate(50),
+    m_leadTime(0)
 {
     // if a saved configuration exists load it
     if (qSettings != 0) {
@@ -71,6 +73,8 @@ AntennaTrackGadgetConfiguration::AntennaTrackGadgetConfiguration(QString classId
         m_defaultParity   = parity;
         m_defaultStopBits = stopbits;
         m_connectionMode  = conMode;
+        m_servoRate = qSettings->value("servoRate", m_servoRate).toInt();
+        m_leadTime  = qSettings->value("leadTime", m_leadTime).toInt();
     }
 }
 
@@ -89,6 +93,8 @@ IUAVGadgetConfiguration *AntennaTrackGadgetConfiguration::clone()
     m->m_defaultStopBits = m_defaultStopBits;
     m->m_defaultPort     = m_defaultPort;
     m->m_connectionMode  = m_connectionMode;
+    m->m_servoRate = m_servoRate;
+    m->m_leadTime  = m_leadTime;
     return m;
 }
 
@@ -105,4 +111,6 @@ void AntennaTrackGadgetConfiguration::saveConfig(QSettings *settings) const
     settings->setValue("defaultStopBits", m_defaultStopBits);
     settings->setValue("defaultPort", m_defaultPort);
     settings->setValue("connectionMode", m_connectionMode);
+    settings->setValue("servoRate", m_servoRate);
+    settings->setValue("leadTime", m_leadTime);
 }
@@ -89,6 +89,14 @@ public:
     {
         m_defaultTimeOut = timeout;
     }
+    void setServoRate(int rate)
+    {
+        m_servoRate = rate;
+    }
+    void setLeadTime(int lead)
+    {
+        m_leadTime = lead;
+    }
 
     // get port configuration functions
     QString port()
@@ -119,6 +127,16 @@ public:
     {
         return m_defaultTimeOut;
     }
+    // Tracker commands per second
+    int servoRate()
+    {
+        return m_servoRate;
+    }
+    // How long the tracker takes to follow a command, in ms
+    int leadTime()
+    {
+        return m_leadTime;
+    }
 
     void saveConfig(QSettings *settings) const;
     IUAVGadgetConfiguration *clone();
@@ -132,6 +150,8 @@ private:
     QSerialPort::Parity m_defaultParity;
     QSerialPort::StopBits m_defaultStopBits;
     long m_defaultTimeOut;
+    int m_servoRate;
+    int m_leadTime;
 };
 
 #endif // ANTENNATRACKGADGETCONFIGURATION_H
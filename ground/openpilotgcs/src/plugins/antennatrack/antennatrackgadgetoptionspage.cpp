@@ -132,6 +132,10 @@ QWidget *AntennaTrackGadgetOptionsPage::createPage(QWidget *parent)
     // TIMEOUT
     options_page->timeoutSpinBox->setValue(m_config->timeOut());
 
+    // TRACKING
+    options_page->servoRateSpinBox->setValue(m_config->servoRate());
+    options_page->leadTimeSpinBox->setValue(m_config->leadTime());
+
     QStringList connectionModes;
     connectionModes << "Serial";
     options_page->connectionMode->addItems(connectionModes);
@@ -163,6 +167,8 @@ void AntennaTrackGadgetOptionsPage::apply()
     m_config->setStopBits((QSerialPort::StopBits)options_page->stopBitsComboBox->itemData(options_page->stopBitsComboBox->currentIndex()).toInt());
     m_config->setParity((QSerialPort::Parity)options_page->parityComboBox->itemData(options_page->parityComboBox->currentIndex()).toInt());
     m_config->setTimeOut(options_page->timeoutSpinBox->value());
+    m_config->setServoRate(options_page->servoRateSpinBox->value());
+    m_config->setLeadTime(options_page->leadTimeSpinBox->value());
     m_config->setConnectionMode(options_page->connectionMode->currentText());
 }
 
@@ -34,8 +34,6 @@
 #include <QGraphicsView>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
-#include <QtSerialPort/QSerialPort>
-#include <QPointer>
 
 class Ui_AntennaTrackWidget;
 
@@ -55,18 +53,14 @@ public:
     AntennaTrackWidget(QWidget *parent = 0);
     ~AntennaTrackWidget();
     TrackData_t TrackData;
-    void setPort(QPointer<QSerialPort> portx);
 
 private slots:
     void setPosition(double, double, double);
     void setHomePosition(double, double, double);
+    void setPointing(double azimuth, double elevation);
     void dumpPacket(const QString &packet);
 
 private:
-    void calcAntennaPosition(void);
     QGraphicsSvgItem *marker;
-    QPointer<QSerialPort> port;
-    double azimuth_old;
-    double elevation_old;
 };
 #endif /* ANTENNATRACKWIDGET_H_ */
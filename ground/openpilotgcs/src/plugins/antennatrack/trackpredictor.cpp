@@ -0,0 +1,239 @@
+/**
+ ******************************************************************************
+ *
+ * @file       trackpredictor.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup AntennaTrackGadgetPlugin Antenna Track Gadget Plugin
+ * @{
+ * @brief Points the tracker where the vehicle is predicted to be
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "trackpredictor.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "positionstate.h"
+#include "velocitystate.h"
+#include "gcstelemetrystats.h"
+
+#include <QtSerialPort/QSerialPort>
+#include <QMutexLocker>
+#include <QDateTime>
+#include <math.h>
+
+// Stepper steps per turn of the azimuth axis, servo pulse of the elevation axis
+#define STEPS_PER_REV     400
+#define SERVO_MIN         2000
+#define SERVO_RANGE       2000
+#define LATENCY_MAX_MS    5000.0
+// Beyond that the vehicle is held where it was last seen, the link is lost anyway
+#define MAX_PREDICTION_MS 3000
+#define DISPLAY_PERIOD_MS 100
+
+TrackPredictor::TrackPredictor(QObject *parent) : QThread(parent),
+    m_periodMs(20), m_leadMs(0), m_running(false),
+    m_hasPosition(false), m_positionTime(0), m_latencyMs(0)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    for (int i = 0; i < 3; i++) {
+        m_position[i] = 0;
+        m_velocity[i] = 0;
+    }
+    m_clock.start();
+
+    m_positionState = PositionState::GetInstance(objManager);
+    m_velocityState = VelocityState::GetInstance(objManager);
+    m_gcsStats = GCSTelemetryStats::GetInstance(objManager);
+    connect(m_positionState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updatePosition(UAVObject *)));
+    connect(m_velocityState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateVelocity(UAVObject *)));
+    connect(m_gcsStats, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateLatency(UAVObject *)));
+}
+
+TrackPredictor::~TrackPredictor()
+{
+    close();
+}
+
+/**
+ * Open the port and start tracking, at rate commands per second
+ */
+void TrackPredictor::open(const QSerialPortInfo &port, const PortSettings &settings, int rate, int leadMs)
+{
+    close();
+
+    m_port     = port;
+    m_settings = settings;
+    m_periodMs = qMax(1000 / qMax(rate, 1), 1);
+    m_leadMs   = leadMs;
+    m_running  = true;
+    start(QThread::TimeCriticalPriority);
+}
+
+void TrackPredictor::close()
+{
+    m_mutex.lock();
+    m_running = false;
+    m_mutex.unlock();
+    wait();
+}
+
+void TrackPredictor::updatePosition(UAVObject *obj)
+{
+    PositionState::DataFields position = m_positionState->getData();
+    qint64 time = updateTime(obj);
+
+    QMutexLocker locker(&m_mutex);
+    m_position[0]  = position.North;
+    m_position[1]  = position.East;
+    m_position[2]  = position.Down;
+    m_positionTime = time;
+    m_hasPosition  = true;
+}
+
+void TrackPredictor::updateVelocity(UAVObject *obj)
+{
+    VelocityState::DataFields velocity = m_velocityState->getData();
+    qint64 now = updateTime(obj);
+
+    QMutexLocker locker(&m_mutex);
+    // Carry the position to now with the old velocity, then continue with the new one
+    if (m_hasPosition && now > m_positionTime) {
+        predict(now, m_position);
+        m_positionTime = now;
+    }
+    m_velocity[0] = velocity.North;
+    m_velocity[1] = velocity.East;
+    m_velocity[2] = velocity.Down;
+}
+
+void TrackPredictor::updateLatency(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    double latency = qBound(0.0, (double)m_gcsStats->getData().Latency, LATENCY_MAX_MS);
+
+    QMutexLocker locker(&m_mutex);
+    m_latencyMs = latency;
+}
+
+/**
+ * When the update left the vehicle, ms of m_clock
+ */
+qint64 TrackPredictor::updateTime(UAVObject *obj)
+{
+    qint64 now = m_clock.elapsed();
+
+    if (obj->hasVehicleTime()) {
+        qint64 age = QDateTime::currentMSecsSinceEpoch() - obj->getVehicleSampleTime();
+        return now - qBound((qint64)0, age, (qint64)LATENCY_MAX_MS);
+    }
+    QMutexLocker locker(&m_mutex);
+    return now - (qint64)m_latencyMs;
+}
+
+/**
+ * Extrapolate the track to timeMs, called with the lock held
+ */
+void TrackPredictor::predict(qint64 timeMs, double position[3])
+{
+    double dt = qBound((qint64)0, timeMs - m_positionTime, (qint64)MAX_PREDICTION_MS) / 1000.0;
+
+    for (int i = 0; i < 3; i++) {
+        position[i] = m_position[i] + m_velocity[i] * dt;
+    }
+}
+
+void TrackPredictor::run()
+{
+    QSerialPort port(m_port);
+
+    if (!port.open(QIODevice::ReadWrite)
+        || !port.setBaudRate(m_settings.BaudRate)
+        || !port.setDataBits(m_settings.DataBits)
+        || !port.setParity(m_settings.Parity)
+        || !port.setStopBits(m_settings.StopBits)
+        || !port.setFlowControl(m_settings.FlowControl)) {
+        emit received(QString("Could not open %1: %2\n").arg(m_port.portName()).arg(port.errorString()));
+        return;
+    }
+    emit received(QString("Tracking at %1 Hz\n").arg(1000 / m_periodMs));
+
+    // The tracker is assumed to start pointing north
+    int steps = 0;
+    int servo = -1;
+    qint64 nextMs    = m_clock.elapsed();
+    qint64 displayMs = nextMs;
+    forever {
+        double position[3];
+        bool hasPosition;
+
+        m_mutex.lock();
+        if (!m_running) {
+            m_mutex.unlock();
+            break;
+        }
+        hasPosition = m_hasPosition;
+        if (hasPosition) {
+            predict(m_clock.elapsed() + m_leadMs, position);
+        }
+        m_mutex.unlock();
+
+        if (hasPosition) {
+            double distance  = sqrt(position[0] * position[0] + position[1] * position[1]);
+            double azimuth   = atan2(position[1], position[0]) * (180 / M_PI);
+            double elevation = (distance > 0 || position[2] != 0) ? atan2(-position[2], distance) * (180 / M_PI) : 0;
+            if (azimuth < 0) {
+                azimuth += 360;
+            }
+
+            // The stepper takes the way round which is shortest
+            int step = qRound(azimuth * STEPS_PER_REV / 360) - steps;
+            step = ((step % STEPS_PER_REV) + STEPS_PER_REV + STEPS_PER_REV / 2) % STEPS_PER_REV - STEPS_PER_REV / 2;
+            // The servo is at the zenith at SERVO_MIN
+            int pulse = SERVO_MIN + qRound(SERVO_RANGE / 180.0 * qBound(0.0, 90 - elevation, 180.0));
+            if (step != 0 || pulse != servo) {
+                QString command;
+                command.sprintf("move %d 2000 2000 2000 %d\r", step, pulse);
+                port.write(command.toLatin1());
+                port.waitForBytesWritten(m_periodMs);
+                steps = (steps + step + STEPS_PER_REV) % STEPS_PER_REV;
+                servo = pulse;
+            }
+
+            if (m_clock.elapsed() >= displayMs) {
+                emit pointing(azimuth, elevation);
+                displayMs = m_clock.elapsed() + DISPLAY_PERIOD_MS;
+            }
+        }
+
+        if (port.waitForReadyRead(0) || port.bytesAvailable()) {
+            emit received(QString(port.readAll()));
+        }
+
+        // Keep the rate on average, skip the commands missed
+        nextMs += m_periodMs;
+        qint64 now = m_clock.elapsed();
+        if (nextMs <= now) {
+            nextMs = now + m_periodMs;
+        }
+        msleep(nextMs - now);
+    }
+    port.close();
+}
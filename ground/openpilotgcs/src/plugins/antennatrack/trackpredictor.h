@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ *
+ * @file       trackpredictor.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup AntennaTrackGadgetPlugin Antenna Track Gadget Plugin
+ * @{
+ * @brief Points the tracker where the vehicle is predicted to be
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TRACKPREDICTOR_H
+#define TRACKPREDICTOR_H
+
+#include "antennatrackgadgetconfiguration.h"
+#include "uavobject.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QtSerialPort/QSerialPortInfo>
+
+class PositionState;
+class VelocityState;
+class GCSTelemetryStats;
+
+/**
+ * Drives the tracker from a thread of its own, which also owns the serial port.
+ *
+ * PositionState and VelocityState (NED, relative to the home location where the
+ * tracker stands) are fused into a constant velocity track. Every servo command
+ * extrapolates it to the time the command takes effect: the age of the last
+ * update, plus the configured lead time of the tracker mechanics. The age is
+ * known from the board time of timestamped updates, otherwise it is taken as
+ * the link latency of the time exchanges (GCSTelemetryStats).
+ */
+class TrackPredictor : public QThread {
+    Q_OBJECT
+
+public:
+    TrackPredictor(QObject *parent = 0);
+    ~TrackPredictor();
+
+    void open(const QSerialPortInfo &port, const PortSettings &settings, int rate, int leadMs);
+    void close();
+
+signals:
+    void pointing(double azimuth, double elevation);
+    void received(QString data);
+
+protected:
+    void run();
+
+private slots:
+    void updatePosition(UAVObject *obj);
+    void updateVelocity(UAVObject *obj);
+    void updateLatency(UAVObject *obj);
+
+private:
+    PositionState *m_positionState;
+    VelocityState *m_velocityState;
+    GCSTelemetryStats *m_gcsStats;
+    QElapsedTimer m_clock;
+
+    QSerialPortInfo m_port;
+    PortSettings m_settings;
+    int m_periodMs;
+    int m_leadMs;
+
+    // Shared with the thread
+    QMutex m_mutex;
+    bool m_running;
+    bool m_hasPosition;
+    double m_position[3];
+    double m_velocity[3];
+    // When m_position was true, ms of m_clock
+    qint64 m_positionTime;
+    double m_latencyMs;
+
+    qint64 updateTime(UAVObject *obj);
+    void predict(qint64 timeMs, double position[3]);
+};
+
+#endif // TRACKPREDICTOR_H
@@ -52,7 +52,14 @@ bool CalibrationUtils::EllipsoidCalibration(Eigen::VectorXf *samplesX, Eigen::Ve
     Eigen::MatrixXf evecs;
 
     EllipsoidFit(samplesX, samplesY, samplesZ, &center, &radii, &evecs, fitAlongXYZ);
+    EllipsoidResult(center, radii, evecs, nominalRange, result);
+    return true;
+}
 
+void CalibrationUtils::EllipsoidResult(const Eigen::Vector3f & center, const Eigen::VectorXf & radii, const Eigen::MatrixXf & evecs,
+                                       float nominalRange,
+                                       EllipsoidCalibrationResult *result)
+{
     result->Scale.setZero();
 
     result->Scale << nominalRange / radii.coeff(0),
@@ -67,7 +74,6 @@ bool CalibrationUtils::EllipsoidCalibration(Eigen::VectorXf *samplesX, Eigen::Ve
     result->CalibrationMatrix = evecs * tmp * evecs.transpose();
     result->Bias.setZero();
     result->Bias << center.coeff(0), center.coeff(1), center.coeff(2);
-    return true;
 }
 
 bool CalibrationUtils::PolynomialCalibration(VectorXf *samplesX, Eigen::VectorXf *samplesY, int degree, Eigen::Ref<Eigen::VectorXf> result, const double maxRelativeError)
@@ -320,6 +326,14 @@ void CalibrationUtils::EllipsoidFit(Eigen::VectorXf *samplesX, Eigen::VectorXf *
     Eigen::MatrixXf dt2 = (D.transpose() * ones);
     Eigen::VectorXf v   = dt1.inverse() * dt2;
 
+    EllipsoidShape(v, fitAlongXYZ, center, radii, evecs);
+}
+
+void CalibrationUtils::EllipsoidShape(const Eigen::VectorXf & v, bool fitAlongXYZ,
+                                      Eigen::Vector3f *center,
+                                      Eigen::VectorXf *radii,
+                                      Eigen::MatrixXf *evecs)
+{
     if (!fitAlongXYZ) {
         Eigen::Matrix4f A;
         A << v.coeff(0), v.coeff(3), v.coeff(4), v.coeff(6),
@@ -479,4 +493,181 @@ double CalibrationUtils::listVar(QList<double> list)
     // Use unbiased estimator
     return var_accum / (list.size() - 1);
 }
+
+PolynomialAccumulator::PolynomialAccumulator(int degree)
+{
+    reset(degree);
+}
+
+void PolynomialAccumulator::reset(int degree)
+{
+    m_xtx.setZero(degree + 1, degree + 1);
+    m_xty.setZero(degree + 1);
+    m_sumY    = 0;
+    m_sumYY   = 0;
+    m_offsetY = 0;
+    m_count   = 0;
+    m_minX    = 0;
+    m_maxX    = 0;
+}
+
+void PolynomialAccumulator::add(float x, float y)
+{
+    if (m_count == 0) {
+        m_offsetY = y;
+        m_minX    = m_maxX = x;
+    }
+    m_minX = qMin(m_minX, x);
+    m_maxX = qMax(m_maxX, x);
+
+    int n = m_xty.rows();
+    double dy = (double)y - m_offsetY;
+    // element (i, j) of X'X sums x^(i + j)
+    VectorXd powers(2 * n - 1);
+    powers[0] = 1.0;
+    for (int i = 1; i < powers.rows(); i++) {
+        powers[i] = powers[i - 1] * x;
+    }
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) {
+            m_xtx(i, j) += powers[i + j];
+        }
+        m_xty[i] += powers[i] * dy;
+    }
+    m_sumY  += dy;
+    m_sumYY += dy * dy;
+    m_count++;
+}
+
+bool PolynomialAccumulator::solve(Eigen::Ref<Eigen::VectorXf> result, const double maxRelativeError) const
+{
+    if (m_count <= degree()) {
+        return false;
+    }
+    VectorXd tmpx = m_xtx.fullPivHouseholderQr().solve(m_xty);
+    double relativeError = (m_xtx * tmpx - m_xty).norm() / m_xty.norm();
+    tmpx[0] += m_offsetY;
+    result   = tmpx.cast<float>();
+    return relativeError < maxRelativeError;
+}
+
+float PolynomialAccumulator::sigma() const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    double mean = m_sumY / m_count;
+    return (float)sqrt(qMax(0.0, m_sumYY / m_count - mean * mean));
+}
+
+float PolynomialAccumulator::residualSigma(const Eigen::VectorXf & polynomial) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    // residuals r = y - X.p expanded over the accumulated sums, y is relative to the offset
+    VectorXd p = polynomial.cast<double>();
+    p[0] -= m_offsetY;
+    double sumR  = m_sumY - m_xtx.row(0).dot(p);
+    double sumRR = m_sumYY - 2.0 * p.dot(m_xty) + p.dot(m_xtx * p);
+    double mean  = sumR / m_count;
+    return (float)sqrt(qMax(0.0, sumRR / m_count - mean * mean));
+}
+
+EllipsoidAccumulator::EllipsoidAccumulator(bool fitAlongXYZ)
+{
+    reset(fitAlongXYZ);
+}
+
+void EllipsoidAccumulator::reset(bool fitAlongXYZ)
+{
+    int n = fitAlongXYZ ? 6 : 9;
+
+    m_fitAlongXYZ = fitAlongXYZ;
+    m_dtd.setZero(n, n);
+    m_dt1.setZero(n);
+    m_count     = 0;
+    m_min.setZero();
+    m_max.setZero();
+    m_center.setZero();
+    m_centerSet = false;
+    m_bins = 0;
+}
+
+void EllipsoidAccumulator::add(float x, float y, float z)
+{
+    Vector3f p(x, y, z);
+
+    if (m_count == 0) {
+        m_min = m_max = p;
+    }
+    m_min = m_min.cwiseMin(p);
+    m_max = m_max.cwiseMax(p);
+
+    // one row of D, see CalibrationUtils::EllipsoidFit
+    VectorXd d(m_dt1.rows());
+    if (!m_fitAlongXYZ) {
+        d << (double)x * x, (double)y * y, (double)z * z,
+            2.0 * x * y, 2.0 * x * z, 2.0 * y * z,
+            2.0 * x, 2.0 * y, 2.0 * z;
+    } else {
+        d << (double)x * x, (double)y * y, (double)z * z,
+            2.0 * x, 2.0 * y, 2.0 * z;
+    }
+    m_dtd.selfadjointView<Eigen::Upper>().rankUpdate(d);
+    m_dt1 += d;
+    m_count++;
+
+    // the patch is the face of the cube around the center the direction
+    // crosses, split in four by the signs of the two other components
+    Vector3f dir  = p - (m_centerSet ? m_center : (m_min + m_max) / 2);
+    int axis;
+    dir.cwiseAbs().maxCoeff(&axis);
+    int face = 2 * axis + (dir[axis] < 0 ? 1 : 0);
+    int quadrant = (dir[(axis + 1) % 3] < 0 ? 1 : 0) + (dir[(axis + 2) % 3] < 0 ? 2 : 0);
+    m_bins |= 1u << (4 * face + quadrant);
+}
+
+void EllipsoidAccumulator::setCenter(const Eigen::Vector3f & center)
+{
+    m_center    = center;
+    m_centerSet = true;
+}
+
+float EllipsoidAccumulator::coverage() const
+{
+    int bins = 0;
+
+    for (int i = 0; i < COVERAGE_BINS; i++) {
+        if (m_bins & (1u << i)) {
+            bins++;
+        }
+    }
+    return (float)bins / COVERAGE_BINS;
+}
+
+bool EllipsoidAccumulator::solve(float nominalRange, CalibrationUtils::EllipsoidCalibrationResult *result, float *residual) const
+{
+    if (m_count < m_dt1.rows()) {
+        return false;
+    }
+    MatrixXd dtd = m_dtd.selfadjointView<Eigen::Upper>();
+    VectorXd v   = dtd.fullPivHouseholderQr().solve(m_dt1);
+
+    Vector3f center;
+    VectorXf radii;
+    MatrixXf evecs;
+    CalibrationUtils::EllipsoidShape(v.cast<float>(), m_fitAlongXYZ, &center, &radii, &evecs);
+    if (!center.allFinite() || !radii.allFinite()) {
+        return false;
+    }
+    CalibrationUtils::EllipsoidResult(center, radii, evecs, nominalRange, result);
+
+    if (residual) {
+        // D.v is 1 on the surface and about 1 + 2 * dr / r next to it, sum((D.v - 1)^2) from the normal equations
+        double sumSq = v.dot(dtd * v) - 2.0 * v.dot(m_dt1) + m_count;
+        *residual = (float)(sqrt(qMax(0.0, sumSq / m_count)) / 2.0);
+    }
+    return true;
+}
 }
@@ -54,12 +54,109 @@ public:
     static double listMean(QList<double> list);
     static double listVar(QList<double> list);
 private:
+    friend class EllipsoidAccumulator;
+
     static void EllipsoidFit(Eigen::VectorXf *samplesX, Eigen::VectorXf *samplesY, Eigen::VectorXf *samplesZ,
                              Eigen::Vector3f *center,
                              Eigen::VectorXf *radii,
                              Eigen::MatrixXf *evecs, bool fitAlongXYZ);
+    static void EllipsoidShape(const Eigen::VectorXf & v, bool fitAlongXYZ,
+                               Eigen::Vector3f *center,
+                               Eigen::VectorXf *radii,
+                               Eigen::MatrixXf *evecs);
+    static void EllipsoidResult(const Eigen::Vector3f & center, const Eigen::VectorXf & radii, const Eigen::MatrixXf & evecs,
+                                float nominalRange,
+                                EllipsoidCalibrationResult *result);
 
     static int LinearEquationsSolve(int nDim, double *pfMatr, double *pfVect, double *pfSolution);
 };
+
+/**
+ * Least squares polynomial fit of y(x) built one sample at a time.
+ * Only the normal equations are kept, so memory does not depend on the
+ * number of samples. y is accumulated relative to the first sample to limit
+ * the cancellation in the sums of squares.
+ */
+class PolynomialAccumulator {
+public:
+    PolynomialAccumulator(int degree = 1);
+
+    void reset(int degree);
+    void add(float x, float y);
+
+    int count() const
+    {
+        return m_count;
+    }
+    int degree() const
+    {
+        return m_xtx.rows() - 1;
+    }
+    float minX() const
+    {
+        return m_minX;
+    }
+    float maxX() const
+    {
+        return m_maxX;
+    }
+
+    // same result as CalibrationUtils::PolynomialCalibration over all the samples added
+    bool solve(Eigen::Ref<Eigen::VectorXf> result, const double maxRelativeError) const;
+    // standard deviation of the samples
+    float sigma() const;
+    // standard deviation of the samples once the polynomial is subtracted
+    float residualSigma(const Eigen::VectorXf & polynomial) const;
+
+private:
+    Eigen::MatrixXd m_xtx;
+    Eigen::VectorXd m_xty;
+    double m_sumY;
+    double m_sumYY;
+    double m_offsetY;
+    int m_count;
+    float m_minX;
+    float m_maxX;
+};
+
+/**
+ * Ellipsoid fit of CalibrationUtils::EllipsoidCalibration built one sample
+ * at a time from the normal equations of the algebraic fit.
+ * Coverage counts the directions around the center that hold samples, the
+ * sphere being split in COVERAGE_BINS patches. Samples are binned around the
+ * latest center given with setCenter(), or the middle of their range before.
+ */
+class EllipsoidAccumulator {
+public:
+    static const int COVERAGE_BINS = 24;
+
+    EllipsoidAccumulator(bool fitAlongXYZ = true);
+
+    void reset(bool fitAlongXYZ);
+    void add(float x, float y, float z);
+    void setCenter(const Eigen::Vector3f & center);
+
+    int count() const
+    {
+        return m_count;
+    }
+
+    // fraction of COVERAGE_BINS holding samples
+    float coverage() const;
+
+    // residual: RMS relative deviation of the samples from the fitted surface
+    bool solve(float nominalRange, CalibrationUtils::EllipsoidCalibrationResult *result, float *residual = 0) const;
+
+private:
+    bool m_fitAlongXYZ;
+    Eigen::MatrixXd m_dtd;
+    Eigen::VectorXd m_dt1;
+    int m_count;
+    Eigen::Vector3f m_min;
+    Eigen::Vector3f m_max;
+    Eigen::Vector3f m_center;
+    bool m_centerSet;
+    quint32 m_bins;
+};
 }
 #endif // CALIBRATIONUTILS_H
@@ -74,17 +74,10 @@ void GyroBiasCalibrationModel::start()
     attitudeSettingsData.BoardRotation[AttitudeSettings::BOARDROTATION_PITCH] = 0;
     attitudeSettings->setData(attitudeSettingsData);
 
-    UAVObject::Metadata gyroStateMetadata = gyroState->getMetadata();
-    memento.gyroStateMetadata = gyroStateMetadata;
-    UAVObject::SetFlightTelemetryUpdateMode(gyroStateMetadata, UAVObject::UPDATEMODE_PERIODIC);
-    gyroStateMetadata.flightTelemetryUpdatePeriod = 100;
-    gyroState->setMetadata(gyroStateMetadata);
-
-    UAVObject::Metadata gyroSensorMetadata = gyroSensor->getMetadata();
-    memento.gyroSensorMetadata = gyroSensorMetadata;
-    UAVObject::SetFlightTelemetryUpdateMode(gyroSensorMetadata, UAVObject::UPDATEMODE_PERIODIC);
-    gyroSensorMetadata.flightTelemetryUpdatePeriod = 100;
-    gyroSensor->setMetadata(gyroSensorMetadata);
+    metadataOverride.clear();
+    metadataOverride.setPeriod(gyroState, 100);
+    metadataOverride.setPeriod(gyroSensor, 100);
+    metadataOverride.apply();
 
     gyro_accum_x.clear();
     gyro_accum_y.clear();
@@ -146,8 +139,7 @@ void GyroBiasCalibrationModel::getSample(UAVObject *obj)
         disconnect(gyroSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(getSample(UAVObject *)));
         disconnect(gyroState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(getSample(UAVObject *)));
 
-        gyroState->setMetadata(memento.gyroStateMetadata);
-        gyroSensor->setMetadata(memento.gyroSensorMetadata);
+        metadataOverride.release();
         revoCalibration->setData(memento.revoCalibrationData);
         attitudeSettings->setData(memento.attitudeSettingsData);
 
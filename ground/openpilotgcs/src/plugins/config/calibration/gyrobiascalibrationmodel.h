@@ -39,6 +39,7 @@
 #include <attitudesettings.h>
 #include <revocalibration.h>
 #include <accelgyrosettings.h>
+#include "uavobjectutil/uavobjecthelper.h"
 
 #include <QObject>
 
@@ -71,8 +72,6 @@ private slots:
 
 private:
     typedef struct {
-        UAVObject::Metadata gyroStateMetadata;
-        UAVObject::Metadata gyroSensorMetadata;
         RevoCalibration::DataFields revoCalibrationData;
         AttitudeSettings::DataFields attitudeSettingsData;
     } Memento;
@@ -83,6 +82,7 @@ private:
     bool m_dirty;
 
     Memento memento;
+    UAVObjectMetadataOverride metadataOverride;
 
     QList<double> gyro_accum_x;
     QList<double> gyro_accum_y;
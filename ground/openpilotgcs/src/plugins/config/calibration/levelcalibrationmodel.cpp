@@ -51,11 +51,9 @@ LevelCalibrationModel::LevelCalibrationModel(QObject *parent) :
  */
 void LevelCalibrationModel::start()
 {
-    memento.attitudeStateMdata = attitudeState->getMetadata();
-    UAVObject::Metadata mdata = attitudeState->getMetadata();
-    UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_PERIODIC);
-    mdata.flightTelemetryUpdatePeriod = 100;
-    attitudeState->setMetadata(mdata);
+    metadataOverride.clear();
+    metadataOverride.setPeriod(attitudeState, 100);
+    metadataOverride.apply();
 
     rot_data_pitch = 0;
     rot_data_roll  = 0;
@@ -138,7 +136,7 @@ void LevelCalibrationModel::getSample(UAVObject *obj)
             rot_data_roll  += OpenPilot::CalibrationUtils::listMean(rot_accum_roll);
             rot_data_roll  /= 2;
 
-            attitudeState->setMetadata(memento.attitudeStateMdata);
+            metadataOverride.release();
 
             m_dirty = true;
 
@@ -32,6 +32,7 @@
 #include "calibration/calibrationutils.h"
 #include <attitudestate.h>
 #include <attitudesettings.h>
+#include "uavobjectutil/uavobjecthelper.h"
 
 #include <QObject>
 #include <QMutex>
@@ -66,17 +67,13 @@ private slots:
     void getSample(UAVObject *obj);
 
 private:
-    typedef struct {
-        UAVObject::Metadata attitudeStateMdata;
-    } Memento;
-
     QMutex sensorsUpdateLock;
     int position;
 
     bool collectingData;
     bool m_dirty;
 
-    Memento memento;
+    UAVObjectMetadataOverride metadataOverride;
 
     QList<double> rot_accum_roll;
     QList<double> rot_accum_pitch;
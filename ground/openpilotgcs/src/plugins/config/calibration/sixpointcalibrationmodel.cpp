@@ -31,6 +31,7 @@
 
 #include <math.h>
 #include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
 #include "QDebug"
 
 #define POINT_SAMPLE_SIZE 50
@@ -118,6 +119,8 @@ SixPointCalibrationModel::SixPointCalibrationModel(QObject *parent) :
 
     homeLocation = HomeLocation::GetInstance(getObjectManager());
     Q_ASSERT(homeLocation);
+
+    connect(&liveFit, SIGNAL(finished()), this, SLOT(liveFitFinished()));
 }
 
 void SixPointCalibrationModel::magStart()
@@ -210,38 +213,22 @@ void SixPointCalibrationModel::start(bool calibrateAccel, bool calibrateMag)
 
     QThread::usleep(100000);
 
-    mag_accum_x.clear();
-    mag_accum_y.clear();
-    mag_accum_z.clear();
+    mag_accum_count = 0;
 
-    mag_fit_x.clear();
-    mag_fit_y.clear();
-    mag_fit_z.clear();
+    mag_fit.reset(true);
+    aux_mag_fit.reset(true);
+    magFitChanged(0, NAN);
 
-    // Need to get as many accel updates as possible
-    memento.accelStateMetadata = accelState->getMetadata();
+    // Need to get as many accel and mag updates as possible
+    metadataOverride.clear();
     if (calibrateAccel) {
-        UAVObject::Metadata mdata = accelState->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_PERIODIC);
-        mdata.flightTelemetryUpdatePeriod = 100;
-        accelState->setMetadata(mdata);
+        metadataOverride.setPeriod(accelState, 100);
     }
-
-    // Need to get as many mag updates as possible
-    memento.magSensorMetadata    = magSensor->getMetadata();
-    memento.auxMagSensorMetadata = auxMagSensor->getMetadata();
-
     if (calibrateMag) {
-        UAVObject::Metadata mdata = magSensor->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_PERIODIC);
-        mdata.flightTelemetryUpdatePeriod = 100;
-        magSensor->setMetadata(mdata);
-
-        mdata = auxMagSensor->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_PERIODIC);
-        mdata.flightTelemetryUpdatePeriod = 100;
-        auxMagSensor->setMetadata(mdata);
+        metadataOverride.setPeriod(magSensor, 100);
+        metadataOverride.setPeriod(auxMagSensor, 100);
     }
+    metadataOverride.apply();
 
     // reset dirty state to forget previous unsaved runs
     m_dirty = false;
@@ -272,15 +259,11 @@ void SixPointCalibrationModel::savePositionData()
 
     savePositionEnabledChanged(false);
 
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
-    mag_accum_x.clear();
-    mag_accum_y.clear();
-    mag_accum_z.clear();
-    aux_mag_accum_x.clear();
-    aux_mag_accum_y.clear();
-    aux_mag_accum_z.clear();
+    accel_accum_x     = 0;
+    accel_accum_y     = 0;
+    accel_accum_z     = 0;
+    accel_accum_count = 0;
+    mag_accum_count   = 0;
 
     collectingData = true;
 
@@ -315,30 +298,23 @@ void SixPointCalibrationModel::getSample(UAVObject *obj)
     if (collectingData == true) {
         if (obj->getObjID() == AccelState::OBJID) {
             AccelState::DataFields accelStateData = accelState->getData();
-            accel_accum_x.append(accelStateData.x);
-            accel_accum_y.append(accelStateData.y);
-            accel_accum_z.append(accelStateData.z);
+            accel_accum_x += accelStateData.x;
+            accel_accum_y += accelStateData.y;
+            accel_accum_z += accelStateData.z;
+            accel_accum_count++;
         } else if (obj->getObjID() == MagSensor::OBJID) {
-            MagSensor::DataFields magData = magSensor->getData();
-            mag_accum_x.append(magData.x);
-            mag_accum_y.append(magData.y);
-            mag_accum_z.append(magData.z);
+            mag_accum_count++;
 #ifndef FITTING_USING_CONTINOUS_ACQUISITION
-            mag_fit_x.append(magData.x);
-            mag_fit_y.append(magData.y);
-            mag_fit_z.append(magData.z);
+            MagSensor::DataFields magData = magSensor->getData();
+            mag_fit.add(magData.x, magData.y, magData.z);
+            startLiveFit();
 #endif // FITTING_USING_CONTINOUS_ACQUISITION
         } else if (obj->getObjID() == AuxMagSensor::OBJID) {
             AuxMagSensor::DataFields auxMagData = auxMagSensor->getData();
             if (auxMagData.Status == AuxMagSensor::STATUS_OK) {
-                aux_mag_accum_x.append(auxMagData.x);
-                aux_mag_accum_y.append(auxMagData.y);
-                aux_mag_accum_z.append(auxMagData.z);
                 calibratingAuxMag = true;
 #ifndef FITTING_USING_CONTINOUS_ACQUISITION
-                aux_mag_fit_x.append(auxMagData.x);
-                aux_mag_fit_y.append(auxMagData.y);
-                aux_mag_fit_z.append(auxMagData.z);
+                aux_mag_fit.add(auxMagData.x, auxMagData.y, auxMagData.z);
 #endif // FITTING_USING_CONTINOUS_ACQUISITION
             }
         } else {
@@ -349,12 +325,12 @@ void SixPointCalibrationModel::getSample(UAVObject *obj)
     bool done = true;
     float progress = 0;
     if (calibratingAccel) {
-        done     = (accel_accum_x.size() >= POINT_SAMPLE_SIZE);
-        progress = (float)accel_accum_x.size() / (float)POINT_SAMPLE_SIZE;
+        done     = (accel_accum_count >= POINT_SAMPLE_SIZE);
+        progress = (float)accel_accum_count / (float)POINT_SAMPLE_SIZE;
     }
     if (calibratingMag) {
-        done     = (mag_accum_x.size() >= POINT_SAMPLE_SIZE / 10);
-        progress = (float)mag_accum_x.size() / (float)(POINT_SAMPLE_SIZE / 10);
+        done     = (mag_accum_count >= POINT_SAMPLE_SIZE / 10);
+        progress = (float)mag_accum_count / (float)(POINT_SAMPLE_SIZE / 10);
     }
 
     progressChanged(progress * 100);
@@ -367,9 +343,9 @@ void SixPointCalibrationModel::getSample(UAVObject *obj)
         // Store the mean for this position for the accel
         if (calibratingAccel) {
             disconnect(accelState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(getSample(UAVObject *)));
-            accel_data_x[position] = CalibrationUtils::listMean(accel_accum_x);
-            accel_data_y[position] = CalibrationUtils::listMean(accel_accum_y);
-            accel_data_z[position] = CalibrationUtils::listMean(accel_accum_z);
+            accel_data_x[position] = accel_accum_x / accel_accum_count;
+            accel_data_y[position] = accel_accum_y / accel_accum_count;
+            accel_data_z[position] = accel_accum_z / accel_accum_count;
         }
 
         // Store the mean for this position for the mag
@@ -394,9 +370,7 @@ void SixPointCalibrationModel::getSample(UAVObject *obj)
             compute();
 
             // Restore original settings
-            accelState->setMetadata(memento.accelStateMetadata);
-            magSensor->setMetadata(memento.magSensorMetadata);
-            auxMagSensor->setMetadata(memento.auxMagSensorMetadata);
+            metadataOverride.release();
             revoCalibration->setData(memento.revoCalibrationData);
             accelGyroSettings->setData(memento.accelGyroSettingsData);
             auxMagSettings->setData(memento.auxMagSettings);
@@ -416,20 +390,55 @@ void SixPointCalibrationModel::continouslyGetMagSamples(UAVObject *obj)
 
     if (obj->getObjID() == MagSensor::OBJID) {
         MagSensor::DataFields magSensorData = magSensor->getData();
-        mag_fit_x.append(magSensorData.x);
-        mag_fit_y.append(magSensorData.y);
-        mag_fit_z.append(magSensorData.z);
+        mag_fit.add(magSensorData.x, magSensorData.y, magSensorData.z);
+        startLiveFit();
     } else if (obj->getObjID() == AuxMagSensor::OBJID) {
         AuxMagSensor::DataFields auxMagData = auxMagSensor->getData();
         if (auxMagData.Status == AuxMagSensor::STATUS_OK) {
-            aux_mag_fit_x.append(auxMagData.x);
-            aux_mag_fit_y.append(auxMagData.y);
-            aux_mag_fit_z.append(auxMagData.z);
+            aux_mag_fit.add(auxMagData.x, auxMagData.y, auxMagData.z);
             calibratingAuxMag = true;
         }
     }
 }
 
+/**
+ * Starts a fit of the onboard mag samples so far unless one is running,
+ * must be called with sensorsUpdateLock held.
+ */
+void SixPointCalibrationModel::startLiveFit()
+{
+    if (!liveFit.isRunning()) {
+        liveFit.setFuture(QtConcurrent::run(&SixPointCalibrationModel::computeLiveFit, mag_fit));
+    }
+}
+
+SixPointCalibrationModel::LiveFit SixPointCalibrationModel::computeLiveFit(EllipsoidAccumulator fit)
+{
+    LiveFit live;
+    OpenPilot::CalibrationUtils::EllipsoidCalibrationResult result;
+
+    // the field strength only scales the result, the center and residual do not depend on it
+    live.valid    = fit.solve(1.0f, &result, &live.residual);
+    live.center   = result.Bias;
+    live.coverage = fit.coverage();
+    return live;
+}
+
+void SixPointCalibrationModel::liveFitFinished()
+{
+    LiveFit live = liveFit.result();
+
+    if (!live.valid) {
+        return;
+    }
+    {
+        QMutexLocker lock(&sensorsUpdateLock);
+        // bin the following samples around the better center
+        mag_fit.setCenter(live.center);
+    }
+    magFitChanged(live.coverage * 100, live.residual * 100);
+}
+
 /**
  * Computes the scale and bias for the magnetomer or for the accel.
  * Called once all the data has been collected in 6 positions.
@@ -463,10 +472,10 @@ void SixPointCalibrationModel::compute()
 
         qDebug() << "-----------------------------------";
         qDebug() << "Onboard Mag";
-        calcCalibration(mag_fit_x, mag_fit_y, mag_fit_z, Be_length, revoCalibrationData.mag_transform, revoCalibrationData.mag_bias);
+        calcCalibration(mag_fit, Be_length, revoCalibrationData.mag_transform, revoCalibrationData.mag_bias);
         if (calibratingAuxMag) {
             qDebug() << "Aux Mag";
-            calcCalibration(aux_mag_fit_x, aux_mag_fit_y, aux_mag_fit_z, Be_length, auxCalibrationData.mag_transform, auxCalibrationData.mag_bias);
+            calcCalibration(aux_mag_fit, Be_length, auxCalibrationData.mag_transform, auxCalibrationData.mag_bias);
         }
     }
     // Restore the previous setting
@@ -537,22 +546,24 @@ void SixPointCalibrationModel::compute()
     position = -1;
 }
 
-void SixPointCalibrationModel::calcCalibration(QList<float> x, QList<float> y, QList<float> z, double Be_length, float calibrationMatrix[], float bias[])
+void SixPointCalibrationModel::calcCalibration(const EllipsoidAccumulator & fit, double Be_length, float calibrationMatrix[], float bias[])
 {
-    int vectSize = x.count();
-    Eigen::VectorXf samples_x(vectSize);
-    Eigen::VectorXf samples_y(vectSize);
-    Eigen::VectorXf samples_z(vectSize);
-
-    for (int i = 0; i < vectSize; i++) {
-        samples_x(i) = x[i];
-        samples_y(i) = y[i];
-        samples_z(i) = z[i];
-    }
     OpenPilot::CalibrationUtils::EllipsoidCalibrationResult result;
-    OpenPilot::CalibrationUtils::EllipsoidCalibration(&samples_x, &samples_y, &samples_z, Be_length, &result, true);
+    float residual;
+
+    if (!fit.solve(Be_length, &result, &residual)) {
+        // not enough samples, fails the NAN checks of compute()
+        qDebug() << "Mag fitting failed with" << fit.count() << "samples";
+        for (uint i = 0; i < RevoCalibration::MAG_TRANSFORM_NUMELEM; i++) {
+            calibrationMatrix[i] = NAN;
+        }
+        for (int i = 0; i < 3; i++) {
+            bias[i] = NAN;
+        }
+        return;
+    }
 
-    qDebug() << "Mag fitting results: ";
+    qDebug() << "Mag fitting results: " << fit.count() << "samples, coverage" << fit.coverage() << "residual" << residual;
     qDebug() << "scale(" << result.Scale.coeff(0) << ", " << result.Scale.coeff(1) << ", " << result.Scale.coeff(2) << ")";
     qDebug() << "bias(" << result.Bias.coeff(0) << ", " << result.Bias.coeff(1) << ", " << result.Bias.coeff(2) << ")";
     qDebug() << "-----------------------------------";
@@ -38,8 +38,10 @@
 #include <accelstate.h>
 #include <magsensor.h>
 #include <auxmagsensor.h>
+#include "uavobjectutil/uavobjecthelper.h"
 
 #include <QMutex>
+#include <QFutureWatcher>
 #include <QObject>
 #include <QList>
 #include <QString>
@@ -65,6 +67,8 @@ signals:
     void progressChanged(int value);
     void displayVisualHelp(QString elementID);
     void displayInstructions(QString text, WizardModel::MessageType type = WizardModel::Info);
+    // live quality of the mag fit, coverage of the sphere and RMS deviation from the fitted surface in %
+    void magFitChanged(int coverage, float residual);
 
 public slots:
     void magStart();
@@ -75,6 +79,7 @@ public slots:
 private slots:
     void getSample(UAVObject *obj);
     void continouslyGetMagSamples(UAVObject *obj);
+    void liveFitFinished();
 
 private:
     class CalibrationStep {
@@ -89,9 +94,6 @@ public:
     };
 
     typedef struct {
-        UAVObject::Metadata accelStateMetadata;
-        UAVObject::Metadata magSensorMetadata;
-        UAVObject::Metadata auxMagSensorMetadata;
         AuxMagSettings::DataFields    auxMagSettings;
         RevoCalibration::DataFields   revoCalibrationData;
         AccelGyroSettings::DataFields accelGyroSettingsData;
@@ -103,6 +105,13 @@ public:
         AccelGyroSettings::DataFields accelGyroSettingsData;
     } Result;
 
+    typedef struct {
+        bool  valid;
+        Eigen::Vector3f center;
+        float coverage;
+        float residual;
+    } LiveFit;
+
     bool calibratingMag;
     bool calibratingAuxMag;
     bool calibratingAccel;
@@ -114,6 +123,7 @@ public:
 
     Memento memento;
     Result result;
+    UAVObjectMetadataOverride metadataOverride;
 
     bool collectingData;
     bool m_dirty;
@@ -122,23 +132,18 @@ public:
 
     double accel_data_x[6], accel_data_y[6], accel_data_z[6];
 
-    QList<double> accel_accum_x;
-    QList<double> accel_accum_y;
-    QList<double> accel_accum_z;
+    // sums of the samples of the current position
+    double accel_accum_x, accel_accum_y, accel_accum_z;
+    int accel_accum_count;
+    int mag_accum_count;
 
-    QList<double> mag_accum_x;
-    QList<double> mag_accum_y;
-    QList<double> mag_accum_z;
-    QList<float> mag_fit_x;
-    QList<float> mag_fit_y;
-    QList<float> mag_fit_z;
+    EllipsoidAccumulator mag_fit;
+    EllipsoidAccumulator aux_mag_fit;
 
-    QList<double> aux_mag_accum_x;
-    QList<double> aux_mag_accum_y;
-    QList<double> aux_mag_accum_z;
-    QList<float> aux_mag_fit_x;
-    QList<float> aux_mag_fit_y;
-    QList<float> aux_mag_fit_z;
+    // fits of the mag samples so far, one at a time on a worker thread
+    QFutureWatcher<LiveFit> liveFit;
+    void startLiveFit();
+    static LiveFit computeLiveFit(EllipsoidAccumulator fit);
 
     // convenience pointers
     RevoCalibration *revoCalibration;
@@ -154,7 +159,7 @@ public:
     void compute();
     void showHelp(QString image);
     UAVObjectManager *getObjectManager();
-    void calcCalibration(QList<float> x, QList<float> y, QList<float> z, double Be_length, float calibrationMatrix[], float bias[]);
+    void calcCalibration(const EllipsoidAccumulator & fit, double Be_length, float calibrationMatrix[], float bias[]);
 };
 }
 
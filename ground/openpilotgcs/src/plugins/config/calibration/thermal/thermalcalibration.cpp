@@ -125,6 +125,54 @@ bool ThermalCalibration::GyroscopeCalibration(Eigen::VectorXf samplesX, Eigen::V
     return (inputSigma[0] > calibratedSigma[0]) && (inputSigma[1] > calibratedSigma[1]) && (inputSigma[2] > calibratedSigma[2]);
 }
 
+bool ThermalCalibration::BarometerCalibration(const PolynomialAccumulator & pressure, float refZero, float *result, float *inputSigma, float *calibratedSigma)
+{
+    Eigen::VectorXf solution(BARO_PRESSURE_POLY_DEGREE + 1);
+
+    if (!pressure.solve(solution, BARO_PRESSURE_MAX_REL_ERROR)) {
+        return false;
+    }
+    // fitting the rebiased pressure only moves the constant term
+    solution[0] -= refZero;
+    copyToArray(result, solution, BARO_PRESSURE_POLY_DEGREE + 1);
+    *inputSigma      = pressure.sigma();
+    *calibratedSigma = pressure.residualSigma(solution);
+    return (*calibratedSigma) < (*inputSigma);
+}
+
+bool ThermalCalibration::AccelerometerCalibration(const PolynomialAccumulator samples[3], float *result, float *inputSigma, float *calibratedSigma)
+{
+    const double maxRelError[3] = { ACCEL_X_MAX_REL_ERROR, ACCEL_Y_MAX_REL_ERROR, ACCEL_Z_MAX_REL_ERROR };
+
+    for (int i = 0; i < 3; i++) {
+        Eigen::VectorXf solution(samples[i].degree() + 1);
+        if (!samples[i].solve(solution, maxRelError[i])) {
+            return false;
+        }
+        result[i]          = solution[1];
+        inputSigma[i]      = samples[i].sigma();
+        calibratedSigma[i] = samples[i].residualSigma(solution);
+    }
+    return (inputSigma[0] > calibratedSigma[0]) && (inputSigma[1] > calibratedSigma[1]) && (inputSigma[2] > calibratedSigma[2]);
+}
+
+bool ThermalCalibration::GyroscopeCalibration(const PolynomialAccumulator samples[3], float *result, float *inputSigma, float *calibratedSigma)
+{
+    const double maxRelError[3] = { GYRO_X_MAX_REL_ERROR, GYRO_Y_MAX_REL_ERROR, GYRO_Z_MAX_REL_ERROR };
+
+    for (int i = 0; i < 3; i++) {
+        Eigen::VectorXf solution(samples[i].degree() + 1);
+        if (!samples[i].solve(solution, maxRelError[i])) {
+            return false;
+        }
+        result[2 * i]     = solution[1];
+        result[2 * i + 1] = solution[2];
+        inputSigma[i]      = samples[i].sigma();
+        calibratedSigma[i] = samples[i].residualSigma(solution);
+    }
+    return (inputSigma[0] > calibratedSigma[0]) && (inputSigma[1] > calibratedSigma[1]) && (inputSigma[2] > calibratedSigma[2]);
+}
+
 void ThermalCalibration::copyToArray(float *result, Eigen::VectorXf solution, int elements)
 {
     for (int i = 0; i < elements; i++) {
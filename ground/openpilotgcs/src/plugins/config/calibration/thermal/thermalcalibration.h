@@ -31,6 +31,7 @@
 
 namespace OpenPilot {
 class ThermalCalibration {
+public:
     static const int GYRO_X_POLY_DEGREE  = 2;
     static const int GYRO_Y_POLY_DEGREE  = 2;
     static const int GYRO_Z_POLY_DEGREE  = 2;
@@ -40,6 +41,8 @@ class ThermalCalibration {
     static const int ACCEL_Z_POLY_DEGREE = 1;
 
     static const int BARO_PRESSURE_POLY_DEGREE = 3;
+
+private:
     // TODO: determine max allowable relative error
     static const double BARO_PRESSURE_MAX_REL_ERROR = 1E-6f;
     static const double ACCEL_X_MAX_REL_ERROR  = 1E-6f;
@@ -96,6 +99,23 @@ public:
      */
     static bool GyroscopeCalibration(Eigen::VectorXf samplesX, Eigen::VectorXf samplesY, Eigen::VectorXf samplesZ, Eigen::VectorXf temperature, float *result, float *inputSigma, float *calibratedSigma);
 
+    /**
+     * @brief same as above from pressure over temperature accumulated while sampling
+     * @param pressure accumulator of BARO_PRESSURE_POLY_DEGREE
+     * @param refZero the pressure taken as zero bias, the reading nearest to 20°C
+     */
+    static bool BarometerCalibration(const PolynomialAccumulator & pressure, float refZero, float *result, float *inputSigma, float *calibratedSigma);
+
+    /**
+     * @brief same as above from the x, y and z axis accumulators of ACCEL_*_POLY_DEGREE
+     */
+    static bool AccelerometerCalibration(const PolynomialAccumulator samples[3], float *result, float *inputSigma, float *calibratedSigma);
+
+    /**
+     * @brief same as above from the x, y and z axis accumulators of GYRO_*_POLY_DEGREE
+     */
+    static bool GyroscopeCalibration(const PolynomialAccumulator samples[3], float *result, float *inputSigma, float *calibratedSigma);
+
 
 private:
     static void copyToArray(float *result, Eigen::VectorXf solution, int elements);
@@ -30,6 +30,7 @@
 #include <uavobjectutil/uavobjectutilmanager.h>
 #include <uavtalk/telemetrymanager.h>
 #include "version_info/version_info.h"
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <math.h>
 
@@ -63,6 +64,7 @@ ThermalCalibrationHelper::ThermalCalibrationHelper(QObject *parent) :
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
     connect(telMngr, SIGNAL(disconnected()), this, SLOT(cleanup()));
+    connect(&m_calculation, SIGNAL(finished()), this, SLOT(calculationFinished()));
 }
 
 /**
@@ -71,9 +73,11 @@ ThermalCalibrationHelper::ThermalCalibrationHelper(QObject *parent) :
  */
 bool ThermalCalibrationHelper::setupBoardForCalibration()
 {
-    setMetadataForCalibration(accelSensor);
-    setMetadataForCalibration(gyroSensor);
-    setMetadataForCalibration(baroSensor);
+    m_metadataOverride.clear();
+    m_metadataOverride.setPeriod(accelSensor, 100);
+    m_metadataOverride.setPeriod(gyroSensor, 100);
+    m_metadataOverride.setPeriod(baroSensor, 100);
+    m_metadataOverride.apply();
 
     // Clean up any gyro/accel correction before calibrating
     AccelGyroSettings::DataFields data = accelGyroSettings->getData();
@@ -110,9 +114,6 @@ bool ThermalCalibrationHelper::setupBoardForCalibration()
 bool ThermalCalibrationHelper::saveBoardInitialSettings()
 {
     // Store current board status:
-    m_memento.accelSensorMeta   = accelSensor->getMetadata();
-    m_memento.gyroSensorMeta    = gyroSensor->getMetadata();
-    m_memento.baroensorMeta     = baroSensor->getMetadata();
     m_memento.accelGyroSettings = accelGyroSettings->getData();
     m_memento.revoSettings = revoSettings->getData();
 
@@ -135,9 +136,7 @@ bool ThermalCalibrationHelper::restoreInitialSettings()
         return false;
     }
 
-    accelSensor->setMetadata(m_memento.accelSensorMeta);
-    gyroSensor->setMetadata(m_memento.gyroSensorMeta);
-    baroSensor->setMetadata(m_memento.baroensorMeta);
+    m_metadataOverride.release();
     accelGyroSettings->setData(m_memento.accelGyroSettings);
     revoSettings->setData(m_memento.revoSettings);
 
@@ -180,10 +179,15 @@ void ThermalCalibrationHelper::initAcquisition()
     QMutexLocker lock(&sensorsUpdateLock);
 
     // Clear all samples
-    m_accelSamples.clear();
-    m_gyroSamples.clear();
-    m_baroSamples.clear();
-    m_magSamples.clear();
+    m_fits.baro.reset(ThermalCalibration::BARO_PRESSURE_POLY_DEGREE);
+    m_fits.baroRefZero  = 0;
+    m_fits.baroRefFound = false;
+    m_fits.accel[0].reset(ThermalCalibration::ACCEL_X_POLY_DEGREE);
+    m_fits.accel[1].reset(ThermalCalibration::ACCEL_Y_POLY_DEGREE);
+    m_fits.accel[2].reset(ThermalCalibration::ACCEL_Z_POLY_DEGREE);
+    m_fits.gyro[0].reset(ThermalCalibration::GYRO_X_POLY_DEGREE);
+    m_fits.gyro[1].reset(ThermalCalibration::GYRO_Y_POLY_DEGREE);
+    m_fits.gyro[2].reset(ThermalCalibration::GYRO_Z_POLY_DEGREE);
 
     m_results.accelCalibrated = false;
     m_results.gyroCalibrated  = false;
@@ -219,22 +223,32 @@ void ThermalCalibrationHelper::collectSample(UAVObject *sample)
 
     switch (sample->getObjID()) {
     case AccelSensor::OBJID:
-        m_accelSamples.append(accelSensor->getData());
-        m_debugStream << "ACCEL:: " << m_accelSamples.last().temperature
+    {
+        AccelSensor::DataFields data = accelSensor->getData();
+        m_fits.accel[0].add(data.temperature, data.x);
+        m_fits.accel[1].add(data.temperature, data.y);
+        m_fits.accel[2].add(data.temperature, data.z);
+        m_debugStream << "ACCEL:: " << data.temperature
                       << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_accelSamples.last().x
-                      << "\t" << m_accelSamples.last().y
-                      << "\t" << m_accelSamples.last().z << endl;
+                      << "\t" << data.x
+                      << "\t" << data.y
+                      << "\t" << data.z << endl;
         break;
+    }
 
     case GyroSensor::OBJID:
-        m_gyroSamples.append(gyroSensor->getData());
-        m_debugStream << "GYRO:: " << m_gyroSamples.last().temperature
+    {
+        GyroSensor::DataFields data = gyroSensor->getData();
+        m_fits.gyro[0].add(data.temperature, data.x);
+        m_fits.gyro[1].add(data.temperature, data.y);
+        m_fits.gyro[2].add(data.temperature, data.z);
+        m_debugStream << "GYRO:: " << data.temperature
                       << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_gyroSamples.last().x
-                      << "\t" << m_gyroSamples.last().y
-                      << "\t" << m_gyroSamples.last().z << endl;
+                      << "\t" << data.x
+                      << "\t" << data.y
+                      << "\t" << data.z << endl;
         break;
+    }
 
     case BaroSensor::OBJID:
     {
@@ -244,23 +258,31 @@ void ThermalCalibrationHelper::collectSample(UAVObject *sample)
         data.Temperature = temp;
         data.Pressure   += 10.0f * temp;
 #endif
-        m_baroSamples.append(data);
-        m_debugStream << "BARO:: " << m_baroSamples.last().Temperature
+        m_fits.baro.add(data.Temperature, data.Pressure);
+        // assume the nearest reading to 20°C as the "zero bias" point
+        if (!m_fits.baroRefFound) {
+            m_fits.baroRefZero  = data.Pressure;
+            m_fits.baroRefFound = !(data.Temperature < 20.0f);
+        }
+        m_debugStream << "BARO:: " << data.Temperature
                       << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_baroSamples.last().Pressure
-                      << "\t" << m_baroSamples.last().Altitude << endl;
+                      << "\t" << data.Pressure
+                      << "\t" << data.Altitude << endl;
         // must be done last as this call might end acquisition and close the debug log file
         updateTemperature(temp);
         break;
     }
 
     case MagSensor::OBJID:
-        m_magSamples.append(magSensor->getData());
+    {
+        // not compensated, logged only
+        MagSensor::DataFields data = magSensor->getData();
         m_debugStream << "MAG:: " << "\t" << QDateTime::currentDateTime().toString("hh.mm.ss.zzz")
-                      << "\t" << m_magSamples.last().x
-                      << "\t" << m_magSamples.last().y
-                      << "\t" << m_magSamples.last().z << endl;
+                      << "\t" << data.x
+                      << "\t" << data.y
+                      << "\t" << data.z << endl;
         break;
+    }
 
     default:
         qDebug() << "Unexpected object" << sample->getObjID();
@@ -300,46 +322,48 @@ void ThermalCalibrationHelper::cleanup()
 
 void ThermalCalibrationHelper::calculate()
 {
+    QMutexLocker lock(&sensorsUpdateLock);
+
+    // the solve works on a copy of the fits, away from the UI thread
+    m_calculation.setFuture(QtConcurrent::run(&ThermalCalibrationHelper::computeResults, m_fits));
+}
+
+Results ThermalCalibrationHelper::computeResults(SampleFits fits)
+{
+    Results results = Results();
+
     // baro
-    int count = m_baroSamples.count();
-    Eigen::VectorXf datax(count);
-    Eigen::VectorXf datay(1);
-    Eigen::VectorXf dataz(1);
-    Eigen::VectorXf datat(count);
-
-    for (int x = 0; x < count; x++) {
-        datax[x] = m_baroSamples[x].Pressure;
-        datat[x] = m_baroSamples[x].Temperature;
-    }
+    results.baroCalibrated   = ThermalCalibration::BarometerCalibration(fits.baro, fits.baroRefZero, results.baro,
+                                                                        &results.baroInSigma, &results.baroOutSigma);
+    results.baroTempMin      = fits.baro.minX();
+    results.baroTempMax      = fits.baro.maxX();
+
+    // gyro
+    results.gyroCalibrated   = ThermalCalibration::GyroscopeCalibration(fits.gyro, results.gyro,
+                                                                        results.gyroInSigma, results.gyroOutSigma);
+
+    // accel
+    results.accelGyroTempMin = fits.gyro[0].minX();
+    results.accelGyroTempMax = fits.gyro[0].maxX();
+    // TODO: sanity checks needs to be enforced before accel calibration can be enabled and usable.
+    /*
+       results.accelCalibrated = ThermalCalibration::AccelerometerCalibration(fits.accel, results.accel,
+                                                                             results.accelInSigma, results.accelOutSigma);
+     */
+    results.accelCalibrated  = false;
+    return results;
+}
+
+void ThermalCalibrationHelper::calculationFinished()
+{
+    m_results = m_calculation.result();
 
-    m_results.baroCalibrated = ThermalCalibration::BarometerCalibration(datax, datat, m_results.baro,
-                                                                        &m_results.baroInSigma, &m_results.baroOutSigma);
     if (m_results.baroCalibrated) {
         addInstructions(tr("Barometer is calibrated."));
     } else {
         qDebug() << "Failed to calibrate baro!";
         addInstructions(tr("Failed to calibrate barometer!"), WizardModel::Warn);
     }
-
-    m_results.baroTempMin = datat.array().minCoeff();
-    m_results.baroTempMax = datat.array().maxCoeff();
-
-    // gyro
-    count = m_gyroSamples.count();
-    datax.resize(count);
-    datay.resize(count);
-    dataz.resize(count);
-    datat.resize(count);
-
-    for (int x = 0; x < count; x++) {
-        datax[x] = m_gyroSamples[x].x;
-        datay[x] = m_gyroSamples[x].y;
-        dataz[x] = m_gyroSamples[x].z;
-        datat[x] = m_gyroSamples[x].temperature;
-    }
-
-    m_results.gyroCalibrated = ThermalCalibration::GyroscopeCalibration(datax, datay, dataz, datat, m_results.gyro,
-                                                                        m_results.gyroInSigma, m_results.gyroOutSigma);
     if (m_results.gyroCalibrated) {
         addInstructions(tr("Gyro is calibrated."));
     } else {
@@ -347,27 +371,6 @@ void ThermalCalibrationHelper::calculate()
         addInstructions(tr("Failed to calibrate gyro!"), WizardModel::Warn);
     }
 
-    // accel
-    m_results.accelGyroTempMin = datat.array().minCoeff();
-    m_results.accelGyroTempMax = datat.array().maxCoeff();
-    // TODO: sanity checks needs to be enforced before accel calibration can be enabled and usable.
-    /*
-       count = m_accelSamples.count();
-       datax.resize(count);
-       datay.resize(count);
-       dataz.resize(count);
-       datat.resize(count);
-
-       for(int x = 0; x < count; x++){
-       datax[x] = m_accelSamples[x].x;
-       datay[x] = m_accelSamples[x].y;
-       dataz[x] = m_accelSamples[x].z;
-       datat[x] = m_accelSamples[x].temperature;
-       }
-
-       m_results.accelCalibrated = ThermalCalibration::AccelerometerCalibration(datax, datay, dataz, datat, m_results.accel);
-     */
-    m_results.accelCalibrated  = false;
     QString str = QStringLiteral("INFO::Calibration results") + "\n";
     str += QStringLiteral("INFO::Baro cal {%1, %2, %3, %4}; initial variance: %5; Calibrated variance %6")
            .arg(m_results.baro[0]).arg(m_results.baro[1]).arg(m_results.baro[2]).arg(m_results.baro[3])
@@ -421,6 +424,8 @@ void ThermalCalibrationHelper::updateTemperature(float temp)
 
         m_lastCheckpointTime = QTime::currentTime();
         m_lastCheckpointTemp = m_temperature;
+
+        updateFitResidual();
     }
     // at least a checkpoint has been reached
     if (elapsed > TimeBetweenCheckpoints) {
@@ -455,6 +460,19 @@ void ThermalCalibrationHelper::updateTemperature(float temp)
     }
 }
 
+void ThermalCalibrationHelper::updateFitResidual()
+{
+    float baro[ThermalCalibration::BARO_PRESSURE_POLY_DEGREE + 1];
+    float inSigma  = NAN;
+    float outSigma = NAN;
+
+    // a few small solves every checkpoint, cheap enough for the UI thread
+    ThermalCalibration::BarometerCalibration(m_fits.baro, m_fits.baroRefZero, baro, &inSigma, &outSigma);
+    emit fitResidualChanged(outSigma);
+
+    m_debugStream << "INFO::Trace Baro fit sigma " << inSigma << " compensated " << outSigma << endl;
+}
+
 void ThermalCalibrationHelper::connectUAVOs()
 {
     connect(accelSensor, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(collectSample(UAVObject *)));
@@ -552,15 +570,6 @@ void ThermalCalibrationHelper::copyResultToSettings()
     }
 }
 
-void ThermalCalibrationHelper::setMetadataForCalibration(UAVDataObject *uavo)
-{
-    Q_ASSERT(uavo);
-    UAVObject::Metadata meta = uavo->getMetadata();
-    UAVObject::SetFlightTelemetryUpdateMode(meta, UAVObject::UPDATEMODE_PERIODIC);
-    meta.flightTelemetryUpdatePeriod = 100;
-    uavo->setMetadata(meta);
-}
-
 /**
  * Util function to get a pointer to the object manager
  * @return pointer to the UAVObjectManager
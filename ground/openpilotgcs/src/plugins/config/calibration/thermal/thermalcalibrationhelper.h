@@ -33,6 +33,7 @@
 #include <QTime>
 #include <QTemporaryDir>
 #include <QTextStream>
+#include <QFutureWatcher>
 
 #include "uavobjectmanager.h"
 #include <uavobject.h>
@@ -51,8 +52,10 @@
 #include <accelgyrosettings.h>
 #include <revocalibration.h>
 #include <revosettings.h>
+#include "uavobjectutil/uavobjecthelper.h"
 
 #include "../wizardmodel.h"
+#include "../calibrationutils.h"
 
 namespace OpenPilot {
 typedef struct {
@@ -60,9 +63,6 @@ typedef struct {
     // AccelGyroSettings::DataFields accelGyroSettings;
     RevoSettings::DataFields revoSettings;
     AccelGyroSettings::DataFields accelGyroSettings;
-    UAVObject::Metadata gyroSensorMeta;
-    UAVObject::Metadata accelSensorMeta;
-    UAVObject::Metadata baroensorMeta;
     bool statusSaved;
 } Memento;
 
@@ -88,6 +88,16 @@ typedef struct {
     float accelGyroTempMax;
 } Results;
 
+// everything the calculation needs, built while sampling
+typedef struct {
+    PolynomialAccumulator baro;
+    // pressure of the first reading at or above 20°C, the last one until then
+    float baroRefZero;
+    bool  baroRefFound;
+    PolynomialAccumulator accel[3];
+    PolynomialAccumulator gyro[3];
+} SampleFits;
+
 class ThermalCalibrationHelper : public QObject {
     Q_OBJECT
 
@@ -151,6 +161,8 @@ signals:
     void temperatureChanged(float temperature);
     void temperatureGradientChanged(float temperatureGradient);
     void temperatureRangeChanged(float temperatureRange);
+    // standard deviation of the compensated baro samples, NAN until a fit is possible
+    void fitResidualChanged(float fitResidual);
 
     void progressChanged(int value);
     void progressMaxChanged(int value);
@@ -208,9 +220,13 @@ public slots:
 
     void cleanup();
 
+private slots:
+    void calculationFinished();
+
 private:
     float getTemperature();
     void updateTemperature(float temp);
+    void updateFitResidual();
 
     void connectUAVOs();
     void disconnectUAVOs();
@@ -223,10 +239,9 @@ private:
 
     QMutex sensorsUpdateLock;
 
-    QList<AccelSensor::DataFields> m_accelSamples;
-    QList<GyroSensor::DataFields> m_gyroSamples;
-    QList<BaroSensor::DataFields> m_baroSamples;
-    QList<MagSensor::DataFields> m_magSamples;
+    SampleFits m_fits;
+    QFutureWatcher<Results> m_calculation;
+    static Results computeResults(SampleFits fits);
 
     // temperature checkpoints, used to calculate temp gradient
     const static int TimeBetweenCheckpoints = 10;
@@ -273,8 +288,8 @@ private:
     }
     Memento m_memento;
     Results m_results;
+    UAVObjectMetadataOverride m_metadataOverride;
 
-    void setMetadataForCalibration(UAVDataObject *uavo);
     UAVObjectManager *getObjectManager();
 };
 }
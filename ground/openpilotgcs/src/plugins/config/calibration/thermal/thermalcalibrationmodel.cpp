@@ -38,7 +38,8 @@ ThermalCalibrationModel::ThermalCalibrationModel(QObject *parent) :
     m_startEnabled(false),
     m_cancelEnabled(false),
     m_endEnabled(false),
-    m_dirty(false)
+    m_dirty(false),
+    m_fitResidual(NAN)
 {
     m_helper.reset(new ThermalCalibrationHelper());
 
@@ -63,6 +64,7 @@ ThermalCalibrationModel::ThermalCalibrationModel(QObject *parent) :
     connect(m_helper.data(), SIGNAL(temperatureChanged(float)), this, SLOT(setTemperature(float)));
     connect(m_helper.data(), SIGNAL(temperatureGradientChanged(float)), this, SLOT(setTemperatureGradient(float)));
     connect(m_helper.data(), SIGNAL(temperatureRangeChanged(float)), this, SLOT(setTemperatureRange(float)));
+    connect(m_helper.data(), SIGNAL(fitResidualChanged(float)), this, SLOT(setFitResidual(float)));
     connect(m_helper.data(), SIGNAL(progressChanged(int)), this, SLOT(setProgress(int)));
     connect(m_helper.data(), SIGNAL(progressMaxChanged(int)), this, SLOT(setProgressMax(int)));
     connect(m_helper.data(), SIGNAL(instructionsAdded(QString, WizardModel::MessageType)), this, SLOT(addInstructions(QString, WizardModel::MessageType)));
@@ -84,6 +86,7 @@ void ThermalCalibrationModel::init()
     setTemperature(NAN);
     setTemperatureGradient(NAN);
     setTemperatureRange(NAN);
+    setFitResidual(NAN);
     start();
 }
 
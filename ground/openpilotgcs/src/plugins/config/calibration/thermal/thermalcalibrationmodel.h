@@ -45,6 +45,7 @@ class ThermalCalibrationModel : public WizardModel {
     Q_PROPERTY(float temperature READ temperature NOTIFY temperatureChanged)
     Q_PROPERTY(float temperatureGradient READ temperatureGradient NOTIFY temperatureGradientChanged)
     Q_PROPERTY(float temperatureRange READ temperatureRange NOTIFY temperatureRangeChanged)
+    Q_PROPERTY(float fitResidual READ fitResidual NOTIFY fitResidualChanged)
     Q_PROPERTY(int progress READ progress WRITE setProgress NOTIFY progressChanged)
     Q_PROPERTY(int progressMax READ progressMax WRITE setProgressMax NOTIFY progressMaxChanged)
 
@@ -99,6 +100,11 @@ public:
         return m_helper->range();
     }
 
+    float fitResidual()
+    {
+        return m_fitResidual;
+    }
+
     bool dirty()
     {
         return m_dirty;
@@ -125,6 +131,12 @@ public slots:
         }
     }
 
+    void setFitResidual(float fitResidual)
+    {
+        m_fitResidual = fitResidual;
+        emit fitResidualChanged(fitResidual);
+    }
+
     int progress()
     {
         return m_progress;
@@ -158,6 +170,8 @@ private:
     int m_progress;
     int m_progressMax;
 
+    float m_fitResidual;
+
     // Start from here
     WizardState *m_readyState;
     // this act as top level container for calibration state
@@ -192,6 +206,7 @@ signals:
     void temperatureChanged(float temperature);
     void temperatureGradientChanged(float temperatureGradient);
     void temperatureRangeChanged(float temperatureRange);
+    void fitResidualChanged(float fitResidual);
 
     void progressChanged(int value);
     void progressMaxChanged(int value);
@@ -134,6 +134,7 @@ ConfigRevoWidget::ConfigRevoWidget(QWidget *parent) :
     connect(m_magCalibrationModel, SIGNAL(displayVisualHelp(QString)), this, SLOT(displayVisualHelp(QString)));
     connect(m_magCalibrationModel, SIGNAL(savePositionEnabledChanged(bool)), m_ui->magSavePos, SLOT(setEnabled(bool)));
     connect(m_magCalibrationModel, SIGNAL(progressChanged(int)), m_ui->magProgress, SLOT(setValue(int)));
+    connect(m_magCalibrationModel, SIGNAL(magFitChanged(int, float)), this, SLOT(displayMagFit(int, float)));
     m_ui->magSavePos->setEnabled(false);
 
     // board level calibration
@@ -179,6 +180,7 @@ ConfigRevoWidget::ConfigRevoWidget(QWidget *parent) :
     connect(m_thermalCalibrationModel, SIGNAL(temperatureChanged(float)), this, SLOT(displayTemperature(float)));
     connect(m_thermalCalibrationModel, SIGNAL(temperatureGradientChanged(float)), this, SLOT(displayTemperatureGradient(float)));
     connect(m_thermalCalibrationModel, SIGNAL(temperatureRangeChanged(float)), this, SLOT(displayTemperatureRange(float)));
+    connect(m_thermalCalibrationModel, SIGNAL(fitResidualChanged(float)), this, SLOT(displayFitResidual(float)));
     connect(m_thermalCalibrationModel, SIGNAL(progressChanged(int)), m_ui->thermalBiasProgress, SLOT(setValue(int)));
     connect(m_thermalCalibrationModel, SIGNAL(progressMaxChanged(int)), m_ui->thermalBiasProgress, SLOT(setMaximum(int)));
     m_thermalCalibrationModel->init();
@@ -341,6 +343,16 @@ void ConfigRevoWidget::displayTemperatureRange(float temperatureRange)
     m_ui->temperatureRangeLabel->setText(tr("Sampled range: %1°C").arg(format(temperatureRange)));
 }
 
+void ConfigRevoWidget::displayMagFit(int coverage, float residual)
+{
+    m_ui->magFitLabel->setText(tr("Coverage: %1% Residual: %2%").arg(coverage).arg(format(residual)));
+}
+
+void ConfigRevoWidget::displayFitResidual(float fitResidual)
+{
+    m_ui->fitResidualLabel->setText(tr("Baro fit residual: %1Pa").arg(format(fitResidual)));
+}
+
 /**
  * Called by the ConfigTaskWidget parent when RevoCalibration is updated
  * to update the UI
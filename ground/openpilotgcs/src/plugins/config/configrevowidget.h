@@ -75,6 +75,8 @@ private slots:
     void displayTemperature(float tempareture);
     void displayTemperatureGradient(float temparetureGradient);
     void displayTemperatureRange(float temparetureRange);
+    void displayFitResidual(float fitResidual);
+    void displayMagFit(int coverage, float residual);
 
     // ! Overriden method from the configTaskWidget to update UI
     virtual void refreshWidgetsValues(UAVObject *object = NULL);
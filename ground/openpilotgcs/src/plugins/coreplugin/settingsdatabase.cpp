@@ -30,9 +30,12 @@
 
 #include <QtCore/QDir>
 #include <QtCore/QMap>
+#include <QtCore/QMutex>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QThread>
 #include <QtCore/QVariant>
+#include <QtCore/QWaitCondition>
 
 #include <QtSql/QSqlDatabase>
 #include <QtSql/QSqlError>
@@ -44,9 +47,10 @@
     \brief An alternative to the application-wide QSettings that is more
     suitable for storing large amounts of data.
 
-    The settings database is SQLite based, and lazily retrieves data when it
-    is asked for. It also does incremental updates of the database rather than
-    rewriting the whole file each time one of the settings change.
+    The settings database is SQLite based. All settings are read with a single
+    query when it is opened and then served from memory. Changes are collected
+    and written by a background thread in one transaction, so storing settings
+    never blocks the user interface on the disk.
 
     The SettingsDatabase API mimics that of QSettings.
  */
@@ -60,8 +64,168 @@ namespace Core {
 namespace Internal {
 typedef QMap<QString, QVariant> SettingsMap;
 
+// Changes are committed this long after the first one that is pending
+static const unsigned long WRITE_DELAY_MS = 500;
+
+class SettingsWriter : public QThread {
+public:
+    SettingsWriter(const QString &fileName)
+        : m_fileName(fileName), m_flushRequested(false), m_quit(false), m_written(0), m_queued(0)
+    {}
+
+    void setValue(const QString &key, const QVariant &value)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // a later value of a key replaces a pending one unless a remove came in between
+        QMap<QString, int>::const_iterator i = m_pendingValues.constFind(key);
+        if (i != m_pendingValues.constEnd()) {
+            m_operations[i.value()].value = value;
+        } else {
+            m_pendingValues.insert(key, m_operations.size());
+            m_operations.append(Operation(false, key, value));
+        }
+        queued();
+    }
+
+    void remove(const QString &key)
+    {
+        QMutexLocker locker(&m_mutex);
+
+        m_pendingValues.clear();
+        m_operations.append(Operation(true, key, QVariant()));
+        queued();
+    }
+
+    // Blocks until everything queued so far is on disk
+    void flush()
+    {
+        QMutexLocker locker(&m_mutex);
+
+        const quint64 target = m_queued;
+        m_flushRequested = true;
+        m_wake.wakeOne();
+        while (m_written < target && isRunning()) {
+            m_done.wait(&m_mutex, 100);
+        }
+    }
+
+    void stop()
+    {
+        QMutexLocker locker(&m_mutex);
+
+        m_quit = true;
+        m_wake.wakeOne();
+    }
+
+protected:
+    void run()
+    {
+        {
+            QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", QLatin1String("settingswriter"));
+            db.setDatabaseName(m_fileName);
+            if (!db.open()) {
+                qWarning().nospace() << "Warning: Failed to open settings database for writing at " << m_fileName << " ("
+                                     << db.lastError().driverText() << ")";
+            }
+
+            QMutexLocker locker(&m_mutex);
+            forever {
+                while (m_operations.isEmpty() && !m_quit) {
+                    m_wake.wait(&m_mutex);
+                }
+                // give the rest of a burst of changes time to arrive
+                if (!m_quit && !m_flushRequested) {
+                    m_wake.wait(&m_mutex, WRITE_DELAY_MS);
+                }
+                QList<Operation> operations = m_operations;
+                const quint64 queued = m_queued;
+                m_operations.clear();
+                m_pendingValues.clear();
+                m_flushRequested = false;
+
+                locker.unlock();
+                if (db.isOpen() && !operations.isEmpty()) {
+                    write(db, operations);
+                }
+                locker.relock();
+
+                m_written = queued;
+                m_done.wakeAll();
+                if (m_quit && m_operations.isEmpty()) {
+                    break;
+                }
+            }
+            db.close();
+        }
+        QSqlDatabase::removeDatabase(QLatin1String("settingswriter"));
+    }
+
+private:
+    // called with the mutex held, only the first change of a batch starts the write delay
+    void queued()
+    {
+        if (m_operations.size() == 1) {
+            m_wake.wakeOne();
+        }
+        ++m_queued;
+    }
+
+    struct Operation {
+        Operation(bool r, const QString &k, const QVariant &v) : remove(r), key(k), value(v) {}
+        bool     remove;
+        QString  key;
+        QVariant value;
+    };
+
+    void write(QSqlDatabase &db, const QList<Operation> &operations)
+    {
+        db.transaction();
+
+        QSqlQuery insert(db);
+        insert.prepare(QLatin1String("INSERT INTO settings VALUES (?, ?)"));
+        QSqlQuery remove(db);
+        remove.prepare(QLatin1String("DELETE FROM settings WHERE key = ? OR key LIKE ?"));
+
+        foreach(const Operation &operation, operations) {
+            if (operation.remove) {
+                remove.addBindValue(operation.key);
+                remove.addBindValue(QString(operation.key + QLatin1String("/%")));
+                remove.exec();
+            } else {
+                insert.addBindValue(operation.key);
+                insert.addBindValue(operation.value);
+                insert.exec();
+                if (debug_settings) {
+                    qDebug() << "Stored:" << operation.key << "=" << operation.value;
+                }
+            }
+        }
+
+        if (!db.commit()) {
+            qWarning().nospace() << "Warning: Failed to write settings database! ("
+                                 << db.lastError().driverText() << ")";
+        }
+    }
+
+    QString m_fileName;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    QWaitCondition m_done;
+    QList<Operation> m_operations;
+    // index in m_operations of the pending value of a key
+    QMap<QString, int> m_pendingValues;
+    bool m_flushRequested;
+    bool m_quit;
+    quint64 m_written;
+    quint64 m_queued;
+};
+
 class SettingsDatabasePrivate {
 public:
+    SettingsDatabasePrivate() : m_writer(0) {}
+
     QString effectiveGroup() const
     {
         return m_groups.join(QLatin1String("/"));
@@ -81,9 +245,8 @@ public:
     SettingsMap m_settings;
 
     QStringList m_groups;
-    QStringList m_dirtyKeys;
 
-    QSqlDatabase m_db;
+    SettingsWriter *m_writer;
 };
 } // namespace Internal
 } // namespace Core
@@ -110,37 +273,54 @@ SettingsDatabase::SettingsDatabase(const QString &path,
     fileName += application;
     fileName += QLatin1String(".db");
 
-    d->m_db   = QSqlDatabase::addDatabase("QSQLITE", QLatin1String("settings"));
-    d->m_db.setDatabaseName(fileName);
-    if (!d->m_db.open()) {
-        qWarning().nospace() << "Warning: Failed to open settings database at " << fileName << " ("
-                             << d->m_db.lastError().driverText() << ")";
-    } else {
-        // Create the settings table if it doesn't exist yet
-        QSqlQuery query(d->m_db);
-        query.prepare(QLatin1String("CREATE TABLE IF NOT EXISTS settings ("
-                                    "key PRIMARY KEY ON CONFLICT REPLACE, "
-                                    "value)"));
-        if (!query.exec()) {
-            qWarning().nospace() << "Warning: Failed to prepare settings database! ("
-                                 << query.lastError().driverText() << ")";
-        }
+    bool opened = false;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", QLatin1String("settings"));
+        db.setDatabaseName(fileName);
+        if (!db.open()) {
+            qWarning().nospace() << "Warning: Failed to open settings database at " << fileName << " ("
+                                 << db.lastError().driverText() << ")";
+        } else {
+            opened = true;
+
+            // Create the settings table if it doesn't exist yet
+            QSqlQuery query(db);
+            query.prepare(QLatin1String("CREATE TABLE IF NOT EXISTS settings ("
+                                        "key PRIMARY KEY ON CONFLICT REPLACE, "
+                                        "value)"));
+            if (!query.exec()) {
+                qWarning().nospace() << "Warning: Failed to prepare settings database! ("
+                                     << query.lastError().driverText() << ")";
+            }
 
-        // Retrieve all available keys (values are retrieved lazily)
-        if (query.exec(QLatin1String("SELECT key FROM settings"))) {
-            while (query.next()) {
-                d->m_settings.insert(query.value(0).toString(), QVariant());
+            // Read everything at once, it is served from memory from now on
+            query.setForwardOnly(true);
+            if (query.exec(QLatin1String("SELECT key, value FROM settings"))) {
+                while (query.next()) {
+                    d->m_settings.insert(query.value(0).toString(), query.value(1));
+                }
             }
+            db.close();
         }
     }
+    QSqlDatabase::removeDatabase(QLatin1String("settings"));
+
+    if (opened) {
+        d->m_writer = new SettingsWriter(fileName);
+        d->m_writer->start(QThread::LowPriority);
+    }
 }
 
 SettingsDatabase::~SettingsDatabase()
 {
     sync();
 
+    if (d->m_writer) {
+        d->m_writer->stop();
+        d->m_writer->wait();
+        delete d->m_writer;
+    }
     delete d;
-    QSqlDatabase::removeDatabase(QLatin1String("settings"));
 }
 
 void SettingsDatabase::setValue(const QString &key, const QVariant &value)
@@ -150,50 +330,19 @@ void SettingsDatabase::setValue(const QString &key, const QVariant &value)
     // Add to cache
     d->m_settings.insert(effectiveKey, value);
 
-    if (!d->m_db.isOpen()) {
-        return;
-    }
-
-    // Instant apply (TODO: Delay writing out settings)
-    QSqlQuery query(d->m_db);
-    query.prepare(QLatin1String("INSERT INTO settings VALUES (?, ?)"));
-    query.addBindValue(effectiveKey);
-    query.addBindValue(value);
-    query.exec();
-
-    if (debug_settings) {
-        qDebug() << "Stored:" << effectiveKey << "=" << value;
+    if (d->m_writer) {
+        d->m_writer->setValue(effectiveKey, value);
     }
 }
 
 QVariant SettingsDatabase::value(const QString &key, const QVariant &defaultValue) const
 {
-    const QString effectiveKey    = d->effectiveKey(key);
-    QVariant value = defaultValue;
-
-    SettingsMap::const_iterator i = d->m_settings.constFind(effectiveKey);
+    SettingsMap::const_iterator i = d->m_settings.constFind(d->effectiveKey(key));
 
     if (i != d->m_settings.constEnd() && i.value().isValid()) {
-        value = i.value();
-    } else if (d->m_db.isOpen()) {
-        // Try to read the value from the database
-        QSqlQuery query(d->m_db);
-        query.prepare(QLatin1String("SELECT value FROM settings WHERE key = ?"));
-        query.addBindValue(effectiveKey);
-        query.exec();
-        if (query.next()) {
-            value = query.value(0);
-
-            if (debug_settings) {
-                qDebug() << "Retrieved:" << effectiveKey << "=" << value;
-            }
-        }
-
-        // Cache the result
-        d->m_settings.insert(effectiveKey, value);
+        return i.value();
     }
-
-    return value;
+    return defaultValue;
 }
 
 bool SettingsDatabase::contains(const QString &key) const
@@ -215,16 +364,9 @@ void SettingsDatabase::remove(const QString &key)
         }
     }
 
-    if (!d->m_db.isOpen()) {
-        return;
+    if (d->m_writer) {
+        d->m_writer->remove(effectiveKey);
     }
-
-    // Delete keys from the database
-    QSqlQuery query(d->m_db);
-    query.prepare(QLatin1String("DELETE FROM settings WHERE key = ? OR key LIKE ?"));
-    query.addBindValue(effectiveKey);
-    query.addBindValue(QString(effectiveKey + QLatin1String("/%")));
-    query.exec();
 }
 
 void SettingsDatabase::beginGroup(const QString &prefix)
@@ -259,7 +401,12 @@ QStringList SettingsDatabase::childKeys() const
     return childs;
 }
 
+/*!
+    Writes the pending changes and returns once they are stored.
+ */
 void SettingsDatabase::sync()
 {
-    // TODO: Delay writing of dirty keys and save them here
+    if (d->m_writer) {
+        d->m_writer->flush();
+    }
 }
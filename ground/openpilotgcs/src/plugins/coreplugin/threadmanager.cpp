@@ -42,6 +42,11 @@ ThreadManager::ThreadManager(QObject *parent) : QObject(parent)
 
 ThreadManager::~ThreadManager()
 {
+    foreach(QThread * thread, linkThreads) {
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
     realTimeThread->quit();
     realTimeThread->wait();
     m_instance = 0;
@@ -51,3 +56,22 @@ QThread *ThreadManager::getRealTimeThread()
 {
     return realTimeThread;
 }
+
+/**
+ * A real time thread of its own for a link, created on first use.
+ * Links on separate threads cannot delay each other, the main
+ * telemetry link stays on the real time thread.
+ */
+QThread *ThreadManager::getLinkThread(const QString &name)
+{
+    QMutexLocker locker(&linkThreadsMutex);
+    QThread *thread = linkThreads.value(name);
+
+    if (!thread) {
+        thread = new QThread();
+        thread->setObjectName(name);
+        thread->start(QThread::TimeCriticalPriority);
+        linkThreads.insert(name, thread);
+    }
+    return thread;
+}
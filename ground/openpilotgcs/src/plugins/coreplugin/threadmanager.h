@@ -33,6 +33,8 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QThread>
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
 
 QT_BEGIN_NAMESPACE
     QT_END_NAMESPACE
@@ -51,10 +53,13 @@ public:
     }
 
     QThread *getRealTimeThread();
+    QThread *getLinkThread(const QString &name);
 
 
 private:
     QThread *realTimeThread;
+    QMap<QString, QThread *> linkThreads;
+    QMutex linkThreadsMutex;
     static ThreadManager *m_instance;
 };
 } // namespace Core
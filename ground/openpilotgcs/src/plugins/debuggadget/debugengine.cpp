@@ -1,8 +1,57 @@
 #include "debugengine.h"
 
-debugengine::debugengine()
+#include <QScrollBar>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QTextStream>
+#include <stdlib.h>
+
+bool LogFileWriter::open(const QString &fileName)
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_file.close();
+    m_file.setFileName(fileName);
+    return m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+}
+
+void LogFileWriter::close()
 {
-    mut_lock = new QMutex(QMutex::Recursive);
+    QMutexLocker lock(&m_mutex);
+
+    m_file.close();
+}
+
+void LogFileWriter::write(const QStringList &lines)
+{
+    QMutexLocker lock(&m_mutex);
+
+    if (m_file.isOpen()) {
+        QTextStream stream(&m_file);
+        foreach(const QString &line, lines) {
+            stream << line << '\n';
+        }
+        stream.flush();
+    }
+}
+
+debugengine::debugengine() :
+    m_ring(RING_SIZE),
+    m_head(0),
+    m_count(0),
+    m_dropped(0),
+    m_minimumLevel(QtDebugMsg),
+    m_flushTimer(new QTimer(this)),
+    m_writer(new LogFileWriter),
+    m_logging(false),
+    m_previousHandler(0)
+{
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(FLUSH_PERIOD_MS);
+    connect(m_flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    m_writer->moveToThread(&m_writerThread);
+    connect(this, SIGNAL(writeLines(QStringList)), m_writer, SLOT(write(QStringList)));
 }
 
 debugengine *debugengine::getInstance()
@@ -14,31 +63,172 @@ debugengine *debugengine::getInstance()
 
 debugengine::~debugengine()
 {
-    delete mut_lock;
-    mut_lock = NULL;
+    uninstall();
+    delete m_writer;
 }
 
-void debugengine::setTextEdit(QTextBrowser *textEdit)
+void debugengine::install()
+{
+    m_writerThread.start(QThread::LowPriority);
+    m_previousHandler = qInstallMessageHandler(messageHandler);
+}
+
+void debugengine::uninstall()
+{
+    if (m_writerThread.isRunning()) {
+        qInstallMessageHandler(m_previousHandler);
+        m_writerThread.quit();
+        m_writerThread.wait();
+    }
+}
+
+void debugengine::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    debugengine *engine = getInstance();
+
+    if (engine->m_previousHandler) {
+        engine->m_previousHandler(type, context, msg);
+    }
+
+    if (engine->accepts(type, context.category)) {
+        QString txt;
+        switch (type) {
+        case QtDebugMsg:
+            txt = QString("Debug: %1").arg(msg);
+            break;
+        case QtWarningMsg:
+            txt = QString("Warning: %1").arg(msg);
+            break;
+        case QtCriticalMsg:
+            txt = QString("Critical: %1").arg(msg);
+            break;
+        case QtFatalMsg:
+            txt = QString("Fatal: %1").arg(msg);
+            break;
+        }
+        engine->writeMessage(type, txt);
+    }
+
+    if (type == QtFatalMsg) {
+        abort();
+    }
+}
+
+bool debugengine::accepts(QtMsgType type, const char *category)
 {
-    QMutexLocker lock(mut_lock);
+    QMutexLocker lock(&m_mutex);
+
+    if (type < m_minimumLevel) {
+        return false;
+    }
+    return m_hiddenCategories.isEmpty() || category == NULL || !m_hiddenCategories.contains(QLatin1String(category));
+}
 
+void debugengine::setTextEdit(QTextBrowser *textEdit)
+{
     _textEdit = textEdit;
 }
 
-void debugengine::writeMessage(const QString &message)
+void debugengine::setMinimumLevel(QtMsgType level)
 {
-    QMutexLocker lock(mut_lock);
+    QMutexLocker lock(&m_mutex);
 
-    if (_textEdit) {
-        _textEdit->append(message);
+    m_minimumLevel = level;
+}
+
+void debugengine::setHiddenCategories(const QStringList &categories)
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_hiddenCategories = categories;
+}
+
+bool debugengine::setLogFile(const QString &fileName)
+{
+    if (fileName.isEmpty()) {
+        m_logging = false;
+        m_writer->close();
+        return true;
     }
+    m_logging = m_writer->open(fileName);
+    return m_logging;
 }
 
-void debugengine::setColor(const QColor &c)
+/**
+ * Called from any thread. The oldest message is dropped when the ring is full.
+ */
+void debugengine::writeMessage(QtMsgType type, const QString &message)
 {
-    QMutexLocker lock(mut_lock);
+    bool wasEmpty;
+    {
+        QMutexLocker lock(&m_mutex);
+
+        wasEmpty = (m_count == 0 && m_dropped == 0);
+        Message &slot = m_ring[(m_head + m_count) % RING_SIZE];
+        slot.type = type;
+        slot.text = message;
+        if (m_count == RING_SIZE) {
+            m_head = (m_head + 1) % RING_SIZE;
+            ++m_dropped;
+        } else {
+            ++m_count;
+        }
+    }
+    // The timer belongs to the GUI thread
+    if (wasEmpty) {
+        QMetaObject::invokeMethod(m_flushTimer, "start", Qt::QueuedConnection);
+    }
+}
+
+void debugengine::flush()
+{
+    QVector<Message> batch;
+    quint32 dropped;
+    {
+        QMutexLocker lock(&m_mutex);
+
+        batch.reserve(m_count);
+        for (; m_count > 0; --m_count) {
+            batch.append(m_ring[m_head]);
+            m_ring[m_head].text.clear();
+            m_head = (m_head + 1) % RING_SIZE;
+        }
+        dropped   = m_dropped;
+        m_dropped = 0;
+    }
+
+    QStringList lines;
+    if (dropped > 0) {
+        lines << QString("Warning: %1 messages dropped").arg(dropped);
+    }
+    foreach(const Message &message, batch) {
+        lines << message.text;
+    }
 
     if (_textEdit) {
-        _textEdit->setTextColor(c);
+        QTextDocument *document = _textEdit->document();
+        QTextCursor cursor(document);
+        QTextCharFormat format;
+        bool first = document->isEmpty();
+
+        cursor.movePosition(QTextCursor::End);
+        cursor.beginEditBlock();
+        for (int i = 0; i < lines.size(); ++i) {
+            QtMsgType type = (dropped > 0 && i == 0) ? QtWarningMsg : batch[i - (dropped > 0 ? 1 : 0)].type;
+            format.setForeground((type == QtDebugMsg) ? Qt::black : Qt::red);
+            if (!first) {
+                cursor.insertBlock();
+            }
+            first = false;
+            cursor.insertText(lines[i], format);
+        }
+        cursor.endEditBlock();
+
+        QScrollBar *sb = _textEdit->verticalScrollBar();
+        sb->setValue(sb->maximum());
+    }
+
+    if (m_logging) {
+        emit writeLines(lines);
     }
 }
@@ -3,19 +3,89 @@
 #include <QTextBrowser>
 #include <QPointer>
 #include <QMutex>
+#include <QFile>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
 
-class debugengine {
+/**
+ * Appends the lines it is given to a file, from a thread of its own.
+ */
+class LogFileWriter : public QObject {
+    Q_OBJECT
+public:
+    bool open(const QString &fileName);
+    void close();
+public slots:
+    void write(const QStringList &lines);
+private:
+    QMutex m_mutex;
+    QFile m_file;
+};
+
+/**
+ * Sink of the GCS debug messages. The message handler drops the messages
+ * below the level shown or of a hidden category before formatting them,
+ * and pushes the others into a bounded ring, from any thread. The GUI
+ * thread drains the ring at most once per FLUSH_PERIOD_MS: the batch is
+ * added to the text browser in a single edit and handed to the log file
+ * writer. When the messages come faster than that the oldest are dropped,
+ * and counted.
+ */
+class debugengine : public QObject {
+    Q_OBJECT
 // Add all missing constructor etc... to have singleton
     debugengine();
     ~debugengine();
 public:
     static debugengine *getInstance();
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
+
+    // Installs the message handler, the previous one still gets the messages
+    void install();
+    void uninstall();
+
     void setTextEdit(QTextBrowser *textEdit);
-    void writeMessage(const QString &message);
-    void setColor(const QColor &c);
-    QMutex *mut_lock;
+    void setMinimumLevel(QtMsgType level);
+    void setHiddenCategories(const QStringList &categories);
+    // Logs the messages to the file too, an empty name stops
+    bool setLogFile(const QString &fileName);
+
+    void writeMessage(QtMsgType type, const QString &message);
+
+signals:
+    void writeLines(const QStringList &lines);
+
+private slots:
+    void flush();
+
 private:
+    struct Message {
+        QtMsgType type;
+        QString text;
+    };
+
+    static const int RING_SIZE = 4096;
+    static const int FLUSH_PERIOD_MS = 40;
+
+    // Guards the ring and the filter, never held while formatting or drawing
+    QMutex m_mutex;
+    QVector<Message> m_ring;
+    int m_head;
+    int m_count;
+    quint32 m_dropped;
+    int m_minimumLevel;
+    QStringList m_hiddenCategories;
+
     QPointer<QTextBrowser> _textEdit;
+    QTimer *m_flushTimer;
+    QThread m_writerThread;
+    LogFileWriter *m_writer;
+    bool m_logging;
+    QtMessageHandler m_previousHandler;
+
+    bool accepts(QtMsgType type, const char *category);
 };
 
 #endif // DEBUGENGINE_H
@@ -39,49 +39,16 @@
 #include <QScrollBar>
 #include <QTime>
 
-QPointer<QTextBrowser> m_textedit;
-
-void DebugGadgetWidget::customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
-{
-    Q_UNUSED(context);
-    QString txt;
-    QColor color = Qt::black;
-
-    switch (type) {
-    case QtDebugMsg:
-        txt   = QString("Debug: %1").arg(msg);
-        color = Qt::black;
-        break;
-    case QtWarningMsg:
-        txt   = QString("Warning: %1").arg(msg);
-        color = Qt::red;
-        break;
-    case QtCriticalMsg:
-        txt   = QString("Critical: %1").arg(msg);
-        color = Qt::red;
-        break;
-    case QtFatalMsg:
-        txt   = QString("Fatal: %1").arg(msg);
-        abort();
-    }
-
-    debugengine::getInstance()->setTextEdit(m_textedit);
-    debugengine::getInstance()->setColor(color);
-    debugengine::getInstance()->writeMessage(txt);
-}
-
 DebugGadgetWidget::DebugGadgetWidget(QWidget *parent) : QLabel(parent)
 {
     m_config = new Ui_Form();
     m_config->setupUi(this);
 
-    // m_textedit = m_config->plainTextEdit;
-    // MyplainTextEdit=m_config->plainTextEdit;
-    // debugengine *de = new debugengine();
-    // qInstallMessageHandler(customMessageHandler);
-    // connect(de, SIGNAL(dbgMsg(QString, QList<QVariant>)), this, SLOT(dbgMsg(QString, QList<QVariant>)));
-    // connect(de, SIGNAL(dbgMsgError(QString, QList<QVariant>)), this, SLOT(dbgMsgError(QString, QList<QVariant>)));
+    m_config->plainTextEdit->document()->setMaximumBlockCount(MAX_LINES);
+    debugengine::getInstance()->setTextEdit(m_config->plainTextEdit);
     connect(m_config->pushButton, SIGNAL(clicked()), this, SLOT(saveLog()));
+    connect(m_config->logFileCheckBox, SIGNAL(toggled(bool)), this, SLOT(logToFile(bool)));
+    connect(m_config->levelComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(setLevel(int)));
 }
 
 DebugGadgetWidget::~DebugGadgetWidget()
@@ -109,6 +76,30 @@ void DebugGadgetWidget::dbgMsgError(const QString &level, const QList<QVariant>
     QScrollBar *sb = m_config->plainTextEdit->verticalScrollBar();
     sb->setValue(sb->maximum());
 }
+void DebugGadgetWidget::logToFile(bool enable)
+{
+    if (!enable) {
+        debugengine::getInstance()->setLogFile(QString());
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(0, tr("Log to File"), "", tr("Text files (*.txt *.log)"));
+    if (fileName.isEmpty() || !debugengine::getInstance()->setLogFile(fileName)) {
+        if (!fileName.isEmpty()) {
+            QMessageBox::critical(0, tr("Log to File"), tr("Unable to open log: ") + fileName, QMessageBox::Ok);
+        }
+        m_config->logFileCheckBox->blockSignals(true);
+        m_config->logFileCheckBox->setChecked(false);
+        m_config->logFileCheckBox->blockSignals(false);
+    }
+}
+
+// The combo box items are in the order of QtMsgType
+void DebugGadgetWidget::setLevel(int level)
+{
+    debugengine::getInstance()->setMinimumLevel((QtMsgType)level);
+}
+
 void DebugGadgetWidget::saveLog()
 {
     QString fileName = QFileDialog::getSaveFileName(0, tr("Save log File As"), "");
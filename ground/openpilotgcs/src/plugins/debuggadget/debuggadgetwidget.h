@@ -37,11 +37,15 @@ class DebugGadgetWidget : public QLabel {
 public:
     DebugGadgetWidget(QWidget *parent = 0);
     ~DebugGadgetWidget();
-    static void customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
 private:
+    // Lines kept in the view, the oldest are removed
+    static const int MAX_LINES = 10000;
+
     Ui_Form *m_config;
 private slots:
     void saveLog();
+    void logToFile(bool enable);
+    void setLevel(int level);
     void dbgMsgError(const QString & level, const QList<QVariant> & msgs);
     void dbgMsg(const QString & level, const QList<QVariant> & msgs);
 };
@@ -26,6 +26,7 @@
  */
 #include "debugplugin.h"
 #include "debuggadgetfactory.h"
+#include "debugengine.h"
 #include <QDebug>
 #include <QtPlugin>
 #include <QStringList>
@@ -48,6 +49,7 @@ bool DebugPlugin::initialize(const QStringList & args, QString *errMsg)
     Q_UNUSED(errMsg);
     mf = new DebugGadgetFactory(this);
     addAutoReleasedObject(mf);
+    debugengine::getInstance()->install();
 
     return true;
 }
@@ -59,5 +61,5 @@ void DebugPlugin::extensionsInitialized()
 
 void DebugPlugin::shutdown()
 {
-    // Do nothing
+    debugengine::getInstance()->uninstall();
 }
@@ -53,7 +53,7 @@ DialGadgetConfiguration::DialGadgetConfiguration(QString classId, QSettings *qSe
     needle1Move("Rotate"),
     needle2Move("Rotate"),
     needle3Move("Rotate"),
-    useOpenGLFlag(false),
+    useOpenGLFlag(true),
     beSmooth(true)
 {
     // if a saved configuration exists load it
@@ -85,7 +85,7 @@ DialGadgetConfiguration::DialGadgetConfiguration(QString classId, QSettings *qSe
         needle2Move   = qSettings->value("needle2Move").toString();
         needle3Move   = qSettings->value("needle3Move").toString();
         font = qSettings->value("font").toString();
-        useOpenGLFlag = qSettings->value("useOpenGLFlag").toBool();
+        useOpenGLFlag = qSettings->value("useOpenGLFlag", true).toBool();
         beSmooth = qSettings->value("beSmooth").toBool();
     }
 }
@@ -28,6 +28,7 @@
 
 #include "dialgadgetwidget.h"
 #include <utils/stylehelper.h>
+#include <utils/cachedsvgitem.h>
 #include <iostream>
 #include <QtOpenGL/QGLWidget>
 #include <QDebug>
@@ -44,9 +45,10 @@ DialGadgetWidget::DialGadgetWidget(QWidget *parent) : QGraphicsView(parent)
 
     m_renderer = new QSvgRenderer();
 
-    obj1    = NULL;
-    obj2    = NULL;
-    obj3    = NULL;
+    connect(&needle1Binding, SIGNAL(updated()), this, SLOT(updateNeedle1()));
+    connect(&needle2Binding, SIGNAL(updated()), this, SLOT(updateNeedle2()));
+    connect(&needle3Binding, SIGNAL(updated()), this, SLOT(updateNeedle3()));
+
     m_text1 = NULL;
     m_text2 = NULL;
     m_text3 = NULL; // Should be initialized to NULL otherwise the setFont method
@@ -87,154 +89,49 @@ void DialGadgetWidget::connectNeedles(QString object1, QString nfield1,
                                       QString object2, QString nfield2,
                                       QString object3, QString nfield3)
 {
-    if (obj1 != NULL) {
-        disconnect(obj1, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateNeedle1(UAVObject *)));
-    }
-    if (obj2 != NULL) {
-        disconnect(obj2, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateNeedle2(UAVObject *)));
-    }
-    if (obj3 != NULL) {
-        disconnect(obj3, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateNeedle3(UAVObject *)));
-    }
-
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
-    // Check validity of arguments first, reject empty args and unknown fields.
-    if (!(object1.isEmpty() || nfield1.isEmpty())) {
-        obj1 = dynamic_cast<UAVDataObject *>(objManager->getObject(object1));
-        if (obj1 != NULL) {
-            // qDebug() << "Connected Object 1 (" << object1 << ").";
-            connect(obj1, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateNeedle1(UAVObject *)));
-            if (nfield1.contains("-")) {
-                QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
-                field1        = fieldSubfield.at(0);
-                subfield1     = fieldSubfield.at(1);
-                haveSubField1 = true;
-            } else {
-                field1 = nfield1;
-                haveSubField1 = false;
-            }
-        } else {
-            qDebug() << "Error: Object is unknown (" << object1 << ").";
-        }
-    }
-
-    // And do the same for the second needle.
-    if (!(object2.isEmpty() || nfield2.isEmpty())) {
-        obj2 = dynamic_cast<UAVDataObject *>(objManager->getObject(object2));
-        if (obj2 != NULL) {
-            // qDebug() << "Connected Object 2 (" << object2 << ").";
-            connect(obj2, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateNeedle2(UAVObject *)));
-            if (nfield2.contains("-")) {
-                QStringList fieldSubfield = nfield2.split("-", QString::SkipEmptyParts);
-                field2        = fieldSubfield.at(0);
-                subfield2     = fieldSubfield.at(1);
-                haveSubField2 = true;
-            } else {
-                field2 = nfield2;
-                haveSubField2 = false;
-            }
-        } else {
-            qDebug() << "Error: Object is unknown (" << object2 << ").";
-        }
-    }
-
-    // And do the same for the third needle.
-    if (!(object3.isEmpty() || nfield3.isEmpty())) {
-        obj3 = dynamic_cast<UAVDataObject *>(objManager->getObject(object3));
-        if (obj3 != NULL) {
-            // qDebug() << "Connected Object 3 (" << object3 << ").";
-            connect(obj3, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateNeedle3(UAVObject *)));
-            if (nfield3.contains("-")) {
-                QStringList fieldSubfield = nfield3.split("-", QString::SkipEmptyParts);
-                field3        = fieldSubfield.at(0);
-                subfield3     = fieldSubfield.at(1);
-                haveSubField3 = true;
-            } else {
-                field3 = nfield3;
-                haveSubField3 = false;
-            }
-        } else {
-            qDebug() << "Error: Object is unknown (" << object3 << ").";
-        }
-    }
+    // Empty arguments leave the needle unbound, unknown ones are reported by the binding
+    needle1Binding.bind(objManager, object1, nfield1);
+    needle2Binding.bind(objManager, object2, nfield2);
+    needle3Binding.bind(objManager, object3, nfield3);
 }
 
 /*!
-   \brief Called by the UAVObject which got updated
+   \brief Called by the binding of the needle when its object got updated
  */
-void DialGadgetWidget::updateNeedle1(UAVObject *object1)
+void DialGadgetWidget::updateNeedle1()
 {
-    // Double check that the field exists:
-    double value;
-    UAVObjectField *field = object1->getField(field1);
-
-    if (field) {
-        if (haveSubField1) {
-            int indexOfSubField = field->getElementNames().indexOf(QRegExp(subfield1, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else {
-            value = field->getDouble();
-        }
-        if (value != value) {
-            qDebug() << "Dial widget: encountered NaN !!";
-            return;
-        }
-        setNeedle1(value);
-    } else {
-        qDebug() << "Wrong field, maybe an issue with object disconnection ?";
+    double value = needle1Binding.getDouble();
+
+    if (value != value) {
+        qDebug() << "Dial widget: encountered NaN !!";
+        return;
     }
+    setNeedle1(value);
 }
 
-/*!
-   \brief Called by the UAVObject which got updated
- */
-void DialGadgetWidget::updateNeedle2(UAVObject *object2)
+void DialGadgetWidget::updateNeedle2()
 {
-    double value;
-    UAVObjectField *field = object2->getField(field2);
+    double value = needle2Binding.getDouble();
 
-    if (field) {
-        if (haveSubField2) {
-            int indexOfSubField = field->getElementNames().indexOf(QRegExp(subfield2, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else {
-            value = field->getDouble();
-        }
-        if (value != value) {
-            qDebug() << "Dial widget: encountered NaN !!";
-            return;
-        }
-        setNeedle2(value);
-    } else {
-        qDebug() << "Wrong field, maybe an issue with object disconnection ?";
+    if (value != value) {
+        qDebug() << "Dial widget: encountered NaN !!";
+        return;
     }
+    setNeedle2(value);
 }
 
-/*!
-   \brief Called by the UAVObject which got updated
- */
-void DialGadgetWidget::updateNeedle3(UAVObject *object3)
+void DialGadgetWidget::updateNeedle3()
 {
-    double value;
-    UAVObjectField *field = object3->getField(field3);
+    double value = needle3Binding.getDouble();
 
-    if (field) {
-        if (haveSubField3) {
-            int indexOfSubField = field->getElementNames().indexOf(QRegExp(subfield3, Qt::CaseSensitive, QRegExp::FixedString));
-            value = field->getDouble(indexOfSubField);
-        } else {
-            value = field->getDouble();
-        }
-        if (value != value) {
-            qDebug() << "Dial widget: encountered NaN !!";
-            return;
-        }
-        setNeedle3(value);
-    } else {
-        qDebug() << "Wrong field, maybe an issue with object disconnection ?";
+    if (value != value) {
+        qDebug() << "Dial widget: encountered NaN !!";
+        return;
     }
+    setNeedle3(value);
 }
 
 /*
@@ -251,14 +148,14 @@ void DialGadgetWidget::setDialFile(QString dfn, QString bg, QString fg, QString
     setBackgroundBrush(QBrush(Utils::StyleHelper::baseColor()));
     if (QFile::exists(dfn) && m_renderer->load(dfn) && m_renderer->isValid()) {
         l_scene->clear(); // This also deletes all items contained in the scene.
-        m_background = new QGraphicsSvgItem();
+        m_background = new CachedSvgItem();
         // All other items will be clipped to the shape of the background
         m_background->setFlags(QGraphicsItem::ItemClipsChildrenToShape |
                                QGraphicsItem::ItemClipsToShape);
-        m_foreground = new QGraphicsSvgItem();
-        m_needle1    = new QGraphicsSvgItem();
-        m_needle2    = new QGraphicsSvgItem();
-        m_needle3    = new QGraphicsSvgItem();
+        m_foreground = new CachedSvgItem();
+        m_needle1    = new CachedSvgItem();
+        m_needle2    = new CachedSvgItem();
+        m_needle3    = new CachedSvgItem();
         m_needle1->setParentItem(m_background);
         m_needle2->setParentItem(m_background);
         m_needle3->setParentItem(m_background);
@@ -428,7 +325,7 @@ void DialGadgetWidget::setDialFile(QString dfn, QString bg, QString fg, QString
         qDebug() << "no file: display default background.";
         m_renderer->load(QString(":/dial/images/empty.svg"));
         l_scene->clear(); // This also deletes all items contained in the scene.
-        m_background = new QGraphicsSvgItem();
+        m_background = new CachedSvgItem();
         m_background->setSharedRenderer(m_renderer);
         l_scene->addItem(m_background);
         m_text1   = NULL;
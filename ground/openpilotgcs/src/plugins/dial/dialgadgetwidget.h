@@ -33,6 +33,7 @@
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include "uavobject.h"
+#include "uavobjectfieldbinding.h"
 #include <QGraphicsView>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
@@ -102,9 +103,9 @@ public:
     void setDialFont(QString fontProps);
 
 public slots:
-    void updateNeedle1(UAVObject *object1); // Called by the UAVObject
-    void updateNeedle2(UAVObject *object2); // Called by the UAVObject
-    void updateNeedle3(UAVObject *object3); // Called by the UAVObject
+    void updateNeedle1(); // Called by the binding
+    void updateNeedle2(); // Called by the binding
+    void updateNeedle3(); // Called by the binding
 
 protected:
     void paintEvent(QPaintEvent *event);
@@ -160,19 +161,10 @@ private:
     double needle3Target;
     double needle3Value;
 
-    // Name of the fields to read when an update is received:
-    UAVDataObject *obj1;
-    UAVDataObject *obj2;
-    UAVDataObject *obj3;
-    QString field1;
-    QString subfield1;
-    bool haveSubField1;
-    QString field2;
-    QString subfield2;
-    bool haveSubField2;
-    QString field3;
-    QString subfield3;
-    bool haveSubField3;
+    // Fields to read when an update is received:
+    UAVObjectFieldBinding needle1Binding;
+    UAVObjectFieldBinding needle2Binding;
+    UAVObjectFieldBinding needle3Binding;
 
     // Rotation timer
     QTimer dialTimer;
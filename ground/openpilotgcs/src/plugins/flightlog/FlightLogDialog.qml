@@ -148,6 +148,24 @@ Rectangle {
                                 onClicked: logManager.retrieveLogs(flightCombo.currentIndex - 1)
                             }
                         }
+                        RowLayout {
+                            spacing: 10
+                            Rectangle {
+                                Layout.fillWidth: true
+                            }
+                            Button {
+                                text: qsTr("Start trace")
+                                enabled: !logManager.disableControls && logManager.boardConnected
+                                activeFocusOnPress: true
+                                onClicked: logManager.startTrace(false)
+                            }
+                            Button {
+                                text: qsTr("Export trace...")
+                                enabled: !logManager.disableControls && logManager.boardConnected
+                                activeFocusOnPress: true
+                                onClicked: logManager.exportTrace()
+                            }
+                        }
                         Rectangle {
                             Layout.fillHeight: true
                         }
@@ -32,19 +32,34 @@
 #include <QFileDialog>
 #include <QXmlStreamReader>
 #include <QMessageBox>
+#include <QEventLoop>
+#include <QTimer>
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QSet>
+#include <QtEndian>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include "debuglogcontrol.h"
+#include "taskinfo.h"
+#include "callbackinfo.h"
+#include "perfcounter.h"
 #include "uavobjecthelper.h"
 #include "uavtalk/uavtalk.h"
 #include "utils/logfile.h"
+#include "utils/crc.h"
 #include "uavdataobject.h"
 #include <uavobjectutil/uavobjectutilmanager.h>
 
 FlightLogManager::FlightLogManager(QObject *parent) :
     QObject(parent), m_disableControls(false),
     m_disableExport(true), m_cancelDownload(false),
-    m_adjustExportedTimestamps(true)
+    m_adjustExportedTimestamps(true), m_streaming(false),
+    m_streamFlight(0), m_streamFirst(0), m_traceStreaming(false),
+    m_traceFirst(0), m_traceCount(0)
 {
     ExtensionSystem::PluginManager *pluginManager = ExtensionSystem::PluginManager::instance();
 
@@ -59,6 +74,9 @@ FlightLogManager::FlightLogManager(QObject *parent) :
     m_objectUtilManager = pluginManager->getObject<UAVObjectUtilManager>();
     Q_ASSERT(m_objectUtilManager);
 
+    m_logEntries = new FlightLogEntryModel(m_objectManager, this);
+    connect(&m_exportWatcher, SIGNAL(finished()), this, SLOT(exportFinished()));
+
     m_flightLogControl  = DebugLogControl::GetInstance(m_objectManager);
     Q_ASSERT(m_flightLogControl);
 
@@ -68,6 +86,9 @@ FlightLogManager::FlightLogManager(QObject *parent) :
 
     m_flightLogEntry    = DebugLogEntry::GetInstance(m_objectManager);
     Q_ASSERT(m_flightLogEntry);
+    // streamed entries arrive in all instances, the others are created on reception
+    connect(m_flightLogEntry, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(logEntryReceived(UAVObject *)));
+    connect(m_objectManager, SIGNAL(newInstance(UAVObject *)), this, SLOT(instanceCreated(UAVObject *)));
 
     m_flightLogSettings = DebugLogSettings::GetInstance(m_objectManager);
     Q_ASSERT(m_flightLogSettings);
@@ -75,6 +96,16 @@ FlightLogManager::FlightLogManager(QObject *parent) :
     m_objectPersistence = ObjectPersistence::GetInstance(m_objectManager);
     Q_ASSERT(m_objectPersistence);
 
+    m_traceControl = TraceControl::GetInstance(m_objectManager);
+    Q_ASSERT(m_traceControl);
+
+    m_traceStatus  = TraceStatus::GetInstance(m_objectManager);
+    Q_ASSERT(m_traceStatus);
+
+    TraceData *traceData = TraceData::GetInstance(m_objectManager);
+    Q_ASSERT(traceData);
+    connect(traceData, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(traceDataReceived(UAVObject *)));
+
     updateFlightEntries(m_flightLogStatus->getFlight());
 
     setupLogSettings();
@@ -88,40 +119,12 @@ FlightLogManager::FlightLogManager(QObject *parent) :
 
 FlightLogManager::~FlightLogManager()
 {
-    while (!m_logEntries.isEmpty()) {
-        delete m_logEntries.takeFirst();
-    }
+    m_exportWatcher.waitForFinished();
     while (!m_uavoEntries.isEmpty()) {
         delete m_uavoEntries.takeFirst();
     }
 }
 
-void addLogEntries(QQmlListProperty<ExtendedDebugLogEntry> *list, ExtendedDebugLogEntry *entry)
-{
-    Q_UNUSED(list);
-    Q_UNUSED(entry);
-}
-
-int countLogEntries(QQmlListProperty<ExtendedDebugLogEntry> *list)
-{
-    return static_cast< QList<ExtendedDebugLogEntry *> *>(list->data)->size();
-}
-
-ExtendedDebugLogEntry *logEntryAt(QQmlListProperty<ExtendedDebugLogEntry> *list, int index)
-{
-    return static_cast< QList<ExtendedDebugLogEntry *> *>(list->data)->at(index);
-}
-
-void clearLogEntries(QQmlListProperty<ExtendedDebugLogEntry> *list)
-{
-    return static_cast< QList<ExtendedDebugLogEntry *> *>(list->data)->clear();
-}
-
-QQmlListProperty<ExtendedDebugLogEntry> FlightLogManager::logEntries()
-{
-    return QQmlListProperty<ExtendedDebugLogEntry>(this, &m_logEntries, &addLogEntries, &countLogEntries, &logEntryAt, &clearLogEntries);
-}
-
 void addUAVOEntries(QQmlListProperty<UAVOLogSettingsWrapper> *list, UAVOLogSettingsWrapper *entry)
 {
     Q_UNUSED(list);
@@ -175,15 +178,10 @@ void FlightLogManager::clearAllLogs()
 
 void FlightLogManager::clearLogList()
 {
-    QList<ExtendedDebugLogEntry *> tmpList(m_logEntries);
-    m_logEntries.clear();
+    m_logEntries->clear();
 
     emit logEntriesChanged();
     setDisableExport(true);
-
-    while (!tmpList.isEmpty()) {
-        delete tmpList.takeFirst();
-    }
 }
 
 void FlightLogManager::retrieveLogs(int flightToRetrieve)
@@ -192,7 +190,6 @@ void FlightLogManager::retrieveLogs(int flightToRetrieve)
     QApplication::setOverrideCursor(Qt::WaitCursor);
     m_cancelDownload = false;
     UAVObjectUpdaterHelper updateHelper;
-    UAVObjectRequestHelper requestHelper;
 
     clearLogList();
 
@@ -200,68 +197,61 @@ void FlightLogManager::retrieveLogs(int flightToRetrieve)
     int startFlight = (flightToRetrieve == -1) ? 0 : flightToRetrieve;
     int endFlight   = (flightToRetrieve == -1) ? m_flightLogStatus->getFlight() : flightToRetrieve;
 
-    // Prepare to send request for event retrieval
-    m_flightLogControl->setOperation(DebugLogControl::OPERATION_RETRIEVE);
-    for (int flight = startFlight; flight <= endFlight; flight++) {
+    // Entries are streamed by the flight side in windows of STREAM_WINDOW entries,
+    // a window is only requested again from the first missing entry if some got lost
+    m_flightLogControl->setOperation(DebugLogControl::OPERATION_STREAM);
+    m_streaming = true;
+    bool failed = false;
+    for (int flight = startFlight; flight <= endFlight && !failed && !m_cancelDownload; flight++) {
         m_flightLogControl->setFlight(flight);
+        m_streamFlight = flight;
         bool gotLast = false;
         int slot     = 0;
-        while (!gotLast) {
-            // Send request for loading flight entry on flight side and wait for ack/nack
+        int retries  = 0;
+        while (!gotLast && !m_cancelDownload) {
+            m_streamEntries.clear();
+            m_streamFirst = slot;
             m_flightLogControl->setEntry(slot);
 
-            if (updateHelper.doObjectAndWait(m_flightLogControl, UAVTALK_TIMEOUT) == UAVObjectUpdaterHelper::SUCCESS &&
-                requestHelper.doObjectAndWait(m_flightLogEntry, UAVTALK_TIMEOUT) == UAVObjectUpdaterHelper::SUCCESS) {
-                if (m_flightLogEntry->getType() != DebugLogEntry::TYPE_EMPTY) {
-                    // Ok, we retrieved the entry, and it was the correct one. clone it and add it to the list
-                    ExtendedDebugLogEntry *logEntry = new ExtendedDebugLogEntry();
-
-                    logEntry->setData(m_flightLogEntry->getData(), m_objectManager);
-                    m_logEntries << logEntry;
-                    if (logEntry->getData().Type == DebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) {
-                        const quint32 total_len  = sizeof(DebugLogEntry::DataFields);
-                        const quint32 data_len   = sizeof(((DebugLogEntry::DataFields *)0)->Data);
-                        const quint32 header_len = total_len - data_len;
-
-                        DebugLogEntry::DataFields fields;
-                        quint32 start = logEntry->getData().Size;
-
-                        // cycle until there is space for another object
-                        while (start + header_len + 1 < data_len) {
-                            memset(&fields, 0xFF, total_len);
-                            memcpy(&fields, &logEntry->getData().Data[start], header_len);
-                            // check wether a packed object is found
-                            // note that empty data blocks are set as 0xFF in flight side to minimize flash wearing
-                            // thus as soon as this read outside of used area, the test will fail as lenght would be 0xFFFF
-                            quint32 toread = header_len + fields.Size;
-                            if (!(toread + start > data_len)) {
-                                memcpy(&fields, &logEntry->getData().Data[start], toread);
-                                ExtendedDebugLogEntry *subEntry = new ExtendedDebugLogEntry();
-                                subEntry->setData(fields, m_objectManager);
-                                m_logEntries << subEntry;
-                            }
-                            start += toread;
-                        }
-                    }
+            // Send request for streaming the next window and wait for ack/nack
+            if (updateHelper.doObjectAndWait(m_flightLogControl, UAVTALK_TIMEOUT) != UAVObjectUpdaterHelper::SUCCESS) {
+                failed = true;
+                break;
+            }
+            if (!streamWindowComplete()) {
+                QEventLoop loop;
+                QTimer timer;
+                timer.setSingleShot(true);
+                connect(this, SIGNAL(streamWindowCompleted()), &loop, SLOT(quit()));
+                connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+                timer.start(UAVTALK_TIMEOUT);
+                loop.exec();
+            }
 
-                    // Increment to get next entry from flight side
-                    slot++;
-                } else {
+            // Keep received entries in order, up to the first missing one
+            int first = slot;
+            while (m_streamEntries.contains(slot)) {
+                const DebugLogEntry::DataFields data = m_streamEntries.take(slot);
+                if (data.Type == DebugLogEntry::TYPE_EMPTY) {
                     // We are done, not more entries on this flight
                     gotLast = true;
+                    break;
                 }
-            } else {
-                // We failed for some reason
-                break;
+                m_logEntries->append(data);
+                slot++;
             }
-            if (m_cancelDownload) {
+            if (slot != first) {
+                emit logEntriesChanged();
+                retries = 0;
+            } else if (!gotLast && ++retries > STREAM_RETRIES) {
+                // We failed for some reason
+                failed = true;
                 break;
             }
         }
-        if (m_cancelDownload) {
-            break;
-        }
     }
+    m_streaming = false;
+    m_streamEntries.clear();
 
     if (m_cancelDownload) {
         clearLogList();
@@ -269,56 +259,105 @@ void FlightLogManager::retrieveLogs(int flightToRetrieve)
     }
 
     emit logEntriesChanged();
-    setDisableExport(m_logEntries.count() == 0);
+    setDisableExport(m_logEntries->rowCount() == 0);
 
     QApplication::restoreOverrideCursor();
     setDisableControls(false);
 }
 
-void FlightLogManager::exportToOPL(QString fileName)
+bool FlightLogManager::streamWindowComplete() const
 {
-    // Fix the file name
-    fileName.replace(QString(".opl"), QString("%1.opl"));
-
-    // Loop and create a new file for each flight.
-    int currentEntry  = 0;
-    int currentFlight = 0;
-    quint32 adjustedBaseTime = 0;
-    // Continue until all entries are exported
-    while (currentEntry < m_logEntries.count()) {
-        if (m_adjustExportedTimestamps) {
-            adjustedBaseTime = m_logEntries[currentEntry]->getFlightTime();
+    for (int slot = m_streamFirst; slot < m_streamFirst + STREAM_WINDOW; slot++) {
+        if (!m_streamEntries.contains(slot)) {
+            return false;
         }
+        if (m_streamEntries.value(slot).Type == DebugLogEntry::TYPE_EMPTY) {
+            break;
+        }
+    }
+    return true;
+}
 
-        // Get current flight
-        currentFlight = m_logEntries[currentEntry]->getFlight();
+void FlightLogManager::instanceCreated(UAVObject *obj)
+{
+    if (obj->getObjID() == DebugLogEntry::OBJID) {
+        connect(obj, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(logEntryReceived(UAVObject *)));
+    } else if (obj->getObjID() == TraceData::OBJID) {
+        connect(obj, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(traceDataReceived(UAVObject *)));
+    }
+}
 
-        LogFile logFile;
-        logFile.useProvidedTimeStamp(true);
+void FlightLogManager::logEntryReceived(UAVObject *obj)
+{
+    DebugLogEntry *entry = qobject_cast<DebugLogEntry *>(obj);
 
-        // Set the file name to contain flight number
-        logFile.setFileName(fileName.arg(tr("_flight-%1").arg(currentFlight + 1)));
-        logFile.open(QIODevice::WriteOnly);
-        UAVTalk uavTalk(&logFile, m_objectManager);
+    if (!m_streaming || !entry) {
+        return;
+    }
+    const DebugLogEntry::DataFields data = entry->getData();
+    if (data.Flight != m_streamFlight || data.Entry < m_streamFirst || data.Entry >= m_streamFirst + STREAM_WINDOW) {
+        // late entry of a previous window
+        return;
+    }
+    m_streamEntries.insert(data.Entry, data);
+    if (streamWindowComplete()) {
+        emit streamWindowCompleted();
+    }
+}
 
-        // Export entries until no more available or flight changes
-        while (currentEntry < m_logEntries.count() && m_logEntries[currentEntry]->getFlight() == currentFlight) {
-            ExtendedDebugLogEntry *entry = m_logEntries[currentEntry];
+/**
+ * Writes the UAVObject entries in the format of LogFile, the packed object
+ * data of the entries go straight into the UAVTalk packets. It only uses
+ * its arguments so it runs in the background.
+ */
+void FlightLogManager::exportToOPL(QString fileName, QByteArray raw, QVector<FlightLogEntryModel::Row> rows, bool adjustTimestamps)
+{
+    // Fix the file name
+    fileName.replace(QString(".opl"), QString("%1.opl"));
 
-            // Only log uavobjects
-            if (entry->getType() == ExtendedDebugLogEntry::TYPE_UAVOBJECT || entry->getType() == ExtendedDebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) {
-                // Set timestamp that should be logged for this entry
-                logFile.setNextTimeStamp(entry->getFlightTime() - adjustedBaseTime);
+    const int HEADER_LENGTH = 10;
+    const quint8 SYNC_VAL   = 0x3C;
+    const quint8 TYPE_OBJ   = 0x20;
+    const int dataLength    = sizeof(((DebugLogEntry::DataFields *)0)->Data);
+    quint8 packet[HEADER_LENGTH + dataLength + 1];
 
-                // Use UAVTalk to log complete message to file
-                uavTalk.sendObject(entry->uavObject(), false, false);
-                qDebug() << entry->getFlightTime() - adjustedBaseTime << "=" << entry->toStringBrief();
+    // Loop and create a new file for each flight.
+    QFile file;
+    int currentFlight = -1;
+    quint32 adjustedBaseTime = 0;
+    DebugLogEntry::DataFields fields;
+    foreach(const FlightLogEntryModel::Row &row, rows) {
+        FlightLogEntryModel::rowFields(raw, row, &fields);
+        if (fields.Flight != currentFlight) {
+            currentFlight    = fields.Flight;
+            adjustedBaseTime = adjustTimestamps ? fields.FlightTime : 0;
+            file.close();
+            // Set the file name to contain flight number
+            file.setFileName(fileName.arg(tr("_flight-%1").arg(currentFlight + 1)));
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                return;
             }
-            currentEntry++;
         }
 
-        logFile.close();
+        // Only log uavobjects
+        if ((fields.Type != DebugLogEntry::TYPE_UAVOBJECT && fields.Type != DebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) || fields.Size > dataLength) {
+            continue;
+        }
+        packet[0] = SYNC_VAL;
+        packet[1] = TYPE_OBJ;
+        qToLittleEndian<quint16>(HEADER_LENGTH + fields.Size, &packet[2]);
+        qToLittleEndian<quint32>(fields.ObjectID, &packet[4]);
+        qToLittleEndian<quint16>(fields.InstanceID, &packet[8]);
+        memcpy(&packet[HEADER_LENGTH], fields.Data, fields.Size);
+        packet[HEADER_LENGTH + fields.Size] = Utils::Crc::updateCRC(0, packet, HEADER_LENGTH + fields.Size);
+
+        quint32 timeStamp = fields.FlightTime - adjustedBaseTime;
+        qint64 size = HEADER_LENGTH + fields.Size + 1;
+        file.write((const char *)&timeStamp, sizeof(timeStamp));
+        file.write((const char *)&size, sizeof(size));
+        file.write((const char *)packet, size);
     }
+    file.close();
 }
 
 void FlightLogManager::exportToCSV(QString fileName)
@@ -330,12 +369,17 @@ void FlightLogManager::exportToCSV(QString fileName)
         quint32 baseTime = 0;
         quint32 currentFlight = 0;
         csvStream << "Flight" << '\t' << "Flight Time" << '\t' << "Entry" << '\t' << "Data" << '\n';
-        foreach(ExtendedDebugLogEntry * entry, m_logEntries) {
-            if (m_adjustExportedTimestamps && entry->getFlight() != currentFlight) {
-                currentFlight = entry->getFlight();
-                baseTime = entry->getFlightTime();
+        const QByteArray raw = m_logEntries->rawEntries();
+        DebugLogEntry::DataFields fields;
+        foreach(const FlightLogEntryModel::Row &row, m_logEntries->rows()) {
+            FlightLogEntryModel::rowFields(raw, row, &fields);
+            ExtendedDebugLogEntry entry;
+            entry.setData(fields, m_objectManager);
+            if (m_adjustExportedTimestamps && entry.getFlight() != currentFlight) {
+                currentFlight = entry.getFlight();
+                baseTime = entry.getFlightTime();
             }
-            entry->toCSV(&csvStream, baseTime);
+            entry.toCSV(&csvStream, baseTime);
         }
         csvStream.flush();
         csvFile.flush();
@@ -358,12 +402,17 @@ void FlightLogManager::exportToXML(QString fileName)
 
         quint32 baseTime = 0;
         quint32 currentFlight = 0;
-        foreach(ExtendedDebugLogEntry * entry, m_logEntries) {
-            if (m_adjustExportedTimestamps && entry->getFlight() != currentFlight) {
-                currentFlight = entry->getFlight();
-                baseTime = entry->getFlightTime();
+        const QByteArray raw = m_logEntries->rawEntries();
+        DebugLogEntry::DataFields fields;
+        foreach(const FlightLogEntryModel::Row &row, m_logEntries->rows()) {
+            FlightLogEntryModel::rowFields(raw, row, &fields);
+            ExtendedDebugLogEntry entry;
+            entry.setData(fields, m_objectManager);
+            if (m_adjustExportedTimestamps && entry.getFlight() != currentFlight) {
+                currentFlight = entry.getFlight();
+                baseTime = entry.getFlightTime();
             }
-            entry->toXML(&xmlWriter, baseTime);
+            entry.toXML(&xmlWriter, baseTime);
         }
         xmlWriter.writeEndElement();
         xmlWriter.writeEndDocument();
@@ -374,7 +423,7 @@ void FlightLogManager::exportToXML(QString fileName)
 
 void FlightLogManager::exportLogs()
 {
-    if (m_logEntries.isEmpty()) {
+    if (m_logEntries->rowCount() == 0 || m_exportWatcher.isRunning()) {
         return;
     }
 
@@ -394,7 +443,10 @@ void FlightLogManager::exportLogs()
             if (!fileName.endsWith(".opl")) {
                 fileName.append(".opl");
             }
-            exportToOPL(fileName);
+            // the controls stay disabled until it is written
+            m_exportWatcher.setFuture(QtConcurrent::run(&FlightLogManager::exportToOPL, fileName,
+                                                        m_logEntries->rawEntries(), m_logEntries->rows(), m_adjustExportedTimestamps));
+            return;
         } else if (selectedFilter == csvFilter) {
             if (!fileName.endsWith(".csv")) {
                 fileName.append(".csv");
@@ -417,6 +469,251 @@ void FlightLogManager::cancelExportLogs()
     m_cancelDownload = true;
 }
 
+void FlightLogManager::exportFinished()
+{
+    QApplication::restoreOverrideCursor();
+    setDisableControls(false);
+}
+
+void FlightLogManager::startTrace(bool continuous)
+{
+    setDisableControls(true);
+    UAVObjectUpdaterHelper updateHelper;
+
+    m_traceControl->setOperation(continuous ? TraceControl::OPERATION_STARTCONTINUOUS : TraceControl::OPERATION_START);
+    updateHelper.doObjectAndWait(m_traceControl, UAVTALK_TIMEOUT);
+    setDisableControls(false);
+}
+
+void FlightLogManager::exportTrace()
+{
+    setDisableControls(true);
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    m_cancelDownload = false;
+    UAVObjectUpdaterHelper updateHelper;
+    UAVObjectRequestHelper requestHelper;
+
+    // The trace buffer only stays consistent while stopped
+    m_traceControl->setOperation(TraceControl::OPERATION_STOP);
+    bool failed = updateHelper.doObjectAndWait(m_traceControl, UAVTALK_TIMEOUT) != UAVObjectUpdaterHelper::SUCCESS ||
+                  requestHelper.doObjectAndWait(m_traceStatus, UAVTALK_TIMEOUT) != UAVObjectRequestHelper::SUCCESS;
+
+    // Blocks are streamed in windows of STREAM_WINDOW like the log entries
+    QList<TraceData::DataFields> blocks;
+    m_traceCount = m_traceStatus->getEvents();
+    m_traceControl->setOperation(TraceControl::OPERATION_STREAM);
+    m_traceStreaming = true;
+    int event   = 0;
+    int retries = 0;
+    while (!failed && event < m_traceCount && !m_cancelDownload) {
+        m_traceBlocks.clear();
+        m_traceFirst = event;
+        m_traceControl->setEvent(event);
+        if (updateHelper.doObjectAndWait(m_traceControl, UAVTALK_TIMEOUT) != UAVObjectUpdaterHelper::SUCCESS) {
+            failed = true;
+            break;
+        }
+        if (!traceWindowComplete()) {
+            QEventLoop loop;
+            QTimer timer;
+            timer.setSingleShot(true);
+            connect(this, SIGNAL(traceWindowCompleted()), &loop, SLOT(quit()));
+            connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+            timer.start(UAVTALK_TIMEOUT);
+            loop.exec();
+        }
+
+        int first = event;
+        while (m_traceBlocks.contains(event)) {
+            const TraceData::DataFields block = m_traceBlocks.take(event);
+            blocks << block;
+            event += block.Count;
+            if (block.Count < TRACE_EVENTS_PER_BLOCK) {
+                break;
+            }
+        }
+        if (event == first || (event < m_traceCount && event % TRACE_EVENTS_PER_BLOCK)) {
+            // nothing new, or the board has less events than it announced
+            if (++retries > STREAM_RETRIES || event % TRACE_EVENTS_PER_BLOCK) {
+                failed = event == first;
+                break;
+            }
+        } else {
+            retries = 0;
+        }
+    }
+    m_traceStreaming = false;
+    m_traceBlocks.clear();
+
+    if (!failed && !m_cancelDownload && !blocks.isEmpty()) {
+        QString jsonFilter = tr("Chrome trace file %1").arg("(*.json)");
+        QString fileName   = QFileDialog::getSaveFileName(NULL, tr("Save Trace"), QDir::homePath(), jsonFilter);
+        if (!fileName.isEmpty()) {
+            if (!fileName.endsWith(".json")) {
+                fileName.append(".json");
+            }
+            exportToChromeTrace(fileName, blocks, m_traceStatus->getTicksPerMs());
+        }
+    }
+    m_cancelDownload = false;
+
+    QApplication::restoreOverrideCursor();
+    setDisableControls(false);
+}
+
+bool FlightLogManager::traceWindowComplete() const
+{
+    for (int i = 0; i < STREAM_WINDOW; i++) {
+        int event = m_traceFirst + i * TRACE_EVENTS_PER_BLOCK;
+        if (event >= m_traceCount) {
+            break;
+        }
+        if (!m_traceBlocks.contains(event)) {
+            return false;
+        }
+        if (m_traceBlocks.value(event).Count < TRACE_EVENTS_PER_BLOCK) {
+            break;
+        }
+    }
+    return true;
+}
+
+void FlightLogManager::traceDataReceived(UAVObject *obj)
+{
+    TraceData *traceData = qobject_cast<TraceData *>(obj);
+
+    if (!m_traceStreaming || !traceData) {
+        return;
+    }
+    const TraceData::DataFields data = traceData->getData();
+    if (data.Event < m_traceFirst || data.Event >= m_traceFirst + STREAM_WINDOW * TRACE_EVENTS_PER_BLOCK) {
+        // late block of a previous window
+        return;
+    }
+    m_traceBlocks.insert(data.Event, data);
+    if (traceWindowComplete()) {
+        emit traceWindowCompleted();
+    }
+}
+
+/**
+ * Writes the events in the Trace Event Format read by chrome://tracing and Perfetto.
+ * Tasks and callbacks are named after the TaskInfo and CallbackInfo elements,
+ * timed sections after the id of their PerfCounter instance.
+ */
+void FlightLogManager::exportToChromeTrace(QString fileName, const QList<TraceData::DataFields> & blocks, quint32 ticksPerMs)
+{
+    enum { TASK_SWITCH, CALLBACK_START, CALLBACK_END, ISR_ENTER, ISR_EXIT, SECTION_START, SECTION_END };
+    enum { TID_TASKS = 1, TID_CALLBACKS, TID_ISRS, TID_SECTIONS };
+    const QStringList isrNames = QStringList() << "MPU6000" << "USART";
+    const QStringList taskNames     = TaskInfo::GetInstance(m_objectManager)->getField("Running")->getElementNames();
+    const QStringList callbackNames = CallbackInfo::GetInstance(m_objectManager)->getField("Running")->getElementNames();
+
+    QJsonArray traceEvents;
+    QStringList trackNames = QStringList() << "" << tr("Tasks") << tr("Callbacks") << tr("Interrupts");
+    for (int tid = TID_TASKS; tid < TID_SECTIONS; tid++) {
+        QJsonObject meta;
+        meta["ph"]   = QString("M");
+        meta["name"] = QString("thread_name");
+        meta["pid"]  = 1;
+        meta["tid"]  = tid;
+        QJsonObject args;
+        args["name"] = trackNames[tid];
+        meta["args"] = args;
+        traceEvents.append(meta);
+    }
+
+    double ticksPerUs = ticksPerMs ? ticksPerMs / 1000.0 : 1.0;
+    quint64 ticks     = 0;
+    quint32 lastStamp = 0;
+    bool first = true;
+    QString runningTask;
+    QSet<int> sectionTracks;
+    foreach(const TraceData::DataFields &block, blocks) {
+        for (int n = 0; n < block.Count; n++) {
+            const quint8 *raw = &block.Data[n * TRACE_EVENT_SIZE];
+            quint32 stamp     = raw[0] | (raw[1] << 8) | (raw[2] << 16) | ((quint32)raw[3] << 24);
+            quint16 id = raw[4] | (raw[5] << 8);
+            quint8 type = raw[6];
+
+            // time stamps wrap around, events are in order
+            ticks    += first ? 0 : (quint32)(stamp - lastStamp);
+            lastStamp = stamp;
+            first     = false;
+
+            QJsonObject ev;
+            ev["pid"] = 1;
+            ev["ts"]  = ticks / ticksPerUs;
+            switch (type) {
+            case TASK_SWITCH:
+            {
+                QString name = id < taskNames.count() ? taskNames[id] : tr("Other");
+                if (!runningTask.isEmpty()) {
+                    QJsonObject end(ev);
+                    end["ph"]   = QString("E");
+                    end["tid"]  = TID_TASKS;
+                    end["name"] = runningTask;
+                    traceEvents.append(end);
+                }
+                ev["ph"]    = QString("B");
+                ev["tid"]   = TID_TASKS;
+                ev["name"]  = name;
+                runningTask = name;
+                break;
+            }
+            case CALLBACK_START:
+            case CALLBACK_END:
+                ev["ph"]   = QString(type == CALLBACK_START ? "B" : "E");
+                ev["tid"]  = TID_CALLBACKS;
+                ev["name"] = id < callbackNames.count() ? callbackNames[id] : tr("Callback %1").arg(id);
+                break;
+            case ISR_ENTER:
+            case ISR_EXIT:
+                ev["ph"]   = QString(type == ISR_ENTER ? "B" : "E");
+                ev["tid"]  = TID_ISRS;
+                ev["name"] = id < isrNames.count() ? isrNames[id] : tr("IRQ %1").arg(id);
+                break;
+            case SECTION_START:
+            case SECTION_END:
+            {
+                // sections of different tasks overlap, give every counter its own track
+                PerfCounter *counter = PerfCounter::GetInstance(m_objectManager, id);
+                QString name = counter ? QString("0x%1").arg(counter->getId(), 8, 16, QChar('0')) : tr("Section %1").arg(id);
+                if (!sectionTracks.contains(id)) {
+                    sectionTracks.insert(id);
+                    QJsonObject meta;
+                    meta["ph"]   = QString("M");
+                    meta["name"] = QString("thread_name");
+                    meta["pid"]  = 1;
+                    meta["tid"]  = TID_SECTIONS + id;
+                    QJsonObject args;
+                    args["name"] = name;
+                    meta["args"] = args;
+                    traceEvents.append(meta);
+                }
+                ev["ph"]   = QString(type == SECTION_START ? "B" : "E");
+                ev["tid"]  = TID_SECTIONS + id;
+                ev["name"] = name;
+                break;
+            }
+            default:
+                continue;
+            }
+            traceEvents.append(ev);
+        }
+    }
+
+    QJsonObject trace;
+    trace["traceEvents"]     = traceEvents;
+    trace["displayTimeUnit"] = QString("ns");
+
+    QFile jsonFile(fileName);
+    if (jsonFile.open(QFile::WriteOnly | QFile::Truncate)) {
+        jsonFile.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+        jsonFile.close();
+    }
+}
+
 void FlightLogManager::loadSettings()
 {
     QString xmlFilter = tr("XML file %1").arg("(*.xml)");
@@ -688,6 +985,150 @@ void ExtendedDebugLogEntry::setData(const DebugLogEntry::DataFields &data, UAVOb
     }
 }
 
+FlightLogEntryModel::FlightLogEntryModel(UAVObjectManager *objectManager, QObject *parent) :
+    QAbstractListModel(parent), m_objectManager(objectManager), m_logStrings(LOG_STRING_CACHE)
+{}
+
+FlightLogEntryModel::~FlightLogEntryModel()
+{
+    qDeleteAll(m_decoders);
+}
+
+int FlightLogEntryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.count();
+}
+
+QHash<int, QByteArray> FlightLogEntryModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[FlightRole]     = "Flight";
+    roles[FlightTimeRole] = "FlightTime";
+    roles[EntryRole]      = "Entry";
+    roles[TypeRole]       = "Type";
+    roles[LogStringRole]  = "LogString";
+    return roles;
+}
+
+QVariant FlightLogEntryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_rows.count()) {
+        return QVariant();
+    }
+    DebugLogEntry::DataFields fields;
+    rowFields(m_raw, m_rows[index.row()], &fields);
+    switch (role) {
+    case FlightRole:
+        return fields.Flight;
+
+    case FlightTimeRole:
+        return fields.FlightTime;
+
+    case EntryRole:
+        return fields.Entry;
+
+    case TypeRole:
+        return fields.Type;
+
+    case LogStringRole:
+        return logString(index.row(), fields);
+
+    default:
+        return QVariant();
+    }
+}
+
+void FlightLogEntryModel::append(const DebugLogEntry::DataFields &data)
+{
+    const quint32 total_len  = sizeof(DebugLogEntry::DataFields);
+    const quint32 data_len   = sizeof(((DebugLogEntry::DataFields *)0)->Data);
+    const quint32 header_len = total_len - data_len;
+    const quint32 entry = m_raw.size() / total_len;
+
+    QVector<Row> rows;
+    Row row = { entry, NO_START };
+    rows << row;
+    if (data.Type == DebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) {
+        DebugLogEntry::DataFields fields;
+        quint32 start = data.Size;
+
+        // cycle until there is space for another object
+        while (start + header_len + 1 < data_len) {
+            memcpy(&fields, &data.Data[start], header_len);
+            // check wether a packed object is found
+            // note that empty data blocks are set as 0xFF in flight side to minimize flash wearing
+            // thus as soon as this read outside of used area, the test will fail as lenght would be 0xFFFF
+            quint32 toread = header_len + fields.Size;
+            if (!(toread + start > data_len)) {
+                row.start = start;
+                rows << row;
+            }
+            start += toread;
+        }
+    }
+
+    beginInsertRows(QModelIndex(), m_rows.count(), m_rows.count() + rows.count() - 1);
+    m_raw.append((const char *)&data, total_len);
+    m_rows << rows;
+    endInsertRows();
+}
+
+void FlightLogEntryModel::clear()
+{
+    beginResetModel();
+    m_raw.clear();
+    m_rows.clear();
+    m_logStrings.clear();
+    qDeleteAll(m_decoders);
+    m_decoders.clear();
+    endResetModel();
+}
+
+void FlightLogEntryModel::rowFields(const QByteArray &raw, const Row &row, DebugLogEntry::DataFields *fields)
+{
+    const quint32 total_len  = sizeof(DebugLogEntry::DataFields);
+    const quint32 data_len   = sizeof(((DebugLogEntry::DataFields *)0)->Data);
+    const quint32 header_len = total_len - data_len;
+    const DebugLogEntry::DataFields *entry = (const DebugLogEntry::DataFields *)(raw.constData() + row.entry * total_len);
+
+    if (row.start == NO_START) {
+        memcpy(fields, entry, total_len);
+        return;
+    }
+    // the objects packed after the first one bring their own header, checked to fit when the row was added
+    memset(fields, 0xFF, total_len);
+    memcpy(fields, &entry->Data[row.start], header_len);
+    memcpy(fields, &entry->Data[row.start], header_len + fields->Size);
+}
+
+QString FlightLogEntryModel::logString(int row, const DebugLogEntry::DataFields &fields) const
+{
+    QString *cached = m_logStrings.object(row);
+
+    if (cached) {
+        return *cached;
+    }
+
+    QString string;
+    if (fields.Type == DebugLogEntry::TYPE_TEXT) {
+        string = QString::fromUtf8((const char *)fields.Data, qstrnlen((const char *)fields.Data, sizeof(fields.Data)));
+    } else if (fields.Type == DebugLogEntry::TYPE_UAVOBJECT || fields.Type == DebugLogEntry::TYPE_MULTIPLEUAVOBJECTS) {
+        quint64 key = ((quint64)fields.ObjectID << 16) | fields.InstanceID;
+        UAVDataObject *object = m_decoders.value(key);
+        if (!object) {
+            UAVDataObject *base = qobject_cast<UAVDataObject *>(m_objectManager->getObject(fields.ObjectID));
+            if (!base) {
+                return QString();
+            }
+            object = base->clone(fields.InstanceID);
+            m_decoders.insert(key, object);
+        }
+        object->unpack(fields.Data);
+        string = object->toString().replace("\n", " ").replace("\t", " ");
+    }
+    m_logStrings.insert(row, new QString(string));
+    return string;
+}
 
 UAVOLogSettingsWrapper::UAVOLogSettingsWrapper() : QObject()
 {}
@@ -31,6 +31,11 @@
 #include <QObject>
 #include <QList>
 #include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QCache>
+#include <QAbstractListModel>
+#include <QFutureWatcher>
 #include <QQmlListProperty>
 #include <QSemaphore>
 #include <QXmlStreamWriter>
@@ -42,6 +47,9 @@
 #include "debuglogstatus.h"
 #include "debuglogsettings.h"
 #include "debuglogcontrol.h"
+#include "tracecontrol.h"
+#include "tracestatus.h"
+#include "tracedata.h"
 #include "objectpersistence.h"
 #include "uavtalk/telemetrymanager.h"
 
@@ -167,11 +175,62 @@ private:
     UAVDataObject *m_object;
 };
 
+/**
+ * The downloaded log entries, kept as the raw fields received. The objects
+ * packed in a MultipleUAVObjects entry get a row each, they are only decoded
+ * when a view asks for the data of their row.
+ */
+class FlightLogEntryModel : public QAbstractListModel {
+    Q_OBJECT
+
+public:
+    enum Roles { FlightRole = Qt::UserRole + 1, FlightTimeRole, EntryRole, TypeRole, LogStringRole };
+
+    struct Row {
+        quint32 entry;
+        quint16 start; // of the object in the Data of the entry, NO_START for the entry itself
+    };
+    static const quint16 NO_START = 0xFFFF;
+
+    explicit FlightLogEntryModel(UAVObjectManager *objectManager, QObject *parent = 0);
+    ~FlightLogEntryModel();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role) const;
+    QHash<int, QByteArray> roleNames() const;
+
+    void append(const DebugLogEntry::DataFields & data);
+    void clear();
+
+    // implicitly shared, a copy stays valid while the model changes
+    QByteArray rawEntries() const
+    {
+        return m_raw;
+    }
+    QVector<Row> rows() const
+    {
+        return m_rows;
+    }
+    static void rowFields(const QByteArray & raw, const Row & row, DebugLogEntry::DataFields *fields);
+
+private:
+    QString logString(int row, const DebugLogEntry::DataFields & fields) const;
+
+    UAVObjectManager *m_objectManager;
+    QByteArray m_raw;
+    QVector<Row> m_rows;
+    // strings of the rows shown lately, and an object per ID and instance to unpack into
+    mutable QCache<int, QString> m_logStrings;
+    mutable QHash<quint64, UAVDataObject *> m_decoders;
+
+    static const int LOG_STRING_CACHE = 512;
+};
+
 class FlightLogManager : public QObject {
     Q_OBJECT Q_PROPERTY(DebugLogStatus *flightLogStatus READ flightLogStatus)
     Q_PROPERTY(DebugLogControl * flightLogControl READ flightLogControl)
     Q_PROPERTY(DebugLogSettings * flightLogSettings READ flightLogSettings)
-    Q_PROPERTY(QQmlListProperty<ExtendedDebugLogEntry> logEntries READ logEntries NOTIFY logEntriesChanged)
+    Q_PROPERTY(QAbstractItemModel * logEntries READ logEntries CONSTANT)
     Q_PROPERTY(QStringList flightEntries READ flightEntries NOTIFY flightEntriesChanged)
     Q_PROPERTY(bool disableControls READ disableControls WRITE setDisableControls NOTIFY disableControlsChanged)
     Q_PROPERTY(bool disableExport READ disableExport WRITE setDisableExport NOTIFY disableExportChanged)
@@ -188,7 +247,10 @@ public:
     explicit FlightLogManager(QObject *parent = 0);
     ~FlightLogManager();
 
-    QQmlListProperty<ExtendedDebugLogEntry> logEntries();
+    QAbstractItemModel *logEntries() const
+    {
+        return m_logEntries;
+    }
     QQmlListProperty<UAVOLogSettingsWrapper> uavoEntries();
 
     QStringList flightEntries();
@@ -246,7 +308,7 @@ public:
     }
     int logEntriesCount()
     {
-        return m_logEntries.count();
+        return m_logEntries->rowCount();
     }
 signals:
     void logEntriesChanged();
@@ -257,6 +319,8 @@ signals:
     void disableExportChanged(bool arg);
     void adjustExportedTimestampsChanged(bool arg);
     void boardConnectedChanged(bool arg);
+    void streamWindowCompleted();
+    void traceWindowCompleted();
 
     void logStatusesChanged(QStringList arg);
     void loggingEnabledChanged(int arg);
@@ -266,6 +330,8 @@ public slots:
     void retrieveLogs(int flightToRetrieve = -1);
     void exportLogs();
     void cancelExportLogs();
+    void startTrace(bool continuous);
+    void exportTrace();
     void loadSettings();
     void saveSettings();
     void resetSettings(bool clear);
@@ -319,6 +385,10 @@ private slots:
     void setupLogStatuses();
     void connectionStatusChanged();
     bool updateLogWrapper(QString name, int level, int period);
+    void instanceCreated(UAVObject *obj);
+    void logEntryReceived(UAVObject *obj);
+    void traceDataReceived(UAVObject *obj);
+    void exportFinished();
 
 private:
     UAVObjectManager *m_objectManager;
@@ -329,8 +399,11 @@ private:
     DebugLogEntry *m_flightLogEntry;
     DebugLogSettings *m_flightLogSettings;
     ObjectPersistence *m_objectPersistence;
+    TraceControl *m_traceControl;
+    TraceStatus *m_traceStatus;
 
-    QList<ExtendedDebugLogEntry *> m_logEntries;
+    FlightLogEntryModel *m_logEntries;
+    QFutureWatcher<void> m_exportWatcher;
     QStringList m_flightEntries;
     QStringList m_logSettings;
     QStringList m_logStatuses;
@@ -338,11 +411,20 @@ private:
     QList<UAVOLogSettingsWrapper *> m_uavoEntries;
     QHash<QString, UAVOLogSettingsWrapper *> m_uavoEntriesHash;
 
-    void exportToOPL(QString fileName);
+    static void exportToOPL(QString fileName, QByteArray raw, QVector<FlightLogEntryModel::Row> rows, bool adjustTimestamps);
     void exportToCSV(QString fileName);
     void exportToXML(QString fileName);
+    bool streamWindowComplete() const;
+    bool traceWindowComplete() const;
+    void exportToChromeTrace(QString fileName, const QList<TraceData::DataFields> & blocks, quint32 ticksPerMs);
 
     static const int UAVTALK_TIMEOUT = 4000;
+    // must match the firmware, entries pushed per stream request
+    static const int STREAM_WINDOW  = 8;
+    static const int STREAM_RETRIES = 3;
+    // must match pios_eventtrace.h, 8 bytes per event
+    static const int TRACE_EVENT_SIZE = 8;
+    static const int TRACE_EVENTS_PER_BLOCK = TraceData::DATA_NUMELEM / TRACE_EVENT_SIZE;
     static const int LOG_SETTINGS_FILE_VERSION = 1;
     bool m_disableControls;
     bool m_disableExport;
@@ -350,6 +432,16 @@ private:
     bool m_adjustExportedTimestamps;
     bool m_boardConnected;
     int m_loggingEnabled;
+    // entries of the stream window being received, by entry number
+    QMap<int, DebugLogEntry::DataFields> m_streamEntries;
+    bool m_streaming;
+    int m_streamFlight;
+    int m_streamFirst;
+    // trace blocks of the stream window being received, by first event
+    QMap<int, TraceData::DataFields> m_traceBlocks;
+    bool m_traceStreaming;
+    int m_traceFirst;
+    int m_traceCount;
 };
 
 #endif // FLIGHTLOGMANAGER_H
@@ -6,6 +6,7 @@ QT += svg opengl network
 include(../../openpilotgcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri)
 include(../../plugins/uavobjects/uavobjects.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
 include(../../libs/sdlgamepad/sdlgamepad.pri)
 
 HEADERS += \
@@ -15,7 +16,8 @@ HEADERS += \
     gcscontrolgadgetwidget.h \
     gcscontrolgadgetfactory.h \
     gcscontrolplugin.h \
-    joystickcontrol.h
+    joystickcontrol.h \
+    gcsreceiverstream.h
 
 SOURCES += \
     gcscontrolgadget.cpp \
@@ -24,7 +26,8 @@ SOURCES += \
     gcscontrolgadgetwidget.cpp \
     gcscontrolgadgetfactory.cpp \
     gcscontrolplugin.cpp \
-    joystickcontrol.cpp
+    joystickcontrol.cpp \
+    gcsreceiverstream.cpp
 
 OTHER_FILES += GCSControl.pluginspec
 
@@ -53,10 +53,15 @@ GCSControlGadget::GCSControlGadget(QString classId, GCSControlGadgetWidget *widg
     connect(pl->sdlGamepad, SIGNAL(gamepads(quint8)), this, SLOT(gamepads(quint8)));
     connect(pl->sdlGamepad, SIGNAL(buttonState(ButtonNumber, bool)), this, SLOT(buttonState(ButtonNumber, bool)));
     connect(pl->sdlGamepad, SIGNAL(axesValues(QListInt16)), this, SLOT(axesValues(QListInt16)));
+
+    // The stream takes the axes in the gamepad thread, not through the GUI event loop
+    receiverStream = new GCSReceiverStream(this);
+    connect(pl->sdlGamepad, SIGNAL(axesValues(QListInt16)), receiverStream, SLOT(setAxes(QListInt16)), Qt::DirectConnection);
 }
 
 GCSControlGadget::~GCSControlGadget()
 {
+    receiverStream->stop();
     delete m_widget;
 }
 
@@ -84,6 +89,9 @@ void GCSControlGadget::loadConfiguration(IUAVGadgetConfiguration *config)
         buttonSettings[i].Amount     = GCSControlConfig->getbuttonSettings(i).Amount;
         channelReverse[i] = GCSControlConfig->getChannelsReverse().at(i);
     }
+
+    receiverStream->setChannelsReverse(GCSControlConfig->getChannelsReverse());
+    receiverStream->setRate(GCSControlConfig->getGCSReceiverRate());
 }
 
 ManualControlCommand *GCSControlGadget::getManualControlCommand()
@@ -34,6 +34,7 @@
 #include "sdlgamepad/sdlgamepad.h"
 #include <QTime>
 #include "gcscontrolplugin.h"
+#include "gcsreceiverstream.h"
 #include <QUdpSocket>
 #include <QHostAddress>
 
@@ -85,6 +86,7 @@ private:
     double wrap(double input);
     bool channelReverse[8];
     QUdpSocket *control_sock;
+    GCSReceiverStream *receiverStream;
 
 
 signals:
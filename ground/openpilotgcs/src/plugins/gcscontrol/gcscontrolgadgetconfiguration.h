@@ -59,6 +59,14 @@ public:
     void setUDPControlSettings(int port, QString host);
     int getUDPControlPort();
     QHostAddress getUDPControlHost();
+    void setGCSReceiverRate(int rate)
+    {
+        gcsReceiverRate = rate;
+    }
+    int getGCSReceiverRate()
+    {
+        return gcsReceiverRate;
+    }
     int getControlsMode()
     {
         return controlsMode;
@@ -102,6 +110,8 @@ private:
     bool channelReverse[8];
     int udp_port;
     QHostAddress udp_host;
+    // Updates per second of the GCSReceiver stream, 0 when off
+    int gcsReceiverRate;
 };
 
 #endif // GCSCONTROLGADGETCONFIGURATION_H
@@ -189,6 +189,7 @@ QWidget *GCSControlGadgetOptionsPage::createPage(QWidget *parent)
 
     options_page->udp_host->setText(m_config->getUDPControlHost().toString());
     options_page->udp_port->setText(QString::number(m_config->getUDPControlPort()));
+    options_page->gcsReceiverRate->setValue(m_config->getGCSReceiverRate());
 
 
     // Controls mode are from 1 to 4.
@@ -267,6 +268,7 @@ void GCSControlGadgetOptionsPage::apply()
     m_config->setRPYTchannels(roll, pitch, yaw, throttle);
 
     m_config->setUDPControlSettings(options_page->udp_port->text().toInt(), options_page->udp_host->text());
+    m_config->setGCSReceiverRate(options_page->gcsReceiverRate->value());
 
 
     int j;
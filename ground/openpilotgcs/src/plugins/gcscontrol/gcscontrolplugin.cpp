@@ -48,7 +48,8 @@ bool GCSControlPlugin::initialize(const QStringList & args, QString *errMsg)
     Q_UNUSED(errMsg);
     sdlGamepad = new SDLGamepad();
     if (sdlGamepad->init()) {
-        sdlGamepad->start();
+        // Sampled away from the GUI, so the sticks do not lag when it is busy
+        sdlGamepad->start(QThread::HighPriority);
         qRegisterMetaType<QListInt16>("QListInt16");
         qRegisterMetaType<ButtonNumber>("ButtonNumber");
     }
@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ *
+ * @file       gcsreceiverstream.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GCSControlGadgetPlugin GCSControl Gadget Plugin
+ * @{
+ * @brief Streams the gamepad axes to the GCS receiver of the flight controller
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "gcsreceiverstream.h"
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "telemetrymanager.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+// Pulse width of the centered axis and of a full deflection, in us
+#define CHANNEL_NEUTRAL 1500
+#define CHANNEL_RANGE   500
+
+GCSReceiverStream::GCSReceiverStream(QObject *parent) : QThread(parent),
+    m_telemetryManager(NULL), m_packet(NULL), m_periodMs(0), m_running(false)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    m_telemetryManager = pm->getObject<TelemetryManager>();
+    m_packet = dynamic_cast<GCSReceiver *>(GCSReceiver::GetInstance(objManager)->clone(0));
+}
+
+GCSReceiverStream::~GCSReceiverStream()
+{
+    stop();
+    delete m_packet;
+}
+
+/**
+ * Updates per second, 0 stops the stream
+ */
+void GCSReceiverStream::setRate(int rate)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_periodMs = rate > 0 ? qMax(1000 / rate, 1) : 0;
+    if (m_periodMs && m_packet && m_telemetryManager && !isRunning()) {
+        m_running = true;
+        start(QThread::TimeCriticalPriority);
+    }
+}
+
+void GCSReceiverStream::setChannelsReverse(const QList<bool> &reverse)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_reverse = reverse;
+}
+
+void GCSReceiverStream::stop()
+{
+    m_mutex.lock();
+    m_running = false;
+    m_mutex.unlock();
+    wait();
+}
+
+void GCSReceiverStream::setAxes(QListInt16 values)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_axes = values;
+}
+
+void GCSReceiverStream::run()
+{
+    QElapsedTimer clock;
+    qint64 nextMs = 0;
+
+    clock.start();
+    // Monotonic from the wall clock at the start, a step of the wall clock (NTP, DST)
+    // would make the flight side take the updates as stale
+    const qint64 startMs = QDateTime::currentMSecsSinceEpoch();
+    forever {
+        GCSReceiver::DataFields data;
+        bool send = false;
+        int periodMs;
+
+        m_mutex.lock();
+        if (!m_running) {
+            m_mutex.unlock();
+            break;
+        }
+        periodMs = m_periodMs;
+        if (periodMs && !m_axes.isEmpty()) {
+            // The channels are the raw axes, they are calibrated like a radio in the input configuration
+            for (int i = 0; i < GCSReceiver::CHANNEL_NUMELEM; i++) {
+                double value = i < m_axes.size() ? m_axes.at(i) / 32767.0 : 0.0;
+                if (i < m_reverse.size() && m_reverse.at(i)) {
+                    value = -value;
+                }
+                data.Channel[i] = CHANNEL_NEUTRAL + qBound(-1.0, value, 1.0) * CHANNEL_RANGE;
+            }
+            send = true;
+        }
+        m_mutex.unlock();
+
+        if (send) {
+            // 0 means no timestamp to the flight side
+            data.Timestamp = (quint32)(startMs + clock.elapsed());
+            if (data.Timestamp == 0) {
+                data.Timestamp = 1;
+            }
+            m_packet->setData(data);
+            m_telemetryManager->sendObjectUnacked(m_packet);
+        }
+
+        // Keep the period on average, skip the updates missed
+        periodMs = periodMs ? periodMs : 100;
+        nextMs  += periodMs;
+        qint64 now = clock.elapsed();
+        if (nextMs <= now) {
+            nextMs = now + periodMs;
+        }
+        msleep(nextMs - now);
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ *
+ * @file       gcsreceiverstream.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GCSControlGadgetPlugin GCSControl Gadget Plugin
+ * @{
+ * @brief Streams the gamepad axes to the GCS receiver of the flight controller
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef GCSRECEIVERSTREAM_H
+#define GCSRECEIVERSTREAM_H
+
+#include "sdlgamepad/sdlgamepad.h"
+#include "gcsreceiver.h"
+
+#include <QThread>
+#include <QMutex>
+
+class TelemetryManager;
+
+/**
+ * Sends the gamepad axes as GCSReceiver channels at a fixed rate, from a thread
+ * of its own. The updates are unacked, timestamped and written straight to the
+ * link, the GUI and the telemetry queues are not involved.
+ *
+ * setAxes() is meant for a direct connection to SDLGamepad::axesValues(), so the
+ * values go from the gamepad thread to this one without the event loop.
+ */
+class GCSReceiverStream : public QThread {
+    Q_OBJECT
+
+public:
+    GCSReceiverStream(QObject *parent = 0);
+    ~GCSReceiverStream();
+
+    void setRate(int rate);
+    void setChannelsReverse(const QList<bool> &reverse);
+    void stop();
+
+public slots:
+    void setAxes(QListInt16 values);
+
+protected:
+    void run();
+
+private:
+    TelemetryManager *m_telemetryManager;
+    // Private copy, so setting it does not emit the updates of the shared instance
+    GCSReceiver *m_packet;
+
+    QMutex m_mutex;
+    QListInt16 m_axes;
+    QList<bool> m_reverse;
+    int m_periodMs;
+    bool m_running;
+};
+
+#endif // GCSRECEIVERSTREAM_H
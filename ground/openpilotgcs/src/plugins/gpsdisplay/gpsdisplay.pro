@@ -6,13 +6,13 @@ include(../../openpilotgcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri)
 include(gpsdisplay_dependencies.pri)
 include(../../libs/qwt/qwt.pri)
+INCLUDEPATH += $$ROOT_DIR/flight/modules/GPS/inc
 HEADERS += gpsdisplayplugin.h
 HEADERS += gpsconstellationwidget.h
 HEADERS += gpsparser.h
 HEADERS += telemetryparser.h
 HEADERS += gpssnrwidget.h
-HEADERS += buffer.h
-HEADERS += nmeaparser.h
+HEADERS += gpsstreamparser.h
 HEADERS += gpsdisplaygadget.h
 HEADERS += gpsdisplaywidget.h
 HEADERS += gpsdisplaygadgetfactory.h
@@ -23,8 +23,7 @@ SOURCES += gpsconstellationwidget.cpp
 SOURCES += gpsparser.cpp
 SOURCES += telemetryparser.cpp
 SOURCES += gpssnrwidget.cpp
-SOURCES += buffer.cpp
-SOURCES += nmeaparser.cpp
+SOURCES += gpsstreamparser.cpp
 SOURCES += gpsdisplaygadget.cpp
 SOURCES += gpsdisplaygadgetfactory.cpp
 SOURCES += gpsdisplaywidget.cpp
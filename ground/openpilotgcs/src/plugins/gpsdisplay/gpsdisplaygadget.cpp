@@ -79,7 +79,7 @@ void GpsDisplayGadget::loadConfiguration(IUAVGadgetConfiguration *config)
         foreach(QSerialPortInfo nport, ports) {
             if (nport.portName() == gpsDisplayConfig->port()) {
                 qDebug() << "Using Serial parser";
-                parser = new NMEAParser();
+                parser = new GPSStreamParser();
                 port   = new QSerialPort(nport);
                 m_widget->connectButton->setEnabled(true);
                 m_widget->disconnectButton->setEnabled(false);
@@ -166,10 +166,5 @@ void GpsDisplayGadget::onDataAvailable()
 
 void GpsDisplayGadget::processNewSerialData(QByteArray serialData)
 {
-    int dataLength   = serialData.size();
-    const char *data = serialData.constData();
-
-    for (int pos = 0; pos < dataLength; pos++) {
-        parser->processInputStream(data[pos]);
-    }
+    parser->processInputStream(serialData.constData(), serialData.size());
 }
@@ -32,7 +32,7 @@
 #include <QtSerialPort/QSerialPortInfo>
 #include <coreplugin/iuavgadget.h>
 #include "gpsdisplaywidget.h"
-#include "nmeaparser.h"
+#include "gpsstreamparser.h"
 #include "telemetryparser.h"
 
 class IUAVGadget;
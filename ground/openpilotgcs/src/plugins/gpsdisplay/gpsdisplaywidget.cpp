@@ -102,7 +102,8 @@ void GpsDisplayWidget::setFixType(const QString &fixtype)
 void GpsDisplayWidget::dumpPacket(const QString &packet)
 {
     textBrowser->append(packet);
-    if (textBrowser->document()->lineCount() > 200) {
+    // The parser sends all the packets of a display frame at once
+    while (textBrowser->document()->lineCount() > 200) {
         QTextCursor tc = textBrowser->textCursor();
         tc.movePosition(QTextCursor::Start);
         tc.movePosition(QTextCursor::Down, QTextCursor::KeepAnchor);
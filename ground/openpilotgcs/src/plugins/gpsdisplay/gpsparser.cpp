@@ -41,3 +41,10 @@ void GPSParser::processInputStream(char c)
         Q_UNUSED(c)
     }
 }
+
+void GPSParser::processInputStream(const char *data, int length)
+{
+    for (int pos = 0; pos < length; pos++) {
+        processInputStream(data[pos]);
+    }
+}
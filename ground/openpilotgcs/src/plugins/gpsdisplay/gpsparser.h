@@ -36,6 +36,7 @@ class GPSParser : public QObject {
     Q_OBJECT
 public: ~GPSParser();
     virtual void processInputStream(char c);
+    virtual void processInputStream(const char *data, int length);
 
 protected:
     GPSParser(QObject *parent = 0);
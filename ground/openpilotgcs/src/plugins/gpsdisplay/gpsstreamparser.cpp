@@ -0,0 +1,569 @@
+/**
+ ******************************************************************************
+ *
+ * @file       gpsstreamparser.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GPSGadgetPlugin GPS Gadget Plugin
+ * @{
+ * @brief A gadget that displays GPS status and enables basic configuration
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "gpsstreamparser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+GPSStreamParser::GPSStreamParser(QObject *parent) : GPSParser(parent),
+    numUpdates(0),
+    numErrors(0),
+    gpsRxOverflow(0),
+    state(STATE_START),
+    sentenceLength(0),
+    ubxCount(0),
+    ubxLength(0),
+    latitude(0),
+    longitude(0),
+    altitude(0),
+    groundspeed(0),
+    heading(0),
+    gpsDate(0),
+    gpsTime(0),
+    hdop(0),
+    vdop(0),
+    pdop(0),
+    svs(0),
+    fixTypeName("NoFix"),
+    fixModeManual(false),
+    numFixSVs(0),
+    updated(0),
+    packetLogLength(0)
+{
+    memset(satellites, 0, sizeof(satellites));
+    memset(shownSatellites, 0, sizeof(shownSatellites));
+
+    connect(&updateTimer, SIGNAL(timeout()), this, SLOT(emitUpdates()));
+    updateTimer.start(UPDATE_INTERVAL_MS);
+}
+
+GPSStreamParser::~GPSStreamParser()
+{}
+
+void GPSStreamParser::processInputStream(char c)
+{
+    processByte((uint8_t)c);
+}
+
+void GPSStreamParser::processInputStream(const char *data, int length)
+{
+    for (int i = 0; i < length; i++) {
+        processByte((uint8_t)data[i]);
+    }
+}
+
+void GPSStreamParser::processByte(uint8_t c)
+{
+    switch (state) {
+    case STATE_START:
+        if (c == '$') {
+            sentenceLength = 0;
+            state = STATE_NMEA;
+        } else if (c == UBX_SYNC1) {
+            state = STATE_UBX_SYNC2;
+        }
+        break;
+
+    case STATE_NMEA:
+        if (c == '\n') {
+            // Drop the <CR>
+            if (sentenceLength > 0 && sentence[sentenceLength - 1] == '\r') {
+                sentenceLength--;
+            }
+            sentence[sentenceLength] = 0;
+            processNMEASentence();
+            state = STATE_START;
+        } else if (c == '$') {
+            // Truncated sentence, start over
+            ++numErrors;
+            sentenceLength = 0;
+        } else if (sentenceLength < NMEA_MAX_SENTENCE - 1) {
+            sentence[sentenceLength++] = c;
+        } else {
+            ++gpsRxOverflow;
+            state = STATE_START;
+        }
+        break;
+
+    case STATE_UBX_SYNC2:
+        if (c == UBX_SYNC2) {
+            ubxCount = 0;
+            state    = STATE_UBX_HEADER;
+        } else {
+            state = (c == '$') ? STATE_NMEA : STATE_START;
+            sentenceLength = 0;
+        }
+        break;
+
+    case STATE_UBX_HEADER:
+        ubxHeader[ubxCount++] = c;
+        if (ubxCount == 4) {
+            ubxLength = ubxHeader[2] | (ubxHeader[3] << 8);
+            ubxCount  = 0;
+            if (ubxLength > UBX_MAX_PAYLOAD) {
+                ++gpsRxOverflow;
+                state = STATE_START;
+            } else {
+                state = (ubxLength > 0) ? STATE_UBX_PAYLOAD : STATE_UBX_CHECKSUM;
+            }
+        }
+        break;
+
+    case STATE_UBX_PAYLOAD:
+        ubxPayload[ubxCount++] = c;
+        if (ubxCount == ubxLength) {
+            ubxCount = 0;
+            state    = STATE_UBX_CHECKSUM;
+        }
+        break;
+
+    case STATE_UBX_CHECKSUM:
+        ubxChecksum[ubxCount++] = c;
+        if (ubxCount == 2) {
+            uint8_t ck_a, ck_b;
+            ubx_checksum(ubxHeader[0], ubxHeader[1], ubxLength, ubxPayload, &ck_a, &ck_b);
+            if (ck_a == ubxChecksum[0] && ck_b == ubxChecksum[1]) {
+                ++numUpdates;
+                processUBXMessage();
+            } else {
+                ++numErrors;
+            }
+            state = STATE_START;
+        }
+        break;
+    }
+}
+
+/**
+ * Checks and splits the sentence in place, then hands the fields to the
+ * handler of the sentence type whatever the talker (GP, GN, GL...)
+ */
+void GPSStreamParser::processNMEASentence()
+{
+    logPacket(sentence, sentenceLength);
+
+    char *star = strchr(sentence, '*');
+    if (!star) {
+        ++numErrors;
+        return;
+    }
+    uint8_t checksum = 0;
+    for (char *p = sentence; p < star; p++) {
+        checksum ^= (uint8_t)*p;
+    }
+    if (checksum != (uint8_t)strtol(star + 1, NULL, 16)) {
+        ++numErrors;
+        return;
+    }
+    ++numUpdates;
+    *star = 0;
+
+    char *fields[NMEA_MAX_FIELDS];
+    int count = 0;
+    fields[count++] = sentence;
+    for (char *p = sentence; *p && count < NMEA_MAX_FIELDS; p++) {
+        if (*p == ',') {
+            *p = 0;
+            fields[count++] = p + 1;
+        }
+    }
+    if (strlen(fields[0]) != 5) {
+        return;
+    }
+
+    const char *type = fields[0] + 2;
+    if (!strcmp(type, "GGA")) {
+        processGxGGA(fields, count);
+    } else if (!strcmp(type, "RMC")) {
+        processGxRMC(fields, count);
+    } else if (!strcmp(type, "VTG")) {
+        processGxVTG(fields, count);
+    } else if (!strcmp(type, "GSA")) {
+        processGxGSA(fields, count);
+    } else if (!strcmp(type, "GSV")) {
+        processGxGSV(fields, count);
+    } else if (!strcmp(type, "ZDA")) {
+        processGxZDA(fields, count);
+    }
+}
+
+void GPSStreamParser::processGxGGA(char *fields[], int count)
+{
+    if (count < 12 || !fields[2][0]) {
+        return;
+    }
+    gpsTime   = parseReal(fields[1]);
+    latitude  = parseLatLon(fields[2], fields[3]);
+    longitude = parseLatLon(fields[4], fields[5]);
+    svs       = atoi(fields[7]);
+    altitude  = parseReal(fields[9]);
+    updated  |= UPDATED_POSITION | UPDATED_SV | UPDATED_DATETIME;
+}
+
+void GPSStreamParser::processGxRMC(char *fields[], int count)
+{
+    if (count < 10 || !fields[1][0]) {
+        return;
+    }
+    gpsTime     = parseReal(fields[1]);
+    groundspeed = parseReal(fields[7]) * 0.51444; // knots
+    heading     = parseReal(fields[8]);
+    gpsDate     = parseReal(fields[9]);
+    updated    |= UPDATED_DATETIME | UPDATED_SPEEDHEADING;
+}
+
+void GPSStreamParser::processGxVTG(char *fields[], int count)
+{
+    if (count < 8 || !fields[1][0]) {
+        return;
+    }
+    heading     = parseReal(fields[1]);
+    groundspeed = parseReal(fields[7]) / 3.6; // km/h
+    updated    |= UPDATED_SPEEDHEADING;
+}
+
+void GPSStreamParser::processGxGSA(char *fields[], int count)
+{
+    if (count < 18) {
+        return;
+    }
+    // M=Manual, forced to operate in 2D or 3D, A=Automatic, 3D/2D
+    if (fields[1][0] == 'A' || fields[1][0] == 'M') {
+        fixModeManual = (fields[1][0] == 'M');
+        updated |= UPDATED_FIXMODE;
+    }
+
+    // Mode: 1=Fix not available, 2=2D, 3=3D
+    switch (atoi(fields[2])) {
+    case 1:
+        fixTypeName = "NoFix";
+        break;
+    case 2:
+        fixTypeName = "Fix2D";
+        break;
+    case 3:
+        fixTypeName = "Fix3D";
+        break;
+    }
+
+    // 3-14 = IDs of SVs used in position fix (null for unused fields)
+    numFixSVs = 0;
+    for (int pos = 0; pos < MAX_FIX_SVS; pos++) {
+        if (fields[3 + pos][0]) {
+            fixSVList[numFixSVs++] = atoi(fields[3 + pos]);
+        }
+    }
+
+    pdop     = parseReal(fields[15]);
+    hdop     = parseReal(fields[16]);
+    vdop     = parseReal(fields[17]);
+    updated |= UPDATED_FIXTYPE | UPDATED_FIXSVS | UPDATED_DOP;
+}
+
+void GPSStreamParser::processGxGSV(char *fields[], int count)
+{
+    if (count < 4) {
+        return;
+    }
+    // Officially there should be a max of three sentences (12 sats), some gps receivers do more..
+    const int sentence_total = atoi(fields[1]);
+    const int sentence_index = atoi(fields[2]);
+    if (sentence_index < 1) {
+        return;
+    }
+
+    int sats = (count - 4) / 4;
+    for (int sat = 0; sat < sats; sat++) {
+        int base = 4 + sat * 4;
+        setSatellite((sentence_index - 1) * 4 + sat, atoi(fields[base]), atoi(fields[base + 1]),
+                     atoi(fields[base + 2]), atoi(fields[base + 3]));
+    }
+    if (sentence_index == sentence_total) {
+        // Last sentence, wipe the rest
+        clearSatellites((sentence_index - 1) * 4 + sats);
+    }
+}
+
+void GPSStreamParser::processGxZDA(char *fields[], int count)
+{
+    if (count < 5 || !fields[1][0]) {
+        return;
+    }
+    gpsTime  = parseReal(fields[1]);
+    gpsDate  = atoi(fields[2]) * 10000 + atoi(fields[3]) * 100 + (atoi(fields[4]) - 2000);
+    updated |= UPDATED_DATETIME;
+}
+
+void GPSStreamParser::processUBXMessage()
+{
+    char text[32];
+    int length = snprintf(text, sizeof(text), "UBX %02X-%02X (%u bytes)", ubxHeader[0], ubxHeader[1], ubxLength);
+
+    logPacket(text, length);
+
+    if (ubxHeader[0] != UBX_CLASS_NAV) {
+        return;
+    }
+
+    // Copied out of the byte buffer, the payload is not aligned
+    switch (ubxHeader[1]) {
+    case UBX_ID_NAV_POSLLH:
+        if (ubxLength == sizeof(struct UBX_NAV_POSLLH)) {
+            struct UBX_NAV_POSLLH posllh;
+            memcpy(&posllh, ubxPayload, sizeof(posllh));
+            latitude  = posllh.lat * 1e-7;
+            longitude = posllh.lon * 1e-7;
+            altitude  = posllh.hMSL * 0.001;
+            updated  |= UPDATED_POSITION;
+        }
+        break;
+    case UBX_ID_NAV_VELNED:
+        if (ubxLength == sizeof(struct UBX_NAV_VELNED)) {
+            struct UBX_NAV_VELNED velned;
+            memcpy(&velned, ubxPayload, sizeof(velned));
+            groundspeed = velned.gSpeed * 0.01;
+            heading     = velned.heading * 1e-5;
+            updated    |= UPDATED_SPEEDHEADING;
+        }
+        break;
+    case UBX_ID_NAV_DOP:
+        if (ubxLength == sizeof(struct UBX_NAV_DOP)) {
+            struct UBX_NAV_DOP dop;
+            memcpy(&dop, ubxPayload, sizeof(dop));
+            hdop     = dop.hDOP * 0.01;
+            vdop     = dop.vDOP * 0.01;
+            pdop     = dop.pDOP * 0.01;
+            updated |= UPDATED_DOP;
+        }
+        break;
+    case UBX_ID_NAV_SOL:
+        if (ubxLength == sizeof(struct UBX_NAV_SOL)) {
+            struct UBX_NAV_SOL sol;
+            memcpy(&sol, ubxPayload, sizeof(sol));
+            svs = sol.numSV;
+            if (!(sol.flags & STATUS_FLAGS_GPSFIX_OK)) {
+                fixTypeName = "NoFix";
+            } else if (sol.gpsFix == STATUS_GPSFIX_2DFIX) {
+                fixTypeName = "Fix2D";
+            } else if (sol.gpsFix == STATUS_GPSFIX_3DFIX) {
+                fixTypeName = "Fix3D";
+            } else {
+                fixTypeName = "NoFix";
+            }
+            updated |= UPDATED_SV | UPDATED_FIXTYPE;
+        }
+        break;
+    case UBX_ID_NAV_PVT:
+        if (ubxLength == sizeof(struct UBX_NAV_PVT)) {
+            struct UBX_NAV_PVT pvt;
+            memcpy(&pvt, ubxPayload, sizeof(pvt));
+            latitude    = pvt.lat * 1e-7;
+            longitude   = pvt.lon * 1e-7;
+            altitude    = pvt.hMSL * 0.001;
+            groundspeed = pvt.gSpeed * 0.001;
+            heading     = pvt.heading * 1e-5;
+            pdop = pvt.pDOP * 0.01;
+            svs  = pvt.numSV;
+            if (!(pvt.flags & PVT_FLAGS_GNSSFIX_OK)) {
+                fixTypeName = "NoFix";
+            } else if (pvt.fixType == PVT_FIX_TYPE_2D) {
+                fixTypeName = "Fix2D";
+            } else if (pvt.fixType == PVT_FIX_TYPE_3D) {
+                fixTypeName = "Fix3D";
+            } else {
+                fixTypeName = "NoFix";
+            }
+            updated |= UPDATED_POSITION | UPDATED_SPEEDHEADING | UPDATED_SV | UPDATED_FIXTYPE;
+            if (pvt.valid & PVT_VALID_VALIDDATE && pvt.valid & PVT_VALID_VALIDTIME) {
+                gpsDate  = pvt.day * 10000 + pvt.month * 100 + (pvt.year - 2000);
+                gpsTime  = pvt.hour * 10000 + pvt.min * 100 + pvt.sec;
+                updated |= UPDATED_DATETIME;
+            }
+        }
+        break;
+    case UBX_ID_NAV_TIMEUTC:
+        if (ubxLength == sizeof(struct UBX_NAV_TIMEUTC)) {
+            struct UBX_NAV_TIMEUTC timeutc;
+            memcpy(&timeutc, ubxPayload, sizeof(timeutc));
+            if (timeutc.valid & TIMEUTC_VALIDUTC) {
+                gpsDate  = timeutc.day * 10000 + timeutc.month * 100 + (timeutc.year - 2000);
+                gpsTime  = timeutc.hour * 10000 + timeutc.min * 100 + timeutc.sec;
+                updated |= UPDATED_DATETIME;
+            }
+        }
+        break;
+    case UBX_ID_NAV_SVINFO:
+    {
+        const int headerLength = sizeof(struct UBX_NAV_SVINFO) - sizeof(struct UBX_NAV_SVINFO_SV) * MAX_SVS;
+        if (ubxLength >= headerLength) {
+            int numCh = qMin((int)ubxPayload[4], (ubxLength - headerLength) / (int)sizeof(struct UBX_NAV_SVINFO_SV));
+            int index = 0;
+            for (int chan = 0; chan < numCh && index < MAX_SATELLITES; chan++) {
+                struct UBX_NAV_SVINFO_SV sv;
+                memcpy(&sv, &ubxPayload[headerLength + chan * sizeof(sv)], sizeof(sv));
+                setSatellite(index++, sv.svid, sv.elev, sv.azim, sv.cno);
+            }
+            clearSatellites(index);
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void GPSStreamParser::setSatellite(int index, int prn, int elevation, int azimuth, int snr)
+{
+    if (index < 0 || index >= MAX_SATELLITES) {
+        return;
+    }
+    satellites[index].prn       = prn;
+    satellites[index].elevation = elevation;
+    satellites[index].azimuth   = azimuth;
+    satellites[index].snr = snr;
+    updated |= UPDATED_SATELLITES;
+}
+
+void GPSStreamParser::clearSatellites(int from)
+{
+    for (int index = from; index < MAX_SATELLITES; index++) {
+        setSatellite(index, 0, 0, 0, 0);
+    }
+}
+
+/**
+ * Keeps the raw packets of this frame for the data stream view, the rest is dropped
+ */
+void GPSStreamParser::logPacket(const char *text, int length)
+{
+    if (packetLogLength + length + 1 > PACKET_LOG_SIZE) {
+        return;
+    }
+    if (packetLogLength > 0) {
+        packetLog[packetLogLength++] = '\n';
+    }
+    memcpy(&packetLog[packetLogLength], text, length);
+    packetLogLength += length;
+}
+
+/**
+ * Emits what changed since the last display frame, at most once per value
+ */
+void GPSStreamParser::emitUpdates()
+{
+    if (packetLogLength > 0) {
+        emit packet(QString::fromLatin1(packetLog, packetLogLength));
+        packetLogLength = 0;
+    }
+    if (!updated) {
+        return;
+    }
+    if (updated & UPDATED_POSITION) {
+        emit position(latitude, longitude, altitude);
+    }
+    if (updated & UPDATED_SPEEDHEADING) {
+        emit speedheading(groundspeed, heading);
+    }
+    if (updated & UPDATED_DATETIME) {
+        emit datetime(gpsDate, gpsTime);
+    }
+    if (updated & UPDATED_SV) {
+        emit sv(svs);
+    }
+    if (updated & UPDATED_FIXTYPE) {
+        emit fixtype(QString(fixTypeName));
+    }
+    if (updated & UPDATED_FIXMODE) {
+        emit fixmode(fixModeManual ? QString("Manual") : QString("Auto"));
+    }
+    if (updated & UPDATED_DOP) {
+        emit dop(hdop, vdop, pdop);
+    }
+    if (updated & UPDATED_FIXSVS) {
+        QList<int> svList;
+        for (int i = 0; i < numFixSVs; i++) {
+            svList.append(fixSVList[i]);
+        }
+        emit fixSVs(svList);
+    }
+    if (updated & UPDATED_SATELLITES) {
+        for (int index = 0; index < MAX_SATELLITES; index++) {
+            const Satellite &sat = satellites[index];
+            if (memcmp(&sat, &shownSatellites[index], sizeof(sat))) {
+                shownSatellites[index] = sat;
+                emit satellite(index, sat.prn, sat.elevation, sat.azimuth, sat.snr);
+            }
+        }
+    }
+    updated = 0;
+}
+
+/**
+ * Parses a decimal NMEA field, independently of the locale
+ */
+double GPSStreamParser::parseReal(const char *field)
+{
+    double value = 0;
+    double scale = 1;
+    bool negative = false;
+    bool fraction = false;
+
+    if (*field == '-') {
+        negative = true;
+        field++;
+    }
+    for (; *field; field++) {
+        if (*field == '.') {
+            fraction = true;
+        } else if (*field >= '0' && *field <= '9') {
+            value = value * 10 + (*field - '0');
+            if (fraction) {
+                scale *= 10;
+            }
+        } else {
+            break;
+        }
+    }
+    value /= scale;
+    return negative ? -value : value;
+}
+
+/**
+ * Converts a ddmm.mmmm NMEA field to degrees
+ */
+double GPSStreamParser::parseLatLon(const char *field, const char *hemisphere)
+{
+    double value = parseReal(field);
+    int deg = (int)value / 100;
+    double degrees = deg + (value - deg * 100) / 60.0;
+
+    if (*hemisphere == 'S' || *hemisphere == 'W') {
+        degrees = -degrees;
+    }
+    return degrees;
+}
@@ -0,0 +1,146 @@
+/**
+ ******************************************************************************
+ *
+ * @file       gpsstreamparser.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup GPSGadgetPlugin GPS Gadget Plugin
+ * @{
+ * @brief A gadget that displays GPS status and enables basic configuration
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef GPSSTREAMPARSER_H
+#define GPSSTREAMPARSER_H
+
+#include <QObject>
+#include <QTimer>
+#include <stdint.h>
+#include "gpsparser.h"
+#include "ubx_protocol.h"
+
+/**
+ * Parser of a raw serial GPS stream, NMEA sentences and UBX messages can be mixed.
+ * The bytes go through a state machine into fixed buffers, and the values are
+ * kept until the next display frame where only the changed ones are emitted.
+ */
+class GPSStreamParser : public GPSParser {
+    Q_OBJECT
+
+public:
+    GPSStreamParser(QObject *parent = 0);
+    ~GPSStreamParser();
+    void processInputStream(char c);
+    void processInputStream(const char *data, int length);
+
+    uint32_t numUpdates;
+    uint32_t numErrors;
+    uint32_t gpsRxOverflow;
+
+private slots:
+    void emitUpdates();
+
+private:
+    static const int UPDATE_INTERVAL_MS  = 16; // about one display frame
+    static const int NMEA_MAX_SENTENCE   = 128;
+    static const int NMEA_MAX_FIELDS     = 32;
+    static const int UBX_MAX_PAYLOAD     = 256;
+    static const int MAX_SATELLITES      = 16;
+    static const int MAX_FIX_SVS         = 12;
+    static const int PACKET_LOG_SIZE     = 4096;
+
+    enum ParserState {
+        STATE_START,
+        STATE_NMEA,
+        STATE_UBX_SYNC2,
+        STATE_UBX_HEADER,
+        STATE_UBX_PAYLOAD,
+        STATE_UBX_CHECKSUM
+    };
+
+    // Values changed since the last display frame
+    enum {
+        UPDATED_POSITION     = 1 << 0,
+        UPDATED_SPEEDHEADING = 1 << 1,
+        UPDATED_DATETIME     = 1 << 2,
+        UPDATED_SV           = 1 << 3,
+        UPDATED_FIXTYPE      = 1 << 4,
+        UPDATED_FIXMODE      = 1 << 5,
+        UPDATED_DOP          = 1 << 6,
+        UPDATED_FIXSVS       = 1 << 7,
+        UPDATED_SATELLITES   = 1 << 8
+    };
+
+    struct Satellite {
+        int prn;
+        int elevation;
+        int azimuth;
+        int snr;
+    };
+
+    void processByte(uint8_t c);
+    void processNMEASentence();
+    void processUBXMessage();
+    void processGxGGA(char *fields[], int count);
+    void processGxRMC(char *fields[], int count);
+    void processGxVTG(char *fields[], int count);
+    void processGxGSA(char *fields[], int count);
+    void processGxGSV(char *fields[], int count);
+    void processGxZDA(char *fields[], int count);
+    void setSatellite(int index, int prn, int elevation, int azimuth, int snr);
+    void clearSatellites(int from);
+    void logPacket(const char *text, int length);
+
+    static double parseReal(const char *field);
+    static double parseLatLon(const char *field, const char *hemisphere);
+
+    ParserState state;
+    char     sentence[NMEA_MAX_SENTENCE];
+    int      sentenceLength;
+    uint8_t  ubxHeader[4]; // class, id, length
+    uint8_t  ubxPayload[UBX_MAX_PAYLOAD];
+    uint8_t  ubxChecksum[2];
+    int      ubxCount;
+    uint16_t ubxLength;
+
+    double   latitude;
+    double   longitude;
+    double   altitude;
+    double   groundspeed;
+    double   heading;
+    double   gpsDate;
+    double   gpsTime;
+    double   hdop;
+    double   vdop;
+    double   pdop;
+    int      svs;
+    const char *fixTypeName;
+    bool     fixModeManual;
+    int      fixSVList[MAX_FIX_SVS];
+    int      numFixSVs;
+    Satellite satellites[MAX_SATELLITES];
+    Satellite shownSatellites[MAX_SATELLITES];
+    quint32  updated;
+
+    char     packetLog[PACKET_LOG_SIZE];
+    int      packetLogLength;
+
+    QTimer   updateTimer;
+};
+
+#endif // GPSSTREAMPARSER_H
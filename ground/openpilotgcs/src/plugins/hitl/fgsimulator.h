@@ -49,6 +49,7 @@ private:
 
     int udpCounterGCSsend; // keeps track of udp packets sent to FG
     int udpCounterFGrecv; // keeps track of udp packets received by FG
+    Utils::CoordinateConversions coordinates; // keeps the conversion of the home location
 
     void processUpdate(const QByteArray & data);
 };
@@ -46,6 +46,7 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings *qSettings, QObj
 
     settings.attRawEnabled        = false;
     settings.attRawRate           = 20;
+    settings.sensorPacketEnabled  = false;
 
     settings.attStateEnabled      = true;
     settings.attActHW             = false;
@@ -88,6 +89,7 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings *qSettings, QObj
 
         settings.attRawEnabled        = qSettings->value("attRawEnabled").toBool();
         settings.attRawRate           = qSettings->value("attRawRate").toInt();
+        settings.sensorPacketEnabled  = qSettings->value("sensorPacketEnabled").toBool();
 
         settings.attStateEnabled      = qSettings->value("attStateEnabled").toBool();
         settings.attActHW = qSettings->value("attActHW").toBool();
@@ -144,6 +146,7 @@ void HITLConfiguration::saveConfig(QSettings *qSettings) const
 
     qSettings->setValue("attRawEnabled", settings.attRawEnabled);
     qSettings->setValue("attRawRate", settings.attRawRate);
+    qSettings->setValue("sensorPacketEnabled", settings.sensorPacketEnabled);
     qSettings->setValue("attStateEnabled", settings.attStateEnabled);
     qSettings->setValue("attActHW", settings.attActHW);
     qSettings->setValue("attActSim", settings.attActSim);
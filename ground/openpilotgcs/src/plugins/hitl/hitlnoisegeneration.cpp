@@ -26,11 +26,31 @@
  */
 
 #include "hitlnoisegeneration.h"
+#include <math.h>
 
 
-HitlNoiseGeneration::HitlNoiseGeneration()
+static void setupModel(NoiseSensorModel *model, float sigma, float correlation, float correlatedSigma, float biasWalk, float tempCoeff)
+{
+    memset(model, 0, sizeof(NoiseSensorModel));
+    model->sigma = sigma;
+    model->correlation     = correlation;
+    model->correlatedSigma = correlatedSigma;
+    model->biasWalk  = biasWalk;
+    model->tempCoeff = tempCoeff;
+    model->tempRef   = 20.0f;
+}
+
+HitlNoiseGeneration::HitlNoiseGeneration(quint64 seed)
 {
     memset(&noise, 0, sizeof(Noise));
+    NoiseSeed(&generator, seed);
+
+    setupModel(&gyroModel, 0.1f, 0.0f, 0.0f, 0.01f, 0.02f); // deg/s
+    setupModel(&accelModel, 0.05f, 0.0f, 0.0f, 0.001f, 0.005f); // m/s^2
+    setupModel(&attitudeModel, 0.05f, 0.0f, 0.0f, 0.0f, 0.0f); // deg
+    setupModel(&gpsPosModel, 0.2f, 0.99f, 1.5f, 0.0f, 0.0f);
+    setupModel(&gpsVelModel, 0.05f, 0.9f, 0.1f, 0.0f, 0.0f);
+    setupModel(&baroModel, 0.1f, 0.95f, 0.3f, 0.0f, 0.0f);
 }
 
 
@@ -42,37 +62,57 @@ Noise HitlNoiseGeneration::getNoise()
     return noise;
 }
 
-Noise HitlNoiseGeneration::generateNoise()
+/**
+ * Errors for one simulator update, dT is the time since the previous one
+ */
+Noise HitlNoiseGeneration::generateNoise(float dT, float temperature)
 {
-    noise.accelStateData.x       = 0;
-    noise.accelStateData.y       = 0;
-    noise.accelStateData.z       = 0;
-
-    noise.gpsPosData.Latitude    = 0;
-    noise.gpsPosData.Longitude   = 0;
-    noise.gpsPosData.Groundspeed = 0;
-    noise.gpsPosData.Heading     = 0;
-    noise.gpsPosData.Altitude    = 0;
+    float v[3];
 
-    noise.gpsVelData.North       = 0;
-    noise.gpsVelData.East = 0;
-    noise.gpsVelData.Down = 0;
+    v[0] = v[1] = v[2] = 0;
+    NoiseSensorApply(&gyroModel, &generator, v, dT, temperature);
+    noise.gyroStateData.x  = v[0];
+    noise.gyroStateData.y  = v[1];
+    noise.gyroStateData.z  = v[2];
 
-    noise.baroAltData.Altitude = 0;
+    v[0] = v[1] = v[2] = 0;
+    NoiseSensorApply(&accelModel, &generator, v, dT, temperature);
+    noise.accelStateData.x = v[0];
+    noise.accelStateData.y = v[1];
+    noise.accelStateData.z = v[2];
 
-    noise.attStateData.Roll    = 0;
-    noise.attStateData.Pitch   = 0;
-    noise.attStateData.Yaw     = 0;
+    v[0] = v[1] = v[2] = 0;
+    NoiseSensorApply(&attitudeModel, &generator, v, dT, temperature);
+    noise.attStateData.Roll  = v[0];
+    noise.attStateData.Pitch = v[1];
+    noise.attStateData.Yaw   = v[2];
 
-    noise.gyroStateData.x  = 0;
-    noise.gyroStateData.y  = 0;
-    noise.gyroStateData.z  = 0;
+    // Latitude and Longitude are in 1e-7 deg, about 1.1 cm
+    v[0] = v[1] = v[2] = 0;
+    NoiseSensorApply(&gpsPosModel, &generator, v, dT, temperature);
+    noise.gpsPosData.Latitude    = v[0] * 90.0f;
+    noise.gpsPosData.Longitude   = v[1] * 90.0f;
+    noise.gpsPosData.Altitude    = v[2];
+    noise.positionStateData.North = v[0];
+    noise.positionStateData.East  = v[1];
+    noise.positionStateData.Down  = v[2];
 
-    noise.accelStateData.x = 0;
-    noise.accelStateData.y = 0;
-    noise.accelStateData.z = 0;
+    v[0] = v[1] = v[2] = 0;
+    NoiseSensorApply(&gpsVelModel, &generator, v, dT, temperature);
+    noise.gpsVelData.North       = v[0];
+    noise.gpsVelData.East        = v[1];
+    noise.gpsVelData.Down        = v[2];
+    noise.velocityStateData.North = v[0];
+    noise.velocityStateData.East  = v[1];
+    noise.velocityStateData.Down  = v[2];
+    noise.gpsPosData.Groundspeed = sqrtf(v[0] * v[0] + v[1] * v[1]);
+    noise.gpsPosData.Heading     = 0;
 
-    noise.airspeedState.CalibratedAirspeed = 0;
+    v[0] = v[1] = v[2] = 0;
+    NoiseSensorApply(&baroModel, &generator, v, dT, temperature);
+    noise.baroAltData.Altitude   = v[0];
+    noise.airspeedState.CalibratedAirspeed = v[1];
+    noise.airspeedState.TrueAirspeed = v[1];
 
     return noise;
 }
@@ -36,6 +36,10 @@
 #include <coreplugin/icore.h>
 #include <coreplugin/threadmanager.h>
 
+extern "C" {
+#include "math/noise.h"
+}
+
 struct Noise {
     AccelState::DataFields        accelStateData;
     AttitudeState::DataFields     attStateData;
@@ -52,14 +56,21 @@ struct Noise {
 class HitlNoiseGeneration {
 // Q_OBJECT
 public:
-    HitlNoiseGeneration();
+    HitlNoiseGeneration(quint64 seed = 1);
     ~HitlNoiseGeneration();
 
     Noise getNoise();
-    Noise generateNoise();
+    Noise generateNoise(float dT, float temperature);
 private slots:
 
 private:
     Noise noise;
+    NoiseGenerator generator;
+    NoiseSensorModel gyroModel;
+    NoiseSensorModel accelModel;
+    NoiseSensorModel attitudeModel;
+    NoiseSensorModel gpsPosModel; // North, East, Down in m
+    NoiseSensorModel gpsVelModel;
+    NoiseSensorModel baroModel; // altitude, airspeed, unused
 };
 #endif // HITLNOISEGENERATION_H
@@ -94,6 +94,7 @@ QWidget *HITLOptionsPage::createPage(QWidget *parent)
     m_optionsPage->gpsPositionCheckbox->setChecked(config->Settings().gpsPositionEnabled);
     m_optionsPage->attStateCheckbox->setChecked(config->Settings().attStateEnabled);
     m_optionsPage->attRawCheckbox->setChecked(config->Settings().attRawEnabled);
+    m_optionsPage->sensorPacketCheckbox->setChecked(config->Settings().sensorPacketEnabled);
 
 
     m_optionsPage->attRawRateSpinbox->setValue(config->Settings().attRawRate);
@@ -138,6 +139,7 @@ void HITLOptionsPage::apply()
 
     settings.attRawEnabled        = m_optionsPage->attRawCheckbox->isChecked();
     settings.attRawRate           = m_optionsPage->attRawRateSpinbox->value();
+    settings.sensorPacketEnabled  = m_optionsPage->sensorPacketCheckbox->isChecked();
 
     settings.attStateEnabled      = m_optionsPage->attStateCheckbox->isChecked();
 
@@ -5,6 +5,8 @@ QT += network
 include(../../openpilotgcsplugin.pri)
 include(hitl_dependencies.pri)
 
+INCLUDEPATH += $$ROOT_DIR/flight/libraries
+
 HEADERS += hitlplugin.h \
     hitlwidget.h \
     hitloptionspage.h \
@@ -28,7 +30,8 @@ SOURCES += hitlplugin.cpp \
     aerosimrcsimulator.cpp \
     fgsimulator.cpp \
     il2simulator.cpp \
-    xplanesimulator.cpp
+    xplanesimulator.cpp \
+    $$ROOT_DIR/flight/libraries/math/noise.c
 OTHER_FILES += hitl.pluginspec
 FORMS += hitloptionspage.ui \
     hitlwidget.ui
@@ -59,8 +59,8 @@ Simulator::Simulator(const SimulatorSettings & params) :
     simTimer(NULL),
     name("")
 {
-    // move to thread
-    moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
+    // move to a thread of its own, the simulator traffic must not hold up telemetry
+    moveToThread(Core::ICore::instance()->threadManager()->getLinkThread("Simulator"));
     connect(this, SIGNAL(myStart()), this, SLOT(onStart()), Qt::QueuedConnection);
     emit myStart();
 
@@ -72,6 +72,8 @@ Simulator::Simulator(const SimulatorSettings & params) :
     baroAltTime       = currentTime;
     battTime = currentTime;
     airspeedStateTime = currentTime;
+    hitlSimTime = 0;
+    noiseSource = new HitlNoiseGeneration();
 
     // Define standard atmospheric constants
     airParameters.univGasConstant  = 8.31447; // [J/(mol·K)]
@@ -105,6 +107,8 @@ Simulator::~Simulator()
         delete simTimer;
         simTimer = NULL;
     }
+
+    delete noiseSource;
     // NOTE: Does not currently work, may need to send control+c to through the terminal
     if (simProcess != NULL) {
         // connect(simProcess,SIGNAL(finished(int, QProcess::ExitStatus)),this,SLOT(onFinished(int, QProcess::ExitStatus)));
@@ -161,6 +165,7 @@ void Simulator::onStart()
     gpsVel = GPSVelocitySensor::GetInstance(objManager);
     telStats      = GCSTelemetryStats::GetInstance(objManager);
     groundTruth   = GroundTruth::GetInstance(objManager);
+    hitlSensors   = HITLSensors::GetInstance(objManager);
 
     // Listen to autopilot connection events
     TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
@@ -252,7 +257,12 @@ void Simulator::setupObjects()
 
     setupOutputObject(posHome, 10000); // Hardcoded? Bleh.
 
-    if (settings.gpsPositionEnabled) {
+    if (settings.sensorPacketEnabled) {
+        // The firmware writes the sensor objects itself, from HITLSensors
+        hitlSensors->setMetadata(hitlSensors->getDefaultMetadata());
+    }
+
+    if (settings.gpsPositionEnabled && !settings.sensorPacketEnabled) {
         setupOutputObject(gpsPos, settings.gpsPosRate);
         setupOutputObject(gpsVel, settings.gpsPosRate);
     }
@@ -262,12 +272,12 @@ void Simulator::setupObjects()
         setupOutputObject(velState, settings.groundTruthRate);
     }
 
-    if (settings.attRawEnabled) {
+    if (settings.attRawEnabled && !settings.sensorPacketEnabled) {
         setupOutputObject(accelState, settings.attRawRate);
         setupOutputObject(gyroState, settings.attRawRate);
     }
 
-    if (settings.attStateEnabled && settings.attActHW) {
+    if (settings.attStateEnabled && settings.attActHW && !settings.sensorPacketEnabled) {
         setupOutputObject(accelState, settings.attRawRate);
         setupOutputObject(gyroState, settings.attRawRate);
     }
@@ -277,12 +287,14 @@ void Simulator::setupObjects()
     } else {
         setupWatchedObject(attState, 100); // Hardcoded? Bleh.
     }
-    if (settings.airspeedStateEnabled) {
+    if (settings.airspeedStateEnabled && !settings.sensorPacketEnabled) {
         setupOutputObject(airspeedState, settings.airspeedStateRate);
     }
 
     if (settings.baroSensorEnabled) {
-        setupOutputObject(baroAlt, settings.baroAltRate);
+        if (!settings.sensorPacketEnabled) {
+            setupOutputObject(baroAlt, settings.baroAltRate);
+        }
         setupOutputObject(flightBatt, settings.baroAltRate);
     }
 }
@@ -392,10 +404,9 @@ void Simulator::updateUAVOs(Output2Hardware out)
     QTime currentTime = QTime::currentTime();
 
     Noise noise;
-    HitlNoiseGeneration noiseSource;
 
     if (settings.addNoise) {
-        noise = noiseSource.generateNoise();
+        noise = noiseSource->generateNoise(out.delT, out.temperature);
     } else {
         memset(&noise, 0, sizeof(Noise));
     }
@@ -626,7 +637,12 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
 
     /*******************************/
-    if (settings.gpsPositionEnabled) {
+    if (settings.sensorPacketEnabled) {
+        sendSensorPacket(out, noise, currentTime);
+    }
+
+    /*******************************/
+    if (settings.gpsPositionEnabled && !settings.sensorPacketEnabled) {
         if (gpsPosTime.msecsTo(currentTime) >= settings.gpsPosRate) {
             qDebug() << " GPS time:" << gpsPosTime << ", currentTime: " << currentTime << ", difference: " << gpsPosTime.msecsTo(currentTime);
             // Update GPS Position objects
@@ -705,7 +721,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
     /*******************************/
     // Update BaroSensor object
-    if (settings.baroSensorEnabled) {
+    if (settings.baroSensorEnabled && !settings.sensorPacketEnabled) {
         if (baroAltTime.msecsTo(currentTime) >= settings.baroAltRate) {
             BaroSensor::DataFields baroAltData;
             memset(&baroAltData, 0, sizeof(BaroSensor::DataFields));
@@ -735,7 +751,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
     /*******************************/
     // Update AirspeedState object
-    if (settings.airspeedStateEnabled) {
+    if (settings.airspeedStateEnabled && !settings.sensorPacketEnabled) {
         if (airspeedStateTime.msecsTo(currentTime) >= settings.airspeedStateRate) {
             AirspeedState::DataFields airspeedStateData;
             memset(&airspeedStateData, 0, sizeof(AirspeedState::DataFields));
@@ -751,7 +767,7 @@ void Simulator::updateUAVOs(Output2Hardware out)
 
     /*******************************/
     // Update raw attitude sensors
-    if (settings.attRawEnabled) {
+    if (settings.attRawEnabled && !settings.sensorPacketEnabled) {
         if (attRawTime.msecsTo(currentTime) >= settings.attRawRate) {
             // Update gyroscope sensor data
             GyroState::DataFields gyroStateData;
@@ -774,6 +790,60 @@ void Simulator::updateUAVOs(Output2Hardware out)
     }
 }
 
+/**
+ * Send every sensor in one unacked HITLSensors update, the slower sensors
+ * are flagged as updated at their configured rate.
+ */
+void Simulator::sendSensorPacket(const Output2Hardware & out, const Noise & noise, const QTime & currentTime)
+{
+    HITLSensors::DataFields data;
+
+    memset(&data, 0, sizeof(HITLSensors::DataFields));
+
+    // Simulator time, so that the firmware can drop packets that arrive out of order
+    hitlSimTime  += qMax((quint32)1, (quint32)(out.delT * 1e6f));
+    data.SimTime  = hitlSimTime;
+
+    data.Updated[HITLSensors::UPDATED_GYRO]  = HITLSensors::UPDATED_TRUE;
+    data.Gyro[HITLSensors::GYRO_X]           = out.rollRate + noise.gyroStateData.x;
+    data.Gyro[HITLSensors::GYRO_Y]           = out.pitchRate + noise.gyroStateData.y;
+    data.Gyro[HITLSensors::GYRO_Z]           = out.yawRate + noise.gyroStateData.z;
+    data.Updated[HITLSensors::UPDATED_ACCEL] = HITLSensors::UPDATED_TRUE;
+    data.Accel[HITLSensors::ACCEL_X]         = out.accX + noise.accelStateData.x;
+    data.Accel[HITLSensors::ACCEL_Y]         = out.accY + noise.accelStateData.y;
+    data.Accel[HITLSensors::ACCEL_Z]         = out.accZ + noise.accelStateData.z;
+    data.Temperature = out.temperature;
+
+    if (settings.baroSensorEnabled && baroAltTime.msecsTo(currentTime) >= settings.baroAltRate) {
+        data.Updated[HITLSensors::UPDATED_BARO] = HITLSensors::UPDATED_TRUE;
+        data.BaroAltitude = out.altitude + noise.baroAltData.Altitude;
+        data.BaroPressure = out.pressure + noise.baroAltData.Pressure;
+        baroAltTime = baroAltTime.addMSecs(settings.baroAltRate);
+    }
+
+    if (settings.gpsPositionEnabled && gpsPosTime.msecsTo(currentTime) >= settings.gpsPosRate) {
+        data.Updated[HITLSensors::UPDATED_GPS] = HITLSensors::UPDATED_TRUE;
+        data.Latitude    = out.latitude + noise.gpsPosData.Latitude;
+        data.Longitude   = out.longitude + noise.gpsPosData.Longitude;
+        data.Altitude    = out.altitude + noise.gpsPosData.Altitude;
+        data.Groundspeed = out.groundspeed + noise.gpsPosData.Groundspeed;
+        data.Heading     = out.heading + noise.gpsPosData.Heading;
+        data.VelocityNED[HITLSensors::VELOCITYNED_NORTH] = out.velNorth + noise.gpsVelData.North;
+        data.VelocityNED[HITLSensors::VELOCITYNED_EAST]  = out.velEast + noise.gpsVelData.East;
+        data.VelocityNED[HITLSensors::VELOCITYNED_DOWN]  = out.velDown + noise.gpsVelData.Down;
+        gpsPosTime = gpsPosTime.addMSecs(settings.gpsPosRate);
+    }
+
+    if (settings.airspeedStateEnabled && airspeedStateTime.msecsTo(currentTime) >= settings.airspeedStateRate) {
+        data.Updated[HITLSensors::UPDATED_AIRSPEED] = HITLSensors::UPDATED_TRUE;
+        data.CalibratedAirspeed = out.calibratedAirspeed + noise.airspeedState.CalibratedAirspeed;
+        data.TrueAirspeed = out.trueAirspeed + noise.airspeedState.TrueAirspeed;
+        airspeedStateTime = airspeedStateTime.addMSecs(settings.airspeedStateRate);
+    }
+
+    hitlSensors->setData(data);
+}
+
 /**
  * calculate air density from altitude. http://en.wikipedia.org/wiki/Density_of_air
  */
@@ -45,6 +45,7 @@
 #include "gpspositionsensor.h"
 #include "gpsvelocitysensor.h"
 #include "groundtruth.h"
+#include "hitlsensors.h"
 #include "gyrostate.h"
 #include "homelocation.h"
 #include "manualcontrolcommand.h"
@@ -61,6 +62,8 @@
 #include <QProcess>
 #include <qmath.h>
 
+class HitlNoiseGeneration;
+
 /**
  * just imagine this was a class without methods and all public properties
  */
@@ -130,6 +133,9 @@ typedef struct _CONNECTION {
     bool    attRawEnabled;
     quint8  attRawRate;
 
+    // All sensors in one HITLSensors packet per update, fed to the firmware Sensors module
+    bool    sensorPacketEnabled;
+
     bool    attStateEnabled;
     bool    attActHW;
     bool    attActSim;
@@ -335,6 +341,7 @@ protected:
     GCSTelemetryStats *telStats;
     GCSReceiver *gcsReceiver;
     GroundTruth *groundTruth;
+    HITLSensors *hitlSensors;
 
     SimulatorSettings settings;
 
@@ -362,6 +369,8 @@ private:
     QTime battTime;
     QTime gcsRcvrTime;
     QTime airspeedStateTime;
+    quint32 hitlSimTime;
+    HitlNoiseGeneration *noiseSource;
 
     QString name;
     QString simulatorId;
@@ -372,6 +381,7 @@ private:
     void setupInputObject(UAVObject *obj, quint32 updatePeriod);
     void setupWatchedObject(UAVObject *obj, quint32 updatePeriod);
     void setupObjects();
+    void sendSensorPacket(const Output2Hardware & out, const struct Noise & noise, const QTime & currentTime);
 
     AirParameters airParameters;
 };
@@ -15,8 +15,8 @@ public:
 
 public slots:
 
-    void onOpenDevice(QString HostName, int Port, bool UseTCP);
-    void onCloseDevice(QAbstractSocket *ipSocket);
+    void onOpenDevice(QString HostName, int Port, bool UseTCP, bool Multicast);
+    void onCloseDevice(QIODevice *ipSocket);
 };
 
 #endif // IPCONNECTION_INTERNAL_H
@@ -32,7 +32,9 @@ IPconnectionConfiguration::IPconnectionConfiguration(QString classId, QSettings
     IUAVGadgetConfiguration(classId, parent),
     m_HostName("127.0.0.1"),
     m_Port(1000),
-    m_UseTCP(1)
+    m_UseTCP(1),
+    m_Vehicles(1),
+    m_Multicast(0)
 {
     Q_UNUSED(qSettings);
 
@@ -46,9 +48,11 @@ IUAVGadgetConfiguration *IPconnectionConfiguration::clone()
 {
     IPconnectionConfiguration *m = new IPconnectionConfiguration(this->classId());
 
-    m->m_Port     = m_Port;
-    m->m_HostName = m_HostName;
-    m->m_UseTCP   = m_UseTCP;
+    m->m_Port      = m_Port;
+    m->m_HostName  = m_HostName;
+    m->m_UseTCP    = m_UseTCP;
+    m->m_Vehicles  = m_Vehicles;
+    m->m_Multicast = m_Multicast;
     return m;
 }
 
@@ -61,6 +65,8 @@ void IPconnectionConfiguration::saveConfig(QSettings *qSettings) const
     qSettings->setValue("port", m_Port);
     qSettings->setValue("hostName", m_HostName);
     qSettings->setValue("useTCP", m_UseTCP);
+    qSettings->setValue("vehicles", m_Vehicles);
+    qSettings->setValue("multicast", m_Multicast);
 }
 
 void IPconnectionConfiguration::savesettings() const
@@ -72,6 +78,8 @@ void IPconnectionConfiguration::savesettings() const
     settings->setValue(QLatin1String("HostName"), m_HostName);
     settings->setValue(QLatin1String("Port"), m_Port);
     settings->setValue(QLatin1String("UseTCP"), m_UseTCP);
+    settings->setValue(QLatin1String("Vehicles"), m_Vehicles);
+    settings->setValue(QLatin1String("Multicast"), m_Multicast);
     settings->endArray();
     settings->endGroup();
 }
@@ -83,9 +91,11 @@ void IPconnectionConfiguration::restoresettings()
 
     settings->beginReadArray("Current");
     settings->setArrayIndex(0);
-    m_HostName = (settings->value(QLatin1String("HostName"), tr("")).toString());
-    m_Port     = (settings->value(QLatin1String("Port"), tr("")).toInt());
-    m_UseTCP   = (settings->value(QLatin1String("UseTCP"), tr("")).toInt());
+    m_HostName  = (settings->value(QLatin1String("HostName"), tr("")).toString());
+    m_Port      = (settings->value(QLatin1String("Port"), tr("")).toInt());
+    m_UseTCP    = (settings->value(QLatin1String("UseTCP"), tr("")).toInt());
+    m_Vehicles  = qMax(1, settings->value(QLatin1String("Vehicles"), 1).toInt());
+    m_Multicast = settings->value(QLatin1String("Multicast"), 0).toInt();
     settings->endArray();
     settings->endGroup();
 }
@@ -38,6 +38,8 @@ class IPconnectionConfiguration : public IUAVGadgetConfiguration {
     Q_OBJECT Q_PROPERTY(QString HostName READ HostName WRITE setHostName)
     Q_PROPERTY(int Port READ Port WRITE setPort)
     Q_PROPERTY(int UseTCP READ UseTCP WRITE setUseTCP)
+    Q_PROPERTY(int Vehicles READ Vehicles WRITE setVehicles)
+    Q_PROPERTY(int Multicast READ Multicast WRITE setMulticast)
 
 public:
     explicit IPconnectionConfiguration(QString classId, QSettings *qSettings = 0, QObject *parent = 0);
@@ -62,6 +64,16 @@ public:
     {
         return m_UseTCP;
     }
+    // Simulated boards started by the swarm harness, vehicle k listens on Port + 10 * k
+    int Vehicles() const
+    {
+        return m_Vehicles;
+    }
+    // Join the UDP multicast group HostName:Port instead of connecting to a host
+    int Multicast() const
+    {
+        return m_Multicast;
+    }
 
 
 public slots:
@@ -77,11 +89,21 @@ public slots:
     {
         m_UseTCP = UseTCP;
     }
+    void setVehicles(int Vehicles)
+    {
+        m_Vehicles = Vehicles;
+    }
+    void setMulticast(int Multicast)
+    {
+        m_Multicast = Multicast;
+    }
 
 private:
     QString m_HostName;
     int m_Port;
     int m_UseTCP;
+    int m_Vehicles;
+    int m_Multicast;
     QSettings *settings;
 };
 
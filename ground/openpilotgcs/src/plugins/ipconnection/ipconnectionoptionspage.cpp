@@ -52,8 +52,10 @@ QWidget *IPconnectionOptionsPage::createPage(QWidget *parent)
 
     m_page->Port->setValue(m_config->Port());
     m_page->HostName->setText(m_config->HostName());
-    m_page->UseTCP->setChecked(m_config->UseTCP() ? true : false);
-    m_page->UseUDP->setChecked(m_config->UseTCP() ? false : true);
+    m_page->UseTCP->setChecked(m_config->UseTCP() && !m_config->Multicast());
+    m_page->UseUDP->setChecked(!m_config->UseTCP() && !m_config->Multicast());
+    m_page->UseMulticast->setChecked(m_config->Multicast() ? true : false);
+    m_page->Vehicles->setValue(m_config->Vehicles());
 
     return w;
 }
@@ -63,6 +65,8 @@ void IPconnectionOptionsPage::apply()
     m_config->setPort(m_page->Port->value());
     m_config->setHostName(m_page->HostName->text());
     m_config->setUseTCP(m_page->UseTCP->isChecked() ? 1 : 0);
+    m_config->setMulticast(m_page->UseMulticast->isChecked() ? 1 : 0);
+    m_config->setVehicles(m_page->Vehicles->value());
     m_config->savesettings();
 
     emit availableDevChanged();
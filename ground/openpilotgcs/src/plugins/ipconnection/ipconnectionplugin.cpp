@@ -33,6 +33,7 @@
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/icore.h>
 #include "ipconnection_internal.h"
+#include "multicastsocket.h"
 
 #include <QtCore/QtPlugin>
 #include <QMainWindow>
@@ -52,16 +53,16 @@ QWaitCondition openDeviceWait;
 QWaitCondition closeDeviceWait;
 // QReadWriteLock dummyLock;
 QMutex ipConMutex;
-QAbstractSocket *ret;
+QIODevice *ret;
 
 IPConnection::IPConnection(IPconnectionConnection *connection) : QObject()
 {
     moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
 
-    QObject::connect(connection, SIGNAL(CreateSocket(QString, int, bool)),
-                     this, SLOT(onOpenDevice(QString, int, bool)));
-    QObject::connect(connection, SIGNAL(CloseSocket(QAbstractSocket *)),
-                     this, SLOT(onCloseDevice(QAbstractSocket *)));
+    QObject::connect(connection, SIGNAL(CreateSocket(QString, int, bool, bool)),
+                     this, SLOT(onOpenDevice(QString, int, bool, bool)));
+    QObject::connect(connection, SIGNAL(CloseSocket(QIODevice *)),
+                     this, SLOT(onCloseDevice(QIODevice *)));
 }
 
 /*IPConnection::~IPConnection()
@@ -69,12 +70,31 @@ IPConnection::IPConnection(IPconnectionConnection *connection) : QObject()
 
    }*/
 
-void IPConnection::onOpenDevice(QString HostName, int Port, bool UseTCP)
+void IPConnection::onOpenDevice(QString HostName, int Port, bool UseTCP, bool Multicast)
 {
     QAbstractSocket *ipSocket;
     const int Timeout = 5 * 1000;
 
     ipConMutex.lock();
+    if (Multicast) {
+        MulticastSocket *mcSocket = new MulticastSocket(this);
+        QHostAddress group(HostName);
+        if (!group.isInSubnet(QHostAddress("224.0.0.0"), 4)) {
+            errorMsg = "Please configure a multicast group (224.0.0.0 to 239.255.255.255) as Host";
+        } else if (mcSocket->join(group, Port)) {
+            ret = mcSocket;
+            openDeviceWait.wakeAll();
+            ipConMutex.unlock();
+            return;
+        } else {
+            errorMsg = mcSocket->errorString();
+        }
+        delete mcSocket;
+        ret = NULL;
+        openDeviceWait.wakeAll();
+        ipConMutex.unlock();
+        return;
+    }
     if (UseTCP) {
         ipSocket = new QTcpSocket(this);
     } else {
@@ -105,7 +125,7 @@ void IPConnection::onOpenDevice(QString HostName, int Port, bool UseTCP)
     ipConMutex.unlock();
 }
 
-void IPConnection::onCloseDevice(QAbstractSocket *ipSocket)
+void IPConnection::onCloseDevice(QIODevice *ipSocket)
 {
     ipConMutex.lock();
     ipSocket->close();
@@ -166,23 +186,36 @@ QList <Core::IConnection::device> IPconnectionConnection::availableDevices()
         d.displayName = "Unconfigured";
     }
     d.name = (const QString)m_config->HostName();
-    // we only have one "device" as defined by the configuration m_config
-    list.append(d);
+    // one "device" as defined by the configuration m_config, or one per simulated vehicle
+    if (m_config->Vehicles() <= 1) {
+        list.append(d);
+        return list;
+    }
+    for (int k = 0; k < m_config->Vehicles(); k++) {
+        device v;
+        v.name = v.displayName = QString("%1:%2").arg(d.displayName).arg(m_config->Port() + 10 * k);
+        list.append(v);
+    }
 
     return list;
 }
 
-QIODevice *IPconnectionConnection::openDevice(const QString &)
+QIODevice *IPconnectionConnection::openDevice(const QString &deviceName)
 {
     QString HostName;
     int Port;
     bool UseTCP;
+    bool Multicast;
     QMessageBox msgBox;
 
     // get the configuration info
-    HostName = m_config->HostName();
-    Port     = m_config->Port();
-    UseTCP   = m_config->UseTCP();
+    HostName  = m_config->HostName();
+    Port      = m_config->Port();
+    UseTCP    = m_config->UseTCP();
+    Multicast = m_config->Multicast();
+    if (m_config->Vehicles() > 1 && deviceName.contains(':')) {
+        Port = deviceName.section(':', -1).toInt();
+    }
 
     if (ipSocket) {
         // Andrew: close any existing socket... this should never occur
@@ -194,7 +227,7 @@ QIODevice *IPconnectionConnection::openDevice(const QString &)
     }
 
     ipConMutex.lock();
-    emit CreateSocket(HostName, Port, UseTCP);
+    emit CreateSocket(HostName, Port, UseTCP, Multicast);
     openDeviceWait.wait(&ipConMutex);
     ipConMutex.unlock();
     ipSocket = ret;
@@ -224,7 +257,9 @@ QString IPconnectionConnection::connectionName()
 
 QString IPconnectionConnection::shortName()
 { // updated from serial plugin
-    if (m_config->UseTCP()) {
+    if (m_config->Multicast()) {
+        return QString("Multicast");
+    } else if (m_config->UseTCP()) {
         return QString("TCP");
     } else {
         return QString("UDP");
@@ -73,11 +73,11 @@ protected slots:
     void onEnumerationChanged();
 
 signals: // For the benefit of IPConnection
-    void CreateSocket(QString HostName, int Port, bool UseTCP);
-    void CloseSocket(QAbstractSocket *socket);
+    void CreateSocket(QString HostName, int Port, bool UseTCP, bool Multicast);
+    void CloseSocket(QIODevice *socket);
 
 private:
-    QAbstractSocket *ipSocket;
+    QIODevice *ipSocket;
     IPconnectionConfiguration *m_config;
     IPconnectionOptionsPage *m_optionspage;
     // QSettings* settings;
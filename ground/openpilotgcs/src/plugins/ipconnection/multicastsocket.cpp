@@ -0,0 +1,129 @@
+/**
+ ******************************************************************************
+ *
+ * @file       multicastsocket.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup IPConnPlugin IP Telemetry Plugin
+ * @{
+ * @brief Receives the telemetry published to a UDP multicast group
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "multicastsocket.h"
+
+#include <QtNetwork/QUdpSocket>
+#include <QtEndian>
+#include <QDebug>
+
+MulticastSocket::MulticastSocket(QObject *parent) :
+    QIODevice(parent),
+    m_socket(new QUdpSocket(this)),
+    m_publisherPort(0),
+    m_expected(0),
+    m_synced(false),
+    m_lost(0)
+{
+    connect(m_socket, SIGNAL(readyRead()), this, SLOT(receive()));
+}
+
+MulticastSocket::~MulticastSocket()
+{}
+
+bool MulticastSocket::join(const QHostAddress &group, quint16 port)
+{
+    // several receivers may run on one host
+    if (!m_socket->bind(QHostAddress::AnyIPv4, port, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint)
+        || !m_socket->joinMulticastGroup(group)) {
+        setErrorString(m_socket->errorString());
+        m_socket->close();
+        return false;
+    }
+    m_group = group;
+    return open(QIODevice::ReadWrite);
+}
+
+void MulticastSocket::close()
+{
+    if (m_socket->state() == QAbstractSocket::BoundState) {
+        m_socket->leaveMulticastGroup(m_group);
+    }
+    m_socket->close();
+    m_rxBuffer.clear();
+    QIODevice::close();
+}
+
+qint64 MulticastSocket::bytesAvailable() const
+{
+    return m_rxBuffer.size() + QIODevice::bytesAvailable();
+}
+
+qint64 MulticastSocket::readData(char *data, qint64 maxSize)
+{
+    qint64 length = qMin(maxSize, (qint64)m_rxBuffer.size());
+
+    memcpy(data, m_rxBuffer.constData(), length);
+    m_rxBuffer.remove(0, length);
+    return length;
+}
+
+qint64 MulticastSocket::writeData(const char *data, qint64 maxSize)
+{
+    if (m_publisher.isNull()) {
+        // nobody heard yet, there is nobody to answer
+        return maxSize;
+    }
+    return m_socket->writeDatagram(data, maxSize, m_publisher, m_publisherPort);
+}
+
+void MulticastSocket::receive()
+{
+    bool received = false;
+
+    while (m_socket->hasPendingDatagrams()) {
+        QByteArray datagram;
+        datagram.resize(m_socket->pendingDatagramSize());
+        m_socket->readDatagram(datagram.data(), datagram.size(), &m_publisher, &m_publisherPort);
+        if (datagram.size() <= SEQUENCE_LENGTH) {
+            continue;
+        }
+
+        quint16 sequence = qFromLittleEndian<quint16>((const uchar *)datagram.constData());
+        if (m_synced && sequence != m_expected) {
+            // later ones are taken as lost, an older one is late and dropped
+            quint16 gap = sequence - m_expected;
+            if (gap >= 0x8000) {
+                continue;
+            }
+            m_lost += gap;
+            qDebug() << "MulticastSocket - lost" << gap << "datagrams from" << m_publisher.toString();
+        }
+        m_expected = sequence + 1;
+        m_synced   = true;
+        m_rxBuffer.append(datagram.constData() + SEQUENCE_LENGTH, datagram.size() - SEQUENCE_LENGTH);
+        received   = true;
+    }
+    if (received) {
+        emit readyRead();
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
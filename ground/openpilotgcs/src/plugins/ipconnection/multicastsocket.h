@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ *
+ * @file       multicastsocket.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup IPConnPlugin IP Telemetry Plugin
+ * @{
+ * @brief Receives the telemetry published to a UDP multicast group
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef MULTICASTSOCKET_H
+#define MULTICASTSOCKET_H
+
+#include <QIODevice>
+#include <QHostAddress>
+
+class QUdpSocket;
+
+/**
+ * Stream of the datagrams published to a multicast group by a simulated
+ * board started with -g or by the telemetry relay of another GCS. Every
+ * datagram starts with a 16 bit little endian sequence number, a gap in
+ * the numbers is counted as lost datagrams and the frames cut by it are
+ * dropped by the UAVTalk checksum.
+ * What is written goes to the last publisher heard, so object requests
+ * and settings still reach the vehicle and are answered on the group.
+ */
+class MulticastSocket : public QIODevice {
+    Q_OBJECT
+
+public:
+    explicit MulticastSocket(QObject *parent = 0);
+    ~MulticastSocket();
+
+    bool join(const QHostAddress &group, quint16 port);
+    void close();
+
+    bool isSequential() const
+    {
+        return true;
+    }
+    qint64 bytesAvailable() const;
+
+    quint32 lostDatagrams() const
+    {
+        return m_lost;
+    }
+
+    static const int SEQUENCE_LENGTH = 2;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize);
+    qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void receive();
+
+private:
+    QUdpSocket *m_socket;
+    QHostAddress m_group;
+    QHostAddress m_publisher;
+    quint16 m_publisherPort;
+    QByteArray m_rxBuffer;
+    quint16 m_expected;
+    bool m_synced;
+    quint32 m_lost;
+};
+
+#endif // MULTICASTSOCKET_H
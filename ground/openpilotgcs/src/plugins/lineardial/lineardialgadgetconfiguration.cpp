@@ -47,7 +47,7 @@ LineardialGadgetConfiguration::LineardialGadgetConfiguration(QString classId, QS
     greenMax(100),
     factor(1.00),
     decimalPlaces(0),
-    useOpenGLFlag(false)
+    useOpenGLFlag(true)
 {
     // if a saved configuration exists load it
     if (qSettings != 0) {
@@ -66,7 +66,7 @@ LineardialGadgetConfiguration::LineardialGadgetConfiguration(QString classId, QS
         font = qSettings->value("font").toString();
         decimalPlaces     = qSettings->value("decimalPlaces").toInt();
         factor            = qSettings->value("factor").toDouble();
-        useOpenGLFlag     = qSettings->value("useOpenGLFlag").toBool();
+        useOpenGLFlag     = qSettings->value("useOpenGLFlag", true).toBool();
     }
 }
 
@@ -27,6 +27,7 @@
 
 #include "lineardialgadgetwidget.h"
 #include <utils/stylehelper.h>
+#include <utils/cachedsvgitem.h>
 #include <QFileDialog>
 #include <QtOpenGL/QGLWidget>
 #include <QDebug>
@@ -42,7 +43,8 @@ LineardialGadgetWidget::LineardialGadgetWidget(QWidget *parent) : QGraphicsView(
 
     paint();
 
-    obj1 = NULL;
+    connect(&binding, SIGNAL(updated()), this, SLOT(updateIndex()));
+
     fieldName   = NULL;
     fieldValue  = NULL;
     indexTarget = 0;
@@ -77,63 +79,38 @@ void LineardialGadgetWidget::enableOpenGL(bool flag)
  */
 void LineardialGadgetWidget::connectInput(QString object1, QString nfield1)
 {
-    if (obj1 != NULL) {
-        disconnect(obj1, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateIndex(UAVObject *)));
-    }
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
     // qDebug() << "Lineardial Connect needles - " << object1 << "-"<< nfield1;
 
-    // Check validity of arguments first, reject empty args and unknown fields.
-    if (!(object1.isEmpty() || nfield1.isEmpty())) {
-        obj1 = dynamic_cast<UAVDataObject *>(objManager->getObject(object1));
-        if (obj1 != NULL) {
-            connect(obj1, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateIndex(UAVObject *)));
-            if (nfield1.contains("-")) {
-                QStringList fieldSubfield = nfield1.split("-", QString::SkipEmptyParts);
-                field1        = fieldSubfield.at(0);
-                subfield1     = fieldSubfield.at(1);
-                haveSubField1 = true;
-            } else {
-                field1 = nfield1;
-                haveSubField1 = false;
-            }
-            if (fieldName) {
-                fieldName->setPlainText(nfield1);
-            }
-            updateIndex(obj1);
-        } else {
-            qDebug() << "Error: Object is unknown (" << object1 << ") this should not happen.";
+    // Empty args are rejected, unknown objects and fields are reported by the binding.
+    if (binding.bind(objManager, object1, nfield1)) {
+        if (fieldName) {
+            fieldName->setPlainText(nfield1);
         }
+        updateIndex();
     }
 }
 
 /*!
-   \brief Called by the UAVObject which got updated
+   \brief Called by the binding when its object got updated
 
    Updates the numeric value and/or the icon if the dial wants this.
  */
-void LineardialGadgetWidget::updateIndex(UAVObject *object1)
+void LineardialGadgetWidget::updateIndex()
 {
-    // Double check that the field exists:
-    UAVObjectField *field = object1->getField(field1);
+    UAVObjectField *field = binding.field();
 
     if (field) {
         QString s;
         if (field->isNumeric()) {
-            double v;
-            if (haveSubField1) {
-                int indexOfSubField = field->getElementNames().indexOf(QRegExp(subfield1, Qt::CaseSensitive, QRegExp::FixedString));
-                v = field->getDouble(indexOfSubField) * factor;
-            } else {
-                v = field->getDouble() * factor;
-            }
+            double v = binding.getDouble() * factor;
             setIndex(v);
             s.sprintf("%.*f", places, v);
         }
         if (field->isText()) {
-            s = field->getValue().toString();
+            s = binding.getValue().toString();
             if (fieldSymbol) {
                 // If we defined a symbol, we will look for a matching
                 // SVG element to display:
@@ -171,7 +148,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
     if (QFile::exists(dfn) && m_renderer->load(dfn) && m_renderer->isValid()) {
         l_scene->clear(); // Beware: clear also deletes all objects
                           // which are currently in the scene
-        background = new QGraphicsSvgItem();
+        background = new CachedSvgItem();
         background->setSharedRenderer(m_renderer);
         background->setElementId("background");
         background->setFlags(QGraphicsItem::ItemClipsChildrenToShape |
@@ -183,15 +160,15 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
         if (m_renderer->elementExists("red")) {
             // Order is important: red, then yellow then green
             // overlayed on top of each other
-            red = new QGraphicsSvgItem();
+            red = new CachedSvgItem();
             red->setSharedRenderer(m_renderer);
             red->setElementId("red");
             red->setParentItem(background);
-            yellow = new QGraphicsSvgItem();
+            yellow = new CachedSvgItem();
             yellow->setSharedRenderer(m_renderer);
             yellow->setElementId("yellow");
             yellow->setParentItem(background);
-            green = new QGraphicsSvgItem();
+            green = new CachedSvgItem();
             green->setSharedRenderer(m_renderer);
             green->setElementId("green");
             green->setParentItem(background);
@@ -268,7 +245,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
             startY = nRect.y();
             QTransform matrix;
             matrix.translate(startX, startY);
-            index  = new QGraphicsSvgItem();
+            index  = new CachedSvgItem();
             index->setSharedRenderer(m_renderer);
             index->setElementId("needle");
             index->setTransform(matrix, false);
@@ -321,7 +298,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
             qreal startY = textMatrix.mapRect(m_renderer->boundsOnElement("symbol")).y();
             QTransform matrix;
             matrix.translate(startX, startY);
-            fieldSymbol = new QGraphicsSvgItem();
+            fieldSymbol = new CachedSvgItem();
             fieldSymbol->setElementId("symbol");
             fieldSymbol->setSharedRenderer(m_renderer);
             fieldSymbol->setTransform(matrix, false);
@@ -331,7 +308,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
         }
 
         if (m_renderer->elementExists("foreground")) {
-            foreground = new QGraphicsSvgItem();
+            foreground = new CachedSvgItem();
             foreground->setSharedRenderer(m_renderer);
             foreground->setElementId("foreground");
             foreground->setParentItem(background);
@@ -351,7 +328,7 @@ void LineardialGadgetWidget::setDialFile(QString dfn)
         qDebug() << "no file ";
         m_renderer->load(QString(":/lineardial/images/empty.svg"));
         l_scene->clear(); // This also deletes all items contained in the scene.
-        background  = new QGraphicsSvgItem();
+        background  = new CachedSvgItem();
         background->setSharedRenderer(m_renderer);
         l_scene->addItem(background);
         fieldName   = NULL;
@@ -32,6 +32,7 @@
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include "uavobject.h"
+#include "uavobjectfieldbinding.h"
 #include <QGraphicsView>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
@@ -77,7 +78,7 @@ public:
     }
 
 public slots:
-    void updateIndex(UAVObject *object1);
+    void updateIndex();
 
 
 protected:
@@ -131,10 +132,7 @@ private:
     // Rotation timer
     QTimer dialTimer;
 
-    // Name of the fields to read when an update is received:
-    UAVDataObject *obj1;
-    QString field1;
-    QString subfield1;
-    bool haveSubField1;
+    // Field to read when an update is received:
+    UAVObjectFieldBinding binding;
 };
 #endif /* LINEARDIALGADGETWIDGET_H_ */
@@ -0,0 +1,331 @@
+/**
+ ******************************************************************************
+ * @file       logdecoder.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup loggingplugin
+ * @{
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logdecoder.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QtEndian>
+#include <QtConcurrent/QtConcurrentMap>
+#include <string.h>
+
+#include <utils/crc.h>
+#include <utils/compressedlog.h>
+#include "uavobjectmanager.h"
+#include "uavdataobject.h"
+#include "uavobjectfield.h"
+
+// Log record: timestamp(4), data size(8), data
+#define RECORD_HEADER_LENGTH 12
+// UAVTalk header: sync(1), type (1), size(2), object ID(4), instance ID(2)
+#define UAVTALK_SYNC_VAL     0x3C
+#define UAVTALK_TYPE_OBJ     0x20
+#define UAVTALK_TYPE_OBJ_ACK 0x22
+#define UAVTALK_TIMESTAMPED  0x80
+#define UAVTALK_HEADER_LENGTH 10
+// Board time stamp of the timestamped object packets, after the header
+#define UAVTALK_TIMESTAMP_LENGTH 2
+#define UAVTALK_CHECKSUM_LENGTH 1
+
+LogDecoder::LogDecoder(UAVObjectManager *objManager) :
+    m_objManager(objManager),
+    m_skippedRecords(0)
+{}
+
+void LogDecoder::clear()
+{
+    m_objects.clear();
+    m_skippedRecords = 0;
+}
+
+const LogDecoder::ObjectColumns *LogDecoder::findObject(const QString &name, quint16 instId) const
+{
+    foreach(const ObjectColumns &columns, m_objects) {
+        if (columns.instId == instId && columns.object->getName() == name) {
+            return &columns;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Decodes the whole log. The record headers are walked once to sort the
+ * packets per object instance, then all object instances are decoded in
+ * parallel, each into its own columns.
+ */
+bool LogDecoder::decode(const QString &fileName)
+{
+    clear();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "LogDecoder: unable to open" << fileName;
+        return false;
+    }
+
+    qint64 size = file.size();
+    if (size == 0) {
+        return true;
+    }
+    const uchar *mapped = file.map(0, size);
+    if (mapped == NULL) {
+        qWarning() << "LogDecoder: unable to map" << fileName;
+        return false;
+    }
+
+    // The blocks of a compressed log are decompressed in parallel, the
+    // columns end up in memory anyway
+    const uchar *data = mapped;
+    QByteArray uncompressed;
+    QVector<CompressedLog::Block> blocks;
+    if (CompressedLog::readBlocks(mapped, size, blocks)) {
+        QVector<DecompressJob> decompressJobs(blocks.size());
+        for (int i = 0; i < blocks.size(); ++i) {
+            decompressJobs[i].file  = mapped;
+            decompressJobs[i].block = blocks.at(i);
+        }
+        QtConcurrent::blockingMap(decompressJobs, decompressJob);
+
+        if (!blocks.isEmpty()) {
+            uncompressed.reserve(blocks.last().position + blocks.last().size);
+        }
+        foreach(const DecompressJob &job, decompressJobs) {
+            uncompressed.append(job.data);
+        }
+        data = (const uchar *)uncompressed.constData();
+        size = uncompressed.size();
+    }
+
+    QHash<quint64, int> jobIndex;
+    QVector<DecodeJob> jobs;
+    qint64 offset = 0;
+
+    while (offset + RECORD_HEADER_LENGTH <= size) {
+        const uchar *record = data + offset;
+        quint32 timeStamp   = qFromLittleEndian<quint32>(record);
+        qint64 dataSize     = qFromLittleEndian<qint64>(record + sizeof(quint32));
+
+        if (dataSize < 1 || dataSize > (1024 * 1024) || offset + RECORD_HEADER_LENGTH + dataSize > size) {
+            qWarning() << "LogDecoder: log corrupted at offset" << offset;
+            break;
+        }
+        offset += RECORD_HEADER_LENGTH + dataSize;
+
+        const uchar *packet = record + RECORD_HEADER_LENGTH;
+        const quint8 type   = (dataSize > 1) ? (packet[1] & ~UAVTALK_TIMESTAMPED) : 0;
+        const int headerLength = UAVTALK_HEADER_LENGTH + ((dataSize > 1 && (packet[1] & UAVTALK_TIMESTAMPED)) ? UAVTALK_TIMESTAMP_LENGTH : 0);
+        if (dataSize < headerLength + UAVTALK_CHECKSUM_LENGTH || packet[0] != UAVTALK_SYNC_VAL
+            || (type != UAVTALK_TYPE_OBJ && type != UAVTALK_TYPE_OBJ_ACK)
+            || qFromLittleEndian<quint16>(packet + 2) + UAVTALK_CHECKSUM_LENGTH > dataSize) {
+            ++m_skippedRecords;
+            continue;
+        }
+
+        quint32 objId  = qFromLittleEndian<quint32>(packet + 4);
+        quint16 instId = qFromLittleEndian<quint16>(packet + 8);
+        quint64 key    = ((quint64)objId << 16) | instId;
+
+        QHash<quint64, int>::const_iterator it = jobIndex.constFind(key);
+        int index;
+        if (it != jobIndex.constEnd()) {
+            index = it.value();
+        } else {
+            // Unknown objects get a job without columns so they are skipped from now on
+            index = jobs.size();
+            jobIndex.insert(key, index);
+            DecodeJob job;
+            job.objectIndex = -1;
+            job.columns     = NULL;
+            job.skipped     = 0;
+            UAVObject *obj = m_objManager->getObject(objId);
+            job.numBytes    = (obj != NULL) ? obj->getNumBytes() : 0;
+            if (obj != NULL && job.numBytes == (quint32)qFromLittleEndian<quint16>(packet + 2) - headerLength) {
+                ObjectColumns columns;
+                columns.object = obj;
+                columns.instId = instId;
+                foreach(UAVObjectField * field, obj->getFields()) {
+                    if (!field->isNumeric() && field->getType() != UAVObjectField::ENUM) {
+                        continue;
+                    }
+                    QStringList elementNames = field->getElementNames();
+                    const bool bitfield      = field->getType() == UAVObjectField::BITFIELD;
+                    quint32 elementBytes     = bitfield ? 0 : field->getNumBytes() / field->getNumElements();
+                    for (quint32 n = 0; n < field->getNumElements(); ++n) {
+                        Column column;
+                        column.name = field->getNumElements() > 1 ? field->getName() + "." + elementNames.at(n) : field->getName();
+                        columns.columns.append(column);
+                        ElementLayout layout;
+                        layout.offset = field->getDataOffset() + (bitfield ? n / 8 : n * elementBytes);
+                        layout.type   = field->getType();
+                        layout.bit    = bitfield ? n % 8 : 0;
+                        job.layout.append(layout);
+                    }
+                }
+                job.objectIndex = m_objects.size();
+                m_objects.append(columns);
+            }
+            jobs.append(job);
+        }
+
+        DecodeJob &job = jobs[index];
+        if (job.objectIndex < 0) {
+            ++m_skippedRecords;
+            continue;
+        }
+        job.packets.append(packet);
+        job.timeStamps.append(timeStamp);
+    }
+
+    // m_objects is complete, its elements don't move anymore
+    for (int i = 0; i < jobs.size(); ++i) {
+        if (jobs[i].objectIndex >= 0) {
+            jobs[i].columns = &m_objects[jobs[i].objectIndex];
+        }
+    }
+
+    QtConcurrent::blockingMap(jobs, decodeJob);
+
+    foreach(const DecodeJob &job, jobs) {
+        m_skippedRecords += job.skipped;
+    }
+
+    file.unmap((uchar *)mapped);
+    return true;
+}
+
+void LogDecoder::decompressJob(DecompressJob &job)
+{
+    job.data = CompressedLog::decompress(job.file, job.block);
+}
+
+/**
+ * Decodes the packets of one object instance into its columns. The board
+ * time stamps are unwrapped, the wraps are counted with the log time; the
+ * packets logged without one get the board time of the log time.
+ */
+void LogDecoder::decodeJob(DecodeJob &job)
+{
+    if (job.columns == NULL) {
+        return;
+    }
+
+    ObjectColumns *columns = job.columns;
+    const int count = job.packets.size();
+    const int numColumns = job.layout.size();
+
+    columns->timeStamps.reserve(count);
+    for (int c = 0; c < numColumns; ++c) {
+        columns->columns[c].samples.reserve(count);
+    }
+
+    QVector<quint32> vehicleTimeStamps;
+    int firstStamped     = -1;
+    quint32 vehicleTime  = 0;
+    quint32 lastLogTime  = 0;
+
+    for (int i = 0; i < count; ++i) {
+        const uchar *packet = job.packets.at(i);
+        const bool stamped  = packet[1] & UAVTALK_TIMESTAMPED;
+        const uchar *data   = packet + UAVTALK_HEADER_LENGTH + (stamped ? UAVTALK_TIMESTAMP_LENGTH : 0);
+        quint16 length = qFromLittleEndian<quint16>(packet + 2);
+        if (length != data - packet + job.numBytes || Utils::Crc::updateCRC(0, packet, length) != packet[length]) {
+            ++job.skipped;
+            continue;
+        }
+
+        const quint32 logTime = job.timeStamps.at(i);
+        if (stamped) {
+            quint16 stamp = qFromLittleEndian<quint16>(packet + UAVTALK_HEADER_LENGTH);
+            if (firstStamped < 0) {
+                firstStamped = columns->timeStamps.size();
+                vehicleTime  = stamp;
+            } else {
+                quint16 delta   = stamp - (quint16)vehicleTime;
+                qint64 elapsed  = (qint64)logTime - lastLogTime;
+                qint64 wraps    = (elapsed - delta + 0x8000) / 0x10000;
+                vehicleTime    += delta + (quint32)(qMax<qint64>(wraps, 0) * 0x10000);
+            }
+        } else {
+            vehicleTime += logTime - lastLogTime;
+        }
+        lastLogTime = logTime;
+        vehicleTimeStamps.append(vehicleTime);
+
+        columns->timeStamps.append(logTime);
+        const ElementLayout *layout = job.layout.constData();
+        for (int c = 0; c < numColumns; ++c, ++layout) {
+            const uchar *value = data + layout->offset;
+            double sample;
+            switch (layout->type) {
+            case UAVObjectField::INT8:
+                sample = (qint8)value[0];
+                break;
+            case UAVObjectField::INT16:
+                sample = qFromLittleEndian<qint16>(value);
+                break;
+            case UAVObjectField::INT32:
+                sample = qFromLittleEndian<qint32>(value);
+                break;
+            case UAVObjectField::UINT16:
+                sample = qFromLittleEndian<quint16>(value);
+                break;
+            case UAVObjectField::UINT32:
+                sample = qFromLittleEndian<quint32>(value);
+                break;
+            case UAVObjectField::FLOAT32:
+            {
+                quint32 raw = qFromLittleEndian<quint32>(value);
+                float f;
+                memcpy(&f, &raw, sizeof(f));
+                sample = f;
+                break;
+            }
+            case UAVObjectField::BITFIELD:
+                sample = (value[0] >> layout->bit) & 1;
+                break;
+            default:
+                // UINT8 and ENUM
+                sample = value[0];
+                break;
+            }
+            columns->columns[c].samples.append(sample);
+        }
+    }
+
+    if (firstStamped >= 0) {
+        // The samples before the first stamp are moved back from it by the log time
+        for (int i = 0; i < firstStamped; ++i) {
+            vehicleTimeStamps[i] = vehicleTimeStamps.at(firstStamped) - (columns->timeStamps.at(firstStamped) - columns->timeStamps.at(i));
+        }
+        columns->vehicleTimeStamps = vehicleTimeStamps;
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
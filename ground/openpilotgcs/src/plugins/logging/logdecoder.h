@@ -0,0 +1,117 @@
+/**
+ ******************************************************************************
+ * @file       logdecoder.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup loggingplugin
+ * @{
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGDECODER_H_
+#define LOGDECODER_H_
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QList>
+#include <utils/compressedlog.h>
+
+class UAVObject;
+class UAVObjectManager;
+
+/**
+ * Offline decoder for OPL logs. The log file is memory mapped and its records
+ * are decoded straight into columns, one contiguous vector of samples per
+ * numeric field element of every object instance, without going through
+ * UAVTalk and the object manager at replay speed.
+ *
+ * The object manager is only used for the object layouts, the registered
+ * objects are never updated.
+ */
+class LogDecoder {
+public:
+    struct Column {
+        QString name; // "Field" or "Field.Element"
+        QVector<double> samples;
+    };
+
+    struct ObjectColumns {
+        UAVObject *object;
+        quint16 instId;
+        QVector<quint32> timeStamps;
+        // Board time of the samples in ms, empty if the instance was never logged
+        // timestamped. It counts from the first stamp, the board time before it is not known.
+        QVector<quint32> vehicleTimeStamps;
+        QList<Column> columns;
+    };
+
+    LogDecoder(UAVObjectManager *objManager);
+
+    bool decode(const QString &fileName);
+    void clear();
+
+    const QList<ObjectColumns> &objects() const
+    {
+        return m_objects;
+    }
+    const ObjectColumns *findObject(const QString &name, quint16 instId = 0) const;
+
+    quint32 skippedRecords() const
+    {
+        return m_skippedRecords;
+    }
+
+private:
+    struct ElementLayout {
+        quint32 offset;
+        int type;
+        quint8 bit; // BITFIELD elements are packed eight to a byte
+    };
+
+    struct DecodeJob {
+        int objectIndex;
+        ObjectColumns *columns;
+        QVector<ElementLayout> layout;
+        quint32 numBytes;
+        QVector<const uchar *> packets;
+        QVector<quint32> timeStamps;
+        quint32 skipped;
+    };
+
+    struct DecompressJob {
+        const uchar *file;
+        CompressedLog::Block block;
+        QByteArray data;
+    };
+
+    UAVObjectManager *m_objManager;
+    QList<ObjectColumns> m_objects;
+    quint32 m_skippedRecords;
+
+    static void decodeJob(DecodeJob &job);
+    static void decompressJob(DecompressJob &job);
+};
+
+#endif // LOGDECODER_H_
+
+/**
+ * @}
+ * @}
+ */
@@ -2,19 +2,21 @@ TEMPLATE = lib
 
 TARGET = LoggingGadget
 DEFINES += LOGGING_LIBRARY
-QT += svg
+QT += svg concurrent
 
 include(../../openpilotgcsplugin.pri)
 include(logging_dependencies.pri)
 HEADERS += loggingplugin.h \
     logginggadgetwidget.h \
     logginggadget.h \
-    logginggadgetfactory.h
+    logginggadgetfactory.h \
+    logdecoder.h
 
 SOURCES += loggingplugin.cpp \
     logginggadgetwidget.cpp \
     logginggadget.cpp \
-    logginggadgetfactory.cpp
+    logginggadgetfactory.cpp \
+    logdecoder.cpp
 
 OTHER_FILES += LoggingGadget.pluginspec
 
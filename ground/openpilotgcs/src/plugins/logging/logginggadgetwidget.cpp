@@ -33,6 +33,7 @@
 #include <QTextEdit>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QTime>
 #include <loggingplugin.h>
 
 LoggingGadgetWidget::LoggingGadgetWidget(QWidget *parent) : QLabel(parent)
@@ -58,6 +59,12 @@ void LoggingGadgetWidget::setPlugin(LoggingPlugin *p)
     connect(m_logging->pauseButton, SIGNAL(clicked()), p->getLogfile(), SLOT(pauseReplay()));
     connect(m_logging->pauseButton, SIGNAL(clicked()), scpPlugin, SLOT(stopPlotting()));
     connect(m_logging->playbackSpeed, SIGNAL(valueChanged(double)), p->getLogfile(), SLOT(setReplaySpeed(double)));
+    connect(p->getLogfile(), SIGNAL(replayStarted()), this, SLOT(replayStarted()));
+    connect(p->getLogfile(), SIGNAL(replayDurationChanged(quint32)), this, SLOT(replayDurationChanged(quint32)));
+    connect(p->getLogfile(), SIGNAL(replayFinished()), this, SLOT(replayFinished()));
+    connect(p->getLogfile(), SIGNAL(replayPositionChanged(quint32)), this, SLOT(replayPositionChanged(quint32)));
+    connect(m_logging->positionSlider, SIGNAL(sliderMoved(int)), this, SLOT(positionSliderMoved(int)));
+    connect(m_logging->positionSlider, SIGNAL(sliderReleased()), this, SLOT(positionSliderReleased()));
     void pauseReplay();
     void resumeReplay();
 }
@@ -68,6 +75,54 @@ void LoggingGadgetWidget::stateChanged(QString status)
     m_logging->statusLabel->setText(status);
 }
 
+void LoggingGadgetWidget::replayStarted()
+{
+    // The slider is enabled once the log is indexed
+    m_logging->positionSlider->setMaximum(0);
+    m_logging->positionSlider->setValue(0);
+    m_logging->positionSlider->setEnabled(false);
+    updatePositionLabel(0);
+}
+
+void LoggingGadgetWidget::replayDurationChanged(quint32 duration)
+{
+    m_logging->positionSlider->setMaximum(duration);
+    m_logging->positionSlider->setEnabled(true);
+    updatePositionLabel(m_logging->positionSlider->value());
+}
+
+void LoggingGadgetWidget::replayFinished()
+{
+    m_logging->positionSlider->setEnabled(false);
+}
+
+void LoggingGadgetWidget::replayPositionChanged(quint32 timeStamp)
+{
+    // Don't fight with the user while the slider is dragged
+    if (!m_logging->positionSlider->isSliderDown()) {
+        m_logging->positionSlider->setValue(timeStamp);
+        updatePositionLabel(timeStamp);
+    }
+}
+
+void LoggingGadgetWidget::positionSliderMoved(int value)
+{
+    updatePositionLabel(value);
+}
+
+void LoggingGadgetWidget::positionSliderReleased()
+{
+    loggingPlugin->getLogfile()->setReplayPosition(m_logging->positionSlider->value());
+}
+
+void LoggingGadgetWidget::updatePositionLabel(quint32 timeStamp)
+{
+    QTime position = QTime(0, 0).addMSecs(timeStamp);
+    QTime duration    = QTime(0, 0).addMSecs(m_logging->positionSlider->maximum());
+
+    m_logging->positionLabel->setText(position.toString("hh:mm:ss") + " / " + duration.toString("hh:mm:ss"));
+}
+
 /**
  * @}
  * @}
@@ -47,6 +47,12 @@ public:
 
 protected slots:
     void stateChanged(QString status);
+    void replayStarted();
+    void replayDurationChanged(quint32 duration);
+    void replayFinished();
+    void replayPositionChanged(quint32 timeStamp);
+    void positionSliderMoved(int value);
+    void positionSliderReleased();
 
 signals:
     void pause();
@@ -56,6 +62,8 @@ private:
     Ui_Logging *m_logging;
     LoggingPlugin *loggingPlugin;
     ScopeGadgetFactory *scpPlugin;
+
+    void updatePositionLabel(quint32 timeStamp);
 };
 
 #endif /* LoggingGADGETWIDGET_H_ */
@@ -29,6 +29,8 @@
 
 #include "loggingplugin.h"
 #include "logginggadgetfactory.h"
+#include "logdecoder.h"
+#include "scope/scopegadgetfactory.h"
 #include <QDebug>
 #include <QtPlugin>
 #include <QThread>
@@ -38,6 +40,7 @@
 #include <QList>
 #include <QErrorMessage>
 #include <QWriteLocker>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include <extensionsystem/pluginmanager.h>
 #include <QKeySequence>
@@ -73,7 +76,7 @@ QIODevice *LoggingConnection::openDevice(const QString &deviceName)
     loggingPlugin->stopLogging();
     closeDevice(deviceName);
 
-    QString fileName = QFileDialog::getOpenFileName(NULL, tr("Open file"), QString(""), tr("OpenPilot Log (*.opl)"));
+    QString fileName = QFileDialog::getOpenFileName(NULL, tr("Open file"), QString(""), tr("OpenPilot Log (*.opl *.oplz)"));
     if (!fileName.isNull()) {
         startReplay(fileName);
         return &logFile;
@@ -128,12 +131,15 @@ LoggingThread::~LoggingThread()
 bool LoggingThread::openFile(QString file, LoggingPlugin *parent)
 {
     logFile.setFileName(file);
+    logFile.setCompressed(file.endsWith(".oplz"));
     logFile.open(QIODevice::WriteOnly);
 
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
     uavTalk = new UAVTalk(&logFile, objManager);
+    // keep the board time of the objects received timestamped
+    uavTalk->setSendTimestamps(true);
     connect(parent, SIGNAL(stopLoggingSignal()), this, SLOT(stopLogging()));
 
     return true;
@@ -294,11 +300,13 @@ LoggingPlugin::LoggingPlugin() :
     loggingThread(NULL),
     logConnection(new LoggingConnection(this)),
     mf(NULL),
-    cmd(NULL)
+    cmd(NULL),
+    scopeFactory(NULL)
 {}
 
 LoggingPlugin::~LoggingPlugin()
 {
+    playbackDecoder.waitForFinished();
     delete loggingThread;
 
     // Don't delete it, the plugin manager will do it:
@@ -353,7 +361,7 @@ void LoggingPlugin::toggleLogging()
     if (state == IDLE) {
         QString fileName = QFileDialog::getSaveFileName(NULL, tr("Start Log"),
                                                         tr("OP-%0.opl").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss")),
-                                                        tr("OpenPilot Log (*.opl)"));
+                                                        tr("OpenPilot Log (*.opl);;Compressed OpenPilot Log (*.oplz)"));
         if (fileName.isEmpty()) {
             return;
         }
@@ -424,6 +432,9 @@ void LoggingPlugin::replayStopped()
 {
     state = IDLE;
     emit stateChanged("IDLE");
+    if (scopeFactory) {
+        scopeFactory->setPlaybackLog(ScopePlaybackLogPtr());
+    }
 }
 
 /**
@@ -433,12 +444,58 @@ void LoggingPlugin::replayStarted()
 {
     state = REPLAY;
     emit stateChanged("REPLAY");
+    if (scopeFactory) {
+        UAVObjectManager *objManager = ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>();
+        playbackDecoder.setFuture(QtConcurrent::run(&LoggingPlugin::decodePlaybackLog, objManager, getLogfile()->fileName()));
+    }
+}
+
+/**
+ * The replayed log is decoded, the scopes show it unless the replay stopped meanwhile
+ */
+void LoggingPlugin::playbackLogDecoded()
+{
+    if (state == REPLAY) {
+        scopeFactory->setPlaybackLog(playbackDecoder.result());
+    }
+}
+
+/**
+ * Worker thread, decodes the whole log into the columns the scopes plot.
+ * The scopes plot the first instance of the objects.
+ */
+ScopePlaybackLogPtr LoggingPlugin::decodePlaybackLog(UAVObjectManager *objManager, QString fileName)
+{
+    LogDecoder decoder(objManager);
+    ScopePlaybackLog *log = new ScopePlaybackLog();
+
+    if (decoder.decode(fileName)) {
+        foreach(const LogDecoder::ObjectColumns &object, decoder.objects()) {
+            if (object.instId != 0) {
+                continue;
+            }
+            foreach(const LogDecoder::Column &column, object.columns) {
+                log->addColumn(object.object->getName() + "." + column.name, object.timeStamps, column.samples);
+            }
+        }
+    } else {
+        qDebug() << "LoggingPlugin: could not decode" << fileName << "for the scopes";
+    }
+    return ScopePlaybackLogPtr(log);
 }
 
 
 void LoggingPlugin::extensionsInitialized()
 {
     addAutoReleasedObject(logConnection);
+
+    // The scopes follow the replay position and move it where they are clicked
+    scopeFactory = ExtensionSystem::PluginManager::instance()->getObject<ScopeGadgetFactory>();
+    if (scopeFactory) {
+        connect(getLogfile(), SIGNAL(replayPositionChanged(quint32)), scopeFactory, SLOT(setPlaybackPosition(quint32)));
+        connect(scopeFactory, SIGNAL(playbackPositionRequested(quint32)), getLogfile(), SLOT(setReplayPosition(quint32)));
+        connect(&playbackDecoder, SIGNAL(finished()), this, SLOT(playbackLogDecoded()));
+    }
 }
 
 void LoggingPlugin::shutdown()
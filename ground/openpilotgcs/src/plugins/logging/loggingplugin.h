@@ -37,12 +37,16 @@
 #include <uavtalk/uavtalk.h>
 #include <utils/logfile.h>
 
+#include "scope/scopeplayback.h"
+
 #include <QThread>
 #include <QQueue>
 #include <QReadWriteLock>
+#include <QFutureWatcher>
 
 class LoggingPlugin;
 class LoggingGadgetFactory;
+class ScopeGadgetFactory;
 
 /**
  *   Define a connection via the IConnection interface
@@ -159,10 +163,16 @@ private slots:
     void loggingStopped();
     void replayStarted();
     void replayStopped();
+    void playbackLogDecoded();
 
 private:
     LoggingGadgetFactory *mf;
     Core::Command *cmd;
+
+    // The scopes are handed the whole replayed log, decoded next to the replay
+    ScopeGadgetFactory *scopeFactory;
+    QFutureWatcher<ScopePlaybackLogPtr> playbackDecoder;
+    static ScopePlaybackLogPtr decodePlaybackLog(UAVObjectManager *objManager, QString fileName);
 };
 #endif /* LoggingPLUGIN_H_ */
 /**
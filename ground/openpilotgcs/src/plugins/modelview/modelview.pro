@@ -1,5 +1,6 @@
 TEMPLATE = lib
 TARGET = ModelViewGadget
+QT += concurrent
 include(../../openpilotgcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri)
 include(../../libs/glc_lib/glc_lib.pri)
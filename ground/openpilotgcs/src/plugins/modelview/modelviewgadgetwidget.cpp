@@ -35,8 +35,24 @@
 #include "glc_openglexception.h"
 #include "viewport/glc_userinput.h"
 
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrentRun>
 #include <iostream>
 
+namespace {
+// Runs in a pool thread, GL resources are only created once the world is rendered
+GLC_World loadWorld(const QString &fileName)
+{
+    try {
+        QFile aircraft(fileName);
+        return GLC_Factory::instance()->createWorldFromFile(aircraft);
+    } catch(GLC_Exception e) {
+        qDebug("ModelView: aircraft file loading failed.");
+    }
+    return GLC_World();
+}
+}
+
 ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     : QGLWidget(new GLC_Context(QGLFormat(QGL::SampleBuffers)), parent)
     , m_Light()
@@ -45,11 +61,16 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     , m_MoverController()
     , m_ModelBoundingBox()
     , m_MotionTimer()
+    , m_FrameTime(0.0)
+    , m_ShowFrameTime(false)
+    , m_AttitudeInterval(100)
+    , m_AttitudeSettled(false)
     , acFilename()
     , bgFilename()
     , vboEnable(false)
 {
     connect(&m_GlView, SIGNAL(updateOpenGL()), this, SLOT(updateGL()));
+    connect(&m_WorldLoader, SIGNAL(finished()), this, SLOT(worldLoaded()));
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
 
     m_Light.setPosition(4000.0, 40000.0, 80000.0);
@@ -68,12 +89,16 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
     attState = AttitudeState::GetInstance(objManager);
+    connect(attState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(attitudeUpdated()));
 
+    m_AttitudeClock.start();
     connect(&m_MotionTimer, SIGNAL(timeout()), this, SLOT(updateAttitude()));
 }
 
 ModelViewGadgetWidget::~ModelViewGadgetWidget()
-{}
+{
+    m_WorldLoader.waitForFinished();
+}
 
 
 void ModelViewGadgetWidget::setAcFilename(QString acf)
@@ -126,12 +151,15 @@ void ModelViewGadgetWidget::initializeGL()
     // Enable antialiasing
     glEnable(GL_MULTISAMPLE);
 
-    m_MotionTimer.start(100);
+    m_MotionTimer.start(16);
     setFocusPolicy(Qt::StrongFocus); // keyboard capture for camera switching
 }
 
 void ModelViewGadgetWidget::paintGL()
 {
+    QElapsedTimer frameTimer;
+
+    frameTimer.start();
     try {
         // Clear screen
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -167,6 +195,14 @@ void ModelViewGadgetWidget::paintGL()
     } catch(GLC_Exception &e) {
         qDebug() << e.what();
     }
+    m_FrameTime = frameTimer.nsecsElapsed() / 1.0e6;
+
+    if (m_WorldLoader.isRunning()) {
+        renderText(10, 20, tr("Loading model..."));
+    }
+    if (m_ShowFrameTime) {
+        renderText(10, height() - 10, tr("Frame %1 ms").arg(m_FrameTime, 0, 'f', 1));
+    }
 }
 
 void ModelViewGadgetWidget::resizeGL(int width, int height)
@@ -197,20 +233,30 @@ void ModelViewGadgetWidget::CreateScene()
         qDebug("ModelView: background image file loading failed.");
     }
 
-    try {
-        if (QFile::exists(acFilename)) {
-            QFile aircraft(acFilename);
-            m_World = GLC_Factory::instance()->createWorldFromFile(aircraft);
-            m_ModelBoundingBox = m_World.boundingBox();
-            m_GlView.reframe(m_ModelBoundingBox); // center 3D model in the scene
-        } else {
-            qDebug("ModelView: aircraft file not found.");
-        }
-    } catch(GLC_Exception e) {
-        qDebug("ModelView: aircraft file loading failed.");
+    // large models take seconds to parse, the previous one stays on screen meanwhile
+    if (QFile::exists(acFilename)) {
+        m_WorldLoader.setFuture(QtConcurrent::run(loadWorld, acFilename));
+    } else {
+        qDebug("ModelView: aircraft file not found.");
     }
 }
 
+void ModelViewGadgetWidget::worldLoaded()
+{
+    GLC_World world = m_WorldLoader.result();
+
+    if (world.isEmpty()) {
+        return;
+    }
+    m_World = world;
+    m_World.collection()->setVboUsage(vboEnable);
+    m_ModelBoundingBox = m_World.boundingBox();
+    m_GlView.reframe(m_ModelBoundingBox); // center 3D model in the scene
+    // the new root has no attitude yet
+    m_AttitudeSettled  = false;
+    updateGL();
+}
+
 void ModelViewGadgetWidget::wheelEvent(QWheelEvent *e)
 {
     double delta = m_GlView.cameraHandle()->distEyeTarget() - (e->delta() / 4);
@@ -315,23 +361,49 @@ void ModelViewGadgetWidget::keyPressEvent(QKeyEvent *e) // switch between camera
         m_GlView.cameraHandle()->rotateAroundTarget(glc::Z_AXIS, glc::toRadian(180));
         updateGL();
     }
+    if (e->key() == Qt::Key_F) {
+        m_ShowFrameTime = !m_ShowFrameTime;
+        updateGL();
+    }
 }
 
 //////////////////////////////////////////////////////////////////////
 // Private slots Functions
 //////////////////////////////////////////////////////////////////////
-void ModelViewGadgetWidget::updateAttitude()
+void ModelViewGadgetWidget::attitudeUpdated()
 {
-    AttitudeState::DataFields data  = attState->getData(); // get attitude data
-    GLC_StructOccurence *rootObject = m_World.rootOccurence(); // get the full 3D model
-    double x = data.q3;
-    double y = data.q2;
-    double z = data.q4;
-    double w = data.q1;
+    AttitudeState::DataFields data = attState->getData();
+    QQuaternion attitude(data.q1, data.q2, data.q3, data.q4);
 
-    if (w == 0.0) {
-        w = 1.0;
+    if (attitude.isNull()) {
+        attitude = QQuaternion();
     }
+
+    // continue from where the model is drawn now to avoid a jump
+    qreal t = qMin(1.0, qreal(m_AttitudeClock.elapsed()) / m_AttitudeInterval);
+    m_PreviousAttitude  = QQuaternion::slerp(m_PreviousAttitude, m_TargetAttitude, t);
+    m_TargetAttitude    = attitude;
+    m_AttitudeInterval  = qBound(Q_INT64_C(10), m_AttitudeClock.restart(), Q_INT64_C(500));
+    m_AttitudeSettled   = false;
+}
+
+void ModelViewGadgetWidget::updateAttitude()
+{
+    if (m_AttitudeSettled) {
+        return;
+    }
+    qreal t = qreal(m_AttitudeClock.elapsed()) / m_AttitudeInterval;
+    if (t >= 1.0) {
+        t = 1.0;
+        m_AttitudeSettled = true;
+    }
+    QQuaternion attitude = QQuaternion::slerp(m_PreviousAttitude, m_TargetAttitude, t);
+
+    GLC_StructOccurence *rootObject = m_World.rootOccurence(); // get the full 3D model
+    double x = attitude.y();
+    double y = attitude.x();
+    double z = attitude.z();
+    double w = attitude.scalar();
     // create and gives the product of 2 4x4 matrices to get the rotation of the 3D model's matrix
     QMatrix4x4 m1;
     m1.setRow(0, QVector4D(w, z, -y, x));
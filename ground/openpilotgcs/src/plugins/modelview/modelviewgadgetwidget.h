@@ -30,6 +30,9 @@
 
 #include <QGLWidget>
 #include <QTimer>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QQuaternion>
 
 #include "glc_factory.h"
 #include "viewport/glc_viewport.h"
@@ -74,6 +77,8 @@ private:
 //////////////////////////////////////////////////////////////////////
 private slots:
     void updateAttitude();
+    void attitudeUpdated();
+    void worldLoaded();
 
 private:
     GLC_Factory *m_pFactory;
@@ -84,6 +89,19 @@ private:
     GLC_BoundingBox m_ModelBoundingBox;
     // ! The timer used for motion
     QTimer m_MotionTimer;
+    // ! Parses the model file off the UI thread
+    QFutureWatcher<GLC_World> m_WorldLoader;
+    // ! Duration of the last paintGL() in ms, shown after pressing F
+    double m_FrameTime;
+    bool m_ShowFrameTime;
+
+    // ! The drawn attitude moves from the previous to the latest telemetry value
+    // ! over one update interval, so 60 fps follow a few Hz of AttitudeState
+    QQuaternion m_PreviousAttitude;
+    QQuaternion m_TargetAttitude;
+    QElapsedTimer m_AttitudeClock;
+    qint64 m_AttitudeInterval;
+    bool m_AttitudeSettled;
 
     QString acFilename;
     QString bgFilename;
@@ -38,6 +38,7 @@
 // Notify plugin headers
 #include "notificationitem.h"
 #include "notifylogging.h"
+#include "notifypluginoptionspage.h"
 
 
 QStringList NotificationItem::sayOrderValues;
@@ -65,6 +66,12 @@ NotificationItem::NotificationItem(QObject *parent)
     , _repeatValue(repeatInstantly)
     , _expireTimeout(eDefaultTimeout)
     , _mute(false)
+    , _compiledObject(NULL)
+    , _compiledField(NULL)
+    , _compiledEnum(false)
+    , _compiledOption(-1)
+    , _compiledMin(0)
+    , _compiledMax(0)
 {
     NotificationItem::sayOrderValues.clear();
     NotificationItem::sayOrderValues.insert(never, QString(tr("Never")));
@@ -447,3 +454,58 @@ UAVDataObject *NotificationItem::getUAVObject()
 {
     return dynamic_cast<UAVDataObject *>((ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>())->getObject(getDataObject()));
 }
+
+bool NotificationItem::compileCondition()
+{
+    _compiledObject = getUAVObject();
+    _compiledField  = _compiledObject ? _compiledObject->getField(getObjectField()) : NULL;
+    if (_compiledField == NULL) {
+        _compiledObject = NULL;
+        return false;
+    }
+
+    _compiledEnum   = (_compiledField->getType() == UAVObjectField::ENUM);
+    _compiledOption = -1;
+    if (_compiledEnum) {
+        // enum values are stored as the index of their option
+        QStringList options = _compiledField->getOptions();
+        for (int i = 0; i < options.length(); ++i) {
+            if (!QString::compare(options.at(i), singleValue().toString(), Qt::CaseInsensitive)) {
+                _compiledOption = i;
+                break;
+            }
+        }
+    }
+    _compiledMin = singleValue().toDouble();
+    _compiledMax = valueRange2();
+    return true;
+}
+
+bool NotificationItem::isConditionMet() const
+{
+    if (_compiledField == NULL) {
+        return false;
+    }
+
+    if (_compiledEnum) {
+        if (getCondition() != NotifyPluginOptionsPage::equal) {
+            return true;
+        }
+        return _compiledField->read<quint8>() == _compiledOption;
+    }
+
+    double value = _compiledField->getDouble();
+    switch (getCondition()) {
+    case NotifyPluginOptionsPage::equal:
+        return value == _compiledMin;
+
+    case NotifyPluginOptionsPage::bigger:
+        return value > _compiledMin;
+
+    case NotifyPluginOptionsPage::smaller:
+        return value < _compiledMin;
+
+    default:
+        return (value > _compiledMin) && (value < _compiledMax);
+    }
+}
@@ -40,6 +40,7 @@ using namespace Core;
     QString getSound##number() const { return _sound##number; } \
     void setSound##number(QString text) { _sound##number = text; } \
 
+class UAVObject;
 class UAVDataObject;
 class UAVObjectField;
 
@@ -184,6 +185,23 @@ public:
     UAVDataObject *getUAVObject(void);
     UAVObjectField *getUAVObjectField(void);
 
+    /**
+     * Resolve the object, the field and the condition values once,
+     * so the condition is checked on updates without any string handling
+     *
+     * @return false if the object or the field is unknown
+     */
+    bool compileCondition();
+
+    // object of the compiled condition, NULL before compileCondition()
+    UAVObject *getCompiledObject() const
+    {
+        return _compiledObject;
+    }
+
+    // evaluates the compiled condition on the current field value
+    bool isConditionMet() const;
+
     void serialize(QDataStream & stream);
     void deserialize(QDataStream & stream);
 
@@ -293,6 +311,14 @@ private:
 
     // ! enables/disables playing of current notification
     bool _mute;
+
+    // ! condition resolved by compileCondition()
+    UAVObject *_compiledObject;
+    UAVObjectField *_compiledField;
+    bool _compiledEnum;
+    int _compiledOption;
+    double _compiledMin;
+    double _compiledMax;
 };
 
 Q_DECLARE_METATYPE(NotificationItem *)
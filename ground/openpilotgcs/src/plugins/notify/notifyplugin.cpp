@@ -45,18 +45,18 @@ static const QString VERSION = "1.0.0";
 // #define DEBUG_NOTIFIES
 
 
-SoundNotifyPlugin::SoundNotifyPlugin()
+SoundNotifyPlugin::SoundNotifyPlugin() :
+    _nowPlayingNotification(NULL),
+    _playingSound(NULL)
 {
-    phonon.mo = NULL;
+    _evaluateTimer.setSingleShot(true);
+    _evaluateTimer.setInterval(EVALUATE_PERIOD_MS);
+    connect(&_evaluateTimer, SIGNAL(timeout()), this, SLOT(on_evaluateTimer_Notification()));
 }
 
 SoundNotifyPlugin::~SoundNotifyPlugin()
 {
     Core::ICore::instance()->saveSettings(this);
-
-    if (phonon.mo != NULL) {
-        delete phonon.mo;
-    }
 }
 
 bool SoundNotifyPlugin::initialize(const QStringList & args, QString *errMsg)
@@ -181,10 +181,9 @@ void SoundNotifyPlugin::connectNotifications()
             disconnect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(on_arrived_Notification(UAVObject *)));
         }
     }
-    if (phonon.mo != NULL) {
-        delete phonon.mo;
-        phonon.mo = NULL;
-    }
+    _evaluateTimer.stop();
+    _updatedObjects.clear();
+    stopSounds();
 
     if (!enableSound) {
         return;
@@ -213,7 +212,11 @@ void SoundNotifyPlugin::connectNotifications()
         }
 
         UAVDataObject *obj = dynamic_cast<UAVDataObject *>(objManager->getObject(notify->getDataObject()));
-        if (obj != NULL) {
+        if (obj != NULL && notify->compileCondition()) {
+            // decode the sounds now, playing them is then immediate
+            foreach(QString fileName, notify->getMessageSequence()) {
+                soundEffect(fileName);
+            }
             if (!lstNotifiedUAVObjects.contains(obj)) {
                 lstNotifiedUAVObjects.append(obj);
 
@@ -222,24 +225,30 @@ void SoundNotifyPlugin::connectNotifications()
                         Qt::QueuedConnection);
             }
         } else {
-            qNotifyDebug() << "Error: Object is unknown (" << notify->getDataObject() << ").";
+            qNotifyDebug() << "Error: Object or field is unknown (" << notify->getDataObject() << notify->getObjectField() << ").";
         }
     }
+}
 
-    if (_notificationList.isEmpty()) {
-        return;
+/*!
+    object updates are only collected here,
+    the conditions are checked by the evaluate timer
+ */
+void SoundNotifyPlugin::on_arrived_Notification(UAVObject *object)
+{
+    _updatedObjects.insert(object);
+    if (!_evaluateTimer.isActive()) {
+        _evaluateTimer.start();
     }
-    // set notification message to current event
-    phonon.mo = new QMediaPlayer;
-    phonon.firstPlay = true;
-    connect(phonon.mo, SIGNAL(stateChanged(QMediaPlayer::State)),
-            this, SLOT(stateChanged(QMediaPlayer::State)));
 }
 
-void SoundNotifyPlugin::on_arrived_Notification(UAVObject *object)
+void SoundNotifyPlugin::on_evaluateTimer_Notification()
 {
+    QSet<UAVObject *> updated = _updatedObjects;
+
+    _updatedObjects.clear();
     foreach(NotificationItem * ntf, _notificationList) {
-        if (object->getName() != ntf->getDataObject()) {
+        if (!updated.contains(ntf->getCompiledObject())) {
             continue;
         }
 
@@ -268,10 +277,8 @@ void SoundNotifyPlugin::on_arrived_Notification(UAVObject *object)
             .arg(ntf->singleValue().toString())
             .arg(ntf->valueRange2());
 
-        checkNotificationRule(ntf, object);
+        checkNotificationRule(ntf);
     }
-    connect(object, SIGNAL(objectUpdated(UAVObject *)),
-            this, SLOT(on_arrived_Notification(UAVObject *)), Qt::UniqueConnection);
 }
 
 
@@ -295,12 +302,7 @@ void SoundNotifyPlugin::on_timerRepeated_Notification()
         .arg(notification->getObjectField())
         .arg(notification->toString());
 
-    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
-    UAVObject *object = objManager->getObject(notification->getDataObject());
-    if (object) {
-        checkNotificationRule(notification, object);
-    }
+    checkNotificationRule(notification);
 }
 
 
@@ -323,122 +325,84 @@ void SoundNotifyPlugin::on_expiredTimer_Notification()
     }
 }
 
-void SoundNotifyPlugin::stateChanged(QMediaPlayer::State newstate)
+/*!
+    a sound of the queue finished, start the next one
+    or the next pending notification
+ */
+void SoundNotifyPlugin::on_playingChanged_Sound()
 {
-    // qNotifyDebug() << "File length (ms): " << phonon.mo->totalTime();
-
-#ifndef Q_OS_WIN
-    // This is a hack to force Linux to wait until the end of the
-    // wav file before moving to the next in the queue.
-    // I wish I did not have to go through a #define, but I did not
-    // manage to make this work on both platforms any other way!
-// if (phonon.mo->totalTime() > 0) {
-// phonon.mo->setTransitionTime(phonon.mo->totalTime());
-// }
-#endif
-    if ((newstate == QMediaPlayer::PausedState) ||
-        (newstate == QMediaPlayer::StoppedState)) {
-        qNotifyDebug() << "New State: " << QVariant(newstate).toString();
-
-        // assignment to NULL needed to detect that palying is finished
-        // it's useful in repeat timer handler, where we can detect
-        // that notification has not overlap with itself
-        _nowPlayingNotification = NULL;
-
-        if (!_pendingNotifications.isEmpty()) {
-            NotificationItem *notification = _pendingNotifications.takeFirst();
-            qNotifyDebug_if(notification) << "play audioFree - " << notification->toString();
-            playNotification(notification);
-            qNotifyDebug() << "end playNotification";
-        }
+    if (sender() == _playingSound && !_playingSound->isPlaying()) {
+        playNextSound();
     }
 }
 
-bool checkRange(QString fieldValue, QString enumValue, QStringList /* values */, int direction)
+void SoundNotifyPlugin::on_statusChanged_Sound()
 {
-    bool ret = false;
-
-    switch (direction) {
-    case NotifyPluginOptionsPage::equal:
-        ret = !QString::compare(enumValue, fieldValue, Qt::CaseInsensitive) ? true : false;
-        break;
-
-    default:
-        ret = true;
-        break;
+    if (sender() == _playingSound && _playingSound->status() == QSoundEffect::Error) {
+        playNextSound();
     }
-    ;
-    return ret;
 }
 
-bool checkRange(double fieldValue, double min, double max, int direction)
+QSoundEffect *SoundNotifyPlugin::soundEffect(const QString &fileName)
 {
-    bool ret = false;
-
-    // Q_ASSERT(min < max);
-    switch (direction) {
-    case NotifyPluginOptionsPage::equal:
-        ret = (fieldValue == min);
-        break;
+    QSoundEffect *effect = _soundEffects.value(fileName);
+
+    if (effect == NULL) {
+        effect = new QSoundEffect(this);
+        effect->setSource(QUrl::fromLocalFile(fileName));
+        connect(effect, SIGNAL(playingChanged()), this, SLOT(on_playingChanged_Sound()));
+        connect(effect, SIGNAL(statusChanged()), this, SLOT(on_statusChanged_Sound()));
+        _soundEffects.insert(fileName, effect);
+    }
+    return effect;
+}
 
-    case NotifyPluginOptionsPage::bigger:
-        ret = (fieldValue > min);
-        break;
+void SoundNotifyPlugin::playNextSound()
+{
+    _playingSound = NULL;
+    while (!_playQueue.isEmpty()) {
+        QSoundEffect *effect = soundEffect(_playQueue.takeFirst());
+        if (effect->status() != QSoundEffect::Error) {
+            _playingSound = effect;
+            // plays once loaded if it is still decoding
+            effect->play();
+            return;
+        }
+    }
 
-    case NotifyPluginOptionsPage::smaller:
-        ret = (fieldValue < min);
-        break;
+    // assignment to NULL needed to detect that palying is finished
+    // it's useful in repeat timer handler, where we can detect
+    // that notification has not overlap with itself
+    _nowPlayingNotification = NULL;
 
-    default:
-        ret = (fieldValue > min) && (fieldValue < max);
-        break;
+    if (!_pendingNotifications.isEmpty()) {
+        NotificationItem *notification = _pendingNotifications.takeFirst();
+        qNotifyDebug_if(notification) << "play audioFree - " << notification->toString();
+        playNotification(notification);
     }
-    ;
-
-    return ret;
 }
 
-void SoundNotifyPlugin::checkNotificationRule(NotificationItem *notification, UAVObject *object)
+void SoundNotifyPlugin::stopSounds()
 {
-    if (notification->getDataObject() != object->getName() || object->getField(notification->getObjectField()) == NULL) {
-        return;
+    QSoundEffect *playing = _playingSound;
+
+    // cleared first, so the stop is not taken for the end of the sound
+    _playQueue.clear();
+    _playingSound = NULL;
+    _nowPlayingNotification = NULL;
+    if (playing) {
+        playing->stop();
     }
-    bool condition = false;
+}
 
+void SoundNotifyPlugin::checkNotificationRule(NotificationItem *notification)
+{
     if (notification->mute()) {
         return;
     }
 
-    int direction         = notification->getCondition();
-    QString fieldName     = notification->getObjectField();
-    UAVObjectField *field = object->getField(fieldName);
-
-    if (field->getName().isEmpty()) {
-        return;
-    }
-
-    QVariant value = field->getValue();
-    if (UAVObjectField::ENUM == field->getType()) {
-        qNotifyDebug() << "Check range ENUM" << value.toString() << "|" << notification->singleValue().toString() << "|" << field->getOptions() << "|" <<
-            direction << checkRange(value.toString(),
-                                    notification->singleValue().toString(),
-                                    field->getOptions(),
-                                    direction);;
-        condition = checkRange(value.toString(),
-                               notification->singleValue().toString(),
-                               field->getOptions(),
-                               direction);
-    } else {
-        qNotifyDebug() << "Check range VAL" << value.toString() << "|" << notification->singleValue().toString() << "|" << field->getOptions() << "|" <<
-            direction << checkRange(value.toDouble(),
-                                    notification->singleValue().toDouble(),
-                                    notification->valueRange2(),
-                                    direction);
-        condition = checkRange(value.toDouble(),
-                               notification->singleValue().toDouble(),
-                               notification->valueRange2(),
-                               direction);
-    }
+    bool condition = notification->isConditionMet();
+    qNotifyDebug() << "Check condition" << notification->getDataObject() << notification->getObjectField() << condition;
 
     notification->_isPlayed = condition;
     // if condition has been changed, and already in false state
@@ -471,21 +435,11 @@ void SoundNotifyPlugin::checkNotificationRule(NotificationItem *notification, UA
 
 bool SoundNotifyPlugin::playNotification(NotificationItem *notification)
 {
-    playlist = new QMediaPlaylist;
-    if (!notification) {
+    if (!notification || !enableSound) {
         return false;
     }
 
-    // Check: race condition, if phonon.mo got deleted don't go further
-    if (phonon.mo == NULL) {
-        return false;
-    }
-
-    // qNotifyDebug() << "Phonon State: " << phonon.mo->state();
-
-    if ((phonon.mo->state() == QMediaPlayer::PausedState)
-        || (phonon.mo->state() == QMediaPlayer::StoppedState)
-        || phonon.firstPlay) {
+    if (_nowPlayingNotification == NULL) {
         _nowPlayingNotification = notification;
         notification->stopExpireTimer();
 
@@ -518,17 +472,9 @@ bool SoundNotifyPlugin::playNotification(NotificationItem *notification)
                         this, SLOT(on_timerRepeated_Notification()), Qt::UniqueConnection);
             }
         }
-        phonon.mo->stop();
         qNotifyDebug() << "play: " << notification->toString();
-        foreach(QString item, notification->toSoundList()) {
-            playlist->addMedia(QUrl::fromLocalFile(item));
-        }
-        qNotifyDebug() << "begin play";
-        phonon.mo->setPlaylist(playlist);
-        phonon.mo->play();
-        qNotifyDebug() << "end play";
-        phonon.firstPlay = false; // On Linux, you sometimes have to nudge Phonon to play 1 time before
-                                  // the state is not "Loading" anymore.
+        _playQueue = notification->getMessageSequence();
+        playNextSound();
         return true;
     }
 
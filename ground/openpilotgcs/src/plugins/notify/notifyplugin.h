@@ -34,17 +34,13 @@
 #include "notificationitem.h"
 
 #include <QSettings>
-#include <QMediaPlaylist>
-#include <QMediaPlayer>
+#include <QSoundEffect>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
 
 class NotifyPluginOptionsPage;
 
-typedef struct {
-    QMediaPlayer *mo;
-    NotificationItem *notify;
-    bool firstPlay;
-} PhononObject, *pPhononObject;
-
 
 class SoundNotifyPlugin : public Core::IConfigurablePlugin {
     Q_OBJECT
@@ -83,7 +79,10 @@ private:
     Q_DISABLE_COPY(SoundNotifyPlugin)
 
     bool playNotification(NotificationItem *notification);
-    void checkNotificationRule(NotificationItem *notification, UAVObject *object);
+    void checkNotificationRule(NotificationItem *notification);
+    QSoundEffect *soundEffect(const QString &fileName);
+    void playNextSound();
+    void stopSounds();
 
 private slots:
 
@@ -93,11 +92,16 @@ private slots:
     void updateNotificationList(QList<NotificationItem *> list);
     void resetNotification(void);
     void on_arrived_Notification(UAVObject *object);
+    void on_evaluateTimer_Notification(void);
     void on_timerRepeated_Notification(void);
     void on_expiredTimer_Notification(void);
-    void stateChanged(QMediaPlayer::State newstate);
+    void on_playingChanged_Sound(void);
+    void on_statusChanged_Sound(void);
 
 private:
+    // Conditions are checked at most that often, for all the objects updated meanwhile
+    static const int EVALUATE_PERIOD_MS = 100;
+
     bool enableSound;
 
     QList<UAVDataObject *> lstNotifiedUAVObjects;
@@ -108,9 +112,16 @@ private:
     NotificationItem currentNotification;
     NotificationItem *_nowPlayingNotification;
 
-    PhononObject phonon;
+    QSet<UAVObject *> _updatedObjects;
+    QTimer _evaluateTimer;
+
+    // decoded sound files, loaded when the notifications are connected
+    QHash<QString, QSoundEffect *> _soundEffects;
+    // sounds of the playing notification still to come
+    QStringList _playQueue;
+    QSoundEffect *_playingSound;
+
     NotifyPluginOptionsPage *mop;
-    QMediaPlaylist *playlist;
 };
 
 #endif // SOUNDNOTIFYPLUGIN_H
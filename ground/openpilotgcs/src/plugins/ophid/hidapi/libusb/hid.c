@@ -142,6 +142,14 @@ struct input_report {
 };
 
 
+/* Interrupt IN transfers kept in flight, so the next report can be
+   received while the previous one is being queued */
+#define HID_IN_TRANSFERS 4
+
+/* Reports kept when the application does not read, about a quarter
+   of a second of a device sending a report every millisecond */
+#define HID_MAX_QUEUED_REPORTS 256
+
 struct hid_device_ {
 	/* Handle to the actual device. */
 	libusb_device_handle *device_handle;
@@ -169,10 +177,13 @@ struct hid_device_ {
 	pthread_barrier_t barrier; /* Ensures correct startup sequence */
 	int shutdown_thread;
 	int cancelled;
-	struct libusb_transfer *transfer;
+	int transfers_active; /* transfers still submitted, protected by the event loop */
+	struct libusb_transfer *transfers[HID_IN_TRANSFERS];
 
 	/* List of received input reports. */
 	struct input_report *input_reports;
+	struct input_report *input_reports_tail;
+	int num_input_reports;
 };
 
 static libusb_context *usb_context = NULL;
@@ -729,6 +740,14 @@ hid_device * hid_open(unsigned short vendor_id, unsigned short product_id, const
 	return handle;
 }
 
+/* A transfer will not be resubmitted, the device is cancelled once none is left.
+   Only called from the event loop, which runs in read_thread(). */
+static void transfer_done(hid_device *dev)
+{
+	if (--dev->transfers_active <= 0)
+		dev->cancelled = 1;
+}
+
 static void read_callback(struct libusb_transfer *transfer)
 {
 	hid_device *dev = transfer->user_data;
@@ -751,32 +770,26 @@ static void read_callback(struct libusb_transfer *transfer)
 			pthread_cond_signal(&dev->condition);
 		}
 		else {
-			/* Find the end of the list and attach. */
-			struct input_report *cur = dev->input_reports;
-			int num_queued = 0;
-			while (cur->next != NULL) {
-				cur = cur->next;
-				num_queued++;
-			}
-			cur->next = rpt;
+			dev->input_reports_tail->next = rpt;
+		}
+		dev->input_reports_tail = rpt;
+		dev->num_input_reports++;
 
-			/* Pop one off if we've reached 30 in the queue. This
-			   way we don't grow forever if the user never reads
-			   anything from the device. */
-			if (num_queued > 30) {
-				return_data(dev, NULL, 0);
-			}
+		/* Pop one off if the queue is full. This way we don't grow
+		   forever if the user never reads anything from the device. */
+		if (dev->num_input_reports > HID_MAX_QUEUED_REPORTS) {
+			return_data(dev, NULL, 0);
 		}
 		pthread_mutex_unlock(&dev->mutex);
 	}
 	else if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
 		dev->shutdown_thread = 1;
-		dev->cancelled = 1;
+		transfer_done(dev);
 		return;
 	}
 	else if (transfer->status == LIBUSB_TRANSFER_NO_DEVICE) {
 		dev->shutdown_thread = 1;
-		dev->cancelled = 1;
+		transfer_done(dev);
 		return;
 	}
 	else if (transfer->status == LIBUSB_TRANSFER_TIMED_OUT) {
@@ -786,12 +799,16 @@ static void read_callback(struct libusb_transfer *transfer)
 		LOG("Unknown transfer code: %d\n", transfer->status);
 	}
 
-	/* Re-submit the transfer object. */
+	/* Re-submit the transfer object, unless we are shutting down. */
+	if (dev->shutdown_thread) {
+		transfer_done(dev);
+		return;
+	}
 	res = libusb_submit_transfer(transfer);
 	if (res != 0) {
 		LOG("Unable to submit URB. libusb error code: %d\n", res);
 		dev->shutdown_thread = 1;
-		dev->cancelled = 1;
+		transfer_done(dev);
 	}
 }
 
@@ -799,24 +816,32 @@ static void read_callback(struct libusb_transfer *transfer)
 static void *read_thread(void *param)
 {
 	hid_device *dev = param;
-	unsigned char *buf;
 	const size_t length = dev->input_ep_max_packet_size;
+	int i;
 
-	/* Set up the transfer object. */
-	buf = malloc(length);
-	dev->transfer = libusb_alloc_transfer(0);
-	libusb_fill_interrupt_transfer(dev->transfer,
-		dev->device_handle,
-		dev->input_endpoint,
-		buf,
-		length,
-		read_callback,
-		dev,
-		5000/*timeout*/);
-
-	/* Make the first submission. Further submissions are made
+	/* Set up the transfer objects. */
+	for (i = 0; i < HID_IN_TRANSFERS; i++) {
+		dev->transfers[i] = libusb_alloc_transfer(0);
+		libusb_fill_interrupt_transfer(dev->transfers[i],
+			dev->device_handle,
+			dev->input_endpoint,
+			malloc(length),
+			length,
+			read_callback,
+			dev,
+			5000/*timeout*/);
+	}
+
+	/* Make the first submissions. Further submissions are made
 	   from inside read_callback() */
-	libusb_submit_transfer(dev->transfer);
+	for (i = 0; i < HID_IN_TRANSFERS; i++) {
+		if (libusb_submit_transfer(dev->transfers[i]) == 0)
+			dev->transfers_active++;
+	}
+	if (dev->transfers_active == 0) {
+		dev->shutdown_thread = 1;
+		dev->cancelled = 1;
+	}
 
 	/* Notify the main thread that the read thread is up and running. */
 	pthread_barrier_wait(&dev->barrier);
@@ -841,7 +866,8 @@ static void *read_thread(void *param)
 
 	/* Cancel any transfer that may be pending. This call will fail
 	   if no transfers are pending, but that's OK. */
-	libusb_cancel_transfer(dev->transfer);
+	for (i = 0; i < HID_IN_TRANSFERS; i++)
+		libusb_cancel_transfer(dev->transfers[i]);
 
 	while (!dev->cancelled)
 		libusb_handle_events_completed(usb_context, &dev->cancelled);
@@ -855,7 +881,7 @@ static void *read_thread(void *param)
 	pthread_cond_broadcast(&dev->condition);
 	pthread_mutex_unlock(&dev->mutex);
 
-	/* The dev->transfer->buffer and dev->transfer objects are cleaned up
+	/* The transfer buffers and transfer objects are cleaned up
 	   in hid_close(). They are not cleaned up here because this thread
 	   could end either due to a disconnect or due to a user
 	   call to hid_close(). In both cases the objects can be safely
@@ -1061,6 +1087,9 @@ static int return_data(hid_device *dev, unsigned char *data, size_t length)
 	if (len > 0)
 		memcpy(data, rpt->data, len);
 	dev->input_reports = rpt->next;
+	if (dev->input_reports == NULL)
+		dev->input_reports_tail = NULL;
+	dev->num_input_reports--;
 	free(rpt->data);
 	free(rpt);
 	return len;
@@ -1234,19 +1263,24 @@ int HID_API_EXPORT hid_get_feature_report(hid_device *dev, unsigned char *data,
 
 void HID_API_EXPORT hid_close(hid_device *dev)
 {
+	int i;
+
 	if (!dev)
 		return;
 
 	/* Cause read_thread() to stop. */
 	dev->shutdown_thread = 1;
-	libusb_cancel_transfer(dev->transfer);
+	for (i = 0; i < HID_IN_TRANSFERS; i++)
+		libusb_cancel_transfer(dev->transfers[i]);
 
 	/* Wait for read_thread() to end. */
 	pthread_join(dev->thread, NULL);
 
 	/* Clean up the Transfer objects allocated in read_thread(). */
-	free(dev->transfer->buffer);
-	libusb_free_transfer(dev->transfer);
+	for (i = 0; i < HID_IN_TRANSFERS; i++) {
+		free(dev->transfers[i]->buffer);
+		libusb_free_transfer(dev->transfers[i]);
+	}
 
 	/* release the interface */
 	libusb_release_interface(dev->device_handle, dev->interface);
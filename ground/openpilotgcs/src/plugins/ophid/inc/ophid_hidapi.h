@@ -49,6 +49,8 @@ public:
 
     int open(int max, int vid, int pid, int usage_page, int usage);
 
+    int open(int vid, int pid, const QString &serial);
+
     int receive(int, void *buf, int len, int timeout);
 
     void close(int num);
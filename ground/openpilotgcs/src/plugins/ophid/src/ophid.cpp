@@ -39,6 +39,8 @@ class IConnection;
 // timeout value used when we want to return directly without waiting
 static const int READ_TIMEOUT  = 200;
 static const int READ_SIZE     = 64;
+// reports buffered between the read thread and the consumer (at most 64KB)
+static const int READ_QUEUE    = 1024;
 
 static const int WRITE_TIMEOUT = 1000;
 static const int WRITE_SIZE    = 64;
@@ -69,13 +71,22 @@ public slots:
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-       a circular buffer but it's good enough and very simple */
-    QByteArray m_readBuffer;
+    /** Ring of raw reports: the device writes straight into the free slot
+       and getReadData copies the payload out to the caller, so each byte
+       is only copied once */
+    char m_reports[READ_QUEUE][READ_SIZE];
+    int m_head; // slot the next report is received into
+    int m_tail; // oldest report not completely read
+    int m_count; // reports queued
+    int m_offset; // payload bytes already read from the oldest report
+    qint64 m_bytesAvailable;
 
     /** A mutex to protect read buffer */
     QMutex m_readBufMtx;
 
+    /** Wakes the thread up when the consumer made room in a full ring */
+    QWaitCondition m_spaceAvailable;
+
     RawHID *m_hid;
 
     opHID_hidapi *hiddev;
@@ -131,7 +142,12 @@ protected:
 // *********************************************************************************
 
 RawHIDReadThread::RawHIDReadThread(RawHID *hid)
-    : m_hid(hid),
+    : m_head(0),
+    m_tail(0),
+    m_count(0),
+    m_offset(0),
+    m_bytesAvailable(0),
+    m_hid(hid),
     hiddev(&hid->dev),
     hidno(hid->m_deviceNo),
     m_running(true)
@@ -157,22 +173,37 @@ void RawHIDReadThread::run()
     m_running = m_hid->openDevice();
 
     while (m_running) {
-        // here we use a temporary buffer so we don't need to lock
-        // the mutex while we are reading from the device
+        char *buffer;
+        {
+            QMutexLocker lock(&m_readBufMtx);
+            while (m_count == READ_QUEUE && m_running) {
+                m_spaceAvailable.wait(&m_readBufMtx, READ_TIMEOUT);
+            }
+            if (!m_running) {
+                break;
+            }
+            // the head slot is not visible to readers until it is queued,
+            // so the device can fill it without holding the mutex
+            buffer = m_reports[m_head];
+        }
 
         // Want to read in regular chunks that match the packet size the device
         // is using.  In this case it is 64 bytes (the interrupt packet limit)
         // although it would be nice if the device had a different report to
         // configure this
-        char buffer[READ_SIZE] = { 0 };
-
         int ret = hiddev->receive(hidno, buffer, READ_SIZE, READ_TIMEOUT);
 
         if (ret > 0) { // read some data
-            QMutexLocker lock(&m_readBufMtx);
             // Note: Preprocess the USB packets in this OS independent code
             // First byte is report ID, second byte is the number of valid bytes
-            m_readBuffer.append(&buffer[2], buffer[1]);
+            int size = qMin((int)(quint8)buffer[1], READ_SIZE - 2);
+            if (size > 0) {
+                buffer[1] = size;
+                QMutexLocker lock(&m_readBufMtx);
+                m_head = (m_head + 1) % READ_QUEUE;
+                m_count++;
+                m_bytesAvailable += size;
+            }
 
             emit m_hid->readyRead();
         } else if (ret == 0) { // nothing read
@@ -189,20 +220,32 @@ void RawHIDReadThread::run()
 int RawHIDReadThread::getReadData(char *data, int size)
 {
     QMutexLocker lock(&m_readBufMtx);
+    int read = 0;
+
+    while (read < size && m_count > 0) {
+        const char *report = m_reports[m_tail];
+        int length = qMin(size - read, (quint8)report[1] - m_offset);
+        memcpy(data + read, &report[2 + m_offset], length);
+        read     += length;
+        m_offset += length;
+        if (m_offset == (quint8)report[1]) {
+            m_offset = 0;
+            m_tail   = (m_tail + 1) % READ_QUEUE;
+            if (m_count-- == READ_QUEUE) {
+                m_spaceAvailable.wakeOne();
+            }
+        }
+    }
+    m_bytesAvailable -= read;
 
-    size = qMin(size, m_readBuffer.size());
-
-    memcpy(data, m_readBuffer.constData(), size);
-    m_readBuffer.remove(0, size);
-
-    return size;
+    return read;
 }
 
 qint64 RawHIDReadThread::getBytesAvailable()
 {
     QMutexLocker lock(&m_readBufMtx);
 
-    return m_readBuffer.size();
+    return m_bytesAvailable;
 }
 
 // *********************************************************************************
@@ -212,23 +212,55 @@ int opHID_hidapi::open(int max, int vid, int pid, int usage_page, int usage)
 }
 
 
+/**
+ * \brief Open the HID device with the given serial number
+ *
+ * \note Used when several boards with the same vid/pid are connected.
+ *
+ * \param[in] vid USB vendor id of the device to open.
+ * \param[in] pid USB product id of the device to open.
+ * \param[in] serial USB serial number string of the device to open.
+ * \return Number of opened device.
+ * \retval 0 or 1.
+ */
+int opHID_hidapi::open(int vid, int pid, const QString &serial)
+{
+    OPHID_TRACE("IN");
+
+    if (handle) {
+        OPHID_WARNING("HID device seems already open.");
+    }
+
+    wchar_t buf[USB_MAX_STRING_SIZE];
+    int len = serial.left(USB_MAX_STRING_SIZE - 1).toWCharArray(buf);
+    buf[len] = 0;
+
+    handle   = hid_open(vid, pid, buf);
+    if (!handle) {
+        OPHID_ERROR("Unable to open device.");
+    }
+
+    OPHID_TRACE("OUT");
+
+    return handle ? 1 : 0;
+}
+
+
 /**
  * \brief Read an Input report from a HID device.
  *
- * \note This function does \b not block for now.
- *      Tests show that it does not need to.
+ * \note Blocks until a report arrives or the timeout expires.
  *
  * \param[in] num Id of the device to receive packet (NOT supported).
  * \param[in] buf Pointer to the bufer to write the received packet to.
  * \param[in] len Size of the buffer.
- * \param[in] timeout Not supported.
- * \return Number of bytes received, or -1 on error.
+ * \param[in] timeout Maximum time to wait in ms, -1 to wait forever.
+ * \return Number of bytes received, 0 on timeout or -1 on error.
  * \retval -1 for error or bytes received.
  */
 int opHID_hidapi::receive(int num, void *buf, int len, int timeout)
 {
     Q_UNUSED(num);
-    Q_UNUSED(timeout);
 
     int bytes_read = 0;
 
@@ -248,7 +280,7 @@ int opHID_hidapi::receive(int num, void *buf, int len, int timeout)
     }
 
     hid_read_Mtx.lock();
-    bytes_read = hid_read(handle, (unsigned char *)buf, len);
+    bytes_read = hid_read_timeout(handle, (unsigned char *)buf, len, timeout);
     hid_read_Mtx.unlock();
 
     // hidapi lib does not expose the libusb errors.
@@ -28,8 +28,10 @@
 #include "flightdatamodel.h"
 #include <QMessageBox>
 #include <QDomDocument>
+#include <qnumeric.h>
 
-flightDataModel::flightDataModel(QObject *parent) : QAbstractTableModel(parent)
+flightDataModel::flightDataModel(QObject *parent) : QAbstractTableModel(parent),
+    homeTerrainHeight(qQNaN())
 {}
 
 int flightDataModel::rowCount(const QModelIndex & /*parent*/) const
@@ -42,7 +44,7 @@ int flightDataModel::columnCount(const QModelIndex &parent) const
     if (parent.isValid()) {
         return 0;
     }
-    return 23;
+    return 24;
 }
 
 QVariant flightDataModel::data(const QModelIndex &index, int role) const
@@ -249,6 +251,11 @@ QVariant flightDataModel::getColumnByIndex(const pathPlanData *row, const int in
     case LOCKED:
         value = row->locked;
         break;
+    case ALTITUDEABOVEGROUND:
+        if (!qIsNaN(homeTerrainHeight) && !qIsNaN(row->terrainHeight)) {
+            value = row->altitudeRelative + homeTerrainHeight - row->terrainHeight;
+        }
+        break;
     }
     return value;
 }
@@ -331,6 +338,9 @@ QVariant flightDataModel::headerData(int section, Qt::Orientation orientation, i
             case LOCKED:
                 value = QString("Locked");
                 break;
+            case ALTITUDEABOVEGROUND:
+                value = QString("Altitude above ground");
+                break;
             default:
                 value = QString();
                 break;
@@ -351,14 +361,19 @@ bool flightDataModel::setData(const QModelIndex &index, const QVariant &value, i
             return false;
         }
         pathPlanData *myRow = dataStorage.at(rowIndex);
-        setColumnByIndex(myRow, columnIndex, value);
+        if (!setColumnByIndex(myRow, columnIndex, value)) {
+            return false;
+        }
         emit dataChanged(index, index);
     }
     return true;
 }
 
-Qt::ItemFlags flightDataModel::flags(const QModelIndex & /*index*/) const
+Qt::ItemFlags flightDataModel::flags(const QModelIndex &index) const
 {
+    if (index.column() == ALTITUDEABOVEGROUND) {
+        return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+    }
     return Qt::ItemIsSelectable | Qt::ItemIsEditable | Qt::ItemIsEnabled;
 }
 
@@ -391,6 +406,7 @@ bool flightDataModel::insertRows(int row, int count, const QModelIndex & /*paren
         data->jumpdestination     = 0;
         data->errordestination    = 0;
         data->locked = false;
+        data->terrainHeight       = qQNaN();
         if (rowCount() > 0) {
             data->altitude            = this->data(this->index(rowCount() - 1, ALTITUDE)).toDouble();
             data->altitudeRelative    = this->data(this->index(rowCount() - 1, ALTITUDERELATIVE)).toDouble();
@@ -604,6 +620,7 @@ void flightDataModel::readFromFile(QString fileName)
         if (e.tagName() == "waypoint") {
             QDomNode fieldNode = e.firstChild();
             data = new pathPlanData;
+            data->terrainHeight = qQNaN();
             while (!fieldNode.isNull()) {
                 QDomElement field = fieldNode.toElement();
                 if (field.tagName() == "field") {
@@ -668,3 +685,14 @@ void flightDataModel::readFromFile(QString fileName)
         node = node.nextSibling();
     }
 }
+
+void flightDataModel::setTerrainHeights(double home, const QVector<double> &waypoints)
+{
+    homeTerrainHeight = home;
+    for (int x = 0; x < dataStorage.length() && x < waypoints.size(); ++x) {
+        dataStorage.at(x)->terrainHeight = waypoints.at(x);
+    }
+    if (rowCount() > 0) {
+        emit dataChanged(index(0, ALTITUDEABOVEGROUND), index(rowCount() - 1, ALTITUDEABOVEGROUND));
+    }
+}
@@ -47,6 +47,7 @@ struct pathPlanData {
     int     jumpdestination;
     int     errordestination;
     bool    locked;
+    double  terrainHeight; // not saved, NaN until known
 };
 
 class flightDataModel : public QAbstractTableModel {
@@ -56,7 +57,7 @@ public:
         WPDESCRITPTION, LATPOSITION, LNGPOSITION, DISRELATIVE, BEARELATIVE, ALTITUDERELATIVE, ISRELATIVE, ALTITUDE,
         VELOCITY, MODE, MODE_PARAMS0, MODE_PARAMS1, MODE_PARAMS2, MODE_PARAMS3,
         CONDITION, CONDITION_PARAMS0, CONDITION_PARAMS1, CONDITION_PARAMS2, CONDITION_PARAMS3,
-        COMMAND, JUMPDESTINATION, ERRORDESTINATION, LOCKED
+        COMMAND, JUMPDESTINATION, ERRORDESTINATION, LOCKED, ALTITUDEABOVEGROUND
     };
     flightDataModel(QObject *parent);
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
@@ -70,8 +71,14 @@ public:
     bool removeRows(int row, int count, const QModelIndex & parent = QModelIndex());
     bool writeToFile(QString filename);
     void readFromFile(QString fileName);
+    /**
+     * @brief Terrain heights above mean sea level of home and of each waypoint,
+     *        ALTITUDEABOVEGROUND is the altitude above home corrected by them
+     */
+    void setTerrainHeights(double home, const QVector<double> &waypoints);
 private:
     QList<pathPlanData *> dataStorage;
+    double homeTerrainHeight;
     QVariant getColumnByIndex(const pathPlanData *row, const int index) const;
     bool setColumnByIndex(pathPlanData *row, const int index, const QVariant value);
 };
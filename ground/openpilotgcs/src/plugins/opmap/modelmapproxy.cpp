@@ -27,7 +27,8 @@
 
 #include "modelmapproxy.h"
 
-modelMapProxy::modelMapProxy(QObject *parent, OPMapWidget *map, flightDataModel *model, QItemSelectionModel *selectionModel) : QObject(parent), myMap(map), model(model), selection(selectionModel)
+modelMapProxy::modelMapProxy(QObject *parent, OPMapWidget *map, flightDataModel *model, QItemSelectionModel *selectionModel) : QObject(parent), myMap(map), model(model), selection(selectionModel),
+    terrainPending(false)
 {
     connect(model, SIGNAL(rowsInserted(const QModelIndex &, int, int)), this, SLOT(rowsInserted(const QModelIndex &, int, int)));
     connect(model, SIGNAL(rowsRemoved(const QModelIndex &, int, int)), this, SLOT(rowsRemoved(const QModelIndex &, int, int)));
@@ -35,6 +36,42 @@ modelMapProxy::modelMapProxy(QObject *parent, OPMapWidget *map, flightDataModel
     connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(dataChanged(QModelIndex, QModelIndex)));
     connect(myMap, SIGNAL(selectedWPChanged(QList<WayPointItem *>)), this, SLOT(selectedWPChanged(QList<WayPointItem *>)));
     connect(myMap, SIGNAL(WPValuesChanged(WayPointItem *)), this, SLOT(WPValuesChanged(WayPointItem *)));
+
+    terrainTimer.setSingleShot(true);
+    terrainTimer.setInterval(200);
+    connect(&terrainTimer, SIGNAL(timeout()), this, SLOT(refreshTerrain()));
+    connect(&terrainWatcher, SIGNAL(finished()), this, SLOT(terrainReady()));
+    connect(myMap->Home, SIGNAL(homePositionChanged(internals::PointLatLng, float)), &terrainTimer, SLOT(start()));
+}
+
+void modelMapProxy::refreshTerrain()
+{
+    // one query at a time, the plan is queried again once it is back
+    if (terrainWatcher.isRunning()) {
+        terrainPending = true;
+        return;
+    }
+    QVector<internals::PointLatLng> points;
+    points.append(myMap->Home->Coord());
+    for (int x = 0; x < model->rowCount(); ++x) {
+        points.append(internals::PointLatLng(model->index(x, flightDataModel::LATPOSITION).data().toDouble(),
+                                             model->index(x, flightDataModel::LNGPOSITION).data().toDouble()));
+    }
+    terrainWatcher.setFuture(OPMapWidget::TerrainHeights(points));
+}
+
+void modelMapProxy::terrainReady()
+{
+    QVector<double> heights = terrainWatcher.result();
+
+    // waypoints added or removed meanwhile, a new query is pending
+    if (heights.size() == model->rowCount() + 1) {
+        model->setTerrainHeights(heights.first(), heights.mid(1));
+    }
+    if (terrainPending) {
+        terrainPending = false;
+        refreshTerrain();
+    }
 }
 
 void modelMapProxy::WPValuesChanged(WayPointItem *wp)
@@ -208,11 +245,14 @@ void modelMapProxy::rowsRemoved(const QModelIndex &parent, int first, int last)
         myMap->WPDelete(x);
     }
     refreshOverlays();
+    terrainTimer.start();
 }
 
 void modelMapProxy::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
 {
-    Q_UNUSED(bottomRight);
+    if (topLeft.column() != flightDataModel::ALTITUDEABOVEGROUND) {
+        terrainTimer.start();
+    }
 
     WayPointItem *item = findWayPointNumber(topLeft.row());
     if (!item) {
@@ -286,6 +326,17 @@ void modelMapProxy::dataChanged(const QModelIndex &topLeft, const QModelIndex &b
         index = model->index(x, flightDataModel::LOCKED);
         item->setFlag(QGraphicsItem::ItemIsMovable, !index.data(Qt::DisplayRole).toBool());
         break;
+    case flightDataModel::ALTITUDEABOVEGROUND:
+        for (; x <= bottomRight.row(); ++x) {
+            item  = findWayPointNumber(x);
+            index = model->index(x, flightDataModel::ALTITUDEABOVEGROUND);
+            if (item) {
+                item->setCustomString(index.data(Qt::DisplayRole).isValid() ?
+                                      tr("Above ground: %1 m").arg(index.data(Qt::DisplayRole).toDouble(), 0, 'f', 0) : QString());
+                item->RefreshToolTip();
+            }
+        }
+        break;
     }
 }
 
@@ -325,6 +376,7 @@ void modelMapProxy::rowsInserted(const QModelIndex &parent, int first, int last)
     }
 
     refreshOverlays();
+    terrainTimer.start();
 }
 void modelMapProxy::deleteWayPoint(int number)
 {
@@ -34,6 +34,8 @@
 #include "QPointer"
 #include "flightdatamodel.h"
 #include <QItemSelectionModel>
+#include <QFutureWatcher>
+#include <QTimer>
 #include <widgetdelegates.h>
 
 
@@ -54,6 +56,8 @@ private slots:
     void WPValuesChanged(WayPointItem *wp);
     void currentRowChanged(QModelIndex, QModelIndex);
     void selectedWPChanged(QList<WayPointItem *>);
+    void refreshTerrain();
+    void terrainReady();
 private:
     overlayType overlayTranslate(int type);
     void createOverlay(WayPointItem *from, WayPointItem *to, overlayType type, QColor color, bool dashed = false, int width = -1);
@@ -62,6 +66,10 @@ private:
     flightDataModel *model;
     void refreshOverlays();
     QItemSelectionModel *selection;
+    // terrain under home and the waypoints, queried a moment after the plan stops changing
+    QTimer terrainTimer;
+    QFutureWatcher<QVector<double> > terrainWatcher;
+    bool terrainPending;
 };
 
 #endif // MODELMAPPROXY_H
@@ -50,41 +50,42 @@ void ModelUavoProxy::sendPathPlan()
     const int waypointCount = pathPlan->getWaypointCount();
     const int actionCount   = pathPlan->getPathActionCount();
 
-    QProgressDialog progress(tr("Sending the path plan to the board... "), "", 0, 1 + waypointCount + actionCount);
+    QProgressDialog progress(tr("Sending the path plan to the board... "), "", 0, waypointCount + actionCount + 1);
     progress.setWindowModality(Qt::WindowModal);
     progress.setCancelButton(NULL);
     progress.show();
 
-    UAVObjectUpdaterHelper updateHelper;
+    // send Waypoint and PathAction instances, several at a time
+    QList<UAVObject *> objects;
+    for (int i = 0; i < waypointCount; ++i) {
+        objects << Waypoint::GetInstance(objMngr, i);
+    }
+    for (int i = 0; i < actionCount; ++i) {
+        objects << PathAction::GetInstance(objMngr, i);
+    }
+    qDebug() << "sending" << waypointCount << "waypoints and" << actionCount << "path actions";
 
-    // send PathPlan
-    bool success = (updateHelper.doObjectAndWait(pathPlan) == UAVObjectUpdaterHelper::SUCCESS);
-    progress.setValue(1);
+    UAVObjectBatchUpdaterHelper batchHelper;
+    connect(&batchHelper, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+    QList<UAVObject *> failed;
+    batchHelper.doObjectsAndWait(objects, failed);
 
-    if (success) {
-        // send Waypoint instances
-        qDebug() << "sending" << waypointCount << "waypoints";
-        for (int i = 0; i < waypointCount; ++i) {
-            Waypoint *waypoint = Waypoint::GetInstance(objMngr, i);
-            success = (updateHelper.doObjectAndWait(waypoint) == UAVObjectUpdaterHelper::SUCCESS);
-            if (!success) {
-                break;
-            }
-            progress.setValue(progress.value() + 1);
+    // resend only what did not make it, one at a time
+    UAVObjectUpdaterHelper updateHelper;
+    bool success = true;
+    foreach(UAVObject * object, failed) {
+        qDebug() << "resending" << object->toStringBrief();
+        success = (updateHelper.doObjectAndWait(object) == UAVObjectUpdaterHelper::SUCCESS);
+        if (!success) {
+            break;
         }
+        progress.setValue(progress.value() + 1);
     }
 
+    // send PathPlan last, the board only accepts the plan once its CRC matches the instances
     if (success) {
-        // send PathAction instances
-        qDebug() << "sending" << actionCount << "path actions";
-        for (int i = 0; i < actionCount; ++i) {
-            PathAction *action = PathAction::GetInstance(objMngr, i);
-            success = (updateHelper.doObjectAndWait(action) == UAVObjectUpdaterHelper::SUCCESS);
-            if (!success) {
-                break;
-            }
-            progress.setValue(progress.value() + 1);
-        }
+        success = (updateHelper.doObjectAndWait(pathPlan) == UAVObjectUpdaterHelper::SUCCESS);
+        progress.setValue(progress.maximum());
     }
 
     qDebug() << "ModelUavoProxy::pathPlanSent - completed" << success;
@@ -111,8 +112,8 @@ void ModelUavoProxy::receivePathPlan()
     const int waypointCount = pathPlan->getWaypointCount();
     const int actionCount   = pathPlan->getPathActionCount();
 
-    progress.setMaximum(1 + waypointCount + actionCount);
-    progress.setValue(1);
+    progress.setMaximum(waypointCount + actionCount);
+    progress.setValue(0);
 
     if (success && (waypointCount > objMngr->getNumInstances(Waypoint::OBJID))) {
         // allocate needed Waypoint instances
@@ -120,19 +121,6 @@ void ModelUavoProxy::receivePathPlan()
         waypoint->initialize(waypointCount - 1, waypoint->getMetaObject());
         success = objMngr->registerObject(waypoint);
     }
-    if (success) {
-        // request Waypoint instances
-        qDebug() << "requesting" << waypointCount << "waypoints";
-        for (int i = 0; i < waypointCount; ++i) {
-            Waypoint *waypoint = Waypoint::GetInstance(objMngr, i);
-            success = (requestHelper.doObjectAndWait(waypoint) == UAVObjectRequestHelper::SUCCESS);
-            if (!success) {
-                break;
-            }
-            progress.setValue(progress.value() + 1);
-        }
-    }
-
     if (success && (actionCount > objMngr->getNumInstances(PathAction::OBJID))) {
         // allocate needed PathAction instances
         PathAction *action = new PathAction;
@@ -140,11 +128,24 @@ void ModelUavoProxy::receivePathPlan()
         success = objMngr->registerObject(action);
     }
     if (success) {
-        // request PathAction isntances
-        qDebug() << "requesting" << actionCount << "path actions";
+        // request Waypoint and PathAction instances, several at a time
+        QList<UAVObject *> objects;
+        for (int i = 0; i < waypointCount; ++i) {
+            objects << Waypoint::GetInstance(objMngr, i);
+        }
         for (int i = 0; i < actionCount; ++i) {
-            PathAction *action = PathAction::GetInstance(objMngr, i);
-            success = (requestHelper.doObjectAndWait(action) == UAVObjectRequestHelper::SUCCESS);
+            objects << PathAction::GetInstance(objMngr, i);
+        }
+        qDebug() << "requesting" << waypointCount << "waypoints and" << actionCount << "path actions";
+
+        UAVObjectBatchRequestHelper batchHelper;
+        connect(&batchHelper, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+        QList<UAVObject *> failed;
+        batchHelper.doObjectsAndWait(objects, failed);
+
+        // request again only what did not arrive
+        foreach(UAVObject * object, failed) {
+            success = (requestHelper.doObjectAndWait(object) == UAVObjectRequestHelper::SUCCESS);
             if (!success) {
                 break;
             }
@@ -152,6 +153,12 @@ void ModelUavoProxy::receivePathPlan()
         }
     }
 
+    // the received instances must match the CRC of the received PathPlan
+    if (success && (computePathPlanCrc(waypointCount, actionCount) != pathPlan->getCrc())) {
+        qWarning() << "ModelUavoProxy::pathPlanReceived - CRC mismatch";
+        success = false;
+    }
+
     qDebug() << "ModelUavoProxy::pathPlanReceived - completed" << success;
     if (success) {
         objectsToModel();
@@ -76,10 +76,13 @@ opmap_edit_waypoint_dialog::opmap_edit_waypoint_dialog(QWidget *parent, QAbstrac
     mapper->addMapping(ui->sbJump, flightDataModel::JUMPDESTINATION);
     mapper->addMapping(ui->sbError, flightDataModel::ERRORDESTINATION);
     connect(itemSelection, SIGNAL(currentRowChanged(QModelIndex, QModelIndex)), this, SLOT(currentRowChanged(QModelIndex, QModelIndex)));
+    connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(refreshAboveGround()));
+    connect(ui->doubleSpinBoxRelativeAltitude, SIGNAL(valueChanged(double)), this, SLOT(refreshAboveGround()));
 }
 void opmap_edit_waypoint_dialog::currentIndexChanged(int index)
 {
     ui->lbNumber->setText(QString::number(index + 1));
+    refreshAboveGround();
     QModelIndex idx = mapper->model()->index(index, 0);
     if (index == itemSelection->currentIndex().row()) {
         return;
@@ -320,3 +323,17 @@ void opmap_edit_waypoint_dialog::currentRowChanged(QModelIndex current, QModelIn
 
     mapper->setCurrentIndex(current.row());
 }
+
+void opmap_edit_waypoint_dialog::refreshAboveGround()
+{
+    int row = mapper->currentIndex();
+    QVariant aboveGround = model->index(row, flightDataModel::ALTITUDEABOVEGROUND).data(Qt::DisplayRole);
+
+    if (!aboveGround.isValid()) {
+        ui->lbAboveGround->setText(tr("unknown"));
+        return;
+    }
+    // the relative altitude being typed is not in the model yet
+    double pending = ui->doubleSpinBoxRelativeAltitude->value() - model->index(row, flightDataModel::ALTITUDERELATIVE).data(Qt::DisplayRole).toDouble();
+    ui->lbAboveGround->setText(QString::number(aboveGround.toDouble() + pending, 'f', 1));
+}
@@ -67,6 +67,7 @@ private slots:
     void on_pushButton_2_clicked();
     void enableEditWidgets(bool);
     void currentRowChanged(QModelIndex, QModelIndex);
+    void refreshAboveGround();
 };
 
 #endif // OPMAP_EDIT_WAYPOINT_DIALOG_H
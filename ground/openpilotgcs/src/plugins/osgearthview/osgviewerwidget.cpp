@@ -38,6 +38,7 @@
 #include <QtCore/QTimer>
 #include <QtWidgets/QApplication>
 #include <QGridLayout>
+#include <QDir>
 
 
 #include <osg/Notify>
@@ -92,6 +93,7 @@ using namespace osgEarth::Annotation;
 #include <iostream>
 
 #include "utils/stylehelper.h"
+#include "utils/pathutils.h"
 #include "utils/homelocationutil.h"
 #include "utils/worldmagmodel.h"
 #include "utils/coordinateconversions.h"
@@ -113,6 +115,11 @@ OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent)
     mapNode = osgEarth::MapNode::findMapNode(earth);
     if (!mapNode) {
         qDebug() << "Uhoh";
+    } else if (!mapNode->getMap()->getCache()) {
+        // tiles are kept next to the opmap cache
+        FileSystemCacheOptions cacheOptions;
+        cacheOptions.rootPath() = (PathUtils().GetStoragePath() + "mapscache" + QDir::separator() + "osgearth").toStdString();
+        mapNode->getMap()->setCache(osgEarth::CacheFactory::create(cacheOptions));
     }
 
     root->addChild(earth);
@@ -153,6 +160,7 @@ QWidget *OsgViewerWidget::createViewWidget(osg::Camera *camera, osg::Node *scene
     view->setSceneData(scene);
     view->addEventHandler(new osgViewer::StatsHandler);
     view->getDatabasePager()->setDoPreCompile(true);
+    view->getDatabasePager()->setUpThreads(4, 1);
 
     manip = new EarthManipulator();
     view->setCameraManipulator(manip);
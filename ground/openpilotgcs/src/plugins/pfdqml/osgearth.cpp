@@ -18,6 +18,8 @@
 
 #include <QtCore/qfileinfo.h>
 #include <QtCore/qthread.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qdir.h>
 #include <QtDeclarative/qdeclarative.h>
 #include <QtDeclarative/qdeclarativeview.h>
 #include <QtDeclarative/qdeclarativeengine.h>
@@ -36,6 +38,9 @@
 #include <osgEarthUtil/EarthManipulator>
 #include <osgEarthUtil/ObjectPlacer>
 #include <osgEarth/Map>
+#include <osgEarth/MapNode>
+#include <osgEarth/Cache>
+#include <osgEarthDrivers/cache_filesystem/FileSystemCache>
 
 #include <QtCore/qtimer.h>
 
@@ -53,7 +58,12 @@ OsgEarthItem::OsgEarthItem(QDeclarativeItem *parent) :
     m_longitude(153.0),
     m_altitude(400.0),
     m_fieldOfView(90.0),
-    m_sceneFile(QLatin1String("/usr/share/osgearth/maps/srtm.earth"))
+    m_sceneFile(QLatin1String("/usr/share/osgearth/maps/srtm.earth")),
+    m_lodScale(1.0),
+    m_pagerThreads(2),
+    // next to the opmap tiles so the caches are cleared together
+    m_cachePath(Utils::PathUtils().GetStoragePath() + "mapscache" + QDir::separator() + "osgearth"),
+    m_frameTime(0.0)
 {
     setSize(m_currentSize);
     setFlag(ItemHasNoContents, false);
@@ -125,6 +135,8 @@ void OsgEarthItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *styl
         m_renderer = new OsgEarthItemRenderer(this, glWidget);
         connect(m_renderer, SIGNAL(frameReady()),
                 this, SLOT(updateView()), Qt::QueuedConnection);
+        connect(m_renderer, SIGNAL(frameTime(qreal)),
+                this, SLOT(setFrameTime(qreal)), Qt::QueuedConnection);
 
         m_rendererThread = new QThread(this);
         m_renderer->moveToThread(m_rendererThread);
@@ -233,6 +245,38 @@ void OsgEarthItem::setSceneFile(QString arg)
     }
 }
 
+void OsgEarthItem::setLodScale(qreal arg)
+{
+    if (!qFuzzyCompare(m_lodScale, arg)) {
+        m_lodScale = arg;
+        emit lodScaleChanged(arg);
+    }
+}
+
+void OsgEarthItem::setPagerThreads(int arg)
+{
+    if (m_pagerThreads != arg) {
+        m_pagerThreads = arg;
+        emit pagerThreadsChanged(arg);
+    }
+}
+
+void OsgEarthItem::setCachePath(QString arg)
+{
+    if (m_cachePath != arg) {
+        m_cachePath = arg;
+        emit cachePathChanged(arg);
+    }
+}
+
+void OsgEarthItem::setFrameTime(qreal arg)
+{
+    if (!qFuzzyCompare(m_frameTime, arg)) {
+        m_frameTime = arg;
+        emit frameTimeChanged(arg);
+    }
+}
+
 OsgEarthItemRenderer::OsgEarthItemRenderer(OsgEarthItem *item, QGLWidget *glWidget) :
     QObject(0),
     m_item(item),
@@ -284,6 +328,11 @@ void OsgEarthItemRenderer::initScene()
     osgEarth::MapNode *mapNode = osgEarth::MapNode::findMapNode(m_model.get());
     if (!mapNode) {
         qWarning() << Q_FUNC_INFO << sceneFile << " doesn't look like an osgEarth file";
+    } else if (!m_item->cachePath().isEmpty() && !mapNode->getMap()->getCache()) {
+        // keep the earth file's own cache if it has one
+        osgEarth::Drivers::FileSystemCacheOptions cacheOptions;
+        cacheOptions.rootPath() = m_item->cachePath().toStdString();
+        mapNode->getMap()->setCache(osgEarth::CacheFactory::create(cacheOptions));
     }
 
     m_gw     = new osgViewer::GraphicsWindowEmbedded(0, 0, w, h);
@@ -292,6 +341,8 @@ void OsgEarthItemRenderer::initScene()
     m_viewer->setThreadingModel(osgViewer::Viewer::SingleThreaded);
     m_viewer->setSceneData(m_model);
     m_viewer->getDatabasePager()->setDoPreCompile(true);
+    // tiles are fetched and built off the render thread, one of the threads serves http only
+    m_viewer->getDatabasePager()->setUpThreads(qMax(2, m_item->pagerThreads()), 1);
 
     osg::Camera *camera = m_viewer->getCamera();
     camera->setViewport(new osg::Viewport(0, 0, w, h));
@@ -301,6 +352,8 @@ void OsgEarthItemRenderer::initScene()
     // configure the near/far so we don't clip things that are up close
     camera->setNearFarRatio(0.00002);
     camera->setProjectionMatrixAsPerspective(m_item->fieldOfView(), qreal(w) / h, 1.0f, 10000.0f);
+    // larger than 1 selects coarser tiles
+    camera->setLODScale(m_item->lodScale());
 
     updateFrame();
 }
@@ -365,7 +418,10 @@ void OsgEarthItemRenderer::updateFrame()
         QGLFramebufferObject *fbo = m_fbo[(m_lastFboNumber + 1) % FboCount];
         QPainter fboPainter(fbo);
         fboPainter.beginNativePainting();
+        QElapsedTimer frameTimer;
+        frameTimer.start();
         m_viewer->frame();
+        emit frameTime(frameTimer.nsecsElapsed() / 1.0e6);
         fboPainter.endNativePainting();
     }
     m_glWidget.data()->doneCurrent();
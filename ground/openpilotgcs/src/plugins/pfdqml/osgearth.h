@@ -40,6 +40,14 @@ class OsgEarthItem : public QDeclarativeItem {
     Q_PROPERTY(double longitude READ longitude WRITE setLongitude NOTIFY longitudeChanged)
     Q_PROPERTY(double altitude READ altitude WRITE setAltitude NOTIFY altitudeChanged)
 
+    // Terrain paging, read when the scene is loaded
+    Q_PROPERTY(qreal lodScale READ lodScale WRITE setLodScale NOTIFY lodScaleChanged)
+    Q_PROPERTY(int pagerThreads READ pagerThreads WRITE setPagerThreads NOTIFY pagerThreadsChanged)
+    Q_PROPERTY(QString cachePath READ cachePath WRITE setCachePath NOTIFY cachePathChanged)
+
+    // Time spent in the last osg frame in ms, for a frame time overlay
+    Q_PROPERTY(qreal frameTime READ frameTime NOTIFY frameTimeChanged)
+
 public:
     OsgEarthItem(QDeclarativeItem *parent = 0);
     ~OsgEarthItem();
@@ -80,6 +88,23 @@ public:
         return m_altitude;
     }
 
+    qreal lodScale() const
+    {
+        return m_lodScale;
+    }
+    int pagerThreads() const
+    {
+        return m_pagerThreads;
+    }
+    QString cachePath() const
+    {
+        return m_cachePath;
+    }
+    qreal frameTime() const
+    {
+        return m_frameTime;
+    }
+
 protected:
     void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry);
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *style, QWidget *widget);
@@ -97,6 +122,10 @@ public slots:
     void setLongitude(double arg);
     void setAltitude(double arg);
 
+    void setLodScale(qreal arg);
+    void setPagerThreads(int arg);
+    void setCachePath(QString arg);
+
 signals:
     void rollChanged(qreal arg);
     void pitchChanged(qreal arg);
@@ -109,8 +138,14 @@ signals:
     void sceneFileChanged(QString arg);
     void fieldOfViewChanged(qreal arg);
 
+    void lodScaleChanged(qreal arg);
+    void pagerThreadsChanged(int arg);
+    void cachePathChanged(QString arg);
+    void frameTimeChanged(qreal arg);
+
 private slots:
     void updateFrame();
+    void setFrameTime(qreal arg);
 
 private:
     OsgEarthItemRenderer *m_renderer;
@@ -128,6 +163,11 @@ private:
 
     qreal m_fieldOfView;
     QString m_sceneFile;
+
+    qreal m_lodScale;
+    int m_pagerThreads;
+    QString m_cachePath;
+    qreal m_frameTime;
 };
 
 class OsgEarthItemRenderer : public QObject {
@@ -148,6 +188,7 @@ public slots:
 
 signals:
     void frameReady();
+    void frameTime(qreal ms);
 
 private:
     enum { FboCount = 3 };
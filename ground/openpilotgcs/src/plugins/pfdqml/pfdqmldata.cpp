@@ -0,0 +1,116 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pfdqmldata.h"
+#include "uavobjectmanager.h"
+#include "attitudestate.h"
+#include "positionstate.h"
+#include "velocitystate.h"
+#include "airspeedstate.h"
+#include "gcstelemetrystats.h"
+#include <QQuickWindow>
+#include <QDateTime>
+#include <QtCore/qmath.h>
+
+// The position is not extrapolated further, the link is lost anyway
+#define MAX_EXTRAPOLATION_MS 1000.0
+
+PfdQmlData::PfdQmlData(UAVObjectManager *objManager, QQuickWindow *window) :
+    QObject(window),
+    m_objManager(objManager),
+    m_window(window),
+    m_dirty(true),
+    m_data()
+{
+    QList<UAVObject *> objects;
+    objects << AttitudeState::GetInstance(m_objManager) <<
+        PositionState::GetInstance(m_objManager) <<
+        VelocityState::GetInstance(m_objManager) <<
+        AirspeedState::GetInstance(m_objManager) <<
+        GCSTelemetryStats::GetInstance(m_objManager);
+    foreach(UAVObject * obj, objects) {
+        if (obj) {
+            connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)));
+        }
+    }
+
+    // GUI thread, after the animations and before the scene graph is synchronised
+    connect(m_window, SIGNAL(afterAnimating()), this, SLOT(sample()));
+}
+
+void PfdQmlData::objectUpdated(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+
+    if (!m_dirty) {
+        m_dirty = true;
+        // The view only renders frames on request
+        m_window->update();
+    }
+}
+
+void PfdQmlData::sample()
+{
+    if (!m_dirty) {
+        return;
+    }
+    m_dirty = false;
+
+    AttitudeState *attitudeState = AttitudeState::GetInstance(m_objManager);
+    if (attitudeState) {
+        AttitudeState::DataFields attitude = attitudeState->getData();
+        m_data.roll  = attitude.Roll;
+        m_data.pitch = attitude.Pitch;
+        m_data.yaw   = attitude.Yaw;
+    }
+    PositionState *positionState = PositionState::GetInstance(m_objManager);
+    if (positionState) {
+        PositionState::DataFields position = positionState->getData();
+        m_data.north = position.North;
+        m_data.east  = position.East;
+        m_data.down  = position.Down;
+    }
+    VelocityState *velocityState = VelocityState::GetInstance(m_objManager);
+    if (velocityState) {
+        VelocityState::DataFields velocity = velocityState->getData();
+        m_data.velocityNorth = velocity.North;
+        m_data.velocityEast  = velocity.East;
+        m_data.velocityDown  = velocity.Down;
+        m_data.groundSpeed   = qSqrt(velocity.North * velocity.North + velocity.East * velocity.East);
+    }
+    AirspeedState *airspeedState = AirspeedState::GetInstance(m_objManager);
+    if (airspeedState) {
+        AirspeedState::DataFields airspeed = airspeedState->getData();
+        m_data.calibratedAirspeed = airspeed.CalibratedAirspeed;
+        m_data.trueAirspeed = airspeed.TrueAirspeed;
+    }
+
+    GCSTelemetryStats *gcsStats = GCSTelemetryStats::GetInstance(m_objManager);
+    if (positionState) {
+        double latency = 0;
+        if (positionState->hasVehicleTime()) {
+            latency = QDateTime::currentMSecsSinceEpoch() - positionState->getVehicleSampleTime();
+        } else if (gcsStats) {
+            latency = gcsStats->getData().Latency;
+        }
+        m_data.latency = qBound(0.0, latency, MAX_EXTRAPOLATION_MS);
+        m_data.north  += m_data.velocityNorth * m_data.latency / 1000;
+        m_data.east   += m_data.velocityEast * m_data.latency / 1000;
+        m_data.down   += m_data.velocityDown * m_data.latency / 1000;
+    }
+
+    emit updated();
+}
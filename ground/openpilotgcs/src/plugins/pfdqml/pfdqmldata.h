@@ -0,0 +1,140 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PFDQMLDATA_H_
+#define PFDQMLDATA_H_
+
+#include <QObject>
+
+class UAVObject;
+class UAVObjectManager;
+class QQuickWindow;
+
+/**
+ * Snapshot of the fast changing objects shown by the PFD.
+ *
+ * The objects are sampled at most once per frame, just before the scene is
+ * synchronised, and all properties notify through the single updated()
+ * signal. A binding on several of them is reevaluated once per frame
+ * instead of once for every field of every object update.
+ *
+ * The position is carried forward with the velocity over the age of the
+ * sample: from its board time when the update was timestamped, otherwise
+ * the link latency measured by the telemetry (GCSTelemetryStats).
+ */
+class PfdQmlData : public QObject {
+    Q_OBJECT Q_PROPERTY(double roll READ roll NOTIFY updated)
+    Q_PROPERTY(double pitch READ pitch NOTIFY updated)
+    Q_PROPERTY(double yaw READ yaw NOTIFY updated)
+    Q_PROPERTY(double north READ north NOTIFY updated)
+    Q_PROPERTY(double east READ east NOTIFY updated)
+    Q_PROPERTY(double down READ down NOTIFY updated)
+    Q_PROPERTY(double velocityNorth READ velocityNorth NOTIFY updated)
+    Q_PROPERTY(double velocityEast READ velocityEast NOTIFY updated)
+    Q_PROPERTY(double velocityDown READ velocityDown NOTIFY updated)
+    Q_PROPERTY(double groundSpeed READ groundSpeed NOTIFY updated)
+    Q_PROPERTY(double calibratedAirspeed READ calibratedAirspeed NOTIFY updated)
+    Q_PROPERTY(double trueAirspeed READ trueAirspeed NOTIFY updated)
+    Q_PROPERTY(double latency READ latency NOTIFY updated)
+
+public:
+    PfdQmlData(UAVObjectManager *objManager, QQuickWindow *window);
+
+    double roll() const
+    {
+        return m_data.roll;
+    }
+    double pitch() const
+    {
+        return m_data.pitch;
+    }
+    double yaw() const
+    {
+        return m_data.yaw;
+    }
+    double north() const
+    {
+        return m_data.north;
+    }
+    double east() const
+    {
+        return m_data.east;
+    }
+    double down() const
+    {
+        return m_data.down;
+    }
+    double velocityNorth() const
+    {
+        return m_data.velocityNorth;
+    }
+    double velocityEast() const
+    {
+        return m_data.velocityEast;
+    }
+    double velocityDown() const
+    {
+        return m_data.velocityDown;
+    }
+    double groundSpeed() const
+    {
+        return m_data.groundSpeed;
+    }
+    double calibratedAirspeed() const
+    {
+        return m_data.calibratedAirspeed;
+    }
+    double trueAirspeed() const
+    {
+        return m_data.trueAirspeed;
+    }
+    // Age of the position shown, ms
+    double latency() const
+    {
+        return m_data.latency;
+    }
+
+signals:
+    void updated();
+
+private slots:
+    void objectUpdated(UAVObject *obj);
+    void sample();
+
+private:
+    typedef struct {
+        float roll;
+        float pitch;
+        float yaw;
+        float north;
+        float east;
+        float down;
+        float velocityNorth;
+        float velocityEast;
+        float velocityDown;
+        float groundSpeed;
+        float calibratedAirspeed;
+        float trueAirspeed;
+        float latency;
+    } Snapshot;
+
+    UAVObjectManager *m_objManager;
+    QQuickWindow *m_window;
+    bool m_dirty;
+    Snapshot m_data;
+};
+
+#endif /* PFDQMLDATA_H_ */
@@ -15,6 +15,7 @@
  */
 
 #include "pfdqmlgadgetwidget.h"
+#include "pfdqmldata.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include "uavobject.h"
@@ -92,6 +93,9 @@ PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent) :
         }
     }
 
+    // Batched attitude, position and speed for the instruments
+    engine()->rootContext()->setContextProperty("pfdData", new PfdQmlData(objManager, this));
+
     // to expose settings values
     engine()->rootContext()->setContextProperty("qmlWidget", this);
 #ifdef USE_OSG
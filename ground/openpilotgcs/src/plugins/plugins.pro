@@ -102,6 +102,7 @@ plugin_uploader.depends += plugin_uavobjects
 plugin_uploader.depends += plugin_uavobjectutil
 plugin_uploader.depends += plugin_uavtalk
 plugin_uploader.depends += plugin_opHID
+plugin_uploader.depends += plugin_uavsettingsimportexport
 SUBDIRS += plugin_uploader
 
 # Dial gadget
@@ -123,6 +124,13 @@ plugin_systemhealth.depends += plugin_uavobjects
 plugin_systemhealth.depends += plugin_uavtalk
 SUBDIRS += plugin_systemhealth
 
+# Profiler gadget
+plugin_profiler.subdir = profiler
+plugin_profiler.depends = plugin_coreplugin
+plugin_profiler.depends += plugin_uavobjects
+plugin_profiler.depends += plugin_uavtalk
+SUBDIRS += plugin_profiler
+
 # Config gadget
 plugin_config.subdir = config
 plugin_config.depends = plugin_coreplugin
@@ -186,6 +194,7 @@ SUBDIRS += plugin_logging
 plugin_gcscontrol.subdir = gcscontrol
 plugin_gcscontrol.depends = plugin_coreplugin
 plugin_gcscontrol.depends += plugin_uavobjects
+plugin_gcscontrol.depends += plugin_uavtalk
 SUBDIRS += plugin_gcscontrol
 
 # Antenna tracker
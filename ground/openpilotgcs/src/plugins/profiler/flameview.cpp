@@ -0,0 +1,130 @@
+/**
+ ******************************************************************************
+ *
+ * @file       flameview.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ProfilerGadgetPlugin Profiler Gadget Plugin
+ * @{
+ * @brief Aggregates the flight PerfCounter, TaskInfo and CallbackInfo objects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "flameview.h"
+#include "profilerdata.h"
+
+#include <QHash>
+#include <QPainter>
+#include <QHelpEvent>
+#include <QToolTip>
+
+FlameView::FlameView(ProfilerData *data, QWidget *parent) : QWidget(parent),
+    m_data(data)
+{
+    setMinimumHeight(3 * ROW_HEIGHT);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Preferred);
+    connect(m_data, SIGNAL(tasksUpdated()), this, SLOT(update()));
+    connect(m_data, SIGNAL(callbacksUpdated()), this, SLOT(update()));
+}
+
+QSize FlameView::sizeHint() const
+{
+    return QSize(400, 3 * ROW_HEIGHT);
+}
+
+void FlameView::addBlock(QList<Block> &blocks, int level, double start, double cpu, const QString &name) const
+{
+    if (cpu <= 0.0) {
+        return;
+    }
+    Block block;
+    block.rect = QRectF(start * width() / 100.0, level * ROW_HEIGHT, cpu * width() / 100.0, ROW_HEIGHT);
+    block.name = name;
+    block.cpu  = cpu;
+    blocks << block;
+}
+
+QList<FlameView::Block> FlameView::layout() const
+{
+    QList<Block> blocks;
+    double start = 0.0;
+    double schedulerStart = -1.0;
+    double schedulerCpu   = 0.0;
+
+    foreach(const ProfilerData::TaskStats &task, m_data->tasks()) {
+        if (task.name.startsWith("CallbackScheduler")) {
+            // the scheduler tasks are next to each other
+            schedulerStart = schedulerStart < 0.0 ? start : schedulerStart;
+            schedulerCpu  += task.cpuAverage;
+        }
+        addBlock(blocks, 1, start, task.cpuAverage, task.name);
+        start += task.cpuAverage;
+    }
+    double load = qMax(m_data->cpuLoad(), start);
+    addBlock(blocks, 0, 0.0, load, tr("CPU"));
+    addBlock(blocks, 1, start, m_data->cpuLoad() - start, tr("Other"));
+
+    // callbacks are not tied to a scheduler task, scale them into all of them
+    double callbacksCpu = 0.0;
+    foreach(const ProfilerData::CallbackStats &callback, m_data->callbacks()) {
+        callbacksCpu += callback.cpu;
+    }
+    if (schedulerStart >= 0.0 && callbacksCpu > 0.0) {
+        double scale = schedulerCpu > 0.0 ? qMin(1.0, schedulerCpu / callbacksCpu) : 1.0;
+        start = schedulerStart;
+        foreach(const ProfilerData::CallbackStats &callback, m_data->callbacks()) {
+            addBlock(blocks, 2, start, callback.cpu * scale, callback.name);
+            start += callback.cpu * scale;
+        }
+    }
+    return blocks;
+}
+
+void FlameView::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+    QPainter painter(this);
+
+    painter.fillRect(rect(), palette().base());
+    foreach(const Block &block, layout()) {
+        // stable warm colour per name, like flame graphs
+        uint hash = qHash(block.name);
+        QColor color = QColor::fromHsv(hash % 50, 120 + hash % 100, 230);
+        painter.fillRect(block.rect.adjusted(0, 0, -1, -1), color);
+        if (block.rect.width() > painter.fontMetrics().width(block.name) + 4) {
+            painter.setPen(Qt::black);
+            painter.drawText(block.rect.adjusted(2, 0, -2, 0), Qt::AlignLeft | Qt::AlignVCenter, block.name);
+        }
+    }
+}
+
+bool FlameView::event(QEvent *event)
+{
+    if (event->type() == QEvent::ToolTip) {
+        QHelpEvent *helpEvent = static_cast<QHelpEvent *>(event);
+        foreach(const Block &block, layout()) {
+            if (block.rect.contains(helpEvent->pos())) {
+                QToolTip::showText(helpEvent->globalPos(), QString("%1: %2%").arg(block.name).arg(block.cpu, 0, 'f', 1));
+                return true;
+            }
+        }
+        QToolTip::hideText();
+        event->ignore();
+        return true;
+    }
+    return QWidget::event(event);
+}
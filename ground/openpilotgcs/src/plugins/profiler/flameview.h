@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ *
+ * @file       flameview.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ProfilerGadgetPlugin Profiler Gadget Plugin
+ * @{
+ * @brief Aggregates the flight PerfCounter, TaskInfo and CallbackInfo objects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef FLAMEVIEW_H_
+#define FLAMEVIEW_H_
+
+#include <QWidget>
+#include <QList>
+#include <QRectF>
+
+class ProfilerData;
+
+/**
+ * Icicle style view of where the CPU time goes: the whole CPU on top,
+ * the tasks below it and the callbacks below the callback scheduler tasks
+ * running them. Widths are proportional to the CPU share.
+ */
+class FlameView : public QWidget {
+    Q_OBJECT
+
+public:
+    FlameView(ProfilerData *data, QWidget *parent = 0);
+
+    QSize sizeHint() const;
+
+protected:
+    void paintEvent(QPaintEvent *event);
+    bool event(QEvent *event);
+
+private:
+    struct Block {
+        QRectF  rect;
+        QString name;
+        double  cpu;
+    };
+
+    void addBlock(QList<Block> &blocks, int level, double start, double cpu, const QString &name) const;
+    QList<Block> layout() const;
+
+    ProfilerData *m_data;
+    static const int ROW_HEIGHT = 22;
+};
+
+#endif // FLAMEVIEW_H_
@@ -0,0 +1,20 @@
+TEMPLATE = lib
+TARGET = ProfilerGadget
+
+include(../../openpilotgcsplugin.pri)
+include(profiler_dependencies.pri)
+
+HEADERS += profilerplugin.h
+HEADERS += profilergadget.h
+HEADERS += profilergadgetfactory.h
+HEADERS += profilergadgetwidget.h
+HEADERS += profilerdata.h
+HEADERS += flameview.h
+SOURCES += profilerplugin.cpp
+SOURCES += profilergadget.cpp
+SOURCES += profilergadgetfactory.cpp
+SOURCES += profilergadgetwidget.cpp
+SOURCES += profilerdata.cpp
+SOURCES += flameview.cpp
+
+OTHER_FILES += ProfilerGadget.pluginspec
@@ -0,0 +1,4 @@
+include(../../plugins/uavobjects/uavobjects.pri)
+include(../../plugins/coreplugin/coreplugin.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
+include(../../libs/qwt/qwt.pri)
@@ -0,0 +1,271 @@
+/**
+ ******************************************************************************
+ *
+ * @file       profilerdata.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ProfilerGadgetPlugin Profiler Gadget Plugin
+ * @{
+ * @brief Aggregates the flight PerfCounter, TaskInfo and CallbackInfo objects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "profilerdata.h"
+
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "uavtalk/telemetrymanager.h"
+#include "taskinfo.h"
+#include "callbackinfo.h"
+#include "perfcounter.h"
+#include "systemstats.h"
+
+#include <QtCore/qmath.h>
+
+// Representative run time of each histogram bin in us, the bins start at 16us and grow 4x
+static const double binTimes[ProfilerData::HISTOGRAM_BINS] = { 8.0, 40.0, 160.0, 640.0, 2560.0, 4096.0 };
+
+ProfilerData::ProfilerData(UAVObjectManager *objManager, QObject *parent) :
+    QObject(parent),
+    m_objManager(objManager),
+    m_telemetryManager(0),
+    m_window(60),
+    m_cpuLoad(0.0),
+    m_lastCallbackTime(-1.0)
+{
+    m_clock.start();
+
+    // a few samples per second at most, coalescing costs nothing
+    m_objManager->subscribeCoalesced(TaskInfo::GetInstance(m_objManager), this, SLOT(taskInfoUpdated(UAVObject *)));
+    m_objManager->subscribeCoalesced(CallbackInfo::GetInstance(m_objManager), this, SLOT(callbackInfoUpdated(UAVObject *)));
+    m_objManager->subscribeCoalesced(SystemStats::GetInstance(m_objManager), this, SLOT(systemStatsUpdated(UAVObject *)));
+
+    // the counter instances are created as the flight side sends them
+    foreach(UAVObject * obj, m_objManager->getObjectInstances(PerfCounter::OBJID)) {
+        instanceCreated(obj);
+    }
+    connect(m_objManager, SIGNAL(newInstance(UAVObject *)), this, SLOT(instanceCreated(UAVObject *)));
+
+    // the board only collects the task and callback statistics at full rate while they are asked for
+    m_telemetryManager = ExtensionSystem::PluginManager::instance()->getObject<TelemetryManager>();
+    if (m_telemetryManager) {
+        connect(m_telemetryManager, SIGNAL(connected()), this, SLOT(telemetryConnected()));
+        if (m_telemetryManager->isConnected()) {
+            demandDiagnostics(true);
+        }
+    }
+}
+
+ProfilerData::~ProfilerData()
+{
+    if (m_telemetryManager && m_telemetryManager->isConnected()) {
+        demandDiagnostics(false);
+    }
+}
+
+void ProfilerData::telemetryConnected()
+{
+    demandDiagnostics(true);
+}
+
+/**
+ * Lower the telemetry period of TaskInfo and CallbackInfo on the board,
+ * or go back to their default period
+ */
+void ProfilerData::demandDiagnostics(bool demanded)
+{
+    QList<UAVObject *> objects;
+
+    objects << TaskInfo::GetInstance(m_objManager) << CallbackInfo::GetInstance(m_objManager);
+    foreach(UAVObject * obj, objects) {
+        UAVObject::Metadata meta = obj->getMetadata();
+        UAVObject::Metadata defaultMeta = obj->getDefaultMetadata();
+
+        if (demanded) {
+            UAVObject::SetFlightTelemetryUpdateMode(meta, UAVObject::UPDATEMODE_PERIODIC);
+            meta.flightTelemetryUpdatePeriod = DIAGNOSTICS_PERIOD_MS;
+        } else {
+            UAVObject::SetFlightTelemetryUpdateMode(meta, UAVObject::GetFlightTelemetryUpdateMode(defaultMeta));
+            meta.flightTelemetryUpdatePeriod = defaultMeta.flightTelemetryUpdatePeriod;
+        }
+        // metadata updates are sent to the board on change
+        obj->setMetadata(meta);
+    }
+}
+
+void ProfilerData::setWindow(int seconds)
+{
+    m_window = qMax(1, seconds);
+}
+
+QString ProfilerData::binName(int bin)
+{
+    static const char *names[HISTOGRAM_BINS] = { "<16us", "<64us", "<256us", "<1ms", "<4ms", ">4ms" };
+
+    return (bin >= 0 && bin < HISTOGRAM_BINS) ? QString(names[bin]) : QString();
+}
+
+void ProfilerData::clear()
+{
+    m_tasks.clear();
+    m_callbacks.clear();
+    m_counters.clear();
+    m_counterTimes.clear();
+    m_lastCallbackTime = -1.0;
+    m_clock.restart();
+    emit tasksUpdated();
+    emit callbacksUpdated();
+    emit countersUpdated();
+}
+
+double ProfilerData::now() const
+{
+    return m_clock.elapsed() / 1000.0;
+}
+
+void ProfilerData::trim(QVector<QPointF> &history, double time) const
+{
+    int old = 0;
+
+    while (old < history.size() && history[old].x() < time - m_window) {
+        old++;
+    }
+    history.remove(0, old);
+}
+
+void ProfilerData::taskInfoUpdated(UAVObject *obj)
+{
+    UAVObjectField *running = obj->getField("Running");
+    UAVObjectField *runningTime    = obj->getField("RunningTime");
+    UAVObjectField *stackRemaining = obj->getField("StackRemaining");
+    QStringList names = running->getElementNames();
+    double time = now();
+
+    for (int i = m_tasks.size(); i < names.size(); i++) {
+        TaskStats task;
+        task.name  = names[i];
+        task.running        = false;
+        task.stackRemaining = 0;
+        task.cpu = task.cpuAverage = task.cpuMax = 0.0;
+        m_tasks << task;
+    }
+    for (int i = 0; i < names.size(); i++) {
+        TaskStats &task = m_tasks[i];
+        task.running        = running->getValue(i).toString() == "True";
+        task.stackRemaining = stackRemaining->getDouble(i);
+        task.cpu = runningTime->getDouble(i);
+        task.cpuHistory << QPointF(time, task.cpu);
+        trim(task.cpuHistory, time);
+
+        double sum = 0.0;
+        task.cpuMax = 0.0;
+        foreach(const QPointF &sample, task.cpuHistory) {
+            sum += sample.y();
+            task.cpuMax = qMax(task.cpuMax, sample.y());
+        }
+        task.cpuAverage = sum / task.cpuHistory.size();
+    }
+    emit tasksUpdated();
+}
+
+void ProfilerData::callbackInfoUpdated(UAVObject *obj)
+{
+    UAVObjectField *running    = obj->getField("Running");
+    UAVObjectField *runningTime = obj->getField("RunningTime");
+    UAVObjectField *runTimeHistogram = obj->getField("RunTimeHistogram");
+    UAVObjectField *latencyHistogram = obj->getField("LatencyHistogram");
+    QStringList names = running->getElementNames();
+    double time     = now();
+    double interval = m_lastCallbackTime < 0.0 ? 0.0 : time - m_lastCallbackTime;
+
+    m_lastCallbackTime = time;
+    for (int i = m_callbacks.size(); i < names.size(); i++) {
+        CallbackStats callback;
+        callback.name = names[i];
+        callback.running     = false;
+        callback.runs        = 0;
+        callback.runRate     = callback.meanRunTime = callback.cpu = 0.0;
+        callback.runTimeHistogram.fill(0, HISTOGRAM_BINS);
+        callback.latencyHistogram.fill(0, HISTOGRAM_BINS);
+        m_callbacks << callback;
+    }
+    for (int i = 0; i < names.size(); i++) {
+        CallbackStats &callback = m_callbacks[i];
+        quint32 runs = runningTime->getDouble(i);
+        if (interval > 0.0) {
+            // the counter restarts with the board
+            callback.runRate = runs >= callback.runs ? (runs - callback.runs) / interval : runs / interval;
+        }
+        callback.runs    = runs;
+        callback.running = running->getValue(i).toString() == "True";
+
+        callback.meanRunTime = 0.0;
+        for (int b = 0; b < HISTOGRAM_BINS; b++) {
+            callback.runTimeHistogram[b] = runTimeHistogram->getDouble(i * HISTOGRAM_BINS + b);
+            callback.latencyHistogram[b] = latencyHistogram->getDouble(i * HISTOGRAM_BINS + b);
+            callback.meanRunTime += binTimes[b] * callback.runTimeHistogram[b] / 100.0;
+        }
+        callback.cpu = callback.runRate * callback.meanRunTime / 1e4;
+    }
+    emit callbacksUpdated();
+}
+
+void ProfilerData::systemStatsUpdated(UAVObject *obj)
+{
+    m_cpuLoad = obj->getField("CPULoad")->getDouble();
+}
+
+void ProfilerData::instanceCreated(UAVObject *obj)
+{
+    if (obj->getObjID() == PerfCounter::OBJID) {
+        connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(perfCounterUpdated(UAVObject *)), Qt::UniqueConnection);
+    }
+}
+
+void ProfilerData::perfCounterUpdated(UAVObject *obj)
+{
+    PerfCounter *perfCounter = qobject_cast<PerfCounter *>(obj);
+
+    if (!perfCounter) {
+        return;
+    }
+    PerfCounter::DataFields data = perfCounter->getData();
+    if (!data.Id) {
+        return;
+    }
+    double time = now();
+    bool known  = m_counters.contains(data.Id);
+    CounterStats &counter = m_counters[data.Id];
+    if (known) {
+        double interval = time - m_counterTimes.value(data.Id);
+        counter.rate = interval > 0.0 ? (data.Counter[PerfCounter::COUNTER_VALUE] - counter.value) / interval : 0.0;
+    } else {
+        counter.id   = data.Id;
+        counter.rate = 0.0;
+    }
+    m_counterTimes[data.Id] = time;
+    counter.value = data.Counter[PerfCounter::COUNTER_VALUE];
+    counter.min   = data.Counter[PerfCounter::COUNTER_MIN];
+    counter.max   = data.Counter[PerfCounter::COUNTER_MAX];
+    counter.valueHistory << QPointF(time, counter.value);
+    counter.minHistory << QPointF(time, counter.min);
+    counter.maxHistory << QPointF(time, counter.max);
+    trim(counter.valueHistory, time);
+    trim(counter.minHistory, time);
+    trim(counter.maxHistory, time);
+    emit countersUpdated();
+}
@@ -0,0 +1,152 @@
+/**
+ ******************************************************************************
+ *
+ * @file       profilerdata.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ProfilerGadgetPlugin Profiler Gadget Plugin
+ * @{
+ * @brief Aggregates the flight PerfCounter, TaskInfo and CallbackInfo objects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PROFILERDATA_H_
+#define PROFILERDATA_H_
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QPointF>
+#include <QVector>
+#include <QElapsedTimer>
+
+class UAVObject;
+class UAVObjectManager;
+class TelemetryManager;
+
+/**
+ * Keeps a sliding window of the profiling objects sent by the flight side
+ * and derives the per task, per callback and per counter statistics from it.
+ * Times in the histories are seconds since the first sample.
+ * While it exists the board is asked for TaskInfo and CallbackInfo
+ * every DIAGNOSTICS_PERIOD_MS instead of their default period.
+ */
+class ProfilerData : public QObject {
+    Q_OBJECT
+
+public:
+    // Must match PIOS_CALLBACKSCHEDULER_HISTOGRAM_BINS
+    static const int HISTOGRAM_BINS = 6;
+    // Below the DIAG_DEMANDED_PERIOD_MS of the System module
+    static const int DIAGNOSTICS_PERIOD_MS = 1000;
+
+    struct TaskStats {
+        QString name;
+        bool    running;
+        int     stackRemaining;
+        double  cpu;
+        double  cpuAverage;
+        double  cpuMax;
+        QVector<QPointF> cpuHistory;
+    };
+
+    struct CallbackStats {
+        QString name;
+        bool    running;
+        quint32 runs;
+        double  runRate; // runs per second
+        double  meanRunTime; // us, estimated from the run time histogram
+        double  cpu; // runRate * meanRunTime, in %
+        QVector<int> runTimeHistogram; // % of the runs per bin
+        QVector<int> latencyHistogram; // % of the dispatches per bin
+    };
+
+    struct CounterStats {
+        quint32 id;
+        qint32  value;
+        qint32  min;
+        qint32  max;
+        double  rate; // change of the value per second
+        QVector<QPointF> valueHistory;
+        QVector<QPointF> minHistory;
+        QVector<QPointF> maxHistory;
+    };
+
+    ProfilerData(UAVObjectManager *objManager, QObject *parent = 0);
+    ~ProfilerData();
+
+    void setWindow(int seconds);
+    int window() const
+    {
+        return m_window;
+    }
+
+    const QList<TaskStats> &tasks() const
+    {
+        return m_tasks;
+    }
+    const QList<CallbackStats> &callbacks() const
+    {
+        return m_callbacks;
+    }
+    const QMap<quint32, CounterStats> &counters() const
+    {
+        return m_counters;
+    }
+    // CPU load of the whole system, including what the tasks do not account for
+    double cpuLoad() const
+    {
+        return m_cpuLoad;
+    }
+
+    static QString binName(int bin);
+
+public slots:
+    void clear();
+
+signals:
+    void tasksUpdated();
+    void callbacksUpdated();
+    void countersUpdated();
+
+private slots:
+    void taskInfoUpdated(UAVObject *obj);
+    void callbackInfoUpdated(UAVObject *obj);
+    void systemStatsUpdated(UAVObject *obj);
+    void perfCounterUpdated(UAVObject *obj);
+    void instanceCreated(UAVObject *obj);
+    void telemetryConnected();
+
+private:
+    double now() const;
+    void trim(QVector<QPointF> &history, double time) const;
+    void demandDiagnostics(bool demanded);
+
+    UAVObjectManager *m_objManager;
+    TelemetryManager *m_telemetryManager;
+    QElapsedTimer m_clock;
+    int m_window;
+    double m_cpuLoad;
+    double m_lastCallbackTime;
+    QList<TaskStats> m_tasks;
+    QList<CallbackStats> m_callbacks;
+    QMap<quint32, CounterStats> m_counters;
+    QMap<quint32, double> m_counterTimes;
+};
+
+#endif // PROFILERDATA_H_
@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ *
+ * @file       profilergadgetfactory.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ProfilerGadgetPlugin Profiler Gadget Plugin
+ * @{
+ * @brief Aggregates the flight PerfCounter, TaskInfo and CallbackInfo objects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "profilergadgetfactory.h"
+#include "profilergadgetwidget.h"
+#include "profilergadget.h"
+#include <coreplugin/iuavgadget.h>
+
+ProfilerGadgetFactory::ProfilerGadgetFactory(QObject *parent) :
+    IUAVGadgetFactory(QString("ProfilerGadget"),
+                      tr("Profiler"),
+                      parent)
+{}
+
+ProfilerGadgetFactory::~ProfilerGadgetFactory()
+{}
+
+IUAVGadget *ProfilerGadgetFactory::createGadget(QWidget *parent)
+{
+    ProfilerGadgetWidget *gadgetWidget = new ProfilerGadgetWidget(parent);
+
+    return new ProfilerGadget(QString("ProfilerGadget"), gadgetWidget, parent);
+}
@@ -0,0 +1,267 @@
+/**
+ ******************************************************************************
+ *
+ * @file       profilergadgetwidget.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ProfilerGadgetPlugin Profiler Gadget Plugin
+ * @{
+ * @brief Aggregates the flight PerfCounter, TaskInfo and CallbackInfo objects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "profilergadgetwidget.h"
+#include "profilerdata.h"
+#include "flameview.h"
+
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+
+#include <QApplication>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPainter>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QSplitter>
+#include <QStyledItemDelegate>
+#include <QTabWidget>
+#include <QTableWidget>
+
+#include "qwt/src/qwt_legend.h"
+#include "qwt/src/qwt_plot.h"
+#include "qwt/src/qwt_plot_curve.h"
+
+/**
+ * Draws the histogram stored as a list of percentages in Qt::UserRole as bars
+ */
+class HistogramDelegate : public QStyledItemDelegate {
+public:
+    HistogramDelegate(QObject *parent) : QStyledItemDelegate(parent) {}
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
+    {
+        QVariantList bins = index.data(Qt::UserRole).toList();
+        QStyleOptionViewItem background(option);
+
+        // selection and background only, the bars replace the text
+        initStyleOption(&background, index);
+        background.text.clear();
+        QApplication::style()->drawControl(QStyle::CE_ItemViewItem, &background, painter);
+        if (bins.isEmpty()) {
+            return;
+        }
+        QRectF area = QRectF(option.rect).adjusted(2, 2, -2, -2);
+        double barWidth = area.width() / bins.size();
+        painter->save();
+        for (int b = 0; b < bins.size(); b++) {
+            double height = area.height() * qBound(0, bins[b].toInt(), 100) / 100.0;
+            // the slow bins are the ones to look at
+            QColor color  = QColor::fromHsv(120 - b * 24, 200, 220);
+            painter->fillRect(QRectF(area.left() + b * barWidth, area.bottom() - height, barWidth - 1, height), color);
+        }
+        painter->restore();
+    }
+};
+
+ProfilerGadgetWidget::ProfilerGadgetWidget(QWidget *parent) : QWidget(parent)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    m_data = new ProfilerData(objManager, this);
+
+    // Tasks: CPU share table and flame view
+    m_taskTable = new QTableWidget(0, 5, this);
+    m_taskTable->setHorizontalHeaderLabels(QStringList() << tr("Task") << tr("CPU %") << tr("Average %") << tr("Max %") << tr("Stack"));
+    m_flameView = new FlameView(m_data, this);
+    QSplitter *taskSplitter = new QSplitter(Qt::Vertical, this);
+    taskSplitter->addWidget(m_taskTable);
+    taskSplitter->addWidget(m_flameView);
+
+    // Callbacks: rates and histograms
+    m_callbackTable = new QTableWidget(0, 6, this);
+    m_callbackTable->setHorizontalHeaderLabels(QStringList() << tr("Callback") << tr("Runs/s") << tr("Mean run time (us)")
+                                               << tr("CPU %") << tr("Run time") << tr("Latency"));
+    m_callbackTable->setItemDelegateForColumn(4, new HistogramDelegate(this));
+    m_callbackTable->setItemDelegateForColumn(5, new HistogramDelegate(this));
+
+    // Counters: table and trend of the selected one
+    m_counterTable = new QTableWidget(0, 5, this);
+    m_counterTable->setHorizontalHeaderLabels(QStringList() << tr("Id") << tr("Value") << tr("Min") << tr("Max") << tr("Change/s"));
+    m_counterTable->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_counterTable->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_counterPlot = new QwtPlot(this);
+    m_counterPlot->insertLegend(new QwtLegend(), QwtPlot::BottomLegend);
+    m_counterPlot->setAxisTitle(QwtPlot::xBottom, tr("Time (s)"));
+    m_valueCurve  = new QwtPlotCurve(tr("Value"));
+    m_valueCurve->setPen(QPen(Qt::blue));
+    m_valueCurve->attach(m_counterPlot);
+    m_minCurve    = new QwtPlotCurve(tr("Min"));
+    m_minCurve->setPen(QPen(Qt::darkGreen));
+    m_minCurve->attach(m_counterPlot);
+    m_maxCurve    = new QwtPlotCurve(tr("Max"));
+    m_maxCurve->setPen(QPen(Qt::red));
+    m_maxCurve->attach(m_counterPlot);
+    QSplitter *counterSplitter = new QSplitter(Qt::Horizontal, this);
+    counterSplitter->addWidget(m_counterTable);
+    counterSplitter->addWidget(m_counterPlot);
+
+    foreach(QTableWidget * table, QList<QTableWidget *>() << m_taskTable << m_callbackTable << m_counterTable) {
+        table->verticalHeader()->hide();
+        table->horizontalHeader()->setStretchLastSection(true);
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    }
+
+    QTabWidget *tabs = new QTabWidget(this);
+    tabs->addTab(taskSplitter, tr("Tasks"));
+    tabs->addTab(m_callbackTable, tr("Callbacks"));
+    tabs->addTab(counterSplitter, tr("Counters"));
+
+    QSpinBox *window = new QSpinBox(this);
+    window->setRange(5, 3600);
+    window->setSuffix(tr(" s"));
+    window->setValue(m_data->window());
+    QPushButton *clear = new QPushButton(tr("Clear"), this);
+    QHBoxLayout *controls = new QHBoxLayout();
+    controls->addWidget(new QLabel(tr("Window:"), this));
+    controls->addWidget(window);
+    controls->addStretch();
+    controls->addWidget(clear);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addLayout(controls);
+    layout->addWidget(tabs);
+
+    connect(window, SIGNAL(valueChanged(int)), this, SLOT(setWindow(int)));
+    connect(clear, SIGNAL(clicked()), m_data, SLOT(clear()));
+    connect(m_data, SIGNAL(tasksUpdated()), this, SLOT(updateTasks()));
+    connect(m_data, SIGNAL(callbacksUpdated()), this, SLOT(updateCallbacks()));
+    connect(m_data, SIGNAL(countersUpdated()), this, SLOT(updateCounters()));
+    connect(m_counterTable, SIGNAL(itemSelectionChanged()), this, SLOT(updateCounterPlot()));
+
+    setToolTip(tr("Profiles the flight tasks, callbacks and performance counters. Builds with DIAG_TASKS "
+                  "publish the task and callback statistics."));
+}
+
+ProfilerGadgetWidget::~ProfilerGadgetWidget()
+{
+    // Do nothing
+}
+
+void ProfilerGadgetWidget::setWindow(int seconds)
+{
+    m_data->setWindow(seconds);
+}
+
+void ProfilerGadgetWidget::setCell(QTableWidget *table, int row, int column, const QVariant &value)
+{
+    QTableWidgetItem *item = table->item(row, column);
+
+    if (!item) {
+        item = new QTableWidgetItem();
+        table->setItem(row, column, item);
+    }
+    if (value.type() == QVariant::List) {
+        item->setData(Qt::UserRole, value);
+        QStringList text;
+        QVariantList bins = value.toList();
+        for (int b = 0; b < bins.size(); b++) {
+            text << QString("%1: %2%").arg(ProfilerData::binName(b)).arg(bins[b].toInt());
+        }
+        item->setToolTip(text.join("\n"));
+    } else {
+        item->setData(Qt::DisplayRole, value);
+    }
+}
+
+void ProfilerGadgetWidget::updateTasks()
+{
+    const QList<ProfilerData::TaskStats> &tasks = m_data->tasks();
+
+    m_taskTable->setRowCount(tasks.size());
+    for (int row = 0; row < tasks.size(); row++) {
+        const ProfilerData::TaskStats &task = tasks[row];
+        setCell(m_taskTable, row, 0, task.name);
+        setCell(m_taskTable, row, 1, task.running ? QVariant(task.cpu) : QVariant(tr("not running")));
+        setCell(m_taskTable, row, 2, QString::number(task.cpuAverage, 'f', 1));
+        setCell(m_taskTable, row, 3, task.cpuMax);
+        setCell(m_taskTable, row, 4, task.stackRemaining);
+    }
+}
+
+void ProfilerGadgetWidget::updateCallbacks()
+{
+    const QList<ProfilerData::CallbackStats> &callbacks = m_data->callbacks();
+
+    m_callbackTable->setRowCount(callbacks.size());
+    for (int row = 0; row < callbacks.size(); row++) {
+        const ProfilerData::CallbackStats &callback = callbacks[row];
+        QVariantList runTime, latency;
+        for (int b = 0; b < ProfilerData::HISTOGRAM_BINS; b++) {
+            runTime << callback.runTimeHistogram[b];
+            latency << callback.latencyHistogram[b];
+        }
+        setCell(m_callbackTable, row, 0, callback.name);
+        setCell(m_callbackTable, row, 1, QString::number(callback.runRate, 'f', 1));
+        setCell(m_callbackTable, row, 2, QString::number(callback.meanRunTime, 'f', 0));
+        setCell(m_callbackTable, row, 3, QString::number(callback.cpu, 'f', 2));
+        setCell(m_callbackTable, row, 4, runTime);
+        setCell(m_callbackTable, row, 5, latency);
+    }
+}
+
+void ProfilerGadgetWidget::updateCounters()
+{
+    const QMap<quint32, ProfilerData::CounterStats> &counters = m_data->counters();
+
+    m_counterTable->setRowCount(counters.size());
+    int row = 0;
+    foreach(const ProfilerData::CounterStats &counter, counters) {
+        setCell(m_counterTable, row, 0, QString("0x%1").arg(counter.id, 8, 16, QChar('0')));
+        m_counterTable->item(row, 0)->setData(Qt::UserRole, counter.id);
+        setCell(m_counterTable, row, 1, counter.value);
+        setCell(m_counterTable, row, 2, counter.min);
+        setCell(m_counterTable, row, 3, counter.max);
+        setCell(m_counterTable, row, 4, QString::number(counter.rate, 'f', 1));
+        row++;
+    }
+    updateCounterPlot();
+}
+
+void ProfilerGadgetWidget::updateCounterPlot()
+{
+    QList<QTableWidgetItem *> selected = m_counterTable->selectedItems();
+    const QMap<quint32, ProfilerData::CounterStats> &counters = m_data->counters();
+    quint32 id = selected.isEmpty() ? 0 : m_counterTable->item(selected.first()->row(), 0)->data(Qt::UserRole).toUInt();
+
+    if (counters.contains(id)) {
+        const ProfilerData::CounterStats &counter = counters[id];
+        m_valueCurve->setSamples(counter.valueHistory);
+        m_minCurve->setSamples(counter.minHistory);
+        m_maxCurve->setSamples(counter.maxHistory);
+        m_counterPlot->setTitle(QString("0x%1").arg(id, 8, 16, QChar('0')));
+    } else {
+        m_valueCurve->setSamples(QVector<QPointF>());
+        m_minCurve->setSamples(QVector<QPointF>());
+        m_maxCurve->setSamples(QVector<QPointF>());
+        m_counterPlot->setTitle(QString());
+    }
+    m_counterPlot->replot();
+}
@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ *
+ * @file       profilergadgetwidget.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ProfilerGadgetPlugin Profiler Gadget Plugin
+ * @{
+ * @brief Aggregates the flight PerfCounter, TaskInfo and CallbackInfo objects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PROFILERGADGETWIDGET_H_
+#define PROFILERGADGETWIDGET_H_
+
+#include <QWidget>
+
+class QTableWidget;
+class QwtPlot;
+class QwtPlotCurve;
+class ProfilerData;
+class FlameView;
+
+class ProfilerGadgetWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    ProfilerGadgetWidget(QWidget *parent = 0);
+    ~ProfilerGadgetWidget();
+
+private slots:
+    void updateTasks();
+    void updateCallbacks();
+    void updateCounters();
+    void updateCounterPlot();
+    void setWindow(int seconds);
+
+private:
+    void setCell(QTableWidget *table, int row, int column, const QVariant &value);
+
+    ProfilerData *m_data;
+    QTableWidget *m_taskTable;
+    QTableWidget *m_callbackTable;
+    QTableWidget *m_counterTable;
+    FlameView *m_flameView;
+    QwtPlot *m_counterPlot;
+    QwtPlotCurve *m_valueCurve;
+    QwtPlotCurve *m_minCurve;
+    QwtPlotCurve *m_maxCurve;
+};
+
+#endif /* PROFILERGADGETWIDGET_H_ */
@@ -28,15 +28,456 @@
 
 #include "plotdata.h"
 #include <math.h>
+#include <qmath.h>
 #include <QDebug>
+#include <qwt/src/qwt_color_map.h>
+#include <algorithm>
+
+// Raw samples queued per curve between two runs of the worker
+#define SAMPLE_QUEUE_SIZE 4096
+
+PlotSampleQueue::PlotSampleQueue(int capacity) : m_head(0), m_tail(0)
+{
+    int size = 2;
+
+    while (size < capacity) {
+        size *= 2;
+    }
+    m_samples.resize(size);
+    m_data = m_samples.data();
+    m_mask = size - 1;
+}
+
+/**
+ * Producer side. Returns false and drops the sample if the queue is full,
+ * one slot is kept free to tell a full queue from an empty one.
+ */
+bool PlotSampleQueue::push(const QPointF &sample)
+{
+    int head = m_head.load();
+    int next = (head + 1) & m_mask;
+
+    if (next == m_tail.loadAcquire()) {
+        return false;
+    }
+    m_data[head] = sample;
+    m_head.storeRelease(next);
+    return true;
+}
+
+/**
+ * Consumer side
+ */
+bool PlotSampleQueue::pop(QPointF *sample)
+{
+    int tail = m_tail.load();
+
+    if (tail == m_head.loadAcquire()) {
+        return false;
+    }
+    *sample = m_data[tail];
+    m_tail.storeRelease((tail + 1) & m_mask);
+    return true;
+}
+
+/**
+ * Only while the consumer is not running
+ */
+void PlotSampleQueue::clear()
+{
+    m_tail.storeRelease(m_head.loadAcquire());
+}
+
+PlotDataSeries::PlotDataSeries(bool indexAsX, int capacity) :
+    m_first(0), m_count(0), m_indexAsX(indexAsX), m_fixedCapacity(capacity > 0)
+{
+    m_buffer.resize(m_fixedCapacity ? capacity : 64);
+}
+
+/**
+ * Appends a sample. A fixed capacity series drops the oldest sample when full,
+ * otherwise the buffer grows.
+ */
+void PlotDataSeries::append(double x, double y)
+{
+    if (m_count == m_buffer.size()) {
+        if (m_fixedCapacity) {
+            removeFirst();
+        } else {
+            QVector<QPointF> buffer(m_buffer.size() * 2);
+            for (int i = 0; i < m_count; ++i) {
+                int index = m_first + i;
+                buffer[i] = m_buffer.at(index >= m_buffer.size() ? index - m_buffer.size() : index);
+            }
+            m_buffer = buffer;
+            m_first  = 0;
+        }
+    }
+    int index = m_first + m_count;
+    if (index >= m_buffer.size()) {
+        index -= m_buffer.size();
+    }
+    m_buffer[index] = QPointF(x, y);
+    ++m_count;
+}
+
+void PlotDataSeries::removeFirst()
+{
+    if (m_count > 0) {
+        if (++m_first == m_buffer.size()) {
+            m_first = 0;
+        }
+        --m_count;
+    }
+}
+
+void PlotDataSeries::clear()
+{
+    m_first = 0;
+    m_count = 0;
+}
+
+/**
+ * Copies the samples to draw and their bounding rectangle. If there are more than
+ * two samples per column only the min/max of every column is kept. The columns
+ * split the visible range from..to, samples outside of it go to the edge columns.
+ * Samples are expected in increasing x order. The vector keeps its capacity between the calls.
+ */
+void PlotDataSeries::prepare(double from, double to, int columns, QVector<QPointF> &samples, QRectF &boundingRect) const
+{
+    if (m_count == 0) {
+        samples.resize(0);
+        boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+        return;
+    }
+
+    const double firstX   = first().x();
+    const double lastX    = last().x();
+    const bool isDecimated = columns > 0 && m_count > 2 * columns && to > from;
+
+    samples.resize(isDecimated ? 2 * columns : m_count);
+    QPointF *out = samples.data();
+    int count    = 0;
+
+    const double columnScale = isDecimated ? columns / (to - from) : 0.0;
+    double minY = rawSample(0).y();
+    double maxY = minY;
+    int column  = -1;
+    QPointF columnMin;
+    QPointF columnMax;
+    int columnMinIndex = 0;
+    int columnMaxIndex = 0;
+
+    for (int i = 0; i < m_count; ++i) {
+        QPointF point = rawSample(i);
+        minY = qMin(minY, point.y());
+        maxY = qMax(maxY, point.y());
+        if (!isDecimated) {
+            out[count++] = point;
+            continue;
+        }
+
+        int pointColumn = (int)qBound(0.0, floor((point.x() - from) * columnScale), columns - 1.0);
+        if (pointColumn != column) {
+            if (column >= 0) {
+                // Keep the extremes in their original order
+                out[count++] = columnMinIndex <= columnMaxIndex ? columnMin : columnMax;
+                if (columnMinIndex != columnMaxIndex) {
+                    out[count++] = columnMinIndex <= columnMaxIndex ? columnMax : columnMin;
+                }
+            }
+            column    = pointColumn;
+            columnMin = columnMax = point;
+            columnMinIndex = columnMaxIndex = i;
+        } else if (point.y() < columnMin.y()) {
+            columnMin = point;
+            columnMinIndex = i;
+        } else if (point.y() > columnMax.y()) {
+            columnMax = point;
+            columnMaxIndex = i;
+        }
+    }
+    if (isDecimated) {
+        out[count++] = columnMinIndex <= columnMaxIndex ? columnMin : columnMax;
+        if (columnMinIndex != columnMaxIndex) {
+            out[count++] = columnMinIndex <= columnMaxIndex ? columnMax : columnMin;
+        }
+    }
+    samples.resize(count);
+
+    boundingRect = QRectF(firstX, minY, lastX - firstX, maxY - minY);
+}
+
+// Number of resolution levels, bucket length of the finest level and buckets kept per level.
+// The coarsest level covers LEVEL_BUCKETS * 0.01 * 4^7 seconds, about 93 hours.
+#define PLOT_LEVELS      8
+#define LEVEL_DURATION   0.01
+#define LEVEL_BUCKETS    2048
+// A level is drawn when it has at most that many buckets per pixel column in the window
+#define LEVEL_MAX_PER_COLUMN 4
+
+void PlotDataLevels::Level::push(const Bucket &bucket)
+{
+    if (count == buckets.size()) {
+        if (buckets.size() < LEVEL_BUCKETS) {
+            // Grow as needed, most curves never fill the coarse levels
+            QVector<Bucket> grown(qMax(buckets.size() * 2, 16));
+            for (int i = 0; i < count; ++i) {
+                grown[i] = at(i);
+            }
+            buckets = grown;
+            first   = 0;
+        } else {
+            removeFirst();
+        }
+    }
+    at(count++) = bucket;
+}
+
+void PlotDataLevels::Level::removeFirst()
+{
+    if (count > 0) {
+        if (++first == buckets.size()) {
+            first = 0;
+        }
+        --count;
+    }
+}
+
+PlotDataLevels::PlotDataLevels()
+{
+    m_levels.resize(PLOT_LEVELS);
+    double duration = LEVEL_DURATION;
+    for (int i = 0; i < PLOT_LEVELS; ++i) {
+        m_levels[i].first    = 0;
+        m_levels[i].count    = 0;
+        m_levels[i].duration = duration;
+        duration *= 4;
+    }
+}
+
+/**
+ * Adds a sample to the last bucket of every level, or starts a new one
+ */
+void PlotDataLevels::append(double x, double y)
+{
+    for (int i = 0; i < PLOT_LEVELS; ++i) {
+        Level &level = m_levels[i];
+        if (level.count > 0 && x < level.at(level.count - 1).time + level.duration) {
+            Bucket &bucket = level.at(level.count - 1);
+            bucket.min  = qMin(bucket.min, y);
+            bucket.max  = qMax(bucket.max, y);
+            bucket.sum += y;
+            bucket.count++;
+        } else {
+            Bucket bucket = { floor(x / level.duration) * level.duration, y, y, y, 1 };
+            level.push(bucket);
+        }
+    }
+}
+
+/**
+ * Drops the buckets which end before x
+ */
+void PlotDataLevels::removeBefore(double x)
+{
+    for (int i = 0; i < PLOT_LEVELS; ++i) {
+        Level &level = m_levels[i];
+        while (level.count > 0 && level.at(0).time + level.duration < x) {
+            level.removeFirst();
+        }
+    }
+}
+
+void PlotDataLevels::clear()
+{
+    for (int i = 0; i < PLOT_LEVELS; ++i) {
+        m_levels[i].first = 0;
+        m_levels[i].count = 0;
+    }
+}
+
+/**
+ * Copies the buckets from x = from on of the level matching the pixel columns.
+ * A bucket of one sample is drawn as its value, the others as their min and max.
+ */
+void PlotDataLevels::prepare(double from, int columns, QVector<QPointF> &samples, QRectF &boundingRect) const
+{
+    int selected = PLOT_LEVELS - 1;
+
+    for (int i = 0; i < PLOT_LEVELS; ++i) {
+        const Level &level = m_levels.at(i);
+        if (level.count == 0) {
+            continue;
+        }
+        // A level which dropped the start of the window is not used, unless it is the last one
+        bool covers    = level.at(0).time <= from || level.count < LEVEL_BUCKETS;
+        double buckets = (level.at(level.count - 1).time + level.duration - from) / level.duration;
+        if (covers && buckets <= (double)LEVEL_MAX_PER_COLUMN * qMax(columns, 1)) {
+            selected = i;
+            break;
+        }
+    }
+
+    const Level &level = m_levels.at(selected);
+    samples.resize(0);
+    if (level.count == 0) {
+        boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+        return;
+    }
+
+    samples.reserve(2 * level.count);
+    double minY = level.at(level.count - 1).min;
+    double maxY = level.at(level.count - 1).max;
+    for (int i = 0; i < level.count; ++i) {
+        const Bucket &bucket = level.at(i);
+        if (bucket.time + level.duration < from) {
+            continue;
+        }
+        double x = bucket.time + level.duration / 2;
+        if (bucket.count == 1) {
+            samples.append(QPointF(x, bucket.sum));
+        } else {
+            samples.append(QPointF(x, bucket.min));
+            samples.append(QPointF(x, bucket.max));
+        }
+        minY = qMin(minY, bucket.min);
+        maxY = qMax(maxY, bucket.max);
+    }
+
+    double firstX = samples.isEmpty() ? from : samples.first().x();
+    double lastX  = samples.isEmpty() ? from : samples.last().x();
+    boundingRect = QRectF(firstX, minY, lastX - firstX, maxY - minY);
+}
+
+// A pyramid level is drawn when it has at most that many buckets per pixel column in the window
+#define PYRAMID_MAX_PER_COLUMN 2
+
+PlotDataPyramid::PlotDataPyramid()
+{}
+
+/**
+ * Shares the samples of the column and computes the min/max levels
+ */
+void PlotDataPyramid::build(const ScopePlaybackLog::Column &column)
+{
+    m_timeStamps = column.timeStamps;
+    m_samples    = column.samples;
+    m_levels.clear();
+
+    int count = qMin(m_timeStamps.size(), m_samples.size());
+    m_timeStamps.resize(count);
+    m_samples.resize(count);
+
+    while (count > 4) {
+        const int buckets = (count + 3) / 4;
+        Level level;
+        level.min.resize(buckets);
+        level.max.resize(buckets);
+        for (int b = 0; b < buckets; ++b) {
+            const int first = 4 * b;
+            const int last  = qMin(first + 4, count);
+            float min;
+            float max;
+            if (m_levels.isEmpty()) {
+                min = max = m_samples.at(first);
+                for (int i = first + 1; i < last; ++i) {
+                    min = qMin(min, (float)m_samples.at(i));
+                    max = qMax(max, (float)m_samples.at(i));
+                }
+            } else {
+                const Level &previous = m_levels.last();
+                min = previous.min.at(first);
+                max = previous.max.at(first);
+                for (int i = first + 1; i < last; ++i) {
+                    min = qMin(min, previous.min.at(i));
+                    max = qMax(max, previous.max.at(i));
+                }
+            }
+            level.min[b] = min;
+            level.max[b] = max;
+        }
+        m_levels.append(level);
+        count = buckets;
+    }
+}
+
+void PlotDataPyramid::clear()
+{
+    m_timeStamps.clear();
+    m_samples.clear();
+    m_levels.clear();
+}
+
+/**
+ * Copies the samples from x = from to x = to, and one on each side so the curve
+ * reaches the edges of the window. A bucket is drawn as its min and max at the
+ * time of its middle sample.
+ */
+void PlotDataPyramid::prepare(double from, double to, double scale, int columns, QVector<QPointF> &samples, QRectF &boundingRect) const
+{
+    const int count = m_samples.size();
+
+    samples.resize(0);
+    if (count == 0 || to <= from) {
+        boundingRect = QRectF(0.0, 0.0, -1.0, -1.0);
+        return;
+    }
+
+    const quint32 *timeStamps = m_timeStamps.constData();
+    const quint32 fromMs = (quint32)qBound(0.0, from * 1000.0, 4294967295.0);
+    const quint32 toMs   = (quint32)qBound(0.0, to * 1000.0, 4294967295.0);
+    const int first = qMax((int)(std::lower_bound(timeStamps, timeStamps + count, fromMs) - timeStamps) - 1, 0);
+    const int last  = qMin((int)(std::upper_bound(timeStamps, timeStamps + count, toMs) - timeStamps) + 1, count);
+
+    const int maxBuckets = PYRAMID_MAX_PER_COLUMN * qMax(columns, 1);
+    int level = 0;
+    int size  = 1;
+    while (level < m_levels.size() && (last - first) / size > maxBuckets) {
+        ++level;
+        size *= 4;
+    }
+
+    double minY;
+    double maxY;
+    if (level == 0) {
+        samples.reserve(last - first);
+        minY = maxY = m_samples.at(first) * scale;
+        for (int i = first; i < last; ++i) {
+            const double y = m_samples.at(i) * scale;
+            samples.append(QPointF(time(i), y));
+            minY = qMin(minY, y);
+            maxY = qMax(maxY, y);
+        }
+    } else {
+        const Level &buckets = m_levels.at(level - 1);
+        const int firstBucket = first / size;
+        const int lastBucket  = (last - 1) / size;
+        samples.reserve(2 * (lastBucket - firstBucket + 1));
+        minY = buckets.min.at(firstBucket) * scale;
+        maxY = buckets.max.at(firstBucket) * scale;
+        for (int b = firstBucket; b <= lastBucket; ++b) {
+            const double x  = time(qMin(b * size + size / 2, count - 1));
+            const double lo = buckets.min.at(b) * scale;
+            const double hi = buckets.max.at(b) * scale;
+            samples.append(QPointF(x, lo));
+            samples.append(QPointF(x, hi));
+            minY = qMin(minY, lo);
+            maxY = qMax(maxY, hi);
+        }
+    }
+    boundingRect = QRectF(samples.first().x(), minY, samples.last().x() - samples.first().x(), maxY - minY);
+}
 
 PlotData::PlotData(UAVObject *object, UAVObjectField *field, int element,
                    int scaleOrderFactor, int meanSamples, QString mathFunction,
                    double plotDataSize, QPen pen, bool antialiased) :
     m_scalePower(scaleOrderFactor), m_meanSamples(meanSamples),
-    m_meanSum(0.0f), m_mathFunction(mathFunction), m_correctionSum(0.0f),
-    m_correctionCount(0), m_plotDataSize(plotDataSize),
-    m_object(object), m_field(field), m_element(element),
+    m_meanSum(0.0f), m_meanSquareSum(0.0f), m_mathFunction(mathFunction), m_correctionSum(0.0f),
+    m_correctionSquareSum(0.0f), m_correctionCount(0), m_plotDataSize(plotDataSize),
+    m_queue(SAMPLE_QUEUE_SIZE), m_series(NULL), m_dirty(false), m_preparedValue(0.0), m_preparedReady(0),
+    m_curveData(NULL), m_lastValue(0.0), m_hasValue(false),
+    m_historyIndex(0), m_historyCount(0), m_object(object), m_field(field), m_element(element),
     m_plotCurve(NULL), m_isVisible(true), m_pen(pen), m_isEnumPlot(false)
 {
     if (m_field->getNumElements() > 1) {
@@ -62,7 +503,9 @@ PlotData::PlotData(UAVObject *object, UAVObjectField *field, int element,
     }
 
     m_plotCurve->setPen(m_pen);
-    m_plotCurve->setSamples(m_xDataEntries, m_yDataEntries);
+    m_curveData = new PlotCurveData();
+    m_plotCurve->setData(m_curveData);
+    m_yDataHistory.resize(qMax(m_meanSamples, 1));
     m_isEnumPlot = m_field->getType() == UAVObjectField::ENUM;
 }
 
@@ -75,6 +518,7 @@ PlotData::~PlotData()
     }
     m_plotCurve->detach();
     delete m_plotCurve;
+    delete m_series;
 }
 
 bool PlotData::isVisible() const
@@ -88,18 +532,98 @@ void PlotData::setVisible(bool visible)
     visibilityChanged(m_plotCurve);
 }
 
+/**
+ * Takes the queued samples, applies the math and the trimming and prepares the
+ * samples to draw when the GUI thread has taken the previous ones.
+ */
+void PlotData::process(int columns)
+{
+    if (processSamples()) {
+        m_dirty = true;
+    }
+
+    if (m_dirty && !m_preparedReady.loadAcquire()) {
+        prepareSamples(columns);
+        m_dirty = false;
+        m_preparedReady.storeRelease(1);
+    }
+}
+
+bool PlotData::processSamples()
+{
+    const bool math = hasMathFunction();
+    QPointF sample;
+    bool appended   = false;
+
+    while (m_queue.pop(&sample)) {
+        appendSample(sample.x(), math ? calcMathFunction(sample.y()) : sample.y());
+        appended = true;
+    }
+    if (appended) {
+        removeStaleSamples();
+    }
+    return appended;
+}
+
+void PlotData::appendSample(double x, double y)
+{
+    m_series->append(x, y);
+}
+
+void PlotData::prepareSamples(int columns)
+{
+    double from, to;
+
+    visibleRange(from, to);
+    m_series->prepare(from, to, columns, m_prepared, m_preparedRect);
+    m_preparedValue = m_series->isEmpty() ? 0.0 : m_series->last().y();
+}
+
+/**
+ * The window of m_plotDataSize which ends at the last sample
+ */
+void PlotData::visibleRange(double &from, double &to) const
+{
+    to   = m_series->isEmpty() ? 0.0 : m_series->last().x();
+    from = to - m_plotDataSize;
+}
+
+/**
+ * Swaps in the samples prepared by the worker
+ */
 void PlotData::updatePlotData()
 {
-    m_plotCurve->setSamples(m_xDataEntries, m_yDataEntries);
+    if (!m_preparedReady.loadAcquire()) {
+        return;
+    }
+    m_curveData->swapSamples(m_prepared, m_preparedRect);
+    if (showsProcessedValue()) {
+        m_lastValue = m_preparedValue;
+        m_hasValue  = true;
+    }
+    m_preparedReady.storeRelease(0);
+    m_plotCurve->itemChanged();
 }
 
 void PlotData::clear()
 {
     m_meanSum = 0.0f;
-    m_correctionSum   = 0.0f;
-    m_correctionCount = 0;
-    m_xDataEntries.clear();
-    m_yDataEntries.clear();
+    m_meanSquareSum       = 0.0f;
+    m_correctionSum       = 0.0f;
+    m_correctionSquareSum = 0.0f;
+    m_correctionCount     = 0;
+    m_historyIndex = 0;
+    m_historyCount = 0;
+    m_queue.clear();
+    if (m_series) {
+        m_series->clear();
+    }
+    m_dirty = false;
+    m_prepared.resize(0);
+    m_preparedReady.storeRelease(0);
+    QVector<QPointF> empty;
+    m_curveData->swapSamples(empty, QRectF(0.0, 0.0, -1.0, -1.0));
+    m_hasValue = false;
     while (!m_enumMarkerList.isEmpty()) {
         QwtPlotMarker *marker = m_enumMarkerList.takeFirst();
         marker->detach();
@@ -113,7 +637,7 @@ void PlotData::clear()
 bool PlotData::hasData() const
 {
     if (!m_isEnumPlot) {
-        return !m_xDataEntries.isEmpty();
+        return m_hasValue;
     } else {
         return !m_enumMarkerList.isEmpty();
     }
@@ -122,12 +646,21 @@ bool PlotData::hasData() const
 QString PlotData::lastDataAsString()
 {
     if (!m_isEnumPlot) {
-        return QString().sprintf("%3.10g", m_yDataEntries.last());
+        return QString().sprintf("%3.10g", m_lastValue);
     } else {
         return m_enumMarkerList.last()->title().text();
     }
 }
 
+double PlotData::lastData()
+{
+    if (!m_isEnumPlot) {
+        return m_lastValue;
+    } else {
+        return m_field->getOptions().indexOf(m_enumMarkerList.last()->title().text());
+    }
+}
+
 void PlotData::attach(QwtPlot *plot)
 {
     m_plotCurve->attach(plot);
@@ -142,37 +675,65 @@ void PlotData::visibilityChanged(QwtPlotItem *item)
     }
 }
 
-void PlotData::calcMathFunction(double currentValue)
+bool PlotData::hasMathFunction() const
 {
-    // Put the new value at the back
-    m_yDataHistory.append(currentValue);
+    return m_mathFunction == "Boxcar average" || m_mathFunction == "Standard deviation";
+}
 
-    // calculate average value
-    m_meanSum += currentValue;
-    if (m_yDataHistory.size() > m_meanSamples) {
-        m_meanSum -= m_yDataHistory.first();
-        m_yDataHistory.pop_front();
+/**
+ * GUI thread, queues a raw sample for the worker. With scope math the value
+ * shown and logged is the processed one, it follows at the next refresh.
+ */
+void PlotData::queueSample(double x, double value)
+{
+    m_queue.push(QPointF(x, value));
+    if (!showsProcessedValue()) {
+        m_lastValue = value;
+        m_hasValue  = true;
+    }
+}
+
+double PlotData::calcMathFunction(double currentValue)
+{
+    // Replace the oldest value in the window with the new one
+    if (m_historyCount == m_yDataHistory.size()) {
+        double oldest = m_yDataHistory.at(m_historyIndex);
+        m_meanSum       -= oldest;
+        m_meanSquareSum -= oldest * oldest;
+    } else {
+        m_historyCount++;
     }
-    // make sure to correct the sum every meanSamples steps to prevent it
+    m_yDataHistory[m_historyIndex] = currentValue;
+    if (++m_historyIndex == m_yDataHistory.size()) {
+        m_historyIndex = 0;
+    }
+
+    // calculate average value
+    m_meanSum       += currentValue;
+    m_meanSquareSum += currentValue * currentValue;
+
+    // make sure to correct the sums every meanSamples steps to prevent them
     // from running away due to floating point rounding errors
-    m_correctionSum += currentValue;
+    m_correctionSum       += currentValue;
+    m_correctionSquareSum += currentValue * currentValue;
     if (++m_correctionCount >= m_meanSamples) {
         m_meanSum = m_correctionSum;
-        m_correctionSum = 0.0f;
-        m_correctionCount = 0;
+        m_meanSquareSum       = m_correctionSquareSum;
+        m_correctionSum       = 0.0f;
+        m_correctionSquareSum = 0.0f;
+        m_correctionCount     = 0;
     }
 
-    double boxcarAvg = m_meanSum / m_yDataHistory.size();
+    double boxcarAvg = m_meanSum / m_historyCount;
     if (m_mathFunction == "Standard deviation") {
-        // Calculate square of sample standard deviation, with Bessel's correction
-        double stdSum = 0;
-        for (int i = 0; i < m_yDataHistory.size(); i++) {
-            stdSum += pow(m_yDataHistory.at(i) - boxcarAvg, 2) / (m_meanSamples - 1);
+        // Square of sample standard deviation, with Bessel's correction, from the running sums
+        if (m_meanSamples < 2) {
+            return 0;
         }
-        m_yDataEntries.append(sqrt(stdSum));
-    } else {
-        m_yDataEntries.append(boxcarAvg);
+        double variance = (m_meanSquareSum - m_meanSum * boxcarAvg) / (m_meanSamples - 1);
+        return sqrt(qMax(variance, 0.0));
     }
+    return boxcarAvg;
 }
 
 QwtPlotMarker *PlotData::createMarker(QString value)
@@ -207,22 +768,10 @@ bool SequentialPlotData::append(UAVObject *obj)
 
     if (m_object == obj && m_field) {
         if (!m_isEnumPlot) {
-            double currentValue = m_field->getValue(m_element).toDouble() * pow(10, m_scalePower);
+            double currentValue = m_field->getDouble(m_element) * pow(10, m_scalePower);
 
-            // Perform scope math, if necessary
-            if (m_mathFunction == "Boxcar average" || m_mathFunction == "Standard deviation") {
-                calcMathFunction(currentValue);
-            } else {
-                m_yDataEntries.append(currentValue);
-            }
-
-            if (m_yDataEntries.size() > m_plotDataSize) {
-                // If new data overflows the window, remove old data...
-                m_yDataEntries.pop_front();
-            } else {
-                // ...otherwise, add a new y point at position xData
-                m_xDataEntries.insert(m_xDataEntries.size(), m_xDataEntries.size());
-            }
+            // The series drops the oldest value when the window is full, x is the sample index
+            queueSample(0, currentValue);
             return true;
         } else {
             // Enum markers
@@ -250,22 +799,18 @@ bool ChronoPlotData::append(UAVObject *obj)
     }
 
     if (m_object == obj && m_field) {
-        // Get the field of interest
-        // THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
-        QDateTime NOW = QDateTime::currentDateTime();
-
-        double xValue = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+        // Objects sent timestamped are plotted at their board time, without the link jitter
+        double xValue;
+        if (obj->hasVehicleTime()) {
+            xValue = obj->getVehicleSampleTime() / 1000.0;
+        } else {
+            QDateTime NOW = QDateTime::currentDateTime();
+            xValue = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+        }
         if (!m_isEnumPlot) {
-            double currentValue = m_field->getValue(m_element).toDouble() * pow(10, m_scalePower);
+            double currentValue = m_field->getDouble(m_element) * pow(10, m_scalePower);
 
-            // Perform scope math, if necessary
-            if (m_mathFunction == "Boxcar average" || m_mathFunction == "Standard deviation") {
-                calcMathFunction(currentValue);
-            } else {
-                m_yDataEntries.append(currentValue);
-            }
-
-            m_xDataEntries.append(xValue);
+            queueSample(xValue, currentValue);
         } else {
             // Enum markers
             QString value = m_field->getValue(m_element).toString();
@@ -287,13 +832,121 @@ bool ChronoPlotData::append(UAVObject *obj)
     return false;
 }
 
-void ChronoPlotData::removeStaleData()
+// Raw samples kept for a chrono curve, older ones are only in the levels
+#define CHRONO_RAW_SAMPLES 16384
+
+void ChronoPlotData::appendSample(double x, double y)
+{
+    if (m_series->count() >= CHRONO_RAW_SAMPLES) {
+        m_series->removeFirst();
+    }
+    m_series->append(x, y);
+    m_levels.append(x, y);
+}
+
+void ChronoPlotData::removeStaleSamples()
+{
+    while (!m_series->isEmpty() &&
+           (m_series->last().x() - m_series->first().x()) > m_plotDataSize) {
+        m_series->removeFirst();
+    }
+    if (!m_series->isEmpty()) {
+        m_levels.removeBefore(m_series->last().x() - m_plotDataSize);
+    }
+}
+
+/**
+ * The raw samples are drawn while they cover the window, the levels afterwards
+ */
+void ChronoPlotData::prepareSamples(int columns)
+{
+    if (m_series->isEmpty() || m_series->count() < CHRONO_RAW_SAMPLES) {
+        PlotData::prepareSamples(columns);
+        return;
+    }
+
+    double from = m_series->last().x() - m_plotDataSize;
+    if (m_series->first().x() <= from) {
+        PlotData::prepareSamples(columns);
+    } else {
+        m_levels.prepare(from, columns, m_prepared, m_preparedRect);
+        m_preparedValue = m_series->last().y();
+    }
+}
+
+/**
+ * Fills a new curve with the values its field had over the window, so it does
+ * not start empty. Enum curves keep starting from the current value.
+ */
+void ChronoPlotData::backfill(const UAVObjectHistory *history)
 {
-    while (!m_xDataEntries.isEmpty() &&
-           (m_xDataEntries.last() - m_xDataEntries.first()) > m_plotDataSize) {
-        m_yDataEntries.pop_front();
-        m_xDataEntries.pop_front();
+    if (m_isEnumPlot || !history) {
+        return;
     }
+
+    const bool math = hasMathFunction();
+    const double scale = pow(10, m_scalePower);
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    UAVObjectHistory::View view = history->range(m_object, m_field, m_element, now - (qint64)(m_plotDataSize * 1000), now);
+    UAVObjectHistory::Sample sample;
+    bool appended = false;
+
+    while (view.next(&sample)) {
+        double value = sample.value * scale;
+        appendSample(sample.time / 1000.0, math ? calcMathFunction(value) : value);
+        appended = true;
+    }
+    if (appended) {
+        removeStaleSamples();
+        m_dirty = true;
+    }
+}
+
+void ChronoPlotData::clear()
+{
+    m_levels.clear();
+    PlotData::clear();
+}
+
+/**
+ * Worker thread. The curve takes the column of its object, field and element,
+ * the scope math is not applied to a log.
+ */
+void ChronoPlotData::buildPlayback(const ScopePlaybackLog *log)
+{
+    QString name = QString("%1.%2").arg(m_object->getName()).arg(m_field->getName());
+
+    if (!m_elementName.isEmpty()) {
+        name.append(QString(".%1").arg(m_elementName));
+    }
+    const ScopePlaybackLog::Column *column = log->column(name);
+    if (column) {
+        m_pyramid.build(*column);
+    } else {
+        m_pyramid.clear();
+    }
+}
+
+void ChronoPlotData::showPlayback(double from, double to, int columns)
+{
+    QVector<QPointF> samples;
+    QRectF boundingRect;
+
+    m_pyramid.prepare(from, to, pow(10, m_scalePower), columns, samples, boundingRect);
+    m_curveData->swapSamples(samples, boundingRect);
+}
+
+/**
+ * Drops the log, the curve starts over with the live samples
+ */
+void ChronoPlotData::endPlayback()
+{
+    m_pyramid.clear();
+    clear();
+}
+
+void ChronoPlotData::removeStaleData()
+{
     while (!m_enumMarkerList.isEmpty() &&
            (m_enumMarkerList.last()->xValue() - m_enumMarkerList.first()->xValue()) > m_plotDataSize) {
         QwtPlotMarker *marker = m_enumMarkerList.takeFirst();
@@ -301,3 +954,401 @@ void ChronoPlotData::removeStaleData()
         delete marker;
     }
 }
+
+WaterfallPlotData::WaterfallPlotData(UAVObject *object, UAVObjectField *field, int element,
+                                     int scaleFactor, int meanSamples, QString mathFunction,
+                                     double plotDataSize, QPen pen, bool antialiased)
+    : PlotData(object, field, element, scaleFactor, meanSamples,
+               mathFunction, plotDataSize, pen, antialiased),
+    m_rows(qMax((int)plotDataSize, 1)), m_columns(field->getNumElements()), m_rowCount(0), m_updated(false)
+{
+    // The whole field is one row, the element is not part of the name
+    m_elementName.clear();
+    m_plotName = QString("%1.%2").arg(m_object->getName()).arg(m_field->getName());
+    if (m_scalePower == 0) {
+        m_plotName.append(QString(" (%1)").arg(m_field->getUnits()));
+    } else {
+        m_plotName.append(QString(" (x10^%1 %2)").arg(m_scalePower).arg(m_field->getUnits()));
+    }
+    m_isEnumPlot = false;
+
+    m_values.fill(0.0, m_rows * m_columns);
+    m_rasterData = new QwtMatrixRasterData();
+    m_rasterData->setValueMatrix(m_values, m_columns);
+    m_rasterData->setInterval(Qt::XAxis, QwtInterval(0, m_columns));
+    m_rasterData->setInterval(Qt::YAxis, QwtInterval(0, m_rows));
+    m_rasterData->setInterval(Qt::ZAxis, QwtInterval(0, 1));
+
+    QwtLinearColorMap *colorMap = new QwtLinearColorMap(QColor(0, 0, 64), Qt::red);
+    colorMap->addColorStop(0.25, Qt::blue);
+    colorMap->addColorStop(0.5, Qt::green);
+    colorMap->addColorStop(0.75, Qt::yellow);
+
+    m_spectrogram = new QwtPlotSpectrogram(m_plotName);
+    m_spectrogram->setItemAttribute(QwtPlotItem::Legend, true);
+    m_spectrogram->setColorMap(colorMap);
+    m_spectrogram->setData(m_rasterData);
+}
+
+WaterfallPlotData::~WaterfallPlotData()
+{
+    m_spectrogram->detach();
+    delete m_spectrogram;
+}
+
+bool WaterfallPlotData::isVisible() const
+{
+    return m_spectrogram->isVisible();
+}
+
+void WaterfallPlotData::setVisible(bool visible)
+{
+    m_spectrogram->setVisible(visible);
+}
+
+void WaterfallPlotData::attach(QwtPlot *plot)
+{
+    m_spectrogram->attach(plot);
+}
+
+bool WaterfallPlotData::append(UAVObject *obj)
+{
+    if (obj == NULL) {
+        obj = m_object;
+    }
+
+    if (m_object == obj && m_field) {
+        // Scroll by one row, the oldest drops out
+        m_values.remove((m_rows - 1) * m_columns, m_columns);
+        m_values.insert(0, m_columns, 0.0);
+
+        const double scale = pow(10, m_scalePower);
+        double maxValue    = 0.0;
+        for (int i = 0; i < m_columns; ++i) {
+            m_values[i] = m_field->getDouble(i) * scale;
+            maxValue    = i == 0 ? m_values[i] : qMax(maxValue, m_values[i]);
+        }
+        m_rowCount  = qMin(m_rowCount + 1, m_rows);
+        m_lastValue = maxValue;
+        m_hasValue  = true;
+        m_updated   = true;
+        return true;
+    }
+    return false;
+}
+
+void WaterfallPlotData::updatePlotData()
+{
+    if (!m_updated) {
+        return;
+    }
+    m_updated = false;
+
+    // Colors span the current content of the matrix
+    double maxValue = 0.0;
+    for (int i = 0; i < m_rowCount * m_columns; ++i) {
+        maxValue = qMax(maxValue, m_values.at(i));
+    }
+    m_rasterData->setValueMatrix(m_values, m_columns);
+    m_rasterData->setInterval(Qt::ZAxis, QwtInterval(0, maxValue > 0.0 ? maxValue : 1.0));
+    m_spectrogram->itemChanged();
+}
+
+void WaterfallPlotData::clear()
+{
+    PlotData::clear();
+    m_values.fill(0.0);
+    m_rowCount = 0;
+    m_updated  = true;
+}
+
+// Limits of the spectrum length, in samples
+#define SPECTRUM_MIN_SIZE 16
+#define SPECTRUM_MAX_SIZE 8192
+
+/**
+ * In place radix 2 FFT, size is a power of 2
+ */
+static void fft(double *re, double *im, int size)
+{
+    // Bit reversed order
+    for (int i = 1, j = 0; i < size; ++i) {
+        int bit = size >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            qSwap(re[i], re[j]);
+            qSwap(im[i], im[j]);
+        }
+    }
+
+    for (int length = 2; length <= size; length <<= 1) {
+        const double angle = -2.0 * M_PI / length;
+        const double stepRe = cos(angle);
+        const double stepIm = sin(angle);
+        for (int i = 0; i < size; i += length) {
+            double wRe = 1.0;
+            double wIm = 0.0;
+            for (int k = 0; k < length / 2; ++k) {
+                int a = i + k;
+                int b = a + length / 2;
+                double tRe = re[b] * wRe - im[b] * wIm;
+                double tIm = re[b] * wIm + im[b] * wRe;
+                re[b] = re[a] - tRe;
+                im[b] = im[a] - tIm;
+                re[a] += tRe;
+                im[a] += tIm;
+                double nextRe = wRe * stepRe - wIm * stepIm;
+                wIm = wRe * stepIm + wIm * stepRe;
+                wRe = nextRe;
+            }
+        }
+    }
+}
+
+SpectrumPlotData::SpectrumPlotData(UAVObject *object, UAVObjectField *field, int element,
+                                   int scaleFactor, int meanSamples, QString mathFunction,
+                                   double plotDataSize, QPen pen, bool antialiased)
+    : PlotData(object, field, element, scaleFactor, meanSamples,
+               mathFunction, plotDataSize, pen, antialiased),
+    m_fftSize(SPECTRUM_MIN_SIZE), m_windowPos(0), m_windowCount(0), m_newSamples(0), m_hannSum(0.0),
+    m_maxAmplitude(0.0), m_peakFrequency(0.0)
+{
+    while (m_fftSize * 2 <= qMin(plotDataSize, (double)SPECTRUM_MAX_SIZE)) {
+        m_fftSize *= 2;
+    }
+    m_window.resize(m_fftSize);
+    m_times.resize(m_fftSize);
+    m_re.resize(m_fftSize);
+    m_im.resize(m_fftSize);
+    m_spectrum.resize(m_fftSize / 2 + 1);
+
+    m_hann.resize(m_fftSize);
+    for (int i = 0; i < m_fftSize; ++i) {
+        m_hann[i]  = 0.5 - 0.5 * cos(2.0 * M_PI * i / (m_fftSize - 1));
+        m_hannSum += m_hann[i];
+    }
+    m_isEnumPlot = false;
+}
+
+bool SpectrumPlotData::append(UAVObject *obj)
+{
+    if (obj == NULL) {
+        obj = m_object;
+    }
+
+    if (m_object == obj && m_field) {
+        QDateTime NOW = QDateTime::currentDateTime();
+        double xValue = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+
+        queueSample(xValue, m_field->getDouble(m_element) * pow(10, m_scalePower));
+        return true;
+    }
+    return false;
+}
+
+bool SpectrumPlotData::processSamples()
+{
+    QPointF sample;
+
+    while (m_queue.pop(&sample)) {
+        m_times[m_windowPos]  = sample.x();
+        m_window[m_windowPos] = sample.y();
+        if (++m_windowPos == m_fftSize) {
+            m_windowPos = 0;
+        }
+        m_windowCount = qMin(m_windowCount + 1, m_fftSize);
+        m_newSamples++;
+    }
+
+    // Windows overlap by half, when the worker is late only the newest is computed
+    if (m_windowCount < m_fftSize || m_newSamples < m_fftSize / 2) {
+        return false;
+    }
+    m_newSamples = 0;
+    computeSpectrum();
+    return true;
+}
+
+void SpectrumPlotData::computeSpectrum()
+{
+    double mean = 0.0;
+
+    for (int i = 0; i < m_fftSize; ++i) {
+        mean += m_window.at(i);
+    }
+    mean /= m_fftSize;
+
+    // Oldest sample first
+    for (int i = 0; i < m_fftSize; ++i) {
+        int index = m_windowPos + i;
+        if (index >= m_fftSize) {
+            index -= m_fftSize;
+        }
+        m_re[i] = (m_window.at(index) - mean) * m_hann.at(i);
+        m_im[i] = 0.0;
+    }
+    fft(m_re.data(), m_im.data(), m_fftSize);
+
+    // Bins in Hz, or in cycles per sample when the samples came in a burst
+    double span = m_times.at(m_windowPos == 0 ? m_fftSize - 1 : m_windowPos - 1) - m_times.at(m_windowPos);
+    double binWidth = span > 0.0 ? (m_fftSize - 1) / span / m_fftSize : 1.0 / m_fftSize;
+
+    m_maxAmplitude  = 0.0;
+    m_peakFrequency = 0.0;
+    for (int i = 0; i <= m_fftSize / 2; ++i) {
+        // Single sided amplitude, corrected for the window gain
+        double amplitude = sqrt(m_re.at(i) * m_re.at(i) + m_im.at(i) * m_im.at(i)) * 2.0 / m_hannSum;
+        m_spectrum[i] = QPointF(i * binWidth, amplitude);
+        if (amplitude > m_maxAmplitude) {
+            m_maxAmplitude  = amplitude;
+            m_peakFrequency = i * binWidth;
+        }
+    }
+}
+
+void SpectrumPlotData::prepareSamples(int columns)
+{
+    Q_UNUSED(columns);
+    m_prepared     = m_spectrum;
+    m_preparedRect = QRectF(0.0, 0.0, m_spectrum.last().x(), m_maxAmplitude);
+    m_preparedValue = m_peakFrequency;
+}
+
+void SpectrumPlotData::clear()
+{
+    m_windowPos   = 0;
+    m_windowCount = 0;
+    m_newSamples  = 0;
+    PlotData::clear();
+}
+
+// Number of histogram bins and the margin added on both sides of the range when it is recomputed
+#define HISTOGRAM_BINS   64
+#define HISTOGRAM_MARGIN 0.1
+
+HistogramPlotData::HistogramPlotData(UAVObject *object, UAVObjectField *field, int element,
+                                     int scaleFactor, int meanSamples, QString mathFunction,
+                                     double plotDataSize, QPen pen, bool antialiased)
+    : PlotData(object, field, element, scaleFactor, meanSamples,
+               mathFunction, plotDataSize, pen, antialiased),
+    m_windowPos(0), m_windowCount(0), m_sum(0.0), m_low(0.0), m_binWidth(0.0), m_maxCount(0)
+{
+    m_window.resize(qMax((int)plotDataSize, 1));
+    m_bins.fill(0, HISTOGRAM_BINS);
+    m_isEnumPlot = false;
+
+    // Every bin is drawn as a step from its lower edge
+    m_plotCurve->setStyle(QwtPlotCurve::Steps);
+}
+
+bool HistogramPlotData::append(UAVObject *obj)
+{
+    if (obj == NULL) {
+        obj = m_object;
+    }
+
+    if (m_object == obj && m_field) {
+        queueSample(0, m_field->getDouble(m_element) * pow(10, m_scalePower));
+        return true;
+    }
+    return false;
+}
+
+int HistogramPlotData::binIndex(double value) const
+{
+    if (m_binWidth <= 0.0) {
+        return -1;
+    }
+    double index = floor((value - m_low) / m_binWidth);
+    return (index < 0.0 || index >= HISTOGRAM_BINS) ? -1 : (int)index;
+}
+
+/**
+ * Sets the range to what the window and the new value span and counts the window again
+ */
+void HistogramPlotData::rebin(double value)
+{
+    double low  = value;
+    double high = value;
+
+    for (int i = 0; i < m_windowCount; ++i) {
+        low  = qMin(low, m_window.at(i));
+        high = qMax(high, m_window.at(i));
+    }
+    double margin = (high - low) * HISTOGRAM_MARGIN;
+    if (margin <= 0.0) {
+        margin = qMax(fabs(value) * HISTOGRAM_MARGIN, 1e-6);
+    }
+    m_low      = low - margin;
+    m_binWidth = (high - low + 2.0 * margin) / HISTOGRAM_BINS;
+
+    // The sum is recomputed as well, so it does not drift
+    m_sum = 0.0;
+    m_bins.fill(0);
+    for (int i = 0; i < m_windowCount; ++i) {
+        m_sum += m_window.at(i);
+        m_bins[binIndex(m_window.at(i))]++;
+    }
+}
+
+bool HistogramPlotData::processSamples()
+{
+    QPointF sample;
+    bool appended = false;
+
+    while (m_queue.pop(&sample)) {
+        double value = sample.y();
+
+        if (m_windowCount == m_window.size()) {
+            double oldest = m_window.at(m_windowPos);
+            m_sum -= oldest;
+            m_bins[binIndex(oldest)]--;
+        } else {
+            m_windowCount++;
+        }
+        m_window[m_windowPos] = value;
+        if (++m_windowPos == m_window.size()) {
+            m_windowPos = 0;
+        }
+        m_sum += value;
+
+        int index = binIndex(value);
+        if (index < 0) {
+            // rebin() counts the new value with the window
+            rebin(value);
+        } else {
+            m_bins[index]++;
+        }
+        appended = true;
+    }
+    return appended;
+}
+
+void HistogramPlotData::prepareSamples(int columns)
+{
+    Q_UNUSED(columns);
+    m_prepared.resize(HISTOGRAM_BINS + 1);
+    m_maxCount = 0;
+    for (int i = 0; i < HISTOGRAM_BINS; ++i) {
+        m_prepared[i] = QPointF(m_low + i * m_binWidth, m_bins.at(i));
+        m_maxCount    = qMax(m_maxCount, m_bins.at(i));
+    }
+    // Closes the last step
+    m_prepared[HISTOGRAM_BINS] = QPointF(m_low + HISTOGRAM_BINS * m_binWidth, m_bins.at(HISTOGRAM_BINS - 1));
+
+    m_preparedRect  = QRectF(m_low, 0.0, HISTOGRAM_BINS * m_binWidth, m_maxCount);
+    m_preparedValue = m_windowCount ? m_sum / m_windowCount : 0.0;
+}
+
+void HistogramPlotData::clear()
+{
+    m_windowPos   = 0;
+    m_windowCount = 0;
+    m_sum      = 0.0;
+    m_binWidth = 0.0;
+    m_bins.fill(0);
+    PlotData::clear();
+}
@@ -29,6 +29,7 @@
 #define PLOTDATA_H
 
 #include "uavobject.h"
+#include "scopeplayback.h"
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_plot.h"
@@ -36,16 +37,191 @@
 #include "qwt/src/qwt_scale_draw.h"
 #include "qwt/src/qwt_scale_widget.h"
 #include <qwt/src/qwt_plot_marker.h>
+#include <qwt/src/qwt_series_data.h>
+#include <qwt/src/qwt_plot_spectrogram.h>
+#include <qwt/src/qwt_matrix_raster_data.h>
 
 #include <QTimer>
 #include <QTime>
 #include <QVector>
+#include <QAtomicInt>
 #include <uavdataobject.h>
+#include <uavobjecthistory.h>
 
 /*!
    \brief Defines the different type of plots.
  */
-enum PlotType { SequentialPlot, ChronoPlot };
+enum PlotType { SequentialPlot, ChronoPlot, WaterfallPlot, SpectrumPlot, HistogramPlot };
+
+/*!
+   \brief Lock-free queue of the raw samples of one curve, pushed by the GUI thread
+   and taken by the worker which processes the curve.
+ */
+class PlotSampleQueue {
+public:
+    PlotSampleQueue(int capacity);
+
+    bool push(const QPointF &sample);
+    bool pop(QPointF *sample);
+    void clear();
+
+private:
+    QVector<QPointF> m_samples;
+    QPointF *m_data;
+    int m_mask;
+    // m_head is only written by the producer, m_tail only by the consumer
+    QAtomicInt m_head;
+    QAtomicInt m_tail;
+};
+
+/*!
+   \brief Ring buffer with the samples of one curve, only used by the worker thread.
+
+   prepare() copies the samples to draw. When there are more samples than pixel
+   columns on the canvas, they are reduced to the minimum and maximum of every column
+   of the visible x range.
+   A sequential series uses the sample index as x value.
+ */
+class PlotDataSeries {
+public:
+    PlotDataSeries(bool indexAsX, int capacity);
+
+    void append(double x, double y);
+    void removeFirst();
+    void clear();
+    void prepare(double from, double to, int columns, QVector<QPointF> &samples, QRectF &boundingRect) const;
+
+    int count() const
+    {
+        return m_count;
+    }
+    bool isEmpty() const
+    {
+        return m_count == 0;
+    }
+    QPointF first() const
+    {
+        return rawSample(0);
+    }
+    QPointF last() const
+    {
+        return rawSample(m_count - 1);
+    }
+
+private:
+    QVector<QPointF> m_buffer;
+    int m_first;
+    int m_count;
+    bool m_indexAsX;
+    bool m_fixedCapacity;
+
+    QPointF rawSample(int i) const
+    {
+        int index = m_first + i;
+
+        if (index >= m_buffer.size()) {
+            index -= m_buffer.size();
+        }
+        return m_indexAsX ? QPointF(i, m_buffer.at(index).y()) : m_buffer.at(index);
+    }
+};
+
+/*!
+   \brief Min/max/mean of the samples of a curve over fixed time buckets, at several
+   resolutions, each level has buckets four times longer than the previous one.
+   Only used by the worker thread.
+
+   Every level keeps a bounded number of buckets, so a long chrono window takes a
+   bounded amount of memory. prepare() draws the finest level which covers the window
+   with a few buckets per pixel column, so the cost does not grow with the window either.
+ */
+class PlotDataLevels {
+public:
+    PlotDataLevels();
+
+    void append(double x, double y);
+    void removeBefore(double x);
+    void clear();
+    void prepare(double from, int columns, QVector<QPointF> &samples, QRectF &boundingRect) const;
+
+private:
+    struct Bucket {
+        double time; // start of the bucket
+        double min;
+        double max;
+        double sum;
+        int    count;
+    };
+    struct Level {
+        QVector<Bucket> buckets;
+        int    first;
+        int    count;
+        double duration;
+
+        Bucket &at(int i)
+        {
+            int index = first + i;
+
+            return buckets[index >= buckets.size() ? index - buckets.size() : index];
+        }
+        const Bucket &at(int i) const
+        {
+            int index = first + i;
+
+            return buckets.at(index >= buckets.size() ? index - buckets.size() : index);
+        }
+        void push(const Bucket &bucket);
+        void removeFirst();
+    };
+    QVector<Level> m_levels;
+};
+
+/*!
+   \brief Min/max pyramid over all the samples of a recorded curve, built once.
+
+   The samples are shared with the log. Level 1 holds the min and max of every four
+   samples, every next level of every four buckets of the previous one. prepare() draws
+   the finest level with at most two buckets per pixel column in the window, so drawing
+   the whole flight costs as much as drawing a few seconds of it.
+ */
+class PlotDataPyramid {
+public:
+    PlotDataPyramid();
+
+    void build(const ScopePlaybackLog::Column &column);
+    void clear();
+    void prepare(double from, double to, double scale, int columns, QVector<QPointF> &samples, QRectF &boundingRect) const;
+
+private:
+    struct Level {
+        QVector<float> min;
+        QVector<float> max;
+    };
+    QVector<quint32> m_timeStamps;
+    QVector<double>  m_samples;
+    QVector<Level>   m_levels;
+
+    double time(int index) const
+    {
+        return m_timeStamps.at(index) / 1000.0;
+    }
+};
+
+/*!
+   \brief The samples a curve draws, swapped in by the GUI thread when the worker has prepared new ones.
+ */
+class PlotCurveData : public QwtArraySeriesData<QPointF> {
+public:
+    QRectF boundingRect() const
+    {
+        return d_boundingRect;
+    }
+    void swapSamples(QVector<QPointF> &samples, const QRectF &boundingRect)
+    {
+        d_samples.swap(samples);
+        d_boundingRect = boundingRect;
+    }
+};
 
 /*!
    \brief Base class that keeps the data for each curve in the plot.
@@ -56,7 +232,7 @@ class PlotData : public QObject {
 public:
     PlotData(UAVObject *object, UAVObjectField *field, int element, int scaleOrderFactor, int meanSamples,
              QString mathFunction, double plotDataSize, QPen pen, bool antialiased);
-    ~PlotData();
+    virtual ~PlotData();
 
     QString plotName() const
     {
@@ -80,25 +256,31 @@ public:
         return m_elementName;
     }
 
-    bool isVisible() const;
-    void setVisible(bool visible);
+    virtual bool isVisible() const;
+    virtual void setVisible(bool visible);
 
     bool wantsInitialData()
     {
         return m_isEnumPlot;
     }
 
+    // GUI thread
     virtual bool append(UAVObject *obj) = 0;
     virtual PlotType plotType() const   = 0;
     virtual void removeStaleData() = 0;
 
-    void updatePlotData();
-    void clear();
+    // Worker thread, never at the same time as clear()
+    virtual void process(int columns);
+
+    // GUI thread
+    virtual void updatePlotData();
+    virtual void clear();
 
     bool hasData() const;
     QString lastDataAsString();
+    double lastData();
 
-    void attach(QwtPlot *plot);
+    virtual void attach(QwtPlot *plot);
 
 public slots:
     void visibilityChanged(QwtPlotItem *item);
@@ -108,14 +290,35 @@ protected:
     int m_scalePower;
     int m_meanSamples;
     double m_meanSum;
+    double m_meanSquareSum;
     QString m_mathFunction;
     double m_correctionSum;
+    double m_correctionSquareSum;
     int m_correctionCount;
     double m_plotDataSize;
 
-    QVector<double> m_xDataEntries;
-    QVector<double> m_yDataEntries;
+    // Raw samples from the GUI thread to the worker
+    PlotSampleQueue m_queue;
+
+    // Worker side, the processed samples
+    PlotDataSeries *m_series;
+    bool m_dirty;
+
+    // Handed from the worker to the GUI thread while m_preparedReady is set
+    QVector<QPointF> m_prepared;
+    QRectF m_preparedRect;
+    double m_preparedValue;
+    QAtomicInt m_preparedReady;
+
+    // GUI side, owned by m_plotCurve
+    PlotCurveData *m_curveData;
+    double m_lastValue;
+    bool m_hasValue;
+
+    // Window of the last m_meanSamples values for the scope math
     QVector<double> m_yDataHistory;
+    int m_historyIndex;
+    int m_historyCount;
 
     UAVObject *m_object;
     UAVObjectField *m_field;
@@ -127,7 +330,22 @@ protected:
     bool m_isVisible;
     QPen m_pen;
     bool m_isEnumPlot;
-    virtual void calcMathFunction(double currentValue);
+    bool hasMathFunction() const;
+    virtual double calcMathFunction(double currentValue);
+    void queueSample(double x, double value);
+    // Worker thread: take the queued samples, true if there is something new to draw,
+    // then fill m_prepared, m_preparedRect and m_preparedValue
+    virtual bool processSamples();
+    virtual void appendSample(double x, double y);
+    virtual void prepareSamples(int columns);
+    virtual void removeStaleSamples() {}
+    // The x range shown by the axis, the decimation columns are spread over it
+    virtual void visibleRange(double &from, double &to) const;
+    // The legend and the logging show the value computed by the worker, not the raw one
+    virtual bool showsProcessedValue() const
+    {
+        return hasMathFunction();
+    }
     QwtPlotMarker *createMarker(QString value);
 };
 
@@ -142,7 +360,10 @@ public:
                        int scaleFactor, int meanSamples, QString mathFunction,
                        double plotDataSize, QPen pen, bool antialiased)
         : PlotData(object, field, element, scaleFactor, meanSamples,
-                   mathFunction, plotDataSize, pen, antialiased) {}
+                   mathFunction, plotDataSize, pen, antialiased)
+    {
+        m_series = new PlotDataSeries(true, (int)plotDataSize);
+    }
     ~SequentialPlotData() {}
 
     bool append(UAVObject *obj);
@@ -151,10 +372,18 @@ public:
         return SequentialPlot;
     }
     void removeStaleData() {}
+
+protected:
+    void visibleRange(double &from, double &to) const
+    {
+        from = 0.0;
+        to   = m_plotDataSize;
+    }
 };
 
 /*!
    \brief The chrono plot have a variable sized buffer of data, where the data is for a specified time period.
+   The raw samples are bounded, older ones are only kept in the min/max/mean levels.
  */
 class ChronoPlotData : public PlotData {
     Q_OBJECT
@@ -164,7 +393,9 @@ public:
                    double plotDataSize, QPen pen, bool antialiased)
         : PlotData(object, field, element, scaleFactor, meanSamples,
                    mathFunction, plotDataSize, pen, antialiased)
-    {}
+    {
+        m_series = new PlotDataSeries(false, 0);
+    }
     ~ChronoPlotData() {}
 
     bool append(UAVObject *obj);
@@ -173,6 +404,160 @@ public:
         return ChronoPlot;
     }
     void removeStaleData();
+    void clear();
+
+    // GUI thread, before the curve is handed to the worker
+    void backfill(const UAVObjectHistory *history);
+
+    // Playback of a recorded log, x is the log time in seconds. Built on the
+    // worker thread, drawn and ended on the GUI thread.
+    void buildPlayback(const ScopePlaybackLog *log);
+    void showPlayback(double from, double to, int columns);
+    void endPlayback();
+
+protected:
+    void appendSample(double x, double y);
+    void prepareSamples(int columns);
+    void removeStaleSamples();
+
+private:
+    PlotDataLevels m_levels;
+    PlotDataPyramid m_pyramid;
+};
+
+/*!
+   \brief The waterfall plot shows every update of an array field as one row of a
+   spectrogram, the newest row at the bottom. Meant for spectra like VibrationAnalysisOutput.
+   The largest value of every row is kept for the legend and the logging.
+   The rows are small, they are handled on the GUI thread.
+ */
+class WaterfallPlotData : public PlotData {
+    Q_OBJECT
+public:
+    WaterfallPlotData(UAVObject *object, UAVObjectField *field, int element,
+                      int scaleFactor, int meanSamples, QString mathFunction,
+                      double plotDataSize, QPen pen, bool antialiased);
+    ~WaterfallPlotData();
+
+    bool append(UAVObject *obj);
+    PlotType plotType() const
+    {
+        return WaterfallPlot;
+    }
+    void removeStaleData() {}
+
+    bool isVisible() const;
+    void setVisible(bool visible);
+    void process(int) {}
+    void updatePlotData();
+    void clear();
+    void attach(QwtPlot *plot);
+
+private:
+    // Owned by m_spectrogram
+    QwtMatrixRasterData *m_rasterData;
+    QwtPlotSpectrogram *m_spectrogram;
+
+    // m_rows rows of m_columns values, the newest first
+    QVector<double> m_values;
+    int m_rows;
+    int m_columns;
+    int m_rowCount;
+    bool m_updated;
+};
+
+/*!
+   \brief The spectrum plot shows the amplitude spectrum of the last plotDataSize samples
+   (rounded to a power of 2) of a field, in its units over Hz. The mean is removed and
+   the samples are Hann windowed. A new spectrum is computed every half window, the sample
+   rate is estimated from the arrival times. The legend and the logging show the peak frequency.
+ */
+class SpectrumPlotData : public PlotData {
+    Q_OBJECT
+public:
+    SpectrumPlotData(UAVObject *object, UAVObjectField *field, int element,
+                     int scaleFactor, int meanSamples, QString mathFunction,
+                     double plotDataSize, QPen pen, bool antialiased);
+    ~SpectrumPlotData() {}
+
+    bool append(UAVObject *obj);
+    PlotType plotType() const
+    {
+        return SpectrumPlot;
+    }
+    void removeStaleData() {}
+    void clear();
+
+protected:
+    bool processSamples();
+    void prepareSamples(int columns);
+    bool showsProcessedValue() const
+    {
+        return true;
+    }
+
+private:
+    int m_fftSize;
+    // The last m_fftSize samples and their times, m_windowPos is the oldest once full
+    QVector<double> m_window;
+    QVector<double> m_times;
+    int m_windowPos;
+    int m_windowCount;
+    int m_newSamples;
+    QVector<double> m_hann;
+    double m_hannSum;
+    // FFT work buffers and the last spectrum
+    QVector<double> m_re;
+    QVector<double> m_im;
+    QVector<QPointF> m_spectrum;
+    double m_maxAmplitude;
+    double m_peakFrequency;
+
+    void computeSpectrum();
+};
+
+/*!
+   \brief The histogram plot shows the distribution of the last plotDataSize samples
+   of a field. The bins are updated as samples enter and leave the window, they are only
+   recomputed when a sample falls out of their range. The legend and the logging show the mean.
+ */
+class HistogramPlotData : public PlotData {
+    Q_OBJECT
+public:
+    HistogramPlotData(UAVObject *object, UAVObjectField *field, int element,
+                      int scaleFactor, int meanSamples, QString mathFunction,
+                      double plotDataSize, QPen pen, bool antialiased);
+    ~HistogramPlotData() {}
+
+    bool append(UAVObject *obj);
+    PlotType plotType() const
+    {
+        return HistogramPlot;
+    }
+    void removeStaleData() {}
+    void clear();
+
+protected:
+    bool processSamples();
+    void prepareSamples(int columns);
+    bool showsProcessedValue() const
+    {
+        return true;
+    }
+
+private:
+    // The last samples, m_windowPos is the oldest once full
+    QVector<double> m_window;
+    int m_windowPos;
+    int m_windowCount;
+    double m_sum;
+    QVector<int> m_bins;
+    double m_low;
+    double m_binWidth;
+    int m_maxCount;
+
+    int binIndex(double value) const;
+    void rebin(double value);
 };
 
 #endif // PLOTDATA_H
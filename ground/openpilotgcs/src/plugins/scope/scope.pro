@@ -9,16 +9,19 @@ include (scope_dependencies.pri)
 HEADERS += \
     scopeplugin.h \
     plotdata.h \
+    scopelogwriter.h \
     scope_global.h \
     scopegadgetoptionspage.h \
     scopegadgetconfiguration.h \
     scopegadget.h \
     scopegadgetwidget.h \
-    scopegadgetfactory.h
+    scopegadgetfactory.h \
+    scopeplayback.h
 
 SOURCES += \
     scopeplugin.cpp \
     plotdata.cpp \
+    scopelogwriter.cpp \
     scopegadgetoptionspage.cpp \
     scopegadgetconfiguration.cpp \
     scopegadget.cpp \
@@ -50,11 +50,18 @@ void ScopeGadget::loadConfiguration(IUAVGadgetConfiguration *config)
     widget->setObjectName(config->name());
     widget->setPlotDataSize(sgConfig->dataSize());
     widget->setRefreshInterval(sgConfig->refreshInterval());
+    widget->setOpenGLCanvas(sgConfig->openGLCanvas());
 
     if (sgConfig->plotType() == SequentialPlot) {
         widget->setupSequentialPlot();
     } else if (sgConfig->plotType() == ChronoPlot) {
         widget->setupChronoPlot();
+    } else if (sgConfig->plotType() == WaterfallPlot) {
+        widget->setupWaterfallPlot();
+    } else if (sgConfig->plotType() == SpectrumPlot) {
+        widget->setupSpectrumPlot();
+    } else if (sgConfig->plotType() == HistogramPlot) {
+        widget->setupHistogramPlot();
     }
 
     foreach(PlotCurveConfiguration * plotCurveConfig, sgConfig->plotCurveConfigs()) {
@@ -83,6 +90,7 @@ void ScopeGadget::loadConfiguration(IUAVGadgetConfiguration *config)
 
     widget->setLoggingEnabled(sgConfig->getLoggingEnabled());
     widget->setLoggingNewFileOnConnect(sgConfig->getLoggingNewFileOnConnect());
+    widget->setLoggingCsv(sgConfig->getLoggingCsv());
     widget->setLoggingPath(sgConfig->getLoggingPath());
 
     widget->csvLoggingStop();
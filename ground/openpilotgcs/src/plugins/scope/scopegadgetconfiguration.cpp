@@ -32,7 +32,9 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings *q
     m_plotType((int)ChronoPlot),
     m_dataSize(60),
     m_refreshInterval(1000),
-    m_mathFunctionType(0)
+    m_openGLCanvas(false),
+    m_mathFunctionType(0),
+    m_loggingCsv(true)
 {
     uint currentStreamVersion = 0;
     int plotCurveCount = 0;
@@ -49,6 +51,7 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings *q
         m_plotType        = qSettings->value("plotType").toInt();
         m_dataSize        = qSettings->value("dataSize").toInt();
         m_refreshInterval = qSettings->value("refreshInterval").toInt();
+        m_openGLCanvas    = qSettings->value("openGLCanvas", false).toBool();
         plotCurveCount    = qSettings->value("plotCurveCount").toInt();
 
         for (int plotDatasLoadIndex = 0; plotDatasLoadIndex < plotCurveCount; plotDatasLoadIndex++) {
@@ -72,6 +75,7 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings *q
 
         m_loggingEnabled = qSettings->value("LoggingEnabled").toBool();
         m_loggingNewFileOnConnect = qSettings->value("LoggingNewFileOnConnect").toBool();
+        m_loggingCsv     = qSettings->value("LoggingCsv", true).toBool();
         m_loggingPath    = qSettings->value("LoggingPath").toString();
     }
 }
@@ -102,6 +106,7 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
     m->setDataSize(m_dataSize);
     m->setMathFunctionType(m_mathFunctionType);
     m->setRefreashInterval(m_refreshInterval);
+    m->setOpenGLCanvas(m_openGLCanvas);
 
     plotCurveCount = m_plotCurveConfigs.size();
 
@@ -124,6 +129,7 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
 
     m->setLoggingEnabled(m_loggingEnabled);
     m->setLoggingNewFileOnConnect(m_loggingNewFileOnConnect);
+    m->setLoggingCsv(m_loggingCsv);
     m->setLoggingPath(m_loggingPath);
 
     return m;
@@ -143,6 +149,7 @@ void ScopeGadgetConfiguration::saveConfig(QSettings *qSettings) const
     qSettings->setValue("plotType", m_plotType);
     qSettings->setValue("dataSize", m_dataSize);
     qSettings->setValue("refreshInterval", m_refreshInterval);
+    qSettings->setValue("openGLCanvas", m_openGLCanvas);
     qSettings->setValue("plotCurveCount", plotCurveCount);
 
     for (plotDatasLoadIndex = 0; plotDatasLoadIndex < plotCurveCount; plotDatasLoadIndex++) {
@@ -164,6 +171,7 @@ void ScopeGadgetConfiguration::saveConfig(QSettings *qSettings) const
 
     qSettings->setValue("LoggingEnabled", m_loggingEnabled);
     qSettings->setValue("LoggingNewFileOnConnect", m_loggingNewFileOnConnect);
+    qSettings->setValue("LoggingCsv", m_loggingCsv);
     qSettings->setValue("LoggingPath", m_loggingPath);
 }
 
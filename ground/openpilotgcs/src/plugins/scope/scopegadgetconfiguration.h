@@ -71,6 +71,10 @@ public:
     {
         m_refreshInterval = value;
     }
+    void setOpenGLCanvas(bool value)
+    {
+        m_openGLCanvas = value;
+    }
     void addPlotCurveConfig(PlotCurveConfiguration *value)
     {
         m_plotCurveConfigs.append(value);
@@ -94,6 +98,10 @@ public:
     {
         return m_refreshInterval;
     }
+    bool openGLCanvas()
+    {
+        return m_openGLCanvas;
+    }
     QList<PlotCurveConfiguration *> plotCurveConfigs()
     {
         return m_plotCurveConfigs;
@@ -110,6 +118,10 @@ public:
     {
         return m_loggingNewFileOnConnect;
     }
+    bool getLoggingCsv()
+    {
+        return m_loggingCsv;
+    }
     QString getLoggingPath()
     {
         return m_loggingPath;
@@ -122,6 +134,10 @@ public:
     {
         m_loggingNewFileOnConnect = value;
     }
+    void setLoggingCsv(bool value)
+    {
+        m_loggingCsv = value;
+    }
     void setLoggingPath(QString value)
     {
         m_loggingPath = value;
@@ -137,6 +153,8 @@ private:
     int m_dataSize;
     // The interval to replot the curve widget. The data buffer is refresh as the data comes in.
     int m_refreshInterval;
+    // Draw the plot on an OpenGL canvas rather than with the raster paint engine
+    bool m_openGLCanvas;
     // The type of math function to be used in the scope analysis
     int m_mathFunctionType;
     QList<PlotCurveConfiguration *> m_plotCurveConfigs;
@@ -144,6 +162,8 @@ private:
     void clearPlotData();
     bool m_loggingEnabled;
     bool m_loggingNewFileOnConnect;
+    // Convert the binary log to CSV when logging stops
+    bool m_loggingCsv;
     QString m_loggingPath;
 };
 
@@ -50,12 +50,27 @@ void ScopeGadgetFactory::startPlotting()
     emit onStartPlotting();
 }
 
+void ScopeGadgetFactory::setPlaybackLog(ScopePlaybackLogPtr log)
+{
+    m_playbackLog = log;
+    emit onPlaybackLog(log);
+}
+
+void ScopeGadgetFactory::setPlaybackPosition(quint32 timeStamp)
+{
+    emit onPlaybackPosition(timeStamp);
+}
+
 Core::IUAVGadget *ScopeGadgetFactory::createGadget(QWidget *parent)
 {
     ScopeGadgetWidget *gadgetWidget = new ScopeGadgetWidget(parent);
 
     connect(this, SIGNAL(onStartPlotting()), gadgetWidget, SLOT(startPlotting()));
     connect(this, SIGNAL(onStopPlotting()), gadgetWidget, SLOT(stopPlotting()));
+    connect(this, SIGNAL(onPlaybackLog(ScopePlaybackLogPtr)), gadgetWidget, SLOT(setPlaybackLog(ScopePlaybackLogPtr)));
+    connect(this, SIGNAL(onPlaybackPosition(quint32)), gadgetWidget, SLOT(setPlaybackPosition(quint32)));
+    connect(gadgetWidget, SIGNAL(playbackPositionRequested(quint32)), this, SIGNAL(playbackPositionRequested(quint32)));
+    gadgetWidget->setPlaybackLog(m_playbackLog);
     return new ScopeGadget(QString("ScopeGadget"), gadgetWidget, parent);
 }
 
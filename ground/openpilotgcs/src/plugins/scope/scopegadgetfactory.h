@@ -29,6 +29,7 @@
 #define SCOPEGADGETFACTORY_H_
 
 #include "scope_global.h"
+#include "scopeplayback.h"
 #include <coreplugin/iuavgadgetfactory.h>
 
 namespace Core {
@@ -51,10 +52,20 @@ public:
 public slots:
     void stopPlotting();
     void startPlotting();
+    // The chrono scopes show the whole log and follow the replay position, a null log ends it
+    void setPlaybackLog(ScopePlaybackLogPtr log);
+    void setPlaybackPosition(quint32 timeStamp);
 
 signals:
     void onStopPlotting();
     void onStartPlotting();
+    void onPlaybackLog(ScopePlaybackLogPtr log);
+    void onPlaybackPosition(quint32 timeStamp);
+    // The user clicked a time of the log on a scope
+    void playbackPositionRequested(quint32 timeStamp);
+
+private:
+    ScopePlaybackLogPtr m_playbackLog;
 };
 
 #endif // SCOPEGADGETFACTORY_H_
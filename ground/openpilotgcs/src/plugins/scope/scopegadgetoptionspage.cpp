@@ -55,6 +55,9 @@ QWidget *ScopeGadgetOptionsPage::createPage(QWidget *parent)
 
     options_page->cmbPlotType->addItem("Sequential Plot", "");
     options_page->cmbPlotType->addItem("Chronological Plot", "");
+    options_page->cmbPlotType->addItem("Waterfall Plot", "");
+    options_page->cmbPlotType->addItem("Spectrum Plot", "");
+    options_page->cmbPlotType->addItem("Histogram Plot", "");
 
     // Fills the combo boxes for the UAVObjects
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -100,6 +103,7 @@ QWidget *ScopeGadgetOptionsPage::createPage(QWidget *parent)
     options_page->mathFunctionComboBox->setCurrentIndex(m_config->mathFunctionType());
     options_page->spnDataSize->setValue(m_config->dataSize());
     options_page->spnRefreshInterval->setValue(m_config->refreshInterval());
+    options_page->openGLCanvasCheckBox->setChecked(m_config->openGLCanvas());
 
     // add the configured curves
     foreach(PlotCurveConfiguration * plotData, m_config->plotCurveConfigs()) {
@@ -132,6 +136,7 @@ QWidget *ScopeGadgetOptionsPage::createPage(QWidget *parent)
     options_page->LoggingPath->setPromptDialogTitle(tr("Choose Logging Directory"));
     options_page->LoggingPath->setPath(m_config->getLoggingPath());
     options_page->LoggingConnect->setChecked(m_config->getLoggingNewFileOnConnect());
+    options_page->LoggingCsv->setChecked(m_config->getLoggingCsv());
     options_page->LoggingEnable->setChecked(m_config->getLoggingEnabled());
     connect(options_page->LoggingEnable, SIGNAL(clicked()), this, SLOT(on_loggingEnable_clicked()));
     on_loggingEnable_clicked();
@@ -275,6 +280,7 @@ void ScopeGadgetOptionsPage::apply()
     m_config->setMathFunctionType(options_page->mathFunctionComboBox->currentIndex());
     m_config->setDataSize(options_page->spnDataSize->value());
     m_config->setRefreashInterval(options_page->spnRefreshInterval->value());
+    m_config->setOpenGLCanvas(options_page->openGLCanvasCheckBox->isChecked());
 
     QList<PlotCurveConfiguration *> plotCurveConfigs;
     for (int iIndex = 0; iIndex < options_page->lstCurves->count(); iIndex++) {
@@ -312,6 +318,7 @@ void ScopeGadgetOptionsPage::apply()
     // save the logging config
     m_config->setLoggingPath(options_page->LoggingPath->path());
     m_config->setLoggingNewFileOnConnect(options_page->LoggingConnect->isChecked());
+    m_config->setLoggingCsv(options_page->LoggingCsv->isChecked());
     m_config->setLoggingEnabled(options_page->LoggingEnable->isChecked());
 }
 
@@ -407,6 +414,7 @@ void ScopeGadgetOptionsPage::on_loggingEnable_clicked()
 
     options_page->LoggingPath->setEnabled(en);
     options_page->LoggingConnect->setEnabled(en);
+    options_page->LoggingCsv->setEnabled(en);
     options_page->LoggingLabel->setEnabled(en);
 }
 
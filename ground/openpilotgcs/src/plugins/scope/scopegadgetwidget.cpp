@@ -53,28 +53,100 @@
 #include <QAction>
 #include <QClipboard>
 #include <QApplication>
+#include <QtNumeric>
+#include <QRunnable>
 
 #include <qwt/src/qwt_legend_label.h>
 #include <qwt/src/qwt_plot_canvas.h>
+#ifndef QWT_NO_OPENGL
+#include <qwt/src/qwt_plot_glcanvas.h>
+#endif
 #include <qwt/src/qwt_plot_layout.h>
 
+/*!
+   \brief Runs PlotData::process() of the curves of a plot on its worker thread.
+ */
+class ScopeProcessingJob : public QRunnable {
+public:
+    ScopeProcessingJob(ScopeGadgetWidget *widget, const QList<PlotData *> &curves, int columns) :
+        m_widget(widget), m_curves(curves), m_columns(columns) {}
+
+    void run()
+    {
+        foreach(PlotData * plotData, m_curves) {
+            plotData->process(m_columns);
+        }
+        m_widget->processingDone();
+    }
+
+private:
+    ScopeGadgetWidget *m_widget;
+    QList<PlotData *> m_curves;
+    int m_columns;
+};
+
+/*!
+   \brief Builds the pyramids of the chrono curves of a plot from a recorded log, on its worker thread.
+ */
+class ScopePlaybackJob : public QRunnable {
+public:
+    ScopePlaybackJob(ScopeGadgetWidget *widget, const QList<PlotData *> &curves, ScopePlaybackLogPtr log, int generation) :
+        m_widget(widget), m_curves(curves), m_log(log), m_generation(generation) {}
+
+    void run()
+    {
+        foreach(PlotData * plotData, m_curves) {
+            static_cast<ChronoPlotData *>(plotData)->buildPlayback(m_log.data());
+        }
+        emit m_widget->curvesBuilt(m_generation);
+    }
+
+private:
+    ScopeGadgetWidget *m_widget;
+    QList<PlotData *> m_curves;
+    ScopePlaybackLogPtr m_log;
+    int m_generation;
+};
+
 ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
+    m_plotType(SequentialPlot),
     m_csvLoggingStarted(false), m_csvLoggingEnabled(false),
     m_csvLoggingHeaderSaved(false), m_csvLoggingDataSaved(false),
     m_csvLoggingNameSet(false), m_csvLoggingDataValid(false),
     m_csvLoggingDataUpdated(false), m_csvLoggingConnected(false),
     m_csvLoggingNewFileOnConnect(false),
+    m_csvLoggingConvert(true),
     m_csvLoggingStartTime(QDateTime::currentDateTime()),
     m_csvLoggingPath("./csvlogging/"),
-    m_plotLegend(NULL)
+    m_csvLoggingWriter(NULL),
+    m_plotLegend(NULL),
+    m_processing(0),
+    m_playbackGeneration(0),
+    m_playbackReady(false),
+    m_playbackBuildPending(false),
+    m_playbackDirty(false),
+    m_playbackFrom(0.0),
+    m_playbackTo(0.0),
+    m_playbackCursor(NULL),
+    m_playbackDragX(0),
+    m_playbackDragFrom(0.0),
+    m_playbackDragging(false),
+    m_playbackDragged(false)
 {
     setMouseTracking(true);
 
-    QwtPlotCanvas *plotCanvas = dynamic_cast<QwtPlotCanvas *>(canvas());
-    if (plotCanvas) {
-        plotCanvas->setFrameStyle(QFrame::StyledPanel | QFrame::Sunken);
-        plotCanvas->setBorderRadius(8);
-    }
+    // A single thread keeps the curves of this plot in order, other plots have their own
+    m_processingPool.setMaxThreadCount(1);
+    connect(this, SIGNAL(curvesProcessed()), this, SLOT(showProcessedData()), Qt::QueuedConnection);
+    connect(this, SIGNAL(curvesBuilt(int)), this, SLOT(playbackBuilt(int)), Qt::QueuedConnection);
+
+    // Replay position in playback, only attached meanwhile
+    m_playbackCursor = new QwtPlotMarker();
+    m_playbackCursor->setLineStyle(QwtPlotMarker::VLine);
+    m_playbackCursor->setLinePen(QPen(QColor(255, 200, 0), 1));
+    m_playbackCursor->setZ(20);
+
+    setOpenGLCanvas(false);
 
     axisWidget(QwtPlot::yLeft)->setMargin(2);
     axisWidget(QwtPlot::xBottom)->setMargin(2);
@@ -96,6 +168,40 @@ ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
 
     setContextMenuPolicy(Qt::CustomContextMenu);
     connect(this, SIGNAL(customContextMenuRequested(const QPoint &)), this, SLOT(popUpMenu(const QPoint &)));
+
+    // Logging data is written from a worker thread
+    m_csvLoggingWriter = new ScopeLogWriter();
+    m_csvLoggingWriter->moveToThread(&m_csvLoggingThread);
+    m_csvLoggingThread.start();
+}
+
+/**
+ * Long curves at short refresh intervals take most of the GUI thread to
+ * rasterize, the OpenGL canvas hands the drawing over to the graphics card.
+ * Qwt built without OpenGL support keeps the raster canvas.
+ */
+void ScopeGadgetWidget::setOpenGLCanvas(bool openGL)
+{
+#ifndef QWT_NO_OPENGL
+    if (openGL) {
+        if (!qobject_cast<QwtPlotGLCanvas *>(canvas())) {
+            QwtPlotGLCanvas *glCanvas = new QwtPlotGLCanvas();
+            glCanvas->setFrameStyle(QFrame::StyledPanel | QFrame::Sunken);
+            setCanvas(glCanvas);
+        }
+        return;
+    }
+#else
+    Q_UNUSED(openGL);
+#endif
+
+    QwtPlotCanvas *plotCanvas = qobject_cast<QwtPlotCanvas *>(canvas());
+    if (!plotCanvas) {
+        plotCanvas = new QwtPlotCanvas();
+        setCanvas(plotCanvas);
+    }
+    plotCanvas->setFrameStyle(QFrame::StyledPanel | QFrame::Sunken);
+    plotCanvas->setBorderRadius(8);
 }
 
 ScopeGadgetWidget::~ScopeGadgetWidget()
@@ -105,6 +211,7 @@ ScopeGadgetWidget::~ScopeGadgetWidget()
         delete replotTimer;
         replotTimer = NULL;
     }
+    waitForProcessing();
 
     // Get the object to de-monitor
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -116,15 +223,36 @@ ScopeGadgetWidget::~ScopeGadgetWidget()
     }
 
     clearCurvePlots();
+    m_playbackCursor->detach();
+    delete m_playbackCursor;
+
+    csvLoggingStop();
+    m_csvLoggingThread.quit();
+    m_csvLoggingThread.wait();
+    delete m_csvLoggingWriter;
 }
 
 void ScopeGadgetWidget::mousePressEvent(QMouseEvent *e)
 {
+    // In playback, dragging pans the log and a click moves the replay there
+    if (playbackActive() && e->button() == Qt::LeftButton) {
+        m_playbackDragX     = e->pos().x();
+        m_playbackDragFrom  = m_playbackFrom;
+        m_playbackDragging  = true;
+        m_playbackDragged   = false;
+    }
     QwtPlot::mousePressEvent(e);
 }
 
 void ScopeGadgetWidget::mouseReleaseEvent(QMouseEvent *e)
 {
+    if (playbackActive() && m_playbackDragging && e->button() == Qt::LeftButton) {
+        m_playbackDragging = false;
+        if (!m_playbackDragged) {
+            double time = invTransform(QwtPlot::xBottom, canvas()->mapFrom(this, e->pos()).x());
+            emit playbackPositionRequested((quint32)qBound(0.0, time * 1000.0, (double)m_playbackLog->duration()));
+        }
+    }
     QwtPlot::mouseReleaseEvent(e);
 }
 
@@ -149,11 +277,32 @@ void ScopeGadgetWidget::mouseDoubleClickEvent(QMouseEvent *e)
 
 void ScopeGadgetWidget::mouseMoveEvent(QMouseEvent *e)
 {
+    if (playbackActive() && m_playbackDragging) {
+        int dx = e->pos().x() - m_playbackDragX;
+        if (qAbs(dx) > 3) {
+            m_playbackDragged = true;
+        }
+        if (m_playbackDragged) {
+            double span = m_playbackTo - m_playbackFrom;
+            double from = m_playbackDragFrom - dx * span / qMax(canvas()->width(), 1);
+            setPlaybackWindow(from, from + span);
+        }
+    }
     QwtPlot::mouseMoveEvent(e);
 }
 
 void ScopeGadgetWidget::wheelEvent(QWheelEvent *e)
 {
+    // In playback the wheel zooms the log about the mouse, the value axis with Ctrl
+    if (playbackActive() && !(e->modifiers() & Qt::ControlModifier)) {
+        double zoomLine  = invTransform(QwtPlot::xBottom, canvas()->mapFrom(this, e->pos()).x());
+        double zoomScale = e->delta() < 0 ? 1.25 : 1 / 1.25;
+        setPlaybackWindow((m_playbackFrom - zoomLine) * zoomScale + zoomLine,
+                          (m_playbackTo - zoomLine) * zoomScale + zoomLine);
+        e->accept();
+        return;
+    }
+
     // Change zoom on scroll wheel event
     QwtInterval yInterval = axisInterval(QwtPlot::yLeft);
 
@@ -258,6 +407,9 @@ void ScopeGadgetWidget::preparePlot(PlotType plotType)
     m_plotType = plotType;
 
     clearCurvePlots();
+    m_playbackGeneration++;
+    m_playbackReady = false;
+    m_playbackCursor->detach();
 
     setMinimumSize(64, 64);
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
@@ -331,6 +483,57 @@ void ScopeGadgetWidget::setupChronoPlot()
     setAxisFont(QwtPlot::yLeft, fnt); // y-axis
 }
 
+void ScopeGadgetWidget::setupWaterfallPlot()
+{
+    preparePlot(WaterfallPlot);
+
+    // x is the element index of the field, y the age of the row in updates
+    setAxisScaleDraw(QwtPlot::xBottom, new QwtScaleDraw());
+    setAxisAutoScale(QwtPlot::xBottom);
+    setAxisLabelRotation(QwtPlot::xBottom, 0.0);
+    setAxisLabelAlignment(QwtPlot::xBottom, Qt::AlignLeft | Qt::AlignBottom);
+
+    // reduce the axis font size
+    QFont fnt(axisFont(QwtPlot::xBottom));
+    fnt.setPointSize(7);
+    setAxisFont(QwtPlot::xBottom, fnt); // x-axis
+    setAxisFont(QwtPlot::yLeft, fnt); // y-axis
+}
+
+void ScopeGadgetWidget::setupSpectrumPlot()
+{
+    preparePlot(SpectrumPlot);
+
+    // x is the frequency in Hz, the data size the number of samples transformed
+    setAxisScaleDraw(QwtPlot::xBottom, new QwtScaleDraw());
+    setAxisAutoScale(QwtPlot::xBottom);
+    setAxisLabelRotation(QwtPlot::xBottom, 0.0);
+    setAxisLabelAlignment(QwtPlot::xBottom, Qt::AlignLeft | Qt::AlignBottom);
+
+    // reduce the axis font size
+    QFont fnt(axisFont(QwtPlot::xBottom));
+    fnt.setPointSize(7);
+    setAxisFont(QwtPlot::xBottom, fnt); // x-axis
+    setAxisFont(QwtPlot::yLeft, fnt); // y-axis
+}
+
+void ScopeGadgetWidget::setupHistogramPlot()
+{
+    preparePlot(HistogramPlot);
+
+    // x is the value, y the number of samples of the last data size samples in its bin
+    setAxisScaleDraw(QwtPlot::xBottom, new QwtScaleDraw());
+    setAxisAutoScale(QwtPlot::xBottom);
+    setAxisLabelRotation(QwtPlot::xBottom, 0.0);
+    setAxisLabelAlignment(QwtPlot::xBottom, Qt::AlignLeft | Qt::AlignBottom);
+
+    // reduce the axis font size
+    QFont fnt(axisFont(QwtPlot::xBottom));
+    fnt.setPointSize(7);
+    setAxisFont(QwtPlot::xBottom, fnt); // x-axis
+    setAxisFont(QwtPlot::yLeft, fnt); // y-axis
+}
+
 void ScopeGadgetWidget::addCurvePlot(QString objectName, QString fieldPlusSubField, int scaleFactor,
                                      int meanSamples, QString mathFunction, QPen pen, bool antialiased)
 {
@@ -376,9 +579,23 @@ void ScopeGadgetWidget::addCurvePlot(QString objectName, QString fieldPlusSubFie
                                           meanSamples, mathFunction, m_plotDataSize,
                                           pen, antialiased);
     } else if (m_plotType == ChronoPlot) {
-        plotData = new ChronoPlotData(object, field, element, scaleFactor,
-                                      meanSamples, mathFunction, m_plotDataSize,
-                                      pen, antialiased);
+        ChronoPlotData *chronoData = new ChronoPlotData(object, field, element, scaleFactor,
+                                                        meanSamples, mathFunction, m_plotDataSize,
+                                                        pen, antialiased);
+        chronoData->backfill(pm->getObject<UAVObjectHistory>());
+        plotData = chronoData;
+    } else if (m_plotType == SpectrumPlot) {
+        plotData = new SpectrumPlotData(object, field, element, scaleFactor,
+                                        meanSamples, mathFunction, m_plotDataSize,
+                                        pen, antialiased);
+    } else if (m_plotType == HistogramPlot) {
+        plotData = new HistogramPlotData(object, field, element, scaleFactor,
+                                         meanSamples, mathFunction, m_plotDataSize,
+                                         pen, antialiased);
+    } else {
+        plotData = new WaterfallPlotData(object, field, element, scaleFactor,
+                                         meanSamples, mathFunction, m_plotDataSize,
+                                         pen, antialiased);
     }
     connect(this, SIGNAL(visibilityChanged(QwtPlotItem *)), plotData, SLOT(visibilityChanged(QwtPlotItem *)));
     plotData->attach(this);
@@ -392,6 +609,12 @@ void ScopeGadgetWidget::addCurvePlot(QString objectName, QString fieldPlusSubFie
         connect(object, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(uavObjectReceived(UAVObject *)));
     }
 
+    // The curves of a configuration come one by one, they are built together
+    if (playbackActive() && !m_playbackBuildPending) {
+        m_playbackBuildPending = true;
+        QMetaObject::invokeMethod(this, "startPlaybackBuild", Qt::QueuedConnection);
+    }
+
     m_mutex.lock();
     replot();
     m_mutex.unlock();
@@ -399,6 +622,10 @@ void ScopeGadgetWidget::addCurvePlot(QString objectName, QString fieldPlusSubFie
 
 void ScopeGadgetWidget::uavObjectReceived(UAVObject *obj)
 {
+    // The replayed objects are already in the log shown
+    if (playbackActive()) {
+        return;
+    }
     foreach(PlotData * plotData, m_curvesData.values()) {
         if (plotData->append(obj)) {
             m_csvLoggingDataUpdated = 1;
@@ -413,6 +640,39 @@ void ScopeGadgetWidget::replotNewData()
         return;
     }
 
+    if (playbackActive()) {
+        if (m_playbackDirty) {
+            showPlayback();
+        }
+        return;
+    }
+
+    // The samples queued since the last refresh are processed off the GUI thread,
+    // a refresh is skipped while the previous one is still being processed
+    if (m_processing.testAndSetAcquire(0, 1)) {
+        m_processingPool.start(new ScopeProcessingJob(this, m_curvesData.values(), canvas()->width()));
+    }
+
+    csvLoggingInsertData();
+}
+
+void ScopeGadgetWidget::processingDone()
+{
+    m_processing.storeRelease(0);
+    emit curvesProcessed();
+}
+
+void ScopeGadgetWidget::waitForProcessing()
+{
+    m_processingPool.waitForDone();
+}
+
+void ScopeGadgetWidget::showProcessedData()
+{
+    if (!isVisible() || playbackActive()) {
+        return;
+    }
+
     QMutexLocker locker(&m_mutex);
     foreach(PlotData * plotData, m_curvesData.values()) {
         plotData->removeStaleData();
@@ -426,13 +686,12 @@ void ScopeGadgetWidget::replotNewData()
         setAxisScale(QwtPlot::xBottom, toTime - m_plotDataSize, toTime);
     }
 
-    csvLoggingInsertData();
-
     replot();
 }
 
 void ScopeGadgetWidget::clearCurvePlots()
 {
+    waitForProcessing();
     foreach(PlotData * plotData, m_curvesData.values()) {
         delete plotData;
     }
@@ -491,20 +750,19 @@ int ScopeGadgetWidget::csvLoggingStart()
                 m_csvLoggingStartTime   = NOW;
                 m_csvLoggingHeaderSaved = 0;
                 m_csvLoggingDataSaved   = 0;
-                m_csvLoggingBuffer.clear();
                 QDir PathCheck(m_csvLoggingPath);
                 if (!PathCheck.exists()) {
                     PathCheck.mkpath("./");
                 }
 
                 if (m_csvLoggingNameSet) {
-                    m_csvLoggingFile.setFileName(QString("%1/%2_%3_%4.csv").arg(m_csvLoggingPath).arg(m_csvLoggingName).arg(NOW.toString("yyyy-MM-dd")).arg(NOW.toString("hh-mm-ss")));
+                    m_csvLoggingFileName = QString("%1/%2_%3_%4").arg(m_csvLoggingPath).arg(m_csvLoggingName).arg(NOW.toString("yyyy-MM-dd")).arg(NOW.toString("hh-mm-ss"));
                 } else {
-                    m_csvLoggingFile.setFileName(QString("%1/Log_%2_%3.csv").arg(m_csvLoggingPath).arg(NOW.toString("yyyy-MM-dd")).arg(NOW.toString("hh-mm-ss")));
+                    m_csvLoggingFileName = QString("%1/Log_%2_%3").arg(m_csvLoggingPath).arg(NOW.toString("yyyy-MM-dd")).arg(NOW.toString("hh-mm-ss"));
                 }
-                QDir FileCheck(m_csvLoggingFile.fileName());
+                QDir FileCheck(m_csvLoggingFileName + (m_csvLoggingConvert ? ".csv" : ".opscope"));
                 if (FileCheck.exists()) {
-                    m_csvLoggingFile.setFileName("");
+                    m_csvLoggingFileName = "";
                 } else {
                     m_csvLoggingStarted = 1;
                     csvLoggingInsertHeader();
@@ -518,6 +776,10 @@ int ScopeGadgetWidget::csvLoggingStart()
 
 int ScopeGadgetWidget::csvLoggingStop()
 {
+    if (m_csvLoggingStarted) {
+        // The writer converts the binary log into CSV once it is complete, if enabled
+        m_csvLoggingWriter->stop();
+    }
     m_csvLoggingStarted = 0;
 
     return 0;
@@ -536,23 +798,18 @@ int ScopeGadgetWidget::csvLoggingInsertHeader()
     }
 
     m_csvLoggingHeaderSaved = 1;
-    if (m_csvLoggingFile.open(QIODevice::WriteOnly | QIODevice::Append) == false) {
-        qDebug() << "Unable to open " << m_csvLoggingFile.fileName() << " for csv logging Header";
-    } else {
-        QTextStream ts(&m_csvLoggingFile);
-        ts << "date" << ", " << "Time" << ", " << "Sec since start" << ", " << "Connected" << ", " << "Data changed";
-
-        foreach(PlotData * plotData2, m_curvesData.values()) {
-            ts << ", ";
-            ts << plotData2->objectName();
-            ts << "." << plotData2->field()->getName();
-            if (!plotData2->elementName().isEmpty()) {
-                ts << "." << plotData2->elementName();
-            }
+
+    QStringList columns;
+    foreach(PlotData * plotData2, m_curvesData.values()) {
+        QString column = plotData2->objectName() + "." + plotData2->field()->getName();
+        if (!plotData2->elementName().isEmpty()) {
+            column += "." + plotData2->elementName();
         }
-        ts << endl;
-        m_csvLoggingFile.close();
+        columns << column;
     }
+    // No CSV file name skips the conversion
+    m_csvLoggingWriter->start(m_csvLoggingFileName + ".opscope", m_csvLoggingStartTime, columns,
+                              m_csvLoggingConvert ? m_csvLoggingFileName + ".csv" : QString());
     return 0;
 }
 
@@ -563,31 +820,22 @@ int ScopeGadgetWidget::csvLoggingAddData()
     }
     m_csvLoggingDataValid = false;
     QDateTime NOW = QDateTime::currentDateTime();
-    QString tempString;
-
-    QTextStream ss(&tempString);
-    ss << NOW.toString("yyyy-MM-dd") << ", " << NOW.toString("hh:mm:ss.z") << ", ";
-
-#if QT_VERSION >= 0x040700
-    ss << (NOW.toMSecsSinceEpoch() - m_csvLoggingStartTime.toMSecsSinceEpoch()) / 1000.00;
-#else
-    ss << (NOW.toTime_t() - m_csvLoggingStartTime.toTime_t());
-#endif
-    ss << ", " << m_csvLoggingConnected << ", " << m_csvLoggingDataUpdated;
-    m_csvLoggingDataUpdated = false;
 
+    QVector<float> values;
+    values.reserve(m_curvesData.size());
     foreach(PlotData * plotData2, m_curvesData.values()) {
-        ss << ", ";
         if (plotData2->hasData()) {
-            ss << plotData2->lastDataAsString();
+            values << plotData2->lastData();
             m_csvLoggingDataValid = true;
+        } else {
+            values << qQNaN();
         }
     }
-    ss << endl;
     if (m_csvLoggingDataValid) {
-        QTextStream ts(&m_csvLoggingBuffer);
-        ts << tempString;
+        m_csvLoggingWriter->addRow((NOW.toMSecsSinceEpoch() - m_csvLoggingStartTime.toMSecsSinceEpoch()) / 1000.00,
+                                   m_csvLoggingConnected, m_csvLoggingDataUpdated, values);
     }
+    m_csvLoggingDataUpdated = false;
 
     return 0;
 }
@@ -599,14 +847,8 @@ int ScopeGadgetWidget::csvLoggingInsertData()
     }
     m_csvLoggingDataSaved = 1;
 
-    if (m_csvLoggingFile.open(QIODevice::WriteOnly | QIODevice::Append) == false) {
-        qDebug() << "Unable to open " << m_csvLoggingFile.fileName() << " for csv logging Data";
-    } else {
-        QTextStream ts(&m_csvLoggingFile);
-        ts << m_csvLoggingBuffer;
-        m_csvLoggingFile.close();
-    }
-    m_csvLoggingBuffer.clear();
+    // Hand the rows over to the writer thread
+    m_csvLoggingWriter->flush();
 
     return 0;
 }
@@ -643,6 +885,10 @@ void ScopeGadgetWidget::popUpMenu(const QPoint &mousePosition)
     connect(action, &QAction::triggered, this, &ScopeGadgetWidget::clearPlot);
     action = menu.addAction(tr("Copy to Clipboard"));
     connect(action, &QAction::triggered, this, &ScopeGadgetWidget::copyToClipboardAsImage);
+    if (playbackActive()) {
+        action = menu.addAction(tr("Show Whole Log"));
+        connect(action, &QAction::triggered, this, &ScopeGadgetWidget::showWholeLog);
+    }
     menu.addSeparator();
     action = menu.addAction(tr("Options..."));
     connect(action, &QAction::triggered, this, &ScopeGadgetWidget::showOptionDialog);
@@ -651,6 +897,7 @@ void ScopeGadgetWidget::popUpMenu(const QPoint &mousePosition)
 
 void ScopeGadgetWidget::clearPlot()
 {
+    waitForProcessing();
     m_mutex.lock();
     foreach(PlotData * plot, m_curvesData.values()) {
         plot->clear();
@@ -675,3 +922,139 @@ void ScopeGadgetWidget::showOptionDialog()
 {
     Core::ICore::instance()->showOptionsDialog("ScopeGadget", objectName());
 }
+
+/**
+ * Starts or ends the playback of a recorded log. The curves are emptied, their
+ * pyramids are built on the worker thread and the whole log is shown.
+ */
+void ScopeGadgetWidget::setPlaybackLog(ScopePlaybackLogPtr log)
+{
+    if (log == m_playbackLog) {
+        return;
+    }
+    if (playbackActive()) {
+        endPlayback();
+    }
+    m_playbackLog  = log;
+    m_playbackFrom = 0.0;
+    m_playbackTo   = log ? log->duration() / 1000.0 : 0.0;
+    m_playbackCursor->setXValue(0.0);
+    if (!playbackActive()) {
+        return;
+    }
+
+    waitForProcessing();
+    m_mutex.lock();
+    foreach(PlotData * plotData, m_curvesData.values()) {
+        plotData->clear();
+    }
+    m_mutex.unlock();
+    startPlaybackBuild();
+}
+
+void ScopeGadgetWidget::endPlayback()
+{
+    waitForProcessing();
+    m_playbackGeneration++;
+    m_playbackReady    = false;
+    m_playbackDragging = false;
+    m_playbackCursor->detach();
+
+    m_mutex.lock();
+    foreach(PlotData * plotData, m_curvesData.values()) {
+        static_cast<ChronoPlotData *>(plotData)->endPlayback();
+    }
+    m_mutex.unlock();
+
+    setAxisScaleDraw(QwtPlot::xBottom, new TimeScaleDraw());
+    replot();
+}
+
+void ScopeGadgetWidget::startPlaybackBuild()
+{
+    m_playbackBuildPending = false;
+    if (!playbackActive()) {
+        return;
+    }
+
+    // A build still running is for older curves, its result is dropped
+    waitForProcessing();
+    m_playbackReady = false;
+    setAxisScaleDraw(QwtPlot::xBottom, new LogTimeScaleDraw());
+    m_playbackCursor->attach(this);
+    setPlaybackWindow(m_playbackFrom, m_playbackTo);
+    m_processingPool.start(new ScopePlaybackJob(this, m_curvesData.values(), m_playbackLog, ++m_playbackGeneration));
+}
+
+void ScopeGadgetWidget::playbackBuilt(int playbackGeneration)
+{
+    if (playbackGeneration != m_playbackGeneration || !playbackActive()) {
+        return;
+    }
+    m_playbackReady = true;
+    showPlayback();
+}
+
+/**
+ * Draws the window of the log. The pyramids make it cost the same whatever the
+ * window, it is done on the GUI thread as the user pans and zooms.
+ */
+void ScopeGadgetWidget::showPlayback()
+{
+    if (!playbackActive()) {
+        return;
+    }
+    m_playbackDirty = false;
+
+    QMutexLocker locker(&m_mutex);
+    if (m_playbackReady) {
+        foreach(PlotData * plotData, m_curvesData.values()) {
+            static_cast<ChronoPlotData *>(plotData)->showPlayback(m_playbackFrom, m_playbackTo, canvas()->width());
+        }
+    }
+    setAxisScale(QwtPlot::xBottom, m_playbackFrom, m_playbackTo);
+    replot();
+}
+
+void ScopeGadgetWidget::showWholeLog()
+{
+    if (playbackActive()) {
+        setPlaybackWindow(0.0, m_playbackLog->duration() / 1000.0);
+    }
+}
+
+void ScopeGadgetWidget::setPlaybackWindow(double from, double to)
+{
+    // Not shorter than 100ms, not wider than the log and within it
+    double duration = qMax(m_playbackLog->duration() / 1000.0, 0.1);
+    double span     = qBound(0.1, to - from, duration);
+
+    m_playbackFrom = qBound(0.0, from, duration - span);
+    m_playbackTo   = m_playbackFrom + span;
+    showPlayback();
+}
+
+/**
+ * Follows the replay. The window pages along when the position leaves it, unless
+ * the user is panning. While the plotting runs the refresh timer draws the change.
+ */
+void ScopeGadgetWidget::setPlaybackPosition(quint32 timeStamp)
+{
+    if (!playbackActive()) {
+        return;
+    }
+
+    double position = timeStamp / 1000.0;
+    m_playbackCursor->setXValue(position);
+    if (!m_playbackDragging && (position < m_playbackFrom || position > m_playbackTo)) {
+        double span = m_playbackTo - m_playbackFrom;
+        m_playbackFrom = qMax(position - span / 10, 0.0);
+        m_playbackTo   = m_playbackFrom + span;
+    }
+
+    if (replotTimer && replotTimer->isActive()) {
+        m_playbackDirty = true;
+    } else {
+        showPlayback();
+    }
+}
@@ -29,6 +29,7 @@
 #define SCOPEGADGETWIDGET_H_
 
 #include "plotdata.h"
+#include "scopelogwriter.h"
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_legend.h"
@@ -41,6 +42,9 @@
 #include <QTime>
 #include <QVector>
 #include <QMutex>
+#include <QThread>
+#include <QThreadPool>
+#include <QAtomicInt>
 
 class QSettings;
 
@@ -62,6 +66,19 @@ public:
     }
 };
 
+/*!
+   \brief Renders the log time, in seconds from the start of the log, on the horizontal
+   axis of a chrono plot in playback.
+ */
+class LogTimeScaleDraw : public QwtScaleDraw {
+public:
+    LogTimeScaleDraw() {}
+    virtual QwtText label(double v) const
+    {
+        return QTime(0, 0).addMSecs(qMax(v, 0.0) * 1000).toString("hh:mm:ss");
+    }
+};
+
 class ScopeGadgetWidget : public QwtPlot {
     Q_OBJECT
 
@@ -71,6 +88,9 @@ public:
 
     void setupSequentialPlot();
     void setupChronoPlot();
+    void setupWaterfallPlot();
+    void setupSpectrumPlot();
+    void setupHistogramPlot();
     void setupUAVObjectPlot();
     PlotType plotType()
     {
@@ -93,6 +113,7 @@ public:
     {
         return m_refreshInterval;
     }
+    void setOpenGLCanvas(bool openGL);
 
 
     void addCurvePlot(QString uavObject, QString uavFieldSubField, int scaleOrderFactor = 0, int meanSamples = 1,
@@ -114,12 +135,26 @@ public:
     {
         m_csvLoggingNewFileOnConnect = value;
     }
+    void setLoggingCsv(bool value)
+    {
+        m_csvLoggingConvert = value;
+    }
     void setLoggingPath(QString value)
     {
         m_csvLoggingPath = value;
     }
+
+public slots:
+    // A chrono plot shows the whole log while one is set, a null log goes back to the live data
+    void setPlaybackLog(ScopePlaybackLogPtr log);
+    void setPlaybackPosition(quint32 timeStamp);
+
 signals:
     void visibilityChanged(QwtPlotItem *item);
+    void curvesProcessed();
+    void curvesBuilt(int playbackGeneration);
+    // The user clicked a time of the log
+    void playbackPositionRequested(quint32 timeStamp);
 
 protected:
     void mousePressEvent(QMouseEvent *e);
@@ -132,6 +167,7 @@ protected:
 private slots:
     void uavObjectReceived(UAVObject *);
     void replotNewData();
+    void showProcessedData();
     void showCurve(QVariant itemInfo, bool visible, int index);
     void startPlotting();
     void stopPlotting();
@@ -141,6 +177,10 @@ private slots:
     void clearPlot();
     void copyToClipboardAsImage();
     void showOptionDialog();
+    void startPlaybackBuild();
+    void playbackBuilt(int playbackGeneration);
+    void showPlayback();
+    void showWholeLog();
 
 private:
 
@@ -165,17 +205,46 @@ private:
     bool m_csvLoggingDataUpdated;
     bool m_csvLoggingConnected;
     bool m_csvLoggingNewFileOnConnect;
+    bool m_csvLoggingConvert;
 
     QDateTime m_csvLoggingStartTime;
 
     QString m_csvLoggingName;
     QString m_csvLoggingPath;
-    QString m_csvLoggingBuffer;
-    QFile m_csvLoggingFile;
+    QString m_csvLoggingFileName;
+    QThread m_csvLoggingThread;
+    ScopeLogWriter *m_csvLoggingWriter;
 
     QMutex m_mutex;
     QwtLegend *m_plotLegend;
 
+    // The curves are processed by one worker thread per plot, set while it runs
+    QThreadPool m_processingPool;
+    QAtomicInt m_processing;
+    friend class ScopeProcessingJob;
+    void processingDone();
+    void waitForProcessing();
+
+    // Playback of a recorded log, the window is in log seconds
+    ScopePlaybackLogPtr m_playbackLog;
+    int m_playbackGeneration;
+    bool m_playbackReady;
+    bool m_playbackBuildPending;
+    bool m_playbackDirty;
+    double m_playbackFrom;
+    double m_playbackTo;
+    QwtPlotMarker *m_playbackCursor;
+    int m_playbackDragX;
+    double m_playbackDragFrom;
+    bool m_playbackDragging;
+    bool m_playbackDragged;
+    bool playbackActive() const
+    {
+        return !m_playbackLog.isNull() && m_plotType == ChronoPlot;
+    }
+    void endPlayback();
+    void setPlaybackWindow(double from, double to);
+
     int csvLoggingInsertHeader();
     int csvLoggingAddData();
     int csvLoggingInsertData();
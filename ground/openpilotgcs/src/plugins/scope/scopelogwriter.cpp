@@ -0,0 +1,244 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopelogwriter.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopelogwriter.h"
+
+#include <string.h>
+#include <QDebug>
+#include <QMetaObject>
+#include <QTextStream>
+#include <QtNumeric>
+
+static const char logMagic[8] = { 'O', 'P', 'S', 'C', 'O', 'P', 'E', 1 };
+
+ScopeLogWriter::ScopeLogWriter() : QObject(), m_columnCount(0), m_writePending(false)
+{}
+
+ScopeLogWriter::~ScopeLogWriter()
+{
+    // Requests still queued when the thread was stopped are lost, finish the log here
+    closeFile(m_csvFileName);
+}
+
+void ScopeLogWriter::start(const QString &fileName, const QDateTime &startTime, const QStringList &columns, const QString &csvFileName)
+{
+    m_mutex.lock();
+    m_columnCount = columns.size();
+    m_times.clear();
+    m_flags.clear();
+    m_values.clear();
+    m_mutex.unlock();
+
+    m_csvFileName = csvFileName;
+    QMetaObject::invokeMethod(this, "openFile", Qt::QueuedConnection,
+                              Q_ARG(QString, fileName), Q_ARG(QDateTime, startTime), Q_ARG(QStringList, columns));
+}
+
+void ScopeLogWriter::addRow(double time, bool connected, bool dataChanged, const QVector<float> &values)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (values.size() != m_columnCount) {
+        return;
+    }
+    m_times.append(time);
+    m_flags.append((connected ? 1 : 0) | (dataChanged ? 2 : 0));
+    m_values += values;
+    if (m_times.size() >= CHUNK_ROWS) {
+        queueWrite();
+    }
+}
+
+void ScopeLogWriter::flush()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (!m_times.isEmpty()) {
+        queueWrite();
+    }
+}
+
+void ScopeLogWriter::stop()
+{
+    flush();
+    QMetaObject::invokeMethod(this, "closeFile", Qt::QueuedConnection, Q_ARG(QString, m_csvFileName));
+}
+
+// Called with m_mutex locked
+void ScopeLogWriter::queueWrite()
+{
+    if (!m_writePending) {
+        m_writePending = true;
+        QMetaObject::invokeMethod(this, "writePending", Qt::QueuedConnection);
+    }
+}
+
+void ScopeLogWriter::openFile(QString fileName, QDateTime startTime, QStringList columns)
+{
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Unable to open " << m_file.fileName() << " for scope logging";
+        return;
+    }
+
+    qint64 start = startTime.toMSecsSinceEpoch();
+    quint32 count = columns.size();
+    m_file.write(logMagic, sizeof(logMagic));
+    m_file.write((char *)&start, sizeof(start));
+    m_file.write((char *)&count, sizeof(count));
+    foreach(QString column, columns) {
+        QByteArray name = column.toUtf8();
+        quint32 length  = name.size();
+        m_file.write((char *)&length, sizeof(length));
+        m_file.write(name);
+    }
+}
+
+void ScopeLogWriter::writePending()
+{
+    QVector<double> times;
+    QVector<quint8> flags;
+    QVector<float> values;
+    int columnCount;
+
+    m_mutex.lock();
+    times.swap(m_times);
+    flags.swap(m_flags);
+    values.swap(m_values);
+    columnCount    = m_columnCount;
+    m_writePending = false;
+    m_mutex.unlock();
+
+    quint32 rows = times.size();
+    if (rows == 0 || !m_file.isOpen()) {
+        return;
+    }
+
+    m_file.write((char *)&rows, sizeof(rows));
+    m_file.write((char *)times.constData(), rows * sizeof(double));
+    m_file.write((char *)flags.constData(), rows * sizeof(quint8));
+
+    // Transpose the rows into columns
+    QVector<float> column(rows);
+    for (int c = 0; c < columnCount; ++c) {
+        for (quint32 r = 0; r < rows; ++r) {
+            column[r] = values.at(r * columnCount + c);
+        }
+        m_file.write((char *)column.constData(), rows * sizeof(float));
+    }
+}
+
+void ScopeLogWriter::closeFile(QString csvFileName)
+{
+    writePending();
+    if (!m_file.isOpen()) {
+        return;
+    }
+    m_file.close();
+
+    if (!csvFileName.isEmpty()) {
+        convertToCsv(m_file.fileName(), csvFileName);
+    }
+}
+
+/**
+ * Converts a binary scope log into CSV, one row per sample with the date,
+ * time, seconds since start, connected and data changed flags, then the columns.
+ */
+bool ScopeLogWriter::convertToCsv(const QString &fileName, const QString &csvFileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Unable to open " << fileName << " for csv conversion";
+        return false;
+    }
+
+    char magic[sizeof(logMagic)];
+    qint64 start;
+    quint32 columnCount;
+    if (file.read(magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, logMagic, sizeof(magic))
+        || file.read((char *)&start, sizeof(start)) != sizeof(start)
+        || file.read((char *)&columnCount, sizeof(columnCount)) != sizeof(columnCount)) {
+        qDebug() << fileName << "is not a scope log";
+        return false;
+    }
+
+    QFile csvFile(csvFileName);
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Unable to open " << csvFileName << " for csv logging";
+        return false;
+    }
+    QTextStream ts(&csvFile);
+
+    ts << "date" << ", " << "Time" << ", " << "Sec since start" << ", " << "Connected" << ", " << "Data changed";
+    for (quint32 c = 0; c < columnCount; ++c) {
+        quint32 length;
+        if (file.read((char *)&length, sizeof(length)) != sizeof(length)) {
+            return false;
+        }
+        ts << ", " << QString::fromUtf8(file.read(length));
+    }
+    ts << endl;
+
+    const QDateTime startTime = QDateTime::fromMSecsSinceEpoch(start);
+    quint32 rows;
+    while (file.read((char *)&rows, sizeof(rows)) == sizeof(rows)) {
+        QVector<double> times(rows);
+        QVector<quint8> flags(rows);
+        QVector<float> values(rows * columnCount);
+        if (file.read((char *)times.data(), rows * sizeof(double)) != (qint64)(rows * sizeof(double))
+            || file.read((char *)flags.data(), rows) != (qint64)rows
+            || file.read((char *)values.data(), values.size() * sizeof(float)) != (qint64)(values.size() * sizeof(float))) {
+            qDebug() << fileName << "is truncated";
+            break;
+        }
+        for (quint32 r = 0; r < rows; ++r) {
+            QDateTime time = startTime.addMSecs(times.at(r) * 1000);
+            ts << time.toString("yyyy-MM-dd") << ", " << time.toString("hh:mm:ss.z") << ", " << times.at(r);
+            ts << ", " << (flags.at(r) & 1) << ", " << ((flags.at(r) >> 1) & 1);
+            // Columns are stored one after the other
+            for (quint32 c = 0; c < columnCount; ++c) {
+                ts << ", ";
+                float value = values.at(c * rows + r);
+                if (!qIsNaN(value)) {
+                    ts << QString().sprintf("%3.10g", value);
+                }
+            }
+            ts << endl;
+        }
+    }
+    return true;
+}
+
+/**
+ * @}
+ * @}
+ */
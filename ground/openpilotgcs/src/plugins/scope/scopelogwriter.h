@@ -0,0 +1,90 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopelogwriter.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SCOPELOGWRITER_H
+#define SCOPELOGWRITER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QFile>
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+
+/*!
+   \brief Writes the scope logging data from a worker thread.
+
+   Rows are batched by the gadget thread and written as chunks in a binary
+   columnar format:
+
+       header : magic "OPSCOPE\1", start time (qint64 ms since epoch),
+                column count (quint32), per column name length (quint32) and UTF-8 name
+       chunk  : row count (quint32), times (double[rows], seconds since start),
+                flags (quint8[rows], bit 0 connected, bit 1 data changed),
+                then per column the values (float[rows], NaN when there is no data)
+
+   All values are in host byte order. convertToCsv() turns a log into the
+   former CSV format.
+ */
+class ScopeLogWriter : public QObject {
+    Q_OBJECT
+
+public:
+    static const int CHUNK_ROWS = 1024;
+
+    ScopeLogWriter();
+    ~ScopeLogWriter();
+
+    // Called from the gadget thread
+    void start(const QString &fileName, const QDateTime &startTime, const QStringList &columns, const QString &csvFileName);
+    void addRow(double time, bool connected, bool dataChanged, const QVector<float> &values);
+    void flush();
+    void stop();
+
+    static bool convertToCsv(const QString &fileName, const QString &csvFileName);
+
+private slots:
+    void openFile(QString fileName, QDateTime startTime, QStringList columns);
+    void writePending();
+    void closeFile(QString csvFileName);
+
+private:
+    QFile m_file;
+    QString m_csvFileName;
+
+    // Rows waiting to be written, guarded by m_mutex
+    QMutex m_mutex;
+    int m_columnCount;
+    QVector<double> m_times;
+    QVector<quint8> m_flags;
+    QVector<float> m_values;
+    bool m_writePending;
+
+    void queueWrite();
+};
+
+#endif // SCOPELOGWRITER_H
@@ -0,0 +1,82 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopeplayback.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SCOPEPLAYBACK_H
+#define SCOPEPLAYBACK_H
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+/*!
+   \brief A whole recorded log handed to the chrono scopes for playback, one column
+   of samples per numeric field element of the logged objects.
+
+   The vectors are implicitly shared, a log decoded elsewhere is handed over without
+   copying its samples. It is not changed once handed over.
+ */
+class ScopePlaybackLog {
+public:
+    struct Column {
+        QVector<quint32> timeStamps; // ms from the start of the log
+        QVector<double>  samples;
+    };
+
+    ScopePlaybackLog() : m_duration(0) {}
+
+    // name is "Object.Field", or "Object.Field.Element" for fields of several elements
+    void addColumn(const QString &name, const QVector<quint32> &timeStamps, const QVector<double> &samples)
+    {
+        Column column;
+
+        column.timeStamps = timeStamps;
+        column.samples    = samples;
+        m_columns.insert(name, column);
+        if (!timeStamps.isEmpty()) {
+            m_duration = qMax(m_duration, timeStamps.last());
+        }
+    }
+    const Column *column(const QString &name) const
+    {
+        QHash<QString, Column>::const_iterator it = m_columns.constFind(name);
+
+        return it == m_columns.constEnd() ? NULL : &it.value();
+    }
+    quint32 duration() const
+    {
+        return m_duration;
+    }
+
+private:
+    QHash<QString, Column> m_columns;
+    quint32 m_duration;
+};
+
+typedef QSharedPointer<const ScopePlaybackLog> ScopePlaybackLogPtr;
+
+#endif // SCOPEPLAYBACK_H
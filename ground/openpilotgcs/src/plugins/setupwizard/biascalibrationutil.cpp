@@ -164,31 +164,17 @@ void BiasCalibrationUtil::startMeasurement()
         AccelGyroSettings::GetInstance(uavObjectManager)->setData(accelGyroSettingsData);
         AttitudeSettings::GetInstance(uavObjectManager)->setData(attitudeSettingsData);
     }
-    // Set up to receive updates for accels
-    UAVDataObject *uavObject = AccelState::GetInstance(uavObjectManager);
-    connect(uavObject, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(accelMeasurementsUpdated(UAVObject *)));
-
-    // Set update period for accels
-    m_previousAccelMetaData = uavObject->getMetadata();
-    UAVObject::Metadata newMetaData = m_previousAccelMetaData;
-    UAVObject::SetFlightTelemetryUpdateMode(newMetaData, UAVObject::UPDATEMODE_PERIODIC);
-    newMetaData.flightTelemetryUpdatePeriod = m_accelMeasurementRate;
-
-    for (i = 0; i < 5; i++) {
-        uavObject->setMetadata(newMetaData);
-    }
-    // Set up to receive updates from gyros
-    uavObject = GyroState::GetInstance(uavObjectManager);
-    connect(uavObject, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(gyroMeasurementsUpdated(UAVObject *)));
-
-    // Set update period for gyros
-    m_previousGyroMetaData = uavObject->getMetadata();
-    newMetaData = m_previousGyroMetaData;
-    UAVObject::SetFlightTelemetryUpdateMode(newMetaData, UAVObject::UPDATEMODE_PERIODIC);
-    newMetaData.flightTelemetryUpdatePeriod = m_gyroMeasurementRate;
-    for (i = 0; i < 5; i++) {
-        uavObject->setMetadata(newMetaData);
-    }
+    // Set up to receive updates for accels and gyros
+    UAVDataObject *accelState = AccelState::GetInstance(uavObjectManager);
+    connect(accelState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(accelMeasurementsUpdated(UAVObject *)));
+    UAVDataObject *gyroState  = GyroState::GetInstance(uavObjectManager);
+    connect(gyroState, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(gyroMeasurementsUpdated(UAVObject *)));
+
+    // Set update periods for both in one transaction
+    m_metadataOverride.clear();
+    m_metadataOverride.setPeriod(accelState, m_accelMeasurementRate);
+    m_metadataOverride.setPeriod(gyroState, m_gyroMeasurementRate);
+    m_metadataOverride.apply();
 }
 
 void BiasCalibrationUtil::stopMeasurement()
@@ -208,12 +194,13 @@ void BiasCalibrationUtil::stopMeasurement()
     // Stop listening for updates from accels
     UAVDataObject *uavObject = AccelState::GetInstance(uavObjectManager);
     disconnect(uavObject, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(accelMeasurementsUpdated(UAVObject *)));
-    uavObject->setMetadata(m_previousAccelMetaData);
 
     // Stop listening for updates from gyros
     uavObject = GyroState::GetInstance(uavObjectManager);
     disconnect(uavObject, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(gyroMeasurementsUpdated(UAVObject *)));
-    uavObject->setMetadata(m_previousGyroMetaData);
+
+    // Back to the metadata rates
+    m_metadataOverride.release();
 
     // Enable gyro bias correction again
     AttitudeSettings::DataFields attitudeSettingsData = AttitudeSettings::GetInstance(uavObjectManager)->getData();
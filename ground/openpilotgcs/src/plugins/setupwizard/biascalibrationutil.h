@@ -32,6 +32,7 @@
 #include <QTimer>
 
 #include "uavobject.h"
+#include "uavobjectutil/uavobjecthelper.h"
 #include "vehicleconfigurationsource.h"
 
 class BiasCalibrationUtil : public QObject {
@@ -67,8 +68,7 @@ private:
     long m_accelMeasurementRate;
     long m_gyroMeasurementRate;
 
-    UAVObject::Metadata m_previousGyroMetaData;
-    UAVObject::Metadata m_previousAccelMetaData;
+    UAVObjectMetadataOverride m_metadataOverride;
 
     double m_accelerometerX;
     double m_accelerometerY;
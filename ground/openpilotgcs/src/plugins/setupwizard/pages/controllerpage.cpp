@@ -196,6 +196,11 @@ void ControllerPage::connectionStatusChanged()
         SetupWizard::CONTROLLER_TYPE type = getControllerType();
         setControllerType(type);
         qDebug() << "Connection status changed: Connected, controller type: " << getControllerType();
+
+        // The board description may be from an earlier connection, check it again without blocking the wizard
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        UAVObjectUtilManager *utilMngr     = pm->getObject<UAVObjectUtilManager>();
+        connect(utilMngr->requestBoardInfo(), SIGNAL(finished()), this, SLOT(boardInfoReceived()));
     } else {
         ui->deviceCombo->setEnabled(true);
         ui->connectButton->setText(tr("Connect"));
@@ -207,6 +212,14 @@ void ControllerPage::connectionStatusChanged()
     emit completeChanged();
 }
 
+void ControllerPage::boardInfoReceived()
+{
+    if (m_connectionManager->isConnected()) {
+        setControllerType(getControllerType());
+        emit completeChanged();
+    }
+}
+
 void ControllerPage::connectDisconnect()
 {
     if (m_connectionManager->isConnected()) {
@@ -61,6 +61,7 @@ private:
 private slots:
     void devicesChanged(QLinkedList<Core::DevListItem> devices);
     void connectionStatusChanged();
+    void boardInfoReceived();
     void connectDisconnect();
 };
 
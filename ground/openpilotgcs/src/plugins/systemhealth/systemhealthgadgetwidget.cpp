@@ -29,6 +29,7 @@
 #include "systemhealthgadgetwidget.h"
 
 #include "utils/stylehelper.h"
+#include "utils/cachedsvgitem.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include <uavtalk/telemetrymanager.h>
@@ -47,9 +48,9 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
 
 
     m_renderer = new QSvgRenderer();
-    background = new QGraphicsSvgItem();
-    foreground = new QGraphicsSvgItem();
-    nolink     = new QGraphicsSvgItem();
+    background = new CachedSvgItem();
+    foreground = new CachedSvgItem();
+    nolink     = new CachedSvgItem();
     missingElements = new QStringList();
     paint();
 
@@ -58,7 +59,8 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
     SystemAlarms *obj = dynamic_cast<SystemAlarms *>(objManager->getObject(QString("SystemAlarms")));
-    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(updateAlarms(UAVObject *)));
+    // Only repaint once per frame, whatever the alarms update rate
+    objManager->subscribeCoalesced(obj, this, SLOT(updateAlarms(UAVObject *)));
 
     // Listen to autopilot connection events
     TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
@@ -86,17 +88,9 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
 
 void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
 {
-    // This code does not know anything about alarms beforehand, and
-    // I found no efficient way to locate items inside the scene by
-    // name, so it's just as simple to reset the scene:
-    // And add the one with the right name.
-    QGraphicsScene *m_scene = scene();
-
-    foreach(QGraphicsItem * item, background->childItems()) {
-        m_scene->removeItem(item);
-        delete item; // removeItem does _not_ delete the item.
-    }
-
+    // This code does not know anything about alarms beforehand, the
+    // indicator of every alarm is created on its first update and kept,
+    // so that its cached rendering survives until the alarm changes.
     QMatrix backgroundMatrix = (m_renderer->matrixForElement(background->elementId())).inverted();
 
     QString alarm = systemAlarm->getName();
@@ -107,6 +101,13 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
             if (!missingElements->contains(element)) {
                 if (m_renderer->elementExists(element)) {
                     QString element2 = element + "-" + value;
+                    CachedSvgItem *ind = indicators.value(element);
+                    if (ind && ind->elementId() == element2) {
+                        continue;
+                    }
+                    // The alarm changed, no indicator until one is found for the new value
+                    delete ind;
+                    indicators.remove(element);
                     if (!missingElements->contains(element2)) {
                         if (m_renderer->elementExists(element2)) {
                             // element2 is in global coordinates
@@ -115,13 +116,14 @@ void SystemHealthGadgetWidget::updateAlarms(UAVObject *systemAlarm)
                             // use this composed projection to get the position in background coordinates
                             QRectF rectProjected  = blockMatrix.mapRect(m_renderer->boundsOnElement(element2));
 
-                            QGraphicsSvgItem *ind = new QGraphicsSvgItem();
+                            ind = new CachedSvgItem();
                             ind->setSharedRenderer(m_renderer);
                             ind->setElementId(element2);
                             ind->setParentItem(background);
                             QTransform matrix;
                             matrix.translate(rectProjected.x(), rectProjected.y());
                             ind->setTransform(matrix, false);
+                            indicators.insert(element, ind);
                         } else {
                             if (value.compare("Uninitialised") != 0) {
                                 missingElements->append(element2);
@@ -148,6 +150,9 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
 {
     // Clear the list of elements not found on svg
     missingElements->clear();
+    // and the indicators placed for the previous file
+    qDeleteAll(indicators);
+    indicators.clear();
     setBackgroundBrush(QBrush(Utils::StyleHelper::baseColor()));
     if (QFile::exists(dfn)) {
         m_renderer->load(dfn);
@@ -38,6 +38,9 @@
 
 #include <QFile>
 #include <QTimer>
+#include <QHash>
+
+class CachedSvgItem;
 
 class SystemHealthGadgetWidget : public QGraphicsView {
     Q_OBJECT
@@ -65,6 +68,8 @@ private:
     QGraphicsSvgItem *foreground;
     QGraphicsSvgItem *nolink;
     QStringList *missingElements;
+    // Indicator of every alarm, by alarm name
+    QHash<QString, CachedSvgItem *> indicators;
     // Simple flag to skip rendering if the
     bool fgenabled; // layer does not exist.
 
@@ -28,16 +28,29 @@
 #include "browseritemdelegate.h"
 #include "fieldtreeitem.h"
 
+#include <QAbstractProxyModel>
+
 BrowserItemDelegate::BrowserItemDelegate(QObject *parent) :
     QStyledItemDelegate(parent)
 {}
 
+/**
+ * The item of a row, through the filter of the view if there is one
+ */
+static FieldTreeItem *fieldItem(const QModelIndex &index)
+{
+    const QAbstractProxyModel *proxyModel = qobject_cast<const QAbstractProxyModel *>(index.model());
+    QModelIndex sourceIndex = proxyModel ? proxyModel->mapToSource(index) : index;
+
+    return static_cast<FieldTreeItem *>(sourceIndex.internalPointer());
+}
+
 QWidget *BrowserItemDelegate::createEditor(QWidget *parent,
                                            const QStyleOptionViewItem & option,
                                            const QModelIndex & index) const
 {
     Q_UNUSED(option)
-    FieldTreeItem * item = static_cast<FieldTreeItem *>(index.internalPointer());
+    FieldTreeItem * item = fieldItem(index);
     QWidget *editor = item->createEditor(parent);
     Q_ASSERT(editor);
     return editor;
@@ -47,7 +60,7 @@ QWidget *BrowserItemDelegate::createEditor(QWidget *parent,
 void BrowserItemDelegate::setEditorData(QWidget *editor,
                                         const QModelIndex &index) const
 {
-    FieldTreeItem *item = static_cast<FieldTreeItem *>(index.internalPointer());
+    FieldTreeItem *item = fieldItem(index);
     QVariant value = index.model()->data(index, Qt::EditRole);
 
     item->setEditorValue(editor, value);
@@ -56,7 +69,7 @@ void BrowserItemDelegate::setEditorData(QWidget *editor,
 void BrowserItemDelegate::setModelData(QWidget *editor, QAbstractItemModel *model,
                                        const QModelIndex &index) const
 {
-    FieldTreeItem *item = static_cast<FieldTreeItem *>(index.internalPointer());
+    FieldTreeItem *item = fieldItem(index);
     QVariant value = item->getEditorValue(editor);
 
     model->setData(index, value, Qt::EditRole);
@@ -30,8 +30,8 @@
 /* Constructor */
 HighLightManager::HighLightManager(long checkingInterval)
 {
-    // Start the timer and connect it to the callback
-    m_expirationTimer.start(checkingInterval);
+    // The timer only runs while there are highlighted items
+    m_expirationTimer.setInterval(checkingInterval);
     connect(&m_expirationTimer, SIGNAL(timeout()), this, SLOT(checkItemsExpired()));
 }
 
@@ -47,6 +47,9 @@ bool HighLightManager::add(TreeItem *itemToAdd)
     // Check so that the item isn't already in the list
     if (!m_items.contains(itemToAdd)) {
         m_items.insert(itemToAdd);
+        if (!m_expirationTimer.isActive()) {
+            m_expirationTimer.start();
+        }
         return true;
     }
     return false;
@@ -93,6 +96,9 @@ void HighLightManager::checkItemsExpired()
             iter.remove();
         }
     }
+    if (m_items.isEmpty()) {
+        m_expirationTimer.stop();
+    }
 }
 
 int TreeItem::m_highlightTimeMs = 500;
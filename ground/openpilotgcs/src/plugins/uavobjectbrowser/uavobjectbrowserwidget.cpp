@@ -48,10 +48,19 @@ UAVObjectBrowserWidget::UAVObjectBrowserWidget(QWidget *parent) : QWidget(parent
     m_viewoptionsDialog = new QDialog(this);
     m_viewoptions->setupUi(m_viewoptionsDialog);
     m_browser->setupUi(this);
-    m_model = new UAVObjectTreeModel();
-    m_browser->treeView->setModel(m_model);
+    m_model = 0;
+    m_proxyModel = new TreeSortFilterProxyModel(this);
+    setModel(new UAVObjectTreeModel());
+    m_browser->treeView->setModel(m_proxyModel);
+    connect(m_browser->treeView, SIGNAL(expanded(QModelIndex)), this, SLOT(viewExpanded(QModelIndex)));
+    connect(m_browser->treeView, SIGNAL(collapsed(QModelIndex)), this, SLOT(viewCollapsed(QModelIndex)));
     m_browser->treeView->setColumnWidth(0, 300);
 
+    m_filterTimer.setSingleShot(true);
+    m_filterTimer.setInterval(FILTER_DELAY_MS);
+    connect(&m_filterTimer, SIGNAL(timeout()), this, SLOT(applyFilter()));
+    connect(m_browser->searchLine, SIGNAL(textChanged(QString)), this, SLOT(searchTextChanged()));
+
     BrowserItemDelegate *m_delegate = new BrowserItemDelegate();
     m_browser->treeView->setItemDelegate(m_delegate);
     m_browser->treeView->setEditTriggers(QAbstractItemView::AllEditTriggers);
@@ -99,10 +108,7 @@ void UAVObjectBrowserWidget::setSplitterState(QByteArray state)
 
 void UAVObjectBrowserWidget::showMetaData(bool show)
 {
-    QList<QModelIndex> metaIndexes = m_model->getMetaDataIndexes();
-    foreach(QModelIndex index, metaIndexes) {
-        m_browser->treeView->setRowHidden(index.row(), index.parent(), !show);
-    }
+    m_proxyModel->setShowMetaData(show);
 }
 
 void UAVObjectBrowserWidget::showDescription(bool show)
@@ -120,9 +126,7 @@ void UAVObjectBrowserWidget::categorize(bool categorize)
     m_model->setRecentlyUpdatedTimeout(m_recentlyUpdatedTimeout);
     m_model->setOnlyHilightChangedValues(m_onlyHilightChangedValues);
     m_model->setUnknowObjectColor(m_unknownObjectColor);
-    m_browser->treeView->setModel(m_model);
-    showMetaData(m_viewoptions->cbMetaData->isChecked());
-    connect(m_browser->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex, QModelIndex)), this, SLOT(currentChanged(QModelIndex, QModelIndex)), Qt::UniqueConnection);
+    setModel(m_model);
 
     delete tmpModel;
 }
@@ -136,13 +140,62 @@ void UAVObjectBrowserWidget::useScientificNotation(bool scientific)
     m_model->setManuallyChangedColor(m_manuallyChangedColor);
     m_model->setRecentlyUpdatedTimeout(m_recentlyUpdatedTimeout);
     m_model->setUnknowObjectColor(m_unknownObjectColor);
-    m_browser->treeView->setModel(m_model);
-    showMetaData(m_viewoptions->cbMetaData->isChecked());
-    connect(m_browser->treeView->selectionModel(), SIGNAL(currentChanged(QModelIndex, QModelIndex)), this, SLOT(currentChanged(QModelIndex, QModelIndex)), Qt::UniqueConnection);
+    setModel(m_model);
 
     delete tmpModel;
 }
 
+/**
+ * Puts the model behind the filter, the view only ever sees the filter
+ */
+void UAVObjectBrowserWidget::setModel(UAVObjectTreeModel *model)
+{
+    m_model = model;
+    m_proxyModel->setSourceModel(m_model);
+    if (!m_browser->searchLine->text().isEmpty()) {
+        applyFilter();
+    }
+}
+
+void UAVObjectBrowserWidget::searchTextChanged()
+{
+    m_filterTimer.start();
+}
+
+void UAVObjectBrowserWidget::applyFilter()
+{
+    QString pattern = m_browser->searchLine->text();
+
+    m_proxyModel->setFilterPattern(pattern);
+    // collapseAll() does not signal the rows it collapses
+    m_browser->treeView->collapseAll();
+    m_model->itemsCollapsed();
+    if (!pattern.isEmpty()) {
+        expandToMatches(QModelIndex());
+    }
+}
+
+void UAVObjectBrowserWidget::expandToMatches(const QModelIndex &parent)
+{
+    for (int row = 0; row < m_proxyModel->rowCount(parent); ++row) {
+        QModelIndex index = m_proxyModel->index(row, 0, parent);
+        if (m_proxyModel->leadsToMatch(index)) {
+            m_browser->treeView->expand(index);
+            expandToMatches(index);
+        }
+    }
+}
+
+void UAVObjectBrowserWidget::viewExpanded(const QModelIndex &index)
+{
+    m_model->itemExpanded(m_proxyModel->mapToSource(index));
+}
+
+void UAVObjectBrowserWidget::viewCollapsed(const QModelIndex &index)
+{
+    m_model->itemCollapsed(m_proxyModel->mapToSource(index));
+}
+
 void UAVObjectBrowserWidget::sendUpdate()
 {
     this->setFocus();
@@ -166,7 +219,7 @@ void UAVObjectBrowserWidget::requestUpdate()
 
 ObjectTreeItem *UAVObjectBrowserWidget::findCurrentObjectTreeItem()
 {
-    QModelIndex current     = m_browser->treeView->currentIndex();
+    QModelIndex current     = m_proxyModel->mapToSource(m_browser->treeView->currentIndex());
     TreeItem *item = static_cast<TreeItem *>(current.internalPointer());
     ObjectTreeItem *objItem = 0;
 
@@ -248,7 +301,7 @@ void UAVObjectBrowserWidget::currentChanged(const QModelIndex &current, const QM
 {
     Q_UNUSED(previous);
 
-    TreeItem *item = static_cast<TreeItem *>(current.internalPointer());
+    TreeItem *item = static_cast<TreeItem *>(m_proxyModel->mapToSource(current).internalPointer());
     bool enable    = true;
     if (current == QModelIndex()) {
         enable = false;
@@ -388,3 +441,137 @@ void UAVObjectBrowserWidget::updateDescription()
     }
     m_browser->descriptionText->setText("");
 }
+
+TreeSortFilterProxyModel::TreeSortFilterProxyModel(QObject *parent) :
+    QSortFilterProxyModel(parent),
+    m_indexValid(false),
+    m_showMetaData(true)
+{
+    // The names never change, only the inserted rows need filtering
+    setDynamicSortFilter(false);
+}
+
+void TreeSortFilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    if (this->sourceModel()) {
+        disconnect(this->sourceModel(), 0, this, SLOT(invalidateIndex()));
+    }
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+    invalidateIndex();
+    // Objects and instances come and go with the boards
+    connect(sourceModel, SIGNAL(rowsInserted(QModelIndex, int, int)), this, SLOT(invalidateIndex()));
+    connect(sourceModel, SIGNAL(rowsRemoved(QModelIndex, int, int)), this, SLOT(invalidateIndex()));
+    connect(sourceModel, SIGNAL(modelReset()), this, SLOT(invalidateIndex()));
+}
+
+void TreeSortFilterProxyModel::invalidateIndex()
+{
+    m_indexValid = false;
+    m_index.clear();
+    m_matches.clear();
+    if (!m_pattern.isEmpty() && sourceModel()) {
+        // the new rows are matched too
+        QString pattern = m_pattern;
+        m_pattern.clear();
+        setFilterPattern(pattern);
+    }
+}
+
+void TreeSortFilterProxyModel::buildIndex()
+{
+    m_index.clear();
+    for (int row = 0; row < sourceModel()->rowCount(); ++row) {
+        addToIndex(item(sourceModel()->index(row, 0)), 0);
+    }
+    m_indexValid = true;
+}
+
+void TreeSortFilterProxyModel::addToIndex(TreeItem *item, int depth)
+{
+    IndexEntry entry;
+
+    entry.item  = item;
+    entry.depth = depth;
+    entry.name  = item->data(0).toString().toLower();
+    m_index.append(entry);
+    foreach(TreeItem * child, item->treeChildren()) {
+        addToIndex(child, depth + 1);
+    }
+}
+
+TreeItem *TreeSortFilterProxyModel::item(const QModelIndex &index) const
+{
+    return static_cast<TreeItem *>(index.internalPointer());
+}
+
+void TreeSortFilterProxyModel::setFilterPattern(const QString &pattern)
+{
+    QString lowerPattern = pattern.toLower();
+
+    if (lowerPattern == m_pattern) {
+        return;
+    }
+
+    if (!m_indexValid) {
+        buildIndex();
+    }
+
+    QVector<int> matches;
+    if (!m_pattern.isEmpty() && lowerPattern.contains(m_pattern)) {
+        // Narrowing, only the previous matches can still match
+        foreach(int i, m_matches) {
+            if (m_index.at(i).name.contains(lowerPattern)) {
+                matches.append(i);
+            }
+        }
+    } else if (!lowerPattern.isEmpty()) {
+        for (int i = 0; i < m_index.size(); ++i) {
+            if (m_index.at(i).name.contains(lowerPattern)) {
+                matches.append(i);
+            }
+        }
+    }
+    m_pattern = lowerPattern;
+    m_matches = matches;
+
+    m_accepted.clear();
+    m_matchParents.clear();
+    foreach(int i, m_matches) {
+        const IndexEntry &match = m_index.at(i);
+
+        m_accepted.insert(match.item);
+        // The rows under a match follow it in the index
+        for (int j = i + 1; j < m_index.size() && m_index.at(j).depth > match.depth; ++j) {
+            m_accepted.insert(m_index.at(j).item);
+        }
+        for (TreeItem *parent = match.item->parent(); parent && !m_matchParents.contains(parent); parent = parent->parent()) {
+            m_matchParents.insert(parent);
+            m_accepted.insert(parent);
+        }
+    }
+
+    invalidateFilter();
+}
+
+void TreeSortFilterProxyModel::setShowMetaData(bool show)
+{
+    if (show != m_showMetaData) {
+        m_showMetaData = show;
+        invalidateFilter();
+    }
+}
+
+bool TreeSortFilterProxyModel::leadsToMatch(const QModelIndex &index) const
+{
+    return m_matchParents.contains(item(mapToSource(index)));
+}
+
+bool TreeSortFilterProxyModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const
+{
+    TreeItem *rowItem = item(sourceModel()->index(source_row, 0, source_parent));
+
+    if (!m_showMetaData && dynamic_cast<MetaObjectTreeItem *>(rowItem)) {
+        return false;
+    }
+    return m_pattern.isEmpty() || m_accepted.contains(rowItem);
+}
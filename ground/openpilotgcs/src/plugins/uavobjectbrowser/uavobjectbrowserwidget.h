@@ -30,6 +30,10 @@
 
 #include <QWidget>
 #include <QTreeView>
+#include <QSortFilterProxyModel>
+#include <QSet>
+#include <QTimer>
+#include <QVector>
 #include "objectpersistence.h"
 #include "uavobjecttreemodel.h"
 
@@ -38,6 +42,51 @@ class ObjectTreeItem;
 class Ui_UAVObjectBrowser;
 class Ui_viewoptions;
 
+/**
+ * Filters the object tree on the names of its rows. The names are indexed
+ * once, in tree order, and the filter only scans the index: a pattern that
+ * extends the previous one only rescans the previous matches. A row is
+ * shown when it matches, lies under a match or leads to one.
+ */
+class TreeSortFilterProxyModel : public QSortFilterProxyModel {
+    Q_OBJECT
+public:
+    explicit TreeSortFilterProxyModel(QObject *parent = 0);
+
+    void setSourceModel(QAbstractItemModel *sourceModel);
+    void setFilterPattern(const QString &pattern);
+    void setShowMetaData(bool show);
+
+    // Rows the view expands to show the matches
+    bool leadsToMatch(const QModelIndex &index) const;
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const;
+
+private slots:
+    void invalidateIndex();
+
+private:
+    struct IndexEntry {
+        TreeItem *item;
+        int depth;
+        QString name; // lower case
+    };
+
+    QVector<IndexEntry> m_index;
+    bool m_indexValid;
+    QString m_pattern;
+    // Positions in m_index of the rows matching m_pattern
+    QVector<int> m_matches;
+    QSet<TreeItem *> m_accepted;
+    QSet<TreeItem *> m_matchParents;
+    bool m_showMetaData;
+
+    void buildIndex();
+    void addToIndex(TreeItem *item, int depth);
+    TreeItem *item(const QModelIndex &index) const;
+};
+
 class UAVObjectBrowserWidget : public QWidget {
     Q_OBJECT
 
@@ -88,6 +137,10 @@ private slots:
     void viewSlot();
     void viewOptionsChangedSlot();
     void splitterMoved();
+    void searchTextChanged();
+    void applyFilter();
+    void viewExpanded(const QModelIndex &index);
+    void viewCollapsed(const QModelIndex &index);
     QString createObjectDescription(UAVObject *object);
 signals:
     void viewOptionsChanged(bool categorized, bool scientific, bool metadata, bool description);
@@ -99,6 +152,10 @@ private:
     Ui_viewoptions *m_viewoptions;
     QDialog *m_viewoptionsDialog;
     UAVObjectTreeModel *m_model;
+    TreeSortFilterProxyModel *m_proxyModel;
+    // Filters once the typing pauses, a keystroke restarts it
+    static const int FILTER_DELAY_MS = 200;
+    QTimer m_filterTimer;
 
     int m_recentlyUpdatedTimeout;
     QColor m_unknownObjectColor;
@@ -110,6 +167,8 @@ private:
     void updateObjectPersistance(ObjectPersistence::OperationOptions op, UAVObject *obj);
     void enableSendRequest(bool enable);
     void updateDescription();
+    void setModel(UAVObjectTreeModel *model);
+    void expandToMatches(const QModelIndex &parent);
     ObjectTreeItem *findCurrentObjectTreeItem();
     QString loadFileIntoString(QString fileName);
 };
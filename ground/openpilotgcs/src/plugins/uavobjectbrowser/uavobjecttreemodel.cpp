@@ -36,6 +36,8 @@
 #include <QtCore/QTimer>
 #include <QtCore/QSignalMapper>
 #include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QPair>
 
 UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool useScientificNotation) :
     QAbstractItemModel(parent),
@@ -56,6 +58,10 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool categorize, bool us
     connect(objManager, SIGNAL(newObject(UAVObject *)), this, SLOT(newObject(UAVObject *)));
     connect(objManager, SIGNAL(newInstance(UAVObject *)), this, SLOT(newObject(UAVObject *)));
 
+    m_refreshTimer.setSingleShot(true);
+    m_refreshTimer.setInterval(REFRESH_INTERVAL);
+    connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+
     TreeItem::setHighlightTime(m_recentlyUpdatedTimeout);
     setupModelData(objManager);
 }
@@ -287,17 +293,7 @@ QModelIndex UAVObjectTreeModel::index(TreeItem *item)
         return QModelIndex();
     }
 
-    QModelIndex root = index(item->parent());
-
-    for (int i = 0; i < rowCount(root); ++i) {
-        QModelIndex childIndex = index(i, 0, root);
-        TreeItem *child = static_cast<TreeItem *>(childIndex.internalPointer());
-        if (child == item) {
-            return childIndex;
-        }
-    }
-    Q_ASSERT(false);
-    return QModelIndex();
+    return createIndex(item->row(), 0, item);
 }
 
 QModelIndex UAVObjectTreeModel::parent(const QModelIndex &index) const
@@ -449,17 +445,138 @@ void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
     Q_ASSERT(obj);
     ObjectTreeItem *item = findObjectTreeItem(obj);
     Q_ASSERT(item);
-    if (!m_onlyHilightChangedValues) {
-        item->setHighlight(true);
+    // Handled on the next refresh tick, however often the object got updated meanwhile
+    m_updatedObjects.insert(item);
+    if (!m_refreshTimer.isActive()) {
+        m_refreshTimer.start();
+    }
+}
+
+void UAVObjectTreeModel::refresh()
+{
+    foreach(ObjectTreeItem * item, m_updatedObjects) {
+        if (!m_onlyHilightChangedValues) {
+            item->setHighlight(true);
+            itemChanged(item);
+        }
+        if (isVisible(item)) {
+            updateVisibleItems(item);
+        } else {
+            m_staleItems.insert(item);
+        }
+    }
+    m_updatedObjects.clear();
+
+    // One dataChanged per parent, spanning the rows that changed
+    QHash<TreeItem *, QPair<int, int> > ranges;
+    foreach(TreeItem * item, m_changedItems) {
+        int row = item->row();
+
+        if (ranges.contains(item->parent())) {
+            QPair<int, int> &range = ranges[item->parent()];
+            range.first  = qMin(range.first, row);
+            range.second = qMax(range.second, row);
+        } else {
+            ranges.insert(item->parent(), qMakePair(row, row));
+        }
     }
-    item->update();
-    if (!m_onlyHilightChangedValues) {
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+    m_changedItems.clear();
+    QHashIterator<TreeItem *, QPair<int, int> > iter(ranges);
+    while (iter.hasNext()) {
+        iter.next();
+        QModelIndex parentIndex = index(iter.key());
+        emit dataChanged(index(iter.value().first, TreeItem::TITLE_COLUMN, parentIndex),
+                         index(iter.value().second, TreeItem::DATA_COLUMN, parentIndex));
     }
 }
 
+/*
+ * A row is on screen when all of its ancestors are expanded.
+ */
+bool UAVObjectTreeModel::isVisible(TreeItem *item)
+{
+    for (TreeItem *parent = item->parent(); parent && parent != m_rootItem; parent = parent->parent()) {
+        if (!m_expandedItems.contains(parent)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Pulls the field values of a visible item into its rows, collapsed children
+ * are only flagged and get their values once they are expanded.
+ */
+void UAVObjectTreeModel::updateVisibleItems(TreeItem *item)
+{
+    if (!m_expandedItems.contains(item)) {
+        m_staleItems.insert(item);
+        return;
+    }
+    m_staleItems.remove(item);
+    foreach(TreeItem * child, item->treeChildren()) {
+        if (dynamic_cast<MetaObjectTreeItem *>(child)) {
+            // Meta data is updated through its own object
+            continue;
+        }
+        if (child->childCount() > 0) {
+            // Array rows show their elements in their own value column
+            itemChanged(child);
+            updateVisibleItems(child);
+        } else {
+            QVariant value = child->data();
+            child->update();
+            if (child->data() != value) {
+                itemChanged(child);
+            }
+        }
+    }
+}
+
+void UAVObjectTreeModel::itemChanged(TreeItem *item)
+{
+    if (isVisible(item)) {
+        m_changedItems.insert(item);
+        if (!m_refreshTimer.isActive()) {
+            m_refreshTimer.start();
+        }
+    }
+}
+
+void UAVObjectTreeModel::itemExpanded(const QModelIndex &index)
+{
+    TreeItem *item = static_cast<TreeItem *>(index.internalPointer());
+
+    m_expandedItems.insert(item);
+    updateStaleItems(item);
+}
+
+/*
+ * Brings an expanded item and its expanded descendants up to date, they may
+ * have gone stale while one of their ancestors was collapsed.
+ */
+void UAVObjectTreeModel::updateStaleItems(TreeItem *item)
+{
+    if (m_staleItems.contains(item)) {
+        updateVisibleItems(item);
+    }
+    foreach(TreeItem * child, item->treeChildren()) {
+        if (m_expandedItems.contains(child)) {
+            updateStaleItems(child);
+        }
+    }
+}
+
+void UAVObjectTreeModel::itemCollapsed(const QModelIndex &index)
+{
+    m_expandedItems.remove(static_cast<TreeItem *>(index.internalPointer()));
+}
+
+void UAVObjectTreeModel::itemsCollapsed()
+{
+    m_expandedItems.clear();
+}
+
 ObjectTreeItem *UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
 {
     UAVDataObject *dataObject = qobject_cast<UAVDataObject *>(object);
@@ -492,18 +609,12 @@ MetaObjectTreeItem *UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *ob
 
 void UAVObjectTreeModel::updateHighlight(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::DATA_COLUMN));
+    itemChanged(item);
 }
 
 void UAVObjectTreeModel::updateIsKnown(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::TITLE_COLUMN));
+    itemChanged(item);
 }
 
 void UAVObjectTreeModel::isKnownChanged(UAVObject *object, bool isKnown)
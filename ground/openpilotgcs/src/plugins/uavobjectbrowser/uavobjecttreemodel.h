@@ -32,6 +32,8 @@
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
 #include <QColor>
 
 class TopTreeItem;
@@ -90,12 +92,17 @@ signals:
 
 public slots:
     void newObject(UAVObject *obj);
+    // The view tells which rows are expanded, only the visible rows are kept up to date
+    void itemExpanded(const QModelIndex &index);
+    void itemCollapsed(const QModelIndex &index);
+    void itemsCollapsed();
 
 private slots:
     void updateHighlight(TreeItem *item);
     void updateIsKnown(TreeItem *item);
     void highlightUpdatedObject(UAVObject *obj);
     void isKnownChanged(UAVObject *object, bool isKnown);
+    void refresh();
 
 private:
     void setupModelData(UAVObjectManager *objManager);
@@ -108,6 +115,11 @@ private:
 
     TreeItem *createCategoryItems(QStringList categoryPath, TreeItem *root);
 
+    bool isVisible(TreeItem *item);
+    void updateVisibleItems(TreeItem *item);
+    void updateStaleItems(TreeItem *item);
+    void itemChanged(TreeItem *item);
+
     QString updateMode(quint8 updateMode);
     ObjectTreeItem *findObjectTreeItem(UAVObject *obj);
     DataObjectTreeItem *findDataObjectTreeItem(UAVDataObject *obj);
@@ -126,6 +138,15 @@ private:
 
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
+
+    // Object updates and row changes are collected and handled once per refresh tick.
+    static const int REFRESH_INTERVAL = 100; // ms
+    QTimer m_refreshTimer;
+    QSet<ObjectTreeItem *> m_updatedObjects;
+    QSet<TreeItem *> m_changedItems;
+    QSet<TreeItem *> m_expandedItems;
+    // Collapsed items whose children missed an update
+    QSet<TreeItem *> m_staleItems;
 };
 
 #endif // UAVOBJECTTREEMODEL_H
@@ -0,0 +1,114 @@
+##
+##############################################################################
+#
+# @file       opllog.py
+# @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+# @brief      Vectorized reader of GCS .opl telemetry logs
+#
+# @see        The GNU Public License (GPL) Version 3
+#
+#############################################################################/
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#
+# Usage, with the generated python directory of uavobject-synthetics in the path:
+#
+#   import opllog
+#   log = opllog.read("flight.opl")
+#   att = log["AttitudeState"]
+#   plot(att["time"] / 1000.0, att["Roll"])
+#
+# Each log record is a quint32 timestamp in ms, a qint64 size and one UAVTalk
+# frame. The framing is walked once to find the records, everything after that
+# is done on whole arrays: one gather and one copy per object type.
+
+import struct
+import numpy
+
+import uavodtypes
+
+__all__ = ("read",)
+
+RECORD_HEADER = struct.Struct("<Iq")
+
+# UAVTalk framing, see plugins/uavtalk/uavtalk.h
+SYNC_VAL      = 0x3C
+TYPE_OBJ      = 0x20
+TYPE_OBJ_ACK  = 0x22
+HEADER_LENGTH = 10
+
+def _scan(buf):
+    """Offset, timestamp and size of every record, up to the first corrupted one"""
+    offsets = []
+    times   = []
+    sizes   = []
+    unpack  = RECORD_HEADER.unpack_from
+    hsize   = RECORD_HEADER.size
+    end     = len(buf)
+    pos     = 0
+    while pos + hsize <= end:
+        time, size = unpack(buf, pos)
+        if size < 1 or size > 1024 * 1024 or pos + hsize + size > end:
+            break
+        offsets.append(pos + hsize)
+        times.append(time)
+        sizes.append(size)
+        pos += hsize + size
+    return (numpy.array(offsets, dtype=numpy.int64),
+            numpy.array(times, dtype=numpy.uint32),
+            numpy.array(sizes, dtype=numpy.int64))
+
+def read(filename, objects=None):
+    """
+    Decode a log into one numpy record array per object type, keyed by name.
+    Besides the data fields each record has the log time in ms and the instance id.
+    Only full object updates are decoded, the records of objects with an
+    unknown ID or a size that does not match the definition are skipped.
+    """
+    buf = numpy.fromfile(filename, dtype=numpy.uint8)
+    offsets, times, sizes = _scan(memoryview(buf))
+
+    # Frame headers of all the records at once
+    ok = sizes >= HEADER_LENGTH
+    offsets, times, sizes = offsets[ok], times[ok], sizes[ok]
+    header = buf[offsets[:, None] + numpy.arange(HEADER_LENGTH)]
+    ok = (header[:, 0] == SYNC_VAL)
+    ok &= (header[:, 1] == TYPE_OBJ) | (header[:, 1] == TYPE_OBJ_ACK)
+    length = header[:, 2].astype(numpy.int64) | (header[:, 3].astype(numpy.int64) << 8)
+    objid  = numpy.ascontiguousarray(header[:, 4:8]).view("<u4").ravel()
+    instid = numpy.ascontiguousarray(header[:, 8:10]).view("<u2").ravel()
+
+    result = {}
+    for id in numpy.unique(objid[ok]):
+        if int(id) not in uavodtypes.dtypes:
+            continue
+        name, dtype = uavodtypes.dtypes[int(id)]
+        if objects is not None and name not in objects:
+            continue
+        sel = ok & (objid == id) & (length == HEADER_LENGTH + dtype.itemsize) & \
+              (sizes >= HEADER_LENGTH + dtype.itemsize)
+        start = offsets[sel] + HEADER_LENGTH
+        data  = buf[start[:, None] + numpy.arange(dtype.itemsize)]
+
+        fields = [("time", "<u4"), ("instance", "<u2")] + \
+                 [(f, dtype.fields[f][0]) for f in dtype.names]
+        records = numpy.empty(len(start), dtype=fields)
+        records["time"]     = times[sel]
+        records["instance"] = instid[sel]
+        values = data.view(dtype).ravel()
+        for f in dtype.names:
+            records[f] = values[f]
+        result[name] = records
+    return result
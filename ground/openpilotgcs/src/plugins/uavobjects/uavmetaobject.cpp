@@ -93,7 +93,9 @@ void UAVMetaObject::setData(const Metadata & mdata)
 {
     QMutexLocker locker(mutex);
 
+    beginDataUpdate();
     parentMetadata = mdata;
+    endDataUpdate();
     emit objectUpdatedAuto(this); // trigger object updated event
     emit objectUpdated(this);
 }
@@ -103,9 +105,7 @@ void UAVMetaObject::setData(const Metadata & mdata)
  */
 UAVObject::Metadata UAVMetaObject::getData()
 {
-    QMutexLocker locker(mutex);
-
-    return parentMetadata;
+    return readValue<Metadata>(0);
 }
 
 bool UAVMetaObject::isMetaDataObject()
@@ -64,6 +64,10 @@ UAVObject::UAVObject(quint32 objID, bool isSingleInst, const QString & name)
     this->numBytes     = 0;
     this->mutex        = new QMutex(QMutex::Recursive);
     m_isKnown = false;
+    m_hasVehicleTime    = false;
+    m_vehicleTime       = 0;
+    m_vehicleSampleTime = 0;
+    m_dataUpdateDepth   = 0;
 }
 
 /**
@@ -91,7 +95,9 @@ void UAVObject::initializeFields(QList<UAVObjectField *> & fields, quint8 *data,
     this->fields   = fields;
     // Initialize fields
     quint32 offset = 0;
+    m_fieldIndex.clear();
     for (int n = 0; n < fields.length(); ++n) {
+        m_fieldIndex.insert(fields[n]->getName(), fields[n]);
         fields[n]->initialize(data, offset, this);
         offset += fields[n]->getNumBytes();
         connect(fields[n], SIGNAL(fieldUpdated(UAVObjectField *)), this, SLOT(fieldUpdated(UAVObjectField *)));
@@ -180,6 +186,74 @@ quint32 UAVObject::getNumBytes()
     return numBytes;
 }
 
+/**
+ * Mark the start of an update of the object data.
+ * Must be called with the object mutex held, calls can be nested.
+ */
+void UAVObject::beginDataUpdate()
+{
+    if (m_dataUpdateDepth++ == 0) {
+        m_dataSequence.fetchAndAddOrdered(1);
+    }
+}
+
+/**
+ * Mark the end of an update of the object data.
+ * Must be called with the object mutex held.
+ */
+void UAVObject::endDataUpdate()
+{
+    if (--m_dataUpdateDepth == 0) {
+        m_dataSequence.fetchAndAddOrdered(1);
+    }
+}
+
+/**
+ * Get the data sequence number, it changes every time the object data is updated
+ */
+quint32 UAVObject::getDataSequence() const
+{
+    return (quint32)m_dataSequence.loadAcquire();
+}
+
+/**
+ * Copy part of the object data without taking the object mutex.
+ * The copy is retried if an update happened while it was taken, if the object
+ * keeps being updated the mutex is used as a fallback.
+ * @param dest Destination buffer
+ * @param src Source address, must point inside the object data
+ * @param length Number of bytes to copy
+ */
+void UAVObject::readData(void *dest, const void *src, quint32 length) const
+{
+    for (int retry = 0; retry < MAX_LOCKFREE_READ_RETRIES; ++retry) {
+        int sequence = m_dataSequence.loadAcquire();
+        if ((sequence & 1) == 0) {
+            memcpy(dest, src, length);
+            // Full barrier so that the copy is complete before the sequence is checked again
+            if (m_dataSequence.fetchAndAddOrdered(0) == sequence) {
+                return;
+            }
+        }
+    }
+    QMutexLocker locker(mutex);
+    memcpy(dest, src, length);
+}
+
+/**
+ * Get a consistent snapshot of the raw object data without blocking on the object mutex
+ * @param dataOut Buffer of at least getNumBytes() bytes
+ * @returns True on success, false if the object has no data
+ */
+bool UAVObject::readData(quint8 *dataOut) const
+{
+    if (data == NULL) {
+        return false;
+    }
+    readData(dataOut, data, numBytes);
+    return true;
+}
+
 /**
  * Request that this object is updated with the latest values from the autopilot
  */
@@ -258,8 +332,7 @@ QMutex *UAVObject::getMutex()
  */
 qint32 UAVObject::getNumFields()
 {
-    QMutexLocker locker(mutex);
-
+    // The field list is set once at construction and never modified, no need to lock
     return fields.count();
 }
 
@@ -268,8 +341,6 @@ qint32 UAVObject::getNumFields()
  */
 QList<UAVObjectField *> UAVObject::getFields()
 {
-    QMutexLocker locker(mutex);
-
     return fields;
 }
 
@@ -279,13 +350,11 @@ QList<UAVObjectField *> UAVObject::getFields()
  */
 UAVObjectField *UAVObject::getField(const QString & name)
 {
-    QMutexLocker locker(mutex);
-
     // Look for field
-    for (int n = 0; n < fields.length(); ++n) {
-        if (name.compare(fields[n]->getName()) == 0) {
-            return fields[n];
-        }
+    UAVObjectField *field = m_fieldIndex.value(name, NULL);
+
+    if (field != NULL) {
+        return field;
     }
     // If this point is reached then the field was not found
     qWarning() << "UAVObject::getField Non existant field" << name << "requested."
@@ -293,12 +362,26 @@ UAVObjectField *UAVObject::getField(const QString & name)
     return NULL;
 }
 
+/**
+ * Get a field by its position, see the generated FIELDINDEX_ constants
+ * @returns The field or NULL if out of range
+ */
+UAVObjectField *UAVObject::getFieldAt(quint32 index)
+{
+    return index < (quint32)fields.size() ? fields.at(index) : NULL;
+}
+
 /**
  * Pack the object data into a byte array
  * @returns The number of bytes copied
  */
 qint32 UAVObject::pack(quint8 *dataOut)
 {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // The fields are stored back to back in little endian order, which is the packed format
+    readData(dataOut);
+    return numBytes;
+#else
     QMutexLocker locker(mutex);
     qint32 offset = 0;
 
@@ -307,6 +390,7 @@ qint32 UAVObject::pack(quint8 *dataOut)
         offset += fields[n]->getNumBytes();
     }
     return numBytes;
+#endif
 }
 
 /**
@@ -318,10 +402,12 @@ qint32 UAVObject::unpack(const quint8 *dataIn)
     QMutexLocker locker(mutex);
     qint32 offset = 0;
 
+    beginDataUpdate();
     for (int n = 0; n < fields.length(); ++n) {
         fields[n]->unpack(&dataIn[offset]);
         offset += fields[n]->getNumBytes();
     }
+    endDataUpdate();
     emit objectUnpacked(this); // trigger object updated event
     emit objectUpdated(this);
 
@@ -343,6 +429,17 @@ quint8 UAVObject::updateCRC(quint8 crc)
     return crc;
 }
 
+/**
+ * Update a CRC-32 with the object data, as the firmware computes it for SettingsCRC
+ * @returns The updated CRC
+ */
+quint32 UAVObject::updateCRC32(quint32 crc)
+{
+    QMutexLocker locker(mutex);
+
+    return Crc::updateCRC32(crc, data, numBytes);
+}
+
 /**
  * Save the object data to the file.
  * The file will be created in the current directory
@@ -623,6 +720,47 @@ void UAVObject::setIsKnown(bool isKnown)
     }
 }
 
+bool UAVObject::hasVehicleTime() const
+{
+    QMutexLocker locker(mutex);
+
+    return m_hasVehicleTime;
+}
+
+quint32 UAVObject::getVehicleTime() const
+{
+    QMutexLocker locker(mutex);
+
+    return m_vehicleTime;
+}
+
+qint64 UAVObject::getVehicleSampleTime() const
+{
+    QMutexLocker locker(mutex);
+
+    return m_vehicleSampleTime;
+}
+
+/**
+ * Set by the telemetry before the update is unpacked, so the board time is
+ * current when the update signals are emitted.
+ */
+void UAVObject::setVehicleTime(quint32 vehicleTime, qint64 sampleTime)
+{
+    QMutexLocker locker(mutex);
+
+    m_hasVehicleTime    = true;
+    m_vehicleTime       = vehicleTime;
+    m_vehicleSampleTime = sampleTime;
+}
+
+void UAVObject::clearVehicleTime()
+{
+    QMutexLocker locker(mutex);
+
+    m_hasVehicleTime = false;
+}
+
 bool UAVObject::isSettingsObject()
 {
     return false;
@@ -35,8 +35,11 @@
 #include <QMutexLocker>
 #include <QString>
 #include <QList>
+#include <QHash>
+#include <QAtomicInt>
 #include <QFile>
 #include <stdint.h>
+#include <stddef.h>
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QJsonObject>
@@ -112,9 +115,12 @@ public:
     QString getCategory();
     QString getDescription();
     quint32 getNumBytes();
-    qint32 pack(quint8 *dataOut);
-    qint32 unpack(const quint8 *dataIn);
+    bool readData(quint8 *dataOut) const;
+    quint32 getDataSequence() const;
+    virtual qint32 pack(quint8 *dataOut);
+    virtual qint32 unpack(const quint8 *dataIn);
     quint8 updateCRC(quint8 crc = 0);
+    quint32 updateCRC32(quint32 crc = 0xFFFFFFFF);
     bool save();
     bool save(QFile & file);
     bool load();
@@ -129,6 +135,7 @@ public:
     qint32 getNumFields();
     QList<UAVObjectField *> getFields();
     UAVObjectField *getField(const QString & name);
+    UAVObjectField *getFieldAt(quint32 index);
     QString toString();
     QString toStringBrief();
     QString toStringData();
@@ -145,6 +152,14 @@ public:
     bool isKnown() const;
     void setIsKnown(bool isKnown);
 
+    // Board time in ms of the last update received timestamped, and the GCS
+    // time (ms since the epoch) it maps to
+    bool hasVehicleTime() const;
+    quint32 getVehicleTime() const;
+    qint64 getVehicleSampleTime() const;
+    void setVehicleTime(quint32 vehicleTime, qint64 sampleTime);
+    void clearVehicleTime();
+
     virtual bool isSettingsObject();
     virtual bool isDataObject();
     virtual bool isMetaDataObject();
@@ -199,8 +214,36 @@ protected:
     void setDescription(const QString & description);
     void setCategory(const QString & category);
 
+    // Writers must hold the object mutex and bracket every change of the object data
+    // with these calls so that lock-free readers can detect concurrent updates
+    void beginDataUpdate();
+    void endDataUpdate();
+    void readData(void *dest, const void *src, quint32 length) const;
+
+    /**
+     * Read a copy of a value located at the given offset in the object data without taking the mutex
+     */
+    template<typename T> T readValue(quint32 offset) const
+    {
+        T copy;
+
+        readData(&copy, &data[offset], sizeof(T));
+        return copy;
+    }
+
 private:
+    friend class UAVObjectField;
+
+    static const int MAX_LOCKFREE_READ_RETRIES = 16;
+
     bool m_isKnown;
+    bool m_hasVehicleTime;
+    quint32 m_vehicleTime;
+    qint64 m_vehicleSampleTime;
+    // Sequence counter of the object data, odd while an update is in progress
+    mutable QAtomicInt m_dataSequence;
+    int m_dataUpdateDepth;
+    QHash<QString, UAVObjectField *> m_fieldIndex;
 
 private slots:
     void fieldUpdated(UAVObjectField *field);
@@ -29,6 +29,8 @@
 #include <QtEndian>
 #include <QDebug>
 #include <QtWidgets>
+#include <QHash>
+#include <QMutex>
 
 UAVObjectField::UAVObjectField(const QString & name, const QString & description, const QString & units, FieldType type, quint32 numElements, const QStringList & options, const QString &limits)
 {
@@ -119,6 +121,22 @@ void UAVObjectField::limitsInitialize(const QString &limits)
     if (limits.isEmpty()) {
         return;
     }
+
+    // Every instance and clone of an object has the same limits, parse and compile them once
+    typedef QPair<QMap<quint32, QList<LimitStruct> >, QVector<QVector<CompiledLimit> > > CachedLimits;
+    static QMutex limitsCacheMutex;
+    static QHash<QString, CachedLimits> limitsCache;
+    const QString cacheKey = QString("%1:%2:%3:%4").arg(type).arg(numElements).arg(options.join(":")).arg(limits);
+    {
+        QMutexLocker locker(&limitsCacheMutex);
+        QHash<QString, CachedLimits>::const_iterator cached = limitsCache.constFind(cacheKey);
+        if (cached != limitsCache.constEnd()) {
+            elementLimits  = cached.value().first;
+            compiledLimits = cached.value().second;
+            return;
+        }
+    }
+
     QStringList stringPerElement = limits.split(";");
     quint32 index = 0;
     foreach(QString str, stringPerElement) {
@@ -201,264 +219,116 @@ void UAVObjectField::limitsInitialize(const QString &limits)
         elementLimits.insert(index, limitList);
         ++index;
     }
-    // foreach(QList<LimitStruct> limitList, elementLimits) {
-    // foreach(LimitStruct limit, limitList) {
-    // qDebug() << "Limit type" << limit.type << "for board" << limit.board << "for field" << getName();
-    // foreach(QVariant var, limit.values) {
-    // qDebug() << "value" << var;
-    // }
-    // }
-    // }
+    compileLimits();
+    QMutexLocker locker(&limitsCacheMutex);
+    limitsCache.insert(cacheKey, CachedLimits(elementLimits, compiledLimits));
 }
-bool UAVObjectField::isWithinLimits(QVariant var, quint32 index, int board)
-{
-    if (!elementLimits.keys().contains(index)) {
-        return true;
-    }
 
-    foreach(LimitStruct struc, elementLimits.value(index)) {
-        if ((struc.board != board) && board != 0 && struc.board != 0) {
+/**
+ * Convert the parsed limits into plain numbers, so checking a value does not
+ * go through QVariant conversions for every rule
+ */
+void UAVObjectField::compileLimits()
+{
+    compiledLimits.clear();
+    compiledLimits.resize(numElements);
+    for (QMap<quint32, QList<LimitStruct> >::const_iterator element = elementLimits.constBegin(); element != elementLimits.constEnd(); ++element) {
+        if (element.key() >= numElements) {
             continue;
         }
-        switch (struc.type) {
-        case EQUAL:
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toInt() == vars.toInt()) {
-                        return true;
-                    }
-                }
-                return false;
-
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toUInt() == vars.toUInt()) {
-                        return true;
-                    }
-                }
-                return false;
-
-                break;
-            case ENUM:
-            case STRING:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toString() == vars.toString()) {
-                        return true;
-                    }
-                }
-                return false;
-
-                break;
-            case FLOAT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toFloat() == vars.toFloat()) {
-                        return true;
-                    }
+        QVector<CompiledLimit> &rules = compiledLimits[element.key()];
+        foreach(const LimitStruct &struc, element.value()) {
+            CompiledLimit rule;
+
+            rule.type  = struc.type;
+            rule.board = struc.board;
+            foreach(const QVariant &value, struc.values) {
+                if (type == STRING) {
+                    rule.strings.append(value.toString());
+                } else {
+                    rule.values.append(limitValue(value));
                 }
-                return false;
-
-                break;
-            default:
-                return true;
             }
-            break;
-        case NOT_EQUAL:
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toInt() == vars.toInt()) {
-                        return false;
-                    }
-                }
-                return true;
 
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toUInt() == vars.toUInt()) {
-                        return false;
-                    }
-                }
-                return true;
-
-                break;
-            case ENUM:
-            case STRING:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toString() == vars.toString()) {
-                        return false;
-                    }
+            int count = (type == STRING) ? rule.strings.size() : rule.values.size();
+            if (struc.type == BETWEEN && count != 2) {
+                if (count < 2) {
+                    qDebug() << __FUNCTION__ << "between limit with less than 1 pair, ignored; field:" << name;
+                    rule.type = UNDEFINED;
+                } else {
+                    qDebug() << __FUNCTION__ << "between limit with more than 1 pair, using first; field" << name;
                 }
-                return true;
-
-                break;
-            case FLOAT32:
-                foreach(QVariant vars, struc.values) {
-                    if (var.toFloat() == vars.toFloat()) {
-                        return false;
-                    }
+            } else if ((struc.type == BIGGER || struc.type == SMALLER) && count != 1) {
+                if (count < 1) {
+                    qDebug() << __FUNCTION__ << "bigger or smaller limit without a value, ignored; field:" << name;
+                    rule.type = UNDEFINED;
+                } else {
+                    qDebug() << __FUNCTION__ << "bigger or smaller limit with more than 1 value, using first; field" << name;
                 }
-                return true;
-
-                break;
-            default:
-                return true;
             }
-            break;
-        case BETWEEN:
-            if (struc.values.length() < 2) {
-                qDebug() << __FUNCTION__ << "between limit with less than 1 pair, aborting; field:" << name;
-                return true;
-            }
-            if (struc.values.length() > 2) {
-                qDebug() << __FUNCTION__ << "between limit with more than 1 pair, using first; field" << name;
-            }
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                if (!(var.toInt() >= struc.values.at(0).toInt() && var.toInt() <= struc.values.at(1).toInt())) {
-                    return false;
-                }
-                return true;
-
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                if (!(var.toUInt() >= struc.values.at(0).toUInt() && var.toUInt() <= struc.values.at(1).toUInt())) {
-                    return false;
-                }
-                return true;
-
-                break;
-            case ENUM:
-                if (!(options.indexOf(var.toString()) >= options.indexOf(struc.values.at(0).toString()) && options.indexOf(var.toString()) <= options.indexOf(struc.values.at(1).toString()))) {
-                    return false;
-                }
-                return true;
-
-                break;
-            case STRING:
-                return true;
+            rules.append(rule);
+        }
+    }
+}
 
-                break;
-            case FLOAT32:
-                if (!(var.toFloat() >= struc.values.at(0).toFloat() && var.toFloat() <= struc.values.at(1).toFloat())) {
-                    return false;
-                }
-                return true;
+/**
+ * A value or limit as the number the limits compare, converted as the field type
+ */
+double UAVObjectField::limitValue(const QVariant &var) const
+{
+    switch (type) {
+    case INT8:
+    case INT16:
+    case INT32:
+        return var.toInt();
 
-                break;
-            default:
-                return true;
-            }
-            break;
-        case BIGGER:
-            if (struc.values.length() < 1) {
-                qDebug() << __FUNCTION__ << "BIGGER limit with less than 1 value, aborting; field:" << name;
-                return true;
-            }
-            if (struc.values.length() > 1) {
-                qDebug() << __FUNCTION__ << "BIGGER limit with more than 1 value, using first; field" << name;
-            }
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                if (!(var.toInt() >= struc.values.at(0).toInt())) {
-                    return false;
-                }
-                return true;
+    case UINT8:
+    case UINT16:
+    case UINT32:
+    case BITFIELD:
+        return var.toUInt();
 
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                if (!(var.toUInt() >= struc.values.at(0).toUInt())) {
-                    return false;
-                }
-                return true;
+    case FLOAT32:
+        return var.toFloat();
 
-                break;
-            case ENUM:
-                if (!(options.indexOf(var.toString()) >= options.indexOf(struc.values.at(0).toString()))) {
-                    return false;
-                }
-                return true;
+    case ENUM:
+        return options.indexOf(var.toString());
 
-                break;
-            case STRING:
-                return true;
+    default:
+        return 0;
+    }
+}
+bool UAVObjectField::isWithinLimits(QVariant var, quint32 index, int board)
+{
+    if (index >= (quint32)compiledLimits.size() || compiledLimits.at(index).isEmpty()) {
+        return true;
+    }
 
-                break;
-            case FLOAT32:
-                if (!(var.toFloat() >= struc.values.at(0).toFloat())) {
-                    return false;
-                }
-                return true;
+    const QVector<CompiledLimit> &rules = compiledLimits.at(index);
+    const bool text      = (type == STRING);
+    const double value   = text ? 0 : limitValue(var);
+    const QString string = text ? var.toString() : QString();
 
-                break;
-            default:
-                return true;
-            }
-            break;
-        case SMALLER:
-            switch (type) {
-            case INT8:
-            case INT16:
-            case INT32:
-                if (!(var.toInt() <= struc.values.at(0).toInt())) {
-                    return false;
-                }
-                return true;
+    for (QVector<CompiledLimit>::const_iterator rule = rules.constBegin(); rule != rules.constEnd(); ++rule) {
+        if ((rule->board != board) && board != 0 && rule->board != 0) {
+            continue;
+        }
+        switch (rule->type) {
+        case EQUAL:
+            return text ? rule->strings.contains(string) : rule->values.contains(value);
 
-                break;
-            case UINT8:
-            case UINT16:
-            case UINT32:
-            case BITFIELD:
-                if (!(var.toUInt() <= struc.values.at(0).toUInt())) {
-                    return false;
-                }
-                return true;
+        case NOT_EQUAL:
+            return text ? !rule->strings.contains(string) : !rule->values.contains(value);
 
-                break;
-            case ENUM:
-                if (!(options.indexOf(var.toString()) <= options.indexOf(struc.values.at(0).toString()))) {
-                    return false;
-                }
-                return true;
+        case BETWEEN:
+            return text || (value >= rule->values.at(0) && value <= rule->values.at(1));
 
-                break;
-            case STRING:
-                return true;
+        case BIGGER:
+            return text || value >= rule->values.at(0);
 
-                break;
-            case FLOAT32:
-                if (!(var.toFloat() <= struc.values.at(0).toFloat())) {
-                    return false;
-                }
-                return true;
+        case SMALLER:
+            return text || value <= rule->values.at(0);
 
-                break;
-            default:
-                return true;
-            }
         default:
             return true;
         }
@@ -470,7 +340,7 @@ QString UAVObjectField::getLimitsAsString(quint32 index, int board)
 {
     QString limitString;
 
-    if (elementLimits.keys().contains(index)) {
+    if (elementLimits.contains(index)) {
         foreach(LimitStruct struc, elementLimits.value(index)) {
             if ((struc.board != board) && board != 0 && struc.board != 0) {
                 continue;
@@ -520,7 +390,7 @@ QString UAVObjectField::getLimitsAsString(quint32 index, int board)
 
 QVariant UAVObjectField::getMaxLimit(quint32 index, int board)
 {
-    if (!elementLimits.keys().contains(index)) {
+    if (!elementLimits.contains(index)) {
         return QVariant();
     }
     foreach(LimitStruct struc, elementLimits.value(index)) {
@@ -547,7 +417,7 @@ QVariant UAVObjectField::getMaxLimit(quint32 index, int board)
 }
 QVariant UAVObjectField::getMinLimit(quint32 index, int board)
 {
-    if (!elementLimits.keys().contains(index)) {
+    if (!elementLimits.contains(index)) {
         return QVariant();
     }
     foreach(LimitStruct struc, elementLimits.value(index)) {
@@ -637,6 +507,7 @@ void UAVObjectField::clear()
 {
     QMutexLocker locker(obj->getMutex());
 
+    obj->beginDataUpdate();
     switch (type) {
     case BITFIELD:
         memset(&data[offset], 0, numBytesPerElement * ((quint32)(1 + (numElements - 1) / 8)));
@@ -645,6 +516,7 @@ void UAVObjectField::clear()
         memset(&data[offset], 0, numBytesPerElement * numElements);
         break;
     }
+    obj->endDataUpdate();
 }
 
 QString UAVObjectField::getName()
@@ -838,6 +710,7 @@ qint32 UAVObjectField::unpack(const quint8 *dataIn)
     QMutexLocker locker(obj->getMutex());
 
     // Unpack each element from input buffer
+    obj->beginDataUpdate();
     switch (type) {
     case INT8:
         memcpy(&data[offset], dataIn, numElements);
@@ -896,6 +769,7 @@ qint32 UAVObjectField::unpack(const quint8 *dataIn)
         memcpy(&data[offset], dataIn, numElements);
         break;
     }
+    obj->endDataUpdate();
     // Done
     return getNumBytes();
 }
@@ -951,18 +825,16 @@ bool UAVObjectField::isText()
 
 QVariant UAVObjectField::getValue(quint32 index)
 {
-    QMutexLocker locker(obj->getMutex());
-
     // Check that index is not out of bounds
     if (index >= numElements) {
         return QVariant();
     }
-    // Get value
+    // Get value, the object data is read without taking the object mutex
     switch (type) {
     case INT8:
     {
         qint8 tmpint8;
-        memcpy(&tmpint8, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpint8, &data[offset + numBytesPerElement * index], numBytesPerElement);
         return QVariant(tmpint8);
 
         break;
@@ -970,7 +842,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case INT16:
     {
         qint16 tmpint16;
-        memcpy(&tmpint16, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpint16, &data[offset + numBytesPerElement * index], numBytesPerElement);
         return QVariant(tmpint16);
 
         break;
@@ -978,7 +850,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case INT32:
     {
         qint32 tmpint32;
-        memcpy(&tmpint32, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpint32, &data[offset + numBytesPerElement * index], numBytesPerElement);
         return QVariant(tmpint32);
 
         break;
@@ -986,7 +858,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case UINT8:
     {
         quint8 tmpuint8;
-        memcpy(&tmpuint8, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpuint8, &data[offset + numBytesPerElement * index], numBytesPerElement);
         return QVariant(tmpuint8);
 
         break;
@@ -994,7 +866,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case UINT16:
     {
         quint16 tmpuint16;
-        memcpy(&tmpuint16, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpuint16, &data[offset + numBytesPerElement * index], numBytesPerElement);
         return QVariant(tmpuint16);
 
         break;
@@ -1002,7 +874,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case UINT32:
     {
         quint32 tmpuint32;
-        memcpy(&tmpuint32, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpuint32, &data[offset + numBytesPerElement * index], numBytesPerElement);
         return QVariant(tmpuint32);
 
         break;
@@ -1010,7 +882,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case FLOAT32:
     {
         float tmpfloat;
-        memcpy(&tmpfloat, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpfloat, &data[offset + numBytesPerElement * index], numBytesPerElement);
         return QVariant(tmpfloat);
 
         break;
@@ -1018,7 +890,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case ENUM:
     {
         quint8 tmpenum;
-        memcpy(&tmpenum, &data[offset + numBytesPerElement * index], numBytesPerElement);
+        obj->readData(&tmpenum, &data[offset + numBytesPerElement * index], numBytesPerElement);
         if (tmpenum >= options.length()) {
             qDebug() << "Invalid value for" << name;
             tmpenum = 0;
@@ -1030,7 +902,7 @@ QVariant UAVObjectField::getValue(quint32 index)
     case BITFIELD:
     {
         quint8 tmpbitfield;
-        memcpy(&tmpbitfield, &data[offset + numBytesPerElement * ((quint32)(index / 8))], numBytesPerElement);
+        obj->readData(&tmpbitfield, &data[offset + numBytesPerElement * ((quint32)(index / 8))], numBytesPerElement);
         tmpbitfield = (tmpbitfield >> (index % 8)) & 1;
         return QVariant(tmpbitfield);
 
@@ -1038,8 +910,10 @@ QVariant UAVObjectField::getValue(quint32 index)
     }
     case STRING:
     {
-        data[offset + numElements - 1] = '\0';
-        QString str((char *)&data[offset]);
+        QByteArray buffer(numElements, '\0');
+        obj->readData(buffer.data(), &data[offset], numElements);
+        buffer[numElements - 1] = '\0';
+        QString str(buffer.constData());
         return QVariant(str);
 
         break;
@@ -1102,6 +976,7 @@ void UAVObjectField::setValue(const QVariant & value, quint32 index)
     UAVObject::Metadata mdata = obj->getMetadata();
     // Update value if the access mode permits
     if (UAVObject::GetGcsAccess(mdata) == UAVObject::ACCESS_READWRITE) {
+        obj->beginDataUpdate();
         switch (type) {
         case INT8:
         {
@@ -1175,12 +1050,40 @@ void UAVObjectField::setValue(const QVariant & value, quint32 index)
             break;
         }
         }
+        obj->endDataUpdate();
     }
 }
 
 double UAVObjectField::getDouble(quint32 index)
 {
-    return getValue(index).toDouble();
+    if (index >= numElements) {
+        return 0;
+    }
+    switch (type) {
+    case INT8:
+        return read<qint8>(index);
+
+    case INT16:
+        return read<qint16>(index);
+
+    case INT32:
+        return read<qint32>(index);
+
+    case UINT8:
+        return read<quint8>(index);
+
+    case UINT16:
+        return read<quint16>(index);
+
+    case UINT32:
+        return read<quint32>(index);
+
+    case FLOAT32:
+        return read<float>(index);
+
+    default:
+        return getValue(index).toDouble();
+    }
 }
 
 void UAVObjectField::setDouble(double value, quint32 index)
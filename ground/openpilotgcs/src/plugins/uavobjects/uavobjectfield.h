@@ -34,6 +34,7 @@
 #include <QVariant>
 #include <QList>
 #include <QMap>
+#include <QVector>
 #include <QXmlStreamWriter>
 #include <QXmlStreamReader>
 #include <QJsonObject>
@@ -71,6 +72,16 @@ public:
     void setValue(const QVariant & data, quint32 index = 0);
     double getDouble(quint32 index = 0);
     void setDouble(double value, quint32 index = 0);
+
+    /**
+     * Typed read of one element, T must match the field type. No QVariant and no
+     * object mutex, the copy is retried if it races with an update.
+     */
+    template<typename T> T read(quint32 index = 0) const
+    {
+        Q_ASSERT(sizeof(T) == numBytesPerElement && index < numElements);
+        return obj->readValue<T>(offset + index * sizeof(T));
+    }
     quint32 getDataOffset();
     quint32 getNumBytes();
     bool isNumeric();
@@ -104,9 +115,22 @@ protected:
     quint8 *data;
     UAVObject *obj;
     QMap<quint32, QList<LimitStruct> > elementLimits;
+
+    // A limit rule compiled for isWithinLimits(), values are the option indexes for enums
+    typedef struct {
+        LimitType type;
+        int board;
+        QVector<double> values;
+        QStringList strings; // STRING fields only
+    } CompiledLimit;
+    // Rules of each element, in the order of the limit string
+    QVector<QVector<CompiledLimit> > compiledLimits;
+
     void clear();
     void constructorInitialize(const QString & name, const QString & description, const QString & units, FieldType type, const QStringList & elementNames, const QStringList & options, const QString &limits);
     void limitsInitialize(const QString &limits);
+    void compileLimits();
+    double limitValue(const QVariant &var) const;
 };
 
 #endif // UAVOBJECTFIELD_H
@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectfieldbinding.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjectfieldbinding.h"
+#include "uavobjectmanager.h"
+
+#include <QDebug>
+
+UAVObjectFieldBinding::UAVObjectFieldBinding(QObject *parent) : QObject(parent),
+    m_objManager(NULL), m_object(NULL), m_field(NULL), m_index(0)
+{}
+
+UAVObjectFieldBinding::~UAVObjectFieldBinding()
+{
+    unbind();
+}
+
+/**
+ * Resolve the object, field and element, replacing a previous binding.
+ * \return false if any of them does not exist, the binding is unbound then
+ */
+bool UAVObjectFieldBinding::bind(UAVObjectManager *objManager, const QString & objectName, const QString & fieldName)
+{
+    unbind();
+
+    if (objManager == NULL || objectName.isEmpty() || fieldName.isEmpty()) {
+        return false;
+    }
+
+    UAVObject *obj = objManager->getObject(objectName);
+    if (obj == NULL) {
+        qDebug() << "UAVObjectFieldBinding: unknown object" << objectName;
+        return false;
+    }
+
+    int separator = fieldName.indexOf('-');
+    QString name  = separator < 0 ? fieldName : fieldName.left(separator);
+    UAVObjectField *field = obj->getField(name);
+    if (field == NULL) {
+        qDebug() << "UAVObjectFieldBinding: unknown field" << objectName << fieldName;
+        return false;
+    }
+
+    int index = 0;
+    if (separator >= 0) {
+        index = field->getElementNames().indexOf(fieldName.mid(separator + 1));
+        if (index < 0) {
+            qDebug() << "UAVObjectFieldBinding: unknown element" << objectName << fieldName;
+            return false;
+        }
+    }
+
+    m_objManager = objManager;
+    m_object     = obj;
+    m_field      = field;
+    m_index      = index;
+    m_objManager->subscribeCoalesced(m_object, this, SLOT(objectUpdated(UAVObject *)));
+    return true;
+}
+
+void UAVObjectFieldBinding::unbind()
+{
+    if (m_objManager && m_object) {
+        m_objManager->unsubscribeCoalesced(m_object, this);
+    }
+    m_objManager = NULL;
+    m_object     = NULL;
+    m_field      = NULL;
+    m_index      = 0;
+}
+
+void UAVObjectFieldBinding::objectUpdated(UAVObject *obj)
+{
+    if (obj == m_object) {
+        emit updated();
+    }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectfieldbinding.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTFIELDBINDING_H
+#define UAVOBJECTFIELDBINDING_H
+
+#include "uavobjects_global.h"
+#include "uavobject.h"
+#include "uavobjectfield.h"
+#include <QObject>
+#include <QVariant>
+
+class UAVObjectManager;
+
+/**
+ * One element of a UAVObject field, looked up by name once when bound.
+ * Updates arrive through the coalesced notifications of the object manager,
+ * so a gadget redraws at most once per display frame whatever the telemetry rate.
+ */
+class UAVOBJECTS_EXPORT UAVObjectFieldBinding : public QObject {
+    Q_OBJECT
+
+public:
+    explicit UAVObjectFieldBinding(QObject *parent = 0);
+    ~UAVObjectFieldBinding();
+
+    // fieldName is "Field" or "Field-Element" as stored in the gadget configurations
+    bool bind(UAVObjectManager *objManager, const QString & objectName, const QString & fieldName);
+    void unbind();
+
+    bool isBound() const
+    {
+        return m_field != NULL;
+    }
+    UAVObject *object() const
+    {
+        return m_object;
+    }
+    UAVObjectField *field() const
+    {
+        return m_field;
+    }
+    quint32 index() const
+    {
+        return m_index;
+    }
+    double getDouble() const
+    {
+        return m_field ? m_field->getDouble(m_index) : 0.0;
+    }
+    QVariant getValue() const
+    {
+        return m_field ? m_field->getValue(m_index) : QVariant();
+    }
+
+signals:
+    void updated();
+
+private slots:
+    void objectUpdated(UAVObject *obj);
+
+private:
+    UAVObjectManager *m_objManager;
+    UAVObject *m_object;
+    UAVObjectField *m_field;
+    quint32 m_index;
+};
+
+#endif // UAVOBJECTFIELDBINDING_H
@@ -0,0 +1,451 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjecthistory.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjecthistory.h"
+#include "uavobjectmanager.h"
+#include <QDateTime>
+#include <string.h>
+
+/*
+ * Delta of delta of the times, the ranges and their prefix:
+ *   0                 '0'
+ *   -63..64           '10'   + 7 bits
+ *   -255..256         '110'  + 9 bits
+ *   -2047..2048       '1110' + 12 bits
+ *   anything else     '1111' + 64 bits
+ * XOR of the value with the previous one:
+ *   0                 '0'
+ *   within the window of meaningful bits of the previous one
+ *                     '10'   + the bits of that window
+ *   else              '11'   + 5 bits leading zeros + 6 bits length - 1 + the meaningful bits
+ */
+static int leadingZeros(quint64 bits)
+{
+    int count = 0;
+
+    for (quint64 mask = 1ULL << 63; mask && !(bits & mask); mask >>= 1) {
+        count++;
+    }
+    return count;
+}
+
+static int trailingZeros(quint64 bits)
+{
+    int count = 0;
+
+    for (quint64 mask = 1; mask && !(bits & mask); mask <<= 1) {
+        count++;
+    }
+    return count;
+}
+
+static quint64 doubleBits(double value)
+{
+    quint64 bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bitsDouble(quint64 bits)
+{
+    double value;
+
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+UAVObjectHistory::UAVObjectHistory(UAVObjectManager *objManager, QObject *parent) :
+    QObject(parent), m_objManager(objManager), m_maxAge(DEFAULT_MAX_AGE_MS),
+    m_maxBytes(DEFAULT_MAX_BYTES), m_bytes(0)
+{
+    foreach(QList<UAVDataObject *> instances, m_objManager->getDataObjects()) {
+        foreach(UAVDataObject * obj, instances) {
+            newObject(obj);
+        }
+    }
+    connect(m_objManager, SIGNAL(newObject(UAVObject *)), this, SLOT(newObject(UAVObject *)));
+    connect(m_objManager, SIGNAL(newInstance(UAVObject *)), this, SLOT(newObject(UAVObject *)));
+
+    connect(&m_pruneTimer, SIGNAL(timeout()), this, SLOT(prune()));
+    m_pruneTimer.start(PRUNE_INTERVAL_MS);
+}
+
+UAVObjectHistory::~UAVObjectHistory()
+{
+    qDeleteAll(m_objects);
+}
+
+void UAVObjectHistory::setLimits(qint64 maxAgeMs, qint64 maxBytes)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_maxAge   = maxAgeMs;
+        m_maxBytes = maxBytes;
+    }
+    prune();
+}
+
+qint64 UAVObjectHistory::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_bytes;
+}
+
+void UAVObjectHistory::newObject(UAVObject *obj)
+{
+    if (obj->isMetaDataObject()) {
+        return;
+    }
+    // Every update is recorded, in the thread which made it
+    connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)), Qt::DirectConnection);
+}
+
+void UAVObjectHistory::objectUpdated(UAVObject *obj)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker locker(&m_mutex);
+    ObjectColumns *columns = m_objects.value(obj);
+
+    if (!columns) {
+        // columns are only made for the objects which get updated
+        columns = new ObjectColumns();
+        int count = 0;
+        foreach(UAVObjectField * field, obj->getFields()) {
+            if (field->getType() == UAVObjectField::STRING) {
+                columns->fieldOffset << -1;
+            } else {
+                columns->fieldOffset << count;
+                count += field->getNumElements();
+            }
+        }
+        Column empty;
+        empty.open.firstTime = 0;
+        empty.open.lastTime  = 0;
+        empty.open.count     = 0;
+        empty.bitPos    = 0;
+        empty.lastDelta = 0;
+        empty.lastValue = 0;
+        empty.leading   = -1;
+        empty.trailing  = -1;
+        columns->columns.fill(empty, count);
+        m_objects.insert(obj, columns);
+    }
+
+    QList<UAVObjectField *> fields = obj->getFields();
+    for (int i = 0; i < fields.count(); i++) {
+        int offset = columns->fieldOffset.at(i);
+        if (offset < 0) {
+            continue;
+        }
+        UAVObjectField *field = fields.at(i);
+        for (quint32 element = 0; element < field->getNumElements(); element++) {
+            append(columns->columns[offset + element], now, field->getDouble(element));
+        }
+    }
+}
+
+void UAVObjectHistory::append(Column &column, qint64 time, double value)
+{
+    Block &block = column.open;
+    quint64 bits = doubleBits(value);
+    int before   = block.bits.size();
+
+    if (block.count == 0) {
+        block.firstTime = time;
+        writeBits(column, (quint64)time, 64);
+        writeBits(column, bits, 64);
+    } else {
+        qint64 delta = time - block.lastTime;
+        qint64 dod   = delta - column.lastDelta;
+        column.lastDelta = delta;
+        if (dod == 0) {
+            writeBits(column, 0, 1);
+        } else if (dod >= -63 && dod <= 64) {
+            writeBits(column, 0x2, 2);
+            writeBits(column, dod + 63, 7);
+        } else if (dod >= -255 && dod <= 256) {
+            writeBits(column, 0x6, 3);
+            writeBits(column, dod + 255, 9);
+        } else if (dod >= -2047 && dod <= 2048) {
+            writeBits(column, 0xE, 4);
+            writeBits(column, dod + 2047, 12);
+        } else {
+            writeBits(column, 0xF, 4);
+            writeBits(column, (quint64)dod, 64);
+        }
+
+        quint64 x = bits ^ column.lastValue;
+        if (x == 0) {
+            writeBits(column, 0, 1);
+        } else {
+            int leading  = qMin(leadingZeros(x), 31);
+            int trailing = trailingZeros(x);
+            if (column.leading >= 0 && leading >= column.leading && trailing >= column.trailing) {
+                writeBits(column, 0x2, 2);
+                writeBits(column, x >> column.trailing, 64 - column.leading - column.trailing);
+            } else {
+                int length = 64 - leading - trailing;
+                writeBits(column, 0x3, 2);
+                writeBits(column, leading, 5);
+                writeBits(column, length - 1, 6);
+                writeBits(column, x >> trailing, length);
+                column.leading  = leading;
+                column.trailing = trailing;
+            }
+        }
+    }
+    column.lastValue = bits;
+    block.lastTime   = time;
+    block.count++;
+    m_bytes += block.bits.size() - before;
+
+    if (block.count == BLOCK_SAMPLES) {
+        seal(column, time);
+    }
+}
+
+void UAVObjectHistory::writeBits(Column &column, quint64 bits, int count)
+{
+    QByteArray &data = column.open.bits;
+
+    while (count > 0) {
+        int used = column.bitPos & 7;
+        if (used == 0) {
+            data.append('\0');
+        }
+        int chunk = qMin(8 - used, count);
+        quint8 part = (bits >> (count - chunk)) & ((1 << chunk) - 1);
+        data.data()[data.size() - 1] |= part << (8 - used - chunk);
+        column.bitPos += chunk;
+        count -= chunk;
+    }
+}
+
+void UAVObjectHistory::seal(Column &column, qint64 now)
+{
+    column.sealed.append(column.open);
+    column.open.bits = QByteArray();
+    column.open.count = 0;
+    column.bitPos    = 0;
+    column.lastDelta = 0;
+    column.leading   = -1;
+    column.trailing  = -1;
+
+    while (!column.sealed.isEmpty() && column.sealed.first().lastTime < now - m_maxAge) {
+        m_bytes -= column.sealed.takeFirst().bits.size();
+    }
+    while (m_bytes > m_maxBytes && m_bytes > 0) {
+        dropOldest();
+    }
+}
+
+/**
+ * Drops the oldest sealed block of all columns, or the oldest open one when
+ * there are no sealed blocks left
+ */
+void UAVObjectHistory::dropOldest()
+{
+    Column *oldest = NULL;
+    bool sealed    = false;
+
+    foreach(ObjectColumns * columns, m_objects) {
+        for (int i = 0; i < columns->columns.count(); i++) {
+            Column *column = &columns->columns[i];
+            if (!column->sealed.isEmpty()) {
+                if (!sealed || column->sealed.first().firstTime < oldest->sealed.first().firstTime) {
+                    oldest = column;
+                    sealed = true;
+                }
+            } else if (!sealed && column->open.count && (!oldest || column->open.firstTime < oldest->open.firstTime)) {
+                oldest = column;
+            }
+        }
+    }
+    if (!oldest) {
+        m_bytes = 0;
+    } else if (sealed) {
+        m_bytes -= oldest->sealed.takeFirst().bits.size();
+    } else {
+        m_bytes -= oldest->open.bits.size();
+        oldest->open.bits.clear();
+        oldest->open.count = 0;
+        oldest->bitPos     = 0;
+        oldest->lastDelta  = 0;
+        oldest->leading    = -1;
+        oldest->trailing   = -1;
+    }
+}
+
+/**
+ * Drops the blocks which got too old, also in the columns which are not updated any more
+ */
+void UAVObjectHistory::prune()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker locker(&m_mutex);
+
+    foreach(ObjectColumns * columns, m_objects) {
+        for (int i = 0; i < columns->columns.count(); i++) {
+            Column &column = columns->columns[i];
+            while (!column.sealed.isEmpty() && column.sealed.first().lastTime < now - m_maxAge) {
+                m_bytes -= column.sealed.takeFirst().bits.size();
+            }
+            if (column.open.count && column.open.lastTime < now - m_maxAge) {
+                m_bytes -= column.open.bits.size();
+                column.open.bits.clear();
+                column.open.count = 0;
+                column.bitPos     = 0;
+                column.lastDelta  = 0;
+                column.leading    = -1;
+                column.trailing   = -1;
+            }
+        }
+    }
+    while (m_bytes > m_maxBytes && m_bytes > 0) {
+        dropOldest();
+    }
+}
+
+UAVObjectHistory::View UAVObjectHistory::range(UAVObject *obj, UAVObjectField *field, int element, qint64 from, qint64 to) const
+{
+    View view;
+
+    view.m_from = from;
+    view.m_to   = to;
+
+    QMutexLocker locker(&m_mutex);
+    ObjectColumns *columns = m_objects.value(obj);
+    int index = columns ? obj->getFields().indexOf(field) : -1;
+    if (index < 0 || columns->fieldOffset.at(index) < 0 || element < 0 || (quint32)element >= field->getNumElements()) {
+        return view;
+    }
+    const Column &column = columns->columns.at(columns->fieldOffset.at(index) + element);
+    foreach(const Block &block, column.sealed) {
+        if (block.lastTime >= from && block.firstTime <= to) {
+            view.m_blocks << block;
+        }
+    }
+    if (column.open.count && column.open.lastTime >= from && column.open.firstTime <= to) {
+        view.m_blocks << column.open;
+    }
+    return view;
+}
+
+QVector<UAVObjectHistory::Sample> UAVObjectHistory::samples(UAVObject *obj, UAVObjectField *field, int element, qint64 from, qint64 to) const
+{
+    QVector<Sample> samples;
+    View view = range(obj, field, element, from, to);
+    Sample sample;
+
+    while (view.next(&sample)) {
+        samples << sample;
+    }
+    return samples;
+}
+
+UAVObjectHistory::View::View() :
+    m_from(0), m_to(0), m_block(0), m_index(0), m_bitPos(0), m_time(0), m_delta(0),
+    m_value(0), m_leading(0), m_trailing(0)
+{}
+
+quint64 UAVObjectHistory::View::readBits(int count)
+{
+    const QByteArray &data = m_blocks.at(m_block).bits;
+    quint64 bits = 0;
+
+    while (count > 0) {
+        int used  = m_bitPos & 7;
+        int chunk = qMin(8 - used, count);
+        quint8 byte = data.at(m_bitPos >> 3);
+        bits = (bits << chunk) | ((byte >> (8 - used - chunk)) & ((1 << chunk) - 1));
+        m_bitPos += chunk;
+        count    -= chunk;
+    }
+    return bits;
+}
+
+/**
+ * The next sample of the range, false at its end
+ */
+bool UAVObjectHistory::View::next(Sample *sample)
+{
+    while (m_block < m_blocks.count()) {
+        if (m_index == m_blocks.at(m_block).count) {
+            m_block++;
+            m_index  = 0;
+            m_bitPos = 0;
+            continue;
+        }
+        if (m_index == 0) {
+            m_time  = (qint64)readBits(64);
+            m_value = readBits(64);
+            m_delta = 0;
+        } else {
+            qint64 dod;
+            if (readBits(1) == 0) {
+                dod = 0;
+            } else if (readBits(1) == 0) {
+                dod = (qint64)readBits(7) - 63;
+            } else if (readBits(1) == 0) {
+                dod = (qint64)readBits(9) - 255;
+            } else if (readBits(1) == 0) {
+                dod = (qint64)readBits(12) - 2047;
+            } else {
+                dod = (qint64)readBits(64);
+            }
+            m_delta += dod;
+            m_time  += m_delta;
+
+            if (readBits(1) == 1) {
+                if (readBits(1) == 1) {
+                    m_leading = readBits(5);
+                    int length = readBits(6) + 1;
+                    m_trailing = 64 - m_leading - length;
+                }
+                m_value ^= readBits(64 - m_leading - m_trailing) << m_trailing;
+            }
+        }
+        m_index++;
+        if (m_time > m_to) {
+            m_block = m_blocks.count();
+            return false;
+        }
+        if (m_time >= m_from) {
+            sample->time  = m_time;
+            sample->value = bitsDouble(m_value);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,143 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjecthistory.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTHISTORY_H
+#define UAVOBJECTHISTORY_H
+
+#include "uavobjects_global.h"
+#include "uavobject.h"
+#include "uavobjectfield.h"
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include <QMutex>
+#include <QTimer>
+
+class UAVObjectManager;
+
+/**
+ * The values every numeric field element of the data objects had lately, shared
+ * by the gadgets so they do not each buffer their own copy.
+ *
+ * Every element is a column of blocks of samples, each block compressed like
+ * Gorilla: the times (ms since the epoch) as delta of delta, the values XORed
+ * with the previous one. Blocks older than the maximum age are dropped, and the
+ * oldest ones of all columns when the store grows above its memory limit.
+ */
+class UAVOBJECTS_EXPORT UAVObjectHistory : public QObject {
+    Q_OBJECT
+
+    struct Block {
+        QByteArray bits;
+        qint64     firstTime;
+        qint64     lastTime;
+        int        count;
+    };
+
+public:
+    struct Sample {
+        qint64 time; // ms since the epoch
+        double value;
+    };
+
+    /**
+     * The samples of a column in a time range, decoded one at a time. It shares
+     * the compressed blocks with the store, it stays valid when they are dropped.
+     */
+    class UAVOBJECTS_EXPORT View {
+    public:
+        View();
+        bool next(Sample *sample);
+
+    private:
+        friend class UAVObjectHistory;
+        QList<Block> m_blocks;
+        qint64  m_from;
+        qint64  m_to;
+        int     m_block;
+        int     m_index;
+        int     m_bitPos;
+        qint64  m_time;
+        qint64  m_delta;
+        quint64 m_value;
+        int     m_leading;
+        int     m_trailing;
+
+        quint64 readBits(int count);
+    };
+
+    explicit UAVObjectHistory(UAVObjectManager *objManager, QObject *parent = 0);
+    ~UAVObjectHistory();
+
+    void setLimits(qint64 maxAgeMs, qint64 maxBytes);
+    qint64 memoryUsage() const;
+
+    View range(UAVObject *obj, UAVObjectField *field, int element, qint64 from, qint64 to) const;
+    QVector<Sample> samples(UAVObject *obj, UAVObjectField *field, int element, qint64 from, qint64 to) const;
+
+private slots:
+    void newObject(UAVObject *obj);
+    void objectUpdated(UAVObject *obj);
+    void prune();
+
+private:
+    struct Column {
+        QList<Block> sealed;
+        Block open;
+        int     bitPos;
+        qint64  lastDelta;
+        quint64 lastValue;
+        int     leading;
+        int     trailing;
+    };
+    struct ObjectColumns {
+        QVector<int> fieldOffset; // of the first element of every field in columns, -1 for strings
+        QVector<Column> columns;
+    };
+
+    UAVObjectManager *m_objManager;
+    QHash<UAVObject *, ObjectColumns *> m_objects;
+    mutable QMutex m_mutex;
+    QTimer m_pruneTimer;
+    qint64 m_maxAge;
+    qint64 m_maxBytes;
+    qint64 m_bytes;
+
+    void append(Column &column, qint64 time, double value);
+    void writeBits(Column &column, quint64 bits, int count);
+    void seal(Column &column, qint64 now);
+    void dropOldest();
+
+    static const int BLOCK_SAMPLES = 1024;
+    static const int PRUNE_INTERVAL_MS = 10000;
+    static const qint64 DEFAULT_MAX_AGE_MS = 30 * 60 * 1000;
+    static const qint64 DEFAULT_MAX_BYTES  = 64 * 1024 * 1024;
+};
+
+#endif // UAVOBJECTHISTORY_H
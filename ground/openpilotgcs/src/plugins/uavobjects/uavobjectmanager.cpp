@@ -35,6 +35,10 @@
 UAVObjectManager::UAVObjectManager()
 {
     mutex = new QMutex(QMutex::Recursive);
+
+    coalescedTimer = new QTimer(this);
+    coalescedTimer->setInterval(DEFAULT_COALESCED_UPDATE_INTERVAL_MS);
+    connect(coalescedTimer, SIGNAL(timeout()), this, SLOT(deliverCoalescedUpdates()));
 }
 
 UAVObjectManager::~UAVObjectManager()
@@ -53,54 +57,53 @@ bool UAVObjectManager::registerObject(UAVDataObject *obj)
     QMutexLocker locker(mutex);
 
     // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0 && objects[objidx][0]->getObjID() == obj->getObjID()) {
-            // Check if this is a single instance object, if yes we can not add a new instance
-            if (obj->isSingleInstance()) {
-                return false;
-            }
-            // The object type has alredy been added, so now we need to initialize the new instance with the appropriate id
-            // There is a single metaobject for all object instances of this type, so no need to create a new one
-            // Get object type metaobject from existing instance
-            UAVDataObject *refObj = dynamic_cast<UAVDataObject *>(objects[objidx][0]);
-            if (refObj == NULL) {
-                return false;
-            }
-            UAVMetaObject *mobj = refObj->getMetaObject();
-            // If the instance ID is specified and not at the default value (0) then we need to make sure
-            // that there are no gaps in the instance list. If gaps are found then then additional instances
-            // will be created.
-            if ((obj->getInstID() > 0) && (obj->getInstID() < MAX_INSTANCES)) {
-                for (int instidx = 0; instidx < objects[objidx].length(); ++instidx) {
-                    if (objects[objidx][instidx]->getInstID() == obj->getInstID()) {
-                        // Instance conflict, do not add
-                        return false;
-                    }
-                }
-                // Check if there are any gaps between the requested instance ID and the ones in the list,
-                // if any then create the missing instances.
-                for (quint32 instidx = objects[objidx].length(); instidx < obj->getInstID(); ++instidx) {
-                    UAVDataObject *cobj = obj->clone(instidx);
-                    cobj->initialize(mobj);
-                    objects[objidx].append(cobj);
-                    getObject(cobj->getObjID())->emitNewInstance(cobj);
-                    emit newInstance(cobj);
+    int objidx = getObjectIndex(NULL, obj->getObjID());
+
+    if (objidx >= 0) {
+        // Check if this is a single instance object, if yes we can not add a new instance
+        if (obj->isSingleInstance()) {
+            return false;
+        }
+        // The object type has alredy been added, so now we need to initialize the new instance with the appropriate id
+        // There is a single metaobject for all object instances of this type, so no need to create a new one
+        // Get object type metaobject from existing instance
+        UAVDataObject *refObj = dynamic_cast<UAVDataObject *>(objects[objidx][0]);
+        if (refObj == NULL) {
+            return false;
+        }
+        UAVMetaObject *mobj = refObj->getMetaObject();
+        // If the instance ID is specified and not at the default value (0) then we need to make sure
+        // that there are no gaps in the instance list. If gaps are found then then additional instances
+        // will be created.
+        if ((obj->getInstID() > 0) && (obj->getInstID() < MAX_INSTANCES)) {
+            for (int instidx = 0; instidx < objects[objidx].length(); ++instidx) {
+                if (objects[objidx][instidx]->getInstID() == obj->getInstID()) {
+                    // Instance conflict, do not add
+                    return false;
                 }
-                // Finally, initialize the actual object instance
-                obj->initialize(mobj);
-            } else if (obj->getInstID() == 0) {
-                // Assign the next available ID and initialize the object instance
-                obj->initialize(objects[objidx].length(), mobj);
-            } else {
-                return false;
             }
-            // Add the actual object instance in the list
-            objects[objidx].append(obj);
-            getObject(obj->getObjID())->emitNewInstance(obj);
-            emit newInstance(obj);
-            return true;
+            // Check if there are any gaps between the requested instance ID and the ones in the list,
+            // if any then create the missing instances.
+            for (quint32 instidx = objects[objidx].length(); instidx < obj->getInstID(); ++instidx) {
+                UAVDataObject *cobj = obj->clone(instidx);
+                cobj->initialize(mobj);
+                objects[objidx].append(cobj);
+                getObject(cobj->getObjID())->emitNewInstance(cobj);
+                emit newInstance(cobj);
+            }
+            // Finally, initialize the actual object instance
+            obj->initialize(mobj);
+        } else if (obj->getInstID() == 0) {
+            // Assign the next available ID and initialize the object instance
+            obj->initialize(objects[objidx].length(), mobj);
+        } else {
+            return false;
         }
+        // Add the actual object instance in the list
+        objects[objidx].append(obj);
+        getObject(obj->getObjID())->emitNewInstance(obj);
+        emit newInstance(obj);
+        return true;
     }
     // If this point is reached then this is the first time this object type (ID) is added in the list
     // create a new list of the instances, add in the object collection and create the object's metaobject
@@ -122,9 +125,25 @@ void UAVObjectManager::addObject(UAVObject *obj)
     QList<UAVObject *> list;
     list.append(obj);
     objects.append(list);
+    // Update the lookup indexes
+    objIdIndex.insert(obj->getObjID(), objects.length() - 1);
+    objNameIndex.insert(obj->getName(), objects.length() - 1);
     emit newObject(obj);
 }
 
+/**
+ * Get the index in the objects list of the object type given by name or by ID.
+ * Must be called with the mutex held.
+ * @returns The index or -1 if the object type is not registered
+ */
+int UAVObjectManager::getObjectIndex(const QString *name, quint32 objId) const
+{
+    if (name != NULL) {
+        return objNameIndex.value(*name, -1);
+    }
+    return objIdIndex.value(objId, -1);
+}
+
 /**
  * Get all objects. A two dimentional QList is returned. Objects are grouped by
  * instances of the same object type.
@@ -227,17 +246,19 @@ UAVObject *UAVObjectManager::getObject(const QString *name, quint32 objId, quint
 {
     QMutexLocker locker(mutex);
 
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0) {
-            if ((name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId)) {
-                // Look for the requested instance ID
-                for (int instidx = 0; instidx < objects[objidx].length(); ++instidx) {
-                    if (objects[objidx][instidx]->getInstID() == instId) {
-                        return objects[objidx][instidx];
-                    }
-                }
+    int objidx = getObjectIndex(name, objId);
+
+    if (objidx >= 0) {
+        const QList<UAVObject *> &instances = objects.at(objidx);
+        // Instances are kept without gaps and ordered by instance ID, so the
+        // instance ID can be used as index directly
+        if (instId < (quint32)instances.length() && instances.at(instId)->getInstID() == instId) {
+            return instances.at(instId);
+        }
+        // Fall back to searching the instance list
+        for (int instidx = 0; instidx < instances.length(); ++instidx) {
+            if (instances.at(instidx)->getInstID() == instId) {
+                return instances.at(instidx);
             }
         }
     }
@@ -269,14 +290,10 @@ QList<UAVObject *> UAVObjectManager::getObjectInstances(const QString *name, qui
 {
     QMutexLocker locker(mutex);
 
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0) {
-            if ((name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId)) {
-                return objects[objidx];
-            }
-        }
+    int objidx = getObjectIndex(name, objId);
+
+    if (objidx >= 0) {
+        return objects.at(objidx);
     }
     // If this point is reached then the requested object could not be found
     return QList<UAVObject *>();
@@ -363,15 +380,102 @@ qint32 UAVObjectManager::getNumInstances(const QString *name, quint32 objId)
 {
     QMutexLocker locker(mutex);
 
-    // Check if this object type is already in the list
-    for (int objidx = 0; objidx < objects.length(); ++objidx) {
-        // Check if the object ID is in the list
-        if (objects[objidx].length() > 0) {
-            if ((name != NULL && objects[objidx][0]->getName().compare(name) == 0) || (name == NULL && objects[objidx][0]->getObjID() == objId)) {
-                return objects[objidx].length();
-            }
-        }
+    int objidx = getObjectIndex(name, objId);
+
+    if (objidx >= 0) {
+        return objects.at(objidx).length();
     }
     // If this point is reached then the requested object could not be found
     return -1;
 }
+
+/**
+ * Subscribe to coalesced updates of an object. Instead of receiving every
+ * update, the receiver's member is invoked at most once per update interval
+ * with the object as argument, if the object was updated since the last call.
+ * \param member Slot taking a UAVObject pointer, given with the SLOT() macro
+ */
+void UAVObjectManager::subscribeCoalesced(UAVObject *obj, QObject *receiver, const char *member)
+{
+    if (obj == NULL || receiver == NULL || member == NULL) {
+        return;
+    }
+
+    // Keep the method name only, SLOT() adds a code and the signature
+    QByteArray method(member + 1);
+    method.truncate(method.indexOf('('));
+
+    CoalescedSubscriber subscriber;
+    subscriber.receiver = receiver;
+    subscriber.method   = method;
+
+    QList<CoalescedSubscriber> &subscribers = coalescedSubscribers[obj];
+    if (subscribers.isEmpty()) {
+        // Direct, the pending set is filled in the updating thread
+        connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(coalescedObjectUpdated(UAVObject *)), Qt::DirectConnection);
+    }
+    subscribers.append(subscriber);
+    if (!coalescedTimer->isActive()) {
+        coalescedTimer->start();
+    }
+}
+
+void UAVObjectManager::unsubscribeCoalesced(UAVObject *obj, QObject *receiver)
+{
+    QHash<UAVObject *, QList<CoalescedSubscriber> >::iterator it = coalescedSubscribers.find(obj);
+
+    if (it == coalescedSubscribers.end()) {
+        return;
+    }
+    for (int i = it.value().size() - 1; i >= 0; --i) {
+        if (it.value().at(i).receiver == receiver || it.value().at(i).receiver.isNull()) {
+            it.value().removeAt(i);
+        }
+    }
+    if (it.value().isEmpty()) {
+        disconnect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(coalescedObjectUpdated(UAVObject *)));
+        coalescedSubscribers.erase(it);
+    }
+    if (coalescedSubscribers.isEmpty()) {
+        coalescedTimer->stop();
+    }
+}
+
+void UAVObjectManager::setCoalescedUpdateInterval(int intervalMs)
+{
+    coalescedTimer->setInterval(intervalMs);
+}
+
+void UAVObjectManager::coalescedObjectUpdated(UAVObject *obj)
+{
+    QMutexLocker locker(&coalescedMutex);
+
+    coalescedPending.insert(obj);
+}
+
+void UAVObjectManager::deliverCoalescedUpdates()
+{
+    QSet<UAVObject *> pending;
+
+    coalescedMutex.lock();
+    pending.swap(coalescedPending);
+    coalescedMutex.unlock();
+
+    foreach(UAVObject * obj, pending) {
+        // Copy, a receiver may unsubscribe from its slot
+        QList<CoalescedSubscriber> subscribers = coalescedSubscribers.value(obj);
+        bool staleReceivers = false;
+        foreach(const CoalescedSubscriber &subscriber, subscribers) {
+            if (subscriber.receiver.isNull()) {
+                staleReceivers = true;
+                continue;
+            }
+            QMetaObject::invokeMethod(subscriber.receiver.data(), subscriber.method.constData(), Q_ARG(UAVObject *, obj));
+        }
+        if (staleReceivers) {
+            // Drops the subscriptions of deleted receivers
+            unsubscribeCoalesced(obj, NULL);
+        }
+    }
+}
+
@@ -33,9 +33,13 @@
 #include "uavdataobject.h"
 #include "uavmetaobject.h"
 #include <QList>
+#include <QHash>
+#include <QSet>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QJsonObject>
+#include <QPointer>
+#include <QTimer>
 
 class UAVOBJECTS_EXPORT UAVObjectManager : public QObject {
     Q_OBJECT
@@ -61,17 +65,44 @@ public:
     void toJson(QJsonObject &jsonObject, const QList<UAVObject *> &objectsToExport);
     void fromJson(const QJsonObject &jsonObject, QList<UAVObject *> *updatedObjects = NULL);
 
+    // Coalesced change notifications, to be used from the GUI thread
+    void subscribeCoalesced(UAVObject *obj, QObject *receiver, const char *member);
+    void unsubscribeCoalesced(UAVObject *obj, QObject *receiver);
+    void setCoalescedUpdateInterval(int intervalMs);
+
 signals:
     void newObject(UAVObject *obj);
     void newInstance(UAVObject *obj);
 
+private slots:
+    void coalescedObjectUpdated(UAVObject *obj);
+    void deliverCoalescedUpdates();
+
 private:
     static const quint32 MAX_INSTANCES = 1000;
+    // About one display frame
+    static const int DEFAULT_COALESCED_UPDATE_INTERVAL_MS = 16;
+
+    typedef struct {
+        QPointer<QObject> receiver;
+        QByteArray method;
+    } CoalescedSubscriber;
 
     QList< QList<UAVObject *> > objects;
+    // Lookup indexes into objects, keyed by object ID and by object name
+    QHash<quint32, int> objIdIndex;
+    QHash<QString, int> objNameIndex;
     QMutex *mutex;
 
+    // Subscribers are only touched from the GUI thread, the pending set is
+    // filled from the thread that updates the objects
+    QHash<UAVObject *, QList<CoalescedSubscriber> > coalescedSubscribers;
+    QSet<UAVObject *> coalescedPending;
+    QMutex coalescedMutex;
+    QTimer *coalescedTimer;
+
     void addObject(UAVObject *obj);
+    int getObjectIndex(const QString *name, quint32 objId) const;
     UAVObject *getObject(const QString *name, quint32 objId, quint32 instId);
     QList<UAVObject *> getObjectInstances(const QString *name, quint32 objId);
     qint32 getNumInstances(const QString *name, quint32 objId);
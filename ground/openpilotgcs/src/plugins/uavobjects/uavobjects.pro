@@ -13,6 +13,9 @@ HEADERS += \
     uavobjectmanager.h \
     uavdataobject.h \
     uavobjectfield.h \
+    uavobjectfieldbinding.h \
+    uavobjecthistory.h \
+    uavobjectstreams.h \
     uavobjectsinit.h \
     uavobjectsplugin.h
 SOURCES += \
@@ -21,6 +24,9 @@ SOURCES += \
     uavobjectmanager.cpp \
     uavdataobject.cpp \
     uavobjectfield.cpp \
+    uavobjectfieldbinding.cpp \
+    uavobjecthistory.cpp \
+    uavobjectstreams.cpp \
     uavobjectsplugin.cpp
 
 OTHER_FILES += UAVObjects.pluginspec
@@ -32,6 +38,7 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/accessorydesired.h \
     $$UAVOBJECT_SYNTHETICS/barosensor.h \
     $$UAVOBJECT_SYNTHETICS/airspeedsensor.h \
+    $$UAVOBJECT_SYNTHETICS/hitlsensors.h \
     $$UAVOBJECT_SYNTHETICS/airspeedsettings.h \
     $$UAVOBJECT_SYNTHETICS/airspeedstate.h \
     $$UAVOBJECT_SYNTHETICS/attitudestate.h \
@@ -48,6 +55,9 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/revocalibration.h \
     $$UAVOBJECT_SYNTHETICS/revosettings.h \
     $$UAVOBJECT_SYNTHETICS/gcstelemetrystats.h \
+    $$UAVOBJECT_SYNTHETICS/telemetryping.h \
+    $$UAVOBJECT_SYNTHETICS/metadataoverride.h \
+    $$UAVOBJECT_SYNTHETICS/telemetryobjectstats.h \
     $$UAVOBJECT_SYNTHETICS/gyrostate.h \
     $$UAVOBJECT_SYNTHETICS/gyrosensor.h \
     $$UAVOBJECT_SYNTHETICS/accelsensor.h \
@@ -59,6 +69,7 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/systemstats.h \
     $$UAVOBJECT_SYNTHETICS/systemalarms.h \
     $$UAVOBJECT_SYNTHETICS/objectpersistence.h \
+    $$UAVOBJECT_SYNTHETICS/settingscrc.h \
     $$UAVOBJECT_SYNTHETICS/overosyncstats.h \
     $$UAVOBJECT_SYNTHETICS/overosyncsettings.h \
     $$UAVOBJECT_SYNTHETICS/systemsettings.h \
@@ -111,6 +122,7 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/flightstatus.h \
     $$UAVOBJECT_SYNTHETICS/hwsettings.h \
     $$UAVOBJECT_SYNTHETICS/gcsreceiver.h \
+    $$UAVOBJECT_SYNTHETICS/gcsreceiverstatus.h \
     $$UAVOBJECT_SYNTHETICS/receiveractivity.h \
     $$UAVOBJECT_SYNTHETICS/attitudesettings.h \
     $$UAVOBJECT_SYNTHETICS/txpidsettings.h \
@@ -129,8 +141,22 @@ HEADERS += \
     $$UAVOBJECT_SYNTHETICS/takeofflocation.h \
     $$UAVOBJECT_SYNTHETICS/auxmagsensor.h \
     $$UAVOBJECT_SYNTHETICS/auxmagsettings.h \
+    $$UAVOBJECT_SYNTHETICS/auxmagcalibration.h \
     $$UAVOBJECT_SYNTHETICS/gpsextendedstatus.h \
-    $$UAVOBJECT_SYNTHETICS/perfcounter.h
+    $$UAVOBJECT_SYNTHETICS/perfcounter.h \
+    $$UAVOBJECT_SYNTHETICS/tracecontrol.h \
+    $$UAVOBJECT_SYNTHETICS/tracestatus.h \
+    $$UAVOBJECT_SYNTHETICS/tracedata.h \
+    $$UAVOBJECT_SYNTHETICS/latencyprobe.h \
+    $$UAVOBJECT_SYNTHETICS/memorystats.h \
+    $$UAVOBJECT_SYNTHETICS/memorypoolstats.h \
+    $$UAVOBJECT_SYNTHETICS/bootprofile.h \
+    $$UAVOBJECT_SYNTHETICS/vibrationanalysissettings.h \
+    $$UAVOBJECT_SYNTHETICS/vibrationanalysisoutput.h \
+    $$UAVOBJECT_SYNTHETICS/systemidentsettings.h \
+    $$UAVOBJECT_SYNTHETICS/systemident.h \
+    $$UAVOBJECT_SYNTHETICS/benchmarkresults.h \
+    $$UAVOBJECT_SYNTHETICS/callbackbenchmark.h
 
 SOURCES += \
     $$UAVOBJECT_SYNTHETICS/vtolselftuningstats.cpp \
@@ -138,6 +164,7 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/accessorydesired.cpp \
     $$UAVOBJECT_SYNTHETICS/barosensor.cpp \
     $$UAVOBJECT_SYNTHETICS/airspeedsensor.cpp \
+    $$UAVOBJECT_SYNTHETICS/hitlsensors.cpp \
     $$UAVOBJECT_SYNTHETICS/airspeedsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/airspeedstate.cpp \
     $$UAVOBJECT_SYNTHETICS/attitudestate.cpp \
@@ -154,6 +181,9 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/revocalibration.cpp \
     $$UAVOBJECT_SYNTHETICS/revosettings.cpp \
     $$UAVOBJECT_SYNTHETICS/gcstelemetrystats.cpp \
+    $$UAVOBJECT_SYNTHETICS/telemetryping.cpp \
+    $$UAVOBJECT_SYNTHETICS/metadataoverride.cpp \
+    $$UAVOBJECT_SYNTHETICS/telemetryobjectstats.cpp \
     $$UAVOBJECT_SYNTHETICS/accelsensor.cpp \
     $$UAVOBJECT_SYNTHETICS/accelstate.cpp \
     $$UAVOBJECT_SYNTHETICS/gyrostate.cpp \
@@ -165,6 +195,7 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/systemstats.cpp \
     $$UAVOBJECT_SYNTHETICS/systemalarms.cpp \
     $$UAVOBJECT_SYNTHETICS/objectpersistence.cpp \
+    $$UAVOBJECT_SYNTHETICS/settingscrc.cpp \
     $$UAVOBJECT_SYNTHETICS/overosyncstats.cpp \
     $$UAVOBJECT_SYNTHETICS/overosyncsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/systemsettings.cpp \
@@ -218,6 +249,7 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/flightstatus.cpp \
     $$UAVOBJECT_SYNTHETICS/hwsettings.cpp \
     $$UAVOBJECT_SYNTHETICS/gcsreceiver.cpp \
+    $$UAVOBJECT_SYNTHETICS/gcsreceiverstatus.cpp \
     $$UAVOBJECT_SYNTHETICS/receiveractivity.cpp \
     $$UAVOBJECT_SYNTHETICS/attitudesettings.cpp \
     $$UAVOBJECT_SYNTHETICS/txpidsettings.cpp \
@@ -236,6 +268,20 @@ SOURCES += \
     $$UAVOBJECT_SYNTHETICS/takeofflocation.cpp \
     $$UAVOBJECT_SYNTHETICS/auxmagsensor.cpp \
     $$UAVOBJECT_SYNTHETICS/auxmagsettings.cpp \
+    $$UAVOBJECT_SYNTHETICS/auxmagcalibration.cpp \
     $$UAVOBJECT_SYNTHETICS/gpsextendedstatus.cpp \
-    $$UAVOBJECT_SYNTHETICS/perfcounter.cpp
+    $$UAVOBJECT_SYNTHETICS/perfcounter.cpp \
+    $$UAVOBJECT_SYNTHETICS/tracecontrol.cpp \
+    $$UAVOBJECT_SYNTHETICS/tracestatus.cpp \
+    $$UAVOBJECT_SYNTHETICS/tracedata.cpp \
+    $$UAVOBJECT_SYNTHETICS/latencyprobe.cpp \
+    $$UAVOBJECT_SYNTHETICS/memorystats.cpp \
+    $$UAVOBJECT_SYNTHETICS/memorypoolstats.cpp \
+    $$UAVOBJECT_SYNTHETICS/bootprofile.cpp \
+    $$UAVOBJECT_SYNTHETICS/vibrationanalysissettings.cpp \
+    $$UAVOBJECT_SYNTHETICS/vibrationanalysisoutput.cpp \
+    $$UAVOBJECT_SYNTHETICS/systemidentsettings.cpp \
+    $$UAVOBJECT_SYNTHETICS/systemident.cpp \
+    $$UAVOBJECT_SYNTHETICS/benchmarkresults.cpp \
+    $$UAVOBJECT_SYNTHETICS/callbackbenchmark.cpp
 
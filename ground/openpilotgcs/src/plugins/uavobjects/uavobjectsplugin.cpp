@@ -27,6 +27,8 @@
  */
 #include "uavobjectsplugin.h"
 #include "uavobjectsinit.h"
+#include "uavobjecthistory.h"
+#include "uavobjectstreams.h"
 
 UAVObjectsPlugin::UAVObjectsPlugin()
 {}
@@ -45,6 +47,10 @@ bool UAVObjectsPlugin::initialize(const QStringList & arguments, QString *errorS
     addAutoReleasedObject(objMngr);
     // Initialize UAVObjects
     UAVObjectsInitialize(objMngr);
+    // Shared recent values of the objects, for the gadgets which plot or query them
+    addAutoReleasedObject(new UAVObjectHistory(objMngr));
+    // Resampled streams of the object fields, shared by the consumers of the same request
+    addAutoReleasedObject(new UAVObjectStreams(objMngr));
     // Done
     Q_UNUSED(arguments);
     Q_UNUSED(errorString);
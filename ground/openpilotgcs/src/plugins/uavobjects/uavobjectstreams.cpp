@@ -0,0 +1,193 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectstreams.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjectstreams.h"
+#include "uavobjectmanager.h"
+#include <QDateTime>
+#include <QTimer>
+#include <cmath>
+
+UAVObjectStream::UAVObjectStream(UAVObject *object, UAVObjectField *field, double rate, Interpolation interpolation) :
+    m_object(object), m_field(field), m_rate(rate), m_interpolation(interpolation),
+    m_elements(field->getNumElements()), m_subscribers(1), m_nextSample(-1)
+{}
+
+void UAVObjectStream::append(qint64 time)
+{
+    // the grid only goes forward, an update from the past is taken as a new one
+    if (!m_times.isEmpty() && time < m_times.last()) {
+        time = m_times.last();
+    }
+    m_times.append(time);
+    for (int i = 0; i < m_elements; ++i) {
+        m_values.append(m_field->getDouble(i));
+    }
+}
+
+void UAVObjectStream::resample()
+{
+    if (m_times.isEmpty()) {
+        return;
+    }
+
+    const double interval = 1000.0 / m_rate;
+    const qint64 last     = m_times.last();
+    if (m_nextSample < 0) {
+        m_nextSample = (qint64)std::ceil(m_times.first() / interval);
+    }
+
+    Block block;
+    block.firstTime = m_nextSample * interval;
+    block.interval  = interval;
+    block.elements  = m_elements;
+    block.values.reserve((int)((last - block.firstTime) / interval + 1) * m_elements);
+
+    // samples up to the last update only, the ones after it need the next one
+    int i = 0;
+    for (double time = m_nextSample * interval; time <= last; time = m_nextSample * interval) {
+        while (i + 1 < m_times.size() && m_times[i + 1] <= time) {
+            ++i;
+        }
+        if (i + 1 < m_times.size() && m_times[i + 1] - m_times[i] > MAX_GAP_MS && time > m_times[i]) {
+            if (!block.values.isEmpty()) {
+                emit blockReady(block);
+            }
+            m_nextSample    = (qint64)std::ceil(m_times[i + 1] / interval);
+            block.firstTime = m_nextSample * interval;
+            block.values.clear();
+            continue;
+        }
+
+        const double *from = m_values.constData() + i * m_elements;
+        if (m_interpolation == Linear && i + 1 < m_times.size()) {
+            const double *to      = from + m_elements;
+            const double fraction = (time - m_times[i]) / (m_times[i + 1] - m_times[i]);
+            for (int e = 0; e < m_elements; ++e) {
+                block.values.append(from[e] + (to[e] - from[e]) * fraction);
+            }
+        } else {
+            for (int e = 0; e < m_elements; ++e) {
+                block.values.append(from[e]);
+            }
+        }
+        ++m_nextSample;
+    }
+    if (!block.values.isEmpty()) {
+        emit blockReady(block);
+    }
+
+    // the next sample is after the last update, it is the only one still needed
+    m_times.remove(0, m_times.size() - 1);
+    m_values.remove(0, m_values.size() - m_elements);
+}
+
+UAVObjectStreams::UAVObjectStreams(UAVObjectManager *objManager, QObject *parent) :
+    QObject(parent), m_objManager(objManager)
+{
+    qRegisterMetaType<UAVObjectStream::Block>("UAVObjectStream::Block");
+
+    // the timer lives in the worker thread, the resampling runs there
+    m_timer = new QTimer();
+    m_timer->setInterval(PROCESS_INTERVAL_MS);
+    m_timer->moveToThread(&m_thread);
+    connect(&m_thread, SIGNAL(started()), m_timer, SLOT(start()));
+    connect(&m_thread, SIGNAL(finished()), m_timer, SLOT(deleteLater()));
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(process()), Qt::DirectConnection);
+    m_thread.start();
+}
+
+UAVObjectStreams::~UAVObjectStreams()
+{
+    m_thread.quit();
+    m_thread.wait();
+    qDeleteAll(m_streams);
+}
+
+UAVObjectStream *UAVObjectStreams::subscribe(UAVObject *obj, UAVObjectField *field, double rateHz,
+                                             UAVObjectStream::Interpolation interpolation)
+{
+    if (!obj || !field || field->getType() == UAVObjectField::STRING || rateHz <= 0) {
+        return NULL;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    QMultiHash<UAVObject *, UAVObjectStream *>::const_iterator it = m_streams.constFind(obj);
+    for (; it != m_streams.constEnd() && it.key() == obj; ++it) {
+        UAVObjectStream *stream = it.value();
+        if (stream->m_field == field && qFuzzyCompare(stream->m_rate, rateHz) && stream->m_interpolation == interpolation) {
+            stream->m_subscribers++;
+            return stream;
+        }
+    }
+
+    if (!m_streams.contains(obj)) {
+        // Every update is queued, in the thread which made it
+        connect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)), Qt::DirectConnection);
+    }
+    UAVObjectStream *stream = new UAVObjectStream(obj, field, rateHz, interpolation);
+    m_streams.insert(obj, stream);
+    return stream;
+}
+
+void UAVObjectStreams::unsubscribe(UAVObjectStream *stream)
+{
+    if (!stream) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (--stream->m_subscribers > 0) {
+        return;
+    }
+    UAVObject *obj = stream->m_object;
+    m_streams.remove(obj, stream);
+    if (!m_streams.contains(obj)) {
+        disconnect(obj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectUpdated(UAVObject *)));
+    }
+    // blocks already queued to the consumers are still delivered
+    delete stream;
+}
+
+void UAVObjectStreams::objectUpdated(UAVObject *obj)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QMutexLocker locker(&m_mutex);
+    QMultiHash<UAVObject *, UAVObjectStream *>::const_iterator it = m_streams.constFind(obj);
+
+    for (; it != m_streams.constEnd() && it.key() == obj; ++it) {
+        it.value()->append(now);
+    }
+}
+
+void UAVObjectStreams::process()
+{
+    QMutexLocker locker(&m_mutex);
+
+    foreach(UAVObjectStream * stream, m_streams) {
+        stream->resample();
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectstreams.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTSTREAMS_H
+#define UAVOBJECTSTREAMS_H
+
+#include "uavobjects_global.h"
+#include "uavobject.h"
+#include "uavobjectfield.h"
+#include <QObject>
+#include <QMultiHash>
+#include <QVector>
+#include <QMutex>
+#include <QThread>
+#include <QMetaType>
+
+class UAVObjectManager;
+class QTimer;
+
+/**
+ * One field of an object resampled at a fixed rate, shared by all the consumers
+ * of the same request. The consumers connect to blockReady, the blocks are emitted
+ * from the worker thread of UAVObjectStreams and queued to them.
+ */
+class UAVOBJECTS_EXPORT UAVObjectStream : public QObject {
+    Q_OBJECT
+
+public:
+    enum Interpolation {
+        Hold, // the value of the last update at or before the sample time
+        Linear // between the updates around the sample time
+    };
+
+    /**
+     * Samples of all the elements of the field at times firstTime + i * interval,
+     * sample i of element e at values[i * elements + e]. The values are shared by
+     * all the consumers of the stream.
+     */
+    struct Block {
+        double firstTime; // ms since the epoch
+        double interval; // ms
+        int    elements;
+        QVector<double> values;
+
+        Block() : firstTime(0), interval(0), elements(0) {}
+        int count() const
+        {
+            return elements ? values.size() / elements : 0;
+        }
+        double time(int i) const
+        {
+            return firstTime + i * interval;
+        }
+        double value(int i, int element = 0) const
+        {
+            return values.at(i * elements + element);
+        }
+    };
+
+    UAVObject *object() const
+    {
+        return m_object;
+    }
+    UAVObjectField *field() const
+    {
+        return m_field;
+    }
+    double rate() const
+    {
+        return m_rate;
+    }
+    Interpolation interpolation() const
+    {
+        return m_interpolation;
+    }
+
+signals:
+    void blockReady(const UAVObjectStream::Block &block);
+
+private:
+    friend class UAVObjectStreams;
+
+    UAVObjectStream(UAVObject *object, UAVObjectField *field, double rate, Interpolation interpolation);
+    void append(qint64 time);
+    void resample();
+
+    UAVObject *m_object;
+    UAVObjectField *m_field;
+    double m_rate;
+    Interpolation m_interpolation;
+    int m_elements;
+    int m_subscribers;
+
+    // the updates from the last one at or before the next sample of the grid on
+    QVector<qint64> m_times;
+    QVector<double> m_values;
+    qint64 m_nextSample; // of the grid, its time is m_nextSample * interval, -1 before the first update
+
+    // longer gaps between the updates start a new block rather than being filled
+    static const qint64 MAX_GAP_MS = 1000;
+};
+
+Q_DECLARE_METATYPE(UAVObjectStream::Block)
+
+/**
+ * The resampled streams of the object fields, for the gadgets which plot, log or
+ * filter them at a fixed rate.
+ *
+ * The updates are queued to the streams of their object as they come, a worker
+ * thread resamples them in batches onto the grid of every stream, multiples of its
+ * interval, so the per-consumer work is only reading the blocks it is handed.
+ */
+class UAVOBJECTS_EXPORT UAVObjectStreams : public QObject {
+    Q_OBJECT
+
+public:
+    explicit UAVObjectStreams(UAVObjectManager *objManager, QObject *parent = 0);
+    ~UAVObjectStreams();
+
+    /**
+     * @brief The stream of the field of obj sampled at rateHz, the existing one if
+     *        there is one for the same request. Every subscribe needs an unsubscribe.
+     * @return NULL for string fields and rates which are not positive
+     */
+    UAVObjectStream *subscribe(UAVObject *obj, UAVObjectField *field, double rateHz,
+                               UAVObjectStream::Interpolation interpolation = UAVObjectStream::Hold);
+    void unsubscribe(UAVObjectStream *stream);
+
+private slots:
+    void objectUpdated(UAVObject *obj);
+    void process();
+
+private:
+    UAVObjectManager *m_objManager;
+    QMultiHash<UAVObject *, UAVObjectStream *> m_streams;
+    // held by the updates, the worker and the subscriptions, none of them for long
+    QMutex m_mutex;
+    QThread m_thread;
+    QTimer *m_timer;
+
+    static const int PROCESS_INTERVAL_MS = 50;
+};
+
+#endif // UAVOBJECTSTREAMS_H
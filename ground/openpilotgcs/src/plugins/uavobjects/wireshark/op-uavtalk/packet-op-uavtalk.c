@@ -49,7 +49,9 @@ static int hf_op_uavtalk_version = -1;
 static int hf_op_uavtalk_type    = -1;
 static int hf_op_uavtalk_len     = -1;
 static int hf_op_uavtalk_objid   = -1;
+static int hf_op_uavtalk_instid  = -1;
 static int hf_op_uavtalk_crc8    = -1;
+static int hf_op_uavtalk_entry_len = -1;
 
 #define UAVTALK_SYNC_VAL 0x3C
 
@@ -59,45 +61,61 @@ static const value_string uavtalk_packet_types[] = {
     { 2, "SetObjAckd" },
     { 3, "Ack"        },
     { 4, "Nack"       },
+    { 5, "MultiObj"   },
+    { 6, "DeltaObj"   },
     { 0, NULL         }
 };
 
 void proto_reg_handoff_op_uavtalk(void);
 
-#define UAVTALK_HEADER_SIZE  8
+#define UAVTALK_HEADER_SIZE  10
 #define UAVTALK_TRAILER_SIZE 1
-static int dissect_op_uavtalk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
+
+#define UAVTALK_TYPE_OBJ       0
+#define UAVTALK_TYPE_OBJ_ACK   2
+#define UAVTALK_TYPE_OBJ_MULTI 5
+
+/* multi-object frame entry : object ID(4), instance ID(2), data length(1) */
+#define UAVTALK_MULTI_ENTRY_HEADER_SIZE 7
+
+/* Hand object data to the dissector bound to its objid */
+static void dissect_op_uavtalk_object(tvbuff_t *tvb, gint offset, gint length, guint32 objid, packet_info *pinfo, proto_tree *tree)
 {
-    gint offset   = 0;
+    tvbuff_t *next_tvb = tvb_new_subset(tvb, offset, length, length);
 
-    guint8 packet_type = tvb_get_guint8(tvb, 1) & 0x7;
-    guint32 objid = tvb_get_letohl(tvb, 4);
-    guint32 payload_length  = tvb_get_letohs(tvb, 2) - UAVTALK_HEADER_SIZE - UAVTALK_TRAILER_SIZE;
-    guint32 reported_length = tvb_reported_length(tvb);
+    /* Call any registered subdissector for this objid */
+    if (!dissector_try_uint(uavtalk_subdissector_table, objid, next_tvb, pinfo, tree)) {
+        /* No subdissector registered, use the default data dissector */
+        call_dissector(data_handle, next_tvb, pinfo, tree);
+    }
+}
 
-    col_set_str(pinfo->cinfo, COL_PROTOCOL, "UAVTALK");
-    /* Clear out stuff in the info column */
-    col_clear(pinfo->cinfo, COL_INFO);
+/* Dissect the frame at offset, its length has been checked by the caller */
+static void dissect_op_uavtalk_frame(tvbuff_t *tvb, gint offset, packet_info *pinfo, proto_tree *tree)
+{
+    guint8 packet_type = tvb_get_guint8(tvb, offset + 1) & 0x7;
+    guint32 objid = tvb_get_letohl(tvb, offset + 4);
+    gint payload_offset = offset + UAVTALK_HEADER_SIZE;
+    gint payload_length = tvb_get_letohs(tvb, offset + 2) - UAVTALK_HEADER_SIZE;
+    proto_tree *op_uavtalk_tree = NULL;
 
-    col_append_fstr(pinfo->cinfo, COL_INFO, "%s: 0x%08x", val_to_str_const(packet_type, uavtalk_packet_types, ""), objid);
+    col_append_sep_fstr(pinfo->cinfo, COL_INFO, ", ", "%s: 0x%08x", val_to_str_const(packet_type, uavtalk_packet_types, ""), objid);
     if (objid & 0x1) {
         col_append_str(pinfo->cinfo, COL_INFO, "(META)");
     }
 
-
     if (tree) { /* we are being asked for details */
-        proto_tree *op_uavtalk_tree = NULL;
         ptvcursor_t *cursor;
         proto_item *ti = NULL;
 
         /* Add a top-level entry to the dissector tree for this protocol */
-        ti = proto_tree_add_item(tree, proto_op_uavtalk, tvb, 0, -1, ENC_NA);
+        ti = proto_tree_add_item(tree, proto_op_uavtalk, tvb, offset, UAVTALK_HEADER_SIZE + payload_length + UAVTALK_TRAILER_SIZE, ENC_NA);
 
         /* Create a subtree to contain the dissection of this protocol */
         op_uavtalk_tree = proto_item_add_subtree(ti, ett_op_uavtalk);
 
         /* Dissect the packet and populate the subtree */
-        cursor = ptvcursor_new(op_uavtalk_tree, tvb, 0);
+        cursor = ptvcursor_new(op_uavtalk_tree, tvb, offset);
 
         /* Populate the fields in this protocol */
         ptvcursor_add(cursor, hf_op_uavtalk_sync, 1, ENC_LITTLE_ENDIAN);
@@ -105,35 +123,73 @@ static int dissect_op_uavtalk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tre
         ptvcursor_add(cursor, hf_op_uavtalk_type, 1, ENC_LITTLE_ENDIAN);
         ptvcursor_add(cursor, hf_op_uavtalk_len, 2, ENC_LITTLE_ENDIAN);
         ptvcursor_add(cursor, hf_op_uavtalk_objid, 4, ENC_LITTLE_ENDIAN);
-
-        offset = ptvcursor_current_offset(cursor);
+        ptvcursor_add(cursor, hf_op_uavtalk_instid, 2, ENC_LITTLE_ENDIAN);
 
         ptvcursor_free(cursor);
 
-        proto_tree_add_item(op_uavtalk_tree, hf_op_uavtalk_crc8, tvb, reported_length - UAVTALK_TRAILER_SIZE, UAVTALK_TRAILER_SIZE, ENC_LITTLE_ENDIAN);
-    } else {
-        offset = UAVTALK_HEADER_SIZE;
+        proto_tree_add_item(op_uavtalk_tree, hf_op_uavtalk_crc8, tvb, payload_offset + payload_length, UAVTALK_TRAILER_SIZE, ENC_LITTLE_ENDIAN);
     }
 
-    {
-        tvbuff_t *next_tvb = tvb_new_subset(tvb, offset,
-                                            reported_length - UAVTALK_HEADER_SIZE - UAVTALK_TRAILER_SIZE,
-                                            payload_length);
-
+    if ((packet_type == UAVTALK_TYPE_OBJ) || (packet_type == UAVTALK_TYPE_OBJ_ACK)) {
         /* Check if we have an embedded objid to decode */
-        if ((packet_type == 0) || (packet_type == 2)) {
-            /* Call any registered subdissector for this objid */
-            if (!dissector_try_uint(uavtalk_subdissector_table, objid, next_tvb, pinfo, tree)) {
-                /* No subdissector registered, use the default data dissector */
-                call_dissector(data_handle, next_tvb, pinfo, tree);
+        dissect_op_uavtalk_object(tvb, payload_offset, payload_length, objid, pinfo, tree);
+    } else if (packet_type == UAVTALK_TYPE_OBJ_MULTI) {
+        /* Each entry is an object of its own */
+        gint pos = payload_offset;
+        gint end = payload_offset + payload_length;
+        while (pos + UAVTALK_MULTI_ENTRY_HEADER_SIZE <= end) {
+            guint32 entry_objid = tvb_get_letohl(tvb, pos);
+            gint entry_length   = tvb_get_guint8(tvb, pos + 6);
+            if (pos + UAVTALK_MULTI_ENTRY_HEADER_SIZE + entry_length > end) {
+                break;
             }
-        } else {
-            /* Render any remaining data as raw bytes */
-            call_dissector(data_handle, next_tvb, pinfo, tree);
+            if (op_uavtalk_tree) {
+                proto_tree_add_item(op_uavtalk_tree, hf_op_uavtalk_objid, tvb, pos, 4, ENC_LITTLE_ENDIAN);
+                proto_tree_add_item(op_uavtalk_tree, hf_op_uavtalk_instid, tvb, pos + 4, 2, ENC_LITTLE_ENDIAN);
+                proto_tree_add_item(op_uavtalk_tree, hf_op_uavtalk_entry_len, tvb, pos + 6, 1, ENC_LITTLE_ENDIAN);
+            }
+            dissect_op_uavtalk_object(tvb, pos + UAVTALK_MULTI_ENTRY_HEADER_SIZE, entry_length, entry_objid, pinfo, tree);
+            pos += UAVTALK_MULTI_ENTRY_HEADER_SIZE + entry_length;
         }
+    } else if (payload_length > 0) {
+        /* Render any remaining data as raw bytes */
+        call_dissector(data_handle, tvb_new_subset(tvb, payload_offset, payload_length, payload_length), pinfo, tree);
     }
+}
 
-    return UAVTALK_HEADER_SIZE + UAVTALK_TRAILER_SIZE;
+/* A datagram carries as many frames as the sender had queued */
+static int dissect_op_uavtalk(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)
+{
+    gint offset = 0;
+    gint reported_length = tvb_reported_length(tvb);
+
+    col_set_str(pinfo->cinfo, COL_PROTOCOL, "UAVTALK");
+    /* Clear out stuff in the info column */
+    col_clear(pinfo->cinfo, COL_INFO);
+
+    while (reported_length - offset >= UAVTALK_HEADER_SIZE + UAVTALK_TRAILER_SIZE) {
+        gint frame_length;
+        if (tvb_get_guint8(tvb, offset) != UAVTALK_SYNC_VAL) {
+            break;
+        }
+        frame_length = tvb_get_letohs(tvb, offset + 2) + UAVTALK_TRAILER_SIZE;
+        if (frame_length < UAVTALK_HEADER_SIZE + UAVTALK_TRAILER_SIZE || frame_length > reported_length - offset) {
+            break;
+        }
+        dissect_op_uavtalk_frame(tvb, offset, pinfo, tree);
+        offset += frame_length;
+    }
+
+    if (offset == 0) {
+        /* Not UAVTalk, let another dissector try */
+        return 0;
+    }
+    if (offset < reported_length) {
+        /* A frame split across datagrams, render the rest as raw bytes */
+        call_dissector(data_handle, tvb_new_subset_remaining(tvb, offset), pinfo, tree);
+    }
+
+    return reported_length;
 }
 
 void proto_register_op_uavtalk(void)
@@ -161,6 +217,14 @@ void proto_register_op_uavtalk(void)
             { "ObjID",               "uavtalk.objid",  FT_UINT32,
             BASE_HEX, NULL, 0x0, NULL, HFILL }
         },
+        { &hf_op_uavtalk_instid,
+            { "InstID",              "uavtalk.instid", FT_UINT16,
+            BASE_DEC, NULL, 0x0, NULL, HFILL }
+        },
+        { &hf_op_uavtalk_entry_len,
+            { "Entry Length",        "uavtalk.entrylen", FT_UINT8,
+            BASE_DEC, NULL, 0x0, NULL, HFILL }
+        },
         { &hf_op_uavtalk_crc8,
             { "Crc8",                "uavtalk.crc8",   FT_UINT8,
             BASE_HEX, NULL, 0x0, NULL, HFILL }
@@ -26,7 +26,14 @@
  */
 
 #include "uavobjecthelper.h"
-#include <QTimer>
+#include "uavobjectmanager.h"
+#include "metadataoverride.h"
+
+#include <extensionsystem/pluginmanager.h>
+
+// The board drops the set this long after the last refresh
+#define METADATA_OVERRIDE_TIMEOUT_S    10
+#define METADATA_OVERRIDE_REFRESH_MS   4000
 
 AbstractUAVObjectHelper::AbstractUAVObjectHelper(QObject *parent) :
     QObject(parent), m_transactionResult(false), m_transactionCompleted(false)
@@ -107,3 +114,268 @@ void UAVObjectRequestHelper::doObjectAndWaitImpl()
 {
     m_object->requestUpdate();
 }
+
+UAVObjectTransactionGroup::UAVObjectTransactionGroup(QObject *parent) :
+    QObject(parent), m_operation(REQUEST), m_window(1), m_completed(0), m_running(false), m_timedOut(false),
+    m_result(AbstractUAVObjectHelper::SUCCESS)
+{
+    m_timeoutTimer.setSingleShot(true);
+    connect(&m_timeoutTimer, SIGNAL(timeout()), this, SLOT(transactionTimeout()));
+}
+
+UAVObjectTransactionGroup::~UAVObjectTransactionGroup()
+{}
+
+void UAVObjectTransactionGroup::start(const QList<UAVObject *> &objects, Operation operation, int window, int timeout)
+{
+    if (m_running) {
+        cancel();
+    }
+
+    m_operation = operation;
+    m_objects   = objects;
+    m_pending   = objects;
+    m_failedList.clear();
+    m_failed.clear();
+    m_inFlight.clear();
+    m_window    = qMax(1, window);
+    m_completed = 0;
+    m_running   = true;
+    m_timedOut  = false;
+
+    foreach(UAVObject * object, m_objects) {
+        connect(object, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)), Qt::UniqueConnection);
+    }
+
+    m_timeoutTimer.start(timeout);
+    startTransactions();
+
+    // Nothing to wait for, still finish from the event loop so the caller can connect first
+    if (m_inFlight.isEmpty()) {
+        QTimer::singleShot(0, this, SLOT(finish()));
+    }
+}
+
+void UAVObjectTransactionGroup::cancel()
+{
+    if (m_running) {
+        finish();
+    }
+}
+
+bool UAVObjectTransactionGroup::isFinished() const
+{
+    return !m_running;
+}
+
+AbstractUAVObjectHelper::Result UAVObjectTransactionGroup::result() const
+{
+    return m_result;
+}
+
+QList<UAVObject *> UAVObjectTransactionGroup::failed() const
+{
+    return m_failedList;
+}
+
+AbstractUAVObjectHelper::Result UAVObjectTransactionGroup::waitForFinished()
+{
+    if (m_running) {
+        QEventLoop eventLoop;
+        connect(this, SIGNAL(finished()), &eventLoop, SLOT(quit()));
+        eventLoop.exec();
+    }
+    return m_result;
+}
+
+void UAVObjectTransactionGroup::startTransactions()
+{
+    while (m_inFlight.size() < m_window && !m_pending.isEmpty()) {
+        UAVObject *object = m_pending.takeFirst();
+        m_inFlight.insert(object);
+        if (m_operation == UPDATE) {
+            object->updated();
+        } else {
+            object->requestUpdate();
+        }
+    }
+}
+
+void UAVObjectTransactionGroup::transactionCompleted(UAVObject *object, bool success)
+{
+    if (!m_running || !m_inFlight.remove(object)) {
+        return;
+    }
+
+    if (success) {
+        emit progress(++m_completed);
+    } else {
+        m_failed.insert(object);
+    }
+
+    // The link is alive, allow the full timeout for the next one
+    m_timeoutTimer.start();
+    startTransactions();
+
+    if (m_inFlight.isEmpty()) {
+        finish();
+    }
+}
+
+void UAVObjectTransactionGroup::transactionTimeout()
+{
+    m_timedOut = true;
+    finish();
+}
+
+void UAVObjectTransactionGroup::finish()
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_timeoutTimer.stop();
+
+    foreach(UAVObject * object, m_objects) {
+        disconnect(object, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+    }
+
+    // Whatever did not complete counts as failed
+    m_failed += m_inFlight;
+    m_failed += m_pending.toSet();
+    m_inFlight.clear();
+    m_pending.clear();
+
+    m_failedList.clear();
+    foreach(UAVObject * object, m_objects) {
+        if (m_failed.contains(object)) {
+            m_failedList << object;
+        }
+    }
+    m_objects.clear();
+
+    if (m_timedOut) {
+        m_result = AbstractUAVObjectHelper::TIMEOUT;
+    } else {
+        m_result = m_failedList.isEmpty() ? AbstractUAVObjectHelper::SUCCESS : AbstractUAVObjectHelper::FAIL;
+    }
+    emit finished();
+}
+
+AbstractUAVObjectBatchHelper::AbstractUAVObjectBatchHelper(QObject *parent) : QObject(parent)
+{
+    connect(&m_group, SIGNAL(progress(int)), this, SIGNAL(progress(int)));
+}
+
+AbstractUAVObjectBatchHelper::~AbstractUAVObjectBatchHelper()
+{}
+
+AbstractUAVObjectHelper::Result AbstractUAVObjectBatchHelper::doObjectsAndWait(const QList<UAVObject *> &objects, QList<UAVObject *> &failed,
+                                                                               int window, int timeout)
+{
+    // Lock, we can't call this twice from different threads
+    QMutexLocker locker(&m_mutex);
+
+    m_group.start(objects, operation(), window, timeout);
+    AbstractUAVObjectHelper::Result result = m_group.waitForFinished();
+    failed = m_group.failed();
+    return result;
+}
+
+UAVObjectBatchUpdaterHelper::UAVObjectBatchUpdaterHelper(QObject *parent) : AbstractUAVObjectBatchHelper(parent)
+{}
+
+UAVObjectBatchUpdaterHelper::~UAVObjectBatchUpdaterHelper()
+{}
+
+UAVObjectTransactionGroup::Operation UAVObjectBatchUpdaterHelper::operation() const
+{
+    return UAVObjectTransactionGroup::UPDATE;
+}
+
+UAVObjectBatchRequestHelper::UAVObjectBatchRequestHelper(QObject *parent) : AbstractUAVObjectBatchHelper(parent)
+{}
+
+UAVObjectBatchRequestHelper::~UAVObjectBatchRequestHelper()
+{}
+
+UAVObjectTransactionGroup::Operation UAVObjectBatchRequestHelper::operation() const
+{
+    return UAVObjectTransactionGroup::REQUEST;
+}
+
+UAVObjectMetadataOverride::UAVObjectMetadataOverride(QObject *parent) : QObject(parent), m_active(false)
+{
+    connect(&m_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+UAVObjectMetadataOverride::~UAVObjectMetadataOverride()
+{
+    release();
+}
+
+bool UAVObjectMetadataOverride::setPeriod(UAVObject *object, quint16 periodMs)
+{
+    Q_ASSERT(object);
+    for (int i = 0; i < m_periods.size(); i++) {
+        if (m_periods[i].first == object->getObjID()) {
+            m_periods[i].second = periodMs;
+            return true;
+        }
+    }
+    if (m_periods.size() >= (int)MetadataOverride::OBJECTID_NUMELEM) {
+        return false;
+    }
+    m_periods << qMakePair(object->getObjID(), periodMs);
+    return true;
+}
+
+void UAVObjectMetadataOverride::clear()
+{
+    m_periods.clear();
+}
+
+void UAVObjectMetadataOverride::apply()
+{
+    m_active = true;
+    send(true);
+    m_refreshTimer.start(METADATA_OVERRIDE_REFRESH_MS);
+}
+
+void UAVObjectMetadataOverride::release()
+{
+    if (!m_active) {
+        return;
+    }
+    m_active = false;
+    m_refreshTimer.stop();
+    send(false);
+}
+
+bool UAVObjectMetadataOverride::isActive() const
+{
+    return m_active;
+}
+
+void UAVObjectMetadataOverride::refresh()
+{
+    send(true);
+}
+
+void UAVObjectMetadataOverride::send(bool active)
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    MetadataOverride *metadataOverride = MetadataOverride::GetInstance(objManager);
+
+    Q_ASSERT(metadataOverride);
+    MetadataOverride::DataFields data = metadataOverride->getData();
+    for (int i = 0; i < (int)MetadataOverride::OBJECTID_NUMELEM; i++) {
+        bool used = active && i < m_periods.size();
+        data.ObjectID[i] = used ? m_periods[i].first : 0;
+        data.TelemetryUpdatePeriod[i] = used ? m_periods[i].second : 0;
+    }
+    data.Timeout = active ? METADATA_OVERRIDE_TIMEOUT_S : 0;
+    metadataOverride->setData(data);
+    metadataOverride->updated();
+}
@@ -32,6 +32,10 @@
 #include <QEventLoop>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QTimer>
+#include <QList>
+#include <QPair>
+#include <QSet>
 
 #include "uavobjectutil_global.h"
 #include "uavobject.h"
@@ -82,4 +86,134 @@ protected:
     virtual void doObjectAndWaitImpl();
 };
 
+// Transactions on a list of objects without blocking, up to window of them in flight
+// at once. start() returns at once and finished() is emitted from the event loop when
+// every transaction completed, failed or timed out. Several groups can be in flight
+// at the same time, so independent round trips overlap.
+class UAVOBJECTUTIL_EXPORT UAVObjectTransactionGroup : public QObject {
+    Q_OBJECT
+public:
+    enum Operation { UPDATE, REQUEST };
+
+    explicit UAVObjectTransactionGroup(QObject *parent = 0);
+    virtual ~UAVObjectTransactionGroup();
+
+    // timeout is the time allowed without any transaction completing
+    void start(const QList<UAVObject *> &objects, Operation operation, int window = 8, int timeout = 800);
+    // whatever did not complete yet counts as failed
+    void cancel();
+
+    bool isFinished() const;
+    AbstractUAVObjectHelper::Result result() const;
+    // the objects whose transaction did not succeed, in list order
+    QList<UAVObject *> failed() const;
+
+    // for callers which cannot be made asynchronous, waits in a local event loop
+    AbstractUAVObjectHelper::Result waitForFinished();
+
+signals:
+    // number of successful transactions so far
+    void progress(int completed);
+    void finished();
+
+private slots:
+    void transactionCompleted(UAVObject *object, bool success);
+    void transactionTimeout();
+    void finish();
+
+private:
+    void startTransactions();
+
+    Operation m_operation;
+    QTimer m_timeoutTimer;
+    QList<UAVObject *> m_objects;
+    QList<UAVObject *> m_pending;
+    QList<UAVObject *> m_failedList;
+    QSet<UAVObject *> m_failed;
+    QSet<UAVObject *> m_inFlight;
+    int m_window;
+    int m_completed;
+    bool m_running;
+    bool m_timedOut;
+    AbstractUAVObjectHelper::Result m_result;
+};
+
+// Same as the helpers above for a list of objects, but with up to window
+// transactions in flight at once instead of one round trip per object.
+class UAVOBJECTUTIL_EXPORT AbstractUAVObjectBatchHelper : public QObject {
+    Q_OBJECT
+public:
+    explicit AbstractUAVObjectBatchHelper(QObject *parent = 0);
+    virtual ~AbstractUAVObjectBatchHelper();
+
+    // the objects whose transaction did not succeed are returned in failed, in list order
+    // timeout is the time allowed without any transaction completing
+    AbstractUAVObjectHelper::Result doObjectsAndWait(const QList<UAVObject *> &objects, QList<UAVObject *> &failed,
+                                                     int window = 8, int timeout = 800);
+
+signals:
+    // number of successful transactions so far
+    void progress(int completed);
+
+protected:
+    virtual UAVObjectTransactionGroup::Operation operation() const = 0;
+
+private:
+    QMutex m_mutex;
+    UAVObjectTransactionGroup m_group;
+};
+
+class UAVOBJECTUTIL_EXPORT UAVObjectBatchUpdaterHelper : public AbstractUAVObjectBatchHelper {
+    Q_OBJECT
+public:
+    explicit UAVObjectBatchUpdaterHelper(QObject *parent = 0);
+    virtual ~UAVObjectBatchUpdaterHelper();
+
+protected:
+    virtual UAVObjectTransactionGroup::Operation operation() const;
+};
+
+class UAVOBJECTUTIL_EXPORT UAVObjectBatchRequestHelper : public AbstractUAVObjectBatchHelper {
+    Q_OBJECT
+public:
+    explicit UAVObjectBatchRequestHelper(QObject *parent = 0);
+    virtual ~UAVObjectBatchRequestHelper();
+
+protected:
+    virtual UAVObjectTransactionGroup::Operation operation() const;
+};
+
+// Telemetry periods of a few objects for a calibration or wizard session. The board
+// applies the whole set over the metadata of the objects in one transaction and drops
+// it in one, the metadata are left untouched. The set is refreshed while the session
+// is active and the board drops it by itself once it is not, so a GCS gone away does
+// not leave the fast rates set. There is one set on the board, one session at a time.
+class UAVOBJECTUTIL_EXPORT UAVObjectMetadataOverride : public QObject {
+    Q_OBJECT
+public:
+    explicit UAVObjectMetadataOverride(QObject *parent = 0);
+    // releases the set if still active
+    virtual ~UAVObjectMetadataOverride();
+
+    // the object is sent every periodMs once applied, false if the set is full
+    bool setPeriod(UAVObject *object, quint16 periodMs);
+    void clear();
+
+    // send the set, again if it changed while active
+    void apply();
+    // drop the set on the board
+    void release();
+    bool isActive() const;
+
+private slots:
+    void refresh();
+
+private:
+    void send(bool active);
+
+    QList<QPair<quint32, quint16> > m_periods;
+    QTimer m_refreshTimer;
+    bool m_active;
+};
+
 #endif // UAVOBJECTHELPER_H
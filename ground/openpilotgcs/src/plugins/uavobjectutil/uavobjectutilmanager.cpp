@@ -98,9 +98,23 @@ void UAVObjectUtilManager::saveObjectToSD(UAVObject *obj)
     qDebug() << "Enqueue object: " << obj->getName();
 
 
-    // If queue length is one, then start sending (call sendNextObject)
-    // Otherwise, do nothing, it's sending anyway
-    if (queue.length() == 1) {
+    // If no request is pending, then start sending (call sendNextObject)
+    // Otherwise, do nothing, the object will go with the next request
+    if (saveState == IDLE) {
+        saveNextObject();
+    }
+}
+
+/*
+   Add a list of objects to save, they are sent to the board in as few
+   ObjectPersistence requests as possible
+ */
+void UAVObjectUtilManager::saveObjectsToSD(const QList<UAVObject *> &objects)
+{
+    foreach(UAVObject * obj, objects) {
+        queue.enqueue(obj);
+    }
+    if (saveState == IDLE) {
         saveNextObject();
     }
 }
@@ -113,23 +127,33 @@ void UAVObjectUtilManager::saveNextObject()
 
     Q_ASSERT(saveState == IDLE);
 
-    // Get next object from the queue
-    UAVObject *obj = queue.head();
-    qDebug() << "Send save object request to board " << obj->getName();
+    // Take the next objects from the queue: all the queued objects of one instance
+    // fit in a single ObjectList request, up to its size
+    saving.clear();
+    quint32 instId = queue.head()->getInstID();
+    while (!queue.isEmpty() && saving.length() < (int)ObjectPersistence::OBJECTIDS_NUMELEM &&
+           queue.head()->getInstID() == instId && !saving.contains(queue.head())) {
+        saving.append(queue.dequeue());
+    }
+    qDebug() << "Send save request to board for" << saving.length() << "objects";
 
     ObjectPersistence *objper = dynamic_cast<ObjectPersistence *>(getObjectManager()->getObject(ObjectPersistence::NAME));
     connect(objper, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(objectPersistenceTransactionCompleted(UAVObject *, bool)));
     connect(objper, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(objectPersistenceUpdated(UAVObject *)));
     saveState = AWAITING_ACK;
-    if (obj != NULL) {
-        ObjectPersistence::DataFields data;
-        data.Operation  = ObjectPersistence::OPERATION_SAVE;
-        data.Selection  = ObjectPersistence::SELECTION_SINGLEOBJECT;
-        data.ObjectID   = obj->getObjID();
-        data.InstanceID = obj->getInstID();
-        objper->setData(data);
-        objper->updated();
+
+    ObjectPersistence::DataFields data = objper->getData();
+    data.Operation  = ObjectPersistence::OPERATION_SAVE;
+    data.ObjectID   = saving.first()->getObjID();
+    data.InstanceID = instId;
+    data.FailedObjects = 0;
+    for (int i = 0; i < (int)ObjectPersistence::OBJECTIDS_NUMELEM; i++) {
+        data.ObjectIDs[i] = (i < saving.length()) ? saving.at(i)->getObjID() : 0;
     }
+    // A lone object still uses the plain request, which every board understands
+    data.Selection = (saving.length() > 1) ? ObjectPersistence::SELECTION_OBJECTLIST : ObjectPersistence::SELECTION_SINGLEOBJECT;
+    objper->setData(data);
+    objper->updated();
     // Now: we are going to get two "objectUpdated" messages (one coming from GCS, one coming from Flight, which
     // will confirm the object was properly received by both sides) and then one "transactionCompleted" indicating
     // that the Flight side did not only receive the object but it did receive it without error. Last we will get
@@ -137,12 +161,33 @@ void UAVObjectUtilManager::saveNextObject()
     // operation we asked for (saved, other).
 }
 
+/**
+ * @brief Report the result of the pending save request for each of its objects
+ * @param[in] failedMask bit n set when the n-th object of the request failed
+ */
+void UAVObjectUtilManager::saveFinished(quint32 failedMask)
+{
+    ObjectPersistence *objectPersistence = ObjectPersistence::GetInstance(getObjectManager());
+
+    Q_ASSERT(objectPersistence);
+    objectPersistence->disconnect(this);
+
+    QList<UAVObject *> saved = saving;
+    saving.clear();
+    saveState = IDLE;
+    for (int i = 0; i < saved.length(); i++) {
+        emit saveCompleted(saved.at(i)->getObjID(), !(failedMask & (1u << i)));
+    }
+
+    saveNextObject();
+}
+
 /**
  * @brief Process the transactionCompleted message from Telemetry indicating request sent successfully
  * @param[in] The object just transsacted.  Must be ObjectPersistance
  * @param[in] success Indicates that the transaction did not time out
  *
- * After a failed transaction (usually timeout) resends the save request.  After a succesful
+ * After a failed transaction (usually timeout) reports the objects as failed.  After a succesful
  * transaction will then wait for a save completed update from the autopilot.
  */
 void UAVObjectUtilManager::objectPersistenceTransactionCompleted(UAVObject *obj, bool success)
@@ -154,20 +199,15 @@ void UAVObjectUtilManager::objectPersistenceTransactionCompleted(UAVObject *obj,
         // Either the Object Save Request did actually go through, and then we should get in
         // "AWAITING_COMPLETED" mode, or the Object Save Request did _not_ go through, for example
         // because the object does not exist and then we will never get a subsequent update.
-        // For this reason, we will arm a 1 second timer to make provision for this and not block
-        // the queue:
+        // For this reason, we will arm a timer to make provision for this and not block
+        // the queue, flash writes take longer for a list of objects:
         saveState = AWAITING_COMPLETED;
         disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(objectPersistenceTransactionCompleted(UAVObject *, bool)));
-        failureTimer.start(2000); // Create a timeout
+        failureTimer.start(2000 + 100 * saving.length()); // Create a timeout
     } else {
         // Can be caused by timeout errors on sending.  Forget it and send next.
         qDebug() << "objectPersistenceTranscationCompleted (error)";
-        UAVObject *obj = getObjectManager()->getObject(ObjectPersistence::NAME);
-        obj->disconnect(this);
-        queue.dequeue(); // We can now remove the object, it failed anyway.
-        saveState = IDLE;
-        emit saveCompleted(obj->getField("ObjectID")->getValue().toInt(), false);
-        saveNextObject();
+        saveFinished(0xFFFFFFFF);
     }
 }
 
@@ -179,28 +219,14 @@ void UAVObjectUtilManager::objectPersistenceOperationFailed()
 {
     if (saveState == AWAITING_COMPLETED) {
         // TODO: some warning that this operation failed somehow
-        // We have to disconnect the object persistence 'updated' signal
-        // and ask to save the next object:
-
-        ObjectPersistence *objectPersistence = ObjectPersistence::GetInstance(getObjectManager());
-        Q_ASSERT(objectPersistence);
-
-        UAVObject *obj = queue.dequeue(); // We can now remove the object, it failed anyway.
-        Q_ASSERT(obj);
-
-        objectPersistence->disconnect(this);
-
-        saveState = IDLE;
-        emit saveCompleted(obj->getObjID(), false);
-
-        saveNextObject();
+        saveFinished(0xFFFFFFFF);
     }
 }
 
 
 /**
- * @brief Process the ObjectPersistence updated message to confirm the right object saved
- * then requests next object be saved.
+ * @brief Process the ObjectPersistence updated message to confirm the right objects saved
+ * then requests next objects be saved.
  * @param[in] The object just received.  Must be ObjectPersistance
  */
 void UAVObjectUtilManager::objectPersistenceUpdated(UAVObject *obj)
@@ -209,26 +235,44 @@ void UAVObjectUtilManager::objectPersistenceUpdated(UAVObject *obj)
     Q_ASSERT(obj->getObjID() == ObjectPersistence::OBJID);
     ObjectPersistence::DataFields objectPersistence = ((ObjectPersistence *)obj)->getData();
 
-    if (saveState == AWAITING_COMPLETED && objectPersistence.Operation == ObjectPersistence::OPERATION_ERROR) {
-        failureTimer.stop();
-        objectPersistenceOperationFailed();
-    } else if (saveState == AWAITING_COMPLETED &&
-               objectPersistence.Operation == ObjectPersistence::OPERATION_COMPLETED) {
-        failureTimer.stop();
-        // Check right object saved
-        UAVObject *savingObj = queue.head();
-        if (objectPersistence.ObjectID != savingObj->getObjID()) {
-            objectPersistenceOperationFailed();
-            return;
+    if (saveState != AWAITING_COMPLETED || saving.isEmpty() ||
+        (objectPersistence.Operation != ObjectPersistence::OPERATION_COMPLETED &&
+         objectPersistence.Operation != ObjectPersistence::OPERATION_ERROR)) {
+        return;
+    }
+    failureTimer.stop();
+    // Check right objects saved
+    if (objectPersistence.ObjectID != saving.first()->getObjID()) {
+        saveFinished(0xFFFFFFFF);
+    } else if (objectPersistence.Selection == ObjectPersistence::SELECTION_OBJECTLIST) {
+        // The board tells which of the objects failed, whatever the overall result
+        if (objectPersistence.ObjectIDs[0] != saving.first()->getObjID()) {
+            saveFinished(0xFFFFFFFF);
+        } else if (objectPersistence.Operation == ObjectPersistence::OPERATION_ERROR) {
+            saveFinished(objectPersistence.FailedObjects ? objectPersistence.FailedObjects : 0xFFFFFFFF);
+        } else {
+            saveFinished(0);
         }
+    } else {
+        saveFinished(objectPersistence.Operation == ObjectPersistence::OPERATION_COMPLETED ? 0 : 0xFFFFFFFF);
+    }
+}
 
-        obj->disconnect(this);
-        queue.dequeue(); // We can now remove the object, it's done.
-        saveState = IDLE;
+UAVObjectTransactionGroup *UAVObjectUtilManager::requestObjects(const QList<UAVObject *> &objects)
+{
+    UAVObjectTransactionGroup *group = new UAVObjectTransactionGroup(this);
 
-        emit saveCompleted(objectPersistence.ObjectID, true);
-        saveNextObject();
-    }
+    connect(group, SIGNAL(finished()), group, SLOT(deleteLater()));
+    group->start(objects, UAVObjectTransactionGroup::REQUEST);
+    return group;
+}
+
+UAVObjectTransactionGroup *UAVObjectUtilManager::requestBoardInfo()
+{
+    QList<UAVObject *> objects;
+
+    objects << FirmwareIAPObj::GetInstance(obm);
+    return requestObjects(objects);
 }
 
 /**
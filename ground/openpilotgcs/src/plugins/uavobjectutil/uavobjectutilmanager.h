@@ -36,6 +36,7 @@
 #include "uavobject.h"
 #include "objectpersistence.h"
 #include "devicedescriptorstruct.h"
+#include "uavobjecthelper.h"
 #include <QtGlobal>
 #include <QObject>
 #include <QTimer>
@@ -67,6 +68,13 @@ public:
     static bool descriptionToStructure(QByteArray desc, deviceDescriptorStruct & struc);
     UAVObjectManager *getObjectManager();
     void saveObjectToSD(UAVObject *obj);
+    void saveObjectsToSD(const QList<UAVObject *> &objects);
+
+    // Non blocking requests, connect to the finished() signal of the group
+    // returned, it deletes itself afterwards
+    UAVObjectTransactionGroup *requestObjects(const QList<UAVObject *> &objects);
+    // Fetch the board description again, the getters above then read it
+    UAVObjectTransactionGroup *requestBoardInfo();
 protected:
     FirmwareIAPObj::DataFields getFirmwareIap();
 
@@ -76,8 +84,10 @@ signals:
 private:
     QMutex *mutex;
     QQueue<UAVObject *> queue;
+    QList<UAVObject *> saving;
     enum { IDLE, AWAITING_ACK, AWAITING_COMPLETED } saveState;
     void saveNextObject();
+    void saveFinished(quint32 failedMask);
     QTimer failureTimer;
 
     ExtensionSystem::PluginManager *pm;
@@ -297,7 +297,14 @@ void ConfigTaskWidget::refreshWidgetsValues(UAVObject *obj)
     foreach(WidgetBinding * binding, bindings) {
         if (binding->field() != NULL && binding->widget() != NULL) {
             if (binding->isEnabled()) {
+                // On an object update only the fields which changed are put into their widgets,
+                // unless the user edited the widget since
+                QVariant fieldValue = binding->field()->getValue(binding->index());
+                if (obj != NULL && binding->isShowing(fieldValue, getVariantFromWidget(binding->widget(), binding))) {
+                    continue;
+                }
                 setWidgetFromField(binding->widget(), binding->field(), binding);
+                binding->setShownValue(fieldValue, getVariantFromWidget(binding->widget(), binding));
             } else {
                 binding->updateValueFromObjectField();
             }
@@ -737,6 +744,11 @@ void ConfigTaskWidget::defaultButtonClicked()
     }
 }
 
+/**
+ * Reload the objects of a group from the board flash, without blocking. The loads
+ * go one after the other through ObjectPersistence, the objects loaded are then
+ * requested all at once.
+ */
 void ConfigTaskWidget::reloadButtonClicked()
 {
     if (m_realtimeUpdateTimer) {
@@ -748,48 +760,80 @@ void ConfigTaskWidget::reloadButtonClicked()
         return;
     }
     ObjectPersistence *objper = dynamic_cast<ObjectPersistence *>(getObjectManager()->getObject(ObjectPersistence::NAME));
-    m_realtimeUpdateTimer = new QTimer(this);
-    QEventLoop *eventLoop     = new QEventLoop(this);
-    connect(m_realtimeUpdateTimer, SIGNAL(timeout()), eventLoop, SLOT(quit()));
-    connect(objper, SIGNAL(objectUpdated(UAVObject *)), eventLoop, SLOT(quit()));
 
-    QList<objectComparator> temp;
+    m_reloadBindings = bindings;
+    m_reloadPending.clear();
+    m_reloadLoaded.clear();
     foreach(WidgetBinding * binding, bindings) {
-        if (binding->isEnabled() && binding->object() != NULL) {
-            objectComparator value;
-            value.objid     = binding->object()->getObjID();
-            value.objinstid = binding->object()->getInstID();
-            if (temp.contains(value)) {
-                continue;
-            } else {
-                temp.append(value);
-            }
-            ObjectPersistence::DataFields data;
-            data.Operation  = ObjectPersistence::OPERATION_LOAD;
-            data.Selection  = ObjectPersistence::SELECTION_SINGLEOBJECT;
-            data.ObjectID   = binding->object()->getObjID();
-            data.InstanceID = binding->object()->getInstID();
-            objper->setData(data);
-            objper->updated();
-            m_realtimeUpdateTimer->start(500);
-            eventLoop->exec();
-            if (m_realtimeUpdateTimer->isActive()) {
-                binding->object()->requestUpdate();
-                if (binding->widget()) {
-                    setWidgetFromField(binding->widget(), binding->field(), binding);
-                }
-            }
-            m_realtimeUpdateTimer->stop();
+        if (binding->isEnabled() && binding->object() != NULL && !m_reloadPending.contains(binding->object())) {
+            m_reloadPending << binding->object();
         }
     }
-    if (eventLoop) {
-        delete eventLoop;
-        eventLoop = NULL;
+
+    m_realtimeUpdateTimer = new QTimer(this);
+    m_realtimeUpdateTimer->setSingleShot(true);
+    connect(m_realtimeUpdateTimer, SIGNAL(timeout()), this, SLOT(reloadObjectTimeout()));
+    connect(objper, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(reloadObjectLoaded(UAVObject *)));
+    reloadNextObject();
+}
+
+void ConfigTaskWidget::reloadNextObject()
+{
+    ObjectPersistence *objper = dynamic_cast<ObjectPersistence *>(getObjectManager()->getObject(ObjectPersistence::NAME));
+
+    if (m_reloadPending.isEmpty()) {
+        disconnect(objper, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(reloadObjectLoaded(UAVObject *)));
+        // finished() comes from the event loop, even for an empty list
+        connect(m_objectUtilManager->requestObjects(m_reloadLoaded), SIGNAL(finished()), this, SLOT(reloadRequestsFinished()));
+        return;
     }
-    if (m_realtimeUpdateTimer) {
-        delete m_realtimeUpdateTimer;
-        m_realtimeUpdateTimer = NULL;
+
+    UAVObject *object = m_reloadPending.first();
+    ObjectPersistence::DataFields data;
+    data.Operation  = ObjectPersistence::OPERATION_LOAD;
+    data.Selection  = ObjectPersistence::SELECTION_SINGLEOBJECT;
+    data.ObjectID   = object->getObjID();
+    data.InstanceID = object->getInstID();
+    objper->setData(data);
+    objper->updated();
+    m_realtimeUpdateTimer->start(500);
+}
+
+void ConfigTaskWidget::reloadObjectLoaded(UAVObject *object)
+{
+    ObjectPersistence::DataFields data = dynamic_cast<ObjectPersistence *>(object)->getData();
+
+    // Our own request is seen here too, wait for the board to complete it
+    if (!m_realtimeUpdateTimer || m_reloadPending.isEmpty() || data.Operation != ObjectPersistence::OPERATION_COMPLETED ||
+        data.ObjectID != m_reloadPending.first()->getObjID()) {
+        return;
+    }
+    m_realtimeUpdateTimer->stop();
+    m_reloadLoaded << m_reloadPending.takeFirst();
+    reloadNextObject();
+}
+
+void ConfigTaskWidget::reloadObjectTimeout()
+{
+    // Not in flash, or the board did not answer, the widgets keep their values
+    m_reloadPending.removeFirst();
+    reloadNextObject();
+}
+
+void ConfigTaskWidget::reloadRequestsFinished()
+{
+    UAVObjectTransactionGroup *group = qobject_cast<UAVObjectTransactionGroup *>(sender());
+    QList<UAVObject *> failed = group ? group->failed() : m_reloadLoaded;
+
+    foreach(WidgetBinding * binding, m_reloadBindings) {
+        if (binding->widget() && m_reloadLoaded.contains(binding->object()) && !failed.contains(binding->object())) {
+            setWidgetFromField(binding->widget(), binding->field(), binding);
+        }
     }
+    m_reloadBindings.clear();
+    m_reloadLoaded.clear();
+    m_realtimeUpdateTimer->deleteLater();
+    m_realtimeUpdateTimer = NULL;
 }
 
 void ConfigTaskWidget::connectWidgetUpdatesToSlot(QWidget *widget, const char *function)
@@ -1218,6 +1262,18 @@ void WidgetBinding::updateValueFromObjectField()
     }
 }
 
+void WidgetBinding::setShownValue(const QVariant &fieldValue, const QVariant &widgetValue)
+{
+    m_shownFieldValue  = fieldValue;
+    m_shownWidgetValue = widgetValue;
+}
+
+bool WidgetBinding::isShowing(const QVariant &fieldValue, const QVariant &widgetValue) const
+{
+    return m_shownFieldValue.isValid() && m_shownWidgetValue.isValid() &&
+           fieldValue == m_shownFieldValue && widgetValue == m_shownWidgetValue;
+}
+
 ShadowWidgetBinding::ShadowWidgetBinding(QWidget *widget, double scale, bool isLimited)
 {
     m_widget    = widget;
@@ -88,6 +88,10 @@ public:
     void updateObjectFieldFromValue();
     void updateValueFromObjectField();
 
+    // The field value last put into the widget and what the widget returned for it
+    void setShownValue(const QVariant &fieldValue, const QVariant &widgetValue);
+    bool isShowing(const QVariant &fieldValue, const QVariant &widgetValue) const;
+
 private:
     UAVObject *m_object;
     UAVObjectField *m_field;
@@ -95,6 +99,8 @@ private:
     bool m_isEnabled;
     QList<ShadowWidgetBinding *> m_shadows;
     QVariant m_value;
+    QVariant m_shownFieldValue;
+    QVariant m_shownWidgetValue;
 };
 
 class UAVOBJECTWIDGETUTILS_EXPORT ConfigTaskWidget : public QWidget {
@@ -180,16 +186,12 @@ private slots:
     void objectUpdated(UAVObject *object);
     void defaultButtonClicked();
     void reloadButtonClicked();
+    void reloadNextObject();
+    void reloadObjectLoaded(UAVObject *object);
+    void reloadObjectTimeout();
+    void reloadRequestsFinished();
 
 private:
-    struct objectComparator {
-        quint32 objid;
-        quint32 objinstid;
-        bool operator==(const objectComparator & lhs)
-        {
-            return lhs.objid == this->objid && lhs.objinstid == this->objinstid;
-        }
-    };
 
     enum buttonTypeEnum { none, save_button, apply_button, reload_button, default_button, help_button };
     struct bindingStruct {
@@ -221,7 +223,11 @@ private:
     QList<QPushButton *> m_reloadButtons;
     bool m_isDirty;
     QString m_outOfLimitsStyle;
+    // Set while a reload is running, it times out the load of one object
     QTimer *m_realtimeUpdateTimer;
+    QList<WidgetBinding *> m_reloadBindings;
+    QList<UAVObject *> m_reloadPending;
+    QList<UAVObject *> m_reloadLoaded;
 
     bool setWidgetFromField(QWidget *widget, UAVObjectField *field, WidgetBinding *binding);
 
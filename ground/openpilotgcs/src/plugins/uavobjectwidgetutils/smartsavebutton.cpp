@@ -72,9 +72,12 @@ void SmartSaveButton::processOperation(QPushButton *button, bool save)
     }
     QTimer timer;
     timer.setSingleShot(true);
+    connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
     bool error = false;
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectUtilManager *utilMngr     = pm->getObject<UAVObjectUtilManager>();
+
+    QList<UAVDataObject *> waiting;
     foreach(UAVDataObject * obj, objects) {
         UAVObject::Metadata mdata = obj->getMetadata();
 
@@ -83,64 +86,103 @@ void SmartSaveButton::processOperation(QPushButton *button, bool save)
             qDebug() << obj->getName() << "was skipped.";
             continue;
         }
+        if (!waiting.contains(obj)) {
+            waiting.append(obj);
+        }
+    }
 
-        up_result = false;
-        current_object = obj;
-        for (int i = 0; i < 3; ++i) {
+    // Upload: keep a window of transactions in flight instead of waiting for each round trip,
+    // telemetry handles concurrent transactions on different objects
+    QList<UAVDataObject *> uploaded;
+    QHash<UAVObject *, int> tries;
+    foreach(UAVDataObject * obj, waiting) {
+        connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transaction_finished(UAVObject *, bool)));
+    }
+    while (!waiting.isEmpty() || !in_flight.isEmpty()) {
+        while (in_flight.length() < UPLOAD_WINDOW && !waiting.isEmpty()) {
+            UAVDataObject *obj = waiting.takeFirst();
             qDebug() << "Uploading" << obj->getName() << "to board.";
-            connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transaction_finished(UAVObject *, bool)));
-            connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
+            in_flight.append(obj);
             obj->updated();
+        }
 
-            timer.start(3000);
+        timer.start(3000);
+        if (finished.isEmpty()) {
             loop.exec();
-            if (!timer.isActive()) {
+        }
+        if (!timer.isActive()) {
+            // Whatever is still pending counts as a failed try
+            foreach(UAVObject * obj, in_flight) {
                 qDebug() << "Upload of" << obj->getName() << "timed out.";
+                finished.append(qMakePair(obj, false));
             }
-            timer.stop();
+            in_flight.clear();
+        }
+        timer.stop();
 
-            disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transaction_finished(UAVObject *, bool)));
-            disconnect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
-            if (up_result) {
+        while (!finished.isEmpty()) {
+            QPair<UAVObject *, bool> result = finished.takeFirst();
+            UAVDataObject *obj = static_cast<UAVDataObject *>(result.first);
+            if (result.second) {
                 qDebug() << "Upload of" << obj->getName() << "successful.";
-                break;
+                uploaded.append(obj);
+            } else if (++tries[obj] < 3) {
+                waiting.append(obj);
+            } else {
+                qDebug() << "Upload of" << obj->getName() << "failed after 3 tries.";
+                error = true;
             }
         }
-        if (up_result == false) {
-            qDebug() << "Upload of" << obj->getName() << "failed after 3 tries.";
-            error = true;
-            continue;
-        }
+    }
+    foreach(UAVDataObject * obj, objects) {
+        disconnect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transaction_finished(UAVObject *, bool)));
+    }
 
-        sv_result = false;
-        current_objectID = obj->getObjID();
-        if (save && (obj->isSettingsObject())) {
-            for (int i = 0; i < 3; ++i) {
-                qDebug() << "Saving" << obj->getName() << "to board.";
-                connect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
-                connect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
-                utilMngr->saveObjectToSD(obj);
-
-                timer.start(3000);
-                loop.exec();
-                if (!timer.isActive()) {
-                    qDebug() << "Saving of" << obj->getName() << "timed out.";
-                }
-                timer.stop();
-
-                disconnect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
-                disconnect(&timer, SIGNAL(timeout()), &loop, SLOT(quit()));
-                if (sv_result) {
-                    qDebug() << "Saving of" << obj->getName() << "successful.";
-                    break;
-                }
+    // Save: the util manager persists the whole list with batched ObjectPersistence requests
+    // and reports each object on its own
+    QList<UAVObject *> toSave;
+    if (save) {
+        foreach(UAVDataObject * obj, uploaded) {
+            if (obj->isSettingsObject()) {
+                toSave.append(obj);
             }
-            if (sv_result == false) {
+        }
+    }
+    tries.clear();
+    connect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
+    while (!toSave.isEmpty()) {
+        qDebug() << "Saving" << toSave.length() << "objects to board.";
+        saving = toSave;
+        saved.clear();
+        toSave.clear();
+        utilMngr->saveObjectsToSD(saving);
+
+        if (!saving.isEmpty()) {
+            timer.start(3000 + 200 * saving.length());
+            loop.exec();
+            timer.stop();
+        }
+
+        // Objects the manager has not reported yet are still in its queue and will be
+        // reported later, only retry the ones that came back failed
+        foreach(UAVObject * obj, saved) {
+            if (!failed_saves.contains(obj)) {
+                qDebug() << "Saving of" << obj->getName() << "successful.";
+            } else if (++tries[obj] < 3) {
+                toSave.append(obj);
+            } else {
                 qDebug() << "Saving of" << obj->getName() << "failed after 3 tries.";
                 error = true;
             }
         }
+        foreach(UAVObject * obj, saving) {
+            qDebug() << "Saving of" << obj->getName() << "timed out.";
+            error = true;
+        }
+        failed_saves.clear();
     }
+    saving.clear();
+    disconnect(utilMngr, SIGNAL(saveCompleted(int, bool)), this, SLOT(saving_finished(int, bool)));
     if (button) {
         button->setEnabled(true);
     }
@@ -185,17 +227,26 @@ void SmartSaveButton::clearObjects()
 }
 void SmartSaveButton::transaction_finished(UAVObject *obj, bool result)
 {
-    if (current_object == obj) {
-        up_result = result;
+    if (in_flight.removeOne(obj)) {
+        finished.append(qMakePair(obj, result));
         loop.quit();
     }
 }
 
 void SmartSaveButton::saving_finished(int id, bool result)
 {
-    if (id == (int)current_objectID) {
-        sv_result = result;
-        loop.quit();
+    foreach(UAVObject * obj, saving) {
+        if (obj->getObjID() == (quint32)id) {
+            saving.removeOne(obj);
+            saved.append(obj);
+            if (!result) {
+                failed_saves.append(obj);
+            }
+            if (saving.isEmpty()) {
+                loop.quit();
+            }
+            return;
+        }
     }
 }
 
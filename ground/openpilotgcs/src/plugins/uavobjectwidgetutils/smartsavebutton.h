@@ -32,6 +32,8 @@
 #include "uavobject.h"
 #include <QPushButton>
 #include <QList>
+#include <QPair>
+#include <QHash>
 #include <QEventLoop>
 #include "uavobjectutilmanager.h"
 #include <QObject>
@@ -73,10 +75,14 @@ private slots:
     void saving_finished(int, bool);
 
 private:
-    quint32 current_objectID;
-    UAVDataObject *current_object;
-    bool up_result;
-    bool sv_result;
+    // Upload transactions kept in flight at once
+    static const int UPLOAD_WINDOW = 8;
+
+    QList<UAVObject *> in_flight;
+    QList<QPair<UAVObject *, bool> > finished;
+    QList<UAVObject *> saving;
+    QList<UAVObject *> saved;
+    QList<UAVObject *> failed_saves;
     QEventLoop loop;
     QList<UAVDataObject *> objects;
     QMap<QPushButton *, buttonTypeEnum> buttonList;
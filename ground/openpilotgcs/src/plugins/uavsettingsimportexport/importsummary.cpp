@@ -114,15 +114,16 @@ void ImportSummaryDialog::doTheSaving()
     }
     ui->progressBar->setMaximum(itemCount + 1);
     ui->progressBar->setValue(1);
+    QList<UAVObject *> objects;
     for (int i = 0; i < ui->importSummaryList->rowCount(); i++) {
         QString uavObjectName = ui->importSummaryList->item(i, 1)->text();
         QCheckBox *box = dynamic_cast<QCheckBox *>(ui->importSummaryList->cellWidget(i, 0));
         if (box->isChecked()) {
-            UAVObject *obj = objManager->getObject(uavObjectName);
-            utilManager->saveObjectToSD(obj);
-            this->repaint();
+            objects.append(objManager->getObject(uavObjectName));
         }
     }
+    // Saved in batches, the progress bar moves as each object is reported
+    utilManager->saveObjectsToSD(objects);
 
     ui->saveToFlash->setEnabled(false);
     ui->closeButton->setEnabled(false);
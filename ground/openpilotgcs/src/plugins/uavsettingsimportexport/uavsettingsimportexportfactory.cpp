@@ -42,7 +42,9 @@
 // for UAVObjects
 #include "uavdataobject.h"
 #include "uavobjectmanager.h"
+#include "uavobjectutil/uavobjecthelper.h"
 #include "extensionsystem/pluginmanager.h"
+#include <utils/crc.h>
 
 // for XML object
 #include <QDomDocument>
@@ -51,6 +53,25 @@
 #include <QFileDialog>
 #include <QMessageBox>
 
+#include <QDataStream>
+
+using namespace Utils;
+
+/*
+ * Binary settings snapshot (.uavb): a header, then one record per settings
+ * object instance, all little endian.
+ *   header: magic, format version (16 bits), record count (16 bits),
+ *           SHA1 of the UAVObject definitions of the GCS which wrote it
+ *   record: object ID, instance ID (16 bits), data size (16 bits),
+ *           CRC-32 of the data, packed object data
+ * The object ID already depends on the object definition, so a record only
+ * matches an object with the same fields.
+ */
+static const quint32 SNAPSHOT_MAGIC     = 0x4253504F; // "OPSB"
+static const quint16 SNAPSHOT_VERSION   = 1;
+static const int SNAPSHOT_HASH_SIZE     = 20;
+static const quint32 SNAPSHOT_CRC_INIT  = 0xFFFFFFFF;
+
 UAVSettingsImportExportFactory::~UAVSettingsImportExportFactory()
 {
     // Do nothing
@@ -91,28 +112,29 @@ UAVSettingsImportExportFactory::UAVSettingsImportExportFactory(QObject *parent)
 }
 
 // Slot called by the menu manager on user action
-void UAVSettingsImportExportFactory::importUAVSettings()
+/**
+ * Pushes the settings stored in fileName to the connected board, one
+ * ImportedObject per object of the file is appended to result.
+ * Objects are only updated, saving them is left to the caller.
+ */
+UAVSettingsImportExportFactory::ImportStatus UAVSettingsImportExportFactory::importUAVSettings(const QString &fileName,
+                                                                                              QList<ImportedObject> *result)
 {
-    // ask for file name
-    QString fileName;
-    QString filters = tr("UAVObjects XML files (*.uav);; XML files (*.xml)");
-
-    fileName = QFileDialog::getOpenFileName(0, tr("Import UAV Settings"), "", filters);
-    if (fileName.isEmpty()) {
-        return;
+    if (fileName.endsWith(".uavb")) {
+        QFile file(fileName);
+        if (!file.open(QFile::ReadOnly)) {
+            return ImportParseError;
+        }
+        return importSnapshot(file.readAll(), result);
     }
 
     // Now open the file
     QFile file(fileName);
     QDomDocument doc("UAVObjects");
+
     file.open(QFile::ReadOnly | QFile::Text);
     if (!doc.setContent(file.readAll())) {
-        QMessageBox msgBox;
-        msgBox.setText(tr("File Parsing Failed."));
-        msgBox.setInformativeText(tr("This file is not a correct XML file"));
-        msgBox.setStandardButtons(QMessageBox::Ok);
-        msgBox.exec();
-        return;
+        return ImportParseError;
     }
     file.close();
 
@@ -125,21 +147,11 @@ void UAVSettingsImportExportFactory::importUAVSettings()
         root = root.firstChildElement("settings");
     }
     if (root.isNull() || (root.tagName() != "settings")) {
-        QMessageBox msgBox;
-        msgBox.setText(tr("Wrong file contents"));
-        msgBox.setInformativeText(tr("This file does not contain correct UAVSettings"));
-        msgBox.setStandardButtons(QMessageBox::Ok);
-        msgBox.exec();
-        return;
+        return ImportWrongContents;
     }
 
-    // We are now ok: setup the import summary dialog & update it as we
-    // go along.
-    ImportSummaryDialog swui((QWidget *)Core::ICore::instance()->mainWindow());
-
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
-    swui.show();
 
     QDomNode node = root.firstChild();
     while (!node.isNull()) {
@@ -148,13 +160,18 @@ void UAVSettingsImportExportFactory::importUAVSettings()
             // - Read each object
             QString uavObjectName = e.attribute("name");
             uint uavObjectID = e.attribute("id").toUInt(NULL, 16);
+            ImportedObject imported;
+            imported.name    = uavObjectName;
+            imported.changed = true;
 
             // Sanity Check:
-            UAVObject *obj   = objManager->getObject(uavObjectName);
+            UAVObject *obj  = objManager->getObject(uavObjectName);
+            imported.object = obj;
             if (obj == NULL) {
                 // This object is unknown!
                 qDebug() << "Object unknown:" << uavObjectName << uavObjectID;
-                swui.addLine(uavObjectName, "Error (Object unknown)", false);
+                imported.status = tr("Error (Object unknown)");
+                imported.ok     = false;
             } else {
                 // - Update each field
                 // - Issue and "updated" command
@@ -197,20 +214,183 @@ void UAVSettingsImportExportFactory::importUAVSettings()
                 obj->updated();
 
                 if (error) {
-                    swui.addLine(uavObjectName, "Warning (Object field unknown)", true);
+                    imported.status = tr("Warning (Object field unknown)");
+                    imported.ok     = true;
                 } else if (uavObjectID != obj->getObjID()) {
                     qDebug() << "Mismatch for Object " << uavObjectName << uavObjectID << " - " << obj->getObjID();
-                    swui.addLine(uavObjectName, "Warning (ObjectID mismatch)", true);
+                    imported.status = tr("Warning (ObjectID mismatch)");
+                    imported.ok     = true;
                 } else if (setError) {
-                    swui.addLine(uavObjectName, "Warning (Objects field value(s) invalid)", false);
+                    imported.status = tr("Warning (Objects field value(s) invalid)");
+                    imported.ok     = false;
                 } else {
-                    swui.addLine(uavObjectName, "OK", true);
+                    imported.status = tr("OK");
+                    imported.ok     = true;
                 }
             }
+            result->append(imported);
         }
         node = node.nextSibling();
     }
     qDebug() << "End import";
+    return ImportOK;
+}
+
+/**
+ * Imports a binary snapshot. Only the objects whose CRC differs from the
+ * GCS copy, which follows the board, are updated; they are uploaded together
+ * with several transactions in flight and the call returns once all are done.
+ */
+UAVSettingsImportExportFactory::ImportStatus UAVSettingsImportExportFactory::importSnapshot(const QByteArray &snapshot,
+                                                                                           QList<ImportedObject> *result)
+{
+    QDataStream in(snapshot);
+
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    quint32 magic;
+    quint16 version;
+    quint16 count;
+    QByteArray hash(SNAPSHOT_HASH_SIZE, 0);
+    in >> magic >> version >> count;
+    in.readRawData(hash.data(), SNAPSHOT_HASH_SIZE);
+    if (in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC) {
+        return ImportParseError;
+    }
+    if (version != SNAPSHOT_VERSION) {
+        return ImportWrongContents;
+    }
+    if (hash != QByteArray::fromHex(VersionInfo::uavoHash().toLatin1()).left(SNAPSHOT_HASH_SIZE)) {
+        qDebug() << "Snapshot written with other UAVObject definitions, changed objects are reported unknown";
+    }
+
+    emit importAboutToBegin();
+    qDebug() << "Snapshot import about to begin," << count << "objects";
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    QList<UAVObject *> changed;
+    QList<int> changedRows;
+
+    for (int n = 0; n < count; ++n) {
+        quint32 objId;
+        quint16 instId;
+        quint16 size;
+        quint32 crc;
+        in >> objId >> instId >> size >> crc;
+        QByteArray data(size, 0);
+        if (in.status() != QDataStream::Ok || in.readRawData(data.data(), size) != size) {
+            return ImportParseError;
+        }
+
+        ImportedObject imported;
+        UAVObject *obj   = objManager->getObject(objId, instId);
+        imported.object  = obj;
+        imported.name    = obj ? obj->getName() : QString("0x") + QString().setNum(objId, 16).toUpper();
+        imported.ok      = false;
+        imported.changed = false;
+        if (obj == NULL) {
+            imported.status = tr("Error (Object unknown)");
+        } else if (Crc::updateCRC32(SNAPSHOT_CRC_INIT, (const quint8 *)data.constData(), size) != crc) {
+            imported.status = tr("Error (Object data corrupted)");
+        } else if (size != obj->getNumBytes()) {
+            imported.status = tr("Error (Object size mismatch)");
+        } else if (obj->updateCRC32(SNAPSHOT_CRC_INIT) == crc) {
+            imported.status = tr("OK (unchanged)");
+            imported.ok     = true;
+        } else {
+            obj->unpack((const quint8 *)data.constData());
+            imported.status  = tr("OK");
+            imported.ok      = true;
+            imported.changed = true;
+            changed.append(obj);
+            changedRows.append(result->length());
+        }
+        result->append(imported);
+    }
+
+    if (!changed.isEmpty()) {
+        UAVObjectBatchUpdaterHelper updater;
+        QList<UAVObject *> failed;
+        updater.doObjectsAndWait(changed, failed);
+        foreach(int row, changedRows) {
+            if (failed.contains((*result)[row].object)) {
+                (*result)[row].status = tr("Error (Upload failed)");
+                (*result)[row].ok     = false;
+            }
+        }
+    }
+    qDebug() << "End import," << changed.length() << "objects uploaded";
+    return ImportOK;
+}
+
+// Packed data of every settings object instance, see importSnapshot()
+QByteArray UAVSettingsImportExportFactory::createSnapshot()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    QList<UAVDataObject *> objects;
+    foreach(QList<UAVDataObject *> list, objManager->getDataObjects()) {
+        foreach(UAVDataObject * obj, list) {
+            if (obj->isSettingsObject()) {
+                objects.append(obj);
+            }
+        }
+    }
+
+    QByteArray snapshot;
+    QDataStream out(&snapshot, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+
+    QByteArray hash = QByteArray::fromHex(VersionInfo::uavoHash().toLatin1()).leftJustified(SNAPSHOT_HASH_SIZE, 0, true);
+    out << SNAPSHOT_MAGIC << SNAPSHOT_VERSION << (quint16)objects.length();
+    out.writeRawData(hash.constData(), SNAPSHOT_HASH_SIZE);
+    foreach(UAVDataObject * obj, objects) {
+        QByteArray data(obj->getNumBytes(), 0);
+        obj->pack((quint8 *)data.data());
+        out << obj->getObjID() << (quint16)obj->getInstID() << (quint16)data.length()
+            << Crc::updateCRC32(SNAPSHOT_CRC_INIT, (const quint8 *)data.constData(), data.length());
+        out.writeRawData(data.constData(), data.length());
+    }
+    return snapshot;
+}
+
+void UAVSettingsImportExportFactory::importUAVSettings()
+{
+    // ask for file name
+    QString fileName;
+    QString filters = tr("UAVObjects XML files (*.uav);; XML files (*.xml);; Binary settings snapshots (*.uavb)");
+
+    fileName = QFileDialog::getOpenFileName(0, tr("Import UAV Settings"), "", filters);
+    if (fileName.isEmpty()) {
+        return;
+    }
+
+    QList<ImportedObject> imported;
+    ImportStatus status = importUAVSettings(fileName, &imported);
+    if (status == ImportParseError) {
+        QMessageBox msgBox;
+        msgBox.setText(tr("File Parsing Failed."));
+        msgBox.setInformativeText(tr("This file is not a correct XML file or settings snapshot"));
+        msgBox.setStandardButtons(QMessageBox::Ok);
+        msgBox.exec();
+        return;
+    } else if (status == ImportWrongContents) {
+        QMessageBox msgBox;
+        msgBox.setText(tr("Wrong file contents"));
+        msgBox.setInformativeText(tr("This file does not contain correct UAVSettings"));
+        msgBox.setStandardButtons(QMessageBox::Ok);
+        msgBox.exec();
+        return;
+    }
+
+    // We are now ok: fill the import summary dialog
+    ImportSummaryDialog swui((QWidget *)Core::ICore::instance()->mainWindow());
+    foreach(ImportedObject obj, imported) {
+        // Objects the board already had are not offered for saving
+        swui.addLine(obj.name, obj.status, obj.ok && obj.changed);
+    }
     swui.exec();
 }
 
@@ -336,7 +516,7 @@ void UAVSettingsImportExportFactory::exportUAVSettings()
 {
     // ask for file name
     QString fileName;
-    QString filters = tr("UAVObjects XML files (*.uav)");
+    QString filters = tr("UAVObjects XML files (*.uav);; Binary settings snapshots (*.uavb)");
 
     fileName = QFileDialog::getSaveFileName(0, tr("Save UAVSettings File As"), "", filters);
     if (fileName.isEmpty()) {
@@ -347,17 +527,17 @@ void UAVSettingsImportExportFactory::exportUAVSettings()
     bool fullExport = false;
     if (fileName.endsWith(".xml")) {
         fullExport = true;
-    } else if (!fileName.endsWith(".uav")) {
+    } else if (!fileName.endsWith(".uav") && !fileName.endsWith(".uavb")) {
         fileName.append(".uav");
     }
 
-    // generate an XML first (used for all export formats as a formatted data source)
-    QString xml = createXMLDocument(Settings, fullExport);
+    // a snapshot holds the packed objects, the other formats are generated from the XML
+    QByteArray contents = fileName.endsWith(".uavb") ? createSnapshot() : createXMLDocument(Settings, fullExport).toLatin1();
 
     // save file
     QFile file(fileName);
     if (file.open(QIODevice::WriteOnly) &&
-        (file.write(xml.toLatin1()) != -1)) {
+        (file.write(contents) != -1)) {
         file.close();
     } else {
         QMessageBox::critical(0,
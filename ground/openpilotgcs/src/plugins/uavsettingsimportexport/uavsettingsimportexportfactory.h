@@ -36,9 +36,24 @@ public:
     UAVSettingsImportExportFactory(QObject *parent = 0);
     ~UAVSettingsImportExportFactory();
 
+    enum ImportStatus { ImportOK, ImportParseError, ImportWrongContents };
+
+    // Outcome of importing one object of a settings file
+    struct ImportedObject {
+        QString   name;
+        QString   status;
+        bool      ok;
+        bool      changed; // false when the board already had the imported values
+        UAVObject *object; // NULL if the object is unknown
+    };
+
+    ImportStatus importUAVSettings(const QString &fileName, QList<ImportedObject> *result);
+
 private:
     enum storedData { Settings, Data, Both };
     QString createXMLDocument(const enum storedData, const bool fullExport);
+    QByteArray createSnapshot();
+    ImportStatus importSnapshot(const QByteArray &snapshot, QList<ImportedObject> *result);
 
 private slots:
     void importUAVSettings();
@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ *
+ * @file       objectcache.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Meta and settings objects of the boards seen before
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "objectcache.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+#include <utils/crc.h>
+
+ObjectCache::ObjectCache()
+{}
+
+bool ObjectCache::load(const QByteArray &cpuSerial, quint32 firmwareCRC)
+{
+    clear();
+
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+    if (!dir.mkpath("objects")) {
+        return false;
+    }
+    m_fileName = dir.filePath(QString("objects/%1-%2.cache")
+                              .arg(QString(cpuSerial.toHex()))
+                              .arg(firmwareCRC, 8, 16, QChar('0')));
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 magic;
+    quint32 version;
+    quint32 count;
+    stream >> magic >> version >> count;
+    if (magic != FILE_MAGIC || version != FILE_VERSION) {
+        return false;
+    }
+    while (count-- > 0 && stream.status() == QDataStream::Ok) {
+        quint32 objId;
+        Entry entry;
+        stream >> objId >> entry.data;
+        entry.crc = Utils::Crc::updateCRC32(0xFFFFFFFF, (const quint8 *)entry.data.constData(), entry.data.size());
+        m_entries.insert(objId, entry);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qDebug() << "Corrupted object cache" << m_fileName;
+        m_entries.clear();
+        return false;
+    }
+    return !m_entries.isEmpty();
+}
+
+void ObjectCache::clear()
+{
+    m_fileName.clear();
+    m_entries.clear();
+}
+
+bool ObjectCache::contains(UAVObject *obj) const
+{
+    return m_entries.contains(obj->getObjID());
+}
+
+quint32 ObjectCache::crc(UAVObject *obj) const
+{
+    return m_entries.value(obj->getObjID()).crc;
+}
+
+bool ObjectCache::restore(UAVObject *obj) const
+{
+    QHash<quint32, Entry>::const_iterator entry = m_entries.constFind(obj->getObjID());
+
+    // The object changed size with a GCS upgrade
+    if (entry == m_entries.constEnd() || (quint32)entry->data.size() != obj->getNumBytes()) {
+        return false;
+    }
+    obj->unpack((const quint8 *)entry->data.constData());
+    return true;
+}
+
+bool ObjectCache::save(const QList<UAVObject *> &objects)
+{
+    if (m_fileName.isEmpty()) {
+        return false;
+    }
+    m_entries.clear();
+    foreach(UAVObject * obj, objects) {
+        Entry entry;
+        entry.data.resize(obj->getNumBytes());
+        obj->pack((quint8 *)entry.data.data());
+        entry.crc = Utils::Crc::updateCRC32(0xFFFFFFFF, (const quint8 *)entry.data.constData(), entry.data.size());
+        m_entries.insert(obj->getObjID(), entry);
+    }
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Could not write the object cache" << m_fileName << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream << FILE_MAGIC << FILE_VERSION << (quint32)m_entries.size();
+    for (QHash<quint32, Entry>::const_iterator i = m_entries.constBegin(); i != m_entries.constEnd(); ++i) {
+        stream << i.key() << i->data;
+    }
+    return stream.status() == QDataStream::Ok;
+}
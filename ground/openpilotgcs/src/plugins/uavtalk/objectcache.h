@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ *
+ * @file       objectcache.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Meta and settings objects of the boards seen before
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef OBJECTCACHE_H
+#define OBJECTCACHE_H
+
+#include "uavobject.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+/**
+ * Copies of the meta and settings objects as the board had them at the end
+ * of the last connection, one file per board (CPU serial) and firmware
+ * (image CRC). A copy is only restored once the board confirmed it with the
+ * CRC it computes for its own object, the cache is never trusted alone.
+ */
+class ObjectCache {
+public:
+    ObjectCache();
+
+    // Loads the copies of the board, returns false if there are none
+    bool load(const QByteArray &cpuSerial, quint32 firmwareCRC);
+    void clear();
+
+    bool contains(UAVObject *obj) const;
+    // CRC32 the board computes for the cached copy, see SettingsCRC
+    quint32 crc(UAVObject *obj) const;
+    // Unpacks the cached copy into the object
+    bool restore(UAVObject *obj) const;
+    // Replaces the copies with the objects as they are now and writes the file
+    bool save(const QList<UAVObject *> &objects);
+
+private:
+    struct Entry {
+        QByteArray data;
+        quint32 crc;
+    };
+
+    static const quint32 FILE_MAGIC   = 0x4F43414F;
+    static const quint32 FILE_VERSION = 1;
+
+    QString m_fileName;
+    QHash<quint32, Entry> m_entries;
+};
+
+#endif // OBJECTCACHE_H
@@ -31,6 +31,7 @@
 #include <QTime>
 #include <QtGlobal>
 #include <stdlib.h>
+#include <algorithm>
 #include <QDebug>
 
 /**
@@ -40,6 +41,13 @@ Telemetry::Telemetry(UAVTalk *utalk, UAVObjectManager *objMngr) : objMngr(objMng
 {
     mutex = new QMutex(QMutex::Recursive);
 
+    // Setup the periodic timer before the objects get scheduled
+    txRateScale = 1.0f;
+    periodicClock.start();
+    updateTimer = new QTimer(this);
+    updateTimer->setSingleShot(true);
+    connect(updateTimer, SIGNAL(timeout()), this, SLOT(processPeriodicUpdates()));
+
     // Register all objects in the list
     foreach(QList<UAVObject *> instances, objMngr->getObjects()) {
         foreach(UAVObject * object, instances) {
@@ -63,11 +71,18 @@ Telemetry::Telemetry(UAVTalk *utalk, UAVObjectManager *objMngr) : objMngr(objMng
     // Get GCS stats object
     gcsStatsObj = GCSTelemetryStats::GetInstance(objMngr);
 
-    // Setup and start the periodic timer
-    timeToNextUpdateMs = 0;
-    updateTimer = new QTimer(this);
-    connect(updateTimer, SIGNAL(timeout()), this, SLOT(processPeriodicUpdates()));
-    updateTimer->start(1000);
+    // Start the periodic timer
+    startPeriodicTimer();
+
+    // Setup the transaction timer wheel, the timer only runs while transactions are pending
+    for (int n = 0; n < TRANSACTION_TIMER_SLOTS; ++n) {
+        transTimerWheel[n] = NULL;
+    }
+    transTimerCount = 0;
+    transClock.start();
+    transTimerLastTick = currentTransactionTick();
+    transTimer = new QTimer(this);
+    connect(transTimer, SIGNAL(timeout()), this, SLOT(processTransactionTimeouts()));
 
     // Setup and start the stats timer
     txErrors  = 0;
@@ -77,6 +92,7 @@ Telemetry::Telemetry(UAVTalk *utalk, UAVObjectManager *objMngr) : objMngr(objMng
 Telemetry::~Telemetry()
 {
     closeAllTransactions();
+    qDeleteAll(transPool);
     foreach(QList<UAVObject *> instances, objMngr->getObjects()) {
         foreach(UAVObject * object, instances) {
             // make sure we 'forget' all objects before we request it from the flight side
@@ -103,18 +119,17 @@ void Telemetry::registerObject(UAVObject *obj)
 void Telemetry::addObject(UAVObject *obj)
 {
     // Check if object type is already in the list
-    for (int n = 0; n < objList.length(); ++n) {
-        if (objList[n].obj->getObjID() == obj->getObjID()) {
-            // Object type (not instance!) is already in the list, do nothing
-            return;
-        }
+    if (objListIndex.contains(obj->getObjID())) {
+        // Object type (not instance!) is already in the list, do nothing
+        return;
     }
 
     // If this point is reached, then the object type is new, let's add it
     ObjectTimeInfo timeInfo;
     timeInfo.obj = obj;
-    timeInfo.timeToNextUpdateMs = 0;
-    timeInfo.updatePeriodMs     = 0;
+    timeInfo.updatePeriodMs = 0;
+    timeInfo.generation     = 0;
+    objListIndex.insert(obj->getObjID(), objList.length());
     objList.append(timeInfo);
 }
 
@@ -124,11 +139,69 @@ void Telemetry::addObject(UAVObject *obj)
 void Telemetry::setUpdatePeriod(UAVObject *obj, qint32 periodMs)
 {
     // Find object type (not instance!) and update its period
-    for (int n = 0; n < objList.length(); ++n) {
-        if (objList[n].obj->getObjID() == obj->getObjID()) {
-            objList[n].updatePeriodMs     = periodMs;
-            objList[n].timeToNextUpdateMs = quint32((float)periodMs * (float)qrand() / (float)RAND_MAX); // avoid bunching of updates
-        }
+    QHash<quint32, int>::const_iterator it = objListIndex.constFind(obj->getObjID());
+
+    if (it == objListIndex.constEnd() || objList[it.value()].updatePeriodMs == periodMs) {
+        return;
+    }
+    ObjectTimeInfo &timeInfo = objList[it.value()];
+    timeInfo.updatePeriodMs = periodMs;
+    // Drops the update scheduled with the previous period
+    ++timeInfo.generation;
+    if (periodMs > 0) {
+        // avoid bunching of updates
+        schedulePeriodicUpdate(it.value(), periodicClock.elapsed() + qint64((float)periodMs * (float)qrand() / (float)RAND_MAX));
+        startPeriodicTimer();
+    }
+}
+
+void Telemetry::schedulePeriodicUpdate(int index, qint64 dueMs)
+{
+    PeriodicUpdate update;
+
+    update.dueMs      = dueMs;
+    update.index      = index;
+    update.generation = objList[index].generation;
+    periodicHeap.append(update);
+    std::push_heap(periodicHeap.begin(), periodicHeap.end(), PeriodicUpdateLater());
+}
+
+/**
+ * (Re)start the periodic timer for the earliest scheduled update
+ */
+void Telemetry::startPeriodicTimer()
+{
+    qint64 delay = MAX_UPDATE_PERIOD_MS;
+    if (!periodicHeap.isEmpty()) {
+        delay = qBound((qint64)MIN_UPDATE_PERIOD_MS, periodicHeap.first().dueMs - periodicClock.elapsed(), delay);
+    }
+    if (!updateTimer->isActive() || updateTimer->remainingTime() > delay) {
+        updateTimer->start(delay);
+    }
+}
+
+/**
+ * Adapt the rate of the periodic updates to the link load
+ * \param txDataRate Current transmit rate in bytes/s
+ * \param linkCapacity Estimated link capacity in bytes/s, 0 if unknown
+ */
+void Telemetry::setLinkUsage(float txDataRate, float linkCapacity)
+{
+    QMutexLocker locker(mutex);
+
+    float scale = txRateScale;
+
+    if (linkCapacity <= 0) {
+        scale = 1.0f;
+    } else if (txDataRate > linkCapacity * LINK_HIGH_LOAD_PERCENT / 100) {
+        scale = qMax(MIN_TX_RATE_SCALE_PERCENT / 100.0f, scale * TX_RATE_SCALE_STEP_PERCENT / 100);
+    } else if (txDataRate < linkCapacity * LINK_LOW_LOAD_PERCENT / 100) {
+        scale = qMin(1.0f, scale * 100 / TX_RATE_SCALE_STEP_PERCENT);
+    }
+    if (scale != txRateScale) {
+        qDebug().nospace() << "Telemetry - periodic update rate scaled to " << scale
+                           << " (tx " << txDataRate << " bytes/s, link " << linkCapacity << " bytes/s)";
+        txRateScale = scale;
     }
 }
 
@@ -326,7 +399,7 @@ void Telemetry::processObjectTransaction(ObjectTransactionInfo *transInfo)
     if (transInfo->objRequest || transInfo->acked) {
         if (sent) {
             // Start timer if a response is expected
-            transInfo->timer->start(REQ_TIMEOUT_MS);
+            startTransactionTimer(transInfo, REQ_TIMEOUT_MS);
         } else {
             // message was not sent, the transaction will not complete and will timeout
             // there is no need to wait to close the transaction and notify of completion failure
@@ -415,7 +488,7 @@ void Telemetry::processObjectQueue()
             return;
         }
         UAVObject::Metadata metadata     = objInfo.obj->getMetadata();
-        ObjectTransactionInfo *transInfo = new ObjectTransactionInfo(this);
+        ObjectTransactionInfo *transInfo = allocateTransaction();
         transInfo->obj   = objInfo.obj;
         transInfo->allInstances = objInfo.allInstances;
         transInfo->retriesRemaining = MAX_RETRIES;
@@ -425,7 +498,6 @@ void Telemetry::processObjectQueue()
         } else if (objInfo.event == EV_UPDATE_REQ) {
             transInfo->objRequest = true;
         }
-        transInfo->telem = this;
         // Insert the transaction into the transaction map.
         openTransaction(transInfo);
         processObjectTransaction(transInfo);
@@ -449,59 +521,48 @@ void Telemetry::processObjectQueue()
 }
 
 /**
- * Check is any objects are pending for periodic updates
- * TODO: Clean-up
+ * Send the periodic updates that are due
  */
 void Telemetry::processPeriodicUpdates()
 {
     QMutexLocker locker(mutex);
 
-    // Stop timer
-    updateTimer->stop();
+    qint64 now = periodicClock.elapsed();
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update (will be used for setting timeToNextUpdateMs)
-    qint32 minDelay  = MAX_UPDATE_PERIOD_MS;
-    ObjectTimeInfo *objinfo;
-    qint32 elapsedMs = 0;
-    QTime time;
-    qint32 offset;
-    bool allInstances;
-    for (int n = 0; n < objList.length(); ++n) {
-        objinfo = &objList[n];
-        // If object is configured for periodic updates
-        if (objinfo->updatePeriodMs > 0) {
-            objinfo->timeToNextUpdateMs -= timeToNextUpdateMs;
-            // Check if time for the next update
-            if (objinfo->timeToNextUpdateMs <= 0) {
-                // Reset timer
-                offset = (-objinfo->timeToNextUpdateMs) % objinfo->updatePeriodMs;
-                objinfo->timeToNextUpdateMs = objinfo->updatePeriodMs - offset;
-                // Send object
-                time.start();
-                allInstances = !objinfo->obj->isSingleInstance();
-                processObjectUpdates(objinfo->obj, EV_UPDATED_PERIODIC, allInstances, false);
-                elapsedMs    = time.elapsed();
-                // Update timeToNextUpdateMs with the elapsed delay of sending the object;
-                timeToNextUpdateMs += elapsedMs;
-            }
-            // Update minimum delay
-            if (objinfo->timeToNextUpdateMs < minDelay) {
-                minDelay = objinfo->timeToNextUpdateMs;
-            }
+    while (!periodicHeap.isEmpty() && periodicHeap.first().dueMs <= now) {
+        std::pop_heap(periodicHeap.begin(), periodicHeap.end(), PeriodicUpdateLater());
+        PeriodicUpdate update = periodicHeap.last();
+        periodicHeap.removeLast();
+
+        ObjectTimeInfo &timeInfo = objList[update.index];
+        // Skip updates scheduled before a period change
+        if (update.generation != timeInfo.generation || timeInfo.updatePeriodMs <= 0) {
+            continue;
         }
-    }
 
-    // Check if delay for the next update is too short
-    if (minDelay < MIN_UPDATE_PERIOD_MS) {
-        minDelay = MIN_UPDATE_PERIOD_MS;
+        // Send object
+        bool allInstances = !timeInfo.obj->isSingleInstance();
+        processObjectUpdates(timeInfo.obj, EV_UPDATED_PERIODIC, allInstances, false);
+
+        // Schedule the next update, stretched when the link is loaded, and skip the missed ones
+        qint32 periodMs = qMax((qint32)(objList[update.index].updatePeriodMs / txRateScale), (qint32)MIN_UPDATE_PERIOD_MS);
+        if (update.generation == objList[update.index].generation) {
+            qint64 dueMs = update.dueMs + periodMs;
+            now = periodicClock.elapsed();
+            if (dueMs <= now) {
+                dueMs = now + periodMs - (now - update.dueMs) % periodMs;
+            }
+            schedulePeriodicUpdate(update.index, dueMs);
+        }
     }
 
-    // Done
-    timeToNextUpdateMs = minDelay;
+    updateTimer->stop();
+    startPeriodicTimer();
+}
 
-    // Restart timer
-    updateTimer->start(timeToNextUpdateMs);
+VehicleClock &Telemetry::vehicleClock()
+{
+    return utalk->vehicleClock();
 }
 
 Telemetry::TelemetryStats Telemetry::getStats()
@@ -531,6 +592,13 @@ Telemetry::TelemetryStats Telemetry::getStats()
     return stats;
 }
 
+QHash<quint32, UAVTalk::ObjectStats> Telemetry::getObjectStats()
+{
+    QMutexLocker locker(mutex);
+
+    return utalk->getObjectStats();
+}
+
 void Telemetry::resetStats()
 {
     QMutexLocker locker(mutex);
@@ -606,17 +674,28 @@ ObjectTransactionInfo *Telemetry::findTransaction(UAVObject *obj)
     quint32 objId  = obj->getObjID();
     quint16 instId = obj->getInstID();
 
-    // Lookup the transaction in the transaction map
-    QMap<quint32, ObjectTransactionInfo *> *objTransactions = transMap.value(objId);
-    if (objTransactions != NULL) {
-        ObjectTransactionInfo *trans = objTransactions->value(instId);
-        if (trans == NULL) {
-            // see if there is an ALL_INSTANCES transaction
-            trans = objTransactions->value(UAVTalk::ALL_INSTANCES);
-        }
-        return trans;
+    // Lookup the transaction in the transaction table
+    ObjectTransactionInfo **trans = transMap.find(objId, instId);
+
+    if (trans == NULL) {
+        // see if there is an ALL_INSTANCES transaction
+        trans = transMap.find(objId, UAVTalk::ALL_INSTANCES);
+    }
+    return (trans != NULL) ? *trans : NULL;
+}
+
+/**
+ * Get a transaction from the pool, a new one is only allocated when the pool is empty
+ */
+ObjectTransactionInfo *Telemetry::allocateTransaction()
+{
+    if (transPool.isEmpty()) {
+        return new ObjectTransactionInfo();
     }
-    return NULL;
+    ObjectTransactionInfo *trans = transPool.last();
+    transPool.removeLast();
+    *trans = ObjectTransactionInfo();
+    return trans;
 }
 
 void Telemetry::openTransaction(ObjectTransactionInfo *trans)
@@ -624,12 +703,7 @@ void Telemetry::openTransaction(ObjectTransactionInfo *trans)
     quint32 objId  = trans->obj->getObjID();
     quint16 instId = trans->allInstances ? UAVTalk::ALL_INSTANCES : trans->obj->getInstID();
 
-    QMap<quint32, ObjectTransactionInfo *> *objTransactions = transMap.value(objId);
-    if (objTransactions == NULL) {
-        objTransactions = new QMap<quint32, ObjectTransactionInfo *>();
-        transMap.insert(objId, objTransactions);
-    }
-    objTransactions->insert(instId, trans);
+    transMap.insert(objId, instId, trans);
 }
 
 void Telemetry::closeTransaction(ObjectTransactionInfo *trans)
@@ -637,55 +711,129 @@ void Telemetry::closeTransaction(ObjectTransactionInfo *trans)
     quint32 objId  = trans->obj->getObjID();
     quint16 instId = trans->allInstances ? UAVTalk::ALL_INSTANCES : trans->obj->getInstID();
 
-    QMap<quint32, ObjectTransactionInfo *> *objTransactions = transMap.value(objId);
-    if (objTransactions != NULL) {
-        objTransactions->remove(instId);
-        // Keep the map even if it is empty
-        // There are at most 100 different object IDs...
-    }
-    delete trans;
+    stopTransactionTimer(trans);
+    transMap.remove(objId, instId);
+    // Return the transaction to the pool
+    trans->obj = NULL;
+    transPool.append(trans);
 }
 
 void Telemetry::closeAllTransactions()
 {
-    foreach(quint32 objId, transMap.keys()) {
-        QMap<quint32, ObjectTransactionInfo *> *objTransactions = transMap.value(objId);
-        foreach(quint32 instId, objTransactions->keys()) {
-            ObjectTransactionInfo *trans = objTransactions->value(instId);
+    for (int n = 0; n < transMap.capacity(); ++n) {
+        if (transMap.isUsed(n)) {
+            ObjectTransactionInfo *trans = transMap.valueAt(n);
 
             qWarning() << "Telemetry - closing active transaction for object" << trans->obj->toStringBrief();
-            objTransactions->remove(instId);
-            delete trans;
+            stopTransactionTimer(trans);
+            trans->obj = NULL;
+            transPool.append(trans);
         }
-        transMap.remove(objId);
-        delete objTransactions;
     }
+    transMap.clear();
 }
 
-ObjectTransactionInfo::ObjectTransactionInfo(QObject *parent) : QObject(parent)
+/**
+ * Current time in timer wheel ticks
+ */
+qint64 Telemetry::currentTransactionTick()
 {
-    obj = 0;
-    allInstances     = false;
-    objRequest       = false;
-    retriesRemaining = 0;
-    acked = false;
-    telem = 0;
-    // Setup transaction timer
-    timer = new QTimer(this);
-    timer->setSingleShot(true);
-    connect(timer, SIGNAL(timeout()), this, SLOT(timeout()));
+    return transClock.elapsed() / TRANSACTION_TIMER_TICK_MS;
 }
 
-ObjectTransactionInfo::~ObjectTransactionInfo()
+/**
+ * Arm (or re-arm) the timeout of a transaction
+ */
+void Telemetry::startTransactionTimer(ObjectTransactionInfo *trans, int timeoutMs)
+{
+    stopTransactionTimer(trans);
+
+    // Round up so that the timeout never fires early
+    trans->timeoutTick = currentTransactionTick() + (timeoutMs + TRANSACTION_TIMER_TICK_MS - 1) / TRANSACTION_TIMER_TICK_MS;
+    int slot = trans->timeoutTick % TRANSACTION_TIMER_SLOTS;
+    trans->timerPrev   = NULL;
+    trans->timerNext   = transTimerWheel[slot];
+    if (trans->timerNext != NULL) {
+        trans->timerNext->timerPrev = trans;
+    }
+    transTimerWheel[slot] = trans;
+    trans->timerActive    = true;
+
+    if (transTimerCount++ == 0) {
+        transTimerLastTick = currentTransactionTick();
+        transTimer->start(TRANSACTION_TIMER_TICK_MS);
+    }
+}
+
+/**
+ * Disarm the timeout of a transaction
+ */
+void Telemetry::stopTransactionTimer(ObjectTransactionInfo *trans)
 {
-    telem = 0;
-    timer->stop();
-    delete timer;
+    if (!trans->timerActive) {
+        return;
+    }
+    if (trans->timerPrev != NULL) {
+        trans->timerPrev->timerNext = trans->timerNext;
+    } else {
+        transTimerWheel[trans->timeoutTick % TRANSACTION_TIMER_SLOTS] = trans->timerNext;
+    }
+    if (trans->timerNext != NULL) {
+        trans->timerNext->timerPrev = trans->timerPrev;
+    }
+    trans->timerPrev   = NULL;
+    trans->timerNext   = NULL;
+    trans->timerActive = false;
+
+    if (--transTimerCount == 0) {
+        transTimer->stop();
+    }
 }
 
-void ObjectTransactionInfo::timeout()
+/**
+ * Advance the timer wheel and handle the transactions that timed out
+ */
+void Telemetry::processTransactionTimeouts()
 {
-    if (!telem.isNull()) {
-        telem->transactionTimeout(this);
+    QMutexLocker locker(mutex);
+
+    qint64 now = currentTransactionTick();
+
+    // If the timer was late by more than a turn there is no need to visit a slot twice
+    qint64 tick = qMax(transTimerLastTick + 1, now - TRANSACTION_TIMER_SLOTS + 1);
+
+    // Collect the expired transactions first as handling them modifies the wheel
+    QVector<ObjectTransactionInfo *> expired;
+    for (; tick <= now; ++tick) {
+        ObjectTransactionInfo *trans = transTimerWheel[tick % TRANSACTION_TIMER_SLOTS];
+        while (trans != NULL) {
+            ObjectTransactionInfo *next = trans->timerNext;
+            if (trans->timeoutTick <= now) {
+                stopTransactionTimer(trans);
+                expired.append(trans);
+            }
+            trans = next;
+        }
     }
+    transTimerLastTick = now;
+
+    foreach(ObjectTransactionInfo * trans, expired) {
+        // Skip transactions closed while handling a previous timeout
+        if (trans->obj != NULL && !trans->timerActive) {
+            transactionTimeout(trans);
+        }
+    }
+}
+
+ObjectTransactionInfo::ObjectTransactionInfo()
+{
+    obj = 0;
+    allInstances     = false;
+    objRequest       = false;
+    retriesRemaining = 0;
+    acked = false;
+    timerActive      = false;
+    timeoutTick      = 0;
+    timerPrev = 0;
+    timerNext = 0;
 }
@@ -35,23 +35,24 @@
 #include <QMutexLocker>
 #include <QTimer>
 #include <QQueue>
-#include <QMap>
-
-class ObjectTransactionInfo : public QObject {
-    Q_OBJECT
+#include <QVector>
+#include <QHash>
+#include <QElapsedTimer>
+#include "transactiontable.h"
 
+class ObjectTransactionInfo {
 public:
-    ObjectTransactionInfo(QObject *parent);
-    ~ObjectTransactionInfo();
+    ObjectTransactionInfo();
     UAVObject *obj;
     bool allInstances;
     bool objRequest;
     qint32 retriesRemaining;
     bool acked;
-    QPointer<class Telemetry>telem;
-    QTimer *timer;
-private slots:
-    void timeout();
+    // Timer wheel bookkeeping
+    bool timerActive;
+    qint64 timeoutTick;
+    ObjectTransactionInfo *timerPrev;
+    ObjectTransactionInfo *timerNext;
 };
 
 class Telemetry : public QObject {
@@ -76,8 +77,10 @@ public:
     Telemetry(UAVTalk *utalk, UAVObjectManager *objMngr);
     ~Telemetry();
     TelemetryStats getStats();
+    QHash<quint32, UAVTalk::ObjectStats> getObjectStats();
     void resetStats();
-    void transactionTimeout(ObjectTransactionInfo *info);
+    void setLinkUsage(float txDataRate, float linkCapacity);
+    VehicleClock &vehicleClock();
 
 private:
     // Constants
@@ -86,6 +89,15 @@ private:
     static const int MAX_UPDATE_PERIOD_MS = 1000;
     static const int MIN_UPDATE_PERIOD_MS = 1;
     static const int MAX_QUEUE_SIZE = 20;
+    // A single timer wheel drives the timeouts of all transactions.
+    // The wheel must span more than REQ_TIMEOUT_MS.
+    static const int TRANSACTION_TIMER_TICK_MS = 10;
+    static const int TRANSACTION_TIMER_SLOTS   = 64;
+    // Adaptive rate limiting of the periodic updates, based on the link load
+    static const int LINK_HIGH_LOAD_PERCENT     = 80;
+    static const int LINK_LOW_LOAD_PERCENT      = 60;
+    static const int TX_RATE_SCALE_STEP_PERCENT = 75;
+    static const int MIN_TX_RATE_SCALE_PERCENT  = 10;
 
     // Types
     /**
@@ -103,9 +115,25 @@ private:
     typedef struct {
         UAVObject *obj;
         qint32    updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
-        qint32    timeToNextUpdateMs; /** Time delay to the next update */
+        quint32   generation; /** Incremented when the period changes, invalidates the scheduled update */
     } ObjectTimeInfo;
 
+    /**
+     * Scheduled periodic update, kept in a min-heap ordered by due time
+     */
+    typedef struct {
+        qint64  dueMs;
+        int     index; /** Index in objList */
+        quint32 generation;
+    } PeriodicUpdate;
+
+    struct PeriodicUpdateLater {
+        bool operator()(const PeriodicUpdate &a, const PeriodicUpdate &b) const
+        {
+            return a.dueMs > b.dueMs;
+        }
+    };
+
     typedef struct {
         UAVObject *obj;
         EventMask event;
@@ -117,13 +145,22 @@ private:
     UAVTalk *utalk;
     GCSTelemetryStats *gcsStatsObj;
     QList<ObjectTimeInfo> objList;
+    QHash<quint32, int> objListIndex;
+    QVector<PeriodicUpdate> periodicHeap;
+    QElapsedTimer periodicClock;
+    float txRateScale;
     QQueue<ObjectQueueInfo> objQueue;
     QQueue<ObjectQueueInfo> objPriorityQueue;
-    QMap<quint32, QMap<quint32, ObjectTransactionInfo *> *> transMap;
+    TransactionTable<ObjectTransactionInfo *> transMap;
+    QVector<ObjectTransactionInfo *> transPool;
+    ObjectTransactionInfo *transTimerWheel[TRANSACTION_TIMER_SLOTS];
+    qint64 transTimerLastTick;
+    int transTimerCount;
+    QElapsedTimer transClock;
+    QTimer *transTimer;
     QMutex *mutex;
     QTimer *updateTimer;
     QTimer *statsTimer;
-    qint32 timeToNextUpdateMs;
     quint32 txErrors;
     quint32 txRetries;
 
@@ -131,6 +168,8 @@ private:
     void registerObject(UAVObject *obj);
     void addObject(UAVObject *obj);
     void setUpdatePeriod(UAVObject *obj, qint32 periodMs);
+    void schedulePeriodicUpdate(int index, qint64 dueMs);
+    void startPeriodicTimer();
     void connectToObjectInstances(UAVObject *obj, quint32 eventMask);
     void connectToObject(UAVObject *obj, quint32 eventMask);
     void updateObject(UAVObject *obj, quint32 eventMask);
@@ -139,9 +178,14 @@ private:
     void processObjectQueue();
 
     ObjectTransactionInfo *findTransaction(UAVObject *obj);
+    ObjectTransactionInfo *allocateTransaction();
     void openTransaction(ObjectTransactionInfo *trans);
     void closeTransaction(ObjectTransactionInfo *trans);
     void closeAllTransactions();
+    void transactionTimeout(ObjectTransactionInfo *info);
+    qint64 currentTransactionTick();
+    void startTransactionTimer(ObjectTransactionInfo *trans, int timeoutMs);
+    void stopTransactionTimer(ObjectTransactionInfo *trans);
 
 private slots:
     void objectUpdatedAuto(UAVObject *obj);
@@ -152,6 +196,7 @@ private slots:
     void newObject(UAVObject *obj);
     void newInstance(UAVObject *obj);
     void processPeriodicUpdates();
+    void processTransactionTimeouts();
     void transactionCompleted(UAVObject *obj, bool success);
 };
 
@@ -32,7 +32,7 @@
 #include <coreplugin/icore.h>
 #include <coreplugin/threadmanager.h>
 
-TelemetryManager::TelemetryManager() : m_connectionState(TELEMETRY_DISCONNECTED)
+TelemetryManager::TelemetryManager() : m_uavTalk(NULL), m_connectionState(TELEMETRY_DISCONNECTED)
 {
     moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
     // Get UAVObjectManager instance
@@ -57,6 +57,22 @@ TelemetryManager::ConnectionState TelemetryManager::connectionState() const
     return m_connectionState;
 }
 
+/**
+ * Sends an object right away, without going through the queues and the
+ * transactions of the telemetry. For fixed rate unacked streams, callable
+ * from any thread, the object is packed in the calling thread.
+ * \return false if there is no link or the link is full
+ */
+bool TelemetryManager::sendObjectUnacked(UAVObject *obj)
+{
+    QMutexLocker locker(&m_uavTalkMutex);
+
+    if (!m_uavTalk || m_connectionState != TELEMETRY_CONNECTED) {
+        return false;
+    }
+    return m_uavTalk->sendObject(obj, false, false);
+}
+
 void TelemetryManager::start(QIODevice *dev)
 {
     m_connectionState = TELEMETRY_CONNECTING;
@@ -74,27 +90,24 @@ void TelemetryManager::start(QIODevice *dev)
 
 void TelemetryManager::onStart()
 {
-    m_uavTalk = new UAVTalk(m_telemetryDevice, m_uavobjectManager);
-    if (false) {
-        // UAVTalk must be thread safe and for that:
-        // 1- all public methods must lock a mutex
-        // 2- the reader thread must lock that mutex too
-        // The reader thread locks the mutex once a packet is read and decoded.
-        // It is assumed that the UAVObjectManager is thread safe
-
-        // Create the reader and move it to the reader thread
-        IODeviceReader *reader = new IODeviceReader(m_uavTalk);
-        reader->moveToThread(&m_telemetryReaderThread);
-        // The reader will be deleted (later) when the thread finishes
-        connect(&m_telemetryReaderThread, &QThread::finished, reader, &QObject::deleteLater);
-        // Connect IO device to reader
-        connect(m_telemetryDevice, SIGNAL(readyRead()), reader, SLOT(read()));
-        // start the reader thread
-        m_telemetryReaderThread.start();
+    // Reading, framing and unpacking run on a thread of their own so transactions,
+    // retries and the monitor here do not hold up the parser and the other way around.
+    // The device and the parser are owned by that thread, frames sent from here are
+    // queued and written from there.
+    QThread *ioThread = Core::ICore::instance()->threadManager()->getLinkThread("TelemetryIO");
+
+    if (m_telemetryDevice->parent()) {
+        // owned by its connection (IP sockets), it cannot move, parse where it lives
+        ioThread = m_telemetryDevice->thread();
     } else {
-        // Connect IO device to reader
-        connect(m_telemetryDevice, SIGNAL(readyRead()), m_uavTalk, SLOT(processInputStream()));
+        m_telemetryDevice->moveToThread(ioThread);
     }
+    UAVTalk *uavTalk = new UAVTalk(m_telemetryDevice, m_uavobjectManager);
+    uavTalk->moveToThread(ioThread);
+    m_uavTalkMutex.lock();
+    m_uavTalk = uavTalk;
+    m_uavTalkMutex.unlock();
+    connect(m_telemetryDevice, SIGNAL(readyRead()), m_uavTalk, SLOT(processInputStream()));
 
     m_telemetry = new Telemetry(m_uavTalk, m_uavobjectManager);
     m_telemetryMonitor = new TelemetryMonitor(m_uavobjectManager, m_telemetry);
@@ -109,11 +122,6 @@ void TelemetryManager::stop()
     m_connectionState = TELEMETRY_DISCONNECTING;
     emit disconnecting();
     emit myStop();
-
-    if (false) {
-        m_telemetryReaderThread.quit();
-        m_telemetryReaderThread.wait();
-    }
 }
 
 void TelemetryManager::onStop()
@@ -121,7 +129,11 @@ void TelemetryManager::onStop()
     m_telemetryMonitor->disconnect(this);
     delete m_telemetryMonitor;
     delete m_telemetry;
-    delete m_uavTalk;
+    // it may be parsing right now, let its own thread delete it
+    m_uavTalkMutex.lock();
+    m_uavTalk->deleteLater();
+    m_uavTalk = NULL;
+    m_uavTalkMutex.unlock();
     onDisconnect();
 }
 
@@ -141,11 +153,3 @@ void TelemetryManager::onTelemetryUpdate(double txRate, double rxRate)
 {
     emit telemetryUpdated(txRate, rxRate);
 }
-
-IODeviceReader::IODeviceReader(UAVTalk *uavTalk) : m_uavTalk(uavTalk)
-{}
-
-void IODeviceReader::read()
-{
-    m_uavTalk->processInputStream();
-}
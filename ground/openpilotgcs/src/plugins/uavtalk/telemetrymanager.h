@@ -33,6 +33,7 @@
 #include "uavobjectmanager.h"
 #include <QIODevice>
 #include <QObject>
+#include <QMutex>
 
 class Telemetry;
 class TelemetryMonitor;
@@ -55,6 +56,7 @@ public:
     void stop();
     bool isConnected() const;
     ConnectionState connectionState() const;
+    bool sendObjectUnacked(UAVObject *obj);
 
 signals:
     void connecting();
@@ -75,23 +77,12 @@ private slots:
 private:
     UAVObjectManager *m_uavobjectManager;
     UAVTalk *m_uavTalk;
+    // Guards m_uavTalk for the senders outside of the telemetry threads
+    QMutex m_uavTalkMutex;
     Telemetry *m_telemetry;
     TelemetryMonitor *m_telemetryMonitor;
     QIODevice *m_telemetryDevice;
     ConnectionState m_connectionState;
-    QThread m_telemetryReaderThread;
-};
-
-
-class IODeviceReader : public QObject {
-    Q_OBJECT
-public:
-    IODeviceReader(UAVTalk *uavTalk);
-
-    UAVTalk *m_uavTalk;
-
-public slots:
-    void read();
 };
 
 #endif // TELEMETRYMANAGER_H
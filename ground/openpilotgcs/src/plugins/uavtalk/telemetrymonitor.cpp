@@ -28,6 +28,7 @@
 #include "telemetrymonitor.h"
 #include "coreplugin/connectionmanager.h"
 #include "coreplugin/icore.h"
+#include <QtMath>
 
 /**
  * Constructor
@@ -38,14 +39,30 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager *objMngr, Telemetry *tel) :
     gcsStatsObj(GCSTelemetryStats::GetInstance(objMngr)),
     flightStatsObj(FlightTelemetryStats::GetInstance(objMngr)),
     firmwareIAPObj(FirmwareIAPObj::GetInstance(objMngr)),
+    settingsCRCObj(SettingsCRC::GetInstance(objMngr)),
+    crcTimer(new QTimer(this)),
     statsTimer(new QTimer(this)),
-    objPending(NULL),
+    pingObj(TelemetryPing::GetInstance(objMngr)),
+    pingTimer(new QTimer(this)),
+    pingSent(-1),
     mutex(new QMutex(QMutex::Recursive)),
-    connectionTimer(new QTime())
+    connectionTimer(new QTime()),
+    linkCapacity(0),
+    budgetLogged(false)
 {
     // Listen for flight stats updates
     connect(flightStatsObj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(flightStatsUpdated(UAVObject *)));
 
+    crcTimer->setSingleShot(true);
+    crcTimer->setInterval(SETTINGS_CRC_TIMEOUT_MS);
+    connect(crcTimer, SIGNAL(timeout()), this, SLOT(settingsCRCTimeout()));
+
+    pingTimer->setInterval(PING_PERIOD_MS);
+    connect(pingTimer, SIGNAL(timeout()), this, SLOT(sendPing()));
+    if (pingObj) {
+        connect(pingObj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(pingUpdated(UAVObject *)));
+    }
+
     // Start update timer
     connect(statsTimer, SIGNAL(timeout()), this, SLOT(processStatsUpdates()));
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
@@ -66,8 +83,13 @@ TelemetryMonitor::~TelemetryMonitor()
  */
 void TelemetryMonitor::startRetrievingObjects()
 {
-    // Clear object queue
+    // Clear object queue, requests left over from the last connection are not waited for
     queue.clear();
+    crcQueue.clear();
+    foreach(UAVObject * obj, objPending) {
+        obj->disconnect(this);
+    }
+    objPending.clear();
     // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queue
     QList< QList<UAVObject *> > objs = objMngr->getObjects();
     for (int n = 0; n < objs.length(); ++n) {
@@ -77,20 +99,178 @@ void TelemetryMonitor::startRetrievingObjects()
         UAVObject::Metadata mdata = obj->getMetadata();
         if (mobj != NULL) {
             queue.enqueue(obj);
+            crcQueue.append(obj);
         } else if (dobj != NULL) {
             if (dobj->isSettingsObject()) {
                 queue.enqueue(obj);
+                crcQueue.append(obj);
             } else {
-                if (UAVObject::GetFlightTelemetryUpdateMode(mdata) == UAVObject::UPDATEMODE_ONCHANGE) {
+                // The board identity is retrieved first, for the cache
+                if (UAVObject::GetFlightTelemetryUpdateMode(mdata) == UAVObject::UPDATEMODE_ONCHANGE && obj != firmwareIAPObj) {
                     queue.enqueue(obj);
                 }
             }
         }
     }
+    cacheObjects = crcQueue;
     // Start retrieving
     qDebug() << tr("Starting to retrieve meta and settings objects from the autopilot (%1 objects)")
         .arg(queue.length());
-    retrieveNextObject();
+    cache.clear();
+    if (settingsCRCObj && !crcQueue.isEmpty()) {
+        connect(firmwareIAPObj, SIGNAL(transactionCompleted(UAVObject *, bool)),
+                this, SLOT(boardIdentityRetrieved(UAVObject *, bool)), Qt::UniqueConnection);
+        firmwareIAPObj->requestUpdate();
+    } else {
+        queue.enqueue(firmwareIAPObj);
+        crcQueue.clear();
+        retrieveNextObjects();
+    }
+}
+
+/**
+ * The CPU serial and firmware CRC select the cache of the board.
+ */
+void TelemetryMonitor::boardIdentityRetrieved(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    disconnect(firmwareIAPObj, SIGNAL(transactionCompleted(UAVObject *, bool)),
+               this, SLOT(boardIdentityRetrieved(UAVObject *, bool)));
+    if (success) {
+        FirmwareIAPObj::DataFields board = firmwareIAPObj->getData();
+        QByteArray cpuSerial((const char *)board.CPUSerial, FirmwareIAPObj::CPUSERIAL_NUMELEM);
+        if (cache.load(cpuSerial, board.crc)) {
+            qDebug("Object cache of the board loaded");
+        }
+    }
+
+    GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
+    if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED) {
+        startComparingCRCs();
+    } else {
+        stopRetrievingObjects();
+    }
+}
+
+void TelemetryMonitor::startComparingCRCs()
+{
+    connect(settingsCRCObj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(settingsCRCUpdated(UAVObject *)));
+    connect(settingsCRCObj, SIGNAL(transactionCompleted(UAVObject *, bool)),
+            this, SLOT(settingsCRCTransactionCompleted(UAVObject *, bool)));
+    requestNextCRCs();
+}
+
+/**
+ * Ask the autopilot for the CRCs of the next batch of meta and settings
+ * objects. The objects whose CRC matches the GCS copy or the cached one are
+ * not requested again, when all are compared the normal retrieval starts
+ * with what is left.
+ */
+void TelemetryMonitor::requestNextCRCs()
+{
+    crcPending.clear();
+    if (crcQueue.isEmpty()) {
+        stopComparingCRCs();
+        qDebug() << tr("Object CRCs compared, %1 objects left to retrieve").arg(queue.length());
+        retrieveNextObjects();
+        return;
+    }
+
+    SettingsCRC::DataFields data;
+    memset(&data, 0, sizeof(data));
+    data.Operation = SettingsCRC::OPERATION_REQUEST;
+    for (int i = 0; i < SettingsCRC::OBJECTIDS_NUMELEM && !crcQueue.isEmpty(); ++i) {
+        UAVObject *obj = crcQueue.takeFirst();
+        data.ObjectIDs[i] = obj->getObjID();
+        crcPending.append(obj);
+    }
+    settingsCRCObj->setData(data);
+    settingsCRCObj->updated();
+}
+
+void TelemetryMonitor::stopComparingCRCs()
+{
+    crcTimer->stop();
+    crcQueue.clear();
+    crcPending.clear();
+    if (settingsCRCObj) {
+        disconnect(settingsCRCObj, 0, this, 0);
+    }
+}
+
+/**
+ * The request was acked, or it failed because the firmware does not know
+ * SettingsCRC, then everything is retrieved.
+ */
+void TelemetryMonitor::settingsCRCTransactionCompleted(UAVObject *obj, bool success)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    if (crcPending.isEmpty()) {
+        return;
+    }
+    if (success) {
+        crcTimer->start();
+    } else {
+        qDebug("The autopilot does not answer SettingsCRC requests, retrieving all settings");
+        stopComparingCRCs();
+        retrieveNextObjects();
+    }
+}
+
+void TelemetryMonitor::settingsCRCTimeout()
+{
+    QMutexLocker locker(mutex);
+
+    if (!crcPending.isEmpty()) {
+        qDebug("SettingsCRC request timed out, retrieving the remaining settings");
+        stopComparingCRCs();
+        retrieveNextObjects();
+    }
+}
+
+/**
+ * Called with the answer of the autopilot, and with the echo of our own request
+ */
+void TelemetryMonitor::settingsCRCUpdated(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    SettingsCRC::DataFields data = settingsCRCObj->getData();
+    if (crcPending.isEmpty() || data.Operation != SettingsCRC::OPERATION_COMPLETED ||
+        data.ObjectIDs[0] != crcPending[0]->getObjID()) {
+        return;
+    }
+    crcTimer->stop();
+
+    for (int i = 0; i < crcPending.length(); ++i) {
+        UAVObject *object = crcPending[i];
+        // 0 is the answer for an object the firmware does not have
+        if (data.ObjectIDs[i] != object->getObjID() || data.CRCs[i] == 0) {
+            continue;
+        }
+        if (data.CRCs[i] == object->updateCRC32()) {
+            // The GCS copy is current, unpacking it again tells the listeners it was received
+            QByteArray buf(object->getNumBytes(), 0);
+            object->pack((quint8 *)buf.data());
+            object->unpack((const quint8 *)buf.constData());
+        } else if (!cache.contains(object) || data.CRCs[i] != cache.crc(object) || !cache.restore(object)) {
+            continue;
+        }
+        queue.removeOne(object);
+    }
+
+    GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
+    if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED) {
+        requestNextCRCs();
+    } else {
+        stopComparingCRCs();
+        stopRetrievingObjects();
+    }
 }
 
 /**
@@ -100,53 +280,64 @@ void TelemetryMonitor::stopRetrievingObjects()
 {
     qDebug("Object retrieval has been cancelled");
     queue.clear();
+    foreach(UAVObject * obj, objPending) {
+        obj->disconnect(this);
+    }
+    objPending.clear();
+    stopComparingCRCs();
 }
 
 /**
- * Retrieve the next object in the queue
+ * Request the next objects in the queue, up to RETRIEVAL_WINDOW at once.
+ * Waiting for each answer before the next request would cost a round trip
+ * of the link per object, the answers are independent of each other.
  */
-void TelemetryMonitor::retrieveNextObject()
+void TelemetryMonitor::retrieveNextObjects()
 {
-    // If queue is empty return
+    // Retrieval completed once all the requests are answered
     if (queue.isEmpty()) {
-        qDebug("Object retrieval completed");
-        if (firmwareIAPObj->getBoardType()) {
-            emit connected();
-        } else {
-            connect(firmwareIAPObj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(firmwareIAPUpdated(UAVObject *)));
+        if (objPending.isEmpty()) {
+            qDebug("Object retrieval completed");
+            cache.save(cacheObjects);
+            if (firmwareIAPObj->getBoardType()) {
+                emit connected();
+            } else {
+                connect(firmwareIAPObj, SIGNAL(objectUpdated(UAVObject *)), this, SLOT(firmwareIAPUpdated(UAVObject *)));
+            }
         }
         return;
     }
 
-    // Get next object from the queue
-    UAVObject *obj = queue.dequeue();
-    // qDebug( tr("Retrieving object: %1").arg(obj->getName()) );
+    while (objPending.length() < RETRIEVAL_WINDOW && !queue.isEmpty()) {
+        // Get next object from the queue
+        UAVObject *obj = queue.dequeue();
+        // qDebug( tr("Retrieving object: %1").arg(obj->getName()) );
 
-    // Connect to object
-    connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
+        // Connect to object
+        connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), this, SLOT(transactionCompleted(UAVObject *, bool)));
 
-    // Request update
-    obj->requestUpdate();
-    objPending = obj;
+        // Request update
+        objPending.append(obj);
+        obj->requestUpdate();
+    }
 }
 
 /**
- * Called by the retrieved object when a transaction is completed.
+ * Called by the retrieved objects when a transaction is completed.
  */
 void TelemetryMonitor::transactionCompleted(UAVObject *obj, bool success)
 {
     Q_UNUSED(success);
     QMutexLocker locker(mutex);
 
-    if (obj == objPending) {
+    if (objPending.removeOne(obj)) {
         // Disconnect from sending object
         obj->disconnect(this);
-        objPending = NULL;
-        // Process next object if telemetry is still available
+        // Process next objects if telemetry is still available
         GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
 
         if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED) {
-            retrieveNextObject();
+            retrieveNextObjects();
         } else {
             stopRetrievingObjects();
         }
@@ -184,6 +375,110 @@ void TelemetryMonitor::firmwareIAPUpdated(UAVObject *obj)
     }
 }
 
+/**
+ * Send a time exchange request, the autopilot answers at once with its
+ * receive and transmit times.
+ */
+void TelemetryMonitor::sendPing()
+{
+    QMutexLocker locker(mutex);
+
+    TelemetryPing::DataFields data;
+
+    memset(&data, 0, sizeof(data));
+    pingSent = tel->vehicleClock().localTime();
+    data.Operation       = TelemetryPing::OPERATION_REQUEST;
+    data.GcsTransmitTime = (quint32)pingSent;
+    pingObj->setData(data);
+    pingObj->updated();
+}
+
+/**
+ * Called with the answer of the autopilot, and with our own request
+ */
+void TelemetryMonitor::pingUpdated(UAVObject *obj)
+{
+    Q_UNUSED(obj);
+    QMutexLocker locker(mutex);
+
+    TelemetryPing::DataFields data = pingObj->getData();
+    // A late answer to an older request is dropped, its round trip would be wrong
+    if (pingSent < 0 || data.Operation != TelemetryPing::OPERATION_REPLY || data.GcsTransmitTime != (quint32)pingSent) {
+        return;
+    }
+    tel->vehicleClock().addExchange(pingSent, data.FlightReceiveTime, data.FlightTransmitTime,
+                                    tel->vehicleClock().localTime());
+    pingSent = -1;
+}
+
+/**
+ * Estimate the link capacity and let the telemetry adapt its periodic updates.
+ * The link is saturated when the autopilot receives clearly less than was sent
+ * or when events were dropped from the full telemetry queues; the capacity is
+ * then what went through. Otherwise the estimate is slowly raised again.
+ */
+void TelemetryMonitor::updateLinkCapacity(const GCSTelemetryStats::DataFields &gcsStats,
+                                          const FlightTelemetryStats::DataFields &flightStats, const Telemetry::TelemetryStats &telStats)
+{
+    if (gcsStats.Status != GCSTelemetryStats::STATUS_CONNECTED || flightStats.Status != FlightTelemetryStats::STATUS_CONNECTED) {
+        linkCapacity = 0;
+    } else if (flightStats.RxDataRate < gcsStats.TxDataRate * LINK_LOSS_PERCENT / 100) {
+        linkCapacity = flightStats.RxDataRate;
+    } else if (telStats.txErrors > 0) {
+        linkCapacity = gcsStats.TxDataRate;
+    } else if (linkCapacity > 0) {
+        linkCapacity = qMax(linkCapacity * LINK_PROBE_PERCENT / 100, gcsStats.TxDataRate);
+    }
+    tel->setLinkUsage(gcsStats.TxDataRate, linkCapacity);
+}
+
+/**
+ * Once per saturation of the link from the autopilot, log the objects that use
+ * the most of it with the flight telemetry period that would fit them in what
+ * the link carries. The board reports the same on its side in
+ * TelemetryObjectStats, when built with DIAG_TELEMETRY.
+ */
+void TelemetryMonitor::logTelemetryBudget(const GCSTelemetryStats::DataFields &gcsStats,
+                                          const FlightTelemetryStats::DataFields &flightStats, const QHash<quint32, UAVTalk::ObjectStats> &objectStats)
+{
+    if (gcsStats.Status != GCSTelemetryStats::STATUS_CONNECTED || flightStats.Status != FlightTelemetryStats::STATUS_CONNECTED ||
+        gcsStats.RxDataRate >= flightStats.TxDataRate * LINK_LOSS_PERCENT / 100 || gcsStats.RxDataRate <= 0) {
+        budgetLogged = false;
+        return;
+    }
+    if (budgetLogged) {
+        return;
+    }
+    budgetLogged = true;
+
+    QList<QPair<quint32, quint32> > ranking;
+    for (QHash<quint32, UAVTalk::ObjectStats>::const_iterator it = objectStats.constBegin(); it != objectStats.constEnd(); ++it) {
+        ranking.append(qMakePair(it.value().rxBytes, it.key()));
+    }
+    qSort(ranking.begin(), ranking.end(), qGreater<QPair<quint32, quint32> >());
+
+    // The periods scale with what was sent over what was received
+    float scale    = flightStats.TxDataRate / gcsStats.RxDataRate;
+    float interval = (float)statsTimer->interval() / 1000.0f;
+    qDebug().nospace() << "Telemetry - link from the autopilot saturated (sent " << flightStats.TxDataRate
+                       << " bytes/s, received " << gcsStats.RxDataRate << " bytes/s), busiest objects:";
+    for (int i = 0; i < ranking.size() && i < BUDGET_OBJECTS; i++) {
+        UAVObject *obj   = objMngr->getObject(ranking[i].second);
+        float rate = ranking[i].first / interval;
+        if (!obj) {
+            qDebug().nospace() << "  0x" << QString::number(ranking[i].second, 16) << " " << rate << " bytes/s";
+            continue;
+        }
+        UAVObject::Metadata mdata = obj->getMetadata();
+        if (UAVObject::GetFlightTelemetryUpdateMode(mdata) == UAVObject::UPDATEMODE_PERIODIC && mdata.flightTelemetryUpdatePeriod > 0) {
+            qDebug().nospace() << "  " << obj->getName() << " " << rate << " bytes/s, period " << mdata.flightTelemetryUpdatePeriod
+                               << " ms, suggested " << qCeil(mdata.flightTelemetryUpdatePeriod * scale) << " ms";
+        } else {
+            qDebug().nospace() << "  " << obj->getName() << " " << rate << " bytes/s, not periodic";
+        }
+    }
+}
+
 /**
  * Called periodically to update the statistics and connection status.
  */
@@ -195,6 +490,7 @@ void TelemetryMonitor::processStatsUpdates()
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
     FlightTelemetryStats::DataFields flightStats = flightStatsObj->getData();
     Telemetry::TelemetryStats telStats     = tel->getStats();
+    QHash<quint32, UAVTalk::ObjectStats> objectStats = tel->getObjectStats();
 
     tel->resetStats();
 
@@ -210,6 +506,12 @@ void TelemetryMonitor::processStatsUpdates()
     gcsStats.RxSyncErrors += telStats.rxSyncErrors;
     gcsStats.RxCrcErrors  += telStats.rxCrcErrors;
 
+    // Half the round trip, the link is assumed to take as long both ways
+    VehicleClock &clock = tel->vehicleClock();
+    gcsStats.RoundTripTime = clock.roundTripTime();
+    gcsStats.Latency   = gcsStats.RoundTripTime / 2;
+    gcsStats.ClockSkew = clock.skew();
+
     // Check for a connection timeout
     bool connectionTimeout;
     if (telStats.rxObjects > 0) {
@@ -238,6 +540,9 @@ void TelemetryMonitor::processStatsUpdates()
         }
     }
 
+    updateLinkCapacity(gcsStats, flightStats, telStats);
+    logTelemetryBudget(gcsStats, flightStats, objectStats);
+
     emit telemetryUpdated((double)gcsStats.TxDataRate, (double)gcsStats.RxDataRate);
 
     // Set data
@@ -253,11 +558,18 @@ void TelemetryMonitor::processStatsUpdates()
     if (gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED && gcsStats.Status != oldStatus) {
         statsTimer->setInterval(STATS_UPDATE_PERIOD_MS);
         qDebug("Connection with the autopilot established");
+        if (pingObj) {
+            pingTimer->start();
+        }
         startRetrievingObjects();
     }
     if (gcsStats.Status == GCSTelemetryStats::STATUS_DISCONNECTED && gcsStats.Status != oldStatus) {
         statsTimer->setInterval(STATS_CONNECT_PERIOD_MS);
         qDebug("Connection with the autopilot lost");
+        pingTimer->stop();
+        pingSent = -1;
+        // The board may come back restarted, its clock with it
+        clock.reset();
         qDebug("Trying to connect to the autopilot");
         emit disconnected();
     }
@@ -39,7 +39,10 @@
 #include "flighttelemetrystats.h"
 #include "firmwareiapobj.h"
 #include "systemstats.h"
+#include "settingscrc.h"
+#include "telemetryping.h"
 #include "telemetry.h"
+#include "objectcache.h"
 
 class TelemetryMonitor : public QObject {
     Q_OBJECT
@@ -58,11 +61,29 @@ public slots:
     void processStatsUpdates();
     void flightStatsUpdated(UAVObject *obj);
     void firmwareIAPUpdated(UAVObject *obj);
+    void settingsCRCUpdated(UAVObject *obj);
+    void settingsCRCTransactionCompleted(UAVObject *obj, bool success);
+    void settingsCRCTimeout();
+    void boardIdentityRetrieved(UAVObject *obj, bool success);
+    void sendPing();
+    void pingUpdated(UAVObject *obj);
 
 private:
     static const int STATS_UPDATE_PERIOD_MS  = 4000;
     static const int STATS_CONNECT_PERIOD_MS = 2000;
     static const int CONNECTION_TIMEOUT_MS   = 8000;
+    // The link is considered saturated when the autopilot receives less than this share of the sent bytes
+    static const int LINK_LOSS_PERCENT = 90;
+    // Growth of the link capacity estimate while the link is not saturated
+    static const int LINK_PROBE_PERCENT = 110;
+    // Time the autopilot has to answer a SettingsCRC request once it acked it
+    static const int SETTINGS_CRC_TIMEOUT_MS = 1000;
+    // Period of the time exchanges while connected
+    static const int PING_PERIOD_MS = 1000;
+    // Object requests kept outstanding during the retrieval, within the telemetry queue size
+    static const int RETRIEVAL_WINDOW = 8;
+    // Busiest objects logged when the link from the autopilot saturates
+    static const int BUDGET_OBJECTS = 8;
 
     UAVObjectManager *objMngr;
     Telemetry *tel;
@@ -70,14 +91,37 @@ private:
     GCSTelemetryStats *gcsStatsObj;
     FlightTelemetryStats *flightStatsObj;
     FirmwareIAPObj *firmwareIAPObj;
+    SettingsCRC *settingsCRCObj;
+    // Settings still to be compared and the ones of the request in flight
+    QList<UAVObject *> crcQueue;
+    QList<UAVObject *> crcPending;
+    // Meta and settings objects of the board, kept across sessions
+    ObjectCache cache;
+    QList<UAVObject *> cacheObjects;
+    QTimer *crcTimer;
     QTimer *statsTimer;
-    UAVObject *objPending;
+    TelemetryPing *pingObj;
+    QTimer *pingTimer;
+    // GCS clock when the last request was sent
+    qint64 pingSent;
+    // Objects requested and not answered yet
+    QList<UAVObject *> objPending;
     QMutex *mutex;
     QTime *connectionTimer;
+    float linkCapacity;
+    // The budget of the current saturation was logged
+    bool budgetLogged;
 
     void startRetrievingObjects();
-    void retrieveNextObject();
+    void retrieveNextObjects();
     void stopRetrievingObjects();
+    void startComparingCRCs();
+    void requestNextCRCs();
+    void stopComparingCRCs();
+    void updateLinkCapacity(const GCSTelemetryStats::DataFields &gcsStats,
+                            const FlightTelemetryStats::DataFields &flightStats, const Telemetry::TelemetryStats &telStats);
+    void logTelemetryBudget(const GCSTelemetryStats::DataFields &gcsStats,
+                            const FlightTelemetryStats::DataFields &flightStats, const QHash<quint32, UAVTalk::ObjectStats> &objectStats);
 };
 
 #endif // TELEMETRYMONITOR_H
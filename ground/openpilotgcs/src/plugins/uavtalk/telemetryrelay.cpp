@@ -0,0 +1,381 @@
+/**
+ ******************************************************************************
+ *
+ * @file       telemetryrelay.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Fans the object updates of the vehicle link out to local clients
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "telemetryrelay.h"
+#include <coreplugin/icore.h>
+#include <coreplugin/threadmanager.h>
+#include <utils/crc.h>
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QTimer>
+#include <QSettings>
+#include <QStringList>
+#include <QtEndian>
+#include <QDebug>
+
+using namespace Utils;
+
+TelemetryRelay::TelemetryRelay(UAVObjectManager *objMngr, quint16 tcpPort, quint16 udpPort,
+                               int defaultRate, const QString &defaultFilter,
+                               const QHostAddress &multicastGroup, quint16 multicastPort) :
+    objMngr(objMngr),
+    tcpPort(tcpPort),
+    udpPort(udpPort),
+    defaultRate(defaultRate),
+    defaultFilter(defaultFilter),
+    multicastGroup(multicastGroup),
+    multicastPort(multicastPort),
+    multicastSequence(0),
+    tcpServer(NULL),
+    udpSocket(NULL),
+    multicastSocket(NULL),
+    flushTimer(NULL)
+{
+    moveToThread(Core::ICore::instance()->threadManager()->getLinkThread("TelemetryRelay"));
+    connect(this, SIGNAL(myStart()), this, SLOT(onStart()), Qt::QueuedConnection);
+    emit myStart();
+}
+
+TelemetryRelay::~TelemetryRelay()
+{
+    qDeleteAll(clients);
+}
+
+/**
+ * Creates the relay configured in the TelemetryRelay settings group, null
+ * when it is disabled. A port of 0 disables that transport, an empty
+ * MulticastGroup disables publishing.
+ */
+TelemetryRelay *TelemetryRelay::fromSettings(UAVObjectManager *objMngr)
+{
+    QSettings *settings = Core::ICore::instance()->settings();
+
+    settings->beginGroup(QLatin1String("TelemetryRelay"));
+    bool enabled    = settings->value(QLatin1String("Enabled"), false).toBool();
+    quint16 tcpPort = settings->value(QLatin1String("TcpPort"), 9100).toUInt();
+    quint16 udpPort = settings->value(QLatin1String("UdpPort"), 9100).toUInt();
+    int rate = settings->value(QLatin1String("DefaultRate"), 10).toInt();
+    QString filter  = settings->value(QLatin1String("DefaultFilter"), QString()).toString();
+    QHostAddress group(settings->value(QLatin1String("MulticastGroup"), QString()).toString());
+    quint16 groupPort = settings->value(QLatin1String("MulticastPort"), 9500).toUInt();
+    settings->endGroup();
+
+    if (!enabled) {
+        return NULL;
+    }
+    return new TelemetryRelay(objMngr, tcpPort, udpPort, rate, filter, group, groupPort);
+}
+
+void TelemetryRelay::onStart()
+{
+    clock.start();
+
+    if (tcpPort) {
+        tcpServer = new QTcpServer(this);
+        connect(tcpServer, SIGNAL(newConnection()), this, SLOT(newTcpClient()));
+        if (!tcpServer->listen(QHostAddress::Any, tcpPort)) {
+            qWarning() << "TelemetryRelay - cannot listen on TCP port" << tcpPort << tcpServer->errorString();
+        }
+    }
+    if (udpPort) {
+        udpSocket = new QUdpSocket(this);
+        connect(udpSocket, SIGNAL(readyRead()), this, SLOT(udpReadyRead()));
+        if (!udpSocket->bind(QHostAddress::Any, udpPort)) {
+            qWarning() << "TelemetryRelay - cannot bind UDP port" << udpPort << udpSocket->errorString();
+        }
+    }
+
+    if (!multicastGroup.isNull()) {
+        // send only, what receivers send back is never read
+        multicastSocket = new QUdpSocket(this);
+        multicastSocket->bind(QHostAddress::AnyIPv4, 0);
+        multicastSocket->setSocketOption(QAbstractSocket::MulticastTtlOption, 1);
+    }
+
+    flushTimer = new QTimer(this);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flushPending()));
+    flushTimer->start(FLUSH_PERIOD_MS);
+
+    QList< QList<UAVObject *> > objs = objMngr->getObjects();
+    foreach(QList<UAVObject *> instances, objs) {
+        foreach(UAVObject * obj, instances) {
+            connectObject(obj);
+        }
+    }
+    connect(objMngr, SIGNAL(newObject(UAVObject *)), this, SLOT(newObject(UAVObject *)));
+    connect(objMngr, SIGNAL(newInstance(UAVObject *)), this, SLOT(newObject(UAVObject *)));
+}
+
+void TelemetryRelay::connectObject(UAVObject *obj)
+{
+    // only what came from the vehicle, the relay does not echo the GCS
+    connect(obj, SIGNAL(objectUnpacked(UAVObject *)), this, SLOT(objectUnpacked(UAVObject *)));
+}
+
+void TelemetryRelay::newObject(UAVObject *obj)
+{
+    connectObject(obj);
+}
+
+bool TelemetryRelay::encode(UAVObject *obj, QByteArray & frame)
+{
+    qint32 length = obj->getNumBytes();
+
+    if (length >= MAX_PAYLOAD_LENGTH) {
+        return false;
+    }
+    frame.resize(HEADER_LENGTH + length + CHECKSUM_LENGTH);
+    quint8 *buf = (quint8 *)frame.data();
+    buf[0] = SYNC_VAL;
+    buf[1] = TYPE_OBJ;
+    qToLittleEndian<quint16>(HEADER_LENGTH + length, &buf[2]);
+    qToLittleEndian<quint32>(obj->getObjID(), &buf[4]);
+    qToLittleEndian<quint16>(obj->getInstID(), &buf[8]);
+    if (length > 0 && !obj->pack(&buf[HEADER_LENGTH])) {
+        return false;
+    }
+    buf[HEADER_LENGTH + length] = Crc::updateCRC(0, buf, HEADER_LENGTH + length);
+    return true;
+}
+
+bool TelemetryRelay::wants(Client *client, UAVObject *obj)
+{
+    QHash<UAVObject *, bool>::const_iterator match = client->matches.constFind(obj);
+
+    if (match != client->matches.constEnd()) {
+        return match.value();
+    }
+    bool wanted = client->filter.isEmpty() || client->filter.exactMatch(obj->getName());
+    client->matches.insert(obj, wanted);
+    return wanted;
+}
+
+void TelemetryRelay::send(Client *client, const QByteArray & frame)
+{
+    if (client->socket) {
+        if (client->socket->bytesToWrite() < MAX_BACKLOG_BYTES) {
+            client->socket->write(frame);
+        }
+    } else {
+        udpSocket->writeDatagram(frame, client->address, client->port);
+    }
+}
+
+void TelemetryRelay::objectUnpacked(UAVObject *obj)
+{
+    QByteArray frame;
+    bool encoded = false;
+    qint64 now   = clock.elapsed();
+
+    foreach(Client * client, clients) {
+        if (!wants(client, obj)) {
+            continue;
+        }
+        if (client->periodMs > 0 && now - client->lastSent.value(obj, -client->periodMs) < client->periodMs) {
+            // too soon for this client, it gets the latest value when its period is up
+            client->pending.insert(obj);
+            continue;
+        }
+        if (!encoded) {
+            if (!encode(obj, frame)) {
+                return;
+            }
+            encoded = true;
+        }
+        send(client, frame);
+        client->lastSent.insert(obj, now);
+        client->pending.remove(obj);
+    }
+    if (multicastSocket && (encoded || encode(obj, frame))) {
+        publish(frame);
+    }
+}
+
+void TelemetryRelay::publish(const QByteArray & frame)
+{
+    QByteArray datagram(2, 0);
+
+    qToLittleEndian<quint16>(multicastSequence++, (uchar *)datagram.data());
+    datagram.append(frame);
+    multicastSocket->writeDatagram(datagram, multicastGroup, multicastPort);
+}
+
+void TelemetryRelay::flushPending()
+{
+    qint64 now = clock.elapsed();
+    QHash<UAVObject *, QByteArray> frames;
+
+    foreach(Client * client, clients) {
+        if (!client->socket && now - client->lastSeen > CLIENT_TIMEOUT_MS) {
+            removeClient(client);
+            continue;
+        }
+        QSet<UAVObject *>::iterator it = client->pending.begin();
+        while (it != client->pending.end()) {
+            UAVObject *obj = *it;
+            if (now - client->lastSent.value(obj, 0) < client->periodMs) {
+                ++it;
+                continue;
+            }
+            // one frame per object for all the clients flushed now
+            QHash<UAVObject *, QByteArray>::iterator frame = frames.find(obj);
+            if (frame == frames.end()) {
+                frame = frames.insert(obj, QByteArray());
+                if (!encode(obj, frame.value())) {
+                    frame.value().clear();
+                }
+            }
+            if (!frame.value().isEmpty()) {
+                send(client, frame.value());
+            }
+            client->lastSent.insert(obj, now);
+            it = client->pending.erase(it);
+        }
+    }
+}
+
+void TelemetryRelay::newTcpClient()
+{
+    while (tcpServer->hasPendingConnections()) {
+        Client *client = new Client;
+        client->socket   = tcpServer->nextPendingConnection();
+        client->address  = client->socket->peerAddress();
+        client->port     = client->socket->peerPort();
+        client->lastSeen = clock.elapsed();
+        subscribe(client, QString("SUBSCRIBE %1 %2").arg(defaultRate).arg(defaultFilter));
+        clients.append(client);
+
+        connect(client->socket, SIGNAL(readyRead()), this, SLOT(tcpReadyRead()));
+        connect(client->socket, SIGNAL(disconnected()), this, SLOT(tcpDisconnected()));
+        qDebug() << "TelemetryRelay - TCP client" << client->address.toString() << client->port;
+    }
+}
+
+void TelemetryRelay::tcpReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+
+    foreach(Client * client, clients) {
+        if (client->socket == socket) {
+            client->input.append(socket->readAll());
+            processInput(client);
+            return;
+        }
+    }
+}
+
+void TelemetryRelay::tcpDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+
+    foreach(Client * client, clients) {
+        if (client->socket == socket) {
+            removeClient(client);
+            return;
+        }
+    }
+}
+
+void TelemetryRelay::udpReadyRead()
+{
+    while (udpSocket->hasPendingDatagrams()) {
+        QByteArray datagram;
+        QHostAddress address;
+        quint16 port;
+        datagram.resize(udpSocket->pendingDatagramSize());
+        udpSocket->readDatagram(datagram.data(), datagram.size(), &address, &port);
+
+        Client *client = NULL;
+        foreach(Client * known, clients) {
+            if (!known->socket && known->address == address && known->port == port) {
+                client = known;
+                break;
+            }
+        }
+        if (!client) {
+            if (!datagram.startsWith("SUBSCRIBE")) {
+                continue;
+            }
+            client = new Client;
+            client->socket  = NULL;
+            client->address = address;
+            client->port    = port;
+            clients.append(client);
+            qDebug() << "TelemetryRelay - UDP client" << address.toString() << port;
+        }
+        client->lastSeen = clock.elapsed();
+        // a datagram is a command of its own, no partial lines to keep
+        client->input    = datagram;
+        client->input.append('\n');
+        processInput(client);
+    }
+}
+
+void TelemetryRelay::processInput(Client *client)
+{
+    int end;
+
+    while ((end = client->input.indexOf('\n')) >= 0) {
+        QString command = QString::fromLatin1(client->input.left(end)).trimmed();
+        client->input.remove(0, end + 1);
+        if (command.startsWith(QLatin1String("SUBSCRIBE"))) {
+            subscribe(client, command);
+        }
+    }
+    // not a client of ours, do not let it grow the buffer
+    if (client->input.size() > MAX_COMMAND_LENGTH) {
+        client->input.clear();
+    }
+}
+
+void TelemetryRelay::subscribe(Client *client, const QString & command)
+{
+    QStringList args = command.split(QLatin1Char(' '), QString::SkipEmptyParts);
+    int rate = (args.size() > 1) ? qMax(0, args.at(1).toInt()) : defaultRate;
+
+    client->periodMs = rate > 0 ? 1000 / rate : 0;
+    client->filter   = QRegExp(args.size() > 2 ? args.at(2) : QString());
+    client->matches.clear();
+    client->pending.clear();
+}
+
+void TelemetryRelay::removeClient(Client *client)
+{
+    clients.removeOne(client);
+    if (client->socket) {
+        client->socket->disconnect(this);
+        client->socket->deleteLater();
+    }
+    delete client;
+}
+
+/**
+ * @}
+ * @}
+ */
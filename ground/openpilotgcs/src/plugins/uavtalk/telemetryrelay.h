@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ *
+ * @file       telemetryrelay.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Fans the object updates of the vehicle link out to local clients
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TELEMETRYRELAY_H
+#define TELEMETRYRELAY_H
+
+#include "uavobjectmanager.h"
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QRegExp>
+#include <QElapsedTimer>
+#include <QHostAddress>
+
+class QTcpServer;
+class QTcpSocket;
+class QUdpSocket;
+class QTimer;
+
+/**
+ * Forwards the objects unpacked from the vehicle link to any number of
+ * TCP and UDP clients as plain UAVTalk object frames. Each update is packed
+ * once whatever the number of clients, the vehicle link is not touched.
+ *
+ * A client tells what it wants with a text line, a UDP client also
+ * registers with it and has to repeat it within CLIENT_TIMEOUT_MS:
+ *   SUBSCRIBE <rate in Hz, 0 for every update> [object name regexp]
+ * Anything else a client sends is ignored, the relay is read only.
+ *
+ * Every update can also be published to a UDP multicast group, one frame
+ * per datagram after a 16 bit little endian sequence number, for the
+ * multicast mode of the IP connection.
+ */
+class TelemetryRelay : public QObject {
+    Q_OBJECT
+
+public:
+    TelemetryRelay(UAVObjectManager *objMngr, quint16 tcpPort, quint16 udpPort,
+                   int defaultRate, const QString &defaultFilter,
+                   const QHostAddress &multicastGroup = QHostAddress(), quint16 multicastPort = 0);
+    ~TelemetryRelay();
+
+    static TelemetryRelay *fromSettings(UAVObjectManager *objMngr);
+
+signals:
+    void myStart();
+
+private slots:
+    void onStart();
+    void newObject(UAVObject *obj);
+    void objectUnpacked(UAVObject *obj);
+    void newTcpClient();
+    void tcpReadyRead();
+    void tcpDisconnected();
+    void udpReadyRead();
+    void flushPending();
+
+private:
+    typedef struct {
+        QTcpSocket   *socket; // null for UDP clients
+        QHostAddress address;
+        quint16      port;
+        qint64 periodMs; // 0 for every update
+        QRegExp      filter;
+        QHash<UAVObject *, bool>   matches;
+        QHash<UAVObject *, qint64> lastSent;
+        QSet<UAVObject *> pending;
+        qint64       lastSeen;
+        QByteArray   input;
+    } Client;
+
+    // the object frames of UAVTalk, see uavtalk.h
+    static const int SYNC_VAL = 0x3C;
+    static const int TYPE_OBJ = 0x20;
+    static const int HEADER_LENGTH      = 10;
+    static const int CHECKSUM_LENGTH    = 1;
+    static const int MAX_PAYLOAD_LENGTH = 256;
+
+    static const int FLUSH_PERIOD_MS    = 20;
+    static const int CLIENT_TIMEOUT_MS  = 10000;
+    // a TCP client that falls this far behind loses updates until it catches up
+    static const int MAX_BACKLOG_BYTES  = 64 * 1024;
+    static const int MAX_COMMAND_LENGTH = 256;
+
+    UAVObjectManager *objMngr;
+    quint16 tcpPort;
+    quint16 udpPort;
+    int defaultRate;
+    QString defaultFilter;
+    QHostAddress multicastGroup;
+    quint16 multicastPort;
+    quint16 multicastSequence;
+    QTcpServer *tcpServer;
+    QUdpSocket *udpSocket;
+    QUdpSocket *multicastSocket;
+    QTimer *flushTimer;
+    QElapsedTimer clock;
+    QList<Client *> clients;
+
+    void connectObject(UAVObject *obj);
+    bool encode(UAVObject *obj, QByteArray & frame);
+    bool wants(Client *client, UAVObject *obj);
+    void send(Client *client, const QByteArray & frame);
+    void publish(const QByteArray & frame);
+    void processInput(Client *client);
+    void subscribe(Client *client, const QString & command);
+    void removeClient(Client *client);
+};
+
+#endif // TELEMETRYRELAY_H
@@ -0,0 +1,118 @@
+/**
+ ******************************************************************************
+ *
+ * @file       loopbackdevice.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief In memory telemetry link for the UAVTalk benchmark
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOOPBACKDEVICE_H
+#define LOOPBACKDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QPointer>
+
+/**
+ * One end of an in memory link. What is written to one end can be read from
+ * its peer. readyRead() is emitted from the event loop as a serial port does,
+ * so a reply is never processed inside the write of the request.
+ */
+class LoopbackDevice : public QIODevice {
+    Q_OBJECT
+
+public:
+    LoopbackDevice(QObject *parent = 0) : QIODevice(parent), rxOffset(0), notifyPending(false)
+    {
+        open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+    }
+
+    void setPeer(LoopbackDevice *device)
+    {
+        peer = device;
+    }
+
+    qint64 bytesAvailable() const
+    {
+        return rxBuffer.size() - rxOffset + QIODevice::bytesAvailable();
+    }
+
+    bool isSequential() const
+    {
+        return true;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize)
+    {
+        const qint64 length = qMin<qint64>(maxSize, rxBuffer.size() - rxOffset);
+
+        memcpy(data, rxBuffer.constData() + rxOffset, length);
+        // consumed bytes are dropped at once when the buffer runs empty, large
+        // writes would be moved around for every read otherwise
+        rxOffset += length;
+        if (rxOffset == rxBuffer.size()) {
+            rxBuffer.clear();
+            rxOffset = 0;
+        }
+        return length;
+    }
+
+    qint64 writeData(const char *data, qint64 size)
+    {
+        if (peer) {
+            peer->receive(data, size);
+        }
+        return size;
+    }
+
+private slots:
+    void notify()
+    {
+        notifyPending = false;
+        if (rxBuffer.size() > rxOffset) {
+            emit readyRead();
+        }
+    }
+
+private:
+    QPointer<LoopbackDevice> peer;
+    QByteArray rxBuffer;
+    qint64 rxOffset;
+    bool notifyPending;
+
+    void receive(const char *data, qint64 size)
+    {
+        rxBuffer.append(data, size);
+        if (!notifyPending) {
+            notifyPending = true;
+            QMetaObject::invokeMethod(this, "notify", Qt::QueuedConnection);
+        }
+    }
+};
+
+#endif // LOOPBACKDEVICE_H
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,363 @@
+/**
+ ******************************************************************************
+ *
+ * @file       main.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Headless throughput and latency benchmark of the GCS telemetry stack
+ *
+ * A GCS side UAVObjectManager, UAVTalk and Telemetry talk to a flight side
+ * UAVTalk over an in memory link:
+ * - decode: a stream of object packets, generated or read from an OPL log, is
+ *   pushed through the GCS side with a number of subscribers connected to
+ *   every object, giving packets/s, time and operator new calls per packet
+ * - ack: acked updates of one object sent by Telemetry, giving the time from
+ *   UAVObject::updated() to the transactionCompleted() signal
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "loopbackdevice.h"
+#include "uavtalk.h"
+#include "telemetry.h"
+#include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
+#include "uavdataobject.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QBuffer>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <QStringList>
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+// Every operator new of the process is counted, Qt containers use malloc and are not
+static QBasicAtomicInt allocationCount = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+void *operator new(std::size_t size)
+{
+    allocationCount.fetchAndAddRelaxed(1);
+    void *p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) throw()
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+    std::free(p);
+}
+
+/**
+ * Stands in for a gadget showing objects
+ */
+class Subscriber : public QObject {
+    Q_OBJECT
+
+public:
+    Subscriber() : updates(0) {}
+    quint64 updates;
+
+public slots:
+    void objectUpdated(UAVObject *obj)
+    {
+        Q_UNUSED(obj);
+        ++updates;
+    }
+};
+
+/**
+ * Ends the wait for the ack of an update
+ */
+class AckProbe : public QObject {
+    Q_OBJECT
+
+public:
+    AckProbe(QEventLoop *loop) : completed(false), loop(loop) {}
+    bool completed;
+
+public slots:
+    void transactionCompleted(UAVObject *obj, bool success)
+    {
+        Q_UNUSED(obj);
+        completed = success;
+        loop->quit();
+    }
+
+private:
+    QEventLoop *loop;
+};
+
+/**
+ * Both ends of the link, the GCS side is set up as TelemetryManager does
+ */
+struct Link {
+    UAVObjectManager gcsManager;
+    UAVObjectManager flightManager;
+    LoopbackDevice gcsDevice;
+    LoopbackDevice flightDevice;
+    UAVTalk *gcsTalk;
+    UAVTalk *flightTalk;
+    Telemetry *telemetry;
+
+    Link()
+    {
+        UAVObjectsInitialize(&gcsManager);
+        UAVObjectsInitialize(&flightManager);
+        gcsDevice.setPeer(&flightDevice);
+        flightDevice.setPeer(&gcsDevice);
+
+        gcsTalk    = new UAVTalk(&gcsDevice, &gcsManager);
+        flightTalk = new UAVTalk(&flightDevice, &flightManager);
+        QObject::connect(&gcsDevice, SIGNAL(readyRead()), gcsTalk, SLOT(processInputStream()));
+        QObject::connect(&flightDevice, SIGNAL(readyRead()), flightTalk, SLOT(processInputStream()));
+        telemetry  = new Telemetry(gcsTalk, &gcsManager);
+    }
+
+    ~Link()
+    {
+        delete telemetry;
+        delete gcsTalk;
+        delete flightTalk;
+    }
+
+    // run the event loop until both ends have read everything
+    void drain()
+    {
+        do {
+            QCoreApplication::processEvents();
+        } while (gcsDevice.bytesAvailable() > 0 || flightDevice.bytesAvailable() > 0);
+    }
+};
+
+static QTextStream out(stdout);
+
+/**
+ * Data objects of the flight side sent round robin, the first byte changes
+ * with every packet so they are not all identical
+ */
+static QByteArray generateStream(UAVObjectManager *manager, int packets)
+{
+    QBuffer buffer;
+
+    buffer.open(QIODevice::WriteOnly);
+    UAVTalk encoder(&buffer, manager);
+
+    QList<UAVObject *> objects;
+    foreach(QList<UAVDataObject *> instances, manager->getDataObjects()) {
+        // larger objects do not fit into one packet
+        if (instances.first()->getNumBytes() < 255) {
+            objects << instances.first();
+        }
+    }
+
+    QByteArray data;
+    for (int n = 0; n < packets && !objects.isEmpty(); ++n) {
+        UAVObject *obj   = objects.at(n % objects.size());
+        data.resize(obj->getNumBytes());
+        obj->pack((quint8 *)data.data());
+        if (data.size() > 0) {
+            data[0] = (char)n;
+        }
+        obj->unpack((const quint8 *)data.constData());
+        encoder.sendObject(obj, false, false);
+    }
+    return buffer.data();
+}
+
+/**
+ * Payloads of the records of an OPL log: timestamp (4), size (8), data
+ */
+static QByteArray readLog(const QString &fileName)
+{
+    QFile file(fileName);
+    QByteArray stream;
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        out << "cannot open " << fileName << endl;
+        return stream;
+    }
+
+    quint32 timeStamp;
+    qint64 dataSize;
+    while (file.read((char *)&timeStamp, sizeof(timeStamp)) == sizeof(timeStamp)
+           && file.read((char *)&dataSize, sizeof(dataSize)) == sizeof(dataSize)) {
+        if (dataSize < 1 || dataSize > (1024 * 1024)) {
+            out << "corrupted log, stopped after " << stream.size() << " bytes" << endl;
+            break;
+        }
+        stream.append(file.read(dataSize));
+    }
+    return stream;
+}
+
+static void runDecode(Link &link, const QByteArray &stream, int subscribers)
+{
+    // connected like the gadgets, to every instance of every object
+    QList<Subscriber *> subscriberList;
+    for (int n = 0; n < subscribers; ++n) {
+        subscriberList << new Subscriber();
+        foreach(QList<UAVObject *> instances, link.gcsManager.getObjects()) {
+            foreach(UAVObject * obj, instances) {
+                QObject::connect(obj, SIGNAL(objectUpdated(UAVObject *)), subscriberList.last(), SLOT(objectUpdated(UAVObject *)));
+            }
+        }
+    }
+
+    link.drain();
+    link.gcsTalk->resetStats();
+    const int allocationsBefore = allocationCount.load();
+
+    QElapsedTimer timer;
+    timer.start();
+    link.flightDevice.write(stream);
+    link.drain();
+    const qint64 elapsed = timer.nsecsElapsed();
+
+    const int allocations = allocationCount.load() - allocationsBefore;
+    const UAVTalk::ComStats stats = link.gcsTalk->getStats();
+    const double packets  = qMax<quint32>(stats.rxObjects, 1);
+
+    quint64 updates = 0;
+    foreach(Subscriber * subscriber, subscriberList) {
+        updates += subscriber->updates;
+    }
+    qDeleteAll(subscriberList);
+
+    out << qSetFieldWidth(12) << subscribers
+        << stats.rxObjects
+        << (quint64)(stats.rxObjects * 1e9 / qMax<qint64>(elapsed, 1))
+        << QString::number(elapsed / packets, 'f', 0)
+        << QString::number(allocations / packets, 'f', 2)
+        << updates
+        << stats.rxErrors + stats.rxCrcErrors
+        << qSetFieldWidth(0) << endl;
+}
+
+static void runAck(Link &link, const QString &objectName, int count)
+{
+    UAVObject *obj = link.gcsManager.getObject(objectName);
+
+    if (!obj) {
+        out << "unknown object " << objectName << endl;
+        return;
+    }
+
+    UAVObject::Metadata metadata = obj->getMetadata();
+    UAVObject::SetGcsTelemetryAcked(metadata, true);
+    UAVObject::SetGcsTelemetryUpdateMode(metadata, UAVObject::UPDATEMODE_MANUAL);
+    obj->setMetadata(metadata);
+    link.drain();
+
+    QEventLoop loop;
+    QTimer timeout;
+    AckProbe probe(&loop);
+    timeout.setSingleShot(true);
+    QObject::connect(&timeout, SIGNAL(timeout()), &loop, SLOT(quit()));
+    QObject::connect(obj, SIGNAL(transactionCompleted(UAVObject *, bool)), &probe, SLOT(transactionCompleted(UAVObject *, bool)));
+
+    QVector<qint64> latency;
+    int failed = 0;
+    const int allocationsBefore = allocationCount.load();
+    QElapsedTimer timer;
+    for (int n = 0; n < count; ++n) {
+        probe.completed = false;
+        timeout.start(1000);
+        timer.start();
+        obj->updated();
+        loop.exec();
+        if (probe.completed) {
+            latency << timer.nsecsElapsed();
+        } else {
+            ++failed;
+        }
+    }
+    const int allocations = allocationCount.load() - allocationsBefore;
+
+    if (latency.isEmpty()) {
+        out << "no acked update completed" << endl;
+        return;
+    }
+    std::sort(latency.begin(), latency.end());
+    out << qSetFieldWidth(12) << latency.size() << failed
+        << QString::number(latency.first() / 1e3, 'f', 1)
+        << QString::number(latency.at(latency.size() / 2) / 1e3, 'f', 1)
+        << QString::number(latency.at(latency.size() * 99 / 100) / 1e3, 'f', 1)
+        << QString::number(latency.last() / 1e3, 'f', 1)
+        << QString::number((double)allocations / count, 'f', 1)
+        << qSetFieldWidth(0) << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+
+    parser.setApplicationDescription("UAVTalk and Telemetry benchmark over an in memory link");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("packets", "Packets of the generated stream.", "n", "100000"));
+    parser.addOption(QCommandLineOption("log", "Replay the telemetry of an OPL log instead.", "file"));
+    parser.addOption(QCommandLineOption("subscribers", "Comma separated subscriber counts to run the decode with.", "list", "0,1,4,16"));
+    parser.addOption(QCommandLineOption("acks", "Acked updates to time.", "n", "1000"));
+    parser.addOption(QCommandLineOption("object", "Object of the acked updates.", "name", "GCSReceiver"));
+    parser.process(app);
+
+    Link link;
+
+    const QByteArray stream = parser.isSet("log") ? readLog(parser.value("log")) :
+                              generateStream(&link.flightManager, parser.value("packets").toInt());
+    out << "decode of " << stream.size() << " bytes" << endl;
+    out << qSetFieldWidth(12) << "subscribers" << "packets" << "packets/s" << "ns/packet" << "new/packet" << "updates" << "errors" << qSetFieldWidth(0) << endl;
+    foreach(QString subscribers, parser.value("subscribers").split(',', QString::SkipEmptyParts)) {
+        runDecode(link, stream, subscribers.toInt());
+    }
+
+    out << endl << "acked updates of " << parser.value("object") << ", latency in us" << endl;
+    out << qSetFieldWidth(12) << "completed" << "failed" << "min" << "median" << "99%" << "max" << "new/update" << qSetFieldWidth(0) << endl;
+    runAck(link, parser.value("object"), parser.value("acks").toInt());
+
+    return 0;
+}
+
+#include "main.moc"
+
+/**
+ * @}
+ * @}
+ */
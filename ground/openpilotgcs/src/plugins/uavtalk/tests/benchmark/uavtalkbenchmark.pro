@@ -0,0 +1,45 @@
+# Headless benchmark of UAVTalk and Telemetry, not part of the GCS build.
+# Build it against a GCS build tree after the GCS, e.g.:
+#   mkdir build/uavtalkbenchmark && cd build/uavtalkbenchmark
+#   qmake GCS_BUILD_TREE=<root>/build/openpilotgcs_release <root>/ground/openpilotgcs/src/plugins/uavtalk/tests/benchmark/uavtalkbenchmark.pro
+#   make && ../openpilotgcs_release/bin/uavtalkbenchmark --help
+
+TEMPLATE = app
+TARGET = uavtalkbenchmark
+
+QT += network
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+
+include(../../../../../openpilotgcs.pri)
+
+DESTDIR = $$GCS_APP_PATH
+
+# the plugin classes are built in, the libraries only export a part of them
+DEFINES += UAVTALK_LIBRARY
+
+INCLUDEPATH += ../.. $$GCS_SOURCE_TREE/src/plugins
+LIBS += -L$$GCS_PLUGIN_PATH/OpenPilot
+
+include(../../uavtalk_dependencies.pri)
+
+HEADERS += \
+    ../../uavtalk.h \
+    ../../vehicleclock.h \
+    ../../telemetry.h \
+    loopbackdevice.h
+
+SOURCES += \
+    ../../uavtalk.cpp \
+    ../../vehicleclock.cpp \
+    ../../telemetry.cpp \
+    $$UAVOBJECT_SYNTHETICS/uavobjectsinit.cpp \
+    main.cpp
+
+linux-* {
+    QMAKE_RPATHDIR = \'\$$ORIGIN\'/$$relative_path($$GCS_LIBRARY_PATH, $$DESTDIR)
+    QMAKE_RPATHDIR += \'\$$ORIGIN\'/$$relative_path($$GCS_PLUGIN_PATH/OpenPilot, $$DESTDIR)
+    QMAKE_RPATHDIR += \'\$$ORIGIN\'/$$relative_path($$GCS_QT_LIBRARY_PATH, $$DESTDIR)
+    include(../../../../rpath.pri)
+}
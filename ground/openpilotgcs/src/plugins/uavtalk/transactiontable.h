@@ -0,0 +1,198 @@
+/**
+ ******************************************************************************
+ *
+ * @file       transactiontable.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2014.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief The UAVTalk protocol plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef TRANSACTIONTABLE_H
+#define TRANSACTIONTABLE_H
+
+#include <QtGlobal>
+#include <QVector>
+
+/**
+ * Flat open addressing (linear probing) table holding the pending transactions.
+ * Entries are keyed by object ID and instance ID and are stored inline, so
+ * opening and closing transactions does not allocate once the table has grown
+ * to the number of concurrent transactions.
+ *
+ * Pointers returned by find() and insert() are only valid until the next insert().
+ */
+template<typename T> class TransactionTable {
+public:
+    TransactionTable(int initialCapacity = 64) : used(0), deleted(0)
+    {
+        int capacity = 8;
+
+        while (capacity < initialCapacity) {
+            capacity <<= 1;
+        }
+        buckets.resize(capacity);
+    }
+
+    T *find(quint32 objId, quint16 instId)
+    {
+        int index = findIndex(makeKey(objId, instId));
+
+        return (index >= 0) ? &buckets[index].value : NULL;
+    }
+
+    T *insert(quint32 objId, quint16 instId, const T & value)
+    {
+        quint64 key = makeKey(objId, instId);
+        int index   = findIndex(key);
+
+        if (index < 0) {
+            // Keep the load (including deleted entries) below 3/4
+            if ((used + deleted + 1) * 4 > buckets.size() * 3) {
+                rehash((used + 1) * 2 > buckets.size() ? buckets.size() * 2 : buckets.size());
+            }
+            int mask = buckets.size() - 1;
+            index = hash(key) & mask;
+            while (buckets[index].state == BUCKET_USED) {
+                index = (index + 1) & mask;
+            }
+            if (buckets[index].state == BUCKET_DELETED) {
+                --deleted;
+            }
+            ++used;
+            buckets[index].key   = key;
+            buckets[index].state = BUCKET_USED;
+        }
+        buckets[index].value = value;
+        return &buckets[index].value;
+    }
+
+    bool remove(quint32 objId, quint16 instId)
+    {
+        int index = findIndex(makeKey(objId, instId));
+
+        if (index < 0) {
+            return false;
+        }
+        buckets[index].state = BUCKET_DELETED;
+        buckets[index].value = T();
+        --used;
+        ++deleted;
+        return true;
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < buckets.size(); ++i) {
+            buckets[i].state = BUCKET_EMPTY;
+            buckets[i].value = T();
+        }
+        used    = 0;
+        deleted = 0;
+    }
+
+    int count() const
+    {
+        return used;
+    }
+
+    // Iteration over the raw buckets, use isUsed() to skip the free ones
+    int capacity() const
+    {
+        return buckets.size();
+    }
+
+    bool isUsed(int index) const
+    {
+        return buckets[index].state == BUCKET_USED;
+    }
+
+    T & valueAt(int index)
+    {
+        return buckets[index].value;
+    }
+
+private:
+    enum { BUCKET_EMPTY = 0, BUCKET_USED, BUCKET_DELETED };
+
+    struct Bucket {
+        Bucket() : key(0), state(BUCKET_EMPTY), value() {}
+        quint64 key;
+        quint8  state;
+        T value;
+    };
+
+    QVector<Bucket> buckets;
+    int used;
+    int deleted;
+
+    static quint64 makeKey(quint32 objId, quint16 instId)
+    {
+        return ((quint64)objId << 16) | instId;
+    }
+
+    static int hash(quint64 key)
+    {
+        // 64 bit mix (finalizer of MurmurHash3)
+        key ^= key >> 33;
+        key *= Q_UINT64_C(0xff51afd7ed558ccd);
+        key ^= key >> 33;
+        return (int)(key & 0x7fffffff);
+    }
+
+    int findIndex(quint64 key) const
+    {
+        int mask = buckets.size() - 1;
+        int i    = hash(key) & mask;
+
+        for (int probe = 0; probe < buckets.size(); ++probe) {
+            const Bucket &bucket = buckets.at(i);
+            if (bucket.state == BUCKET_EMPTY) {
+                return -1;
+            }
+            if (bucket.state == BUCKET_USED && bucket.key == key) {
+                return i;
+            }
+            i = (i + 1) & mask;
+        }
+        return -1;
+    }
+
+    void rehash(int capacity)
+    {
+        QVector<Bucket> old = buckets;
+
+        buckets.fill(Bucket(), capacity);
+        used    = 0;
+        deleted = 0;
+        int mask = capacity - 1;
+        for (int n = 0; n < old.size(); ++n) {
+            if (old.at(n).state == BUCKET_USED) {
+                int i = hash(old.at(n).key) & mask;
+                while (buckets[i].state != BUCKET_EMPTY) {
+                    i = (i + 1) & mask;
+                }
+                buckets[i] = old.at(n);
+                ++used;
+            }
+        }
+    }
+};
+
+#endif // TRANSACTIONTABLE_H
@@ -32,6 +32,7 @@
 #include <QtEndian>
 #include <QDebug>
 #include <QEventLoop>
+#include <QThread>
 
 #ifdef VERBOSE_UAVTALK
 // uncomment and adapt the following lines to filter verbose logging to include specific object(s) only
@@ -48,17 +49,27 @@ using namespace Utils;
 
 /**
  * Constructor
+ * The instance must live in the thread of the device, sendObject() and
+ * sendObjectRequest() can be called from any thread.
  */
 UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr) : io(iodev), objMngr(objMngr), mutex(QMutex::Recursive)
 {
     rxState = STATE_SYNC;
     rxPacketLength = 0;
+    rxTimestampLength = 0;
+    rxTimestamp    = 0;
+    rxTimestamped  = false;
+    rxVehicleTime  = 0;
+    sendTimestamps = false;
+    txFlushPending = false;
+    txBacklog = 0;
 
     memset(&stats, 0, sizeof(ComStats));
 
+    // there are no settings when running outside of the GCS, e.g. in the benchmark
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    Core::Internal::GeneralSettings *settings = pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror = settings->useUDPMirror();
+    Core::Internal::GeneralSettings *settings = pm ? pm->getObject<Core::Internal::GeneralSettings>() : NULL;
+    useUDPMirror = settings && settings->useUDPMirror();
     qDebug() << "USE UDP:::::::::::." << useUDPMirror;
     if (useUDPMirror) {
         udpSocketTx = new QUdpSocket(this);
@@ -68,6 +79,8 @@ UAVTalk::UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr) : io(iodev), objMn
         connect(udpSocketTx, SIGNAL(readyRead()), this, SLOT(dummyUDPRead()));
         connect(udpSocketRx, SIGNAL(readyRead()), this, SLOT(dummyUDPRead()));
     }
+    // keeps the backlog seen by other threads current
+    connect(io, SIGNAL(bytesWritten(qint64)), this, SLOT(flushOutput()));
 }
 
 UAVTalk::~UAVTalk()
@@ -86,6 +99,7 @@ void UAVTalk::resetStats()
     QMutexLocker locker(&mutex);
 
     memset(&stats, 0, sizeof(ComStats));
+    objectStats.clear();
 }
 
 /**
@@ -98,6 +112,30 @@ UAVTalk::ComStats UAVTalk::getStats()
     return stats;
 }
 
+/**
+ * Get the per object statistics counters
+ */
+QHash<quint32, UAVTalk::ObjectStats> UAVTalk::getObjectStats()
+{
+    QMutexLocker locker(&mutex);
+
+    return objectStats;
+}
+
+/**
+ * Counters of an object, zeroed when it is first seen
+ */
+UAVTalk::ObjectStats &UAVTalk::objectStatsOf(quint32 objId)
+{
+    QHash<quint32, ObjectStats>::iterator it = objectStats.find(objId);
+    if (it == objectStats.end()) {
+        ObjectStats zero;
+        memset(&zero, 0, sizeof(ObjectStats));
+        it = objectStats.insert(objId, zero);
+    }
+    return it.value();
+}
+
 void UAVTalk::dummyUDPRead()
 {
     QUdpSocket *socket = qobject_cast<QUdpSocket *>(sender());
@@ -109,6 +147,17 @@ void UAVTalk::dummyUDPRead()
     }
 }
 
+/**
+ * Send the objects that carry a board time as timestamped frames. The logging
+ * connection does it so the logs keep the board time of the updates.
+ */
+void UAVTalk::setSendTimestamps(bool enable)
+{
+    QMutexLocker locker(&mutex);
+
+    sendTimestamps = enable;
+}
+
 /**
  * Send the specified object through the telemetry link.
  * \param[in] obj Object to send
@@ -208,36 +257,222 @@ bool UAVTalk::objectTransaction(quint8 type, quint32 objId, quint16 instId, UAVO
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
+        // read straight into a stack buffer and parse from there, this stays
+        // safe if a slot called while parsing spins a nested event loop
+        quint8 inputChunk[INPUT_CHUNK_LENGTH];
         while (io->bytesAvailable() > 0) {
-            int ret = io->read((char *)&tmp, 1);
-            if (ret != -1) {
-                processInputByte(tmp);
-            } else {
-                // TODOD
+            qint64 length = io->read((char *)inputChunk, INPUT_CHUNK_LENGTH);
+            if (length <= 0) {
+                break;
             }
+            processInputBuffer(inputChunk, length);
+        }
+    }
+}
+
+/**
+ * Write the queued frames, runs in the thread of the device
+ */
+void UAVTalk::flushOutput()
+{
+    QMutexLocker locker(&mutex);
+
+    txFlushPending = false;
+    if (io.isNull()) {
+        txQueue.clear();
+        return;
+    }
+    if (!txQueue.isEmpty()) {
+        io->write(txQueue);
+        if (useUDPMirror) {
+            udpSocketRx->writeDatagram(txQueue, QHostAddress::LocalHost, udpSocketTx->localPort());
+        }
+        txQueue.clear();
+    }
+    txBacklog = io->bytesToWrite();
+}
+
+/**
+ * Process a chunk of bytes from the telemetry stream.
+ * Sync bytes are searched for in the whole chunk and complete frames are validated
+ * and dispatched straight from the chunk. Only frames split across two chunks go
+ * through the byte oriented state machine.
+ * \param[in] buffer Received bytes
+ * \param[in] length Number of bytes in the buffer
+ */
+void UAVTalk::processInputBuffer(const quint8 *buffer, qint32 length)
+{
+    qint32 pos = 0;
+
+    while (pos < length) {
+        if (rxState != STATE_SYNC && rxState != STATE_COMPLETE && rxState != STATE_ERROR) {
+            // A frame is in progress, finish it with the byte parser
+            processInputByte(buffer[pos++]);
             if (rxState == STATE_COMPLETE) {
-                mutex.lock();
-                if (receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength)) {
-                    stats.rxObjectBytes += rxLength;
-                    stats.rxObjects++;
-                } else {
-                    // TODO...
-                }
-                mutex.unlock();
+                processReceivedObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength, rxTimestampLength, rxTimestamp);
 
                 if (useUDPMirror) {
-                    // it is safe to do this outside of the above critical section as the rxDataArray is
+                    // it is safe to do this outside of the critical section as the rxDataArray is
                     // accessed from this thread only
                     udpSocketTx->writeDatagram(rxDataArray, QHostAddress::LocalHost, udpSocketRx->localPort());
                 }
             }
+            continue;
+        }
+
+        // Look for the next sync byte
+        const quint8 *sync = (const quint8 *)memchr(&buffer[pos], SYNC_VAL, length - pos);
+        qint32 skipped     = (sync != NULL) ? (qint32)(sync - &buffer[pos]) : (length - pos);
+        stats.rxBytes      += skipped;
+        stats.rxSyncErrors += skipped;
+        pos += skipped;
+        if (sync == NULL) {
+            break;
+        }
+
+        qint32 frameLength = processInputFrame(&buffer[pos], length - pos);
+        if (frameLength > 0) {
+            pos += frameLength;
+        } else if (frameLength == 0) {
+            // Incomplete frame, the byte parser keeps the state until the next chunk arrives
+            processInputByte(buffer[pos++]);
+        } else {
+            // Invalid frame, skip the sync byte and resynchronize
+            stats.rxBytes++;
+            pos++;
         }
     }
 }
 
+/**
+ * Validate and dispatch a complete frame starting with a sync byte.
+ * \param[in] frame Pointer to the sync byte of the frame
+ * \param[in] length Number of bytes available from the sync byte on
+ * \return The frame length when it was processed, 0 if more bytes are needed
+ * and -1 if the frame is invalid
+ */
+qint32 UAVTalk::processInputFrame(const quint8 *frame, qint32 length)
+{
+    if (length < 2) {
+        return 0;
+    }
+
+    // Only the object frames carry a board time stamp
+    quint8 type = frame[1] & ~TIMESTAMPED;
+    qint32 timestampLength = (frame[1] & TIMESTAMPED) ? TIMESTAMP_LENGTH : 0;
+    if ((type & TYPE_MASK) != TYPE_VER || (timestampLength > 0 && type != TYPE_OBJ && type != TYPE_OBJ_ACK)) {
+        qWarning() << "UAVTalk - error : bad type";
+        stats.rxErrors++;
+        return -1;
+    }
+
+    if (length < HEADER_LENGTH + timestampLength) {
+        return 0;
+    }
+
+    qint32 packetSize = qFromLittleEndian<quint16>(&frame[2]);
+    if (packetSize < HEADER_LENGTH + timestampLength || packetSize > HEADER_LENGTH + timestampLength + MAX_PAYLOAD_LENGTH) {
+        // incorrect packet size
+        qWarning() << "UAVTalk - error : incorrect packet size";
+        stats.rxErrors++;
+        return -1;
+    }
+
+    quint32 objId  = qFromLittleEndian<quint32>(&frame[4]);
+    quint16 instId = qFromLittleEndian<quint16>(&frame[8]);
+    quint16 timestamp = (timestampLength > 0) ? qFromLittleEndian<quint16>(&frame[HEADER_LENGTH]) : 0;
+
+    // Search for object, multi-object frames do not carry one in the header
+    UAVObject *obj = (type != TYPE_OBJ_MULTI) ? objMngr->getObject(objId) : NULL;
+    if (obj == NULL && type != TYPE_OBJ_REQ && type != TYPE_OBJ_MULTI) {
+        qWarning() << "UAVTalk - error : unknown object" << objId;
+        stats.rxErrors++;
+        return -1;
+    }
+
+    // Determine data length, delta frames are shorter than their object
+    qint32 dataLength;
+    if (type == TYPE_OBJ_REQ || type == TYPE_ACK || type == TYPE_NACK) {
+        dataLength = 0;
+    } else if (obj && type != TYPE_OBJ_DELTA) {
+        dataLength = obj->getNumBytes();
+    } else {
+        dataLength = packetSize - HEADER_LENGTH - timestampLength;
+    }
+
+    if (dataLength >= MAX_PAYLOAD_LENGTH) {
+        // packet error - exceeded payload max length
+        qWarning() << "UAVTalk - error : exceeded payload max length" << objId;
+        stats.rxErrors++;
+        return -1;
+    }
+
+    if (HEADER_LENGTH + timestampLength + dataLength != packetSize) {
+        // packet error - mismatched packet size
+        qWarning() << "UAVTalk - error : mismatched packet size" << objId;
+        stats.rxErrors++;
+        return -1;
+    }
+
+    if (length < packetSize + CHECKSUM_LENGTH) {
+        return 0;
+    }
+
+    // Check the CRC over the header and the payload in one go
+    if (Crc::updateCRC(0, frame, packetSize) != frame[packetSize]) {
+        // packet error - faulty CRC
+        qWarning() << "UAVTalk - error : failed CRC check" << objId;
+        stats.rxCrcErrors++;
+        return -1;
+    }
+
+    stats.rxBytes += packetSize + CHECKSUM_LENGTH;
+
+    // The payload is unpacked straight from the input buffer
+    processReceivedObject(type, objId, instId, &frame[HEADER_LENGTH + timestampLength], dataLength, timestampLength, timestamp);
+
+    if (useUDPMirror) {
+        udpSocketTx->writeDatagram((const char *)frame, packetSize + CHECKSUM_LENGTH, QHostAddress::LocalHost, udpSocketRx->localPort());
+    }
+
+    return packetSize + CHECKSUM_LENGTH;
+}
+
+/**
+ * Hand a complete received message over to receiveObject() and update the statistics.
+ * The board time of a timestamped message is unwrapped first, the object is
+ * stamped with it before it is unpacked.
+ */
+void UAVTalk::processReceivedObject(quint8 type, quint32 objId, quint16 instId, const quint8 *data, qint32 length,
+                                    qint32 timestampLength, quint16 timestamp)
+{
+    QMutexLocker locker(&mutex);
+
+    rxTimestamped = (timestampLength > 0);
+    if (rxTimestamped) {
+        rxVehicleTime = clock.update(timestamp);
+        stats.rxTimestampedObjects++;
+        stats.rxTimestampDelay = clock.lastDelay();
+    }
+
+    bool received = receiveObject(type, objId, instId, data, length);
+    rxTimestamped = false;
+
+    if (received) {
+        // multi-object frames count their objects themselves
+        if (type != TYPE_OBJ_MULTI) {
+            stats.rxObjectBytes += length;
+            stats.rxObjects++;
+            ObjectStats &objStats = objectStatsOf(objId);
+            objStats.rxBytes += HEADER_LENGTH + timestampLength + length + CHECKSUM_LENGTH;
+            objStats.rxObjects++;
+        }
+    } else {
+        // TODO...
+    }
+}
+
 /**
  * Process an byte from the telemetry stream.
  * \param[in] rxbyte Received byte
@@ -289,15 +524,16 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
         // Update CRC
         rxCS = Crc::updateCRC(rxCS, rxbyte);
 
-        if ((rxbyte & TYPE_MASK) != TYPE_VER) {
+        // Only the object frames carry a board time stamp
+        rxType = rxbyte & ~TIMESTAMPED;
+        rxTimestampLength = (rxbyte & TIMESTAMPED) ? TIMESTAMP_LENGTH : 0;
+        if ((rxType & TYPE_MASK) != TYPE_VER || (rxTimestampLength > 0 && rxType != TYPE_OBJ && rxType != TYPE_OBJ_ACK)) {
             qWarning() << "UAVTalk - error : bad type";
             stats.rxErrors++;
             rxState = STATE_ERROR;
             break;
         }
 
-        rxType     = rxbyte;
-
         packetSize = 0;
 
         rxState    = STATE_SIZE;
@@ -317,7 +553,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
         rxCount     = 0;
 
 
-        if (packetSize < HEADER_LENGTH || packetSize > HEADER_LENGTH + MAX_PAYLOAD_LENGTH) {
+        if (packetSize < HEADER_LENGTH + rxTimestampLength || packetSize > HEADER_LENGTH + rxTimestampLength + MAX_PAYLOAD_LENGTH) {
             // incorrect packet size
             qWarning() << "UAVTalk - error : incorrect packet size";
             stats.rxErrors++;
@@ -361,8 +597,8 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
 
         // Search for object, if not found reset state machine
         {
-            UAVObject *rxObj = objMngr->getObject(rxObjId);
-            if (rxObj == NULL && rxType != TYPE_OBJ_REQ) {
+            UAVObject *rxObj = (rxType != TYPE_OBJ_MULTI) ? objMngr->getObject(rxObjId) : NULL;
+            if (rxObj == NULL && rxType != TYPE_OBJ_REQ && rxType != TYPE_OBJ_MULTI) {
                 qWarning() << "UAVTalk - error : unknown object" << rxObjId;
                 stats.rxErrors++;
                 rxState = STATE_ERROR;
@@ -373,10 +609,10 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
             if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK) {
                 rxLength = 0;
             } else {
-                if (rxObj) {
+                if (rxObj && rxType != TYPE_OBJ_DELTA) {
                     rxLength = rxObj->getNumBytes();
                 } else {
-                    rxLength = packetSize - rxPacketLength;
+                    rxLength = packetSize - rxPacketLength - rxTimestampLength;
                 }
             }
 
@@ -390,7 +626,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
             }
 
             // Check the lengths match
-            if ((rxPacketLength + rxLength) != packetSize) {
+            if ((rxPacketLength + rxTimestampLength + rxLength) != packetSize) {
                 // packet error - mismatched packet size
                 qWarning() << "UAVTalk - error : mismatched packet size" << rxObjId;
                 stats.rxErrors++;
@@ -399,6 +635,29 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
             }
         }
 
+        // Get the time stamp if there is one, then the payload if there is one, otherwise receive checksum
+        if (rxTimestampLength > 0) {
+            rxState = STATE_TIMESTAMP;
+        } else if (rxLength > 0) {
+            rxState = STATE_DATA;
+        } else {
+            rxState = STATE_CS;
+        }
+        break;
+
+    case STATE_TIMESTAMP:
+
+        // Update CRC
+        rxCS = Crc::updateCRC(rxCS, rxbyte);
+
+        rxTmpBuffer[rxCount++] = rxbyte;
+        if (rxCount < TIMESTAMP_LENGTH) {
+            break;
+        }
+        rxCount     = 0;
+
+        rxTimestamp = qFromLittleEndian<quint16>(rxTmpBuffer);
+
         // If there is a payload get it, otherwise receive checksum
         if (rxLength > 0) {
             rxState = STATE_DATA;
@@ -472,7 +731,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
  * \param[in] length Buffer length
  * \return Success (true), Failure (false)
  */
-bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length)
+bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8 *data, qint32 length)
 {
     Q_UNUSED(length);
 
@@ -584,6 +843,20 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *
         }
         break;
 
+    case TYPE_OBJ_MULTI:
+        // Several objects sent by the flight side in one frame, the instance ID holds their number
+        error = !receiveMultiObject(data, length);
+        break;
+
+    case TYPE_OBJ_DELTA:
+        // Changes since the previous frame of the object, a lost frame is not an error
+        if (!allInstances) {
+            error = !receiveDeltaObject(objId, instId, data, length);
+        } else {
+            error = true;
+        }
+        break;
+
     default:
         error = true;
     }
@@ -594,12 +867,156 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *
     return !error;
 }
 
+/**
+ * Receive the objects of a multi-object frame, each one is handled as a TYPE_OBJ message.
+ * Every entry carries its data length so unknown objects are skipped without losing the others.
+ * \param[in] data Payload of the frame
+ * \param[in] length Payload length
+ * \return Success (true), Failure (false) if any of the objects could not be received
+ */
+bool UAVTalk::receiveMultiObject(const quint8 *data, qint32 length)
+{
+    bool error = false;
+    qint32 pos = 0;
+
+    while (pos + MULTI_ENTRY_HEADER_LENGTH <= length) {
+        quint32 objId      = qFromLittleEndian<quint32>(&data[pos]);
+        quint16 instId     = qFromLittleEndian<quint16>(&data[pos + 4]);
+        qint32 dataLength  = data[pos + 6];
+        pos += MULTI_ENTRY_HEADER_LENGTH;
+        if (pos + dataLength > length) {
+            break;
+        }
+
+        UAVObject *obj = objMngr->getObject(objId);
+        if (obj == NULL || (qint32)obj->getNumBytes() != dataLength) {
+            qWarning() << "UAVTalk - error : unknown object in multi-object frame" << objId;
+            error = true;
+        } else if (receiveObject(TYPE_OBJ, objId, instId, &data[pos], dataLength)) {
+            stats.rxObjectBytes += dataLength;
+            stats.rxObjects++;
+            ObjectStats &objStats = objectStatsOf(objId);
+            objStats.rxBytes += MULTI_ENTRY_HEADER_LENGTH + dataLength;
+            objStats.rxObjects++;
+        } else {
+            error = true;
+        }
+        pos += dataLength;
+    }
+
+    if (pos != length) {
+        qWarning() << "UAVTalk - error : truncated multi-object frame";
+        error = true;
+    }
+    return !error;
+}
+
+/**
+ * Receive a delta frame and update the object from the previous frame of this instance.
+ * Deltas are only applied in sequence within the epoch of the last key frame. After a lost
+ * frame, or before the first key frame, they are dropped and a key frame is requested.
+ * \param[in] objId Object ID
+ * \param[in] instId Instance ID
+ * \param[in] data Payload of the frame
+ * \param[in] length Payload length
+ * \return Success (true), Failure (false) on a malformed frame
+ */
+bool UAVTalk::receiveDeltaObject(quint32 objId, quint16 instId, const quint8 *data, qint32 length)
+{
+    UAVObject *obj = objMngr->getObject(objId);
+
+    if (obj == NULL) {
+        return false;
+    }
+    qint32 numBytes   = obj->getNumBytes();
+    qint32 numChunks  = (numBytes + DELTA_CHUNK_LENGTH - 1) / DELTA_CHUNK_LENGTH;
+    qint32 maskLength = (numChunks + 7) / 8;
+    if (length < DELTA_HEADER_LENGTH + maskLength) {
+        return false;
+    }
+
+    DeltaImage *delta = deltaMap.find(objId, instId);
+    if (delta == NULL) {
+        DeltaImage init;
+        init.epoch = 0;
+        init.seq   = 0;
+        init.valid = false;
+        init.keyFrameRequested = false;
+        delta = deltaMap.insert(objId, instId, init);
+    }
+    quint8 epoch  = data[0];
+    quint8 seq    = data[1];
+    bool keyFrame = (seq == 0);
+    const quint8 *mask = &data[DELTA_HEADER_LENGTH];
+    if (keyFrame) {
+        for (qint32 n = 0; n < numChunks; ++n) {
+            if (!(mask[n / 8] & (1 << (n % 8)))) {
+                delta->valid = false;
+                return false;
+            }
+        }
+        delta->image = QByteArray(numBytes, 0);
+    } else if (!delta->valid || epoch != delta->epoch || seq != (quint8)(delta->seq + 1)) {
+        // Never applied to another base than the one of the sender
+        delta->valid = false;
+        requestDeltaKeyFrame(objId, instId, delta);
+        return true;
+    }
+
+    qint32 pos = DELTA_HEADER_LENGTH + maskLength;
+    quint8 *image = (quint8 *)delta->image.data();
+    for (qint32 n = 0; n < numChunks; ++n) {
+        if (mask[n / 8] & (1 << (n % 8))) {
+            qint32 offset = n * DELTA_CHUNK_LENGTH;
+            qint32 chunkLength = qMin(DELTA_CHUNK_LENGTH, numBytes - offset);
+            if (pos + chunkLength > length) {
+                delta->valid = false;
+                return false;
+            }
+            memcpy(&image[offset], &data[pos], chunkLength);
+            pos += chunkLength;
+        }
+    }
+    if (pos != length) {
+        delta->valid = false;
+        return false;
+    }
+    delta->epoch = epoch;
+    delta->seq   = seq;
+    delta->valid = true;
+    if (keyFrame) {
+        delta->keyFrameRequested = false;
+    }
+
+    obj = updateObject(objId, instId, image);
+#ifdef VERBOSE_UAVTALK
+    VERBOSE_FILTER(objId) qDebug() << "UAVTalk - received delta" << objId << instId << (obj != NULL ? obj->toStringBrief() : "<null object>");
+#endif
+    if (obj == NULL) {
+        return false;
+    }
+    updateAck(TYPE_OBJ, objId, instId, obj);
+    return true;
+}
+
+/**
+ * Request the object from the sender of the delta frames, which sends a key frame next.
+ * Requested once until a key frame comes, the periodic key frames cover a lost request.
+ */
+void UAVTalk::requestDeltaKeyFrame(quint32 objId, quint16 instId, DeltaImage *delta)
+{
+    if (!delta->keyFrameRequested) {
+        delta->keyFrameRequested = true;
+        transmitObject(TYPE_OBJ_REQ, objId, instId, NULL);
+    }
+}
+
 /**
  * Update the data of an object from a byte array (unpack).
  * If the object instance could not be found in the list, then a
  * new one is created.
  */
-UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
+UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, const quint8 *data)
 {
     // Get object
     UAVObject *obj = objMngr->getObject(objId, instId);
@@ -623,10 +1040,18 @@ UAVObject *UAVTalk::updateObject(quint32 objId, quint16 instId, quint8 *data)
             qWarning() << "UAVTalk - failed to register object " << instObj->toStringBrief();
             return NULL;
         }
+        if (rxTimestamped) {
+            instObj->setVehicleTime(rxVehicleTime, clock.toLocalTime(rxVehicleTime));
+        }
         instObj->unpack(data);
         return instObj;
     } else {
-        // Unpack data into object instance
+        // Unpack data into object instance, an update without a time stamp makes its board time stale
+        if (rxTimestamped) {
+            obj->setVehicleTime(rxVehicleTime, clock.toLocalTime(rxVehicleTime));
+        } else if (obj->hasVehicleTime()) {
+            obj->clearVehicleTime();
+        }
         obj->unpack(data);
         return obj;
     }
@@ -743,6 +1168,7 @@ bool UAVTalk::transmitObject(quint8 type, quint32 objId, quint16 instId, UAVObje
 bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, UAVObject *obj)
 {
     qint32 length;
+    qint32 headerLength = HEADER_LENGTH;
 
     // IMPORTANT : obj can be null (when type is NACK for example)
 
@@ -755,6 +1181,12 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
     qToLittleEndian<quint32>(objId, &txBuffer[4]);
     // Setup instance ID
     qToLittleEndian<quint16>(instId, &txBuffer[8]);
+    // Setup the board time of the update, if it has one
+    if (sendTimestamps && (type == TYPE_OBJ || type == TYPE_OBJ_ACK) && obj->hasVehicleTime()) {
+        txBuffer[1] |= TIMESTAMPED;
+        qToLittleEndian<quint16>((quint16)obj->getVehicleTime(), &txBuffer[HEADER_LENGTH]);
+        headerLength += TIMESTAMP_LENGTH;
+    }
 
     // Determine data length
     if (type == TYPE_OBJ_REQ || type == TYPE_ACK || type == TYPE_NACK) {
@@ -772,7 +1204,7 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
 
     // Copy data (if any)
     if (length > 0) {
-        if (!obj->pack(&txBuffer[HEADER_LENGTH])) {
+        if (!obj->pack(&txBuffer[headerLength])) {
             qWarning() << "UAVTalk - error transmitting : failed to pack object" << obj->toStringBrief();
             ++stats.txErrors;
             return false;
@@ -780,17 +1212,23 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
     }
 
     // Store the packet length
-    qToLittleEndian<quint16>(HEADER_LENGTH + length, &txBuffer[2]);
+    qToLittleEndian<quint16>(headerLength + length, &txBuffer[2]);
 
     // Calculate checksum
-    txBuffer[HEADER_LENGTH + length] = Crc::updateCRC(0, txBuffer, HEADER_LENGTH + length);
+    txBuffer[headerLength + length] = Crc::updateCRC(0, txBuffer, headerLength + length);
 
     // Send buffer, check that the transmit backlog does not grow above limit
     if (!io.isNull() && io->isWritable()) {
-        if (io->bytesToWrite() < TX_BUFFER_SIZE) {
-            io->write((const char *)txBuffer, HEADER_LENGTH + length + CHECKSUM_LENGTH);
-            if (useUDPMirror) {
-                udpSocketRx->writeDatagram((const char *)txBuffer, HEADER_LENGTH + length + CHECKSUM_LENGTH, QHostAddress::LocalHost, udpSocketTx->localPort());
+        const bool ownThread = (QThread::currentThread() == thread());
+        const qint64 backlog = ownThread ? io->bytesToWrite() : txBacklog;
+        if (backlog + txQueue.size() < TX_BUFFER_SIZE) {
+            txQueue.append((const char *)txBuffer, headerLength + length + CHECKSUM_LENGTH);
+            if (ownThread) {
+                flushOutput();
+            } else if (!txFlushPending) {
+                // the device may only be used from its own thread
+                txFlushPending = true;
+                QMetaObject::invokeMethod(this, "flushOutput", Qt::QueuedConnection);
             }
         } else {
             qWarning() << "UAVTalk - error transmitting : io device full";
@@ -806,7 +1244,10 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
     // Update stats
     ++stats.txObjects;
     stats.txObjectBytes += length;
-    stats.txBytes += HEADER_LENGTH + length + CHECKSUM_LENGTH;
+    stats.txBytes += headerLength + length + CHECKSUM_LENGTH;
+    ObjectStats &objStats = objectStatsOf(objId);
+    objStats.txBytes += headerLength + length + CHECKSUM_LENGTH;
+    objStats.txObjects++;
 
     // Done
     return true;
@@ -814,60 +1255,41 @@ bool UAVTalk::transmitSingleObject(quint8 type, quint32 objId, quint16 instId, U
 
 UAVTalk::Transaction *UAVTalk::findTransaction(quint32 objId, quint16 instId)
 {
-    // Lookup the transaction in the transaction map
-    QMap<quint32, Transaction *> *objTransactions = transMap.value(objId);
-    if (objTransactions != NULL) {
-        Transaction *trans = objTransactions->value(instId);
-        if (trans == NULL) {
-            // see if there is an ALL_INSTANCES transaction
-            trans = objTransactions->value(ALL_INSTANCES);
-        }
-        return trans;
+    // Lookup the transaction in the transaction table
+    Transaction *trans = transMap.find(objId, instId);
+
+    if (trans == NULL) {
+        // see if there is an ALL_INSTANCES transaction
+        trans = transMap.find(objId, ALL_INSTANCES);
     }
-    return NULL;
+    return trans;
 }
 
 void UAVTalk::openTransaction(quint8 type, quint32 objId, quint16 instId)
 {
-    Transaction *trans = new Transaction();
+    Transaction trans;
 
-    trans->respType   = (type == TYPE_OBJ_REQ) ? TYPE_OBJ : TYPE_ACK;
-    trans->respObjId  = objId;
-    trans->respInstId = instId;
+    trans.respType   = (type == TYPE_OBJ_REQ) ? TYPE_OBJ : TYPE_ACK;
+    trans.respObjId  = objId;
+    trans.respInstId = instId;
 
-    QMap<quint32, Transaction *> *objTransactions = transMap.value(trans->respObjId);
-    if (objTransactions == NULL) {
-        objTransactions = new QMap<quint32, Transaction *>();
-        transMap.insert(trans->respObjId, objTransactions);
-    }
-    objTransactions->insert(trans->respInstId, trans);
+    transMap.insert(trans.respObjId, trans.respInstId, trans);
 }
 
 void UAVTalk::closeTransaction(Transaction *trans)
 {
-    QMap<quint32, Transaction *> *objTransactions = transMap.value(trans->respObjId);
-    if (objTransactions != NULL) {
-        objTransactions->remove(trans->respInstId);
-        // Keep the map even if it is empty
-        // There are at most 100 different object IDs...
-        delete trans;
-    }
+    // Transactions are stored in the table, removing it releases it
+    transMap.remove(trans->respObjId, trans->respInstId);
 }
 
 void UAVTalk::closeAllTransactions()
 {
-    foreach(quint32 objId, transMap.keys()) {
-        QMap<quint32, Transaction *> *objTransactions = transMap.value(objId);
-        foreach(quint32 instId, objTransactions->keys()) {
-            Transaction *trans = objTransactions->value(instId);
-
-            qWarning() << "UAVTalk - closing active transaction for object" << trans->respObjId;
-            objTransactions->remove(instId);
-            delete trans;
+    for (int n = 0; n < transMap.capacity(); ++n) {
+        if (transMap.isUsed(n)) {
+            qWarning() << "UAVTalk - closing active transaction for object" << transMap.valueAt(n).respObjId;
         }
-        transMap.remove(objId);
-        delete objTransactions;
     }
+    transMap.clear();
 }
 
 const char *UAVTalk::typeToString(quint8 type)
@@ -896,6 +1318,16 @@ const char *UAVTalk::typeToString(quint8 type)
     case TYPE_NACK:
         return "nack";
 
+        break;
+
+    case TYPE_OBJ_MULTI:
+        return "multiple objects";
+
+        break;
+
+    case TYPE_OBJ_DELTA:
+        return "delta object";
+
         break;
     }
     return "<error>";
@@ -29,6 +29,8 @@
 
 #include "uavobjectmanager.h"
 #include "uavtalk_global.h"
+#include "transactiontable.h"
+#include "vehicleclock.h"
 
 #include <QtCore>
 #include <QIODevice>
@@ -41,8 +43,6 @@
 class UAVTALK_EXPORT UAVTalk : public QObject {
     Q_OBJECT
 
-    friend class IODeviceReader;
-
 public:
     static const quint16 ALL_INSTANCES = 0xFFFF;
 
@@ -58,23 +58,45 @@ public:
         quint32 rxErrors;
         quint32 rxSyncErrors;
         quint32 rxCrcErrors;
+        quint32 rxTimestampedObjects;
+        // delay of the last timestamped frame above the fastest one, in ms
+        quint32 rxTimestampDelay;
     } ComStats;
 
+    // Traffic of an object, frame bytes or multi-object frame entry bytes
+    typedef struct {
+        quint32 txBytes;
+        quint32 txObjects;
+        quint32 rxBytes;
+        quint32 rxObjects;
+    } ObjectStats;
+
     UAVTalk(QIODevice *iodev, UAVObjectManager *objMngr);
     ~UAVTalk();
 
     ComStats getStats();
+    // Per object counters, reset along with the others
+    QHash<quint32, ObjectStats> getObjectStats();
     void resetStats();
 
     bool sendObject(UAVObject *obj, bool acked, bool allInstances);
     bool sendObjectRequest(UAVObject *obj, bool allInstances);
     void cancelTransaction(UAVObject *obj);
 
+    // Board time of the timestamped frames received so far, thread safe
+    VehicleClock &vehicleClock()
+    {
+        return clock;
+    }
+    // Sends the objects that carry a board time timestamped, for the logs
+    void setSendTimestamps(bool enable);
+
 signals:
     void transactionCompleted(UAVObject *obj, bool success);
 
 private slots:
     void processInputStream();
+    void flushOutput();
     void dummyUDPRead();
 
 private:
@@ -85,29 +107,56 @@ private:
         quint16 respInstId;
     } Transaction;
 
+    // Base of the delta frames of an object instance
+    typedef struct {
+        QByteArray image;
+        quint8     epoch;
+        quint8     seq;
+        bool valid;
+        bool keyFrameRequested;
+    } DeltaImage;
+
     // Constants
-    static const int TYPE_MASK     = 0xF8;
+    static const int TYPE_MASK     = 0x78;
     static const int TYPE_VER      = 0x20;
     static const int TYPE_OBJ      = (TYPE_VER | 0x00);
     static const int TYPE_OBJ_REQ  = (TYPE_VER | 0x01);
     static const int TYPE_OBJ_ACK  = (TYPE_VER | 0x02);
     static const int TYPE_ACK      = (TYPE_VER | 0x03);
     static const int TYPE_NACK     = (TYPE_VER | 0x04);
+    static const int TYPE_OBJ_MULTI = (TYPE_VER | 0x05);
+    static const int TYPE_OBJ_DELTA = (TYPE_VER | 0x06);
+    // flag of the object frames carrying the board time after the header
+    static const int TIMESTAMPED    = 0x80;
+    static const int TYPE_OBJ_TS     = (TIMESTAMPED | TYPE_OBJ);
+    static const int TYPE_OBJ_ACK_TS = (TIMESTAMPED | TYPE_OBJ_ACK);
 
     // header : sync(1), type (1), size(2), object ID(4), instance ID(2)
     static const int HEADER_LENGTH = 10;
 
+    // board time in ms, low 16 bits
+    static const int TIMESTAMP_LENGTH = 2;
+
+    // multi-object frame entry : object ID(4), instance ID(2), data length(1)
+    static const int MULTI_ENTRY_HEADER_LENGTH = 7;
+
+    // delta frame payload : epoch(1), sequence number(1), bitmask of the changed chunks, changed chunks
+    // sequence number zero is the key frame of the epoch, with all the chunks
+    static const int DELTA_HEADER_LENGTH = 2;
+    static const int DELTA_CHUNK_LENGTH  = 4;
+
     static const int MAX_PAYLOAD_LENGTH = 256;
 
     static const int CHECKSUM_LENGTH    = 1;
 
-    static const int MAX_PACKET_LENGTH  = (HEADER_LENGTH + MAX_PAYLOAD_LENGTH + CHECKSUM_LENGTH);
+    static const int MAX_PACKET_LENGTH  = (HEADER_LENGTH + TIMESTAMP_LENGTH + MAX_PAYLOAD_LENGTH + CHECKSUM_LENGTH);
+    static const int INPUT_CHUNK_LENGTH = 4096;
 
     static const int TX_BUFFER_SIZE     = 2 * 1024;
 
     // Types
     typedef enum {
-        STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_DATA, STATE_CS, STATE_COMPLETE, STATE_ERROR
+        STATE_SYNC, STATE_TYPE, STATE_SIZE, STATE_OBJID, STATE_INSTID, STATE_TIMESTAMP, STATE_DATA, STATE_CS, STATE_COMPLETE, STATE_ERROR
     } RxStateType;
 
     // Variables
@@ -116,15 +165,26 @@ private:
     UAVObjectManager *objMngr;
 
     ComStats stats;
+    QHash<quint32, ObjectStats> objectStats;
 
     QMutex mutex;
 
-    QMap<quint32, QMap<quint32, Transaction *> *> transMap;
+    TransactionTable<Transaction> transMap;
+
+    TransactionTable<DeltaImage> deltaMap;
+
+    VehicleClock clock;
+    bool sendTimestamps;
 
     quint8 rxBuffer[MAX_PACKET_LENGTH];
 
     quint8 txBuffer[MAX_PACKET_LENGTH];
 
+    // Frames sent from other threads, written by the thread of the device
+    QByteArray txQueue;
+    bool txFlushPending;
+    qint64 txBacklog;
+
     // Variables used by the receive state machine
     // state machine variables
     qint32 rxCount;
@@ -137,6 +197,11 @@ private:
     quint16 rxInstId;
     quint16 rxLength;
     quint16 rxPacketLength;
+    quint8 rxTimestampLength;
+    quint16 rxTimestamp;
+    // board time of the object being received, valid if rxTimestamped is set
+    bool rxTimestamped;
+    quint32 rxVehicleTime;
     quint8 rxCSPacket;
     quint8 rxCS;
 
@@ -147,13 +212,21 @@ private:
 
     // Methods
     bool objectTransaction(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
+    void processInputBuffer(const quint8 *buffer, qint32 length);
+    qint32 processInputFrame(const quint8 *frame, qint32 length);
     bool processInputByte(quint8 rxbyte);
-    bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8 *data, qint32 length);
-    UAVObject *updateObject(quint32 objId, quint16 instId, quint8 *data);
+    void processReceivedObject(quint8 type, quint32 objId, quint16 instId, const quint8 *data, qint32 length,
+                               qint32 timestampLength, quint16 timestamp);
+    bool receiveObject(quint8 type, quint32 objId, quint16 instId, const quint8 *data, qint32 length);
+    bool receiveMultiObject(const quint8 *data, qint32 length);
+    bool receiveDeltaObject(quint32 objId, quint16 instId, const quint8 *data, qint32 length);
+    void requestDeltaKeyFrame(quint32 objId, quint16 instId, DeltaImage *delta);
+    UAVObject *updateObject(quint32 objId, quint16 instId, const quint8 *data);
     void updateAck(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
     void updateNack(quint32 objId, quint16 instId, UAVObject *obj);
     bool transmitObject(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
     bool transmitSingleObject(quint8 type, quint32 objId, quint16 instId, UAVObject *obj);
+    ObjectStats &objectStatsOf(quint32 objId);
 
     Transaction *findTransaction(quint32 objId, quint16 instId);
     void openTransaction(quint8 type, quint32 objId, quint16 instId);
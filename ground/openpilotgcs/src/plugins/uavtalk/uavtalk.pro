@@ -13,17 +13,24 @@ include(uavtalk_dependencies.pri)
 
 HEADERS += \
     uavtalk.h \
+    vehicleclock.h \
     uavtalkplugin.h \
     telemetrymonitor.h \
     telemetrymanager.h \
     uavtalk_global.h \
-    telemetry.h
+    objectcache.h \
+    transactiontable.h \
+    telemetry.h \
+    telemetryrelay.h
 
 SOURCES += \
     uavtalk.cpp \
+    vehicleclock.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
+    objectcache.cpp \
     telemetrymanager.cpp \
-    telemetry.cpp
+    telemetry.cpp \
+    telemetryrelay.cpp
 
 OTHER_FILES += UAVTalk.pluginspec
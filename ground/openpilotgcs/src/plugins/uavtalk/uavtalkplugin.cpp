@@ -25,6 +25,7 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 #include "uavtalkplugin.h"
+#include "telemetryrelay.h"
 
 #include <coreplugin/icore.h>
 #include <coreplugin/connectionmanager.h>
@@ -53,6 +54,13 @@ bool UAVTalkPlugin::initialize(const QStringList & arguments, QString *errorStri
     telMngr = new TelemetryManager();
     addAutoReleasedObject(telMngr);
 
+    // Share the link with the local clients, if configured
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    TelemetryRelay *relay = TelemetryRelay::fromSettings(pm->getObject<UAVObjectManager>());
+    if (relay) {
+        addAutoReleasedObject(relay);
+    }
+
     // Connect to connection manager so we get notified when the user connect to his device
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
     QObject::connect(cm, SIGNAL(deviceConnected(QIODevice *)),
@@ -0,0 +1,227 @@
+/**
+ ******************************************************************************
+ *
+ * @file       vehicleclock.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Board time reconstructed from the timestamped UAVTalk frames
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "vehicleclock.h"
+
+#include <QDateTime>
+
+VehicleClock::VehicleClock()
+{
+    reset();
+}
+
+void VehicleClock::reset()
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_timer.start();
+    m_epoch          = QDateTime::currentMSecsSinceEpoch();
+    m_valid          = false;
+    m_vehicleTime    = 0;
+    m_lastReceived   = 0;
+    m_windowStart    = 0;
+    m_windowOffset   = 0;
+    m_previousOffset = 0;
+    m_lastDelay      = 0;
+    resetSynchronization();
+}
+
+void VehicleClock::resetSynchronization()
+{
+    m_exchanges.clear();
+    m_synchronized  = false;
+    m_syncOffset    = 0;
+    m_syncTime      = 0;
+    m_roundTripTime = 0;
+    m_skew       = 0;
+    m_skewTime   = 0;
+    m_skewOffset = 0;
+}
+
+quint32 VehicleClock::update(quint16 timeStamp)
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 now = m_timer.elapsed();
+    quint32 vehicleTime;
+
+    if (m_synchronized) {
+        // The latest board time that ends with the stamp, a second of margin for the offset errors
+        quint32 latest = (quint32)(now - offset(now)) + 1000;
+        vehicleTime    = latest - (quint16)((quint16)latest - timeStamp);
+        m_valid        = true;
+        m_vehicleTime  = vehicleTime;
+        m_lastReceived = now;
+        m_lastDelay    = (quint32)qMax(0.0, now - vehicleTime - offset(now));
+        return vehicleTime;
+    }
+
+    if (!m_valid) {
+        m_valid          = true;
+        m_vehicleTime    = timeStamp;
+        m_lastReceived   = now;
+        m_windowStart    = now;
+        m_windowOffset   = now - timeStamp;
+        m_previousOffset = m_windowOffset;
+        m_lastDelay      = 0;
+        return m_vehicleTime;
+    }
+
+    quint16 delta  = timeStamp - (quint16)m_vehicleTime;
+    qint64 elapsed = now - m_lastReceived;
+    if (delta >= WRAP / 2 && elapsed < WRAP / 2) {
+        // A frame older than the last one, it was held up behind it
+        vehicleTime = m_vehicleTime - (quint32)(WRAP - delta);
+    } else {
+        qint64 wraps = (elapsed - delta + WRAP / 2) / WRAP;
+        if (wraps < 0) {
+            wraps = 0;
+        }
+        vehicleTime    = m_vehicleTime + delta + (quint32)(wraps * WRAP);
+        m_vehicleTime  = vehicleTime;
+        m_lastReceived = now;
+    }
+
+    qint64 sample = now - vehicleTime;
+    if (now - m_windowStart >= WINDOW_LENGTH_MS) {
+        m_previousOffset = m_windowOffset;
+        m_windowOffset   = sample;
+        m_windowStart    = now;
+    } else if (sample < m_windowOffset) {
+        m_windowOffset = sample;
+    }
+    m_lastDelay = (quint32)(sample - offset(now));
+
+    return vehicleTime;
+}
+
+bool VehicleClock::isValid() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_valid;
+}
+
+qint64 VehicleClock::toLocalTime(quint32 vehicleTime) const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_epoch + vehicleTime + qRound64(offset(m_timer.elapsed()));
+}
+
+quint32 VehicleClock::lastDelay() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_lastDelay;
+}
+
+qint64 VehicleClock::localTime() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_timer.elapsed();
+}
+
+/**
+ * Adds a time exchange. Its offset assumes the same latency both ways, the
+ * error is at most half the round trip, so the exchange with the shortest
+ * round trip of the last few is the one trusted.
+ */
+void VehicleClock::addExchange(qint64 localSent, quint32 vehicleReceived, quint32 vehicleSent, qint64 localReceived)
+{
+    QMutexLocker locker(&m_mutex);
+
+    Exchange exchange;
+
+    exchange.time = localReceived;
+    exchange.roundTripTime = qMax((qint64)0, (localReceived - localSent) - (qint64)(quint32)(vehicleSent - vehicleReceived));
+    exchange.offset = ((localSent - (double)vehicleReceived) + (localReceived - (double)vehicleSent)) / 2.0;
+
+    if (m_synchronized && qAbs(exchange.offset - offset(exchange.time)) > OFFSET_JUMP_MS) {
+        // The board restarted, its tick count with it
+        resetSynchronization();
+        m_valid = false;
+    }
+
+    m_roundTripTime = (m_roundTripTime > 0) ? 0.875 * m_roundTripTime + 0.125 * exchange.roundTripTime : exchange.roundTripTime;
+
+    m_exchanges.append(exchange);
+    if (m_exchanges.size() > EXCHANGE_FILTER_LENGTH) {
+        m_exchanges.remove(0);
+    }
+    const Exchange *best = m_exchanges.constData();
+    for (int i = 1; i < m_exchanges.size(); ++i) {
+        if (m_exchanges.at(i).roundTripTime < best->roundTripTime) {
+            best = &m_exchanges.at(i);
+        }
+    }
+
+    if (!m_synchronized) {
+        m_skewTime   = best->time;
+        m_skewOffset = best->offset;
+    } else if (best->time - m_skewTime >= SKEW_SPAN_MS) {
+        double skew = (best->offset - m_skewOffset) / (best->time - m_skewTime);
+        m_skew       = (m_skew != 0) ? 0.8 * m_skew + 0.2 * skew : skew;
+        m_skewTime   = best->time;
+        m_skewOffset = best->offset;
+    }
+    m_syncOffset   = best->offset;
+    m_syncTime     = best->time;
+    m_synchronized = true;
+}
+
+bool VehicleClock::isSynchronized() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_synchronized;
+}
+
+double VehicleClock::roundTripTime() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_roundTripTime;
+}
+
+double VehicleClock::skew() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_skew * 1000000.0;
+}
+
+/**
+ * GCS minus board time at the GCS time now
+ */
+double VehicleClock::offset(qint64 now) const
+{
+    if (m_synchronized) {
+        return m_syncOffset + m_skew * (now - m_syncTime);
+    }
+    return (m_previousOffset < m_windowOffset) ? m_previousOffset : m_windowOffset;
+}
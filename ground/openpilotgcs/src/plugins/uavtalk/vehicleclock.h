@@ -0,0 +1,118 @@
+/**
+ ******************************************************************************
+ *
+ * @file       vehicleclock.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Board time reconstructed from the timestamped UAVTalk frames
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef VEHICLECLOCK_H
+#define VEHICLECLOCK_H
+
+#include "uavtalk_global.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+
+/**
+ * The board stamps its timestamped frames with the low 16 bits of its
+ * millisecond tick count. The stamps are unwrapped to a 32 bit board time,
+ * the wraps missed during a link outage are counted with the GCS clock.
+ *
+ * Until the clocks are synchronised, the offset between them is the
+ * smallest difference between the GCS receive time and the board time seen
+ * over the last two windows: the frames that were not queued anywhere give
+ * it, the drift of the clocks is followed as the windows roll. The delay of
+ * a frame is then its delay above the fastest one.
+ *
+ * The time exchanges (TelemetryPing) synchronise the clocks the way NTP
+ * does: of the last few exchanges, the one with the shortest round trip
+ * gives the offset, and the offsets over a minute or more give the skew of
+ * the board clock. Once synchronised, the stamps unwrap to the board tick
+ * count itself and the delay of a frame is its one way latency.
+ */
+class UAVTALK_EXPORT VehicleClock {
+public:
+    VehicleClock();
+
+    void reset();
+
+    // Unwraps the stamp of a frame received now, returns the board time in ms
+    quint32 update(quint16 timeStamp);
+
+    bool isValid() const;
+    // GCS time (ms since the epoch) at which the board was at vehicleTime
+    qint64 toLocalTime(quint32 vehicleTime) const;
+    // Delay of the last frame in ms, see above
+    quint32 lastDelay() const;
+
+    // Time of the GCS clock in ms, for the time exchanges
+    qint64 localTime() const;
+    // A time exchange: GCS send time, board receive and send times, GCS receive time
+    void addExchange(qint64 localSent, quint32 vehicleReceived, quint32 vehicleSent, qint64 localReceived);
+    bool isSynchronized() const;
+    // Smoothed round trip time in ms, without the time the board took to answer
+    double roundTripTime() const;
+    // Drift of the board clock against the GCS clock in ppm
+    double skew() const;
+
+private:
+    struct Exchange {
+        qint64 time;
+        qint64 roundTripTime;
+        double offset;
+    };
+
+    static const qint64 WINDOW_LENGTH_MS = 10000;
+    static const qint64 WRAP = 0x10000;
+    static const int EXCHANGE_FILTER_LENGTH = 8;
+    // Time between two offsets for a skew estimate
+    static const qint64 SKEW_SPAN_MS = 60000;
+    // An offset that far from the prediction means the board restarted
+    static const qint64 OFFSET_JUMP_MS = 1000;
+
+    mutable QMutex m_mutex;
+    QElapsedTimer m_timer;
+    qint64 m_epoch;
+    bool m_valid;
+    quint32 m_vehicleTime;
+    qint64 m_lastReceived;
+    qint64 m_windowStart;
+    qint64 m_windowOffset;
+    qint64 m_previousOffset;
+    quint32 m_lastDelay;
+
+    QVector<Exchange> m_exchanges;
+    bool m_synchronized;
+    // GCS minus board time at m_syncTime
+    double m_syncOffset;
+    qint64 m_syncTime;
+    double m_roundTripTime;
+    double m_skew;
+    qint64 m_skewTime;
+    double m_skewOffset;
+
+    double offset(qint64 now) const;
+    void resetSynchronization();
+};
+
+#endif // VEHICLECLOCK_H
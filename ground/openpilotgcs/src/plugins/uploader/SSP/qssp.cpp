@@ -149,6 +149,11 @@ void qssp::ssp_Init(const PortConfig_t *const info)
     thisport->RxError = 0;
     thisport->txSeqNo = 0;
     thisport->rxSeqNo = 0;
+    windowed    = false;
+    window      = 1;
+    frameLength = thisport->txBufSize - 2;
+    windowHead  = 0;
+    windowCount = 0;
 }
 
 /*!
@@ -166,6 +171,9 @@ int16_t qssp::ssp_SendProcess()
 {
     int16_t value = SSP_TX_WAITING;
 
+    if (windowed) {
+        return sf_SendWindowProcess();
+    }
     if (thisport->SendState == SSP_AWAITING_ACK) {
         if (sf_CheckTimeout() == TRUE) {
             if (thisport->retryCount < thisport->maxRetryCount) {
@@ -286,9 +294,29 @@ int16_t qssp::ssp_SendData(const uint8_t *data, const uint16_t length)
 {
     int16_t value = SSP_TX_WAITING;
 
-    if ((length + 2) > thisport->txBufSize) {
+    if ((length + 2) > thisport->txBufSize || (windowed && length > frameLength)) {
         // TRYING to send too much data.
         value = SSP_TX_BUFOVERRUN;
+    } else if (windowed) {
+        if (windowCount == window) {
+            return SSP_TX_BUSY;
+        }
+        thisport->txSeqNo = (thisport->txSeqNo & 0x7F) + 1;
+        if (thisport->txSeqNo > 0x7F) {
+            thisport->txSeqNo = 1;
+        }
+        uint8_t *frame = windowBuf[(windowHead + windowCount) % SSP_MAX_WINDOW];
+        sf_MakePacket(frame, data, length, thisport->txSeqNo);
+        sf_SendFrame(frame);
+        if (windowCount++ == 0) {
+            // the timeout runs for the oldest packet in flight
+            thisport->retryCount = 0;
+            sf_SetSendTimeout();
+        }
+        thisport->SendState = SSP_AWAITING_ACK;
+        if (debug) {
+            qDebug() << "Sent DATA PACKET:" << thisport->txSeqNo << "in flight:" << windowCount;
+        }
     } else if (thisport->SendState == SSP_IDLE) {
 #ifdef ACTIVE_SYNCH
         if (thisport->sendSynch == TRUE) {
@@ -364,8 +392,12 @@ uint16_t qssp::ssp_Synchronise()
 #ifndef USE_SENDPACKET_DATA
     thisport->txSeqNo = 0; // make this zero to cause the other end to re-synch with us
     SETBIT(thisport->flags, SENT_SYNCH);
+    // Ask for the windowed mode, an old bootloader ignores the request data and ACKs without any
+    windowed    = false;
+    windowCount = 0;
+    uint8_t request[SSP_SYNC_LENGTH] = { SSP_SYNC_MAGIC, SSP_SYNC_VERSION, SSP_MAX_WINDOW, (uint8_t)(thisport->txBufSize - 3) };
     // TODO - should this be using ssp_SendPacketData()??
-    sf_MakePacket(thisport->txBuf, NULL, 0, thisport->txSeqNo); // construct the packet
+    sf_MakePacket(thisport->txBuf, request, SSP_SYNC_LENGTH, thisport->txSeqNo); // construct the packet
     sf_SendPacket();
     sf_SetSendTimeout();
     thisport->SendState = SSP_AWAITING_ACK;
@@ -405,16 +437,26 @@ uint16_t qssp::ssp_Synchronise()
  * Packet should be formed through the use of sf_MakePacket before calling this function.
  */
 void qssp::sf_SendPacket()
+{
+    sf_SendFrame(thisport->txBuf);
+    thisport->retryCount++;
+}
+
+/*!
+ * \brief   sends out a preformatted packet held in any buffer
+ * \param	buf = packet formed by sf_MakePacket
+ * \return  none.
+ */
+void qssp::sf_SendFrame(const uint8_t *buf)
 {
     // add 3 to packet data length for: 1 length + 2 CRC (packet overhead)
-    uint8_t packetLen = thisport->txBuf[LENGTH] + 3;
+    uint16_t packetLen = buf[LENGTH] + 3;
 
     // use the raw serial write function so the SYNC byte does not get 'escaped'
     thisport->pfSerialWrite(SYNC);
-    for (uint8_t x = 0; x < packetLen; x++) {
-        sf_write_byte(thisport->txBuf[x]);
+    for (uint16_t x = 0; x < packetLen; x++) {
+        sf_write_byte(buf[x]);
     }
-    thisport->retryCount++;
 }
 
 
@@ -469,9 +511,9 @@ void qssp::sf_SendAckPacket(uint8_t seqNumber)
 {
     uint8_t AckSeqNumber = SETBIT(seqNumber, ACK_BIT);
 
-    // create the packet, note we pass AckSequenceNumber directly
-    sf_MakePacket(thisport->txBuf, NULL, 0, AckSeqNumber);
-    sf_SendPacket();
+    // create the packet, note we pass AckSequenceNumber directly, txBuf may still be waiting for its own ACK
+    sf_MakePacket(ackBuf, NULL, 0, AckSeqNumber);
+    sf_SendFrame(ackBuf);
     if (debug) {
         qDebug() << "Sent ACK PACKET:" << seqNumber;
     }
@@ -736,9 +778,24 @@ int16_t qssp::sf_ReceivePacket()
 {
     int16_t value = FALSE;
 
-    if (ISBITSET(thisport->rxBuf[SEQNUM], ACK_BIT)) {
+    if (ISBITSET(thisport->rxBuf[SEQNUM], ACK_BIT) && windowed) {
+        sf_ReceiveAck(thisport->rxBuf[SEQNUM] & 0x7F);
+    } else if (ISBITSET(thisport->rxBuf[SEQNUM], ACK_BIT)) {
         // Received an ACK packet, need to check if it matches the previous sent packet
         if ((thisport->rxBuf[SEQNUM] & 0x7F) == (thisport->txSeqNo & 0x7f)) {
+            if ((thisport->txSeqNo & 0x7F) == 0) {
+                // The ACK of a synchronise request, a bootloader that supports the windowed mode sends its terms
+                uint8_t *terms = &thisport->rxBuf[DATA];
+                windowed = (thisport->rxBufLen >= SSP_SYNC_LENGTH && terms[0] == SSP_SYNC_MAGIC &&
+                            terms[1] == SSP_SYNC_VERSION && terms[2] > 0 && terms[3] > 0);
+                if (windowed) {
+                    window      = qMin((uint8_t)SSP_MAX_WINDOW, terms[2]);
+                    frameLength = qMin((uint16_t)(thisport->txBufSize - 2), (uint16_t)terms[3]);
+                }
+                if (debug) {
+                    qDebug() << "Windowed mode:" << windowed << "window:" << window << "frame:" << frameLength;
+                }
+            }
             // It matches the last packet sent by us
             SETBIT(thisport->txSeqNo, ACK_BIT);
             thisport->SendState = SSP_ACKED;
@@ -805,7 +862,95 @@ qssp::qssp(port *info, bool debug) : debug(debug)
     thisport->RxError = 0;
     thisport->txSeqNo = 0;
     thisport->rxSeqNo = 0;
+    windowed    = false;
+    window      = 1;
+    frameLength = thisport->txBufSize - 2;
+    windowHead  = 0;
+    windowCount = 0;
 }
+/*!
+ * \brief   takes a cumulative ACK in windowed mode
+ * \param	seqNumber = sequence number acknowledged, with all the packets sent before it
+ * \return  none.
+ *
+ * \note
+ * An ACK of a packet no longer in flight is a duplicate, or the board telling the last one it
+ * accepted after a packet went missing, the timeout of the oldest packet then resends from there.
+ */
+void qssp::sf_ReceiveAck(uint8_t seqNumber)
+{
+    for (int i = 0; i < windowCount; ++i) {
+        if (windowBuf[(windowHead + i) % SSP_MAX_WINDOW][SEQNUM] == seqNumber) {
+            windowHead  = (windowHead + i + 1) % SSP_MAX_WINDOW;
+            windowCount = windowCount - i - 1;
+            thisport->retryCount = 0;
+            if (windowCount > 0) {
+                sf_SetSendTimeout();
+            } else {
+                thisport->SendState = SSP_ACKED;
+            }
+            if (debug) {
+                qDebug() << "Received ACK:" << seqNumber << "in flight:" << windowCount;
+            }
+            return;
+        }
+    }
+}
+
+/*!
+ * \brief   runs the send process in windowed mode, resends all the packets in flight on timeout
+ * \return  same as ssp_SendProcess, SSP_TX_ACKED once nothing is left in flight
+ */
+int16_t qssp::sf_SendWindowProcess()
+{
+    if (windowCount > 0) {
+        if (sf_CheckTimeout() == FALSE) {
+            return SSP_TX_WAITING;
+        }
+        if (thisport->retryCount >= thisport->maxRetryCount) {
+            windowCount = 0;
+            thisport->SendState = SSP_IDLE;
+            if (debug) {
+                qDebug() << "Send TimeOut!";
+            }
+            return SSP_TX_TIMEOUT;
+        }
+        // Go back N, the board dropped everything after the packet it missed
+        for (int i = 0; i < windowCount; ++i) {
+            sf_SendFrame(windowBuf[(windowHead + i) % SSP_MAX_WINDOW]);
+        }
+        thisport->retryCount++;
+        sf_SetSendTimeout();
+        return SSP_TX_WAITING;
+    }
+    if (thisport->SendState == SSP_ACKED) {
+        thisport->SendState = SSP_IDLE;
+        return SSP_TX_ACKED;
+    }
+    thisport->SendState = SSP_IDLE;
+    return SSP_TX_IDLE;
+}
+
+bool qssp::ssp_Windowed() const
+{
+    return windowed;
+}
+
+uint16_t qssp::ssp_FrameLength() const
+{
+    return frameLength;
+}
+
+bool qssp::ssp_WindowFull() const
+{
+    return windowCount >= window;
+}
+
+int qssp::ssp_Outstanding() const
+{
+    return windowCount;
+}
+
 void qssp::pfCallBack(uint8_t *buf, uint16_t size)
 {
     Q_UNUSED(size);
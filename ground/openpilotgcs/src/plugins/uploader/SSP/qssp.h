@@ -55,6 +55,13 @@
 #define SSP_RX_ACK        6
 #define SSP_RX_SYNCH      7
 
+// Windowed mode, negotiated by the synchronise request, see flight/libraries/ssp.c
+#define SSP_SYNC_MAGIC     0x57
+#define SSP_SYNC_VERSION   1
+#define SSP_SYNC_LENGTH    4
+#define SSP_MAX_WINDOW     8
+#define SSP_FRAME_BUF_SIZE (1 + 1 + 255 + 2)
+
 
 typedef struct {
     uint8_t  *pbuff;
@@ -96,8 +103,20 @@ private:
     void        sf_SendAckPacket(uint8_t seqNumber);
     void     sf_MakePacket(uint8_t *buf, const uint8_t *pdata, uint16_t length, uint8_t seqNo);
     int16_t     sf_ReceivePacket();
+    void        sf_SendFrame(const uint8_t *buf);
+    void        sf_ReceiveAck(uint8_t seqNumber);
+    int16_t     sf_SendWindowProcess();
     uint16_t ssp_SendDataBlock(uint8_t *data, uint16_t length);
     bool debug;
+
+    // Windowed mode, the packets sent and not acknowledged yet, oldest first
+    bool windowed;
+    uint8_t window;
+    uint16_t frameLength;
+    uint8_t windowBuf[SSP_MAX_WINDOW][SSP_FRAME_BUF_SIZE];
+    int windowHead;
+    int windowCount;
+    uint8_t ackBuf[1 + 1 + 2];
 public:
     /** PUBLIC FUNCTIONS **/
     virtual void pfCallBack(uint8_t *, uint16_t); // call back function that is called when a full packet has been received
@@ -108,6 +127,12 @@ public:
     void        ssp_Init(const PortConfig_t *const info);
     int16_t             ssp_ReceiveByte();
     uint16_t    ssp_Synchronise();
+    // True once the board agreed to the windowed mode in ssp_Synchronise
+    bool        ssp_Windowed() const;
+    // Largest payload of a packet, several can be sent before the first is acknowledged in windowed mode
+    uint16_t    ssp_FrameLength() const;
+    bool        ssp_WindowFull() const;
+    int         ssp_Outstanding() const;
     qssp(port *info, bool debug);
 };
 
@@ -26,7 +26,9 @@
  */
 #include "qsspt.h"
 
-qsspt::qsspt(port *info, bool debug) : qssp(info, debug), endthread(false), datapending(false), debug(debug)
+#include <QTime>
+
+qsspt::qsspt(port *info, bool debug) : qssp(info, debug), endthread(false), datapending(false), debug(debug), sendfailed(false)
 {}
 
 void qsspt::run()
@@ -34,6 +36,11 @@ void qsspt::run()
     while (!endthread) {
         receivestatus = this->ssp_ReceiveProcess();
         sendstatus    = this->ssp_SendProcess();
+        if (ssp_Windowed()) {
+            sendPending();
+            msleep(1);
+            continue;
+        }
         msleep(1);
         sendbufmutex.lock();
         if (datapending && receivestatus == SSP_TX_IDLE) {
@@ -46,8 +53,44 @@ void qsspt::run()
         }
     }
 }
+/**
+ * Fills the window with the data queued by sendData, the frames may carry
+ * several messages or part of one: the bootloader handles them as a stream.
+ */
+void qsspt::sendPending()
+{
+    QMutexLocker lock(&sendbufmutex);
+
+    if (sendstatus == SSP_TX_TIMEOUT) {
+        sendfailed = true;
+        pending.clear();
+    }
+    while (!pending.isEmpty() && !ssp_WindowFull()) {
+        int length = qMin(pending.size(), (int)ssp_FrameLength());
+        if (ssp_SendData((const uint8_t *)pending.constData(), length) != SSP_TX_WAITING) {
+            break;
+        }
+        pending.remove(0, length);
+    }
+    pendingwait.wakeAll();
+}
+
 bool qsspt::sendData(uint8_t *buf, uint16_t size)
 {
+    if (ssp_Windowed()) {
+        // Returns once queued, only waits for the window when enough is queued already
+        QMutexLocker lock(&sendbufmutex);
+        while (!sendfailed && pending.size() + size > MAX_PENDING) {
+            if (!pendingwait.wait(&sendbufmutex, 10000)) {
+                return false;
+            }
+        }
+        if (sendfailed) {
+            return false;
+        }
+        pending.append((const char *)buf, size);
+        return true;
+    }
     if (datapending) {
         return false;
     }
@@ -94,6 +137,13 @@ int qsspt::read_Packet(void *data)
 }
 qsspt::~qsspt()
 {
+    // Let the last messages reach the bootloader
+    QTime time;
+
+    time.start();
+    while (ssp_Windowed() && !sendfailed && (!pending.isEmpty() || ssp_Outstanding() > 0) && time.elapsed() < 2000) {
+        msleep(1);
+    }
     endthread = true;
     wait(1000);
 }
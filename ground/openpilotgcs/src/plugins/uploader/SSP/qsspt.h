@@ -54,6 +54,13 @@ private:
     QWaitCondition sendwait;
     QMutex msendwait;
     bool debug;
+
+    // Windowed mode, the data not sent yet, cut in frames as the window opens
+    static const int MAX_PENDING = 4096;
+    QByteArray pending;
+    QWaitCondition pendingwait;
+    bool sendfailed;
+    void sendPending();
 };
 
 #endif // QSSPT_H
@@ -348,11 +348,8 @@ void DeviceWidget::uploadFirmware()
         return;
     }
 
-    bool verify     = false;
-    /* TODO: does not work properly on current Bootloader!
-       if (m_dfu->devices[deviceID].Readable)
-        verify = true;
-     */
+    // Verification only compares the CRC of the flash, it doesn't read the image back
+    bool verify     = true;
 
     QByteArray desc = loadedFW.right(100);
     if (desc.startsWith("OpFw")) {
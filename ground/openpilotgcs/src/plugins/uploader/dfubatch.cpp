@@ -0,0 +1,146 @@
+/**
+ ******************************************************************************
+ *
+ * @file       dfubatch.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Uploader Uploader Plugin
+ * @{
+ * @brief Flashes every connected bootloader in parallel
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "dfubatch.h"
+
+using namespace OP_DFU;
+
+DFUBatch::DFUBatch(bool debug, QObject *parent) : QObject(parent),
+    m_debug(debug), m_failed(0)
+{}
+
+DFUBatch::~DFUBatch()
+{
+    foreach(DFUObject * dfu, m_boards.keys()) {
+        dfu->wait();
+        delete dfu;
+    }
+}
+
+/**
+   Serial numbers of all the boards currently in bootloader mode
+ */
+QStringList DFUBatch::connectedBoards()
+{
+    QStringList serials;
+
+    foreach(USBPortInfo dev, USBMonitor::instance()->availableDevices(0x20a0, -1, -1, USBMonitor::Bootloader)) {
+        if (!dev.serialNumber.isEmpty() && !serials.contains(dev.serialNumber)) {
+            serials << dev.serialNumber;
+        }
+    }
+    return serials;
+}
+
+/**
+   Starts uploading sfile to every connected board, returns how many uploads
+   were started. boardFinished is emitted for each board, then finished.
+ */
+int DFUBatch::start(const QString &sfile, bool verify)
+{
+    if (isRunning()) {
+        return 0;
+    }
+    QFile file(sfile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QByteArray desc = file.readAll().right(100);
+    m_description = desc.startsWith("OpFw") ? desc : QByteArray();
+    m_failed = 0;
+
+    foreach(QString serial, connectedBoards()) {
+        DFUObject *dfu = new DFUObject(m_debug, false, QString(), serial);
+        if (!dfu->ready()) {
+            delete dfu;
+            fail(serial, OP_DFU::abort);
+            continue;
+        }
+        dfu->AbortOperation();
+        if (!dfu->enterDFU(0) || !dfu->findDevices() || dfu->devices.isEmpty() || !dfu->devices[0].Writable) {
+            delete dfu;
+            fail(serial, OP_DFU::abort);
+            continue;
+        }
+        // Packaged firmware must match the board exactly, there is nobody to ask
+        if (!m_description.isEmpty()
+            && (((m_description.at(12) & 0xff) << 8) + (m_description.at(13) & 0xff)) != dfu->devices[0].ID) {
+            delete dfu;
+            fail(serial, OP_DFU::abort);
+            continue;
+        }
+        connect(dfu, SIGNAL(progressUpdated(int)), this, SLOT(onProgress(int)));
+        connect(dfu, SIGNAL(uploadFinished(OP_DFU::Status)), this, SLOT(onUploadFinished(OP_DFU::Status)));
+        m_boards.insert(dfu, serial);
+        dfu->UploadFirmware(sfile, verify, 0);
+    }
+
+    int started = m_boards.count();
+    if (!started) {
+        emit finished(m_failed);
+    }
+    return started;
+}
+
+void DFUBatch::onProgress(int percent)
+{
+    DFUObject *dfu = qobject_cast<DFUObject *>(sender());
+
+    if (m_boards.contains(dfu)) {
+        emit boardProgress(m_boards.value(dfu), percent);
+    }
+}
+
+void DFUBatch::onUploadFinished(OP_DFU::Status status)
+{
+    DFUObject *dfu = qobject_cast<DFUObject *>(sender());
+
+    if (!m_boards.contains(dfu)) {
+        return;
+    }
+    QString serial = m_boards.take(dfu);
+    dfu->wait();
+    if (status == OP_DFU::Last_operation_Success && !m_description.isEmpty()) {
+        status = dfu->UploadDescription(m_description);
+    }
+    dfu->deleteLater();
+
+    if (status != OP_DFU::Last_operation_Success) {
+        fail(serial, status);
+    } else {
+        emit boardFinished(serial, status);
+    }
+    if (m_boards.isEmpty()) {
+        emit finished(m_failed);
+    }
+}
+
+void DFUBatch::fail(const QString &serial, OP_DFU::Status status)
+{
+    ++m_failed;
+    emit boardFinished(serial, status);
+}
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ *
+ * @file       dfubatch.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Uploader Uploader Plugin
+ * @{
+ * @brief Flashes every connected bootloader in parallel
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef DFUBATCH_H
+#define DFUBATCH_H
+
+#include "op_dfu.h"
+#include <QMap>
+#include <QStringList>
+
+/**
+   Uploads one firmware file to all boards sitting in their bootloader.
+   Each board gets its own DFUObject, so the uploads run in parallel.
+ */
+class DFUBatch : public QObject {
+    Q_OBJECT
+
+public:
+    DFUBatch(bool debug, QObject *parent = 0);
+    ~DFUBatch();
+
+    static QStringList connectedBoards();
+
+    int start(const QString &sfile, bool verify);
+    bool isRunning() const
+    {
+        return !m_boards.isEmpty();
+    }
+
+signals:
+    void boardProgress(QString serial, int percent);
+    void boardFinished(QString serial, OP_DFU::Status status);
+    void finished(int failed);
+
+private slots:
+    void onProgress(int percent);
+    void onUploadFinished(OP_DFU::Status status);
+
+private:
+    bool m_debug;
+    int m_failed;
+    QByteArray m_description;
+    QMap<OP_DFU::DFUObject *, QString> m_boards;
+
+    void fail(const QString &serial, OP_DFU::Status status);
+};
+
+#endif // DFUBATCH_H
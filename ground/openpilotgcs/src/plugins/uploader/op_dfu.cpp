@@ -33,7 +33,7 @@
 
 using namespace OP_DFU;
 
-DFUObject::DFUObject(bool _debug, bool _use_serial, QString portname) :
+DFUObject::DFUObject(bool _debug, bool _use_serial, QString portname, QString serialNumber) :
     debug(_debug), use_serial(_use_serial), mready(true)
 {
     info = NULL;
@@ -69,6 +69,15 @@ DFUObject::DFUObject(bool _debug, bool _use_serial, QString portname) :
         }
         qDebug() << "SYNC Succeded";
         serialhandle->start();
+    } else if (!serialNumber.isEmpty()) {
+        // Several bootloaders are on the bus, open the one we were asked for
+        mready = false;
+        foreach(USBPortInfo dev, USBMonitor::instance()->availableDevices(0x20a0, -1, -1, USBMonitor::Bootloader)) {
+            if (dev.serialNumber == serialNumber) {
+                mready = (hidHandle.open(dev.vendorID, dev.productID, serialNumber) == 1);
+                break;
+            }
+        }
     } else {
         mready = false;
         QEventLoop m_eventloop;
@@ -180,7 +189,7 @@ bool DFUObject::enterDFU(int const &devNumber)
    erase the memory to make room for the data. You will have to query
    its status to wait until erase is done before doing the actual upload.
  */
-bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const & type, quint32 crc)
+bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const & type, quint32 crc, bool delta)
 {
     int lastPacketCount;
     qint32 numberOfPackets = numberOfBytes / 4 / 14;
@@ -205,6 +214,14 @@ bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const &
     buf[9]  = crc >> 16;
     buf[10] = crc >> 8;
     buf[11] = crc;
+    // with delta the bootloader only erases the sectors which are not kept
+    quint32 opt = delta ? DFU_DELTA_UPLOAD : 0;
+    buf[12] = 0;
+    buf[13] = 0;
+    buf[14] = opt >> 24;
+    buf[15] = opt >> 16;
+    buf[16] = opt >> 8;
+    buf[17] = opt;
     if (debug) {
         qDebug() << "Number of packets:" << numberOfPackets << " Size of last packet:" << lastPacketCount;
     }
@@ -222,11 +239,22 @@ bool DFUObject::StartUpload(qint32 const & numberOfBytes, TransferTypes const &
 }
 
 
+static bool isKept(QList<OP_DFU::sector> const & kept, quint32 start, quint32 end)
+{
+    foreach(const OP_DFU::sector &sector, kept) {
+        if (start >= sector.Start && end <= sector.Start + sector.Size) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
    Does the actual data upload to the board. Needs to be called once the
    board is ready to accept data following a StartUpload command, and it is erased.
+   Packets holding only data of kept sectors are not sent.
  */
-bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray & data)
+bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray & data, QList<OP_DFU::sector> const & kept)
 {
     int lastPacketCount;
     qint32 numberOfPackets = numberOfBytes / 4 / 14;
@@ -247,50 +275,162 @@ bool DFUObject::UploadData(qint32 const & numberOfBytes, QByteArray & data)
     int packetsize;
     float percentage;
     int laspercentage = 0;
-    for (qint32 packetcount = 0; packetcount < numberOfPackets; ++packetcount) {
+    int retries = 0;
+    int sent    = 0;
+    qint32 packetcount = 0;
+    // Packets are streamed without waiting for the bootloader, which is only
+    // asked for its status once per window. If a packet went missing it reports
+    // the one it expects next and we resend from there.
+    while (packetcount < numberOfPackets) {
         percentage = (float)(packetcount + 1) / numberOfPackets * 100;
         if (laspercentage != (int)percentage) {
             printProgBar((int)percentage, "UPLOADING");
         }
         laspercentage = (int)percentage;
-        if (packetcount == numberOfPackets) {
-            packetsize = lastPacketCount;
+        qint32 next = packetcount;
+        while (next < numberOfPackets) {
+            packetsize = (next == numberOfPackets - 1) ? lastPacketCount : 14;
+            if (!isKept(kept, 4 * 14 * next, 4 * 14 * next + 4 * packetsize)) {
+                break;
+            }
+            ++next;
+        }
+        if (next != packetcount) {
+            if (!UploadSkip(packetcount, next)) {
+                return false;
+            }
+            packetcount = next;
         } else {
-            packetsize = 14;
+            buf[2] = packetcount >> 24; // DFU Count
+            buf[3] = packetcount >> 16; // DFU Count
+            buf[4] = packetcount >> 8; // DFU Count
+            buf[5] = packetcount; // DFU Count
+            char *pointer = data.data();
+            pointer = pointer + 4 * 14 * packetcount;
+            CopyWords(pointer, buf + 6, packetsize * 4);
+            int result = sendData(buf, BUF_LEN);
+            if (result < 1) {
+                return false;
+            }
+            ++packetcount;
+        }
+
+        if ((++sent % UPLOAD_WINDOW) != 0 && packetcount != numberOfPackets) {
+            continue;
+        }
+        quint32 expected = 0;
+        OP_DFU::Status status = StatusRequest(&expected);
+        if (status == OP_DFU::uploading) {
+            continue;
         }
-        // qDebug()<<packetcount;
-        buf[2]  = packetcount >> 24; // DFU Count
-        buf[3]  = packetcount >> 16; // DFU Count
-        buf[4]  = packetcount >> 8; // DFU Count
-        buf[5]  = packetcount; // DFU Count
-        char *pointer = data.data();
-        pointer = pointer + 4 * 14 * packetcount;
-        // qDebug()<<"Packet Number="<<packetcount<<"Data0="<<(int)data[0]<<" Data1="<<(int)data[1]<<" Data0="<<(int)data[2]<<" Data0="<<(int)data[3]<<" buf6="<<(int)buf[6]<<" buf7="<<(int)buf[7]<<" buf8="<<(int)buf[8]<<" buf9="<<(int)buf[9];
-        CopyWords(pointer, buf + 6, packetsize * 4);
-        // for (int y=0;y<packetsize*4;++y)
-        // {
-
-        // qDebug()<<y<<":"<<(int)data[packetcount*14*4+y]<<"---"<<(int)buf[6+y];
-
-
-        // }
-        // qDebug()<<" Data0="<<(int)data[0]<<" Data0="<<(int)data[1]<<" Data0="<<(int)data[2]<<" Data0="<<(int)data[3]<<" buf6="<<(int)buf[6]<<" buf7="<<(int)buf[7]<<" buf8="<<(int)buf[8]<<" buf9="<<(int)buf[9];
-        // delay::msleep(send_delay);
-
-        // if(StatusRequest()!=OP_DFU::uploading) return false;
-        int result = sendData(buf, BUF_LEN);
-        // qDebug()<<"sent:"<<result;
-        if (result < 1) {
+        if (status != OP_DFU::wrong_packet_received || (qint32)expected >= packetcount || ++retries > UPLOAD_RETRIES) {
+            if (debug) {
+                qDebug() << "Upload stopped at packet" << packetcount << "status:" << StatusToString(status);
+            }
             return false;
         }
-
-        // qDebug() << "UPLOAD:"<<"Data="<<(int)buf[6]<<(int)buf[7]<<(int)buf[8]<<(int)buf[9]<<";"<<result << " bytes sent";
+        if (debug) {
+            qDebug() << "Bootloader missed packet" << expected << ", resending from there";
+        }
+        packetcount = expected;
     }
     cout << "\n";
-    // while(true){}
     return true;
 }
 
+/**
+   Asks the bootloader for the CRC of the flash sector holding offset, a size of 0 is past its end
+ */
+bool DFUObject::SectorCRC(quint32 offset, quint32 *start, quint32 *size, quint32 *crc)
+{
+    char buf[BUF_LEN];
+
+    buf[0] = 0x02; // reportID
+    buf[1] = OP_DFU::Req_Sector_CRC; // DFU Command
+    buf[2] = offset >> 24; // DFU Count
+    buf[3] = offset >> 16;
+    buf[4] = offset >> 8;
+    buf[5] = offset;
+    buf[6] = 0;
+    buf[7] = 0;
+    buf[8] = 0;
+    buf[9] = 0;
+
+    if (sendData(buf, BUF_LEN) < 1 || receiveData(buf, BUF_LEN) < 1 || buf[1] != OP_DFU::Rep_Sector_CRC) {
+        return false;
+    }
+    *start = ((quint8)buf[2] << 24) | ((quint8)buf[3] << 16) | ((quint8)buf[4] << 8) | (quint8)buf[5];
+    *size  = ((quint8)buf[6] << 24) | ((quint8)buf[7] << 16) | ((quint8)buf[8] << 8) | (quint8)buf[9];
+    *crc   = ((quint8)buf[10] << 24) | ((quint8)buf[11] << 16) | ((quint8)buf[12] << 8) | (quint8)buf[13];
+    return true;
+}
+
+/**
+   Tells the bootloader a sector already holds the new firmware, during a delta upload
+ */
+bool DFUObject::KeepSector(quint32 offset, quint32 crc)
+{
+    char buf[BUF_LEN];
+
+    buf[0] = 0x02; // reportID
+    buf[1] = OP_DFU::Keep_Sector; // DFU Command
+    buf[2] = offset >> 24; // DFU Count
+    buf[3] = offset >> 16;
+    buf[4] = offset >> 8;
+    buf[5] = offset;
+    buf[6] = crc >> 24; // DFU Data
+    buf[7] = crc >> 16;
+    buf[8] = crc >> 8;
+    buf[9] = crc;
+
+    return sendData(buf, BUF_LEN) > 0;
+}
+
+/**
+   Tells the bootloader the packets from first up to next are not sent, during a delta upload
+ */
+bool DFUObject::UploadSkip(qint32 first, qint32 next)
+{
+    char buf[BUF_LEN];
+
+    buf[0] = 0x02; // reportID
+    buf[1] = OP_DFU::Upload_Skip; // DFU Command
+    buf[2] = first >> 24; // DFU Count
+    buf[3] = first >> 16;
+    buf[4] = first >> 8;
+    buf[5] = first;
+    buf[6] = next >> 24; // DFU Data
+    buf[7] = next >> 16;
+    buf[8] = next >> 8;
+    buf[9] = next;
+
+    return sendData(buf, BUF_LEN) > 0;
+}
+
+/**
+   The sectors of the device whose content is the same in the new firmware.
+   The sector holding the description is always rewritten.
+ */
+QList<OP_DFU::sector> DFUObject::FindKeptSectors(QByteArray const & arr, int device)
+{
+    QList<OP_DFU::sector> kept;
+    quint32 codeSize = devices[device].SizeOfCode;
+    QByteArray image = arr;
+
+    image.append(QByteArray(codeSize - image.length(), 255));
+    OP_DFU::sector sector;
+    for (quint32 offset = 0; offset < codeSize; offset = sector.Start + sector.Size) {
+        if (!SectorCRC(offset, &sector.Start, &sector.Size, &sector.CRC) || sector.Size == 0
+            || sector.Start + sector.Size <= offset || sector.Start + sector.Size > codeSize) {
+            break;
+        }
+        if (sector.CRC == CRCFromQBArray(image.mid(sector.Start, sector.Size), sector.Size)) {
+            kept.append(sector);
+        }
+    }
+    return kept;
+}
+
 /**
    Sends the firmware description to the device
  */
@@ -560,6 +700,15 @@ int DFUObject::JumpToApp(bool safeboot, bool erase)
 }
 
 OP_DFU::Status DFUObject::StatusRequest()
+{
+    return StatusRequest(NULL);
+}
+
+/**
+   Same as StatusRequest(), also returning the packet count the bootloader
+   reports alongside wrong_packet_received
+ */
+OP_DFU::Status DFUObject::StatusRequest(quint32 *count)
 {
     char buf[BUF_LEN];
 
@@ -583,6 +732,9 @@ OP_DFU::Status DFUObject::StatusRequest()
         qDebug() << "StatusRequest: " << result << " bytes received";
     }
     if (buf[1] == OP_DFU::Status_Rep) {
+        if (count) {
+            *count = ((quint8)buf[2] << 24) | ((quint8)buf[3] << 16) | ((quint8)buf[4] << 8) | (quint8)buf[5];
+        }
         return (OP_DFU::Status)buf[6];
     } else {
         return OP_DFU::abort;
@@ -658,6 +810,8 @@ bool DFUObject::findDevices()
             aux = aux << 8 | (quint8)buf[4];
             aux = aux << 8 | (quint8)buf[5];
             devices[x].SizeOfCode = aux;
+            // older bootloaders leave it 0
+            devices[x].SectorDelta = (quint8)buf[16] & DFU_CAP_SECTOR_DELTA;
         }
         if (debug) {
             qDebug() << "Found " << numberOfDevices << " devices";
@@ -670,6 +824,7 @@ bool DFUObject::findDevices()
                 qDebug() << "Device SizeOfDesc=" << devices[x].SizeOfDesc;
                 qDebug() << "BL Version=" << devices[x].BL_Version;
                 qDebug() << "FW CRC=" << devices[x].FW_CRC;
+                qDebug() << "Sector delta=" << devices[x].SectorDelta;
             }
         }
     }
@@ -761,7 +916,56 @@ OP_DFU::Status DFUObject::UploadFirmwareT(const QString &sfile, const bool &veri
         qDebug() << "NEW FIRMWARE CRC=" << crc;
     }
 
-    if (!StartUpload(arr.length(), OP_DFU::FW, crc)) {
+    bool delta = devices[device].SectorDelta;
+    ret = UploadImage(arr, crc, device, delta);
+    if (delta && ret == OP_DFU::CRC_Fail) {
+        // a kept sector changed behind our back, write all of it
+        if (debug) {
+            qDebug() << "Delta upload failed, uploading the whole firmware";
+        }
+        AbortOperation();
+        ret = UploadImage(arr, crc, device, false);
+    }
+    if (ret != OP_DFU::Last_operation_Success) {
+        return ret;
+    }
+
+    // The bootloader already matched the image CRC at the end of the upload,
+    // verifying only reads its freshly computed flash CRC back instead of the whole image
+    if (verify) {
+        emit operationProgress(QString("Verifying firmware"));
+        cout << "Starting code verification\n";
+        if (!findDevices() || device >= devices.length() || devices[device].FW_CRC != crc) {
+            cout << "Verify:FAILED\n";
+            return OP_DFU::abort;
+        }
+    }
+
+    if (debug) {
+        qDebug() << "Status=" << ret;
+    }
+    cout << "Firmware Uploading succeeded\n";
+    return ret;
+}
+
+
+/**
+   Writes the firmware, with delta the sectors which did not change are kept
+   \return the status at the end of the upload
+ */
+OP_DFU::Status DFUObject::UploadImage(QByteArray & arr, quint32 crc, int device, bool delta)
+{
+    OP_DFU::Status ret;
+    QList<OP_DFU::sector> kept;
+
+    if (delta) {
+        kept = FindKeptSectors(arr, device);
+        if (debug) {
+            qDebug() << kept.length() << "sectors unchanged";
+        }
+    }
+
+    if (!StartUpload(arr.length(), OP_DFU::FW, crc, delta)) {
         ret = StatusRequest();
         if (debug) {
             qDebug() << "StartUpload failed";
@@ -793,8 +997,14 @@ OP_DFU::Status DFUObject::UploadFirmwareT(const QString &sfile, const bool &veri
         }
     }
 
+    foreach(const OP_DFU::sector &sector, kept) {
+        if (!KeepSector(sector.Start, sector.CRC)) {
+            return StatusRequest();
+        }
+    }
+
     emit operationProgress(QString("Uploading firmware"));
-    if (!UploadData(arr.length(), arr)) {
+    if (!UploadData(arr.length(), arr, kept)) {
         ret = StatusRequest();
         if (debug) {
             qDebug() << "Upload failed (upload data)";
@@ -810,27 +1020,7 @@ OP_DFU::Status DFUObject::UploadFirmwareT(const QString &sfile, const bool &veri
         }
         return ret;
     }
-    ret = StatusRequest();
-    if (ret != OP_DFU::Last_operation_Success) {
-        return ret;
-    }
-
-    if (verify) {
-        emit operationProgress(QString("Verifying firmware"));
-        cout << "Starting code verification\n";
-        QByteArray arr2;
-        StartDownloadT(&arr2, arr.length(), OP_DFU::FW);
-        if (arr != arr2) {
-            cout << "Verify:FAILED\n";
-            return OP_DFU::abort;
-        }
-    }
-
-    if (debug) {
-        qDebug() << "Status=" << ret;
-    }
-    cout << "Firmware Uploading succeeded\n";
-    return ret;
+    return StatusRequest();
 }
 
 
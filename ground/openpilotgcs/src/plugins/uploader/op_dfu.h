@@ -27,6 +27,15 @@
 using namespace std;
 #define BUF_LEN             64
 
+// Upload packets sent between two status checkpoints, and how often
+// the upload may rewind to a packet the bootloader missed
+#define UPLOAD_WINDOW       32
+#define UPLOAD_RETRIES      3
+
+// Start of an upload keeping the sectors the bootloader already holds, and the capability the bootloader reports for it
+#define DFU_DELTA_UPLOAD     0x44454C54
+#define DFU_CAP_SECTOR_DELTA 0x01
+
 #define MAX_PACKET_DATA_LEN 255
 #define MAX_PACKET_BUF_SIZE (1 + 1 + MAX_PACKET_DATA_LEN + 2)
 
@@ -85,6 +94,10 @@ enum Commands {
     Download, // 10
     Status_Request, // 11
     Status_Rep, // 12
+    Req_Sector_CRC, // 13
+    Rep_Sector_CRC, // 14
+    Keep_Sector, // 15
+    Upload_Skip // 16
 };
 
 enum eBoardType {
@@ -104,6 +117,13 @@ struct device {
     quint32 SizeOfCode;
     bool    Readable;
     bool    Writable;
+    bool    SectorDelta;
+};
+
+struct sector {
+    quint32 Start; // offset in the firmware bank
+    quint32 Size;
+    quint32 CRC;
 };
 
 
@@ -113,7 +133,7 @@ class DFUObject : public QThread {
 public:
     static quint32 CRCFromQBArray(QByteArray array, quint32 Size);
     // DFUObject(bool debug);
-    DFUObject(bool debug, bool use_serial, QString port);
+    DFUObject(bool debug, bool use_serial, QString port, QString serialNumber = QString());
 
     virtual ~DFUObject();
 
@@ -156,7 +176,7 @@ public:
     bool use_delay;
 
     // Helper functions:
-    QString StatusToString(OP_DFU::Status const & status);
+    static QString StatusToString(OP_DFU::Status const & status);
     static quint32 CRC32WideFast(quint32 Crc, quint32 Size, quint32 *Buffer);
     OP_DFU::eBoardType GetBoardType(int boardNum);
 
@@ -175,6 +195,7 @@ private:
     int RWFlags;
     qsspt *serialhandle;
     int sendData(void *, int);
+    OP_DFU::Status StatusRequest(quint32 *count);
     int receiveData(void *data, int size);
     uint8_t sspTxBuf[MAX_PACKET_BUF_SIZE];
     uint8_t sspRxBuf[MAX_PACKET_BUF_SIZE];
@@ -190,8 +211,13 @@ private:
 
     void CopyWords(char *source, char *destination, int count);
     void printProgBar(int const & percent, QString const & label);
-    bool StartUpload(qint32 const &numberOfBytes, TransferTypes const & type, quint32 crc);
-    bool UploadData(qint32 const & numberOfPackets, QByteArray & data);
+    bool StartUpload(qint32 const &numberOfBytes, TransferTypes const & type, quint32 crc, bool delta = false);
+    bool UploadData(qint32 const & numberOfPackets, QByteArray & data, QList<OP_DFU::sector> const & kept = QList<OP_DFU::sector>());
+    bool SectorCRC(quint32 offset, quint32 *start, quint32 *size, quint32 *crc);
+    bool KeepSector(quint32 offset, quint32 crc);
+    bool UploadSkip(qint32 first, qint32 next);
+    QList<OP_DFU::sector> FindKeptSectors(QByteArray const & arr, int device);
+    OP_DFU::Status UploadImage(QByteArray & arr, quint32 crc, int device, bool delta);
 
     // Thread management:
     // Same as startDownload except that we store in an external array:
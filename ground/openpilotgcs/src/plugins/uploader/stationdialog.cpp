@@ -0,0 +1,342 @@
+/**
+ ******************************************************************************
+ *
+ * @file       stationdialog.cpp
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Uploader Uploader Plugin
+ * @{
+ * @brief Production station: flashes and configures every connected board
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "stationdialog.h"
+
+#include <extensionsystem/pluginmanager.h>
+#include <coreplugin/icore.h>
+#include <coreplugin/connectionmanager.h>
+#include <uavtalk/telemetrymanager.h>
+#include <uavobjectutil/uavobjectutilmanager.h>
+#include "uavsettingsimportexport/uavsettingsimportexportfactory.h"
+
+#include <QDialogButtonBox>
+#include <QFileDialog>
+#include <QGridLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTreeWidget>
+
+// How long a freshly booted board has to bring telemetry up
+#define CONNECT_TIMEOUT 30000
+
+StationDialog::StationDialog(QWidget *parent) : QDialog(parent),
+    m_settingErrors(0)
+{
+    setWindowTitle(tr("Production Station"));
+
+    m_firmware = new QLineEdit(this);
+    m_settings = new QLineEdit(this);
+    m_settings->setPlaceholderText(tr("none, only flash the boards"));
+    QPushButton *firmwareButton = new QPushButton(tr("..."), this);
+    QPushButton *settingsButton = new QPushButton(tr("..."), this);
+
+    m_boards = new QTreeWidget(this);
+    m_boards->setRootIsDecorated(false);
+    m_boards->setHeaderLabels(QStringList() << tr("Board") << tr("Status") << tr("Progress"));
+    m_boards->header()->setSectionResizeMode(ColumnStatus, QHeaderView::Stretch);
+
+    m_startButton = new QPushButton(tr("Start"), this);
+    QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    buttons->addButton(m_startButton, QDialogButtonBox::ActionRole);
+
+    QGridLayout *layout = new QGridLayout(this);
+    layout->addWidget(new QLabel(tr("Firmware:"), this), 0, 0);
+    layout->addWidget(m_firmware, 0, 1);
+    layout->addWidget(firmwareButton, 0, 2);
+    layout->addWidget(new QLabel(tr("Settings:"), this), 1, 0);
+    layout->addWidget(m_settings, 1, 1);
+    layout->addWidget(settingsButton, 1, 2);
+    layout->addWidget(new QLabel(tr("Boards are picked up while they are in their bootloader."), this), 2, 0, 1, 3);
+    layout->addWidget(m_boards, 3, 0, 1, 3);
+    layout->addWidget(buttons, 4, 0, 1, 3);
+    resize(600, 400);
+
+    m_batch = new DFUBatch(false, this);
+    connect(m_batch, SIGNAL(boardProgress(QString, int)), this, SLOT(boardProgress(QString, int)));
+    connect(m_batch, SIGNAL(boardFinished(QString, OP_DFU::Status)), this, SLOT(boardFlashed(QString, OP_DFU::Status)));
+    connect(m_batch, SIGNAL(finished(int)), this, SLOT(flashingFinished(int)));
+
+    m_connectTimer.setInterval(500);
+    connect(&m_connectTimer, SIGNAL(timeout()), this, SLOT(checkConnection()));
+
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    connect(pm->getObject<TelemetryManager>(), SIGNAL(connected()), this, SLOT(telemetryConnected()));
+    connect(pm->getObject<UAVObjectUtilManager>(), SIGNAL(saveCompleted(int, bool)), this, SLOT(saveCompleted(int, bool)));
+
+    connect(firmwareButton, SIGNAL(clicked()), this, SLOT(browseFirmware()));
+    connect(settingsButton, SIGNAL(clicked()), this, SLOT(browseSettings()));
+    connect(m_startButton, SIGNAL(clicked()), this, SLOT(start()));
+    connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+}
+
+StationDialog::~StationDialog()
+{}
+
+void StationDialog::browseFirmware()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Select firmware file"), m_firmware->text(),
+                                                    tr("Firmware Files (*.opfw *.bin)"));
+
+    if (!fileName.isEmpty()) {
+        m_firmware->setText(fileName);
+    }
+}
+
+void StationDialog::browseSettings()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Select settings file"), m_settings->text(),
+                                                    tr("UAVObjects XML files (*.uav);; XML files (*.xml);; Binary settings snapshots (*.uavb)"));
+
+    if (!fileName.isEmpty()) {
+        m_settings->setText(fileName);
+    }
+}
+
+void StationDialog::start()
+{
+    if (!QFile::exists(m_firmware->text())) {
+        QMessageBox::warning(this, windowTitle(), tr("Please select a firmware file."));
+        return;
+    }
+    if (!m_settings->text().isEmpty() && !QFile::exists(m_settings->text())) {
+        QMessageBox::warning(this, windowTitle(), tr("The settings file does not exist."));
+        return;
+    }
+
+    // Telemetry and the connection polling would get in the way of DFU
+    Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
+    if (cm->isConnected()) {
+        cm->disconnectDevice();
+    }
+    cm->suspendPolling();
+
+    m_boards->clear();
+    m_toConfigure.clear();
+    foreach(QString serial, DFUBatch::connectedBoards()) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(m_boards, QStringList() << serial << tr("Flashing"));
+        QProgressBar *progress = new QProgressBar(m_boards);
+        progress->setRange(0, 100);
+        m_boards->setItemWidget(item, ColumnProgress, progress);
+    }
+    if (!m_boards->topLevelItemCount()) {
+        cm->resumePolling();
+        QMessageBox::warning(this, windowTitle(), tr("No board in bootloader mode was found."));
+        return;
+    }
+
+    m_startButton->setEnabled(false);
+    m_batch->start(m_firmware->text(), true);
+}
+
+QTreeWidgetItem *StationDialog::boardItem(const QString &serial)
+{
+    QList<QTreeWidgetItem *> items = m_boards->findItems(serial, Qt::MatchExactly, ColumnBoard);
+
+    return items.isEmpty() ? NULL : items.first();
+}
+
+void StationDialog::setBoardStatus(const QString &serial, const QString &text, bool ok)
+{
+    QTreeWidgetItem *item = boardItem(serial);
+
+    if (item) {
+        item->setText(ColumnStatus, text);
+        item->setForeground(ColumnStatus, ok ? palette().text() : QBrush(Qt::red));
+    }
+}
+
+void StationDialog::boardProgress(QString serial, int percent)
+{
+    QTreeWidgetItem *item = boardItem(serial);
+
+    if (item) {
+        QProgressBar *progress = qobject_cast<QProgressBar *>(m_boards->itemWidget(item, ColumnProgress));
+        if (progress) {
+            progress->setValue(percent);
+        }
+    }
+}
+
+void StationDialog::boardFlashed(QString serial, OP_DFU::Status status)
+{
+    if (!boardItem(serial)) {
+        // plugged in after the scan, or refused by DFUBatch before we listed it
+        new QTreeWidgetItem(m_boards, QStringList() << serial);
+    }
+    if (status != OP_DFU::Last_operation_Success) {
+        setBoardStatus(serial, tr("Flashing failed: %1").arg(OP_DFU::DFUObject::StatusToString(status)), false);
+    } else if (m_settings->text().isEmpty()) {
+        setBoardStatus(serial, tr("Flashed and verified"), true);
+    } else {
+        setBoardStatus(serial, tr("Flashed, waiting for configuration"), true);
+        m_toConfigure << serial;
+    }
+}
+
+void StationDialog::flashingFinished(int failed)
+{
+    Q_UNUSED(failed);
+    configureNext();
+}
+
+/**
+   Telemetry only talks to one board at a time, so the flashed boards are
+   booted and configured one after the other
+ */
+void StationDialog::configureNext()
+{
+    if (m_toConfigure.isEmpty()) {
+        finish();
+        return;
+    }
+    m_current = m_toConfigure.takeFirst();
+    setBoardStatus(m_current, tr("Booting"), true);
+
+    OP_DFU::DFUObject *dfu = new OP_DFU::DFUObject(false, false, QString(), m_current);
+    bool booted = dfu->ready() && dfu->JumpToApp(false, false) > 0;
+    delete dfu;
+    if (!booted) {
+        boardConfigured(false, tr("Could not boot the firmware"));
+        return;
+    }
+
+    Core::ICore::instance()->connectionManager()->resumePolling();
+    m_connectTime.start();
+    m_connectTimer.start();
+}
+
+void StationDialog::checkConnection()
+{
+    Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
+
+    if (m_connectTime.elapsed() > CONNECT_TIMEOUT) {
+        boardConfigured(false, tr("No telemetry"));
+        return;
+    }
+    // Autoconnect may have picked a board we already configured
+    if (cm->isConnected() && cm->getCurrentDevice().device.name != m_current) {
+        cm->disconnectDevice();
+    }
+    if (!cm->isConnected()) {
+        foreach(Core::DevListItem d, cm->getAvailableDevices()) {
+            if (d.device.name == m_current) {
+                cm->connectDevice(d);
+                break;
+            }
+        }
+    }
+}
+
+void StationDialog::telemetryConnected()
+{
+    Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
+
+    if (m_current.isEmpty() || !m_connectTimer.isActive() || cm->getCurrentDevice().device.name != m_current) {
+        return;
+    }
+    m_connectTimer.stop();
+    applySettings();
+}
+
+void StationDialog::applySettings()
+{
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVSettingsImportExportFactory *importExport = pm->getObject<UAVSettingsImportExportFactory>();
+    UAVObjectUtilManager *utilMngr = pm->getObject<UAVObjectUtilManager>();
+    QList<UAVSettingsImportExportFactory::ImportedObject> imported;
+
+    setBoardStatus(m_current, tr("Applying settings"), true);
+    if (importExport->importUAVSettings(m_settings->text(), &imported) != UAVSettingsImportExportFactory::ImportOK) {
+        boardConfigured(false, tr("Invalid settings file"));
+        return;
+    }
+
+    m_settingErrors = 0;
+    m_pendingSaves.clear();
+    foreach(UAVSettingsImportExportFactory::ImportedObject obj, imported) {
+        if (!obj.ok || !obj.object) {
+            ++m_settingErrors;
+        } else if (obj.changed && obj.object->isSettingsObject()) {
+            m_pendingSaves << obj.object->getObjID();
+        }
+    }
+    if (m_pendingSaves.isEmpty()) {
+        boardConfigured(m_settingErrors == 0, tr("Nothing to save"));
+        return;
+    }
+    QList<UAVObject *> objects;
+    foreach(UAVSettingsImportExportFactory::ImportedObject obj, imported) {
+        if (obj.ok && obj.changed && obj.object && obj.object->isSettingsObject()) {
+            objects.append(obj.object);
+        }
+    }
+    utilMngr->saveObjectsToSD(objects);
+}
+
+void StationDialog::saveCompleted(int objectID, bool status)
+{
+    if (m_current.isEmpty() || !m_pendingSaves.removeOne(objectID)) {
+        return;
+    }
+    if (!status) {
+        ++m_settingErrors;
+    }
+    if (m_pendingSaves.isEmpty()) {
+        if (m_settingErrors) {
+            boardConfigured(false, tr("%1 setting(s) failed").arg(m_settingErrors));
+        } else {
+            boardConfigured(true, tr("Flashed, configured and verified"));
+        }
+    }
+}
+
+void StationDialog::boardConfigured(bool ok, const QString &text)
+{
+    Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
+
+    m_connectTimer.stop();
+    m_pendingSaves.clear();
+    setBoardStatus(m_current, text, ok);
+    m_current.clear();
+
+    if (cm->isConnected()) {
+        cm->disconnectDevice();
+    }
+    cm->suspendPolling();
+    configureNext();
+}
+
+void StationDialog::finish()
+{
+    Core::ICore::instance()->connectionManager()->resumePolling();
+    m_startButton->setEnabled(true);
+}
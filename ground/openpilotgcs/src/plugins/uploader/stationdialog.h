@@ -0,0 +1,87 @@
+/**
+ ******************************************************************************
+ *
+ * @file       stationdialog.h
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Uploader Uploader Plugin
+ * @{
+ * @brief Production station: flashes and configures every connected board
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef STATIONDIALOG_H
+#define STATIONDIALOG_H
+
+#include "dfubatch.h"
+#include <QDialog>
+#include <QTime>
+#include <QTimer>
+
+class QLineEdit;
+class QPushButton;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+/**
+   Flashes every board sitting in its bootloader in parallel, then boots
+   them one after the other to apply and save a .uav settings file.
+ */
+class StationDialog : public QDialog {
+    Q_OBJECT
+
+public:
+    StationDialog(QWidget *parent = 0);
+    ~StationDialog();
+
+private slots:
+    void browseFirmware();
+    void browseSettings();
+    void start();
+    void boardProgress(QString serial, int percent);
+    void boardFlashed(QString serial, OP_DFU::Status status);
+    void flashingFinished(int failed);
+    void checkConnection();
+    void telemetryConnected();
+    void saveCompleted(int objectID, bool status);
+
+private:
+    enum Column { ColumnBoard, ColumnStatus, ColumnProgress };
+
+    QLineEdit *m_firmware;
+    QLineEdit *m_settings;
+    QPushButton *m_startButton;
+    QTreeWidget *m_boards;
+
+    DFUBatch *m_batch;
+    QStringList m_toConfigure;
+    QString m_current;
+    QTimer m_connectTimer;
+    QTime m_connectTime;
+    QList<int> m_pendingSaves;
+    int m_settingErrors;
+
+    QTreeWidgetItem *boardItem(const QString &serial);
+    void setBoardStatus(const QString &serial, const QString &text, bool ok);
+    void configureNext();
+    void applySettings();
+    void boardConfigured(bool ok, const QString &text);
+    void finish();
+};
+
+#endif // STATIONDIALOG_H
@@ -22,6 +22,8 @@ HEADERS += uploadergadget.h \
     uploadergadgetwidget.h \
     uploaderplugin.h \
     op_dfu.h \
+    dfubatch.h \
+    stationdialog.h \
     delay.h \
     devicewidget.h \
     SSP/port.h \
@@ -41,6 +43,8 @@ SOURCES += uploadergadget.cpp \
     uploadergadgetwidget.cpp \
     uploaderplugin.cpp \
     op_dfu.cpp \
+    dfubatch.cpp \
+    stationdialog.cpp \
     delay.cpp \
     devicewidget.cpp \
     SSP/port.cpp \
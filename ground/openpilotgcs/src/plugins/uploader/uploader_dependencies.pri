@@ -2,5 +2,6 @@ include(../../openpilotgcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri)
 include(../../plugins/uavobjects/uavobjects.pri)
 include(../../plugins/uavobjectutil/uavobjectutil.pri)
+include(../../plugins/uavsettingsimportexport/uavsettingsimportexport.pri)
 include(../../plugins/uavtalk/uavtalk.pri)
 include(../../plugins/ophid/ophid.pri)
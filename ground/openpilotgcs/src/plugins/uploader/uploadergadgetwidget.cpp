@@ -43,6 +43,7 @@
 #include <QProgressBar>
 #include <QDebug>
 #include "rebootdialog.h"
+#include "stationdialog.h"
 
 #define DFU_DEBUG true
 
@@ -159,6 +160,7 @@ UploaderGadgetWidget::UploaderGadgetWidget(QWidget *parent) : QWidget(parent)
     connect(m_config->safeBootButton, SIGNAL(clicked()), this, SLOT(systemSafeBoot()));
     connect(m_config->eraseBootButton, SIGNAL(clicked()), this, SLOT(systemEraseBoot()));
     connect(m_config->rescueButton, SIGNAL(clicked()), this, SLOT(systemRescue()));
+    connect(m_config->stationButton, SIGNAL(clicked()), this, SLOT(openStation()));
 
     getSerialPorts();
 
@@ -856,6 +858,23 @@ void UploaderGadgetWidget::autoUpdateFlashProgress(int value)
    Attempt a guided procedure to put both boards in BL mode when
    the system is not bootable
  */
+void UploaderGadgetWidget::openStation()
+{
+    // The station opens every bootloader itself, ours would be in the way
+    if (m_dfu) {
+        delete m_dfu;
+        m_dfu = NULL;
+    }
+    while (m_config->systemElements->count()) {
+        QWidget *qw = m_config->systemElements->widget(0);
+        m_config->systemElements->removeTab(0);
+        delete qw;
+    }
+
+    StationDialog dialog(this);
+    dialog.exec();
+}
+
 void UploaderGadgetWidget::systemRescue()
 {
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
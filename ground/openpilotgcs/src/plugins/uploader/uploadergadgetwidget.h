@@ -171,6 +171,7 @@ private slots:
     void systemReboot();
     void commonSystemBoot(bool safeboot = false, bool erase = false);
     void systemRescue();
+    void openStation();
     void getSerialPorts();
     void uploadStarted();
     void uploadEnded(bool succeed);
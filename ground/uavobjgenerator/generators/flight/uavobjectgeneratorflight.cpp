@@ -34,6 +34,7 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
                   << "uint16_t" << "uint32_t" << "float" << "uint8_t";
 
     QString flightObjInit, objInc, objFileNames, objNames;
+    QList<quint32> objIds;
     qint32 sizeCalc;
     flightCodePath            = QDir(templatepath + QString(FLIGHT_CODE_DIR));
     flightOutputPath          = QDir(outputpath + QString("flight"));
@@ -60,6 +61,7 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
         objInc.append("#include \"" + info->namelc + ".h\"\n");
         objFileNames.append(" " + info->namelc);
         objNames.append(" " + info->name);
+        objIds.append(info->id);
         if (parser->getNumBytes(objidx) > sizeCalc) {
             sizeCalc = parser->getNumBytes(objidx);
         }
@@ -75,8 +77,17 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser *parser, QString templat
         return false;
     }
 
+    // Sorted table of all object IDs, used by the object manager for lookups by ID
+    qSort(objIds);
+    QString objIdTable;
+    for (int n = 0; n < objIds.length(); ++n) {
+        objIdTable.append(QString("    0x%1, \\\n").arg(QString("%1").arg(objIds[n], 8, 16, QChar('0')).toUpper()));
+    }
+
     // Write the flight object initialization header
     flightInitIncludeTemplate.replace(QString("$(SIZECALCULATION)"), QString().setNum(sizeCalc));
+    flightInitIncludeTemplate.replace(QString("$(OBJCOUNT)"), QString().setNum(objIds.length()));
+    flightInitIncludeTemplate.replace(QString("$(OBJIDTABLE)"), objIdTable);
     res = writeFileIfDiffrent(flightOutputPath.absolutePath() + "/uavobjectsinit.h",
                               flightInitIncludeTemplate);
     if (!res) {
@@ -204,194 +215,72 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo *info)
     }
     outInclude.replace(QString("$(DATAFIELDINFO)"), enums);
 
-    // Replace the $(INITFIELDS) tag
+    // Replace the $(DEFAULTDATA) tag, the default field values as a const initializer
     QString initfields;
     for (int n = 0; n < info->fields.length(); ++n) {
         if (!info->fields[n]->defaultValues.isEmpty()) {
-            // For non-array fields
-            if (info->fields[n]->numElements == 1) {
+            QStringList values;
+            for (int idx = 0; idx < info->fields[n]->numElements; ++idx) {
+                QString value;
                 if (info->fields[n]->type == FIELDTYPE_ENUM) {
-                    initfields.append(QString("    data.%1 = %2;\n")
-                                      .arg(info->fields[n]->name)
-                                      .arg(info->fields[n]->options.indexOf(info->fields[n]->defaultValues[0])));
+                    value = QString("%1").arg(info->fields[n]->options.indexOf(info->fields[n]->defaultValues[idx]));
                 } else if (info->fields[n]->type == FIELDTYPE_FLOAT32) {
-                    initfields.append(QString("    data.%1 = %2f;\n")
-                                      .arg(info->fields[n]->name)
-                                      .arg(info->fields[n]->defaultValues[0].toFloat(), 0, 'e', 6));
+                    value = QString("%1f").arg(info->fields[n]->defaultValues[idx].toFloat(), 0, 'e', 6);
                 } else {
-                    initfields.append(QString("    data.%1 = %2;\n")
-                                      .arg(info->fields[n]->name)
-                                      .arg(info->fields[n]->defaultValues[0].toInt()));
+                    value = QString("%1").arg(info->fields[n]->defaultValues[idx].toInt());
                 }
-            } else {
-                // Initialize all fields in the array
-                for (int idx = 0; idx < info->fields[n]->numElements; ++idx) {
-                    if (info->fields[n]->elementNames[0].compare(QString("0")) == 0) {
-                        initfields.append(QString("    data.%1[%2] = ")
-                                          .arg(info->fields[n]->name)
-                                          .arg(idx));
-                    } else {
-                        initfields.append(QString("    data.%1.%2 = ")
-                                          .arg(info->fields[n]->name)
-                                          .arg(info->fields[n]->elementNames[idx]));
-                    }
-
-
-                    if (info->fields[n]->type == FIELDTYPE_ENUM) {
-                        initfields.append(QString("%1;\n")
-                                          .arg(info->fields[n]->options.indexOf(info->fields[n]->defaultValues[idx])));
-                    } else if (info->fields[n]->type == FIELDTYPE_FLOAT32) {
-                        initfields.append(QString("%1f;\n")
-                                          .arg(info->fields[n]->defaultValues[idx].toFloat(), 0, 'e', 6));
-                    } else {
-                        initfields.append(QString("%1;\n")
-                                          .arg(info->fields[n]->defaultValues[idx].toInt()));
-                    }
+                // Elements of named sets are initialized by name
+                if (info->fields[n]->numElements > 1 && info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
+                    value = QString(".%1 = %2").arg(info->fields[n]->elementNames[idx]).arg(value);
                 }
+                values.append(value);
             }
-        }
-    }
-    outCode.replace(QString("$(INITFIELDS)"), initfields);
-
-    // Replace the $(SETGETFIELDS) tag
-    QString setgetfields;
-    for (int n = 0; n < info->fields.length(); ++n) {
-        // if (!info->fields[n]->defaultValues.isEmpty() )
-        {
-            // For non-array fields
             if (info->fields[n]->numElements == 1) {
-                /* Set */
-                setgetfields.append(QString("void %2%3Set(%1 *New%3)\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), sizeof(%3));\n")
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
-
-                /* GET */
-                setgetfields.append(QString("void %2%3Get(%1 *New%3)\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), sizeof(%3));\n")
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
+                initfields.append(QString("    .%1 = %2,\n").arg(info->fields[n]->name).arg(values[0]));
             } else {
-                // When no struct accessor is available for a field array accessor is the default.
-                QString suffix = QString("");
-
-                if (info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
-                    // struct based field accessor
-                    QString structTypeName = QString("%1%2Data").arg(info->name).arg(info->fields[n]->name);
-                    /* SET */
-                    setgetfields.append(QString("void %2%3Set( %1 *New%3 )\n")
-                                        .arg(structTypeName)
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name));
-                    setgetfields.append(QString("{\n"));
-                    setgetfields.append(QString("    UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name)
-                                        .arg(info->fields[n]->numElements)
-                                        .arg(fieldTypeStrC[info->fields[n]->type]));
-                    setgetfields.append(QString("}\n"));
-
-                    /* GET */
-                    setgetfields.append(QString("void %2%3Get( %1 *New%3 )\n")
-                                        .arg(structTypeName)
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name));
-                    setgetfields.append(QString("{\n"));
-                    setgetfields.append(QString("    UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
-                                        .arg(info->name)
-                                        .arg(info->fields[n]->name)
-                                        .arg(info->fields[n]->numElements)
-                                        .arg(fieldTypeStrC[info->fields[n]->type]));
-                    setgetfields.append(QString("}\n"));
-
-                    // Append array suffix to array accessors
-                    suffix = QString("Array");
-                }
-
-                // array based field accessor
-                /* SET */
-                setgetfields.append(QString("void %2%3%4Set( %1 *New%3 )\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(suffix));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(info->fields[n]->numElements)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
-
-                /* GET */
-                setgetfields.append(QString("void %2%3%4Get( %1 *New%3 )\n")
-                                    .arg(fieldTypeStrC[info->fields[n]->type])
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(suffix));
-                setgetfields.append(QString("{\n"));
-                setgetfields.append(QString("    UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %3*sizeof(%4));\n")
-                                    .arg(info->name)
-                                    .arg(info->fields[n]->name)
-                                    .arg(info->fields[n]->numElements)
-                                    .arg(fieldTypeStrC[info->fields[n]->type]));
-                setgetfields.append(QString("}\n"));
+                initfields.append(QString("    .%1 = { %2 },\n").arg(info->fields[n]->name).arg(values.join(", ")));
             }
         }
     }
-    outCode.replace(QString("$(SETGETFIELDS)"), setgetfields);
+    // Objects without defaults are cleared instead, they take no table
+    if (initfields.isEmpty()) {
+        outCode.replace(QString("$(DEFAULTDATA)"), QString());
+        outCode.replace(QString("$(DEFAULTDATAPTR)"), QString("NULL"));
+    } else {
+        outCode.replace(QString("$(DEFAULTDATA)"),
+                        QString("// Default field values, in flash\nstatic const %1Data defaultData = {\n%2};\n\n").arg(info->name).arg(initfields));
+        outCode.replace(QString("$(DEFAULTDATAPTR)"), QString("&defaultData"));
+    }
 
-    // Replace the $(SETGETFIELDSEXTERN) tag
-    QString setgetfieldsextern;
+    // Replace the $(SETGETFIELDS) tag, the field accessors are inline as the offset and size are constants
+    QString setgetfields;
     for (int n = 0; n < info->fields.length(); ++n) {
-        // if (!info->fields[n]->defaultValues.isEmpty() )
-        {
-            QString suffix = QString("");
-            if (info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
-                // struct based field accessor
-                QString structTypeName = QString("%1%2Data").arg(info->name).arg(info->fields[n]->name);
-
-                /* SET */
-                setgetfieldsextern.append(QString("extern void %2%3Set(%1 *New%3);\n")
-                                          .arg(structTypeName)
-                                          .arg(info->name)
-                                          .arg(info->fields[n]->name));
-
-                /* GET */
-                setgetfieldsextern.append(QString("extern void %2%3Get(%1 *New%3);\n")
-                                          .arg(structTypeName)
-                                          .arg(info->name)
-                                          .arg(info->fields[n]->name));
-                suffix = QString("Array");
-            }
-            /* SET */
-            setgetfieldsextern.append(QString("extern void %2%3%4Set(%1 *New%3);\n")
-                                      .arg(fieldTypeStrC[info->fields[n]->type])
-                                      .arg(info->name)
-                                      .arg(info->fields[n]->name)
-                                      .arg(suffix));
-
-            /* GET */
-            setgetfieldsextern.append(QString("extern void %2%3%4Get(%1 *New%3);\n")
-                                      .arg(fieldTypeStrC[info->fields[n]->type])
-                                      .arg(info->name)
-                                      .arg(info->fields[n]->name)
-                                      .arg(suffix));
+        QString type   = fieldTypeStrC[info->fields[n]->type];
+        QString name   = info->fields[n]->name;
+        QString size   = (info->fields[n]->numElements == 1) ? QString("sizeof(%1)").arg(type) :
+                         QString("%1 * sizeof(%2)").arg(info->fields[n]->numElements).arg(type);
+        QString suffix = QString("");
+
+        if (info->fields[n]->elementNames[0].compare(QString("0")) != 0) {
+            // struct based field accessor
+            QString structTypeName = QString("%1%2Data").arg(info->name).arg(name);
+
+            setgetfields.append(QString("static inline void %1%2Set(%3 *New%2) { UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %4); }\n")
+                                .arg(info->name).arg(name).arg(structTypeName).arg(size));
+            setgetfields.append(QString("static inline void %1%2Get(%3 *New%2) { UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %4); }\n")
+                                .arg(info->name).arg(name).arg(structTypeName).arg(size));
+
+            // Append array suffix to array accessors
+            suffix = QString("Array");
         }
+
+        // array based field accessor, or plain field accessor for single element fields
+        setgetfields.append(QString("static inline void %1%2%3Set(%4 *New%2) { UAVObjSetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %5); }\n")
+                            .arg(info->name).arg(name).arg(suffix).arg(type).arg(size));
+        setgetfields.append(QString("static inline void %1%2%3Get(%4 *New%2) { UAVObjGetDataField(%1Handle(), (void *)New%2, offsetof(%1Data, %2), %5); }\n")
+                            .arg(info->name).arg(name).arg(suffix).arg(type).arg(size));
     }
-    outInclude.replace(QString("$(SETGETFIELDSEXTERN)"), setgetfieldsextern);
+    outInclude.replace(QString("$(SETGETFIELDS)"), setgetfields);
 
     // Write the flight code
     bool res = writeFileIfDiffrent(flightOutputPath.absolutePath() + "/" + info->namelc + ".c", outCode);
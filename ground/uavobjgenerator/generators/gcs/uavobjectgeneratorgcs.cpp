@@ -104,6 +104,13 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
     }
     outInclude.replace(QString("$(DATAFIELDS)"), fields);
 
+    // Replace the $(NUMBYTES) tag with the packed size, checked against the data fields at compile time
+    int numBytes = 0;
+    for (int n = 0; n < info->fields.length(); ++n) {
+        numBytes += info->fields[n]->numBytes * info->fields[n]->numElements;
+    }
+    outInclude.replace(QString("$(NUMBYTES)"), QString().setNum(numBytes));
+
     // Replace $(PROPERTIES) and related tags
     QString properties;
     QString propertiesImpl;
@@ -131,15 +138,11 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
             // field_element is more convenient if only certain element is used
             // and much easier to use from the qml side
             propertyGetters +=
-                QString("    Q_INVOKABLE %1 get%2(quint32 index) const;\n")
+                QString("    Q_INVOKABLE %1 get%2(quint32 index) const\n"
+                        "    {\n"
+                        "        return readValue<%1>(offsetof(DataFields, %2) + index * sizeof(%1));\n"
+                        "    }\n")
                 .arg(type).arg(field->name);
-            propertiesImpl  +=
-                QString("%1 %2::get%3(quint32 index) const\n"
-                        "{\n"
-                        "   QMutexLocker locker(mutex);\n"
-                        "   return data.%3[index];\n"
-                        "}\n")
-                .arg(type).arg(info->name).arg(field->name);
             propertySetters +=
                 QString("    void set%1(quint32 index, %2 value);\n")
                 .arg(field->name).arg(type);
@@ -148,7 +151,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
                         "{\n"
                         "   mutex->lock();\n"
                         "   bool changed = data.%2[index] != value;\n"
+                        "   beginDataUpdate();\n"
                         "   data.%2[index] = value;\n"
+                        "   endDataUpdate();\n"
                         "   mutex->unlock();\n"
                         "   if (changed) emit %2Changed(index,value);\n"
                         "}\n\n")
@@ -162,15 +167,11 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
                 properties += QString("    Q_PROPERTY(%1 %2 READ get%2 WRITE set%2 NOTIFY %2Changed);\n")
                               .arg(type).arg(field->name + "_" + elementName);
                 propertyGetters +=
-                    QString("    Q_INVOKABLE %1 get%2_%3() const;\n")
-                    .arg(type).arg(field->name).arg(elementName);
-                propertiesImpl  +=
-                    QString("%1 %2::get%3_%4() const\n"
-                            "{\n"
-                            "   QMutexLocker locker(mutex);\n"
-                            "   return data.%3[%5];\n"
-                            "}\n")
-                    .arg(type).arg(info->name).arg(field->name).arg(elementName).arg(elementIndex);
+                    QString("    Q_INVOKABLE %1 get%2_%3() const\n"
+                            "    {\n"
+                            "        return readValue<%1>(offsetof(DataFields, %2) + %4 * sizeof(%1));\n"
+                            "    }\n")
+                    .arg(type).arg(field->name).arg(elementName).arg(elementIndex);
                 propertySetters +=
                     QString("    void set%1_%2(%3 value);\n")
                     .arg(field->name).arg(elementName).arg(type);
@@ -179,7 +180,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
                             "{\n"
                             "   mutex->lock();\n"
                             "   bool changed = data.%2[%5] != value;\n"
+                            "   beginDataUpdate();\n"
                             "   data.%2[%5] = value;\n"
+                            "   endDataUpdate();\n"
                             "   mutex->unlock();\n"
                             "   if (changed) emit %2_%3Changed(value);\n"
                             "}\n\n")
@@ -188,23 +191,20 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
                     QString("    void %1_%2Changed(%3 value);\n")
                     .arg(field->name).arg(elementName).arg(type);
                 propertyNotificationsImpl +=
-                    QString("        //if (data.%1[%2] != oldData.%1[%2])\n"
-                            "            emit %1_%3Changed(data.%1[%2]);\n")
+                    QString("    if (notifiedData.%1[%2] != oldData.%1[%2]) {\n"
+                            "        emit %1_%3Changed(notifiedData.%1[%2]);\n"
+                            "    }\n")
                     .arg(field->name).arg(elementIndex).arg(elementName);
             }
         } else {
             properties += QString("    Q_PROPERTY(%1 %2 READ get%2 WRITE set%2 NOTIFY %2Changed);\n")
                           .arg(type).arg(field->name);
             propertyGetters +=
-                QString("    Q_INVOKABLE %1 get%2() const;\n")
+                QString("    Q_INVOKABLE %1 get%2() const\n"
+                        "    {\n"
+                        "        return readValue<%1>(offsetof(DataFields, %2));\n"
+                        "    }\n")
                 .arg(type).arg(field->name);
-            propertiesImpl  +=
-                QString("%1 %2::get%3() const\n"
-                        "{\n"
-                        "   QMutexLocker locker(mutex);\n"
-                        "   return data.%3;\n"
-                        "}\n")
-                .arg(type).arg(info->name).arg(field->name);
             propertySetters +=
                 QString("    void set%1(%2 value);\n")
                 .arg(field->name).arg(type);
@@ -213,7 +213,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
                         "{\n"
                         "   mutex->lock();\n"
                         "   bool changed = data.%2 != value;\n"
+                        "   beginDataUpdate();\n"
                         "   data.%2 = value;\n"
+                        "   endDataUpdate();\n"
                         "   mutex->unlock();\n"
                         "   if (changed) emit %2Changed(value);\n"
                         "}\n\n")
@@ -222,8 +224,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
                 QString("    void %1Changed(%2 value);\n")
                 .arg(field->name).arg(type);
             propertyNotificationsImpl +=
-                QString("        //if (data.%1 != oldData.%1)\n"
-                        "            emit %1Changed(data.%1);\n")
+                QString("    if (notifiedData.%1 != oldData.%1) {\n"
+                        "        emit %1Changed(notifiedData.%1);\n"
+                        "    }\n")
                 .arg(field->name);
         }
     }
@@ -237,29 +240,28 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
     outCode.replace(QString("$(NOTIFY_PROPERTIES_CHANGED)"), propertyNotificationsImpl);
 
     // Replace the $(FIELDSINIT) tag
+    // The name lists are built once per class, the fields of every instance share them
     QString finit;
     for (int n = 0; n < info->fields.length(); ++n) {
         // Setup element names
         QString varElemName   = info->fields[n]->name + "ElemNames";
-        finit.append(QString("    QStringList %1;\n").arg(varElemName));
         QStringList elemNames = info->fields[n]->elementNames;
+        finit.append(QString("    static const QStringList %1 = QStringList()").arg(varElemName));
         for (int m = 0; m < elemNames.length(); ++m) {
-            finit.append(QString("    %1.append(\"%2\");\n")
-                         .arg(varElemName)
-                         .arg(elemNames[m]));
+            finit.append(QString(" << QStringLiteral(\"%1\")").arg(elemNames[m]));
         }
+        finit.append(";\n");
 
         // Only for enum types
         if (info->fields[n]->type == FIELDTYPE_ENUM) {
             QString varOptionName = info->fields[n]->name + "EnumOptions";
-            finit.append(QString("    QStringList %1;\n").arg(varOptionName));
             QStringList options   = info->fields[n]->options;
+            finit.append(QString("    static const QStringList %1 = QStringList()").arg(varOptionName));
             for (int m = 0; m < options.length(); ++m) {
-                finit.append(QString("    %1.append(\"%2\");\n")
-                             .arg(varOptionName)
-                             .arg(options[m]));
+                finit.append(QString(" << QStringLiteral(\"%1\")").arg(options[m]));
             }
-            finit.append(QString("    fields.append( new UAVObjectField(QString(\"%1\"), tr(\"%2\"), QString(\"%3\"), UAVObjectField::ENUM, %4, %5, QString(\"%6\")));\n")
+            finit.append(";\n");
+            finit.append(QString("    fields.append( new UAVObjectField(QStringLiteral(\"%1\"), tr(\"%2\"), QStringLiteral(\"%3\"), UAVObjectField::ENUM, %4, %5, QStringLiteral(\"%6\")));\n")
                          .arg(info->fields[n]->name)
                          .arg(info->fields[n]->description)
                          .arg(info->fields[n]->units)
@@ -269,7 +271,7 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
         }
         // For all other types
         else {
-            finit.append(QString("    fields.append( new UAVObjectField(QString(\"%1\"), tr(\"%2\"), QString(\"%3\"), UAVObjectField::%4, %5, QStringList(), QString(\"%6\")));\n")
+            finit.append(QString("    fields.append( new UAVObjectField(QStringLiteral(\"%1\"), tr(\"%2\"), QStringLiteral(\"%3\"), UAVObjectField::%4, %5, QStringList(), QStringLiteral(\"%6\")));\n")
                          .arg(info->fields[n]->name)
                          .arg(info->fields[n]->description)
                          .arg(info->fields[n]->units)
@@ -285,6 +287,10 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo *info)
     QString enums;
     for (int n = 0; n < info->fields.length(); ++n) {
         enums.append(QString("    // Field %1 information\n").arg(info->fields[n]->name));
+        // Position in getFields(), binds a field once without the name lookup of getField()
+        enums.append(QString("    static const quint32 FIELDINDEX_%1 = %2;\n")
+                     .arg(info->fields[n]->name.toUpper())
+                     .arg(n));
         // Only for enum types
         if (info->fields[n]->type == FIELDTYPE_ENUM) {
             enums.append(QString("    /* Enumeration options for field %1 */\n").arg(info->fields[n]->name));
@@ -75,6 +75,8 @@ void replaceCommonTags(QString & out, ObjectInfo *info)
     // Replace $(ISPRIORITY) tag
     out.replace(QString("$(ISPRIORITY)"), boolTo01String(info->isPriority));
     out.replace(QString("$(ISPRIORITYTF)"), boolToTRUEFALSEString(info->isPriority));
+    // Replace $(NUMINSTANCES) tag
+    out.replace(QString("$(NUMINSTANCES)"), QString().setNum(info->numInstances));
     // Replace $(GCSACCESS) tag
     value = accessModeStr[info->gcsAccess];
     out.replace(QString("$(GCSACCESS)"), value);
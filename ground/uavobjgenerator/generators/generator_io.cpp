@@ -73,12 +73,29 @@ bool writeFile(QString name, QString & str)
 }
 
 /**
- * Write contents of string to file if the content changes
+ * Write contents of string to file if the content changes, so that the
+ * timestamp of unchanged outputs is kept and they are not rebuilt
  */
 bool writeFileIfDiffrent(QString name, QString & str)
 {
-    if (str == readFile(name, false)) {
-        return true;
+    QByteArray bytes;
+    QTextStream bytesStr(&bytes, QIODevice::WriteOnly);
+
+    bytesStr << str;
+    bytesStr.flush();
+
+    QFile file(name);
+    if (file.size() == bytes.size() && file.open(QFile::ReadOnly)) {
+        bool same = (file.readAll() == bytes);
+        file.close();
+        if (same) {
+            return true;
+        }
     }
-    return writeFile(name, str);
+    if (!file.open(QFile::WriteOnly)) {
+        return false;
+    }
+    bool res = (file.write(bytes) == bytes.size());
+    file.close();
+    return res;
 }
@@ -36,6 +36,14 @@ bool UAVObjectGeneratorJava::generate(UAVObjectParser *parser, QString templatep
     fieldTypeStrCPPClass << "INT8" << "INT16" << "INT32"
                          << "UINT8" << "UINT16" << "UINT32" << "FLOAT32" << "ENUM";
 
+    // unsigned types are kept in the next wider signed type
+    fieldTypeStrPrimitive << "byte" << "short" << "int" <<
+        "short" << "int" << "long" << "float" << "byte";
+
+    fieldTypeStrRead << "data.get()" << "data.getShort()" << "data.getInt()" <<
+        "(short)(data.get() & 0xFF)" << "(data.getShort() & 0xFFFF)" << "(data.getInt() & 0xFFFFFFFFL)" <<
+        "data.getFloat()" << "data.get()";
+
     javaCodePath     = QDir(templatepath + QString(JAVA_TEMPLATE_DIR));
     javaOutputPath   = QDir(outputpath + QString("java"));
     javaOutputPath.mkpath(javaOutputPath.absolutePath());
@@ -237,6 +245,29 @@ bool UAVObjectGeneratorJava::process_object(ObjectInfo *info)
 
     outCode.replace(QString("$(INITFIELDS)"), initfields);
 
+    // Replace the $(PRIMITIVEFIELDS) and $(UNPACKFIELDS) tags, fields are in packing order
+    QString primitives;
+    QString unpack;
+    for (int n = 0; n < info->fields.length(); ++n) {
+        FieldInfo *field = info->fields[n];
+        primitives.append(QString("\t\tpublic final %1[] %2 = new %1[%3];\n")
+                          .arg(fieldTypeStrPrimitive[field->type])
+                          .arg(field->name)
+                          .arg(field->numElements));
+        if (field->numElements == 1) {
+            unpack.append(QString("\t\t\t%1[0] = %2;\n")
+                          .arg(field->name)
+                          .arg(fieldTypeStrRead[field->type]));
+        } else {
+            unpack.append(QString("\t\t\tfor (int n = 0; n < %1; n++)\n\t\t\t\t%2[n] = %3;\n")
+                          .arg(field->numElements)
+                          .arg(field->name)
+                          .arg(fieldTypeStrRead[field->type]));
+        }
+    }
+    outCode.replace(QString("$(PRIMITIVEFIELDS)"), primitives);
+    outCode.replace(QString("$(UNPACKFIELDS)"), unpack);
+
     // Write the java code
     bool res = writeFileIfDiffrent(javaOutputPath.absolutePath() + "/" + info->name + ".java", outCode);
     if (!res) {
@@ -41,6 +41,7 @@ private:
 
     QString javaCodeTemplate, javaIncludeTemplate;
     QStringList fieldTypeStrCPP, fieldTypeStrCPPClass;
+    QStringList fieldTypeStrPrimitive, fieldTypeStrRead;
     QDir javaCodePath;
     QDir javaOutputPath;
 };
@@ -54,12 +54,11 @@ bool UAVObjectGeneratorMatlab::generate(UAVObjectParser *parser, QString templat
 
     matlabCodeTemplate.replace(QString("$(INSTANTIATIONCODE)"), matlabInstantiationCode);
     matlabCodeTemplate.replace(QString("$(SWITCHCODE)"), matlabSwitchCode);
-    matlabCodeTemplate.replace(QString("$(CLEANUPCODE)"), matlabCleanupCode);
     matlabCodeTemplate.replace(QString("$(SAVEOBJECTSCODE)"), matlabSaveObjectsCode);
     matlabCodeTemplate.replace(QString("$(ALLOCATIONCODE)"), matlabAllocationCode);
     matlabCodeTemplate.replace(QString("$(EXPORTCSVCODE)"), matlabExportCsvCode);
 
-    bool res = writeFile(matlabOutputPath.absolutePath() + "/OPLogConvert.m", matlabCodeTemplate);
+    bool res = writeFileIfDiffrent(matlabOutputPath.absolutePath() + "/OPLogConvert.m", matlabCodeTemplate);
     if (!res) {
         cout << "Error: Could not write output files" << endl;
         return false;
@@ -113,25 +112,18 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo *info, int numBytes)
     matlabInstantiationCode.append("\t" + objectTableName.toUpper() + "_OBJID=" + objectID + ";\n");
     matlabInstantiationCode.append("\t" + objectTableName.toUpper() + "_NUMBYTES=" + numBytesString + ";\n");
     matlabInstantiationCode.append("\t" + objectName + "FidIdx = [];\n");
+    matlabInstantiationCode.append("\tknownObjIDs = [knownObjIDs " + objectTableName.toUpper() + "_OBJID];\n");
 
 
-    // ==============================================================//
-    // Generate 'Switch:' code (will replace the $(SWITCHCODE) tag) //
-    // ==============================================================//
-    matlabSwitchCode.append("\t\tcase " + objectTableName.toUpper() + "_OBJID\n");
-    matlabSwitchCode.append("\t\t\t" + tableIdxName + " = " + tableIdxName + " + 1;\n");
-    matlabSwitchCode.append("\t\t\t" + objectTableName + "FidIdx(" + tableIdxName + ") = bufferIdx; %#ok<*AGROW>\n");
-    matlabSwitchCode.append("\t\t\tbufferIdx=bufferIdx + " + objectTableName.toUpper() + "_NUMBYTES+1; %+1 is for CRC\n");
-    matlabSwitchCode.append("\t\t\tif " + tableIdxName + " >= length(" + objectTableName + "FidIdx) %Check to see if pre-allocated memory is exhausted\n");
-    matlabSwitchCode.append("\t\t\t\t" + objectTableName + "FidIdx(" + tableIdxName + "*2) = 0;\n");
-    matlabSwitchCode.append("\t\t\tend\n");
+    // ==============================================================================//
+    // Generate message selection code (will replace the $(SWITCHCODE) tag)         //
+    // ==============================================================================//
+    matlabSwitchCode.append("% " + objectName + " messages\n");
+    matlabSwitchCode.append(tableIdxName + " = objIDs == " + objectTableName.toUpper() + "_OBJID & dataSize == " + objectTableName.toUpper() + "_NUMBYTES;\n");
+    matlabSwitchCode.append(objectTableName + "FidIdx = dataIdx(" + tableIdxName + ");\n");
+    matlabSwitchCode.append(objectTableName + "RecordIdx = recordIdx(" + tableIdxName + ");\n");
 
 
-    // ============================================================//
-    // Generate 'Cleanup:' code (will replace the $(CLEANUP) tag) //
-    // ============================================================//
-    matlabCleanupCode.append(objectTableName + "FidIdx =" + objectTableName + "FidIdx(1:" + tableIdxName + ");\n");
-
     // =================================================================//
     // Generate functions code (will replace the $(ALLOCATIONCODE) tag) //
     // =================================================================//
@@ -141,16 +133,16 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo *info, int numBytes)
 
     // Add timestamp
     allocationFields.append("\t" + objectName + ".timestamp = " +
-                            "double(typecast(buffer(mcolon(" + objectName + "FidIdx "
-                            "- headerLen - oplHeaderLen, " + objectName + "FidIdx + 3 - headerLen - oplHeaderLen)), 'uint32'))';\n");
+                            "double(typecast(buffer(mcolon(" + objectName + "RecordIdx "
+                            "- oplHeaderLen, " + objectName + "RecordIdx + 3 - oplHeaderLen)), 'uint32'))';\n");
 
     int currentIdx = 0;
 
     // Add Instance ID, if necessary
     if (!info->isSingleInst) {
         allocationFields.append("\t" + objectName + ".instanceID = " +
-                                "double(typecast(buffer(mcolon(" + objectName + "FidIdx - 2"
-                                ", " + objectName + "FidIdx - 2 + 1)), 'uint16'))';\n");
+                                "double(typecast(buffer(mcolon(" + objectName + "RecordIdx + 8"
+                                ", " + objectName + "RecordIdx + 8 + 1)), 'uint16'))';\n");
     }
 
     for (int n = 0; n < info->fields.length(); ++n) {
@@ -39,7 +39,6 @@ private:
     bool process_object(ObjectInfo *info, int numBytes);
     QString matlabInstantiationCode;
     QString matlabSwitchCode;
-    QString matlabCleanupCode;
     QString matlabAllocationCode;
     QString matlabSaveObjectsCode;
     QString matlabExportCsvCode;
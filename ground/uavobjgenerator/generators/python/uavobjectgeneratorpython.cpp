@@ -34,7 +34,8 @@ bool UAVObjectGeneratorPython::generate(UAVObjectParser *parser, QString templat
     pythonOutputPath   = QDir(outputpath + QString("python"));
     pythonOutputPath.mkpath(pythonOutputPath.absolutePath());
     pythonCodeTemplate = readFile(pythonCodePath.absoluteFilePath("uavobject.pyt.template"));
-    if (pythonCodeTemplate.isEmpty()) {
+    pythonDtypesTemplate = readFile(QDir(templatepath + QString("ground/openpilotgcs/src/plugins/uavobjects")).absoluteFilePath("uavodtypes.py.template"));
+    if (pythonCodeTemplate.isEmpty() || pythonDtypesTemplate.isEmpty()) {
         std::cerr << "Problem reading python templates" << endl;
         return false;
     }
@@ -45,7 +46,44 @@ bool UAVObjectGeneratorPython::generate(UAVObjectParser *parser, QString templat
         process_object(info);
     }
 
-    return true; // if we come here everything should be fine
+    return process_dtypes(parser);
+}
+
+/**
+ * Generate the numpy record types used by the log reader, opllog.py
+ */
+bool UAVObjectGeneratorPython::process_dtypes(UAVObjectParser *parser)
+{
+    // Same order as FieldType
+    QStringList fieldTypeStrNumpy;
+
+    fieldTypeStrNumpy << "i1" << "<i2" << "<i4" << "u1" << "<u2" << "<u4" << "<f4" << "u1";
+
+    QString dtypes;
+    for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
+        ObjectInfo *info = parser->getObjectByIndex(objidx);
+        dtypes.append(QString("    0x%1: (\"%2\", numpy.dtype([\n").arg(info->id, 8, 16, QChar('0')).arg(info->name));
+        for (int n = 0; n < info->fields.length(); ++n) {
+            FieldInfo *field = info->fields[n];
+            if (field->numElements > 1) {
+                dtypes.append(QString("        (\"%1\", \"%2\", (%3,)),\n").arg(field->name)
+                              .arg(fieldTypeStrNumpy[field->type]).arg(field->numElements));
+            } else {
+                dtypes.append(QString("        (\"%1\", \"%2\"),\n").arg(field->name)
+                              .arg(fieldTypeStrNumpy[field->type]));
+            }
+        }
+        dtypes.append(QString("    ])),\n"));
+    }
+    QString outCode = pythonDtypesTemplate;
+    outCode.replace(QString("$(DTYPES)"), dtypes);
+
+    bool res = writeFileIfDiffrent(pythonOutputPath.absolutePath() + "/uavodtypes.py", outCode);
+    if (!res) {
+        cout << "Error: Could not write Python output files" << endl;
+        return false;
+    }
+    return true;
 }
 
 /**
@@ -35,8 +35,10 @@ public:
 
 private:
     bool process_object(ObjectInfo *info);
+    bool process_dtypes(UAVObjectParser *parser);
 
     QString pythonCodeTemplate;
+    QString pythonDtypesTemplate;
     QDir pythonCodePath;
     QDir pythonOutputPath;
 };
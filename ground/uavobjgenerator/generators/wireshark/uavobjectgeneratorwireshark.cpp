@@ -83,18 +83,29 @@ bool UAVObjectGeneratorWireshark::generate(UAVObjectParser *parser, QString temp
                     uavobjectsOutputPath.absoluteFilePath(uavostaticfiles[i]));
     }
 
-    /* Generate the per-object files from the templates, and keep track of the list of generated filenames */
-    QString objFileNames;
+    /* Collect the dissection of every object into the one dissector file */
     for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
         ObjectInfo *info = parser->getObjectByIndex(objidx);
-        process_object(info, uavobjectsOutputPath);
-        objFileNames.append(" packet-op-uavobjects-" + info->namelc + ".c");
+        process_object(info);
+    }
+
+    QString outCode = wiresharkCodeTemplate;
+    outCode.replace(QString("$(SUBTREESTATICS)"), subtreestatics);
+    outCode.replace(QString("$(FIELDHANDLES)"), fieldhandles);
+    outCode.replace(QString("$(ENUMFIELDNAMES)"), enumfieldnames);
+    outCode.replace(QString("$(DISSECTORS)"), dissectors);
+    outCode.replace(QString("$(HEADERFIELDS)"), headerfields);
+    outCode.replace(QString("$(SUBTREES)"), subtrees);
+    outCode.replace(QString("$(HANDOFFS)"), handoffs);
+    bool res = writeFileIfDiffrent(uavobjectsOutputPath.absolutePath() + "/packet-op-uavobjects.c", outCode);
+    if (!res) {
+        cout << "Error: Could not write wireshark code files" << endl;
+        return false;
     }
 
     /* Write the uavobject dissector's Makefile.common */
-    wiresharkMakeTemplate.replace(QString("$(UAVOBJFILENAMES)"), objFileNames);
-    bool res = writeFileIfDiffrent(uavobjectsOutputPath.absolutePath() + "/Makefile.common",
-                                   wiresharkMakeTemplate);
+    res = writeFileIfDiffrent(uavobjectsOutputPath.absolutePath() + "/Makefile.common",
+                              wiresharkMakeTemplate);
     if (!res) {
         cout << "Error: Could not write wireshark Makefile" << endl;
         return false;
@@ -105,59 +116,44 @@ bool UAVObjectGeneratorWireshark::generate(UAVObjectParser *parser, QString temp
 
 
 /**
- * Generate the Flight object files
+ * Append the dissection of an object to the dissector file
  **/
-bool UAVObjectGeneratorWireshark::process_object(ObjectInfo *info, QDir outputpath)
+bool UAVObjectGeneratorWireshark::process_object(ObjectInfo *info)
 {
     if (info == NULL) {
         return false;
     }
 
-    // Prepare output strings
-    QString outCode = wiresharkCodeTemplate;
-
-    // Replace common tags
-    replaceCommonTags(outCode, info);
-
-    // Replace the $(SUBTREES) and $(SUBTREESTATICS) tags
-    QString subtrees;
-    QString subtreestatics;
-    subtreestatics.append(QString("static gint ett_uavo = -1;\r\n"));
-    subtrees.append(QString("&ett_uavo,\r\n"));
+    // Append to the $(SUBTREES) and $(SUBTREESTATICS) tags
     for (int n = 0; n < info->fields.length(); ++n) {
         if (info->fields[n]->numElements > 1) {
             /* Reserve a subtree for each array */
             subtreestatics.append(QString("static gint ett_%1_%2 = -1;\r\n")
                                   .arg(info->namelc)
                                   .arg(info->fields[n]->name));
-            subtrees.append(QString("&ett_%1_%2,\r\n")
+            subtrees.append(QString("\t&ett_%1_%2,\r\n")
                             .arg(info->namelc)
                             .arg(info->fields[n]->name));
         }
     }
-    outCode.replace(QString("$(SUBTREES)"), subtrees);
-    outCode.replace(QString("$(SUBTREESTATICS)"), subtreestatics);
 
-    // Replace the $(FIELDHANDLES) tag
-    QString type;
-    QString fields;
+    // Append to the $(FIELDHANDLES) tag
     for (int n = 0; n < info->fields.length(); ++n) {
-        fields.append(QString("static int hf_op_uavobjects_%1_%2 = -1;\r\n")
-                      .arg(info->namelc)
-                      .arg(info->fields[n]->name));
+        fieldhandles.append(QString("static int hf_op_uavobjects_%1_%2 = -1;\r\n")
+                            .arg(info->namelc)
+                            .arg(info->fields[n]->name));
         if (info->fields[n]->numElements > 1) {
             QStringList elemNames = info->fields[n]->elementNames;
             for (int m = 0; m < elemNames.length(); ++m) {
-                fields.append(QString("static int hf_op_uavobjects_%1_%2_%3 = -1;\r\n")
-                              .arg(info->namelc)
-                              .arg(info->fields[n]->name)
-                              .arg(elemNames[m]));
+                fieldhandles.append(QString("static int hf_op_uavobjects_%1_%2_%3 = -1;\r\n")
+                                    .arg(info->namelc)
+                                    .arg(info->fields[n]->name)
+                                    .arg(elemNames[m]));
             }
         }
     }
-    outCode.replace(QString("$(FIELDHANDLES)"), fields);
 
-    // Replace the $(ENUMFIELDNAMES) tag
+    // Append to the $(ENUMFIELDNAMES) tag
     QString enums;
     for (int n = 0; n < info->fields.length(); ++n) {
         // Only for enum types
@@ -178,9 +174,9 @@ bool UAVObjectGeneratorWireshark::process_object(ObjectInfo *info, QDir outputpa
             enums.append(QString("};\r\n"));
         }
     }
-    outCode.replace(QString("$(ENUMFIELDNAMES)"), enums);
+    enumfieldnames.append(enums);
 
-    // Replace the $(POPULATETREE) tag
+    // Append the object dissector to the $(DISSECTORS) tag
     QString treefields;
     for (int n = 0; n < info->fields.length(); ++n) {
         if (info->fields[n]->numElements == 1) {
@@ -210,11 +206,28 @@ bool UAVObjectGeneratorWireshark::process_object(ObjectInfo *info, QDir outputpa
             treefields.append(QString("    }\r\n"));
         }
     }
-    outCode.replace(QString("$(POPULATETREE)"), treefields);
+    dissectors.append(QString("static int dissect_uavo_%1(tvbuff_t *tvb, packet_info *pinfo, proto_tree *tree)\r\n").arg(info->namelc));
+    dissectors.append(QString("{\r\n"));
+    dissectors.append(QString("  proto_tree *uavo_tree = uavo_add_tree(tvb, pinfo, tree, \"%1\");\r\n").arg(info->name));
+    dissectors.append(QString("\r\n"));
+    dissectors.append(QString("  if (uavo_tree) {\r\n"));
+    dissectors.append(QString("    ptvcursor_t *cursor = ptvcursor_new(uavo_tree, tvb, 0);\r\n"));
+    dissectors.append(QString("\r\n"));
+    dissectors.append(treefields);
+    dissectors.append(QString("\r\n"));
+    dissectors.append(QString("    ptvcursor_free(cursor);\r\n"));
+    dissectors.append(QString("  }\r\n"));
+    dissectors.append(QString("\r\n"));
+    dissectors.append(QString("  return tvb_length(tvb);\r\n"));
+    dissectors.append(QString("}\r\n"));
+    dissectors.append(QString("\r\n"));
 
-    // Replace the $(HEADERFIELDS) tag
-    QString headerfields;
-    headerfields.append(QString("   static hf_register_info hf[] = {\r\n"));
+    // Append the binding to its ObjID to the $(HANDOFFS) tag
+    handoffs.append(QString("   dissector_add_uint(\"uavtalk.objid\", 0x%1, new_create_dissector_handle(dissect_uavo_%2, proto_uavo));\r\n")
+                    .arg(QString().setNum(info->id, 16).toUpper())
+                    .arg(info->namelc));
+
+    // Append to the $(HEADERFIELDS) tag
     for (int n = 0; n < info->fields.length(); ++n) {
         // For non-array fields
         if (info->fields[n]->numElements == 1) {
@@ -275,15 +288,6 @@ bool UAVObjectGeneratorWireshark::process_object(ObjectInfo *info, QDir outputpa
             }
         }
     }
-    headerfields.append(QString("   };\r\n"));
-    outCode.replace(QString("$(HEADERFIELDS)"), headerfields);
-
-    // Write the flight code
-    bool res = writeFileIfDiffrent(outputpath.absolutePath() + "/packet-op-uavobjects-" + info->namelc + ".c", outCode);
-    if (!res) {
-        cout << "Error: Could not write wireshark code files" << endl;
-        return false;
-    }
 
     return true;
 }
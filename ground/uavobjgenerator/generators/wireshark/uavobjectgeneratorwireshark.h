@@ -39,7 +39,11 @@ public:
     QDir wiresharkOutputPath;
 
 private:
-    bool process_object(ObjectInfo *info, QDir outputpath);
+    // the sections of the dissector file, filled object by object
+    QString subtreestatics, subtrees, fieldhandles, enumfieldnames;
+    QString dissectors, headerfields, handoffs;
+
+    bool process_object(ObjectInfo *info);
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include <QFile>
 #include <QString>
 #include <QStringList>
+#include <QtConcurrent/QtConcurrentMap>
 #include <iostream>
 
 #include "generators/java/uavobjectgeneratorjava.h"
@@ -77,6 +78,41 @@ int usage_err()
     return RETURN_ERR_USAGE;
 }
 
+/**
+ * An XML file parsed on its own, so that all the files can be parsed in parallel
+ */
+struct ParseJob {
+    QFileInfo fileinfo;
+    UAVObjectParser *parser;
+    QString   result;
+};
+
+void parseJob(ParseJob & job)
+{
+    QString filename = job.fileinfo.fileName();
+    QString xmlstr   = readFile(job.fileinfo.absoluteFilePath());
+
+    job.parser = new UAVObjectParser();
+    job.result = job.parser->parseXML(xmlstr, filename);
+}
+
+/**
+ * Write the list of objects with their ID and definition file, the ID changes
+ * with the definition so the build can tell which objects were modified
+ */
+bool writeManifest(UAVObjectParser *parser, QString outputpath)
+{
+    QString manifest;
+
+    for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
+        ObjectInfo *info = parser->getObjectByIndex(objidx);
+        manifest.append(QString("%1 0x%2 %3\n").arg(info->name)
+                        .arg(QString().setNum(info->id, 16).toUpper(), 8, QChar('0'))
+                        .arg(info->filename));
+    }
+    return writeFileIfDiffrent(outputpath + "uavobjects.manifest", manifest);
+}
+
 /**
  * entrance
  */
@@ -146,6 +182,7 @@ int main(int argc, char *argv[])
     QFileInfoList xmlList   = xmlPath.entryInfoList();
 
     // Read in each XML file and parse object(s) in them
+    QList<ParseJob> jobs;
 
     for (int n = 0; n < xmlList.length(); ++n) {
         QFileInfo fileinfo = xmlList[n];
@@ -157,23 +194,40 @@ int main(int argc, char *argv[])
                 continue;
             }
         }
-        if (verbose) {
-            cout << "Parsing XML file: " << fileinfo.fileName().toStdString() << endl;
-        }
-        QString filename = fileinfo.fileName();
-        QString xmlstr   = readFile(fileinfo.absoluteFilePath());
+        ParseJob job;
+        job.fileinfo = fileinfo;
+        job.parser   = NULL;
+        jobs.append(job);
+    }
 
-        QString res = parser->parseXML(xmlstr, filename);
+    QtConcurrent::blockingMap(jobs, parseJob);
 
-        if (!res.isNull()) {
+    // Merge the results in file order, the generated code does not depend on the thread scheduling
+    bool parse_error = false;
+    for (int n = 0; n < jobs.length() && !parse_error; ++n) {
+        if (verbose) {
+            cout << "Parsing XML file: " << jobs[n].fileinfo.fileName().toStdString() << endl;
+        }
+        if (!jobs[n].result.isNull()) {
             if (!verbose) {
-                cout << "Error in XML file: " << fileinfo.fileName().toStdString() << endl;
+                cout << "Error in XML file: " << jobs[n].fileinfo.fileName().toStdString() << endl;
             }
-            cout << "Error parsing " << res.toStdString() << endl;
-            return RETURN_ERR_XML;
+            cout << "Error parsing " << jobs[n].result.toStdString() << endl;
+            parse_error = true;
+        } else {
+            parser->appendObjects(*jobs[n].parser);
         }
     }
 
+    // every job has its parser, also those after a failed file
+    for (int n = 0; n < jobs.length(); ++n) {
+        delete jobs[n].parser;
+    }
+    if (parse_error) {
+        delete parser;
+        return RETURN_ERR_XML;
+    }
+
     if (objects_stringlist.length() > 0) {
         cout << "required UAVObject definitions not found! " << objects_stringlist.join(",").toStdString() << endl;
         return RETURN_ERR_XML;
@@ -209,6 +263,10 @@ int main(int argc, char *argv[])
         return RETURN_OK;
     }
 
+    if (!writeManifest(parser, outputpath)) {
+        cout << "Error: Could not write the object manifest" << endl;
+    }
+
     // generate flight code if wanted
     if (do_flight | do_all) {
         cout << "generating flight code" << endl;
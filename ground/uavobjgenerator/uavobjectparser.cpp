@@ -45,6 +45,16 @@ UAVObjectParser::UAVObjectParser()
     accessModeStrXML << "readwrite" << "readonly";
 }
 
+/**
+ * Take over the objects of another parser, used to merge files parsed in parallel
+ */
+void UAVObjectParser::appendObjects(const UAVObjectParser & parser)
+{
+    objInfo.append(parser.objInfo);
+    all_units.append(parser.all_units);
+    all_units.removeDuplicates();
+}
+
 /**
  * Get number of objects
  */
@@ -657,6 +667,20 @@ QString UAVObjectParser::processObjectAttributes(QDomNode & node, ObjectInfo *in
         return QString("Object: Settings objects can not have multiple instances");
     }
 
+    // Get instances attribute if present
+    attr = attributes.namedItem("instances");
+    info->numInstances = 1;
+    if (!attr.isNull()) {
+        bool ok;
+        info->numInstances = attr.nodeValue().toInt(&ok);
+        if (!ok || info->numInstances < 1 || info->numInstances > 1000) {
+            return QString("Object:instances attribute value is invalid (1 to 1000)");
+        }
+        if (info->isSingleInst && info->numInstances != 1) {
+            return QString("Object: Single instance objects can not have an instances hint");
+        }
+    }
+
     // Done
     return QString();
 }
@@ -86,6 +86,7 @@ typedef struct  {
     bool       isSingleInst;
     bool       isSettings;
     bool       isPriority;
+    int        numInstances; /** Instances to preallocate for a multi instance object, a hint not part of the hash */
     AccessMode gcsAccess;
     AccessMode flightAccess;
     bool       flightTelemetryAcked;
@@ -107,6 +108,7 @@ public:
     // Functions
     UAVObjectParser();
     QString parseXML(QString & xml, QString & filename);
+    void appendObjects(const UAVObjectParser & parser);
     int getNumObjects();
     QList<ObjectInfo *> getObjectInfo();
     QString getObjectName(int objIndex);
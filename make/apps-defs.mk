@@ -81,6 +81,7 @@ SRC += $(PIOSCOMMON)/pios_rfm22b_com.c
 SRC += $(PIOSCOMMON)/pios_rcvr.c
 SRC += $(PIOSCOMMON)/pios_sbus.c
 SRC += $(PIOSCOMMON)/pios_sdcard.c
+SRC += $(PIOSCOMMON)/pios_sdlog.c
 SRC += $(PIOSCOMMON)/pios_sensors.c
 
 ## Misc library functions
@@ -113,12 +114,20 @@ SRC += $(PIOSCOMMON)/pios_task_monitor.c
 SRC += $(PIOSCOMMON)/pios_callbackscheduler.c
 SRC += $(PIOSCOMMON)/pios_notify.c
 SRC += $(PIOSCOMMON)/pios_instrumentation.c
+SRC += $(PIOSCOMMON)/pios_eventtrace.c
+SRC += $(PIOSCOMMON)/pios_latencyprobe.c
 SRC += $(PIOSCOMMON)/pios_mem.c
+SRC += $(PIOSCOMMON)/pios_initcall.c
+SRC += $(PIOSCOMMON)/pios_spscqueue.c
 ## Misc library functions
 SRC += $(FLIGHTLIB)/fifo_buffer.c
 
 SRC += $(MATHLIB)/mathmisc.c
 SRC += $(MATHLIB)/butterworth.c
+SRC += $(MATHLIB)/biquad.c
+SRC += $(MATHLIB)/fft.c
+SRC += $(MATHLIB)/sysident.c
+SRC += $(MATHLIB)/magfit.c
 SRC += $(FLIGHTLIB)/printf-stdarg.c
 SRC += $(FLIGHTLIB)/optypes.c
 
@@ -0,0 +1,75 @@
+###############################################################################
+# @file       benchmark.mk
+# @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+# @addtogroup 
+# @{
+# @addtogroup 
+# @{
+# @brief Makefile template for host benchmarks of flight code
+###############################################################################
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#
+
+# Use native toolchain and disable THUMB mode for benchmarks
+override ARM_SDK_PREFIX :=
+override THUMB :=
+
+# Google Benchmark, the system wide installation unless told otherwise
+BENCHMARK_LIBS ?= -lbenchmark
+
+# Benchmark source files
+ALLSRC     := $(SRC) $(wildcard ./*.c)
+ALLCPPSRC  := $(wildcard ./*.cpp)
+ALLSRCBASE := $(notdir $(basename $(ALLSRC) $(ALLCPPSRC)))
+ALLOBJ     := $(addprefix $(OUTDIR)/, $(addsuffix .o, $(ALLSRCBASE)))
+
+$(foreach src,$(ALLSRC),$(eval $(call COMPILE_C_TEMPLATE,$(src))))
+$(foreach src,$(ALLCPPSRC),$(eval $(call COMPILE_CXX_TEMPLATE,$(src))))
+
+$(eval $(call LINK_CXX_TEMPLATE,$(OUTDIR)/$(TARGET).elf,$(ALLOBJ)))
+
+# Flags passed to the C++ compiler
+CXXFLAGS += -Wall -Wextra
+
+# Flags passed to the C compiler
+CONLYFLAGS += -std=gnu99
+
+# Same define as the unit tests, the flight code sees a host build
+CFLAGS += -DUNIT_TEST
+CPPFLAGS += -DUNIT_TEST
+
+# Common compiler flags, optimised as the numbers are meaningless otherwise
+CFLAGS += -O2 -g
+CFLAGS += -Wall -Werror
+CFLAGS += $(patsubst %,-I%,$(EXTRAINCDIRS))
+
+LDFLAGS += $(BENCHMARK_LIBS) -lpthread -lm
+
+.PHONY: elf
+elf: $(OUTDIR)/$(TARGET).elf
+
+# Results of every run in a file, to compare between commits
+.PHONY: json
+json: $(OUTDIR)/$(TARGET).json
+
+$(OUTDIR)/$(TARGET).json: $(OUTDIR)/$(TARGET).elf
+	$(V0) @echo " BENCH JSON $(MSG_EXTRA)  $(call toprel, $@)"
+	$(V1) $< --benchmark_out=$@ --benchmark_out_format=json > /dev/null
+
+.PHONY: run
+run: $(OUTDIR)/$(TARGET).elf
+	$(V0) @echo " BENCH RUN  $(MSG_EXTRA)  $(call toprel, $<)"
+	$(V1) $<
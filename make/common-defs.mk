@@ -39,6 +39,15 @@ DIAG_RATEDESIRED     ?= NO
 DIAG_I2C_WDG_STATS   ?= NO
 DIAG_TASKS           ?= NO
 DIAG_INSTRUMENTATION ?= NO
+DIAG_MEMORY          ?= NO
+DIAG_BOOT            ?= NO
+DIAG_TELEMETRY       ?= NO
+
+# Set to YES to record task switches, callbacks, ISRs and timed sections into a RAM trace buffer (Revolution only, not part of DIAG_ALL)
+DIAG_TRACE           ?= NO
+
+# Set to YES to measure the latency from the receiver frames to the outputs into LatencyProbe (Revolution only, not part of DIAG_ALL)
+DIAG_LATENCY         ?= NO
 
 # Or just turn on all the above diagnostics. WARNING: this consumes massive amounts of memory.
 DIAG_ALL             ?= NO
@@ -98,6 +107,26 @@ endif
 ifneq (,$(filter YES,$(DIAG_INSTRUMENTATION) $(DIAG_ALL)))
     CFLAGS += -DPIOS_INCLUDE_INSTRUMENTATION
 endif
+
+ifneq (,$(filter YES,$(DIAG_MEMORY) $(DIAG_ALL)))
+    CFLAGS += -DPIOS_INCLUDE_MEM_ACCOUNTING
+endif
+
+ifneq (,$(filter YES,$(DIAG_BOOT) $(DIAG_ALL)))
+    CFLAGS += -DPIOS_INCLUDE_INITCALL_PROFILE
+endif
+
+ifneq (,$(filter YES,$(DIAG_TELEMETRY) $(DIAG_ALL)))
+    CFLAGS += -DDIAG_TELEMETRY
+endif
+
+ifeq ($(DIAG_TRACE), YES)
+    CFLAGS += -DPIOS_INCLUDE_EVENTTRACE
+endif
+
+ifeq ($(DIAG_LATENCY), YES)
+    CFLAGS += -DPIOS_INCLUDE_LATENCYPROBE
+endif
 # Place project-specific -D and/or -U options for Assembler with preprocessor here.
 #ADEFS = -DUSE_IRQ_ASM_WRAPPER
 ADEFS = -D__ASSEMBLY__
@@ -43,6 +43,7 @@ endif
 MSG_FORMATERROR      = $(QUOTE) Can not handle output-format$(QUOTE)
 MSG_MODINIT          = $(QUOTE) MODINIT   $(MSG_EXTRA) $(QUOTE)
 MSG_SIZE             = $(QUOTE) SIZE      $(MSG_EXTRA) $(QUOTE)
+MSG_PLACEMENT        = $(QUOTE) PLACEMENT $(MSG_EXTRA) $(QUOTE)
 MSG_LOAD_FILE        = $(QUOTE) BIN/HEX   $(MSG_EXTRA) $(QUOTE)
 MSG_BIN_OBJ          = $(QUOTE) BINO      $(MSG_EXTRA) $(QUOTE)
 MSG_STRIP_FILE       = $(QUOTE) STRIP     $(MSG_EXTRA) $(QUOTE)
@@ -127,6 +128,15 @@ size: $(1)_size
 $(1)_size: $(1)
 	@$(ECHO) $(MSG_SIZE) $$(call toprel, $$<)
 	$(V1) $(SIZE) -A $$<
+
+# Lists what the linker map shows placed in the CCM (.fast, .irqstack) and in SRAM code (.ramfunc)
+.PHONY: placement
+placement: $(1)_placement
+
+.PHONY: $(1)_placement
+$(1)_placement: $(1)
+	@$(ECHO) $(MSG_PLACEMENT) $$(call toprel, $$(<:.elf=.map))
+	$(V1) grep -E '^ \.(fast|irqstack|ramfunc)[ ]' $$(<:.elf=.map) || $(ECHO) "nothing placed"
 endef
 
 # OpenPilot firmware image template
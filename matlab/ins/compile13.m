@@ -0,0 +1,2 @@
+% Builds insgps13_ml from the flight code EKF, optimized for the replays
+mex -O CFLAGS='$CFLAGS -std=gnu99' -I../../flight/libraries/inc -I../../flight/pios/inc insgps13_ml.c ../../flight/libraries/insgps13state.c
@@ -0,0 +1,339 @@
+/**
+ ******************************************************************************
+ *
+ * @file       insgps13_ml.c
+ * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2015.
+ * @brief      Matlab gateway to the 13 state INSGPS of the flight code
+ *
+ * The EKF is flight/libraries/insgps13state.c as it is flown, built by
+ * compile13.m. A whole log is replayed in a single call so that the
+ * filter runs at C speed, see tune13.m.
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+// Not the insgps.h of this directory, it goes with the older copy of the filter in insgps.c
+#include "../../flight/libraries/inc/insgps.h"
+#include "mex.h"
+#include "stdbool.h"
+#include "stdio.h"
+#include "string.h"
+#include "math.h"
+
+#define NUMX 13
+
+// Columns of the log replayed by INSReplay
+#define LOG_DT      0
+#define LOG_GYRO    1
+#define LOG_ACCEL   4
+#define LOG_MAG     7
+#define LOG_POS     10
+#define LOG_VEL     13
+#define LOG_BARO    16
+#define LOG_SENSORS 17
+#define LOG_COLUMNS 18
+
+bool mlStringCompare(const mxArray *mlVal, char *cStr);
+bool mlGetFloatArray(const mxArray *mlVal, float *dest, int numel);
+static void replay(const mxArray *log, int nlhs, mxArray *plhs[]);
+static void getState(float X[NUMX]);
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    float X[NUMX];
+
+    if (nrhs < 1 || !mxIsChar(prhs[0])) {
+        mexErrMsgTxt("First parameter must be name of a function\n");
+        return;
+    }
+
+    if (mlStringCompare(prhs[0], "INSGPSInit")) {
+        INSGPSInit();
+    } else if (mlStringCompare(prhs[0], "INSReplay")) {
+        if (nrhs != 2) {
+            mexErrMsgTxt("Incorrect number of inputs for replay\n");
+            return;
+        }
+        replay(prhs[1], nlhs, plhs);
+        return;
+    } else if (mlStringCompare(prhs[0], "INSStatePrediction")) {
+        float gyro_data[3], accel_data[3], dT;
+        if ((nrhs != 4) ||
+            !mlGetFloatArray(prhs[1], gyro_data, 3) ||
+            !mlGetFloatArray(prhs[2], accel_data, 3) ||
+            !mlGetFloatArray(prhs[3], &dT, 1)) {
+            mexErrMsgTxt("Error with the input parameters\n");
+            return;
+        }
+        INSStatePrediction(gyro_data, accel_data, dT);
+        INSCovariancePrediction(dT);
+    } else if (mlStringCompare(prhs[0], "INSCorrection")) {
+        float mag_data[3], pos_data[3], vel_data[3], baro_data, sensors;
+        if ((nrhs != 6) ||
+            !mlGetFloatArray(prhs[1], mag_data, 3) ||
+            !mlGetFloatArray(prhs[2], pos_data, 3) ||
+            !mlGetFloatArray(prhs[3], vel_data, 3) ||
+            !mlGetFloatArray(prhs[4], &baro_data, 1) ||
+            !mlGetFloatArray(prhs[5], &sensors, 1)) {
+            mexErrMsgTxt("Error with the input parameters\n");
+            return;
+        }
+        INSCorrection(mag_data, pos_data, vel_data, baro_data, (uint16_t)sensors);
+    } else if (mlStringCompare(prhs[0], "INSSetState")) {
+        float zeros[3] = { 0, 0, 0 };
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], X, NUMX)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSSetState(&X[0], &X[3], &X[6], &X[10], zeros);
+    } else if (mlStringCompare(prhs[0], "INSResetP")) {
+        float p_diag[NUMX];
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], p_diag, NUMX)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSResetP(p_diag);
+    } else if (mlStringCompare(prhs[0], "INSSetPosVelVar")) {
+        float pos_var[3], vel_var[3];
+        if ((nrhs != 3) || !mlGetFloatArray(prhs[1], pos_var, 3) || !mlGetFloatArray(prhs[2], vel_var, 3)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSSetPosVelVar(pos_var, vel_var);
+    } else if (mlStringCompare(prhs[0], "INSSetAccelVar")) {
+        float accel_var[3];
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], accel_var, 3)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSSetAccelVar(accel_var);
+    } else if (mlStringCompare(prhs[0], "INSSetGyroVar")) {
+        float gyro_var[3];
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], gyro_var, 3)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSSetGyroVar(gyro_var);
+    } else if (mlStringCompare(prhs[0], "INSSetGyroBiasVar")) {
+        float gyro_bias_var[3];
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], gyro_bias_var, 3)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSSetGyroBiasVar(gyro_bias_var);
+    } else if (mlStringCompare(prhs[0], "INSSetMagVar")) {
+        float mag_var[3];
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], mag_var, 3)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSSetMagVar(mag_var);
+    } else if (mlStringCompare(prhs[0], "INSSetBaroVar")) {
+        float baro_var;
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], &baro_var, 1)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        INSSetBaroVar(baro_var);
+    } else if (mlStringCompare(prhs[0], "INSSetMagNorth")) {
+        float mag_north[3];
+        float Bmag;
+        if ((nrhs != 2) || !mlGetFloatArray(prhs[1], mag_north, 3)) {
+            mexErrMsgTxt("Error with input parameters\n");
+            return;
+        }
+        Bmag = sqrtf(mag_north[0] * mag_north[0] + mag_north[1] * mag_north[1] +
+                     mag_north[2] * mag_north[2]);
+        mag_north[0] = mag_north[0] / Bmag;
+        mag_north[1] = mag_north[1] / Bmag;
+        mag_north[2] = mag_north[2] / Bmag;
+
+        INSSetMagNorth(mag_north);
+    } else if (!mlStringCompare(prhs[0], "INSGetState")) {
+        mexErrMsgTxt("Unknown function");
+    }
+
+    if (nlhs > 0) {
+        // return current state vector
+        double *data_out;
+        int i;
+
+        getState(X);
+        plhs[0]  = mxCreateDoubleMatrix(1, NUMX, mxREAL);
+        data_out = mxGetPr(plhs[0]);
+        for (i = 0; i < NUMX; i++) {
+            data_out[i] = X[i];
+        }
+    }
+
+    if (nlhs > 1) {
+        // return the state variances
+        float p_diag[NUMX];
+        double *data_out;
+        int i;
+
+        INSGetP(p_diag);
+        plhs[1]  = mxCreateDoubleMatrix(1, NUMX, mxREAL);
+        data_out = mxGetPr(plhs[1]);
+        for (i = 0; i < NUMX; i++) {
+            data_out[i] = p_diag[i];
+        }
+    }
+}
+
+/**
+ * Runs the filter over a log of N rows by LOG_COLUMNS:
+ *   [dT gyro(3) accel(3) mag(3) pos(3) vel(3) baro sensors]
+ * with the gyros in rad/s and sensors the mask of INSCorrection, 0 for a
+ * row without any measurement. As in filterekf.c the covariance is only
+ * propagated, over the time accumulated, before a correction.
+ * Returns the N by 13 states after each row, the N by 13 states just
+ * before its correction, whose difference with the measurements are the
+ * innovations, and the N by 13 state variances.
+ */
+static void replay(const mxArray *log, int nlhs, mxArray *plhs[])
+{
+    const double *in;
+    double *out[3] = { 0, 0, 0 };
+    float covarianceDT = 0.0f;
+    float X[NUMX], p_diag[NUMX];
+    mwSize rows;
+    mwSize r;
+    int i, k;
+
+    if (!mxIsDouble(log) || mxGetN(log) != LOG_COLUMNS) {
+        mexErrMsgTxt("The log must be a double matrix of 18 columns\n");
+        return;
+    }
+    rows = mxGetM(log);
+    in   = mxGetPr(log);
+
+    for (k = 0; k < 3 && k < (nlhs > 0 ? nlhs : 1); k++) {
+        plhs[k] = mxCreateDoubleMatrix(rows, NUMX, mxREAL);
+        out[k]  = mxGetPr(plhs[k]);
+    }
+
+    // Matlab matrices are column major, element (r, c) is in[r + c * rows]
+#define IN(c) ((float)in[r + (c) * rows])
+    for (r = 0; r < rows; r++) {
+        float gyro[3]  = { IN(LOG_GYRO), IN(LOG_GYRO + 1), IN(LOG_GYRO + 2) };
+        float accel[3] = { IN(LOG_ACCEL), IN(LOG_ACCEL + 1), IN(LOG_ACCEL + 2) };
+        float dT = IN(LOG_DT);
+        uint16_t sensors = (uint16_t)in[r + LOG_SENSORS * rows];
+
+        INSStatePrediction(gyro, accel, dT);
+        covarianceDT += dT;
+
+        if (out[1]) {
+            getState(X);
+            for (i = 0; i < NUMX; i++) {
+                out[1][r + i * rows] = X[i];
+            }
+        }
+
+        if (sensors) {
+            float mag[3] = { IN(LOG_MAG), IN(LOG_MAG + 1), IN(LOG_MAG + 2) };
+            float pos[3] = { IN(LOG_POS), IN(LOG_POS + 1), IN(LOG_POS + 2) };
+            float vel[3] = { IN(LOG_VEL), IN(LOG_VEL + 1), IN(LOG_VEL + 2) };
+
+            INSCovariancePrediction(covarianceDT);
+            covarianceDT = 0.0f;
+            INSCorrection(mag, pos, vel, IN(LOG_BARO), sensors);
+        }
+
+        getState(X);
+        for (i = 0; i < NUMX; i++) {
+            out[0][r + i * rows] = X[i];
+        }
+
+        if (out[2]) {
+            INSGetP(p_diag);
+            for (i = 0; i < NUMX; i++) {
+                out[2][r + i * rows] = p_diag[i];
+            }
+        }
+    }
+#undef IN
+}
+
+static void getState(float X[NUMX])
+{
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        X[i]      = Nav.Pos[i];
+        X[3 + i]  = Nav.Vel[i];
+        X[10 + i] = Nav.gyro_bias[i];
+    }
+    for (i = 0; i < 4; i++) {
+        X[6 + i] = Nav.q[i];
+    }
+}
+
+bool mlGetFloatArray(const mxArray *mlVal, float *dest, int numel)
+{
+    if (!mxIsNumeric(mlVal) || (!mxIsDouble(mlVal) && !mxIsSingle(mlVal)) || (mxGetNumberOfElements(mlVal) != (mwSize)numel)) {
+        mexErrMsgTxt("Data misformatted (either not double or not the right number)");
+        return false;
+    }
+
+    if (mxIsSingle(mlVal)) {
+        memcpy(dest, mxGetData(mlVal), numel * sizeof(*dest));
+    } else {
+        int i;
+        double *data_in = mxGetPr(mlVal);
+        for (i = 0; i < numel; i++) {
+            dest[i] = data_in[i];
+        }
+    }
+
+    return true;
+}
+
+bool mlStringCompare(const mxArray *mlVal, char *cStr)
+{
+    int i;
+    char *mlCStr = 0;
+    bool val     = false;
+    int strLen   = mxGetNumberOfElements(mlVal);
+
+    mlCStr = mxCalloc((1 + strLen), sizeof(*mlCStr));
+    if (!mlCStr) {
+        return false;
+    }
+
+    if (mxGetString(mlVal, mlCStr, strLen + 1)) {
+        goto cleanup;
+    }
+
+    for (i = 0; i < strLen; i++) {
+        if (mlCStr[i] != cStr[i]) {
+            goto cleanup;
+        }
+    }
+
+    if (cStr[i] == '\0') {
+        val = true;
+    }
+
+cleanup:
+    if (mlCStr) {
+        mxFree(mlCStr);
+        mlCStr = 0;
+    }
+    return val;
+}
@@ -0,0 +1,35 @@
+function [cost, best] = tune13(log, Be, P0, gyro_var, accel_var, mag_var)
+% Sweeps the process and magnetometer noise variances of the flight EKF
+% over a log, in parallel when a pool is open (matlabpool / parpool)
+%
+% log        N x 18 [dT gyro(3) accel(3) mag(3) pos(3) vel(3) baro sensors]
+%            gyros in rad/s, sensors the mask of INSCorrection (0 when none)
+% Be         magnetic field at the home location
+% P0         1 x 13 initial state variances
+% gyro_var, accel_var, mag_var  candidate variances, applied to the 3 axes
+%
+% cost is the RMS of the GPS position and velocity innovations for each
+% combination, indexed (gyro, accel, mag), best the variances of the lowest.
+% Every worker is a process of its own with its own copy of the MEX, and so
+% of the static EKF, each combination replays the whole log from INSGPSInit.
+%
+% compile13 first.
+
+[G, A, M] = ndgrid(gyro_var, accel_var, mag_var);
+cost = zeros(size(G));
+gps = bitand(log(:,18), 63) ~= 0;
+
+parfor k = 1:numel(G)
+	insgps13_ml('INSGPSInit');
+	insgps13_ml('INSSetMagNorth', Be);
+	insgps13_ml('INSResetP', P0);
+	insgps13_ml('INSSetGyroVar', G(k) * ones(1,3));
+	insgps13_ml('INSSetAccelVar', A(k) * ones(1,3));
+	insgps13_ml('INSSetMagVar', M(k) * ones(1,3));
+	[X, Xprior] = insgps13_ml('INSReplay', log);
+	innovation = log(gps, 11:16) - Xprior(gps, 1:6);
+	cost(k) = sqrt(mean(innovation(:).^2));
+end
+
+[~, k] = min(cost(:));
+best = [G(k) A(k) M(k)];